@@ -0,0 +1,185 @@
+/*
+ * Microbenchmark runner.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <lwiot.h>
+#include <new>
+
+#include "bench.h"
+
+#ifdef BENCH_WRAP_ALLOC
+static long allocation_count = 0;
+
+extern "C" {
+	void *__real_malloc(size_t size);
+	void *__real_calloc(size_t num, size_t size);
+	void *__real_realloc(void *ptr, size_t size);
+
+	void *__wrap_malloc(size_t size)
+	{
+		__atomic_fetch_add(&allocation_count, 1, __ATOMIC_RELAXED);
+		return __real_malloc(size);
+	}
+
+	void *__wrap_calloc(size_t num, size_t size)
+	{
+		__atomic_fetch_add(&allocation_count, 1, __ATOMIC_RELAXED);
+		return __real_calloc(num, size);
+	}
+
+	void *__wrap_realloc(void *ptr, size_t size)
+	{
+		__atomic_fetch_add(&allocation_count, 1, __ATOMIC_RELAXED);
+		return __real_realloc(ptr, size);
+	}
+}
+
+/*
+ * The C++ runtime calls malloc() from a shared library, where --wrap does not reach, so new and
+ * delete are routed through the wrapped functions here.
+ */
+void *operator new(size_t size)
+{
+	auto ptr = malloc(size != 0 ? size : 1);
+
+	if(ptr == nullptr)
+		throw std::bad_alloc();
+
+	return ptr;
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+	free(ptr);
+}
+#endif
+
+namespace bench
+{
+	uint64_t cycles()
+	{
+#if defined(HAVE_CYCLE_COUNTER)
+		return lwiot_cycles();
+#elif defined(__x86_64__) || defined(__i386__)
+		return __builtin_ia32_rdtsc();
+#else
+		return 0;
+#endif
+	}
+
+	long allocations()
+	{
+#ifdef BENCH_WRAP_ALLOC
+		return __atomic_load_n(&allocation_count, __ATOMIC_RELAXED);
+#else
+		return -1;
+#endif
+	}
+
+	Runner::Runner(int warmup, int repetitions) : _warmup(warmup), _repetitions(repetitions)
+	{
+		if(this->_repetitions < 1)
+			this->_repetitions = 1;
+		else if(this->_repetitions > MaxRepetitions)
+			this->_repetitions = MaxRepetitions;
+	}
+
+	void Runner::header() const
+	{
+		printf("%d warmup runs, %d repetitions\n\n", this->_warmup, this->_repetitions);
+		printf("%-36s %12s %10s %12s %10s\n", "benchmark", "ns/op", "mad", "cycles/op", "allocs/op");
+	}
+
+	static int compare(const void *a, const void *b)
+	{
+		auto x = *static_cast<const double *>(a);
+		auto y = *static_cast<const double *>(b);
+
+		return x < y ? -1 : x > y;
+	}
+
+	static double median(double *values, int count)
+	{
+		qsort(values, static_cast<size_t>(count), sizeof(*values), compare);
+
+		if(count % 2)
+			return values[count / 2];
+
+		return (values[count / 2 - 1] + values[count / 2]) / 2;
+	}
+
+	Result Runner::statistics(Sample *samples, int count, size_t ops)
+	{
+		double values[MaxRepetitions];
+		double divisor = ops != 0 ? static_cast<double>(ops) : 1.0;
+		Result result;
+
+		for(int idx = 0; idx < count; idx++)
+			values[idx] = static_cast<double>(samples[idx].ns) / divisor;
+
+		result.ns = median(values, count);
+
+		for(int idx = 0; idx < count; idx++) {
+			values[idx] = static_cast<double>(samples[idx].ns) / divisor - result.ns;
+			values[idx] = values[idx] < 0 ? -values[idx] : values[idx];
+		}
+
+		result.mad = median(values, count);
+
+		for(int idx = 0; idx < count; idx++)
+			values[idx] = static_cast<double>(samples[idx].cycles) / divisor;
+
+		result.cycles = cycles() != 0 ? median(values, count) : -1;
+
+		for(int idx = 0; idx < count; idx++)
+			values[idx] = static_cast<double>(samples[idx].allocations) / divisor;
+
+		result.allocations = allocations() >= 0 ? median(values, count) : -1;
+		return result;
+	}
+
+	void Runner::print(const char *name, const Result &result)
+	{
+		char cycles[16];
+		char allocs[16];
+
+		if(result.cycles < 0)
+			snprintf(cycles, sizeof(cycles), "-");
+		else
+			snprintf(cycles, sizeof(cycles), "%.1f", result.cycles);
+
+		if(result.allocations < 0)
+			snprintf(allocs, sizeof(allocs), "-");
+		else
+			snprintf(allocs, sizeof(allocs), "%.2f", result.allocations);
+
+		printf("%-36s %12.2f %10.2f %12s %10s\n", name, result.ns, result.mad, cycles, allocs);
+		fflush(stdout);
+	}
+}
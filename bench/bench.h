@@ -0,0 +1,155 @@
+/*
+ * Microbenchmark runner.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/kernel/clock.h>
+
+#ifndef BENCH_WARMUP
+#define BENCH_WARMUP 3
+#endif
+
+#ifndef BENCH_REPETITIONS
+#define BENCH_REPETITIONS 15
+#endif
+
+namespace bench
+{
+	/**
+	 * @brief Keep the compiler from optimizing \p value, or the code computing it, away.
+	 */
+	template <typename T>
+	inline void doNotOptimize(const T& value)
+	{
+		asm volatile("" : : "r,m"(value) : "memory");
+	}
+
+	/**
+	 * @brief Keep the compiler from assuming memory is unchanged across this point.
+	 */
+	inline void clobber()
+	{
+		asm volatile("" : : : "memory");
+	}
+
+	/**
+	 * @brief Free running cycle counter.
+	 * @return The cycle count, or 0 when the target has no cycle counter.
+	 *
+	 * Ports with HAVE_CYCLE_COUNTER use lwiot_cycles(). On x86 hosts the time stamp counter is
+	 * used, which ticks at a constant rate close to, but not equal to, the core clock.
+	 */
+	uint64_t cycles();
+
+	/**
+	 * @brief Number of heap allocations made so far.
+	 * @return The number of allocations, or -1 when allocations are not counted.
+	 *
+	 * Allocations are counted when the benchmark is linked with BENCH_WRAP_ALLOC and
+	 * <tt>--wrap</tt> for malloc(), calloc() and realloc().
+	 */
+	long allocations();
+
+	/**
+	 * @brief Statistics of a benchmark over its repetitions.
+	 */
+	struct Result {
+		double ns; //!< Median time per operation, in nanoseconds.
+		double mad; //!< Median absolute deviation of the time per operation.
+		double cycles; //!< Median cycles per operation, or a negative value if unknown.
+		double allocations; //!< Allocations per operation, or a negative value if unknown.
+	};
+
+	/**
+	 * @brief Runs benchmarks and prints a line of statistics for each.
+	 *
+	 * A benchmark is a callable that performs \p ops operations. It is run a number of times
+	 * to warm up caches and the heap, and then a number of repetitions are timed. Results are
+	 * reported as the median and the median absolute deviation per operation, which are not
+	 * thrown off by the occasional preemption.
+	 *
+	 * The clock has a resolution of a microsecond on hosted ports, so a single call of a
+	 * benchmark should take well over that. Output goes to stdout, which is the UART on devices.
+	 *
+	 * @code
+	 * bench::Runner runner;
+	 *
+	 * runner.run("vector push_back", 1000, []() {
+	 *     lwiot::stl::Vector<int> vector;
+	 *
+	 *     for(int idx = 0; idx < 1000; idx++)
+	 *         vector.push_back(idx);
+	 *
+	 *     bench::doNotOptimize(vector);
+	 * });
+	 * @endcode
+	 */
+	class Runner {
+	public:
+		explicit Runner(int warmup = BENCH_WARMUP, int repetitions = BENCH_REPETITIONS);
+
+		/**
+		 * @brief Print the column headers.
+		 */
+		void header() const;
+
+		/**
+		 * @brief Run and report a benchmark.
+		 * @param name Name of the benchmark.
+		 * @param ops Number of operations that a single call of \p func performs.
+		 * @param func Benchmark body.
+		 */
+		template <typename Func>
+		Result run(const char *name, size_t ops, Func&& func)
+		{
+			Sample samples[MaxRepetitions];
+
+			for(int idx = 0; idx < this->_warmup; idx++)
+				func();
+
+			for(int idx = 0; idx < this->_repetitions; idx++) {
+				auto allocs = allocations();
+				auto begin = lwiot::Clock::now();
+				auto start = cycles();
+
+				func();
+
+				auto stop = cycles();
+				auto end = lwiot::Clock::now();
+
+				samples[idx].ns = end - begin;
+				samples[idx].cycles = stop - start;
+				samples[idx].allocations = allocs < 0 ? -1 : allocations() - allocs;
+			}
+
+			auto result = Runner::statistics(samples, this->_repetitions, ops);
+			Runner::print(name, result);
+
+			return result;
+		}
+
+		static constexpr int MaxRepetitions = 64;
+
+	private:
+		struct Sample {
+			uint64_t ns;
+			uint64_t cycles;
+			long allocations;
+		};
+
+		int _warmup;
+		int _repetitions;
+
+		static Result statistics(Sample *samples, int count, size_t ops);
+		static void print(const char *name, const Result& result);
+	};
+}
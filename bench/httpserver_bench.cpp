@@ -0,0 +1,382 @@
+/*
+ * HttpServer load benchmark.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+#include <new>
+#include <signal.h>
+#include <sys/stat.h>
+
+#include <lwiot/io/file.h>
+#include <lwiot/kernel/clock.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/network/httpserver.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+
+#define PORT 5580
+#define MAX_CONNECTIONS 32
+#define RESPONSE_BUFFER 65536
+#define STATIC_SIZE 4096
+#define UPLOAD_SIZE 8192
+#define BOUNDARY "lwiot-bench-boundary"
+
+/*
+ * Allocations and copies are only counted on the thread that runs the server, so the load
+ * generator does not show up in the numbers. Where the linker supports --wrap, malloc() and
+ * friends are counted as well as operator new, and so are memcpy() and memmove() calls that the
+ * compiler did not inline.
+ */
+static thread_local bool counting = false;
+static uint64_t allocations = 0;
+static uint64_t copied = 0;
+
+#ifdef BENCH_WRAP_ALLOC
+extern "C" {
+	void *__real_malloc(size_t size);
+	void *__real_calloc(size_t num, size_t size);
+	void *__real_realloc(void *ptr, size_t size);
+	void *__real_memcpy(void *dst, const void *src, size_t length);
+	void *__real_memmove(void *dst, const void *src, size_t length);
+
+	void *__wrap_malloc(size_t size)
+	{
+		if(counting)
+			allocations++;
+
+		return __real_malloc(size);
+	}
+
+	void *__wrap_calloc(size_t num, size_t size)
+	{
+		if(counting)
+			allocations++;
+
+		return __real_calloc(num, size);
+	}
+
+	void *__wrap_realloc(void *ptr, size_t size)
+	{
+		if(counting)
+			allocations++;
+
+		return __real_realloc(ptr, size);
+	}
+
+	void *__wrap_memcpy(void *dst, const void *src, size_t length)
+	{
+		if(counting)
+			copied += length;
+
+		return __real_memcpy(dst, src, length);
+	}
+
+	void *__wrap_memmove(void *dst, const void *src, size_t length)
+	{
+		if(counting)
+			copied += length;
+
+		return __real_memmove(dst, src, length);
+	}
+}
+#endif
+
+void *operator new(size_t size)
+{
+	if(counting)
+		allocations++;
+
+	auto ptr = malloc(size ? size : 1);
+
+	if(ptr == nullptr)
+		throw std::bad_alloc();
+
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t size) noexcept
+{
+	free(ptr);
+}
+
+struct Workload {
+	const char *name;
+	char *request;
+	size_t length;
+};
+
+struct Result {
+	double rps;
+	double p50;
+	double p99;
+	double allocations;
+	double copied;
+	size_t failures;
+};
+
+static lwiot::AtomicBool running(true);
+
+static int compare_latency(const void *a, const void *b)
+{
+	auto x = *static_cast<const uint32_t *>(a);
+	auto y = *static_cast<const uint32_t *>(b);
+
+	return x < y ? -1 : x > y;
+}
+
+static const char *find(const char *data, size_t length, const char *needle)
+{
+	auto size = strlen(needle);
+
+	for(size_t idx = 0; idx + size <= length; idx++) {
+		if(memcmp(data + idx, needle, size) == 0)
+			return data + idx;
+	}
+
+	return nullptr;
+}
+
+/*
+ * Send a request and read its response, which has to carry a Content-Length. The server closes a
+ * connection after a number of requests, after which the client connects again.
+ */
+static bool roundtrip(lwiot::SocketTcpClient& client, const Workload& workload, char *buffer)
+{
+	size_t received = 0;
+	size_t expected = 0;
+	bool close = false;
+
+	if(client.write(workload.request, workload.length) != static_cast<ssize_t>(workload.length))
+		return false;
+
+	while(expected == 0 || received < expected) {
+		auto rv = client.read(buffer + received, RESPONSE_BUFFER - received);
+
+		if(rv <= 0)
+			return false;
+
+		received += rv;
+
+		if(expected != 0)
+			continue;
+
+		auto end = find(buffer, received, "\r\n\r\n");
+
+		if(end == nullptr)
+			continue;
+
+		auto length = find(buffer, end - buffer, "Content-Length: ");
+
+		if(length == nullptr || memcmp(buffer, "HTTP/1.1 200", 12) != 0)
+			return false;
+
+		expected = (end - buffer) + 4 + strtoul(length + 16, nullptr, 10);
+		close = find(buffer, end - buffer, "Connection: close") != nullptr;
+	}
+
+	if(received != expected)
+		return false;
+
+	if(close) {
+		client.close();
+		return client.connect(lwiot::IPAddress(127, 0, 0, 1), PORT);
+	}
+
+	return true;
+}
+
+static Result run(const Workload& workload, size_t connections, size_t requests)
+{
+	lwiot::HttpServer server(new lwiot::SocketTcpServer(BIND_ADDR_LB, PORT));
+	lwiot::FunctionalThread worker("http");
+	lwiot::FunctionalThread *clients[MAX_CONNECTIONS];
+	auto latencies = new uint32_t[connections * requests];
+	lwiot::AtomicBool failed[MAX_CONNECTIONS];
+	Result result;
+
+	server.on("/json", lwiot::HTTP_GET, [](lwiot::HttpServer& srv) {
+		srv.send(200, "application/json", "{\"id\":7,\"temperature\":21.5,\"humidity\":40,\"unit\":\"C\"}");
+	});
+
+	server.on("/upload", lwiot::HTTP_POST, [](lwiot::HttpServer& srv) {
+		srv.send(200, "text/plain", "ok");
+	}, [](lwiot::HttpServer& srv) {
+	});
+
+	server.serveStatic("/static/", "bench-www/");
+	server.setMaxConnections(connections + 1, 10000);
+	assert(server.begin());
+
+	running = true;
+	worker.start([&]() {
+		counting = true;
+
+		while(running)
+			server.handleClient();
+
+		counting = false;
+	});
+
+	/* Connect every client before the clock starts. */
+	lwiot::SocketTcpClient *sockets[MAX_CONNECTIONS];
+	lwiot::IPAddress addr(127, 0, 0, 1);
+
+	for(size_t idx = 0; idx < connections; idx++) {
+		sockets[idx] = new lwiot::SocketTcpClient();
+		assert(sockets[idx]->connect(addr, PORT));
+		sockets[idx]->setTimeout(5);
+		clients[idx] = new lwiot::FunctionalThread("load");
+	}
+
+	auto allocs = allocations;
+	auto copies = copied;
+	auto start = lwiot::Clock::now();
+
+	for(size_t idx = 0; idx < connections; idx++) {
+		clients[idx]->start([&, idx]() {
+			auto buffer = new char[RESPONSE_BUFFER];
+			auto samples = latencies + idx * requests;
+
+			for(size_t num = 0; num < requests; num++) {
+				auto begin = lwiot::Clock::now();
+
+				if(!roundtrip(*sockets[idx], workload, buffer)) {
+					failed[idx] = true;
+					samples[num] = UINT32_MAX;
+					continue;
+				}
+
+				samples[num] = static_cast<uint32_t>((lwiot::Clock::now() - begin) / 1000ULL);
+			}
+
+			delete[] buffer;
+		});
+	}
+
+	for(size_t idx = 0; idx < connections; idx++)
+		clients[idx]->join();
+
+	auto elapsed = lwiot::Clock::now() - start;
+	auto total = connections * requests;
+
+	result.allocations = static_cast<double>(allocations - allocs) / total;
+	result.copied = static_cast<double>(copied - copies) / total;
+
+	running = false;
+	worker.join();
+
+	result.failures = 0;
+
+	for(size_t idx = 0; idx < connections; idx++) {
+		if(failed[idx])
+			result.failures++;
+
+		sockets[idx]->close();
+		delete sockets[idx];
+		delete clients[idx];
+	}
+
+	server.close();
+
+	qsort(latencies, total, sizeof(*latencies), compare_latency);
+	result.rps = total / (elapsed / 1e9);
+	result.p50 = latencies[total / 2];
+	result.p99 = latencies[total * 99 / 100];
+
+	delete[] latencies;
+	return result;
+}
+
+static Workload make_workload(const char *name, const char *head, const char *body, size_t length)
+{
+	auto size = strlen(head);
+	Workload workload = { name, new char[size + length], size + length };
+
+	memcpy(workload.request, head, size);
+	memcpy(workload.request + size, body, length);
+
+	return workload;
+}
+
+static void create_static()
+{
+	char content[STATIC_SIZE];
+
+	memset(content, 'x', sizeof(content));
+	mkdir("bench-www", 0755);
+
+	lwiot::File file("bench-www/index.html", lwiot::FileMode::Write);
+
+	assert(file);
+	file.write(content, sizeof(content));
+}
+
+int main(int argc, char **argv)
+{
+	size_t connections = argc > 1 ? strtoul(argv[1], nullptr, 10) : 4;
+	size_t requests = argc > 2 ? strtoul(argv[2], nullptr, 10) : 2000;
+	char upload[UPLOAD_SIZE + 256];
+	char head[256];
+
+	lwiot_init();
+
+	/* Connections are torn down while the other side may still write to them. */
+	signal(SIGPIPE, SIG_IGN);
+
+	if(connections == 0 || connections > MAX_CONNECTIONS || requests == 0) {
+		fprintf(stderr, "Usage: %s [connections (1-%d)] [requests per connection]\n", argv[0], MAX_CONNECTIONS);
+		return -EXIT_FAILURE;
+	}
+
+	create_static();
+
+	auto length = snprintf(upload, sizeof(upload), "--" BOUNDARY "\r\nContent-Disposition: form-data; "
+		"name=\"file\"; filename=\"data.bin\"\r\nContent-Type: application/octet-stream\r\n\r\n");
+	memset(upload + length, 'u', UPLOAD_SIZE);
+	length += UPLOAD_SIZE;
+	length += snprintf(upload + length, sizeof(upload) - length, "\r\n--" BOUNDARY "--\r\n");
+	snprintf(head, sizeof(head), "POST /upload HTTP/1.1\r\nHost: bench\r\nContent-Type: multipart/form-data; "
+		"boundary=" BOUNDARY "\r\nContent-Length: %d\r\n\r\n", length);
+
+	Workload workloads[] = {
+		make_workload("json", "GET /json HTTP/1.1\r\nHost: bench\r\nAccept: application/json\r\n\r\n", "", 0),
+		make_workload("static", "GET /static/ HTTP/1.1\r\nHost: bench\r\nAccept-Encoding: gzip\r\n\r\n", "", 0),
+		make_workload("upload", head, upload, length)
+	};
+
+	printf("HttpServer benchmark: %u connections, %u requests per connection\n\n",
+		static_cast<unsigned>(connections), static_cast<unsigned>(requests));
+	printf("%-8s %12s %10s %10s %12s %14s\n", "workload", "requests/s", "p50 (us)", "p99 (us)", "allocs/req", "copied/req (B)");
+
+	int rv = EXIT_SUCCESS;
+
+	for(auto& workload : workloads) {
+		auto result = run(workload, connections, requests);
+
+		printf("%-8s %12.0f %10.0f %10.0f %12.1f %14.0f\n", workload.name, result.rps, result.p50, result.p99,
+			result.allocations, result.copied);
+
+		if(result.failures != 0) {
+			fprintf(stderr, "%s: %u connections failed\n", workload.name, static_cast<unsigned>(result.failures));
+			rv = EXIT_FAILURE;
+		}
+
+		delete[] workload.request;
+	}
+
+	lwiot_destroy();
+	return -rv;
+}
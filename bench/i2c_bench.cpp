@@ -0,0 +1,230 @@
+/*
+ * I2C driver benchmark against simulated devices.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/kernel/clock.h>
+#include <lwiot/io/i2cbus.h>
+#include <lwiot/io/i2cmessage.h>
+#include <lwiot/io/asynci2cbus.h>
+#include <lwiot/io/i2ctransaction.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/device/eeprom24c02.h>
+#include <lwiot/device/ssd1306display.h>
+#include <lwiot/hosted/i2csimulator.h>
+#include <lwiot/hosted/i2cdevicemodels.h>
+
+#define OPS 64
+#define ASYNC_OPS 16
+#define EEPROM_BYTES 32
+
+using lwiot::hosted::I2CSimulator;
+
+/*
+ * Bus figures come from the statistics of the simulator and are the same on every run, except
+ * for drivers that poll a busy device. Host time is the time the calling thread spent, which
+ * includes waiting for devices.
+ */
+template <typename Func>
+static void run(I2CSimulator& sim, const char *name, int ops, Func&& func)
+{
+	sim.resetStatistics();
+
+	auto start = lwiot::Clock::now();
+
+	for(int idx = 0; idx < ops; idx++)
+		func();
+
+	auto end = lwiot::Clock::now();
+	auto stats = sim.statistics();
+
+	printf("%-34s %10.1f %10.1f %8.1f %12.1f %12.1f\n", name, stats.transfers / static_cast<double>(ops),
+		stats.bytes / static_cast<double>(ops), stats.nacks / static_cast<double>(ops),
+		stats.busy / 1000.0 / ops, (end - start) / 1000.0 / ops);
+}
+
+static void registerRead(lwiot::stl::Vector<lwiot::I2CMessage>& msgs, uint16_t address, uint8_t reg, size_t length)
+{
+	lwiot::I2CMessage tx(1), rx(length);
+
+	tx.setAddress(address, false, false);
+	tx.setRepeatedStart(true);
+	tx.write(reg);
+	rx.setAddress(address, false, true);
+
+	msgs.pushback(lwiot::stl::move(tx));
+	msgs.pushback(lwiot::stl::move(rx));
+}
+
+static void bench_registers(I2CSimulator& sim, lwiot::I2CBus& bus)
+{
+	run(sim, "BMP280 calibration, 12 reads", OPS, [&bus]() {
+		for(uint8_t reg = 0x88; reg < 0x88 + 24; reg += 2) {
+			lwiot::stl::Vector<lwiot::I2CMessage> msgs;
+
+			registerRead(msgs, 0x77, reg, 2);
+			bus.transfer(msgs);
+		}
+	});
+
+	run(sim, "BMP280 calibration, 1 burst", OPS, [&bus]() {
+		lwiot::stl::Vector<lwiot::I2CMessage> msgs;
+
+		registerRead(msgs, 0x77, 0x88, 24);
+		bus.transfer(msgs);
+	});
+
+	run(sim, "3 sensor reads, 3 transfers", OPS, [&bus]() {
+		const uint16_t addresses[] = { 0x77, 0x5B, 0x50 };
+		const uint8_t registers[] = { 0xF7, 0x02, 0x00 };
+
+		for(int idx = 0; idx < 3; idx++) {
+			lwiot::stl::Vector<lwiot::I2CMessage> msgs;
+
+			registerRead(msgs, addresses[idx], registers[idx], 6);
+			bus.transfer(msgs);
+		}
+	});
+
+	run(sim, "3 sensor reads, 1 transfer", OPS, [&bus]() {
+		lwiot::stl::Vector<lwiot::I2CMessage> msgs;
+
+		registerRead(msgs, 0x77, 0xF7, 6);
+		registerRead(msgs, 0x5B, 0x02, 6);
+		registerRead(msgs, 0x50, 0x00, 6);
+
+		for(auto& msg : msgs)
+			msg.setRepeatedStart(true);
+
+		msgs.back().setRepeatedStart(false);
+		bus.transfer(msgs);
+	});
+}
+
+static void bench_display(I2CSimulator& sim, lwiot::I2CBus& bus)
+{
+	lwiot::Ssd1306Display display(bus);
+	int frame = 0;
+
+	display.begin();
+
+	run(sim, "SSD1306 full frame", OPS, [&display]() {
+		display.invalidate();
+		display.display();
+	});
+
+	run(sim, "SSD1306 8x8 glyph", OPS, [&display, &frame]() {
+		display.fillRect((frame % 16) * 8, 8, 8, 8, frame & 1 ? WHITE : BLACK);
+		display.display();
+		frame++;
+	});
+
+	run(sim, "SSD1306 single pixel", OPS, [&display, &frame]() {
+		display.drawPixel(frame++ % SSD1306_LCDWIDTH, 40, INVERSE);
+		display.display();
+	});
+}
+
+static void bench_eeprom(I2CSimulator& sim, lwiot::I2CBus& bus)
+{
+	uint8_t data[EEPROM_BYTES];
+
+	for(size_t idx = 0; idx < sizeof(data); idx++)
+		data[idx] = static_cast<uint8_t>(idx);
+
+	lwiot::Eeprom24C02 eeprom(bus);
+
+	run(sim, "24C02 32 bytes, byte writes", 1, [&eeprom, &data]() {
+		for(size_t idx = 0; idx < sizeof(data); idx++) {
+			eeprom.write(0x40 + idx, &data[idx], 1);
+			eeprom.flush();
+		}
+	});
+
+	run(sim, "24C02 32 bytes, page writes", 1, [&eeprom, &data]() {
+		eeprom.write(0x40, data, sizeof(data));
+		eeprom.flush();
+	});
+}
+
+/* Real time bus, so that the caller sees what it would see on hardware. */
+static void bench_async()
+{
+	auto sim = new I2CSimulator(400000, I2CSimulator::Timing::RealTime);
+	lwiot::hosted::Bmp280Model bmp;
+	lwiot::I2CBus bus(sim);
+	lwiot::AsyncI2CBus async(bus);
+	lwiot::I2CTransaction transactions[ASYNC_OPS];
+
+	sim->attach(bmp);
+	async.begin();
+
+	for(auto& transaction : transactions) {
+		lwiot::stl::Vector<lwiot::I2CMessage> msgs;
+
+		registerRead(msgs, 0x77, 0xF7, 6);
+
+		for(auto& msg : msgs)
+			transaction.add(msg);
+	}
+
+	run(*sim, "BMP280 data, blocking", ASYNC_OPS, [&bus]() {
+		lwiot::stl::Vector<lwiot::I2CMessage> msgs;
+
+		registerRead(msgs, 0x77, 0xF7, 6);
+		bus.transfer(msgs);
+	});
+
+	int idx = 0;
+
+	run(*sim, "BMP280 data, AsyncI2CBus::submit", ASYNC_OPS, [&async, &transactions, &idx]() {
+		async.submit(transactions[idx++]);
+	});
+
+	for(auto& transaction : transactions)
+		transaction.wait();
+
+	async.end();
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t frequency = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 400000;
+
+	lwiot_init();
+
+	if(frequency == 0) {
+		fprintf(stderr, "Usage: %s [bus frequency (Hz)]\n", argv[0]);
+		return -EXIT_FAILURE;
+	}
+
+	auto sim = new I2CSimulator(frequency);
+	lwiot::hosted::Bmp280Model bmp;
+	lwiot::hosted::Ccs811Model ccs;
+	lwiot::hosted::Eeprom24C02Model eeprom;
+	lwiot::hosted::Ssd1306Model oled;
+	lwiot::I2CBus bus(sim);
+
+	sim->attach(bmp);
+	sim->attach(ccs);
+	sim->attach(eeprom);
+	sim->attach(oled);
+
+	printf("I2C benchmark: %u Hz, simulated devices, figures per operation\n\n", static_cast<unsigned>(frequency));
+	printf("%-34s %10s %10s %8s %12s %12s\n", "", "transfers", "bytes", "nacks", "bus (us)", "host (us)");
+
+	bench_registers(*sim, bus);
+	bench_display(*sim, bus);
+	bench_eeprom(*sim, bus);
+	bench_async();
+
+	lwiot_destroy();
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,635 @@
+/*
+ * AsyncMqttClient throughput and latency benchmark.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+#include <signal.h>
+
+#ifdef BENCH_WRAP_ALLOC
+#include <malloc.h>
+#endif
+
+#include <lwiot/bufferedstream.h>
+#include <lwiot/kernel/clock.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/network/asyncmqttclient.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+#include <lwiot/stl/vector.h>
+
+#define PORT 5581
+#define MAX_CLIENTS 64
+#define STAMP sizeof(uint64_t)
+#define DRAIN_TIMEOUT 10000
+
+/*
+ * Where the linker supports --wrap, malloc() and friends keep track of the number of bytes in
+ * use, which gives the heap usage of a client. Thread stacks are not part of it.
+ */
+#ifdef BENCH_WRAP_ALLOC
+static size_t heap_in_use = 0;
+
+extern "C" {
+	void *__real_malloc(size_t size);
+	void *__real_calloc(size_t num, size_t size);
+	void *__real_realloc(void *ptr, size_t size);
+	void __real_free(void *ptr);
+
+	void *__wrap_malloc(size_t size)
+	{
+		auto ptr = __real_malloc(size);
+
+		if(ptr != nullptr)
+			__atomic_fetch_add(&heap_in_use, malloc_usable_size(ptr), __ATOMIC_RELAXED);
+
+		return ptr;
+	}
+
+	void *__wrap_calloc(size_t num, size_t size)
+	{
+		auto ptr = __real_calloc(num, size);
+
+		if(ptr != nullptr)
+			__atomic_fetch_add(&heap_in_use, malloc_usable_size(ptr), __ATOMIC_RELAXED);
+
+		return ptr;
+	}
+
+	void *__wrap_realloc(void *ptr, size_t size)
+	{
+		auto old = ptr != nullptr ? malloc_usable_size(ptr) : 0;
+		auto rv = __real_realloc(ptr, size);
+
+		if(rv != nullptr || size == 0) {
+			__atomic_fetch_sub(&heap_in_use, old, __ATOMIC_RELAXED);
+			__atomic_fetch_add(&heap_in_use, rv != nullptr ? malloc_usable_size(rv) : 0, __ATOMIC_RELAXED);
+		}
+
+		return rv;
+	}
+
+	void __wrap_free(void *ptr)
+	{
+		if(ptr != nullptr)
+			__atomic_fetch_sub(&heap_in_use, malloc_usable_size(ptr), __ATOMIC_RELAXED);
+
+		__real_free(ptr);
+	}
+}
+
+static size_t heap()
+{
+	return __atomic_load_n(&heap_in_use, __ATOMIC_RELAXED);
+}
+#endif
+
+/*
+ * Minimal MQTT 3.1.1 broker: it accepts every client and forwards each PUBLISH to the sessions
+ * that subscribed to exactly its topic, always at QoS 0. QoS 1 messages are acknowledged.
+ */
+class Broker {
+public:
+	explicit Broker() : _running(false)
+	{
+	}
+
+	~Broker()
+	{
+		this->stop();
+	}
+
+	bool start(uint16_t port)
+	{
+		if(!this->_server.bind(BIND_ADDR_LB, port))
+			return false;
+
+		this->_running = true;
+		this->_acceptor.start([this]() {
+			while(this->_running) {
+				auto client = this->_server.accept();
+
+				if(!client)
+					continue;
+
+				client->setOption(SOCKET_OPT_NODELAY, 1);
+
+				auto session = new Session(lwiot::stl::move(client));
+
+				this->_lock.lock();
+				this->_sessions.pushback(session);
+				this->_lock.unlock();
+
+				session->thread.start([this, session]() {
+					this->serve(*session);
+				});
+			}
+		});
+
+		return true;
+	}
+
+	/* Close every connection, so that the clients have to reconnect. */
+	void drop()
+	{
+		lwiot::ScopedLock lock(this->_lock);
+
+		for(auto session : this->_sessions)
+			session->closing = true;
+	}
+
+	void stop()
+	{
+		if(!this->_running)
+			return;
+
+		this->_running = false;
+
+		/* Wake up accept() with a last connection. */
+		lwiot::SocketTcpClient wakeup(lwiot::IPAddress(127, 0, 0, 1), PORT);
+
+		this->_acceptor.join();
+		wakeup.close();
+		this->drop();
+
+		for(auto session : this->_sessions) {
+			session->thread.join();
+			delete session;
+		}
+
+		this->_sessions.clear();
+		this->_server.close();
+	}
+
+private:
+	struct Session {
+		explicit Session(lwiot::UniquePointer<lwiot::TcpClient>&& socket) :
+			client(lwiot::stl::move(socket)), thread("session"), closing(false)
+		{
+		}
+
+		lwiot::UniquePointer<lwiot::TcpClient> client;
+		lwiot::FunctionalThread thread;
+		lwiot::Lock lock;
+		lwiot::String topic;
+		volatile bool closing;
+	};
+
+	lwiot::SocketTcpServer _server;
+	lwiot::FunctionalThread _acceptor = lwiot::FunctionalThread("broker");
+	lwiot::Lock _lock;
+	lwiot::stl::Vector<Session*> _sessions;
+	volatile bool _running;
+
+	static bool read(lwiot::TcpClient& client, void *data, size_t length)
+	{
+		auto bytes = static_cast<uint8_t *>(data);
+
+		for(size_t idx = 0; idx < length; ) {
+			auto rv = client.read(bytes + idx, length - idx);
+
+			if(rv <= 0)
+				return false;
+
+			idx += rv;
+		}
+
+		return true;
+	}
+
+	static void send(Session& session, const uint8_t *data, size_t length)
+	{
+		lwiot::ScopedLock lock(session.lock);
+
+		if(session.client->connected())
+			session.client->write(data, length);
+	}
+
+	/* Only the session thread closes its connection, so it is never closed under its feet. */
+	void serve(Session& session)
+	{
+		this->receive(session);
+
+		lwiot::ScopedLock lock(session.lock);
+		session.client->close();
+	}
+
+	void receive(Session& session)
+	{
+		lwiot::ByteBuffer packet(1024);
+		uint8_t type, byte;
+
+		while(this->_running && !session.closing) {
+			size_t length = 0;
+			int shift = 0;
+
+			if(!session.client->readable(10))
+				continue;
+
+			if(session.closing || session.client->read(&type, 1) != 1)
+				break;
+
+			do {
+				if(session.client->read(&byte, 1) != 1)
+					return;
+
+				length |= (byte & 0x7F) << shift;
+				shift += 7;
+			} while(byte & 0x80);
+
+			packet.reserveExact(length + 5);
+			packet.setIndex(0);
+
+			if(!read(*session.client, packet.data(), length))
+				break;
+
+			auto data = packet.data();
+
+			switch(type & 0xF0) {
+			case 0x10: {
+				const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+				send(session, connack, sizeof(connack));
+				break;
+			}
+
+			case 0x80: {
+				size_t tl = (data[2] << 8) | data[3];
+				const uint8_t suback[] = { 0x90, 0x03, data[0], data[1], 0x00 };
+
+				session.topic = lwiot::String(reinterpret_cast<const char *>(data + 4), tl);
+				send(session, suback, sizeof(suback));
+				break;
+			}
+
+			case 0x30:
+				this->forward(session, type, data, length);
+				break;
+
+			case 0xC0: {
+				const uint8_t pingresp[] = { 0xD0, 0x00 };
+				send(session, pingresp, sizeof(pingresp));
+				break;
+			}
+
+			case 0xE0:
+				return;
+
+			default:
+				break;
+			}
+		}
+	}
+
+	void forward(Session& session, uint8_t type, const uint8_t *data, size_t length)
+	{
+		size_t tl = (data[0] << 8) | data[1];
+		lwiot::String topic(reinterpret_cast<const char *>(data + 2), tl);
+		size_t offset = 2 + tl;
+		uint8_t header[5];
+		size_t hlen = 1;
+
+		if(type & 0x06) {
+			const uint8_t puback[] = { 0x40, 0x02, data[offset], data[offset + 1] };
+
+			send(session, puback, sizeof(puback));
+			offset += 2;
+		}
+
+		auto payload = length - offset;
+		auto remaining = 2 + tl + payload;
+
+		header[0] = 0x30;
+
+		do {
+			header[hlen] = remaining & 0x7F;
+			remaining >>= 7;
+
+			if(remaining > 0)
+				header[hlen] |= 0x80;
+
+			hlen++;
+		} while(remaining > 0);
+
+		lwiot::ScopedLock lock(this->_lock);
+
+		for(auto target : this->_sessions) {
+			if(target->topic != topic)
+				continue;
+
+			lwiot::ScopedLock guard(target->lock);
+
+			if(!target->client->connected())
+				continue;
+
+			target->client->write(header, hlen);
+			target->client->write(data, 2 + tl);
+			target->client->write(data + offset, payload);
+		}
+	}
+};
+
+struct Client {
+	lwiot::SocketTcpClient socket;
+	lwiot::AsyncMqttClient mqtt;
+	lwiot::String topic;
+	lwiot::Atomic<size_t> received;
+	lwiot::Atomic<uint64_t> reconnected;
+	uint32_t *samples;
+	size_t capacity;
+	uint8_t stamp[STAMP];
+
+	explicit Client() : received(0), reconnected(0), samples(nullptr), capacity(0), stamp()
+	{
+	}
+
+	/* Record the latency of a message that was sent at the time in \p stamp. */
+	void record(const uint8_t *stamp)
+	{
+		uint64_t sent;
+		auto idx = this->received.load();
+
+		memcpy(&sent, stamp, sizeof(sent));
+
+		if(idx < this->capacity)
+			this->samples[idx] = static_cast<uint32_t>((lwiot::Clock::now() - sent) / 1000ULL);
+
+		this->received.fetch_add(1);
+	}
+};
+
+struct Result {
+	double rate;
+	double throughput;
+	double p50;
+	double p99;
+	size_t lost;
+};
+
+static int compare_latency(const void *a, const void *b)
+{
+	auto x = *static_cast<const uint32_t *>(a);
+	auto y = *static_cast<const uint32_t *>(b);
+
+	return x < y ? -1 : x > y;
+}
+
+static void stamp(uint8_t *payload)
+{
+	auto now = lwiot::Clock::now();
+	memcpy(payload, &now, sizeof(now));
+}
+
+/* Publishes that fit in the packet buffer are queued, larger ones are streamed. */
+static bool queued(const Client& client, size_t size)
+{
+	return size + client.topic.length() + 16 <= lwiot::MqttClient::MQTT_MAX_PACKET_SIZE;
+}
+
+static void publish(Client& client, size_t messages, size_t size)
+{
+	if(queued(client, size)) {
+		lwiot::ByteBuffer payload(size, true);
+
+		memset(payload.data(), 'p', size);
+		payload.setIndex(size);
+
+		for(size_t idx = 0; idx < messages; idx++) {
+			stamp(payload.data());
+			client.mqtt.publish(client.topic, payload, false);
+		}
+
+		return;
+	}
+
+	auto payload = new uint8_t[size];
+
+	memset(payload, 'p', size);
+
+	for(size_t idx = 0; idx < messages; idx++) {
+		lwiot::BufferedStream stream(static_cast<int>(size));
+
+		stamp(payload);
+		stream.write(payload, size);
+		client.mqtt.publish(client.topic, stream, size);
+	}
+
+	delete[] payload;
+}
+
+static Result run(Client **clients, size_t num, size_t messages, lwiot::MqttClient::QoS qos, size_t size)
+{
+	lwiot::FunctionalThread *publishers[MAX_CLIENTS];
+	auto samples = new uint32_t[num * messages];
+	size_t total = 0;
+	Result result;
+
+	for(size_t idx = 0; idx < num; idx++) {
+		clients[idx]->samples = samples + idx * messages;
+		clients[idx]->capacity = messages;
+		clients[idx]->received.store(0);
+		clients[idx]->mqtt.setQoS(clients[idx]->topic, qos);
+		publishers[idx] = new lwiot::FunctionalThread("publisher");
+	}
+
+	auto start = lwiot::Clock::now();
+
+	for(size_t idx = 0; idx < num; idx++) {
+		auto client = clients[idx];
+
+		publishers[idx]->start([client, messages, size]() {
+			publish(*client, messages, size);
+		});
+	}
+
+	for(size_t idx = 0; idx < num; idx++) {
+		publishers[idx]->join();
+		delete publishers[idx];
+	}
+
+	/* Wait for the last messages to come back. */
+	auto deadline = lwiot_tick_ms() + DRAIN_TIMEOUT;
+
+	for(size_t idx = 0; idx < num; idx++) {
+		while(clients[idx]->received.load() < messages && lwiot_tick_ms() < deadline)
+			lwiot_sleep(1);
+	}
+
+	auto elapsed = (lwiot::Clock::now() - start) / 1e9;
+
+	for(size_t idx = 0; idx < num; idx++) {
+		auto received = clients[idx]->received.load();
+
+		received = received < messages ? received : messages;
+		memmove(samples + total, clients[idx]->samples, received * sizeof(*samples));
+		total += received;
+	}
+
+	qsort(samples, total, sizeof(*samples), compare_latency);
+
+	result.rate = total / elapsed;
+	result.throughput = total * size / elapsed / (1024.0 * 1024.0);
+	result.p50 = total > 0 ? samples[total / 2] : 0;
+	result.p99 = total > 0 ? samples[total * 99 / 100] : 0;
+	result.lost = num * messages - total;
+
+	delete[] samples;
+	return result;
+}
+
+/* Time from the broker dropping the connections until every client is subscribed again. */
+static void reconnect(Broker& broker, Client **clients, size_t num)
+{
+	uint32_t times[MAX_CLIENTS];
+	size_t count = 0;
+
+	for(size_t idx = 0; idx < num; idx++)
+		clients[idx]->reconnected.store(0);
+
+	auto start = lwiot::Clock::now();
+
+	broker.drop();
+
+	auto deadline = lwiot_tick_ms() + DRAIN_TIMEOUT;
+
+	for(size_t idx = 0; idx < num; idx++) {
+		while(clients[idx]->reconnected.load() == 0 && lwiot_tick_ms() < deadline)
+			lwiot_sleep(1);
+
+		auto done = clients[idx]->reconnected.load();
+
+		if(done != 0)
+			times[count++] = static_cast<uint32_t>((done - start) / 1000000ULL);
+	}
+
+	qsort(times, count, sizeof(*times), compare_latency);
+
+	if(count == 0) {
+		printf("\nreconnect: no client reconnected\n");
+		return;
+	}
+
+	printf("\nreconnect: %u/%u clients, p50 %u ms, max %u ms\n", static_cast<unsigned>(count),
+		static_cast<unsigned>(num), times[count / 2], times[count - 1]);
+}
+
+int main(int argc, char **argv)
+{
+	const lwiot::MqttClient::QoS levels[] = { lwiot::MqttClient::QOS0, lwiot::MqttClient::QOS1 };
+	const size_t sizes[] = { 16, 256, 4096, 65536 };
+	size_t num = argc > 1 ? strtoul(argv[1], nullptr, 10) : 4;
+	size_t messages = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000;
+	const char *host = argc > 3 ? argv[3] : nullptr;
+	uint16_t port = argc > 4 ? static_cast<uint16_t>(strtoul(argv[4], nullptr, 10)) : PORT;
+	Client *clients[MAX_CLIENTS];
+	Broker broker;
+
+	lwiot_init();
+	signal(SIGPIPE, SIG_IGN);
+
+	if(num == 0 || num > MAX_CLIENTS || messages == 0) {
+		fprintf(stderr, "Usage: %s [clients (1-%d)] [messages per client] [broker host] [broker port]\n",
+			argv[0], MAX_CLIENTS);
+		return -EXIT_FAILURE;
+	}
+
+	if(host == nullptr && !broker.start(port)) {
+		fprintf(stderr, "Unable to start the broker on port %u\n", port);
+		return -EXIT_FAILURE;
+	}
+
+	auto address = host != nullptr ? lwiot::IPAddress::fromString(host) : lwiot::IPAddress(127, 0, 0, 1);
+
+	printf("MQTT benchmark: %u clients, %u messages per client, broker %s:%u%s\n\n", static_cast<unsigned>(num),
+		static_cast<unsigned>(messages), host != nullptr ? host : "127.0.0.1", port,
+		host != nullptr ? "" : " (built-in)");
+
+#ifdef BENCH_WRAP_ALLOC
+	auto before = heap();
+#endif
+
+	for(size_t idx = 0; idx < num; idx++) {
+		char name[32];
+		auto client = clients[idx] = new Client();
+
+		snprintf(name, sizeof(name), "bench/%u", static_cast<unsigned>(idx));
+		client->topic = name;
+		client->socket.connect(address, port);
+		client->socket.setOption(SOCKET_OPT_NODELAY, 1);
+
+		client->mqtt.setReconnectBackoff(10, 1000);
+		client->mqtt.setReconnectHandler([client]() {
+			client->mqtt.subscribe(client->topic, [client](const lwiot::SharedByteBuffer& data) {
+				client->record(data.data());
+			});
+			client->reconnected.store(lwiot::Clock::now());
+		});
+
+		/* Streamed payloads come in as chunks; the first bytes hold the time stamp. */
+		client->mqtt.setChunkHandler([client](const lwiot::String& topic, size_t offset, const lwiot::RawBuffer& span,
+		                                      size_t total) {
+			auto data = static_cast<const uint8_t *>(span.buffer());
+
+			for(size_t idx = offset; idx < STAMP && idx < offset + span.size(); idx++)
+				client->stamp[idx] = data[idx - offset];
+
+			if(offset + span.size() == total)
+				client->record(client->stamp);
+		});
+
+		snprintf(name, sizeof(name), "lwiot-bench-%u", static_cast<unsigned>(idx));
+
+		if(!client->mqtt.start(client->socket) || !client->mqtt.connect(name, "", "") ||
+		   !client->mqtt.subscribe(client->topic, [client](const lwiot::SharedByteBuffer& data) {
+			   client->record(data.data());
+		   })) {
+			fprintf(stderr, "Client %u could not connect\n", static_cast<unsigned>(idx));
+			return -EXIT_FAILURE;
+		}
+	}
+
+#ifdef BENCH_WRAP_ALLOC
+	printf("heap per client: %u bytes\n\n", static_cast<unsigned>((heap() - before) / num));
+#endif
+
+	printf("%-4s %8s %12s %10s %10s %10s %8s\n", "qos", "payload", "messages/s", "MB/s", "p50 (us)", "p99 (us)", "lost");
+
+	int rv = EXIT_SUCCESS;
+
+	for(auto qos : levels) {
+		for(auto size : sizes) {
+			/* Streamed publishes are always QoS 0. */
+			if(qos != lwiot::MqttClient::QOS0 && !queued(*clients[0], size))
+				continue;
+
+			auto count = queued(*clients[0], size) ? messages : (messages / 10 > 10 ? messages / 10 : 10);
+			auto result = run(clients, num, count, qos, size);
+
+			printf("%-4d %8u %12.0f %10.2f %10.0f %10.0f %8u\n", qos, static_cast<unsigned>(size), result.rate,
+				result.throughput, result.p50, result.p99, static_cast<unsigned>(result.lost));
+
+			if(qos != lwiot::MqttClient::QOS0 && result.lost != 0)
+				rv = EXIT_FAILURE;
+		}
+	}
+
+	if(host == nullptr)
+		reconnect(broker, clients, num);
+
+	for(size_t idx = 0; idx < num; idx++) {
+		clients[idx]->mqtt.stop();
+		delete clients[idx];
+	}
+
+	broker.stop();
+	lwiot_destroy();
+
+	return -rv;
+}
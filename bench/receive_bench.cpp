@@ -0,0 +1,725 @@
+/*
+ * Receive path budget benchmark.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+#include <new>
+#include <signal.h>
+#include <time.h>
+
+#include <lwiot/kernel/clock.h>
+#include <lwiot/kernel/thread.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/sharedbytebuffer.h>
+#include <lwiot/network/stdnet.h>
+#include <lwiot/network/mqttclient.h>
+#include <lwiot/network/httpserver.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+#include <lwiot/network/xbee/xbee.h>
+#include <lwiot/network/xbee/asyncxbee.h>
+#include <lwiot/network/xbee/xbeeframe.h>
+#include <lwiot/stl/string.h>
+
+#include "bench.h"
+
+#define MQTT_PORT 5584
+#define HTTP_PORT 5585
+#define WARMUP 200
+#define MAX_DEPTH 4
+#define TIMEOUT 5000
+
+#define MQTT_TOPIC "bench/sensor"
+#define MQTT_PAYLOAD 64
+#define XBEE_PAYLOAD 32
+#define HTTP_BODY "{\"id\":7,\"temperature\":21.5,\"rh\":40}"
+
+/*
+ * Every stage of a receive path has a budget per message. Allocations and copied bytes do not
+ * depend on the host, and a stage fails when it exceeds them. Cycle budgets are about twice what
+ * the time stamp counter of an x86 host measured, and may be exceeded by the tolerance.
+ */
+struct Budget {
+	double allocations;
+	double copied;
+	double cycles;
+};
+
+struct Counters {
+	uint64_t cycles;
+	uint64_t allocations;
+	uint64_t copied;
+};
+
+/* Counters are only written by the thread that runs the stage, and read by the main thread. */
+struct Stage {
+	Stage(const char *path, const char *name, const Budget& budget) :
+		path(path), name(name), budget(budget), counters(), base(), messages(1.0)
+	{
+	}
+
+	const char *path;
+	const char *name;
+	Budget budget;
+	Counters counters;
+	Counters base;
+	double messages;
+
+	Counters snapshot() const
+	{
+		Counters counters;
+
+		counters.cycles = __atomic_load_n(&this->counters.cycles, __ATOMIC_RELAXED);
+		counters.allocations = __atomic_load_n(&this->counters.allocations, __ATOMIC_RELAXED);
+		counters.copied = __atomic_load_n(&this->counters.copied, __ATOMIC_RELAXED);
+
+		return counters;
+	}
+
+	void begin()
+	{
+		this->base = this->snapshot();
+	}
+
+	void end(size_t messages)
+	{
+		auto now = this->snapshot();
+
+		this->base.cycles = now.cycles - this->base.cycles;
+		this->base.allocations = now.allocations - this->base.allocations;
+		this->base.copied = now.copied - this->base.copied;
+		this->messages = static_cast<double>(messages);
+	}
+};
+
+enum StageId {
+	MqttSocket,
+	MqttParse,
+	MqttHandler,
+	XBeeUart,
+	XBeeParse,
+	XBeeHandler,
+	HttpSocket,
+	HttpParse,
+	HttpHandler,
+	StageCount
+};
+
+static Stage stages[StageCount] = {
+	/* MqttClient asks the socket how much is available before every byte it reads. */
+	{ "MQTT", "socket -> TcpClient",        { 0, 80, 100000 } },
+	{ "MQTT", "TcpClient -> readPacket",    { 3, 168, 55000 } },
+	{ "MQTT", "handler",                    { 0, 0, 500 } },
+	{ "XBee", "UART -> AsyncXbee::receive", { 0, 48, 6000 } },
+	{ "XBee", "ring -> XBee::readPacket",   { 0, 48, 35000 } },
+	{ "XBee", "AsyncXbee handler",          { 0, 0, 500 } },
+	{ "HTTP", "socket -> TcpClient",        { 0, 125, 8000 } },
+	/* A reconnect every CONFIG_HTTP_KEEPALIVE_REQUESTS requests accepts a new client. */
+	{ "HTTP", "TcpClient -> _parseRequest", { 2.05, 87, 25000 } },
+	{ "HTTP", "handler",                    { 0, 95, 16000 } },
+};
+
+/*
+ * Each thread keeps a stack of the stages it is in. Cycles, allocations and copies are charged
+ * to the innermost stage only, so a stage does not include the stages nested in it. A stage
+ * that is not timed only collects allocations and copies.
+ */
+namespace meter
+{
+	struct Frame {
+		Stage *stage;
+		bool timed;
+	};
+
+	static thread_local Frame stack[MAX_DEPTH];
+	static thread_local int depth = 0;
+	static thread_local uint64_t mark = 0;
+	static bool tsc = false;
+	static double ticks_per_ns = 1.0;
+
+	static inline void add(uint64_t& counter, uint64_t value)
+	{
+		__atomic_store_n(&counter, __atomic_load_n(&counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+	}
+
+	static inline uint64_t ticks()
+	{
+		return tsc ? bench::cycles() : static_cast<uint64_t>(lwiot::Clock::now());
+	}
+
+	static inline void charge(uint64_t now)
+	{
+		if(depth > 0 && stack[depth - 1].timed)
+			add(stack[depth - 1].stage->counters.cycles, now - mark);
+
+		mark = now;
+	}
+
+	static void enter(Stage& stage, bool timed = true)
+	{
+		assert(depth < MAX_DEPTH);
+
+		charge(ticks());
+		stack[depth].stage = &stage;
+		stack[depth].timed = timed;
+		depth++;
+	}
+
+	static void leave()
+	{
+		charge(ticks());
+		depth--;
+	}
+
+	static inline void allocated()
+	{
+		if(depth > 0)
+			add(stack[depth - 1].stage->counters.allocations, 1);
+	}
+
+	static inline void copied(size_t length)
+	{
+		if(depth > 0)
+			add(stack[depth - 1].stage->counters.copied, length);
+	}
+
+	/* Time stamp counter ticks per nanosecond, to express CPU time in cycles. */
+	static void calibrate()
+	{
+		tsc = bench::cycles() != 0;
+
+		if(!tsc)
+			return;
+
+		auto start = lwiot::Clock::now();
+		auto cycles = bench::cycles();
+
+		while(lwiot::Clock::now() - start < 50000000ULL)
+			bench::clobber();
+
+		ticks_per_ns = static_cast<double>(bench::cycles() - cycles) /
+			static_cast<double>(lwiot::Clock::now() - start);
+	}
+
+	class ScopedStage {
+	public:
+		explicit ScopedStage(Stage& stage)
+		{
+			enter(stage);
+		}
+
+		~ScopedStage()
+		{
+			leave();
+		}
+
+		ScopedStage(const ScopedStage&) = delete;
+		ScopedStage& operator=(const ScopedStage&) = delete;
+	};
+}
+
+/*
+ * Where the linker supports --wrap, malloc() and friends are counted as well as operator new,
+ * and so are memcpy() and memmove() calls that the compiler did not inline. Copies made one
+ * byte at a time are not counted, but bytes that the kernel copies into a socket read are.
+ */
+#ifdef BENCH_WRAP_STAGES
+extern "C" {
+	void *__real_malloc(size_t size);
+	void *__real_calloc(size_t num, size_t size);
+	void *__real_realloc(void *ptr, size_t size);
+	void *__real_memcpy(void *dst, const void *src, size_t length);
+	void *__real_memmove(void *dst, const void *src, size_t length);
+
+	void *__wrap_malloc(size_t size)
+	{
+		meter::allocated();
+		return __real_malloc(size);
+	}
+
+	void *__wrap_calloc(size_t num, size_t size)
+	{
+		meter::allocated();
+		return __real_calloc(num, size);
+	}
+
+	void *__wrap_realloc(void *ptr, size_t size)
+	{
+		meter::allocated();
+		return __real_realloc(ptr, size);
+	}
+
+	void *__wrap_memcpy(void *dst, const void *src, size_t length)
+	{
+		meter::copied(length);
+		return __real_memcpy(dst, src, length);
+	}
+
+	void *__wrap_memmove(void *dst, const void *src, size_t length)
+	{
+		meter::copied(length);
+		return __real_memmove(dst, src, length);
+	}
+}
+
+/* The C++ runtime calls malloc() from a shared library, where --wrap does not reach. */
+void *operator new(size_t size)
+{
+	auto ptr = malloc(size != 0 ? size : 1);
+
+	if(ptr == nullptr)
+		throw std::bad_alloc();
+
+	return ptr;
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+	free(ptr);
+}
+#endif
+
+/* Socket client that charges the socket calls made through it to a stage. */
+class MeteredClient : public lwiot::SocketTcpClient {
+public:
+	explicit MeteredClient(Stage& stage) : SocketTcpClient(), _stage(stage)
+	{
+	}
+
+	explicit MeteredClient(socket_t *raw, Stage& stage) : SocketTcpClient(raw), _stage(stage)
+	{
+	}
+
+	size_t available() const override
+	{
+		meter::ScopedStage stage(this->_stage);
+		return SocketTcpClient::available();
+	}
+
+protected:
+	ssize_t receive(void *output, size_t length) override
+	{
+		meter::ScopedStage stage(this->_stage);
+		auto rv = SocketTcpClient::receive(output, length);
+
+		if(rv > 0)
+			meter::copied(static_cast<size_t>(rv));
+
+		return rv;
+	}
+
+private:
+	Stage& _stage;
+};
+
+class MeteredServer : public lwiot::SocketTcpServer {
+public:
+	explicit MeteredServer(uint16_t port, Stage& stage) : SocketTcpServer(BIND_ADDR_LB, port), _stage(stage)
+	{
+	}
+
+	lwiot::UniquePointer<lwiot::TcpClient> accept() override
+	{
+		auto socket = server_socket_accept(this->handle());
+
+		if(socket == nullptr)
+			return lwiot::UniquePointer<lwiot::TcpClient>();
+
+		return lwiot::UniquePointer<lwiot::TcpClient>(new MeteredClient(socket, this->_stage));
+	}
+
+private:
+	Stage& _stage;
+};
+
+static bool wait_for(const lwiot::Atomic<size_t>& counter, size_t value)
+{
+	auto start = lwiot_tick_ms();
+
+	while(counter.load(lwiot::memory_order_acquire) < value) {
+		if(lwiot_tick_ms() - start > TIMEOUT)
+			return false;
+
+		lwiot::Thread::yield();
+	}
+
+	return true;
+}
+
+/* socket -> TcpClient -> MqttClient::readPacket() -> handler */
+static bool run_mqtt(size_t messages)
+{
+	const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+	uint8_t publish[4 + sizeof(MQTT_TOPIC) - 1 + MQTT_PAYLOAD];
+	lwiot::SocketTcpServer broker;
+	MeteredClient socket(stages[MqttSocket]);
+	lwiot::MqttClient mqtt;
+	size_t received = 0;
+	size_t bytes = 0;
+
+	publish[0] = 0x30;
+	publish[1] = sizeof(publish) - 2;
+	publish[2] = 0;
+	publish[3] = sizeof(MQTT_TOPIC) - 1;
+	memcpy(publish + 4, MQTT_TOPIC, sizeof(MQTT_TOPIC) - 1);
+	memset(publish + 4 + sizeof(MQTT_TOPIC) - 1, 'm', MQTT_PAYLOAD);
+
+	if(!broker.bind(BIND_ADDR_LB, MQTT_PORT) || !socket.connect(lwiot::IPAddress(127, 0, 0, 1), MQTT_PORT))
+		return false;
+
+	auto peer = broker.accept();
+
+	if(!peer || peer->write(connack, sizeof(connack)) != sizeof(connack))
+		return false;
+
+	mqtt.begin(socket);
+	mqtt.setCallback([&](const lwiot::String& topic, const lwiot::SharedByteBuffer& payload) {
+		meter::ScopedStage stage(stages[MqttHandler]);
+
+		bytes += payload.size();
+		received++;
+	});
+
+	if(!mqtt.connect("receive-bench", "", ""))
+		return false;
+
+	for(size_t idx = 0; idx < WARMUP + messages; idx++) {
+		if(idx == WARMUP) {
+			for(int stage = MqttSocket; stage <= MqttHandler; stage++)
+				stages[stage].begin();
+		}
+
+		if(peer->write(publish, sizeof(publish)) != sizeof(publish))
+			return false;
+
+		auto start = lwiot_tick_ms();
+
+		while(received <= idx) {
+			meter::ScopedStage stage(stages[MqttParse]);
+
+			if(!mqtt.loop() || lwiot_tick_ms() - start > TIMEOUT)
+				return false;
+		}
+	}
+
+	for(int stage = MqttSocket; stage <= MqttHandler; stage++)
+		stages[stage].end(messages);
+
+	bench::doNotOptimize(bytes);
+	mqtt.disconnect();
+	peer->close();
+	broker.close();
+
+	return true;
+}
+
+static uint64_t thread_cpu_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Cost of reading the CPU time of a thread, in nanoseconds of CPU time. */
+static uint64_t thread_cpu_overhead()
+{
+	const int reads = 1000;
+	auto start = thread_cpu_ns();
+
+	for(int idx = 0; idx < reads; idx++)
+		bench::doNotOptimize(thread_cpu_ns());
+
+	return (thread_cpu_ns() - start) / (reads + 1);
+}
+
+/*
+ * UART -> AsyncXbee::receive() -> XBee::readPacket() -> frame handler
+ *
+ * The receive thread of the radio blocks between frames, so its cycles can not be taken from
+ * the time stamp counter. The thread is charged the CPU time that it used between two frame
+ * handlers instead, which includes waking up, parsing and dispatching the next frame.
+ */
+static bool run_xbee(size_t messages)
+{
+	/* begin() enables ZigBee Pro and waits for the radio to answer the AT command. */
+	const uint8_t atzs[] = { 0x7E, 0x00, 0x05, 0x88, 0x01, 'Z', 'S', 0x00, 0xC9 };
+	uint8_t frame[3 + 12 + XBEE_PAYLOAD + 1] = {
+		0x7E, 0x00, 12 + XBEE_PAYLOAD, 0x90, 0x00, 0x13, 0xA2, 0x00, 0x40, 0xA1, 0xB2, 0xC3, 0x12, 0x34, 0x01
+	};
+	lwiot::BufferedStream serial(1024);
+	lwiot::XBee xb;
+	lwiot::AsyncXbee xbee;
+	lwiot::Atomic<size_t> received(0);
+	auto overhead = thread_cpu_overhead();
+	uint8_t sum = 0;
+
+	memset(frame + 15, 'x', XBEE_PAYLOAD);
+
+	for(size_t idx = 3; idx < sizeof(frame) - 1; idx++)
+		sum += frame[idx];
+
+	frame[sizeof(frame) - 1] = 0xFF - sum;
+
+	xb.setSerial(serial);
+	xbee.setDevice(xb);
+	xbee.setReceiveMode(lwiot::AsyncXbee::ReceiveMode::Pushed);
+
+	xbee.setFrameHandler([&](const lwiot::XBeeFrame& handle) {
+		static thread_local uint64_t handled = 0;
+		auto now = thread_cpu_ns();
+
+		if(handled == 0) {
+			meter::enter(stages[XBeeParse], false);
+		} else {
+			auto used = now - handled > overhead ? now - handled - overhead : 0;
+			meter::add(stages[XBeeParse].counters.cycles, static_cast<uint64_t>(used * meter::ticks_per_ns));
+		}
+
+		{
+			meter::ScopedStage stage(stages[XBeeHandler]);
+			bench::doNotOptimize(handle.response().getFrameDataLength());
+		}
+
+		handled = thread_cpu_ns();
+		received.fetch_add(1, lwiot::memory_order_release);
+	});
+
+	xbee.receive(atzs, sizeof(atzs));
+	xbee.begin([](lwiot::XBeeResponse&) { });
+
+	for(size_t idx = 0; idx < WARMUP + messages; idx++) {
+		if(idx == WARMUP) {
+			for(int stage = XBeeUart; stage <= XBeeHandler; stage++)
+				stages[stage].begin();
+		}
+
+		{
+			meter::ScopedStage stage(stages[XBeeUart]);
+
+			if(xbee.receive(frame, sizeof(frame)) != sizeof(frame))
+				return false;
+		}
+
+		if(!wait_for(received, idx + 1))
+			return false;
+	}
+
+	for(int stage = XBeeUart; stage <= XBeeHandler; stage++)
+		stages[stage].end(messages);
+
+	return true;
+}
+
+static bool read_response(lwiot::SocketTcpClient& client, bool& close)
+{
+	char response[256];
+	size_t length = 0;
+
+	while(length < sizeof(response) - 1) {
+		auto rv = client.read(response + length, sizeof(response) - 1 - length);
+
+		if(rv <= 0)
+			return false;
+
+		length += rv;
+		response[length] = '\0';
+
+		if(strstr(response, "\r\n\r\n") != nullptr) {
+			close = strstr(response, "Connection: close") != nullptr;
+			return strncmp(response, "HTTP/1.1 204", 12) == 0;
+		}
+	}
+
+	return false;
+}
+
+/* socket -> TcpClient -> HttpServer::_parseRequest() -> handler */
+static bool run_http(size_t messages)
+{
+	lwiot::HttpServer server(new MeteredServer(HTTP_PORT, stages[HttpSocket]));
+	lwiot::SocketTcpClient client;
+	lwiot::IPAddress addr(127, 0, 0, 1);
+	char request[256];
+	size_t handled = 0;
+
+	auto length = snprintf(request, sizeof(request), "POST /sensor HTTP/1.1\r\nHost: bench\r\n"
+		"Content-Type: application/json\r\nContent-Length: %u\r\n\r\n" HTTP_BODY,
+		static_cast<unsigned>(sizeof(HTTP_BODY) - 1));
+
+	server.on("/sensor", lwiot::HTTP_POST, [&](lwiot::HttpServer& srv) {
+		meter::ScopedStage stage(stages[HttpHandler]);
+
+		handled++;
+		srv.send(204);
+	});
+
+	server.setMaxConnections(2, TIMEOUT);
+
+	if(!server.begin() || !client.connect(addr, HTTP_PORT))
+		return false;
+
+	client.setTimeout(TIMEOUT / 1000);
+
+	for(size_t idx = 0; idx < WARMUP + messages; idx++) {
+		bool close = false;
+
+		if(idx == WARMUP) {
+			for(int stage = HttpSocket; stage <= HttpHandler; stage++)
+				stages[stage].begin();
+		}
+
+		if(client.write(request, length) != length)
+			return false;
+
+		auto start = lwiot_tick_ms();
+
+		while(handled <= idx) {
+			meter::ScopedStage stage(stages[HttpParse]);
+
+			server.handleClient();
+
+			if(lwiot_tick_ms() - start > TIMEOUT)
+				return false;
+		}
+
+		if(!read_response(client, close))
+			return false;
+
+		/* The server closes a connection after CONFIG_HTTP_KEEPALIVE_REQUESTS requests. */
+		if(close) {
+			client.close();
+
+			if(!client.connect(addr, HTTP_PORT))
+				return false;
+		}
+	}
+
+	for(int stage = HttpSocket; stage <= HttpHandler; stage++)
+		stages[stage].end(messages);
+
+	client.close();
+	server.close();
+
+	return true;
+}
+
+static bool report(double tolerance, bool cycles)
+{
+	bool ok = true;
+
+	printf("%-5s %-27s %11s %7s %11s %7s %12s %8s\n", "path", "stage", "allocs/msg", "budget",
+		"copied/msg", "budget", meter::tsc ? "cycles/msg" : "ns/msg", "budget");
+
+	for(auto& stage : stages) {
+		auto allocations = static_cast<double>(stage.base.allocations) / stage.messages;
+		auto copied = static_cast<double>(stage.base.copied) / stage.messages;
+		auto used = static_cast<double>(stage.base.cycles) / stage.messages;
+		bool over = allocations > stage.budget.allocations + 0.005 || copied > stage.budget.copied + 0.5;
+
+		if(cycles && used > stage.budget.cycles * (1.0 + tolerance / 100.0))
+			over = true;
+
+		printf("%-5s %-27s %11.2f %7.2f %11.1f %7.0f %12.0f %8.0f %s\n", stage.path, stage.name,
+			allocations, stage.budget.allocations, copied, stage.budget.copied, used, stage.budget.cycles,
+			over ? "OVER" : "ok");
+
+		if(over)
+			ok = false;
+	}
+
+	return ok;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [options]\n\n"
+			"  --messages <n>    Messages per path (default 20000)\n"
+			"  --tolerance <%%>   Cycles a stage may use over its budget (default 25)\n"
+			"  --no-cycles       Only check allocations and copies\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	size_t messages = 20000;
+	double tolerance = 25.0;
+	bool cycles = true;
+
+	for(int idx = 1; idx < argc; idx++) {
+		if(strcmp(argv[idx], "--messages") == 0 && idx + 1 < argc) {
+			messages = strtoul(argv[++idx], nullptr, 10);
+		} else if(strcmp(argv[idx], "--tolerance") == 0 && idx + 1 < argc) {
+			tolerance = atof(argv[++idx]);
+		} else if(strcmp(argv[idx], "--no-cycles") == 0) {
+			cycles = false;
+		} else {
+			usage(argv[0]);
+			return -EXIT_FAILURE;
+		}
+	}
+
+	if(messages == 0 || tolerance < 0) {
+		usage(argv[0]);
+		return -EXIT_FAILURE;
+	}
+
+	lwiot_init();
+
+	/* Connections are torn down while the other side may still write to them. */
+	signal(SIGPIPE, SIG_IGN);
+	meter::calibrate();
+
+	printf("Receive path budget: %u messages per path", static_cast<unsigned>(messages));
+
+	if(meter::tsc)
+		printf(", cycles at %.2f GHz", meter::ticks_per_ns);
+
+	printf("\n\n");
+	fflush(stdout);
+
+	if(!run_mqtt(messages) || !run_xbee(messages) || !run_http(messages)) {
+		fprintf(stderr, "A receive path did not complete.\n");
+		lwiot_destroy();
+		return -EXIT_FAILURE;
+	}
+
+	auto ok = report(tolerance, cycles && meter::tsc);
+
+	printf("\nCopies include bytes read from a socket. The HTTP handler includes sending the response, and "
+		"one in %d HTTP requests includes a reconnect.\n", CONFIG_HTTP_KEEPALIVE_REQUESTS);
+
+	fflush(stdout);
+
+	if(!ok)
+		fprintf(stderr, "A receive path stage is over its budget.\n");
+
+	lwiot_destroy();
+	return ok ? -EXIT_SUCCESS : -EXIT_FAILURE;
+}
@@ -0,0 +1,331 @@
+/*
+ * Container and utility microbenchmarks.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/bufferedstream.h>
+#include <lwiot/sharedpointer.h>
+#include <lwiot/stl/map.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/skiplist.h>
+#include <lwiot/stl/linkedlist.h>
+
+#include "bench.h"
+
+#define ELEMENTS 1000
+#define MAP_ELEMENTS 100
+#define STREAM_CHUNK 32
+
+static void bench_vector(bench::Runner& runner)
+{
+	runner.run("Vector::push_back", ELEMENTS, []() {
+		lwiot::stl::Vector<int> vector;
+
+		for(int idx = 0; idx < ELEMENTS; idx++)
+			vector.push_back(idx);
+
+		bench::doNotOptimize(vector);
+	});
+
+	runner.run("Vector::push_back reserved", ELEMENTS, []() {
+		lwiot::stl::Vector<int> vector;
+
+		vector.reserve(ELEMENTS);
+
+		for(int idx = 0; idx < ELEMENTS; idx++)
+			vector.push_back(idx);
+
+		bench::doNotOptimize(vector);
+	});
+
+	lwiot::stl::Vector<int> filled;
+
+	for(int idx = 0; idx < ELEMENTS; idx++)
+		filled.push_back(idx);
+
+	runner.run("Vector iterate", ELEMENTS, [&filled]() {
+		long sum = 0;
+
+		for(auto value : filled)
+			sum += value;
+
+		bench::doNotOptimize(sum);
+	});
+}
+
+static void bench_string(bench::Runner& runner)
+{
+	runner.run("String construct", ELEMENTS, []() {
+		for(int idx = 0; idx < ELEMENTS; idx++) {
+			lwiot::String str("a string that does not fit a small buffer");
+			bench::doNotOptimize(str);
+		}
+	});
+
+	runner.run("String += char", ELEMENTS, []() {
+		lwiot::String str;
+
+		for(int idx = 0; idx < ELEMENTS; idx++)
+			str += 'x';
+
+		bench::doNotOptimize(str);
+	});
+
+	runner.run("String += literal", ELEMENTS / 10, []() {
+		lwiot::String str;
+
+		for(int idx = 0; idx < ELEMENTS / 10; idx++)
+			str += "0123456789";
+
+		bench::doNotOptimize(str);
+	});
+
+	lwiot::String a("/api/v1/sensors/temperature");
+	lwiot::String b("/api/v1/sensors/temperaturf");
+
+	runner.run("String compare", ELEMENTS, [&a, &b]() {
+		int equal = 0;
+
+		for(int idx = 0; idx < ELEMENTS; idx++) {
+			bench::clobber();
+			equal += a == b;
+		}
+
+		bench::doNotOptimize(equal);
+	});
+}
+
+static void bench_map(bench::Runner& runner)
+{
+	runner.run("Map::add", MAP_ELEMENTS, []() {
+		lwiot::stl::Map<int, int> map;
+
+		for(int idx = 0; idx < MAP_ELEMENTS; idx++)
+			map.add(idx, idx);
+
+		bench::doNotOptimize(map);
+	});
+
+	lwiot::stl::Map<int, int> map;
+
+	for(int idx = 0; idx < MAP_ELEMENTS; idx++)
+		map.add(idx, idx);
+
+	runner.run("Map::find", MAP_ELEMENTS, [&map]() {
+		int found = 0;
+
+		for(int idx = 0; idx < MAP_ELEMENTS; idx++)
+			found += map.contains(idx);
+
+		bench::doNotOptimize(found);
+	});
+}
+
+static void bench_skiplist(bench::Runner& runner)
+{
+	runner.run("SkipList::insert", ELEMENTS, []() {
+		lwiot::stl::SkipList<int, int> list;
+
+		for(int idx = 0; idx < ELEMENTS; idx++)
+			list.insert(idx * 7 % ELEMENTS, idx);
+
+		bench::doNotOptimize(list);
+	});
+
+	runner.run("SkipList::insert slab", ELEMENTS, []() {
+		lwiot::stl::SkipList<int, int, 8> list;
+
+		list.reserve(ELEMENTS);
+
+		for(int idx = 0; idx < ELEMENTS; idx++)
+			list.insert(idx * 7 % ELEMENTS, idx);
+
+		bench::doNotOptimize(list);
+	});
+
+	lwiot::stl::SkipList<int, int> list;
+
+	for(int idx = 0; idx < ELEMENTS; idx++)
+		list.insert(idx, idx);
+
+	runner.run("SkipList::at", ELEMENTS, [&list]() {
+		long sum = 0;
+
+		for(int idx = 0; idx < ELEMENTS; idx++)
+			sum += list.at(idx * 7 % ELEMENTS);
+
+		bench::doNotOptimize(sum);
+	});
+}
+
+static void bench_linkedlist(bench::Runner& runner)
+{
+	runner.run("LinkedList::push_back", ELEMENTS, []() {
+		lwiot::stl::LinkedList<int> list;
+
+		for(int idx = 0; idx < ELEMENTS; idx++)
+			list.push_back(idx);
+
+		bench::doNotOptimize(list);
+	});
+
+	lwiot::stl::LinkedList<int> list;
+
+	for(int idx = 0; idx < ELEMENTS; idx++)
+		list.push_back(idx);
+
+	runner.run("LinkedList iterate", ELEMENTS, [&list]() {
+		long sum = 0;
+
+		for(auto value : list)
+			sum += value;
+
+		bench::doNotOptimize(sum);
+	});
+}
+
+static void bench_bytebuffer(bench::Runner& runner)
+{
+	runner.run("ByteBuffer::write byte", ELEMENTS, []() {
+		lwiot::ByteBuffer buffer;
+
+		for(int idx = 0; idx < ELEMENTS; idx++)
+			buffer.write(static_cast<uint8_t>(idx));
+
+		bench::doNotOptimize(buffer);
+	});
+
+	runner.run("ByteBuffer::write sized", ELEMENTS, []() {
+		lwiot::ByteBuffer buffer(ELEMENTS, true);
+
+		for(int idx = 0; idx < ELEMENTS; idx++)
+			buffer.write(static_cast<uint8_t>(idx));
+
+		bench::doNotOptimize(buffer);
+	});
+}
+
+static void bench_bufferedstream(bench::Runner& runner)
+{
+	lwiot::BufferedStream stream(ELEMENTS * STREAM_CHUNK);
+	uint8_t chunk[STREAM_CHUNK] = { 0 };
+
+	runner.run("BufferedStream write+read 32B", ELEMENTS, [&stream, &chunk]() {
+		for(int idx = 0; idx < ELEMENTS; idx++) {
+			stream.write(chunk, sizeof(chunk));
+			stream.read(chunk, sizeof(chunk));
+		}
+
+		bench::doNotOptimize(chunk);
+	});
+}
+
+static int add_one(int value)
+{
+	return value + 1;
+}
+
+static void bench_function(bench::Runner& runner)
+{
+	lwiot::Function<int(int)> pointer(add_one);
+	int offset = 1;
+	lwiot::Function<int(int)> lambda([offset](int value) {
+		return value + offset;
+	});
+
+	runner.run("Function call pointer", ELEMENTS, [&pointer]() {
+		int value = 0;
+
+		for(int idx = 0; idx < ELEMENTS; idx++)
+			value = pointer(value);
+
+		bench::doNotOptimize(value);
+	});
+
+	runner.run("Function call lambda", ELEMENTS, [&lambda]() {
+		int value = 0;
+
+		for(int idx = 0; idx < ELEMENTS; idx++)
+			value = lambda(value);
+
+		bench::doNotOptimize(value);
+	});
+
+	runner.run("Function construct", ELEMENTS, [offset]() {
+		for(int idx = 0; idx < ELEMENTS; idx++) {
+			lwiot::Function<int(int)> func([offset, idx](int value) {
+				return value + offset + idx;
+			});
+
+			bench::doNotOptimize(func);
+		}
+	});
+}
+
+static void bench_sharedpointer(bench::Runner& runner)
+{
+	runner.run("makeShared", ELEMENTS, []() {
+		for(int idx = 0; idx < ELEMENTS; idx++) {
+			auto ptr = lwiot::makeShared<int>(idx);
+			bench::doNotOptimize(ptr);
+		}
+	});
+
+	runner.run("SharedPointer(new)", ELEMENTS, []() {
+		for(int idx = 0; idx < ELEMENTS; idx++) {
+			lwiot::SharedPointer<int> ptr(new int(idx));
+			bench::doNotOptimize(ptr);
+		}
+	});
+
+	auto shared = lwiot::makeShared<int>(1);
+
+	runner.run("SharedPointer copy", ELEMENTS, [&shared]() {
+		for(int idx = 0; idx < ELEMENTS; idx++) {
+			auto copy = shared;
+			bench::doNotOptimize(copy);
+		}
+	});
+}
+
+/*
+ * Runs every benchmark in this file. Firmware that cannot use main() calls this from its main
+ * thread, and reads the results from the UART.
+ */
+void stl_bench()
+{
+	bench::Runner runner;
+
+	runner.header();
+	bench_vector(runner);
+	bench_string(runner);
+	bench_map(runner);
+	bench_skiplist(runner);
+	bench_linkedlist(runner);
+	bench_bytebuffer(runner);
+	bench_bufferedstream(runner);
+	bench_function(runner);
+	bench_sharedpointer(runner);
+}
+
+#ifndef BENCH_NO_MAIN
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	stl_bench();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
+#endif
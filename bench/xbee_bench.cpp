@@ -0,0 +1,255 @@
+/*
+ * AsyncXbee coordinator benchmark against a simulated mesh.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/kernel/clock.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/network/xbee/xbee.h>
+#include <lwiot/network/xbee/asyncxbee.h>
+#include <lwiot/network/xbee/xbeeframe.h>
+#include <lwiot/hosted/xbeesimulator.h>
+
+#define MAX_SAMPLES 1000000
+#define TX_FRAMES 200
+#define PAYLOAD 32
+
+struct RxResult {
+	double offered;
+	double rate;
+	double p50;
+	double p99;
+	size_t lost;
+};
+
+struct TxResult {
+	double rate;
+	double p50;
+	double p99;
+	size_t failed;
+};
+
+static int compare_latency(const void *a, const void *b)
+{
+	auto x = *static_cast<const uint32_t *>(a);
+	auto y = *static_cast<const uint32_t *>(b);
+
+	return x < y ? -1 : x > y;
+}
+
+/*
+ * The coordinator side: an AsyncXbee in pushed mode, fed by the simulator like a UART driver
+ * would feed it. Data that does not fit in the receive ring within a few milliseconds is lost,
+ * as it would be on a real UART.
+ */
+class Coordinator {
+public:
+	explicit Coordinator(const lwiot::hosted::XBeeSimulator::Config& config) :
+		sim(config), received(0), overrun(0), samples(new uint32_t[MAX_SAMPLES])
+	{
+		this->xb.setSerial(this->sim);
+		this->xbee.setDevice(this->xb);
+		this->xbee.setReceiveMode(lwiot::AsyncXbee::ReceiveMode::Pushed);
+
+		this->sim.setReceiver([this](const uint8_t *data, size_t length) {
+			this->push(data, length);
+		});
+
+		this->xbee.setFrameHandler([this](const lwiot::XBeeFrame& frame) {
+			this->record(frame);
+		});
+
+		this->xbee.begin([](lwiot::XBeeResponse&) { });
+	}
+
+	~Coordinator()
+	{
+		/* The simulator may still be emitting; the XBee goes first. */
+		this->sim.stop();
+		this->sim.setReceiver([](const uint8_t *, size_t) { });
+		delete[] this->samples;
+	}
+
+	lwiot::hosted::XBeeSimulator sim;
+	lwiot::XBee xb;
+	lwiot::AsyncXbee xbee;
+	lwiot::Atomic<size_t> received;
+	lwiot::Atomic<size_t> overrun;
+	uint32_t *samples;
+
+private:
+	void push(const uint8_t *data, size_t length)
+	{
+		for(int attempt = 0; length > 0 && attempt < 5; attempt++) {
+			auto rv = this->xbee.receive(data, length);
+
+			data += rv;
+			length -= rv;
+
+			if(length > 0)
+				lwiot_sleep(1);
+		}
+
+		this->overrun.fetch_add(length);
+	}
+
+	/* Only the receive thread of the XBee runs this. */
+	void record(const lwiot::XBeeFrame& frame)
+	{
+		auto& response = frame.response();
+		lwiot::ZBRxResponse rx;
+		uint64_t sent;
+
+		if(response.getApiId() != ZB_RX_RESPONSE)
+			return;
+
+		response.getZBRxResponse(rx);
+
+		if(rx.getDataLength() < sizeof(sent))
+			return;
+
+		auto idx = this->received.load();
+
+		memcpy(&sent, rx.getData(), sizeof(sent));
+
+		if(idx < MAX_SAMPLES)
+			this->samples[idx] = static_cast<uint32_t>((lwiot::Clock::now() - sent) / 1000ULL);
+
+		this->received.fetch_add(1);
+	}
+};
+
+static RxResult receive(Coordinator& coordinator, int seconds)
+{
+	RxResult result;
+
+	coordinator.received.store(0);
+
+	auto before = coordinator.sim.statistics();
+	auto start = lwiot::Clock::now();
+
+	coordinator.sim.start();
+	lwiot_sleep(seconds * 1000);
+	coordinator.sim.stop();
+
+	/* Let the receive thread catch up with what is in flight. */
+	lwiot_sleep(100);
+
+	auto elapsed = (lwiot::Clock::now() - start) / 1e9;
+	auto after = coordinator.sim.statistics();
+	size_t total = coordinator.received.load();
+	auto generated = static_cast<size_t>(after.generated - before.generated);
+	auto count = total < MAX_SAMPLES ? total : MAX_SAMPLES;
+
+	qsort(coordinator.samples, count, sizeof(*coordinator.samples), compare_latency);
+
+	result.offered = (after.generated + after.lost - before.generated - before.lost) / elapsed;
+	result.rate = total / elapsed;
+	result.p50 = count > 0 ? coordinator.samples[count / 2] : 0;
+	result.p99 = count > 0 ? coordinator.samples[count * 99 / 100] : 0;
+	result.lost = static_cast<size_t>(after.lost - before.lost) + (generated > total ? generated - total : 0);
+
+	return result;
+}
+
+static TxResult transmit(Coordinator& coordinator, size_t nodes)
+{
+	auto latencies = new uint32_t[TX_FRAMES];
+	lwiot::Atomic<size_t> done(0);
+	lwiot::Atomic<size_t> failed(0);
+	lwiot::ByteBuffer payload(PAYLOAD, true);
+	TxResult result;
+
+	memset(payload.data(), 'x', PAYLOAD);
+	payload.setIndex(PAYLOAD);
+
+	auto start = lwiot::Clock::now();
+
+	for(size_t idx = 0; idx < TX_FRAMES; idx++) {
+		lwiot::ZigbeeAddress address;
+		auto sent = lwiot::Clock::now();
+
+		address.setAddress64(lwiot::hosted::XBeeSimulator::address(idx % nodes));
+
+		coordinator.xbee.transmit(address, payload, [&, sent](bool delivered) {
+			auto slot = done.fetch_add(1);
+
+			latencies[slot] = static_cast<uint32_t>((lwiot::Clock::now() - sent) / 1000000ULL);
+
+			if(!delivered)
+				failed.fetch_add(1);
+		});
+	}
+
+	/* Every frame is delivered or given up after its retries, which the handlers rely on. */
+	coordinator.xbee.flush();
+
+	auto elapsed = (lwiot::Clock::now() - start) / 1e9;
+	auto count = done.load();
+
+	qsort(latencies, count, sizeof(*latencies), compare_latency);
+
+	result.rate = (count - failed.load()) / elapsed;
+	result.p50 = count > 0 ? latencies[count / 2] : 0;
+	result.p99 = count > 0 ? latencies[count * 99 / 100] : 0;
+	result.failed = failed.load() + TX_FRAMES - count;
+
+	delete[] latencies;
+	return result;
+}
+
+int main(int argc, char **argv)
+{
+	const size_t networks[] = { 1, 50, 500 };
+	double rate = argc > 1 ? strtod(argv[1], nullptr) : 2.0;
+	time_t latency = argc > 2 ? strtol(argv[2], nullptr, 10) : 20;
+	double loss = argc > 3 ? strtod(argv[3], nullptr) : 0.01;
+	size_t baud = argc > 4 ? strtoul(argv[4], nullptr, 10) : 115200;
+	int seconds = argc > 5 ? static_cast<int>(strtol(argv[5], nullptr, 10)) : 3;
+
+	lwiot_init();
+
+	if(rate <= 0 || latency < 0 || loss < 0 || loss >= 1 || seconds <= 0) {
+		fprintf(stderr, "Usage: %s [frames/s per node] [latency (ms)] [loss (0-1)] [baud rate, 0 for no limit] "
+			"[seconds]\n", argv[0]);
+		return -EXIT_FAILURE;
+	}
+
+	printf("XBee benchmark: %.1f frames/s per node, %u ms latency, %.1f%% loss, %u baud, %d s per run\n\n",
+		rate, static_cast<unsigned>(latency), loss * 100, static_cast<unsigned>(baud), seconds);
+	printf("%6s %10s %10s %10s %10s %8s %9s %10s %10s %10s %8s\n", "nodes", "offered/s", "frames/s",
+		"p50 (us)", "p99 (us)", "lost", "overrun", "tx/s", "p50 (ms)", "p99 (ms)", "failed");
+
+	for(auto nodes : networks) {
+		lwiot::hosted::XBeeSimulator::Config config;
+
+		config.nodes = nodes;
+		config.rate = rate;
+		config.payload = PAYLOAD;
+		config.latency = latency;
+		config.loss = loss;
+		config.throughput = baud / 10;
+		config.echo = false;
+
+		auto coordinator = new Coordinator(config);
+		auto rx = receive(*coordinator, seconds);
+		auto tx = transmit(*coordinator, nodes);
+
+		printf("%6u %10.0f %10.0f %10.0f %10.0f %8u %9u %10.0f %10.0f %10.0f %8u\n", static_cast<unsigned>(nodes),
+			rx.offered, rx.rate, rx.p50, rx.p99, static_cast<unsigned>(rx.lost),
+			static_cast<unsigned>(coordinator->overrun.load()), tx.rate, tx.p50, tx.p99,
+			static_cast<unsigned>(tx.failed));
+
+		delete coordinator;
+	}
+
+	lwiot_destroy();
+	return -EXIT_SUCCESS;
+}
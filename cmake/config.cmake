@@ -6,7 +6,12 @@ endif()
 
 SET(HAVE_DEBUG False CACHE BOOL "Enable debug output.")
 SET(CONFIG_BUILD_TESTS False CACHE BOOL "Build unit tests.")
+SET(CONFIG_BUILD_BENCHMARKS False CACHE BOOL "Build benchmarks.")
 SET(CONFIG_PIN_VECTOR False CACHE BOOL "Build a vector of pins the the GPIO chip.")
+SET(HAVE_TLS_SESSIONS False CACHE BOOL "The TLS binding supports session resumption.")
+SET(CONFIG_XBEE_PROFILING False CACHE BOOL "Time and count the XBee receive path.")
+SET(CONFIG_TRACE False CACHE BOOL "Record TRACE_SPAN tracing spans.")
+SET(CONFIG_ALLOC_TRACKING False CACHE BOOL "Count heap allocations for ScopedAllocationGuard.")
 
 SET(CONFIG_SSD1306_128_64 True CACHE BOOL "SSD1306 in 128x64 mode")
 SET(CONFIG_SSD1306_128_32 False CACHE BOOL "SSD1306 in 128x32 mode")
@@ -0,0 +1,20 @@
+
+find_package(PythonInterp 3)
+
+#
+# Write the token database of a tokenized logging target to <target file>.tokens.csv after
+# every build. scripts/detokenize.py decodes logs against the database, or against the
+# image itself.
+#
+function(lwiot_log_tokens target)
+	if(NOT PYTHONINTERP_FOUND)
+		message(WARNING "No Python interpreter found, not writing the token database of ${target}.")
+		return()
+	endif()
+
+	add_custom_command(TARGET ${target} POST_BUILD
+		COMMAND ${PYTHON_EXECUTABLE} ${PROJECT_SOURCE_DIR}/scripts/detokenize.py tokens
+			$<TARGET_FILE:${target}> -o $<TARGET_FILE:${target}>.tokens.csv
+		COMMENT "Writing the token database of ${target}"
+		VERBATIM)
+endfunction()
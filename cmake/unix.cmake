@@ -3,9 +3,23 @@ find_path(MBEDTLS_INCLUDE_DIRS mbedtls/ssl.h)
 SET(UNIX True)
 SET(LWIOT_SYSTEM_LIBS ${LWIOT_SYSTEM_LIBS} ${CMAKE_THREAD_LIBS_INIT} mbedtls mbedx509 mbedcrypto)
 
+find_package(ZLIB)
+
+if(ZLIB_FOUND)
+	SET(HAVE_ZLIB True)
+	SET(LWIOT_SYSTEM_LIBS ${LWIOT_SYSTEM_LIBS} ${ZLIB_LIBRARIES})
+	SET(EXTRA_INCLUDE_DIRECTORIES ${EXTRA_INCLUDE_DIRECTORIES} ${ZLIB_INCLUDE_DIRS})
+endif()
+
 SET(HAVE_JSON True CACHE BOOL "Build JSON library")
 SET(HAVE_NETWORKING True)
-SET(HAVE_SYNC_FETCH True)
+SET(CONFIG_WORK_STEALING True CACHE BOOL "Use work stealing executors.")
+
+CHECK_INCLUDE_FILES(linux/io_uring.h HAVE_IO_URING_H)
+
+if(HAVE_IO_URING_H)
+	SET(CONFIG_IO_URING True CACHE BOOL "Build the io_uring socket and file I/O backend.")
+endif()
 
 SET(PORT_C_FLAGS "-fstack-protector -Wextra -Wno-error=unused-function -Wno-error=unused-but-set-variable \
 	-Wno-error=unused-variable -Wno-error=deprecated-declarations -Wextra -Wno-unused-parameter -Wno-sign-compare \
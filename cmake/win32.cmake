@@ -7,10 +7,16 @@ SET(PORT_INCLUDE_DIR
 SET(PLATFORM_DIRECTORY ${PROJECT_SOURCE_DIR}/source/platform/win32)
 
 find_package(Threads REQUIRED)
-SET(LWIOT_SYSTEM_LIBS ${LWIOT_SYSTEM_LIBS} ${CMAKE_THREAD_LIBS_INIT})
+SET(LWIOT_SYSTEM_LIBS ${LWIOT_SYSTEM_LIBS} ${CMAKE_THREAD_LIBS_INIT} bcrypt)
 
 SET(HAVE_JSON True CACHE BOOL "Build JSON library")
 SET(HAVE_NETWORKING True)
 
+if(MINGW)
+	SET(CONFIG_WORK_STEALING True CACHE BOOL "Use work stealing executors.")
+endif()
+
+SET(CONFIG_WIN32_IOCP True CACHE BOOL "Wait for socket events on an I/O completion port.")
+
 SET(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} ")
 SET(CONFIG_BUILD_TESTS True)
@@ -32,6 +32,13 @@ namespace lwiot { namespace json
 
 		virtual size_t write(uint8_t) = 0;
 
+		/**
+		 * @brief Write \p size bytes at once.
+		 *
+		 * The default writes them one by one, printers that can copy a block in one go override it.
+		 */
+		virtual size_t write(const uint8_t *buffer, size_t size);
+
 		size_t print(const char *s);
 
 		size_t print(ArduinoJson::Internals::JsonFloat value, int digits = 2);
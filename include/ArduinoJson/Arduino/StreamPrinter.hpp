@@ -0,0 +1,74 @@
+/*
+ * Buffered ArduinoJson printers.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Printer.hpp"
+
+#ifndef CONFIG_JSON_PRINT_BUFFER
+#define CONFIG_JSON_PRINT_BUFFER 64
+#endif
+
+namespace lwiot
+{
+	class Stream;
+}
+
+namespace lwiot { namespace json
+{
+	/**
+	 * @brief Printer that collects its output in a small buffer and hands it on in blocks.
+	 *
+	 * Output is lost after emit() has failed once, which failed() reports. Derived classes
+	 * should call flush() from their destructor.
+	 */
+	class BufferedPrinter : public Printer {
+	public:
+		explicit BufferedPrinter();
+
+		size_t write(uint8_t c) override;
+		size_t write(const uint8_t *buffer, size_t size) override;
+
+		/**
+		 * @brief Pass on the buffered output.
+		 * @return False if any output was lost.
+		 */
+		bool flush();
+
+		bool failed() const
+		{
+			return this->_failed;
+		}
+
+	protected:
+		virtual bool emit(const uint8_t *data, size_t length) = 0;
+
+	private:
+		uint8_t _buffer[CONFIG_JSON_PRINT_BUFFER];
+		size_t _length;
+		bool _failed;
+	};
+
+	/**
+	 * @brief Printer that writes to a Stream, such as a TcpClient.
+	 */
+	class StreamPrinter : public BufferedPrinter {
+	public:
+		explicit StreamPrinter(Stream& stream);
+		~StreamPrinter() override;
+
+	protected:
+		bool emit(const uint8_t *data, size_t length) override;
+
+	private:
+		Stream& _stream;
+	};
+}
+}
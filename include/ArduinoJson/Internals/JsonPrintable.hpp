@@ -8,6 +8,7 @@
 #pragma once
 
 #include "../Configuration.hpp"
+#include "../Arduino/StreamPrinter.hpp"
 #include "DummyPrint.hpp"
 #include "IndentedPrint.hpp"
 #include "JsonWriter.hpp"
@@ -53,6 +54,14 @@ class JsonPrintable {
     return printTo(sb);
   }
 
+  // Writes straight to the stream, through a small buffer.
+  // Returns 0 if the stream did not take all of it.
+  size_t printTo(lwiot::Stream &stream) const {
+    lwiot::json::StreamPrinter printer(stream);
+    size_t n = printTo(printer);
+    return printer.flush() ? n : 0;
+  }
+
   size_t prettyPrintTo(IndentedPrint &print) const {
     Prettyfier p(print);
     return printTo(p);
@@ -73,6 +82,12 @@ class JsonPrintable {
     return prettyPrintTo(sb);
   }
 
+  size_t prettyPrintTo(lwiot::Stream &stream) const {
+    lwiot::json::StreamPrinter printer(stream);
+    size_t n = prettyPrintTo(printer);
+    return printer.flush() ? n : 0;
+  }
+
   size_t measureLength() const {
     DummyPrint dp;
     return printTo(dp);
@@ -48,7 +48,16 @@ class JsonWriter {
       write("null");
     } else {
       write('\"');
-      while (*value) writeChar(*value++);
+      while (*value) {
+        // pass on the characters that need no escaping in one go
+        const char *run = value;
+        while (*value && !Encoding::escapeChar(*value)) value++;
+        if (value != run) {
+          _length += _sink.write(reinterpret_cast<const uint8_t *>(run),
+                                 static_cast<size_t>(value - run));
+        }
+        if (*value) writeChar(*value++);
+      }
       write('\"');
     }
   }
@@ -0,0 +1,19 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+namespace ArduinoJson {
+namespace Internals {
+// Returns a pointer to the first quote, backslash or NUL at or after ptr
+const char *scanString(const char *ptr, char quote);
+
+// Returns a pointer to the first character at or after ptr that is not a
+// space, tab, carriage return or line feed
+const char *scanSpaces(const char *ptr);
+}
+}
@@ -21,6 +21,7 @@ class StaticStringBuilder : public Print {
   }
 
   virtual size_t write(uint8_t c);
+  virtual size_t write(const uint8_t *data, size_t size);
 
  private:
   char *buffer;
@@ -0,0 +1,91 @@
+/*
+ * Scatter/gather buffer chain.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#include <lwiot/bytebuffer.h>
+#include <lwiot/stl/smallvector.h>
+
+#ifdef __cplusplus
+namespace lwiot
+{
+	/**
+	 * @brief List of memory segments that are sent as a single message.
+	 *
+	 * A chain references memory owned by someone else: appending a segment does not copy it, so
+	 * every segment must remain valid until the chain has been written. Sockets that support it
+	 * send a chain using a single gathered write.
+	 */
+	class BufferChain {
+	public:
+		typedef stl::Vector<RawBuffer>::const_iterator const_iterator;
+
+		static constexpr size_t InlineSegments = 4;
+
+		explicit BufferChain();
+		explicit BufferChain(size_t segments);
+
+		BufferChain(const BufferChain& other) = default;
+		BufferChain(BufferChain&& other) noexcept = default;
+		~BufferChain() = default;
+
+		BufferChain& operator =(const BufferChain& rhs) = default;
+		BufferChain& operator =(BufferChain&& rhs) noexcept = default;
+
+		BufferChain& append(const void *data, size_t length);
+		BufferChain& append(const RawBuffer& raw);
+		BufferChain& append(const ByteBuffer& buffer);
+
+		void clear();
+
+		/**
+		 * @brief Copy the contents of the chain into a contiguous buffer.
+		 * @param output Output buffer.
+		 * @param length Size of \p output.
+		 * @return The number of bytes copied.
+		 */
+		size_t copyTo(void *output, size_t length) const;
+
+		const RawBuffer& operator[](size_t idx) const
+		{
+			return this->_segments[idx];
+		}
+
+		constexpr size_t segments() const
+		{
+			return this->_segments.size();
+		}
+
+		constexpr size_t length() const
+		{
+			return this->_length;
+		}
+
+		constexpr bool empty() const
+		{
+			return this->_length == 0;
+		}
+
+		const_iterator begin() const
+		{
+			return this->_segments.begin();
+		}
+
+		const_iterator end() const
+		{
+			return this->_segments.end();
+		}
+
+	private:
+		stl::SmallVector<RawBuffer, InlineSegments> _segments;
+		size_t _length;
+	};
+}
+#endif
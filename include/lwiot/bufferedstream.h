@@ -13,12 +13,27 @@
 #include <lwiot/stream.h>
 #include <lwiot/stl/string.h>
 #include <lwiot/countable.h>
+#include <lwiot/bytebuffer.h>
 
 namespace lwiot {
+	/**
+	 * @brief In-memory byte stream.
+	 *
+	 * By default the buffer grows when it is written beyond its size. A stream created in
+	 * Circular mode has a fixed capacity instead: reading frees space for new data, and writes
+	 * that do not fit are truncated. The span accessors give direct access to the underlying
+	 * storage, so producers and consumers can work in place without copying.
+	 */
 	class BufferedStream : public Stream, public Countable<uint8_t> {
 	public:
+		enum Mode {
+			Growing,
+			Circular
+		};
+
 		explicit BufferedStream();
 		explicit BufferedStream(int size);
+		explicit BufferedStream(int size, Mode mode);
 		explicit BufferedStream(const BufferedStream& stream);
 #if __cplusplus >= 201103L || defined(__GXX_EXPERIMENTAL_CXX0X__) || defined(WIN32)
 		explicit BufferedStream(BufferedStream&& other);
@@ -29,6 +44,7 @@ namespace lwiot {
 		virtual Stream& operator =(const Stream& stream);
 #if __cplusplus >= 201103L || defined(__GXX_EXPERIMENTAL_CXX0X__) || defined(WIN32)
 		virtual Stream& operator =(Stream&& stream);
+		BufferedStream& operator =(BufferedStream&& stream);
 #endif
 
 		virtual Stream& operator << (char x) override;
@@ -54,6 +70,24 @@ namespace lwiot {
 
 		const void *data() const;
 		const size_t& size() const;
+		Mode mode() const;
+		bool full() const;
+
+		/**
+		 * @brief Contiguous part of the unread data.
+		 * @note In Circular mode the unread data can wrap around the end of the buffer, in
+		 *       which case the remainder is returned after commitRead() is called.
+		 */
+		RawBuffer readableSpan() const;
+
+		/**
+		 * @brief Contiguous part of the free space.
+		 * @note In Growing mode the buffer is grown when it is full.
+		 */
+		RawBuffer writableSpan();
+
+		void commitRead(size_t num);
+		void commitWrite(size_t num);
 
 		virtual size_t available() const override;
 		virtual String toString();
@@ -71,7 +105,7 @@ namespace lwiot {
 
 	private:
 		/* methods */
-		void append(const void *data, size_t length);
+		size_t append(const void *data, size_t length);
 		void grow();
 		void grow(int num);
 
@@ -82,5 +116,7 @@ namespace lwiot {
 		/* attributes */
 		uint8_t *_data;
 		size_t rd_idx, wr_idx;
+		size_t _used;
+		Mode _mode;
 	};
 }
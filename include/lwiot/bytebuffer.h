@@ -8,6 +8,7 @@
 #pragma once
 
 #include <stdlib.h>
+#include <string.h>
 #include <lwiot.h>
 
 #include <lwiot/countable.h>
@@ -68,6 +69,38 @@ namespace lwiot
 		void write(const RawBuffer& raw);
 		void write(const ByteBuffer& buffer);
 
+		/**
+		 * @brief Append \p num bytes using a single capacity check.
+		 * @param bytes Bytes to append.
+		 * @param num Number of bytes.
+		 * @return A reference to \c this.
+		 * @note The buffer grows exactly as far as needed.
+		 */
+		ByteBuffer& append(const uint8_t *bytes, size_t num);
+
+		/**
+		 * @brief Make sure the buffer can hold at least \p size bytes.
+		 * @param size Required capacity.
+		 * @note Unlike write(), this allocates exactly \p size bytes.
+		 */
+		void reserveExact(size_t size);
+
+		/**
+		 * @brief Append a byte without checking the capacity.
+		 * @param byte Byte to append.
+		 * @note Space has to be reserved up front, for example using reserveExact().
+		 */
+		void writeUnchecked(uint8_t byte)
+		{
+			this->_data[this->_index++] = byte;
+		}
+
+		void writeUnchecked(const void *bytes, size_t num)
+		{
+			memcpy(this->_data + this->_index, bytes, num);
+			this->_index += num;
+		}
+
 		template<typename Func>
 		void foreach(Func f) const
 		{
@@ -81,6 +114,16 @@ namespace lwiot
 	protected:
 		size_t _index;
 
+		/**
+		 * @brief Wrap \p size bytes of memory that is owned by someone else.
+		 *
+		 * For subclasses that lend memory out, such as a network buffer, through an immutable
+		 * view like SharedByteBuffer. The buffer must not grow, and the subclass has to take
+		 * the memory back with release() before it is destroyed.
+		 */
+		explicit ByteBuffer(uint8_t *external, size_t size);
+		uint8_t *release();
+
 		void grow(const size_t& size) override;
 		void move(ByteBuffer& other);
 		void copy(const ByteBuffer& other);
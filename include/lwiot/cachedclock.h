@@ -0,0 +1,98 @@
+/*
+ * Wall clock cache on top of a real time clock.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/realtimeclock.h>
+#include <lwiot/util/datetime.h>
+#include <lwiot/kernel/lock.h>
+
+#ifndef CONFIG_CLOCK_RESYNC
+#define CONFIG_CLOCK_RESYNC 3600000
+#endif
+
+#ifndef CONFIG_CLOCK_MAX_DRIFT
+#define CONFIG_CLOCK_MAX_DRIFT 500
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Wall clock that is kept in memory, on top of a real time clock such as a DsRealTimeClock.
+	 *
+	 * The real time clock is read once, after which the time is advanced using lwiot_tick_ms(), so
+	 * that now() does not cause any bus traffic. The real time clock is read again every \p resync
+	 * milliseconds. Since it only counts whole seconds, a reading only moves the clock when it is
+	 * outside the second that was read; the fraction of the second is kept otherwise.
+	 *
+	 * The rate of the tick counter is compared with the reference at every resync, over the time
+	 * since the first one, and corrected for up to CONFIG_CLOCK_MAX_DRIFT parts per million.
+	 * Use sync() to discipline the clock against another reference, such as an NtpClient:
+	 *
+	 * @code
+	 * if(ntp.update())
+	 *     clock.sync(ntp.time());
+	 * @endcode
+	 *
+	 * The time handed out does not run backwards: after a small correction back, the clock stands
+	 * still until it has caught up. Only set() and large corrections step it back.
+	 */
+	class CachedClock : public RealTimeClock {
+	public:
+		explicit CachedClock(RealTimeClock& rtc, time_t resync = CONFIG_CLOCK_RESYNC);
+		~CachedClock() override = default;
+
+		DateTime now() override;
+
+		/**
+		 * @brief Set both this clock and the real time clock.
+		 */
+		void set(const DateTime& dt) override;
+
+		/**
+		 * @brief Current UNIX time in milliseconds.
+		 */
+		time_t milliseconds();
+
+		/**
+		 * @brief Discipline the clock against a reference, and write it to the real time clock.
+		 * @param epoch Reference UNIX time in seconds.
+		 */
+		void sync(time_t epoch);
+
+		/**
+		 * @brief Read the real time clock on the next call to now().
+		 */
+		void invalidate();
+
+		int32_t drift() const; //!< Measured drift of the tick counter, in parts per million.
+
+	private:
+		RealTimeClock& _rtc;
+		mutable Lock _lock;
+		time_t _interval;
+		bool _valid;
+		bool _stale;
+
+		time_t _base_tick;
+		int64_t _base;
+		time_t _anchor_tick;
+		int64_t _anchor;
+		int64_t _last;
+		int32_t _drift;
+
+		int64_t estimate(time_t tick) const;
+		int64_t current();
+		void discipline(time_t epoch, time_t tick);
+		void anchor(int64_t time, time_t tick);
+	};
+}
@@ -0,0 +1,149 @@
+/*
+ * Compressing and decompressing stream adapters.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stream.h>
+#include <lwiot/compression.h>
+#include <lwiot/stl/string.h>
+
+#ifndef CONFIG_CODEC_STREAM_BUFFER
+#define CONFIG_CODEC_STREAM_BUFFER 64
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Stream that passes data through a codec on its way to or from another stream.
+	 *
+	 * Data written to the stream is transformed and written to the inner stream, in chunks of
+	 * CONFIG_CODEC_STREAM_BUFFER bytes. Reading from the stream reads from the inner stream
+	 * and returns the transformed data. Either way nothing is staged beyond that buffer and the
+	 * codec window. A stream is used either for writing or for reading, not both.
+	 *
+	 * The inner stream can be anything, such as a TcpClient, a File or a BufferedStream.
+	 */
+	class CodecStream : public Stream {
+	public:
+		~CodecStream() override;
+
+		CodecStream(const CodecStream&) = delete;
+		CodecStream& operator=(const CodecStream&) = delete;
+
+		Stream& operator << (char x) override;
+		Stream& operator << (short x) override;
+		Stream& operator << (int  x) override;
+		Stream& operator << (const long&  x) override;
+		Stream& operator << (const long long&  x) override;
+
+		Stream& operator << (unsigned char x) override;
+		Stream& operator << (unsigned short x) override;
+		Stream& operator << (unsigned int  x) override;
+		Stream& operator << (const unsigned long&  x) override;
+		Stream& operator << (const unsigned long long&  x) override;
+
+		Stream& operator << (const double& flt) override;
+		Stream& operator << (const float& flt) override;
+
+		Stream& operator << (const String& str) override;
+		Stream& operator << (const char *cstr) override;
+
+		/**
+		 * @brief Input that was read from the inner stream, but not processed yet, plus the
+		 *        data that the inner stream has available.
+		 */
+		size_t available() const override;
+
+		uint8_t read() override;
+
+		/**
+		 * @brief Read transformed data from the inner stream.
+		 * @return The number of bytes read; 0 once the inner stream has no more data.
+		 */
+		ssize_t read(void *output, const size_t& length) override;
+		using Stream::read;
+
+		bool write(uint8_t byte) override;
+
+		/**
+		 * @brief Transform data and write it to the inner stream.
+		 * @return \p length, or -EINVALID if the data is malformed or the inner stream did not
+		 *         take it.
+		 */
+		ssize_t write(const void *bytes, const size_t& length) override;
+		using Stream::write;
+
+		/**
+		 * @brief End the data written to the stream.
+		 *
+		 * A compressor writes its remaining output and trailer; a decompressor checks that the
+		 * compressed stream was complete. The codec is reset afterwards.
+		 */
+		bool finish();
+
+		bool failed() const;
+
+	protected:
+		explicit CodecStream(Stream& inner, Codec *codec);
+
+	private:
+		Stream& _inner;
+		Codec *_codec;
+		bool _error;
+
+		/* Used when reading: input from the inner stream and output of the codec. */
+		uint8_t _input[CONFIG_CODEC_STREAM_BUFFER];
+		size_t _start;
+		size_t _end;
+		uint8_t _output[CONFIG_CODEC_STREAM_BUFFER];
+		size_t _head;
+		size_t _tail;
+		bool _eof;
+		bool _finished;
+
+		void rewind();
+	};
+
+	/**
+	 * @brief Compress data that is written to, or read through, another stream.
+	 *
+	 * @code
+	 * lwiot::CompressingStream gzip(client, lwiot::CompressionFormat::Gzip);
+	 *
+	 * gzip << body;
+	 * gzip.finish();
+	 * @endcode
+	 */
+	class CompressingStream : public CodecStream {
+	public:
+		/**
+		 * @param inner Stream to write to, or read from.
+		 * @param format Output format.
+		 * @param window Log2 of the window size, or 0 for the default of the format.
+		 * @param lookahead Log2 of the longest match, or 0 for the default of the format.
+		 */
+		explicit CompressingStream(Stream& inner, CompressionFormat format = CompressionFormat::Gzip,
+		                           uint8_t window = 0, uint8_t lookahead = 0);
+	};
+
+	/**
+	 * @brief Decompress data that is written to, or read through, another stream.
+	 *
+	 * Heatshrink data must be read with the window and lookahead it was compressed with. The
+	 * window of a deflate decoder must be at least that of the compressor; 15 decodes any stream.
+	 */
+	class DecompressingStream : public CodecStream {
+	public:
+		explicit DecompressingStream(Stream& inner, CompressionFormat format = CompressionFormat::Gzip,
+		                             uint8_t window = 0, uint8_t lookahead = 0);
+	};
+}
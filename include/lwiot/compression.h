@@ -0,0 +1,350 @@
+/*
+ * Streaming compression codecs.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+
+#ifndef CONFIG_HEATSHRINK_WINDOW
+#define CONFIG_HEATSHRINK_WINDOW 8
+#endif
+
+#ifndef CONFIG_HEATSHRINK_LOOKAHEAD
+#define CONFIG_HEATSHRINK_LOOKAHEAD 4
+#endif
+
+#ifndef CONFIG_DEFLATE_WINDOW
+#define CONFIG_DEFLATE_WINDOW 12
+#endif
+
+#ifndef CONFIG_DEFLATE_LOOKAHEAD
+#define CONFIG_DEFLATE_LOOKAHEAD 8
+#endif
+
+#ifndef CONFIG_INFLATE_WINDOW
+#define CONFIG_INFLATE_WINDOW 15
+#endif
+
+#ifndef CONFIG_COMPRESSION_CHAIN
+#define CONFIG_COMPRESSION_CHAIN 16
+#endif
+
+namespace lwiot
+{
+	enum class CompressionFormat {
+		Heatshrink, //!< LZSS with a tiny window, for links between MCUs.
+		Deflate, //!< Raw deflate (RFC 1951).
+		Gzip //!< Deflate with a gzip header and trailer (RFC 1952), as used by HTTP.
+	};
+
+	/**
+	 * @brief Incremental compressor or decompressor.
+	 *
+	 * Codecs work on caller supplied buffers and never block: process() takes as much input and
+	 * produces as much output as fits, and is called again with the remaining input. Memory is
+	 * allocated once, when the codec is created, and depends only on its window size.
+	 */
+	class Codec {
+	public:
+		explicit Codec();
+		virtual ~Codec() = default;
+
+		Codec(const Codec&) = delete;
+		Codec& operator=(const Codec&) = delete;
+
+		/**
+		 * @brief Transform input into output.
+		 * @param input Input data.
+		 * @param length Number of input bytes.
+		 * @param used Set to the number of input bytes that were consumed.
+		 * @param output Output buffer.
+		 * @param size Size of \p output.
+		 * @return Number of bytes written to \p output.
+		 * @note Call again, with the input that was not used, until no input is used and no
+		 *       output is produced.
+		 */
+		virtual size_t process(const uint8_t *input, size_t length, size_t& used, uint8_t *output, size_t size) = 0;
+
+		/**
+		 * @brief End the input and write the remaining output.
+		 * @return Number of bytes written to \p output; 0 once everything has been written.
+		 */
+		virtual size_t finish(uint8_t *output, size_t size);
+
+		/**
+		 * @brief Start over with a new stream.
+		 */
+		virtual void reset() = 0;
+
+		/**
+		 * @brief Check whether the input was malformed.
+		 */
+		bool failed() const;
+
+		/**
+		 * @brief Check whether the end of a compressed stream was decoded.
+		 * @note Heatshrink streams have no end marker.
+		 */
+		bool done() const;
+
+	protected:
+		bool _failed;
+		bool _done;
+	};
+
+	namespace detail
+	{
+		/*
+		 * LZ77 match finder on a window of 2^window bytes. Input is buffered in twice the window
+		 * and candidates are found through hash chains of up to CONFIG_COMPRESSION_CHAIN entries.
+		 */
+		class LzMatcher {
+		public:
+			explicit LzMatcher(uint8_t window, size_t longest, size_t shortest);
+			~LzMatcher();
+
+			LzMatcher(const LzMatcher&) = delete;
+			LzMatcher& operator=(const LzMatcher&) = delete;
+
+			void reset();
+
+			/* Buffer input; returns the number of bytes taken. */
+			size_t fill(const uint8_t *data, size_t length);
+
+			/* Bytes buffered after the current position. */
+			size_t lookahead() const;
+			size_t longest() const;
+
+			uint8_t current() const;
+
+			/* Length of the longest match at the current position, or 0 if it is too short. */
+			size_t match(size_t& distance) const;
+			void advance(size_t num);
+
+		private:
+			uint8_t *_data;
+			uint16_t *_head;
+			uint16_t *_prev;
+			size_t _window;
+			size_t _hash;
+			size_t _longest;
+			size_t _shortest;
+			size_t _start;
+			size_t _end;
+
+			size_t hash(size_t pos) const;
+			void slide();
+		};
+
+		class BitWriter {
+		public:
+			explicit BitWriter(bool msb);
+
+			void reset();
+			void attach(uint8_t *output, size_t size);
+			size_t written() const;
+			size_t space() const;
+
+			void put(uint32_t value, uint8_t num);
+			void align();
+
+		private:
+			bool _msb;
+			uint32_t _bits;
+			uint8_t _count;
+			uint8_t *_output;
+			size_t _size;
+			size_t _written;
+		};
+	}
+
+	/**
+	 * @brief Heatshrink compressor.
+	 *
+	 * Back references reach back up to 2^window bytes and are 2^lookahead bytes long at most;
+	 * the lookahead must be smaller than the window. The match finder uses four times the
+	 * window size in memory, plus a hash table.
+	 */
+	class HeatshrinkEncoder : public Codec {
+	public:
+		explicit HeatshrinkEncoder(uint8_t window = CONFIG_HEATSHRINK_WINDOW, uint8_t lookahead = CONFIG_HEATSHRINK_LOOKAHEAD);
+		~HeatshrinkEncoder() override = default;
+
+		size_t process(const uint8_t *input, size_t length, size_t& used, uint8_t *output, size_t size) override;
+		size_t finish(uint8_t *output, size_t size) override;
+		void reset() override;
+
+	private:
+		uint8_t _window;
+		uint8_t _lookahead;
+		detail::LzMatcher _matcher;
+		detail::BitWriter _writer;
+		bool _flushed;
+
+		void encode(bool last);
+	};
+
+	/**
+	 * @brief Heatshrink decompressor. Window and lookahead must match those of the compressor.
+	 */
+	class HeatshrinkDecoder : public Codec {
+	public:
+		explicit HeatshrinkDecoder(uint8_t window = CONFIG_HEATSHRINK_WINDOW, uint8_t lookahead = CONFIG_HEATSHRINK_LOOKAHEAD);
+		~HeatshrinkDecoder() override;
+
+		size_t process(const uint8_t *input, size_t length, size_t& used, uint8_t *output, size_t size) override;
+		void reset() override;
+
+	private:
+		enum class State {
+			Tag,
+			Literal,
+			Index,
+			Count,
+			Copy
+		};
+
+		uint8_t _window;
+		uint8_t _lookahead;
+		uint8_t *_buffer;
+
+		State _state;
+		uint8_t _byte;
+		uint8_t _mask;
+		uint16_t _bits;
+		uint8_t _count;
+
+		uint16_t _offset;
+		uint16_t _copy;
+		uint16_t _head;
+
+		bool take(const uint8_t *input, size_t length, size_t& used, uint8_t num, uint16_t& value);
+		void push(uint8_t value);
+	};
+
+	/**
+	 * @brief Deflate compressor, producing a raw deflate or a gzip stream.
+	 *
+	 * Output is a single block with the fixed Huffman codes, so nothing has to be buffered to
+	 * build code tables; every decoder accepts it. Matches reach back 2^window bytes
+	 * (9 to 15) and are 2^lookahead bytes long at most, up to 258.
+	 */
+	class DeflateEncoder : public Codec {
+	public:
+		explicit DeflateEncoder(bool gzip = false, uint8_t window = CONFIG_DEFLATE_WINDOW,
+		                        uint8_t lookahead = CONFIG_DEFLATE_LOOKAHEAD);
+		~DeflateEncoder() override = default;
+
+		size_t process(const uint8_t *input, size_t length, size_t& used, uint8_t *output, size_t size) override;
+		size_t finish(uint8_t *output, size_t size) override;
+		void reset() override;
+
+	private:
+		bool _gzip;
+		detail::LzMatcher _matcher;
+		detail::BitWriter _writer;
+		bool _started;
+		bool _flushed;
+		uint32_t _crc;
+		uint32_t _size;
+
+		void start();
+		void encode(bool last);
+		void symbol(uint16_t value);
+	};
+
+	/**
+	 * @brief Deflate decompressor for raw deflate and gzip streams.
+	 *
+	 * All block types are supported. Back references are resolved from a window of 2^window
+	 * bytes, so streams compressed with a larger window than that fail. The gzip CRC and size
+	 * are checked.
+	 */
+	class InflateDecoder : public Codec {
+	public:
+		explicit InflateDecoder(bool gzip = false, uint8_t window = CONFIG_INFLATE_WINDOW);
+		~InflateDecoder() override;
+
+		size_t process(const uint8_t *input, size_t length, size_t& used, uint8_t *output, size_t size) override;
+
+		/**
+		 * @brief End the input. Marks the decoder as failed if the stream was incomplete.
+		 */
+		size_t finish(uint8_t *output, size_t size) override;
+		void reset() override;
+
+	private:
+		struct Huffman {
+			uint16_t count[16];
+			uint16_t *symbol;
+		};
+
+		enum class State {
+			Header,
+			HeaderExtraLength,
+			HeaderExtra,
+			HeaderName,
+			HeaderComment,
+			HeaderCrc,
+			Block,
+			StoredLength,
+			Stored,
+			Tables,
+			LengthCodes,
+			Lengths,
+			Symbol,
+			Length,
+			Distance,
+			DistanceExtra,
+			Copy,
+			Trailer,
+			End
+		};
+
+		bool _gzip;
+		uint8_t _window;
+		uint8_t *_buffer;
+		size_t _head;
+		size_t _total;
+
+		State _state;
+		uint32_t _bits;
+		uint8_t _count;
+		const uint8_t *_input;
+		size_t _length;
+		size_t _used;
+
+		bool _last;
+		uint8_t _flags;
+		size_t _remaining;
+		size_t _distance;
+		uint32_t _crc;
+
+		uint16_t _nlen;
+		uint16_t _ndist;
+		uint16_t _ncode;
+		uint16_t _index;
+		uint8_t _lengths[320];
+
+		uint16_t _symbols[288 + 30];
+		Huffman _lencode;
+		Huffman _distcode;
+
+		bool need(uint8_t num);
+		uint32_t bits(uint8_t num);
+		int decode(const Huffman& table);
+		bool build(Huffman& table, const uint8_t *lengths, size_t num);
+		void fixed();
+		void emit(uint8_t *output, size_t& produced, uint8_t value);
+		void end();
+		bool step(uint8_t *output, size_t size, size_t& produced);
+	};
+}
@@ -1,5 +1,5 @@
 /*
- * Generic atomic implementation.
+ * Critical section atomic operations.
  *
  * @author Michel Megens
  * @email  dev@bietje.net
@@ -8,234 +8,120 @@
 #pragma once
 
 #include <lwiot.h>
-#include <lwiot/stl/move.h>
+#include <lwiot/detail/memory_order.h>
 
 namespace lwiot
 {
 	namespace detail
 	{
-		typedef enum memory_order {
-			memory_order_relaxed,
-			memory_order_consume,
-			memory_order_acquire,
-			memory_order_release,
-			memory_order_acq_rel,
-			memory_order_seq_cst
-		} memory_order;
-
-		template<typename T>
-		class Atomic {
-		public:
-			explicit Atomic() = default;
-
-			explicit Atomic(const Atomic &) = delete;
-
-			explicit Atomic(const T &value) : _value(value)
-			{
-			}
-
-			Atomic(Atomic&& value) noexcept : _value(value.load())
-			{ }
+		/*
+		 * Fallback for cores (or operand sizes) without atomic instructions. Every operation
+		 * runs inside a critical section, which also makes it a full barrier, so the memory
+		 * order arguments are ignored.
+		 */
+		template <typename T, typename D>
+		struct CriticalAtomic {
+			static constexpr bool lock_free = false;
 
-			Atomic &operator=(const Atomic &) = delete;
-
-			constexpr Atomic& operator=(Atomic&& value) noexcept
+			static T load(const T& obj, memory_order order)
 			{
 				enter_critical();
-				this->_value = stl::move(value._value);
+				auto v = obj;
 				exit_critical();
 
-				return *this;
+				return v;
 			}
 
-			T fetch_add(const T &value)
+			static void store(T& obj, T value, memory_order order)
 			{
 				enter_critical();
-				auto v = this->_value;
-				this->_value += value;
+				obj = value;
 				exit_critical();
-				return v;
 			}
 
-			T fetch_sub(const T &value)
+			static T exchange(T& obj, T value, memory_order order)
 			{
-
 				enter_critical();
-				auto v = this->_value;
-				this->_value -= value;
+				auto v = obj;
+				obj = value;
 				exit_critical();
+
 				return v;
 			}
 
-			T fetch_and(const T &value)
+			static bool compare_exchange(T& obj, T& expected, T desired, bool weak,
+			                             memory_order success, memory_order failure)
 			{
+				bool rv;
+
 				enter_critical();
-				auto v = this->_value;
-				this->_value &= value;
+				if(obj == expected) {
+					obj = desired;
+					rv = true;
+				} else {
+					expected = obj;
+					rv = false;
+				}
 				exit_critical();
 
-				return v;
+				return rv;
 			}
 
-			T fetch_xor(const T &value)
+			static T fetch_add(T& obj, D value, memory_order order)
 			{
 				enter_critical();
-				auto v = this->_value;
-				this->_value ^= value;
+				auto v = obj;
+				obj += value;
 				exit_critical();
 
 				return v;
 			}
 
-			T fetch_or(const T &value)
+			static T fetch_sub(T& obj, D value, memory_order order)
 			{
 				enter_critical();
-				auto v = this->_value;
-				this->_value |= value;
+				auto v = obj;
+				obj -= value;
 				exit_critical();
 
 				return v;
 			}
 
-			T load() const
+			static T fetch_and(T& obj, T value, memory_order order)
 			{
 				enter_critical();
-				auto v = this->_value;
+				auto v = obj;
+				obj &= value;
 				exit_critical();
 
 				return v;
 			}
 
-			void store(T v, memory_order order = memory_order_seq_cst)
+			static T fetch_or(T& obj, T value, memory_order order)
 			{
 				enter_critical();
-				this->_value = v;
+				auto v = obj;
+				obj |= value;
 				exit_critical();
-			}
 
-			void store(T v, memory_order order = memory_order_seq_cst) volatile
-			{
-				enter_critical();
-				this->_value = v;
-				exit_critical();
+				return v;
 			}
 
-			bool operator==(const Atomic<T> &other)
+			static T fetch_xor(T& obj, T value, memory_order order)
 			{
 				enter_critical();
-				auto ours = this->_value;
+				auto v = obj;
+				obj ^= value;
 				exit_critical();
 
-				return ours == other.value();
+				return v;
 			}
 
-			bool operator!=(const Atomic<T> &other)
+			static void fence(memory_order order)
 			{
 				enter_critical();
-				auto ours = this->_value;
 				exit_critical();
-
-				return ours != other.value();
 			}
-
-			T operator++()
-			{
-				return fetch_add(1) + 1;
-			}
-
-			T operator++() volatile
-			{
-				return fetch_add(1) + 1;
-			}
-
-			// Post-increment
-			T operator++(int)
-			{
-				return fetch_add(1);
-			}
-
-			T operator++(int) volatile
-			{
-				return fetch_add(1);
-			}
-
-			T operator--()
-			{
-				return fetch_sub(1) + 1;
-			}
-
-			T operator--() volatile
-			{
-				return fetch_sub(1) + 1;
-			}
-
-			T operator--(int)
-			{
-				return fetch_sub(1);
-			}
-
-			T operator--(int) volatile
-			{
-				return fetch_sub(1);
-			}
-
-			T operator+=(T v)
-			{
-				return fetch_add(v) + v;
-			}
-
-			T operator+=(T v) volatile
-			{
-				return fetch_add(v) + v;
-			}
-
-			T operator-=(T v)
-			{
-				return fetch_sub(v) - v;
-			}
-
-			T operator-=(T v) volatile
-			{
-				return fetch_sub(v) - v;
-			}
-
-			// And
-			T operator&=(T v)
-			{
-				return fetch_and(v) & v;
-			}
-
-			T operator&=(T v) volatile
-			{
-				return fetch_and(v) & v;
-			}
-
-			T operator|=(T v)
-			{
-				return fetch_or(v) | v;
-			}
-
-			T operator|=(T v) volatile
-			{
-				return fetch_or(v) | v;
-			}
-
-			T operator^=(T v)
-			{
-				return fetch_xor(v) ^ v;
-			}
-
-			T operator^=(T v) volatile
-			{
-				return fetch_xor(v) ^ v;
-			}
-
-		private:
-			T _value;
 		};
 	}
-
-	using memory_order = detail::memory_order;
-	template <typename T>
-	using Atomic = detail::Atomic<T>;
 }
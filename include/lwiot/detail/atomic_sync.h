@@ -1,5 +1,5 @@
 /*
- * GCC sync atomic implementation.
+ * GCC atomic builtin operations.
  *
  * @author Michel Megens
  * @email  dev@bietje.net
@@ -7,406 +7,75 @@
 
 #pragma once
 
-#include <lwiot/traits/isintegral.h>
-
-#ifndef HAVE_SYNC_FETCH
-
-#include "fetch_sync.h"
-#endif
+#include <lwiot/detail/memory_order.h>
 
 namespace lwiot
 {
 	namespace detail
 	{
-		typedef enum memory_order
-		{
-			memory_order_relaxed,
-			memory_order_consume,
-			memory_order_acquire,
-			memory_order_release,
-			memory_order_acq_rel,
-			memory_order_seq_cst
-		} memory_order;
-
-		template <typename T>
-		class Atomic {
-		public:
-			static_assert(traits::IsIntegral<T>::value, "Atomic only works for integral types!");
-
-			constexpr Atomic() : _value() { }
-
-			explicit constexpr Atomic(T value) : _value(value) { }
-
-			Atomic(const Atomic& value) : _value(value.load())
-			{ }
-
-			Atomic(Atomic&& value) noexcept : _value(value.load())
-			{ }
-
-			constexpr Atomic& operator=(const Atomic& value)
-			{
-				this->store(value.load());
-				return *this;
-			}
-
-			constexpr Atomic& operator=(Atomic&& value) noexcept
-			{
-				this->store(value.load());
-				return *this;
-			}
-
-			constexpr Atomic& operator = (const T& value) noexcept
-			{
-				this->store(value);
-				return *this;
-			}
-
-			constexpr Atomic& operator = (const T& value) volatile noexcept
-			{
-				this->store(value);
-				return *this;
-			}
-
-			T operator ++()
-			{
-				return fetch_add(1) + 1;
-			}
-
-			T operator ++() volatile
-			{
-				return fetch_add(1) + 1;
-			}
-
-			// Post-increment
-			const T operator ++(int)
-			{
-				return fetch_add(1);
-			}
+		/*
+		 * Operations based on the __atomic builtins. These compile to the native instructions
+		 * of the core (LDREX/STREX on ARMv7, S32C1I on Xtensa, LOCK prefixed instructions on
+		 * x86) and honour the requested memory order. Only used for sizes the compiler reports
+		 * as always lock free, so no libatomic calls are emitted.
+		 *
+		 * Pointer arithmetic on the builtins is done in bytes; Scale is the size of the
+		 * pointed-to type for pointers and 1 otherwise.
+		 */
+		template <typename T, typename D, size_t Scale>
+		struct BuiltinAtomic {
+			static constexpr bool lock_free = true;
 
-			const T operator ++(int) volatile
+			static T load(const T& obj, memory_order order)
 			{
-				return fetch_add(1);
+				return __atomic_load_n(&obj, order);
 			}
 
-			// Pre-decrement
-			T operator --()
+			static void store(T& obj, T value, memory_order order)
 			{
-				return fetch_sub(1) + 1;
+				__atomic_store_n(&obj, value, order);
 			}
 
-			T operator --() volatile
+			static T exchange(T& obj, T value, memory_order order)
 			{
-				return fetch_sub(1) + 1;
+				return __atomic_exchange_n(&obj, value, order);
 			}
 
-			// Post-decrement
-			const T operator --(int)
+			static bool compare_exchange(T& obj, T& expected, T desired, bool weak,
+			                             memory_order success, memory_order failure)
 			{
-				return fetch_sub(1);
+				return __atomic_compare_exchange_n(&obj, &expected, desired, weak, success, failure);
 			}
 
-			const T operator --(int) volatile
+			static T fetch_add(T& obj, D value, memory_order order)
 			{
-				return fetch_sub(1);
+				return __atomic_fetch_add(&obj, value * static_cast<D>(Scale), order);
 			}
 
-			// Add
-			T operator +=(T v)
+			static T fetch_sub(T& obj, D value, memory_order order)
 			{
-				return fetch_add(v) + v;
+				return __atomic_fetch_sub(&obj, value * static_cast<D>(Scale), order);
 			}
 
-			T operator +=(T v) volatile
+			static T fetch_and(T& obj, T value, memory_order order)
 			{
-				return fetch_add(v) + v;
+				return __atomic_fetch_and(&obj, value, order);
 			}
 
-			// Subtract
-			T operator -=(T v)
+			static T fetch_or(T& obj, T value, memory_order order)
 			{
-				return fetch_sub(v) - v;
+				return __atomic_fetch_or(&obj, value, order);
 			}
 
-			T operator -=(T v) volatile
+			static T fetch_xor(T& obj, T value, memory_order order)
 			{
-				return fetch_sub(v) - v;
+				return __atomic_fetch_xor(&obj, value, order);
 			}
 
-			// And
-			T operator &=(T v)
+			static void fence(memory_order order)
 			{
-				return fetch_and(v) & v;
+				__atomic_thread_fence(order);
 			}
-
-			T operator &=(T v) volatile
-			{
-				return fetch_and(v) & v;
-			}
-
-			// Or
-			T operator |=(T v)
-			{
-				return fetch_or(v) | v;
-			}
-
-			T operator |=(T v) volatile
-			{
-				return fetch_or(v) | v;
-			}
-
-			// Exclusive or
-			T operator ^=(T v)
-			{
-				return fetch_xor(v) ^ v;
-			}
-
-			T operator ^=(T v) volatile
-			{
-				return fetch_xor(v) ^ v;
-			}
-
-			// Conversion operator
-			explicit operator T () const
-			{
-				return __sync_fetch_and_add((T*) &this->_value, 0);
-			}
-
-			explicit operator T() volatile const
-			{
-				return __sync_fetch_and_add((T*) &this->_value, 0);
-			}
-
-			// Is lock free?
-			bool is_lock_free() const
-			{
-				return true;
-			}
-
-			bool is_lock_free() const volatile
-			{
-				return true;
-			}
-
-			// Store
-			void store(T v, detail::memory_order order = detail::memory_order_seq_cst)
-			{
-				__sync_lock_test_and_set(&this->_value, v);
-			}
-
-			void store(T v, detail::memory_order order = detail::memory_order_seq_cst) volatile
-			{
-				__sync_lock_test_and_set(&this->_value, v);
-			}
-
-			// Load
-			T load(detail::memory_order order = detail::memory_order_seq_cst) const
-			{
-				return __sync_fetch_and_add((volatile T*) &this->_value, 0);
-			}
-
-			T load(detail::memory_order order = detail::memory_order_seq_cst) const volatile
-			{
-				return __sync_fetch_and_add(&this->_value, 0);
-			}
-
-			// Fetch add
-			T fetch_add(T v, detail::memory_order order = detail::memory_order_seq_cst)
-			{
-				return __sync_fetch_and_add(&this->_value, v);
-			}
-
-			T fetch_add(T v, detail::memory_order order = detail::memory_order_seq_cst) volatile
-			{
-				return __sync_fetch_and_add(&this->_value, v);
-			}
-
-			// Fetch subtract
-			T fetch_sub(T v, detail::memory_order order = detail::memory_order_seq_cst)
-			{
-				return __sync_fetch_and_sub(&this->_value, v);
-			}
-
-			T fetch_sub(T v, detail::memory_order order = detail::memory_order_seq_cst) volatile
-			{
-				return __sync_fetch_and_sub(&this->_value, v);
-			}
-
-			// Fetch or
-			T fetch_or(T v, detail::memory_order order = detail::memory_order_seq_cst)
-			{
-				return __sync_fetch_and_or(&this->_value, v);
-			}
-
-			T fetch_or(T v, detail::memory_order order = detail::memory_order_seq_cst) volatile
-			{
-				return __sync_fetch_and_or(&this->_value, v);
-			}
-
-			// Fetch and
-			T fetch_and(T v, detail::memory_order order = detail::memory_order_seq_cst)
-			{
-				return __sync_fetch_and_and(&this->_value, v);
-			}
-
-			T fetch_and(T v, detail::memory_order order = detail::memory_order_seq_cst) volatile
-			{
-				return __sync_fetch_and_and(&this->_value, v);
-			}
-
-			// Fetch exclusive or
-			T fetch_xor(T v, detail::memory_order order = detail::memory_order_seq_cst)
-			{
-				return __sync_fetch_and_xor(&this->_value, v);
-			}
-
-			T fetch_xor(T v, detail::memory_order order = detail::memory_order_seq_cst) volatile
-			{
-				return __sync_fetch_and_xor(&this->_value, v);
-			}
-
-			// Exchange
-			T exchange(T v, detail::memory_order order = detail::memory_order_seq_cst)
-			{
-				return __sync_lock_test_and_set(&this->_value, v);
-			}
-
-			T exchange(T v, detail::memory_order order = detail::memory_order_seq_cst) volatile
-			{
-				return __sync_lock_test_and_set(&this->_value, v);
-			}
-
-			// Compare exchange weak
-			bool compare_exchange_weak(T& expected, T desired, detail::memory_order order = detail::memory_order_seq_cst)
-			{
-				T old = __sync_val_compare_and_swap(&this->_value, expected, desired);
-
-				if (old == expected)
-				{
-					return true;
-				}
-				else
-				{
-					expected = old;
-					return false;
-				}
-			}
-
-			bool compare_exchange_weak(T& expected, T desired, detail::memory_order order = detail::memory_order_seq_cst) volatile
-			{
-				T old = __sync_val_compare_and_swap(&this->_value, expected, desired);
-
-				if (old == expected)
-				{
-					return true;
-				}
-				else
-				{
-					expected = old;
-					return false;
-				}
-			}
-
-			bool compare_exchange_weak(T& expected, T desired, detail::memory_order success, detail::memory_order failure)
-			{
-				T old = __sync_val_compare_and_swap(&this->_value, expected, desired);
-
-				if (old == expected)
-				{
-					return true;
-				}
-				else
-				{
-					expected = old;
-					return false;
-				}
-			}
-
-			bool compare_exchange_weak(T& expected, T desired, detail::memory_order success, detail::memory_order failure) volatile
-			{
-				T old = __sync_val_compare_and_swap(&this->_value, expected, desired);
-
-				if (old == expected)
-				{
-					return true;
-				}
-				else
-				{
-					expected = old;
-					return false;
-				}
-			}
-
-			// Compare exchange strong
-			bool compare_exchange_strong(T& expected, T desired, detail::memory_order order = detail::memory_order_seq_cst)
-			{
-				T old = expected;
-
-				while (!compare_exchange_weak(old, desired))
-				{
-					if (memcmp(&old, &expected, sizeof(T)))
-					{
-						expected = old;
-						return false;
-					}
-				}
-
-				return true;
-			}
-
-			bool compare_exchange_strong(T& expected, T desired, detail::memory_order order = detail::memory_order_seq_cst) volatile
-			{
-				T old = expected;
-
-				while (!compare_exchange_weak(old, desired))
-				{
-					if (memcmp(&old, &expected, sizeof(T)))
-					{
-						expected = old;
-						return false;
-					}
-				}
-
-				return true;
-			}
-
-			bool compare_exchange_strong(T& expected, T desired, detail::memory_order success, detail::memory_order failure)
-			{
-				T old = expected;
-
-				while (!compare_exchange_weak(old, desired))
-				{
-					if (memcmp(&old, &expected, sizeof(T)))
-					{
-						expected = old;
-						return false;
-					}
-				}
-
-				return true;
-			}
-
-			bool compare_exchange_strong(T& expected, T desired, detail::memory_order success, detail::memory_order failure) volatile
-			{
-				T old = expected;
-
-				while (!compare_exchange_weak(old, desired))
-				{
-					if (memcmp(&old, &expected, sizeof(T)))
-					{
-						expected = old;
-						return false;
-					}
-				}
-
-				return true;
-			}
-
-		private:
-			T _value;
 		};
 	}
-
-	using memory_order = detail::memory_order;
-	template <typename T>
-	using Atomic = detail::Atomic<T>;
 }
@@ -0,0 +1,117 @@
+/*
+ * Lock free bounded queue.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/kernel/atomic.h>
+
+namespace lwiot
+{
+	namespace detail
+	{
+		/*
+		 * Fixed size multi-producer, multi-consumer FIFO of pointers. Every slot carries a
+		 * sequence number that tells producers and consumers whose turn it is, so a push() or
+		 * pop() only has to claim a position with a single compare and swap.
+		 */
+		template <typename T, size_t Size>
+		class BoundedQueue {
+		public:
+			static_assert((Size & (Size - 1)) == 0, "Queue size must be a power of two!");
+			static_assert(Atomic<long>::is_always_lock_free, "Bounded queue requires lock free atomics!");
+
+			BoundedQueue() : _head(0), _tail(0)
+			{
+				for(size_t idx = 0; idx < Size; idx++) {
+					this->_slots[idx].sequence.store(static_cast<long>(idx));
+					this->_slots[idx].entry.store(0);
+				}
+			}
+
+			BoundedQueue(const BoundedQueue&) = delete;
+			BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+			bool push(T* entry)
+			{
+				auto pos = this->_tail.load();
+				Slot* slot;
+
+				for(;;) {
+					slot = &this->_slots[pos & Mask];
+					auto diff = slot->sequence.load() - pos;
+
+					if(diff == 0) {
+						if(this->_tail.compare_exchange_weak(pos, pos + 1))
+							break;
+					} else if(diff < 0) {
+						return false;
+					} else {
+						pos = this->_tail.load();
+					}
+				}
+
+				slot->entry.store(reinterpret_cast<uintptr_t>(entry));
+				slot->sequence.store(pos + 1);
+
+				return true;
+			}
+
+			T* pop()
+			{
+				auto pos = this->_head.load();
+				Slot* slot;
+
+				for(;;) {
+					slot = &this->_slots[pos & Mask];
+					auto diff = slot->sequence.load() - (pos + 1);
+
+					if(diff == 0) {
+						if(this->_head.compare_exchange_weak(pos, pos + 1))
+							break;
+					} else if(diff < 0) {
+						return nullptr;
+					} else {
+						pos = this->_head.load();
+					}
+				}
+
+				auto entry = reinterpret_cast<T*>(slot->entry.load());
+				slot->sequence.store(pos + static_cast<long>(Size));
+
+				return entry;
+			}
+
+			/* Only a snapshot while other threads push or pop. */
+			size_t size() const
+			{
+				auto size = this->_tail.load() - this->_head.load();
+				return size > 0 ? static_cast<size_t>(size) : 0;
+			}
+
+			constexpr size_t capacity() const
+			{
+				return Size;
+			}
+
+		private:
+			static constexpr long Mask = static_cast<long>(Size) - 1;
+
+			struct Slot {
+				Atomic<long> sequence;
+				Atomic<uintptr_t> entry;
+			};
+
+			Slot _slots[Size];
+			Atomic<long> _head;
+			Atomic<long> _tail;
+		};
+	}
+}
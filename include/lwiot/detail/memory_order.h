@@ -0,0 +1,43 @@
+/*
+ * Atomic memory orders.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+namespace lwiot
+{
+	namespace detail
+	{
+		/*
+		 * The values match the __ATOMIC_* constants of GCC and Clang, so orders can be passed
+		 * to the atomic builtins as-is.
+		 */
+		typedef enum memory_order {
+			memory_order_relaxed,
+			memory_order_consume,
+			memory_order_acquire,
+			memory_order_release,
+			memory_order_acq_rel,
+			memory_order_seq_cst
+		} memory_order;
+
+		/* Strongest order that is valid for the load of a failed compare exchange. */
+		static constexpr memory_order failure_order(memory_order order)
+		{
+			return order == memory_order_acq_rel ? memory_order_acquire :
+			       order == memory_order_release ? memory_order_relaxed : order;
+		}
+	}
+
+	using memory_order = detail::memory_order;
+
+	using detail::memory_order_relaxed;
+	using detail::memory_order_consume;
+	using detail::memory_order_acquire;
+	using detail::memory_order_release;
+	using detail::memory_order_acq_rel;
+	using detail::memory_order_seq_cst;
+}
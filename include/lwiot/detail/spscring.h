@@ -0,0 +1,113 @@
+/*
+ * Lock free single-producer, single-consumer byte ring.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/kernel/atomic.h>
+
+namespace lwiot
+{
+	namespace detail
+	{
+		/*
+		 * Byte FIFO between one producer and one consumer. The producer only moves the head
+		 * and the consumer only moves the tail, so neither side ever waits for the other. That
+		 * makes push() safe to call from an interrupt handler or a DMA completion callback.
+		 * The size has to be a power of two.
+		 */
+		class SpscRing {
+		public:
+			explicit SpscRing(size_t size) : _mask(size - 1), _buffer(new uint8_t[size]), _head(0), _tail(0)
+			{
+				static_assert(Atomic<size_t>::is_always_lock_free, "SPSC ring requires lock free atomics!");
+			}
+
+			~SpscRing()
+			{
+				delete[] this->_buffer;
+			}
+
+			SpscRing(const SpscRing&) = delete;
+			SpscRing& operator=(const SpscRing&) = delete;
+
+			/*
+			 * Append up to `length` bytes and return the number that fitted.
+			 */
+			size_t push(const void *data, size_t length)
+			{
+				auto head = this->_head.load(memory_order_relaxed);
+				auto room = this->_mask + 1 - (head - this->_tail.load(memory_order_acquire));
+
+				if(length > room)
+					length = room;
+
+				this->copy(head, static_cast<const uint8_t *>(data), length);
+				this->_head.store(head + length, memory_order_release);
+
+				return length;
+			}
+
+			/*
+			 * Remove up to `length` bytes and return the number that was read.
+			 */
+			size_t pop(void *data, size_t length)
+			{
+				auto tail = this->_tail.load(memory_order_relaxed);
+				auto used = this->_head.load(memory_order_acquire) - tail;
+				auto output = static_cast<uint8_t *>(data);
+
+				if(length > used)
+					length = used;
+
+				auto offset = tail & this->_mask;
+				auto first = this->_mask + 1 - offset;
+
+				if(first > length)
+					first = length;
+
+				memcpy(output, this->_buffer + offset, first);
+				memcpy(output + first, this->_buffer, length - first);
+				this->_tail.store(tail + length, memory_order_release);
+
+				return length;
+			}
+
+			size_t size() const
+			{
+				return this->_head.load(memory_order_acquire) - this->_tail.load(memory_order_acquire);
+			}
+
+			bool empty() const
+			{
+				return this->size() == 0;
+			}
+
+		private:
+			size_t _mask;
+			uint8_t *_buffer;
+			Atomic<size_t> _head;
+			Atomic<size_t> _tail;
+
+			void copy(size_t position, const uint8_t *data, size_t length)
+			{
+				auto offset = position & this->_mask;
+				auto first = this->_mask + 1 - offset;
+
+				if(first > length)
+					first = length;
+
+				memcpy(this->_buffer + offset, data, first);
+				memcpy(this->_buffer, data + first, length - first);
+			}
+		};
+	}
+}
@@ -0,0 +1,110 @@
+/*
+ * Lock free work stealing deque.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/kernel/atomic.h>
+
+namespace lwiot
+{
+	namespace detail
+	{
+		/*
+		 * Fixed size Chase-Lev deque. Only the owning thread may push() and pop(), which work on
+		 * the bottom of the deque. Other threads take entries from the top using steal(). The
+		 * sequentially consistent defaults of lwiot::Atomic provide the ordering the protocol
+		 * relies on.
+		 */
+		template <typename T, size_t Size>
+		class WorkDeque {
+		public:
+			static_assert((Size & (Size - 1)) == 0, "Deque size must be a power of two!");
+			static_assert(Atomic<long>::is_always_lock_free, "Work stealing requires lock free atomics!");
+
+			WorkDeque() : _top(0), _bottom(0)
+			{
+				for(auto& slot : this->_slots)
+					slot.store(0);
+			}
+
+			WorkDeque(const WorkDeque&) = delete;
+			WorkDeque& operator=(const WorkDeque&) = delete;
+
+			bool push(T* entry)
+			{
+				auto bottom = this->_bottom.load();
+				auto top = this->_top.load();
+
+				if(bottom - top >= static_cast<long>(Size))
+					return false;
+
+				this->_slots[bottom & Mask].store(reinterpret_cast<uintptr_t>(entry));
+				this->_bottom.store(bottom + 1);
+
+				return true;
+			}
+
+			T* pop()
+			{
+				auto bottom = this->_bottom.load() - 1;
+
+				this->_bottom.store(bottom);
+				auto top = this->_top.load();
+
+				if(top > bottom) {
+					this->_bottom.store(bottom + 1);
+					return nullptr;
+				}
+
+				auto entry = reinterpret_cast<T*>(this->_slots[bottom & Mask].load());
+
+				if(top == bottom) {
+					/* Last entry: race the thieves for it. */
+					if(!this->_top.compare_exchange_strong(top, top + 1))
+						entry = nullptr;
+
+					this->_bottom.store(bottom + 1);
+				}
+
+				return entry;
+			}
+
+			T* steal()
+			{
+				while(true) {
+					auto top = this->_top.load();
+					auto bottom = this->_bottom.load();
+
+					if(top >= bottom)
+						return nullptr;
+
+					auto entry = reinterpret_cast<T*>(this->_slots[top & Mask].load());
+
+					if(this->_top.compare_exchange_strong(top, top + 1))
+						return entry;
+				}
+			}
+
+			size_t size() const
+			{
+				auto size = this->_bottom.load() - this->_top.load();
+				return size > 0 ? static_cast<size_t>(size) : 0;
+			}
+
+		private:
+			static constexpr long Mask = Size - 1;
+
+			Atomic<long> _top;
+			Atomic<long> _bottom;
+			Atomic<uintptr_t> _slots[Size];
+		};
+	}
+}
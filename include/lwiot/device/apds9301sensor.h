@@ -10,11 +10,26 @@
 #include <lwiot/types.h>
 #include <lwiot/error.h>
 #include <lwiot/io/i2cbus.h>
+#include <lwiot/io/gpiochip.h>
 #include <lwiot/kernel/lock.h>
+#include <lwiot/device/registerdevice.h>
+#include <lwiot/device/datareadyinterrupt.h>
+#include <lwiot/device/asyncsensor.h>
 
 namespace lwiot
 {
-	class Apds9301Sensor {
+	/**
+	 * @brief APDS-9301 driver.
+	 *
+	 * The sensor integrates continuously; a measurement waits for one integration cycle, so that
+	 * the result is taken after the measurement was started. The timing register is only changed
+	 * by the driver and is cached after begin(), so that a measurement only reads the two channels.
+	 *
+	 * When the INT line is connected, enableInterrupt() makes the sensor interrupt at the end of
+	 * every integration cycle, or when channel 0 leaves the window set by setThresholds(). A
+	 * measurement is then ready on the first interrupt after it was started.
+	 */
+	class Apds9301Sensor : public AsyncSensor {
 	public:
 		explicit Apds9301Sensor(I2CBus& bus, uint8_t addr = SlaveAddress);
 		~Apds9301Sensor() = default;
@@ -35,14 +50,48 @@ namespace lwiot
 		integration_time_t getIntegrationTime();
 		bool setIntegrationTime(integration_time_t time);
 
+		/**
+		 * @brief Handle results on an interrupt of the INT line.
+		 * @param chip GPIO chip that INT is connected to.
+		 * @param pin Pin number of INT.
+		 */
+		bool enableInterrupt(GpioChip& chip, int pin);
+		void disableInterrupt();
+
+		/**
+		 * @brief Only interrupt when channel 0 is outside [\p low, \p high].
+		 * @param low Lower threshold.
+		 * @param high Upper threshold.
+		 * @param persist Number of integration cycles the level must be outside the window,
+		 *                at most 15; 0 interrupts on every cycle.
+		 */
+		bool setThresholds(uint16_t low, uint16_t high, uint8_t persist = 1);
+
+		bool startMeasurement() override;
+		bool ready() override;
+		bool collect() override;
+
+		/**
+		 * @brief Illuminance in lux.
+		 */
+		size_t values(float* values, size_t count) const override;
+		double lux() const;
+
+	protected:
+		void await(time_t ms) override;
+
 	private:
-		I2CBus _bus;
-		uint8_t _addr;
+		RegisterDevice<uint8_t> _regs;
+		DataReadyInterrupt _irq;
+		uint8_t _persist;
+		double _lux;
 
 		static constexpr int SlaveAddress = 0x39;
 
 		/* Methods */
 		bool getData(uint16_t &x, uint16_t &y);
+		time_t integration();
+		bool clearInterrupt();
 
 		bool read(uint8_t addr, uint8_t& byte);
 		bool read(uint8_t addr, uint16_t& word);
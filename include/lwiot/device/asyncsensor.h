@@ -0,0 +1,111 @@
+/*
+ * Non-blocking sensor measurements.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+
+#ifndef CONFIG_ASYNC_SENSOR_TIMEOUT
+#define CONFIG_ASYNC_SENSOR_TIMEOUT 1000
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Sensor of which a measurement is split in a trigger and a collect phase.
+	 *
+	 * startMeasurement() starts a conversion on the sensor and returns right away. The caller
+	 * is free to do other work until ready() returns true, after which collect() reads and
+	 * converts the result. ready() is a poll: it never waits, but it can advance sensors that
+	 * convert in several stages to their next stage.
+	 *
+	 * Drivers schedule() the time at which a conversion is expected to be done; the default
+	 * ready() only checks that deadline. sample() runs a complete measurement and await()s,
+	 * instead of spinning, while the conversion is running.
+	 *
+	 * @see SensorSampler
+	 */
+	class AsyncSensor {
+	public:
+		explicit AsyncSensor();
+		virtual ~AsyncSensor() = default;
+
+		/**
+		 * @brief Start a measurement.
+		 * @return False if the sensor could not be triggered.
+		 */
+		virtual bool startMeasurement() = 0;
+
+		/**
+		 * @brief Check whether the running measurement can be collected.
+		 */
+		virtual bool ready();
+
+		/**
+		 * @brief Read the result of the running measurement.
+		 * @return False if no measurement is ready, or if the result could not be read.
+		 */
+		virtual bool collect() = 0;
+
+		/**
+		 * @brief Copy the results of the last collected measurement to \p values.
+		 * @param values Output array.
+		 * @param count Capacity of \p values.
+		 * @return Number of values copied.
+		 */
+		virtual size_t values(float* values, size_t count) const;
+
+		/**
+		 * @brief Check whether a measurement was started, but not yet collected.
+		 */
+		bool busy() const;
+
+		/**
+		 * @brief Milliseconds until the running measurement is expected to be ready.
+		 */
+		time_t remaining() const;
+
+		/**
+		 * @brief Start a measurement and collect it once it is ready.
+		 * @param tmo Time in milliseconds to wait for the sensor to become ready.
+		 * @return True if a measurement was collected within \p tmo.
+		 */
+		bool sample(int tmo = CONFIG_ASYNC_SENSOR_TIMEOUT);
+
+	protected:
+		/**
+		 * @brief Mark a measurement as running; it is expected to be ready in \p ms milliseconds.
+		 */
+		void schedule(time_t ms);
+
+		/**
+		 * @brief Mark the running measurement as collected.
+		 */
+		void complete();
+
+		/**
+		 * @brief Block for at most \p ms milliseconds while a measurement is running.
+		 *
+		 * The default sleeps for \p ms. Drivers that are told about new results by an interrupt
+		 * wait for that interrupt instead.
+		 */
+		virtual void await(time_t ms);
+
+		/**
+		 * @brief Copy \p num results to \p values, which can hold \p count values.
+		 */
+		static size_t store(float* values, size_t count, const float* results, size_t num);
+
+	private:
+		time_t _deadline;
+		bool _busy;
+	};
+}
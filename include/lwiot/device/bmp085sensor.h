@@ -12,10 +12,20 @@
 #include <lwiot/log.h>
 #include <lwiot/io/i2cbus.h>
 #include <lwiot/device/bmpsensor.h>
+#include <lwiot/device/asyncsensor.h>
 
 namespace lwiot
 {
-	class Bmp085Sensor : public BmpSensor {
+	/**
+	 * @brief BMP085 driver.
+	 *
+	 * A measurement converts the temperature and then the pressure; ready() starts the pressure
+	 * conversion once the temperature conversion is done.
+	 *
+	 * Results are compensated with the integer algorithm from the datasheet and stored as
+	 * integers; temperature() only converts to degrees when it is called.
+	 */
+	class Bmp085Sensor : public BmpSensor, public AsyncSensor {
 	public:
 		explicit Bmp085Sensor(I2CBus& bus);
 		virtual ~Bmp085Sensor() = default;
@@ -25,16 +35,36 @@ namespace lwiot
 		void read(int32_t & pressure, float& temperature);
 		void read();
 
+		bool startMeasurement() override;
+		bool ready() override;
+		bool collect() override;
+
+		/**
+		 * @brief Pressure in Pa and temperature in degrees Celsius.
+		 */
+		size_t values(float* values, size_t count) const override;
+
 		int32_t pressure() const;
 		float temperature() const;
 
+		/**
+		 * @brief Temperature in 0.1 degrees Celsius.
+		 */
+		int32_t temperatureDeciCelsius() const;
+
 	private:
 		int32_t _pressure;
-		float _temperature;
+		int32_t _temperature;
 
 		mutable bool _calibrate;
 		uint8_t _oversampling;
 
+		enum class Stage {
+			Temperature,
+			Pressure
+		} _stage;
+		uint16_t _ut;
+
 		int16_t ac1, ac2, ac3;
 		uint16_t ac4, ac5, ac6;
 		int16_t b1, b2;
@@ -43,10 +73,10 @@ namespace lwiot
 		static constexpr int8_t SlaveAddress = 0x77;
 
 		/* Methods */
-		uint16_t readTemperature();
+		time_t pressureDelay() const;
 		uint32_t readPressure();
-		float calculateTemperature();
-		int32_t calculatePressure();
-		int32_t computeB5(int32_t ut);
+		int32_t calculateTemperature(int32_t b5) const;
+		int32_t calculatePressure(int32_t b5, int32_t up) const;
+		int32_t computeB5(int32_t ut) const;
 	};
 }
@@ -10,12 +10,19 @@
 #include <lwiot/types.h>
 #include <lwiot/error.h>
 #include <lwiot/device/bmpsensor.h>
+#include <lwiot/device/asyncsensor.h>
 
 typedef int32_t BMP280_S32_t;
 typedef uint32_t BMP280_U32_t;
 
 typedef int64_t BMP280_S64_t;
 
+/*
+ * Define CONFIG_BMP280_PRESSURE_32BIT to compensate the pressure with the 32-bit algorithm from
+ * the datasheet, for cores without a fast 64-bit multiply. It has a resolution of 1 Pa instead
+ * of 1/256 Pa.
+ */
+
 namespace lwiot
 {
 	typedef enum {
@@ -64,7 +71,16 @@ namespace lwiot
 		};
 	}
 
-	class Bmp280Sensor : public BmpSensor {
+	/**
+	 * @brief BMP280 driver.
+	 *
+	 * The sensor converts continuously in normal mode; a measurement reads the latest
+	 * temperature and pressure in a single burst.
+	 *
+	 * Results are compensated with the integer algorithms from the datasheet and stored as
+	 * integers; temperature() only converts to degrees when it is called.
+	 */
+	class Bmp280Sensor : public BmpSensor, public AsyncSensor {
 	public:
 		explicit Bmp280Sensor(I2CBus& bus);
 		virtual ~Bmp280Sensor() = default;
@@ -74,12 +90,25 @@ namespace lwiot
 		void read(int32_t & pressure, float& temperature);
 		void read();
 
+		bool startMeasurement() override;
+		bool collect() override;
+
+		/**
+		 * @brief Pressure in Pa and temperature in degrees Celsius.
+		 */
+		size_t values(float* values, size_t count) const override;
+
 		const int32_t & pressure() const;
-		const float& temperature() const;
+		float temperature() const;
+
+		/**
+		 * @brief Temperature in 0.01 degrees Celsius.
+		 */
+		int32_t temperatureCentiCelsius() const;
 
 	private:
 		int32_t _pressure;
-		float _temperature;
+		int32_t _temperature;
 		bmp280::CallibrationData _data;
 
 		mutable bool _calibrate;
@@ -88,9 +117,6 @@ namespace lwiot
 		static constexpr int8_t SlaveAddress = 0x77;
 		static constexpr uint8_t ChipId = 0x58;
 
-		inline int32_t readAdcTemperature();
-		inline int32_t readAdcPressure();
-
 		/* Methods */
 		int32_t computeTemperature(int32_t input) const;
 		int32_t computePressure(int32_t input);
@@ -11,6 +11,7 @@
 #include <lwiot/types.h>
 #include <lwiot/log.h>
 #include <lwiot/io/i2cbus.h>
+#include <lwiot/device/registerdevice.h>
 
 namespace lwiot
 {
@@ -30,11 +31,14 @@ namespace lwiot
 		int16_t readS16_LE(uint8_t reg);
 
 		virtual void write(uint8_t reg, uint8_t value);
+		bool read(uint8_t reg, uint8_t *rv, size_t num);
 
-	private:
-		uint8_t _addr;
-		I2CBus _bus;
+		/**
+		 * @brief Read the calibration registers in a single burst and keep them in memory.
+		 */
+		bool cache(uint8_t reg, size_t num);
 
-		bool read(uint8_t reg, uint8_t *rv, size_t num);
+	private:
+		RegisterDevice<uint8_t> _regs;
 	};
 }
@@ -10,6 +10,10 @@
 #include <lwiot/lwiot.h>
 #include <lwiot/types.h>
 #include <lwiot/io/i2cbus.h>
+#include <lwiot/io/gpiochip.h>
+#include <lwiot/device/asyncsensor.h>
+#include <lwiot/device/registerdevice.h>
+#include <lwiot/device/datareadyinterrupt.h>
 
 namespace lwiot
 {
@@ -78,7 +82,19 @@ namespace lwiot
 		};
 	}
 
-	class Ccs811Sensor {
+	/**
+	 * @brief CCS811 driver.
+	 *
+	 * The sensor measures on its own, once per period of its drive mode. A measurement waits for
+	 * the next result after the previous one was collected, and polls the status register once it
+	 * is due. The result block ends with the status register, so a result and its status are
+	 * collected in a single burst.
+	 *
+	 * When the nINT line is connected, enableInterrupt() makes the sensor signal new results and
+	 * the status register is no longer polled: a measurement is ready once the line was pulled
+	 * low, and sample() waits for it.
+	 */
+	class Ccs811Sensor : public AsyncSensor {
 	public:
 		explicit Ccs811Sensor(I2CBus& bus);
 		virtual ~Ccs811Sensor() = default;
@@ -91,6 +107,16 @@ namespace lwiot
 		void setTemperatureOffset(float offset);
 		void setThresholds(uint16_t low, uint16_t medium, uint8_t hysteresis = 50);
 
+		/**
+		 * @brief Handle results on an interrupt of the nINT line.
+		 * @param chip GPIO chip that nINT is connected to.
+		 * @param pin Pin number of nINT.
+		 * @param threshold Only interrupt when the eCO2 level crosses a threshold set by
+		 *                  setThresholds(), instead of on every result.
+		 */
+		bool enableInterrupt(GpioChip& chip, int pin, bool threshold = false);
+		void disableInterrupt();
+
 		uint16_t tvoc() const;
 		uint16_t eco2() const;
 		bool available();
@@ -99,12 +125,25 @@ namespace lwiot
 		double calculateTemperature();
 		bool read();
 
+		bool startMeasurement() override;
+		bool ready() override;
+		bool collect() override;
+
+		/**
+		 * @brief CO2 equivalent and TVOC in ppm and ppb.
+		 */
+		size_t values(float* values, size_t count) const override;
+
+	protected:
+		void await(time_t ms) override;
 
 	private:
-		I2CBus _bus;
+		RegisterDevice<uint8_t> _regs;
+		DataReadyInterrupt _irq;
 		float _temp_offset;
 		uint16_t _tvoc;
 		uint16_t _eco2;
+		time_t _collected;
 
 		ccs811::Status _status;
 		ccs811::MeasurementMode _mode;
@@ -117,6 +156,7 @@ namespace lwiot
 		bool write(uint8_t reg, const void *data, size_t length);
 		bool read(uint8_t reg, uint8_t *buf, size_t length);
 		uint8_t read8(uint8_t reg);
+		time_t period() const;
 
 		void reset();
 	};
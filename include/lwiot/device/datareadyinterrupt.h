@@ -0,0 +1,71 @@
+/*
+ * Sensor data ready interrupt.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/gpiochip.h>
+#include <lwiot/io/irqslot.h>
+
+#ifndef CONFIG_STANDALONE
+#include <lwiot/kernel/event.h>
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Interrupt line of a sensor that signals a new result.
+	 *
+	 * The interrupt handler marks the interrupt as pending and signals an event; wait() blocks on
+	 * that event, so that a reader does not have to poll the sensor over the bus. Without a
+	 * scheduler wait() sleeps until the handler has run.
+	 *
+	 * @see IrqSlot
+	 */
+	class DataReadyInterrupt {
+	public:
+		explicit DataReadyInterrupt();
+		~DataReadyInterrupt();
+
+		DataReadyInterrupt(const DataReadyInterrupt&) = delete;
+		DataReadyInterrupt& operator=(const DataReadyInterrupt&) = delete;
+
+		/**
+		 * @brief Attach to \p pin of \p chip.
+		 * @return False when all IRQ slots are taken.
+		 */
+		bool attach(GpioChip& chip, int pin, IrqEdge edge);
+		void detach();
+		bool attached() const;
+
+		/**
+		 * @brief Check whether the interrupt fired since the last clear().
+		 */
+		bool pending() const;
+		void clear();
+
+		/**
+		 * @brief Wait at most \p tmo milliseconds for the interrupt.
+		 * @return True if the interrupt is pending.
+		 */
+		bool wait(int tmo);
+
+	private:
+		IrqSlot _slot;
+		volatile bool _pending;
+
+#ifndef CONFIG_STANDALONE
+		Event _event;
+#endif
+
+		static void fire(void* arg);
+	};
+}
@@ -13,6 +13,8 @@
 
 #include <lwiot/io/gpiopin.h>
 #include <lwiot/io/dhtbus.h>
+#include <lwiot/io/edgecapture.h>
+#include <lwiot/device/asyncsensor.h>
 
 namespace lwiot
 {
@@ -21,20 +23,46 @@ namespace lwiot
 		DHT22
 	} dht_type_t;
 
-	class DhtSensor {
+	/**
+	 * @brief DHT11 and DHT22 driver.
+	 *
+	 * A measurement waits until the minimum interval between readouts of the sensor passed,
+	 * starts the readout and receives it StartTime milliseconds later. Only receiving the
+	 * readout itself blocks; with an EdgeCapture it does so without disabling interrupts.
+	 */
+	class DhtSensor : public AsyncSensor {
 	public:
 		explicit DhtSensor(const GpioPin& pin, dht_type_t type = DHT22);
+		explicit DhtSensor(const GpioPin& pin, EdgeCapture& capture, dht_type_t type = DHT22);
 		virtual ~DhtSensor() = default;
 
 		bool read(float& humidity, float& temperature);
 		const dht_type_t& type() const;
 
+		bool startMeasurement() override;
+		bool ready() override;
+		bool collect() override;
+
+		/**
+		 * @brief Relative humidity in percent and temperature in degrees Celsius.
+		 */
+		size_t values(float* values, size_t count) const override;
+
+		float humidity() const;
+		float temperature() const;
+
 	private:
 		DhtBus _io;
 		dht_type_t _type;
+		bool _started;
+		bool _sampled;
+		time_t _last;
+		float _humidity;
+		float _temperature;
 
 		/* Methods */
 		int16_t convert(uint8_t msb, uint8_t lsb);
 		bool read(int16_t& humid, int16_t& temperature);
+		time_t interval() const;
 	};
 }
@@ -11,26 +11,43 @@
 #include <lwiot/error.h>
 #include <lwiot/io/i2cbus.h>
 #include <lwiot/io/i2cmessage.h>
-#include <lwiot/kernel/lock.h>
+#include <lwiot/io/blockdevice.h>
+
+#ifndef CONFIG_EEPROM_WRITE_TIME
+#define CONFIG_EEPROM_WRITE_TIME 10
+#endif
 
 namespace lwiot
 {
-	class Eeprom24C02 {
+	/**
+	 * @brief 24C02 EEPROM.
+	 *
+	 * A page write returns as soon as the chip accepted the data. The next transfer polls the
+	 * chip until it acknowledges again, for at most CONFIG_EEPROM_WRITE_TIME milliseconds.
+	 */
+	class Eeprom24C02 : public BlockDevice {
 	public:
 		explicit Eeprom24C02(I2CBus& bus);
-		~Eeprom24C02() = default;
+		~Eeprom24C02() override;
+
+		using BlockDevice::read;
+		using BlockDevice::write;
 
 		uint8_t read(uint8_t addr);
 		void write(uint8_t addr, uint8_t byte);
 
-		ssize_t read(uint8_t addr, void *data, size_t length);
-		ssize_t write(uint8_t addr, const void *data, size_t length);
+	protected:
+		bool readBurst(size_t addr, void *data, size_t length) override;
+		bool writeBurst(size_t addr, const void *data, size_t length) override;
 
 	private:
 		I2CBus& _bus;
-		Lock _lock;
+		bool _busy;
 
 		static constexpr int8_t PageSize = 4;
 		static constexpr int8_t SlaveAddress = 0x50;
+		static constexpr size_t Size = 256;
+
+		bool poll();
 	};
 }
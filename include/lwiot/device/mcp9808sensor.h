@@ -16,10 +16,17 @@
 
 #include <lwiot/kernel/uniquelock.h>
 #include <lwiot/stl/referencewrapper.h>
+#include <lwiot/device/asyncsensor.h>
 
 namespace lwiot
 {
-	class MCP9808Sensor {
+	/**
+	 * @brief MCP9808 driver.
+	 *
+	 * The sensor converts continuously; a measurement is only delayed by the first conversion
+	 * after begin() or wake().
+	 */
+	class MCP9808Sensor : public AsyncSensor {
 	public:
 		explicit MCP9808Sensor();
 		~MCP9808Sensor() = default;
@@ -31,12 +38,24 @@ namespace lwiot
 		float read();
 		void setResolution(int resolution);
 
+		bool startMeasurement() override;
+		bool collect() override;
+
+		/**
+		 * @brief Temperature in degrees Celsius.
+		 */
+		size_t values(float* values, size_t count) const override;
+		float temperature() const;
+
 		static constexpr uint8_t I2C_ADDRESS = 0x18;
 
 	private:
 		stl::ReferenceWrapper<I2CBus> _bus;
 		uint8_t _addr;
 		Lock _lock;
+		int _resolution;
+		time_t _woken;
+		float _temperature;
 
 	private:
 		void write16(uint8_t reg, uint16_t value);
@@ -44,5 +63,6 @@ namespace lwiot
 
 		uint8_t read8(uint8_t reg);
 		uint16_t read16(uint8_t reg);
+		time_t conversionTime() const;
 	};
 }
@@ -0,0 +1,262 @@
+/*
+ * Register mapped I2C device.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/io/i2cbus.h>
+#include <lwiot/io/i2cmessage.h>
+#include <lwiot/stl/smallvector.h>
+#include <lwiot/stl/move.h>
+
+#ifndef CONFIG_REGISTER_DEVICE_BURST
+#define CONFIG_REGISTER_DEVICE_BURST 32
+#endif
+
+#ifndef CONFIG_REGISTER_DEVICE_GAP
+#define CONFIG_REGISTER_DEVICE_GAP 2
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief I2C device with a register map that auto-increments the register address.
+	 * @tparam AddrT Register address type; addresses are sent MSB first.
+	 *
+	 * Every read is a single write-then-read transaction with a repeated start, no matter how
+	 * many registers it spans. Devices that only auto-increment when a flag is set in the
+	 * register address pass that flag as \p increment; it is added to multi-byte accesses.
+	 *
+	 * read(Span*, size_t) coalesces reads of registers that are close to each other into as few
+	 * transactions as possible. A block of registers that does not change, such as calibration
+	 * data, can be cache()d after initialisation; reads of cached registers do not touch the bus.
+	 * Writes update the cache, so registers that are only written by the driver can be cached as
+	 * well.
+	 */
+	template <typename AddrT = uint8_t>
+	class RegisterDevice {
+	public:
+		struct Span {
+			AddrT reg;
+			uint8_t* data;
+			size_t length;
+		};
+
+		explicit RegisterDevice(I2CBus& bus, uint16_t addr, AddrT increment = 0) :
+			_bus(bus), _addr(addr), _increment(increment), _cache(0, true), _cache_first(0), _cache_length(0)
+		{
+		}
+
+		virtual ~RegisterDevice() = default;
+
+		bool read(AddrT reg, uint8_t* data, size_t length)
+		{
+			if(this->cached(reg, length)) {
+				memcpy(data, this->_cache.data() + (reg - this->_cache_first), length);
+				return true;
+			}
+
+			return this->transfer(reg, data, length);
+		}
+
+		bool read8(AddrT reg, uint8_t& value)
+		{
+			return this->read(reg, &value, 1);
+		}
+
+		bool read16(AddrT reg, uint16_t& value, bool le = false)
+		{
+			uint8_t raw[2];
+
+			if(!this->read(reg, raw, sizeof(raw)))
+				return false;
+
+			value = le ? raw[0] | (raw[1] << BITS_PER_BYTE) : (raw[0] << BITS_PER_BYTE) | raw[1];
+			return true;
+		}
+
+		/**
+		 * @brief Read several register blocks.
+		 * @param spans Blocks to read; they are sorted by register address.
+		 * @param count Number of blocks.
+		 *
+		 * Blocks that are at most CONFIG_REGISTER_DEVICE_GAP registers apart are read in a
+		 * single transaction of at most CONFIG_REGISTER_DEVICE_BURST bytes.
+		 */
+		bool read(Span* spans, size_t count)
+		{
+			uint8_t buffer[CONFIG_REGISTER_DEVICE_BURST];
+
+			for(size_t idx = 1; idx < count; idx++) {
+				for(size_t pos = idx; pos > 0 && spans[pos].reg < spans[pos - 1].reg; pos--) {
+					auto tmp = spans[pos];
+					spans[pos] = spans[pos - 1];
+					spans[pos - 1] = tmp;
+				}
+			}
+
+			for(size_t first = 0; first < count;) {
+				auto& head = spans[first];
+				size_t last = first + 1;
+				size_t end = head.reg + head.length;
+
+				if(this->cached(head.reg, head.length) || head.length > sizeof(buffer)) {
+					if(!this->read(head.reg, head.data, head.length))
+						return false;
+
+					first++;
+					continue;
+				}
+
+				for(; last < count; last++) {
+					auto& span = spans[last];
+					size_t next = span.reg + span.length;
+
+					if(span.reg > end + CONFIG_REGISTER_DEVICE_GAP || this->cached(span.reg, span.length))
+						break;
+
+					if(next > end && next - head.reg > sizeof(buffer))
+						break;
+
+					end = next > end ? next : end;
+				}
+
+				if(!this->transfer(head.reg, buffer, end - head.reg))
+					return false;
+
+				for(; first < last; first++) {
+					auto& span = spans[first];
+					memcpy(span.data, buffer + (span.reg - head.reg), span.length);
+				}
+			}
+
+			return true;
+		}
+
+		bool write(AddrT reg, const uint8_t* data, size_t length)
+		{
+			I2CMessage msg(sizeof(AddrT) + length);
+
+			msg.setAddress(this->_addr, false, false);
+			msg.setRepeatedStart(false);
+			this->address(msg, length > 1 ? static_cast<AddrT>(reg | this->_increment) : reg);
+
+			if(length)
+				msg.writeUnchecked(data, length);
+
+			if(!this->_bus.transfer(msg)) {
+				print_dbg("Unable to write register 0x%X of I2C device 0x%X\n", reg, this->_addr);
+				return false;
+			}
+
+			this->update(reg, data, length);
+			return true;
+		}
+
+		bool write8(AddrT reg, uint8_t value)
+		{
+			return this->write(reg, &value, 1);
+		}
+
+		/**
+		 * @brief Read \p length registers starting at \p first and serve later reads from memory.
+		 * @note Only a single block can be cached; a new block replaces the previous one.
+		 */
+		bool cache(AddrT first, size_t length)
+		{
+			ByteBuffer cache(length, true);
+
+			this->invalidate();
+
+			if(!this->transfer(first, cache.data(), length))
+				return false;
+
+			this->_cache = stl::move(cache);
+			this->_cache_first = first;
+			this->_cache_length = length;
+
+			return true;
+		}
+
+		void invalidate()
+		{
+			this->_cache_length = 0;
+		}
+
+	protected:
+		I2CBus _bus;
+		uint16_t _addr;
+
+	private:
+		AddrT _increment;
+		ByteBuffer _cache;
+		AddrT _cache_first;
+		size_t _cache_length;
+
+		bool cached(AddrT reg, size_t length) const
+		{
+			return this->_cache_length && reg >= this->_cache_first &&
+			       reg + length <= this->_cache_first + this->_cache_length;
+		}
+
+		void update(AddrT reg, const uint8_t* data, size_t length)
+		{
+			for(size_t idx = 0; idx < length; idx++) {
+				size_t offset = reg + idx;
+
+				if(offset >= this->_cache_first && offset < this->_cache_first + this->_cache_length)
+					this->_cache[offset - this->_cache_first] = data[idx];
+			}
+		}
+
+		static void address(I2CMessage& msg, AddrT reg)
+		{
+			for(auto idx = sizeof(AddrT); idx > 0; idx--)
+				msg.writeUnchecked(static_cast<uint8_t>(reg >> ((idx - 1) * BITS_PER_BYTE)));
+		}
+
+		bool transfer(AddrT reg, uint8_t* data, size_t length)
+		{
+			I2CMessage wr(sizeof(AddrT)), rd(length);
+			stl::SmallVector<I2CMessage, 2> msgs;
+			size_t idx = 0;
+
+			wr.setAddress(this->_addr, false, false);
+			wr.setRepeatedStart(true);
+			this->address(wr, length > 1 ? static_cast<AddrT>(reg | this->_increment) : reg);
+
+			rd.setAddress(this->_addr, false, true);
+			rd.setRepeatedStart(false);
+
+			msgs.pushback(stl::move(wr));
+			msgs.pushback(stl::move(rd));
+
+			if(!this->_bus.transfer(msgs)) {
+				print_dbg("Unable to read %u bytes from I2C device 0x%X\n", length, this->_addr);
+				return false;
+			}
+
+			rd = stl::move(msgs.back());
+
+			for(auto byte : rd) {
+				if(idx >= length)
+					break;
+
+				data[idx++] = byte;
+			}
+
+			return idx == length;
+		}
+	};
+}
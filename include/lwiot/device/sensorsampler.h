@@ -0,0 +1,57 @@
+/*
+ * Timer driven sensor sampling.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/kernel/timer.h>
+#include <lwiot/device/asyncsensor.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Sample an AsyncSensor on the timer service.
+	 *
+	 * Every interval the sampler triggers a measurement and arms its timer for the moment the
+	 * sensor expects to be ready, so that no thread sleeps while the sensor converts. Once the
+	 * measurement is collected the handler is called with the outcome. A sensor that is not ready
+	 * on time is polled again every millisecond; an interval that is shorter than the measurement
+	 * takes starts the next measurement right after the previous one was collected.
+	 *
+	 * @note The handler runs on the timer thread and should not block.
+	 */
+	class SensorSampler : public Timer {
+	public:
+		typedef Function<void(AsyncSensor& sensor, bool ok)> Handler;
+
+		explicit SensorSampler(AsyncSensor& sensor, time_t interval, const Handler& handler);
+		~SensorSampler() override = default;
+
+		void start();
+		using Timer::stop;
+
+		AsyncSensor& sensor() const;
+		time_t interval() const;
+
+	protected:
+		void tick() override;
+
+	private:
+		AsyncSensor& _sensor;
+		time_t _interval;
+		Handler _handler;
+		time_t _started;
+
+		void trigger();
+		void arm(time_t ms);
+	};
+}
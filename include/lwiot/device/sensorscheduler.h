@@ -0,0 +1,131 @@
+/*
+ * Multi-sensor sampling scheduler.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/i2cbus.h>
+#include <lwiot/kernel/timer.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/stl/ringbuffer.h>
+#include <lwiot/device/asyncsensor.h>
+
+#ifndef CONFIG_SENSOR_READING_VALUES
+#define CONFIG_SENSOR_READING_VALUES 2
+#endif
+
+#ifndef CONFIG_SENSOR_SCHEDULER_READINGS
+#define CONFIG_SENSOR_SCHEDULER_READINGS 32
+#endif
+
+#ifndef CONFIG_SENSOR_SCHEDULER_GRANULARITY
+#define CONFIG_SENSOR_SCHEDULER_GRANULARITY 10
+#endif
+
+#ifndef CONFIG_SENSOR_SCHEDULER_SLACK
+#define CONFIG_SENSOR_SCHEDULER_SLACK 5
+#endif
+
+namespace lwiot
+{
+	struct SensorReading {
+		int sensor; //!< Identifier returned by SensorScheduler::add().
+		time_t timestamp; //!< Time at which the measurement was collected, in milliseconds.
+		bool ok; //!< False if the measurement failed; no values are available.
+		uint8_t count; //!< Number of values.
+		float values[CONFIG_SENSOR_READING_VALUES];
+	};
+
+	/**
+	 * @brief Sample several AsyncSensors from a single timer.
+	 *
+	 * Every sensor is sampled at a multiple of its period from the moment the scheduler started.
+	 * Periods are rounded up to CONFIG_SENSOR_SCHEDULER_GRANULARITY milliseconds, so that sensors
+	 * with related periods are sampled together. A measurement is triggered its conversion time
+	 * ahead of its sample time, which overlaps the conversions of all sensors; a conversion time
+	 * that is not given is learned from the driver. Triggers that are due within
+	 * CONFIG_SENSOR_SCHEDULER_SLACK milliseconds are taken early, to share a wake up.
+	 *
+	 * On each wake up the sensors of a bus are collected and triggered in a single batch, during
+	 * which the bus is held. Readings are timestamped and queued in a ring buffer of
+	 * CONFIG_SENSOR_SCHEDULER_READINGS entries; when it is full new readings are dropped.
+	 *
+	 * @note Only a single thread may read() readings. Sensors run on the timer thread.
+	 */
+	class SensorScheduler : public Timer {
+	public:
+		explicit SensorScheduler();
+		~SensorScheduler() override;
+
+		/**
+		 * @brief Register a sensor.
+		 * @param sensor Sensor to sample.
+		 * @param period Sample period in milliseconds.
+		 * @param conversion Conversion time in milliseconds, or 0 to learn it from \p sensor.
+		 * @return Identifier of the sensor in readings, or -EINVALID.
+		 */
+		int add(AsyncSensor& sensor, time_t period, time_t conversion = 0);
+
+		/**
+		 * @brief Register a sensor on \p bus.
+		 * @see add
+		 */
+		int add(AsyncSensor& sensor, const I2CBus& bus, time_t period, time_t conversion = 0);
+
+		void start();
+		void stop();
+
+		/**
+		 * @brief Take the oldest reading.
+		 * @return False when no reading is available.
+		 */
+		bool read(SensorReading& reading);
+		size_t available() const;
+
+		uint32_t dropped() const; //!< Readings that did not fit in the ring buffer.
+		uint32_t overruns() const; //!< Samples that were skipped because a sensor was late.
+		uint32_t wakeups() const; //!< Timer ticks handled.
+
+	protected:
+		void tick() override;
+
+	private:
+		struct Entry {
+			AsyncSensor* sensor;
+			I2CBus bus;
+			bool shared;
+			time_t period;
+			time_t conversion;
+			time_t due;
+			time_t started;
+			bool learn;
+		};
+
+		stl::Vector<Entry> _entries;
+		stl::RingBuffer<SensorReading, CONFIG_SENSOR_SCHEDULER_READINGS> _readings;
+		mutable Lock _lock;
+		bool _running;
+		time_t _epoch;
+
+		uint32_t _dropped;
+		uint32_t _overruns;
+		uint32_t _wakeups;
+
+		void align(Entry& entry, time_t now);
+		void batch(size_t first, time_t now);
+		void collect(size_t id, Entry& entry);
+		void trigger(size_t id, Entry& entry, time_t now);
+		void push(size_t id, const Entry& entry, bool ok);
+		void arm(time_t now);
+		static bool sameBus(const Entry& a, const Entry& b);
+	};
+}
@@ -9,13 +9,14 @@
 
 #include <lwiot/io/i2cbus.h>
 #include <lwiot/stl/referencewrapper.h>
+#include <lwiot/device/asyncsensor.h>
 
 #define SGP30_CRC8_POLYNOMIAL 0x31
 #define SGP30_CRC8_INIT 0xFF
 
 namespace lwiot
 {
-	class Sgp30Sensor {
+	class Sgp30Sensor : public AsyncSensor {
 	public:
 		explicit Sgp30Sensor() : _bus(), _tvoc(0), _co2(0)
 		{ }
@@ -26,6 +27,14 @@ namespace lwiot
 		bool setHumidity(uint32_t abs);
 		bool measure();
 
+		bool startMeasurement() override;
+		bool collect() override;
+
+		/**
+		 * @brief CO2 equivalent and TVOC in ppm and ppb.
+		 */
+		size_t values(float* values, size_t count) const override;
+
 		inline uint16_t tvoc() const
 		{
 			return this->_tvoc;
@@ -48,5 +57,7 @@ namespace lwiot
 
 		bool init();
 		bool read(uint8_t cmd[], int len, uint16_t ms, uint16_t *result = nullptr, int readlen = 0);
+		bool command(uint8_t cmd[], int len);
+		bool response(uint16_t *result, int readlen);
 	};
 }
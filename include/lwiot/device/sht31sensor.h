@@ -11,6 +11,7 @@
 
 #include <lwiot/stl/referencewrapper.h>
 #include <lwiot/io/i2cbus.h>
+#include <lwiot/device/asyncsensor.h>
 
 #define SHT31_DEFAULT_ADDR         0x44
 #define SHT31_MEAS_HIGHREP_STRETCH 0x2C06
@@ -27,31 +28,52 @@
 
 namespace lwiot
 {
-	class Sht31Sensor {
+	/**
+	 * @brief SHT31 driver.
+	 *
+	 * collect() only stores the raw signal words; they are converted when a result is asked
+	 * for. The *Milli*() accessors use the integer conversion of the Sensirion reference driver.
+	 * When CONFIG_SENSOR_FIXED_POINT is defined, temperature(), humidity() and values() are
+	 * derived from those as well, so that no double arithmetic is done on cores that would
+	 * emulate it.
+	 */
+	class Sht31Sensor : public AsyncSensor {
 	public:
 		explicit Sht31Sensor();
 		explicit Sht31Sensor(I2CBus& io);
 		virtual ~Sht31Sensor() = default;
 
 		bool begin();
-		double humidity();
-		double temperature();
+		double humidity() const;
+		double temperature() const;
+
+		int32_t temperatureMilliCelsius() const; //!< Temperature in 0.001 degrees Celsius.
+		int32_t humidityMilliPercent() const; //!< Relative humidity in 0.001 percent.
 		void reset();
 		void setHeaterStatus(bool enable);
 
 		void measure();
 
+		bool startMeasurement() override;
+		bool collect() override;
+
+		/**
+		 * @brief Temperature in degrees Celsius and relative humidity in percent.
+		 */
+		size_t values(float* values, size_t count) const override;
+
 		void setBus(I2CBus& io);
 
 	private:
 		stl::ReferenceWrapper<I2CBus> _bus;
 
 		/* Methods */
-		void writeCommaned(uint16_t cmd);
+		bool writeCommaned(uint16_t cmd);
 
 		struct ShtResult {
-			double temperature;
-			double humidity;
+			uint16_t temperature;
+			uint16_t humidity;
+			bool valid;
 		} _result;
 	};
 }
@@ -17,18 +17,27 @@
 #include <lwiot/bytebuffer.h>
 
 #include <lwiot/stl/referencewrapper.h>
+#include <lwiot/stl/vector.h>
 
 #include <lwiot/io/spimessage.h>
 #include <lwiot/io/spibus.h>
+#include <lwiot/io/blockdevice.h>
 
 #include <lwiot/device/sram23k256.h>
 
 namespace lwiot
 {
-	class SRAM23K256 {
+	/**
+	 * @brief 23K256 SRAM, which is used in sequential mode: a burst may span the whole chip.
+	 */
+	class SRAM23K256 : public BlockDevice {
 	public:
 		explicit SRAM23K256(int cs = 1);
 		explicit SRAM23K256(SpiBus& bus, int cs = 1);
+		~SRAM23K256() override;
+
+		using BlockDevice::read;
+		using BlockDevice::write;
 
 		void begin();
 		void begin(SpiBus& bus, int cs = 1);
@@ -36,11 +45,18 @@ namespace lwiot
 		ByteBuffer read(size_t addr, size_t length);
 		void write(size_t addr, const ByteBuffer& buffer);
 
+	protected:
+		bool readBurst(size_t addr, void *data, size_t length) override;
+		bool writeBurst(size_t addr, const void *data, size_t length) override;
+
 	private:
 		stl::ReferenceWrapper<SpiBus> _bus;
 		GpioPin _cs;
 
+		static constexpr size_t Size = 32768;
+
 		/* Methods */
 		void mode(uint16_t mode);
+		void command(SpiMessage& msg, uint8_t cmd, size_t addr) const;
 	};
 }
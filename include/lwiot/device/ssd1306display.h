@@ -8,10 +8,13 @@
 #pragma once
 
 #include <lwiot/types.h>
+#include <lwiot/uniquepointer.h>
 #include <lwiot/kernel/lock.h>
+#include <lwiot/io/gpiopin.h>
 #include <lwiot/io/i2cbus.h>
-#include <lwiot/io/i2cmessage.h>
+#include <lwiot/io/spibus.h>
 #include <lwiot/gfxbase.h>
+#include <lwiot/device/ssd1306transport.h>
 
 #define BLACK    0
 #define WHITE    1
@@ -40,15 +43,65 @@ namespace lwiot
 	class Ssd1306Display : public GfxBase {
 	public:
 		explicit Ssd1306Display(I2CBus& bus, uint8_t addr = Ssd1306Display::SlaveAddress);
+
+		/**
+		 * @brief Drive the display over 4-wire SPI.
+		 *
+		 * The controller accepts a serial clock of up to 10 MHz, at which a full frame takes about a
+		 * millisecond. \p rst may be left unconnected, in which case begin() does not reset the
+		 * controller.
+		 */
+		explicit Ssd1306Display(SpiBus& bus, int cs, const GpioPin& dc, const GpioPin& rst = GpioPin(),
+		                        uint32_t freq = CONFIG_SSD1306_SPI_FREQUENCY);
+
+		/**
+		 * @brief Drive the display through \p transport, which the display takes ownership of.
+		 */
+		explicit Ssd1306Display(Ssd1306Transport* transport);
+		Ssd1306Display(const Ssd1306Display&) = delete;
 		virtual ~Ssd1306Display() = default;
 
+		Ssd1306Display& operator=(const Ssd1306Display&) = delete;
+
 		void begin();
 
 		void clear();
 		virtual void invert(bool invert) override;
 		void dim(bool dim);
+
+		/**
+		 * @brief Send the part of the frame buffer that changed since the last refresh.
+		 *
+		 * Drawing marks the columns and pages it touches. The bounding window of those is sent in
+		 * a single transfer after COLUMNADDR and PAGEADDR select it on the display; a fully dirty
+		 * frame is sent straight from the frame buffer.
+		 */
 		void display();
 
+		/**
+		 * @brief Mark the entire frame buffer as changed, so that the next display() sends all of it.
+		 */
+		void invalidate();
+
+		/**
+		 * @brief Draw into a back buffer, and show it with swap().
+		 *
+		 * display() then sends the front buffer, so that drawing the next frame can overlap the
+		 * transfer of the previous one on another thread. Costs a second frame buffer.
+		 *
+		 * @return False if the back buffer could not be allocated.
+		 */
+		bool enableDoubleBuffering();
+
+		/**
+		 * @brief Make the back buffer the front buffer.
+		 *
+		 * Waits for a running display(). The new back buffer starts as a copy of the new front
+		 * buffer, so that drawing can continue where it left off. Without double buffering this is
+		 * the same as display().
+		 */
+		void swap();
+
 		void startScrollRight(uint8_t start, uint8_t stop);
 		void startScrollLeft(uint8_t start, uint8_t stop);
 
@@ -60,16 +113,53 @@ namespace lwiot
 		void drawPixel(int16_t x, int16_t y, uint16_t color) override;
 		void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
 		void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+		void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+
+		void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color) override;
+		void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h,
+		                uint16_t color, uint16_t bg) override;
+		void drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color) override;
+		void drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h,
+		                uint16_t color, uint16_t bg) override;
+		void drawColumnBitmap(int16_t x, int16_t y, const uint8_t* columns, int16_t w, int16_t h,
+		                      uint16_t color, uint16_t bg, bool opaque) override;
 
 	protected:
 		void writeCommand(uint8_t cmd);
+		void writeCommands(const uint8_t* cmds, size_t num);
 
 	private:
-		I2CBus _bus;
-		uint8_t _i2caddr;
+		UniquePointer<Ssd1306Transport> _transport;
+
+		struct Window {
+			bool dirty;
+			uint8_t x0;
+			uint8_t x1;
+			uint8_t p0;
+			uint8_t p1;
+
+			void add(const Window& other);
+		};
+
+		/* Both frame buffers are owned by the transport. */
+		uint8_t* _buffer;
+		uint8_t* _front;
+		bool _double;
+		Lock _lock;
+
+		Window _drawn; /* Changes to _buffer */
+		Window _pending; /* Changes that have not been sent */
+
+		void markDirty(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+		void flush();
+
 		static constexpr uint8_t SlaveAddress = 0x3C;
 
 		void inline rawDrawVerticalLine(int16_t x, int16_t y, int16_t h, uint16_t color);
 		void inline rawDrawHorizontalLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+		void rawFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+		void blitBitmap(int16_t x, int16_t y, const uint8_t* bitmap, int16_t w, int16_t h, uint16_t color,
+		                uint16_t bg, bool opaque, bool progmem);
+		void column(int16_t x, int16_t y, uint8_t bits, uint8_t mask, uint16_t color, uint16_t bg, bool opaque);
 	};
 }
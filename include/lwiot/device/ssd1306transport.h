@@ -0,0 +1,117 @@
+/*
+ * SSD1306 bus transports.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <lwiot/types.h>
+#include <lwiot/io/gpiopin.h>
+#include <lwiot/io/i2cbus.h>
+#include <lwiot/io/i2cmessage.h>
+#include <lwiot/io/spibus.h>
+#include <lwiot/io/spidevice.h>
+#include <lwiot/io/spimessage.h>
+#include <lwiot/stl/vector.h>
+
+#ifndef CONFIG_SSD1306_SPI_FREQUENCY
+#define CONFIG_SSD1306_SPI_FREQUENCY 8000000UL
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Link between an Ssd1306Display and its controller.
+	 *
+	 * The display owns the drawing state and decides what to send; a transport frames commands
+	 * and display data for its bus. Frame buffers are allocated by the transport, so that it can
+	 * keep them in a message that sends a full frame without copying it.
+	 */
+	class Ssd1306Transport {
+	public:
+		static constexpr size_t MaxFrames = 2;
+
+		explicit Ssd1306Transport() = default;
+		virtual ~Ssd1306Transport() = default;
+
+		Ssd1306Transport(const Ssd1306Transport&) = delete;
+		Ssd1306Transport& operator=(const Ssd1306Transport&) = delete;
+
+		/**
+		 * @brief Reset the controller, if the transport has a reset line.
+		 */
+		virtual void reset();
+
+		virtual bool command(const uint8_t* cmds, size_t num) = 0;
+
+		/**
+		 * @brief Allocate one of at most MaxFrames frame buffers of \p size bytes.
+		 *
+		 * The buffer lives as long as the transport does.
+		 *
+		 * @return The frame buffer, or nullptr if it could not be allocated.
+		 */
+		virtual uint8_t* allocate(size_t size) = 0;
+
+		/**
+		 * @brief Send columns \p x0 to \p x1 of pages \p p0 to \p p1 of \p frame.
+		 *
+		 * The window has already been selected with COLUMNADDR and PAGEADDR. \p frame is a buffer
+		 * from allocate(), in which pages are \p stride bytes apart.
+		 */
+		virtual bool data(const uint8_t* frame, size_t stride, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1) = 0;
+	};
+
+	class Ssd1306I2CTransport : public Ssd1306Transport {
+	public:
+		explicit Ssd1306I2CTransport(I2CBus& bus, uint8_t addr);
+		~Ssd1306I2CTransport() override = default;
+
+		bool command(const uint8_t* cmds, size_t num) override;
+		uint8_t* allocate(size_t size) override;
+		bool data(const uint8_t* frame, size_t stride, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1) override;
+
+	private:
+		I2CBus _bus;
+		uint8_t _addr;
+
+		/* The frame buffers live in the messages that send them, after the data control byte. */
+		I2CMessage _frames[MaxFrames];
+		size_t _count;
+		size_t _size;
+	};
+
+	/**
+	 * @brief 4-wire SPI link: chip select, and a D/C line that selects commands or display data.
+	 *
+	 * The SSD1306 samples D/C with the last bit of every byte, so D/C is only driven when it
+	 * changes: consecutive commands share one level, and a refresh switches it once for all the
+	 * pages of its window. A full frame is sent straight from the frame buffer, a partial window
+	 * as a single packed message, so that a DMA capable bus runs either as one transfer.
+	 */
+	class Ssd1306SpiTransport : public Ssd1306Transport {
+	public:
+		explicit Ssd1306SpiTransport(SpiBus& bus, int cs, const GpioPin& dc, const GpioPin& rst = GpioPin(),
+		                             uint32_t freq = CONFIG_SSD1306_SPI_FREQUENCY);
+		~Ssd1306SpiTransport() override = default;
+
+		void reset() override;
+		bool command(const uint8_t* cmds, size_t num) override;
+		uint8_t* allocate(size_t size) override;
+		bool data(const uint8_t* frame, size_t stride, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1) override;
+
+	private:
+		SpiDevice _device;
+		GpioPin _dc;
+		GpioPin _rst;
+		bool _data;
+
+		/* The frame buffers are the transmit buffers of these messages. */
+		stl::Vector<SpiMessage> _frames;
+		size_t _size;
+
+		void select(bool data);
+	};
+}
@@ -0,0 +1,344 @@
+/*
+ * Type safe string formatting.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <lwiot.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/traits/enableif.h>
+#include <lwiot/traits/integralconstant.h>
+#include <lwiot/traits/issame.h>
+#include <lwiot/traits/isintegral.h>
+#include <lwiot/traits/isfloatingpoint.h>
+#include <lwiot/traits/isconvirtible.h>
+#include <lwiot/traits/removecv.h>
+
+#ifdef __cplusplus
+/**
+ * @brief Create a format string that is validated at compile time.
+ * @param str Format string literal.
+ * @see lwiot::format()
+ */
+#define LWIOT_FMT(str) \
+	([]() { \
+		struct FormatLiteralImpl : public lwiot::detail::FormatLiteral { \
+			static constexpr const char *get() { return str; } \
+		}; \
+		return FormatLiteralImpl(); \
+	}())
+
+namespace lwiot
+{
+	namespace detail
+	{
+		enum class FormatKind : uint8_t {
+			None,
+			Signed,
+			Unsigned,
+			Float,
+			Char,
+			Bool,
+			String,
+			Pointer
+		};
+
+		struct FormatLiteral {
+		};
+
+		struct FormatArg {
+			FormatKind kind;
+			size_t length;
+
+			union {
+				long long i;
+				unsigned long long u;
+				double f;
+				const char *s;
+				const void *p;
+			};
+
+			FormatArg() : kind(FormatKind::None), length(0), u(0)
+			{ }
+		};
+
+		template <typename T, bool = traits::IsIntegral<T>::value>
+		struct IsSignedIntegral : public traits::FalseType {
+		};
+
+		template <typename T>
+		struct IsSignedIntegral<T, true> : public traits::BoolConstant<(T(-1) < T(0))> {
+		};
+
+		template <typename T, typename = void>
+		struct FormatTraits;
+
+		template <typename T>
+		struct FormatTraits<T, traits::EnableIf_t<IsSignedIntegral<T>::value && !traits::IsSame<T, char>::value>> {
+			static constexpr FormatKind kind = FormatKind::Signed;
+
+			static FormatArg make(T value)
+			{
+				FormatArg arg;
+
+				arg.kind = kind;
+				arg.i = value;
+				return arg;
+			}
+		};
+
+		template <typename T>
+		struct FormatTraits<T, traits::EnableIf_t<traits::IsIntegral<T>::value && !IsSignedIntegral<T>::value &&
+				!traits::IsSame<T, char>::value && !traits::IsSame<T, bool>::value>> {
+			static constexpr FormatKind kind = FormatKind::Unsigned;
+
+			static FormatArg make(T value)
+			{
+				FormatArg arg;
+
+				arg.kind = kind;
+				arg.u = value;
+				return arg;
+			}
+		};
+
+		template <typename T>
+		struct FormatTraits<T, traits::EnableIf_t<traits::IsFloatingPoint<T>::value>> {
+			static constexpr FormatKind kind = FormatKind::Float;
+
+			static FormatArg make(T value)
+			{
+				FormatArg arg;
+
+				arg.kind = kind;
+				arg.f = static_cast<double>(value);
+				return arg;
+			}
+		};
+
+		template <>
+		struct FormatTraits<char> {
+			static constexpr FormatKind kind = FormatKind::Char;
+
+			static FormatArg make(char value)
+			{
+				FormatArg arg;
+
+				arg.kind = kind;
+				arg.u = static_cast<unsigned char>(value);
+				return arg;
+			}
+		};
+
+		template <>
+		struct FormatTraits<bool> {
+			static constexpr FormatKind kind = FormatKind::Bool;
+
+			static FormatArg make(bool value)
+			{
+				FormatArg arg;
+
+				arg.kind = kind;
+				arg.u = value;
+				return arg;
+			}
+		};
+
+		template <>
+		struct FormatTraits<const char *> {
+			static constexpr FormatKind kind = FormatKind::String;
+
+			static FormatArg make(const char *value)
+			{
+				FormatArg arg;
+
+				arg.kind = kind;
+				arg.s = value ? value : "(null)";
+				arg.length = strlen(arg.s);
+				return arg;
+			}
+		};
+
+		template <>
+		struct FormatTraits<char *> : public FormatTraits<const char *> {
+		};
+
+		template <size_t N>
+		struct FormatTraits<char[N]> : public FormatTraits<const char *> {
+		};
+
+		template <>
+		struct FormatTraits<StringView> {
+			static constexpr FormatKind kind = FormatKind::String;
+
+			static FormatArg make(const StringView &value)
+			{
+				FormatArg arg;
+
+				arg.kind = kind;
+				arg.s = value.data();
+				arg.length = value.length();
+				return arg;
+			}
+		};
+
+		template <>
+		struct FormatTraits<String> {
+			static constexpr FormatKind kind = FormatKind::String;
+
+			static FormatArg make(const String &value)
+			{
+				return FormatTraits<StringView>::make(StringView(value));
+			}
+		};
+
+		template <typename T>
+		struct FormatTraits<T *, traits::EnableIf_t<!traits::IsSame<typename traits::RemoveCv<T>::type, char>::value>> {
+			static constexpr FormatKind kind = FormatKind::Pointer;
+
+			static FormatArg make(const T *value)
+			{
+				FormatArg arg;
+
+				arg.kind = kind;
+				arg.p = value;
+				return arg;
+			}
+		};
+
+		template <typename T>
+		using FormatTraitsOf = FormatTraits<typename traits::RemoveCv<T>::type>;
+
+		struct FormatSpec {
+			char type;
+			int precision;
+		};
+
+		/*
+		 * Parse the replacement field that starts at `fmt'. Returns the number of characters parsed,
+		 * or 0 when the field is malformed.
+		 */
+		constexpr size_t parse_format_spec(const char *fmt, FormatSpec &spec)
+		{
+			size_t idx = 1;
+
+			spec.type = '\0';
+			spec.precision = -1;
+
+			if(fmt[idx] == ':') {
+				idx++;
+
+				if(fmt[idx] == '.') {
+					idx++;
+
+					if(fmt[idx] < '0' || fmt[idx] > '9')
+						return 0;
+
+					spec.precision = fmt[idx++] - '0';
+				}
+
+				if(fmt[idx] == 'x' || fmt[idx] == 'X' || fmt[idx] == 'b' || fmt[idx] == 'o')
+					spec.type = fmt[idx++];
+			}
+
+			return fmt[idx] == '}' ? idx + 1 : 0;
+		}
+
+		constexpr bool is_valid_spec(const FormatSpec &spec, FormatKind kind)
+		{
+			if(spec.precision >= 0 && kind != FormatKind::Float)
+				return false;
+
+			if(spec.type != '\0' && kind != FormatKind::Signed && kind != FormatKind::Unsigned)
+				return false;
+
+			return true;
+		}
+
+		constexpr bool validate_format(const char *fmt, const FormatKind *kinds, size_t num)
+		{
+			size_t arg = 0;
+
+			for(size_t idx = 0; fmt[idx] != '\0'; idx++) {
+				if(fmt[idx] == '}') {
+					if(fmt[idx + 1] != '}')
+						return false;
+
+					idx++;
+					continue;
+				}
+
+				if(fmt[idx] != '{')
+					continue;
+
+				if(fmt[idx + 1] == '{') {
+					idx++;
+					continue;
+				}
+
+				FormatSpec spec{'\0', -1};
+				auto length = parse_format_spec(fmt + idx, spec);
+
+				if(length == 0 || arg >= num || !is_valid_spec(spec, kinds[arg]))
+					return false;
+
+				arg++;
+				idx += length - 1;
+			}
+
+			return arg == num;
+		}
+
+		template <typename... Args>
+		constexpr bool is_valid_format(const char *fmt)
+		{
+			const FormatKind kinds[] = { FormatTraitsOf<Args>::kind..., FormatKind::None };
+			return validate_format(fmt, kinds, sizeof...(Args));
+		}
+
+		extern DLL_EXPORT size_t vformat(char *output, size_t size, const char *fmt,
+				const FormatArg *args, size_t num);
+	}
+
+	/**
+	 * @brief Format a string into \p output.
+	 * @param output Output buffer.
+	 * @param size Size of \p output.
+	 * @param fmt Format string.
+	 * @param args Arguments.
+	 * @return The length of the fully formatted string, which can exceed \p size.
+	 *
+	 * Every `{}' in \p fmt is replaced by the next argument. How an argument is formatted follows
+	 * from its type: integers, floats, characters, booleans, strings and pointers are supported.
+	 * A field can carry a specification: `{:x}', `{:X}', `{:o}' and `{:b}' format an integer in a
+	 * different base and `{:.N}' prints a float with N decimals (the default is 6). Use `{{' and
+	 * `}}' for literal braces. The output is always nul-terminated, unless \p size is 0.
+	 *
+	 * Format strings created using LWIOT_FMT() are checked against the argument types at compile
+	 * time. Other format strings are interpreted leniently: extra fields are printed as-is.
+	 */
+	template <typename... Args>
+	size_t format(char *output, size_t size, const char *fmt, const Args&... args)
+	{
+		const detail::FormatArg values[] = { detail::FormatTraitsOf<Args>::make(args)..., detail::FormatArg() };
+		return detail::vformat(output, size, fmt, values, sizeof...(Args));
+	}
+
+	template <typename Literal, typename... Args,
+			typename = traits::EnableIf_t<traits::IsConvirtable<Literal, detail::FormatLiteral>::value>>
+	size_t format(char *output, size_t size, Literal fmt, const Args&... args)
+	{
+		static_assert(detail::is_valid_format<Args...>(Literal::get()), "Format string does not match its arguments");
+		return format(output, size, Literal::get(), args...);
+	}
+}
+#endif
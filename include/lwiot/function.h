@@ -10,6 +10,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
 
 #include <lwiot/lwiot.h>
 #include <lwiot/log.h>
@@ -17,144 +18,398 @@
 #include <lwiot/sharedpointer.h>
 #include <lwiot/functor.h>
 
+#include <lwiot/stl/move.h>
+#include <lwiot/stl/forward.h>
+
 #include <lwiot/traits/isfunction.h>
 #include <lwiot/traits/enableif.h>
+#include <lwiot/traits/issame.h>
+#include <lwiot/traits/decay.h>
+#include <lwiot/traits/removecv.h>
+#include <lwiot/traits/integralconstant.h>
+
+/*
+ * Callables up to this size are stored inline, larger ones are moved to the heap.
+ */
+#ifndef CONFIG_FUNCTION_BUFFER_SIZE
+#define CONFIG_FUNCTION_BUFFER_SIZE (4 * sizeof(void*))
+#endif
 
 namespace lwiot
 {
-	template<class ReturnType, class...Xs>
-	struct SFConcept {
-		virtual ReturnType operator()(Xs...) const = 0;
-		virtual ReturnType operator()(Xs...) = 0;
-		virtual void copy(void *) const = 0;
+	namespace detail
+	{
+		template <typename T>
+		struct IsCopyable {
+			template <typename U, typename = decltype(U(*static_cast<const U*>(nullptr)))>
+			static traits::TrueType test(int);
 
-		virtual ~SFConcept() = default;
-	};
+			template <typename>
+			static traits::FalseType test(...);
 
-	template<class F, typename ReturnType, typename...Xs>
-	struct SFModel final : SFConcept<ReturnType, Xs...> {
-        typename traits::RemoveCv<F>::type f;
+			typedef decltype(test<T>(0)) type;
+		};
 
-		explicit SFModel(F const &f) : f(f)
-		{
-		}
+		template <typename Func>
+		struct FunctionTarget {
+			typedef typename traits::RemoveCv<typename traits::Decay<Func>::type>::type type;
+		};
 
-		virtual void copy(void *memory) const
-		{
-			new(memory) SFModel<F, ReturnType, Xs...>(f);
-		}
+		enum class FunctionOp {
+			Copy,
+			Move,
+			Destroy
+		};
 
-		virtual ReturnType operator()(Xs...xs) const
-		{
-			return f(xs...);
-		}
+		/*
+		 * Type erasure without a vtable. The invoker is called directly from operator(), and
+		 * everything else (copy, move, destroy) goes through the manager.
+		 */
+		template <typename ReturnType, typename ...Xs>
+		struct FunctionOps {
+			typedef ReturnType (*Invoker)(void *memory, Xs... xs);
+			typedef void (*Manager)(FunctionOp op, void *dst, size_t size, void *src, FunctionOps *ops);
 
-		virtual ReturnType operator()(Xs...xs)
-		{
-			return f(xs...);
-		}
+			Invoker invoke;
+			Manager manage;
+		};
 
-		virtual ~SFModel() = default;
-	};
+		/*
+		 * Callables that fit the buffer of the wrapper are stored inline, others on the heap
+		 * with a pointer to them in the buffer. Each storage mode has its own invoker, so the
+		 * call itself never branches. Calls to stateless lambdas are inlined into the invoker.
+		 */
+		template <typename F, typename ReturnType, typename ...Xs>
+		struct FunctionModel {
+			typedef FunctionOps<ReturnType, Xs...> Ops;
+			typedef typename IsCopyable<F>::type Copyable;
+
+			static constexpr bool fits(size_t size)
+			{
+				return sizeof(F) <= size && alignof(F) <= alignof(max_align_t);
+			}
+
+			template <typename... Args>
+			static void create(void *memory, size_t size, Ops *ops, Args&&... args)
+			{
+				if(fits(size)) {
+					new(memory) F(stl::forward<Args>(args)...);
+					ops->invoke = &FunctionModel::invokeInline;
+					ops->manage = &FunctionModel::manageInline;
+				} else {
+					*static_cast<F**>(memory) = new F(stl::forward<Args>(args)...);
+					ops->invoke = &FunctionModel::invokeHeap;
+					ops->manage = &FunctionModel::manageHeap;
+				}
+			}
+
+			static ReturnType invokeInline(void *memory, Xs... xs)
+			{
+				return (*static_cast<F*>(memory))(stl::forward<Xs>(xs)...);
+			}
+
+			static ReturnType invokeHeap(void *memory, Xs... xs)
+			{
+				return (**static_cast<F**>(memory))(stl::forward<Xs>(xs)...);
+			}
+
+			static void manageInline(FunctionOp op, void *dst, size_t size, void *src, Ops *ops)
+			{
+				auto f = static_cast<F*>(src);
+
+				switch(op) {
+				case FunctionOp::Copy:
+					copy(dst, size, *f, ops, Copyable());
+					break;
+
+				case FunctionOp::Move:
+					create(dst, size, ops, stl::move(*f));
+					f->~F();
+					break;
+
+				case FunctionOp::Destroy:
+					f->~F();
+					break;
+				}
+			}
+
+			static void manageHeap(FunctionOp op, void *dst, size_t size, void *src, Ops *ops)
+			{
+				auto f = *static_cast<F**>(src);
+
+				switch(op) {
+				case FunctionOp::Copy:
+					copy(dst, size, *f, ops, Copyable());
+					break;
+
+				case FunctionOp::Move:
+					*static_cast<F**>(dst) = f;
+					ops->invoke = &FunctionModel::invokeHeap;
+					ops->manage = &FunctionModel::manageHeap;
+					break;
+
+				case FunctionOp::Destroy:
+					delete f;
+					break;
+				}
+			}
+
+			static void copy(void *dst, size_t size, const F& f, Ops *ops, traits::TrueType)
+			{
+				create(dst, size, ops, f);
+			}
+
+			static void copy(void *dst, size_t size, const F& f, Ops *ops, traits::FalseType)
+			{
+				/* Move-only callables only live in a UniqueFunction, which is never copied. */
+				ops->invoke = nullptr;
+				ops->manage = nullptr;
+			}
+		};
+
+		template<typename Func, size_t size>
+		class FunctionBase;
+
+		/*
+		 * Storage shared by Function and UniqueFunction.
+		 */
+		template<typename ReturnType, typename ...Xs, size_t size>
+		class FunctionBase<ReturnType(Xs...), size> {
+			static_assert(size >= sizeof(void*), "Function buffer too small!");
+
+		public:
+			template<class...Ys>
+			ReturnType operator()(Ys &&...ys) const
+			{
+				return this->_ops.invoke(this->memory(), stl::forward<Ys>(ys)...);
+			}
+
+			bool valid() const
+			{
+				return this->_ops.invoke != nullptr;
+			}
+
+			explicit operator bool() const
+			{
+				return this->valid();
+			}
+
+			void clean()
+			{
+				if(this->_ops.manage == nullptr)
+					return;
+
+				this->_ops.manage(FunctionOp::Destroy, nullptr, 0, this->memory(), nullptr);
+				this->_ops.invoke = nullptr;
+				this->_ops.manage = nullptr;
+			}
+
+		protected:
+			FunctionBase() : _ops()
+			{
+			}
 
+			~FunctionBase()
+			{
+				this->clean();
+			}
+
+			template <typename Func>
+			void assign(Func&& f)
+			{
+				typedef FunctionModel<typename FunctionTarget<Func>::type, ReturnType, Xs...> Model;
+
+				this->clean();
+				Model::create(this->_memory, size, &this->_ops, stl::forward<Func>(f));
+			}
+
+			template <size_t s>
+			void copy(const FunctionBase<ReturnType(Xs...), s>& other)
+			{
+				this->clean();
+
+				if(other._ops.manage)
+					other._ops.manage(FunctionOp::Copy, this->_memory, size, other.memory(), &this->_ops);
+			}
 
-	template<typename Func, size_t size = 128>
-	class Function ;
+			void move(FunctionBase& other)
+			{
+				this->clean();
+
+				if(other._ops.manage == nullptr)
+					return;
+
+				other._ops.manage(FunctionOp::Move, this->_memory, size, other.memory(), &this->_ops);
+				other._ops.invoke = nullptr;
+				other._ops.manage = nullptr;
+			}
+
+		private:
+			alignas(max_align_t) char _memory[size];
+			FunctionOps<ReturnType, Xs...> _ops;
+
+			template <typename, size_t>
+			friend class FunctionBase;
+
+			void *memory() const
+			{
+				return const_cast<char*>(this->_memory);
+			}
+		};
+	}
+
+	/**
+	 * @brief Copyable wrapper for callables.
+	 * @tparam size Inline buffer size. Larger callables are stored on the heap.
+	 * @see UniqueFunction
+	 * @see FunctionRef
+	 */
+	template<typename Func, size_t size = CONFIG_FUNCTION_BUFFER_SIZE>
+	class Function;
 
 	template<typename ReturnType, typename ...Xs, size_t size>
-	class Function<ReturnType(Xs...), size> {
+	class Function<ReturnType(Xs...), size> : public detail::FunctionBase<ReturnType(Xs...), size> {
+		typedef detail::FunctionBase<ReturnType(Xs...), size> Base;
+
 	public:
-		Function() : memory(), allocated(false)
+		Function() : Base()
 		{
 		}
 
 		template <typename Func>
-		Function(const Func &f) : memory(),  allocated(sizeof(SFModel<Func, ReturnType, Xs...>) != 0)
+		Function(const Func &f) : Base()
 		{
-			static_assert(sizeof(SFModel<Func, ReturnType, Xs...>) <= size, "Expression too big!");
-			new(memory) SFModel<Func, ReturnType, Xs...>(f);
+			this->assign(f);
 		}
 
-		template<unsigned s, traits::EnableIf_t<(s <= size), bool> = false>
-		Function(Function<ReturnType(Xs...), s> const &sf) : memory(), allocated(sf.allocated)
+		Function(const Function& other) : Base()
 		{
-			sf.copy(memory);
+			this->copy(other);
 		}
 
+		Function(Function&& other) noexcept : Base()
+		{
+			this->move(other);
+		}
 
-		template<unsigned s, traits::EnableIf_t<(s <= size), bool> = false>
-		Function &operator=(Function<ReturnType(Xs...), s> const &sf)
+		template<size_t s, traits::EnableIf_t<(s != size), bool> = false>
+		Function(Function<ReturnType(Xs...), s> const &sf) : Base()
 		{
-			clean();
-			allocated = sf.allocated;
-			sf.copy(memory);
+			this->copy(sf);
+		}
+
+		Function &operator=(const Function& other)
+		{
+			if(this != &other)
+				this->copy(other);
+
 			return *this;
 		}
 
-		void clean()
+		Function &operator=(Function&& other) noexcept
 		{
-			if(allocated) {
-				auto c = this->as_concept();
-				c->~concept();
-				allocated = false;
-			}
+			if(this != &other)
+				this->move(other);
+
+			return *this;
 		}
 
-		virtual ~Function()
+		template<size_t s, traits::EnableIf_t<(s != size), bool> = false>
+		Function &operator=(Function<ReturnType(Xs...), s> const &sf)
 		{
-			if(allocated) {
-				auto c = this->as_concept();
-				c->~concept();
-			}
+			this->copy(sf);
+			return *this;
 		}
 
-		template <typename Func>
+		template <typename Func, traits::EnableIf_t<!traits::IsSame<typename traits::Decay<Func>::type, Function>::value, bool> = false>
 		Function& operator=(Func& f)
 		{
-			this->allocated = sizeof(SFModel<Func, ReturnType, Xs...>) != 0;
-			new(memory) SFModel<Func, ReturnType, Xs...>(f);
+			this->assign(f);
 			return *this;
 		}
+	};
+
+	/**
+	 * @brief Move-only wrapper for callables.
+	 *
+	 * Unlike Function, the wrapped callable does not have to be copyable.
+	 */
+	template<typename Func, size_t size = CONFIG_FUNCTION_BUFFER_SIZE>
+	class UniqueFunction;
 
-		template<class...Ys>
-		ReturnType operator()(Ys &&...ys)
+	template<typename ReturnType, typename ...Xs, size_t size>
+	class UniqueFunction<ReturnType(Xs...), size> : public detail::FunctionBase<ReturnType(Xs...), size> {
+		typedef detail::FunctionBase<ReturnType(Xs...), size> Base;
+
+	public:
+		UniqueFunction() : Base()
 		{
-			auto c = this->as_concept();
-			return (*c)(stl::forward<Ys>(ys)...);
 		}
 
-		template<class...Ys>
-		ReturnType operator()(Ys &&...ys) const
+		template <typename Func, traits::EnableIf_t<!traits::IsSame<typename detail::FunctionTarget<Func>::type, UniqueFunction>::value, bool> = false>
+		UniqueFunction(Func&& f) : Base()
 		{
-			auto c = this->as_concept();
-			return (*c)(stl::forward<Ys>(ys)...);
+			this->assign(stl::forward<Func>(f));
 		}
 
-		bool valid() const
+		UniqueFunction(UniqueFunction&& other) noexcept : Base()
 		{
-			return this->allocated;
+			this->move(other);
 		}
 
-		explicit operator bool() const
+		UniqueFunction(const UniqueFunction&) = delete;
+		UniqueFunction& operator=(const UniqueFunction&) = delete;
+
+		UniqueFunction& operator=(UniqueFunction&& other) noexcept
 		{
-			return this->valid();
+			if(this != &other)
+				this->move(other);
+
+			return *this;
 		}
 
-		void copy(void *data) const
+		template <typename Func, traits::EnableIf_t<!traits::IsSame<typename detail::FunctionTarget<Func>::type, UniqueFunction>::value, bool> = false>
+		UniqueFunction& operator=(Func&& f)
 		{
-			if(allocated) {
-				((concept *) memory)->copy(data);
-			}
+			this->assign(stl::forward<Func>(f));
+			return *this;
+		}
+	};
+
+	/**
+	 * @brief Non-owning reference to a callable.
+	 *
+	 * Two pointers in size and never allocates. The referenced callable must outlive the
+	 * FunctionRef, which makes it suitable for callbacks that are only invoked during a call.
+	 */
+	template <typename Func>
+	class FunctionRef;
+
+	template <typename ReturnType, typename ...Xs>
+	class FunctionRef<ReturnType(Xs...)> {
+	public:
+		template <typename Func, traits::EnableIf_t<!traits::IsSame<typename detail::FunctionTarget<Func>::type, FunctionRef>::value, bool> = false>
+		FunctionRef(Func&& f) : _object((void*) &f),
+			_invoke(&FunctionRef::invoke<typename traits::RemoveReference<Func>::type>)
+		{
+		}
+
+		FunctionRef(const FunctionRef&) = default;
+		FunctionRef& operator=(const FunctionRef&) = default;
+
+		ReturnType operator()(Xs... xs) const
+		{
+			return this->_invoke(this->_object, stl::forward<Xs>(xs)...);
 		}
 
 	private:
-		char memory[size];
-		bool allocated;
-		using concept = SFConcept<ReturnType, Xs...>;
+		void *_object;
+		ReturnType (*_invoke)(void *object, Xs... xs);
 
-		constexpr concept* as_concept() const
+		template <typename F>
+		static ReturnType invoke(void *object, Xs... xs)
 		{
-			return (concept*) &memory[0];
+			return (*reinterpret_cast<F*>(object))(stl::forward<Xs>(xs)...);
 		}
 	};
 }
@@ -9,23 +9,15 @@
 
 #include <lwiot/types.h>
 #include <lwiot/printer.h>
-
-typedef struct { // Data stored PER GLYPH
-	uint16_t bitmapOffset;     // Pointer into GFXfont->bitmap
-	uint8_t  width, height;    // Bitmap dimensions in pixels
-	uint8_t  xAdvance;         // Distance to advance cursor (x axis)
-	int8_t   xOffset, yOffset; // Dist from cursor pos to UL corner
-} GFXglyph;
-
-typedef struct { // Data stored for FONT AS A WHOLE:
-	uint8_t  *bitmap;      // Glyph bitmaps, concatenated
-	GFXglyph *glyph;       // Glyph array
-	uint8_t   first, last; // ASCII extents
-	uint8_t   yAdvance;    // Newline distance (y axis)
-} GFXfont;
+#include <lwiot/gfxfont.h>
+#include <lwiot/glyphcache.h>
 
 namespace lwiot
 {
+	class GfxCanvas1;
+	class GfxCanvas8;
+	class GfxCanvas16;
+
 	class GfxBase : public Printer {
 	public:
 		explicit GfxBase(int16_t w, int16_t h);
@@ -59,10 +51,32 @@ namespace lwiot
 		void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
 		void drawRoundRect(int16_t x0, int16_t y0, int16_t w, int16_t h, int16_t radius, uint16_t color);
 		void fillRoundRect(int16_t x0, int16_t y0, int16_t w, int16_t h, int16_t radius, uint16_t color);
-		void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color);
-		void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color, uint16_t bg);
-		void drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color);
-		void drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg);
+		virtual void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color);
+		virtual void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color, uint16_t bg);
+		virtual void drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color);
+		virtual void drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg);
+
+		/**
+		 * @brief Draw a 1bpp bitmap in page format.
+		 *
+		 * \p columns holds (h + 7) / 8 bands of \p w bytes; each byte is a column of eight pixels,
+		 * least significant bit on top. This is the format of the classic font and of cached glyphs,
+		 * and the native format of monochrome displays, which can override this to copy whole bytes.
+		 *
+		 * @param opaque Draw the pixels that are not set in \p bg.
+		 */
+		virtual void drawColumnBitmap(int16_t x, int16_t y, const uint8_t* columns, int16_t w, int16_t h,
+		                              uint16_t color, uint16_t bg, bool opaque);
+
+		/**
+		 * @brief Draw the contents of \p canvas at (\p x, \p y).
+		 *
+		 * Set pixels of a monochrome canvas are drawn in \p color, the others in \p bg. The rotation
+		 * of the canvas does not matter; its buffer is copied as is.
+		 */
+		void blit(const GfxCanvas1& canvas, int16_t x, int16_t y, uint16_t color = 1, uint16_t bg = 0);
+		void blit(const GfxCanvas8& canvas, int16_t x, int16_t y);
+		void blit(const GfxCanvas16& canvas, int16_t x, int16_t y);
 		void drawXBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color);
 		void drawGrayscaleBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h);
 		void drawGrayscaleBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h);
@@ -80,6 +94,16 @@ namespace lwiot
 		void setTextWrap(bool w);
 		void cp437(bool x=true);
 		void setFont(const GFXfont *f = nullptr);
+
+		/**
+		 * @brief Use a font image, such as a MappedRegion, in place.
+		 *
+		 * The image is a GFXfontImage header, followed by the GFXglyph array and the glyph bitmaps,
+		 * in the memory layout of the target. It must stay valid while the font is in use.
+		 *
+		 * @return False if the image is malformed.
+		 */
+		bool setFont(const uint8_t *image, size_t size);
 		void getTextBounds(char *string, int16_t x, int16_t y, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h);
 
 		virtual size_t write(uint8_t byte);
@@ -97,6 +121,8 @@ namespace lwiot
 		uint8_t textsize, rotation;
 		bool wrap, _cp437;
 		GFXfont *gfxFont;
+		GFXfont imageFont;
+		GlyphCache glyphs;
 
 		void charBounds(char c, int16_t *x, int16_t *y, int16_t *minx, int16_t *miny, int16_t *maxx, int16_t *maxy);
 	};
@@ -0,0 +1,89 @@
+/*
+ * Off-screen canvasses.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/gfxbase.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Display that draws into a buffer in memory.
+	 *
+	 * Screens are drawn on a canvas and then shown at once with GfxBase::blit(). Canvasses have no
+	 * locking; a canvas is drawn on by one thread at a time.
+	 */
+	class GfxCanvas : public GfxBase {
+	public:
+		GfxCanvas(const GfxCanvas&) = delete;
+		~GfxCanvas() override;
+
+		GfxCanvas& operator=(const GfxCanvas&) = delete;
+
+		/**
+		 * @brief Canvas memory; nullptr if it could not be allocated.
+		 */
+		void* buffer() const;
+
+	protected:
+		explicit GfxCanvas(int16_t w, int16_t h, size_t size);
+
+		/**
+		 * @brief Rotate \p x and \p y into buffer coordinates.
+		 * @return False if the pixel is outside the canvas.
+		 */
+		bool map(int16_t& x, int16_t& y) const;
+
+		void* _buffer;
+		size_t _size;
+	};
+
+	/**
+	 * @brief Monochrome canvas in page format: a byte per column of eight pixels, least significant
+	 *        bit on top. Non-zero colors set pixels.
+	 */
+	class GfxCanvas1 : public GfxCanvas {
+	public:
+		explicit GfxCanvas1(int16_t w, int16_t h);
+
+		void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+		void fillScreen(uint16_t color) override;
+
+		bool getPixel(int16_t x, int16_t y) const;
+	};
+
+	/**
+	 * @brief Canvas of 8 bit pixels, row by row.
+	 */
+	class GfxCanvas8 : public GfxCanvas {
+	public:
+		explicit GfxCanvas8(int16_t w, int16_t h);
+
+		void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+		void fillScreen(uint16_t color) override;
+
+		uint8_t getPixel(int16_t x, int16_t y) const;
+	};
+
+	/**
+	 * @brief Canvas of 16 bit (RGB565) pixels, row by row.
+	 */
+	class GfxCanvas16 : public GfxCanvas {
+	public:
+		explicit GfxCanvas16(int16_t w, int16_t h);
+
+		void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+		void fillScreen(uint16_t color) override;
+
+		uint16_t getPixel(int16_t x, int16_t y) const;
+	};
+}
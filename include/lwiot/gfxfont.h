@@ -0,0 +1,31 @@
+/*
+ * Adafruit GFX font format.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef struct { // Data stored PER GLYPH
+	uint16_t bitmapOffset;     // Pointer into GFXfont->bitmap
+	uint8_t  width, height;    // Bitmap dimensions in pixels
+	uint8_t  xAdvance;         // Distance to advance cursor (x axis)
+	int8_t   xOffset, yOffset; // Dist from cursor pos to UL corner
+} GFXglyph;
+
+typedef struct { // Data stored for FONT AS A WHOLE:
+	uint8_t  *bitmap;      // Glyph bitmaps, concatenated
+	GFXglyph *glyph;       // Glyph array
+	uint8_t   first, last; // ASCII extents
+	uint8_t   yAdvance;    // Newline distance (y axis)
+} GFXfont;
+
+typedef struct { // Header of a font image, which is followed by the
+	char     magic[4];     // "GFXF"          glyph array and the bitmaps
+	uint8_t  first, last;  // ASCII extents
+	uint8_t  yAdvance;     // Newline distance (y axis)
+	uint8_t  reserved;
+} GFXfontImage;
@@ -0,0 +1,65 @@
+/*
+ * Cache of rasterized font glyphs.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/gfxfont.h>
+
+#ifndef CONFIG_GFX_GLYPH_CACHE
+#define CONFIG_GFX_GLYPH_CACHE 32
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Cache of GFXfont glyphs in page format.
+	 *
+	 * A glyph is rasterized the first time it is drawn, into (height + 7) / 8 bands of one byte
+	 * per column with the least significant bit on top; the format of the classic font and of
+	 * monochrome displays such as the SSD1306. Up to CONFIG_GFX_GLYPH_CACHE glyphs are kept; the
+	 * least recently used glyph makes room for a new one.
+	 *
+	 * @see GfxBase::drawColumnBitmap
+	 */
+	class GlyphCache {
+	public:
+		struct Glyph {
+			const GFXfont* font;
+			uint8_t c;
+			uint8_t width;
+			uint8_t height;
+			int8_t xOffset;
+			int8_t yOffset;
+			uint8_t* columns;
+			uint32_t used;
+		};
+
+		explicit GlyphCache();
+		GlyphCache(const GlyphCache&) = delete;
+		~GlyphCache();
+
+		GlyphCache& operator=(const GlyphCache&) = delete;
+
+		/**
+		 * @brief Find glyph \p c of \p font, rasterizing it if it isn't cached.
+		 * @return nullptr if the glyph has no bitmap, or memory ran out.
+		 */
+		const Glyph* lookup(const GFXfont* font, uint8_t c);
+		void clear();
+
+	private:
+		Glyph _glyphs[CONFIG_GFX_GLYPH_CACHE];
+		uint32_t _clock;
+
+		static bool rasterize(Glyph& glyph, const GFXfont* font, uint8_t c);
+	};
+}
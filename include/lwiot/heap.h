@@ -0,0 +1,68 @@
+/*
+ * Heap hooks and memory accounting.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+/*
+ * Subsystem tags. Every tagged allocation is accounted to exactly one tag.
+ */
+typedef enum {
+	LWIOT_HEAP_TAG_DEFAULT = 0,
+	LWIOT_HEAP_TAG_NET,
+	LWIOT_HEAP_TAG_HTTP,
+	LWIOT_HEAP_TAG_MQTT,
+	LWIOT_HEAP_TAG_GFX,
+	LWIOT_HEAP_TAG_STL,
+	LWIOT_HEAP_TAG_MAX
+} lwiot_heap_tag_t;
+
+/* Regions a backend can be registered for. */
+typedef enum {
+	LWIOT_HEAP_REGION_DEFAULT = 0,
+	LWIOT_HEAP_REGION_EXTERNAL, /* External RAM, for example PSRAM. */
+	LWIOT_HEAP_REGION_MAX
+} lwiot_heap_region_t;
+
+#define LWIOT_HEAP_TAG_MASK 0xFFU
+/* Allocation flag: prefer external RAM. Falls back to the default region when there is none. */
+#define LWIOT_HEAP_EXTERNAL 0x100U
+
+struct lwiot_heap_backend {
+	void *(*alloc)(void *ctx, size_t size);
+	void *(*realloc)(void *ctx, void *ptr, size_t size); /* Optional. */
+	void (*free)(void *ctx, void *ptr);
+	void *ctx;
+};
+
+struct lwiot_heap_stats {
+	size_t current;      /* Bytes in use. */
+	size_t peak;         /* Largest number of bytes that was in use at the same time. */
+	size_t allocations;  /* Live allocations. */
+	size_t failures;     /* Allocations the backend could not satisfy. */
+};
+
+CDECL
+/*
+ * Register a backend for a region. The default region uses lwiot_mem_alloc() until another backend
+ * is registered. Backends must be registered before the first allocation from their region.
+ */
+extern DLL_EXPORT int lwiot_heap_register(lwiot_heap_region_t region, const struct lwiot_heap_backend *backend);
+
+/* Flags are a lwiot_heap_tag_t, optionally or'ed with LWIOT_HEAP_EXTERNAL. */
+extern DLL_EXPORT void *lwiot_heap_alloc(size_t size, uint32_t flags);
+extern DLL_EXPORT void *lwiot_heap_zalloc(size_t size, uint32_t flags);
+/* Keeps the tag and region of the original allocation. */
+extern DLL_EXPORT void *lwiot_heap_realloc(void *ptr, size_t size);
+extern DLL_EXPORT void lwiot_heap_free(void *ptr);
+
+extern DLL_EXPORT int lwiot_heap_statistics(lwiot_heap_tag_t tag, struct lwiot_heap_stats *stats);
+extern DLL_EXPORT void lwiot_heap_reset_peak(lwiot_heap_tag_t tag);
+CDECL_END
@@ -9,9 +9,12 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 
 namespace lwiot
 {
+	class AdcSampler;
+
 	class AdcChip {
 	public:
 		virtual void begin() = 0;
@@ -23,6 +26,18 @@ namespace lwiot
 
 		size_t operator [](int pin) const;
 
+		/**
+		 * @brief Start converting \p pins continuously, \p rate times per second.
+		 *
+		 * Chips with a DMA or timer triggered conversion mode override this and hand every
+		 * conversion, in the order of \p pins, to AdcSampler::push().
+		 *
+		 * @return False if the chip has no continuous mode. The sampler then calls read() itself.
+		 * @see AdcSampler
+		 */
+		virtual bool startContinuous(const int *pins, size_t num, uint32_t rate, AdcSampler& sampler);
+		virtual void stopContinuous();
+
 	protected:
 		explicit AdcChip(int pins, int ref, int width);
 
@@ -0,0 +1,101 @@
+/*
+ * Continuous ADC sampler.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/io/adcchip.h>
+#include <lwiot/stl/vector.h>
+
+#include <lwiot/kernel/thread.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/event.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Sample a set of ADC pins at a fixed rate and deliver the samples in blocks.
+	 *
+	 * Samples are stored in a caller supplied ring buffer, one frame (a sample of every pin, in
+	 * the order of the pins) after the other. Whenever a block is complete the block handler is
+	 * called from the sampler thread with a pointer into the ring buffer; the block may be used
+	 * until the handler returns.
+	 *
+	 * When the ADC has a continuous mode (see AdcChip::startContinuous()) the conversions are
+	 * timed by the hardware and pushed from its interrupt or DMA handler. Otherwise the sampler
+	 * thread paces the conversions on the delay counter and calls AdcChip::read(), which also
+	 * runs the block handler between two frames.
+	 *
+	 * If the handler does not keep up, the blocks that do not fit in the ring buffer are dropped.
+	 * Frames that the sampler thread could not take in time are skipped. Both count as overruns.
+	 */
+	class AdcSampler : public Thread {
+	public:
+		typedef Function<void(const uint16_t *samples, size_t length)> BlockHandler;
+
+		explicit AdcSampler(AdcChip& chip);
+		~AdcSampler() override;
+
+		AdcSampler(const AdcSampler&) = delete;
+		AdcSampler& operator=(const AdcSampler&) = delete;
+
+		/**
+		 * @brief Start sampling.
+		 * @param pins ADC pins to sample.
+		 * @param rate Frames per second.
+		 * @param buffer Ring buffer of \p length samples.
+		 * @param length Ring buffer length, a multiple of \p block.
+		 * @param block Number of samples per block, a multiple of the number of pins.
+		 * @param handler Block handler.
+		 * @return False when the arguments are invalid or the sampler is already running.
+		 */
+		bool begin(const stl::Vector<int>& pins, uint32_t rate, uint16_t *buffer, size_t length,
+				   size_t block, const BlockHandler& handler);
+		void end();
+
+		/**
+		 * @brief Store a conversion. Safe to call from interrupt context.
+		 */
+		void push(uint16_t sample);
+
+		size_t overruns() const;
+		uint32_t rate() const;
+		const stl::Vector<int>& pins() const;
+
+	protected:
+		void run() override;
+
+	private:
+		AdcChip& _chip;
+		mutable Lock _lock;
+		Event _ready;
+
+		stl::Vector<int> _pins;
+		uint32_t _rate;
+		BlockHandler _handler;
+
+		uint16_t *_buffer;
+		size_t _length;
+		size_t _block;
+
+		volatile size_t _head;
+		volatile size_t _tail;
+		volatile size_t _skip;
+		volatile size_t _overruns;
+
+		volatile bool _running;
+		bool _hardware;
+
+		void sample();
+		void dispatch();
+	};
+}
@@ -0,0 +1,76 @@
+/*
+ * Asynchronous I2C bus engine.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <lwiot/lwiot.h>
+#include <lwiot/types.h>
+#include <lwiot/io/i2cbus.h>
+#include <lwiot/io/i2ctransaction.h>
+
+#include <lwiot/kernel/thread.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/event.h>
+
+#include <lwiot/stl/linkedlist.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Executes queued I2C transactions on a bus thread.
+	 *
+	 * Callers submit() transactions and continue; the bus thread transfers them in the order in
+	 * which they were submitted, holding the lock of the bus only for the transfer itself. Blocking
+	 * transfers through other copies of the bus are serialized with the queue by that lock.
+	 *
+	 * A transfer that fails with -ETRYAGAIN is not retried on the spot. It is set aside for the
+	 * retry delay of the I2C algorithm, and the bus thread sleeps until it may be retried unless
+	 * other work arrives. Meanwhile, transactions to other devices continue; transactions to the same
+	 * device wait, so that every device sees its transactions in order. A transaction fails
+	 * after MAX_RETRIES attempts.
+	 */
+	class AsyncI2CBus : public Thread {
+	public:
+		explicit AsyncI2CBus(const I2CBus& bus);
+		~AsyncI2CBus() override;
+
+		AsyncI2CBus(const AsyncI2CBus&) = delete;
+		AsyncI2CBus& operator=(const AsyncI2CBus&) = delete;
+
+		void begin();
+
+		/**
+		 * @brief Stop the bus thread. Transactions that are still queued fail.
+		 */
+		void end();
+
+		/**
+		 * @brief Queue \p transaction.
+		 * @return False if \p transaction is empty or already queued, or the bus is not running.
+		 */
+		bool submit(I2CTransaction& transaction);
+
+		/**
+		 * @brief Number of queued transactions, including the one in transfer.
+		 */
+		size_t pending() const;
+
+	protected:
+		void run() override;
+
+	private:
+		I2CBus _bus;
+		mutable Lock _lock;
+		Event _work;
+		stl::LinkedList<I2CTransaction*> _queue;
+		bool _running;
+
+		I2CTransaction* next(time_t now, time_t& due);
+		void remove(I2CTransaction* transaction);
+		void complete(I2CTransaction* transaction, bool ok);
+	};
+}
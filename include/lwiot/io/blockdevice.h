@@ -0,0 +1,98 @@
+/*
+ * Byte addressable block device.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/kernel/lock.h>
+
+#ifndef CONFIG_BLOCK_DEVICE_CACHE
+#define CONFIG_BLOCK_DEVICE_CACHE 32
+#endif
+
+#ifndef CONFIG_BLOCK_DEVICE_READAHEAD
+#define CONFIG_BLOCK_DEVICE_READAHEAD 32
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief External memory that is accessed in bursts.
+	 *
+	 * Chips implement burst transfers; the block device splits writes at page boundaries, writes
+	 * runs of whole cache units in a single burst and coalesces smaller writes in a write cache of
+	 * one unit. A unit is a page, or CONFIG_BLOCK_DEVICE_CACHE bytes if pages are larger. Cached
+	 * data is written when the unit is complete, when a write to another part of the chip
+	 * arrives, or on flush(). Reads that are shorter than CONFIG_BLOCK_DEVICE_READAHEAD bytes
+	 * fetch that many bytes, so that subsequent reads are served from memory. Reads always
+	 * return the data that was written, including data that is still cached.
+	 *
+	 * The page size and CONFIG_BLOCK_DEVICE_CACHE must be powers of two.
+	 */
+	class BlockDevice {
+	public:
+		explicit BlockDevice(size_t size, size_t page);
+		virtual ~BlockDevice() = default;
+
+		BlockDevice(const BlockDevice&) = delete;
+		BlockDevice& operator=(const BlockDevice&) = delete;
+
+		size_t size() const;
+		size_t pageSize() const;
+
+		/**
+		 * @brief Read \p length bytes from \p addr.
+		 * @return Number of bytes read, or a negative error code.
+		 */
+		ssize_t read(size_t addr, void *data, size_t length);
+
+		/**
+		 * @brief Write \p length bytes to \p addr.
+		 * @return Number of bytes written, or a negative error code.
+		 * @note Data may be cached until flush() is called.
+		 */
+		ssize_t write(size_t addr, const void *data, size_t length);
+
+		/**
+		 * @brief Write cached data to the chip.
+		 */
+		bool flush();
+
+	protected:
+		/**
+		 * @brief Read \p length bytes from \p addr in a single burst.
+		 */
+		virtual bool readBurst(size_t addr, void *data, size_t length) = 0;
+
+		/**
+		 * @brief Write \p length bytes to \p addr in a single burst, which never crosses a page.
+		 */
+		virtual bool writeBurst(size_t addr, const void *data, size_t length) = 0;
+
+	private:
+		mutable Lock _lock;
+		size_t _size;
+		size_t _page;
+		size_t _unit;
+
+		uint8_t _cache[CONFIG_BLOCK_DEVICE_CACHE];
+		size_t _start;
+		size_t _end;
+
+		uint8_t _ahead[CONFIG_BLOCK_DEVICE_READAHEAD];
+		size_t _ahead_addr;
+		size_t _ahead_length;
+
+		bool cache(size_t addr, const uint8_t *data, size_t length);
+		bool writeback();
+		void update(size_t addr, const uint8_t *data, size_t length);
+	};
+}
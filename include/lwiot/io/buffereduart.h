@@ -0,0 +1,135 @@
+/*
+ * Interrupt driven, buffered UART.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/uart.h>
+#include <lwiot/ringbufferstream.h>
+
+#include <lwiot/kernel/event.h>
+#include <lwiot/kernel/atomic.h>
+
+#ifndef CONFIG_UART_RX_BUFFER
+#define CONFIG_UART_RX_BUFFER 256
+#endif
+
+#ifndef CONFIG_UART_TX_BUFFER
+#define CONFIG_UART_TX_BUFFER 256
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief UART that moves data between ring buffers and the hardware from interrupt context.
+	 *
+	 * Received bytes are stored by the RX interrupt (or DMA completion) handler of the port, so no
+	 * data is lost while the reading thread is descheduled, as long as the RX ring does not
+	 * overflow. write() copies into the TX ring and returns immediately; the port drains the ring
+	 * from its TX FIFO-empty interrupt or DMA handler. Reads block on an event, for at most the
+	 * stream timeout.
+	 *
+	 * Ports implement startTransmit() and call received(), idle() and transmit() from their
+	 * interrupt handlers. The RX and TX rings are single producer, single consumer: one thread
+	 * may read and one thread may write at a time.
+	 */
+	class BufferedUart : public Uart {
+	public:
+		explicit BufferedUart(int tx, int rx, long baud = 9600, uint32_t config = SERIAL_8N1,
+							  size_t rxsize = CONFIG_UART_RX_BUFFER, size_t txsize = CONFIG_UART_TX_BUFFER);
+		explicit BufferedUart(const GpioPin& tx, const GpioPin& rx, long baud = 9600, uint32_t config = SERIAL_8N1,
+							  size_t rxsize = CONFIG_UART_RX_BUFFER, size_t txsize = CONFIG_UART_TX_BUFFER);
+		~BufferedUart() override = default;
+
+		using Uart::write;
+		using Uart::read;
+
+		size_t available() const override;
+
+		uint8_t read() override;
+		ssize_t read(void *output, const size_t& length) override;
+
+		/**
+		 * @brief Read \p length bytes.
+		 * @param output Output buffer.
+		 * @param length Number of bytes to read.
+		 * @param tmo Timeout in milliseconds.
+		 * @return The number of bytes read, or -ETMO if nothing was received in time.
+		 */
+		ssize_t read(void *output, size_t length, int tmo);
+
+		/**
+		 * @brief Read the bytes received up to the next idle line.
+		 *
+		 * Frames that are longer than \p length are returned in pieces by consecutive calls.
+		 *
+		 * @return The number of bytes read, or -ETMO if no frame was completed in time.
+		 */
+		ssize_t readFrame(void *output, size_t length, int tmo);
+
+		bool write(uint8_t byte) override;
+
+		/**
+		 * @brief Queue \p length bytes for transmission.
+		 *
+		 * Only blocks while the TX ring is full, for at most the stream timeout.
+		 *
+		 * @return The number of bytes queued.
+		 */
+		ssize_t write(const void *bytes, const size_t& length) override;
+
+		/**
+		 * @brief Wait until the TX ring has been drained.
+		 */
+		bool flush(int tmo = FOREVER);
+
+		size_t overruns() const; //!< Number of received bytes that did not fit in the RX ring.
+
+	protected:
+		/**
+		 * @brief Enable the TX interrupt or start a DMA transfer, which pulls data using transmit().
+		 */
+		virtual void startTransmit() = 0;
+
+		/**
+		 * @brief Store received bytes. Safe to call from interrupt context.
+		 * @return The number of bytes stored.
+		 */
+		size_t received(const uint8_t *data, size_t length);
+
+		/**
+		 * @brief Mark the end of a frame, when the RX line went idle. Safe to call from interrupt context.
+		 */
+		void idle();
+
+		/**
+		 * @brief Take up to \p length bytes to transmit. Safe to call from interrupt context.
+		 * @return The number of bytes to transmit. When 0 is returned, the transmission is done and
+		 *         the port should disable its TX interrupt until the next startTransmit().
+		 */
+		size_t transmit(uint8_t *data, size_t length);
+
+	private:
+		RingBufferStream _rx;
+		RingBufferStream _tx;
+
+		Event _rx_event;
+		Event _tx_event;
+
+		Atomic<size_t> _received;
+		Atomic<size_t> _consumed;
+		Atomic<size_t> _frame;
+		Atomic<size_t> _overruns;
+		Atomic<bool> _transmitting;
+
+		ssize_t take(void *output, size_t length);
+	};
+}
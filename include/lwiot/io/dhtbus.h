@@ -9,6 +9,7 @@
 
 #include <lwiot/lwiot.h>
 #include <lwiot/io/gpiopin.h>
+#include <lwiot/io/edgecapture.h>
 #include <lwiot/log.h>
 #include <lwiot/stl/vector.h>
 #include <lwiot/kernel/lock.h>
@@ -20,19 +21,45 @@ namespace lwiot
 		float temperature;
 	};
 
+	/**
+	 * @brief DHT single wire bus.
+	 *
+	 * The readout is decoded by polling the line with interrupts disabled, for about 5 ms, unless
+	 * an EdgeCapture is given. The line is then released and the edges are recorded while the
+	 * calling thread sleeps; the bits are decoded from the recorded timings afterwards.
+	 */
 	class DhtBus {
 	public:
 		explicit DhtBus(const GpioPin& pin);
+		explicit DhtBus(const GpioPin& pin, EdgeCapture& capture);
 		virtual ~DhtBus();
 
 		bool read(stl::Vector<bool>& output);
+
+		/**
+		 * @brief Pull the line low to request a readout.
+		 *
+		 * The sensor answers once the line is released by finish(), at least StartTime
+		 * milliseconds later.
+		 */
+		void start();
+
+		/**
+		 * @brief Release the line and receive the readout requested by start().
+		 */
+		bool finish(stl::Vector<bool>& output);
 		const GpioPin& pin() const;
 
 		static constexpr int Bits = 40;
+		static constexpr int StartTime = 10;
 
 	private:
 		GpioPin _pin;
 		Lock _lock;
+		EdgeCapture* _capture;
+
+		/* Response and 40 bits of at most 120 us each, with margin. */
+		static constexpr int CaptureTime = 7;
 
 		static constexpr int Interval = 1;
 
@@ -47,5 +74,6 @@ namespace lwiot
 		/* Methods */
 		bool await(uint32_t tmo, bool expected, uint32_t& duration);
 		bool _read(stl::Vector<bool>& output);
+		bool decode(stl::Vector<bool>& output);
 	};
 }
@@ -0,0 +1,89 @@
+/*
+ * GPIO edge capture.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/gpiochip.h>
+#include <lwiot/io/gpiopin.h>
+#include <lwiot/io/irqslot.h>
+
+#ifndef CONFIG_EDGE_CAPTURE_EDGES
+#define CONFIG_EDGE_CAPTURE_EDGES 96
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Record the edges of a signal, to be decoded after it was received.
+	 *
+	 * Protocols with a device timed response, like that of the DHT sensors, are normally decoded
+	 * by polling the line with interrupts disabled. Capturing the edges instead keeps interrupts
+	 * and other tasks running: each edge costs one short interrupt and the bits are decoded
+	 * afterwards from the time between edges.
+	 *
+	 * The default backend timestamps edges from a GPIO interrupt with the delay counter. Ports
+	 * with capture hardware, such as a remote control peripheral or a timer input capture
+	 * channel, override start() and stop() and feed their edges to record().
+	 */
+	class EdgeCapture {
+	public:
+		struct Edge {
+			uint32_t stamp; //!< Delay counter value at the edge.
+			bool level; //!< Level of the line after the edge.
+		};
+
+		explicit EdgeCapture();
+		virtual ~EdgeCapture();
+
+		EdgeCapture(const EdgeCapture&) = delete;
+		EdgeCapture& operator=(const EdgeCapture&) = delete;
+
+		/**
+		 * @brief Discard the previous capture and record the edges on \p pin.
+		 */
+		virtual bool start(const GpioPin& pin);
+		virtual void stop();
+
+		size_t count() const;
+		bool overflow() const; //!< More than Capacity edges were seen.
+		const Edge& edge(size_t idx) const;
+
+		/**
+		 * @brief Time between edge \p idx and the next edge, in microseconds.
+		 */
+		uint32_t duration(size_t idx) const;
+
+		static constexpr size_t Capacity = CONFIG_EDGE_CAPTURE_EDGES;
+
+	protected:
+		void reset();
+
+		/**
+		 * @brief Store an edge. Safe to call from interrupt context.
+		 * @param stamp Delay counter value at the edge.
+		 * @param level Level of the line after the edge.
+		 */
+		void record(uint32_t stamp, bool level);
+
+	private:
+		IrqSlot _slot;
+		GpioChip* _chip;
+		int _pin;
+		uint64_t _per_ms;
+
+		Edge _edges[Capacity];
+		volatile size_t _count;
+		volatile bool _overflow;
+
+		static void handler(void* arg);
+	};
+}
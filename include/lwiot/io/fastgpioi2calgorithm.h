@@ -0,0 +1,81 @@
+/*
+ * Bit-banged I2C algorithm on direct port registers.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/gpiopin.h>
+#include <lwiot/io/gpiofastpin.h>
+#include <lwiot/io/gpioi2calgorithm.h>
+#include <lwiot/io/i2cmessage.h>
+#include <lwiot/kernel/lock.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Bit-banged I2C master that toggles port registers directly.
+	 *
+	 * SDA and SCL are resolved to their port registers once, when the algorithm is created. Clock
+	 * edges are scheduled on the calibrated delay counter (the cycle counter on ports that have
+	 * one): every half period ends at a deadline that is set relative to the previous one, so the
+	 * time spent in the algorithm itself does not stretch the clock. The byte loops are unrolled.
+	 *
+	 * If the GPIO chip of either pin has no direct register access, all transfers fall back
+	 * to GpioI2CAlgorithm.
+	 */
+	class FastGpioI2CAlgorithm : public GpioI2CAlgorithm {
+	public:
+		explicit FastGpioI2CAlgorithm(int sda, int scl, uint32_t frequency = 100000);
+		explicit FastGpioI2CAlgorithm(const GpioPin& sda, const GpioPin& scl, uint32_t frequency = 100000);
+		~FastGpioI2CAlgorithm() override = default;
+
+		ssize_t transfer(I2CMessage& msg) override;
+		ssize_t transfer(stl::Vector<I2CMessage>& msgs) override;
+		void setFrequency(const uint32_t& freq) override;
+
+		/**
+		 * @brief Check whether transfers use the register fast path.
+		 */
+		bool isFast() const;
+
+	private:
+		GpioFastPin _sda;
+		GpioFastPin _scl;
+		bool _fast;
+
+		uint64_t _half; //!< Half a clock period in delay counter ticks.
+		uint64_t _timeout; //!< Clock stretch timeout in delay counter ticks.
+		uint64_t _deadline;
+		Lock _lock;
+
+		static constexpr int Timeout = 10;
+
+		/* Methods */
+		void calibrate(uint32_t frequency);
+		ssize_t transfer(I2CMessage *msgs, size_t num);
+
+		void wait();
+		bool sclhi();
+		bool busy() const;
+
+		void start();
+		bool repstart();
+		void stop();
+
+		bool begin(const I2CMessage& msg);
+		int begin(uint8_t addr);
+
+		int writeBit(bool bit);
+		int readBit();
+		int write(uint8_t byte);
+		int read(uint8_t& byte, bool ack);
+	};
+}
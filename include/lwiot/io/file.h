@@ -12,10 +12,15 @@
 
 #include <lwiot/lwiot.h>
 #include <lwiot/stream.h>
+#include <lwiot/bytebuffer.h>
 #include <lwiot/sharedpointer.h>
 
 #include <lwiot/kernel/lock.h>
 
+#ifndef CONFIG_FILE_BUFFER
+#define CONFIG_FILE_BUFFER 512
+#endif
+
 namespace lwiot
 {
 	enum class FileMode {
@@ -27,11 +32,51 @@ namespace lwiot
 		ReadWriteAppend
 	};
 
+	/**
+	 * @brief Buffered file.
+	 *
+	 * Reads are served from a buffer that is filled one aligned block of \p buffer bytes at a
+	 * time, so that the file system only sees sector aligned reads. Writes are collected in the
+	 * same buffer and written when a block is complete, on flush() or when the file is closed.
+	 * A buffer size of zero disables buffering.
+	 *
+	 * @note The buffer size should be a multiple of the sector size of the file system.
+	 */
 	class File : public virtual Stream {
 	public:
-		explicit File(const String& fname, FileMode mode);
+		explicit File(const String& fname, FileMode mode, size_t buffer = CONFIG_FILE_BUFFER);
 		virtual ~File();
 
+		File(const File&) = delete;
+		File& operator=(const File&) = delete;
+
+		explicit operator bool() const;
+
+		const String& name() const;
+		size_t size() const;
+
+		/**
+		 * @brief Time of the last modification, zero if the file system does not record it.
+		 */
+		time_t modified() const;
+
+		/**
+		 * @brief Move the read and write position to \p offset bytes from the start of the file.
+		 */
+		bool seek(size_t offset);
+
+		/**
+		 * @brief Write buffered data to the file system.
+		 */
+		bool flush();
+
+		/**
+		 * @brief Descriptor of the open file, for calls such as tcp_socket_sendfile().
+		 * @return The descriptor, or -1 if the file is not open.
+		 * @note Call flush() first, the descriptor does not see buffered writes.
+		 */
+		int descriptor() const;
+
 		size_t available() const override;
 
 		Stream &operator<<(char x) override;
@@ -51,6 +96,21 @@ namespace lwiot
 
 		uint8_t read() override;
 		ssize_t read(void *output, const size_t &length) override;
+		using Stream::read;
+
+		/**
+		 * @brief Read up to a delimiter, scanning the buffer rather than reading byte by byte.
+		 * @return The number of bytes appended to \p output, or -ENOTFOUND at the end of the file.
+		 */
+		ssize_t readUntil(char delim, ByteBuffer& output) override;
+
+		/**
+		 * @brief Read a line, without its line ending (LF or CR LF).
+		 * @return The length of the line, or -ENOTFOUND at the end of the file.
+		 */
+		ssize_t readLine(ByteBuffer& line);
+
+		RawBuffer peekSpan() override;
 
 		bool write(uint8_t byte) override;
 		ssize_t write(const void *bytes, const size_t &length) override;
@@ -60,11 +120,26 @@ namespace lwiot
 		
 	private:
 		SharedPointer<Lock> _lock;
+		String _name;
 		FILE* _io;
 		FileMode _mode;
-		size_t _available;
+		size_t _size;
+
+		uint8_t* _buffer;
+		size_t _capacity;
+		size_t _offset; //!< Read and write position.
+		size_t _start; //!< File offset of the first byte in the buffer.
+		size_t _length; //!< Bytes in the buffer.
+		bool _dirty; //!< The buffer holds data that has not been written.
+		bool _append;
 
 		/* Methods */
 		static void fileModeToString(FileMode mode, char *output);
+
+		bool buffered() const;
+		bool commit();
+		bool fill();
+		ssize_t load(void *output, size_t length);
+		ssize_t store(const void *input, size_t length);
 	};
 }
@@ -10,6 +10,8 @@
 #include <lwiot.h>
 
 #include <lwiot/io/gpiopin.h>
+#include <lwiot/io/gpiofastpin.h>
+#include <lwiot/io/waveform.h>
 
 #ifdef __cplusplus
 #include <lwiot/stl/vector.h>
@@ -49,6 +51,42 @@ namespace lwiot
 		virtual uint8_t shiftIn(int dpin, int cpin, bool lsb, uint8_t count, int delay);
 		virtual int shiftOut(int dpin, int cpin, bool lsb, uint8_t val, uint8_t count, int delay);
 
+		/**
+		 * @brief Drive the pins in \p set high and the pins in \p clear low.
+		 *
+		 * Bit n of a mask selects pin n. Chips with set and clear registers override this with a
+		 * single register write, which changes all pins at once; the default writes the pins one
+		 * by one.
+		 */
+		virtual void writeMask(uint32_t set, uint32_t clear);
+
+		/**
+		 * @brief Read the level of the first 32 pins, pin n in bit n.
+		 */
+		virtual uint32_t readPort() const;
+
+		/**
+		 * @brief Invert the pins in \p mask.
+		 */
+		virtual void toggleMask(uint32_t mask);
+
+		/**
+		 * @brief Resolve \p pin to its port registers.
+		 * @return False if the chip offers no direct register access, which is the default.
+		 */
+		virtual bool fastPin(int pin, GpioFastPin& fast) const;
+
+		/**
+		 * @brief Play \p wave on \p pin, which must be an output.
+		 *
+		 * Chips with a pulse or waveform peripheral override this to clock the buffer out by
+		 * DMA. The default bit-bangs the waveform against the delay counter with interrupts
+		 * disabled, for the whole length of the waveform.
+		 *
+		 * @return False if the resolution of \p wave is too fine to bit-bang.
+		 */
+		virtual bool waveform(int pin, const Waveform& wave);
+
 #ifdef CONFIG_PIN_VECTOR
 		virtual GpioPin& operator[] (const size_t& idx);
 		virtual GpioPin& pin(size_t idx);
@@ -0,0 +1,56 @@
+/*
+ * Direct register access to a GPIO pin.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#ifdef __cplusplus
+namespace lwiot
+{
+	/**
+	 * @brief Port registers and bit mask of a single pin.
+	 *
+	 * A GpioChip that can bypass its virtual interface hands these out through GpioChip::fastPin().
+	 * Writing the mask to the set register drives (or, for an open drain pin, releases) the pin
+	 * high; writing it to the clear register drives it low. The input register reflects the level
+	 * on the pin. Ports with a single output register point both at write-one-to-set and
+	 * write-one-to-clear aliases of it.
+	 */
+	struct GpioFastPin {
+		volatile uint32_t *set;
+		volatile uint32_t *clear;
+		const volatile uint32_t *in;
+		uint32_t mask;
+
+		inline void high() const
+		{
+			*this->set = this->mask;
+		}
+
+		inline void low() const
+		{
+			*this->clear = this->mask;
+		}
+
+		inline void write(bool value) const
+		{
+			if(value)
+				this->high();
+			else
+				this->low();
+		}
+
+		inline bool read() const
+		{
+			return (*this->in & this->mask) != 0;
+		}
+	};
+}
+#endif
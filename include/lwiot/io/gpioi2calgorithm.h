@@ -33,18 +33,24 @@ namespace lwiot
 		bool test();
 
 	protected:
+		/**
+		 * @brief Calculate the delay between clock edges.
+		 * @param freq Bus frequency in Hz.
+		 * @return The delay in nanoseconds.
+		 */
 		virtual int calcDelay(const uint32_t& freq) const;
 
 	private:
 		mutable GpioPin _scl;
 		mutable GpioPin _sda;
 
-		int _udelay;
+		int _delay; //!< Delay between clock edges in nanoseconds.
 		int _halftime;
 		Lock _lock;
 		mutable Logger log;
 
 		static constexpr int Timeout = 10;
+		static constexpr int ToggleTime = 2000;
 		static constexpr uint8_t MsbPosition = 7U;
 		static constexpr uint8_t LsbValue = 1U;
 
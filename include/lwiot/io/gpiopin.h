@@ -13,6 +13,8 @@
 namespace lwiot
 {
 	class GpioChip;
+	class Waveform;
+	struct GpioFastPin;
 
 	enum PinMode {
 		INPUT,
@@ -27,6 +29,7 @@ namespace lwiot
 		GpioPin(int pin);
 		explicit GpioPin();
 		explicit GpioPin(int pin, GpioChip& gpio);
+		GpioPin(const GpioPin& pin);
 		virtual ~GpioPin();
 
 		GpioPin& operator =(int pin);
@@ -53,8 +56,21 @@ namespace lwiot
 		int shiftOut(const GpioPin& clock, bool lsb, uint8_t value, uint8_t count, int delay);
 
 		int pin() const;
+		GpioChip& chip() const;
 		operator int() const;
 
+		/**
+		 * @brief Resolve the pin to its port registers.
+		 * @see GpioChip::fastPin
+		 */
+		bool fastPin(GpioFastPin& fast) const;
+
+		/**
+		 * @brief Play \p wave on the pin.
+		 * @see GpioChip::waveform
+		 */
+		bool waveform(const Waveform& wave);
+
 		bool operator ==(const GpioPin& pin);
 		bool operator >(const GpioPin& pin);
 		bool operator <(const GpioPin& pin);
@@ -18,6 +18,10 @@
 #include <lwiot/io/gpiopin.h>
 #include <lwiot/kernel/lock.h>
 
+#ifndef CONFIG_I2C_BULK_THRESHOLD
+#define CONFIG_I2C_BULK_THRESHOLD 16
+#endif
+
 namespace lwiot
 {
 	class HardwareI2CAlgorithm : public I2CAlgorithm {
@@ -60,6 +64,21 @@ namespace lwiot
 		virtual void read(uint8_t* bytes, size_t length, bool ack) = 0;
 		virtual int flush() const = 0;
 
+		/**
+		 * @brief Queue a write of at least CONFIG_I2C_BULK_THRESHOLD bytes.
+		 *
+		 * Backends that are able to move a buffer by DMA or through a FIFO override this, so
+		 * that large transfers do not cost CPU time per byte. The default queues the buffer
+		 * as a regular write.
+		 */
+		virtual void writeBulk(const uint8_t *bytes, size_t length, bool ack);
+
+		/**
+		 * @brief Queue a read of at least CONFIG_I2C_BULK_THRESHOLD bytes.
+		 * @see writeBulk
+		 */
+		virtual void readBulk(uint8_t *bytes, size_t length, bool ack);
+
 	private:
 		static constexpr int MaxRiseTime = 20;
 
@@ -68,6 +87,8 @@ namespace lwiot
 		mutable Logger log;
 		SharedPointer<Lock> _lock;
 
+		void queue(I2CMessage& msg);
+
 		void sdahi() const;
 		void sdalow() const;
 
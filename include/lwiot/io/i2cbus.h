@@ -22,6 +22,8 @@
 
 namespace lwiot
 {
+	class AsyncI2CBus;
+
 	class I2CBus {
 	public:
 		explicit I2CBus();
@@ -41,6 +43,14 @@ namespace lwiot
 
 		I2CAlgorithm *algorithm() const;
 
+		/**
+		 * @brief Hold the bus across several transfers, so that they run as a single batch.
+		 *
+		 * The bus lock is recursive: transfers of the holder nest in the lock.
+		 */
+		void lock();
+		void unlock();
+
 		inline int timeout() const
 		{
 			return this->_timeout;
@@ -52,8 +62,12 @@ namespace lwiot
 		}
 
 	private:
+		friend class AsyncI2CBus;
+
 		SharedPointer<I2CAlgorithm> _algo;
 		SharedPointer<Lock> _lock;
 		int _timeout;
+
+		int attempt(stl::Vector<I2CMessage>& msgs);
 	};
 }
@@ -26,6 +26,8 @@ extern void i2c_write_byte(const uint8_t *byte, bool ack);
 extern void i2c_write_buffer(const uint8_t *bytes, size_t length, bool ack);
 extern void i2c_read_byte(uint8_t* byte, bool ack);
 extern void i2c_read_buffer(uint8_t* bytes, size_t length, bool ack);
+extern void i2c_write_bulk(const uint8_t *bytes, size_t length, bool ack);
+extern void i2c_read_bulk(uint8_t* bytes, size_t length, bool ack);
 extern int i2c_write_buffers();
 
 CDECL_END
@@ -0,0 +1,72 @@
+/*
+ * Queued I2C transaction.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <lwiot/lwiot.h>
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/io/i2cmessage.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/kernel/event.h>
+#include <lwiot/kernel/lock.h>
+
+namespace lwiot
+{
+	class AsyncI2CBus;
+
+	/**
+	 * @brief Set of messages that an AsyncI2CBus transfers in a single bus transaction.
+	 *
+	 * The completion of a transaction is reported to its handler, which runs on the bus thread,
+	 * and then signalled to threads that wait() for it. Read messages hold the data that was read
+	 * once the transaction completed. A transaction must stay alive until it completed, and can
+	 * be submitted again afterwards.
+	 */
+	class I2CTransaction {
+	public:
+		typedef Function<void(bool ok)> CompletionHandler;
+
+		explicit I2CTransaction();
+		explicit I2CTransaction(const CompletionHandler& handler);
+		I2CTransaction(const I2CTransaction&) = delete;
+		I2CTransaction& operator=(const I2CTransaction&) = delete;
+
+		void add(const I2CMessage& msg);
+		void add(I2CMessage&& msg);
+		void clear();
+
+		stl::Vector<I2CMessage>& messages();
+		const stl::Vector<I2CMessage>& messages() const;
+
+		void setHandler(const CompletionHandler& handler);
+
+		/**
+		 * @brief Wait until the transaction completed.
+		 * @param tmo Timeout in milliseconds.
+		 * @return True if the transaction completed successfully within \p tmo.
+		 */
+		bool wait(int tmo = FOREVER);
+
+		bool isComplete() const;
+		bool isSuccess() const;
+
+	private:
+		friend class AsyncI2CBus;
+
+		stl::Vector<I2CMessage> _msgs;
+		CompletionHandler _handler;
+		mutable Lock _lock;
+		Event _done;
+		bool _queued;
+		bool _complete;
+		bool _ok;
+
+		int _attempts;
+		time_t _due;
+	};
+}
@@ -0,0 +1,62 @@
+/*
+ * GPIO interrupt with a context argument.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/gpiochip.h>
+
+#ifndef CONFIG_IRQ_SLOTS
+#define CONFIG_IRQ_SLOTS 8
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Attach a handler that takes an argument to a GPIO interrupt.
+	 *
+	 * GpioChip handlers take no argument. Every attached IrqSlot takes one of CONFIG_IRQ_SLOTS
+	 * global slots, each of which has a handler of its own that forwards to \p handler.
+	 */
+	class IrqSlot {
+	public:
+		typedef void (*Handler)(void* arg);
+
+		explicit IrqSlot();
+		~IrqSlot();
+
+		IrqSlot(const IrqSlot&) = delete;
+		IrqSlot& operator=(const IrqSlot&) = delete;
+
+		/**
+		 * @brief Attach \p handler to \p pin of \p chip.
+		 * @return False when all slots are taken.
+		 */
+		bool attach(GpioChip& chip, int pin, IrqEdge edge, Handler handler, void* arg);
+		void detach();
+		bool attached() const;
+
+	private:
+		GpioChip* _chip;
+		int _pin;
+		int _slot;
+		Handler _handler;
+		void* _arg;
+
+		template <int Slot>
+		static void dispatch();
+
+		template <int Num>
+		struct Handlers;
+
+		static IrqSlot* _slots[CONFIG_IRQ_SLOTS];
+	};
+}
@@ -0,0 +1,101 @@
+/*
+ * Timer driven LED animations.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/leddriver.h>
+#include <lwiot/io/rgbleddriver.h>
+#include <lwiot/stl/vector.h>
+
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/functionaltimer.h>
+
+#ifndef CONFIG_LED_ANIMATOR_TICK
+#define CONFIG_LED_ANIMATOR_TICK 20
+#endif
+
+namespace lwiot
+{
+	enum class Easing {
+		Linear,
+		EaseIn, //!< Quadratic, slow start.
+		EaseOut, //!< Quadratic, slow end.
+		EaseInOut //!< Smoothstep.
+	};
+
+	/**
+	 * @brief Run LED fades and colour rotations in the background.
+	 *
+	 * Unlike LedDriver::fade() and RgbLedDriver::rotate(), which sleep between steps, the
+	 * animator returns immediately. All animations are stepped by a single periodic timer, which
+	 * only runs while there is something to animate, so any number of LEDs can be animated
+	 * without a thread each.
+	 *
+	 * Starting an animation on an LED replaces the animation it was running. Linear fades are
+	 * handed to the PWM channel when it can fade by itself (see PwmChannel::fade()).
+	 *
+	 * @note The LED drivers must outlive their animations.
+	 */
+	class LedAnimator {
+	public:
+		explicit LedAnimator(int tick = CONFIG_LED_ANIMATOR_TICK);
+		virtual ~LedAnimator();
+
+		LedAnimator(const LedAnimator&) = delete;
+		LedAnimator& operator=(const LedAnimator&) = delete;
+
+		/**
+		 * @brief Fade \p led to \p brightness (0 - 100) in \p ms milliseconds.
+		 */
+		void fade(LedDriver& led, double brightness, int ms, Easing easing = Easing::Linear);
+		void fade(RgbLedDriver& led, uint8_t r, uint8_t g, uint8_t b, int ms, Easing easing = Easing::Linear);
+
+		/**
+		 * @brief Rotate the hue of \p led once every \p period milliseconds.
+		 * @param led LED to animate.
+		 * @param period Duration of one rotation.
+		 * @param s Saturation (0 - 1).
+		 * @param v Value (0 - 1).
+		 * @param repeat Keep rotating until cancelled.
+		 */
+		void rotate(RgbLedDriver& led, int period, double s = 1.0, double v = 1.0, bool repeat = true);
+
+		void cancel(LedDriver& led);
+		void cancel(RgbLedDriver& led);
+
+		size_t active() const;
+
+		static double ease(Easing easing, double t);
+
+	private:
+		struct Animation {
+			LedDriver* led;
+			RgbLedDriver* rgb;
+			double from;
+			double to;
+			time_t start;
+			int duration;
+			Easing easing;
+			bool hardware;
+			bool repeat;
+		};
+
+		mutable Lock _lock;
+		FunctionalTimer<void> _timer;
+		stl::Vector<Animation> _animations;
+		bool _running;
+
+		void add(const Animation& animation);
+		void remove(const LedDriver* led, const RgbLedDriver* rgb);
+		void tick();
+	};
+}
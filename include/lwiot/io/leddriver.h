@@ -8,6 +8,7 @@
 #pragma once
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <lwiot.h>
 
 #include <lwiot/io/pwm.h>
@@ -18,7 +19,7 @@ namespace lwiot
 {
 	class LedDriver {
 	public:
-		constexpr LedDriver() : _brightness(0.0)
+		constexpr LedDriver() : _brightness(0.0), _gamma(false)
 		{ }
 
 		explicit LedDriver(double brightness);
@@ -27,6 +28,21 @@ namespace lwiot
 		void setChannel(PwmChannel& channel);
 		void setBrightness(double brightness);
 
+		/**
+		 * @brief Set the brightness on a 0 - 255 scale without floating point math.
+		 */
+		void set(uint8_t value);
+
+		/**
+		 * @brief Map brightness levels through a gamma 2.2 curve, so that they are perceived linearly.
+		 */
+		void setGamma(bool enabled);
+
+		/**
+		 * @brief Gamma correct \p value to a PWM level of 0 to \p max.
+		 */
+		static uint32_t gamma(uint8_t value, uint32_t max);
+
 		void fade(double target, int ms, int step_size = 50);
 
 		constexpr double brightness() const
@@ -42,5 +58,8 @@ namespace lwiot
 	private:
 		stl::ReferenceWrapper<PwmChannel> _channel;
 		double _brightness;
+		bool _gamma;
+
+		void write(uint8_t value);
 	};
 }
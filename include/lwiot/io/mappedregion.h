@@ -0,0 +1,76 @@
+/*
+ * Read-only memory mapped data.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Read-only view of a file or of memory mapped flash.
+	 *
+	 * Static assets, such as web pages, fonts and calibration tables, can be used in place
+	 * through data() instead of being read into the heap first. Files are mapped using mmap()
+	 * where the platform has it; elsewhere they are read into a heap buffer once, which keeps
+	 * the API the same but saves no memory (see mapped()).
+	 *
+	 * Data that is already addressable, such as a flash partition that a port has mapped or an
+	 * asset that was linked into the image, is wrapped without taking ownership.
+	 */
+	class MappedRegion {
+	public:
+		explicit MappedRegion();
+		explicit MappedRegion(const void *address, size_t size);
+		explicit MappedRegion(const String& path);
+		~MappedRegion();
+
+		MappedRegion(MappedRegion&& other) noexcept;
+		MappedRegion& operator=(MappedRegion&& rhs) noexcept;
+
+		MappedRegion(const MappedRegion&) = delete;
+		MappedRegion& operator=(const MappedRegion&) = delete;
+
+		/**
+		 * @brief Map \p path read-only, replacing the current region.
+		 */
+		bool map(const String& path);
+		void unmap();
+
+		explicit operator bool() const;
+
+		const uint8_t *data() const;
+		size_t size() const;
+
+		RawBuffer span() const;
+		StringView view() const;
+
+		/**
+		 * @brief Check whether the data is used in place, rather than copied into the heap.
+		 */
+		bool mapped() const;
+
+	private:
+		enum class Kind {
+			None,
+			Borrowed,
+			Mapped,
+			Heap
+		};
+
+		const uint8_t *_data;
+		size_t _size;
+		Kind _kind;
+	};
+}
@@ -15,11 +15,20 @@
 #include <lwiot/io/gpiochip.h>
 #include <lwiot/bufferedstream.h>
 #include <lwiot/kernel/lock.h>
+#include <lwiot/stl/vector.h>
 
 typedef uint64_t onewire_addr_t;
 
 namespace lwiot
 {
+	/**
+	 * @brief 1-Wire bus master.
+	 *
+	 * Devices on the bus are found with the ROM search algorithm and are cached by scan(). A
+	 * command that every device should execute, such as starting a temperature conversion, can
+	 * be broadcast with a single skip ROM transaction; the results are then collected with one
+	 * addressed read per cached device.
+	 */
 	class OneWireBus {
 	public:
 		explicit OneWireBus(const GpioPin& pin);
@@ -27,6 +36,46 @@ namespace lwiot
 
 		bool reset();
 		bool select(const onewire_addr_t& addr);
+		bool skip(); //!< Address all devices on the bus (skip ROM).
+
+		/**
+		 * @brief Find the next device on the bus.
+		 * @param addr Address of the device that was found.
+		 * @return False when all devices have been found or when no device responded.
+		 * @see resetSearch
+		 */
+		bool search(onewire_addr_t& addr);
+		void resetSearch();
+
+		/**
+		 * @brief Search the bus and cache the address of every device found.
+		 * @return The number of devices found.
+		 */
+		size_t scan();
+		const stl::Vector<onewire_addr_t>& devices() const;
+
+		/**
+		 * @brief Send \p command to all devices at once.
+		 */
+		bool broadcast(uint8_t command);
+
+		/**
+		 * @brief Send \p command to each cached device and read its response.
+		 *
+		 * The response of the i-th device in devices() is stored at data + i * length. When
+		 * \p crc is set, the last byte of each response is checked as a Dallas CRC-8 and a
+		 * response that fails the check is overwritten with 0xFF, which is what an absent device
+		 * reads as.
+		 *
+		 * @param command Function command, e.g. read scratchpad.
+		 * @param data Output buffer of at least devices().size() * length bytes.
+		 * @param length Response length per device.
+		 * @param crc Verify the CRC of each response.
+		 * @return The number of valid responses.
+		 */
+		size_t read(uint8_t command, uint8_t *data, size_t length, bool crc = true);
+
+		static uint8_t crc8(const uint8_t *data, size_t length);
 
 		bool write(BufferedStream& data);
 		bool write(const uint8_t *data, size_t length);
@@ -45,11 +94,20 @@ namespace lwiot
 		Lock _lock;
 		mutable Logger _log;
 
+		stl::Vector<onewire_addr_t> _devices;
+		onewire_addr_t _rom;
+		int _last_discrepancy;
+		bool _last_device;
+
 		/* Methods */
 		int read(bool& output);
 		bool write(bool value);
 		bool wait(unsigned long us);
 
+		bool presence();
+		bool address(const onewire_addr_t& addr);
+		bool next(onewire_addr_t& addr);
+
 		static constexpr uint8_t msb()
 		{
 			return 7U;
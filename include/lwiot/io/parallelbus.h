@@ -0,0 +1,65 @@
+/*
+ * Parallel GPIO bus.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/gpiochip.h>
+
+#ifndef CONFIG_PARALLEL_BUS_WIDTH
+#define CONFIG_PARALLEL_BUS_WIDTH 16
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Data bus of up to CONFIG_PARALLEL_BUS_WIDTH GPIO pins, such as the 8-bit interface
+	 * of a display controller or the row lines of an LED matrix.
+	 *
+	 * A word is written with a single GpioChip::writeMask() call, so all data lines change at
+	 * once. When a strobe (write enable) pin is given, it is asserted together with the data and
+	 * released by a second port write, which latches the word on the release edge.
+	 *
+	 * The pins must be below 32. Data pins that are consecutive are mapped with a single shift.
+	 */
+	class ParallelBus {
+	public:
+		/**
+		 * @param chip GPIO chip of the pins.
+		 * @param pins Data pins, least significant bit first.
+		 * @param width Number of data pins.
+		 * @param strobe Strobe pin, or -1.
+		 * @param active_low Strobe polarity.
+		 */
+		explicit ParallelBus(GpioChip& chip, const int *pins, size_t width, int strobe = -1, bool active_low = true);
+
+		void begin();
+
+		void write(uint16_t value);
+		void write(const uint8_t *data, size_t length);
+		uint16_t read() const;
+
+		size_t width() const;
+
+	private:
+		GpioChip& _chip;
+		int _pins[CONFIG_PARALLEL_BUS_WIDTH];
+		size_t _width;
+		int _shift;
+
+		uint32_t _data;
+		int _strobe_pin;
+		uint32_t _strobe;
+		bool _active_low;
+
+		uint32_t expand(uint16_t value) const;
+	};
+}
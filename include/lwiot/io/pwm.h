@@ -15,6 +15,10 @@
 #include <lwiot/io/gpiochip.h>
 #include <lwiot/io/gpiopin.h>
 
+#ifndef CONFIG_PWM_RESOLUTION
+#define CONFIG_PWM_RESOLUTION 10
+#endif
+
 namespace lwiot
 {
 	class PwmTimer;
@@ -26,9 +30,21 @@ namespace lwiot
 		explicit PwmChannel(const GpioPin& pin);
 		virtual ~PwmChannel() = default;
 
-		const double& duty() const;
+		double duty() const;
 		void setDutyCycle(const double& duty);
 
+		/**
+		 * @brief Duty cycle in timer ticks, 0 to resolution().
+		 */
+		uint32_t level() const;
+		void setLevel(uint32_t level);
+
+		/**
+		 * @brief Largest duty cycle level of the timer.
+		 * @note Defaults to 2^CONFIG_PWM_RESOLUTION - 1.
+		 */
+		virtual uint32_t resolution() const;
+
 		virtual void setGpioPin(const GpioPin& pin);
 
 		virtual void enable() = 0;
@@ -36,6 +52,12 @@ namespace lwiot
 		virtual void reload() = 0;
 		operator bool() const;
 
+		/**
+		 * @brief Let the PWM hardware fade linearly to \p duty in \p ms milliseconds.
+		 * @return False if the channel cannot fade by itself, which is the default.
+		 */
+		virtual bool fade(const double& duty, int ms);
+
 	protected:
 		mutable unsigned int freq_cache;
 
@@ -48,7 +70,7 @@ namespace lwiot
 	private:
 		/* Attributes */
 		GpioPin _pin;
-		double _duty;
+		uint32_t _level;
 	};
 
 	class PwmTimer {
@@ -59,6 +81,9 @@ namespace lwiot
 
 		const int& frequency() const;
 		virtual void setFrequency(const int &freq);
+		/**
+		 * @brief Update all channels and commit their duty cycles at once.
+		 */
 		virtual void update();
 
 		PwmChannel& operator [](const size_t& index);
@@ -67,6 +92,15 @@ namespace lwiot
 
 	protected:
 		void addChannel(PwmChannel& channel);
+
+		/**
+		 * @brief Latch the duty cycles that the channels staged in PwmChannel::update().
+		 *
+		 * Timers with shadow registers should only stage the new levels in the channels and load
+		 * them all in a single register write here, so that the channels of an RGB LED never show
+		 * a mix of old and new levels.
+		 */
+		virtual void commit();
 		stl::Vector<PwmChannel*> _channels;
 		friend class PwmChannel;
 
@@ -36,9 +36,19 @@ namespace lwiot
 		void fade(uint8_t r, uint8_t g, uint8_t b, int ms = 30, double stepsize = 50.0);
 		void fadeBrightness(bool out, int ms = 30, double stepsize  = 50.0);
 		void setHSV(int h, double s, double v);
+		void setGamma(bool enabled);
+
+		/**
+		 * @brief Convert a hue (degrees) with saturation and value (0 - 255) to RGB using integer math.
+		 */
+		static void hsvToRgb(int h, uint8_t s, uint8_t v, uint8_t& r, uint8_t& g, uint8_t& b);
 
 		void rotate(int ms = 30);
 
+		LedDriver& red();
+		LedDriver& green();
+		LedDriver& blue();
+
 	private:
 		LedDriver _red;
 		LedDriver _green;
@@ -46,13 +56,7 @@ namespace lwiot
 
 		double _r, _g, _b;
 
-		static constexpr void clamp(double &value, double min, double max)
-		{
-			if(value < min)
-				value = min;
-			else if(value > max)
-				value = max;
-		}
+		static uint8_t toByte(double value);
 
 		/* Private methods */
 		void updateDiffValue(double &diff, double &step);
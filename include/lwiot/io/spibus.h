@@ -13,32 +13,83 @@
 #include <lwiot/io/spimessage.h>
 #include <lwiot/types.h>
 #include <lwiot/io/gpiopin.h>
+#include <lwiot/kernel/lock.h>
 #include <lwiot/stl/vector.h>
 
 #ifdef __cplusplus
 namespace lwiot
 {
+	enum class SpiMode : uint8_t {
+		Mode0, //!< CPOL:0 CPHA:0
+		Mode1, //!< CPOL:0 CPHA:1
+		Mode2, //!< CPOL:1 CPHA:0
+		Mode3, //!< CPOL:1 CPHA:1
+	};
+
+	class SpiDevice;
+
+	/**
+	 * @brief SPI bus master.
+	 *
+	 * Backends implement transfer(SpiMessage&) and drive chip select through select() and
+	 * release(), which keep chip select asserted after a message that holds it (see
+	 * SpiMessage::setHold). A backend that is able to chain segments, using DMA for example,
+	 * overrides transfer(stl::Vector<SpiMessage>&) to run a whole transaction at once.
+	 */
 	class SpiBus {
 	public:
 		explicit SpiBus(int mosi, int miso, int clk, uint32_t freq = 1000000UL);
 		virtual ~SpiBus() = default;
 
 		const uint32_t& frequency() const;
+		const SpiMode& mode() const;
 		const GpioPin& miso() const;
 		const GpioPin& mosi() const;
 		const GpioPin& clk() const;
 
 		virtual bool transfer(SpiMessage& msg) = 0;
+
+		/**
+		 * @brief Transfer \p msgs, in order, without interleaving transfers through an SpiDevice.
+		 *
+		 * Chip select is released when a transfer fails, even if the failed message holds it.
+		 */
 		virtual bool transfer(stl::Vector<SpiMessage>& msgs);
 		virtual void setFrequency(uint32_t freq);
+		virtual void setMode(SpiMode mode);
+
+		/**
+		 * @brief Apply \p freq and \p mode, skipping the settings that did not change.
+		 */
+		void configure(uint32_t freq, SpiMode mode);
 
 	protected:
 		GpioPin _miso;
 		GpioPin _mosi;
 		GpioPin _clk;
 
+		/**
+		 * @brief Assert the chip select of \p msg, unless it is still held.
+		 */
+		void select(const SpiMessage& msg);
+
+		/**
+		 * @brief Deassert the chip select of \p msg, unless \p msg holds it.
+		 */
+		void release(const SpiMessage& msg);
+
+		/**
+		 * @brief Deassert a chip select that is still held.
+		 */
+		void release();
+
 	private:
+		friend class SpiDevice;
+
 		uint32_t _freq;
+		SpiMode _mode;
+		GpioPin _selected;
+		Lock _lock;
 	};
 }
 #endif
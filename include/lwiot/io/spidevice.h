@@ -0,0 +1,59 @@
+/*
+ * SPI slave device.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <lwiot.h>
+#include <stdlib.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/gpiopin.h>
+#include <lwiot/io/spibus.h>
+#include <lwiot/io/spimessage.h>
+#include <lwiot/stl/vector.h>
+
+#ifdef __cplusplus
+namespace lwiot
+{
+	/**
+	 * @brief Slave on an SpiBus, with its own clock frequency and mode.
+	 *
+	 * The settings of a device are applied to the bus before each of its transfers. The bus
+	 * remembers the settings that it runs at, so that devices that share settings, or a single
+	 * device, do not reconfigure the bus on every transfer.
+	 */
+	class SpiDevice {
+	public:
+		explicit SpiDevice(SpiBus& bus, int cs, uint32_t freq = 1000000UL, SpiMode mode = SpiMode::Mode0);
+		virtual ~SpiDevice() = default;
+
+		const GpioPin& cs() const;
+		const uint32_t& frequency() const;
+		const SpiMode& mode() const;
+		SpiBus& bus() const;
+
+		void setFrequency(uint32_t freq);
+		void setMode(SpiMode mode);
+
+		bool transfer(SpiMessage& msg);
+
+		/**
+		 * @brief Transfer \p msgs as a single transaction.
+		 *
+		 * Chip select stays asserted from the first message until the last one, so a command and
+		 * its data can be sent as separate segments. Every message is addressed to this device.
+		 */
+		bool transfer(stl::Vector<SpiMessage>& msgs);
+
+	private:
+		SpiBus& _bus;
+		GpioPin _cs;
+		uint32_t _freq;
+		SpiMode _mode;
+	};
+}
+#endif
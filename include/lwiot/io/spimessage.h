@@ -37,12 +37,22 @@ namespace lwiot
 		const size_t& size() const;
 		const GpioPin& cspin() const;
 
+		/**
+		 * @brief Keep chip select asserted after this message.
+		 *
+		 * The next message to the same chip select continues the transaction, which ends with
+		 * the first message that does not hold chip select.
+		 */
+		void setHold(bool hold);
+		bool hold() const;
+
 	private:
 		ByteBuffer _tx;
 		ByteBuffer _rx;
 		size_t _idx;
 		size_t _size;
 		GpioPin _cspin;
+		bool _hold;
 	};
 }
 #endif
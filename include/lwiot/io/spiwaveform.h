@@ -0,0 +1,41 @@
+/*
+ * Waveform output on the MOSI line of an SPI bus.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/spibus.h>
+#include <lwiot/io/waveform.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Clock a Waveform out of the MOSI pin of an SPI bus.
+	 *
+	 * The bus runs at 1 / resolution with one sample per bit, so the waveform is timed by the
+	 * SPI peripheral (and its DMA, if the backend uses it) instead of the CPU. Only MOSI is
+	 * connected to the receiver; clock and chip select are unused by it.
+	 */
+	class SpiWaveform {
+	public:
+		/**
+		 * @param bus SPI bus to use.
+		 * @param cs Chip select pin for the transfer, or -1 when the bus needs none.
+		 */
+		explicit SpiWaveform(SpiBus& bus, int cs = -1);
+
+		bool write(const Waveform& wave);
+
+	private:
+		SpiBus& _bus;
+		int _cs;
+	};
+}
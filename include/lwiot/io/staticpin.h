@@ -0,0 +1,351 @@
+/*
+ * Compile-time GPIO pins.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/error.h>
+#include <lwiot/io/gpiopin.h>
+#include <lwiot/io/gpiochip.h>
+#include <lwiot/io/gpiofastpin.h>
+
+#ifdef __cplusplus
+namespace lwiot
+{
+	/**
+	 * @brief GPIO port at fixed register addresses.
+	 *
+	 * Writing a mask to \p Set drives the pins in it high and writing it to \p Clear drives them
+	 * low; \p In reads the level of the port. \p DirSet and \p DirClear switch pins to output
+	 * and to input. Ports without separate direction set and clear registers leave them at 0,
+	 * and configure the direction once with GpioChip::mode().
+	 *
+	 * Any type with the same static members can be used as the port of a StaticPin, for
+	 * example to reach registers that are not memory mapped.
+	 */
+	template <uintptr_t Set, uintptr_t Clear, uintptr_t In, uintptr_t DirSet = 0, uintptr_t DirClear = 0>
+	struct RegisterPort {
+		static inline void set(uint32_t mask)
+		{
+			*reinterpret_cast<volatile uint32_t *>(Set) = mask;
+		}
+
+		static inline void clear(uint32_t mask)
+		{
+			*reinterpret_cast<volatile uint32_t *>(Clear) = mask;
+		}
+
+		static inline uint32_t read()
+		{
+			return *reinterpret_cast<const volatile uint32_t *>(In);
+		}
+
+		static inline void output(uint32_t mask)
+		{
+			if(DirSet != 0)
+				*reinterpret_cast<volatile uint32_t *>(DirSet) = mask;
+		}
+
+		static inline void input(uint32_t mask)
+		{
+			if(DirClear != 0)
+				*reinterpret_cast<volatile uint32_t *>(DirClear) = mask;
+		}
+
+		static inline bool registers(GpioFastPin& fast)
+		{
+			fast.set = reinterpret_cast<volatile uint32_t *>(Set);
+			fast.clear = reinterpret_cast<volatile uint32_t *>(Clear);
+			fast.in = reinterpret_cast<const volatile uint32_t *>(In);
+
+			return true;
+		}
+	};
+
+	/**
+	 * @brief GPIO pin that is fixed at compile time.
+	 *
+	 * The port and the pin number are template arguments, so each operation inlines to a single
+	 * access of a port register, without a chip pointer or a virtual call. A StaticPin has no
+	 * state; objects of it can be passed around for free and are used by the same templates as
+	 * a DynamicPin.
+	 *
+	 * @code
+	 * typedef lwiot::RegisterPort<0x3FF44008, 0x3FF4400C, 0x3FF4403C, 0x3FF44024, 0x3FF44028> Port0;
+	 * typedef lwiot::StaticPin<Port0, 4> Led;
+	 *
+	 * Led::output();
+	 * Led::high();
+	 * @endcode
+	 */
+	template <typename Port, unsigned Pin>
+	struct StaticPin {
+		static_assert(Pin < 32, "A port has 32 pins at most");
+
+		static constexpr uint32_t mask = 1UL << Pin;
+
+		static inline void high()
+		{
+			Port::set(mask);
+		}
+
+		static inline void low()
+		{
+			Port::clear(mask);
+		}
+
+		static inline void write(bool value)
+		{
+			if(value)
+				high();
+			else
+				low();
+		}
+
+		static inline bool read()
+		{
+			return (Port::read() & mask) != 0;
+		}
+
+		static inline void output()
+		{
+			Port::output(mask);
+		}
+
+		static inline void input()
+		{
+			Port::input(mask);
+		}
+
+		/**
+		 * @brief Release an open drain line: stop driving it and let the pull up raise it.
+		 */
+		static inline void release()
+		{
+			Port::input(mask);
+		}
+
+		/**
+		 * @brief Pull an open drain line low.
+		 */
+		static inline void pull()
+		{
+			Port::clear(mask);
+			Port::output(mask);
+		}
+
+		/**
+		 * @brief Port registers of the pin, for code that takes a GpioFastPin.
+		 */
+		static inline GpioFastPin fast()
+		{
+			GpioFastPin rv;
+
+			Port::registers(rv);
+			rv.mask = mask;
+
+			return rv;
+		}
+	};
+
+	/**
+	 * @brief Adapter that gives a GpioPin the interface of a StaticPin.
+	 *
+	 * Templates that are written against the StaticPin interface, such as shiftOut(), take a
+	 * DynamicPin for pins that are only known at run time.
+	 */
+	class DynamicPin {
+	public:
+		explicit DynamicPin(const GpioPin& pin) : _pin(pin)
+		{
+		}
+
+		inline void high()
+		{
+			this->_pin.write(true);
+		}
+
+		inline void low()
+		{
+			this->_pin.write(false);
+		}
+
+		inline void write(bool value)
+		{
+			this->_pin.write(value);
+		}
+
+		inline bool read() const
+		{
+			return this->_pin.read();
+		}
+
+		inline void output()
+		{
+			this->_pin.output();
+		}
+
+		inline void input()
+		{
+			this->_pin.input();
+		}
+
+		inline void release()
+		{
+			this->_pin.input();
+		}
+
+		inline void pull()
+		{
+			this->_pin.write(false);
+			this->_pin.output();
+		}
+
+	private:
+		GpioPin _pin;
+	};
+
+	/**
+	 * @brief GpioChip that drives a port through its compile-time interface.
+	 *
+	 * The adapter in the other direction: GpioPin(n, chip) gives code that takes a GpioPin, such
+	 * as OneWireBus, DhtBus and the software I2C algorithms, access to the port. fastPin() hands
+	 * out the port registers, so FastGpioI2CAlgorithm still toggles them directly. Open drain
+	 * pins are emulated by switching between a low output and an input.
+	 */
+	template <typename Port>
+	class StaticGpioChip : public GpioChip {
+	public:
+		explicit StaticGpioChip() : GpioChip(32)
+		{
+		}
+
+		~StaticGpioChip() override = default;
+
+		void mode(int pin, const PinMode& mode) override
+		{
+			if(mode == OUTPUT)
+				Port::output(1UL << pin);
+			else if(mode == OUTPUT_OPEN_DRAIN)
+				this->setOpenDrain(pin);
+			else
+				Port::input(1UL << pin);
+		}
+
+		void write(int pin, bool value) override
+		{
+			if(value)
+				Port::set(1UL << pin);
+			else
+				Port::clear(1UL << pin);
+		}
+
+		bool read(int pin) const override
+		{
+			return (Port::read() & (1UL << pin)) != 0;
+		}
+
+		void setOpenDrain(int pin) override
+		{
+			Port::clear(1UL << pin);
+			Port::input(1UL << pin);
+		}
+
+		void odWrite(int pin, bool value) override
+		{
+			if(value) {
+				Port::input(1UL << pin);
+			} else {
+				Port::clear(1UL << pin);
+				Port::output(1UL << pin);
+			}
+		}
+
+		void attachIrqHandler(int pin, irq_handler_t handler, IrqEdge edge) override
+		{
+		}
+
+		void detachIrqHandler(int pin) override
+		{
+		}
+
+		void writeMask(uint32_t set, uint32_t clear) override
+		{
+			Port::set(set);
+			Port::clear(clear);
+		}
+
+		uint32_t readPort() const override
+		{
+			return Port::read();
+		}
+
+		bool fastPin(int pin, GpioFastPin& fast) const override
+		{
+			if(!Port::registers(fast))
+				return false;
+
+			fast.mask = 1UL << pin;
+			return true;
+		}
+	};
+
+	/**
+	 * @brief Clock \p count bits of \p value out on \p data, most significant bit first unless
+	 *        \p lsb is set.
+	 * @param delay Half of the clock period in microseconds; 0 runs at the speed of the port.
+	 */
+	template <typename Data, typename Clock>
+	inline void shiftOut(Data&& data, Clock&& clock, bool lsb, uint8_t value, uint8_t count = 8, int delay = 0)
+	{
+		for(uint8_t idx = 0; idx < count; idx++) {
+			auto bit = lsb ? idx : (count - 1) - idx;
+
+			data.write((value >> bit) & 1);
+			clock.high();
+
+			if(delay)
+				lwiot_udelay(delay);
+
+			clock.low();
+
+			if(delay)
+				lwiot_udelay(delay);
+		}
+	}
+
+	/**
+	 * @brief Clock \p count bits in from \p data, sampled while \p clock is high.
+	 */
+	template <typename Data, typename Clock>
+	inline uint8_t shiftIn(Data&& data, Clock&& clock, bool lsb, uint8_t count = 8, int delay = 0)
+	{
+		uint8_t value = 0;
+
+		for(uint8_t idx = 0; idx < count; idx++) {
+			auto bit = lsb ? idx : (count - 1) - idx;
+
+			clock.high();
+
+			if(delay)
+				lwiot_udelay(delay);
+
+			value |= static_cast<uint8_t>(data.read() << bit);
+			clock.low();
+
+			if(delay)
+				lwiot_udelay(delay);
+		}
+
+		return value;
+	}
+}
+#endif
@@ -0,0 +1,162 @@
+/*
+ * Watchdog supervision of threads.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/io/watchdog.h>
+
+#include <lwiot/kernel/thread.h>
+#include <lwiot/kernel/event.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/atomic.h>
+
+#include <lwiot/stl/vector.h>
+
+#ifndef CONFIG_WATCHDOG_HEARTBEATS
+#define CONFIG_WATCHDOG_HEARTBEATS 8
+#endif
+
+#ifndef CONFIG_WATCHDOG_INTERVAL
+#define CONFIG_WATCHDOG_INTERVAL 500
+#endif
+
+namespace lwiot
+{
+	class WatchdogSupervisor;
+
+	/**
+	 * @brief State of a supervised thread.
+	 */
+	struct HeartbeatStatus {
+		const char *name;
+		uint32_t timeout; //!< Longest time between check-ins, in milliseconds.
+		uint32_t age; //!< Time since the last check-in, in milliseconds.
+		bool stalled;
+	};
+
+	/**
+	 * @brief Check-in of a supervised thread.
+	 *
+	 * A thread creates a heartbeat, for example as a member, and calls beat() once per
+	 * iteration of its loop. A beat is a single atomic store; it takes no lock.
+	 *
+	 * @code
+	 * lwiot::Heartbeat heartbeat(supervisor, "mqtt", 5000);
+	 *
+	 * while(running) {
+	 *     heartbeat.beat();
+	 *     ...
+	 * }
+	 * @endcode
+	 */
+	class Heartbeat {
+	public:
+		/**
+		 * @param supervisor Supervisor to register with.
+		 * @param name Name in the report; a string that outlives the heartbeat.
+		 * @param tmo Longest time, in milliseconds, between two check-ins.
+		 */
+		explicit Heartbeat(WatchdogSupervisor& supervisor, const char *name, uint32_t tmo);
+		~Heartbeat();
+
+		Heartbeat(const Heartbeat&) = delete;
+		Heartbeat& operator=(const Heartbeat&) = delete;
+
+		void beat()
+		{
+			if(this->_last != nullptr)
+				this->_last->store(static_cast<uint32_t>(lwiot_tick_ms()), memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Check whether the supervisor had a free slot for this heartbeat.
+		 */
+		bool registered() const;
+
+	private:
+		WatchdogSupervisor& _supervisor;
+		Atomic<uint32_t> *_last;
+	};
+
+	/**
+	 * @brief Feeds a watchdog as long as every supervised thread checks in.
+	 *
+	 * Up to CONFIG_WATCHDOG_HEARTBEATS threads register a Heartbeat. Every interval the
+	 * supervisor thread checks the time since each of them last checked in. The watchdog is
+	 * only fed when all of them checked in within their timeout, so a thread that deadlocks
+	 * resets the device once the watchdog expires, even though other threads keep running. The
+	 * stall handler is called once for each thread that stalls, before that happens, to log or
+	 * store which thread it was.
+	 *
+	 * The watchdog timeout must be longer than the interval. Applications without a thread to
+	 * spare can call check() from their main loop instead of calling begin().
+	 */
+	class WatchdogSupervisor : public Thread {
+	public:
+		typedef Function<void(const HeartbeatStatus& status)> StallHandler;
+
+		explicit WatchdogSupervisor(Watchdog& watchdog, int interval = CONFIG_WATCHDOG_INTERVAL);
+		~WatchdogSupervisor() override;
+
+		/**
+		 * @brief Enable the watchdog and start supervising.
+		 * @param tmo Watchdog timeout in milliseconds, which must be longer than the interval.
+		 * @return False if supervision already runs, \p tmo is too short or the watchdog could
+		 *         not be enabled.
+		 */
+		bool begin(uint32_t tmo);
+
+		/**
+		 * @brief Stop supervising and disable the watchdog.
+		 */
+		void end();
+
+		/**
+		 * @brief Check all heartbeats and feed the watchdog if none of them stalled.
+		 * @return True if the watchdog was fed.
+		 */
+		bool check();
+
+		void setStallHandler(const StallHandler& handler);
+
+		/**
+		 * @brief State of all registered heartbeats.
+		 */
+		stl::Vector<HeartbeatStatus> report() const;
+
+	protected:
+		void run() override;
+
+	private:
+		friend class Heartbeat;
+
+		struct Slot {
+			const char *name;
+			uint32_t timeout;
+			bool used;
+			bool reported;
+			Atomic<uint32_t> last;
+		};
+
+		Watchdog& _watchdog;
+		int _interval;
+		mutable Lock _lock;
+		Event _wakeup;
+		bool _running;
+		StallHandler _handler;
+		Slot _slots[CONFIG_WATCHDOG_HEARTBEATS];
+
+		Atomic<uint32_t> *attach(const char *name, uint32_t tmo);
+		void detach(Atomic<uint32_t> *last);
+	};
+}
@@ -0,0 +1,76 @@
+/*
+ * Sampled pulse train.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/vector.h>
+
+#ifndef CONFIG_WAVEFORM_MIN_RESOLUTION
+#define CONFIG_WAVEFORM_MIN_RESOLUTION 100
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Encoding of a single data bit as a high pulse followed by a low pulse.
+	 */
+	struct WaveformSymbol {
+		uint32_t high; //!< High time in nanoseconds.
+		uint32_t low; //!< Low time in nanoseconds.
+	};
+
+	/**
+	 * @brief Pulse train sampled at a fixed resolution.
+	 *
+	 * The levels are packed one bit per sample, most significant bit first, so that the buffer
+	 * can be clocked out as is by a peripheral that shifts out bits at 1 / resolution, such as
+	 * the MOSI line of an SPI bus (see SpiWaveform). Without such a peripheral, GpioPin::waveform()
+	 * plays it on a pin.
+	 *
+	 * Every pulse is rounded to the nearest number of samples, so the resolution should be well
+	 * within the timing tolerance of the receiver. For WS2812 LEDs a resolution of 416 ns
+	 * (2.4 MHz) encodes each bit in three samples.
+	 */
+	class Waveform {
+	public:
+		explicit Waveform(uint32_t resolution);
+
+		void clear();
+		void reserve(size_t samples);
+
+		/**
+		 * @brief Append a pulse of \p ns nanoseconds at \p level.
+		 */
+		void append(bool level, uint32_t ns);
+
+		/**
+		 * @brief Append \p data, most significant bit first, as a symbol per bit.
+		 */
+		void encode(const uint8_t *data, size_t length, const WaveformSymbol& zero, const WaveformSymbol& one);
+
+		bool sample(size_t idx) const;
+		size_t samples() const;
+
+		const uint8_t *data() const;
+		size_t size() const; //!< Number of bytes in data().
+
+		uint32_t resolution() const;
+
+		static constexpr WaveformSymbol Ws2812Zero = { 400, 850 };
+		static constexpr WaveformSymbol Ws2812One = { 800, 450 };
+
+	private:
+		stl::Vector<uint8_t> _buffer;
+		size_t _samples;
+		uint32_t _resolution;
+	};
+}
@@ -8,16 +8,249 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 #include <lwiot.h>
 
-#ifdef HAVE_SYNC_FETCH
-#include <lwiot/detail/atomic_sync.h>
-#else
+#include <lwiot/traits/isintegral.h>
+#include <lwiot/traits/typechoice.h>
+
+#include <lwiot/detail/memory_order.h>
 #include <lwiot/detail/atomic_crit.h>
+
+#ifdef __ATOMIC_SEQ_CST
+#include <lwiot/detail/atomic_sync.h>
 #endif
 
 namespace lwiot
 {
+	namespace detail
+	{
+		template <typename T>
+		struct AtomicTraits {
+			static_assert(traits::IsIntegral<T>::value, "Atomic only works for integral and pointer types!");
+
+			typedef T difference_type;
+			static constexpr size_t scale = 1;
+		};
+
+		template <typename T>
+		struct AtomicTraits<T*> {
+			typedef ptrdiff_t difference_type;
+			static constexpr size_t scale = sizeof(T);
+		};
+
+		template <>
+		struct AtomicTraits<void*> {
+			typedef ptrdiff_t difference_type;
+			static constexpr size_t scale = 1;
+		};
+
+		template <>
+		struct AtomicTraits<const void*> {
+			typedef ptrdiff_t difference_type;
+			static constexpr size_t scale = 1;
+		};
+
+		/*
+		 * Select the builtin operations when the compiler can implement them with native,
+		 * lock free instructions for this size. Otherwise fall back to critical sections.
+		 */
+		template <typename T>
+		struct AtomicOps {
+#ifdef __ATOMIC_SEQ_CST
+			typedef typename traits::TypeChoice<__atomic_always_lock_free(sizeof(T), 0),
+				BuiltinAtomic<T, typename AtomicTraits<T>::difference_type, AtomicTraits<T>::scale>,
+				CriticalAtomic<T, typename AtomicTraits<T>::difference_type>>::type type;
+#else
+			typedef CriticalAtomic<T, typename AtomicTraits<T>::difference_type> type;
+#endif
+		};
+
+		template <typename T>
+		class Atomic {
+			typedef typename AtomicOps<T>::type Ops;
+
+		public:
+			typedef T value_type;
+			typedef typename AtomicTraits<T>::difference_type difference_type;
+
+			static constexpr bool is_always_lock_free = Ops::lock_free;
+
+			constexpr Atomic() : _value() { }
+
+			explicit constexpr Atomic(T value) : _value(value) { }
+
+			Atomic(const Atomic& value) : _value(value.load())
+			{ }
+
+			Atomic(Atomic&& value) noexcept : _value(value.load())
+			{ }
+
+			Atomic& operator=(const Atomic& value)
+			{
+				this->store(value.load());
+				return *this;
+			}
+
+			Atomic& operator=(Atomic&& value) noexcept
+			{
+				this->store(value.load());
+				return *this;
+			}
+
+			Atomic& operator=(T value) noexcept
+			{
+				this->store(value);
+				return *this;
+			}
+
+			bool is_lock_free() const
+			{
+				return is_always_lock_free;
+			}
+
+			T load(memory_order order = memory_order_seq_cst) const
+			{
+				return Ops::load(this->_value, order);
+			}
+
+			void store(T value, memory_order order = memory_order_seq_cst)
+			{
+				Ops::store(this->_value, value, order);
+			}
+
+			T exchange(T value, memory_order order = memory_order_seq_cst)
+			{
+				return Ops::exchange(this->_value, value, order);
+			}
+
+			/*
+			 * On failure, expected is updated with the current value. The weak forms may
+			 * fail spuriously, so use them in a loop.
+			 */
+			bool compare_exchange_weak(T& expected, T desired, memory_order success, memory_order failure)
+			{
+				return Ops::compare_exchange(this->_value, expected, desired, true, success, failure);
+			}
+
+			bool compare_exchange_weak(T& expected, T desired, memory_order order = memory_order_seq_cst)
+			{
+				return this->compare_exchange_weak(expected, desired, order, failure_order(order));
+			}
+
+			bool compare_exchange_strong(T& expected, T desired, memory_order success, memory_order failure)
+			{
+				return Ops::compare_exchange(this->_value, expected, desired, false, success, failure);
+			}
+
+			bool compare_exchange_strong(T& expected, T desired, memory_order order = memory_order_seq_cst)
+			{
+				return this->compare_exchange_strong(expected, desired, order, failure_order(order));
+			}
+
+			T fetch_add(difference_type value, memory_order order = memory_order_seq_cst)
+			{
+				return Ops::fetch_add(this->_value, value, order);
+			}
+
+			T fetch_sub(difference_type value, memory_order order = memory_order_seq_cst)
+			{
+				return Ops::fetch_sub(this->_value, value, order);
+			}
+
+			T fetch_and(T value, memory_order order = memory_order_seq_cst)
+			{
+				return Ops::fetch_and(this->_value, value, order);
+			}
+
+			T fetch_or(T value, memory_order order = memory_order_seq_cst)
+			{
+				return Ops::fetch_or(this->_value, value, order);
+			}
+
+			T fetch_xor(T value, memory_order order = memory_order_seq_cst)
+			{
+				return Ops::fetch_xor(this->_value, value, order);
+			}
+
+			explicit operator T() const
+			{
+				return this->load();
+			}
+
+			bool operator==(const Atomic& other) const
+			{
+				return this->load() == other.load();
+			}
+
+			bool operator!=(const Atomic& other) const
+			{
+				return this->load() != other.load();
+			}
+
+			T operator++()
+			{
+				return this->fetch_add(1) + 1;
+			}
+
+			T operator++(int)
+			{
+				return this->fetch_add(1);
+			}
+
+			T operator--()
+			{
+				return this->fetch_sub(1) - 1;
+			}
+
+			T operator--(int)
+			{
+				return this->fetch_sub(1);
+			}
+
+			T operator+=(difference_type v)
+			{
+				return this->fetch_add(v) + v;
+			}
+
+			T operator-=(difference_type v)
+			{
+				return this->fetch_sub(v) - v;
+			}
+
+			T operator&=(T v)
+			{
+				return this->fetch_and(v) & v;
+			}
+
+			T operator|=(T v)
+			{
+				return this->fetch_or(v) | v;
+			}
+
+			T operator^=(T v)
+			{
+				return this->fetch_xor(v) ^ v;
+			}
+
+		private:
+			T _value;
+		};
+	}
+
+	template <typename T>
+	using Atomic = detail::Atomic<T>;
+
+	static inline void atomic_thread_fence(memory_order order)
+	{
+#ifdef __ATOMIC_SEQ_CST
+		__atomic_thread_fence(order);
+#else
+		enter_critical();
+		exit_critical();
+#endif
+	}
+
 	typedef lwiot::Atomic<uint8_t> atomic_uint8_t;
 	typedef lwiot::Atomic<uint16_t> atomic_uint16_t;
 	typedef lwiot::Atomic<uint32_t> atomic_uint32_t;
@@ -0,0 +1,170 @@
+/*
+ * Parallel start up of components with dependencies.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/log.h>
+
+#include <lwiot/kernel/executor.h>
+#include <lwiot/kernel/event.h>
+#include <lwiot/kernel/lock.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/vector.h>
+
+namespace lwiot
+{
+	enum class BootStatus {
+		Pending, //!< Not started yet, or lazy and not required yet.
+		Running,
+		Done,
+		Failed, //!< The initializer returned false.
+		Skipped //!< A dependency failed.
+	};
+
+	/**
+	 * @brief Start up timing of a component.
+	 */
+	struct BootStep {
+		String name;
+		BootStatus status;
+		uint64_t queued; //!< Nanoseconds after start() at which the dependencies were done.
+		uint64_t started; //!< Nanoseconds after start() at which the initializer started.
+		uint64_t duration; //!< Run time of the initializer in nanoseconds.
+	};
+
+	/**
+	 * @brief Initialize components in parallel, in the order of their dependencies.
+	 *
+	 * Each component has an initializer, such as connecting to a network or calling begin() on
+	 * a sensor, and names the components it depends on. start() posts every component whose
+	 * dependencies are done to the executor, so independent components, like a sensor that
+	 * waits for its warm up and a Wi-Fi connection, start at the same time. The more workers
+	 * the executor has, the more initializers run in parallel.
+	 *
+	 * Lazy components are left alone by start(). They are initialized by the first require(),
+	 * or when a component that is not lazy depends on them. A component whose initializer
+	 * fails, or returns false, fails the components that depend on it.
+	 *
+	 * @code
+	 * lwiot::BootSequence boot(executor);
+	 *
+	 * boot.add("wifi", [&]() { return station.connect(ssid, password); });
+	 * boot.add("sensor", [&]() { return sensor.begin(); });
+	 * boot.add("mqtt", [&]() { return client.connect(); }).after("mqtt", "wifi");
+	 * boot.add("ota", [&]() { return ota.begin(); }, true).after("ota", "wifi");
+	 *
+	 * boot.start();
+	 * boot.wait();
+	 * boot.report(logger);
+	 * @endcode
+	 *
+	 * Spans are recorded for the Tracer when built with CONFIG_TRACE.
+	 */
+	class BootSequence {
+	public:
+		typedef Function<bool(void)> Initializer;
+
+		explicit BootSequence(Executor& executor);
+		virtual ~BootSequence();
+
+		BootSequence(const BootSequence&) = delete;
+		BootSequence& operator=(const BootSequence&) = delete;
+
+		/**
+		 * @brief Declare a component.
+		 * @param name Unique name of the component.
+		 * @param init Initializer; returns false if the component failed to start.
+		 * @param lazy Only initialize the component when it is required.
+		 * @note Components are declared before start() is called.
+		 */
+		BootSequence& add(const String& name, const Initializer& init, bool lazy = false);
+
+		/**
+		 * @brief Initialize \p name only after \p dependency is done.
+		 *
+		 * If \p name was not added, start() fails.
+		 */
+		BootSequence& after(const String& name, const String& dependency);
+
+		/**
+		 * @brief Start initializing all components that are not lazy.
+		 * @return False if a component or dependency is unknown or dependencies form a cycle.
+		 */
+		bool start();
+
+		/**
+		 * @brief Wait until the components that were started are done or failed.
+		 * @param tmo Timeout in milliseconds.
+		 * @return True if all of them are done.
+		 */
+		bool wait(int tmo = FOREVER);
+
+		/**
+		 * @brief Initialize a component, and its dependencies, if that did not happen yet.
+		 * @param tmo Timeout in milliseconds.
+		 * @return True if the component is done.
+		 * @note An initializer that requires another component occupies a worker while it
+		 *       waits, so the executor needs a worker to spare.
+		 */
+		bool require(const String& name, int tmo = FOREVER);
+
+		BootStatus status(const String& name) const;
+
+		/**
+		 * @brief Timing of the components, in the order they were declared.
+		 */
+		stl::Vector<BootStep> steps() const;
+
+		/**
+		 * @brief Time from start() until the last initializer finished, in nanoseconds.
+		 */
+		uint64_t elapsed() const;
+
+		/**
+		 * @brief Log the timing of each component.
+		 */
+		void report(Logger& logger) const;
+
+	private:
+		struct Component {
+			String name;
+			Initializer init;
+			bool lazy;
+			bool wanted;
+			BootStatus status;
+			stl::Vector<String> after;
+			stl::Vector<size_t> dependencies;
+			uint64_t queued;
+			uint64_t started;
+			uint64_t finished;
+		};
+
+		Executor& _executor;
+		mutable Lock _lock;
+		Event _done;
+		bool _started;
+		bool _unknown;
+		uint64_t _epoch;
+		uint64_t _last;
+		stl::Vector<Component*> _components;
+
+		int find(const String& name) const;
+		bool prepare();
+		bool acyclic(size_t idx, stl::Vector<uint8_t>& marks) const;
+		void want(size_t idx);
+		void dispatch();
+		void run(size_t idx);
+		bool finished(size_t idx) const;
+	};
+}
@@ -0,0 +1,48 @@
+/*
+ * Monotonic clock definition.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Monotonic, high resolution clock.
+	 *
+	 * The clock does not follow changes of the wall clock time. Its resolution depends on the
+	 * port: ports that provide lwiot_tick_ns() (HAVE_TICK_NS) offer nanoseconds, the others fall
+	 * back to the microsecond resolution of lwiot_tick().
+	 */
+	class Clock {
+	public:
+		/**
+		 * @brief Current time in nanoseconds.
+		 * @note The epoch is unspecified, only differences between two values are meaningful.
+		 */
+		static inline uint64_t now()
+		{
+#ifdef HAVE_TICK_NS
+			return lwiot_tick_ns();
+#else
+			return static_cast<uint64_t>(lwiot_tick()) * 1000ULL;
+#endif
+		}
+
+		static inline uint64_t nowUs()
+		{
+			return Clock::now() / 1000ULL;
+		}
+
+		static inline uint64_t nowMs()
+		{
+			return Clock::now() / 1000000ULL;
+		}
+	};
+}
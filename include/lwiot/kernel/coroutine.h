@@ -0,0 +1,322 @@
+/*
+ * Stackless coroutines.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/stream.h>
+#include <lwiot/scopedlock.h>
+
+#include <lwiot/kernel/executor.h>
+#include <lwiot/kernel/event.h>
+#include <lwiot/kernel/lock.h>
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+#define HAVE_COROUTINES 1
+#include <coroutine>
+#endif
+
+#ifndef CONFIG_COROUTINE_POLL_INTERVAL
+#define CONFIG_COROUTINE_POLL_INTERVAL 10
+#endif
+
+/**
+ * @brief Start the body of Coroutine::run().
+ * @note The LWIOT_CO_* macros expand to case labels, so only one can be used per line and they
+ *       cannot be used inside a switch statement. Local variables do not survive a suspension;
+ *       keep state in members instead.
+ */
+#define LWIOT_CO_BEGIN() switch(this->_co_line) { case 0:
+
+/**
+ * @brief End the body of Coroutine::run().
+ */
+#define LWIOT_CO_END() } this->_co_line = 0; return lwiot::CoroutineState::Done
+
+/**
+ * @brief Give other coroutines a chance to run.
+ */
+#define LWIOT_CO_YIELD() \
+	do { \
+		this->_co_line = __LINE__; \
+		return lwiot::CoroutineState::Yielded; \
+		case __LINE__: ; \
+	} while(0)
+
+/**
+ * @brief Wait for the condition set by Coroutine::sleep() or Coroutine::waitReadable().
+ */
+#define LWIOT_CO_WAIT() \
+	do { \
+		this->_co_line = __LINE__; \
+		case __LINE__: \
+		if(!this->poll()) \
+			return lwiot::CoroutineState::Waiting; \
+	} while(0)
+
+/**
+ * @brief Suspend for \p ms milliseconds.
+ */
+#define LWIOT_CO_SLEEP(ms) do { this->sleep(ms); LWIOT_CO_WAIT(); } while(0)
+
+/**
+ * @brief Suspend until \p stream has \p bytes available, or \p tmo milliseconds have passed.
+ * @see Coroutine::timedOut()
+ */
+#define LWIOT_CO_READABLE(stream, bytes, tmo) do { this->waitReadable(stream, bytes, tmo); LWIOT_CO_WAIT(); } while(0)
+
+namespace lwiot
+{
+	enum class CoroutineState {
+		Yielded,
+		Waiting,
+		Done
+	};
+
+	/**
+	 * @brief Stackless coroutine.
+	 *
+	 * Coroutines are resumed as tasks on an executor, which allows a single worker thread to
+	 * serve many connections without a stack per connection. Implementations write run() as a
+	 * protothread using the LWIOT_CO_* macros. When the compiler supports C++20 coroutines,
+	 * AsyncCoroutine can be used to run a co_await based function instead.
+	 *
+	 * Timers wake a coroutine when they expire. Streams do not provide readiness notifications,
+	 * so a coroutine waiting for a stream polls it every CONFIG_COROUTINE_POLL_INTERVAL ms.
+	 */
+	class Coroutine {
+	public:
+		explicit Coroutine();
+		explicit Coroutine(const Coroutine&) = delete;
+		virtual ~Coroutine() = default;
+
+		Coroutine& operator=(const Coroutine&) = delete;
+
+		/**
+		 * @brief Start the coroutine.
+		 * @param executor Executor to resume the coroutine on.
+		 * @return True if the coroutine was started.
+		 * @note The coroutine must outlive its execution.
+		 */
+		bool start(Executor& executor);
+
+		bool done() const;
+
+		/**
+		 * @brief Wait for the coroutine to finish.
+		 * @param tmo Timeout in milliseconds.
+		 * @return True if the coroutine has finished.
+		 */
+		bool join(int tmo = FOREVER);
+
+		/* Wait conditions, used through the LWIOT_CO_* macros or co_await. */
+		void sleep(int ms);
+		void waitReadable(const Stream& stream, size_t bytes = 1, int tmo = FOREVER);
+		bool poll();
+
+		/**
+		 * @brief Check whether the last wait for a stream ended due to a timeout.
+		 */
+		bool timedOut() const;
+
+	protected:
+		int _co_line;
+
+		/**
+		 * @brief Coroutine body.
+		 * @return The state of the coroutine.
+		 */
+		virtual CoroutineState run() = 0;
+
+	private:
+		mutable Lock _lock;
+		Event _event;
+		Executor* _executor;
+		bool _done;
+
+		const Stream* _stream;
+		size_t _bytes;
+		time_t _deadline;
+		bool _timedout;
+
+		/* Methods */
+		void resume();
+		int delay(time_t now) const;
+	};
+
+#ifdef HAVE_COROUTINES
+	/**
+	 * @brief Return type of functions that can be run by an AsyncCoroutine.
+	 *
+	 * @code
+	 * lwiot::Async echo(lwiot::TcpClient& client)
+	 * {
+	 *     while(co_await lwiot::readable(client, 1, 5000))
+	 *         client.write(client.read());
+	 * }
+	 * @endcode
+	 */
+	class Async {
+	public:
+		struct promise_type {
+			Coroutine* owner = nullptr;
+			CoroutineState state = CoroutineState::Yielded;
+
+			Async get_return_object()
+			{
+				return Async(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+
+			std::suspend_always initial_suspend() noexcept
+			{
+				return {};
+			}
+
+			std::suspend_always final_suspend() noexcept
+			{
+				return {};
+			}
+
+			void return_void()
+			{
+			}
+
+			void unhandled_exception()
+			{
+				panic("Unhandled exception in coroutine!\n");
+			}
+		};
+
+		typedef std::coroutine_handle<promise_type> Handle;
+
+		Async(Async&& other) noexcept : _handle(other._handle)
+		{
+			other._handle = nullptr;
+		}
+
+		Async(const Async&) = delete;
+		Async& operator=(const Async&) = delete;
+
+		~Async()
+		{
+			if(this->_handle)
+				this->_handle.destroy();
+		}
+
+		Handle handle() const
+		{
+			return this->_handle;
+		}
+
+	private:
+		Handle _handle;
+
+		explicit Async(Handle handle) : _handle(handle)
+		{
+		}
+	};
+
+	class AsyncCoroutine : public Coroutine {
+	public:
+		explicit AsyncCoroutine(Async&& async);
+
+	protected:
+		CoroutineState run() override;
+
+	private:
+		Async _async;
+	};
+
+	namespace detail
+	{
+		struct SleepAwaiter {
+			int ms;
+
+			bool await_ready() const noexcept
+			{
+				return this->ms <= 0;
+			}
+
+			void await_suspend(Async::Handle handle)
+			{
+				handle.promise().owner->sleep(this->ms);
+				handle.promise().state = CoroutineState::Waiting;
+			}
+
+			void await_resume() const noexcept
+			{
+			}
+		};
+
+		struct ReadableAwaiter {
+			const Stream& stream;
+			size_t bytes;
+			int tmo;
+			Coroutine* owner;
+
+			bool await_ready() const
+			{
+				return this->stream.available() >= this->bytes;
+			}
+
+			void await_suspend(Async::Handle handle)
+			{
+				this->owner = handle.promise().owner;
+				this->owner->waitReadable(this->stream, this->bytes, this->tmo);
+				handle.promise().state = CoroutineState::Waiting;
+			}
+
+			bool await_resume() const
+			{
+				return this->owner == nullptr || !this->owner->timedOut();
+			}
+		};
+
+		struct YieldAwaiter {
+			bool await_ready() const noexcept
+			{
+				return false;
+			}
+
+			void await_suspend(Async::Handle handle) noexcept
+			{
+				handle.promise().state = CoroutineState::Yielded;
+			}
+
+			void await_resume() const noexcept
+			{
+			}
+		};
+	}
+
+	/**
+	 * @brief Suspend the calling coroutine for \p ms milliseconds.
+	 */
+	static inline detail::SleepAwaiter sleepFor(int ms)
+	{
+		return detail::SleepAwaiter{ms};
+	}
+
+	/**
+	 * @brief Suspend until \p stream has \p bytes available.
+	 * @return An awaitable that yields false when \p tmo milliseconds have passed first.
+	 */
+	static inline detail::ReadableAwaiter readable(const Stream& stream, size_t bytes = 1, int tmo = FOREVER)
+	{
+		return detail::ReadableAwaiter{stream, bytes, tmo, nullptr};
+	}
+
+	static inline detail::YieldAwaiter yield()
+	{
+		return detail::YieldAwaiter{};
+	}
+#endif
+}
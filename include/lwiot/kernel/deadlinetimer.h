@@ -0,0 +1,71 @@
+/*
+ * Busy-wait deadline timer definition.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Wait for an absolute point in time, measured on the delay counter.
+	 *
+	 * Waiting for absolute deadlines does not accumulate the time spent between delays, as a
+	 * sequence of lwiot_udelay() calls does. This makes it suitable for bit-banged protocol timing:
+	 * take a deadline at the start of a slot, do the work and wait for the end of the slot.
+	 *
+	 * @note DeadlineTimer busy-waits and does not give the CPU away.
+	 * @see lwiot_delay_counter
+	 */
+	class DeadlineTimer {
+	public:
+		explicit DeadlineTimer() : _deadline(lwiot_delay_counter())
+		{
+		}
+
+		/**
+		 * @brief Expire after \p ns nanoseconds from now.
+		 */
+		inline void expiresAfter(uint32_t ns)
+		{
+			this->_deadline = lwiot_delay_counter() + lwiot_delay_ns_to_cycles(ns);
+		}
+
+		/**
+		 * @brief Move the deadline \p ns nanoseconds past the previous deadline.
+		 */
+		inline void extend(uint32_t ns)
+		{
+			this->_deadline += lwiot_delay_ns_to_cycles(ns);
+		}
+
+		inline void expiresAt(uint64_t cycles)
+		{
+			this->_deadline = cycles;
+		}
+
+		inline uint64_t deadline() const
+		{
+			return this->_deadline;
+		}
+
+		inline bool expired() const
+		{
+			return static_cast<int64_t>(this->_deadline - lwiot_delay_counter()) <= 0;
+		}
+
+		inline void wait() const
+		{
+			lwiot_delay_until(this->_deadline);
+		}
+
+	private:
+		uint64_t _deadline;
+	};
+}
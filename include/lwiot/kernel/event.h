@@ -14,11 +14,47 @@
 #include <lwiot/kernel/uniquelock.h>
 
 #include <lwiot/scopedlock.h>
+#include <lwiot/stl/vector.h>
+
+#ifndef CONFIG_EVENT_WAIT_MAX
+#define CONFIG_EVENT_WAIT_MAX 8
+#endif
 
 namespace lwiot {
+	enum class EventType {
+		Binary,
+		Counting
+	};
+
+	/**
+	 * @brief Wait queue.
+	 *
+	 * A binary event wakes one waiter per signal and discards signals nobody waits for. A
+	 * counting event works like a semaphore: signals that nobody waits for are stored, up to
+	 * a maximum, and consumed by later waits. broadcast() wakes every waiter, and waitAny()
+	 * waits for any one of a set of events.
+	 *
+	 * Waiters are queued in FIFO order and each waiting thread parks on a port event of its
+	 * own. Those are pooled per event, so waiting does not allocate in the steady state.
+	 *
+	 * @note Event(int) creates a binary event; the length argument is unused.
+	 */
 	class Event {
+	private:
+		struct WaitNode {
+			WaitNode* next;
+			WaitNode* prev;
+			lwiot_event_t* parker;
+			int* fired;
+			int index;
+			uint32_t sequence;
+			bool multi;
+			bool queued;
+		};
+
 	public:
 		explicit Event(int length = 4);
+		explicit Event(EventType type, int max = 1);
 		explicit Event(const Event& event) = delete;
 		Event(Event&& event) noexcept ;
 		virtual ~Event();
@@ -26,8 +62,6 @@ namespace lwiot {
 		Event& operator=(const Event& rhs) = delete;
 		Event& operator=(Event&& rhs) noexcept ;
 
-		const lwiot_event_t* getEvent() const;
-
 		void wait();
 		bool wait(int tmo);
 		bool wait(ScopedLock& guard, int tmo = FOREVER);
@@ -35,20 +69,58 @@ namespace lwiot {
 		template <typename T>
 		bool wait(UniqueLock<T>& guard, int tmo = FOREVER)
 		{
+			WaitNode node;
+			int fired = -1;
+
+			if(this->enqueue(node, &fired, 0, nullptr))
+				return true;
+
 			guard.unlock();
-			auto rv = this->wait(tmo);
+			auto rv = this->park(node, tmo);
 			guard.lock();
 
 			return rv;
 		}
 
+		/**
+		 * @brief Wait for any of \p events to be signalled.
+		 * @param events Events to wait for.
+		 * @param num Number of events, at most CONFIG_EVENT_WAIT_MAX.
+		 * @param tmo Timeout in milliseconds.
+		 * @return The index of the event that woke the caller, -ETMO on timeout or -EINVALID
+		 *         when \p num is out of range.
+		 * @note A single signal wakes at most one waiter; it is never consumed twice.
+		 */
+		static int waitAny(Event* events[], size_t num, int tmo = FOREVER);
 
 		void signalFromIrq();
 		void signal();
 
+		/**
+		 * @brief Wake all current waiters.
+		 */
+		void broadcast();
+
 	private:
-		lwiot_event_t* _event;
-		int _waiters;
-		Lock _lock;
+		mutable Lock _lock;
+		stl::Vector<lwiot_event_t*> _parkers;
+
+		WaitNode* _head;
+		WaitNode* _tail;
+		uint32_t _sequence;
+
+		EventType _type;
+		int _count;
+		int _max;
+
+		/* Methods */
+		bool enqueue(WaitNode& node, int* fired, int index, lwiot_event_t* parker);
+		bool park(WaitNode& node, int tmo);
+		void unlink(WaitNode& node);
+		lwiot_event_t* wake(const uint32_t* limit);
+		void lockState() const;
+		void unlockState() const;
+		lwiot_event_t* takeParker();
+		void releaseParker(lwiot_event_t* parker);
 	};
 }
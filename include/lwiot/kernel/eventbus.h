@@ -0,0 +1,338 @@
+/*
+ * Typed publish/subscribe event bus.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/sharedpointer.h>
+
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/executor.h>
+#include <lwiot/kernel/thread.h>
+#include <lwiot/kernel/lock.h>
+
+#include <lwiot/detail/boundedqueue.h>
+#include <lwiot/stl/forward.h>
+
+#ifndef CONFIG_EVENTBUS_SUBSCRIBERS
+#define CONFIG_EVENTBUS_SUBSCRIBERS 8
+#endif
+
+#ifndef CONFIG_EVENTBUS_QUEUE_DEPTH
+#define CONFIG_EVENTBUS_QUEUE_DEPTH 8
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Base of topic types. A topic is a type, so publishing the wrong message type to it
+	 *        does not compile.
+	 *
+	 * @code
+	 * struct Temperature : public lwiot::Topic<Measurement> { };
+	 * @endcode
+	 */
+	template <typename T>
+	struct Topic {
+		typedef T Message;
+	};
+
+	/**
+	 * @brief What a queued subscriber does with a message when its queue is full.
+	 */
+	enum class EventOverflow {
+		Reject, //!< Refuse the new message; the publisher sees it was not delivered.
+		DropOldest //!< Replace the oldest message that was not handled yet.
+	};
+
+	namespace detail
+	{
+		class EventSubscriber {
+		public:
+			virtual ~EventSubscriber() = default;
+
+			/* Returns false if the message, a SharedPointer to the topic message, was not taken. */
+			virtual bool deliver(const void *message) = 0;
+		};
+
+		/* The address of id identifies the topic. */
+		template <typename T>
+		struct TopicTag {
+			static const char id;
+		};
+
+		template <typename T>
+		const char TopicTag<T>::id = 0;
+	}
+
+	/**
+	 * @brief In-process publish/subscribe bus.
+	 *
+	 * Messages are passed as SharedPointer references, so every subscriber sees the same object
+	 * and nothing is copied. Subscribers should treat messages as immutable.
+	 *
+	 * Publishing does not lock: the subscribers of a topic are kept in a fixed array of
+	 * CONFIG_EVENTBUS_SUBSCRIBERS atomic slots, and subscribers that leave wait for the
+	 * publishers that may still see them, using two reader counters that are swapped on every
+	 * change. Subscribing and unsubscribing take a lock.
+	 *
+	 * Subscriber objects handle messages synchronously, in the thread of the publisher.
+	 * QueuedSubscriber objects put them on a lock free queue and handle them on an Executor.
+	 *
+	 * @note Subscribers must not be destroyed from one of their own handlers, and must be
+	 *       destroyed before the bus.
+	 */
+	class EventBus {
+	public:
+		explicit EventBus();
+		~EventBus();
+
+		EventBus(const EventBus&) = delete;
+		EventBus& operator=(const EventBus&) = delete;
+
+		/**
+		 * @brief Publish \p message on \p TopicType.
+		 * @return The number of subscribers that accepted the message.
+		 */
+		template <typename TopicType>
+		size_t publish(const SharedPointer<typename TopicType::Message>& message)
+		{
+			return this->dispatch(&detail::TopicTag<TopicType>::id, &message);
+		}
+
+		/**
+		 * @brief Create a message from \p args and publish it.
+		 * @return The number of subscribers that accepted the message.
+		 */
+		template <typename TopicType, typename... Args>
+		size_t emit(Args&&... args)
+		{
+			auto message = makeShared<typename TopicType::Message>(stl::forward<Args>(args)...);
+			return this->publish<TopicType>(message);
+		}
+
+		template <typename TopicType>
+		size_t subscribers() const
+		{
+			return this->count(&detail::TopicTag<TopicType>::id);
+		}
+
+	private:
+		struct Channel {
+			explicit Channel(const void *topic) : topic(topic), next(nullptr), slots()
+			{
+			}
+
+			const void *topic;
+			Channel *next;
+			Atomic<detail::EventSubscriber*> slots[CONFIG_EVENTBUS_SUBSCRIBERS];
+		};
+
+		Lock _lock;
+		Atomic<Channel*> _channels;
+		Atomic<long> _epoch;
+		Atomic<long> _readers[2];
+
+		template <typename TopicType>
+		friend class Subscriber;
+
+		template <typename TopicType, size_t Depth>
+		friend class QueuedSubscriber;
+
+		bool attach(const void *topic, detail::EventSubscriber *subscriber);
+		void detach(const void *topic, detail::EventSubscriber *subscriber);
+		size_t dispatch(const void *topic, const void *message);
+		size_t count(const void *topic) const;
+		Channel *find(const void *topic) const;
+		void synchronize();
+	};
+
+	/**
+	 * @brief Subscriber that handles messages in the thread that publishes them.
+	 */
+	template <typename TopicType>
+	class Subscriber : private detail::EventSubscriber {
+	public:
+		typedef typename TopicType::Message Message;
+		typedef Function<void(const SharedPointer<Message>&)> Handler;
+
+		explicit Subscriber(EventBus& bus, const Handler& handler) : _bus(bus), _handler(handler)
+		{
+			this->_subscribed = bus.attach(&detail::TopicTag<TopicType>::id, this);
+		}
+
+		~Subscriber() override
+		{
+			if(this->_subscribed)
+				this->_bus.detach(&detail::TopicTag<TopicType>::id, this);
+		}
+
+		Subscriber(const Subscriber&) = delete;
+		Subscriber& operator=(const Subscriber&) = delete;
+
+		/**
+		 * @brief False if the topic already had CONFIG_EVENTBUS_SUBSCRIBERS subscribers.
+		 */
+		bool subscribed() const
+		{
+			return this->_subscribed;
+		}
+
+	private:
+		EventBus& _bus;
+		Handler _handler;
+		bool _subscribed;
+
+		bool deliver(const void *message) override
+		{
+			this->_handler(*static_cast<const SharedPointer<Message> *>(message));
+			return true;
+		}
+	};
+
+	/**
+	 * @brief Subscriber that queues messages and handles them on an executor.
+	 *
+	 * Up to \p Depth messages, a power of two, are queued without allocating. When the queue is
+	 * full, the overflow policy decides between refusing new messages and dropping old ones;
+	 * either way dropped() counts them, so a slow consumer pushes back on its publishers instead
+	 * of growing a queue. Messages are handled one at a time and in order.
+	 */
+	template <typename TopicType, size_t Depth = CONFIG_EVENTBUS_QUEUE_DEPTH>
+	class QueuedSubscriber : private detail::EventSubscriber {
+	public:
+		typedef typename TopicType::Message Message;
+		typedef Function<void(const SharedPointer<Message>&)> Handler;
+
+		explicit QueuedSubscriber(EventBus& bus, Executor& executor, const Handler& handler,
+		                          EventOverflow overflow = EventOverflow::Reject) :
+			_bus(bus), _executor(executor), _overflow(overflow), _state(makeShared<State>(handler))
+		{
+			this->_subscribed = bus.attach(&detail::TopicTag<TopicType>::id, this);
+		}
+
+		/**
+		 * @brief Unsubscribe. Queued messages are discarded; a handler that is running is waited for.
+		 */
+		~QueuedSubscriber() override
+		{
+			if(this->_subscribed)
+				this->_bus.detach(&detail::TopicTag<TopicType>::id, this);
+
+			this->_state->close();
+		}
+
+		QueuedSubscriber(const QueuedSubscriber&) = delete;
+		QueuedSubscriber& operator=(const QueuedSubscriber&) = delete;
+
+		bool subscribed() const
+		{
+			return this->_subscribed;
+		}
+
+		size_t pending() const
+		{
+			return this->_state->ready.size();
+		}
+
+		uint32_t dropped() const
+		{
+			return this->_state->dropped.load();
+		}
+
+	private:
+		typedef SharedPointer<Message> Slot;
+
+		/* Shared with the tasks on the executor, which may outlive the subscriber. */
+		struct State {
+			explicit State(const Handler& handler) : handler(handler), scheduled(0), active(0), closed(0), dropped(0)
+			{
+				for(auto& slot : this->slots)
+					this->free.push(&slot);
+			}
+
+			Handler handler;
+			Slot slots[Depth];
+			detail::BoundedQueue<Slot, Depth> free;
+			detail::BoundedQueue<Slot, Depth> ready;
+			Atomic<int> scheduled;
+			Atomic<int> active;
+			Atomic<int> closed;
+			Atomic<uint32_t> dropped;
+
+			void drain()
+			{
+				Slot *slot;
+
+				this->active.fetch_add(1);
+
+				while(this->closed.load() == 0) {
+					while(this->closed.load() == 0 && (slot = this->ready.pop()) != nullptr) {
+						this->handler(*slot);
+						slot->reset();
+						this->free.push(slot);
+					}
+
+					/* Messages queued after the last pop, but before the flag was cleared, are ours. */
+					this->scheduled.store(0);
+
+					if(this->ready.size() == 0 || this->scheduled.exchange(1) != 0)
+						break;
+				}
+
+				this->active.fetch_sub(1);
+			}
+
+			void close()
+			{
+				this->closed.store(1);
+
+				while(this->active.load() != 0)
+					Thread::yield();
+			}
+		};
+
+		EventBus& _bus;
+		Executor& _executor;
+		EventOverflow _overflow;
+		SharedPointer<State> _state;
+		bool _subscribed;
+
+		bool deliver(const void *message) override
+		{
+			auto& state = *this->_state;
+			auto slot = state.free.pop();
+
+			if(slot == nullptr) {
+				if(this->_overflow == EventOverflow::DropOldest)
+					slot = state.ready.pop();
+
+				state.dropped.fetch_add(1);
+
+				if(slot == nullptr)
+					return false;
+			}
+
+			*slot = *static_cast<const SharedPointer<Message> *>(message);
+			state.ready.push(slot);
+
+			if(state.scheduled.exchange(1) == 0) {
+				auto shared = this->_state;
+
+				if(!this->_executor.post([shared]() { shared->drain(); }))
+					state.scheduled.store(0);
+			}
+
+			return true;
+		}
+	};
+}
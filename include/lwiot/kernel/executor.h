@@ -0,0 +1,158 @@
+/*
+ * Task executor backed by a fixed pool of worker threads.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/scopedlock.h>
+
+#include <lwiot/kernel/thread.h>
+#include <lwiot/kernel/event.h>
+#include <lwiot/kernel/lock.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/vector.h>
+
+#ifdef CONFIG_WORK_STEALING
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/detail/workdeque.h>
+
+#ifndef CONFIG_EXECUTOR_DEQUE_SIZE
+#define CONFIG_EXECUTOR_DEQUE_SIZE 256
+#endif
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Run tasks on a shared pool of worker threads.
+	 *
+	 * Components that need to do work in the background can post tasks to an executor instead
+	 * of each creating a thread, and thus a stack, of their own. Ready tasks are run in order of
+	 * priority; tasks with an equal priority run in the order they were posted.
+	 *
+	 * @note Tasks should not block for long, as a blocked task occupies a worker. Long running
+	 *       work should be split into steps that reschedule themselves.
+	 *
+	 * When built with CONFIG_WORK_STEALING (the default on hosted platforms), each worker also
+	 * owns a lock free deque. Tasks posted from a task with the default priority are pushed onto
+	 * the deque of the current worker, and idle workers steal from the deques of busy ones. Tasks
+	 * posted from other threads are queued centrally and handed to workers in batches. Priorities
+	 * are only ordered within the central queue.
+	 */
+	class Executor {
+	public:
+		typedef Function<void(void)> Task;
+
+		explicit Executor(const String& name, int workers = 1);
+		explicit Executor(const String& name, int workers, int priority, size_t stacksize);
+		explicit Executor(const Executor&) = delete;
+		virtual ~Executor();
+
+		Executor& operator=(const Executor&) = delete;
+
+		/**
+		 * @brief Start the worker threads.
+		 */
+		void start();
+
+		/**
+		 * @brief Stop the worker threads.
+		 *
+		 * Tasks that are running are completed; queued tasks are discarded.
+		 * @note Do not call this from a task.
+		 */
+		void stop();
+
+		/**
+		 * @brief Queue a task for execution.
+		 * @param task Task to run.
+		 * @param priority Task priority. Higher priorities run first.
+		 * @return True if the task was queued.
+		 */
+		bool post(const Task& task, int priority = 0);
+
+		/**
+		 * @brief Queue a task for delayed execution.
+		 * @param ms Delay in milliseconds.
+		 * @param task Task to run.
+		 * @param priority Task priority, used once the delay has expired.
+		 * @return True if the task was queued.
+		 */
+		bool schedule(int ms, const Task& task, int priority = 0);
+
+		size_t pending() const;
+		bool running() const;
+
+		size_t workers() const
+		{
+			return this->_workers.size();
+		}
+
+	private:
+		struct Entry {
+			Task task;
+			time_t due;
+			int priority;
+			uint32_t sequence;
+		};
+
+		class Worker : public Thread {
+		public:
+			explicit Worker(const String& name, Executor& executor);
+			explicit Worker(const String& name, int priority, size_t stacksize, Executor& executor);
+
+			bool ownedBy(const Executor* executor) const
+			{
+				return &this->_executor == executor;
+			}
+
+#ifdef CONFIG_WORK_STEALING
+			detail::WorkDeque<Entry, CONFIG_EXECUTOR_DEQUE_SIZE> deque;
+#endif
+
+		protected:
+			void run() override;
+
+		private:
+			Executor& _executor;
+		};
+
+		mutable Lock _lock;
+		Event _event;
+		bool _running;
+		uint32_t _sequence;
+
+#ifdef CONFIG_WORK_STEALING
+		Atomic<int> _idle;
+		static thread_local Worker* _current;
+#endif
+
+		stl::Vector<Entry*> _ready;
+		stl::Vector<Entry*> _delayed;
+		stl::Vector<Worker*> _workers;
+
+		/* Methods */
+		bool enqueue(const Task& task, time_t due, int priority);
+		void promote(time_t now);
+		int timeout(time_t now) const;
+		void work(Worker& worker);
+		void clear();
+
+#ifdef CONFIG_WORK_STEALING
+		bool pushLocal(Entry* entry);
+		Entry* acquire(Worker& worker, time_t now);
+		Entry* steal(const Worker& worker);
+		bool stealable() const;
+		void wakeIdle();
+#endif
+	};
+}
@@ -73,11 +73,6 @@ namespace lwiot
 
 	}
 
-	enum TimerType {
-		Continuous = 0,
-		OneShot = 0x1,
-	};
-
 	template <typename T>
 	class FunctionalTimer : public Timer {
 	private:
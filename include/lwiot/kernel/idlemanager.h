@@ -0,0 +1,115 @@
+/*
+ * Power-aware idle management.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+
+#ifndef CONFIG_IDLE_MIN_SLEEP
+#define CONFIG_IDLE_MIN_SLEEP 2
+#endif
+
+#ifndef CONFIG_IDLE_MAX_SLEEP
+#define CONFIG_IDLE_MAX_SLEEP 1000
+#endif
+
+namespace lwiot
+{
+	struct IdleStatistics {
+		size_t sleeps; //!< Number of times the CPU was put to sleep.
+		size_t skipped; //!< Idle periods that were too short, or held off by a wake lock.
+		size_t early; //!< Sleeps that ended before their deadline, e.g. by an interrupt.
+		time_t asleep; //!< Total time asleep, in milliseconds.
+		time_t latency; //!< Mean time woken up after the deadline, in microseconds.
+		time_t worst; //!< Longest time woken up after the deadline, in microseconds.
+	};
+
+	/**
+	 * @brief Put the CPU to sleep until the next thing it has to do.
+	 *
+	 * The next deadline is the earliest of the running timers, the timed waits on an Event and
+	 * the deadlines that drivers register, such as the wake up of a sleeping radio. Every timed
+	 * Event wait registers itself, so threads that block with a timeout are accounted for
+	 * without further work.
+	 *
+	 * Where the CPU sleeps depends on the port. Ports with a tickless idle, such as FreeRTOS
+	 * with configUSE_TICKLESS_IDLE, call lwiot_idle_enter() and lwiot_idle_exit() around the
+	 * sleep of the idle task. Otherwise the lowest priority thread calls idle(), which enters
+	 * lwiot_light_sleep() on ports that have it (HAVE_LIGHT_SLEEP), for example through
+	 * esp_light_sleep_start(), and sleeps the thread on other ports.
+	 *
+	 * Sleeps are never longer than CONFIG_IDLE_MAX_SLEEP milliseconds, so waits that are not
+	 * known to the manager are late by that much at most. Idle periods shorter than
+	 * CONFIG_IDLE_MIN_SLEEP milliseconds are not worth the wake up and are skipped.
+	 */
+	class IdleManager {
+	public:
+		/**
+		 * @brief Point in time at which the CPU has to be awake.
+		 */
+		class Deadline {
+		public:
+			/**
+			 * @param expiry Tick, in microseconds, of the deadline; 0 for none.
+			 */
+			explicit Deadline(time_t expiry = 0);
+			~Deadline();
+
+			Deadline(const Deadline&) = delete;
+			Deadline& operator=(const Deadline&) = delete;
+
+			void set(time_t expiry);
+			void clear();
+			time_t expiry() const;
+
+		private:
+			friend class IdleManager;
+
+			Deadline *_next;
+			Deadline *_prev;
+			time_t _expiry;
+		};
+
+		/**
+		 * @brief Keeps the CPU awake while it exists, for example while a radio is awake.
+		 */
+		class WakeLock {
+		public:
+			explicit WakeLock();
+			~WakeLock();
+
+			WakeLock(const WakeLock&) = delete;
+			WakeLock& operator=(const WakeLock&) = delete;
+		};
+
+		/**
+		 * @brief Tick, in microseconds, of the earliest deadline; 0 if there is none.
+		 */
+		static time_t next();
+
+		/**
+		 * @brief Sleep until the next deadline.
+		 * @param tmo Longest sleep in milliseconds, or FOREVER.
+		 * @return True if the CPU slept.
+		 */
+		static bool idle(int tmo = FOREVER);
+
+		static IdleStatistics statistics();
+		static void reset();
+
+	private:
+		friend int ::lwiot_idle_enter(int ms);
+		friend void ::lwiot_idle_exit(void);
+
+		static int enter(int ms);
+		static void exit();
+	};
+}
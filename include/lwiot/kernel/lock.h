@@ -20,7 +20,13 @@
 namespace lwiot {
 	class Lock {
 	public:
-		explicit Lock(bool recursive = false);
+		/**
+		 * @brief Create a new lock.
+		 * @param recursive Allow the owner to take the lock more than once.
+		 * @param inherit Boost the owner to the priority of the highest waiting thread, to
+		 *        prevent priority inversion. Ignored by ports that cannot provide it.
+		 */
+		explicit Lock(bool recursive = false, bool inherit = false);
 		virtual ~Lock() = default;
 
 		Lock(Lock &&rhs) noexcept : _mtx(stl::move(rhs._mtx))
@@ -50,57 +56,55 @@ namespace lwiot {
 		struct LockValue {
 		public:
 #ifdef CONFIG_STANDALONE
-			explicit LockValue(bool value) : _lockval(value)
+			explicit LockValue(bool value, bool inherit) : _lockval(value)
 			{
+				UNUSED(inherit);
 			}
 
 			void lock()
 			{
-				bool value = true;
-
-				while(value) {
-					enter_critical();
-					value = this->_lockval;
-					exit_critical();
-
+				/* Without a scheduler only an interrupt can release the lock: poll for it. */
+				while(!this->acquire())
 					lwiot_sleep(1);
-				}
-
-				enter_critical();
-				this->_lockval = true;
-				exit_critical();
 			}
 
 			bool try_lock(int tmo = 100)
 			{
-				bool cache;
+				return this->acquire();
+			}
 
+			void unlock()
+			{
 				enter_critical();
-				cache = this->_lockval;
+				this->_lockval = false;
 				exit_critical();
-
-				if(cache)
-					return false;
-
-				this->lock();
-				return true;
 			}
 
-			void unlock()
+			bool acquire()
 			{
+				bool acquired;
+
 				enter_critical();
-				this->_lockval = false;
+				acquired = !this->_lockval;
+				this->_lockval = true;
 				exit_critical();
+
+				return acquired;
 			}
 
 			bool _lockval;
 #else
-			explicit LockValue(bool recursive) : _lockdepth(0)
+			explicit LockValue(bool recursive, bool inherit) : _lockdepth(0)
 			{
+				uint32_t flags = 0;
+
 				if(recursive)
-					this->_lock = lwiot_mutex_create(MTX_RECURSIVE);
-				else
-					this->_lock = lwiot_mutex_create(0);
+					flags |= MTX_RECURSIVE;
+
+				if(inherit)
+					flags |= MTX_PRIO_INHERIT;
+
+				this->_lock = lwiot_mutex_create(flags);
 			}
 
 			virtual ~LockValue()
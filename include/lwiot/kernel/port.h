@@ -31,6 +31,8 @@ typedef void* lwiot_timer_t;
 #endif
 
 #define MTX_RECURSIVE 1U
+/* Ask for a priority inheriting mutex where the port supports it. */
+#define MTX_PRIO_INHERIT 2U
 
 typedef void (*thread_handle_t)(void *arg);
 
@@ -41,6 +43,7 @@ struct lwiot_thread_attributes {
 
 	int priority;
 	size_t stacksize;
+	uint32_t affinity; /* Bit mask of the cores the thread may run on, 0 for any core. */
 };
 
 extern DLL_EXPORT lwiot_thread_t* lwiot_thread_create(thread_handle_t handle, const char *name, void *arg);
@@ -49,6 +52,28 @@ extern DLL_EXPORT int lwiot_thread_destroy(lwiot_thread_t *tp);
 extern DLL_EXPORT void lwiot_thread_yield();
 extern DLL_EXPORT void lwiot_thread_join(lwiot_thread_t *tp);
 
+#ifdef HAVE_STATIC_THREAD
+/*
+ * Optional: start a thread in caller supplied storage, so that nothing is taken from the heap.
+ * The stack is attrs->stacksize bytes large. The storage must stay valid until the thread
+ * has been destroyed.
+ */
+extern DLL_EXPORT int lwiot_thread_create_static(lwiot_thread_t *tp, const struct lwiot_thread_attributes *attrs,
+	void *stack);
+#endif
+
+#ifdef HAVE_THREAD_STATS
+/* Optional: resource usage of a thread. Values a port cannot measure are left at 0. */
+struct lwiot_thread_stats {
+	size_t stack_size;       /* Stack size in bytes. */
+	size_t stack_free;       /* Least amount of free stack seen so far, in bytes. */
+	uint64_t cpu_time;       /* CPU time in microseconds. */
+	uint32_t switches;       /* Voluntary and involuntary context switches. */
+};
+
+extern DLL_EXPORT int lwiot_thread_stats(lwiot_thread_t *tp, struct lwiot_thread_stats *stats);
+#endif
+
 extern DLL_EXPORT lwiot_event_t* lwiot_event_create(int length);
 extern DLL_EXPORT void  lwiot_event_destroy(lwiot_event_t *e);
 extern DLL_EXPORT void lwiot_event_signal(lwiot_event_t *event);
@@ -56,6 +81,14 @@ extern DLL_EXPORT int lwiot_event_wait(lwiot_event_t *event, int tmo);
 extern DLL_EXPORT void lwiot_event_signal_irq(lwiot_event_t *event);
 
 #define TIMER_ONSHOT_FLAG 0x1U
+/* Schedule each expiry relative to the previous deadline instead of relative to when it ran. */
+#define TIMER_PERIODIC_FLAG 0x2U
+
+/* Missed tick policies for periodic timers. */
+#define TIMER_CATCHUP_SKIP     0x0U /* Drop missed ticks and stay in phase. */
+#define TIMER_CATCHUP_BURST    0x4U /* Run the handler once for every missed tick. */
+#define TIMER_CATCHUP_COALESCE 0x8U /* Run once for all missed ticks and restart the period. */
+#define TIMER_CATCHUP_MASK     0xCU
 extern DLL_EXPORT lwiot_timer_t* lwiot_timer_create(  const char *name, int ms,
 	uint32_t flags, void *arg, void (*cb)(lwiot_timer_t *timer, void *arg));
 extern DLL_EXPORT int lwiot_timer_start(lwiot_timer_t *timer);
@@ -67,6 +100,27 @@ extern DLL_EXPORT bool lwiot_timer_is_running(lwiot_timer_t *timer);
 extern DLL_EXPORT int lwiot_timer_set_period(lwiot_timer_t *timer, int ms);
 extern DLL_EXPORT void lwiot_timer_reset(lwiot_timer_t* timer);
 extern DLL_EXPORT time_t lwiot_timer_get_expiry(lwiot_timer_t *timer);
+
+#ifdef HAVE_TIMER_EXPIRY
+/* Optional: tick, in microseconds, at which the first running timer expires; 0 if none runs. */
+extern DLL_EXPORT time_t lwiot_timers_next_expiry(void);
+#endif
+
+#ifdef HAVE_LIGHT_SLEEP
+/*
+ * Optional: suspend the CPU for at most ms milliseconds, or until an interrupt arrives, for
+ * example with esp_light_sleep_start(). Used by lwiot::IdleManager.
+ */
+extern DLL_EXPORT void lwiot_light_sleep(int ms);
+#endif
+
+/*
+ * Tickless idle hooks, implemented by lwiot::IdleManager. A port calls lwiot_idle_enter() with
+ * the time it expects to be idle, or FOREVER, and sleeps no longer than it returns; 0 means
+ * stay awake. lwiot_idle_exit() is called after the sleep.
+ */
+extern DLL_EXPORT int lwiot_idle_enter(int ms);
+extern DLL_EXPORT void lwiot_idle_exit(void);
 #else /* CONFIG_CONFIG_STANDALONE */
 #define lwiot_timers_init()
 #define lwiot_timers_destroy()
@@ -75,16 +129,47 @@ extern DLL_EXPORT time_t lwiot_timer_get_expiry(lwiot_timer_t *timer);
 extern DLL_EXPORT time_t lwiot_tick(void);
 extern DLL_EXPORT time_t lwiot_tick_ms(void);
 
+#ifdef HAVE_TICK_NS
+/* Optional: monotonic clock in nanoseconds. Use lwiot::Clock, which falls back to lwiot_tick(). */
+extern DLL_EXPORT uint64_t lwiot_tick_ns(void);
+#endif
+
+#ifdef HAVE_RANDOM_BYTES
+/*
+ * Optional: fill output with bytes from a cryptographically secure source, such as a hardware
+ * random number generator. Returns -EOK on success.
+ */
+extern DLL_EXPORT int lwiot_random_bytes(void *output, size_t length);
+#endif
+
 extern DLL_EXPORT void *lwiot_mem_alloc(size_t size);
 extern DLL_EXPORT void *lwiot_mem_zalloc(size_t size);
 extern DLL_EXPORT void lwiot_mem_free(void *ptr);
 extern DLL_EXPORT void *lwiot_mem_realloc(void *ptr, size_t size);
 
+#ifdef CONFIG_ALLOC_TRACKING
+/* Called by the port for every allocation and free, to count them for ScopedAllocationGuard. */
+extern DLL_EXPORT void lwiot_mem_track_alloc(size_t size);
+extern DLL_EXPORT void lwiot_mem_track_free(void);
+#endif
+
 extern DLL_EXPORT lwiot_mutex_t* lwiot_mutex_create(const uint32_t flags);
 extern DLL_EXPORT int lwiot_mutex_destroy(lwiot_mutex_t *mtx);
 extern DLL_EXPORT int lwiot_mutex_lock(lwiot_mutex_t *mtx, int tmo);
 extern DLL_EXPORT void lwiot_mutex_unlock(lwiot_mutex_t *mtx);
 
+#ifdef HAVE_RWLOCK
+/* Optional: ports without native reader-writer locks get an emulation in lwiot::SharedLock. */
+extern DLL_EXPORT lwiot_rwlock_t* lwiot_rwlock_create(void);
+extern DLL_EXPORT void lwiot_rwlock_destroy(lwiot_rwlock_t *lock);
+extern DLL_EXPORT void lwiot_rwlock_read_lock(lwiot_rwlock_t *lock);
+extern DLL_EXPORT bool lwiot_rwlock_read_trylock(lwiot_rwlock_t *lock);
+extern DLL_EXPORT void lwiot_rwlock_read_unlock(lwiot_rwlock_t *lock);
+extern DLL_EXPORT void lwiot_rwlock_write_lock(lwiot_rwlock_t *lock);
+extern DLL_EXPORT bool lwiot_rwlock_write_trylock(lwiot_rwlock_t *lock);
+extern DLL_EXPORT void lwiot_rwlock_write_unlock(lwiot_rwlock_t *lock);
+#endif
+
 extern DLL_EXPORT void lwiot_sleep(int ms);
 
 extern DLL_EXPORT int lwiot_hostname_to_ip(const char *host, uint32_t *addr);
@@ -93,6 +178,21 @@ extern DLL_EXPORT void enter_critical();
 extern DLL_EXPORT void exit_critical();
 extern DLL_EXPORT RAM_ATTR void lwiot_udelay(uint32_t us);
 
+#ifdef HAVE_CYCLE_COUNTER
+/* Optional: free running CPU cycle counter, used for calibrated delays. */
+extern DLL_EXPORT RAM_ATTR uint64_t lwiot_cycles(void);
+#endif
+
+/*
+ * Calibrated busy-wait delays. The delay counter is the cycle counter when the port has one, and
+ * the monotonic clock otherwise. lwiot_init() calibrates it against lwiot_tick().
+ */
+extern DLL_EXPORT void lwiot_delay_calibrate(void);
+extern DLL_EXPORT RAM_ATTR uint64_t lwiot_delay_counter(void);
+extern DLL_EXPORT RAM_ATTR uint64_t lwiot_delay_ns_to_cycles(uint32_t ns);
+extern DLL_EXPORT RAM_ATTR void lwiot_delay_until(uint64_t deadline);
+extern DLL_EXPORT RAM_ATTR void lwiot_ndelay(uint32_t ns);
+
 #ifdef CONFIG_STANDALONE
 extern DLL_EXPORT void no_os_init();
 #endif
@@ -0,0 +1,336 @@
+/*
+ * Bounded message queue definition.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/kernel/port.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/event.h>
+
+#include <lwiot/scopedlock.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/stl/move.h>
+#include <lwiot/stl/forward.h>
+#include <lwiot/traits/typechoice.h>
+#include <lwiot/traits/istriviallycopyable.h>
+
+#ifdef HAVE_RTOS
+#include <FreeRTOS.h>
+#include <queue.h>
+#endif
+
+namespace lwiot
+{
+	namespace detail
+	{
+		/*
+		 * Portable queue backend. Elements are stored in a fixed array guarded by a lock.
+		 * Blocked producers and consumers wait on an event each.
+		 */
+		template <typename T, size_t N>
+		class LockedQueue {
+		public:
+			explicit LockedQueue() : _head(0), _size(0)
+			{
+			}
+
+			~LockedQueue()
+			{
+				for(; this->_size > 0; this->_size--) {
+					this->slot(this->_head)->~T();
+					this->_head = (this->_head + 1) % N;
+				}
+			}
+
+			template <typename U>
+			bool enqueue(U&& value, bool block, int tmo)
+			{
+				ScopedLock g(this->_lock);
+				auto start = lwiot_tick_ms();
+
+				while(this->_size == N) {
+					if(!block || !this->wait(this->_writable, g, start, tmo))
+						return false;
+				}
+
+				new(this->slot(this->_head + this->_size)) T(stl::forward<U>(value));
+				this->_size++;
+
+				/* Pass the wake up on when other producers can make progress as well. */
+				if(this->_size < N)
+					this->_writable.signal();
+
+				this->_readable.signal();
+				return true;
+			}
+
+			bool dequeue(T& value, bool block, int tmo)
+			{
+				ScopedLock g(this->_lock);
+				auto start = lwiot_tick_ms();
+
+				while(this->_size == 0) {
+					if(!block || !this->wait(this->_readable, g, start, tmo))
+						return false;
+				}
+
+				auto obj = this->slot(this->_head);
+
+				value = stl::move(*obj);
+				obj->~T();
+				this->_head = (this->_head + 1) % N;
+				this->_size--;
+
+				/* Pass the wake up on when other consumers can make progress as well. */
+				if(this->_size > 0)
+					this->_readable.signal();
+
+				this->_writable.signal();
+				return true;
+			}
+
+			size_t drain(stl::Vector<T>& output, bool block, int tmo)
+			{
+				ScopedLock g(this->_lock);
+				auto start = lwiot_tick_ms();
+				auto num = this->_size;
+
+				while(this->_size == 0) {
+					if(!block || !this->wait(this->_readable, g, start, tmo))
+						return 0;
+
+					num = this->_size;
+				}
+
+				output.reserve(output.size() + num);
+
+				for(; this->_size > 0; this->_size--) {
+					auto obj = this->slot(this->_head);
+
+					output.pushback(stl::move(*obj));
+					obj->~T();
+					this->_head = (this->_head + 1) % N;
+				}
+
+				/* Every slot is free, so every blocked producer can make progress. */
+				this->_writable.broadcast();
+				return num;
+			}
+
+			size_t size() const
+			{
+				return this->_size;
+			}
+
+		private:
+			alignas(T) uint8_t _storage[N * sizeof(T)];
+			size_t _head;
+			size_t _size;
+
+			Lock _lock;
+			Event _readable;
+			Event _writable;
+
+			T *slot(size_t idx)
+			{
+				return reinterpret_cast<T *>(this->_storage) + (idx % N);
+			}
+
+			/* Returns false when the timeout has expired. */
+			bool wait(Event& event, ScopedLock& guard, time_t start, int tmo)
+			{
+				if(tmo == FOREVER) {
+					event.wait(guard, FOREVER);
+					return true;
+				}
+
+				auto elapsed = static_cast<int>(lwiot_tick_ms() - start);
+
+				if(elapsed >= tmo)
+					return false;
+
+				event.wait(guard, tmo - elapsed);
+				return true;
+			}
+		};
+
+#ifdef HAVE_RTOS
+		/*
+		 * FreeRTOS queue backend. Elements are copied into the kernel queue, which is why this backend
+		 * is only used for trivially copyable types.
+		 */
+		template <typename T, size_t N>
+		class NativeQueue {
+		public:
+			explicit NativeQueue() : _queue(xQueueCreate(N, sizeof(T)))
+			{
+			}
+
+			~NativeQueue()
+			{
+				vQueueDelete(this->_queue);
+			}
+
+			template <typename U>
+			bool enqueue(U&& value, bool block, int tmo)
+			{
+				const T copy(stl::forward<U>(value));
+				return xQueueSendToBack(this->_queue, &copy, ticks(block, tmo)) == pdTRUE;
+			}
+
+			bool dequeue(T& value, bool block, int tmo)
+			{
+				return xQueueReceive(this->_queue, &value, ticks(block, tmo)) == pdTRUE;
+			}
+
+			size_t drain(stl::Vector<T>& output, bool block, int tmo)
+			{
+				T value;
+				size_t num = 0;
+
+				if(!this->dequeue(value, block, tmo))
+					return 0;
+
+				do {
+					output.pushback(value);
+					num++;
+				} while(this->dequeue(value, false, 0));
+
+				return num;
+			}
+
+			size_t size() const
+			{
+				return uxQueueMessagesWaiting(this->_queue);
+			}
+
+		private:
+			QueueHandle_t _queue;
+
+			static TickType_t ticks(bool block, int tmo)
+			{
+				if(!block)
+					return 0;
+
+				if(tmo == FOREVER)
+					return portMAX_DELAY;
+
+				return tmo / portTICK_PERIOD_MS;
+			}
+		};
+
+		template <typename T, size_t N>
+		using QueueBackend = typename traits::TypeChoice<traits::IsTriviallyCopyable<T>::value,
+				NativeQueue<T, N>, LockedQueue<T, N>>::type;
+#else
+		template <typename T, size_t N>
+		using QueueBackend = LockedQueue<T, N>;
+#endif
+	}
+
+	/**
+	 * @brief Fixed capacity, multi-producer, multi-consumer queue.
+	 * @tparam T Element type.
+	 * @tparam N Capacity.
+	 *
+	 * Elements are stored in place, so enqueueing never allocates. On FreeRTOS, queues of trivially
+	 * copyable types map onto native kernel queues.
+	 *
+	 * @note Timeouts are in milliseconds. As everywhere else in lwIoT, a timeout of FOREVER (0) waits
+	 *       indefinitely; use tryPush() and tryPop() for non-blocking access.
+	 */
+	template <typename T, size_t N>
+	class Queue {
+		static_assert(N > 0, "Queue capacity must be larger than zero");
+
+	public:
+		typedef T value_type;
+
+		explicit Queue() = default;
+
+		Queue(const Queue&) = delete;
+		Queue& operator=(const Queue&) = delete;
+
+		bool push(const T& value, int tmo = FOREVER)
+		{
+			return this->_backend.enqueue(value, true, tmo);
+		}
+
+		bool push(T&& value, int tmo = FOREVER)
+		{
+			return this->_backend.enqueue(stl::move(value), true, tmo);
+		}
+
+		bool tryPush(const T& value)
+		{
+			return this->_backend.enqueue(value, false, 0);
+		}
+
+		bool tryPush(T&& value)
+		{
+			return this->_backend.enqueue(stl::move(value), false, 0);
+		}
+
+		bool pop(T& value, int tmo = FOREVER)
+		{
+			return this->_backend.dequeue(value, true, tmo);
+		}
+
+		bool tryPop(T& value)
+		{
+			return this->_backend.dequeue(value, false, 0);
+		}
+
+		/**
+		 * @brief Move all queued elements into \p output.
+		 * @param output Vector to append to.
+		 * @return The number of elements appended.
+		 */
+		size_t popAll(stl::Vector<T>& output)
+		{
+			return this->_backend.drain(output, false, 0);
+		}
+
+		/**
+		 * @brief Wait for at least one element, then move all queued elements into \p output.
+		 * @param output Vector to append to.
+		 * @param tmo Timeout in milliseconds.
+		 * @return The number of elements appended.
+		 */
+		size_t popAll(stl::Vector<T>& output, int tmo)
+		{
+			return this->_backend.drain(output, true, tmo);
+		}
+
+		size_t size() const
+		{
+			return this->_backend.size();
+		}
+
+		bool empty() const
+		{
+			return this->size() == 0;
+		}
+
+		bool full() const
+		{
+			return this->size() == N;
+		}
+
+		static constexpr size_t capacity()
+		{
+			return N;
+		}
+
+	private:
+		detail::QueueBackend<T, N> _backend;
+	};
+}
@@ -0,0 +1,65 @@
+/*
+ * Reader-writer lock definition.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#include <lwiot/kernel/lock.h>
+
+#if !defined(HAVE_RWLOCK) && !defined(CONFIG_STANDALONE)
+#include <lwiot/kernel/event.h>
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Lock that can be held by many readers, or by a single writer.
+	 *
+	 * Waiting writers are preferred over new readers, so a steady stream of readers cannot
+	 * starve a writer. Ports that provide native reader-writer locks (pthreads, Win32 SRW) use
+	 * them; other ports use an emulation based on Lock and Event. Standalone builds do not have
+	 * concurrent readers and only use an exclusive lock.
+	 *
+	 * @note The lock is not recursive.
+	 * @see ScopedSharedLock
+	 * @see UniqueLock
+	 */
+	class SharedLock {
+	public:
+		explicit SharedLock();
+		virtual ~SharedLock();
+
+		SharedLock(const SharedLock&) = delete;
+		SharedLock& operator=(const SharedLock&) = delete;
+
+		void lock();
+		bool try_lock();
+		void unlock();
+
+		void lock_shared();
+		bool try_lock_shared();
+		void unlock_shared();
+
+	private:
+#if defined(HAVE_RWLOCK)
+		lwiot_rwlock_t* _rwlock;
+#elif defined(CONFIG_STANDALONE)
+		Lock _lock;
+#else
+		Lock _lock;
+		Event _readers;
+		Event _writers;
+
+		int _active;
+		int _waiting_readers;
+		int _waiting_writers;
+		bool _writer;
+#endif
+	};
+}
@@ -0,0 +1,55 @@
+/*
+ * Statically allocated thread definition.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/kernel/thread.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Thread that keeps its control block and stack inside the object.
+	 *
+	 * Starting a StaticThread does not allocate the thread from the heap, so global or static
+	 * instances lay out all thread memory at link time. Ports that cannot run a thread on a
+	 * caller supplied stack only keep the control block inside the object.
+	 *
+	 * @tparam StackSize Stack size in bytes.
+	 * @note A StaticThread cannot be moved.
+	 */
+	template <size_t StackSize>
+	class StaticThread : public Thread {
+	public:
+		explicit StaticThread(const String& name, int priority = 0, void* argument = nullptr) :
+#ifdef HAVE_STATIC_THREAD
+			Thread(name, priority, StackSize, &this->_tcb, this->_stack, argument)
+#else
+			Thread(name, priority, StackSize, argument)
+#endif
+		{
+		}
+
+		StaticThread(StaticThread&&) = delete;
+		StaticThread& operator=(StaticThread&&) = delete;
+
+		static constexpr size_t stackSize()
+		{
+			return StackSize;
+		}
+
+	private:
+#ifdef HAVE_STATIC_THREAD
+		lwiot_thread_t _tcb;
+		alignas(16) uint8_t _stack[StackSize];
+#endif
+	};
+}
@@ -16,6 +16,21 @@
 #include <lwiot/stl/move.h>
 
 namespace lwiot {
+	/**
+	 * @brief Resource usage of a thread.
+	 * @note Values the port cannot measure are 0.
+	 */
+	struct ThreadStatistics {
+		String name;
+		int priority;
+		bool running;
+
+		size_t stackSize; //!< Stack size in bytes.
+		size_t stackHighWaterMark; //!< Least amount of free stack seen so far, in bytes.
+		uint64_t cpuTime; //!< CPU time in microseconds.
+		uint32_t contextSwitches;
+	};
+
 	class Thread {
 	public:
 		explicit Thread(void *argument = nullptr);
@@ -40,6 +55,31 @@ namespace lwiot {
 			this->_name = stl::move(name);
 		}
 
+		inline const String& name() const
+		{
+			return this->_name;
+		}
+
+		/**
+		 * @brief Restrict the thread to a set of cores.
+		 * @param mask Bit mask of the cores the thread may run on, 0 for any core.
+		 * @note Only takes effect when the thread is started.
+		 */
+		inline void setAffinity(uint32_t mask)
+		{
+			this->_affinity = mask;
+		}
+
+		inline uint32_t affinity() const
+		{
+			return this->_affinity;
+		}
+
+		bool statistics(ThreadStatistics& stats) const;
+		size_t stackHighWaterMark() const;
+		uint64_t cpuTime() const;
+		uint32_t contextSwitches() const;
+
 		Thread& operator=(Thread&& rhs) noexcept ;
 		Thread& operator=(Thread& rhs) = delete;
 
@@ -72,6 +112,9 @@ namespace lwiot {
 			swap(a._internal, b._internal);
 			swap(a._prio, b._prio);
 			swap(a.stacksize, b.stacksize);
+			swap(a._affinity, b._affinity);
+			swap(a._storage, b._storage);
+			swap(a._stack, b._stack);
 			swap(a._name, b._name);
 		}
 
@@ -80,17 +123,32 @@ namespace lwiot {
 		void *_argument;
 		virtual void move(Thread& rhs);
 
+		/**
+		 * @brief Create a thread that runs in caller supplied storage.
+		 * @param storage Control block storage.
+		 * @param stack Stack storage of \p stacksize bytes.
+		 * @note Ports without HAVE_STATIC_THREAD ignore the storage and allocate the thread.
+		 * @see StaticThread
+		 */
+		explicit Thread(const String& name, int priority, size_t stacksize, lwiot_thread_t* storage, void* stack,
+				void* argument = nullptr);
+
 	private:
 		friend void thread_starter(void *arg);
+		friend class ThreadRegistry;
 		void pre_run();
+		void collect(ThreadStatistics& stats) const;
 
 		bool _running;
 		lwiot_thread_t *_internal;
 		Event _join;
-		Lock _lock;
+		mutable Lock _lock;
 
 		int _prio;
 		size_t stacksize;
+		uint32_t _affinity;
+		lwiot_thread_t* _storage;
+		void* _stack;
 		String _name;
 	};
 
@@ -0,0 +1,39 @@
+/*
+ * Registry of running threads.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#include <lwiot/kernel/thread.h>
+#include <lwiot/stl/vector.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Overview of all started threads.
+	 *
+	 * Threads register themselves when they are started. They stay registered until they are
+	 * joined, stopped or destroyed, so the usage of threads that have finished can still be
+	 * inspected.
+	 */
+	class ThreadRegistry {
+	public:
+		/**
+		 * @brief Collect the statistics of all registered threads.
+		 */
+		static stl::Vector<ThreadStatistics> snapshot();
+		static size_t count();
+
+	private:
+		friend class Thread;
+
+		static void add(Thread* thread);
+		static void remove(Thread* thread);
+	};
+}
@@ -18,6 +18,23 @@
 
 namespace lwiot
 {
+	/**
+	 * @brief Timer scheduling modes.
+	 *
+	 * A continuous timer is rescheduled relative to the moment it ran, so its period drifts by
+	 * the scheduling latency. Periodic timers are scheduled relative to their previous deadline
+	 * and differ in how they handle ticks that were missed because the handler ran too long:
+	 * Periodic drops them, PeriodicBurst runs the handler for each of them and PeriodicCoalesce
+	 * runs the handler once and restarts the period from there.
+	 */
+	enum TimerType {
+		Continuous = 0,
+		OneShot = TIMER_ONSHOT_FLAG,
+		Periodic = TIMER_PERIODIC_FLAG | TIMER_CATCHUP_SKIP,
+		PeriodicBurst = TIMER_PERIODIC_FLAG | TIMER_CATCHUP_BURST,
+		PeriodicCoalesce = TIMER_PERIODIC_FLAG | TIMER_CATCHUP_COALESCE,
+	};
+
 	class Timer {
 	public:
 		explicit Timer(const lwiot::String& name, unsigned long ms, uint32_t flags, void *arg);
@@ -34,6 +51,11 @@ namespace lwiot
 		bool isExpired();
 		void reset();
 
+		/**
+		 * @brief Change the period of the timer; it applies from the next time the timer is (re)started.
+		 */
+		void setPeriod(unsigned long ms);
+
 		time_t expiry();
 
 	protected:
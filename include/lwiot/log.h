@@ -16,6 +16,21 @@
 #include <lwiot/stl/string.h>
 #include <lwiot/lwiot.h>
 
+#define LWIOT_LOG_LEVEL_DEBUG   0
+#define LWIOT_LOG_LEVEL_INFO    1
+#define LWIOT_LOG_LEVEL_WARNING 2
+#define LWIOT_LOG_LEVEL_ERROR   3
+#define LWIOT_LOG_LEVEL_NONE    4
+
+/* Lowest level that is compiled in, and the initial level of every subsystem. */
+#ifndef CONFIG_LOG_LEVEL
+#ifdef HAVE_DEBUG
+#define CONFIG_LOG_LEVEL LWIOT_LOG_LEVEL_DEBUG
+#else
+#define CONFIG_LOG_LEVEL LWIOT_LOG_LEVEL_INFO
+#endif
+#endif
+
 #ifdef HAVE_DEBUG
 CDECL
 extern DLL_EXPORT void print_dbg(const char *fmt, ...);
@@ -31,8 +46,82 @@ CDECL_END
 
 #ifdef __cplusplus
 #include <lwiot/stl/string.h>
+#include <lwiot/format.h>
+#include <lwiot/kernel/atomic.h>
+
+#ifndef CONFIG_LOG_LINE_LENGTH
+#define CONFIG_LOG_LINE_LENGTH 128
+#endif
+
+/* Number of subsystems that can have a level of their own. */
+#ifndef CONFIG_LOG_FILTERS
+#define CONFIG_LOG_FILTERS 8
+#endif
+
+/* Subsystem names are compared up to this length. */
+#ifndef CONFIG_LOG_FILTER_NAME_LENGTH
+#define CONFIG_LOG_FILTER_NAME_LENGTH 16
+#endif
+
+/**
+ * @brief Log a line at a level.
+ * @param __logger Logger to write to.
+ * @param __fmt Format string literal, checked against the arguments.
+ *
+ * Lines below CONFIG_LOG_LEVEL are compiled out, including their arguments. Other lines are
+ * written when the level of the subsystem of \p __logger allows it, see Logger::setLevel(). The
+ * arguments of lines that are filtered out are not evaluated.
+ */
+#if CONFIG_LOG_LEVEL <= LWIOT_LOG_LEVEL_DEBUG
+#define LWIOT_LOG_DEBUG(__logger, __fmt, ...) \
+	do { \
+		if((__logger).enabled(lwiot::LogLevel::Debug)) \
+			(__logger).println(lwiot::LogLevel::Debug, LWIOT_FMT(__fmt), ##__VA_ARGS__); \
+	} while(0)
+#else
+#define LWIOT_LOG_DEBUG(__logger, __fmt, ...) do { } while(0)
+#endif
+
+#if CONFIG_LOG_LEVEL <= LWIOT_LOG_LEVEL_INFO
+#define LWIOT_LOG_INFO(__logger, __fmt, ...) \
+	do { \
+		if((__logger).enabled(lwiot::LogLevel::Info)) \
+			(__logger).println(lwiot::LogLevel::Info, LWIOT_FMT(__fmt), ##__VA_ARGS__); \
+	} while(0)
+#else
+#define LWIOT_LOG_INFO(__logger, __fmt, ...) do { } while(0)
+#endif
+
+#if CONFIG_LOG_LEVEL <= LWIOT_LOG_LEVEL_WARNING
+#define LWIOT_LOG_WARNING(__logger, __fmt, ...) \
+	do { \
+		if((__logger).enabled(lwiot::LogLevel::Warning)) \
+			(__logger).println(lwiot::LogLevel::Warning, LWIOT_FMT(__fmt), ##__VA_ARGS__); \
+	} while(0)
+#else
+#define LWIOT_LOG_WARNING(__logger, __fmt, ...) do { } while(0)
+#endif
+
+#if CONFIG_LOG_LEVEL <= LWIOT_LOG_LEVEL_ERROR
+#define LWIOT_LOG_ERROR(__logger, __fmt, ...) \
+	do { \
+		if((__logger).enabled(lwiot::LogLevel::Error)) \
+			(__logger).println(lwiot::LogLevel::Error, LWIOT_FMT(__fmt), ##__VA_ARGS__); \
+	} while(0)
+#else
+#define LWIOT_LOG_ERROR(__logger, __fmt, ...) do { } while(0)
+#endif
 
 namespace lwiot {
+	enum class LogLevel : uint8_t {
+		Debug,
+		Info,
+		Warning,
+		Error
+	};
+
+	class AsyncLogBackend;
+
 	class Logger {
 	public:
 		class NewLine {
@@ -56,14 +145,93 @@ namespace lwiot {
 		Logger& operator <<(float fp);
 		Logger& operator <<(double fp);
 
+		/**
+		 * @brief Log a single, formatted line.
+		 * @param fmt Format string.
+		 * @param args Format arguments.
+		 * @see lwiot::format()
+		 *
+		 * The line, including its prefix and line ending, is formatted into a buffer of
+		 * CONFIG_LOG_LINE_LENGTH bytes and written to the output using a single write. Longer lines
+		 * are formatted into a temporary heap buffer.
+		 *
+		 * When a backend is installed, the line is handed to it as a single record instead.
+		 */
+		template <typename... Args>
+		Logger& println(const char *fmt, const Args&... args)
+		{
+			return this->println(LogLevel::Info, fmt, args...);
+		}
+
+		template <typename... Args>
+		Logger& println(LogLevel level, const char *fmt, const Args&... args)
+		{
+			if(!this->enabled(level))
+				return *this;
+
+			const detail::FormatArg values[] = { detail::FormatTraitsOf<Args>::make(args)..., detail::FormatArg() };
+
+			this->writeLine(level, fmt, values, sizeof...(Args));
+			return *this;
+		}
+
+		template <typename Literal, typename... Args,
+				typename = traits::EnableIf_t<traits::IsConvirtable<Literal, detail::FormatLiteral>::value>>
+		Logger& println(Literal fmt, const Args&... args)
+		{
+			static_assert(detail::is_valid_format<Args...>(Literal::get()), "Format string does not match its arguments");
+			return this->println(Literal::get(), args...);
+		}
+
+		template <typename Literal, typename... Args,
+				typename = traits::EnableIf_t<traits::IsConvirtable<Literal, detail::FormatLiteral>::value>>
+		Logger& println(LogLevel level, Literal fmt, const Args&... args)
+		{
+			static_assert(detail::is_valid_format<Args...>(Literal::get()), "Format string does not match its arguments");
+			return this->println(level, Literal::get(), args...);
+		}
+
+		/**
+		 * @brief Check if lines at \p level are written by this logger.
+		 */
+		bool enabled(LogLevel level) const
+		{
+			return static_cast<uint8_t>(level) >= this->_level->load(memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Set the level of every subsystem that has no level of its own.
+		 */
+		static void setLevel(LogLevel level);
+
+		/**
+		 * @brief Set the level of \p subsys, which takes effect in existing loggers as well.
+		 * @return False if there is no room for another subsystem.
+		 *
+		 * Up to CONFIG_LOG_FILTERS subsystems can have a level of their own. Loggers of other
+		 * subsystems use the default level.
+		 */
+		static bool setLevel(const String& subsys, LogLevel level);
+
+		/**
+		 * @brief Send the output of every logger to \p backend, or write it directly when it is null.
+		 * @see AsyncLogBackend
+		 */
+		static void setBackend(AsyncLogBackend *backend);
+
 		static NewLine newline;
 	private:
 		FILE *_f_output;
 		bool _newline;
 		String _subsys;
+		const Atomic<uint8_t> *_level;
 
 		void format(const char *fmt, ...);
 		void print_newline();
+		size_t formatPrefix(char *output, size_t size, unsigned long long tick) const;
+		void writeLine(LogLevel level, const char *fmt, const detail::FormatArg *args, size_t num);
+
+		static AsyncLogBackend *backend;
 	};
 }
 #endif
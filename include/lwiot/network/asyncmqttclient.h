@@ -9,26 +9,96 @@
 
 #include <lwiot/function.h>
 #include <lwiot/scopedlock.h>
+#include <lwiot/uniquepointer.h>
+#include <lwiot/kernel/uniquelock.h>
 
-#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/kernel/executor.h>
+#include <lwiot/kernel/event.h>
 #include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/sharedlock.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/detail/boundedqueue.h>
 
 #include <lwiot/network/mqttclient.h>
 #include <lwiot/network/ipaddress.h>
 #include <lwiot/network/stdnet.h>
+#include <lwiot/network/topictrie.h>
+#include <lwiot/network/mqttsessionstore.h>
+#include <lwiot/network/mqttofflinelog.h>
 
-#include <lwiot/stl/map.h>
+#include <lwiot/stl/unorderedmap.h>
 #include <lwiot/stl/string.h>
 
+#ifndef CONFIG_MQTT_ASYNC_POLL
+#define CONFIG_MQTT_ASYNC_POLL 100
+#endif
+
+#ifndef CONFIG_MQTT_BACKOFF_MIN
+#define CONFIG_MQTT_BACKOFF_MIN 500
+#endif
+
+#ifndef CONFIG_MQTT_BACKOFF_MAX
+#define CONFIG_MQTT_BACKOFF_MAX 30000
+#endif
+
+#ifndef CONFIG_MQTT_QUEUE_SIZE
+#define CONFIG_MQTT_QUEUE_SIZE 32
+#endif
+
+#ifndef CONFIG_MQTT_COALESCE
+#define CONFIG_MQTT_COALESCE 8
+#endif
+
+#ifndef CONFIG_MQTT_RETRY_INTERVAL
+#define CONFIG_MQTT_RETRY_INTERVAL 10000
+#endif
+
+#ifndef CONFIG_MQTT_REPLAY_BATCH
+#define CONFIG_MQTT_REPLAY_BATCH 8
+#endif
+
+#ifndef CONFIG_MQTT_REPLAY_INTERVAL
+#define CONFIG_MQTT_REPLAY_INTERVAL 100
+#endif
+
 namespace lwiot
 {
+	/**
+	 * @brief MQTT client that processes incoming messages in the background.
+	 *
+	 * The client loop runs as a recurring task on an executor. Clients can share an executor
+	 * with other components; clients constructed without one create a private executor.
+	 *
+	 * Each run of the task waits for the connection to become readable and dispatches incoming
+	 * messages as soon as they arrive. The wait lasts at most CONFIG_MQTT_ASYNC_POLL milliseconds,
+	 * after which the task is posted again so that it does not hold on to a shared executor. The
+	 * client lock is not held while waiting, so publishing from other threads is never delayed by
+	 * the loop.
+	 *
+	 * Published messages are encoded by the caller and put on a lock free queue of
+	 * CONFIG_MQTT_QUEUE_SIZE packets, which the executor drains. Messages that are queued
+	 * together are written to the connection at once, up to CONFIG_MQTT_COALESCE packets per
+	 * write. Messages published while the connection is down are sent once it is restored. The
+	 * private executor has two workers, so that the queue is drained while the loop waits for
+	 * data; a shared executor should have more than one worker for the same reason.
+	 */
 	class AsyncMqttClient : private MqttClient {
 	public:
-		typedef Function<void(const ByteBuffer&)> AsyncHandler;
+		typedef Function<void(const SharedByteBuffer&)> AsyncHandler;
+		typedef Function<void(const String& topic, const SharedByteBuffer&)> TopicHandler;
 		typedef Function<void(void)> ReconnectHandler;
 
+		/**
+		 * @brief What publish() does when the outbound queue is full.
+		 */
+		enum class OverflowPolicy {
+			DropOldest, //!< Discard the oldest queued message to make room.
+			Block       //!< Wait for room, at most the client timeout.
+		};
+
 		explicit AsyncMqttClient(int tmo = 1000);
 		explicit AsyncMqttClient(const ReconnectHandler& handler, int tmo = 1000);
+		explicit AsyncMqttClient(Executor& executor, int tmo = 1000);
 		explicit AsyncMqttClient(const AsyncMqttClient& rhs) = delete;
 		explicit AsyncMqttClient(AsyncMqttClient&& rhs) noexcept  = delete;
 		virtual ~AsyncMqttClient();
@@ -38,6 +108,74 @@ namespace lwiot
 
 		void setReconnectHandler(const ReconnectHandler& handler);
 
+		/**
+		 * @brief Set the delay between attempts to restore a lost connection.
+		 *
+		 * The delay starts at \p min milliseconds and doubles after every failed attempt, up to
+		 * \p max. Each delay is shortened by a random part of up to half of it, so that clients
+		 * that lost the broker at the same time do not retry in lock step.
+		 */
+		void setReconnectBackoff(int min, int max);
+
+		/**
+		 * @brief Choose what happens to messages published while the outbound queue is full.
+		 * @note The default is OverflowPolicy::Block.
+		 */
+		void setOverflowPolicy(OverflowPolicy policy);
+
+		/**
+		 * @brief Set the QoS of messages published on \p topic.
+		 *
+		 * Topics default to QoS 0. QoS 1 and QoS 2 messages are kept until the broker has
+		 * acknowledged them. They are sent again, marked as duplicates, after a lost connection
+		 * has been restored and when the retry interval passes without an acknowledgement.
+		 */
+		void setQoS(const stl::String& topic, QoS qos);
+
+		/**
+		 * @brief Set the number of QoS 1 and QoS 2 messages that may await acknowledgement.
+		 *
+		 * Messages after those wait in the queue. The window is at most CONFIG_MQTT_MAX_INFLIGHT,
+		 * which is also the default.
+		 */
+		void setInflightWindow(size_t window);
+
+		/**
+		 * @brief Set the time after which an unacknowledged message is sent again.
+		 * @param ms Retry interval in milliseconds, 0 to only retry after a reconnect.
+		 */
+		void setRetryInterval(int ms);
+
+		/**
+		 * @brief Keep unacknowledged messages in \p store.
+		 *
+		 * Messages that were left in the store by an earlier run are sent again once the client
+		 * connects. Set the store before the client is connected.
+		 */
+		void setSessionStore(MqttSessionStore& store);
+
+		/**
+		 * @brief Keep messages that are published while the client is offline in \p log.
+		 *
+		 * Logged messages are published again once the client is connected, oldest first. As long
+		 * as the log holds messages, new messages are appended to it as well, so that the order
+		 * is kept. Set the log before the client is started.
+		 */
+		void setOfflineLog(MqttOfflineLog& log);
+
+		/**
+		 * @brief Limit the replay of the offline log to \p batch messages every \p ms milliseconds.
+		 */
+		void setReplayRate(size_t batch, int ms);
+
+		/**
+		 * @brief Number of messages that were discarded because the outbound queue was full.
+		 */
+		size_t dropped() const
+		{
+			return this->_dropped.load();
+		}
+
 		bool start(TcpClient& client);
 		void stop();
 
@@ -46,20 +184,52 @@ namespace lwiot
 		                     const String& willMessage, bool cleanSession) override ;
 		using MqttClient::connect;
 
+		/**
+		 * @brief Subscribe to a topic filter.
+		 *
+		 * The filter may contain the `+` and `#` wildcards. A message is handed to the handlers
+		 * of every matching filter, and a filter can have more than one handler. Shared
+		 * subscriptions, `$share/<group>/<filter>`, are matched on their filter.
+		 */
 		bool subscribe(const stl::String& topic, AsyncHandler handler, QoS qos = QOS0);
 
 		template <typename Func>
 		inline bool subscribe(const stl::String& topic, Func&& handler, QoS qos = QOS0)
 		{
-			ScopedLock lock(this->_lock);
-
-			this->_handlers.add(topic, handler);
-			return MqttClient::subscribe(topic, qos);
+			return this->subscribe(topic, AsyncHandler(stl::forward<Func>(handler)), qos);
 		}
 
+		/**
+		 * @brief Subscribe to a topic filter with a handler that is also given the topic.
+		 *
+		 * Useful for filters with wildcards, whose handler has to tell the matching topics apart.
+		 */
+		bool route(const stl::String& topic, TopicHandler handler, QoS qos = QOS0);
+
 		bool unsubscribe(const stl::String& topic) override;
 		bool publish(const stl::String& topic, const ByteBuffer& data, bool retained) override;
+		bool publish(const stl::String& topic, const ByteBuffer& data, bool retained,
+		             const UserProperties& properties) override;
+
+		/**
+		 * @brief Publish \p length bytes read from \p source.
+		 *
+		 * Streamed messages are not queued: the queue is flushed and the payload is written from
+		 * the calling thread. The client lock is held until the whole message has been sent.
+		 */
+		bool publish(const stl::String& topic, Stream& source, size_t length, bool retained = false) override;
+
+		/**
+		 * @brief Publish a JSON document. Like streamed messages, it is sent from the calling thread.
+		 */
+		bool publishJson(const stl::String& topic, const JsonVariant& json, bool retained = false) override;
 		using MqttClient::publish;
+		using MqttClient::setChunkHandler;
+		using MqttClient::UserProperties;
+		using MqttClient::Version;
+		using MqttClient::setVersion;
+		using MqttClient::version;
+		using MqttClient::properties;
 
 		inline bool connected() override
 		{
@@ -73,15 +243,39 @@ namespace lwiot
 			return MqttClient::state();
 		}
 
+		inline uint8_t reason() const
+		{
+			ScopedLock lock(this->_lock);
+			return MqttClient::reason();
+		}
+
 	protected:
-		virtual void run();
+		void acknowledged(Ack ack, uint16_t id) override;
 
 	private:
-		stl::Map<stl::String, AsyncHandler> _handlers;
+		struct Outbound {
+			ByteBuffer packet;
+			uint16_t id;
+			time_t sent;
+		};
+
+		TopicTrie<TopicHandler> _handlers;
+		mutable SharedLock _handler_lock;
 		ReconnectHandler _reconnect_handler;
-		FunctionalThread _executor;
+		UniquePointer<Executor> _private_executor;
+		Executor& _executor;
 		mutable Lock _lock;
+		Event _idle;
+		Event _wakeup;
+		TcpClient* _client;
 		bool _running;
+		bool _active;
+
+		int _backoff_min;
+		int _backoff_max;
+		int _backoff;
+		time_t _next_attempt;
+		uint32_t _seed;
 
 		stl::String _id, _user, _pass, _will_topic, _will;
 		uint8_t _will_qos;
@@ -89,7 +283,42 @@ namespace lwiot
 		bool _clean;
 		int _tmo;
 
+		detail::BoundedQueue<Outbound, CONFIG_MQTT_QUEUE_SIZE> _queue;
+		Outbound* _inflight[CONFIG_MQTT_MAX_INFLIGHT];
+		Outbound* _stalled;
+		size_t _window;
+		int _retry;
+		MqttSessionStore* _store;
+		MqttOfflineLog* _log;
+		size_t _replay_batch;
+		int _replay_interval;
+		time_t _replayed;
+		AtomicBool _online;
+		stl::UnorderedMap<stl::String, QoS> _qos;
+		mutable SharedLock _qos_lock;
+		Event _space;
+		atomic_int_t _policy;
+		atomic_int_t _flushes;
+		AtomicBool _flush_posted;
+		atomic_uint16_t _msgid;
+		Atomic<size_t> _dropped;
+
 		/* Methods */
-		void invoke(const String& topic, const ByteBuffer& data) const;
+		void step();
+		void flush();
+		void drain();
+		void resend();
+		void retry();
+		void replay();
+		Outbound* prepare(const stl::String& topic, const ByteBuffer& data, bool retained,
+		                  const UserProperties& properties);
+		void transmit(Outbound* entry);
+		void complete(Outbound*& entry);
+		void schedule();
+		bool enqueue(Outbound* entry);
+		QoS qos(const stl::String& topic) const;
+		void restore(ScopedLock& lock);
+		int jitter(int delay);
+		void invoke(const String& topic, const SharedByteBuffer& data) const;
 	};
 }
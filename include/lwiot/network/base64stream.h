@@ -0,0 +1,82 @@
+/*
+ * Streaming base 64 encoder and decoder.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stream.h>
+#include <lwiot/network/base64.h>
+
+#ifndef CONFIG_BASE64_BUFFER
+#define CONFIG_BASE64_BUFFER 128
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Encodes data of any length to a stream, in chunks.
+	 *
+	 * Input is encoded into a buffer of CONFIG_BASE64_BUFFER characters on the stack, which is
+	 * written to the output every time it fills up. Groups that are split over two calls to
+	 * update() are carried over, so the output is the same as that of a single call.
+	 */
+	class Base64Encoder {
+	public:
+		/**
+		 * @param output Stream to write the encoded data to.
+		 * @param newlines Break the output into lines of BASE64_CHARS_PER_LINE characters.
+		 */
+		explicit Base64Encoder(Stream& output, bool newlines = false);
+
+		/**
+		 * @brief Encode \p length bytes.
+		 * @return The number of characters written, or -EINVALID if the output did not take them.
+		 */
+		ssize_t update(const void *data, size_t length);
+
+		/**
+		 * @brief Write the last group and its padding, and start over.
+		 * @return The number of characters written, or -EINVALID if the output did not take them.
+		 */
+		ssize_t final();
+
+	private:
+		Stream& _output;
+		bool _newlines;
+		base64_encodestate _state;
+	};
+
+	/**
+	 * @brief Decodes base 64 text of any length to a stream, in chunks.
+	 *
+	 * Characters outside of the alphabet, such as line breaks and padding, are skipped.
+	 */
+	class Base64Decoder {
+	public:
+		explicit Base64Decoder(Stream& output);
+
+		/**
+		 * @brief Decode \p length characters.
+		 * @return The number of bytes written, or -EINVALID if the output did not take them.
+		 */
+		ssize_t update(const char *data, size_t length);
+
+		/**
+		 * @brief End the input, and start over.
+		 * @return 0, or -EINVALID if the input ended with a group of a single character.
+		 */
+		ssize_t final();
+
+	private:
+		Stream& _output;
+		base64_decodestate _state;
+	};
+}
@@ -24,6 +24,14 @@
 
 namespace lwiot
 {
+	class HttpServer;
+
+	/**
+	 * @brief DNS responder that resolves every A query to the captor address.
+	 *
+	 * The answer to a single A question is encoded once, so the common query is answered by
+	 * copying it and appending that answer.
+	 */
 	class CaptivePortal : Thread {
 	public:
 		explicit CaptivePortal(const IPAddress& bind, const IPAddress& captor, uint16_t port = DNS_SERVER_PORT, UdpServer* server = nullptr);
@@ -33,6 +41,14 @@ namespace lwiot
 		void begin(UdpServer* server, uint16_t port);
 		void end();
 
+		/**
+		 * @brief Answer the connectivity checks of common operating systems on \p server.
+		 *
+		 * The checks are redirected to \p page on the captor address, which makes the operating
+		 * system show the portal. The responses are canned, see HttpServer::serveCanned().
+		 */
+		void redirectProbes(HttpServer& server, const String& page = "/") const;
+
 	protected:
 		void run() override;
 
@@ -44,8 +60,12 @@ namespace lwiot
 		IPAddress _bind_addr;
 		uint16_t _port;
 		char *udp_msg;
+		char *_reply;
+		char *_label;
+		char _answer[16]; /* Answer to an A query, pointing back at the question. */
 
 		/* Methods */
-		void respond(UdpClient& client, char *data, const size_t& length);
+		bool answer(const IPAddress& peer, uint16_t port, const char *data, size_t length);
+		void respond(const IPAddress& peer, uint16_t port, char *data, const size_t& length);
 	};
 }
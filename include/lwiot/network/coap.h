@@ -0,0 +1,243 @@
+/*
+ * CoAP message definitions (RFC 7252).
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/stl/smallvector.h>
+
+#ifndef CONFIG_COAP_OPTIONS
+#define CONFIG_COAP_OPTIONS 12
+#endif
+
+#ifndef CONFIG_COAP_OPTION_STORAGE
+#define CONFIG_COAP_OPTION_STORAGE 96
+#endif
+
+namespace lwiot
+{
+	enum class CoapType : uint8_t {
+		Confirmable,
+		NonConfirmable,
+		Acknowledgement,
+		Reset
+	};
+
+#define COAP_CODE(__class, __detail) static_cast<uint8_t>(((__class) << 5) | (__detail))
+
+	enum CoapCode : uint8_t {
+		COAP_EMPTY = 0,
+		COAP_GET = 1,
+		COAP_POST = 2,
+		COAP_PUT = 3,
+		COAP_DELETE = 4,
+		COAP_FETCH = 5,
+		COAP_PATCH = 6,
+
+		COAP_CREATED = COAP_CODE(2, 1),
+		COAP_DELETED = COAP_CODE(2, 2),
+		COAP_VALID = COAP_CODE(2, 3),
+		COAP_CHANGED = COAP_CODE(2, 4),
+		COAP_CONTENT = COAP_CODE(2, 5),
+		COAP_CONTINUE = COAP_CODE(2, 31),
+
+		COAP_BAD_REQUEST = COAP_CODE(4, 0),
+		COAP_UNAUTHORIZED = COAP_CODE(4, 1),
+		COAP_BAD_OPTION = COAP_CODE(4, 2),
+		COAP_NOT_FOUND = COAP_CODE(4, 4),
+		COAP_METHOD_NOT_ALLOWED = COAP_CODE(4, 5),
+		COAP_REQUEST_ENTITY_INCOMPLETE = COAP_CODE(4, 8),
+		COAP_REQUEST_ENTITY_TOO_LARGE = COAP_CODE(4, 13),
+
+		COAP_INTERNAL_ERROR = COAP_CODE(5, 0),
+		COAP_NOT_IMPLEMENTED = COAP_CODE(5, 1),
+		COAP_SERVICE_UNAVAILABLE = COAP_CODE(5, 3)
+	};
+
+	enum CoapOptionNumber : uint16_t {
+		COAP_OPTION_IF_MATCH = 1,
+		COAP_OPTION_URI_HOST = 3,
+		COAP_OPTION_ETAG = 4,
+		COAP_OPTION_IF_NONE_MATCH = 5,
+		COAP_OPTION_OBSERVE = 6,
+		COAP_OPTION_URI_PORT = 7,
+		COAP_OPTION_LOCATION_PATH = 8,
+		COAP_OPTION_URI_PATH = 11,
+		COAP_OPTION_CONTENT_FORMAT = 12,
+		COAP_OPTION_MAX_AGE = 14,
+		COAP_OPTION_URI_QUERY = 15,
+		COAP_OPTION_ACCEPT = 17,
+		COAP_OPTION_LOCATION_QUERY = 20,
+		COAP_OPTION_BLOCK2 = 23,
+		COAP_OPTION_BLOCK1 = 27,
+		COAP_OPTION_SIZE2 = 28,
+		COAP_OPTION_PROXY_URI = 35,
+		COAP_OPTION_SIZE1 = 60
+	};
+
+	enum CoapContentFormat : uint16_t {
+		COAP_FORMAT_TEXT = 0,
+		COAP_FORMAT_LINK = 40,
+		COAP_FORMAT_OCTETS = 42,
+		COAP_FORMAT_JSON = 50,
+		COAP_FORMAT_CBOR = 60
+	};
+
+	/**
+	 * @brief Value of a Block1 or Block2 option (RFC 7959).
+	 */
+	struct CoapBlock {
+		uint32_t num;
+		bool more;
+		uint16_t size; //!< Block size in bytes, a power of two from 16 to 1024.
+
+		constexpr CoapBlock() : num(0), more(false), size(1024)
+		{
+		}
+
+		constexpr explicit CoapBlock(uint32_t num, bool more, uint16_t size) : num(num), more(more), size(size)
+		{
+		}
+
+		uint32_t encode() const;
+		static bool decode(uint32_t value, CoapBlock& block);
+
+		/**
+		 * @brief Largest valid block size that does not exceed \p size.
+		 */
+		static uint16_t fit(size_t size);
+	};
+
+	/**
+	 * @brief CoAP request or response.
+	 *
+	 * A parsed message refers to the datagram it was parsed from: its options and payload are
+	 * only valid as long as the datagram is. Options added to a message are copied into a fixed
+	 * buffer of CONFIG_COAP_OPTION_STORAGE bytes inside the message, and a payload set with
+	 * setPayload() is referenced, not copied. Payloads written to body() are owned by the
+	 * message, which is how handlers return a representation they build, for example with a
+	 * CborWriter.
+	 */
+	class CoapMessage {
+	public:
+		static constexpr size_t HeaderSize = 4;
+		static constexpr size_t MaxToken = 8;
+
+		explicit CoapMessage();
+		explicit CoapMessage(CoapType type, uint8_t code, uint16_t id = 0);
+		CoapMessage(const CoapMessage& other);
+		~CoapMessage() = default;
+
+		CoapMessage& operator =(const CoapMessage& other);
+
+		/**
+		 * @brief Parse a datagram.
+		 * @return False if \p data is not a valid CoAP message.
+		 */
+		bool parse(const void *data, size_t length);
+
+		/**
+		 * @brief Encode the message into \p buffer.
+		 * @return The message length, or -ENOMEMORY if it does not fit.
+		 */
+		ssize_t encode(void *buffer, size_t size) const;
+
+		CoapType type() const { return this->_type; }
+		uint8_t code() const { return this->_code; }
+		uint16_t id() const { return this->_id; }
+
+		void setType(CoapType type) { this->_type = type; }
+		void setCode(uint8_t code) { this->_code = code; }
+		void setId(uint16_t id) { this->_id = id; }
+
+		bool isRequest() const;
+		bool isResponse() const;
+		bool isEmpty() const { return this->_code == COAP_EMPTY; }
+
+		const uint8_t *token() const { return this->_token; }
+		size_t tokenLength() const { return this->_tokenLength; }
+		void setToken(const void *token, size_t length);
+		bool sameToken(const CoapMessage& other) const;
+
+		/**
+		 * @brief Add an option; repeated options keep the order in which they were added.
+		 * @return False if the option does not fit.
+		 */
+		bool addOption(uint16_t number, const void *value, size_t length);
+		bool addOption(uint16_t number, const StringView& value);
+		bool addOption(uint16_t number, uint32_t value);
+		void removeOption(uint16_t number);
+
+		/**
+		 * @brief Find the \p index'th option \p number.
+		 * @return False if the message does not have it.
+		 */
+		bool option(uint16_t number, RawBuffer& value, size_t index = 0) const;
+		bool option(uint16_t number, uint32_t& value) const;
+		bool hasOption(uint16_t number) const;
+
+		/**
+		 * @brief Set the Uri-Path options from a path such as <tt>/sensors/temp</tt>.
+		 */
+		bool setPath(const StringView& path);
+
+		/**
+		 * @brief Write the Uri-Path options as a path into \p buffer.
+		 * @return The length of the path, or 0 if it does not fit; the root path is <tt>/</tt>.
+		 */
+		size_t path(char *buffer, size_t length) const;
+		String path() const;
+
+		bool block(uint16_t number, CoapBlock& block) const;
+		bool setBlock(uint16_t number, const CoapBlock& block);
+		bool setContentFormat(uint16_t format);
+
+		const uint8_t *payload() const;
+		size_t payloadLength() const;
+
+		/**
+		 * @brief Refer to \p length bytes at \p data as the payload.
+		 * @note The data must stay valid until the message was encoded.
+		 */
+		void setPayload(const void *data, size_t length);
+
+		/**
+		 * @brief Payload owned by the message. Writing to it replaces a payload set with setPayload().
+		 */
+		ByteBuffer& body();
+
+	private:
+		struct Option {
+			uint16_t number;
+			uint16_t length;
+			const uint8_t *value;
+		};
+
+		CoapType _type;
+		uint8_t _code;
+		uint16_t _id;
+		uint8_t _token[MaxToken];
+		uint8_t _tokenLength;
+
+		stl::SmallVector<Option, CONFIG_COAP_OPTIONS> _options;
+		uint8_t _storage[CONFIG_COAP_OPTION_STORAGE];
+		size_t _used;
+
+		const uint8_t *_payload;
+		size_t _payloadLength;
+		ByteBuffer _body;
+
+		void copy(const CoapMessage& other);
+	};
+}
@@ -0,0 +1,337 @@
+/*
+ * CoAP client and server.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/uniquepointer.h>
+
+#include <lwiot/kernel/thread.h>
+#include <lwiot/kernel/timer.h>
+#include <lwiot/kernel/lock.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/stl/vector.h>
+
+#include <lwiot/util/poolallocator.h>
+
+#include <lwiot/network/coap.h>
+#include <lwiot/network/ipaddress.h>
+#include <lwiot/network/udpclient.h>
+#include <lwiot/network/udpserver.h>
+#include <lwiot/network/httprouter.h>
+#include <lwiot/network/requesthandler.h>
+
+#ifndef CONFIG_COAP_MESSAGE_SIZE
+#define CONFIG_COAP_MESSAGE_SIZE 640
+#endif
+
+#ifndef CONFIG_COAP_MESSAGES
+#define CONFIG_COAP_MESSAGES 8
+#endif
+
+#ifndef CONFIG_COAP_BLOCK_SIZE
+#define CONFIG_COAP_BLOCK_SIZE 512
+#endif
+
+#ifndef CONFIG_COAP_MAX_BODY
+#define CONFIG_COAP_MAX_BODY 8192
+#endif
+
+#ifndef CONFIG_COAP_ACK_TIMEOUT
+#define CONFIG_COAP_ACK_TIMEOUT 2000
+#endif
+
+#ifndef CONFIG_COAP_MAX_RETRANSMIT
+#define CONFIG_COAP_MAX_RETRANSMIT 4
+#endif
+
+#ifndef CONFIG_COAP_RESPONSE_TIMEOUT
+#define CONFIG_COAP_RESPONSE_TIMEOUT 10000
+#endif
+
+#ifndef CONFIG_COAP_EXCHANGE_LIFETIME
+#define CONFIG_COAP_EXCHANGE_LIFETIME 247000
+#endif
+
+#ifndef CONFIG_COAP_DUPLICATES
+#define CONFIG_COAP_DUPLICATES 4
+#endif
+
+#ifndef CONFIG_COAP_OBSERVERS
+#define CONFIG_COAP_OBSERVERS 8
+#endif
+
+#ifndef CONFIG_COAP_PATH_LENGTH
+#define CONFIG_COAP_PATH_LENGTH 96
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief CoAP endpoint (RFC 7252) that serves resources and sends requests.
+	 *
+	 * Resources are routed by the same HttpRouter as HttpServer routes, so patterns such as
+	 * <tt>/sensors/{id}</tt> work the same. Handlers build the response in place; a handler
+	 * that returns CBOR writes it with a CborWriter to CoapMessage::body() and sets the content
+	 * format to COAP_FORMAT_CBOR.
+	 *
+	 * Confirmable messages are retransmitted from a timer, with the exponential back-off of
+	 * the RFC, so the receive thread only wakes up for datagrams. Encoded messages live in a
+	 * pool of CONFIG_COAP_MESSAGES buffers of CONFIG_COAP_MESSAGE_SIZE bytes: one for the
+	 * receive buffer, one for each request and confirmable notification in flight, and one for
+	 * each response that is kept to answer duplicate requests. The latter are evicted, oldest
+	 * first, when the pool runs out.
+	 *
+	 * Observe (RFC 7641) and block-wise transfers (RFC 7959) are handled by the endpoint.
+	 * Representations larger than CONFIG_COAP_BLOCK_SIZE are sent in blocks, and responses
+	 * and uploads that come in blocks are reassembled, up to CONFIG_COAP_MAX_BODY bytes, before
+	 * they are passed to a handler.
+	 *
+	 * @code
+	 * lwiot::CoapEndpoint coap;
+	 *
+	 * coap.on("/sensors/{id}", COAP_GET, [](const CoapMessage& request, CoapMessage& response,
+	 *                                       const HttpPathArgs& args) {
+	 *	lwiot::CborWriter cbor(response.body());
+	 *	cbor.beginMap(1).member("t", 21);
+	 *	response.setContentFormat(COAP_FORMAT_CBOR);
+	 * });
+	 *
+	 * coap.begin(new lwiot::SocketUdpServer(BIND_ADDR_ANY, 5683));
+	 * coap.notify("/sensors/1");
+	 * @endcode
+	 *
+	 * @note Handlers run on the receive thread, or on the timer thread for timeouts, with the
+	 *       endpoint locked. They may send requests and notifications, but should not block.
+	 */
+	class CoapEndpoint : public Thread {
+	public:
+		/**
+		 * @brief Resource handler. The response arrives as 2.05 Content, with an empty payload.
+		 */
+		typedef Function<void(const CoapMessage& request, CoapMessage& response, const HttpPathArgs& args)> Handler;
+
+		/**
+		 * @brief Response handler; \p response is nullptr when the request timed out or was rejected.
+		 */
+		typedef Function<void(const CoapMessage* response)> ResponseHandler;
+
+		struct Statistics {
+			uint32_t sent; //!< Datagrams sent, including retransmissions.
+			uint32_t received; //!< Datagrams received.
+			uint32_t retransmissions; //!< Confirmable messages that had to be sent again.
+			uint32_t timeouts; //!< Requests and notifications that were not answered.
+			uint32_t duplicates; //!< Requests that were answered from the duplicate cache.
+		};
+
+		static constexpr uint16_t DefaultPort = 5683;
+
+		explicit CoapEndpoint();
+		~CoapEndpoint() override;
+
+		CoapEndpoint(const CoapEndpoint&) = delete;
+		CoapEndpoint& operator=(const CoapEndpoint&) = delete;
+
+		/**
+		 * @brief Start serving and receiving responses on \p server, which must be bound.
+		 * @note The endpoint takes ownership of \p server.
+		 */
+		void begin(UdpServer *server);
+		void end();
+
+		/**
+		 * @brief Add a resource.
+		 * @param method Request code to handle, or COAP_EMPTY for all methods.
+		 * @return False if the resource already has a handler for \p method.
+		 */
+		bool on(const StringView& pattern, uint8_t method, const Handler& handler);
+
+		/**
+		 * @brief Send \p request, which may be confirmable or not.
+		 *
+		 * The message ID and, unless the request has one, the token are assigned here. Payloads
+		 * larger than CONFIG_COAP_BLOCK_SIZE are uploaded in blocks.
+		 *
+		 * @return False if the request could not be sent.
+		 */
+		bool request(const IPAddress& addr, uint16_t port, CoapMessage& request, const ResponseHandler& handler);
+		bool get(const IPAddress& addr, uint16_t port, const StringView& path, const ResponseHandler& handler);
+
+		/**
+		 * @brief Observe the resource at \p path; \p handler is called for every fresh notification.
+		 * @return An observation handle for cancel(), or a negative error code.
+		 */
+		int observe(const IPAddress& addr, uint16_t port, const StringView& path, const ResponseHandler& handler);
+
+		/**
+		 * @brief Stop an observation. The server is told with a reset on its next notification.
+		 */
+		void cancel(int observation);
+
+		/**
+		 * @brief Send the current representation of \p path to its observers.
+		 * @param confirmable Send confirmable notifications; observers that do not acknowledge
+		 *                    them are removed.
+		 * @return The number of notifications sent.
+		 */
+		size_t notify(const StringView& path, bool confirmable = false);
+		size_t observers() const;
+
+		Statistics statistics() const;
+
+		/**
+		 * @brief Change the initial retransmission time out and the number of retransmissions.
+		 */
+		void setAckTimeout(int ms, int retransmissions = CONFIG_COAP_MAX_RETRANSMIT);
+
+	protected:
+		void run() override;
+
+	private:
+		typedef BlockPool<CONFIG_COAP_MESSAGE_SIZE, CONFIG_COAP_MESSAGES> Pool;
+
+		class Retransmitter : public Timer {
+		public:
+			explicit Retransmitter(CoapEndpoint& endpoint);
+
+		protected:
+			void tick() override;
+
+		private:
+			CoapEndpoint& _endpoint;
+		};
+
+		struct Route : public RequestHandler {
+			explicit Route(const Handler& handler) : handler(handler)
+			{
+			}
+
+			Handler handler;
+		};
+
+		struct Peer {
+			IPAddress addr;
+			uint16_t port;
+			uint8_t token[CoapMessage::MaxToken];
+			uint8_t tokenLength;
+
+			void set(const IPAddress& addr, uint16_t port, const CoapMessage& msg);
+			bool matches(const IPAddress& addr, uint16_t port) const;
+			bool matches(const IPAddress& addr, uint16_t port, const CoapMessage& msg) const;
+		};
+
+		struct Exchange {
+			Peer peer;
+			int handle;
+			uint16_t id;
+			uint8_t *message; //!< Last message sent, from the pool.
+			size_t length;
+			bool confirmable;
+			bool acknowledged;
+			bool notification; //!< Confirmable notification of ours, without a handler.
+			bool observe;
+			int attempts;
+			time_t timeout;
+			time_t due; //!< Next retransmission or time out, 0 while waiting for notifications.
+			ResponseHandler handler;
+
+			ByteBuffer upload; //!< Body of a block-wise request.
+			ByteBuffer download; //!< Body of a block-wise response.
+			uint32_t sequence; //!< Observe sequence number of the last notification.
+			time_t notified;
+		};
+
+		struct Observer {
+			Peer peer;
+			String path;
+			uint32_t sequence;
+			uint16_t last; //!< Message ID of the last notification.
+		};
+
+		struct Duplicate {
+			IPAddress addr;
+			uint16_t port;
+			uint16_t id;
+			uint8_t *response;
+			size_t length;
+			time_t expires;
+		};
+
+		struct Upload {
+			IPAddress addr;
+			uint16_t port;
+			String path;
+			ByteBuffer body;
+			uint32_t next;
+			time_t expires;
+		};
+
+		mutable Lock _lock;
+		UniquePointer<UdpServer> _udp;
+		Retransmitter _timer;
+		bool _running;
+		Pool _pool;
+		uint8_t *_rx;
+
+		HttpRouter _router;
+		stl::Vector<Route*> _routes;
+		stl::Vector<Exchange*> _exchanges;
+		stl::Vector<Observer*> _observers;
+		stl::Vector<Upload*> _uploads;
+		Duplicate _duplicates[CONFIG_COAP_DUPLICATES];
+		size_t _duplicate;
+
+		int _ackTimeout;
+		int _maxRetransmit;
+		uint16_t _id;
+		uint32_t _token;
+		int _handle;
+		Statistics _stats;
+
+		/* Server */
+		void serve(const CoapMessage& request, const IPAddress& addr, uint16_t port);
+		bool upload(const CoapMessage& request, const IPAddress& addr, uint16_t port, const StringView& path,
+		            CoapMessage& response, Upload*& upload);
+		void dispatch(const CoapMessage& request, const StringView& path, CoapMessage& response);
+		void observe(const CoapMessage& request, const IPAddress& addr, uint16_t port, const StringView& path,
+		             CoapMessage& response);
+		static void slice(const CoapMessage& request, CoapMessage& response);
+		void remove(Upload *upload);
+		void remove(Observer *observer);
+
+		/* Client */
+		void receive(const CoapMessage& msg, const IPAddress& addr, uint16_t port);
+		void complete(Exchange *exchange, const CoapMessage& response);
+		void deliver(Exchange *exchange, const CoapMessage& response);
+		bool follow(Exchange *exchange, uint16_t option, const CoapBlock& block);
+		bool transmit(Exchange *exchange, const CoapMessage& msg);
+		Exchange *find(const IPAddress& addr, uint16_t port, uint16_t id) const;
+		Exchange *find(const IPAddress& addr, uint16_t port, const CoapMessage& msg) const;
+		void remove(Exchange *exchange);
+		void fail(Exchange *exchange);
+
+		/* Shared */
+		void expire();
+		void arm(time_t now);
+		uint8_t *acquire();
+		void release(uint8_t *buffer);
+		bool send(const CoapMessage& msg, const IPAddress& addr, uint16_t port, uint8_t **keep = nullptr,
+		          size_t *length = nullptr);
+		void empty(CoapType type, const IPAddress& addr, uint16_t port, uint16_t id);
+		void remember(const IPAddress& addr, uint16_t port, uint16_t id, uint8_t *response, size_t length);
+		const Duplicate *duplicate(const IPAddress& addr, uint16_t port, uint16_t id) const;
+		time_t initialTimeout();
+	};
+}
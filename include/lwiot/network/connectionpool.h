@@ -0,0 +1,143 @@
+/*
+ * Pool of reusable TCP connections.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/network/tcpclient.h>
+#include <lwiot/network/tlssessioncache.h>
+#include <lwiot/network/securetcpclient.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/vector.h>
+
+#ifndef CONFIG_POOL_MAX_PER_HOST
+#define CONFIG_POOL_MAX_PER_HOST 2
+#endif
+
+#ifndef CONFIG_POOL_IDLE_TIMEOUT
+#define CONFIG_POOL_IDLE_TIMEOUT 30000
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Keep connections open between requests, so that each request does not pay for DNS, the
+	 *        TCP handshake and, for TLS, the TLS handshake.
+	 *
+	 * Connections are keyed by host, port and whether they use TLS. acquire() hands out a Lease on an
+	 * idle connection, or opens a new one while the host is below its connection limit. Connections
+	 * return to the pool when the lease ends. Idle connections are closed once they have been
+	 * unused for the idle timeout, or when the peer closed them. New TLS connections resume the
+	 * session of an earlier connection to the same host when the TLS binding supports it.
+	 */
+	class ConnectionPool {
+	private:
+		struct Connection {
+			String host;
+			uint16_t port;
+			bool secure;
+			bool leased;
+			time_t used;
+			TcpClient *client;
+		};
+
+	public:
+		/**
+		 * @brief Exclusive use of a pooled connection. The connection goes back to the pool when
+		 *        the lease is destroyed or released.
+		 */
+		class Lease {
+		public:
+			Lease();
+			Lease(Lease&& other) noexcept;
+			~Lease();
+
+			Lease(const Lease&) = delete;
+			Lease& operator=(const Lease&) = delete;
+			Lease& operator=(Lease&& other) noexcept;
+
+			explicit operator bool() const;
+
+			TcpClient& client() const;
+			TcpClient& operator*() const;
+			TcpClient* operator->() const;
+
+			/**
+			 * @brief Return the connection to the pool.
+			 */
+			void release();
+
+			/**
+			 * @brief Close the connection instead of returning it, e.g. after a protocol error
+			 *        or when the server did not agree to keep it alive.
+			 */
+			void discard();
+
+		private:
+			friend class ConnectionPool;
+
+			ConnectionPool *_pool;
+			Connection *_connection;
+
+			explicit Lease(ConnectionPool* pool, Connection* connection);
+		};
+
+		explicit ConnectionPool(size_t perhost = CONFIG_POOL_MAX_PER_HOST, int idle = CONFIG_POOL_IDLE_TIMEOUT);
+		virtual ~ConnectionPool();
+
+		ConnectionPool(const ConnectionPool&) = delete;
+		ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+		/**
+		 * @brief Lease a connection to \p host.
+		 * @param host Host name or address.
+		 * @param port Port number.
+		 * @param secure Use TLS.
+		 * @return A lease, which is empty if the host is at its limit or the connect failed.
+		 */
+		Lease acquire(const String& host, uint16_t port, bool secure = false);
+
+		void setConnectTimeout(int ms);
+		void setServerCertificate(const String& cert);
+		void setRecordSize(size_t size);
+
+		/**
+		 * @brief Close idle connections that timed out or that the peer closed.
+		 */
+		void purge();
+		void clear();
+
+		size_t size() const;
+		size_t idle() const;
+
+	protected:
+		/**
+		 * @brief Open a new connection.
+		 * @return The connected client, or nullptr on failure.
+		 */
+		virtual TcpClient* create(const String& host, uint16_t port, bool secure);
+
+	private:
+		mutable Lock _lock;
+		stl::Vector<Connection*> _connections;
+		size_t _perhost;
+		int _idle;
+		int _connect_tmo;
+		size_t _record_size;
+		String _cert;
+		TlsSessionCache _sessions;
+
+		void giveBack(Connection* connection, bool reuse);
+		void remove(size_t idx);
+		void expire(time_t now);
+	};
+}
@@ -0,0 +1,76 @@
+/*
+ * Batch of UDP datagrams.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/network/ipaddress.h>
+#include <lwiot/network/stdnet.h>
+
+#ifndef CONFIG_DATAGRAM_MTU
+#define CONFIG_DATAGRAM_MTU 1472
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Fixed set of datagram buffers, filled or drained in bulk by a UdpServer.
+	 *
+	 * All buffers are allocated once, up front. Each datagram carries its peer address by value,
+	 * so receiving a burst of packets does not allocate.
+	 *
+	 * @see UdpServer::recvBatch
+	 * @see UdpServer::sendBatch
+	 */
+	class DatagramBatch {
+	public:
+		explicit DatagramBatch(size_t capacity, size_t mtu = CONFIG_DATAGRAM_MTU);
+		virtual ~DatagramBatch();
+
+		DatagramBatch(const DatagramBatch&) = delete;
+		DatagramBatch& operator=(const DatagramBatch&) = delete;
+
+		size_t capacity() const;
+		size_t size() const;
+		size_t mtu() const;
+		void clear();
+
+		/**
+		 * @brief Queue a datagram for sendBatch().
+		 * @param data Datagram payload, copied into the batch.
+		 * @param length Payload length, at most mtu() bytes.
+		 * @param addr Peer address.
+		 * @param port Peer port, in host order.
+		 * @return False if the batch is full or the payload too large.
+		 */
+		bool add(const void *data, size_t length, const IPAddress& addr, uint16_t port);
+
+		uint8_t *data(size_t idx);
+		const uint8_t *data(size_t idx) const;
+		size_t length(size_t idx) const;
+		IPAddress address(size_t idx) const;
+		uint16_t port(size_t idx) const;
+
+		/**
+		 * @brief Prepare the first \p num buffers for receiving.
+		 * @return The raw datagram array, for use with udp_recv_batch().
+		 */
+		socket_datagram_t *prepare(size_t num);
+		socket_datagram_t *datagrams() const;
+		void setSize(size_t size);
+
+	private:
+		uint8_t *_buffer;
+		socket_datagram_t *_datagrams;
+		size_t _capacity;
+		size_t _mtu;
+		size_t _size;
+	};
+}
@@ -0,0 +1,148 @@
+/*
+ * Streaming delta firmware update.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/compression.h>
+#include <lwiot/io/blockdevice.h>
+#include <lwiot/network/uploadsink.h>
+#include <lwiot/network/sha256.h>
+
+#ifndef CONFIG_DELTA_WINDOW
+#define CONFIG_DELTA_WINDOW 8
+#endif
+
+#ifndef CONFIG_DELTA_LOOKAHEAD
+#define CONFIG_DELTA_LOOKAHEAD 4
+#endif
+
+#ifndef CONFIG_DELTA_BLOCK_SIZE
+#define CONFIG_DELTA_BLOCK_SIZE 256
+#endif
+
+#define DELTA_HEADER_SIZE 24
+
+namespace lwiot
+{
+	/**
+	 * @brief Apply a compressed binary delta to a firmware image while it is being received.
+	 *
+	 * Patches are bsdiff patches in the single stream ENDSLEY/BSDIFF43 format, with the stream
+	 * after the 24 byte header compressed by heatshrink instead of bzip2
+	 * (`heatshrink -e -w CONFIG_DELTA_WINDOW -l CONFIG_DELTA_LOOKAHEAD`). The new image is built
+	 * from the running image on \p source and written to \p target, a different partition, in
+	 * blocks of CONFIG_DELTA_BLOCK_SIZE bytes. Memory use does not depend on the size of the
+	 * patch or the image: one block, the decoder window and a SHA-256 context.
+	 *
+	 * The SHA-256 digest of the new image is computed as it is written; finish() fails unless
+	 * the image is complete and, if expect() was called, its digest matches. The target must
+	 * erase flash as it is written, and the new image should only be booted after finish()
+	 * succeeded.
+	 *
+	 * The update is an UploadSink, so an HttpServer upload handler can attach it to a multipart
+	 * upload. For MQTT, pass the chunks of MqttClient::setChunkHandler() to receive().
+	 */
+	class DeltaUpdate : public UploadSink {
+	public:
+		enum class Error {
+			None,
+			Format, //!< The patch is malformed or not a delta patch.
+			Source, //!< The running image could not be read.
+			Target, //!< The new image could not be written.
+			Size, //!< The patch ended before the new image was complete.
+			Digest //!< The new image does not match the expected digest.
+		};
+
+		explicit DeltaUpdate(BlockDevice& source, BlockDevice& target);
+		~DeltaUpdate() override = default;
+
+		DeltaUpdate(const DeltaUpdate&) = delete;
+		DeltaUpdate& operator=(const DeltaUpdate&) = delete;
+
+		/**
+		 * @brief Set the SHA-256 digest that the new image must have.
+		 */
+		void expect(const uint8_t *digest);
+
+		/**
+		 * @brief Prepare for a new patch. The expected digest is kept.
+		 */
+		void reset();
+
+		bool write(const uint8_t *data, size_t length) override;
+		bool finish() override;
+		void abort() override;
+
+		/**
+		 * @brief Feed a chunk of an MQTT message that carries a patch.
+		 *
+		 * A chunk at \p offset 0 starts a new update; the last chunk finishes it.
+		 * @return False if the update failed.
+		 */
+		bool receive(size_t offset, const RawBuffer& span, size_t total);
+
+		/**
+		 * @brief Size of the new image, once the patch header has been received.
+		 */
+		size_t size() const;
+		size_t written() const;
+
+		Error error() const;
+		const uint8_t *digest() const;
+
+	private:
+		enum class State {
+			Header,
+			Control,
+			Diff,
+			Extra,
+			Done,
+			Failed
+		};
+
+		BlockDevice& _source;
+		BlockDevice& _target;
+		HeatshrinkDecoder _decoder;
+		sha256_context_t _sha;
+
+		State _state;
+		Error _error;
+
+		/* The patch header, and then each control record, is collected here. */
+		uint8_t _record[DELTA_HEADER_SIZE];
+		size_t _used;
+
+		int64_t _old;
+		size_t _new;
+		size_t _size;
+		size_t _run;
+		size_t _extra;
+		int64_t _seek;
+
+		uint8_t _block[CONFIG_DELTA_BLOCK_SIZE];
+		size_t _fill;
+
+		bool _check;
+		uint8_t _expected[SHA256_DIGEST_SIZE];
+		uint8_t _digest[SHA256_DIGEST_SIZE];
+
+		bool header(const uint8_t *&data, size_t& length);
+		bool control();
+		void next();
+		bool apply(const uint8_t *data, size_t length);
+		bool diff(const uint8_t *data, size_t length);
+		bool emit(const uint8_t *data, size_t length);
+		bool flush();
+		bool fail(Error error);
+	};
+}
@@ -10,20 +10,102 @@
 #include <stdlib.h>
 #include <lwiot.h>
 
+#include <lwiot/function.h>
 #include <lwiot/network/udpclient.h>
 #include <lwiot/network/stdnet.h>
 
 #include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/executor.h>
+#include <lwiot/stl/vector.h>
+
+#ifndef CONFIG_DNS_CACHE_SIZE
+#define CONFIG_DNS_CACHE_SIZE 8
+#endif
+
+#ifndef CONFIG_DNS_CACHE_TTL
+#define CONFIG_DNS_CACHE_TTL 60000
+#endif
+
+#ifndef CONFIG_DNS_NEGATIVE_TTL
+#define CONFIG_DNS_NEGATIVE_TTL 10000
+#endif
 
 namespace lwiot
 {
+	/**
+	 * @brief Resolve host names, caching the results.
+	 *
+	 * Successful lookups are cached for the positive TTL and failed lookups for the negative TTL,
+	 * so a reconnect loop does not block in the resolver on every attempt. When the stack
+	 * supports IPv6, A and AAAA records are queried in a single resolver call.
+	 *
+	 * @note The system resolver does not report record TTLs. The cache lifetimes are therefore
+	 *       fixed upper bounds, which should not exceed the TTLs of the records involved.
+	 */
 	class DnsClient {
 	public:
-		explicit DnsClient();
+		/**
+		 * @brief Lookup completion handler.
+		 * @param host Host name that was resolved.
+		 * @param address Address of \p host, or 0.0.0.0 if it could not be resolved.
+		 */
+		typedef Function<void(const String& host, const IPAddress& address)> Handler;
+
+		explicit DnsClient(int ttl = CONFIG_DNS_CACHE_TTL, int negative = CONFIG_DNS_NEGATIVE_TTL);
+		virtual ~DnsClient();
+
+		DnsClient(const DnsClient&) = delete;
+		DnsClient& operator=(const DnsClient&) = delete;
 
 		IPAddress lookup(const stl::String& domain) const;
 
+		/**
+		 * @brief Resolve \p domain without blocking the caller.
+		 *
+		 * Cached results are passed to \p handler before this method returns. Otherwise the
+		 * lookup runs as a task on \p executor and \p handler is called from that task.
+		 * Concurrent lookups of the same host share a single query.
+		 *
+		 * @param domain Host name to resolve.
+		 * @param executor Executor to run the query on.
+		 * @param handler Completion handler.
+		 * @return False if the lookup could not be queued.
+		 * @note The client has to outlive all pending lookups.
+		 */
+		bool lookup(const stl::String& domain, Executor& executor, const Handler& handler);
+
+		/**
+		 * @brief Look \p domain up in the cache only.
+		 * @param domain Host name.
+		 * @param address Cached address. Set to 0.0.0.0 for a cached failure.
+		 * @return True if a result was cached.
+		 */
+		bool cached(const stl::String& domain, IPAddress& address) const;
+
+		void flush();
+
 	private:
+		struct Entry {
+			String host;
+			IPAddress address;
+			bool found;
+			bool pending;
+			time_t expires;
+			stl::Vector<Handler> waiters;
+		};
+
 		mutable Lock _lock;
+		mutable stl::Vector<Entry*> _entries;
+		int _ttl;
+		int _negative;
+
+		static bool resolve(const String& domain, IPAddress& address);
+
+		ssize_t find(const String& domain) const;
+		void insert(Entry* entry) const;
+		void store(const String& domain, const IPAddress& address, bool found) const;
+		void complete(const String& domain, const IPAddress& address, bool found);
+		void erase(size_t idx) const;
+		void expire(time_t now) const;
 	};
 }
@@ -13,6 +13,7 @@
 #include <lwiot/types.h>
 #include <lwiot/error.h>
 #include <lwiot/uniquepointer.h>
+#include <lwiot/bytebuffer.h>
 
 #include <lwiot/kernel/thread.h>
 #include <lwiot/kernel/lock.h>
@@ -22,10 +23,23 @@
 #include <lwiot/network/udpserver.h>
 #include <lwiot/network/dns.h>
 
-#include <lwiot/stl/map.h>
+#include <lwiot/stl/unorderedmap.h>
+#include <lwiot/stl/stringview.h>
+
+#ifndef CONFIG_DNS_SERVER_TTL
+#define CONFIG_DNS_SERVER_TTL 0
+#endif
 
 namespace lwiot
 {
+	/**
+	 * @brief DNS server for a fixed set of host names.
+	 *
+	 * Host names are matched without regard to case. The response to an A query is encoded when
+	 * the record is added, so that answering the common single question query only takes copying
+	 * the response and patching in the ID and the question of the query. Other queries, such as
+	 * those for NS or URI records, are answered as they come in.
+	 */
 	class DnsServer : public Thread {
 	public:
 		explicit DnsServer();
@@ -34,6 +48,9 @@ namespace lwiot
 		void begin(UdpServer* server);
 		void end();
 
+		/**
+		 * @brief Add a record for \p hostname, or replace it.
+		 */
 		void map(const stl::String& hostname, const IPAddress& addr);
 
 	protected:
@@ -41,15 +58,23 @@ namespace lwiot
 		void begin();
 
 	private:
+		struct Record {
+			IPAddress address;
+			ByteBuffer reply; //!< Response to an A query, with ID 0.
+		};
+
 		Lock _lock;
 		UniquePointer<UdpServer> _udp;
-		stl::Map<stl::String, IPAddress> _table;
+		stl::UnorderedMap<stl::String, Record> _table;
 		bool _running;
 		char *_udp_msg;
+		char *_reply;
+		char *_label;
 
 		/* Methods */
-		void respond(UdpClient& client, char *data, const size_t& length);
-		static void respond(UdpClient& client, DnsHeader* hdr, DnsReplyCode drc);
-		bool hasRecord(const String& record);
+		void respond(const IPAddress& peer, uint16_t port, char *data, const size_t& length);
+		void respond(const IPAddress& peer, uint16_t port, DnsHeader* hdr, DnsReplyCode drc);
+		bool answer(const IPAddress& peer, uint16_t port, const char *data, size_t length);
+		bool hasRecord(const stl::StringView& record) const;
 	};
 }
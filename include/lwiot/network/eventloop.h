@@ -0,0 +1,101 @@
+/*
+ * Socket event loop definition.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/function.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/network/stdnet.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/uniquepointer.h>
+
+#ifndef CONFIG_EVENTLOOP_ACCEPT_BATCH
+#define CONFIG_EVENTLOOP_ACCEPT_BATCH 16
+#endif
+
+namespace lwiot
+{
+	class SocketTcpClient;
+	class SocketTcpServer;
+	class SocketUdpServer;
+	class TcpClient;
+
+	/**
+	 * @brief Dispatch socket readiness to callbacks, so that one thread can serve many sockets.
+	 *
+	 * Sockets are registered with the events to wait for (SOCKET_POLL_READ, SOCKET_POLL_WRITE). The
+	 * handler is called with the events that occurred, SOCKET_POLL_ERROR included. Sockets can be
+	 * added and removed from any thread, including from within a handler. Changes made by other
+	 * threads take effect on the next iteration.
+	 *
+	 * @note The loop does not own the registered sockets.
+	 */
+	class EventLoop {
+	public:
+		typedef Function<void(uint32_t events)> Handler;
+		typedef Function<void(UniquePointer<TcpClient>& client)> AcceptHandler;
+
+		explicit EventLoop(int interval = 100);
+		virtual ~EventLoop() = default;
+
+		EventLoop(const EventLoop&) = delete;
+		EventLoop& operator=(const EventLoop&) = delete;
+
+		bool add(socket_t* socket, uint32_t events, const Handler& handler);
+		bool add(SocketTcpClient& client, uint32_t events, const Handler& handler);
+		bool add(SocketTcpServer& server, const Handler& handler);
+		bool add(SocketUdpServer& server, const Handler& handler);
+
+		/**
+		 * @brief Accept connections on \p server whenever it is readable.
+		 *
+		 * Pending connections are drained with SocketTcpServer::acceptMany(), up to
+		 * CONFIG_EVENTLOOP_ACCEPT_BATCH per wake up. \p handler is called for each of them and may
+		 * take ownership of the client.
+		 */
+		bool accept(SocketTcpServer& server, const AcceptHandler& handler);
+
+		bool modify(socket_t* socket, uint32_t events);
+		bool remove(socket_t* socket);
+
+		size_t size() const;
+
+		/**
+		 * @brief Wait for events and dispatch them once.
+		 * @param tmo Timeout in milliseconds.
+		 * @return The number of handlers called, or a negative error code.
+		 */
+		int poll(int tmo = FOREVER);
+
+		/**
+		 * @brief Dispatch events until stop() is called.
+		 * @note Waits at most \p interval milliseconds at a time, which bounds the delay of stop().
+		 */
+		void run();
+		void stop();
+
+	private:
+		struct Entry {
+			socket_t* socket;
+			uint32_t events;
+			Handler handler;
+		};
+
+		mutable Lock _lock;
+		stl::Vector<Entry> _entries;
+		stl::Vector<socket_poll_t> _polls;
+		AtomicBool _running;
+		int _interval;
+
+		int find(socket_t* socket) const;
+	};
+}
@@ -0,0 +1,61 @@
+/*
+ * Server-Sent Events endpoint.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/network/httppushendpoint.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Server-Sent Events (text/event-stream) endpoint.
+	 *
+	 * Each broadcast is rendered once into a shared buffer and written to every subscriber. Browsers
+	 * reconnect by themselves when the stream ends, after the retry interval.
+	 */
+	class EventSource : public HttpPushEndpoint {
+	public:
+		explicit EventSource(size_t subscribers = CONFIG_HTTP_PUSH_SUBSCRIBERS);
+		~EventSource() override = default;
+
+		/**
+		 * @brief Send an event to all subscribers.
+		 * @param data Event data. Each line is sent as a separate data field.
+		 * @param event Event type, the default type "message" when empty.
+		 * @param id Event ID, sent back by browsers in the Last-Event-ID header when they reconnect.
+		 * @return The number of subscribers that received the event.
+		 */
+		size_t broadcast(StringView data, StringView event = StringView(), StringView id = StringView());
+
+		/**
+		 * @brief Send a comment, which keeps idle streams from being closed by proxies.
+		 * @return The number of subscribers that received the comment.
+		 */
+		size_t heartbeat();
+
+		/**
+		 * @brief Ask new subscribers to wait \p ms milliseconds before reconnecting.
+		 */
+		void setRetry(int ms);
+
+	protected:
+		UniquePointer<TcpClient> handshake(HttpServer& server) override;
+
+	private:
+		ByteBuffer _frame;
+		int _retry;
+
+		void field(StringView name, StringView value);
+	};
+}
@@ -0,0 +1,118 @@
+/*
+ * HTTP chunked body writer.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/network/tcpclient.h>
+
+#ifndef CONFIG_HTTP_CHUNK_BUFFER
+#define CONFIG_HTTP_CHUNK_BUFFER 1024
+#endif
+
+#ifndef CONFIG_HTTP_CHUNK_TIMEOUT
+#define CONFIG_HTTP_CHUNK_TIMEOUT 5000
+#endif
+
+/* zlib window (2^bits bytes) and memory level, kept small for devices with little RAM. */
+#ifndef CONFIG_HTTP_DEFLATE_WINDOW_BITS
+#define CONFIG_HTTP_DEFLATE_WINDOW_BITS 12
+#endif
+
+#ifndef CONFIG_HTTP_DEFLATE_MEM_LEVEL
+#define CONFIG_HTTP_DEFLATE_MEM_LEVEL 4
+#endif
+
+namespace lwiot
+{
+	enum class HttpContentCoding {
+		Identity,
+		Gzip,
+		Deflate
+	};
+
+	/**
+	 * @brief Streams a response body of unknown length.
+	 *
+	 * Data is collected in a buffer of CONFIG_HTTP_CHUNK_BUFFER bytes and every time it fills up, it
+	 * is sent as one chunk. Before a chunk is sent, the writer waits until the connection accepts
+	 * more data, so a producer that is faster than the network is held back instead of using more
+	 * memory. The body can be compressed on the fly when lwIoT is built with zlib (HAVE_ZLIB).
+	 */
+	class HttpChunkedWriter {
+	public:
+		explicit HttpChunkedWriter(size_t size = CONFIG_HTTP_CHUNK_BUFFER);
+		virtual ~HttpChunkedWriter();
+
+		HttpChunkedWriter(const HttpChunkedWriter&) = delete;
+		HttpChunkedWriter& operator=(const HttpChunkedWriter&) = delete;
+
+		/**
+		 * @brief Start a body.
+		 * @param client Connection to write to.
+		 * @param chunked Use chunked transfer encoding. HTTP/1.0 bodies are written as they are and
+		 *                end when the connection is closed.
+		 * @param coding Content coding of the body.
+		 * @return False if \p coding is not supported.
+		 */
+		bool begin(TcpClient& client, bool chunked, HttpContentCoding coding = HttpContentCoding::Identity);
+
+		/**
+		 * @brief Add \p length bytes to the body.
+		 * @return \p length, or a negative error code when the connection failed or did not accept
+		 *         data within CONFIG_HTTP_CHUNK_TIMEOUT milliseconds.
+		 */
+		ssize_t write(const void *data, size_t length);
+
+		/**
+		 * @brief Send the buffered data now, instead of waiting for the buffer to fill up.
+		 */
+		bool flush();
+
+		/**
+		 * @brief Send the remaining data and end the body.
+		 * @return False if the body could not be completed.
+		 */
+		bool end();
+
+		bool active() const;
+		bool failed() const;
+
+		/**
+		 * @brief Check whether lwIoT can produce a content coding.
+		 */
+		static bool supports(HttpContentCoding coding);
+
+		/**
+		 * @brief Name of a content coding, as used in Content-Encoding headers.
+		 */
+		static StringView name(HttpContentCoding coding);
+
+	private:
+		TcpClient *_client;
+		ByteBuffer _buffer;
+		size_t _size;
+		size_t _length;
+		bool _chunked;
+		bool _failed;
+		void *_stream;
+
+		ssize_t append(const void *data, size_t length);
+		ssize_t compress(const void *data, size_t length, int mode);
+		bool sendChunk();
+		bool sendDirect(const void *data, size_t length);
+		bool wait();
+		void fail();
+		void release();
+	};
+}
@@ -0,0 +1,96 @@
+/*
+ * Well-known HTTP header names.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/stringview.h>
+
+namespace lwiot
+{
+	namespace http
+	{
+		/**
+		 * @brief Request headers the server knows by name.
+		 * @note Keep this list in the same order as the names in httpheaders.cpp.
+		 */
+		enum class Header : uint8_t {
+			Accept,
+			AcceptCharset,
+			AcceptEncoding,
+			AcceptLanguage,
+			Authorization,
+			CacheControl,
+			Connection,
+			ContentDisposition,
+			ContentEncoding,
+			ContentLength,
+			ContentType,
+			Cookie,
+			Date,
+			Expect,
+			Host,
+			IfMatch,
+			IfModifiedSince,
+			IfNoneMatch,
+			IfRange,
+			IfUnmodifiedSince,
+			KeepAlive,
+			Origin,
+			Pragma,
+			Range,
+			Referer,
+			SecWebSocketExtensions,
+			SecWebSocketKey,
+			SecWebSocketProtocol,
+			SecWebSocketVersion,
+			TransferEncoding,
+			Upgrade,
+			UserAgent,
+			XForwardedFor,
+			XRequestedWith,
+			Unknown
+		};
+
+		constexpr size_t HeaderCount = static_cast<size_t>(Header::Unknown);
+
+		/**
+		 * @brief Case insensitive FNV-1a hash of a header name.
+		 */
+		constexpr uint32_t hash(StringView name)
+		{
+			uint32_t value = 2166136261U;
+
+			for(auto c : name) {
+				value ^= static_cast<uint8_t>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+				value *= 16777619U;
+			}
+
+			return value;
+		}
+
+		/**
+		 * @brief Find a well-known header by its case insensitive name, using a perfect hash.
+		 * @return The header, or Header::Unknown.
+		 */
+		Header lookup(StringView name);
+
+		/**
+		 * @brief Find a well-known header by the hash() of its name.
+		 */
+		Header lookup(StringView name, uint32_t hash);
+
+		/**
+		 * @brief Canonical name of a well-known header.
+		 */
+		StringView name(Header header);
+	}
+}
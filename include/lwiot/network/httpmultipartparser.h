@@ -0,0 +1,119 @@
+/*
+ * Streaming multipart/form-data parser.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+
+#ifndef CONFIG_HTTP_MULTIPART_BUFFER
+#define CONFIG_HTTP_MULTIPART_BUFFER 2048
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Headers of a single part of a multipart body.
+	 * @note The views point into the parser buffer and are only valid during the begin handler.
+	 */
+	struct HttpMultipartPart {
+		StringView name;
+		StringView filename;
+		StringView type;
+		bool file;
+	};
+
+	/**
+	 * @brief Block wise parser for multipart/form-data bodies.
+	 *
+	 * The body is received into an internal buffer and the delimiters are located using a
+	 * Boyer-Moore-Horspool search, so the content of a part is handed to the data handler in blocks
+	 * that point straight into that buffer. Only the bytes that could be the start of a delimiter are
+	 * held back until more data arrives.
+	 *
+	 * Handlers can return false to stop parsing, after which the parser reports failed().
+	 */
+	class HttpMultipartParser {
+	public:
+		typedef Function<bool(const HttpMultipartPart& part)> BeginHandler;
+		typedef Function<bool(const uint8_t *data, size_t length)> DataHandler;
+		typedef Function<bool()> EndHandler;
+
+		/**
+		 * @param boundary Boundary parameter of the content type, at most 70 characters.
+		 * @param size Buffer size. Part headers must fit in it.
+		 */
+		explicit HttpMultipartParser(StringView boundary, size_t size = CONFIG_HTTP_MULTIPART_BUFFER);
+		virtual ~HttpMultipartParser();
+
+		HttpMultipartParser(const HttpMultipartParser&) = delete;
+		HttpMultipartParser& operator=(const HttpMultipartParser&) = delete;
+
+		void onBegin(const BeginHandler& handler);
+		void onData(const DataHandler& handler);
+		void onEnd(const EndHandler& handler);
+
+		/**
+		 * @brief Get the free space at the end of the buffer.
+		 * @param length Set to the number of bytes that can be written.
+		 * @return Location to receive the next bytes of the body into.
+		 * @see commit()
+		 */
+		uint8_t *buffer(size_t& length);
+
+		/**
+		 * @brief Parse \p length bytes that were written to buffer().
+		 */
+		void commit(size_t length);
+
+		/**
+		 * @brief Copy data into the buffer and parse it.
+		 * @return The number of bytes that were accepted.
+		 */
+		size_t feed(const void *data, size_t length);
+
+		/**
+		 * @brief Check whether the final delimiter has been seen. Anything after it is discarded.
+		 */
+		bool done() const;
+		bool failed() const;
+
+	private:
+		enum State {
+			Preamble,
+			Delimiter,
+			Headers,
+			Body,
+			Done
+		};
+
+		uint8_t *_buffer;
+		size_t _size;
+		size_t _length;
+		State _state;
+		bool _failed;
+
+		String _delimiter;
+		uint8_t _skip[256];
+
+		BeginHandler _begin;
+		DataHandler _data;
+		EndHandler _end;
+
+		size_t search(size_t pos) const;
+		bool process(size_t& pos);
+		bool parseDelimiter(size_t& pos);
+		bool parseHeaders(size_t& pos);
+		bool parseBody(size_t& pos);
+	};
+}
@@ -0,0 +1,106 @@
+/*
+ * HTTP push endpoint.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bufferchain.h>
+#include <lwiot/uniquepointer.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/stl/intrusivelist.h>
+#include <lwiot/network/tcpclient.h>
+
+#ifndef CONFIG_HTTP_PUSH_SUBSCRIBERS
+#define CONFIG_HTTP_PUSH_SUBSCRIBERS 4
+#endif
+
+namespace lwiot
+{
+	class HttpServer;
+
+	/**
+	 * @brief Endpoint that keeps the connections of its clients open to push data to them.
+	 *
+	 * A request for the endpoint is answered with a handshake, after which the HttpServer hands
+	 * the connection over to the endpoint. Broadcasts are encoded once and the same frame is
+	 * written to every subscriber. A subscriber that cannot take a frame without blocking misses
+	 * it; one that fails to take a frame is disconnected.
+	 *
+	 * @note The methods of an endpoint may be called from any thread.
+	 * @see HttpServer::addEndpoint()
+	 */
+	class HttpPushEndpoint {
+	public:
+		explicit HttpPushEndpoint(size_t subscribers = CONFIG_HTTP_PUSH_SUBSCRIBERS);
+		virtual ~HttpPushEndpoint();
+
+		HttpPushEndpoint(const HttpPushEndpoint&) = delete;
+		HttpPushEndpoint& operator=(const HttpPushEndpoint&) = delete;
+
+		/**
+		 * @brief Accept the current request of \p server as a subscriber.
+		 * @note This is called by the request handler of the endpoint.
+		 */
+		void accept(HttpServer& server);
+
+		/**
+		 * @brief Handle data sent by subscribers and drop the ones that went away.
+		 * @note HttpServer::handleClient() calls this for each endpoint it serves.
+		 */
+		void process();
+
+		/**
+		 * @brief Disconnect all subscribers.
+		 */
+		void close();
+
+		/**
+		 * @brief Number of connected subscribers.
+		 */
+		size_t subscribers() const;
+
+		stl::IntrusiveListHook hook;
+
+	protected:
+		mutable Lock _lock;
+
+		/**
+		 * @brief Answer the request of a new subscriber.
+		 * @return The connection, taken over from \p server using HttpServer::takeOver(), or an empty
+		 *         pointer when the request was refused.
+		 */
+		virtual UniquePointer<TcpClient> handshake(HttpServer& server) = 0;
+
+		/**
+		 * @brief Handle data that subscriber \p idx sent.
+		 * @return False to disconnect the subscriber. The default discards the data.
+		 */
+		virtual bool receive(size_t idx, TcpClient& client);
+
+		virtual void attached(size_t idx);
+		virtual void detached(size_t idx);
+
+		/**
+		 * @brief Write \p frame to all subscribers.
+		 * @return The number of subscribers that received the frame.
+		 */
+		size_t writeAll(const BufferChain& frame);
+		bool writeTo(size_t idx, const BufferChain& frame);
+
+		TcpClient *subscriber(size_t idx) const;
+		void drop(size_t idx);
+
+	private:
+		UniquePointer<TcpClient> *_clients;
+		size_t _max;
+		size_t _count;
+	};
+}
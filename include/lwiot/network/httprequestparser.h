@@ -0,0 +1,150 @@
+/*
+ * Incremental HTTP request head parser.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/network/httpheaders.h>
+
+#ifndef CONFIG_HTTP_REQUEST_BUFFER
+#define CONFIG_HTTP_REQUEST_BUFFER 2048
+#endif
+
+#ifndef CONFIG_HTTP_MAX_HEADERS
+#define CONFIG_HTTP_MAX_HEADERS 32
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Parser for the request line and headers of an HTTP/1.x request.
+	 *
+	 * Data is fed as it arrives, in pieces of any size. The parser copies it into a fixed buffer
+	 * and stops at the empty line that ends the head, so a body or a pipelined request that follows
+	 * is left to the caller. Once the head is complete, it is split into spans that point into the
+	 * buffer: nothing is allocated per header, and percent-encoding is left for the caller to decode
+	 * when a value is actually used.
+	 *
+	 * @note The spans are valid until reset() is called.
+	 */
+	class HttpRequestParser {
+	public:
+		explicit HttpRequestParser(size_t size = CONFIG_HTTP_REQUEST_BUFFER);
+		virtual ~HttpRequestParser();
+
+		HttpRequestParser(const HttpRequestParser&) = delete;
+		HttpRequestParser& operator=(const HttpRequestParser&) = delete;
+
+		/**
+		 * @brief Add data to the request head.
+		 * @param data Received data.
+		 * @param length Length of \p data.
+		 * @return The number of bytes that belong to the head. The remainder was not consumed.
+		 */
+		size_t feed(const void *data, size_t length);
+
+		/**
+		 * @brief Prepare the parser for the next request.
+		 */
+		void reset();
+
+		/**
+		 * @brief Check whether the head is complete and valid.
+		 */
+		bool done() const;
+
+		/**
+		 * @brief Check whether the head is malformed or does not fit in the buffer.
+		 */
+		bool failed() const;
+
+		/**
+		 * @brief Check whether data has been fed since the last reset().
+		 */
+		bool started() const;
+
+		StringView method() const;
+		StringView target() const;
+		StringView path() const;
+		StringView query() const;
+
+		/**
+		 * @brief Minor version of the request, 0 for HTTP/1.0 and 1 for HTTP/1.1.
+		 */
+		int version() const;
+
+		size_t headers() const;
+		StringView headerName(size_t idx) const;
+		StringView headerValue(size_t idx) const;
+
+		/**
+		 * @brief Which well-known header the header at \p idx is.
+		 * @return The header, or http::Header::Unknown.
+		 */
+		http::Header headerId(size_t idx) const;
+
+		/**
+		 * @brief Find a header by its case insensitive name.
+		 * @return The value of the first matching header, or an empty view.
+		 * @note Well-known headers are found in constant time, others by a scan.
+		 */
+		StringView header(StringView name) const;
+
+		/**
+		 * @brief Find a well-known header.
+		 * @return The value of the first header of this kind, or an empty view.
+		 */
+		StringView header(http::Header id) const;
+
+		/**
+		 * @brief Decode percent-encoding, and '+' into a space.
+		 * @note Invalid escapes are kept as is.
+		 */
+		static String decode(StringView text);
+
+		/**
+		 * @brief Compare percent-encoded \p encoded to \p plain without decoding it first.
+		 */
+		static bool decodedEquals(StringView encoded, StringView plain);
+
+	private:
+		struct Header {
+			StringView name;
+			StringView value;
+			http::Header id;
+		};
+
+		char *_buffer;
+		size_t _size;
+		size_t _length;
+		int _newlines;
+		bool _done;
+		bool _failed;
+
+		StringView _method;
+		StringView _target;
+		StringView _path;
+		StringView _query;
+		int _version;
+
+		Header _headers[CONFIG_HTTP_MAX_HEADERS];
+		size_t _count;
+
+		/* One-based index of the first header of each well-known kind, or 0. */
+		uint8_t _known[http::HeaderCount];
+
+		bool parse();
+		bool parseRequestLine(StringView line);
+		bool parseHeader(StringView line);
+	};
+}
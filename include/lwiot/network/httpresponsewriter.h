@@ -0,0 +1,93 @@
+/*
+ * HTTP response writer.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/network/tcpclient.h>
+
+#ifndef CONFIG_HTTP_RESPONSE_BUFFER
+#define CONFIG_HTTP_RESPONSE_BUFFER 256
+#endif
+
+namespace lwiot
+{
+	namespace http
+	{
+		/* Pre-rendered header lines. */
+		constexpr StringView ConnectionClose("Connection: close\r\n");
+		constexpr StringView ConnectionKeepAlive("Connection: keep-alive\r\n");
+		constexpr StringView TransferChunked("Accept-Ranges: none\r\nTransfer-Encoding: chunked\r\n");
+	}
+
+	/**
+	 * @brief Renders the head of an HTTP response into a reusable buffer.
+	 *
+	 * The status lines of the common response codes are rendered at compile time, so starting a
+	 * response copies a constant byte array instead of formatting it. Headers can be added before
+	 * the status is known: room for the status line is kept at the front of the buffer. The buffer
+	 * is kept between responses and only grows, and send() writes the head and body using a single
+	 * gathered write.
+	 */
+	class HttpResponseWriter {
+	public:
+		explicit HttpResponseWriter(size_t size = CONFIG_HTTP_RESPONSE_BUFFER);
+		virtual ~HttpResponseWriter() = default;
+
+		HttpResponseWriter(const HttpResponseWriter&) = delete;
+		HttpResponseWriter& operator=(const HttpResponseWriter&) = delete;
+
+		/**
+		 * @brief Set the status line.
+		 * @param version Minor HTTP version, 0 for HTTP/1.0 and 1 for HTTP/1.1.
+		 * @param code Status code.
+		 */
+		void begin(uint8_t version, int code);
+
+		void header(StringView name, StringView value, bool first = false);
+		void header(StringView name, size_t value);
+
+		/**
+		 * @brief Append one or more complete header lines, such as http::ConnectionClose.
+		 */
+		void append(StringView lines);
+
+		/**
+		 * @brief Terminate the head and write it, followed by \p length bytes of \p body.
+		 * @return The number of bytes written or a negative value on error.
+		 * @note The writer is cleared for the next response.
+		 */
+		ssize_t send(TcpClient& client, const void *body = nullptr, size_t length = 0);
+
+		/**
+		 * @brief Discard the head, including the headers added so far.
+		 */
+		void clear();
+
+		/**
+		 * @brief Check whether the head is empty, apart from the status line.
+		 */
+		bool empty() const;
+
+		/**
+		 * @brief Reason phrase of a status code, empty for unknown codes.
+		 */
+		static StringView reason(int code);
+
+	private:
+		ByteBuffer _buffer;
+		size_t _start;
+
+		void reserve(size_t length);
+	};
+}
@@ -0,0 +1,109 @@
+/*
+ * HTTP route table.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/network/requesthandler.h>
+
+#ifndef CONFIG_HTTP_PATH_ARGS
+#define CONFIG_HTTP_PATH_ARGS 8
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Path arguments captured while matching a route.
+	 * @note The values point into the matched path and are only valid as long as it is.
+	 */
+	struct HttpPathArgs {
+		size_t count;
+		const stl::Vector<String>* names;
+		StringView values[CONFIG_HTTP_PATH_ARGS];
+
+		constexpr HttpPathArgs() : count(0), names(nullptr), values()
+		{
+		}
+	};
+
+	/**
+	 * @brief Route table that maps a method and path onto a request handler.
+	 *
+	 * Routes are stored in a trie of path segments, so a lookup only visits the segments of the
+	 * requested path instead of every registered route. A pattern segment can be:
+	 *
+	 * - a literal, which must match exactly;
+	 * - a parameter written as <tt>{name}</tt>, which matches any single segment;
+	 * - a final <tt>*</tt>, which matches the remainder of the path. The remainder is available
+	 *   as the path argument named <tt>*</tt>.
+	 *
+	 * Literals take precedence over parameters, and parameters over wildcards. Handlers registered
+	 * for HTTP_ANY are used when a route has no handler for the requested method.
+	 *
+	 * @note The router does not own the handlers.
+	 */
+	class HttpRouter {
+	public:
+		explicit HttpRouter();
+		virtual ~HttpRouter();
+
+		HttpRouter(const HttpRouter&) = delete;
+		HttpRouter& operator=(const HttpRouter&) = delete;
+
+		/**
+		 * @brief Add a route.
+		 * @param pattern Path pattern, such as <tt>/api/sensor/{id}</tt>.
+		 * @param method Method to route, or HTTP_ANY.
+		 * @param handler Handler to invoke.
+		 * @return False if the route already has a handler for \p method. The first one is kept.
+		 */
+		bool add(StringView pattern, HTTPMethod method, RequestHandler* handler);
+
+		/**
+		 * @brief Find the handler for a request.
+		 * @param method Request method.
+		 * @param path Request path, without the query string.
+		 * @param args Receives the path arguments of the matched route.
+		 * @return The handler, or nullptr if no route matches.
+		 */
+		RequestHandler* match(HTTPMethod method, StringView path, HttpPathArgs& args) const;
+
+		void clear();
+		bool empty() const;
+
+	private:
+		static constexpr int Methods = HTTP_OPTIONS + 1;
+
+		struct Node {
+			explicit Node(StringView segment);
+			~Node();
+
+			String segment;
+			stl::Vector<Node*> children; /* Literal children, sorted by segment. */
+			Node* param;
+			RequestHandler* handlers[Methods];
+			RequestHandler* wildcard[Methods];
+			stl::Vector<String> names;
+			stl::Vector<String> wildcard_names;
+			bool named;
+			bool wildcard_named;
+		};
+
+		Node* _root;
+
+		static RequestHandler* pick(RequestHandler* const * handlers, HTTPMethod method);
+		static Node* child(const Node* node, StringView segment, size_t* position);
+		static RequestHandler* match(const Node* node, HTTPMethod method, StringView path, HttpPathArgs& args);
+	};
+}
@@ -14,17 +14,47 @@
 #include <lwiot/types.h>
 #include <lwiot/log.h>
 #include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/stl/vector.h>
 #include <lwiot/stream.h>
 #include <lwiot/network/requesthandler.h>
+#include <lwiot/network/httprouter.h>
+#include <lwiot/network/httpheaders.h>
+#include <lwiot/network/httprequestparser.h>
+#include <lwiot/network/httpresponsewriter.h>
+#include <lwiot/network/httpchunkedwriter.h>
+#include <lwiot/network/httppushendpoint.h>
 #include <lwiot/function.h>
 
 #include <lwiot/network/ipaddress.h>
 #include <lwiot/network/tcpserver.h>
 #include <lwiot/network/tcpclient.h>
 #include <lwiot/uniquepointer.h>
+#include <lwiot/util/arenaallocator.h>
+#include <lwiot/util/json.h>
+
+#ifndef CONFIG_HTTP_KEEPALIVE_TIMEOUT
+#define CONFIG_HTTP_KEEPALIVE_TIMEOUT 5000
+#endif
+
+#ifndef CONFIG_HTTP_KEEPALIVE_REQUESTS
+#define CONFIG_HTTP_KEEPALIVE_REQUESTS 100
+#endif
+
+#ifndef CONFIG_HTTP_PIPELINE_DEPTH
+#define CONFIG_HTTP_PIPELINE_DEPTH 4
+#endif
 
 namespace lwiot
 {
+	class MappedRegion;
+	class TimeSeriesStore;
+
+	namespace metrics
+	{
+		class Registry;
+	}
+
 	class HttpServer {
 	public:
 		explicit HttpServer(TcpServer* server);
@@ -37,17 +67,142 @@ namespace lwiot
 
 		void stop();
 
+		/**
+		 * @brief Serve several clients at once, over persistent connections.
+		 *
+		 * Every call to handleClient() accepts a pending connection if a slot is free, and serves
+		 * a request on each connection that has one waiting. Connections are kept open as HTTP/1.1
+		 * (or HTTP/1.0 with <tt>Connection: keep-alive</tt>) permits, until they have been idle
+		 * for \p idle milliseconds or served CONFIG_HTTP_KEEPALIVE_REQUESTS requests.
+		 *
+		 * @param connections Number of connection slots. Zero restores the default of serving one
+		 *                    request at a time and closing the connection after the response.
+		 * @param idle Idle timeout in milliseconds.
+		 * @note Handlers are still called one at a time, from the thread that calls handleClient().
+		 *       Call this before begin().
+		 */
+		void setMaxConnections(size_t connections, int idle = CONFIG_HTTP_KEEPALIVE_TIMEOUT);
+
+		/**
+		 * @brief Serve requests that a client sent without waiting for the previous response.
+		 *
+		 * When enabled, up to CONFIG_HTTP_PIPELINE_DEPTH buffered requests on a connection are served
+		 * back to back. Otherwise connections take turns with one request each.
+		 */
+		void setPipelining(bool enabled);
+
 		void requestAuthentication(HTTPAuthMethod mode = BASIC_AUTH, const char *realm = nullptr,
 		                           const String &authFailMsg = String(""));
 
 		using THandlerFunction = Function<void(HttpServer& server)>;
 
+		/**
+		 * @brief Route requests for \p uri to a handler function.
+		 *
+		 * The URI is a route pattern: segments written as <tt>{name}</tt> match any segment and
+		 * are available through pathArg(), a final <tt>*</tt> matches the rest of the path. The
+		 * routes are compiled into an HttpRouter by begin().
+		 *
+		 * @see HttpRouter
+		 */
 		void on(const String &uri, THandlerFunction handler);
 		void on(const String &uri, HTTPMethod method, THandlerFunction fn);
 		void on(const String &uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn);
 
+		/**
+		 * @brief Add a custom request handler.
+		 * @note Custom handlers are asked in order, after the routes registered with on().
+		 */
 		void addHandler(RequestHandler *handler);
 
+#ifdef HAVE_UNISTD_H
+		/**
+		 * @brief Serve the files below \p path for GET requests on \p uri.
+		 *
+		 * If \p path ends with a slash, \p uri is a prefix and the rest of the request path names
+		 * a file below \p path (<tt>index.html</tt> for directories). Otherwise \p uri serves the
+		 * single file \p path. Responses carry an ETag and Last-Modified header, conditional
+		 * requests are answered with 304 and single byte ranges with 206. A <tt>.gz</tt> variant
+		 * of a file is sent with <tt>Content-Encoding: gzip</tt> to clients that accept it.
+		 *
+		 * @param uri Request path to serve.
+		 * @param path File or directory to serve.
+		 * @param cacheHeader Value of the Cache-Control header, if any.
+		 * @see TcpClient::sendFile()
+		 */
+		void serveStatic(const String &uri, const String &path, const char *cacheHeader = nullptr);
+
+		/**
+		 * @brief Serve \p region in place for GET requests on \p uri.
+		 *
+		 * Works like serveStatic() for a single file, but the body is sent straight from the
+		 * region, without copying it into the heap. The ETag is a hash of the content.
+		 *
+		 * @param uri Request path to serve.
+		 * @param region Content to serve. It must outlive the server.
+		 * @param contentType Content type, derived from the extension of \p uri if not given.
+		 * @param cacheHeader Value of the Cache-Control header, if any.
+		 */
+		void serveStatic(const String &uri, const MappedRegion &region, const char *contentType = nullptr,
+		                 const char *cacheHeader = nullptr);
+#endif
+
+		/**
+		 * @brief Hand GET requests on \p uri to a push endpoint, such as a WebSocketEndpoint or an
+		 *        EventSource.
+		 *
+		 * handleClient() also serves the subscribers of the endpoint. It does not block between
+		 * connections when setMaxConnections() is used, which keeps the endpoint responsive.
+		 *
+		 * @note The endpoint must outlive the server.
+		 */
+		void addEndpoint(const String &uri, HttpPushEndpoint &endpoint);
+
+		/**
+		 * @brief Serve the points of \p store for GET requests on \p uri.
+		 *
+		 * The optional <tt>from</tt> and <tt>to</tt> arguments select a time range, in
+		 * milliseconds. The points are sent as CSV, or as a JSON array of [timestamp, value]
+		 * pairs when the <tt>format</tt> argument is <tt>json</tt>. The response is chunked, so a
+		 * long history is decoded and sent block by block.
+		 *
+		 * @note The store must outlive the server.
+		 */
+		void serveTimeSeries(const String &uri, TimeSeriesStore &store);
+
+		/**
+		 * @brief Serve the metrics of \p registry for GET requests on \p uri.
+		 *
+		 * The metrics are sent in the Prometheus text format, or as JSON when the
+		 * <tt>format</tt> argument is <tt>json</tt>.
+		 *
+		 * @note The registry must outlive the server.
+		 * @see metrics::Registry
+		 */
+		void serveMetrics(const String &uri, metrics::Registry &registry);
+
+		/**
+		 * @brief Serve the global metrics registry for GET requests on \p uri.
+		 */
+		void serveMetrics(const String &uri);
+
+		/**
+		 * @brief Answer GET requests for \p uri with a fixed response, ahead of the request parser.
+		 *
+		 * The response is encoded once. Requests are matched on their raw request line, after which
+		 * the head is discarded and the response is sent in a single write, and the connection is
+		 * closed. This keeps frequent requests with a trivial answer, such as the connectivity
+		 * checks of phones on a captive portal, away from the parser and the handlers.
+		 *
+		 * @param uri Request path, without arguments.
+		 * @param code Status code.
+		 * @param headers Additional header lines, each ending in CRLF.
+		 * @param body Body of the response.
+		 * @note Requests whose head does not arrive in one piece take the normal route.
+		 */
+		void serveCanned(const String &uri, int code, const String &headers = String(""),
+		                 const String &body = String(""));
+
 		void onNotFound(THandlerFunction fn);  //called when handler is not assigned
 		void onFileUpload(THandlerFunction fn); //handle file uploads
 
@@ -67,17 +222,38 @@ namespace lwiot
 		}
 
 		bool hasClient() const;
-		String arg(const String& name);        // get request argument value by name
+		String pathArg(int i);          // get path argument value by number
+		String pathArg(StringView name);    // get path argument value by name
+		int pathArgs();                 // get path argument count
+		String arg(StringView name);        // get request argument value by name
 		String arg(int i);              // get request argument value by number
 		String argName(int i);          // get request argument name by number
 		int args();                     // get arguments count
-		bool hasArg(const String& name);       // check if argument exists
+		bool hasArg(StringView name);       // check if argument exists
 		void collectHeaders(const char *headerKeys[], size_t headerKeysCount); // set the request headers to collect
-		String header(const String& name);      // get request header value by name
+		String header(StringView name);      // get request header value by name
 		String header(int i);              // get request header value by number
 		String headerName(int i);          // get request header name by number
 		int headers();                     // get header count
-		bool hasHeader(const String& name);       // check if header exists
+		bool hasHeader(StringView name);       // check if header exists
+
+		/**
+		 * @brief Get any header of the current request, without collecting it first.
+		 * @return The header value, or an empty view. It is valid until the handler returns.
+		 * @see collectHeaders()
+		 */
+		StringView requestHeader(StringView name) const;
+
+		/**
+		 * @brief Get a well-known header of the current request.
+		 * @see requestHeader(StringView) const
+		 */
+		StringView requestHeader(http::Header id) const;
+
+		/**
+		 * @brief Check whether the client accepts a content coding, such as "gzip".
+		 */
+		bool acceptsEncoding(StringView coding) const;
 
 		String hostHeader();            // get request host header if available or empty String if not
 
@@ -85,10 +261,68 @@ namespace lwiot
 		void send(int code, char *content_type, const String &content);
 		void send(int code, const String &content_type, const String &content);
 
+		/**
+		 * @brief Send a JSON document, without rendering it to a String first.
+		 *
+		 * The length is measured up front for the Content-Length header, after which the document is
+		 * written to the connection CONFIG_JSON_PRINT_BUFFER bytes at a time.
+		 */
+		void sendJson(int code, const JsonVariant& json);
 
 		void setContentLength(size_t contentLength);
-		void sendHeader(const String &name, const String &value, bool first = false);
+		void sendHeader(StringView name, StringView value, bool first = false);
 		void sendContent(const String &content);
+		void sendContent(const void *data, size_t length);
+
+		/**
+		 * @brief Start a response body of unknown length, to be written using writeChunk().
+		 *
+		 * The body is sent in chunks of up to CONFIG_HTTP_CHUNK_BUFFER bytes, so it does not have to
+		 * fit in memory. Writes wait for the client to accept more data. HTTP/1.0 clients receive the
+		 * body as it is, after which the connection is closed.
+		 *
+		 * @param code Status code.
+		 * @param contentType Content type of the body.
+		 * @param coding Compress the body, if the client accepts the coding and lwIoT supports it.
+		 *               The body is sent uncompressed otherwise.
+		 * @return False if the response could not be started.
+		 */
+		bool beginChunked(int code, const char *contentType = nullptr,
+		                  HttpContentCoding coding = HttpContentCoding::Identity);
+
+		/**
+		 * @brief Add \p length bytes to a body started using beginChunked().
+		 * @return \p length, or a negative error code when the client did not accept the data. The
+		 *         connection is closed after the handler returns in that case.
+		 */
+		ssize_t writeChunk(const void *data, size_t length);
+		ssize_t writeChunk(StringView data);
+
+		/**
+		 * @brief End a body started using beginChunked().
+		 * @note Bodies that are not ended explicitly are ended when the handler returns.
+		 */
+		bool endChunked();
+
+		/**
+		 * @brief Answer the current request and take its connection away from the server.
+		 *
+		 * The response head is sent without a Content-Length or chunked framing: what follows is up
+		 * to the new owner of the connection. Add headers using sendHeader() first.
+		 *
+		 * @param code Status code, such as 101 for a protocol upgrade.
+		 * @param contentType Content type, if any.
+		 * @return The connection, or an empty pointer if the head could not be sent.
+		 */
+		UniquePointer<TcpClient> takeOver(int code, const char *contentType = nullptr);
+
+#ifdef HAVE_UNISTD_H
+		/**
+		 * @brief Send \p length bytes of \p file, starting at \p offset, as (part of) the body.
+		 * @return The number of bytes sent.
+		 */
+		size_t sendContent(File &file, size_t offset, size_t length);
+#endif
 
 		static String urlDecode(const String &text);
 
@@ -109,28 +343,63 @@ namespace lwiot
 		void _addRequestHandler(RequestHandler *handler);
 		void _handleRequest();
 		void _finalizeResponse();
-		bool _parseRequest(TcpClient &client);
-		void _parseArguments(const String& data);
+		bool _readRequestHead(TcpClient &client, HttpRequestParser &parser, bool wait);
+		bool _parseRequest(TcpClient &client, HttpRequestParser &parser);
+		void _releaseRequest();
+		void _parseArguments(StringView data);
 
 		static String _responseCodeToString(int code);
 
 		bool _parseForm(TcpClient &client, const String& boundary, uint32_t len);
 		bool _parseFormUploadAborted();
-		void _uploadWriteByte(uint8_t b);
-		uint8_t _uploadReadByte(TcpClient &client);
+		void _uploadCallback();
+		void _uploadFlush();
+		bool _uploadWrite(const uint8_t *data, size_t length);
 
-		void _prepareHeader(String &response, int code, const char *content_type, size_t contentLength);
-		bool _collectHeader(const char *headerName, const char *headerValue);
+		void _prepareHeader(int code, const char *content_type, size_t contentLength);
+		bool _collectHeader(StringView headerName, StringView headerValue);
+		int _findHeader(StringView name) const;
+		void _parseConnectionHeader(StringView value);
 
 		void _streamFileCore(size_t fileSize, const String &fileName, const String &contentType);
 		String _getRandomHexString();
 		String _extractParam(String &authReq, const String &param, char delimit = '"');
 
 		struct RequestArgument {
+			RequestArgument() : encoded(false)
+			{
+			}
+
 			String key;
 			String value;
+
+			/* Spans in the request, decoded into key and value on first access. */
+			StringView encodedKey;
+			StringView encodedValue;
+			bool encoded;
 		};
 
+		struct Connection {
+			UniquePointer<TcpClient> client;
+			HttpRequestParser parser;
+			HttpResponseWriter writer;
+			time_t active;
+			uint32_t requests;
+		};
+
+		static void _decodeArgument(RequestArgument &arg);
+		static bool _argumentIs(const RequestArgument &arg, StringView name);
+
+		struct CannedResponse {
+			String request; /* Start of the request line, "GET <uri>". */
+			String response;
+		};
+
+		void _handleConnections();
+		void _acceptConnection();
+		bool _serveConnection(Connection& connection);
+		bool _serveCanned(TcpClient& client);
+
 		UniquePointer<TcpServer> _server;
 		UniquePointer<TcpClient> _currentClient;
 
@@ -141,8 +410,13 @@ namespace lwiot
 		unsigned long _statusChange;
 
 		RequestHandler *_currentHandler;
-		RequestHandler *_firstHandler;
-		RequestHandler *_lastHandler;
+		stl::IntrusiveList<RequestHandler, &RequestHandler::hook> _handlers;
+		stl::IntrusiveList<RequestHandler, &RequestHandler::hook> _routes;
+		stl::IntrusiveList<HttpPushEndpoint, &HttpPushEndpoint::hook> _endpoints;
+		HttpRouter _router;
+		HttpPathArgs _pathArgs;
+		stl::Vector<CannedResponse> _canned;
+		bool _routed;
 		THandlerFunction _notFoundHandler;
 		THandlerFunction _fileUploadHandler;
 
@@ -152,15 +426,30 @@ namespace lwiot
 
 		int _headerKeysCount;
 		RequestArgument *_currentHeaders;
+		uint8_t *_headerSlots;
+		size_t _headerMask;
 		size_t _contentLength;
-		String _responseHeaders;
 
 		String _hostHeader;
 		bool _chunked;
+		bool _keepAlive;
+
+		Connection *_connections;
+		size_t _maxConnections;
+		int _idleTimeout;
+		bool _pipelining;
+		String _keepAliveHeader;
 
 		String _snonce;
 		String _sopaque;
 		String _srealm;
 
+		Arena _arena; /* Per request scratch memory */
+		HttpRequestParser _parser;
+		HttpResponseWriter _writer;
+		HttpResponseWriter *_response; /* Writer of the connection that is being served */
+		HttpChunkedWriter _stream;
+		const HttpRequestParser *_currentParser;
+
 	};
 }
@@ -1,6 +1,6 @@
 /*
  * IP address object definition.
- * 
+ *
  * @author Michel Megens
  * @email  dev@bietje.net
  */
@@ -9,6 +9,8 @@
 
 #include <lwiot/types.h>
 #include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/stl/hash.h>
 
 #include <lwiot/network/stdnet.h>
 
@@ -18,20 +20,68 @@ namespace lwiot
 
 	class IPAddress {
 	public:
-		explicit IPAddress();
-		explicit IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t forth);
+		static constexpr size_t MaxStringLength = 46; //!< Longest text form of an address, including the terminator.
+
+		constexpr explicit IPAddress() : _address{}, _version(4)
+		{
+		}
+
+		constexpr explicit IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t forth) :
+			_address{ { first, second, third, forth } }, _version(4)
+		{
+		}
+
+		/**
+		 * @brief Construct an IPv6 address from its eight groups.
+		 */
+		constexpr explicit IPAddress(uint16_t g0, uint16_t g1, uint16_t g2, uint16_t g3, uint16_t g4, uint16_t g5,
+		                             uint16_t g6, uint16_t g7) :
+			_address{ { IPAddress::hi(g0), IPAddress::lo(g0), IPAddress::hi(g1), IPAddress::lo(g1),
+			            IPAddress::hi(g2), IPAddress::lo(g2), IPAddress::hi(g3), IPAddress::lo(g3),
+			            IPAddress::hi(g4), IPAddress::lo(g4), IPAddress::hi(g5), IPAddress::lo(g5),
+			            IPAddress::hi(g6), IPAddress::lo(g6), IPAddress::hi(g7), IPAddress::lo(g7) } }, _version(6)
+		{
+		}
+
+		constexpr explicit IPAddress(uint32_t address) :
+			_address{ { static_cast<uint8_t>(address >> 24), static_cast<uint8_t>(address >> 16),
+			            static_cast<uint8_t>(address >> 8), static_cast<uint8_t>(address) } }, _version(4)
+		{
+		}
+
 		explicit IPAddress(const uint8_t *address);
-		explicit IPAddress(uint32_t address);
 		explicit IPAddress(const remote_addr_t& remote);
-		virtual ~IPAddress() = default;
 
-		virtual String toString() const;
+		String toString() const;
+
+		/**
+		 * @brief Write the address as text, compressed as in RFC 5952 for IPv6.
+		 * @param buffer Buffer to write to, which is terminated.
+		 * @param length Size of \p buffer. MaxStringLength bytes always suffice.
+		 * @return The length of the text, or 0 if it does not fit.
+		 */
+		size_t formatTo(char *buffer, size_t length) const;
+
+		/**
+		 * @brief Parse an IPv4 address in dotted decimal notation, or an IPv6 address.
+		 * @param str Text to parse, without a port or zone.
+		 * @param address Result, which is left alone if \p str is not a valid address.
+		 * @return False if \p str is not a valid address.
+		 */
+		static bool parse(const StringView& str, IPAddress& address);
+
+		/**
+		 * @brief Parse \p str.
+		 * @return The address, or 0.0.0.0 if \p str is not a valid address.
+		 * @see parse
+		 */
 		static IPAddress fromString(const String& str);
 		static IPAddress fromString(const char *str);
 
 		/* Operators */
 		operator uint32_t () const;
 		bool operator ==(const IPAddress& other) const;
+		bool operator !=(const IPAddress& other) const { return !(*this == other); }
 		bool operator ==(const uint32_t& other) const;
 		bool operator ==(const uint8_t* other) const;
 		uint8_t operator [](int idx) const;
@@ -39,12 +89,16 @@ namespace lwiot
 
 		IPAddress& operator =(const uint8_t *address);
 		IPAddress& operator =(uint32_t addr);
-		IPAddress& operator =(const IPAddress& addr);
+		IPAddress& operator =(const IPAddress& addr) = default;
+		IPAddress(const IPAddress& addr) = default;
 
 		void toRemoteAddress(remote_addr_t& remote) const;
 
 		int version() const { return this->_version; }
 		bool isIPv6() const { return this->_version == 6; }
+		bool isMulticast() const;
+
+		size_t hash() const;
 
 		static IPAddress fromBindAddress(BindAddress addr);
 
@@ -56,5 +110,32 @@ namespace lwiot
 		int _version;
 
 		const uint8_t *raw() const;
+		size_t format6(char *buffer) const;
+
+		uint16_t group(int idx) const
+		{
+			return static_cast<uint16_t>(this->_address.bytes[idx * 2] << 8 | this->_address.bytes[idx * 2 + 1]);
+		}
+
+		static constexpr uint8_t hi(uint16_t group)
+		{
+			return static_cast<uint8_t>(group >> 8);
+		}
+
+		static constexpr uint8_t lo(uint16_t group)
+		{
+			return static_cast<uint8_t>(group);
+		}
 	};
+
+	namespace stl
+	{
+		template <>
+		struct Hash<IPAddress> {
+			size_t operator()(const IPAddress& addr) const
+			{
+				return addr.hash();
+			}
+		};
+	}
 }
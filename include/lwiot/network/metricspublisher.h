@@ -0,0 +1,79 @@
+/*
+ * Periodic MQTT metrics snapshots.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/util/metrics.h>
+#include <lwiot/network/mqttclient.h>
+
+/* Time between two snapshots, in milliseconds. */
+#ifndef CONFIG_METRICS_PUBLISH_INTERVAL
+#define CONFIG_METRICS_PUBLISH_INTERVAL 60000
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Publishes snapshots of a metrics registry to an MQTT topic.
+	 *
+	 * A snapshot is encoded as JSON or CBOR, in the layout of metrics::Registry::writeJson().
+	 * The client is only used from poll() and publish(), so call poll() from the thread that
+	 * runs the client.
+	 *
+	 * @code
+	 * lwiot::MetricsPublisher publisher(client, "devices/sensor-1/metrics");
+	 *
+	 * while(true) {
+	 *     client.loop();
+	 *     publisher.poll();
+	 * }
+	 * @endcode
+	 */
+	class MetricsPublisher {
+	public:
+		enum class Format {
+			Json,
+			Cbor
+		};
+
+		explicit MetricsPublisher(MqttClient& client, const String& topic, Format format = Format::Json,
+		                          time_t interval = CONFIG_METRICS_PUBLISH_INTERVAL);
+		explicit MetricsPublisher(MqttClient& client, const String& topic, metrics::Registry& registry,
+		                          Format format = Format::Json, time_t interval = CONFIG_METRICS_PUBLISH_INTERVAL);
+
+		/**
+		 * @brief Publish a snapshot when the interval has passed since the last one.
+		 * @return False if a snapshot was due, but could not be published.
+		 */
+		bool poll();
+
+		/**
+		 * @brief Publish a snapshot now.
+		 */
+		bool publish();
+
+		/**
+		 * @brief Encode a snapshot into \p output.
+		 */
+		void encode(ByteBuffer& output) const;
+
+	private:
+		MqttClient& _client;
+		String _topic;
+		metrics::Registry& _registry;
+		Format _format;
+		time_t _interval;
+		time_t _last;
+		bool _published;
+	};
+}
@@ -0,0 +1,122 @@
+/*
+ * MQTT bridge that multiplexes many devices over one client session.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/sharedbytebuffer.h>
+#include <lwiot/kernel/lock.h>
+
+#include <lwiot/network/asyncmqttclient.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/stl/unorderedmap.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Bridge that publishes and subscribes on behalf of many devices over one MQTT session.
+	 *
+	 * Each device owns the topics below `<prefix>/<device>/`. Devices publish and subscribe with
+	 * topics relative to their own namespace, and receive messages with relative topics as well.
+	 *
+	 * Subscriptions are aggregated: all devices that subscribe to the same relative filter share
+	 * a single broker subscription on `<prefix>/+/<filter>`, which is made by the first device and
+	 * dropped with the last one. Incoming messages are routed to the bridge by the topic trie of
+	 * the client and handed to the device named in the topic, if it holds the filter. An
+	 * aggregated subscription keeps the QoS of the device that made it.
+	 *
+	 * The client drops its subscriptions when the connection is restored, so resubscribe() has to
+	 * be called from the reconnect handler of the client.
+	 */
+	class MqttBridge {
+	public:
+		typedef Function<void(const String& topic, const SharedByteBuffer& data)> Handler;
+
+		explicit MqttBridge(AsyncMqttClient& client, const String& prefix);
+		virtual ~MqttBridge();
+
+		MqttBridge(const MqttBridge&) = delete;
+		MqttBridge& operator=(const MqttBridge&) = delete;
+
+		/**
+		 * @brief Add a device.
+		 * @param device Device name; a single topic level without wildcards.
+		 * @param handler Handler for messages on the subscriptions of \p device.
+		 * @return False if the name is invalid or already in use.
+		 */
+		bool add(const String& device, const Handler& handler);
+
+		/**
+		 * @brief Remove a device along with its subscriptions.
+		 */
+		bool remove(const String& device);
+
+		/**
+		 * @brief Subscribe \p device to \p filter, relative to its namespace.
+		 * @return False if the broker subscription could not be made; it is recorded regardless and
+		 *         made by the next call to resubscribe().
+		 */
+		bool subscribe(const String& device, const String& filter, MqttClient::QoS qos = MqttClient::QOS0);
+		bool unsubscribe(const String& device, const String& filter);
+
+		/**
+		 * @brief Publish \p data on \p topic, relative to the namespace of \p device.
+		 */
+		bool publish(const String& device, const String& topic, const ByteBuffer& data, bool retained = false);
+
+		/**
+		 * @brief Renew all broker subscriptions after the connection has been restored.
+		 */
+		bool resubscribe();
+
+		bool contains(const String& device) const;
+		size_t devices() const;
+
+		/**
+		 * @brief Number of broker subscriptions.
+		 */
+		size_t subscriptions() const;
+
+		const String& prefix() const
+		{
+			return this->_prefix;
+		}
+
+	private:
+		struct Device {
+			Handler handler;
+			stl::Vector<String> filters;
+		};
+
+		struct Filter {
+			size_t references;
+			MqttClient::QoS qos;
+		};
+
+		AsyncMqttClient& _client;
+		String _prefix;
+		mutable Lock _lock;
+		Lock _subscriptions;
+		stl::UnorderedMap<String, Device> _devices;
+		stl::UnorderedMap<String, Filter> _filters;
+
+		String topic(const String& device, const String& filter) const;
+		bool route(const String& filter, MqttClient::QoS qos);
+		void release(const String& filter);
+		void dispatch(const String& filter, const String& topic, const SharedByteBuffer& data);
+
+		static bool valid(const String& device);
+	};
+}
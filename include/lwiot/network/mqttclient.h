@@ -13,25 +13,50 @@
 
 #include <lwiot/stream.h>
 #include <lwiot/bytebuffer.h>
+#include <lwiot/sharedbytebuffer.h>
 
 #include <lwiot/network/ipaddress.h>
 #include <lwiot/network/tcpclient.h>
 
 #include <lwiot/stl/map.h>
+#include <lwiot/stl/pair.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/stl/stringview.h>
 #include <lwiot/function.h>
 #include <lwiot/stl/referencewrapper.h>
+#include <lwiot/util/json.h>
+
+#ifndef CONFIG_MQTT_CHUNK_SIZE
+#define CONFIG_MQTT_CHUNK_SIZE 256
+#endif
+
+#ifndef CONFIG_MQTT_MAX_INFLIGHT
+#define CONFIG_MQTT_MAX_INFLIGHT 8
+#endif
+
+#ifndef CONFIG_MQTT_TOPIC_ALIASES
+#define CONFIG_MQTT_TOPIC_ALIASES 16
+#endif
 
 namespace lwiot
 {
 	class MqttClient {
 	public:
-		typedef Function<void(const String&, const ByteBuffer&)> Handler;
+		typedef Function<void(const String&, const SharedByteBuffer&)> Handler;
+		typedef Function<void(const String& topic, size_t offset, const RawBuffer& span, size_t total)> ChunkHandler;
+		typedef stl::Vector<stl::Pair<String, String>> UserProperties;
+
 		enum QoS {
 			QOS0 = 0,
 			QOS1,
 			QOS2
 		};
 
+		enum class Version : uint8_t {
+			V311 = 4,
+			V5 = 5
+		};
+
 		explicit MqttClient();
 		virtual ~MqttClient() = default;
 
@@ -50,6 +75,70 @@ namespace lwiot
 			this->_cb = stl::forward<CB>(cb);
 		}
 
+		/**
+		 * @brief Receive PUBLISH packets that do not fit in MQTT_MAX_PACKET_SIZE in chunks.
+		 *
+		 * The payload of such a packet is passed to \p cb piece by piece, as it is read from the
+		 * connection. \p offset is the position of \p span in the payload of \p total bytes.
+		 * Without a chunk handler, oversize packets are discarded.
+		 */
+		void setChunkHandler(const ChunkHandler& cb)
+		{
+			this->_chunk = cb;
+		}
+
+		template <typename CB>
+		void setChunkHandler(CB&& cb)
+		{
+			this->_chunk = stl::forward<CB>(cb);
+		}
+
+		/**
+		 * @brief Select the protocol version of the next connect().
+		 *
+		 * MQTT 5 adds topic aliases, receive maximum flow control, user properties and reason
+		 * codes. QoS 0 messages to a topic that was published before are sent with a two byte
+		 * topic alias instead of the topic, for up to CONFIG_MQTT_TOPIC_ALIASES topics or as many
+		 * as the broker allows. The default is MQTT 3.1.1.
+		 */
+		void setVersion(Version version)
+		{
+			this->_version = version;
+		}
+
+		Version version() const
+		{
+			return this->_version;
+		}
+
+		/**
+		 * @brief Reason code of the last CONNACK, SUBACK, acknowledgement or DISCONNECT.
+		 *
+		 * Codes of 0x80 and up report an error. MQTT 3.1.1 brokers only return a code in CONNACK
+		 * and SUBACK packets.
+		 */
+		uint8_t reason() const
+		{
+			return this->_reason;
+		}
+
+		/**
+		 * @brief User properties of the message that is being delivered.
+		 * @note Only valid in the message handler.
+		 */
+		const UserProperties& properties() const
+		{
+			return this->_properties;
+		}
+
+		/**
+		 * @brief Number of QoS 1 and QoS 2 messages the broker accepts before acknowledging them.
+		 */
+		uint16_t receiveMaximum() const
+		{
+			return this->_receive_max;
+		}
+
 		bool connect(const String& id, const String& user, const String& pass);
 		virtual bool connect(const String& id, const String& user, const String& pass,
 				const String& willTopic, uint8_t willQos, bool willRetain,
@@ -66,8 +155,32 @@ namespace lwiot
 		}
 
 		virtual bool publish(const stl::String& topic, const ByteBuffer& data, bool retained);
+
+		/**
+		 * @brief Publish \p data with MQTT 5 user properties.
+		 * @note \p properties are left out when the client does not use MQTT 5.
+		 */
+		virtual bool publish(const stl::String& topic, const ByteBuffer& data, bool retained,
+		                     const UserProperties& properties);
 		bool publish(const stl::String& topic, const stl::String& data, bool retained = false);
 
+		/**
+		 * @brief Publish \p length bytes read from \p source.
+		 *
+		 * The payload is copied from \p source to the connection CONFIG_MQTT_CHUNK_SIZE bytes at a
+		 * time, so it is not limited by MQTT_MAX_PACKET_SIZE.
+		 */
+		virtual bool publish(const stl::String& topic, Stream& source, size_t length, bool retained = false);
+
+		/**
+		 * @brief Publish a JSON document, without rendering it to a String first.
+		 *
+		 * The document is measured for the packet header, after which it is written to the connection
+		 * CONFIG_JSON_PRINT_BUFFER bytes at a time. Like streamed payloads, it is not limited by
+		 * MQTT_MAX_PACKET_SIZE.
+		 */
+		virtual bool publishJson(const stl::String& topic, const JsonVariant& json, bool retained = false);
+
 		virtual inline int state() const
 		{
 			return this->_state;
@@ -76,6 +189,52 @@ namespace lwiot
 		static constexpr int MQTT_MAX_PACKET_SIZE = 512;
 		static constexpr int MQTT_MAX_HEADER_SIZE =   5;
 		static constexpr int MQTT_SOCKET_TIMEOUT  =  15;
+		static constexpr size_t MQTT_MAX_REMAINING_LENGTH = 268435455;
+
+	protected:
+		enum class Ack : uint8_t {
+			PubAck,
+			PubRec,
+			PubComp,
+			Rejected //!< The broker refused a QoS 2 message in its PUBREC.
+		};
+
+		/**
+		 * @brief Encode a PUBLISH packet for the selected protocol version.
+		 * @param packet Output buffer.
+		 * @param id Packet identifier, only used for QoS 1 and 2.
+		 * @param properties MQTT 5 user properties.
+		 * @return False if the packet does not fit in MQTT_MAX_PACKET_SIZE.
+		 */
+		bool encode(ByteBuffer& packet, const stl::String& topic, const ByteBuffer& data,
+		            bool retained, QoS qos, uint16_t id, const UserProperties& properties) const;
+
+		/**
+		 * @brief Replace the topic of an encoded QoS 0 PUBLISH by a topic alias.
+		 *
+		 * The first packet to a topic assigns the alias, later packets carry an empty topic. Aliases
+		 * only last as long as the connection, so this has to be done right before \p packet is sent.
+		 * Packets of QoS 1 and 2 are left alone, because they may be sent again on a new connection.
+		 */
+		void alias(ByteBuffer& packet);
+
+		/**
+		 * @brief Write one or more complete packets to the connection.
+		 */
+		bool send(const BufferChain& chain);
+
+		/**
+		 * @brief Write a PUBACK, PUBREC, PUBREL or PUBCOMP packet.
+		 * @param type Packet type, in the upper four bits.
+		 */
+		void acknowledge(uint8_t type, uint16_t id);
+
+		/**
+		 * @brief Called when the broker acknowledges a step of a QoS 1 or QoS 2 PUBLISH.
+		 */
+		virtual void acknowledged(Ack ack, uint16_t id)
+		{
+		}
 
 	private:
 		stl::ReferenceWrapper<TcpClient> _io;
@@ -89,16 +248,34 @@ namespace lwiot
 		unsigned long _lastInActivity;
 		bool _pingOutstanding;
 		Handler _cb;
+		ChunkHandler _chunk;
+		uint16_t _incoming[CONFIG_MQTT_MAX_INFLIGHT];
+
+		/* MQTT 5 */
+		Version _version;
+		uint8_t _reason;
+		uint16_t _receive_max;
+		uint16_t _alias_max;
+		String _aliases[CONFIG_MQTT_TOPIC_ALIASES];
+		UserProperties _properties;
 
 		/* Methods */
-		size_t build(uint8_t header, uint16_t length) const;
+		size_t build(uint8_t header, size_t length) const;
 		uint16_t readPacket(uint8_t* data);
+		void readChunked(size_t length, uint8_t llen);
+		size_t parseProperties(const uint8_t *data, size_t length);
+		uint16_t alias(StringView topic, bool& known);
+		bool receive(uint16_t id);
+		void release(uint16_t id);
 		bool read(uint8_t * result);
 		bool read(uint8_t * result, uint16_t * index);
 
 		uint16_t write(const stl::String& data, uint16_t pos);
 		size_t write(uint8_t);
 		bool write(uint8_t header, size_t length);
+		bool write(uint8_t header, size_t length, const RawBuffer& payload);
+		bool beginPublish(const stl::String& topic, size_t length, bool retained);
+		void abortPublish();
 		bool isConnected();
 	};
 }
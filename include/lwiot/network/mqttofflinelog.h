@@ -0,0 +1,164 @@
+/*
+ * Store-and-forward log for MQTT messages published while offline.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/uniquepointer.h>
+#include <lwiot/io/file.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/kernel/lock.h>
+
+namespace lwiot
+{
+	class Eeprom24C02;
+	class SRAM23K256;
+
+	/**
+	 * @brief Ring log of messages that could not be published yet.
+	 *
+	 * The storage is divided into segments of a fixed size, which are filled one after the
+	 * other. A segment starts with a header holding its sequence number; records are appended
+	 * behind it and never moved. Every record carries a CRC over its contents and the sequence
+	 * number of its segment, so that a record that was cut short by a reset, or one left over
+	 * from an earlier use of the segment, ends the segment. After a reset only the segment
+	 * headers and the record headers are read back.
+	 *
+	 * Replayed records are marked as sent in place. A segment is released once all of its
+	 * records have been sent. When the log is full, the oldest segment is discarded.
+	 */
+	class MqttOfflineLog {
+	public:
+		/**
+		 * @brief Replay callback.
+		 * @return False to stop replaying; the message is offered again on the next replay.
+		 */
+		typedef Function<bool(const String& topic, const ByteBuffer& payload, bool retained)> Visitor;
+
+		explicit MqttOfflineLog(size_t segments, size_t segsize);
+		virtual ~MqttOfflineLog();
+
+		/**
+		 * @brief Append a message.
+		 * @return False if the message does not fit in a segment or could not be written.
+		 */
+		bool append(const String& topic, const ByteBuffer& payload, bool retained);
+
+		/**
+		 * @brief Hand at most \p max messages to \p visitor, oldest first.
+		 * @return The number of messages that were accepted by \p visitor.
+		 */
+		size_t replay(size_t max, const Visitor& visitor);
+
+		bool empty();
+		size_t pending();
+		void clear();
+
+		/**
+		 * @brief Number of messages that were discarded because the log was full.
+		 */
+		size_t dropped() const
+		{
+			return this->_dropped;
+		}
+
+	protected:
+		static constexpr size_t SegmentHeader = 8;
+		static constexpr size_t RecordHeader = 6;
+
+		virtual bool read(size_t offset, void *data, size_t length) = 0;
+		virtual bool write(size_t offset, const void *data, size_t length) = 0;
+
+		size_t size() const
+		{
+			return this->_segments * this->_segsize;
+		}
+
+	private:
+		struct Record {
+			uint8_t state;
+			size_t length;
+			uint16_t crc;
+		};
+
+		Lock _lock;
+		size_t _segments;
+		size_t _segsize;
+		uint32_t *_sequences;
+		size_t _head;
+		size_t _head_offset;
+		size_t _tail;
+		size_t _tail_offset;
+		uint32_t _next;
+		size_t _pending;
+		size_t _dropped;
+		bool _loaded;
+
+		void scan();
+		bool header(size_t segment, size_t offset, Record& record);
+		bool verify(size_t segment, size_t offset, const Record& record);
+		size_t walk(size_t segment, size_t& end, bool check);
+		bool open(size_t segment);
+		void release(size_t segment);
+	};
+
+	/**
+	 * @brief Offline log in a file, which is created when it does not exist yet.
+	 */
+	class MqttFileOfflineLog : public MqttOfflineLog {
+	public:
+		explicit MqttFileOfflineLog(const String& path, size_t segments = 16, size_t segsize = 4096);
+		~MqttFileOfflineLog() override = default;
+
+	protected:
+		bool read(size_t offset, void *data, size_t length) override;
+		bool write(size_t offset, const void *data, size_t length) override;
+
+	private:
+		UniquePointer<File> _file;
+	};
+
+	/**
+	 * @brief Offline log in a 23K256 SRAM, from address \p base onwards.
+	 */
+	class MqttSramOfflineLog : public MqttOfflineLog {
+	public:
+		explicit MqttSramOfflineLog(SRAM23K256& sram, size_t base = 0, size_t segments = 8, size_t segsize = 4096);
+		~MqttSramOfflineLog() override = default;
+
+	protected:
+		bool read(size_t offset, void *data, size_t length) override;
+		bool write(size_t offset, const void *data, size_t length) override;
+
+	private:
+		SRAM23K256& _sram;
+		size_t _base;
+	};
+
+	/**
+	 * @brief Offline log in a 24C02 EEPROM, from address \p base onwards.
+	 */
+	class MqttEepromOfflineLog : public MqttOfflineLog {
+	public:
+		explicit MqttEepromOfflineLog(Eeprom24C02& eeprom, uint8_t base = 0, size_t segments = 4, size_t segsize = 64);
+		~MqttEepromOfflineLog() override = default;
+
+	protected:
+		bool read(size_t offset, void *data, size_t length) override;
+		bool write(size_t offset, const void *data, size_t length) override;
+
+	private:
+		Eeprom24C02& _eeprom;
+		uint8_t _base;
+	};
+}
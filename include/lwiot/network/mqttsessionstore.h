@@ -0,0 +1,122 @@
+/*
+ * Persistent storage for unacknowledged MQTT messages.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/uniquepointer.h>
+#include <lwiot/io/file.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/network/mqttclient.h>
+
+namespace lwiot
+{
+	class Eeprom24C02;
+
+	/**
+	 * @brief Store for the packets of QoS 1 and QoS 2 messages that still have to be acknowledged.
+	 *
+	 * Entries are keyed on the packet identifier and hold the packet that is to be sent again
+	 * after a reconnect: the PUBLISH, or the PUBREL once the broker has received a QoS 2 message.
+	 */
+	class MqttSessionStore {
+	public:
+		typedef Function<void(uint16_t id, const ByteBuffer& packet)> Visitor;
+
+		virtual ~MqttSessionStore() = default;
+
+		/**
+		 * @brief Store \p packet under \p id, replacing the packet that was stored before.
+		 * @return False if the packet could not be stored.
+		 */
+		virtual bool save(uint16_t id, const uint8_t *packet, size_t length) = 0;
+		virtual void remove(uint16_t id) = 0;
+
+		/**
+		 * @brief Call \p visitor for every stored packet.
+		 */
+		virtual void load(const Visitor& visitor) = 0;
+		virtual void clear() = 0;
+	};
+
+	/**
+	 * @brief Session store on byte addressable storage, divided into slots of a fixed size.
+	 *
+	 * A slot holds a two byte packet identifier, a two byte length and the packet. Identifier
+	 * zero marks a free slot. Packets that do not fit in a slot are not stored.
+	 */
+	class MqttSlotSessionStore : public MqttSessionStore {
+	public:
+		explicit MqttSlotSessionStore(size_t slots, size_t slotsize);
+		~MqttSlotSessionStore() override;
+
+		bool save(uint16_t id, const uint8_t *packet, size_t length) override;
+		void remove(uint16_t id) override;
+		void load(const Visitor& visitor) override;
+		void clear() override;
+
+	protected:
+		static constexpr size_t SlotHeader = 4;
+
+		virtual bool read(size_t offset, void *data, size_t length) = 0;
+		virtual bool write(size_t offset, const void *data, size_t length) = 0;
+
+		size_t size() const
+		{
+			return this->_slots * this->_slotsize;
+		}
+
+	private:
+		size_t _slots;
+		size_t _slotsize;
+		uint16_t *_ids;
+		bool _loaded;
+
+		void scan();
+		size_t find(uint16_t id);
+	};
+
+	/**
+	 * @brief Session store in a file, which is created when it does not exist yet.
+	 */
+	class MqttFileSessionStore : public MqttSlotSessionStore {
+	public:
+		explicit MqttFileSessionStore(const String& path, size_t slots = CONFIG_MQTT_MAX_INFLIGHT,
+		                              size_t slotsize = MqttClient::MQTT_MAX_PACKET_SIZE + SlotHeader);
+		~MqttFileSessionStore() override = default;
+
+	protected:
+		bool read(size_t offset, void *data, size_t length) override;
+		bool write(size_t offset, const void *data, size_t length) override;
+
+	private:
+		UniquePointer<File> _file;
+	};
+
+	/**
+	 * @brief Session store in a 24C02 EEPROM, from address \p base onwards.
+	 */
+	class MqttEepromSessionStore : public MqttSlotSessionStore {
+	public:
+		explicit MqttEepromSessionStore(Eeprom24C02& eeprom, uint8_t base = 0, size_t slots = 4, size_t slotsize = 64);
+		~MqttEepromSessionStore() override = default;
+
+	protected:
+		bool read(size_t offset, void *data, size_t length) override;
+		bool write(size_t offset, const void *data, size_t length) override;
+
+	private:
+		Eeprom24C02& _eeprom;
+		uint8_t _base;
+	};
+}
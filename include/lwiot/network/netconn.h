@@ -0,0 +1,36 @@
+/*
+ * Helpers for the lwIP netconn API.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#ifdef HAVE_LWIP
+#include <lwip/api.h>
+#include <lwip/pbuf.h>
+
+#include <lwiot/sharedbytebuffer.h>
+#include <lwiot/network/ipaddress.h>
+
+namespace lwiot
+{
+	namespace netconn
+	{
+		extern void toIpAddr(const IPAddress& addr, ip_addr_t& ip);
+		extern IPAddress fromIpAddr(const ip_addr_t& ip);
+
+		/**
+		 * @brief View the payload of a single pbuf, from \p offset on, without copying it.
+		 *
+		 * The view takes a reference on \p p, which keeps it and the pbufs chained after it
+		 * alive until the last view is destroyed.
+		 */
+		extern SharedByteBuffer share(struct pbuf *p, size_t offset = 0);
+	}
+}
+#endif
@@ -0,0 +1,126 @@
+/*
+ * TCP client on the lwIP netconn API.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <lwiot.h>
+
+#ifdef HAVE_LWIP
+#include <lwip/api.h>
+#include <lwip/pbuf.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/sharedbytebuffer.h>
+#include <lwiot/network/ipaddress.h>
+#include <lwiot/network/tcpclient.h>
+#include <lwiot/network/tcpserver.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief TCP client that reads straight from the pbufs of the lwIP stack.
+	 *
+	 * The socket layer copies every segment from its pbuf into a socket buffer, and the
+	 * read-ahead buffer of the client copies it once more. This client holds on to the pbuf
+	 * chain that netconn_recv_tcp_pbuf() returns instead: peekSpan() and skip() parse the
+	 * payload in place, which is what HttpServer does, and reads copy directly from the pbufs.
+	 * receiveSegment() hands out the payload of a pbuf as a SharedByteBuffer, which keeps the
+	 * pbuf alive until the last view is gone.
+	 *
+	 * @note Each pbuf kept alive holds on to a buffer of the stack; release views quickly.
+	 */
+	class NetconnTcpClient : public TcpClient {
+	public:
+		explicit NetconnTcpClient();
+		explicit NetconnTcpClient(struct netconn *conn);
+		explicit NetconnTcpClient(const IPAddress& addr, uint16_t port);
+		explicit NetconnTcpClient(const String& host, uint16_t port);
+		~NetconnTcpClient() override;
+
+		NetconnTcpClient(const NetconnTcpClient&) = delete;
+		NetconnTcpClient& operator =(const NetconnTcpClient&) = delete;
+
+		explicit operator bool() const override;
+		bool connected() const override;
+		bool alive() const override;
+		bool readable(int tmo) const override;
+
+		size_t available() const override;
+
+		using TcpClient::read;
+		using TcpClient::write;
+
+		ssize_t read(void *output, const size_t& length) override;
+		ssize_t readUntil(char delim, ByteBuffer& output) override;
+		ssize_t skipUntil(char delim) override;
+		RawBuffer peekSpan() override;
+		size_t skip(size_t length) override;
+
+		/**
+		 * @brief Take the unread payload of the current pbuf without copying it.
+		 * @return An empty buffer on timeout or when the peer closed the connection.
+		 */
+		SharedByteBuffer receiveSegment();
+
+		ssize_t write(const void *bytes, const size_t& length) override;
+		ssize_t write(const BufferChain& chain) override;
+
+		bool connect(const IPAddress& addr, uint16_t port) override;
+		bool connect(const String& host, uint16_t port) override;
+		void setTimeout(time_t seconds) override;
+
+		void close() override;
+
+		inline struct netconn *handle() const
+		{
+			return this->_conn;
+		}
+
+	private:
+		struct netconn *_conn;
+		struct pbuf *_rx;
+		size_t _offset;
+		bool _eof;
+
+		ssize_t fetch(int tmo);
+		void consume(size_t length);
+		void copy(ByteBuffer& output, size_t length) const;
+		ssize_t consumeUntil(char delim, ByteBuffer *output);
+		void release();
+	};
+
+	/**
+	 * @brief TCP server that accepts NetconnTcpClient connections.
+	 */
+	class NetconnTcpServer : public TcpServer {
+	public:
+		explicit NetconnTcpServer();
+		explicit NetconnTcpServer(const IPAddress& addr, uint16_t port);
+		~NetconnTcpServer() override;
+
+		NetconnTcpServer(const NetconnTcpServer&) = delete;
+		NetconnTcpServer& operator =(const NetconnTcpServer&) = delete;
+
+		bool bind() const override;
+		bool bind(const IPAddress& addr, uint16_t port) override;
+
+		void connect() override;
+		UniquePointer<TcpClient> accept() override;
+		bool pending(int tmo) override;
+		void close() override;
+		void setTimeout(time_t seconds) override;
+
+	private:
+		struct netconn *_conn;
+		struct netconn *_backlog;
+		time_t _timeout;
+	};
+}
+#endif
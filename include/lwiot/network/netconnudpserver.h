@@ -0,0 +1,72 @@
+/*
+ * UDP server on the lwIP netconn API.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#ifdef HAVE_LWIP
+#include <lwip/api.h>
+
+#include <lwiot/sharedbytebuffer.h>
+#include <lwiot/network/stdnet.h>
+#include <lwiot/network/udpclient.h>
+#include <lwiot/network/udpserver.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief UDP server that receives datagrams as lwIP netbufs.
+	 *
+	 * receive() hands out the datagram as a view of its pbuf, so servers such as DnsServer can
+	 * parse a request without copying it out of the stack first.
+	 */
+	class NetconnUdpServer : public UdpServer {
+	public:
+		explicit NetconnUdpServer();
+		explicit NetconnUdpServer(bind_addr_t addr, uint16_t port);
+		explicit NetconnUdpServer(const IPAddress& addr, uint16_t port);
+		~NetconnUdpServer() override;
+
+		NetconnUdpServer(const NetconnUdpServer&) = delete;
+		NetconnUdpServer& operator =(const NetconnUdpServer&) = delete;
+
+		void close() override;
+		bool bind() override;
+		bool bind(bind_addr_t addr, uint16_t port) override;
+		bool bind(const IPAddress& addr, uint16_t port) override;
+
+		UniquePointer<UdpClient> recv(void *buffer, size_t& length) override;
+		void setTimeout(int tmo) override;
+
+		ssize_t recvFrom(void *buffer, size_t length, IPAddress& addr, uint16_t& port) override;
+		ssize_t sendTo(const void *data, size_t length, const IPAddress& addr, uint16_t port) override;
+
+		/**
+		 * @brief Receive a datagram without copying it.
+		 * @param port Sender port, in host order.
+		 * @return The datagram length, or a negative error code.
+		 * @note Datagrams that span more than one pbuf are copied once.
+		 */
+		ssize_t receive(SharedByteBuffer& datagram, IPAddress& addr, uint16_t& port);
+
+		bool joinGroup(const IPAddress& group);
+		bool leaveGroup(const IPAddress& group);
+
+		inline struct netconn *handle() const
+		{
+			return this->_conn;
+		}
+
+	private:
+		struct netconn *_conn;
+
+		struct netbuf *next(IPAddress& addr, uint16_t& port, err_t& err);
+	};
+}
+#endif
@@ -9,15 +9,58 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <lwiot.h>
 
+#include <lwiot/types.h>
+#include <lwiot/kernel/lock.h>
 #include <lwiot/network/udpclient.h>
 #include <lwiot/network/ipaddress.h>
 
-#include <lwiot/stl/referencewrapper.h>
+#ifndef CONFIG_NTP_SERVERS
+#define CONFIG_NTP_SERVERS 4
+#endif
+
+#ifndef CONFIG_NTP_SAMPLES
+#define CONFIG_NTP_SAMPLES 4
+#endif
+
+#ifndef CONFIG_NTP_MAX_DELAY
+#define CONFIG_NTP_MAX_DELAY 1000
+#endif
+
+#ifndef CONFIG_NTP_STEP
+#define CONFIG_NTP_STEP 128
+#endif
+
+#ifndef CONFIG_NTP_SLEW_RATE
+#define CONFIG_NTP_SLEW_RATE 500
+#endif
+
+#ifndef CONFIG_NTP_MAX_DRIFT
+#define CONFIG_NTP_MAX_DRIFT 500
+#endif
+
+#ifndef CONFIG_NTP_DRIFT_INTERVAL
+#define CONFIG_NTP_DRIFT_INTERVAL 16000
+#endif
 
 namespace lwiot
 {
+	/**
+	 * @brief SNTP client that keeps a disciplined wall clock on top of lwiot_tick_ms().
+	 *
+	 * Every update() sends CONFIG_NTP_SAMPLES requests to each server. The offset of every answer
+	 * is corrected for the round trip, and per server the answer with the shortest round trip is
+	 * used, since it suffers the least from queueing. The clock follows the median of the servers,
+	 * so a single server that is off does not drag it along.
+	 *
+	 * The first update, and offsets larger than CONFIG_NTP_STEP milliseconds, step the clock.
+	 * Smaller offsets are slewed away at CONFIG_NTP_SLEW_RATE parts per million, so the clock
+	 * never jumps or runs backwards. The rate of the tick counter is measured between updates that
+	 * are at least CONFIG_NTP_DRIFT_INTERVAL milliseconds apart and corrected for, which keeps the
+	 * clock accurate without frequent updates.
+	 */
 	class NtpClient {
 	public:
 		explicit NtpClient();
@@ -25,20 +68,55 @@ namespace lwiot
 
 		void begin();
 		void begin(UdpClient& client);
+
+		/**
+		 * @brief Add a server to query, besides the one given to the constructor or begin().
+		 * @return False if there are already CONFIG_NTP_SERVERS servers.
+		 * @note Call this before begin().
+		 */
+		bool addServer(UdpClient& client);
+
+		/**
+		 * @brief Query the servers and discipline the clock.
+		 * @return False if none of the servers answered.
+		 */
 		bool update();
-		time_t time() const;
+
+		time_t time() const; //!< UNIX time in seconds.
+		int64_t milliseconds() const; //!< UNIX time in milliseconds.
+		bool synchronized() const;
+
+		int32_t offset() const; //!< Offset measured by the last update, in milliseconds.
+		uint32_t delay() const; //!< Round trip of the answer the last update used, in milliseconds.
+		int32_t drift() const; //!< Measured drift of the tick counter, in parts per million.
 
 	private:
-		mutable stl::ReferenceWrapper<UdpClient> _client;
+		struct Sample {
+			int64_t time; /* Server time at tick. */
+			time_t tick;
+			int64_t delay;
+		};
+
+		UdpClient *_servers[CONFIG_NTP_SERVERS];
+		size_t _count;
 
-		time_t _current_epoch;
-		time_t _last_update;
+		mutable Lock _lock;
+		bool _synchronized;
+		time_t _base_tick;
+		int64_t _base;
+		int64_t _slew;
+		int32_t _drift;
+		int32_t _offset;
+		uint32_t _delay;
+		uint32_t _sequence;
 
 		constexpr static int NTP_PACKET_SIZE = 48;
 		constexpr static int NTP_DEFAULT_PORT = 1337;
 		constexpr static unsigned long SEVENTY_YEARS = 2208988800UL;
 
 		/* Methods */
-		void sendRequest() const;
+		int64_t estimate(time_t tick) const;
+		bool query(UdpClient& client, Sample& sample);
+		void discipline(int64_t offset, time_t tick);
 	};
 }
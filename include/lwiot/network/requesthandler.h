@@ -15,9 +15,11 @@
 #include <lwiot/log.h>
 #include <lwiot/stl/string.h>
 #include <lwiot/stream.h>
+#include <lwiot/stl/intrusivelist.h>
 #include <lwiot/network/ipaddress.h>
 #include <lwiot/network/tcpserver.h>
 #include <lwiot/network/tcpclient.h>
+#include <lwiot/network/uploadsink.h>
 
 namespace lwiot
 {
@@ -59,6 +61,7 @@ namespace lwiot
 		size_t totalSize;    // file size
 		size_t currentSize;  // size of data currently in buf
 		uint8_t buf[HTTP_UPLOAD_BUFLEN];
+		UploadSink *sink;    // set on UPLOAD_FILE_START to bypass buf
 	} HTTPUpload;
 
 	class RequestHandler {
@@ -67,20 +70,20 @@ namespace lwiot
 		{
 		}
 
-		virtual bool canHandle(HTTPMethod method, String uri)
+		virtual bool canHandle(HTTPMethod method, const String& uri)
 		{
 			(void) method;
 			(void) uri;
 			return false;
 		}
 
-		virtual bool canUpload(String uri)
+		virtual bool canUpload(const String& uri)
 		{
 			(void) uri;
 			return false;
 		}
 
-		virtual bool handle(HttpServer &server, HTTPMethod requestMethod, String requestUri)
+		virtual bool handle(HttpServer &server, HTTPMethod requestMethod, const String& requestUri)
 		{
 			(void) server;
 			(void) requestMethod;
@@ -88,24 +91,13 @@ namespace lwiot
 			return false;
 		}
 
-		virtual void upload(HttpServer &server, String requestUri, HTTPUpload &upload)
+		virtual void upload(HttpServer &server, const String& requestUri, HTTPUpload &upload)
 		{
 			(void) server;
 			(void) requestUri;
 			(void) upload;
 		}
 
-		RequestHandler *next()
-		{
-			return _next;
-		}
-
-		void next(RequestHandler *r)
-		{
-			_next = r;
-		}
-
-	private:
-		RequestHandler *_next = nullptr;
+		stl::IntrusiveListHook hook;
 	};
 }
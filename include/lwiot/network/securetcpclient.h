@@ -12,9 +12,19 @@
 
 #include <lwiot/log.h>
 #include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
 
 #include <lwiot/network/tcpclient.h>
 #include <lwiot/network/stdnet.h>
+#include <lwiot/network/tlssessioncache.h>
+
+#ifndef CONFIG_TLS_RECORD_SIZE
+#define CONFIG_TLS_RECORD_SIZE 0
+#endif
+
+#ifndef CONFIG_TLS_COALESCE_SIZE
+#define CONFIG_TLS_COALESCE_SIZE 256
+#endif
 
 namespace lwiot
 {
@@ -22,6 +32,19 @@ namespace lwiot
 	public:
 		explicit SecureTcpClient();
 		explicit SecureTcpClient(const IPAddress& addr, uint16_t port, const String& host);
+
+		/**
+		 * @brief Wrap an accepted connection and run the server side handshake on it.
+		 * @param socket Socket returned by secure_socket_accept(). The client takes ownership.
+		 * @param tmo Longest time the handshake may take, in milliseconds.
+		 *
+		 * The handshake does not block the caller of available(): every call advances it with
+		 * the data that has arrived, and available() returns 0 until it is complete. read() and
+		 * write() wait for it. A handshake that fails or times out disconnects the client.
+		 *
+		 * @see SecureTcpServer
+		 */
+		explicit SecureTcpClient(secure_socket_t* socket, int tmo);
 		explicit SecureTcpClient(const SecureTcpClient& other);
 		explicit SecureTcpClient(SecureTcpClient&& other);
 
@@ -41,6 +64,32 @@ namespace lwiot
 		void setServerName(const String& host);
 		void setServerCertificate(const String& cert);
 
+		/**
+		 * @brief Resume sessions from \p cache when connecting, and store the negotiated session
+		 *        in it after a handshake. Pass \c nullptr to always do a full handshake.
+		 * @param cache Session cache; it has to outlive the client.
+		 */
+		void setSessionCache(TlsSessionCache* cache);
+		void setSessionTickets(bool enabled);
+
+		/**
+		 * @brief Authenticate using a pre-shared key instead of certificates.
+		 * @param identity PSK identity sent to the server.
+		 * @param key Pre-shared key.
+		 */
+		void setPreSharedKey(const String& identity, const ByteBuffer& key);
+
+		/**
+		 * @brief Limit TLS records to \p size bytes of plaintext.
+		 *
+		 * Smaller records let the TLS binding allocate a few KiB of record buffers per connection
+		 * instead of 32 KiB. The server has to support the max fragment length extension; valid
+		 * sizes are 512, 1024, 2048 and 4096.
+		 *
+		 * @param size Record size, or 0 for the TLS default of 16 KiB.
+		 */
+		void setRecordSize(size_t size);
+
 		explicit operator bool() const override;
 		bool connected() const override;
 
@@ -49,11 +98,40 @@ namespace lwiot
 
 		ssize_t read(void *output, const size_t &length) override;
 		ssize_t write(const void *bytes, const size_t& length) override;
+
+		/**
+		 * @brief Write a buffer chain.
+		 *
+		 * Every write produces at least one TLS record, each with its own header and MAC. Small
+		 * segments are therefore gathered into a buffer of CONFIG_TLS_COALESCE_SIZE bytes and sent
+		 * as one record. Larger segments are passed to the TLS binding directly.
+		 *
+		 * @param chain Chain to write.
+		 * @return The number of bytes written, or an error code if nothing was written.
+		 */
+		ssize_t write(const BufferChain& chain) override;
 		size_t available() const override;
 
 	private:
+		enum class Handshake {
+			Done,
+			Pending,
+			Failed
+		};
+
 		secure_socket_t* _socket;
+		mutable Handshake _handshake;
+		time_t _handshake_start;
+		int _handshake_tmo;
 		String _host;
 		String _cert;
+		TlsSessionCache* _sessions;
+		bool _tickets;
+		String _psk_identity;
+		ByteBuffer _psk;
+		size_t _record_size;
+
+		void copySettings(const SecureTcpClient& other);
+		bool handshake(bool wait) const;
 	};
 }
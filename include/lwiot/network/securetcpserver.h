@@ -0,0 +1,109 @@
+/*
+ * TLS TCP server wrapper.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/stl/string.h>
+
+#include <lwiot/network/ipaddress.h>
+#include <lwiot/network/stdnet.h>
+#include <lwiot/network/sockettcpserver.h>
+#include <lwiot/network/securetcpclient.h>
+#include <lwiot/uniquepointer.h>
+
+#ifndef CONFIG_TLS_HANDSHAKE_TIMEOUT
+#define CONFIG_TLS_HANDSHAKE_TIMEOUT 5000
+#endif
+
+#ifndef CONFIG_TLS_SERVER_SESSIONS
+#define CONFIG_TLS_SERVER_SESSIONS 8
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief TCP server that accepts TLS connections.
+	 *
+	 * The certificate and key are parsed once, when the server is connected, into a TLS
+	 * configuration that all accepted connections share. Only the per connection state is
+	 * allocated on accept. Clients that reconnect resume their session from the server side
+	 * session cache or from a session ticket, which skips the public key operations of a full
+	 * handshake. Browsers open several connections to the same server in parallel, so after the
+	 * first one completes, the others are cheap.
+	 *
+	 * A certificate or key that can not be loaded closes the listening socket, so binding the
+	 * server fails. accept() does not wait for the handshake: it runs on the accepted client,
+	 * driven by its available(), so a client that connects and sends nothing does not hold up
+	 * the other connections of an HttpServer.
+	 *
+	 * Accepted connections are SecureTcpClient objects, so the server can be passed to
+	 * HttpServer like any other TcpServer:
+	 *
+	 * @code
+	 * auto tls = new lwiot::SecureTcpServer(BIND_ADDR_ANY, 443, cert, key);
+	 * lwiot::HttpServer server(tls);
+	 * @endcode
+	 */
+	class SecureTcpServer : public SocketTcpServer {
+	public:
+		explicit SecureTcpServer();
+		explicit SecureTcpServer(BindAddress addr, uint16_t port, const String& cert, const String& key);
+		explicit SecureTcpServer(const IPAddress& addr, uint16_t port, const String& cert, const String& key);
+		~SecureTcpServer() override;
+
+		SecureTcpServer(const SecureTcpServer&) = delete;
+		SecureTcpServer& operator =(const SecureTcpServer&) = delete;
+
+		/**
+		 * @brief Set the PEM encoded certificate chain and private key.
+		 * @note Takes effect the next time the server is connected.
+		 */
+		void setCertificate(const String& cert, const String& key);
+
+		/**
+		 * @brief Size the server side session cache.
+		 * @param size Number of sessions to keep, 0 to disable the cache.
+		 * @param lifetime Lifetime of cached sessions and tickets in milliseconds.
+		 */
+		void setSessionCache(size_t size, int lifetime = CONFIG_TLS_SESSION_LIFETIME);
+		void setSessionTickets(bool enabled);
+
+		/**
+		 * @brief Limit TLS records to \p size bytes of plaintext.
+		 * @see SecureTcpClient::setRecordSize
+		 */
+		void setRecordSize(size_t size);
+
+		/**
+		 * @brief Set the longest time a handshake may take, in milliseconds.
+		 */
+		void setHandshakeTimeout(int tmo);
+
+		void connect() override;
+		UniquePointer<TcpClient> accept() override;
+		size_t acceptMany(UniquePointer<TcpClient>* clients, size_t num) override;
+
+	private:
+		static constexpr size_t AcceptBatch = 8;
+
+		secure_server_t* _server;
+		String _cert;
+		String _key;
+		size_t _sessions;
+		int _lifetime;
+		bool _tickets;
+		size_t _record_size;
+		int _handshake_tmo;
+
+		UniquePointer<TcpClient> secure(socket_t* socket);
+	};
+}
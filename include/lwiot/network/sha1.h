@@ -0,0 +1,41 @@
+/*
+ * SHA-1 hash header.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+
+#define SHA1_DIGEST_SIZE 20
+#define SHA1_BLOCK_SIZE  64
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * SHA-1 is broken as a signature hash. It is provided for protocols that still need it, such as the
+ * WebSocket handshake, and should not be used to protect anything.
+ */
+typedef struct {
+	uint32_t state[5];
+	uint64_t length;
+	uint8_t block[SHA1_BLOCK_SIZE];
+	size_t used;
+} sha1_context_t;
+
+extern DLL_EXPORT void sha1_init(sha1_context_t *ctx);
+extern DLL_EXPORT void sha1_update(sha1_context_t *ctx, const void *data, size_t length);
+extern DLL_EXPORT void sha1_final(sha1_context_t *ctx, uint8_t *digest);
+extern DLL_EXPORT void sha1(const void *data, size_t length, uint8_t *digest);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,37 @@
+/*
+ * SHA-256 hash header.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+
+#define SHA256_DIGEST_SIZE 32
+#define SHA256_BLOCK_SIZE  64
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	uint32_t state[8];
+	uint64_t length;
+	uint8_t block[SHA256_BLOCK_SIZE];
+	size_t used;
+} sha256_context_t;
+
+extern DLL_EXPORT void sha256_init(sha256_context_t *ctx);
+extern DLL_EXPORT void sha256_update(sha256_context_t *ctx, const void *data, size_t length);
+extern DLL_EXPORT void sha256_final(sha256_context_t *ctx, uint8_t *digest);
+extern DLL_EXPORT void sha256(const void *data, size_t length, uint8_t *digest);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,85 @@
+/*
+ * Socket traffic and latency counters.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/network/stdnet.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Traffic and latency counters of a client.
+	 *
+	 * Every client keeps its own counters. All of them also add to process wide totals, which are
+	 * available through global(). Round trip time and retransmits are sampled from the network
+	 * stack when a TCP client is queried, and are zero where the stack does not report them.
+	 *
+	 * @see TcpClient::stats
+	 * @see UdpClient::stats
+	 */
+	class SocketStats {
+	public:
+		explicit SocketStats();
+
+		uint64_t bytes_in; //!< Bytes received.
+		uint64_t bytes_out; //!< Bytes sent.
+		uint32_t reads; //!< Receive calls into the network stack.
+		uint32_t writes; //!< Send calls into the network stack.
+		uint32_t would_block; //!< Calls that timed out or would have blocked.
+		uint32_t errors; //!< Calls that failed otherwise.
+		uint32_t connects; //!< Successful connects.
+		uint32_t connect_failures; //!< Failed connects.
+		time_t connect_time; //!< Duration of the last connect, including a TLS handshake, in ms.
+		uint32_t rtt; //!< Smoothed round trip time in microseconds.
+		uint32_t retransmits; //!< Retransmitted segments.
+
+		void reset();
+
+		/**
+		 * @brief Account a receive call.
+		 * @param rv Return value of the call.
+		 */
+		void received(ssize_t rv);
+
+		/**
+		 * @brief Account a send call.
+		 * @param rv Return value of the call.
+		 */
+		void sent(ssize_t rv);
+
+		/**
+		 * @brief Account a connect attempt.
+		 * @param ok Whether the connect succeeded.
+		 * @param start Tick (lwiot_tick_ms()) at which the attempt started.
+		 */
+		void connected(bool ok, time_t start);
+
+		/**
+		 * @brief Fill the round trip time and retransmits from the network stack.
+		 * @param socket Connected TCP socket.
+		 */
+		void sample(socket_t *socket);
+
+		/**
+		 * @brief Format the counters as space separated key=value pairs.
+		 * @note The format is meant for log lines and MQTT payloads.
+		 */
+		String toString() const;
+
+		/**
+		 * @brief Snapshot of the totals of all clients.
+		 */
+		static SocketStats global();
+		static void resetGlobal();
+	};
+}
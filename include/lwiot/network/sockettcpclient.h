@@ -19,6 +19,10 @@
 #include <lwiot/network/stdnet.h>
 #include <lwiot/network/tcpclient.h>
 
+#ifndef CONFIG_TCP_CONNECT_ADDRESSES
+#define CONFIG_TCP_CONNECT_ADDRESSES 4
+#endif
+
 namespace lwiot
 {
 	class SocketTcpClient : public TcpClient {
@@ -39,6 +43,9 @@ namespace lwiot
 
 		explicit operator bool() const override;
 		bool connected() const override;
+		bool alive() const override;
+		bool writable(int tmo) const override;
+		bool readable(int tmo) const override;
 
 		size_t available() const override;
 
@@ -47,16 +54,37 @@ namespace lwiot
 
 		ssize_t read(void *output, const size_t &length) override;
 		ssize_t write(const void *bytes, const size_t& length) override;
+		ssize_t write(const BufferChain& chain) override;
+#ifdef HAVE_UNISTD_H
+		ssize_t sendFile(File& file, size_t offset, size_t length) override;
+#endif
 
 		bool connect(const IPAddress& addr, uint16_t port) override;
 		bool connect(const String& host, uint16_t port) override;
 		void setTimeout(time_t seconds) override;
+		bool setOption(socket_option_t option, int value) override;
+		SocketStats stats() const override;
 
 		void close() override;
 
+		/**
+		 * @brief Raw socket, for use with socket_poll() or an EventLoop.
+		 */
+		inline socket_t* handle() const
+		{
+			return this->_socket;
+		}
+
+	protected:
+		ssize_t receive(void *output, size_t length) override;
+
 	private:
 		socket_t *_socket;
+		int _options[SOCKET_OPT_MAX];
+		uint32_t _option_mask;
 
 		bool connect();
+		void applyOptions();
+		void copyOptions(const SocketTcpClient& other);
 	};
 }
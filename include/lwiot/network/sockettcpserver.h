@@ -22,6 +22,10 @@
 #include <lwiot/network/tcpserver.h>
 #include <lwiot/uniquepointer.h>
 
+#ifndef CONFIG_TCP_CLIENT_POOL
+#define CONFIG_TCP_CLIENT_POOL 4
+#endif
+
 namespace lwiot
 {
 	class SocketTcpServer : public TcpServer {
@@ -45,9 +49,25 @@ namespace lwiot
 
 		void connect() override;
 		UniquePointer<TcpClient> accept() override;
+		size_t acceptMany(UniquePointer<TcpClient>* clients, size_t num) override;
+		bool pending(int tmo) override;
 		void close() override;
 		void setTimeout(time_t seconds) override ;
 
+		/**
+		 * @brief Set an option on the listening socket.
+		 * @note SOCKET_OPT_REUSEPORT has to be set before bind().
+		 */
+		bool setOption(socket_option_t option, int value);
+
+		/**
+		 * @brief Raw socket, for use with socket_poll() or an EventLoop.
+		 */
+		inline socket_t* handle() const
+		{
+			return this->_socket;
+		}
+
 #ifdef HAVE_LWIP
 		static constexpr int BacklogSize = 16;
 #else
@@ -55,6 +75,8 @@ namespace lwiot
 #endif
 
 	private:
+		static constexpr size_t AcceptBatch = 16;
+
 		socket_t *_socket;
 	};
 }
@@ -31,10 +31,25 @@ namespace lwiot
 		ssize_t write(const void *bytes, const size_t& length) override;
 		void setTimeout(time_t seconds) override;
 
+		bool setOption(socket_option_t option, int value) override;
+		bool joinGroup(const IPAddress& group) override;
+		bool leaveGroup(const IPAddress& group) override;
+		ssize_t broadcast(const void *data, size_t length, uint16_t port) override;
+
+		/**
+		 * @brief Raw socket, for use with socket_poll() or an EventLoop.
+		 */
+		inline socket_t* handle() const
+		{
+			return this->_socket;
+		}
+
 	private:
 		socket_t* _socket;
 		bool _noclose;
+		bool _bound;
 
 		void init();
+		bool open();
 	};
 }
@@ -12,6 +12,10 @@
 #include <lwiot/network/udpserver.h>
 #include <lwiot/network/socketudpserver.h>
 
+#ifndef CONFIG_UDP_CLIENT_POOL
+#define CONFIG_UDP_CLIENT_POOL 4
+#endif
+
 namespace lwiot
 {
 	class SocketUdpServer : public UdpServer {
@@ -29,6 +33,30 @@ namespace lwiot
 		UniquePointer<UdpClient> recv(void *buffer, size_t& length) override;
 		void setTimeout(int tmo) override;
 
+		ssize_t recvFrom(void *buffer, size_t length, IPAddress& addr, uint16_t& port) override;
+		ssize_t sendTo(const void *data, size_t length, const IPAddress& addr, uint16_t port) override;
+		ssize_t recvBatch(DatagramBatch& batch, size_t num) override;
+		ssize_t sendBatch(const DatagramBatch& batch) override;
+
+		/**
+		 * @brief Receive the datagrams sent to the multicast \p group on the bound port.
+		 */
+		bool joinGroup(const IPAddress& group);
+		bool leaveGroup(const IPAddress& group);
+
+		/**
+		 * @brief Set an option on the server socket, such as SOCKET_OPT_BROADCAST.
+		 */
+		bool setOption(socket_option_t option, int value);
+
+		/**
+		 * @brief Raw socket, for use with socket_poll() or an EventLoop.
+		 */
+		inline socket_t* handle() const
+		{
+			return this->_socket;
+		}
+
 	private:
 		socket_t* _socket;
 	};
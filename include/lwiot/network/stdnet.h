@@ -70,6 +70,13 @@ typedef struct {
 	int8_t version;
 } remote_addr_t;
 
+typedef struct socket_tcp_info {
+	uint32_t rtt; //!< Smoothed round trip time in microseconds.
+	uint32_t rtt_var; //!< Round trip time variance in microseconds.
+	uint32_t retransmits; //!< Total number of retransmitted segments.
+	uint32_t cwnd; //!< Congestion window in segments.
+} socket_tcp_info_t;
+
 typedef enum {
 	SOCKET_STREAM,
 	SOCKET_DGRAM
@@ -79,22 +86,112 @@ typedef enum {
 	BIND_ADDR_ANY,
 	BIND_ADDR_LB,
 
-	BIND6_ADDR_ANY
+	BIND6_ADDR_ANY,
+	BIND6_ADDR_LB
 } bind_addr_t;
 
+typedef struct socket_buffer {
+	const void *data;
+	size_t length;
+} socket_buffer_t;
+
+typedef struct socket_datagram {
+	void *data;
+	size_t length;        /* Buffer size on receive, datagram size once received. */
+	remote_addr_t remote; /* Peer address, port in network order. */
+} socket_datagram_t;
+
+typedef enum {
+	SOCKET_OPT_NODELAY,   /* Disable Nagle's algorithm (TCP_NODELAY). */
+	SOCKET_OPT_KEEPALIVE, /* Send keep-alive probes (SO_KEEPALIVE). */
+	SOCKET_OPT_KEEPIDLE,  /* Idle time before the first keep-alive probe, in seconds. */
+	SOCKET_OPT_KEEPINTVL, /* Time between keep-alive probes, in seconds. */
+	SOCKET_OPT_KEEPCNT,   /* Unanswered probes before the connection is dropped. */
+	SOCKET_OPT_SNDBUF,    /* Send buffer size in bytes. */
+	SOCKET_OPT_RCVBUF,    /* Receive buffer size in bytes. */
+	SOCKET_OPT_QUICKACK,  /* Acknowledge immediately instead of delaying ACKs (TCP_QUICKACK). */
+	SOCKET_OPT_REUSEPORT, /* Let several sockets bind the same port (SO_REUSEPORT), set before binding. */
+	SOCKET_OPT_BROADCAST, /* Allow sending to broadcast addresses (SO_BROADCAST). */
+	SOCKET_OPT_MULTICAST_TTL,  /* Hop limit of outgoing multicast datagrams, 1 keeps them on the local network. */
+	SOCKET_OPT_MULTICAST_LOOP, /* Deliver outgoing multicast datagrams to the sending host as well. */
+	SOCKET_OPT_MAX
+} socket_option_t;
+
+#define SOCKET_POLL_READ  0x1U
+#define SOCKET_POLL_WRITE 0x2U
+#define SOCKET_POLL_ERROR 0x4U /* Reported only: error or hang up. */
+
+#define SOCKET_POLL_NOWAIT -1 /* Timeout that only checks readiness, FOREVER (0) blocks. */
+
+typedef struct socket_poll {
+	socket_t *socket;
+	uint32_t events;  /* Events to wait for. */
+	uint32_t revents; /* Events that occurred. */
+} socket_poll_t;
+
 CDECL
 #ifndef HAVE_SOCKET_DEFINITION
 extern DLL_EXPORT socket_t *tcp_socket_create(remote_addr_t *remote);
+/* Connect, giving up after tmo milliseconds. FOREVER waits as long as the network stack does. */
+extern DLL_EXPORT socket_t *tcp_socket_create_timeout(remote_addr_t *remote, int tmo);
+/*
+ * Connect to the first of num addresses that accepts (happy eyeballs, RFC 8305). Attempts are
+ * started CONFIG_CONNECT_ATTEMPT_DELAY milliseconds apart, or as soon as the previous attempt
+ * failed, and run in parallel. Order the addresses by preference, e.g. using
+ * dns_resolve_host_all(). The index of the address that was connected to is stored in index,
+ * unless it is NULL.
+ */
+extern DLL_EXPORT socket_t *tcp_socket_create_any(remote_addr_t *remotes, size_t num, int tmo, size_t *index);
 extern DLL_EXPORT ssize_t tcp_socket_send(socket_t *socket, const void *data, size_t length);
+extern DLL_EXPORT ssize_t tcp_socket_sendv(socket_t *socket, const socket_buffer_t *buffers, size_t num);
+/*
+ * Send length bytes of the file descriptor fd, starting at offset, without copying them through a
+ * user space buffer: sendfile() where the platform has it, a mapping of the file otherwise. Returns
+ * the number of bytes sent, or -ENOTSUPPORTED if the file cannot be sent this way.
+ */
+extern DLL_EXPORT ssize_t tcp_socket_sendfile(socket_t *socket, int fd, size_t offset, size_t length);
 extern DLL_EXPORT ssize_t tcp_socket_read(socket_t *socket, void *data, size_t length);
 extern DLL_EXPORT size_t tcp_socket_available(socket_t *socket);
 extern DLL_EXPORT socket_t *udp_socket_create(remote_addr_t *remote);
 extern DLL_EXPORT ssize_t udp_send_to(socket_t *socket, const void *data, size_t length, remote_addr_t *remote);
 extern DLL_EXPORT ssize_t udp_recv_from(socket_t *socket, void *data, size_t length, remote_addr_t *remote);
 extern DLL_EXPORT size_t udp_socket_available(socket_t *socket);
+/*
+ * Join or leave a multicast group on the default interface. The group must have the address family
+ * of the socket; bind the socket to the port of the group to receive its datagrams.
+ */
+extern DLL_EXPORT int udp_socket_join_group(socket_t *socket, const remote_addr_t *group);
+extern DLL_EXPORT int udp_socket_leave_group(socket_t *socket, const remote_addr_t *group);
+/* Send a datagram to the IPv4 limited broadcast address on port (network order), enabling SO_BROADCAST. */
+extern DLL_EXPORT ssize_t udp_broadcast(socket_t *socket, const void *data, size_t length, uint16_t port);
+/*
+ * Receive or send up to num datagrams in as few calls into the network stack as possible. Receiving
+ * only waits for the first datagram. Both return the number of datagrams transferred, or a negative
+ * error code if none were.
+ */
+extern DLL_EXPORT ssize_t udp_recv_batch(socket_t *socket, socket_datagram_t *datagrams, size_t num);
+extern DLL_EXPORT ssize_t udp_send_batch(socket_t *socket, const socket_datagram_t *datagrams, size_t num);
 
 extern DLL_EXPORT void socket_close(socket_t *socket);
 extern DLL_EXPORT void socket_set_timeout(socket_t *sock, int tmo);
+/* Returns -ENOTSUPPORTED for options the network stack does not have. */
+extern DLL_EXPORT int socket_set_option(socket_t *sock, socket_option_t option, int value);
+extern DLL_EXPORT int socket_get_option(socket_t *sock, socket_option_t option, int *value);
+
+/*
+ * Transport statistics of a connected TCP socket, as reported by the network stack. Returns
+ * -ENOTSUPPORTED when the stack does not expose them.
+ */
+extern DLL_EXPORT int socket_tcp_info(socket_t *sock, socket_tcp_info_t *info);
+/* Check whether the last failed socket call timed out or would have blocked. */
+extern DLL_EXPORT bool socket_would_block(void);
+
+/*
+ * Wait up to tmo milliseconds (FOREVER to block, SOCKET_POLL_NOWAIT to return immediately) until
+ * one of the sockets is ready. Returns the number of ready sockets, 0 on timeout or a negative
+ * error code.
+ */
+extern DLL_EXPORT int socket_poll(socket_poll_t *sockets, size_t num, int tmo);
 
 /* SERVER OPS */
 extern DLL_EXPORT socket_t *server_socket_create(socket_type_t type, bool ipv6);
@@ -102,15 +199,52 @@ extern DLL_EXPORT bool server_socket_bind_to(socket_t *sock, remote_addr_t *remo
 extern DLL_EXPORT bool server_socket_bind(socket_t *sock, bind_addr_t addr, uint16_t port);
 extern DLL_EXPORT bool server_socket_listen(socket_t *socket);
 extern DLL_EXPORT socket_t *server_socket_accept(socket_t *socket);
+/*
+ * Accept up to num connections. Waits for the first one only; the others are taken from the
+ * backlog if they are already pending. Returns the number of accepted connections.
+ */
+extern DLL_EXPORT size_t server_socket_accept_many(socket_t *socket, socket_t **clients, size_t num);
 
 /* DNS */
 extern DLL_EXPORT int dns_resolve_host(const char *host, remote_addr_t *addr);
+/*
+ * Resolve up to num addresses of host, alternating between IPv6 and IPv4 in the order of
+ * preference of the resolver. Returns the number of addresses or a negative error code.
+ */
+extern DLL_EXPORT int dns_resolve_host_all(const char *host, remote_addr_t *addrs, size_t num);
 
 /* SSL */
+typedef struct secure_session secure_session_t;
+
 typedef struct ssl_context {
 	const char *root_ca;
 	const char *client_cert;
 	const char *client_key;
+
+	/*
+	 * Session to resume, saving the full handshake. The binding falls back to a full handshake
+	 * when the server does not accept it.
+	 */
+	const secure_session_t *session;
+	bool session_tickets;
+
+	/* Pre-shared key; used instead of certificates when psk is set. */
+	const uint8_t *psk;
+	size_t psk_length;
+	const char *psk_identity;
+
+	/*
+	 * Largest plaintext record, in bytes. The binding negotiates the max fragment length extension
+	 * and sizes its record buffers to match, instead of allocating 16 KiB per direction. Zero keeps
+	 * the binding default.
+	 */
+	size_t record_size;
+
+	/*
+	 * Additional entropy source for the random generator of the TLS stack, for example a hardware
+	 * RNG. Returns -EOK on success. May be NULL.
+	 */
+	int (*entropy)(void *output, size_t length);
 } ssl_context_t;
 
 extern DLL_EXPORT bool secure_socket_connect(secure_socket_t *socket, const char *host, remote_addr_t* addr, ssl_context_t* context);
@@ -120,5 +254,56 @@ extern DLL_EXPORT size_t secure_socket_available(secure_socket_t* socket);
 extern DLL_EXPORT ssize_t secure_socket_send(secure_socket_t* socket, const void *data, size_t length);
 extern DLL_EXPORT ssize_t secure_socket_recv(secure_socket_t* socket, void *data, size_t length);
 
+#ifdef HAVE_TLS_SESSIONS
+/*
+ * Copy the session (or session ticket) negotiated on a connected socket. The copy outlives the
+ * socket and has to be released using secure_session_free(). Returns NULL on error.
+ */
+extern DLL_EXPORT secure_session_t* secure_socket_get_session(secure_socket_t* socket);
+extern DLL_EXPORT void secure_session_free(secure_session_t* session);
+#endif
+
+/* SSL server */
+typedef struct secure_server secure_server_t;
+
+typedef struct ssl_server_context {
+	const char *cert;
+	const char *key;
+
+	/*
+	 * Number of sessions kept in the server side session cache, so that clients can resume using a
+	 * session ID. Zero disables the cache.
+	 */
+	size_t session_cache_size;
+	/* Lifetime of cached sessions and session tickets, in milliseconds. */
+	int session_lifetime;
+	/* Issue session tickets; the binding generates the ticket keys and rotates them every lifetime. */
+	bool session_tickets;
+
+	/* Largest plaintext record, in bytes. Zero keeps the binding default. */
+	size_t record_size;
+	int (*entropy)(void *output, size_t length);
+} ssl_server_context_t;
+
+/*
+ * Parse the certificate and key once and set up a TLS configuration, session cache and ticket
+ * keys that are shared by every connection accepted with the returned server. Returns NULL on
+ * error. The server is reference counted by the binding, so it may be destroyed while accepted
+ * sockets are still open.
+ */
+extern DLL_EXPORT secure_server_t* secure_server_create(const ssl_server_context_t* context);
+extern DLL_EXPORT void secure_server_destroy(secure_server_t* server);
+/*
+ * Set up the server side of a TLS connection on an accepted socket, without reading from it. Takes
+ * ownership of the socket: it is closed on error, in which case NULL is returned.
+ */
+extern DLL_EXPORT secure_socket_t* secure_socket_accept(secure_server_t* server, socket_t* socket);
+/*
+ * Advance the server side handshake of an accepted socket with the data that has arrived, without
+ * blocking. Returns 1 once the handshake is complete, 0 while it waits for the client and a negative
+ * error code when it failed.
+ */
+extern DLL_EXPORT int secure_socket_handshake(secure_socket_t* socket);
+
 #endif
 CDECL_END
@@ -0,0 +1,53 @@
+/*
+ * Syslog sink for the asynchronous logging backend.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/util/logbackend.h>
+#include <lwiot/network/udpclient.h>
+
+#ifndef CONFIG_LOG_SYSLOG_LENGTH
+#define CONFIG_LOG_SYSLOG_LENGTH 256
+#endif
+
+#ifndef CONFIG_LOG_SYSLOG_FACILITY
+#define CONFIG_LOG_SYSLOG_FACILITY 16 /* local0 */
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Sends every line to a syslog server as an RFC 5424 message.
+	 *
+	 * The subsystem is used as the application name. The timestamp is left out, which lets the
+	 * server use the time of arrival. Lines longer than CONFIG_LOG_SYSLOG_LENGTH are cut off.
+	 */
+	class SyslogLogSink : public LogSink {
+	public:
+		/**
+		 * @param client Client that is connected to the server, usually on port 514.
+		 * @param hostname Name of this device.
+		 */
+		explicit SyslogLogSink(UdpClient& client, const String& hostname = "-");
+
+		void write(const LogRecord& record) override;
+
+	private:
+		UdpClient& _client;
+		String _hostname;
+		char _line[CONFIG_LOG_SYSLOG_LENGTH];
+		size_t _length;
+
+		void send();
+	};
+}
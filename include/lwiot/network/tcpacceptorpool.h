@@ -0,0 +1,67 @@
+/*
+ * Pool of TCP acceptor threads.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/function.h>
+#include <lwiot/uniquepointer.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/network/ipaddress.h>
+#include <lwiot/network/tcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+#include <lwiot/stl/vector.h>
+
+#ifndef CONFIG_ACCEPTOR_BATCH
+#define CONFIG_ACCEPTOR_BATCH 16
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Accept connections on a single port from several threads.
+	 *
+	 * Where the network stack supports SOCKET_OPT_REUSEPORT, every thread gets its own listening
+	 * socket and the kernel spreads incoming connections over them. Otherwise the pool falls back
+	 * to a single listener and a single acceptor thread. Each thread drains its backlog with
+	 * SocketTcpServer::acceptMany() and calls the handler, from that thread, for every connection.
+	 */
+	class TcpAcceptorPool {
+	public:
+		typedef Function<void(UniquePointer<TcpClient>& client)> Handler;
+
+		explicit TcpAcceptorPool(size_t threads = 2, int interval = 100);
+		virtual ~TcpAcceptorPool();
+
+		TcpAcceptorPool(const TcpAcceptorPool&) = delete;
+		TcpAcceptorPool& operator=(const TcpAcceptorPool&) = delete;
+
+		bool start(const IPAddress& addr, uint16_t port, const Handler& handler);
+		bool start(BindAddress addr, uint16_t port, const Handler& handler);
+		void stop();
+
+		/**
+		 * @brief Number of listening sockets, and thus acceptor threads, in use.
+		 */
+		size_t listeners() const;
+
+	private:
+		stl::Vector<SocketTcpServer*> _servers;
+		stl::Vector<FunctionalThread*> _threads;
+		size_t _size;
+		int _interval;
+		AtomicBool _running;
+		Handler _handler;
+
+		void serve(SocketTcpServer* server);
+		void release();
+	};
+}
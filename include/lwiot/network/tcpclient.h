@@ -15,11 +15,30 @@
 #include <lwiot/log.h>
 #include <lwiot/stl/string.h>
 #include <lwiot/stream.h>
+#include <lwiot/bufferchain.h>
+#include <lwiot/bufferedstream.h>
 #include <lwiot/network/ipaddress.h>
 #include <lwiot/network/stdnet.h>
+#include <lwiot/network/socketstats.h>
+
+#ifndef CONFIG_TCP_READAHEAD_SIZE
+#define CONFIG_TCP_READAHEAD_SIZE 128
+#endif
+
+#ifndef CONFIG_TCP_FILE_CHUNK_SIZE
+#define CONFIG_TCP_FILE_CHUNK_SIZE 512
+#endif
 
 namespace lwiot
 {
+	class File;
+
+	/**
+	 * @brief TCP client interface.
+	 *
+	 * Clients that implement receive() get an internal read-ahead buffer: small reads and the
+	 * delimiter based reads are then served from the buffer instead of a socket call per byte.
+	 */
 	class TcpClient : public Stream {
 	public:
 		explicit TcpClient();
@@ -36,6 +55,27 @@ namespace lwiot
 		virtual explicit operator bool() const = 0;
 		virtual bool connected() const = 0;
 
+		/**
+		 * @brief Check whether an idle connection is still usable.
+		 * @return False when the peer closed the connection or it failed. The default returns
+		 *         connected().
+		 */
+		virtual bool alive() const;
+
+		/**
+		 * @brief Wait until the connection accepts more data.
+		 * @param tmo Timeout in milliseconds, SOCKET_POLL_NOWAIT to only check.
+		 * @return True if data can be written without blocking. The default returns connected().
+		 */
+		virtual bool writable(int tmo) const;
+
+		/**
+		 * @brief Wait until data can be read, or the peer closed the connection.
+		 * @param tmo Timeout in milliseconds, SOCKET_POLL_NOWAIT to only check.
+		 * @return True if a read will not block. The default checks available() every millisecond.
+		 */
+		virtual bool readable(int tmo) const;
+
 		using Stream::available;
 
 		Stream &operator<<(char x) override;
@@ -56,21 +96,88 @@ namespace lwiot
 		using Stream::read;
 		uint8_t read() override;
 
+		ssize_t readUntil(char delim, ByteBuffer& output) override;
+		ssize_t skipUntil(char delim) override;
+		RawBuffer peekSpan() override;
+
+		/**
+		 * @brief Discard up to \p length bytes of the data returned by peekSpan().
+		 * @return The number of bytes discarded.
+		 */
+		virtual size_t skip(size_t length);
+
 		using Stream::write;
 		bool write(uint8_t byte) override;
 
+		/**
+		 * @brief Write all segments of \p chain.
+		 * @param chain Segments to write.
+		 * @return The number of bytes written or a negative value on error.
+		 * @note This writes the segments one by one. Implementations that can do a gathered
+		 *       write override this method.
+		 */
+		virtual ssize_t write(const BufferChain& chain);
+
+#ifdef HAVE_UNISTD_H
+		/**
+		 * @brief Send \p length bytes of \p file, starting at \p offset.
+		 * @return The number of bytes sent or a negative value on error.
+		 * @note This reads the file in blocks of CONFIG_TCP_FILE_CHUNK_SIZE bytes. Implementations
+		 *       that can have the network stack read the file override this method.
+		 */
+		virtual ssize_t sendFile(File& file, size_t offset, size_t length);
+#endif
+
 		virtual bool connect(const IPAddress& addr, uint16_t port) = 0;
 		virtual bool connect(const String& host, uint16_t port)    = 0;
 
 		using Stream::setTimeout;
 
+		/**
+		 * @brief Set a socket option, such as SOCKET_OPT_NODELAY.
+		 * @param option Option to set.
+		 * @param value Option value.
+		 * @return True if the option was set, false otherwise (the default).
+		 * @note Clients apply options that are set while disconnected on the next connect.
+		 */
+		virtual bool setOption(socket_option_t option, int value);
+
+		/**
+		 * @brief Limit the time a connect may take.
+		 * @param ms Timeout in milliseconds, FOREVER (the default) to wait on the network stack.
+		 */
+		void setConnectTimeout(int ms);
+
 		virtual void close() = 0;
 
 		const IPAddress& remote() const;
 		uint16_t port() const;
 
+		/**
+		 * @brief Traffic and latency counters of this client.
+		 * @note The counters survive reconnects until resetStats() is called.
+		 */
+		virtual SocketStats stats() const;
+		void resetStats();
+
 	protected:
 		IPAddress _remote_addr;
 		uint16_t _remote_port;
+		BufferedStream _readahead;
+		int _connect_tmo;
+		SocketStats _stats;
+
+		/**
+		 * @brief Read directly from the connection, bypassing the read-ahead buffer.
+		 * @return The number of bytes read, or -ENOTSUPPORTED when the client has no read-ahead.
+		 */
+		virtual ssize_t receive(void *output, size_t length);
+
+		ssize_t readBuffered(void *output, size_t length);
+		void dropReadAhead();
+
+	private:
+		ssize_t fill();
+		ssize_t consumeUntil(char delim, ByteBuffer *output);
 	};
 }
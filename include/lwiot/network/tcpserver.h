@@ -39,6 +39,29 @@ namespace lwiot
 		virtual void connect() = 0;
 
 		virtual UniquePointer<TcpClient> accept() = 0;
+
+		/**
+		 * @brief Accept up to \p num connections.
+		 *
+		 * Waits for the first connection only, the others are taken from the backlog if they are
+		 * already pending. Call it when the listening socket is readable to drain a burst of
+		 * connections in one go.
+		 *
+		 * @param clients Output array of at least \p num entries.
+		 * @param num Maximum number of connections to accept.
+		 * @return The number of accepted connections.
+		 * @note The default implementation accepts a single connection.
+		 */
+		virtual size_t acceptMany(UniquePointer<TcpClient>* clients, size_t num);
+
+		/**
+		 * @brief Wait for an incoming connection.
+		 * @param tmo Timeout in milliseconds, SOCKET_POLL_NOWAIT to return immediately.
+		 * @return True if accept() will not block.
+		 * @note The default implementation cannot tell and always returns true.
+		 */
+		virtual bool pending(int tmo);
+
 		virtual void close() = 0;
 
 		const IPAddress& address() const { return this->_bind_addr; }
@@ -0,0 +1,85 @@
+/*
+ * Cache of resumable TLS sessions.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/network/stdnet.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/vector.h>
+
+#ifndef CONFIG_TLS_SESSION_CACHE_SIZE
+#define CONFIG_TLS_SESSION_CACHE_SIZE 4
+#endif
+
+#ifndef CONFIG_TLS_SESSION_LIFETIME
+#define CONFIG_TLS_SESSION_LIFETIME 3600000
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Store TLS sessions by server name, so that reconnecting to a server resumes the previous
+	 *        session instead of doing a full handshake.
+	 *
+	 * A stored session is handed out at most once: take() removes it from the cache and the caller
+	 * owns it until it is passed back using put(). Sessions older than the lifetime are dropped. When
+	 * the cache is full, the least recently stored session is replaced.
+	 *
+	 * @note Sessions are only produced when the TLS binding is built with HAVE_TLS_SESSIONS. Without
+	 *       it, the cache stays empty.
+	 * @see SecureTcpClient::setSessionCache
+	 */
+	class TlsSessionCache {
+	public:
+		explicit TlsSessionCache(size_t capacity = CONFIG_TLS_SESSION_CACHE_SIZE,
+		                         int lifetime = CONFIG_TLS_SESSION_LIFETIME);
+		virtual ~TlsSessionCache();
+
+		TlsSessionCache(const TlsSessionCache&) = delete;
+		TlsSessionCache& operator=(const TlsSessionCache&) = delete;
+
+		/**
+		 * @brief Remove the session stored for \p host from the cache.
+		 * @param host Server name.
+		 * @return The session, or \c nullptr if none is stored. The caller owns the session.
+		 */
+		secure_session_t* take(const String& host);
+
+		/**
+		 * @brief Store \p session for \p host. An older session for the same host is released.
+		 * @param host Server name.
+		 * @param session Session to store. The cache takes ownership.
+		 */
+		void put(const String& host, secure_session_t* session);
+
+		void remove(const String& host);
+		void clear();
+		size_t size() const;
+
+	private:
+		struct Entry {
+			String host;
+			secure_session_t *session;
+			time_t stored;
+		};
+
+		mutable Lock _lock;
+		stl::Vector<Entry*> _entries;
+		size_t _capacity;
+		int _lifetime;
+
+		ssize_t find(const String& host) const;
+		void erase(size_t idx);
+		void expire(time_t now);
+	};
+}
@@ -0,0 +1,331 @@
+/*
+ * MQTT topic filter trie.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/stl/vector.h>
+
+#ifndef CONFIG_MQTT_TOPIC_LEVELS
+#define CONFIG_MQTT_TOPIC_LEVELS 16
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Values keyed on MQTT topic filters.
+	 * @tparam T Value type.
+	 *
+	 * Filters are stored one `/` separated level per node. The single level wildcard `+` and the
+	 * multi level wildcard `#` have a node of their own, so matching a topic only visits the
+	 * nodes that can match it. Several values can be added for the same filter.
+	 *
+	 * Topics and filters are split into views on the original string; nothing is allocated while
+	 * matching. Topics and filters have at most CONFIG_MQTT_TOPIC_LEVELS levels.
+	 */
+	template <typename T>
+	class TopicTrie {
+	public:
+		explicit TopicTrie() : _root(new Node(StringView()))
+		{
+		}
+
+		TopicTrie(const TopicTrie&) = delete;
+		TopicTrie& operator=(const TopicTrie&) = delete;
+
+		virtual ~TopicTrie()
+		{
+			delete this->_root;
+		}
+
+		/**
+		 * @brief Add a value for \p filter.
+		 * @return False if \p filter is not a valid topic filter.
+		 */
+		bool add(StringView filter, const T& value)
+		{
+			StringView levels[CONFIG_MQTT_TOPIC_LEVELS];
+			auto count = split(filter, levels, CONFIG_MQTT_TOPIC_LEVELS);
+
+			if(!valid(levels, count))
+				return false;
+
+			auto node = this->_root;
+
+			for(size_t idx = 0; idx < count; idx++)
+				node = node->child(levels[idx]);
+
+			node->values.pushback(value);
+			this->_size++;
+
+			return true;
+		}
+
+		/**
+		 * @brief Remove every value of \p filter.
+		 * @return The number of values that were removed.
+		 */
+		size_t remove(StringView filter)
+		{
+			StringView levels[CONFIG_MQTT_TOPIC_LEVELS];
+			auto count = split(filter, levels, CONFIG_MQTT_TOPIC_LEVELS);
+			size_t removed = 0;
+
+			if(!valid(levels, count))
+				return 0;
+
+			this->prune(this->_root, levels, count, removed);
+			this->_size -= removed;
+
+			return removed;
+		}
+
+		/**
+		 * @brief Call \p func for every value whose filter matches \p topic.
+		 * @return The number of matching values.
+		 */
+		template <typename Func>
+		size_t match(StringView topic, Func&& func) const
+		{
+			StringView levels[CONFIG_MQTT_TOPIC_LEVELS];
+			auto count = split(topic, levels, CONFIG_MQTT_TOPIC_LEVELS);
+
+			if(count == 0)
+				return 0;
+
+			/* Wildcards at the first level do not match topics such as $SYS/... */
+			auto system = levels[0].length() != 0 && levels[0][0] == '$';
+
+			return visit(this->_root, levels, count, 0, system, func);
+		}
+
+		void clear()
+		{
+			delete this->_root;
+
+			this->_root = new Node(StringView());
+			this->_size = 0;
+		}
+
+		size_t size() const
+		{
+			return this->_size;
+		}
+
+		bool empty() const
+		{
+			return this->_size == 0;
+		}
+
+		/**
+		 * @brief Filter of a shared subscription, `$share/<group>/<filter>`.
+		 * @return \p filter without the share prefix, or \p filter itself if it is not shared.
+		 */
+		static StringView unshare(StringView filter)
+		{
+			static constexpr size_t prefix = 7;
+
+			if(!filter.startsWith("$share/"))
+				return filter;
+
+			auto end = filter.find('/', prefix);
+			return end == StringView::npos ? filter : filter.substr(end + 1);
+		}
+
+		/**
+		 * @brief Split \p topic into its levels.
+		 * @param topic Topic or filter.
+		 * @param levels Output array.
+		 * @param max Size of \p levels.
+		 * @return The number of levels, or 0 if \p topic is empty or has more than \p max levels.
+		 */
+		static size_t split(StringView topic, StringView* levels, size_t max)
+		{
+			size_t count = 0;
+			size_t start = 0;
+
+			if(topic.length() == 0)
+				return 0;
+
+			for(;;) {
+				auto end = topic.find('/', start);
+
+				if(count == max)
+					return 0;
+
+				if(end == StringView::npos) {
+					levels[count++] = topic.substr(start);
+					return count;
+				}
+
+				levels[count++] = topic.substr(start, end - start);
+				start = end + 1;
+			}
+		}
+
+	private:
+		struct Node {
+			explicit Node(StringView name) : level(name.toString()), plus(nullptr), hash(nullptr)
+			{
+			}
+
+			~Node()
+			{
+				for(auto node : this->children)
+					delete node;
+
+				delete this->plus;
+				delete this->hash;
+			}
+
+			Node* find(StringView name) const
+			{
+				if(name.length() == 1 && name[0] == '+')
+					return this->plus;
+
+				if(name.length() == 1 && name[0] == '#')
+					return this->hash;
+
+				for(auto node : this->children) {
+					if(name.equals(StringView(node->level)))
+						return node;
+				}
+
+				return nullptr;
+			}
+
+			Node* child(StringView name)
+			{
+				auto node = this->find(name);
+
+				if(node != nullptr)
+					return node;
+
+				node = new Node(name);
+
+				if(name.length() == 1 && name[0] == '+')
+					this->plus = node;
+				else if(name.length() == 1 && name[0] == '#')
+					this->hash = node;
+				else
+					this->children.pushback(node);
+
+				return node;
+			}
+
+			bool unused() const
+			{
+				return this->values.size() == 0 && this->children.size() == 0 &&
+					this->plus == nullptr && this->hash == nullptr;
+			}
+
+			String level;
+			stl::Vector<Node*> children;
+			Node* plus;
+			Node* hash;
+			stl::Vector<T> values;
+		};
+
+		Node* _root;
+		size_t _size = 0;
+
+		/* `+` and `#` have to fill a level on their own, and `#` has to be the last level. */
+		static bool valid(const StringView* levels, size_t count)
+		{
+			if(count == 0)
+				return false;
+
+			for(size_t idx = 0; idx < count; idx++) {
+				auto& level = levels[idx];
+
+				if(level.length() <= 1)
+					continue;
+
+				if(level.find('+') != StringView::npos || level.find('#') != StringView::npos)
+					return false;
+			}
+
+			for(size_t idx = 0; idx + 1 < count; idx++) {
+				if(levels[idx].length() == 1 && levels[idx][0] == '#')
+					return false;
+			}
+
+			return true;
+		}
+
+		template <typename Func>
+		static size_t emit(const Node* node, Func& func)
+		{
+			for(auto& value : node->values)
+				func(value);
+
+			return node->values.size();
+		}
+
+		template <typename Func>
+		static size_t visit(const Node* node, const StringView* levels, size_t count, size_t depth,
+		                    bool system, Func& func)
+		{
+			auto wildcards = depth != 0 || !system;
+			size_t matches = 0;
+
+			/* `#` also matches the parent level: a/# matches a. */
+			if(node->hash != nullptr && wildcards)
+				matches += emit(node->hash, func);
+
+			if(depth == count)
+				return matches + emit(node, func);
+
+			auto next = node->find(levels[depth]);
+
+			if(next != nullptr && next != node->plus && next != node->hash)
+				matches += visit(next, levels, count, depth + 1, system, func);
+
+			if(node->plus != nullptr && wildcards)
+				matches += visit(node->plus, levels, count, depth + 1, system, func);
+
+			return matches;
+		}
+
+		static bool prune(Node* node, const StringView* levels, size_t count, size_t& removed, size_t depth = 0)
+		{
+			if(depth == count) {
+				removed += node->values.size();
+				node->values.clear();
+
+				return node->unused();
+			}
+
+			auto next = node->find(levels[depth]);
+
+			if(next == nullptr || !prune(next, levels, count, removed, depth + 1))
+				return false;
+
+			if(next == node->plus) {
+				node->plus = nullptr;
+			} else if(next == node->hash) {
+				node->hash = nullptr;
+			} else {
+				for(size_t idx = 0; idx < node->children.size(); idx++) {
+					if(node->children[idx] == next) {
+						node->children.erase(idx);
+						break;
+					}
+				}
+			}
+
+			delete next;
+			return node->unused();
+		}
+	};
+}
@@ -10,7 +10,9 @@
 #include <lwiot/types.h>
 #include <lwiot/stream.h>
 
+#include <lwiot/network/stdnet.h>
 #include <lwiot/network/ipaddress.h>
+#include <lwiot/network/socketstats.h>
 
 namespace lwiot
 {
@@ -42,6 +44,38 @@ namespace lwiot
 
 		virtual void close() = 0;
 
+		/**
+		 * @brief Set a socket option, such as SOCKET_OPT_MULTICAST_TTL.
+		 * @return True if the option was set, false otherwise (the default).
+		 */
+		virtual bool setOption(socket_option_t option, int value);
+
+		/**
+		 * @brief Receive the datagrams sent to \p group on port().
+		 *
+		 * A client whose address is a multicast group sends every write() to all members of the
+		 * group at once, instead of a unicast datagram per node. To receive them, the members
+		 * join the group.
+		 *
+		 * @return True if the group was joined, false otherwise (the default).
+		 */
+		virtual bool joinGroup(const IPAddress& group);
+		virtual bool leaveGroup(const IPAddress& group);
+
+		/**
+		 * @brief Send a datagram to all hosts on the local IPv4 network.
+		 * @param port Destination port, in host order.
+		 * @return The number of bytes sent, or -ENOTSUPPORTED (the default).
+		 */
+		virtual ssize_t broadcast(const void *data, size_t length, uint16_t port);
+
+		/**
+		 * @brief Limit the number of routers that multicast datagrams cross; 1 (the usual
+		 *        default) keeps them on the local network.
+		 */
+		bool setMulticastTtl(int hops);
+		bool setMulticastLoopback(bool enable);
+
 		using Stream::read;
 		uint8_t read() override;
 
@@ -53,9 +87,16 @@ namespace lwiot
 
 		void resolve();
 
+		/**
+		 * @brief Traffic counters of this client.
+		 */
+		const SocketStats& stats() const;
+		void resetStats();
+
 	protected:
 		IPAddress _remote;
 		uint16_t _port;
 		stl::String _host;
+		SocketStats _stats;
 	};
 }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <lwiot/network/ipaddress.h>
+#include <lwiot/network/datagrambatch.h>
 #include <lwiot/uniquepointer.h>
 
 namespace lwiot
@@ -26,6 +27,41 @@ namespace lwiot
 		virtual UniquePointer<UdpClient> recv(void *buffer, size_t& length) = 0;
 		virtual void setTimeout(int tmo) = 0;
 
+		/**
+		 * @brief Receive a single datagram and report its sender.
+		 * @param buffer Output buffer.
+		 * @param length Size of \p buffer.
+		 * @param addr Sender address.
+		 * @param port Sender port, in host order.
+		 * @return The datagram length, or a negative error code.
+		 * @note Unlike recv() this does not create a client. The default implementation does,
+		 *       through recv(), so servers that can should override it.
+		 */
+		virtual ssize_t recvFrom(void *buffer, size_t length, IPAddress& addr, uint16_t& port);
+
+		/**
+		 * @brief Send a datagram from the server socket.
+		 * @param port Destination port, in host order.
+		 * @return The number of bytes sent, or a negative error code.
+		 */
+		virtual ssize_t sendTo(const void *data, size_t length, const IPAddress& addr, uint16_t port);
+
+		/**
+		 * @brief Receive up to \p num datagrams into \p batch.
+		 *
+		 * Waits for the first datagram only; the others are taken from what is already queued.
+		 *
+		 * @return The number of datagrams received, or a negative error code.
+		 * @note The default implementation receives a single datagram through recv().
+		 */
+		virtual ssize_t recvBatch(DatagramBatch& batch, size_t num);
+
+		/**
+		 * @brief Send all datagrams queued in \p batch.
+		 * @return The number of datagrams sent, or a negative error code.
+		 */
+		virtual ssize_t sendBatch(const DatagramBatch& batch);
+
 		const IPAddress& address() const;
 		uint16_t port() const;
 
@@ -0,0 +1,62 @@
+/*
+ * HTTP upload sink.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stream.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Destination of an uploaded file.
+	 *
+	 * A sink is attached to an upload by setting HTTPUpload::sink when the upload handler is called
+	 * with UPLOAD_FILE_START. The file content is then written to the sink in blocks, straight from
+	 * the receive buffer, instead of being copied into HTTPUpload::buf. Implement this interface to
+	 * write an upload to flash, for example an OTA partition.
+	 */
+	class UploadSink {
+	public:
+		virtual ~UploadSink() = default;
+
+		/**
+		 * @brief Write a block of the file.
+		 * @return False to abort the upload.
+		 */
+		virtual bool write(const uint8_t *data, size_t length) = 0;
+
+		/**
+		 * @brief Complete the file after the last block was written.
+		 * @return False if the file could not be committed, which aborts the upload.
+		 */
+		virtual bool finish();
+
+		/**
+		 * @brief Discard an upload that could not be completed.
+		 */
+		virtual void abort();
+	};
+
+	/**
+	 * @brief Upload sink that writes to a stream, such as a File.
+	 */
+	class StreamUploadSink : public UploadSink {
+	public:
+		explicit StreamUploadSink(Stream& stream);
+		~StreamUploadSink() override = default;
+
+		bool write(const uint8_t *data, size_t length) override;
+
+	private:
+		Stream& _stream;
+	};
+}
@@ -0,0 +1,201 @@
+/*
+ * WebSocket (RFC 6455) server endpoint.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/network/httppushendpoint.h>
+
+#ifndef CONFIG_WEBSOCKET_MAX_MESSAGE
+#define CONFIG_WEBSOCKET_MAX_MESSAGE 1024
+#endif
+
+namespace lwiot
+{
+	namespace websocket
+	{
+		enum Opcode : uint8_t {
+			Continuation = 0x0,
+			Text = 0x1,
+			Binary = 0x2,
+			Close = 0x8,
+			Ping = 0x9,
+			Pong = 0xA
+		};
+
+		/* Close status codes. */
+		constexpr uint16_t NormalClosure = 1000;
+		constexpr uint16_t GoingAway = 1001;
+		constexpr uint16_t ProtocolError = 1002;
+		constexpr uint16_t MessageTooBig = 1009;
+
+		/* Longest frame header a server sends: no masking key. */
+		constexpr size_t MaxHeader = 10;
+
+		/**
+		 * @brief Render the header of an unmasked, final frame.
+		 * @param output Buffer of at least MaxHeader bytes.
+		 * @return The length of the header.
+		 */
+		size_t header(uint8_t *output, Opcode opcode, size_t length);
+
+		/**
+		 * @brief Compute the Sec-WebSocket-Accept value for a Sec-WebSocket-Key.
+		 * @param output Buffer of at least 29 bytes, receives a terminated string.
+		 */
+		void accept(StringView key, char *output);
+	}
+
+	/**
+	 * @brief Incremental parser for the frames a WebSocket client sends.
+	 *
+	 * Data is fed as it arrives. Payloads are unmasked while they are copied, fragmented messages
+	 * are joined, and parsing stops at the end of each complete message or control frame so that
+	 * the caller can handle it. Control frames may arrive between the fragments of a message
+	 * without disturbing it.
+	 */
+	class WebSocketParser {
+	public:
+		explicit WebSocketParser(size_t max = CONFIG_WEBSOCKET_MAX_MESSAGE);
+		virtual ~WebSocketParser() = default;
+
+		WebSocketParser(const WebSocketParser&) = delete;
+		WebSocketParser& operator=(const WebSocketParser&) = delete;
+
+		/**
+		 * @brief Add received data.
+		 * @return The number of bytes consumed. Feeding stops once a message is done().
+		 */
+		size_t feed(const void *data, size_t length);
+
+		/**
+		 * @brief Continue with the next message.
+		 */
+		void next();
+
+		/**
+		 * @brief Forget all state, including a partial message.
+		 */
+		void reset();
+
+		bool done() const;
+
+		/**
+		 * @brief Check whether the client violated the protocol.
+		 * @see error()
+		 */
+		bool failed() const;
+
+		/**
+		 * @brief Close status code that describes the failure.
+		 */
+		uint16_t error() const;
+
+		/**
+		 * @brief Opcode of the message: Text, Binary, Close, Ping or Pong.
+		 */
+		websocket::Opcode opcode() const;
+
+		const uint8_t *payload() const;
+		size_t length() const;
+
+		StringView text() const;
+
+	private:
+		enum State {
+			Head,
+			Payload,
+			Done,
+			Failed
+		};
+
+		ByteBuffer _message;
+		size_t _max;
+		uint8_t _control[125];
+		size_t _controlLength;
+
+		State _state;
+		uint16_t _error;
+		uint8_t _head[14];
+		size_t _headLength;
+		size_t _headNeeded;
+		uint8_t _mask[4];
+		uint64_t _remaining;
+		size_t _offset;
+		websocket::Opcode _frameOpcode;
+		websocket::Opcode _messageOpcode;
+		bool _fin;
+		bool _fragmented;
+
+		void parseHead();
+		void endFrame();
+		void fail(uint16_t code);
+	};
+
+	/**
+	 * @brief WebSocket endpoint with broadcast to all connected clients.
+	 *
+	 * Pings are answered and close handshakes are completed by the endpoint. Messages of up to
+	 * CONFIG_WEBSOCKET_MAX_MESSAGE bytes are passed to the message handler, from the thread that
+	 * calls HttpServer::handleClient(). Clients are identified by their slot number.
+	 */
+	class WebSocketEndpoint : public HttpPushEndpoint {
+	public:
+		typedef Function<void(WebSocketEndpoint&, size_t)> ConnectionHandler;
+		typedef Function<void(WebSocketEndpoint&, size_t, const WebSocketParser&)> MessageHandler;
+
+		explicit WebSocketEndpoint(size_t subscribers = CONFIG_HTTP_PUSH_SUBSCRIBERS);
+		~WebSocketEndpoint() override;
+
+		void onConnect(const ConnectionHandler& handler);
+		void onDisconnect(const ConnectionHandler& handler);
+		void onMessage(const MessageHandler& handler);
+
+		/**
+		 * @brief Send a text message to all clients.
+		 * @return The number of clients that received the message.
+		 */
+		size_t broadcast(StringView text);
+
+		/**
+		 * @brief Send a binary message to all clients.
+		 * @return The number of clients that received the message.
+		 */
+		size_t broadcast(const void *data, size_t length);
+
+		bool send(size_t client, StringView text);
+		bool send(size_t client, const void *data, size_t length);
+
+		/**
+		 * @brief Close the connection to \p client, with a close status code.
+		 */
+		void disconnect(size_t client, uint16_t code = websocket::NormalClosure);
+
+	protected:
+		UniquePointer<TcpClient> handshake(HttpServer& server) override;
+		bool receive(size_t idx, TcpClient& client) override;
+		void attached(size_t idx) override;
+		void detached(size_t idx) override;
+
+	private:
+		WebSocketParser *_parsers;
+		ConnectionHandler _connect;
+		ConnectionHandler _disconnect;
+		MessageHandler _message;
+
+		size_t broadcastFrame(websocket::Opcode opcode, const void *data, size_t length);
+		bool sendFrame(size_t idx, websocket::Opcode opcode, const void *data, size_t length);
+		void sendClose(size_t idx, uint16_t code);
+	};
+}
@@ -7,11 +7,34 @@
 
 #pragma once
 
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
 #include <lwiot/stl/string.h>
 #include <lwiot/network/ipaddress.h>
 
+#ifndef CONFIG_WIFI_CONNECT_TIMEOUT
+#define CONFIG_WIFI_CONNECT_TIMEOUT 10000
+#endif
+
+#ifndef CONFIG_WIFI_FAST_TIMEOUT
+#define CONFIG_WIFI_FAST_TIMEOUT 1000
+#endif
+
+#ifndef CONFIG_WIFI_POLL_INTERVAL
+#define CONFIG_WIFI_POLL_INTERVAL 5
+#endif
+
+#ifndef CONFIG_WIFI_LINK_KEY
+#define CONFIG_WIFI_LINK_KEY "wifi.link"
+#endif
+
 namespace lwiot
 {
+	class KeyValueStore;
+
 	typedef enum {
 		WL_NO_SHIELD        = 255,
 		WL_IDLE_STATUS      = 0,
@@ -23,8 +46,43 @@ namespace lwiot
 		WL_DISCONNECTED     = 6
 	} wireless_status_t;
 
+	/**
+	 * @brief WiFi station interface.
+	 *
+	 * Ports implement connectTo() and report the connection through setStatus() and
+	 * setAddress(). connect() drives a port and waits for the result. With fast reconnect
+	 * enabled it stores the BSSID, channel and DHCP lease of the access point in a key-value
+	 * store once connected. The next connect() to the same network hands these to resume(),
+	 * which associates without scanning and configures the address without DHCP. If that does
+	 * not succeed within CONFIG_WIFI_FAST_TIMEOUT milliseconds the stored link is dropped and
+	 * the station connects the normal way.
+	 */
 	class WifiStation {
 	public:
+		/**
+		 * @brief Parameters of a connection that a fast reconnect reuses.
+		 */
+		struct Link {
+			uint8_t bssid[6];
+			uint8_t channel;
+			IPAddress address;
+			IPAddress gateway;
+			IPAddress netmask;
+			IPAddress dns;
+		};
+
+		/**
+		 * @brief Duration of the phases of the last connect(), in milliseconds.
+		 */
+		struct Timing {
+			bool fast;        //!< Connected using the stored link.
+			bool stored;      //!< The link is stored for the next fast reconnect.
+			time_t resume;    //!< Time spent on a fast reconnect that failed.
+			time_t associate; //!< Scan and association, or association only when \p fast is set.
+			time_t address;   //!< DHCP, or configuring the stored address when \p fast is set.
+			time_t total;
+		};
+
 		explicit WifiStation();
 		virtual ~WifiStation() = default;
 
@@ -35,6 +93,28 @@ namespace lwiot
 		virtual void connectTo(const String& ssid, const String& password);
 		virtual void disconnect();
 
+		/**
+		 * @brief Connect and wait until the station has an address.
+		 * @param ssid Network name.
+		 * @param password Network password.
+		 * @param tmo Timeout in milliseconds.
+		 * @return True if connected.
+		 * @see timing()
+		 */
+		bool connect(const String& ssid, const String& password, int tmo = CONFIG_WIFI_CONNECT_TIMEOUT);
+
+		/**
+		 * @brief Store links in \p store and reuse them in connect().
+		 */
+		void setFastReconnect(KeyValueStore& store);
+
+		/**
+		 * @brief Stop reusing links and remove the stored link.
+		 */
+		void clearFastReconnect();
+
+		const Timing& timing() const;
+
 		virtual void setStatus(wireless_status_t status);
 		wireless_status_t status() const;
 
@@ -47,9 +127,28 @@ namespace lwiot
 		IPAddress _addr;
 		wireless_status_t _status;
 
+		/**
+		 * @brief Get the parameters of the current connection.
+		 * @return False if the port does not support fast reconnects.
+		 */
+		virtual bool link(Link& link) const;
+
+		/**
+		 * @brief Associate with the access point in \p link, on its channel and without scanning,
+		 *        and configure the address in \p link instead of using DHCP.
+		 * @return False if the port does not support fast reconnects.
+		 */
+		virtual bool resume(const String& ssid, const String& password, const Link& link);
+
 	private:
 		String _ssid;
 		String _password;
+		KeyValueStore *_store;
+		Timing _timing;
+
+		bool await(time_t start, int tmo, bool address) const;
+		bool load(const String& ssid, Link& link) const;
+		bool save(const String& ssid, const Link& link) const;
 
 	};
 }
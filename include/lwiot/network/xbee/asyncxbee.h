@@ -19,20 +19,112 @@
 
 #include <lwiot/stream.h>
 
+#include <lwiot/uniquepointer.h>
+
 #include <lwiot/kernel/thread.h>
 #include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/event.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/detail/spscring.h>
+#include <lwiot/stl/unorderedmap.h>
 
 #include <lwiot/network/xbee/xbee.h>
 #include <lwiot/network/xbee/asyncxbee.h>
 #include <lwiot/network/xbee/xbeeresponse.h>
 #include <lwiot/network/xbee/xbeeaddress.h>
 #include <lwiot/network/xbee/xbeerequest.h>
+#include <lwiot/network/xbee/xbeeframe.h>
+
+#ifndef CONFIG_XBEE_RX_RING
+#define CONFIG_XBEE_RX_RING 512
+#endif
+
+/* Interval at which a polled serial stream is read. */
+#ifndef CONFIG_XBEE_RX_POLL
+#define CONFIG_XBEE_RX_POLL 100
+#endif
+
+#ifndef CONFIG_XBEE_TX_TIMEOUT
+#define CONFIG_XBEE_TX_TIMEOUT 500
+#endif
+
+#ifndef CONFIG_XBEE_TX_WINDOW
+#define CONFIG_XBEE_TX_WINDOW 4
+#endif
+
+#ifndef CONFIG_XBEE_TX_RETRIES
+#define CONFIG_XBEE_TX_RETRIES 3
+#endif
+
+#ifndef CONFIG_XBEE_TX_BACKOFF
+#define CONFIG_XBEE_TX_BACKOFF 50
+#endif
+
+#ifndef CONFIG_XBEE_AT_PENDING
+#define CONFIG_XBEE_AT_PENDING 8
+#endif
+
+#ifndef CONFIG_XBEE_AT_TIMEOUT
+#define CONFIG_XBEE_AT_TIMEOUT 1000
+#endif
 
 namespace lwiot
 {
+	/**
+	 * @brief XBee radio served by a background thread.
+	 *
+	 * By default the thread polls the serial stream for frames. In pushed mode the UART driver
+	 * hands received data to receive() or receiveFromIrq() instead, which put it in a lock free
+	 * ring of CONFIG_XBEE_RX_RING bytes. The thread wakes up as soon as data arrives, decodes the
+	 * frames in the ring and passes them to the handler. Transmit status frames are handed to
+	 * the transmitting thread, so that transmitting does not wait for the receiver. Between
+	 * frames the thread sleeps until the next command or transmission times out, if any, so an
+	 * idle radio does not wake up the CPU.
+	 *
+	 * Frames are parsed straight into a pool of CONFIG_XBEE_FRAME_POOL frames. A frame handler
+	 * receives a reference counted handle that it can keep, or pass on to queued work, without
+	 * copying the frame. The receiver pauses while every frame is in use.
+	 *
+	 * AT commands issued through command() or configure() do not wait for each other. Each gets
+	 * its own frame ID and the receive thread matches the responses against a table of
+	 * CONFIG_XBEE_AT_PENDING pending commands.
+	 *
+	 * Transmissions that take a delivery handler are tracked in a window of CONFIG_XBEE_TX_WINDOW
+	 * frames. The transmit status of the radio is matched by frame ID, and a frame that failed is
+	 * sent again after a backoff of CONFIG_XBEE_TX_BACKOFF milliseconds, which doubles with every
+	 * attempt, up to CONFIG_XBEE_TX_RETRIES times.
+	 */
 	class AsyncXbee : public Thread {
 	public:
 		typedef Function<void(XBeeResponse&)> ResponseHandler;
+		typedef Function<void(const XBeeFrame&)> FrameHandler;
+		typedef Function<void(bool ok, const ByteBuffer& value)> CommandHandler;
+		typedef Function<void(bool delivered)> DeliveryHandler;
+
+		/**
+		 * @brief Delivery statistics of a destination.
+		 */
+		struct DeliveryStats {
+			uint32_t delivered;
+			uint32_t failed;
+			uint32_t retries;
+			time_t latency; //!< Average time from transmit to delivery, in milliseconds.
+			time_t maximum; //!< Longest time from transmit to delivery, in milliseconds.
+		};
+
+		/**
+		 * @brief AT command and its parameter, as passed to configure().
+		 */
+		struct AtSetting {
+			const char *command; //!< Two character command name.
+			const uint8_t *value;
+			size_t length;
+		};
+
+		enum class ReceiveMode {
+			Polled, //!< Read frames from the serial stream.
+			Pushed  //!< Decode data passed to receive() and receiveFromIrq().
+		};
 
 		explicit AsyncXbee();
 		explicit AsyncXbee(XBee& xb);
@@ -43,6 +135,29 @@ namespace lwiot
 		void begin(const ResponseHandler& handler);
 
 		void setHandler(const ResponseHandler& handler);
+
+		/**
+		 * @brief Set a handler that receives frames as handles; it replaces the response handler.
+		 */
+		void setFrameHandler(const FrameHandler& handler);
+
+		/**
+		 * @brief Select how received data reaches the radio. Call before begin().
+		 */
+		void setReceiveMode(ReceiveMode mode);
+
+		/**
+		 * @brief Pass data received by the UART in pushed mode.
+		 * @return The number of bytes that fitted in the receive ring.
+		 * @note There can be only one caller at a time, usually the UART driver.
+		 */
+		size_t receive(const void *data, size_t length);
+
+		/**
+		 * @brief Pass data received by the UART from an interrupt handler or DMA callback.
+		 * @see receive()
+		 */
+		size_t receiveFromIrq(const void *data, size_t length);
 		void setDevice(XBee& xb);
 		XBee& getDevice();
 
@@ -60,6 +175,35 @@ namespace lwiot
 		bool transmit(ZigbeeAddress addr, const ByteBuffer& buffer) const;
 		bool transmit(ZigbeeAddress addr, const ByteBuffer& buffer, uint16_t profile, uint16_t cluster) const;
 
+		/**
+		 * @brief Transmit without waiting for the transmit status.
+		 * @param addr Destination.
+		 * @param buffer Data to transmit; it is copied into the transmit window.
+		 * @param handler Called by the receive thread once the frame is delivered or given up.
+		 * @return False when the transmit window stayed full for CONFIG_XBEE_TX_TIMEOUT milliseconds.
+		 */
+		bool transmit(ZigbeeAddress addr, const ByteBuffer& buffer, const DeliveryHandler& handler) const;
+
+		/**
+		 * @brief Wait until every frame in the transmit window is delivered or given up, and its
+		 *        delivery handler has returned.
+		 */
+		bool flush(int tmo = FOREVER) const;
+
+		/**
+		 * @brief Get the delivery statistics of \p destination.
+		 * @param destination 64-bit address, or the 16-bit address for frames sent to one.
+		 * @param stats Statistics output.
+		 * @return False when nothing was transmitted to \p destination.
+		 */
+		bool getDeliveryStats(uint64_t destination, DeliveryStats& stats) const;
+
+		/**
+		 * @brief Snapshot of the receive path counters of the radio.
+		 * @note The receive thread only accounts when built with CONFIG_XBEE_PROFILING.
+		 */
+		XBeeStats stats() const;
+
 		template <typename Func>
 		void setHandler(Func&& handler)
 		{
@@ -88,6 +232,36 @@ namespace lwiot
 
 		void writeToFlash() const;
 
+		/**
+		 * @brief Issue an AT command without waiting for its response.
+		 * @param cmd Two character command name.
+		 * @param value Command parameter.
+		 * @param length Length of \p value.
+		 * @param handler Called by the receive thread with the response, or with \p false after
+		 *                \p tmo milliseconds.
+		 * @param tmo Response timeout.
+		 * @return False when CONFIG_XBEE_AT_PENDING commands are already pending.
+		 */
+		bool command(const char *cmd, const uint8_t *value, size_t length, const CommandHandler& handler,
+		             int tmo = CONFIG_XBEE_AT_TIMEOUT) const;
+
+		/**
+		 * @brief Issue a batch of AT commands back to back and wait for all of their responses.
+		 * @param settings Commands to issue.
+		 * @param count Number of commands.
+		 * @param apply Follow the batch with an AC (apply changes) command.
+		 * @param tmo Time to wait for the whole batch.
+		 * @return True when every command succeeded.
+		 */
+		bool configure(const AtSetting *settings, size_t count, bool apply = true,
+		               int tmo = CONFIG_XBEE_AT_TIMEOUT) const;
+
+		template <size_t N>
+		bool configure(const AtSetting (&settings)[N], bool apply = true, int tmo = CONFIG_XBEE_AT_TIMEOUT) const
+		{
+			return this->configure(settings, N, apply, tmo);
+		}
+
 	protected:
 		void run() override;
 		void init();
@@ -98,6 +272,66 @@ namespace lwiot
 		bool _running;
 		mutable XBee _xb;
 
+		UniquePointer<detail::SpscRing> _ring;
+		mutable Event _rx;
+		mutable Lock _tx_lock;
+		mutable Event _tx_done;
+		mutable atomic_int_t _tx_status;
+
+		FrameHandler _frame_handler;
+		XBeeFramePool _frames;
+		uint8_t *_buffer;
+
+		struct PendingCommand {
+			uint8_t id;
+			time_t deadline;
+			CommandHandler handler;
+		};
+
+		mutable Lock _at_lock;
+		mutable PendingCommand _pending[CONFIG_XBEE_AT_PENDING];
+
+		struct Outstanding {
+			uint8_t id;
+			uint8_t attempts;
+			bool sent;
+			time_t started;
+			time_t deadline;
+			ZigbeeAddress address;
+			ByteBuffer payload;
+			DeliveryHandler handler;
+		};
+
+		mutable Lock _write_lock;
+		mutable Lock _window_lock;
+		mutable Event _window;
+		mutable Outstanding _outstanding[CONFIG_XBEE_TX_WINDOW];
+		int _completing;
+		mutable stl::UnorderedMap<uint64_t, DeliveryStats> _delivery;
+
+		void poll();
+		void decode();
+		bool arm();
+		XBeeFrame take();
+		void dispatch(const XBeeFrame& frame, UniqueLock<Lock>& lock);
+		bool acknowledge(XBeeResponse& response);
+		bool complete(XBeeResponse& response, UniqueLock<Lock>& lock);
+		void expire(UniqueLock<Lock>& lock);
+		int timeout() const;
+		uint8_t issue(const char *cmd, const uint8_t *value, size_t length, const CommandHandler& handler,
+		              int tmo) const;
+		bool claim(uint8_t id, CommandHandler& handler) const;
+
+		bool deliver(XBeeResponse& response, UniqueLock<Lock>& lock);
+		void retransmit(UniqueLock<Lock>& lock);
+		bool retry(Outstanding& entry, time_t now);
+		DeliveryHandler finish(Outstanding& entry, bool delivered, time_t now);
+		void settle();
+		uint8_t nextTransmitId() const;
+
+		template <typename Func>
+		bool transfer(Func&& send) const;
+
 		bool validateTxRequest() const;
 	};
 }
@@ -88,6 +88,8 @@
 #define ZB_IO_NODE_IDENTIFIER_RESPONSE 0x95
 #define AT_COMMAND_RESPONSE 0x88
 #define REMOTE_AT_COMMAND_RESPONSE 0x97
+#define ZB_ROUTE_RECORD_INDICATOR 0xa1
+#define ZB_MANY_TO_ONE_ROUTE_REQUEST 0xa3
 
 
 /**
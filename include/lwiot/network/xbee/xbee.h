@@ -18,12 +18,20 @@
 #include <lwiot/network/xbee/xbeeaddress.h>
 #include <lwiot/network/xbee/xbeeresponse.h>
 #include <lwiot/network/xbee/xbeerequest.h>
+#include <lwiot/network/xbee/xbeenodetable.h>
+#include <lwiot/network/xbee/xbeestats.h>
 
 #include <lwiot/network/zigbeeaddress.h>
 
 #include <lwiot/stl/referencewrapper.h>
+#include <lwiot/detail/spscring.h>
 #include <lwiot/io/gpiopin.h>
 
+/* Start byte, then the length, API ID, frame ID, data and checksum, all of which may be escaped. */
+#ifndef CONFIG_XBEE_TX_BUFFER
+#define CONFIG_XBEE_TX_BUFFER (1 + 2 * (2 + 2 + MAX_FRAME_DATA_SIZE + 1))
+#endif
+
 namespace lwiot
 {
 	class AsyncXbee;
@@ -58,12 +66,30 @@ namespace lwiot
 		void getResponse(XBeeResponse &response);
 		XBeeResponse& getResponse();
 		void send(XBeeRequest &request) const;
-		void send(ZigbeeAddress addr, const ByteBuffer& buffer) const;
+		void send(ZigbeeAddress addr, const ByteBuffer& buffer, uint8_t id = DEFAULT_FRAME_ID) const;
 		void send(ZigbeeAddress addr, const ByteBuffer& buffer, uint16_t profile, uint16_t cluster) const;
 		uint8_t getNextFrameId();
 		void setSerial(Stream &serial);
 		void setSleepPin(const GpioPin& pin);
 
+		/**
+		 * @brief Learn node addresses from received frames, and use them to address transmissions.
+		 * @note The table is not owned by the XBee, and is shared by copies of it.
+		 */
+		void setNodeTable(XBeeNodeTable* table);
+		XBeeNodeTable* getNodeTable() const;
+
+		/**
+		 * @brief Get the cached 16-bit address of \p address, or 0xFFFE when it is unknown.
+		 */
+		uint16_t resolve(uint64_t address) const;
+
+		/**
+		 * @brief Receive path counters of this radio.
+		 * @see XBeeStats
+		 */
+		const XBeeStats& stats() const;
+
 		void apply();
 		uint64_t getHardwareAddress();
 		void setNetworkID(uint16_t netid);
@@ -104,12 +130,17 @@ namespace lwiot
 		uint8_t _max_payload;
 
 		stl::ReferenceWrapper<Stream> _serial;
+		detail::SpscRing* _ring;
+		XBeeNodeTable* _nodes;
 		GpioPin _sleep_pin;
 
+		XBeeStats _stats;
+		uint64_t _started;
+		uint64_t _completed;
+
 		bool available();
 		uint8_t read();
-		void write(uint8_t val) const;
-		void sendByte(uint8_t b, bool escape) const;
+		void write(const uint8_t *data, size_t length) const;
 		void resetResponse();
 		ByteBuffer sendCommand(const uint8_t* cmd, int tmo, const uint8_t* value = nullptr, size_t length = 0U);
 		void fetchMaxPayloadSize();
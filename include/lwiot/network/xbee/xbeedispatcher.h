@@ -0,0 +1,159 @@
+/*
+ * Compile-time XBee response dispatcher.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/move.h>
+#include <lwiot/stl/forward.h>
+#include <lwiot/stl/dispatchtable.h>
+#include <lwiot/traits/decay.h>
+
+#include <lwiot/network/xbee/constants.h>
+#include <lwiot/network/xbee/xbeeresponse.h>
+
+namespace lwiot
+{
+	namespace detail
+	{
+		/* Fill a typed response from the generic one, using the getter that belongs to its type. */
+#ifdef SERIES_2
+		static inline void xbee_response_cast(XBeeResponse& response, ZBTxStatusResponse& typed)
+		{
+			response.getZBTxStatusResponse(typed);
+		}
+
+		static inline void xbee_response_cast(XBeeResponse& response, ZBRxResponse& typed)
+		{
+			response.getZBRxResponse(typed);
+		}
+
+		static inline void xbee_response_cast(XBeeResponse& response, ZBExplicitRxResponse& typed)
+		{
+			response.getZBExplicitRxResponse(typed);
+		}
+
+		static inline void xbee_response_cast(XBeeResponse& response, ZBRxIoSampleResponse& typed)
+		{
+			response.getZBRxIoSampleResponse(typed);
+		}
+#endif
+
+#ifdef SERIES_1
+		static inline void xbee_response_cast(XBeeResponse& response, TxStatusResponse& typed)
+		{
+			response.getTxStatusResponse(typed);
+		}
+
+		static inline void xbee_response_cast(XBeeResponse& response, Rx16Response& typed)
+		{
+			response.getRx16Response(typed);
+		}
+
+		static inline void xbee_response_cast(XBeeResponse& response, Rx64Response& typed)
+		{
+			response.getRx64Response(typed);
+		}
+
+		static inline void xbee_response_cast(XBeeResponse& response, Rx16IoSampleResponse& typed)
+		{
+			response.getRx16IoSampleResponse(typed);
+		}
+
+		static inline void xbee_response_cast(XBeeResponse& response, Rx64IoSampleResponse& typed)
+		{
+			response.getRx64IoSampleResponse(typed);
+		}
+#endif
+
+		static inline void xbee_response_cast(XBeeResponse& response, ModemStatusResponse& typed)
+		{
+			response.getModemStatusResponse(typed);
+		}
+
+		static inline void xbee_response_cast(XBeeResponse& response, AtCommandResponse& typed)
+		{
+			response.getAtCommandResponse(typed);
+		}
+
+		static inline void xbee_response_cast(XBeeResponse& response, RemoteAtCommandResponse& typed)
+		{
+			response.getRemoteAtCommandResponse(typed);
+		}
+	}
+
+	/**
+	 * @brief Dispatch XBee responses to a fixed set of typed handlers.
+	 *
+	 * \p Handler is called with the typed response, so it overloads the call operator for every
+	 * type in \p Responses. The API ID to handler table is built at compile time, so handling a
+	 * response is a single indexed call that the compiler can inline into; nothing is stored
+	 * in a Function.
+	 *
+	 * @code
+	 * struct Handler {
+	 *     void operator()(lwiot::ZBRxResponse& rx);
+	 *     void operator()(lwiot::ModemStatusResponse& status);
+	 * };
+	 *
+	 * auto dispatcher = lwiot::make_xbee_dispatcher<lwiot::ZBRxResponse, lwiot::ModemStatusResponse>(Handler());
+	 *
+	 * xbee.readPacket();
+	 * dispatcher.dispatch(xbee.getResponse());
+	 * @endcode
+	 */
+	template <typename Handler, typename... Responses>
+	class XBeeDispatcher {
+	public:
+		explicit XBeeDispatcher(const Handler& handler) : _handler(handler)
+		{
+		}
+
+		explicit XBeeDispatcher(Handler&& handler) : _handler(stl::move(handler))
+		{
+		}
+
+		/**
+		 * @brief Pass \p response to the handler of its API ID.
+		 * @return False if no handler takes the API ID of \p response.
+		 */
+		bool dispatch(XBeeResponse& response)
+		{
+			return Table::dispatch(response.getApiId(), response, this->_handler);
+		}
+
+		Handler& handler()
+		{
+			return this->_handler;
+		}
+
+	private:
+		struct Invoker {
+			template <typename T>
+			static void invoke(XBeeResponse& response, Handler& handler)
+			{
+				T typed;
+
+				detail::xbee_response_cast(response, typed);
+				handler(typed);
+			}
+		};
+
+		typedef stl::DispatchTable<void(XBeeResponse&, Handler&), Invoker, Responses...> Table;
+
+		Handler _handler;
+	};
+
+	template <typename... Responses, typename Handler>
+	XBeeDispatcher<typename traits::Decay<Handler>::type, Responses...> make_xbee_dispatcher(Handler&& handler)
+	{
+		return XBeeDispatcher<typename traits::Decay<Handler>::type, Responses...>(stl::forward<Handler>(handler));
+	}
+}
@@ -0,0 +1,123 @@
+/*
+ * Pool of received XBee frames.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/function.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/util/poolallocator.h>
+
+#include <lwiot/network/xbee/constants.h>
+#include <lwiot/network/xbee/xbeeresponse.h>
+
+#ifndef CONFIG_XBEE_FRAME_POOL
+#define CONFIG_XBEE_FRAME_POOL 4
+#endif
+
+namespace lwiot
+{
+	class XBeeFramePool;
+
+	/**
+	 * @brief Reference counted handle to a frame in an XBeeFramePool.
+	 *
+	 * Copies share the frame, which returns to its pool when the last handle goes away. Handles
+	 * must not outlive their pool.
+	 */
+	class XBeeFrame {
+	public:
+		XBeeFrame();
+		XBeeFrame(const XBeeFrame& other);
+		XBeeFrame(XBeeFrame&& other) noexcept;
+		~XBeeFrame();
+
+		XBeeFrame& operator=(const XBeeFrame& rhs);
+		XBeeFrame& operator=(XBeeFrame&& rhs) noexcept;
+
+		explicit operator bool() const
+		{
+			return this->_slot != nullptr;
+		}
+
+		/**
+		 * @brief Response that refers to the frame data in the pool.
+		 */
+		XBeeResponse& response() const;
+
+		void reset();
+
+	private:
+		friend class XBeeFramePool;
+
+		struct Slot;
+		Slot* _slot;
+
+		explicit XBeeFrame(Slot* slot);
+	};
+
+	struct XBeeFrame::Slot {
+		uint8_t data[MAX_FRAME_DATA_SIZE];
+		Atomic<int> references;
+		XBeeFramePool* pool;
+		XBeeResponse response;
+	};
+
+	/**
+	 * @brief Fixed pool of CONFIG_XBEE_FRAME_POOL receive frames.
+	 *
+	 * The frame parser writes into a buffer that it reserves with acquire(). Once the frame is
+	 * complete, commit() turns the buffer into a handle, without copying the frame data.
+	 * Allocation and release are lock free.
+	 */
+	class XBeeFramePool {
+	public:
+		typedef Function<void()> ReleaseHandler;
+
+		explicit XBeeFramePool() = default;
+		XBeeFramePool(const XBeeFramePool&) = delete;
+		XBeeFramePool& operator=(const XBeeFramePool&) = delete;
+
+		/**
+		 * @brief Set a handler that is called when a frame returns to the pool.
+		 * @note The handler runs on the thread that drops the last handle.
+		 */
+		void setReleaseHandler(const ReleaseHandler& handler);
+
+		/**
+		 * @brief Reserve a frame buffer of MAX_FRAME_DATA_SIZE bytes.
+		 * @return The buffer, or \p nullptr when every frame is in use.
+		 */
+		uint8_t *acquire();
+
+		/**
+		 * @brief Turn the buffer of \p parsed, obtained from acquire(), into a frame.
+		 */
+		XBeeFrame commit(XBeeResponse& parsed);
+
+		/**
+		 * @brief Return a buffer obtained from acquire() that was not committed.
+		 */
+		void cancel(uint8_t *buffer);
+
+		constexpr size_t frames() const
+		{
+			return CONFIG_XBEE_FRAME_POOL;
+		}
+
+	private:
+		friend class XBeeFrame;
+
+		BlockPool<sizeof(XBeeFrame::Slot), CONFIG_XBEE_FRAME_POOL> _blocks;
+		ReleaseHandler _released;
+
+		void release(XBeeFrame::Slot* slot);
+	};
+}
@@ -0,0 +1,57 @@
+/*
+ * MQTT bridge for XBee end devices.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/network/mqttbridge.h>
+#include <lwiot/network/xbee/asyncxbee.h>
+#include <lwiot/network/xbee/xbeeresponse.h>
+
+#include <lwiot/stl/string.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Bridge between XBee end devices and an MQTT broker.
+	 *
+	 * Every end device is a bridge device named after its 64-bit address, written as 16
+	 * hexadecimal digits, and is added when its first frame arrives. The first byte of a frame
+	 * is a command:
+	 *
+	 * - `P<topic>\0<payload>` publishes \p payload on the relative \p topic; `R` retains it;
+	 * - `S<qos><filter>` subscribes to the relative \p filter, with the QoS as a binary byte;
+	 * - `U<filter>` unsubscribes.
+	 *
+	 * Messages on the subscriptions of a device are transmitted to it as `M<topic>\0<payload>`.
+	 * The bridge does not install itself as the XBee handler: call handle() from the handler.
+	 */
+	class XBeeMqttBridge : public MqttBridge {
+	public:
+		explicit XBeeMqttBridge(AsyncMqttClient& client, AsyncXbee& xbee, const String& prefix);
+		~XBeeMqttBridge() override = default;
+
+		/**
+		 * @brief Handle a frame received by the XBee.
+		 * @return False if \p response is not a valid bridge frame.
+		 */
+		bool handle(XBeeResponse& response);
+
+		/**
+		 * @brief Bridge device name of the end device at \p address.
+		 */
+		static String name(uint64_t address);
+
+	private:
+		AsyncXbee& _xbee;
+
+		void forward(uint64_t address, const String& topic, const SharedByteBuffer& data);
+	};
+}
@@ -0,0 +1,98 @@
+/*
+ * XBee node address table.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/kernel/lock.h>
+
+#include <lwiot/network/xbee/constants.h>
+#include <lwiot/network/xbee/xbeeresponse.h>
+
+#ifndef CONFIG_XBEE_NODE_TABLE
+#define CONFIG_XBEE_NODE_TABLE 16
+#endif
+
+#ifndef CONFIG_XBEE_NODE_AGE
+#define CONFIG_XBEE_NODE_AGE 600000
+#endif
+
+#ifndef CONFIG_XBEE_ROUTE_HOPS
+#define CONFIG_XBEE_ROUTE_HOPS 8
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Cache of 64-bit to 16-bit address mappings of remote nodes.
+	 *
+	 * The table learns mappings from the frames that the radio receives, and the route
+	 * records that it reports for nodes that reply to a many-to-one route request. Entries
+	 * that were not refreshed for CONFIG_XBEE_NODE_AGE milliseconds are aged out. When the
+	 * table is full, the least recently refreshed node makes room.
+	 *
+	 * Transmitting to a 64-bit address with the 16-bit address set to 0xFFFE forces the
+	 * radio to discover the network address first; XBee::send() fills in the cached address
+	 * instead.
+	 */
+	class XBeeNodeTable {
+	public:
+		/**
+		 * @brief Source route from a route record.
+		 */
+		struct Route {
+			uint8_t hops;
+			uint16_t addresses[CONFIG_XBEE_ROUTE_HOPS]; //!< Hops, in the order the radio reports them.
+		};
+
+		explicit XBeeNodeTable(time_t age = CONFIG_XBEE_NODE_AGE);
+		XBeeNodeTable(const XBeeNodeTable&) = delete;
+		XBeeNodeTable& operator=(const XBeeNodeTable&) = delete;
+
+		/**
+		 * @brief Learn the addresses in a received frame.
+		 */
+		void learn(XBeeResponse& response);
+		void learn(uint64_t address64, uint16_t address16);
+
+		/**
+		 * @brief Look up the 16-bit address of \p address64.
+		 * @return False when the node is not in the table, or its entry has expired.
+		 */
+		bool lookup(uint64_t address64, uint16_t& address16) const;
+
+		/**
+		 * @brief Get the last route record of \p address64.
+		 * @return False when no route record was received for the node.
+		 */
+		bool route(uint64_t address64, Route& route) const;
+
+		void forget(uint64_t address64);
+		void clear();
+		size_t size() const;
+
+	private:
+		struct Node {
+			uint64_t address64;
+			uint16_t address16;
+			time_t seen;
+			bool valid;
+			bool routed;
+			Route route;
+		};
+
+		time_t _age;
+		mutable Lock _lock;
+		mutable Node _nodes[CONFIG_XBEE_NODE_TABLE];
+
+		Node* find(uint64_t address64, time_t now) const;
+		Node* insert(uint64_t address64, uint16_t address16, time_t now);
+	};
+}
@@ -0,0 +1,116 @@
+/*
+ * Sleep aware transmit scheduling for XBee end devices.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/bytebuffer.h>
+
+#include <lwiot/kernel/thread.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/event.h>
+
+#include <lwiot/stl/linkedlist.h>
+#include <lwiot/network/xbee/asyncxbee.h>
+
+#ifndef CONFIG_XBEE_SLEEP_QUEUE
+#define CONFIG_XBEE_SLEEP_QUEUE 16
+#endif
+
+#ifndef CONFIG_XBEE_WAKE_TIME
+#define CONFIG_XBEE_WAKE_TIME 15
+#endif
+
+#ifndef CONFIG_XBEE_POLL_TIME
+#define CONFIG_XBEE_POLL_TIME 50
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Batches the transmissions of a pin sleep end device into short awake periods.
+	 *
+	 * Messages are queued while the radio sleeps. Once per period the scheduler pulls the sleep
+	 * pin low, waits CONFIG_XBEE_WAKE_TIME milliseconds for the radio to come up and transmits
+	 * the whole queue through the transmit window of the XBee. Once every message is delivered
+	 * or given up, the radio stays awake for another CONFIG_XBEE_POLL_TIME milliseconds, in
+	 * which it polls its parent for the data that was buffered for it, and is put back to sleep.
+	 *
+	 * The radio should be in PinHibernate mode, with a sleep pin set on its XBee device.
+	 */
+	class XBeeSleepScheduler : public Thread {
+	public:
+		struct Statistics {
+			uint32_t cycles;  //!< Number of times the radio woke up.
+			uint32_t sent;    //!< Messages that were delivered.
+			uint32_t failed;  //!< Messages that were transmitted but not delivered.
+			uint32_t dropped; //!< Messages that did not fit in the queue or the transmit window.
+			time_t awake;     //!< Total awake time, in milliseconds.
+			time_t asleep;    //!< Total sleep time, in milliseconds.
+			time_t longest;   //!< Longest awake period, in milliseconds.
+		};
+
+		/**
+		 * @param xbee Radio to schedule.
+		 * @param period Time between two wake ups, in milliseconds.
+		 */
+		explicit XBeeSleepScheduler(AsyncXbee& xbee, time_t period);
+		~XBeeSleepScheduler() override;
+
+		XBeeSleepScheduler(const XBeeSleepScheduler&) = delete;
+		XBeeSleepScheduler& operator=(const XBeeSleepScheduler&) = delete;
+
+		void begin();
+		void end();
+
+		/**
+		 * @brief Queue \p payload for the next awake period.
+		 * @param handler Called by the receive thread of the XBee once the message is delivered
+		 *                or given up.
+		 * @return False if CONFIG_XBEE_SLEEP_QUEUE messages are already queued.
+		 */
+		bool enqueue(const ZigbeeAddress& address, const ByteBuffer& payload,
+		             const AsyncXbee::DeliveryHandler& handler = AsyncXbee::DeliveryHandler());
+
+		/**
+		 * @brief Start the next awake period now, instead of at the end of the current period.
+		 */
+		void wake();
+
+		Statistics statistics() const;
+
+		/**
+		 * @brief Fraction of the time that the radio was awake.
+		 */
+		double dutyCycle() const;
+
+	protected:
+		void run() override;
+
+	private:
+		struct Message {
+			ZigbeeAddress address;
+			ByteBuffer payload;
+			AsyncXbee::DeliveryHandler handler;
+		};
+
+		AsyncXbee& _xbee;
+		time_t _period;
+
+		mutable Lock _lock;
+		Event _wake;
+		bool _running;
+		stl::LinkedList<Message> _queue;
+		Statistics _stats;
+
+		void cycle();
+		void transmit(Message& message);
+	};
+}
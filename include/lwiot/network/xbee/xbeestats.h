@@ -0,0 +1,115 @@
+/*
+ * XBee receive path counters and latencies.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/string.h>
+
+#ifndef CONFIG_XBEE_STATS_TYPES
+#define CONFIG_XBEE_STATS_TYPES 8
+#endif
+
+#ifdef CONFIG_XBEE_PROFILING
+#define XBEE_PROFILE(expr) expr
+#else
+#define XBEE_PROFILE(expr)
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Counters and latencies of the receive path of an XBee.
+	 *
+	 * The parser and the receive thread of AsyncXbee only account when the library is built with
+	 * CONFIG_XBEE_PROFILING; otherwise every counter stays zero and the receive path is not
+	 * timed at all. Every radio keeps its own counters, which also add to process wide totals
+	 * that are available through global(). Latencies are kept for the first
+	 * CONFIG_XBEE_STATS_TYPES frame types that are received, and only for a single radio.
+	 *
+	 * All times are in microseconds, taken from Clock::now():
+	 * - decode: from the start byte until the checksum of the frame was parsed;
+	 * - dispatch: from the checksum until the handler is called;
+	 * - handle: time spent in the handler.
+	 *
+	 * @see XBee::stats
+	 * @see AsyncXbee::stats
+	 */
+	class XBeeStats {
+	public:
+		struct Latency {
+			uint8_t type; //!< API ID of the frames.
+			uint32_t frames; //!< Frames that were parsed.
+			uint32_t handled; //!< Frames that were passed to a handler.
+			uint64_t decode;
+			uint64_t dispatch;
+			uint64_t handle;
+			uint32_t max_decode;
+			uint32_t max_dispatch;
+			uint32_t max_handle;
+		};
+
+		explicit XBeeStats();
+
+		uint64_t bytes; //!< Bytes parsed.
+		uint32_t frames; //!< Frames that were parsed without errors.
+		uint32_t escapes; //!< Escaped bytes.
+		uint32_t checksum_errors; //!< Frames with a bad checksum.
+		uint32_t framing_errors; //!< Frames cut short by a start byte, or longer than a frame buffer.
+		uint32_t dropped; //!< Frames that were dropped because of an error.
+		uint32_t overruns; //!< Received bytes that did not fit in the receive ring.
+		uint32_t queue_depth; //!< Bytes waiting in the receive ring when the receive thread last woke up.
+		uint32_t max_queue_depth; //!< Largest queue_depth seen.
+
+		void reset();
+
+		void received(size_t bytes);
+		void escaped();
+		void parsed(uint8_t type, uint64_t started, uint64_t completed);
+		void checksumError();
+		void framingError();
+		void overrun(size_t bytes);
+		void queued(size_t depth);
+
+		/**
+		 * @brief Account a frame that was passed to a handler.
+		 * @param type API ID of the frame.
+		 * @param completed Time at which the frame was parsed.
+		 * @param called Time at which the handler was called.
+		 * @param returned Time at which the handler returned.
+		 */
+		void dispatched(uint8_t type, uint64_t completed, uint64_t called, uint64_t returned);
+
+		/**
+		 * @brief Latencies of frames of API ID \p type.
+		 * @return nullptr if no frame of \p type was accounted.
+		 */
+		const Latency* latency(uint8_t type) const;
+
+		/**
+		 * @brief Format the counters, and the average latencies per frame type, as space
+		 *        separated key=value pairs.
+		 */
+		String toString() const;
+
+		/**
+		 * @brief Snapshot of the counter totals of all radios; it holds no latencies.
+		 */
+		static XBeeStats global();
+		static void resetGlobal();
+
+	private:
+		Latency _latency[CONFIG_XBEE_STATS_TYPES];
+		size_t _types;
+
+		Latency* slot(uint8_t type);
+	};
+}
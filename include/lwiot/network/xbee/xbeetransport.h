@@ -0,0 +1,129 @@
+/*
+ * Fragmenting transport over XBee.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/function.h>
+#include <lwiot/bytebuffer.h>
+
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/event.h>
+
+#include <lwiot/network/xbee/asyncxbee.h>
+#include <lwiot/network/xbee/xbeeresponse.h>
+
+#ifndef CONFIG_XBEE_TRANSPORT_WINDOW
+#define CONFIG_XBEE_TRANSPORT_WINDOW 8
+#endif
+
+#ifndef CONFIG_XBEE_TRANSPORT_SESSIONS
+#define CONFIG_XBEE_TRANSPORT_SESSIONS 2
+#endif
+
+#ifndef CONFIG_XBEE_TRANSPORT_TIMEOUT
+#define CONFIG_XBEE_TRANSPORT_TIMEOUT 1000
+#endif
+
+#ifndef CONFIG_XBEE_TRANSPORT_RETRIES
+#define CONFIG_XBEE_TRANSPORT_RETRIES 5
+#endif
+
+#ifndef CONFIG_XBEE_TRANSPORT_MTU
+#define CONFIG_XBEE_TRANSPORT_MTU 64
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Transport for messages that do not fit in a single XBee frame.
+	 *
+	 * Messages are split into at most 255 sequence numbered fragments, which are sent in bursts
+	 * of CONFIG_XBEE_TRANSPORT_WINDOW. The last fragment of a burst asks the receiver for an
+	 * acknowledgement, which holds a bitmap of the fragments that arrived. Only the missing
+	 * fragments are sent again. A burst that is not acknowledged within
+	 * CONFIG_XBEE_TRANSPORT_TIMEOUT milliseconds is repeated, up to CONFIG_XBEE_TRANSPORT_RETRIES
+	 * times in a row.
+	 *
+	 * Received messages are reassembled in a pool of CONFIG_XBEE_TRANSPORT_SESSIONS buffers,
+	 * which are reused from message to message. The transport does not install itself as the
+	 * XBee handler: call handle() from the handler.
+	 */
+	class XBeeTransport {
+	public:
+		typedef Function<void(uint64_t source, const ByteBuffer& message)> MessageHandler;
+
+		explicit XBeeTransport(AsyncXbee& xbee);
+		XBeeTransport(const XBeeTransport&) = delete;
+		XBeeTransport& operator=(const XBeeTransport&) = delete;
+
+		/**
+		 * @brief Set the handler of reassembled messages.
+		 * @note The message refers to a pooled buffer, which is only valid while the handler runs.
+		 */
+		void setHandler(const MessageHandler& handler);
+
+		/**
+		 * @brief Send \p message to \p destination and wait until all of it is acknowledged.
+		 * @return False if the message is too large, or the receiver stopped acknowledging.
+		 */
+		bool send(uint64_t destination, const ByteBuffer& message);
+
+		/**
+		 * @brief Handle a frame received by the XBee.
+		 * @return False if \p response is not a transport frame.
+		 * @note Call this from the receive thread of the XBee only.
+		 */
+		bool handle(XBeeResponse& response);
+
+		/**
+		 * @brief Number of message bytes per fragment.
+		 */
+		size_t mtu() const;
+
+	private:
+		enum SessionState {
+			Free,
+			Receiving,
+			Complete
+		};
+
+		struct Session {
+			SessionState state;
+			uint64_t source;
+			uint8_t id;
+			uint8_t count;
+			uint8_t size;
+			uint8_t received;
+			time_t updated;
+			uint8_t fragments[32];
+			ByteBuffer data;
+		};
+
+		AsyncXbee& _xbee;
+		MessageHandler _handler;
+		Session _sessions[CONFIG_XBEE_TRANSPORT_SESSIONS];
+
+		Lock _send_lock;
+		Lock _lock;
+		Event _acked;
+		uint64_t _destination;
+		uint8_t _id;
+		uint8_t _count;
+		uint8_t _fragments[32];
+		uint32_t _acks;
+
+		Session* session(uint64_t source, const uint8_t* header, time_t now);
+		void acknowledge(const Session& session);
+		bool receive(uint64_t source, const uint8_t* data, size_t length);
+		void update(uint64_t source, const uint8_t* data, size_t length);
+		void transmit(uint64_t destination, const ByteBuffer& frame);
+	};
+}
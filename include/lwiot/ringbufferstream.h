@@ -0,0 +1,70 @@
+/*
+ * Lock-free ring buffer stream definition.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#include <lwiot/stream.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/kernel/atomic.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Byte stream backed by a single producer, single consumer ring buffer.
+	 *
+	 * Writes never block and never allocate: bytes that do not fit are dropped and write() reports
+	 * how many were stored. One context (e.g. an interrupt handler) may write while another context
+	 * reads, without any locking.
+	 */
+	class RingBufferStream : public Stream {
+	public:
+		explicit RingBufferStream(size_t capacity);
+		~RingBufferStream() override;
+
+		RingBufferStream(const RingBufferStream&) = delete;
+		RingBufferStream& operator=(const RingBufferStream&) = delete;
+
+		Stream& operator << (char x) override;
+		Stream& operator << (short x) override;
+		Stream& operator << (int  x) override;
+		Stream& operator << (const long&  x) override;
+		Stream& operator << (const long long&  x) override;
+
+		Stream& operator << (unsigned char x) override;
+		Stream& operator << (unsigned short x) override;
+		Stream& operator << (unsigned int  x) override;
+		Stream& operator << (const unsigned long&  x) override;
+		Stream& operator << (const unsigned long long&  x) override;
+
+		Stream& operator << (const double& flt) override;
+		Stream& operator << (const float& flt) override;
+
+		Stream& operator << (const String& str) override;
+		Stream& operator << (const char *cstr) override;
+
+		size_t available() const override;
+		size_t capacity() const;
+		bool full() const;
+
+		uint8_t read() override;
+		ssize_t read(void *output, const size_t& length) override;
+		using Stream::read;
+
+		bool write(uint8_t byte) override;
+		ssize_t write(const void *bytes, const size_t& length) override;
+		using Stream::write;
+
+	private:
+		uint8_t *_data;
+		size_t _mask;
+		lwiot::Atomic<size_t> _head;
+		lwiot::Atomic<size_t> _tail;
+	};
+}
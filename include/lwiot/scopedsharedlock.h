@@ -0,0 +1,58 @@
+/*
+ * Scoped shared lock definition.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <lwiot.h>
+#include <stdlib.h>
+
+#include <lwiot/kernel/sharedlock.h>
+#include <lwiot/stl/referencewrapper.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Hold a SharedLock in shared (reader) mode for the lifetime of the guard.
+	 * @note Use UniqueLock<SharedLock> to hold the lock exclusively.
+	 */
+	class ScopedSharedLock {
+	public:
+		explicit ScopedSharedLock(SharedLock& lock) : _lock(lock), _locked(false)
+		{
+			this->lock();
+		}
+
+		explicit ScopedSharedLock(SharedLock* lock) : ScopedSharedLock(*lock)
+		{
+		}
+
+		~ScopedSharedLock()
+		{
+			if(this->_locked)
+				this->unlock();
+		}
+
+		ScopedSharedLock(const ScopedSharedLock&) = delete;
+		ScopedSharedLock& operator=(const ScopedSharedLock&) = delete;
+
+		void lock() const
+		{
+			this->_lock->lock_shared();
+			this->_locked = true;
+		}
+
+		void unlock() const
+		{
+			this->_locked = false;
+			this->_lock->unlock_shared();
+		}
+
+	private:
+		stl::ReferenceWrapper<SharedLock> _lock;
+		mutable bool _locked;
+	};
+}
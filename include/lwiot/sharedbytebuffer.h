@@ -0,0 +1,106 @@
+/*
+ * Reference counted, immutable byte buffer.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#include <lwiot/bytebuffer.h>
+#include <lwiot/sharedpointer.h>
+
+#ifdef __cplusplus
+namespace lwiot
+{
+	/**
+	 * @brief Immutable view on a reference counted byte buffer.
+	 *
+	 * Copying a SharedByteBuffer or taking a slice of it only copies a reference: all views share
+	 * the same storage, which is released when the last view is destroyed. This makes it cheap to
+	 * hand a single payload to several consumers, or to queue it for later processing.
+	 */
+	class SharedByteBuffer {
+	public:
+		static constexpr size_t npos = ~size_t(0);
+
+		explicit SharedByteBuffer();
+		explicit SharedByteBuffer(const void *data, size_t length);
+		explicit SharedByteBuffer(const ByteBuffer& buffer);
+		explicit SharedByteBuffer(ByteBuffer&& buffer);
+
+		/**
+		 * @brief View all data written to \p storage, without copying it.
+		 */
+		explicit SharedByteBuffer(const SharedPointer<ByteBuffer>& storage);
+
+		SharedByteBuffer(const SharedByteBuffer& other) = default;
+		SharedByteBuffer(SharedByteBuffer&& other) noexcept;
+		~SharedByteBuffer() = default;
+
+		SharedByteBuffer& operator =(const SharedByteBuffer& rhs) = default;
+		SharedByteBuffer& operator =(SharedByteBuffer&& rhs) noexcept;
+
+		/**
+		 * @brief Create a view on a part of this buffer.
+		 * @param offset Start of the slice.
+		 * @param length Number of bytes, clipped to the end of this view.
+		 * @return A view that shares its storage with this buffer.
+		 */
+		SharedByteBuffer slice(size_t offset, size_t length = npos) const;
+
+		/**
+		 * @brief Copy the view into a new, mutable ByteBuffer.
+		 */
+		ByteBuffer toByteBuffer() const;
+
+		bool operator ==(const SharedByteBuffer& rhs) const;
+		bool operator !=(const SharedByteBuffer& rhs) const;
+
+		const uint8_t& operator[](size_t idx) const
+		{
+			return this->data()[idx];
+		}
+
+		const uint8_t *data() const
+		{
+			return this->_storage ? this->_storage->data() + this->_offset : nullptr;
+		}
+
+		const uint8_t *begin() const
+		{
+			return this->data();
+		}
+
+		const uint8_t *end() const
+		{
+			return this->data() + this->_length;
+		}
+
+		constexpr size_t size() const
+		{
+			return this->_length;
+		}
+
+		constexpr bool empty() const
+		{
+			return this->_length == 0;
+		}
+
+		long useCount() const
+		{
+			return this->_storage.useCount();
+		}
+
+	private:
+		SharedPointer<ByteBuffer> _storage;
+		size_t _offset;
+		size_t _length;
+
+		explicit SharedByteBuffer(const SharedPointer<ByteBuffer>& storage, size_t offset, size_t length);
+	};
+}
+#endif
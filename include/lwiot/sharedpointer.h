@@ -17,6 +17,7 @@
 #include <lwiot/log.h>
 
 #include <lwiot/stl/move.h>
+#include <lwiot/stl/forward.h>
 
 #ifndef SHARED_ASSERT
 #define SHARED_ASSERT(__x__) assert(__x__)
@@ -24,11 +25,52 @@
 
 namespace lwiot
 {
+	namespace detail
+	{
+		/*
+		 * Reference count of a shared object. Blocks created by makeShared() hold the object
+		 * as well and destroy both through dispose. Otherwise dispose is null and the object
+		 * is deleted separately.
+		 */
+		struct SharedControlBlock {
+			typedef void (*Dispose)(SharedControlBlock* block);
+
+			explicit SharedControlBlock(Dispose dispose = nullptr) : count(1L), dispose(dispose)
+			{ }
+
+			Atomic<long> count;
+			Dispose dispose;
+		};
+
+		template <typename T>
+		struct SharedObjectBlock : public SharedControlBlock {
+			template <typename... Args>
+			explicit SharedObjectBlock(Args&&... args) : SharedControlBlock(&SharedObjectBlock::destroy),
+				object(stl::forward<Args>(args)...)
+			{ }
+
+			T object;
+
+			static void destroy(SharedControlBlock* block)
+			{
+				delete static_cast<SharedObjectBlock*>(block);
+			}
+		};
+	}
+
+	/*
+	 * References are taken with relaxed increments. Dropping a reference is an acq_rel
+	 * decrement, so everything done through other references happens before the object is
+	 * destroyed, without further locking.
+	 */
 	class SharedPointerCount {
 	public:
 		constexpr SharedPointerCount() : _count(nullptr)
 		{ }
 
+		explicit constexpr SharedPointerCount(detail::SharedControlBlock* block) : _count(block)
+		{ }
+
 		constexpr SharedPointerCount(const SharedPointerCount &count) = default;
 		SharedPointerCount(SharedPointerCount&& count) noexcept;
 		virtual ~SharedPointerCount() = default;
@@ -45,9 +87,9 @@ namespace lwiot
 		{
 			if(p != nullptr) {
 				if(this->_count == nullptr) {
-					this->_count = new Atomic<long>(1L);
+					this->_count = new detail::SharedControlBlock();
 				} else {
-					this->_count->fetch_add(1);
+					this->_count->count.fetch_add(1, memory_order_relaxed);
 				}
 			}
 		}
@@ -56,13 +98,16 @@ namespace lwiot
 		CONSTEXPR void release(U *p) noexcept
 		{
 			if(this->_count != nullptr) {
-				this->_count->fetch_sub(1);
-
-				if(this->_count->load() == 0L) {
-					if(p)
-						delete p;
-
-					delete this->_count;
+				/* Only the thread that drops the last reference may free the object. */
+				if(this->_count->count.fetch_sub(1, memory_order_acq_rel) == 1L) {
+					if(this->_count->dispose) {
+						this->_count->dispose(this->_count);
+					} else {
+						if(p)
+							delete p;
+
+						delete this->_count;
+					}
 				}
 
 				this->_count = nullptr;
@@ -70,7 +115,7 @@ namespace lwiot
 		}
 
 	private:
-		Atomic<long> *_count;
+		detail::SharedControlBlock *_count;
 	};
 
 	template<typename T>
@@ -233,13 +278,32 @@ namespace lwiot
 			this->_pn.acquire();
 		}
 
+		explicit SharedPointer(detail::SharedObjectBlock<T>* block) noexcept : _ptr(&block->object), _pn(block)
+		{
+		}
+
 		template<class U>
 		friend class SharedPointer;
 
+		template <typename U, typename... Args>
+		friend SharedPointer<U> makeShared(Args&&... args);
+
 		PointerType *_ptr;
 		SharedPointerCount _pn;
 	};
 
+	/**
+	 * @brief Create a shared object.
+	 * @param args Constructor arguments.
+	 * @return A shared pointer to the new object.
+	 * @note The object and its reference count share a single allocation.
+	 */
+	template <typename T, typename... Args>
+	SharedPointer<T> makeShared(Args&&... args)
+	{
+		return SharedPointer<T>(new detail::SharedObjectBlock<T>(stl::forward<Args>(args)...));
+	}
+
 	template<class T, class U>
 	CONSTEXPR bool operator==(const SharedPointer<T>& l, const SharedPointer<U>& r) noexcept
 	{
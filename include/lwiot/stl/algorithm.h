@@ -0,0 +1,594 @@
+/*
+ * Sort, search and reduction algorithms.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <lwiot.h>
+
+#include <lwiot/stl/move.h>
+
+#ifndef CONFIG_STANDALONE
+#include <lwiot/sharedpointer.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/kernel/executor.h>
+#include <lwiot/kernel/event.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/stl/vector.h>
+#endif
+
+#ifndef CONFIG_PARALLEL_GRAIN
+#define CONFIG_PARALLEL_GRAIN 512
+#endif
+
+#ifndef CONFIG_PARALLEL_MAX_PARTS
+#define CONFIG_PARALLEL_MAX_PARTS 16
+#endif
+
+/*
+ * The algorithms take random access iterators, such as those of stl::Vector or plain pointers,
+ * and follow the semantics of their standard library counterparts.
+ */
+namespace lwiot
+{
+	namespace stl
+	{
+		namespace detail
+		{
+			struct Less {
+				template <typename T, typename U>
+				constexpr bool operator()(const T& a, const U& b) const
+				{
+					return a < b;
+				}
+			};
+
+			struct Plus {
+				template <typename T, typename U>
+				constexpr T operator()(const T& a, const U& b) const
+				{
+					return a + b;
+				}
+			};
+
+			/* Below this size, partitions are left for the final insertion sort. */
+			static constexpr ptrdiff_t SortThreshold = 16;
+
+			static inline int depth_limit(ptrdiff_t length)
+			{
+				int depth = 0;
+
+				for(; length > 1; length >>= 1)
+					depth += 2;
+
+				return depth;
+			}
+
+			template <typename Iter, typename Compare>
+			void insertion_sort(Iter first, Iter last, Compare& comp)
+			{
+				if(first == last)
+					return;
+
+				for(auto iter = first + 1; iter < last; ++iter) {
+					auto value = stl::move(*iter);
+					auto hole = iter;
+
+					for(; hole > first && comp(value, *(hole - 1)); --hole)
+						*hole = stl::move(*(hole - 1));
+
+					*hole = stl::move(value);
+				}
+			}
+
+			template <typename Iter, typename Compare>
+			void sift_down(Iter first, ptrdiff_t root, ptrdiff_t length, Compare& comp)
+			{
+				ptrdiff_t child;
+
+				while((child = 2 * root + 1) < length) {
+					if(child + 1 < length && comp(first[child], first[child + 1]))
+						child++;
+
+					if(!comp(first[root], first[child]))
+						return;
+
+					stl::swap(first[root], first[child]);
+					root = child;
+				}
+			}
+
+			template <typename Iter, typename Compare>
+			void heap_sort(Iter first, Iter last, Compare& comp)
+			{
+				auto length = last - first;
+
+				for(auto root = length / 2 - 1; root >= 0; root--)
+					sift_down(first, root, length, comp);
+
+				for(auto end = length - 1; end > 0; end--) {
+					stl::swap(first[0], first[end]);
+					sift_down(first, 0, end, comp);
+				}
+			}
+
+			template <typename Iter, typename Compare>
+			void move_median_to_first(Iter result, Iter a, Iter b, Iter c, Compare& comp)
+			{
+				if(comp(*a, *b)) {
+					if(comp(*b, *c))
+						stl::swap(*result, *b);
+					else if(comp(*a, *c))
+						stl::swap(*result, *c);
+					else
+						stl::swap(*result, *a);
+				} else if(comp(*a, *c)) {
+					stl::swap(*result, *a);
+				} else if(comp(*b, *c)) {
+					stl::swap(*result, *c);
+				} else {
+					stl::swap(*result, *b);
+				}
+			}
+
+			/*
+			 * Partition around the median of three, which is moved to *first. Elements before the
+			 * returned iterator are not greater than the pivot, those after it are not less. The
+			 * pivot guards both scans, so they need no bounds checks.
+			 */
+			template <typename Iter, typename Compare>
+			Iter partition_pivot(Iter first, Iter last, Compare& comp)
+			{
+				auto mid = first + (last - first) / 2;
+				auto pivot = first;
+
+				move_median_to_first(first, first + 1, mid, last - 1, comp);
+				++first;
+
+				while(true) {
+					while(comp(*first, *pivot))
+						++first;
+
+					--last;
+
+					while(comp(*pivot, *last))
+						--last;
+
+					if(!(first < last))
+						return first;
+
+					stl::swap(*first, *last);
+					++first;
+				}
+			}
+
+			template <typename Iter, typename Compare>
+			void introsort_loop(Iter first, Iter last, int depth, Compare& comp)
+			{
+				while(last - first > SortThreshold) {
+					if(depth == 0) {
+						heap_sort(first, last, comp);
+						return;
+					}
+
+					depth--;
+
+					auto cut = partition_pivot(first, last, comp);
+					introsort_loop(cut, last, depth, comp);
+					last = cut;
+				}
+			}
+		}
+
+		/**
+		 * @brief Sort [first, last) using introsort.
+		 *
+		 * Quicksort with a median of three pivot, which falls back to heap sort when the
+		 * recursion gets too deep, so the worst case stays O(n log n). The sort is not stable
+		 * and does not allocate.
+		 */
+		template <typename Iter, typename Compare>
+		void sort(Iter first, Iter last, Compare comp)
+		{
+			if(last - first < 2)
+				return;
+
+			detail::introsort_loop(first, last, detail::depth_limit(last - first), comp);
+			detail::insertion_sort(first, last, comp);
+		}
+
+		template <typename Iter>
+		void sort(Iter first, Iter last)
+		{
+			sort(first, last, detail::Less());
+		}
+
+		/**
+		 * @brief Reorder [first, last) so that the elements for which \p pred holds come first.
+		 * @return Iterator to the first element for which \p pred does not hold.
+		 */
+		template <typename Iter, typename Predicate>
+		Iter partition(Iter first, Iter last, Predicate pred)
+		{
+			while(true) {
+				while(first != last && pred(*first))
+					++first;
+
+				if(first == last)
+					return first;
+
+				do {
+					--last;
+				} while(first != last && !pred(*last));
+
+				if(first == last)
+					return first;
+
+				stl::swap(*first, *last);
+				++first;
+			}
+		}
+
+		/**
+		 * @brief Partially sort [first, last) so that \p nth holds the element that would be there
+		 *        if the range was sorted.
+		 *
+		 * No element before \p nth is greater than it and no element after it is less. Runs in
+		 * linear time on average, which makes it the cheap way to find a median.
+		 */
+		template <typename Iter, typename Compare>
+		void nth_element(Iter first, Iter nth, Iter last, Compare comp)
+		{
+			if(first == last || nth == last)
+				return;
+
+			auto depth = detail::depth_limit(last - first);
+
+			while(last - first > 3) {
+				if(depth == 0) {
+					detail::heap_sort(first, last, comp);
+					return;
+				}
+
+				depth--;
+
+				auto cut = detail::partition_pivot(first, last, comp);
+
+				if(cut <= nth)
+					first = cut;
+				else
+					last = cut;
+			}
+
+			detail::insertion_sort(first, last, comp);
+		}
+
+		template <typename Iter>
+		void nth_element(Iter first, Iter nth, Iter last)
+		{
+			nth_element(first, nth, last, detail::Less());
+		}
+
+		/**
+		 * @brief Find the first element of the sorted range [first, last) that is not less than
+		 *        \p value.
+		 */
+		template <typename Iter, typename T, typename Compare>
+		Iter lower_bound(Iter first, Iter last, const T& value, Compare comp)
+		{
+			auto count = last - first;
+
+			while(count > 0) {
+				auto step = count / 2;
+				auto iter = first + step;
+
+				if(comp(*iter, value)) {
+					first = iter + 1;
+					count -= step + 1;
+				} else {
+					count = step;
+				}
+			}
+
+			return first;
+		}
+
+		template <typename Iter, typename T>
+		Iter lower_bound(Iter first, Iter last, const T& value)
+		{
+			return lower_bound(first, last, value, detail::Less());
+		}
+
+		/**
+		 * @brief Find the first element of the sorted range [first, last) that is greater than
+		 *        \p value.
+		 */
+		template <typename Iter, typename T, typename Compare>
+		Iter upper_bound(Iter first, Iter last, const T& value, Compare comp)
+		{
+			auto count = last - first;
+
+			while(count > 0) {
+				auto step = count / 2;
+				auto iter = first + step;
+
+				if(!comp(value, *iter)) {
+					first = iter + 1;
+					count -= step + 1;
+				} else {
+					count = step;
+				}
+			}
+
+			return first;
+		}
+
+		template <typename Iter, typename T>
+		Iter upper_bound(Iter first, Iter last, const T& value)
+		{
+			return upper_bound(first, last, value, detail::Less());
+		}
+
+		/**
+		 * @brief Check whether the sorted range [first, last) contains \p value.
+		 */
+		template <typename Iter, typename T, typename Compare>
+		bool binary_search(Iter first, Iter last, const T& value, Compare comp)
+		{
+			auto iter = lower_bound(first, last, value, comp);
+			return iter != last && !comp(value, *iter);
+		}
+
+		template <typename Iter, typename T>
+		bool binary_search(Iter first, Iter last, const T& value)
+		{
+			return binary_search(first, last, value, detail::Less());
+		}
+
+		/**
+		 * @brief Fold [first, last) into \p init, from left to right.
+		 */
+		template <typename Iter, typename T, typename BinaryOp>
+		T accumulate(Iter first, Iter last, T init, BinaryOp op)
+		{
+			for(; first != last; ++first)
+				init = op(stl::move(init), *first);
+
+			return init;
+		}
+
+		template <typename Iter, typename T>
+		T accumulate(Iter first, Iter last, T init)
+		{
+			return accumulate(first, last, stl::move(init), detail::Plus());
+		}
+
+		/**
+		 * @brief Store \p op applied to each element of [first, last) in the range starting at
+		 *        \p output, which may be \p first itself.
+		 * @return Iterator past the last element written.
+		 * @note A Vector does not grow through its iterators; the output has to be large enough.
+		 */
+		template <typename Iter, typename Output, typename UnaryOp>
+		Output transform(Iter first, Iter last, Output output, UnaryOp op)
+		{
+			for(; first != last; ++first, ++output)
+				*output = op(*first);
+
+			return output;
+		}
+
+#ifndef CONFIG_STANDALONE
+		/*
+		 * Parallel versions of the algorithms, which split the range into parts and hand them to
+		 * the workers of an executor. The calling thread works on parts as well, so the executor
+		 * may be busy, or the caller may be one of its workers, without deadlocking. Ranges of
+		 * less than CONFIG_PARALLEL_GRAIN elements per part are processed by the caller alone.
+		 */
+		namespace parallel
+		{
+			namespace detail
+			{
+				struct Work {
+					explicit Work(size_t count) : next(0), finished(0), parts(count), lock(false)
+					{
+					}
+
+					Atomic<size_t> next;
+					size_t finished;
+					size_t parts;
+					Lock lock;
+					Event done;
+				};
+
+				template <typename Body>
+				void drain(Work& work, const Body& body)
+				{
+					size_t part;
+
+					while((part = work.next.fetch_add(1)) < work.parts) {
+						body(part);
+
+						ScopedLock g(work.lock);
+
+						if(++work.finished == work.parts)
+							work.done.signal();
+					}
+				}
+
+				/*
+				 * Run body(0) .. body(parts - 1) on the executor and the calling thread. Tasks that
+				 * only get to run after all parts are claimed find nothing to do; they keep the
+				 * shared state alive, but never touch the body.
+				 */
+				template <typename Body>
+				void run(Executor& executor, size_t parts, const Body& body)
+				{
+					auto work = makeShared<Work>(parts);
+					auto helpers = executor.workers();
+					auto fn = &body;
+
+					if(parts == 1) {
+						body(0);
+						return;
+					}
+
+					if(helpers > parts - 1)
+						helpers = parts - 1;
+
+					for(size_t idx = 0; idx < helpers; idx++) {
+						if(!executor.post([work, fn]() { drain(*work, *fn); }))
+							break;
+					}
+
+					drain(*work, body);
+
+					ScopedLock g(work->lock);
+
+					while(work->finished < work->parts)
+						work->done.wait(g);
+				}
+
+				static inline size_t parts(Executor& executor, ptrdiff_t length)
+				{
+					auto rv = executor.workers() + 1;
+					auto max = static_cast<size_t>(length / CONFIG_PARALLEL_GRAIN);
+
+					if(rv > max)
+						rv = max;
+
+					if(rv > CONFIG_PARALLEL_MAX_PARTS)
+						rv = CONFIG_PARALLEL_MAX_PARTS;
+
+					return rv > 0 ? rv : 1;
+				}
+
+				template <typename Iter>
+				struct Range {
+					Iter first;
+					Iter last;
+				};
+			}
+
+			/**
+			 * @brief Sort [first, last) on the workers of \p executor.
+			 *
+			 * The range is partitioned into up to twice as many parts as there are threads, by
+			 * repeatedly splitting the largest part around its median of three. The parts are
+			 * then sorted independently. No memory is allocated for the elements.
+			 */
+			template <typename Iter, typename Compare>
+			void sort(Executor& executor, Iter first, Iter last, Compare comp)
+			{
+				detail::Range<Iter> ranges[CONFIG_PARALLEL_MAX_PARTS];
+				auto wanted = detail::parts(executor, last - first) * 2;
+				size_t count = 1;
+
+				if(wanted > CONFIG_PARALLEL_MAX_PARTS)
+					wanted = CONFIG_PARALLEL_MAX_PARTS;
+
+				if(wanted <= 2) {
+					stl::sort(first, last, comp);
+					return;
+				}
+
+				ranges[0] = { first, last };
+
+				while(count < wanted) {
+					size_t largest = 0;
+
+					for(size_t idx = 1; idx < count; idx++) {
+						if(ranges[idx].last - ranges[idx].first > ranges[largest].last - ranges[largest].first)
+							largest = idx;
+					}
+
+					auto& range = ranges[largest];
+
+					if(range.last - range.first < CONFIG_PARALLEL_GRAIN)
+						break;
+
+					auto cut = stl::detail::partition_pivot(range.first, range.last, comp);
+
+					ranges[count++] = { cut, range.last };
+					range.last = cut;
+				}
+
+				detail::run(executor, count, [&](size_t part) {
+					stl::sort(ranges[part].first, ranges[part].last, comp);
+				});
+			}
+
+			template <typename Iter>
+			void sort(Executor& executor, Iter first, Iter last)
+			{
+				sort(executor, first, last, stl::detail::Less());
+			}
+
+			/**
+			 * @brief Store \p op applied to each element of [first, last) in the range starting at
+			 *        \p output, on the workers of \p executor.
+			 */
+			template <typename Iter, typename Output, typename UnaryOp>
+			Output transform(Executor& executor, Iter first, Iter last, Output output, UnaryOp op)
+			{
+				auto length = last - first;
+				auto parts = detail::parts(executor, length);
+
+				detail::run(executor, parts, [&](size_t part) {
+					auto begin = static_cast<ptrdiff_t>(length * part / parts);
+					auto end = static_cast<ptrdiff_t>(length * (part + 1) / parts);
+
+					stl::transform(first + begin, first + end, output + begin, op);
+				});
+
+				return output + length;
+			}
+
+			/**
+			 * @brief Reduce [first, last) into \p init on the workers of \p executor.
+			 *
+			 * Each part is folded on its own and the partial results are folded into \p init in
+			 * order, so \p op has to be associative. It does not have to be commutative.
+			 */
+			template <typename Iter, typename T, typename BinaryOp>
+			T accumulate(Executor& executor, Iter first, Iter last, T init, BinaryOp op)
+			{
+				auto length = last - first;
+				auto parts = detail::parts(executor, length);
+
+				if(parts == 1)
+					return stl::accumulate(first, last, stl::move(init), op);
+
+				stl::Vector<T> partials(parts);
+
+				for(size_t idx = 0; idx < parts; idx++)
+					partials.push_back(init);
+
+				detail::run(executor, parts, [&](size_t part) {
+					auto begin = first + static_cast<ptrdiff_t>(length * part / parts);
+					auto end = first + static_cast<ptrdiff_t>(length * (part + 1) / parts);
+
+					partials[part] = stl::accumulate(begin + 1, end, T(*begin), op);
+				});
+
+				for(size_t idx = 0; idx < parts; idx++)
+					init = op(stl::move(init), partials[idx]);
+
+				return init;
+			}
+
+			template <typename Iter, typename T>
+			T accumulate(Executor& executor, Iter first, Iter last, T init)
+			{
+				return accumulate(executor, first, last, stl::move(init), stl::detail::Plus());
+			}
+		}
+#endif
+	}
+}
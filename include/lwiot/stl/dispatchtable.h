@@ -0,0 +1,149 @@
+/*
+ * Compile-time dispatch table.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stddef.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/forward.h>
+#include <lwiot/stl/tuple.h>
+#include <lwiot/traits/integralconstant.h>
+
+namespace lwiot
+{
+	namespace stl
+	{
+		/**
+		 * @brief Dispatch key of \p T. Specialize it for types that do not define \c API_ID.
+		 */
+		template <typename T>
+		struct DispatchKey : traits::IntegralConstant<size_t, T::API_ID> {
+		};
+
+		namespace detail
+		{
+			template <typename... Types>
+			struct DispatchRange;
+
+			template <typename T>
+			struct DispatchRange<T> {
+				static constexpr size_t min = DispatchKey<T>::value;
+				static constexpr size_t max = DispatchKey<T>::value;
+			};
+
+			template <typename Head, typename... Tail>
+			struct DispatchRange<Head, Tail...> {
+				static constexpr size_t min = DispatchKey<Head>::value < DispatchRange<Tail...>::min ?
+						DispatchKey<Head>::value : DispatchRange<Tail...>::min;
+				static constexpr size_t max = DispatchKey<Head>::value > DispatchRange<Tail...>::max ?
+						DispatchKey<Head>::value : DispatchRange<Tail...>::max;
+			};
+
+			template <typename Signature, typename Invoker, size_t Key, typename... Types>
+			struct DispatchSlot;
+
+			template <typename R, typename... Args, typename Invoker, size_t Key>
+			struct DispatchSlot<R(Args...), Invoker, Key> {
+				static constexpr R (*get())(Args...)
+				{
+					return nullptr;
+				}
+			};
+
+			template <typename R, typename... Args, typename Invoker, size_t Key, typename Head, typename... Tail>
+			struct DispatchSlot<R(Args...), Invoker, Key, Head, Tail...> {
+				static constexpr R (*get())(Args...)
+				{
+					return DispatchKey<Head>::value == Key ? &Invoker::template invoke<Head> :
+					       DispatchSlot<R(Args...), Invoker, Key, Tail...>::get();
+				}
+			};
+
+			template <typename Signature, typename Invoker, size_t Base, typename Sequence, typename... Types>
+			struct DispatchArray;
+
+			template <typename R, typename... Args, typename Invoker, size_t Base, size_t... Indices, typename... Types>
+			struct DispatchArray<R(Args...), Invoker, Base, IndexSequence<Indices...>, Types...> {
+				static constexpr R (*table[sizeof...(Indices)])(Args...) = {
+					DispatchSlot<R(Args...), Invoker, Base + Indices, Types...>::get()...
+				};
+			};
+
+			template <typename R, typename... Args, typename Invoker, size_t Base, size_t... Indices, typename... Types>
+			constexpr R (*DispatchArray<R(Args...), Invoker, Base, IndexSequence<Indices...>, Types...>::table[sizeof...(Indices)])(Args...);
+		}
+
+		/**
+		 * @brief Jump table from a key to a handler for each of \p Types.
+		 *
+		 * The table is built at compile time. Entry \c DispatchKey<T>::value points to
+		 * \c Invoker::invoke<T>, which must have the signature \p Signature. Keys that belong to
+		 * none of \p Types have no entry. The table spans the smallest to the largest key, so
+		 * dispatching is a bounds check and one indirect call, without type erasure.
+		 *
+		 * @code
+		 * struct Invoker {
+		 *     template <typename T>
+		 *     static void invoke(Frame& frame)
+		 *     {
+		 *         handle(static_cast<T&>(frame));
+		 *     }
+		 * };
+		 *
+		 * typedef lwiot::stl::DispatchTable<void(Frame&), Invoker, Ping, Data, Ack> Table;
+		 * Table::dispatch(frame.type(), frame);
+		 * @endcode
+		 */
+		template <typename Signature, typename Invoker, typename... Types>
+		class DispatchTable;
+
+		template <typename R, typename... Args, typename Invoker, typename... Types>
+		class DispatchTable<R(Args...), Invoker, Types...> {
+		public:
+			typedef R (*Pointer)(Args...);
+
+			static_assert(sizeof...(Types) > 0, "A dispatch table needs at least one type!");
+
+			static constexpr size_t Min = detail::DispatchRange<Types...>::min;
+			static constexpr size_t Max = detail::DispatchRange<Types...>::max;
+			static constexpr size_t Size = Max - Min + 1;
+
+			/**
+			 * @brief Look up the handler of \p key.
+			 * @return The handler, or \c nullptr if none of the types has \p key.
+			 */
+			static Pointer lookup(size_t key)
+			{
+				if(key < Min || key > Max)
+					return nullptr;
+
+				return Array::table[key - Min];
+			}
+
+			/**
+			 * @brief Call the handler of \p key.
+			 * @return False if none of the types has \p key.
+			 */
+			static bool dispatch(size_t key, Args... args)
+			{
+				auto handler = lookup(key);
+
+				if(handler == nullptr)
+					return false;
+
+				handler(stl::forward<Args>(args)...);
+				return true;
+			}
+
+		private:
+			typedef detail::DispatchArray<R(Args...), Invoker, Min,
+					typename make_index_sequence<Size>::type, Types...> Array;
+		};
+	}
+}
@@ -0,0 +1,225 @@
+/*
+ * Sorted map implementation using a vector.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <lwiot.h>
+#include <stdlib.h>
+
+#include <lwiot/stl/vector.h>
+#include <lwiot/stl/move.h>
+#include <lwiot/stl/forward.h>
+
+namespace lwiot
+{
+	namespace stl
+	{
+		/**
+		 * @brief Map that keeps its entries sorted in contiguous storage.
+		 * @tparam K Key type. Keys must be comparable using `<' and `=='.
+		 * @tparam V Value type.
+		 *
+		 * Lookups are a binary search, insertion and removal are linear. This makes the FlatMap a
+		 * good fit for small tables that are built once and queried often. The interface matches
+		 * stl::Map.
+		 */
+		template<typename K, typename V>
+		class FlatMap {
+		public:
+			typedef K MapKey;
+			typedef V MapValue;
+
+			struct Entry {
+			public:
+				Entry() = default;
+
+				Entry(const MapKey &key, const MapValue &value) : key(key), value(value)
+				{
+				}
+
+				Entry(MapKey &&key, MapValue &&value) noexcept :
+						key(stl::forward<MapKey>(key)), value(stl::forward<MapValue>(value))
+				{
+				}
+
+				MapKey key;
+				MapValue value;
+			};
+
+			typedef typename Vector<Entry>::iterator iterator;
+			typedef typename Vector<Entry>::const_iterator const_iterator;
+
+			explicit FlatMap() = default;
+
+			explicit FlatMap(size_t capacity) : _data(capacity)
+			{
+			}
+
+			FlatMap(const FlatMap &other) = default;
+			FlatMap(FlatMap &&other) noexcept = default;
+			virtual ~FlatMap() = default;
+
+			FlatMap &operator=(const FlatMap &rhs) = default;
+			FlatMap &operator=(FlatMap &&rhs) noexcept = default;
+
+			void clear()
+			{
+				this->_data.clear();
+			}
+
+			constexpr size_t size() const
+			{
+				return this->_data.size();
+			}
+
+			constexpr bool empty() const
+			{
+				return this->_data.size() == 0;
+			}
+
+			void reserve(size_t num)
+			{
+				this->_data.reserve(num);
+			}
+
+			void add(const MapKey &key, const MapValue &value)
+			{
+				auto idx = this->lowerBound(key);
+
+				if(this->matches(idx, key)) {
+					this->_data[idx].value = value;
+					return;
+				}
+
+				this->_data.insert(idx, Entry(key, value));
+			}
+
+			void add(MapKey &&key, MapValue &&value)
+			{
+				auto idx = this->lowerBound(key);
+
+				if(this->matches(idx, key)) {
+					this->_data[idx].value = stl::move(value);
+					return;
+				}
+
+				this->_data.insert(idx, Entry(stl::forward<MapKey>(key), stl::forward<MapValue>(value)));
+			}
+
+			MapValue at(const MapKey &key) const
+			{
+				auto idx = this->lowerBound(key);
+
+				if(!this->matches(idx, key))
+					return MapValue();
+
+				return this->_data[idx].value;
+			}
+
+			MapValue operator[](const MapKey &key) const
+			{
+				return this->at(key);
+			}
+
+			MapValue &operator[](const MapKey &key)
+			{
+				auto idx = this->lowerBound(key);
+
+				if(!this->matches(idx, key))
+					this->_data.insert(idx, Entry(key, MapValue()));
+
+				return this->_data[idx].value;
+			}
+
+			iterator find(const MapKey &key)
+			{
+				auto idx = this->lowerBound(key);
+
+				if(!this->matches(idx, key))
+					return this->end();
+
+				return iterator(this->_data.data(), idx);
+			}
+
+			const_iterator find(const MapKey &key) const
+			{
+				auto idx = this->lowerBound(key);
+
+				if(!this->matches(idx, key))
+					return this->end();
+
+				return const_iterator(const_cast<Entry *>(&this->_data[0]), idx);
+			}
+
+			bool contains(const MapKey &key) const
+			{
+				return this->matches(this->lowerBound(key), key);
+			}
+
+			void remove(const MapKey &key)
+			{
+				auto idx = this->lowerBound(key);
+
+				if(this->matches(idx, key))
+					this->_data.erase(idx);
+			}
+
+			iterator begin()
+			{
+				return this->_data.begin();
+			}
+
+			iterator end()
+			{
+				return this->_data.end();
+			}
+
+			const_iterator begin() const
+			{
+				return this->_data.begin();
+			}
+
+			const_iterator end() const
+			{
+				return this->_data.end();
+			}
+
+			template <typename Func>
+			void foreach(Func functor)
+			{
+				for(auto &entry : this->_data)
+					functor(entry);
+			}
+
+		private:
+			Vector<Entry> _data;
+
+			/* Index of the first entry whose key is not less than `key'. */
+			size_t lowerBound(const MapKey &key) const
+			{
+				size_t low = 0;
+				size_t high = this->_data.size();
+
+				while(low < high) {
+					auto mid = low + (high - low) / 2;
+
+					if(this->_data[mid].key < key)
+						low = mid + 1;
+					else
+						high = mid;
+				}
+
+				return low;
+			}
+
+			bool matches(size_t idx, const MapKey &key) const
+			{
+				return idx < this->_data.size() && this->_data[idx].key == key;
+			}
+		};
+	}
+}
@@ -0,0 +1,109 @@
+/*
+ * Hash functions.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+
+namespace lwiot
+{
+	namespace stl
+	{
+		namespace detail
+		{
+			/* FNV-1a */
+			static inline size_t hash_bytes(const void *data, size_t length)
+			{
+				auto bytes = static_cast<const uint8_t *>(data);
+				uint32_t hash = 2166136261U;
+
+				for(size_t idx = 0; idx < length; idx++) {
+					hash ^= bytes[idx];
+					hash *= 16777619U;
+				}
+
+				return hash;
+			}
+
+			static inline size_t hash_integer(uint64_t value)
+			{
+				value ^= value >> 33U;
+				value *= 0xff51afd7ed558ccdULL;
+				value ^= value >> 33U;
+				value *= 0xc4ceb9fe1a85ec53ULL;
+				value ^= value >> 33U;
+
+				return static_cast<size_t>(value);
+			}
+		}
+
+		template <typename T>
+		struct Hash;
+
+		template <>
+		struct Hash<String> {
+			size_t operator()(const String& str) const
+			{
+				return detail::hash_bytes(str.c_str(), str.length());
+			}
+		};
+
+		/* Equal to the hash of a String with the same contents. */
+		template <>
+		struct Hash<StringView> {
+			size_t operator()(const StringView& str) const
+			{
+				return detail::hash_bytes(str.data(), str.length());
+			}
+		};
+
+		template <>
+		struct Hash<const char *> {
+			size_t operator()(const char *str) const
+			{
+				return detail::hash_bytes(str, strlen(str));
+			}
+		};
+
+		template <typename T>
+		struct Hash<T *> {
+			size_t operator()(const T *ptr) const
+			{
+				return detail::hash_integer(reinterpret_cast<uintptr_t>(ptr));
+			}
+		};
+
+#define HASH_INTEGER(__type) \
+		template <> \
+		struct Hash<__type> { \
+			size_t operator()(__type value) const \
+			{ \
+				return detail::hash_integer(static_cast<uint64_t>(value)); \
+			} \
+		};
+
+		HASH_INTEGER(bool)
+		HASH_INTEGER(char)
+		HASH_INTEGER(signed char)
+		HASH_INTEGER(unsigned char)
+		HASH_INTEGER(short)
+		HASH_INTEGER(unsigned short)
+		HASH_INTEGER(int)
+		HASH_INTEGER(unsigned int)
+		HASH_INTEGER(long)
+		HASH_INTEGER(unsigned long)
+		HASH_INTEGER(long long)
+		HASH_INTEGER(unsigned long long)
+
+#undef HASH_INTEGER
+	}
+}
@@ -0,0 +1,281 @@
+/*
+ * Intrusive doubly linked list.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/traits/typechoice.h>
+
+namespace lwiot
+{
+	namespace stl
+	{
+		/**
+		 * @brief Link embedded in objects that are stored in an IntrusiveList.
+		 *
+		 * Copying an object does not copy its membership: a copied hook is always unlinked.
+		 */
+		struct IntrusiveListHook {
+		public:
+			constexpr IntrusiveListHook() : next(nullptr), prev(nullptr)
+			{
+			}
+
+			constexpr IntrusiveListHook(const IntrusiveListHook &) : next(nullptr), prev(nullptr)
+			{
+			}
+
+			IntrusiveListHook &operator=(const IntrusiveListHook &)
+			{
+				return *this;
+			}
+
+			constexpr bool linked() const
+			{
+				return this->next != nullptr;
+			}
+
+			IntrusiveListHook *next;
+			IntrusiveListHook *prev;
+		};
+
+		/**
+		 * @brief Doubly linked list that links objects through an embedded hook.
+		 * @tparam T Object type.
+		 * @tparam Hook Pointer to the IntrusiveListHook member of \p T.
+		 *
+		 * The list never allocates and never owns its objects. An object must be removed from the
+		 * list before it is destroyed, and can be a member of one list per hook.
+		 */
+		template <typename T, IntrusiveListHook T::*Hook>
+		class IntrusiveList {
+		public:
+			typedef T value_type;
+
+			template <bool is_const>
+			class IteratorBase {
+			public:
+				typedef typename traits::TypeChoice<is_const, const T &, T &>::type reference;
+				typedef typename traits::TypeChoice<is_const, const T *, T *>::type pointer;
+
+				constexpr explicit IteratorBase() : _node(nullptr)
+				{
+				}
+
+				constexpr explicit IteratorBase(IntrusiveListHook *node) : _node(node)
+				{
+				}
+
+				IteratorBase &operator++()
+				{
+					this->_node = this->_node->next;
+					return *this;
+				}
+
+				IteratorBase operator++(int)
+				{
+					IteratorBase iter = *this;
+
+					++*this;
+					return iter;
+				}
+
+				IteratorBase &operator--()
+				{
+					this->_node = this->_node->prev;
+					return *this;
+				}
+
+				IteratorBase operator--(int)
+				{
+					IteratorBase iter = *this;
+
+					--*this;
+					return iter;
+				}
+
+				constexpr bool operator==(const IteratorBase &rhs) const
+				{
+					return this->_node == rhs._node;
+				}
+
+				constexpr bool operator!=(const IteratorBase &rhs) const
+				{
+					return this->_node != rhs._node;
+				}
+
+				reference operator*() const
+				{
+					return *IntrusiveList::owner(this->_node);
+				}
+
+				pointer operator->() const
+				{
+					return IntrusiveList::owner(this->_node);
+				}
+
+			private:
+				IntrusiveListHook *_node;
+
+				friend class IntrusiveList;
+			};
+
+			typedef IteratorBase<false> iterator;
+			typedef IteratorBase<true> const_iterator;
+
+			explicit IntrusiveList() : _size(0)
+			{
+				this->_head.next = &this->_head;
+				this->_head.prev = &this->_head;
+			}
+
+			~IntrusiveList()
+			{
+				this->clear();
+			}
+
+			IntrusiveList(const IntrusiveList &) = delete;
+			IntrusiveList &operator=(const IntrusiveList &) = delete;
+
+			constexpr size_t size() const
+			{
+				return this->_size;
+			}
+
+			constexpr bool empty() const
+			{
+				return this->_size == 0;
+			}
+
+			T &front()
+			{
+				return *owner(this->_head.next);
+			}
+
+			T &back()
+			{
+				return *owner(this->_head.prev);
+			}
+
+			void push_front(T &obj)
+			{
+				this->link(&(obj.*Hook), &this->_head, this->_head.next);
+			}
+
+			void push_back(T &obj)
+			{
+				this->link(&(obj.*Hook), this->_head.prev, &this->_head);
+			}
+
+			/**
+			 * @brief Insert an object before \p pos.
+			 * @return An iterator to the inserted object.
+			 */
+			iterator insert(iterator pos, T &obj)
+			{
+				auto node = &(obj.*Hook);
+
+				this->link(node, pos._node->prev, pos._node);
+				return iterator(node);
+			}
+
+			void pop_front()
+			{
+				if(!this->empty())
+					this->unlink(this->_head.next);
+			}
+
+			void pop_back()
+			{
+				if(!this->empty())
+					this->unlink(this->_head.prev);
+			}
+
+			/**
+			 * @brief Unlink the object at \p pos.
+			 * @return An iterator to the next object.
+			 */
+			iterator erase(iterator pos)
+			{
+				auto next = pos._node->next;
+
+				this->unlink(pos._node);
+				return iterator(next);
+			}
+
+			void remove(T &obj)
+			{
+				auto node = &(obj.*Hook);
+
+				if(node->linked())
+					this->unlink(node);
+			}
+
+			void clear()
+			{
+				while(!this->empty())
+					this->unlink(this->_head.next);
+			}
+
+			iterator begin()
+			{
+				return iterator(this->_head.next);
+			}
+
+			iterator end()
+			{
+				return iterator(&this->_head);
+			}
+
+			const_iterator begin() const
+			{
+				return const_iterator(this->_head.next);
+			}
+
+			const_iterator end() const
+			{
+				return const_iterator(const_cast<IntrusiveListHook *>(&this->_head));
+			}
+
+		private:
+			IntrusiveListHook _head;
+			size_t _size;
+
+			static T *owner(IntrusiveListHook *node)
+			{
+				/* Offset of the hook inside T, computed on a dummy address; no object is accessed. */
+				auto dummy = reinterpret_cast<T *>(alignof(T) * 16);
+				auto offset = reinterpret_cast<uintptr_t>(&(dummy->*Hook)) - reinterpret_cast<uintptr_t>(dummy);
+
+				return reinterpret_cast<T *>(reinterpret_cast<uint8_t *>(node) - offset);
+			}
+
+			void link(IntrusiveListHook *node, IntrusiveListHook *prev, IntrusiveListHook *next)
+			{
+				next->prev = node;
+				node->next = next;
+				node->prev = prev;
+				prev->next = node;
+
+				this->_size++;
+			}
+
+			void unlink(IntrusiveListHook *node)
+			{
+				node->prev->next = node->next;
+				node->next->prev = node->prev;
+				node->next = nullptr;
+				node->prev = nullptr;
+
+				this->_size--;
+			}
+		};
+	}
+}
@@ -17,12 +17,13 @@
 #include <lwiot/stl/foreach.h>
 
 #include <lwiot/traits/typechoice.h>
+#include <lwiot/util/defaultallocator.h>
 
 namespace lwiot
 {
 	namespace stl
 	{
-		template<typename T>
+		template<typename T, typename A = DefaultAllocator<T>>
 		class LinkedList;
 
 		namespace list
@@ -46,7 +47,7 @@ namespace lwiot
 				}
 
 				T _data;
-				friend class LinkedList<T>;
+				template <typename, typename> friend class stl::LinkedList;
 
 			private:
 				friend class Iterator;
@@ -56,11 +57,12 @@ namespace lwiot
 			};
 		}
 
-		template<typename T>
+		template<typename T, typename A>
 		class LinkedList {
 		public:
 			typedef T value_type;
 			typedef list::Node<value_type> node_type;
+			typedef typename A::template rebind<node_type>::other allocator_type;
 
 			template<bool is_const>
 			class Iterator {
@@ -78,7 +80,7 @@ namespace lwiot
 						this->_next = node->next;
 				}
 
-				constexpr Iterator &operator=(typename LinkedList<T>::node_type *node)
+				constexpr Iterator &operator=(node_type *node)
 				{
 					this->_current = node;
 					this->_start = node;
@@ -152,7 +154,7 @@ namespace lwiot
 				}
 
 			private:
-				friend class LinkedList<T>;
+				friend class LinkedList<T, A>;
 				node_type *_current;
 				node_type *_start;
 				node_type *_next;
@@ -165,12 +167,16 @@ namespace lwiot
 			{
 			}
 
-			LinkedList(const LinkedList<T> &other) : _head(nullptr), _size(0UL)
+			constexpr explicit LinkedList(const allocator_type &alloc) : _alloc(alloc), _head(nullptr), _size(0UL)
+			{
+			}
+
+			LinkedList(const LinkedList &other) : _alloc(other._alloc), _head(nullptr), _size(0UL)
 			{
 				this->copy(other);
 			}
 
-			constexpr LinkedList(LinkedList<T> &&other) noexcept : _head(nullptr), _size(0)
+			constexpr LinkedList(LinkedList &&other) noexcept : _alloc(other._alloc), _head(nullptr), _size(0)
 			{
 				this->_size = other._size;
 				this->_head = other._head;
@@ -184,13 +190,13 @@ namespace lwiot
 				this->clear();
 			}
 
-			LinkedList &operator=(const LinkedList<T> &rhs)
+			LinkedList &operator=(const LinkedList &rhs)
 			{
 				this->copy(rhs);
 				return *this;
 			}
 
-			LinkedList &operator=(LinkedList<T> &&rhs) noexcept
+			LinkedList &operator=(LinkedList &&rhs) noexcept
 			{
 				if(this->_size > 0UL)
 					this->clear();
@@ -219,7 +225,7 @@ namespace lwiot
 				if(!removeAndKeepNode(node))
 					return;
 
-				delete node;
+				this->destroyNode(const_cast<node_type *>(node));
 			}
 
 			void erase(const_iterator  iter)
@@ -238,7 +244,7 @@ namespace lwiot
 					iter.clear();
 			}
 
-			void copy(const LinkedList<T> &list)
+			void copy(const LinkedList &list)
 			{
 				for(const value_type &value : list) {
 					this->push_back(value);
@@ -310,25 +316,25 @@ namespace lwiot
 
 			void push_back(const value_type &data)
 			{
-				node_type *node = new node_type(data);
+				node_type *node = this->createNode(data);
 				this->add_back(node);
 			}
 
 			void push_back(value_type &&data)
 			{
-				node_type *node = new node_type(stl::forward<value_type>(data));
+				node_type *node = this->createNode(stl::forward<value_type>(data));
 				this->add_back(node);
 			}
 
 			void push_front(const value_type &data)
 			{
-				node_type *node = new node_type(data);
+				node_type *node = this->createNode(data);
 				this->add_front(node);
 			}
 
 			void push_front(value_type &&data)
 			{
-				node_type *node = new node_type(stl::forward<value_type>(data));
+				node_type *node = this->createNode(stl::forward<value_type>(data));
 				this->add_front(node);
 			}
 
@@ -338,7 +344,8 @@ namespace lwiot
 					return;
 
 				if(this->_size == 1UL) {
-					delete this->_head;
+					this->destroyNode(this->_head);
+					this->_head = nullptr;
 					this->_size = 0UL;
 
 					return;
@@ -361,7 +368,7 @@ namespace lwiot
 				return this->size() == 0UL;
 			}
 
-			constexpr friend void swap(LinkedList<value_type>& l1, LinkedList<value_type>& l2)
+			constexpr friend void swap(LinkedList& l1, LinkedList& l2)
 			{
 				using stl::swap;
 
@@ -373,9 +380,25 @@ namespace lwiot
 		private:
 
 			friend struct list::Node<T>;
+			allocator_type _alloc;
 			node_type *_head;
 			size_t _size;
 
+			template <typename Arg>
+			node_type *createNode(Arg &&data)
+			{
+				auto node = this->_alloc.allocate(1);
+
+				new(node) node_type(stl::forward<Arg>(data));
+				return node;
+			}
+
+			void destroyNode(node_type *node)
+			{
+				this->_alloc.destroy(node);
+				this->_alloc.deallocate(node, 1);
+			}
+
 			constexpr bool removeAndKeepNode(const node_type *node)
 			{
 				if(this->_head == nullptr || !(node->next || node->prev))
@@ -11,12 +11,16 @@
 #include <stdlib.h>
 
 #include <lwiot/stl/linkedlist.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/util/defaultallocator.h>
+#include <lwiot/traits/enableif.h>
+#include <lwiot/traits/issame.h>
 
 namespace lwiot
 {
 	namespace stl
 	{
-		template<typename K, typename V>
+		template<typename K, typename V, typename A = DefaultAllocator<V>>
 		class Map {
 		public:
 			typedef K MapKey;
@@ -57,8 +61,9 @@ namespace lwiot
 				MapValue value;
 			};
 
-			typedef typename LinkedList<Entry>::iterator iterator;
-			typedef typename LinkedList<Entry>::const_iterator const_iterator;
+			typedef LinkedList<Entry, typename A::template rebind<Entry>::other> list_type;
+			typedef typename list_type::iterator iterator;
+			typedef typename list_type::const_iterator const_iterator;
 
 			CONSTEXPR explicit Map() : _data()
 			{
@@ -82,12 +87,12 @@ namespace lwiot
 				this->_data.clear();
 			}
 
-			Map<K, V> &operator=(const Map<K, V> &rhs)
+			Map &operator=(const Map &rhs)
 			{
 				return *this;
 			}
 
-			CONSTEXPR Map<K, V> &operator=(Map<K, V> &&rhs) noexcept
+			CONSTEXPR Map &operator=(Map &&rhs) noexcept
 			{
 				this->_data = stl::move(rhs._data);
 				return *this;
@@ -139,7 +144,7 @@ namespace lwiot
 			{
 				for(auto &e : this->_data) {
 					if(e == key) {
-						return iterator(reinterpret_cast<typename lwiot::stl::LinkedList<Entry>::node_type *>(&e));
+						return iterator(reinterpret_cast<typename list_type::node_type *>(&e));
 					}
 				}
 
@@ -150,13 +155,38 @@ namespace lwiot
 			{
 				for(const auto &e : this->_data) {
 					if(e == key) {
-						return const_iterator(reinterpret_cast<typename lwiot::stl::LinkedList<Entry>::node_type *>(&e));
+						return const_iterator(reinterpret_cast<typename list_type::node_type *>(&e));
 					}
 				}
 
 				return const_iterator(nullptr);
 			}
 
+			/* Lookup using a StringView, for maps keyed by String. */
+			template <typename L, typename = traits::EnableIf_t<traits::IsSame<L, StringView>::value>>
+			iterator find(const L &key)
+			{
+				for(auto &e : this->_data) {
+					if(e.key == key) {
+						return iterator(reinterpret_cast<typename list_type::node_type *>(&e));
+					}
+				}
+
+				return iterator(nullptr);
+			}
+
+			template <typename L, typename = traits::EnableIf_t<traits::IsSame<L, StringView>::value>>
+			bool contains(const L &key) const
+			{
+				for(const Entry &e : this->_data) {
+					if(e.key == key) {
+						return true;
+					}
+				}
+
+				return false;
+			}
+
 			CONSTEXPR iterator begin()
 			{
 				return this->_data.begin();
@@ -203,6 +233,18 @@ namespace lwiot
 				}
 			}
 
+			template <typename Func>
+			void foreach(Func functor)
+			{
+				for(auto &entry : this->_data)
+					functor(entry);
+			}
+
+			CONSTEXPR size_t size() const
+			{
+				return this->_data.size();
+			}
+
 			MapValue &operator[](MapKey idx)
 			{
 				for(Entry &e : this->_data) {
@@ -217,7 +259,7 @@ namespace lwiot
 			}
 
 		private:
-			LinkedList<Entry> _data;
+			list_type _data;
 		};
 	}
 }
@@ -0,0 +1,145 @@
+/*
+ * Single producer, single consumer ring buffer.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/stl/move.h>
+#include <lwiot/stl/forward.h>
+
+namespace lwiot
+{
+	namespace stl
+	{
+		/**
+		 * @brief Wait-free ring buffer for one producer and one consumer.
+		 * @tparam T Element type.
+		 * @tparam N Capacity, must be a power of two.
+		 *
+		 * The producer only writes the head index and the consumer only writes the tail index. Neither
+		 * side takes a lock, which makes the buffer safe to fill from an interrupt handler and drain
+		 * from a thread (or the other way around). Only one context may push and only one context may
+		 * pop.
+		 */
+		template <typename T, size_t N>
+		class RingBuffer {
+			static_assert(N > 0 && (N & (N - 1)) == 0, "Ring buffer capacity must be a power of two");
+
+		public:
+			typedef T value_type;
+
+			explicit RingBuffer() : _head(0), _tail(0)
+			{
+			}
+
+			~RingBuffer()
+			{
+				this->clear();
+			}
+
+			RingBuffer(const RingBuffer &) = delete;
+			RingBuffer &operator=(const RingBuffer &) = delete;
+
+			bool push(const T &value)
+			{
+				return this->emplace(value);
+			}
+
+			bool push(T &&value)
+			{
+				return this->emplace(stl::move(value));
+			}
+
+			/**
+			 * @brief Construct an element at the head of the buffer.
+			 * @return False when the buffer is full.
+			 * @note Producer side only.
+			 */
+			template <typename... Args>
+			bool emplace(Args&&... args)
+			{
+				auto head = this->_head.load();
+
+				if(head - this->_tail.load() == N)
+					return false;
+
+				new(this->slot(head)) T(stl::forward<Args>(args)...);
+				this->_head.fetch_add(1);
+
+				return true;
+			}
+
+			/**
+			 * @brief Take the element at the tail of the buffer.
+			 * @param value Output value.
+			 * @return False when the buffer is empty.
+			 * @note Consumer side only.
+			 */
+			bool pop(T &value)
+			{
+				auto tail = this->_tail.load();
+
+				if(tail == this->_head.load())
+					return false;
+
+				auto obj = this->slot(tail);
+
+				value = stl::move(*obj);
+				obj->~T();
+				this->_tail.fetch_add(1);
+
+				return true;
+			}
+
+			/* Consumer side only. */
+			void clear()
+			{
+				auto tail = this->_tail.load();
+				auto head = this->_head.load();
+
+				for(; tail != head; tail++) {
+					this->slot(tail)->~T();
+					this->_tail.fetch_add(1);
+				}
+			}
+
+			size_t size() const
+			{
+				return this->_head.load() - this->_tail.load();
+			}
+
+			bool empty() const
+			{
+				return this->size() == 0;
+			}
+
+			bool full() const
+			{
+				return this->size() == N;
+			}
+
+			static constexpr size_t capacity()
+			{
+				return N;
+			}
+
+		private:
+			alignas(T) uint8_t _storage[N * sizeof(T)];
+			lwiot::Atomic<size_t> _head;
+			lwiot::Atomic<size_t> _tail;
+
+			T *slot(size_t idx)
+			{
+				return reinterpret_cast<T *>(this->_storage) + (idx & (N - 1));
+			}
+		};
+	}
+}
@@ -7,9 +7,14 @@
 
 #pragma once
 
+#include <lwiot.h>
+#include <stdint.h>
+#include <string.h>
+
 #include <lwiot/stl/vector.h>
 #include <lwiot/stl/foreach.h>
 #include <lwiot/stl/pair.h>
+#include <lwiot/traits/typechoice.h>
 
 namespace lwiot
 {
@@ -36,12 +41,167 @@ namespace lwiot
 				size_type levels;
 				SkipListNode *next[1];
 			};
+
+			/*
+			 * Node storage for unbounded skip lists. Every node is allocated from the heap with
+			 * exactly the number of links it needs.
+			 */
+			template <typename N>
+			class SkipListHeap {
+			public:
+				static constexpr size_t MaximumLevel = ~size_t(0);
+
+				void *allocate(size_t levels)
+				{
+					return lwiot_mem_zalloc(sizeof(N) + (levels - 1) * sizeof(N *));
+				}
+
+				void deallocate(void *node)
+				{
+					lwiot_mem_free(node);
+				}
+
+				void reserve(size_t num)
+				{
+				}
+
+				void swap(SkipListHeap &other)
+				{
+				}
+			};
+
+			/*
+			 * Node storage for skip lists with a level limit. All nodes have room for MaxLevel links,
+			 * which means they can be carved from chunks of equally sized slots. Released slots are
+			 * kept on a free list and reused before a new chunk is taken from the heap.
+			 */
+			template <typename N, size_t MaxLevel>
+			class SkipListSlab {
+			public:
+				static constexpr size_t MaximumLevel = MaxLevel;
+
+				explicit SkipListSlab() : _chunks(nullptr), _free(nullptr), _available(0)
+				{
+				}
+
+				SkipListSlab(SkipListSlab &&other) noexcept : _chunks(other._chunks), _free(other._free),
+					_available(other._available)
+				{
+					other._chunks = nullptr;
+					other._free = nullptr;
+					other._available = 0;
+				}
+
+				~SkipListSlab()
+				{
+					for(auto chunk = this->_chunks; chunk != nullptr;) {
+						auto next = chunk->next;
+
+						lwiot_mem_free(chunk);
+						chunk = next;
+					}
+				}
+
+				SkipListSlab(const SkipListSlab &) = delete;
+				SkipListSlab &operator=(const SkipListSlab &) = delete;
+
+				void *allocate(size_t levels)
+				{
+					if(this->_free == nullptr)
+						this->grow(ChunkSlots);
+
+					auto slot = this->_free;
+
+					if(slot == nullptr)
+						return nullptr;
+
+					this->_free = slot->next;
+					this->_available -= 1;
+
+					memset(slot, 0, SlotSize);
+					return slot;
+				}
+
+				void deallocate(void *node)
+				{
+					auto slot = static_cast<FreeSlot *>(node);
+
+					slot->next = this->_free;
+					this->_free = slot;
+					this->_available += 1;
+				}
+
+				void reserve(size_t num)
+				{
+					if(num > this->_available)
+						this->grow(num - this->_available);
+				}
+
+				void swap(SkipListSlab &other)
+				{
+					using stl::swap;
+
+					swap(this->_chunks, other._chunks);
+					swap(this->_free, other._free);
+					swap(this->_available, other._available);
+				}
+
+			private:
+				struct Chunk {
+					Chunk *next;
+				};
+
+				struct FreeSlot {
+					FreeSlot *next;
+				};
+
+				static constexpr size_t align(size_t size, size_t alignment)
+				{
+					return (size + alignment - 1) & ~(alignment - 1);
+				}
+
+				static constexpr size_t ChunkSlots = 8;
+				static constexpr size_t SlotSize = align(sizeof(N) + (MaxLevel - 1) * sizeof(N *), alignof(N));
+				static constexpr size_t ChunkHeader = align(sizeof(Chunk), alignof(N));
+
+				Chunk *_chunks;
+				FreeSlot *_free;
+				size_t _available;
+
+				void grow(size_t slots)
+				{
+					auto chunk = static_cast<Chunk *>(lwiot_mem_alloc(ChunkHeader + slots * SlotSize));
+
+					if(chunk == nullptr)
+						return;
+
+					chunk->next = this->_chunks;
+					this->_chunks = chunk;
+
+					auto data = reinterpret_cast<uint8_t *>(chunk) + ChunkHeader;
+
+					for(size_t idx = slots; idx > 0; idx--)
+						this->deallocate(data + (idx - 1) * SlotSize);
+				}
+			};
 		}
 
-		template<typename K, typename V>
+		/**
+		 * @brief Ordered associative container.
+		 * @tparam K Key type.
+		 * @tparam V Value type.
+		 * @tparam MaxLevel Maximum node level, or 0 for no limit.
+		 *
+		 * When \p MaxLevel is non-zero every node has room for \p MaxLevel links and nodes are taken
+		 * from a slab owned by the list. Combined with reserve() this makes insertion independent of
+		 * the state of the heap.
+		 */
+		template<typename K, typename V, size_t MaxLevel = 0>
 		class SkipList {
 		private:
 			typedef detail::SkipListNode<K, V> node_type;
+			typedef typename traits::TypeChoice<MaxLevel == 0, detail::SkipListHeap<node_type>,
+					detail::SkipListSlab<node_type, MaxLevel>>::type storage_type;
 
 		public:
 			typedef K key_type;
@@ -54,7 +214,7 @@ namespace lwiot
 				typedef typename traits::TypeChoice<is_const, const SkipList::value_type,
 						SkipList::value_type>::type value_type;
 				typedef typename traits::TypeChoice<is_const, const SkipList::key_type, SkipList::key_type>::type key_type;
-				typedef typename traits::TypeChoice<is_const, const stl::SkipList<K, V>::node_type, stl::SkipList<K, V>::node_type>::type node_type;
+				typedef typename traits::TypeChoice<is_const, const stl::SkipList<K, V, MaxLevel>::node_type, stl::SkipList<K, V, MaxLevel>::node_type>::type node_type;
 
 				constexpr explicit IteratorBase() : _current(nullptr)
 				{
@@ -160,7 +320,7 @@ namespace lwiot
 			private:
 				node_type *_current;
 
-				friend class SkipList<K, V>;
+				friend class SkipList<K, V, MaxLevel>;
 			};
 
 			typedef IteratorBase<true> const_iterator;
@@ -175,9 +335,11 @@ namespace lwiot
 				this->copy(other);
 			}
 
-			SkipList(SkipList &&other) noexcept : _head(stl::move(other._head)), _size(other._size)
+			SkipList(SkipList &&other) noexcept : _head(stl::move(other._head)), _size(other._size),
+				_storage(stl::move(other._storage))
 			{
 				other._head.assign(1, nullptr);
+				other._size = 0;
 			}
 
 			virtual ~SkipList()
@@ -194,6 +356,10 @@ namespace lwiot
 
 			SkipList &operator=(const SkipList &rhs)
 			{
+				if(this == &rhs)
+					return *this;
+
+				this->freeAllNodes(this->_head[0]);
 				this->copy(rhs);
 				return *this;
 			}
@@ -209,6 +375,22 @@ namespace lwiot
 				return this->_head[0] == nullptr;
 			}
 
+			constexpr size_type size() const noexcept
+			{
+				return this->_size;
+			}
+
+			/**
+			 * @brief Make sure \p num nodes can be stored without allocating.
+			 * @param num Number of nodes.
+			 * @note Only has an effect on lists with a level limit.
+			 */
+			void reserve(size_type num)
+			{
+				if(num > this->_size)
+					this->_storage.reserve(num - this->_size);
+			}
+
 			iterator begin() noexcept
 			{
 				return iterator{this->_head[0]};
@@ -278,6 +460,74 @@ namespace lwiot
 				return this->insert(new_node, node_level);
 			}
 
+			/**
+			 * @brief Insert a range of key-value pairs.
+			 * @param first Iterator to the first pair.
+			 * @param last Iterator past the last pair.
+			 */
+			template <typename Iter>
+			void insertRange(Iter first, Iter last)
+			{
+				size_type num = 0;
+
+				for(auto iter = first; iter != last; ++iter)
+					num++;
+
+				this->reserve(this->_size + num);
+
+				for(auto iter = first; iter != last; ++iter)
+					this->insert((*iter).first, (*iter).second);
+			}
+
+			/**
+			 * @brief Erase all entries with a key in the range [first, last).
+			 * @param first Lowest key to erase.
+			 * @param last Key to stop at.
+			 * @return The number of erased entries.
+			 */
+			size_type eraseRange(const key_type &first, const key_type &last)
+			{
+				node_type *node = nullptr;
+				size_type num = 0;
+
+				auto level = this->_head.size();
+				auto next = this->_head.data();
+
+				while(level > 0) {
+					const auto index = level - 1;
+
+					if(next[index] && first > next[index]->_key) {
+						next = next[index]->next;
+						continue;
+					}
+
+					auto end = next[index];
+
+					while(end && last > end->_key)
+						end = end->next[index];
+
+					if(index == 0)
+						node = next[index];
+
+					next[index] = end;
+					--level;
+				}
+
+				while(node && last > node->_key) {
+					auto temp = node;
+
+					node = node->next[0];
+					this->destroyNode(temp);
+					num++;
+				}
+
+				while(this->_head.size() > 1 && this->_head.back() == nullptr)
+					this->_head.popback();
+
+				this->_size -= num;
+				return num;
+			}
+
 			bool erase(const key_type &key)
 			{
 				node_type *node = nullptr;
@@ -304,6 +554,7 @@ namespace lwiot
 
 				if(node) {
 					this->destroyNode(node);
+					this->_size -= 1;
 					return true;
 				} else {
 					return false;
@@ -361,6 +612,7 @@ namespace lwiot
 		private:
 			stl::Vector<node_type *> _head;
 			size_type _size;
+			storage_type _storage;
 
 			static constexpr double DefaultProbability = 0.5;
 			static constexpr int DefaultLevel = 5;
@@ -373,7 +625,7 @@ namespace lwiot
 				do {
 					++new_level;
 					nxtlvl = this->shouldProgress();
-				} while(new_level <= this->_head.size() && nxtlvl);
+				} while(new_level <= this->_head.size() && new_level < storage_type::MaximumLevel && nxtlvl);
 
 				return new_level;
 			}
@@ -385,8 +637,7 @@ namespace lwiot
 
 			node_type *allocateNode(key_type &&key, value_type &&value, size_type levels)
 			{
-				const auto node_size = sizeof(node_type) + (levels - 1) * sizeof(node_type *);
-				const auto node = lwiot_mem_zalloc(node_size);
+				const auto node = this->_storage.allocate(levels);
 
 				new(node) node_type{stl::forward<key_type>(key), stl::forward<value_type>(value), levels, {nullptr}};
 				return reinterpret_cast<node_type *>(node);
@@ -394,8 +645,7 @@ namespace lwiot
 
 			node_type *allocateNode(const key_type &key, const value_type &value, size_type levels)
 			{
-				const auto node_size = sizeof(node_type) + (levels - 1) * sizeof(node_type *);
-				const auto node = lwiot_mem_zalloc(node_size);
+				const auto node = this->_storage.allocate(levels);
 
 				new(node) node_type{key, value, levels, {nullptr}};
 				return reinterpret_cast<node_type *>(node);
@@ -407,7 +657,7 @@ namespace lwiot
 					return;
 
 				node->~node_type();
-				lwiot_mem_free(node);
+				this->_storage.deallocate(node);
 			}
 
 			void freeAllNodes(node_type *head)
@@ -426,6 +676,7 @@ namespace lwiot
 				using stl::swap;
 				swap(a._head, b._head);
 				swap(a._size, b._size);
+				a._storage.swap(b._storage);
 			}
 
 			iterator insert(node_type *new_node, int node_level)
@@ -453,7 +704,7 @@ namespace lwiot
 					} else if(node->_key == new_node->_key) {
 						if(node->levels >= node_level) {
 							node->_value = stl::move(new_node->_value);
-							this->destroyNode(node);
+							this->destroyNode(new_node);
 
 							return iterator(node);
 						}
@@ -481,6 +732,8 @@ namespace lwiot
 			void copy(const SkipList &other)
 			{
 				this->_head.assign(other._head.size(), nullptr);
+				this->_size = other._size;
+				this->_storage.reserve(other._size);
 
 				auto tail = stl::Vector<node_type **>{};
 
@@ -0,0 +1,111 @@
+/*
+ * Dynamic array with inline storage.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <lwiot.h>
+
+#ifdef CXX
+#include <lwiot/types.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/stl/move.h>
+
+namespace lwiot
+{
+	namespace stl
+	{
+		/**
+		 * @brief Vector that keeps its first \p N elements inside the object.
+		 * @tparam T Object type.
+		 * @tparam N Number of inline elements.
+		 * @tparam A Allocator type, used once the vector grows beyond \p N elements.
+		 *
+		 * A SmallVector is a Vector, so it can be passed to any API that takes a `Vector<T, A>&`.
+		 */
+		template<class T, size_t N, class A = DefaultAllocator<T>>
+		class SmallVector : public Vector<T, A> {
+			static_assert(N > 0, "SmallVector requires at least one inline element");
+
+		public:
+			typedef Vector<T, A> Base;
+
+			CONSTEXPR explicit SmallVector() : Base(this->storage(), N), _storage()
+			{
+			}
+
+			explicit SmallVector(const size_t &s) : Base(this->storage(), N), _storage()
+			{
+				this->reserve(s);
+			}
+
+			SmallVector(const Base &other) : Base(this->storage(), N), _storage()
+			{
+				this->copy(other);
+			}
+
+			SmallVector(const SmallVector &other) : Base(this->storage(), N), _storage()
+			{
+				this->copy(other);
+			}
+
+			SmallVector(Base &&other) noexcept : Base(this->storage(), N), _storage()
+			{
+				Base::operator=(stl::move(other));
+			}
+
+			SmallVector(SmallVector &&other) noexcept : Base(this->storage(), N), _storage()
+			{
+				Base::operator=(stl::move(other));
+			}
+
+			~SmallVector() override
+			{
+				this->clear();
+			}
+
+			SmallVector &operator=(const SmallVector &rhs)
+			{
+				Base::operator=(rhs);
+				return *this;
+			}
+
+			SmallVector &operator=(SmallVector &&rhs) noexcept
+			{
+				Base::operator=(stl::move(rhs));
+				return *this;
+			}
+
+			constexpr size_t inlineCapacity() const
+			{
+				return N;
+			}
+
+			constexpr bool isSmall() const
+			{
+				return this->isInline();
+			}
+
+		private:
+			alignas(T) uint8_t _storage[N * sizeof(T)];
+
+			T *storage()
+			{
+				return reinterpret_cast<T *>(this->_storage);
+			}
+
+			void copy(const Base &other)
+			{
+				this->reserve(other.size());
+
+				for(auto &obj : other)
+					this->pushback(obj);
+			}
+		};
+	}
+}
+
+#endif
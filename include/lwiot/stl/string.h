@@ -11,6 +11,7 @@
 #include <string.h>
 
 #include <lwiot/bytebuffer.h>
+#include <lwiot/util/numberformat.h>
 
 #ifdef __cplusplus
 namespace lwiot
@@ -18,6 +19,46 @@ namespace lwiot
 	namespace stl
 	{
 		class StringSumHelper;
+		class String;
+		class StringView;
+
+		namespace detail
+		{
+			/*
+			 * Single operand of String::append(). Numbers are formatted into the piece itself, so the
+			 * total length of all operands is known before anything is copied.
+			 */
+			class StringPiece {
+			public:
+				StringPiece(const String &str);
+				StringPiece(const StringView &str);
+				StringPiece(const char *cstr);
+				StringPiece(char c);
+				StringPiece(unsigned char num);
+				StringPiece(int num);
+				StringPiece(unsigned int num);
+				StringPiece(long num);
+				StringPiece(unsigned long num);
+				StringPiece(long long num);
+				StringPiece(unsigned long long num);
+				StringPiece(double num);
+
+				const char *data() const
+				{
+					return this->_data ? this->_data : this->_local;
+				}
+
+				size_t length() const
+				{
+					return this->_length;
+				}
+
+			private:
+				const char *_data;
+				size_t _length;
+				char _local[NumberFormat::DecimalBufferSize];
+			};
+		}
 
 		// The string class
 		class String {
@@ -37,6 +78,7 @@ namespace lwiot
 			// fails, the string will be marked as invalid (i.e. "if (s)" will
 			// be false).
 			String(const char *cstr = "");
+			String(const char *cstr, size_t length);
 			explicit String(const lwiot::ByteBuffer& buf);
 			String(const String &str);
 
@@ -120,6 +162,21 @@ namespace lwiot
 
 			bool equalsConstantTime(const String &s) const;
 
+			/**
+			 * @brief Append any number of strings, characters and numbers.
+			 * @return A reference to this string.
+			 *
+			 * The combined length is computed up front, so the buffer is resized at most once.
+			 */
+			template <typename First, typename... Args>
+			String &append(const First &first, const Args&... args)
+			{
+				const detail::StringPiece pieces[] = { detail::StringPiece(first), detail::StringPiece(args)... };
+
+				this->appendPieces(pieces, sizeof...(Args) + 1);
+				return *this;
+			}
+
 			// if there's not enough memory for the concatenated value, the string
 			// will be left unchanged (but this isn't signalled in any way)
 			String &operator+=(const String &rhs)
@@ -338,15 +395,26 @@ namespace lwiot
 			double toDouble() const;
 
 		protected:
+			/* Strings up to this length are stored inline, without a heap allocation. */
+			static constexpr unsigned int InlineCapacity = 15;
+
 			char *buffer;
 			unsigned int capacity;
 			unsigned int len;
+			char inlineBuffer[InlineCapacity + 1];
 
 		protected:
+			bool isInline() const
+			{
+				return this->buffer == this->inlineBuffer;
+			}
+
 			void init();
 			void invalidate();
 			unsigned char changeBuffer(unsigned int maxStrLen);
 			unsigned char concat(const char *cstr, unsigned int length);
+			unsigned char reserveForAppend(unsigned int extra);
+			void appendPieces(const detail::StringPiece *pieces, size_t num);
 
 			// copy and move
 			String &copy(const char *cstr, unsigned int length);
@@ -0,0 +1,248 @@
+/*
+ * Non-owning string view.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <lwiot.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <lwiot/stl/string.h>
+
+#ifdef __cplusplus
+namespace lwiot
+{
+	namespace stl
+	{
+		/**
+		 * @brief Read-only reference to a sequence of characters.
+		 *
+		 * A view does not own the characters it points to and is not necessarily nul-terminated. It
+		 * is only valid as long as the underlying buffer is. Views are cheap to copy and are meant to
+		 * be passed by value.
+		 */
+		class StringView {
+		public:
+			static constexpr size_t npos = ~size_t(0);
+
+			constexpr StringView() : _data(""), _length(0)
+			{
+			}
+
+			constexpr StringView(const char *str, size_t length) : _data(str), _length(length)
+			{
+			}
+
+			constexpr StringView(const char *str) : _data(str), _length(StringView::strlen(str))
+			{
+			}
+
+			StringView(const String &str) : _data(str.c_str() ? str.c_str() : ""), _length(str.length())
+			{
+			}
+
+			constexpr const char *data() const
+			{
+				return this->_data;
+			}
+
+			constexpr size_t length() const
+			{
+				return this->_length;
+			}
+
+			constexpr size_t size() const
+			{
+				return this->_length;
+			}
+
+			constexpr bool empty() const
+			{
+				return this->_length == 0;
+			}
+
+			constexpr char operator[](size_t idx) const
+			{
+				return this->_data[idx];
+			}
+
+			constexpr const char *begin() const
+			{
+				return this->_data;
+			}
+
+			constexpr const char *end() const
+			{
+				return this->_data + this->_length;
+			}
+
+			/**
+			 * @brief Create a view on a part of this view.
+			 * @param pos Start position.
+			 * @param count Number of characters, clipped to the end of the view.
+			 */
+			constexpr StringView substr(size_t pos, size_t count = npos) const
+			{
+				return pos >= this->_length ? StringView(this->_data + this->_length, 0) :
+					StringView(this->_data + pos, count > this->_length - pos ? this->_length - pos : count);
+			}
+
+			StringView trim() const
+			{
+				size_t start = 0;
+				size_t end = this->_length;
+
+				while(start < end && isspace(this->_data[start]))
+					start++;
+
+				while(end > start && isspace(this->_data[end - 1]))
+					end--;
+
+				return StringView(this->_data + start, end - start);
+			}
+
+			size_t find(char c, size_t pos = 0) const
+			{
+				for(auto idx = pos; idx < this->_length; idx++) {
+					if(this->_data[idx] == c)
+						return idx;
+				}
+
+				return npos;
+			}
+
+			size_t find(const StringView &str, size_t pos = 0) const
+			{
+				if(str._length > this->_length)
+					return npos;
+
+				for(auto idx = pos; idx + str._length <= this->_length; idx++) {
+					if(memcmp(this->_data + idx, str._data, str._length) == 0)
+						return idx;
+				}
+
+				return npos;
+			}
+
+			size_t rfind(char c) const
+			{
+				for(auto idx = this->_length; idx > 0; idx--) {
+					if(this->_data[idx - 1] == c)
+						return idx - 1;
+				}
+
+				return npos;
+			}
+
+			int compare(const StringView &other) const
+			{
+				auto num = this->_length < other._length ? this->_length : other._length;
+				auto rv = num ? memcmp(this->_data, other._data, num) : 0;
+
+				if(rv != 0)
+					return rv;
+
+				if(this->_length == other._length)
+					return 0;
+
+				return this->_length < other._length ? -1 : 1;
+			}
+
+			bool equals(const StringView &other) const
+			{
+				return this->_length == other._length && this->compare(other) == 0;
+			}
+
+			bool equalsIgnoreCase(const StringView &other) const
+			{
+				if(this->_length != other._length)
+					return false;
+
+				for(size_t idx = 0; idx < this->_length; idx++) {
+					if(tolower(this->_data[idx]) != tolower(other._data[idx]))
+						return false;
+				}
+
+				return true;
+			}
+
+			bool startsWith(const StringView &prefix) const
+			{
+				return prefix._length <= this->_length && memcmp(this->_data, prefix._data, prefix._length) == 0;
+			}
+
+			bool endsWith(const StringView &suffix) const
+			{
+				return suffix._length <= this->_length &&
+					memcmp(this->end() - suffix._length, suffix._data, suffix._length) == 0;
+			}
+
+			String toString() const
+			{
+				return String(this->_data, this->_length);
+			}
+
+		private:
+			const char *_data;
+			size_t _length;
+
+			static constexpr size_t strlen(const char *str)
+			{
+				size_t length = 0;
+
+				while(str[length] != '\0')
+					length++;
+
+				return length;
+			}
+		};
+
+		static inline bool operator==(const StringView &lhs, const StringView &rhs)
+		{
+			return lhs.equals(rhs);
+		}
+
+		static inline bool operator!=(const StringView &lhs, const StringView &rhs)
+		{
+			return !lhs.equals(rhs);
+		}
+
+		static inline bool operator==(const String &lhs, const StringView &rhs)
+		{
+			return rhs.equals(lhs);
+		}
+
+		static inline bool operator==(const StringView &lhs, const String &rhs)
+		{
+			return lhs.equals(rhs);
+		}
+
+		static inline bool operator==(const StringView &lhs, const char *rhs)
+		{
+			return lhs.equals(rhs);
+		}
+
+		static inline bool operator==(const char *lhs, const StringView &rhs)
+		{
+			return rhs.equals(lhs);
+		}
+
+		static inline bool operator!=(const StringView &lhs, const char *rhs)
+		{
+			return !lhs.equals(rhs);
+		}
+
+		static inline bool operator<(const StringView &lhs, const StringView &rhs)
+		{
+			return lhs.compare(rhs) < 0;
+		}
+	}
+
+	typedef stl::StringView StringView;
+}
+#endif
@@ -20,6 +20,7 @@
 #include <lwiot/traits/decay.h>
 #include <lwiot/traits/removecv.h>
 #include <lwiot/traits/enableif.h>
+#include <lwiot/traits/isreference.h>
 
 namespace lwiot
 {
@@ -44,6 +45,10 @@ namespace lwiot
 		struct make_index_sequence<1> : IndexSequence<0> {
 		};
 
+		template<>
+		struct make_index_sequence<0> : IndexSequence<> {
+		};
+
 		template<size_t, typename T>
 		struct TupleElement {
 			typedef T Type;
@@ -196,7 +201,7 @@ namespace lwiot
 		template<size_t I, typename... Types>
 		constexpr type_at_index_t<I, Types...> const &get(Tuple<Types...> const &tup)
 		{
-			TupleElement<I, type_at_index_t<I, Types...>> &base = tup;
+			const TupleElement<I, type_at_index_t<I, Types...>> &base = tup;
 			return base._value;
 		}
 
@@ -215,6 +220,10 @@ namespace lwiot
 		struct TupleSize<Tuple<Types...>> : traits::IntegralConstant<size_t, sizeof...(Types)> {
 		};
 
+		template<typename T>
+		struct TupleSize<const T> : TupleSize<T> {
+		};
+
 		template<typename T>
 		struct UnwrapRefwrapper {
 			using type = T;
@@ -239,6 +248,81 @@ namespace lwiot
 		{
 			return Tuple<T&...>(args...);
 		}
+
+		namespace detail
+		{
+			template <typename Func, typename T, size_t... Indices>
+			constexpr auto apply(Func &&func, T &&tuple, IndexSequence<Indices...>)
+				-> decltype(func(get<Indices>(stl::forward<T>(tuple))...))
+			{
+				return func(get<Indices>(stl::forward<T>(tuple))...);
+			}
+		}
+
+		/**
+		 * @brief Call \p func with the elements of \p tuple as its arguments.
+		 *
+		 * The call is resolved at compile time; no Function object is created.
+		 */
+		template <typename Func, typename T,
+				typename Indices = typename make_index_sequence<TupleSize<typename traits::Decay<T>::type>::value>::type>
+		constexpr auto apply(Func &&func, T &&tuple)
+			-> decltype(detail::apply(stl::forward<Func>(func), stl::forward<T>(tuple), Indices()))
+		{
+			return detail::apply(stl::forward<Func>(func), stl::forward<T>(tuple), Indices());
+		}
+
+		/**
+		 * @brief Callable that passes a fixed set of leading arguments to a function.
+		 * @see bind_front()
+		 */
+		template <typename Func, typename... Bound>
+		class BindFront {
+		private:
+			typedef typename make_index_sequence<sizeof...(Bound)>::type Indices;
+
+			template <size_t... idx, typename... Args>
+			auto call(IndexSequence<idx...>, Args&&... args)
+				-> decltype(traits::declval<Func&>()(traits::declval<Bound&>()..., stl::forward<Args>(args)...))
+			{
+				return this->_func(get<idx>(this->_bound)..., stl::forward<Args>(args)...);
+			}
+
+		public:
+			template <typename F, typename... B>
+			explicit BindFront(F&& func, B&&... bound) : _func(stl::forward<F>(func)), _bound(stl::forward<B>(bound)...)
+			{
+			}
+
+			template <typename... Args>
+			auto operator()(Args&&... args)
+				-> decltype(traits::declval<Func&>()(traits::declval<Bound&>()..., stl::forward<Args>(args)...))
+			{
+				return this->call(Indices(), stl::forward<Args>(args)...);
+			}
+
+		private:
+			Func _func;
+			Tuple<Bound...> _bound;
+		};
+
+		/**
+		 * @brief Bind the leading arguments of \p func.
+		 *
+		 * Unlike a lambda stored in a Function, the result has a concrete type that holds \p func
+		 * and copies of \p args, so a call through it can be inlined.
+		 *
+		 * @code
+		 * auto handler = lwiot::stl::bind_front(&on_frame, &context);
+		 * handler(frame); // on_frame(&context, frame)
+		 * @endcode
+		 */
+		template <typename Func, typename... Args>
+		BindFront<typename traits::Decay<Func>::type, typename traits::Decay<Args>::type...> bind_front(Func&& func, Args&&... args)
+		{
+			typedef BindFront<typename traits::Decay<Func>::type, typename traits::Decay<Args>::type...> Result;
+			return Result(stl::forward<Func>(func), stl::forward<Args>(args)...);
+		}
 /*template<typename Value>
 struct Tuple<Value> {
 	constexpr Tuple()
@@ -0,0 +1,502 @@
+/*
+ * Hash map implementation using open addressing.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <lwiot.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lwiot/stl/move.h>
+#include <lwiot/stl/forward.h>
+#include <lwiot/stl/hash.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/traits/typechoice.h>
+#include <lwiot/traits/enableif.h>
+#include <lwiot/traits/issame.h>
+
+namespace lwiot
+{
+	namespace stl
+	{
+		/**
+		 * @brief Hash map with a flat memory layout.
+		 * @tparam K Key type.
+		 * @tparam V Value type.
+		 * @tparam H Hash function type.
+		 *
+		 * Collisions are resolved using linear probing in a power of two sized table. The table grows
+		 * when the number of used slots exceeds the maximum load factor. The interface matches stl::Map.
+		 */
+		template<typename K, typename V, typename H = Hash<K>>
+		class UnorderedMap {
+		public:
+			typedef K MapKey;
+			typedef V MapValue;
+
+			struct Entry {
+			public:
+				Entry(const MapKey &key, const MapValue &value) : key(key), value(value)
+				{
+				}
+
+				Entry(MapKey &&key, MapValue &&value) noexcept :
+						key(stl::forward<MapKey>(key)), value(stl::forward<MapValue>(value))
+				{
+				}
+
+				MapKey key;
+				MapValue value;
+			};
+
+			template<bool is_const>
+			class Iterator {
+			public:
+				typedef typename traits::TypeChoice<is_const, const Entry &, Entry &>::type reference;
+				typedef typename traits::TypeChoice<is_const, const Entry *, Entry *>::type pointer;
+				typedef typename traits::TypeChoice<is_const, const UnorderedMap *, UnorderedMap *>::type map_pointer;
+
+				constexpr explicit Iterator() : _map(nullptr), _index(0)
+				{
+				}
+
+				constexpr explicit Iterator(map_pointer map, size_t index) : _map(map), _index(index)
+				{
+				}
+
+				Iterator &operator++()
+				{
+					this->_index = this->_map->next(this->_index + 1);
+					return *this;
+				}
+
+				const Iterator operator++(int)
+				{
+					Iterator iter = *this;
+
+					++*this;
+					return iter;
+				}
+
+				constexpr bool operator==(const Iterator &rhs) const
+				{
+					return this->_index == rhs._index;
+				}
+
+				constexpr bool operator!=(const Iterator &rhs) const
+				{
+					return !(*this == rhs);
+				}
+
+				reference operator*() const
+				{
+					return this->_map->_entries[this->_index];
+				}
+
+				pointer operator->() const
+				{
+					return &this->_map->_entries[this->_index];
+				}
+
+			private:
+				map_pointer _map;
+				size_t _index;
+			};
+
+			typedef Iterator<false> iterator;
+			typedef Iterator<true> const_iterator;
+
+			static constexpr float DefaultLoadFactor = 0.75f;
+
+			explicit UnorderedMap(size_t capacity = 0) : _entries(nullptr), _states(nullptr), _capacity(0),
+				_size(0), _deleted(0), _load(DefaultLoadFactor)
+			{
+				if(capacity)
+					this->rehash(capacity);
+			}
+
+			UnorderedMap(const UnorderedMap &other) : UnorderedMap()
+			{
+				this->copy(other);
+			}
+
+			UnorderedMap(UnorderedMap &&other) noexcept : UnorderedMap()
+			{
+				this->swap(other);
+			}
+
+			virtual ~UnorderedMap()
+			{
+				this->release();
+			}
+
+			UnorderedMap &operator=(const UnorderedMap &rhs)
+			{
+				if(this == &rhs)
+					return *this;
+
+				this->clear();
+				this->copy(rhs);
+
+				return *this;
+			}
+
+			UnorderedMap &operator=(UnorderedMap &&rhs) noexcept
+			{
+				this->swap(rhs);
+				return *this;
+			}
+
+			void clear()
+			{
+				for(size_t idx = 0; idx < this->_capacity; idx++) {
+					if(this->_states[idx] == Full)
+						this->_entries[idx].~Entry();
+
+					this->_states[idx] = Empty;
+				}
+
+				this->_size = 0;
+				this->_deleted = 0;
+			}
+
+			constexpr size_t size() const
+			{
+				return this->_size;
+			}
+
+			constexpr bool empty() const
+			{
+				return this->_size == 0;
+			}
+
+			constexpr size_t capacity() const
+			{
+				return this->_capacity;
+			}
+
+			void setMaxLoadFactor(float factor)
+			{
+				if(factor <= 0.0f || factor >= 1.0f)
+					return;
+
+				this->_load = factor;
+			}
+
+			constexpr float maxLoadFactor() const
+			{
+				return this->_load;
+			}
+
+			void reserve(size_t num)
+			{
+				auto needed = static_cast<size_t>(num / this->_load) + 1;
+
+				if(needed > this->_capacity)
+					this->rehash(needed);
+			}
+
+			void add(const MapKey &key, const MapValue &value)
+			{
+				auto idx = this->insert(key);
+
+				if(this->_states[idx] == Full) {
+					this->_entries[idx].value = value;
+					return;
+				}
+
+				new(&this->_entries[idx]) Entry(key, value);
+				this->_states[idx] = Full;
+				this->_size++;
+			}
+
+			void add(MapKey &&key, MapValue &&value)
+			{
+				auto idx = this->insert(key);
+
+				if(this->_states[idx] == Full) {
+					this->_entries[idx].value = stl::move(value);
+					return;
+				}
+
+				new(&this->_entries[idx]) Entry(stl::forward<MapKey>(key), stl::forward<MapValue>(value));
+				this->_states[idx] = Full;
+				this->_size++;
+			}
+
+			MapValue at(const MapKey &key) const
+			{
+				auto idx = this->lookup(key);
+
+				if(idx == this->_capacity)
+					return MapValue();
+
+				return this->_entries[idx].value;
+			}
+
+			MapValue operator[](const MapKey &key) const
+			{
+				return this->at(key);
+			}
+
+			MapValue &operator[](const MapKey &key)
+			{
+				auto idx = this->insert(key);
+
+				if(this->_states[idx] != Full) {
+					new(&this->_entries[idx]) Entry(key, MapValue());
+					this->_states[idx] = Full;
+					this->_size++;
+				}
+
+				return this->_entries[idx].value;
+			}
+
+			iterator find(const MapKey &key)
+			{
+				return iterator(this, this->lookup(key));
+			}
+
+			const_iterator find(const MapKey &key) const
+			{
+				return const_iterator(this, this->lookup(key));
+			}
+
+			bool contains(const MapKey &key) const
+			{
+				return this->lookup(key) != this->_capacity;
+			}
+
+			/*
+			 * Lookups using a StringView, for maps keyed by String. These avoid constructing a
+			 * temporary String for every lookup.
+			 */
+			template <typename L, typename = traits::EnableIf_t<traits::IsSame<L, StringView>::value>>
+			iterator find(const L &key)
+			{
+				return iterator(this, this->lookup(key));
+			}
+
+			template <typename L, typename = traits::EnableIf_t<traits::IsSame<L, StringView>::value>>
+			const_iterator find(const L &key) const
+			{
+				return const_iterator(this, this->lookup(key));
+			}
+
+			template <typename L, typename = traits::EnableIf_t<traits::IsSame<L, StringView>::value>>
+			bool contains(const L &key) const
+			{
+				return this->lookup(key) != this->_capacity;
+			}
+
+			void remove(const MapKey &key)
+			{
+				auto idx = this->lookup(key);
+
+				if(idx == this->_capacity)
+					return;
+
+				this->_entries[idx].~Entry();
+				this->_states[idx] = Deleted;
+				this->_size--;
+				this->_deleted++;
+			}
+
+			iterator begin()
+			{
+				return iterator(this, this->next(0));
+			}
+
+			iterator end()
+			{
+				return iterator(this, this->_capacity);
+			}
+
+			const_iterator begin() const
+			{
+				return const_iterator(this, this->next(0));
+			}
+
+			const_iterator end() const
+			{
+				return const_iterator(this, this->_capacity);
+			}
+
+			template <typename Func>
+			void foreach(Func functor)
+			{
+				for(auto &entry : *this)
+					functor(entry);
+			}
+
+		private:
+			enum SlotState : uint8_t {
+				Empty = 0,
+				Full,
+				Deleted
+			};
+
+			static constexpr size_t MinimumCapacity = 8;
+
+			Entry *_entries;
+			uint8_t *_states;
+			size_t _capacity;
+			size_t _size;
+			size_t _deleted;
+			float _load;
+			H _hash;
+
+			/* Methods */
+			constexpr size_t slot(const MapKey &key) const
+			{
+				return this->_hash(key) & (this->_capacity - 1);
+			}
+
+			size_t slot(const StringView &key) const
+			{
+				static_assert(traits::IsSame<H, Hash<String>>::value, "StringView lookups require Hash<String>");
+				return Hash<StringView>()(key) & (this->_capacity - 1);
+			}
+
+			size_t next(size_t idx) const
+			{
+				while(idx < this->_capacity && this->_states[idx] != Full)
+					idx++;
+
+				return idx;
+			}
+
+			template <typename L>
+			size_t lookup(const L &key) const
+			{
+				if(this->_size == 0)
+					return this->_capacity;
+
+				auto idx = this->slot(key);
+
+				for(size_t probe = 0; probe < this->_capacity; probe++) {
+					auto state = this->_states[idx];
+
+					if(state == Empty)
+						break;
+
+					if(state == Full && this->_entries[idx].key == key)
+						return idx;
+
+					idx = (idx + 1) & (this->_capacity - 1);
+				}
+
+				return this->_capacity;
+			}
+
+			/* Find the slot that holds `key', or the slot it should be inserted in. */
+			size_t insert(const MapKey &key)
+			{
+				if(this->_capacity == 0 || this->_size + this->_deleted + 1 > this->_capacity * this->_load)
+					this->rehash(this->_size * 2 + 1);
+
+				auto idx = this->slot(key);
+				auto target = this->_capacity;
+
+				for(size_t probe = 0; probe < this->_capacity; probe++) {
+					auto state = this->_states[idx];
+
+					if(state == Empty) {
+						if(target == this->_capacity)
+							target = idx;
+
+						break;
+					}
+
+					if(state == Deleted) {
+						if(target == this->_capacity)
+							target = idx;
+					} else if(this->_entries[idx].key == key) {
+						return idx;
+					}
+
+					idx = (idx + 1) & (this->_capacity - 1);
+				}
+
+				if(this->_states[target] == Deleted)
+					this->_deleted--;
+
+				return target;
+			}
+
+			void rehash(size_t num)
+			{
+				size_t capacity = MinimumCapacity;
+
+				while(capacity < num || this->_size + 1 > capacity * this->_load)
+					capacity <<= 1U;
+
+				auto entries = this->_entries;
+				auto states = this->_states;
+				auto old = this->_capacity;
+
+				this->_entries = static_cast<Entry *>(lwiot_mem_alloc(capacity * sizeof(Entry)));
+				this->_states = static_cast<uint8_t *>(lwiot_mem_zalloc(capacity));
+				this->_capacity = capacity;
+				this->_deleted = 0;
+
+				for(size_t idx = 0; idx < old; idx++) {
+					if(states[idx] != Full)
+						continue;
+
+					auto target = this->slot(entries[idx].key);
+
+					while(this->_states[target] != Empty)
+						target = (target + 1) & (capacity - 1);
+
+					new(&this->_entries[target]) Entry(stl::move(entries[idx]));
+					this->_states[target] = Full;
+					entries[idx].~Entry();
+				}
+
+				lwiot_mem_free(entries);
+				lwiot_mem_free(states);
+			}
+
+			void release()
+			{
+				if(this->_capacity == 0)
+					return;
+
+				this->clear();
+
+				lwiot_mem_free(this->_entries);
+				lwiot_mem_free(this->_states);
+
+				this->_entries = nullptr;
+				this->_states = nullptr;
+				this->_capacity = 0;
+			}
+
+			void copy(const UnorderedMap &other)
+			{
+				this->_load = other._load;
+				this->reserve(other._size);
+
+				for(const auto &entry : other)
+					this->add(entry.key, entry.value);
+			}
+
+			void swap(UnorderedMap &other)
+			{
+				using stl::swap;
+
+				swap(this->_entries, other._entries);
+				swap(this->_states, other._states);
+				swap(this->_capacity, other._capacity);
+				swap(this->_size, other._size);
+				swap(this->_deleted, other._deleted);
+				swap(this->_load, other._load);
+			}
+		};
+	}
+}
@@ -16,7 +16,9 @@
 #include <lwiot/util/defaultallocator.h>
 
 #include <lwiot/stl/move.h>
+#include <lwiot/stl/forward.h>
 #include <lwiot/traits/typechoice.h>
+#include <lwiot/traits/istriviallycopyable.h>
 
 namespace lwiot
 {
@@ -69,6 +71,78 @@ namespace lwiot
 					return iter;
 				}
 
+				Iterator &operator--()
+				{
+					--this->_index;
+					return *this;
+				}
+
+				const Iterator operator--(int num)
+				{
+					Iterator iter(*this);
+
+					--*this;
+					return iter;
+				}
+
+				Iterator &operator+=(ptrdiff_t num)
+				{
+					this->_index += num;
+					return *this;
+				}
+
+				Iterator &operator-=(ptrdiff_t num)
+				{
+					this->_index -= num;
+					return *this;
+				}
+
+				Iterator operator+(ptrdiff_t num) const
+				{
+					Iterator iter(*this);
+
+					iter += num;
+					return iter;
+				}
+
+				Iterator operator-(ptrdiff_t num) const
+				{
+					Iterator iter(*this);
+
+					iter -= num;
+					return iter;
+				}
+
+				constexpr ptrdiff_t operator-(const Iterator &rhs) const
+				{
+					return static_cast<ptrdiff_t>(this->_index) - static_cast<ptrdiff_t>(rhs._index);
+				}
+
+				CONSTEXPR ObjectType &operator[](ptrdiff_t num) const
+				{
+					return this->_base[this->_index + num];
+				}
+
+				constexpr bool operator<(const Iterator &rhs) const
+				{
+					return this->_index < rhs._index;
+				}
+
+				constexpr bool operator>(const Iterator &rhs) const
+				{
+					return rhs < *this;
+				}
+
+				constexpr bool operator<=(const Iterator &rhs) const
+				{
+					return !(rhs < *this);
+				}
+
+				constexpr bool operator>=(const Iterator &rhs) const
+				{
+					return !(*this < rhs);
+				}
+
 				constexpr bool operator==(const Iterator &rhs) const
 				{
 					return this->_base == rhs._base && this->_index == rhs._index;
@@ -107,49 +181,48 @@ namespace lwiot
 			typedef Iterator<false> iterator;
 			typedef Iterator<true> const_iterator;
 
-			CONSTEXPR explicit Vector() : _index(0), _objects(nullptr), _space(0)
+			CONSTEXPR explicit Vector() : _index(0), _objects(nullptr), _space(0), _inline(nullptr), _inline_space(0)
 			{
 			}
 
-			explicit Vector(const size_t &s) : _index(0), _objects(nullptr), _space(0)
+			explicit Vector(const size_t &s) : _index(0), _objects(nullptr), _space(0), _inline(nullptr), _inline_space(0)
 			{
 				this->reserve(s);
 			}
 
-			Vector(const Vector<T, A> &other) : _alloc(other._alloc), _index(0), _objects(nullptr), _space(0)
+			explicit Vector(const Allocator &alloc) : _alloc(alloc), _index(0), _objects(nullptr), _space(0),
+				_inline(nullptr), _inline_space(0)
+			{
+			}
+
+			Vector(const Vector<T, A> &other) : _alloc(other._alloc), _index(0), _objects(nullptr), _space(0),
+				_inline(nullptr), _inline_space(0)
 			{
-				this->clear();
 				this->reserve(other.capacity());
 
-				for(auto &idx : other) {
-					this->pushback(idx);
-				}
+				for(size_t idx = 0; idx < other._index; idx++)
+					this->_alloc.construct(&this->_objects[idx], other._objects[idx]);
+
+				this->_index = other._index;
 			}
 
 			CONSTEXPR Vector(Vector<T, A> &&other) noexcept :
-					_index(other._index), _objects(other._objects), _space(other._space)
+					_index(0), _objects(nullptr), _space(0), _inline(nullptr), _inline_space(0)
 			{
 				this->_alloc = other._alloc;
-
-				other._objects = nullptr;
-				other._space = 0;
-				other._index = 0;
+				this->steal(other);
 			}
 
 			Vector<T, A> &operator=(const Vector &a);
 
 			Vector<T, A> &operator=(Vector<T, A> &&rhs) noexcept
 			{
-				this->release();
+				if(this == &rhs)
+					return *this;
 
+				this->release();
 				this->_alloc = stl::move(rhs._alloc);
-				this->_space = rhs._space;
-				this->_objects = rhs._objects;
-				this->_index = rhs._index;
-
-				rhs._objects = nullptr;
-				rhs._space = 0;
-				rhs._index = 0;
+				this->steal(rhs);
 
 				return *this;
 			}
@@ -248,19 +321,36 @@ namespace lwiot
 
 			CONSTEXPR void pushback(ObjectType&& value)
 			{
-				if(this->_space == 0UL)
-					this->reserve(4);
-				else if(this->_index == this->_space)
-					this->reserve(2 * this->_space);
-
+				this->grow();
 				this->_alloc.move(&this->_objects[this->_index], value);
 				this->_index++;
 			}
 
+			void push_back(const ObjectType &value)
+			{
+				this->pushback(value);
+			}
+
+			void push_back(ObjectType &&value)
+			{
+				this->pushback(stl::forward<ObjectType>(value));
+			}
+
+			/**
+			 * @brief Construct a new element in place at the end of the vector.
+			 * @param args Constructor arguments.
+			 * @return A reference to the new element.
+			 */
 			template <typename... Args>
-			auto push_back(Args&&... args) -> decltype(f(stl::forward<Args>(args)...))
+			ObjectType& emplace_back(Args&&... args)
 			{
-				return pushback(stl::forward<Args>(args)...);
+				this->grow();
+
+				auto obj = &this->_objects[this->_index];
+				new(obj) ObjectType(stl::forward<Args>(args)...);
+				this->_index++;
+
+				return *obj;
 			}
 
 			CONSTEXPR void add(const ObjectType &val)
@@ -279,15 +369,55 @@ namespace lwiot
 			void assign(size_t n, const ObjectType& value)
 			{
 				this->release();
-				this->_index = 0;
-				this->_space = 0;
-
 				this->reserve(n);
 
 				for(size_t idx = 0; idx < n; idx++)
 					this->pushback(value);
 			}
 
+			/**
+			 * @brief Insert an element at a given position.
+			 * @param index Position to insert at. Elements at and after \p index shift back by one.
+			 * @param value Value to insert.
+			 */
+			void insert(size_t index, ObjectType&& value)
+			{
+				if(index >= this->_index) {
+					this->pushback(stl::forward<ObjectType>(value));
+					return;
+				}
+
+				this->grow();
+				this->_alloc.move(&this->_objects[this->_index], this->_objects[this->_index - 1]);
+
+				for(size_t idx = this->_index - 1; idx > index; idx--)
+					this->_objects[idx] = stl::move(this->_objects[idx - 1]);
+
+				this->_objects[index] = stl::move(value);
+				this->_index++;
+			}
+
+			void insert(size_t index, const ObjectType& value)
+			{
+				ObjectType copy(value);
+				this->insert(index, stl::move(copy));
+			}
+
+			/**
+			 * @brief Remove the element at a given position.
+			 * @param index Position of the element to remove.
+			 */
+			void erase(size_t index)
+			{
+				if(index >= this->_index)
+					return;
+
+				for(size_t idx = index; idx + 1 < this->_index; idx++)
+					this->_objects[idx] = stl::move(this->_objects[idx + 1]);
+
+				this->popback();
+			}
+
 			void popback()
 			{
 				if(this->_index == 0)
@@ -295,7 +425,25 @@ namespace lwiot
 
 				this->_index -= 1;
 				this->_alloc.destroy(&this->_objects[this->_index]);
-				memset(&this->_objects[this->_index], 0, sizeof(ObjectType));
+				memset(static_cast<void*>(&this->_objects[this->_index]), 0, sizeof(ObjectType));
+			}
+
+		protected:
+			/**
+			 * @brief Construct a vector on top of caller owned inline storage.
+			 * @param storage Storage for at least \p space objects.
+			 * @param space Number of objects that fit in \p storage.
+			 * @note The storage is only used as long as the size does not exceed \p space. Growing beyond
+			 *       it moves the vector to the heap. The storage must outlive the vector.
+			 */
+			CONSTEXPR explicit Vector(ObjectType *storage, size_t space) :
+				_index(0), _objects(storage), _space(space), _inline(storage), _inline_space(space)
+			{
+			}
+
+			constexpr bool isInline() const
+			{
+				return this->_objects != nullptr && this->_objects == this->_inline;
 			}
 
 		private:
@@ -309,6 +457,9 @@ namespace lwiot
 			ObjectType *_objects;
 			size_t _space;
 
+			ObjectType *_inline;
+			size_t _inline_space;
+
 			/* Methods */
 			inline void release()
 			{
@@ -316,10 +467,57 @@ namespace lwiot
 					_alloc.destroy(&_objects[i]);
 				}
 
-				if(this->_objects != nullptr)
+				if(this->_objects != nullptr && !this->isInline())
 					this->_alloc.deallocate(_objects, this->_space);
 
-				this->_objects = nullptr;
+				this->_objects = this->_inline;
+				this->_space = this->_inline_space;
+				this->_index = 0;
+			}
+
+			inline void grow()
+			{
+				if(this->_space == 0UL)
+					this->reserve(4);
+				else if(this->_index == this->_space)
+					this->reserve(2 * this->_space);
+			}
+
+			void relocate(ObjectType *dst, ObjectType *src, size_t num)
+			{
+				if(traits::IsTriviallyCopyable<ObjectType>::value) {
+					memcpy(static_cast<void*>(dst), static_cast<const void*>(src), num * sizeof(ObjectType));
+					return;
+				}
+
+				for(size_t idx = 0; idx < num; idx++) {
+					this->_alloc.move(&dst[idx], src[idx]);
+					this->_alloc.destroy(&src[idx]);
+				}
+			}
+
+			void steal(Vector<T, A> &other)
+			{
+				if(!other.isInline()) {
+					if(other._objects != nullptr) {
+						this->_objects = other._objects;
+						this->_space = other._space;
+						this->_index = other._index;
+					}
+
+					other._objects = other._inline;
+					other._space = other._inline_space;
+					other._index = 0;
+					return;
+				}
+
+				/* Inline storage can't change owner, move the elements instead. */
+				this->reserve(other._index);
+
+				for(size_t idx = 0; idx < other._index; idx++)
+					this->pushback(stl::move(other._objects[idx]));
+
+				other.clear();
 			}
 		};
 
@@ -330,9 +528,16 @@ namespace lwiot
 				return *this;
 
 			if(a.size() <= this->_space) {
-				for(size_t i = 0; i < a.size(); ++i) {
+				size_t i;
+
+				for(i = 0; i < a.size() && i < this->_index; ++i)
 					this->_objects[i] = a[i];
-				}
+
+				for(; i < a.size(); ++i)
+					this->_alloc.construct(&this->_objects[i], a[i]);
+
+				for(; i < this->_index; ++i)
+					this->_alloc.destroy(&this->_objects[i]);
 
 				this->_index = a.size();
 				return *this;
@@ -348,7 +553,7 @@ namespace lwiot
 				a._alloc.destroy(&_objects[i]);
 			}
 
-			if(this->_objects != nullptr)
+			if(this->_objects != nullptr && !this->isInline())
 				this->_alloc.deallocate(this->_objects, this->_space);
 
 			this->_space = this->_index = a.size();
@@ -364,16 +569,13 @@ namespace lwiot
 				return;
 
 			T *p = _alloc.allocate(newalloc);
-			memset(p, 0, newalloc * sizeof(T));
 
-			for(size_t i = 0; i < this->_index; i++) {
-				_alloc.construct(&p[i], _objects[i]);
-			}
-			for(size_t i = 0; i < this->_index; i++) {
-				_alloc.destroy(&_objects[i]);
-			}
+			if(this->_index > 0)
+				this->relocate(p, this->_objects, this->_index);
 
-			if(this->_objects)
+			memset(static_cast<void*>(&p[this->_index]), 0, (newalloc - this->_index) * sizeof(T));
+
+			if(this->_objects && !this->isInline())
 				_alloc.deallocate(_objects, this->_space);
 
 			this->_objects = p;
@@ -383,11 +585,7 @@ namespace lwiot
 		template<class T, class A>
 		CONSTEXPR void Vector<T, A>::pushback(const T &val)
 		{
-			if(this->_space == 0UL)
-				reserve(4);
-			else if(this->_index == this->_space)
-				reserve(2 * this->_space);
-
+			this->grow();
 			_alloc.construct(&_objects[this->_index], val);
 			this->_index++;
 		}
@@ -11,6 +11,7 @@
 
 #include <lwiot/types.h>
 #include <lwiot/stl/string.h>
+#include <lwiot/bytebuffer.h>
 
 #ifdef __cplusplus
 namespace lwiot {
@@ -46,6 +47,27 @@ namespace lwiot {
 		virtual String readString();
 		virtual String readStringUntil(char terminator);
 
+		/**
+		 * @brief Read up to a delimiter.
+		 * @param delim Delimiter. It is consumed, but not stored in \p output.
+		 * @param output Buffer to append the data to.
+		 * @return The number of bytes appended to \p output or -ETMO on timeout.
+		 */
+		virtual ssize_t readUntil(char delim, ByteBuffer& output);
+
+		/**
+		 * @brief Discard data up to and including a delimiter.
+		 * @param delim Delimiter.
+		 * @return The number of bytes discarded, excluding the delimiter, or -ETMO on timeout.
+		 */
+		virtual ssize_t skipUntil(char delim);
+
+		/**
+		 * @brief Data that is buffered by the stream, without consuming it.
+		 * @note Streams without an internal buffer return an empty span.
+		 */
+		virtual RawBuffer peekSpan();
+
 		virtual bool write(uint8_t byte) = 0;
 		virtual ssize_t write(const void *bytes, const size_t& length) = 0;
 		virtual ssize_t write(const String& data);
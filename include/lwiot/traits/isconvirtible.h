@@ -11,6 +11,7 @@
 #include <lwiot/traits/isfunction.h>
 #include <lwiot/traits/issame.h>
 #include <lwiot/traits/isarray.h>
+#include <lwiot/traits/isreference.h>
 #include <lwiot/traits/isfunction.h>
 
 namespace lwiot
@@ -23,10 +23,15 @@ namespace lwiot { namespace traits
 	template <>
 	struct IsIntegral_helper<char32_t> : TrueType { };
 
+	template <>
+	struct IsIntegral_helper<wchar_t> : TrueType { };
+
 	/* Signed types */
 	template <>
 	struct IsIntegral_helper<char> : TrueType { };
 	template <>
+	struct IsIntegral_helper<signed char> : TrueType { };
+	template <>
 	struct IsIntegral_helper<short> : TrueType { };
 	template <>
 	struct IsIntegral_helper<int> : TrueType { };
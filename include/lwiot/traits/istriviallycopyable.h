@@ -0,0 +1,24 @@
+/*
+ * Trivially copyable type traits.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <lwiot/traits/integralconstant.h>
+
+namespace lwiot
+{
+	namespace traits
+	{
+		template <typename _Tp>
+		struct IsTriviallyCopyable : public IntegralConstant<bool, __is_trivially_copyable(_Tp)>
+		{ };
+
+		template <typename _Tp>
+		struct IsTriviallyDestructible : public IntegralConstant<bool, __has_trivial_destructor(_Tp)>
+		{ };
+	}
+}
@@ -23,30 +23,59 @@
 
 namespace lwiot
 {
+	/**
+	 * @brief Deleter that releases an object using \c delete.
+	 */
 	template<typename T>
-	class UniquePointer {
+	struct DefaultDelete {
+		constexpr DefaultDelete() noexcept = default;
+
+		template<typename U>
+		DefaultDelete(const DefaultDelete<U>&) noexcept
+		{
+		}
+
+		void operator()(T *p) const noexcept
+		{
+			delete p;
+		}
+	};
+
+	/**
+	 * @brief Pointer that owns an object and releases it when it goes out of scope.
+	 * @tparam T Object type.
+	 * @tparam D Deleter, a class type whose call operator takes a \p T pointer. It is stored
+	 *           as an empty base, so a deleter without state takes no space.
+	 */
+	template<typename T, typename D = DefaultDelete<T>>
+	class UniquePointer : private D {
 	public:
 		typedef T PointerType;
+		typedef D DeleterType;
+
+		constexpr UniquePointer() noexcept : D(), px(nullptr)
+		{
+		}
 
-		constexpr UniquePointer() noexcept : px(nullptr)
+		constexpr explicit UniquePointer(T *p) noexcept : D(), px(p)
 		{
 		}
 
-		constexpr explicit UniquePointer(T *p) noexcept : px(p)
+		constexpr explicit UniquePointer(T *p, const D& deleter) noexcept : D(deleter), px(p)
 		{
 		}
 
-		template<class U>
-		explicit UniquePointer(const UniquePointer<U> &ptr) = delete;
+		template<class U, class E>
+		explicit UniquePointer(const UniquePointer<U, E> &ptr) = delete;
 		UniquePointer(const UniquePointer &ptr) = delete;
 
-		UniquePointer(UniquePointer&& ptr) noexcept
+		UniquePointer(UniquePointer&& ptr) noexcept : D(stl::move(ptr.deleter()))
 		{
 			this->px = ptr.release();
 		}
 
-		template<class U>
-		explicit UniquePointer(UniquePointer<U> &&ptr) noexcept
+		template<class U, class E>
+		explicit UniquePointer(UniquePointer<U, E> &&ptr) noexcept : D(stl::move(ptr.deleter()))
 		{
 			this->px = ptr.release();
 		}
@@ -54,6 +83,8 @@ namespace lwiot
 		UniquePointer &operator=(UniquePointer ptr) noexcept
 		{
 			this->reset(ptr.release());
+			this->deleter() = stl::move(ptr.deleter());
+
 			return *this;
 		}
 
@@ -104,10 +135,21 @@ namespace lwiot
 			return px;
 		}
 
+		D& deleter() noexcept
+		{
+			return *this;
+		}
+
+		const D& deleter() const noexcept
+		{
+			return *this;
+		}
+
 		friend void swap(UniquePointer& a, UniquePointer& b)
 		{
 			using stl::swap;
 			swap(a.px, b.px);
+			swap(a.deleter(), b.deleter());
 		}
 
 	private:
@@ -116,46 +158,48 @@ namespace lwiot
 			if(px == nullptr)
 				return;
 
-			delete px;
+			auto p = px;
+
 			px = nullptr;
+			this->deleter()(p);
 		}
 
 	private:
 		PointerType* px;
 	};
 
-	template<class T, class U>
-	inline bool operator==(const UniquePointer <T> &l, const UniquePointer <U> &r) noexcept
+	template<class T, class D, class U, class E>
+	inline bool operator==(const UniquePointer <T, D> &l, const UniquePointer <U, E> &r) noexcept
 	{
 		return (l.get() == r.get());
 	}
 
-	template<class T, class U>
-	inline bool operator!=(const UniquePointer <T> &l, const UniquePointer <U> &r) noexcept
+	template<class T, class D, class U, class E>
+	inline bool operator!=(const UniquePointer <T, D> &l, const UniquePointer <U, E> &r) noexcept
 	{
 		return (l.get() != r.get());
 	}
 
-	template<class T, class U>
-	inline bool operator<=(const UniquePointer <T> &l, const UniquePointer <U> &r) noexcept
+	template<class T, class D, class U, class E>
+	inline bool operator<=(const UniquePointer <T, D> &l, const UniquePointer <U, E> &r) noexcept
 	{
 		return (l.get() <= r.get());
 	}
 
-	template<class T, class U>
-	inline bool operator<(const UniquePointer <T> &l, const UniquePointer <U> &r) noexcept
+	template<class T, class D, class U, class E>
+	inline bool operator<(const UniquePointer <T, D> &l, const UniquePointer <U, E> &r) noexcept
 	{
 		return (l.get() < r.get());
 	}
 
-	template<class T, class U>
-	inline bool operator>=(const UniquePointer <T> &l, const UniquePointer <U> &r) noexcept
+	template<class T, class D, class U, class E>
+	inline bool operator>=(const UniquePointer <T, D> &l, const UniquePointer <U, E> &r) noexcept
 	{
 		return (l.get() >= r.get());
 	}
 
-	template<class T, class U>
-	inline bool operator>(const UniquePointer <T> &l, const UniquePointer <U> &r) noexcept
+	template<class T, class D, class U, class E>
+	inline bool operator>(const UniquePointer <T, D> &l, const UniquePointer <U, E> &r) noexcept
 	{
 		return (l.get() > r.get());
 	}
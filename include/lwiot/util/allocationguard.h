@@ -0,0 +1,87 @@
+/*
+ * Allocation tracking for tests.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Counts the heap allocations that the calling thread makes while the guard exists.
+	 *
+	 * Allocations are only counted in builds with CONFIG_ALLOC_TRACKING, in which the port
+	 * reports every lwiot_mem_alloc(), lwiot_mem_zalloc(), lwiot_mem_realloc() and
+	 * lwiot_mem_free() call, and new and delete are routed through them. Without it, every
+	 * count is 0 and enabled() returns false. Only the hosted Unix port reports allocations.
+	 *
+	 * Counts are kept per thread, so work done by other threads does not show up. Guards can
+	 * be nested.
+	 *
+	 * @code
+	 * lwiot::ScopedAllocationGuard guard;
+	 *
+	 * client.loop();
+	 * assert(guard.ok());
+	 * @endcode
+	 */
+	class ScopedAllocationGuard {
+	public:
+		/**
+		 * @brief Start counting.
+		 * @param limit Number of bytes the guarded code may allocate. With the default of 0
+		 *              the code may not allocate at all.
+		 */
+		explicit ScopedAllocationGuard(size_t limit = 0);
+		~ScopedAllocationGuard() = default;
+
+		ScopedAllocationGuard(const ScopedAllocationGuard&) = delete;
+		ScopedAllocationGuard& operator=(const ScopedAllocationGuard&) = delete;
+
+		size_t allocations() const;
+		size_t frees() const;
+
+		/**
+		 * @brief Number of bytes requested by the allocations, regardless of frees.
+		 */
+		size_t bytes() const;
+
+		/**
+		 * @brief Check whether the guarded code stayed within the limit.
+		 * @return True if nothing was allocated, or if no more than the limit of bytes was
+		 *         allocated when the limit is not 0.
+		 */
+		bool ok() const;
+
+		/**
+		 * @brief Start counting again from 0.
+		 */
+		void reset();
+
+		/**
+		 * @brief Check whether allocations are counted in this build.
+		 */
+		static constexpr bool enabled()
+		{
+#ifdef CONFIG_ALLOC_TRACKING
+			return true;
+#else
+			return false;
+#endif
+		}
+
+	private:
+		size_t _limit;
+		size_t _allocations;
+		size_t _frees;
+		size_t _bytes;
+	};
+}
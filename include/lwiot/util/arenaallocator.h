@@ -0,0 +1,169 @@
+/*
+ * Monotonic arena allocator.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <lwiot.h>
+
+#ifdef CXX
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <lwiot/stl/move.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Bump pointer memory arena.
+	 *
+	 * Memory is handed out sequentially from one or more blocks and is never freed individually. A
+	 * call to reset() releases everything at once. Objects created using create() are destroyed on
+	 * reset(), in reverse order of creation.
+	 *
+	 * After a reset the arena keeps a single block that is large enough for the peak usage seen so far,
+	 * so a steady state workload does not touch the heap.
+	 */
+	class Arena {
+	public:
+		static constexpr size_t DefaultBlockSize = 256;
+
+		explicit Arena(size_t blocksize = DefaultBlockSize);
+		explicit Arena(void *buffer, size_t size);
+		virtual ~Arena();
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		void *allocate(size_t size, size_t alignment = alignof(max_align_t));
+		void reset();
+
+		size_t used() const;
+		size_t capacity() const;
+
+		/**
+		 * @brief Allocate and default construct \p num objects.
+		 * @tparam T Object type.
+		 * @param num Number of objects to create.
+		 * @return A pointer to the first object or \p nullptr when out of memory.
+		 * @note The objects are destroyed when the arena is reset.
+		 */
+		template <typename T>
+		T *create(size_t num = 1)
+		{
+			auto fin = static_cast<Finalizer*>(this->allocate(sizeof(Finalizer), alignof(Finalizer)));
+			auto objs = static_cast<T*>(this->allocate(sizeof(T) * num, alignof(T)));
+
+			if(fin == nullptr || objs == nullptr)
+				return nullptr;
+
+			for(size_t idx = 0; idx < num; idx++)
+				new(&objs[idx]) T();
+
+			fin->destroy = &Arena::destroy<T>;
+			fin->data = objs;
+			fin->num = num;
+			fin->next = this->_finalizers;
+			this->_finalizers = fin;
+
+			return objs;
+		}
+
+	private:
+		struct Block {
+			Block *next;
+			size_t size;
+			size_t used;
+		};
+
+		struct Finalizer {
+			void (*destroy)(void *data, size_t num);
+			void *data;
+			size_t num;
+			Finalizer *next;
+		};
+
+		Block *_head;
+		Block *_external;
+		Finalizer *_finalizers;
+		size_t _blocksize;
+
+		/* Methods */
+		void *allocate(Block *block, size_t size, size_t alignment);
+		Block *allocateBlock(size_t size);
+		void release();
+
+		template <typename T>
+		static void destroy(void *data, size_t num)
+		{
+			auto objs = static_cast<T*>(data);
+
+			for(size_t idx = num; idx > 0; idx--)
+				objs[idx - 1].~T();
+		}
+	};
+
+	/**
+	 * @brief Allocator adapter for Arena.
+	 * @tparam T Object type.
+	 *
+	 * Deallocation is a no-op, memory is returned when the arena is reset.
+	 */
+	template <typename T>
+	struct ArenaAllocator {
+	public:
+		typedef T ObjectType;
+
+		template <typename U>
+		struct rebind {
+			typedef ArenaAllocator<U> other;
+		};
+
+		explicit ArenaAllocator(Arena& arena) : _arena(&arena)
+		{
+		}
+
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) : _arena(other.arena())
+		{
+		}
+
+		ObjectType* allocate(size_t num) const noexcept
+		{
+			auto data = this->_arena->allocate(num * sizeof(ObjectType), alignof(ObjectType));
+			return reinterpret_cast<ObjectType*>(data);
+		}
+
+		void deallocate(ObjectType* obj, size_t num) const noexcept
+		{
+		}
+
+		CONSTEXPR void move(ObjectType *obj, ObjectType& t)
+		{
+			new(obj) ObjectType(stl::move(t));
+		}
+
+		CONSTEXPR void construct(ObjectType *obj, const ObjectType& t) const
+		{
+			new(obj) ObjectType(t);
+		}
+
+		CONSTEXPR void destroy(ObjectType* obj) const
+		{
+			obj->~ObjectType();
+		}
+
+		Arena *arena() const
+		{
+			return this->_arena;
+		}
+
+	private:
+		Arena *_arena;
+	};
+}
+#endif
@@ -0,0 +1,180 @@
+/*
+ * CBOR encoder and decoder.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/traits/enableif.h>
+#include <lwiot/traits/isintegral.h>
+#include <lwiot/traits/issame.h>
+
+#ifndef CONFIG_CBOR_NESTING
+#define CONFIG_CBOR_NESTING 16
+#endif
+
+namespace lwiot
+{
+	class SampleBatch;
+
+	/**
+	 * @brief Streaming CBOR (RFC 7049) encoder.
+	 *
+	 * Items are appended to a ByteBuffer as they are written, no document is built in memory.
+	 * Arrays and maps either get their number of items up front, or are left open by
+	 * beginArray() or beginMap() and closed by end(). A map entry is a key followed by its value.
+	 * Floating point values are written in single precision when that does not lose anything.
+	 */
+	class CborWriter {
+	public:
+		explicit CborWriter(ByteBuffer& output);
+
+		CborWriter& beginArray(size_t size);
+		CborWriter& beginMap(size_t size);
+		CborWriter& beginArray();
+		CborWriter& beginMap();
+		CborWriter& end();
+
+		template <typename T>
+		traits::EnableIf_t<traits::IsIntegral<T>::value && !traits::IsSame<T, bool>::value, CborWriter&> write(T value)
+		{
+			auto number = static_cast<int64_t>(value);
+
+			if(T(-1) < T(0) && number < 0)
+				return this->head(Negative, static_cast<uint64_t>(-1 - number));
+
+			return this->head(Unsigned, static_cast<uint64_t>(value));
+		}
+
+		CborWriter& write(bool value);
+		CborWriter& write(float value);
+		CborWriter& write(double value);
+		CborWriter& write(const char *value);
+		CborWriter& write(const StringView& value);
+		CborWriter& write(const String& value);
+		CborWriter& writeBytes(const void *data, size_t length);
+		CborWriter& writeNull();
+
+		/**
+		 * @brief Write a sample batch as one map.
+		 *
+		 * The map holds the time of the first sample ("t"), the offsets of all samples from it in
+		 * milliseconds ("dt"), and the sensor identifiers ("s") and values ("v") as arrays.
+		 */
+		CborWriter& write(const SampleBatch& batch);
+
+		/**
+		 * @brief Write a map entry.
+		 */
+		template <typename T>
+		CborWriter& member(const StringView& key, const T& value)
+		{
+			this->write(key);
+			return this->write(value);
+		}
+
+	private:
+		enum Major : uint8_t {
+			Unsigned,
+			Negative,
+			Bytes,
+			Text,
+			Array,
+			Map,
+			Tag,
+			Simple
+		};
+
+		ByteBuffer& _output;
+
+		CborWriter& head(uint8_t major, uint64_t value);
+		uint8_t *reserve(size_t length);
+	};
+
+	/**
+	 * @brief Pull parser for CBOR data.
+	 *
+	 * Every call to next() decodes one data item. The items of an array or map follow its header;
+	 * an array or map of indefinite length ends with a Break item. Strings are returned as a view
+	 * on the input, nothing is copied or allocated. Strings of indefinite length are not
+	 * supported.
+	 */
+	class CborReader {
+	public:
+		enum class Type : uint8_t {
+			Unsigned,
+			Negative,
+			Bytes,
+			Text,
+			Array,
+			Map,
+			Tag,
+			Bool,
+			Null,
+			Undefined,
+			Float,
+			Break
+		};
+
+		struct Item {
+			Type type;
+			bool indefinite;
+
+			/* Integer, -1 - negative integer, string length, number of items, tag or boolean. */
+			uint64_t value;
+			double number;
+			const uint8_t *data;
+
+			int64_t integer() const
+			{
+				return this->type == Type::Negative ? -1 - static_cast<int64_t>(this->value) :
+					static_cast<int64_t>(this->value);
+			}
+
+			StringView text() const
+			{
+				return StringView(reinterpret_cast<const char *>(this->data), static_cast<size_t>(this->value));
+			}
+		};
+
+		explicit CborReader(const void *data, size_t length);
+
+		/**
+		 * @brief Decode the next item.
+		 * @return False at the end of the input or if the input is malformed.
+		 */
+		bool next(Item& item);
+
+		/**
+		 * @brief Skip the items in the array, map or tag \p item.
+		 */
+		bool skip(const Item& item, size_t depth = 0);
+
+		bool done() const
+		{
+			return this->_pos == this->_length;
+		}
+
+		size_t position() const
+		{
+			return this->_pos;
+		}
+
+	private:
+		const uint8_t *_data;
+		size_t _length;
+		size_t _pos;
+
+		bool argument(uint8_t info, uint64_t& value);
+	};
+}
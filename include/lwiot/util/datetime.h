@@ -13,6 +13,7 @@
 
 #include <lwiot/types.h>
 #include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
 
 namespace lwiot
 {
@@ -39,7 +40,50 @@ namespace lwiot
 
 		static DateTime now();
 
+		/**
+		 * @brief Length of an ISO 8601 time stamp with milliseconds, including the terminator.
+		 */
+		static constexpr size_t IsoBufferSize = 25;
+
+		/**
+		 * @brief Number of days between 1970-01-01 and a date, in constant time.
+		 * @param year Year.
+		 * @param month Month, starting at 1.
+		 * @param day Day of the month, starting at 1.
+		 */
+		static int64_t daysFromCivil(int64_t year, int month, int day);
+
+		/**
+		 * @brief Date that lies \p days after 1970-01-01, in constant time.
+		 * @see daysFromCivil()
+		 */
+		static void civilFromDays(int64_t days, int64_t& year, int& month, int& day);
+
+		/**
+		 * @brief Write \p seconds as <tt>YYYY-MM-DDTHH:MM:SSZ</tt>, or with the milliseconds as
+		 *        <tt>YYYY-MM-DDTHH:MM:SS.mmmZ</tt>.
+		 * @param output Buffer of at least IsoBufferSize bytes.
+		 * @param seconds UNIX time in seconds, between the years 0 and 9999.
+		 * @param milliseconds Milliseconds, or a negative number to leave them out.
+		 * @return The length of the time stamp.
+		 */
+		static size_t formatIso(char *output, time_t seconds, int milliseconds = -1);
+
+		/**
+		 * @brief Parse an ISO 8601 time stamp, such as <tt>2020-09-13T12:26:40.5+02:00</tt>.
+		 *
+		 * The date and time are required, seconds and their fraction are optional. The separator
+		 * may be a space. Without an offset the time is taken to be UTC.
+		 *
+		 * @param text Time stamp.
+		 * @param seconds UNIX time in seconds.
+		 * @param milliseconds Milliseconds, if not \c nullptr.
+		 * @return False if \p text is not a time stamp.
+		 */
+		static bool parseIso(const StringView& text, time_t& seconds, int *milliseconds = nullptr);
+
 		String toString() const;
+		String toIsoString() const;
 		void sync(const time_t& value);
 		void update();
 
@@ -76,9 +120,33 @@ namespace lwiot
 	private:
 		time_t stamp;
 		mutable struct tm gmt;
+		mutable int64_t gmt_day; /* Day for which the date in gmt is valid. */
 
 		/* Methods */
 		void updateGmt() const;
 		int compare(const time_t& other) const;
 	};
+
+	/**
+	 * @brief ISO 8601 formatter for increasing time stamps, such as those of log lines.
+	 *
+	 * The date is only written when the day changes, and the time when the second changes, so
+	 * that most time stamps only take writing the milliseconds.
+	 */
+	class IsoFormatter {
+	public:
+		explicit IsoFormatter();
+
+		/**
+		 * @brief Format \p milliseconds since the UNIX epoch.
+		 * @return The time stamp, which is valid until the next call.
+		 * @see DateTime::formatIso()
+		 */
+		const char *format(int64_t milliseconds);
+
+	private:
+		char _buffer[DateTime::IsoBufferSize];
+		int64_t _day;
+		int64_t _second;
+	};
 }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <lwiot.h>
+#include <lwiot/heap.h>
 
 #ifdef CXX
 
@@ -20,12 +21,17 @@ namespace lwiot
 	public:
 		typedef T ObjectType;
 
+		template <typename U>
+		struct rebind {
+			typedef DefaultAllocator<U> other;
+		};
+
 		explicit CONSTEXPR DefaultAllocator() = default;
 		virtual ~DefaultAllocator() = default;
 
 		ObjectType* allocate(size_t bytes) const noexcept
 		{
-			auto data = lwiot_mem_alloc(bytes * sizeof(ObjectType));
+			auto data = lwiot_heap_alloc(bytes * sizeof(ObjectType), LWIOT_HEAP_TAG_STL);
 			return reinterpret_cast<ObjectType*>(data);
 		}
 
@@ -34,13 +40,12 @@ namespace lwiot
 			if(obj == nullptr || bytes == 0UL)
 				return;
 
-			lwiot_mem_free(obj);
+			lwiot_heap_free(obj);
 		}
 
 		CONSTEXPR void move(ObjectType *obj, ObjectType& t)
 		{
-			new(obj) ObjectType();
-			*obj = stl::move(t);
+			new(obj) ObjectType(stl::move(t));
 		}
 
 		CONSTEXPR void construct(ObjectType *obj, const ObjectType& t) const
@@ -0,0 +1,170 @@
+/*
+ * Signal processing kernels for blocks of samples.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/util/samplebatch.h>
+
+namespace lwiot
+{
+	namespace dsp
+	{
+		/**
+		 * @brief Convert raw ADC samples to (sample - offset) * scale.
+		 */
+		void convert(const uint16_t *in, float *out, size_t length, float offset, float scale);
+
+		float mean(const float *data, size_t length);
+		float rms(const float *data, size_t length);
+		float peak(const float *data, size_t length); //!< Largest absolute value.
+
+		/*
+		 * The batch versions run over the value array of a batch. The batch should hold the
+		 * samples of a single sensor, or the values of several sensors are mixed.
+		 */
+		inline float mean(const SampleBatch& batch)
+		{
+			return mean(batch.values(), batch.size());
+		}
+
+		inline float rms(const SampleBatch& batch)
+		{
+			return rms(batch.values(), batch.size());
+		}
+
+		inline float peak(const SampleBatch& batch)
+		{
+			return peak(batch.values(), batch.size());
+		}
+
+		/**
+		 * @brief Finite impulse response filter.
+		 *
+		 * The delay line is stored twice in a row, so that the newest N samples are always
+		 * contiguous and every output is a single dot product.
+		 */
+		class Fir {
+		public:
+			explicit Fir(const float *taps, size_t length);
+			explicit Fir(const stl::Vector<float>& taps);
+
+			void reset();
+
+			/**
+			 * @brief Filter \p length samples. \p in and \p out may be the same buffer.
+			 */
+			void process(const float *in, float *out, size_t length);
+
+			/**
+			 * @brief Filter the values of \p batch in place.
+			 */
+			void process(SampleBatch& batch)
+			{
+				this->process(batch.values(), batch.values(), batch.size());
+			}
+
+			/**
+			 * @brief Filter and keep every \p factor -th output.
+			 * @return The number of samples written to \p out.
+			 */
+			size_t decimate(const float *in, float *out, size_t length, size_t factor);
+
+			/**
+			 * @brief Moving average filter of \p length taps.
+			 */
+			static Fir average(size_t length);
+
+		private:
+			stl::Vector<float> _taps;
+			stl::Vector<float> _delay;
+			size_t _pos;
+			size_t _phase;
+
+			float step(float sample);
+		};
+
+		/**
+		 * @brief Second order IIR section (transposed direct form II).
+		 *
+		 * The factories compute the coefficients of the RBJ audio EQ cookbook filters; \p fs is the
+		 * sample rate and \p f0 the corner or centre frequency, both in Hz.
+		 */
+		class Biquad {
+		public:
+			explicit Biquad(float b0 = 1.0f, float b1 = 0.0f, float b2 = 0.0f, float a1 = 0.0f, float a2 = 0.0f);
+
+			void reset();
+			void process(const float *in, float *out, size_t length);
+			float process(float sample);
+
+			/**
+			 * @brief Filter the values of \p batch in place.
+			 */
+			void process(SampleBatch& batch)
+			{
+				this->process(batch.values(), batch.values(), batch.size());
+			}
+
+			static Biquad lowpass(float fs, float f0, float q = 0.7071f);
+			static Biquad highpass(float fs, float f0, float q = 0.7071f);
+			static Biquad bandpass(float fs, float f0, float q);
+			static Biquad notch(float fs, float f0, float q);
+
+		private:
+			float _b0, _b1, _b2;
+			float _a1, _a2;
+			float _z1, _z2;
+		};
+
+		/**
+		 * @brief In place radix-2 FFT.
+		 * @param re Real parts.
+		 * @param im Imaginary parts, zeroes for a real signal.
+		 * @param length Number of points, a power of two.
+		 * @return False if \p length is not a power of two.
+		 */
+		bool fft(float *re, float *im, size_t length);
+
+		/**
+		 * @brief Magnitude of the first \p length bins of an FFT result.
+		 */
+		void magnitude(const float *re, const float *im, float *out, size_t length);
+
+		/**
+		 * @brief Detect a single frequency in a block of samples.
+		 *
+		 * Computes one DFT bin in O(N) without storing the block, which is cheaper than an FFT
+		 * when only a few frequencies are of interest.
+		 */
+		class Goertzel {
+		public:
+			explicit Goertzel(float fs, float frequency, size_t length);
+
+			/**
+			 * @brief Squared magnitude of the bin in \p data, which holds length() samples.
+			 */
+			float power(const float *data) const;
+
+			/**
+			 * @brief Amplitude of a sine at the bin frequency.
+			 */
+			float amplitude(const float *data) const;
+
+			size_t length() const;
+
+		private:
+			float _coeff;
+			size_t _length;
+		};
+	}
+}
@@ -8,38 +8,99 @@
 #pragma once
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <assert.h>
 #include <lwiot.h>
 
 #include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
 #include <lwiot/log.h>
 
 namespace lwiot
 {
+	/**
+	 * @brief RFC 4122 GUID.
+	 *
+	 * Random GUIDs (version 4) are taken from the hardware random number generator of the port,
+	 * if it has one (HAVE_RANDOM_BYTES). Otherwise they are hashed from a seeded counter, which
+	 * takes a few multiplications per GUID.
+	 *
+	 * Time ordered GUIDs (version 7) start with the creation time in milliseconds since the
+	 * epoch, so they sort in creation order. Used as keys they are appended at the end of an
+	 * index, instead of at random places.
+	 *
+	 * formatTo() and parse() use lookup tables and do not allocate.
+	 */
 	class Guid {
 	public:
+		static constexpr int GUID_SIZE = 16;
+		static constexpr size_t STRING_LENGTH = 36; //!< Length of the text form, excluding the terminator.
+
+		/**
+		 * @brief Create a random (version 4) GUID.
+		 */
 		explicit Guid();
+		explicit Guid(const uint8_t *bytes);
 		Guid(const Guid& other);
 		Guid(Guid&& other) noexcept;
 
 		Guid& operator=(const Guid& rhs);
 		Guid& operator=(Guid&& rhs) noexcept;
 
-		bool operator==(const Guid& other);
-		bool operator==(const String& str);
-		bool operator!=(const Guid& other);
-		bool operator!=(const String& other);
+		bool operator==(const Guid& other) const;
+		bool operator==(const StringView& str) const;
+		bool operator!=(const Guid& other) const;
+		bool operator!=(const StringView& other) const;
+		bool operator<(const Guid& other) const;
+
+		/**
+		 * @brief Create a random (version 4) GUID.
+		 */
+		static Guid v4();
+
+		/**
+		 * @brief Create a time ordered (version 7) GUID, using the wall clock.
+		 *
+		 * GUIDs created by this function sort in the order in which they were created, also when
+		 * several are created within the same millisecond.
+		 */
+		static Guid v7();
+
+		/**
+		 * @brief Create a time ordered (version 7) GUID for time \p ms.
+		 * @param ms Milliseconds since the epoch.
+		 */
+		static Guid v7(int64_t ms);
 
+		/**
+		 * @brief Parse the text form of a GUID, such as \c 3f2504e0-4f89-41d3-9a0c-0305e82c3301.
+		 * @param text Text to parse; upper and lower case digits are accepted.
+		 * @param guid Parsed GUID.
+		 * @return False if \p text is not a GUID.
+		 */
+		static bool parse(const StringView& text, Guid& guid);
+
+		/**
+		 * @brief Write the text form of the GUID.
+		 * @param output Buffer of at least STRING_LENGTH + 1 bytes.
+		 * @return \p output, terminated by a 0 byte.
+		 */
+		char *formatTo(char *output) const;
 		String toString() const;
 
-		static constexpr int GUID_SIZE = 16;
+		int version() const;
+
+		/**
+		 * @brief Creation time of a version 7 GUID.
+		 * @return Milliseconds since the epoch, or -1 for other versions.
+		 */
+		int64_t timestamp() const;
+
+		const uint8_t *bytes() const;
 
 	private:
 		uint8_t _bytes[GUID_SIZE];
 
-		/* Methods */
-		uint8_t random() const;
-		uint8_t randomBit() const;
-		uint8_t improveRandomBit() const;
+		void stamp(int64_t ms, uint16_t counter);
 	};
 }
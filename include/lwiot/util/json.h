@@ -8,13 +8,71 @@
 #pragma once
 
 #include <ArduinoJson.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/util/arenaallocator.h>
+#include <lwiot/util/cbor.h>
 
 namespace lwiot
 {
+	class SampleBatch;
+
 	template<size_t T>
 	using StaticJsonBuffer = ArduinoJson::StaticJsonBuffer<T>;
 
 	typedef ArduinoJson::JsonArray JsonArray;
 	typedef ArduinoJson::JsonObject JsonObject;
 	typedef ArduinoJson::DynamicJsonBuffer DynamicJsonBuffer;
+	typedef ArduinoJson::JsonVariant JsonVariant;
+	typedef ArduinoJson::JsonBuffer JsonBuffer;
+
+	/**
+	 * @brief JSON buffer that takes its memory from an Arena.
+	 *
+	 * Parsed documents stay valid until the arena is reset.
+	 */
+	class ArenaJsonBuffer : public ArduinoJson::JsonBuffer {
+	public:
+		explicit ArenaJsonBuffer(Arena& arena) : _arena(arena)
+		{
+		}
+
+		void *alloc(size_t bytes) override
+		{
+			return this->_arena.allocate(bytes, sizeof(void*));
+		}
+
+	private:
+		Arena& _arena;
+	};
+
+	/**
+	 * @brief Write a JSON document as CBOR.
+	 *
+	 * Numbers that are neither integers nor floating point values, such as the unparsed literal
+	 * null, are written as CBOR null.
+	 */
+	extern void serializeCbor(const JsonVariant& variant, CborWriter& writer);
+	extern void serializeCbor(const JsonVariant& variant, ByteBuffer& output);
+
+	/**
+	 * @brief Build a JSON document from CBOR data.
+	 *
+	 * Strings and keys are copied into \p buffer, \p data can be released afterwards. Byte strings
+	 * and undefined become null, tags are dropped. Map keys must be text strings.
+	 *
+	 * @return True if \p data holds exactly one well formed item.
+	 */
+	extern bool parseCbor(JsonBuffer& buffer, const void *data, size_t length, JsonVariant& result);
+
+	/**
+	 * @brief Append a sample batch to \p output as a JSON object.
+	 *
+	 * The object has the layout of CborWriter::write(const SampleBatch&):
+	 * <tt>{"t":1000,"dt":[0,10],"s":[1,1],"v":[20.5,20.6]}</tt>. The text is written directly,
+	 * without building a document. Values that are not finite are written as null.
+	 *
+	 * @param precision Number of decimals of the values.
+	 * @return The number of bytes appended.
+	 */
+	extern size_t serializeJson(const SampleBatch& batch, ByteBuffer& output, uint8_t precision = 3);
 }
@@ -0,0 +1,167 @@
+/*
+ * Streaming JSON reader.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stream.h>
+#include <lwiot/function.h>
+#include <lwiot/stl/stringview.h>
+
+#ifndef CONFIG_JSON_READER_BUFFER
+#define CONFIG_JSON_READER_BUFFER 64
+#endif
+
+#ifndef CONFIG_JSON_READER_TOKEN
+#define CONFIG_JSON_READER_TOKEN 64
+#endif
+
+#ifndef CONFIG_JSON_READER_PATH
+#define CONFIG_JSON_READER_PATH 128
+#endif
+
+#ifndef CONFIG_JSON_READER_NESTING
+#define CONFIG_JSON_READER_NESTING 16
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Pull parser for JSON documents that are read from a Stream.
+	 *
+	 * Unlike a JsonBuffer, the reader never holds the whole document: it reads the stream in small
+	 * pieces and every call to next() returns one event. Memory use is fixed and set by the
+	 * CONFIG_JSON_READER_* options. Strings and numbers are available until the next event; a
+	 * string that is longer than CONFIG_JSON_READER_TOKEN is cut off, which truncated() reports.
+	 * The reader stops at the end of the first document. It reads no more than the stream has
+	 * available, so it does not wait for data after the document, but it may consume some.
+	 *
+	 * The location of the current value can be compared with a path, such as
+	 * <tt>$.sensors[*].id</tt>. A path is made of <tt>.name</tt>, <tt>[index]</tt> and the
+	 * wildcards <tt>.*</tt> and <tt>[*]</tt>:
+	 *
+	 * @code
+	 * JsonReader reader(client);
+	 *
+	 * reader.select("$.sensors[*].id", [](JsonReader& json, JsonReader::Event event) {
+	 *     print_dbg("Sensor: %s\n", json.string().data());
+	 *     return true;
+	 * });
+	 * @endcode
+	 */
+	class JsonReader {
+	public:
+		enum class Event : uint8_t {
+			BeginObject,
+			EndObject,
+			BeginArray,
+			EndArray,
+			String,
+			Number,
+			Bool,
+			Null,
+			End,
+			Error
+		};
+
+		/**
+		 * @brief Selection callback.
+		 * @return False to stop reading.
+		 */
+		typedef Function<bool(JsonReader& reader, Event event)> Visitor;
+
+		explicit JsonReader(Stream& input);
+
+		/**
+		 * @brief Read a document that is already in memory, such as an MQTT payload.
+		 */
+		explicit JsonReader(const void *json, size_t length);
+
+		JsonReader(const JsonReader&) = delete;
+		JsonReader& operator=(const JsonReader&) = delete;
+
+		/**
+		 * @brief Read the next event.
+		 * @return End after the document, Error if it is malformed or nested too deep.
+		 */
+		Event next();
+
+		/**
+		 * @brief Skip the contents of the object or array that was just opened.
+		 * @return False if the document ended or is malformed.
+		 */
+		bool skip();
+
+		/**
+		 * @brief Read the rest of the document, and call \p visitor for every value at \p path.
+		 * @return The number of values visited, or -EINVALID if the document is malformed.
+		 */
+		ssize_t select(const StringView& path, const Visitor& visitor);
+
+		/**
+		 * @brief Check whether the current value is located at \p path.
+		 */
+		bool matches(const StringView& path) const;
+
+		StringView key() const; //!< Name of the current value in its object, or empty.
+		size_t index() const; //!< Index of the current value in its array.
+		size_t depth() const; //!< Number of enclosing objects and arrays.
+
+		StringView string() const; //!< Text of the current string, or of the current number.
+		double number() const;
+		int64_t integer() const;
+		bool boolean() const;
+
+		bool truncated() const
+		{
+			return this->_truncated;
+		}
+
+	private:
+		struct Level {
+			uint16_t key;
+			uint16_t length;
+			uint32_t index;
+			bool array;
+		};
+
+		Stream *_input;
+		const char *_data;
+		char _buffer[CONFIG_JSON_READER_BUFFER];
+		size_t _pos;
+		size_t _length;
+
+		char _token[CONFIG_JSON_READER_TOKEN + 1];
+		size_t _token_length;
+		char _path[CONFIG_JSON_READER_PATH];
+		Level _levels[CONFIG_JSON_READER_NESTING];
+		size_t _depth;
+
+		Event _pending;
+		bool _first;
+		bool _started;
+		bool _error;
+		bool _truncated;
+
+		int peek();
+		int get();
+		int space();
+
+		Event fail();
+		Event value();
+		bool key(Level& level);
+		bool string(char *output, size_t capacity, size_t& length);
+		bool escape(char *output, size_t capacity, size_t& length);
+		void append(char *output, size_t capacity, size_t& length, char c);
+		bool literal(const char *text);
+		bool hex(uint32_t& value);
+	};
+}
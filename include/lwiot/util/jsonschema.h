@@ -0,0 +1,277 @@
+/*
+ * Compiled JSON bindings for plain structures.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stream.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/util/jsonreader.h>
+
+#include <ArduinoJson/Arduino/Printer.hpp>
+
+namespace lwiot
+{
+	class JsonSchema;
+
+	namespace detail
+	{
+		/* FNV-1a, usable in constant expressions. */
+		constexpr uint32_t json_hash(const char *str, uint32_t hash = 2166136261U)
+		{
+			return *str == '\0' ? hash : json_hash(str + 1, (hash ^ static_cast<uint8_t>(*str)) * 16777619U);
+		}
+
+		template <typename T>
+		const JsonSchema& json_schema_of()
+		{
+			return jsonSchemaOf(static_cast<const T *>(nullptr));
+		}
+	}
+
+	/**
+	 * @brief Field table of a structure, that reads and writes it as a JSON object.
+	 *
+	 * A schema is declared once for a structure, using LWIOT_JSON_SCHEMA() and LWIOT_JSON_FIELD(),
+	 * in the namespace of the structure:
+	 *
+	 * @code
+	 * struct Reading {
+	 *     uint32_t id;
+	 *     double value;
+	 *     char unit[8];
+	 *     float history[4];
+	 * };
+	 *
+	 * LWIOT_JSON_SCHEMA(Reading,
+	 *     LWIOT_JSON_FIELD(Reading, id),
+	 *     LWIOT_JSON_FIELD(Reading, value),
+	 *     LWIOT_JSON_FIELD(Reading, unit),
+	 *     LWIOT_JSON_FIELD(Reading, history)
+	 * )
+	 *
+	 * Reading reading;
+	 * lwiot::readJson(client, reading);
+	 * lwiot::writeJson(client, reading);
+	 * @endcode
+	 *
+	 * The table, including the hashes of the keys, is built by the compiler. Values are read from
+	 * a JsonReader and stored in the fields directly, so no document is built in memory. Supported
+	 * fields are booleans, integers, floating point numbers, character arrays, structures that have
+	 * a schema themselves, and fixed size arrays of those.
+	 *
+	 * Unknown keys are skipped, and fields that are missing or null are left as they are. Strings
+	 * that do not fit are cut off. A value of the wrong type makes reading fail.
+	 */
+	class JsonSchema {
+	public:
+		enum class Type : uint8_t {
+			Bool,
+			Signed,
+			Unsigned,
+			Float,
+			String,
+			Object
+		};
+
+		struct Field {
+			const char *name;
+			uint32_t hash;
+			Type type;
+			size_t width; //!< Size of a single value.
+			size_t count; //!< Number of values in an array, 0 for a single value.
+			size_t offset;
+			const JsonSchema& (*schema)();
+		};
+
+		template <typename T>
+		struct Traits;
+
+		constexpr JsonSchema(const Field *fields, size_t count) : _fields(fields), _count(count)
+		{
+		}
+
+		template <typename T>
+		static constexpr Field field(const char *name, size_t offset)
+		{
+			return Field{ name, detail::json_hash(name), Traits<T>::type, Traits<T>::width, Traits<T>::count, offset,
+			              Traits<T>::schema() };
+		}
+
+		/**
+		 * @brief Read an object into \p object.
+		 * @param reader Reader to take the object from.
+		 * @param object Structure to store the values in.
+		 * @param begin False if the reader has already returned the start of the object.
+		 */
+		bool read(JsonReader& reader, void *object, bool begin = true) const;
+
+		/**
+		 * @brief Write \p object as a JSON object.
+		 * @return The number of bytes written.
+		 */
+		size_t write(json::Printer& output, const void *object) const;
+
+		const Field *find(const StringView& key) const;
+
+		size_t size() const
+		{
+			return this->_count;
+		}
+
+	private:
+		const Field *_fields;
+		size_t _count;
+	};
+
+	template <typename T>
+	struct JsonSchema::Traits {
+		static constexpr Type type = Type::Object;
+		static constexpr size_t width = sizeof(T);
+		static constexpr size_t count = 0;
+
+		static constexpr const JsonSchema& (*schema())()
+		{
+			return &detail::json_schema_of<T>;
+		}
+	};
+
+	template <typename T, size_t N>
+	struct JsonSchema::Traits<T[N]> {
+		static constexpr Type type = Traits<T>::type;
+		static constexpr size_t width = sizeof(T);
+		static constexpr size_t count = N;
+
+		static constexpr const JsonSchema& (*schema())()
+		{
+			return Traits<T>::schema();
+		}
+	};
+
+	template <size_t N>
+	struct JsonSchema::Traits<char[N]> {
+		static constexpr Type type = Type::String;
+		static constexpr size_t width = N;
+		static constexpr size_t count = 0;
+
+		static constexpr const JsonSchema& (*schema())()
+		{
+			return nullptr;
+		}
+	};
+
+#define LWIOT_JSON_TRAITS(__type, __kind) \
+	template <> \
+	struct JsonSchema::Traits<__type> { \
+		static constexpr Type type = Type::__kind; \
+		static constexpr size_t width = sizeof(__type); \
+		static constexpr size_t count = 0; \
+		static constexpr const JsonSchema& (*schema())() \
+		{ \
+			return nullptr; \
+		} \
+	};
+
+	LWIOT_JSON_TRAITS(bool, Bool)
+	LWIOT_JSON_TRAITS(char, Signed)
+	LWIOT_JSON_TRAITS(signed char, Signed)
+	LWIOT_JSON_TRAITS(short, Signed)
+	LWIOT_JSON_TRAITS(int, Signed)
+	LWIOT_JSON_TRAITS(long, Signed)
+	LWIOT_JSON_TRAITS(long long, Signed)
+	LWIOT_JSON_TRAITS(unsigned char, Unsigned)
+	LWIOT_JSON_TRAITS(unsigned short, Unsigned)
+	LWIOT_JSON_TRAITS(unsigned int, Unsigned)
+	LWIOT_JSON_TRAITS(unsigned long, Unsigned)
+	LWIOT_JSON_TRAITS(unsigned long long, Unsigned)
+	LWIOT_JSON_TRAITS(float, Float)
+	LWIOT_JSON_TRAITS(double, Float)
+
+#undef LWIOT_JSON_TRAITS
+
+	/**
+	 * @brief Read a JSON object into \p object, using the schema of \p T.
+	 * @return False if the document is malformed or does not match the schema.
+	 */
+	template <typename T>
+	bool readJson(JsonReader& reader, T& object)
+	{
+		return detail::json_schema_of<T>().read(reader, &object);
+	}
+
+	template <typename T>
+	bool readJson(Stream& input, T& object)
+	{
+		JsonReader reader(input);
+		return readJson(reader, object);
+	}
+
+	template <typename T>
+	bool readJson(const void *json, size_t length, T& object)
+	{
+		JsonReader reader(json, length);
+		return readJson(reader, object);
+	}
+
+	/**
+	 * @brief Write \p object as a JSON object, using the schema of \p T.
+	 * @return The number of bytes written.
+	 */
+	template <typename T>
+	size_t writeJson(json::Printer& output, const T& object)
+	{
+		return detail::json_schema_of<T>().write(output, &object);
+	}
+
+	/**
+	 * @brief Write \p object to \p output through a small buffer.
+	 * @return The number of bytes written, or 0 if \p output did not take all of them.
+	 */
+	extern size_t writeJson(Stream& output, const JsonSchema& schema, const void *object);
+	extern size_t writeJson(String& output, const JsonSchema& schema, const void *object);
+
+	template <typename T>
+	size_t writeJson(Stream& output, const T& object)
+	{
+		return writeJson(output, detail::json_schema_of<T>(), &object);
+	}
+
+	template <typename T>
+	size_t writeJson(String& output, const T& object)
+	{
+		return writeJson(output, detail::json_schema_of<T>(), &object);
+	}
+}
+
+/**
+ * @brief Declare the JSON schema of \p __type, from a list of LWIOT_JSON_FIELD() entries.
+ */
+#define LWIOT_JSON_SCHEMA(__type, ...) \
+	inline const lwiot::JsonSchema& jsonSchemaOf(const __type *) \
+	{ \
+		static constexpr lwiot::JsonSchema::Field fields[] = { __VA_ARGS__ }; \
+		static constexpr lwiot::JsonSchema schema(fields, sizeof(fields) / sizeof(fields[0])); \
+		return schema; \
+	}
+
+/**
+ * @brief Field \p __member of \p __type, stored under its own name.
+ */
+#define LWIOT_JSON_FIELD(__type, __member) \
+	LWIOT_JSON_NAMED_FIELD(__type, __member, #__member)
+
+/**
+ * @brief Field \p __member of \p __type, stored under the key \p __key.
+ */
+#define LWIOT_JSON_NAMED_FIELD(__type, __member, __key) \
+	lwiot::JsonSchema::field<decltype(__type::__member)>(__key, offsetof(__type, __member))
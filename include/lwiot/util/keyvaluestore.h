@@ -0,0 +1,174 @@
+/*
+ * Log-structured key-value store.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/uniquepointer.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/stl/unorderedmap.h>
+#include <lwiot/kernel/lock.h>
+
+#ifdef HAVE_UNISTD_H
+#include <lwiot/io/file.h>
+#endif
+
+namespace lwiot
+{
+	class Eeprom24C02;
+	class SRAM23K256;
+
+	/**
+	 * @brief Persistent key-value store for configuration and state.
+	 *
+	 * The storage is divided into sectors of a fixed size. A sector starts with a header holding
+	 * its sequence number. Every update appends a record to the newest sector; records are never
+	 * rewritten in place, and removing a key appends a tombstone. A record carries a CRC over its
+	 * contents and the sequence number of its sector, so that a record that was cut short by a
+	 * reset, or one left over from an earlier use of the sector, ends the sector.
+	 *
+	 * On first use the store is read once to build an index in RAM, which maps every key to its
+	 * newest record. A lookup then costs a single read.
+	 *
+	 * Sectors are used in ring order. Compaction copies the records that are still current out of
+	 * the oldest sector to the newest one and releases the oldest sector, so every sector is
+	 * rewritten in turn, also those that hold values which never change. One sector is kept free
+	 * for this. Compaction runs when the store runs out of space; call compact() from an idle loop
+	 * or a timer to do it ahead of time.
+	 */
+	class KeyValueStore {
+	public:
+		explicit KeyValueStore(size_t sectors, size_t sectorsize);
+		virtual ~KeyValueStore();
+
+		/**
+		 * @brief Store \p length bytes under \p key.
+		 * @return False if the record does not fit in a sector, the store is full or the write failed.
+		 */
+		bool set(const StringView& key, const void *value, size_t length);
+		bool set(const StringView& key, const ByteBuffer& value);
+
+		/**
+		 * @brief Copy at most \p length bytes of the value stored under \p key.
+		 * @return The length of the value, or -ENOTFOUND.
+		 */
+		ssize_t get(const StringView& key, void *value, size_t length);
+		bool get(const StringView& key, ByteBuffer& value);
+
+		bool remove(const StringView& key);
+		bool contains(const StringView& key);
+		size_t size(); //!< Number of keys.
+		void clear();
+
+		/**
+		 * @brief Compact the oldest sector, if it holds records that were overwritten or removed.
+		 * @return True if a sector was released.
+		 */
+		bool compact();
+
+	protected:
+		static constexpr size_t SectorHeader = 8;
+		static constexpr size_t RecordHeader = 6;
+
+		virtual bool read(size_t offset, void *data, size_t length) = 0;
+		virtual bool write(size_t offset, const void *data, size_t length) = 0;
+
+		size_t storage() const
+		{
+			return this->_sectors * this->_sectorsize;
+		}
+
+	private:
+		struct Location {
+			size_t sector;
+			size_t offset;
+			size_t length;
+		};
+
+		Lock _lock;
+		size_t _sectors;
+		size_t _sectorsize;
+		uint32_t *_sequences;
+		size_t *_stale;
+		size_t _head;
+		size_t _head_offset;
+		size_t _tail;
+		size_t _free;
+		uint32_t _next;
+		bool _loaded;
+		bool _compacting;
+		stl::UnorderedMap<String, Location> _index;
+
+		void scan();
+		size_t replay(size_t sector);
+		bool append(const StringView& key, const void *value, size_t length, bool tombstone);
+		bool reserve(size_t length);
+		bool collect();
+		bool stale() const;
+		bool open(size_t sector);
+		void release(size_t sector);
+		void discard(const StringView& key);
+	};
+
+#ifdef HAVE_UNISTD_H
+	/**
+	 * @brief Key-value store in a file, which is created when it does not exist yet.
+	 */
+	class FileKeyValueStore : public KeyValueStore {
+	public:
+		explicit FileKeyValueStore(const String& path, size_t sectors = 4, size_t sectorsize = 4096);
+		~FileKeyValueStore() override = default;
+
+	protected:
+		bool read(size_t offset, void *data, size_t length) override;
+		bool write(size_t offset, const void *data, size_t length) override;
+
+	private:
+		UniquePointer<File> _file;
+	};
+#endif
+
+	/**
+	 * @brief Key-value store in a 23K256 SRAM, from address \p base onwards.
+	 */
+	class SramKeyValueStore : public KeyValueStore {
+	public:
+		explicit SramKeyValueStore(SRAM23K256& sram, size_t base = 0, size_t sectors = 4, size_t sectorsize = 2048);
+		~SramKeyValueStore() override = default;
+
+	protected:
+		bool read(size_t offset, void *data, size_t length) override;
+		bool write(size_t offset, const void *data, size_t length) override;
+
+	private:
+		SRAM23K256& _sram;
+		size_t _base;
+	};
+
+	/**
+	 * @brief Key-value store in a 24C02 EEPROM, from address \p base onwards.
+	 */
+	class EepromKeyValueStore : public KeyValueStore {
+	public:
+		explicit EepromKeyValueStore(Eeprom24C02& eeprom, uint8_t base = 0, size_t sectors = 4, size_t sectorsize = 64);
+		~EepromKeyValueStore() override = default;
+
+	protected:
+		bool read(size_t offset, void *data, size_t length) override;
+		bool write(size_t offset, const void *data, size_t length) override;
+
+	private:
+		Eeprom24C02& _eeprom;
+		uint8_t _base;
+	};
+}
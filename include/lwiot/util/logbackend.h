@@ -0,0 +1,209 @@
+/*
+ * Asynchronous logging backend.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/stream.h>
+#include <lwiot/format.h>
+#include <lwiot/kernel/thread.h>
+#include <lwiot/kernel/event.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/detail/boundedqueue.h>
+
+/* Number of records that can be queued, a power of two. */
+#ifndef CONFIG_LOG_RECORDS
+#define CONFIG_LOG_RECORDS 32
+#endif
+
+#ifndef CONFIG_LOG_RECORD_SIZE
+#define CONFIG_LOG_RECORD_SIZE 96
+#endif
+
+#ifndef CONFIG_LOG_SUBSYS_LENGTH
+#define CONFIG_LOG_SUBSYS_LENGTH 12
+#endif
+
+#ifndef CONFIG_LOG_BATCH_SIZE
+#define CONFIG_LOG_BATCH_SIZE 512
+#endif
+
+/* Time in milliseconds the sink thread waits for records before it flushes anyway. */
+#ifndef CONFIG_LOG_FLUSH_INTERVAL
+#define CONFIG_LOG_FLUSH_INTERVAL 100
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Line, or part of a line, produced by a Logger.
+	 */
+	struct LogRecord {
+		enum Flags : uint8_t {
+			Start = 1, //!< First part of a line, which gets a prefix.
+			End = 2, //!< Last part of a line, which is followed by a line ending.
+			Binary = 4 //!< Payload is a TokenizedLogger record, rather than text.
+		};
+
+		time_t tick;
+		LogLevel level;
+		uint8_t flags;
+		uint16_t length;
+		char subsystem[CONFIG_LOG_SUBSYS_LENGTH]; //!< Terminated, empty for the default logger.
+		char payload[CONFIG_LOG_RECORD_SIZE]; //!< Not terminated, cut off when it does not fit.
+	};
+
+	/**
+	 * @brief Destination of an AsyncLogBackend.
+	 *
+	 * Sinks are only called from the thread of the backend.
+	 */
+	class LogSink {
+	public:
+		virtual ~LogSink() = default;
+
+		virtual void write(const LogRecord& record) = 0;
+
+		/**
+		 * @brief Called once the backend has written all records it had queued.
+		 */
+		virtual void flush()
+		{
+		}
+
+	protected:
+		/**
+		 * @brief Format \p record the way a Logger would write it.
+		 * @return The length of the text, at most \p size.
+		 */
+		static size_t format(const LogRecord& record, char *output, size_t size);
+	};
+
+	/**
+	 * @brief Sink that collects records as text, and writes them out in batches.
+	 */
+	class TextLogSink : public LogSink {
+	public:
+		explicit TextLogSink();
+		~TextLogSink() override = default;
+
+		void write(const LogRecord& record) override;
+		void flush() override;
+
+	protected:
+		virtual void output(const char *data, size_t length) = 0;
+
+	private:
+		char _buffer[CONFIG_LOG_BATCH_SIZE];
+		size_t _length;
+	};
+
+	class FileLogSink : public TextLogSink {
+	public:
+		explicit FileLogSink(FILE *file = stdout);
+
+	protected:
+		void output(const char *data, size_t length) override;
+
+	private:
+		FILE *_file;
+	};
+
+	/**
+	 * @brief Sink that writes to a stream, such as a Uart or a TcpClient.
+	 */
+	class StreamLogSink : public TextLogSink {
+	public:
+		explicit StreamLogSink(Stream& stream);
+
+	protected:
+		void output(const char *data, size_t length) override;
+
+	private:
+		Stream& _stream;
+	};
+
+	/**
+	 * @brief Takes log records off the calling thread, and writes them to a sink from a thread of its own.
+	 *
+	 * A record holds the tick, level, subsystem and the formatted text of a line. Callers take a
+	 * free record from a lock free queue, format into it and put it on a second lock free queue,
+	 * so logging never waits for a lock or for the output. The sink thread writes the records in
+	 * batches and returns them to the free queue. It only has to be woken when it ran out of work.
+	 *
+	 * When all CONFIG_LOG_RECORDS records are in use, the Drop policy drops the line and counts
+	 * it, while the Block policy waits for the sink thread to catch up.
+	 *
+	 * @code
+	 * lwiot::FileLogSink sink(stdout);
+	 * lwiot::AsyncLogBackend backend(sink);
+	 *
+	 * backend.begin();
+	 * lwiot::Logger::setBackend(&backend);
+	 * @endcode
+	 */
+	class AsyncLogBackend : public Thread {
+	public:
+		enum class Policy {
+			Drop,
+			Block
+		};
+
+		explicit AsyncLogBackend(LogSink& sink, Policy policy = Policy::Drop);
+		~AsyncLogBackend() override;
+
+		AsyncLogBackend(const AsyncLogBackend&) = delete;
+		AsyncLogBackend& operator=(const AsyncLogBackend&) = delete;
+
+		void begin();
+
+		/**
+		 * @brief Write the queued records and stop the sink thread.
+		 */
+		void end();
+
+		/**
+		 * @brief Queue a formatted line.
+		 * @return False if the line was dropped.
+		 */
+		bool log(LogLevel level, const char *subsystem, uint8_t flags, const char *fmt,
+		         const detail::FormatArg *args, size_t num);
+
+		/**
+		 * @brief Queue text that has already been formatted.
+		 * @return False if the text was dropped.
+		 */
+		bool log(LogLevel level, const char *subsystem, uint8_t flags, const char *text, size_t length);
+
+		size_t dropped() const;
+
+	protected:
+		void run() override;
+
+	private:
+		LogSink& _sink;
+		Policy _policy;
+		LogRecord _records[CONFIG_LOG_RECORDS];
+		detail::BoundedQueue<LogRecord, CONFIG_LOG_RECORDS> _free;
+		detail::BoundedQueue<LogRecord, CONFIG_LOG_RECORDS> _queue;
+
+		Event _ready;
+		AtomicBool _idle;
+		AtomicBool _running;
+		detail::Atomic<long> _dropped;
+
+		LogRecord *acquire(LogLevel level, const char *subsystem, uint8_t flags);
+		void commit(LogRecord *record);
+		void drain();
+	};
+}
@@ -16,6 +16,12 @@
 
 namespace lwiot
 {
+	/**
+	 * @brief Unbounded collection of measurements.
+	 *
+	 * smooth() returns the root mean square of all measurements, which is kept up to date on
+	 * every add(). For a bounded window with more statistics see MeasurementWindow.
+	 */
 	class MeasurementVector {
 	public:
 		explicit MeasurementVector(int num = 0);
@@ -33,5 +39,8 @@ namespace lwiot
 
 	private:
 		stl::Vector<double> _measurements;
+		double _squares;
+
+		void sum();
 	};
 }
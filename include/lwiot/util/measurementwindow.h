@@ -0,0 +1,374 @@
+/*
+ * Fixed window streaming statistics.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/traits/isintegral.h>
+#include <lwiot/traits/typechoice.h>
+#include <lwiot/traits/enableif.h>
+
+namespace lwiot
+{
+	namespace measurement_detail
+	{
+		/* Queue of window slots, used as a monotonic deque. */
+		template <size_t N>
+		struct SlotQueue {
+			size_t slots[N];
+			size_t head;
+			size_t count;
+
+			void clear()
+			{
+				this->head = this->count = 0;
+			}
+
+			size_t front() const
+			{
+				return this->slots[this->head];
+			}
+
+			size_t back() const
+			{
+				return this->slots[(this->head + this->count - 1) % N];
+			}
+
+			void popFront()
+			{
+				this->head = (this->head + 1) % N;
+				this->count--;
+			}
+
+			void popBack()
+			{
+				this->count--;
+			}
+
+			void pushBack(size_t slot)
+			{
+				this->slots[(this->head + this->count) % N] = slot;
+				this->count++;
+			}
+		};
+	}
+
+	/**
+	 * @brief Statistics over the last N samples, updated in constant time per sample.
+	 * @tparam T Sample type: float, double or an integral type.
+	 * @tparam N Window size.
+	 *
+	 * Samples are kept in a ring buffer of N entries. The sum, mean and variance are updated on
+	 * every add(); the minimum and maximum are kept in monotonic deques and the median in a sorted
+	 * copy of the window, which costs O(N) moves per sample but no comparisons beyond a binary
+	 * search. An exponential moving average runs over all samples, not only the window.
+	 *
+	 * Floating point windows use Welford's method for the variance. Integral windows keep exact
+	 * 64-bit sums instead and never touch the FPU, which makes an int32_t window with fixed-point
+	 * samples the choice for cores without a (double) FPU. Their squares must fit in 64 bits:
+	 * keep samples below 2^31 / sqrt(N).
+	 */
+	template <typename T = float, size_t N = 16>
+	class MeasurementWindow {
+		static_assert(N > 0, "Measurement window must hold at least one sample");
+
+		static constexpr bool Integral = traits::IsIntegral<T>::value;
+		static constexpr int EmaShift = 16;
+
+	public:
+		typedef T value_type;
+		typedef typename traits::TypeChoice<Integral, int64_t, T>::type Accumulator;
+
+		/**
+		 * @param alpha Weight of a new sample in the exponential moving average.
+		 */
+		explicit MeasurementWindow(float alpha = 0.1f)
+		{
+			this->setAlpha(alpha);
+			this->clear();
+		}
+
+		void setAlpha(float alpha)
+		{
+			this->_alpha = static_cast<T>(alpha);
+			this->_alpha_q = static_cast<int64_t>(alpha * (1 << EmaShift));
+		}
+
+		void clear()
+		{
+			this->_head = this->_count = 0;
+			this->_sum = this->_squares = 0;
+			this->_mean = this->_m2 = 0;
+			this->_ema = 0;
+			this->_ema_q = 0;
+			this->_seeded = false;
+			this->_min.clear();
+			this->_max.clear();
+		}
+
+		void add(T value)
+		{
+			auto slot = this->_head;
+			bool evict = this->_count == N;
+			T old = evict ? this->_values[slot] : T();
+
+			if(evict) {
+				if(this->_min.count && this->_min.front() == slot)
+					this->_min.popFront();
+
+				if(this->_max.count && this->_max.front() == slot)
+					this->_max.popFront();
+
+				this->erase(old);
+			} else {
+				this->_count++;
+			}
+
+			this->_values[slot] = value;
+			this->_head = (slot + 1) % N;
+			this->insert(value);
+			this->update(value, old, evict);
+
+			while(this->_min.count && this->_values[this->_min.back()] >= value)
+				this->_min.popBack();
+
+			this->_min.pushBack(slot);
+
+			while(this->_max.count && this->_values[this->_max.back()] <= value)
+				this->_max.popBack();
+
+			this->_max.pushBack(slot);
+		}
+
+		size_t size() const
+		{
+			return this->_count;
+		}
+
+		bool empty() const
+		{
+			return this->_count == 0;
+		}
+
+		bool full() const
+		{
+			return this->_count == N;
+		}
+
+		static constexpr size_t capacity()
+		{
+			return N;
+		}
+
+		Accumulator sum() const
+		{
+			return this->_sum;
+		}
+
+		T mean() const
+		{
+			if(this->_count == 0)
+				return T();
+
+			return this->meanOf();
+		}
+
+		/**
+		 * @brief Population variance of the window.
+		 *
+		 * The variance of integral samples is returned in 64 bits: it is in the square of the
+		 * sample unit, e.g. Q32 for Q16 samples.
+		 */
+		Accumulator variance() const
+		{
+			if(this->_count == 0)
+				return Accumulator();
+
+			return this->varianceOf();
+		}
+
+		T min() const
+		{
+			return this->_count ? this->_values[this->_min.front()] : T();
+		}
+
+		T max() const
+		{
+			return this->_count ? this->_values[this->_max.front()] : T();
+		}
+
+		T median() const
+		{
+			if(this->_count == 0)
+				return T();
+
+			auto mid = this->_count / 2;
+
+			if(this->_count & 1)
+				return this->_sorted[mid];
+
+			T low = this->_sorted[mid - 1];
+			return low + (this->_sorted[mid] - low) / 2;
+		}
+
+		T ema() const
+		{
+			return Integral ? static_cast<T>(this->_ema_q >> EmaShift) : this->_ema;
+		}
+
+	private:
+		T _values[N];
+		T _sorted[N];
+		size_t _head;
+		size_t _count;
+
+		measurement_detail::SlotQueue<N> _min;
+		measurement_detail::SlotQueue<N> _max;
+
+		/* Integral samples: exact sums. */
+		Accumulator _sum;
+		int64_t _squares;
+
+		/* Floating point samples: Welford. */
+		T _mean;
+		T _m2;
+
+		T _alpha;
+		T _ema;
+		int64_t _alpha_q;
+		int64_t _ema_q;
+		bool _seeded;
+
+		size_t lowerBound(T value) const
+		{
+			size_t low = 0, high = this->_count - 1;
+
+			/*
+			 * Search the first _count - 1 entries: the sorted copy is one sample short while a
+			 * sample is inserted, and a sample that is erased is found before the last entry or
+			 * is the last entry itself.
+			 */
+			while(low < high) {
+				auto mid = (low + high) / 2;
+
+				if(this->_sorted[mid] < value)
+					low = mid + 1;
+				else
+					high = mid;
+			}
+
+			return low;
+		}
+
+		void erase(T value)
+		{
+			auto idx = this->lowerBound(value);
+
+			for(; idx + 1 < this->_count; idx++)
+				this->_sorted[idx] = this->_sorted[idx + 1];
+		}
+
+		void insert(T value)
+		{
+			auto idx = this->lowerBound(value);
+
+			for(auto pos = this->_count - 1; pos > idx; pos--)
+				this->_sorted[pos] = this->_sorted[pos - 1];
+
+			this->_sorted[idx] = value;
+		}
+
+		template <bool I = Integral>
+		typename traits::EnableIf<I, void>::type update(T value, T old, bool evict)
+		{
+			int64_t diff = static_cast<int64_t>(value) << EmaShift;
+
+			this->_sum += value;
+			this->_squares += static_cast<int64_t>(value) * value;
+
+			if(evict) {
+				this->_sum -= old;
+				this->_squares -= static_cast<int64_t>(old) * old;
+			}
+
+			if(!this->_seeded) {
+				this->_ema_q = diff;
+				this->_seeded = true;
+				return;
+			}
+
+			/* Split the product so that it cannot overflow 64 bits. */
+			diff -= this->_ema_q;
+			this->_ema_q += (diff >> EmaShift) * this->_alpha_q + (((diff & 0xFFFF) * this->_alpha_q) >> EmaShift);
+		}
+
+		template <bool I = Integral>
+		typename traits::EnableIf<!I, void>::type update(T value, T old, bool evict)
+		{
+			if(evict) {
+				auto mean = this->_mean + (value - old) / static_cast<T>(N);
+
+				this->_m2 += (value - old) * (value - mean + old - this->_mean);
+				this->_mean = mean;
+
+				if(this->_m2 < 0)
+					this->_m2 = 0;
+			} else {
+				auto delta = value - this->_mean;
+
+				this->_mean += delta / static_cast<T>(this->_count);
+				this->_m2 += delta * (value - this->_mean);
+			}
+
+			this->_sum = this->_mean * static_cast<T>(this->_count);
+
+			if(!this->_seeded) {
+				this->_ema = value;
+				this->_seeded = true;
+				return;
+			}
+
+			this->_ema += this->_alpha * (value - this->_ema);
+		}
+
+		template <bool I = Integral>
+		typename traits::EnableIf<I, T>::type meanOf() const
+		{
+			return static_cast<T>(this->_sum / static_cast<int64_t>(this->_count));
+		}
+
+		template <bool I = Integral>
+		typename traits::EnableIf<!I, T>::type meanOf() const
+		{
+			return this->_mean;
+		}
+
+		template <bool I = Integral>
+		typename traits::EnableIf<I, Accumulator>::type varianceOf() const
+		{
+			auto n = static_cast<int64_t>(this->_count);
+			auto q = this->_sum / n;
+			auto r = this->_sum % n;
+
+			/*
+			 * n * variance = squares - sum * sum / n. With sum = q * n + r, the square is expanded
+			 * so that the truncated mean does not drift the result, and nothing overflows 64 bits.
+			 */
+			return (this->_squares - q * (this->_sum + r) - r * r / n) / n;
+		}
+
+		template <bool I = Integral>
+		typename traits::EnableIf<!I, Accumulator>::type varianceOf() const
+		{
+			return this->_m2 / static_cast<T>(this->_count);
+		}
+	};
+}
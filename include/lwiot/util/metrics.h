@@ -0,0 +1,249 @@
+/*
+ * Metrics registry.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/stl/intrusivelist.h>
+
+/* Number of histogram buckets. The last bucket counts every value beyond the others. */
+#ifndef CONFIG_METRICS_HISTOGRAM_BUCKETS
+#define CONFIG_METRICS_HISTOGRAM_BUCKETS 64
+#endif
+
+namespace lwiot
+{
+	class CborWriter;
+
+	namespace metrics
+	{
+		class Registry;
+
+		/**
+		 * @brief Named value in a Registry.
+		 *
+		 * A metric adds itself to a registry when it is created and removes itself when it is
+		 * destroyed. The name and help text are not copied, and should be string literals. Names
+		 * follow the Prometheus conventions, such as <tt>http_requests_total</tt> or
+		 * <tt>i2c_transfer_us</tt>.
+		 */
+		class Metric {
+		public:
+			enum class Type : uint8_t {
+				Counter,
+				Gauge,
+				Histogram
+			};
+
+			virtual ~Metric();
+
+			Metric(const Metric&) = delete;
+			Metric& operator=(const Metric&) = delete;
+
+			const char *name() const;
+			const char *help() const;
+			Type type() const;
+
+			virtual void reset() = 0;
+
+			stl::IntrusiveListHook hook;
+
+		protected:
+			explicit Metric(Registry& registry, Type type, const char *name, const char *help);
+
+		private:
+			Registry& _registry;
+			Type _type;
+			const char *_name;
+			const char *_help;
+		};
+
+		/**
+		 * @brief Value that only goes up, such as a number of requests.
+		 */
+		class Counter : public Metric {
+		public:
+			typedef unsigned long value_type;
+
+			explicit Counter(const char *name, const char *help = nullptr);
+			explicit Counter(Registry& registry, const char *name, const char *help = nullptr);
+
+			void inc(value_type amount = 1)
+			{
+				this->_value.fetch_add(amount, memory_order_relaxed);
+			}
+
+			value_type value() const
+			{
+				return this->_value.load(memory_order_relaxed);
+			}
+
+			void reset() override;
+
+		private:
+			Atomic<value_type> _value;
+		};
+
+		/**
+		 * @brief Value that goes up and down, such as a queue length or the free heap.
+		 */
+		class Gauge : public Metric {
+		public:
+			typedef long value_type;
+
+			explicit Gauge(const char *name, const char *help = nullptr);
+			explicit Gauge(Registry& registry, const char *name, const char *help = nullptr);
+
+			void set(value_type value)
+			{
+				this->_value.store(value, memory_order_relaxed);
+			}
+
+			void add(value_type amount)
+			{
+				this->_value.fetch_add(amount, memory_order_relaxed);
+			}
+
+			void sub(value_type amount)
+			{
+				this->_value.fetch_sub(amount, memory_order_relaxed);
+			}
+
+			value_type value() const
+			{
+				return this->_value.load(memory_order_relaxed);
+			}
+
+			void reset() override;
+
+		private:
+			Atomic<value_type> _value;
+		};
+
+		/**
+		 * @brief Distribution of values, such as latencies.
+		 *
+		 * Buckets are log-linear: values up to 3 have a bucket each, after which every power of
+		 * two is split into four buckets of equal width. The relative error of a bucket is at most
+		 * 25%, and the default of 64 buckets covers values up to 114687, for example microseconds
+		 * up to 114 ms. Recording a value is a few instructions and two atomic additions.
+		 */
+		class Histogram : public Metric {
+		public:
+			typedef unsigned long value_type;
+			static constexpr size_t Buckets = CONFIG_METRICS_HISTOGRAM_BUCKETS;
+
+			explicit Histogram(const char *name, const char *help = nullptr);
+			explicit Histogram(Registry& registry, const char *name, const char *help = nullptr);
+
+			void observe(value_type value)
+			{
+				this->_buckets[Histogram::bucket(value)].fetch_add(1, memory_order_relaxed);
+				this->_sum.fetch_add(value, memory_order_relaxed);
+			}
+
+			value_type count() const;
+			value_type sum() const;
+			value_type bucketCount(size_t idx) const;
+
+			/**
+			 * @brief Largest value that falls in bucket \p idx. The last bucket has no upper bound.
+			 */
+			static value_type upperBound(size_t idx);
+			static size_t bucket(value_type value);
+
+			void reset() override;
+
+		private:
+			Atomic<uint32_t> _buckets[Buckets];
+			Atomic<value_type> _sum;
+		};
+
+		/**
+		 * @brief Set of metrics, which can be exported as a whole.
+		 *
+		 * Metrics are linked into the registry, so registering does not allocate. Values are
+		 * read without stopping the writers, so an export is not a single snapshot in time.
+		 *
+		 * @code
+		 * static lwiot::metrics::Counter requests("http_requests_total", "Requests served.");
+		 * static lwiot::metrics::Histogram latency("http_request_us", "Request latency.");
+		 *
+		 * requests.inc();
+		 * latency.observe(elapsed);
+		 * @endcode
+		 */
+		class Registry {
+		public:
+			/**
+			 * @brief Output callback of an exporter.
+			 * @return False to stop the export.
+			 */
+			typedef Function<bool(const char *data, size_t length)> Writer;
+
+			explicit Registry();
+			~Registry();
+
+			Registry(const Registry&) = delete;
+			Registry& operator=(const Registry&) = delete;
+
+			/**
+			 * @brief Registry that metrics are added to by default.
+			 */
+			static Registry& global();
+
+			size_t size() const;
+			void reset();
+
+			/**
+			 * @brief Look up a metric by name.
+			 * @return The metric, or null.
+			 */
+			Metric *find(const char *name) const;
+
+			/**
+			 * @brief Write the metrics in the Prometheus text exposition format.
+			 *
+			 * Histogram buckets are written up to the highest bucket in use, followed by the
+			 * <tt>+Inf</tt> bucket.
+			 *
+			 * @return False if \p writer stopped the export.
+			 */
+			bool writePrometheus(const Writer& writer) const;
+
+			/**
+			 * @brief Write the metrics as a JSON object, keyed by name.
+			 *
+			 * Counters and gauges are numbers. A histogram is an object with its count, sum and an
+			 * array of [upper bound, count] pairs of the buckets that are not empty. The last bucket
+			 * has an upper bound of null.
+			 */
+			bool writeJson(const Writer& writer) const;
+
+			/**
+			 * @brief Write the metrics as a CBOR map, in the layout of writeJson().
+			 */
+			void writeCbor(CborWriter& writer) const;
+
+		private:
+			friend class Metric;
+
+			mutable Lock _lock;
+			stl::IntrusiveList<Metric, &Metric::hook> _metrics;
+
+			void add(Metric& metric);
+			void remove(Metric& metric);
+		};
+	}
+}
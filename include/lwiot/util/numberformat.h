@@ -0,0 +1,53 @@
+/*
+ * Allocation free number formatting.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <lwiot.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <lwiot/types.h>
+
+#ifdef __cplusplus
+namespace lwiot
+{
+	/**
+	 * @brief Number to text conversion into caller supplied buffers.
+	 *
+	 * All functions write a nul-terminated string into \p output and return its length. A buffer
+	 * of BufferSize bytes is large enough for any value; DecimalBufferSize bytes suffice for
+	 * decimal integers and floats. Decimal integers are converted two digits at a time using a
+	 * lookup table; floats are converted using integer arithmetic.
+	 */
+	class NumberFormat {
+	public:
+		static constexpr size_t BufferSize = 72;
+		static constexpr size_t DecimalBufferSize = 33;
+		static constexpr uint8_t MaxPrecision = 9;
+
+		/**
+		 * @brief Format an unsigned integer.
+		 * @param output Output buffer.
+		 * @param value Value to format.
+		 * @param base Base between 2 and 36. Other values are treated as 10.
+		 */
+		static size_t formatUnsigned(char *output, unsigned long long value, uint8_t base = 10);
+		static size_t formatSigned(char *output, long long value);
+
+		/**
+		 * @brief Format a floating point number in fixed point notation.
+		 * @param output Output buffer.
+		 * @param value Value to format.
+		 * @param precision Number of decimals, clipped to MaxPrecision.
+		 * @note Values whose integral part does not fit in 64 bits are formatted using
+		 *       scientific notation.
+		 */
+		static size_t formatFloat(char *output, double value, uint8_t precision);
+	};
+}
+#endif
@@ -0,0 +1,175 @@
+/*
+ * Typed pool of objects.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <lwiot.h>
+
+#ifdef CXX
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+
+#include <lwiot/uniquepointer.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/stl/move.h>
+#include <lwiot/stl/forward.h>
+#include <lwiot/util/poolallocator.h>
+
+namespace lwiot
+{
+	namespace detail
+	{
+		/* Stored in front of every pooled object, so that it finds its way back to its pool. */
+		struct PoolHeader {
+			void (*release)(void *pool, void *slot);
+			void *pool;
+		};
+
+		template <typename T>
+		struct PoolSlot;
+	}
+
+	/**
+	 * @brief Object of type \p T that lives in an ObjectPool.
+	 *
+	 * Deleting a pooled object runs its destructor and returns its memory to the pool it came
+	 * from. When \p T has a virtual destructor this also happens through a pointer to a base
+	 * class, so a pooled object can be handed out as a <tt>UniquePointer<Base></tt> with the
+	 * default deleter.
+	 */
+	template <typename T>
+	class Pooled : public T {
+	public:
+		template <typename... Args>
+		explicit Pooled(Args&&... args) : T(stl::forward<Args>(args)...)
+		{
+		}
+
+		static void *operator new(size_t size, void *ptr) noexcept
+		{
+			UNUSED(size);
+			return ptr;
+		}
+
+		static void *operator new(size_t size) = delete;
+
+		static void operator delete(void *ptr) noexcept
+		{
+			auto slot = static_cast<uint8_t *>(ptr) - offsetof(detail::PoolSlot<T>, storage);
+			auto header = reinterpret_cast<detail::PoolHeader *>(slot);
+
+			header->release(header->pool, slot);
+		}
+	};
+
+	namespace detail
+	{
+		template <typename T>
+		struct PoolSlot {
+			PoolHeader header;
+			alignas(Pooled<T>) uint8_t storage[sizeof(Pooled<T>)];
+		};
+	}
+
+	/**
+	 * @brief Deleter for UniquePointers to pooled objects.
+	 */
+	template <typename T>
+	struct PoolDelete {
+		void operator()(T *obj) const noexcept
+		{
+			delete static_cast<Pooled<T> *>(obj);
+		}
+	};
+
+	/**
+	 * @brief Pool of \p N objects of type \p T.
+	 *
+	 * Objects are constructed in place in a BlockPool, so creating and destroying them does not
+	 * touch the heap. Taking an object from the pool and returning it are lock-free, and objects
+	 * may be returned from any thread. The pool has to outlive its objects.
+	 *
+	 * @code
+	 * static lwiot::ObjectPool<lwiot::SocketTcpClient, 8> clients;
+	 *
+	 * lwiot::UniquePointer<lwiot::TcpClient> client(clients.create(socket));
+	 * @endcode
+	 */
+	template <typename T, size_t N>
+	class ObjectPool {
+	public:
+		typedef UniquePointer<T, PoolDelete<T>> Pointer;
+
+		explicit ObjectPool() : _used(0)
+		{
+		}
+
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+
+		/**
+		 * @brief Construct an object in the pool.
+		 * @return The object, or \c nullptr if the pool is exhausted. Release it using \c delete,
+		 *         which returns it to the pool.
+		 */
+		template <typename... Args>
+		T *create(Args&&... args)
+		{
+			auto slot = static_cast<detail::PoolSlot<T> *>(this->_slots.allocate());
+
+			if(slot == nullptr)
+				return nullptr;
+
+			slot->header.release = &ObjectPool::release;
+			slot->header.pool = this;
+			this->_used.fetch_add(1, memory_order_relaxed);
+
+			return new(slot->storage) Pooled<T>(stl::forward<Args>(args)...);
+		}
+
+		/**
+		 * @brief Construct an object in the pool, owned by a UniquePointer.
+		 * @return The object, or an empty pointer if the pool is exhausted.
+		 */
+		template <typename... Args>
+		Pointer acquire(Args&&... args)
+		{
+			return Pointer(this->create(stl::forward<Args>(args)...));
+		}
+
+		bool contains(const T *obj) const
+		{
+			return this->_slots.contains(obj);
+		}
+
+		size_t used() const
+		{
+			return this->_used.load(memory_order_relaxed);
+		}
+
+		constexpr size_t capacity() const
+		{
+			return N;
+		}
+
+	private:
+		BlockPool<sizeof(detail::PoolSlot<T>), N> _slots;
+		Atomic<size_t> _used;
+
+		static void release(void *pool, void *slot)
+		{
+			auto self = static_cast<ObjectPool *>(pool);
+
+			self->_slots.deallocate(slot);
+			self->_used.fetch_sub(1, memory_order_relaxed);
+		}
+	};
+}
+
+#endif
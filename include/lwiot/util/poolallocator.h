@@ -0,0 +1,216 @@
+/*
+ * Fixed-block pool allocator.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <lwiot.h>
+
+#ifdef CXX
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/stl/move.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Pool of fixed size memory blocks.
+	 * @tparam BlockSize Size of a single block in bytes.
+	 * @tparam Blocks Number of blocks in the pool.
+	 *
+	 * Allocation and deallocation are O(1) and lock-free. Free blocks are kept on a singly linked
+	 * list of block indices. The list head carries a generation tag to avoid ABA problems.
+	 */
+	template <size_t BlockSize, size_t Blocks>
+	class BlockPool {
+		static_assert(Blocks > 0 && Blocks < 0xFFFF, "Block count must be in the range [1, 65535)");
+
+	public:
+		explicit BlockPool() : _head(0U)
+		{
+			for(uint32_t idx = 0; idx < Blocks; idx++)
+				this->_blocks[idx].next = idx + 1 == Blocks ? Empty : idx + 1;
+		}
+
+		BlockPool(const BlockPool&) = delete;
+		BlockPool& operator=(const BlockPool&) = delete;
+
+		/**
+		 * @brief Take a block from the pool.
+		 * @return A pointer to a block of \p BlockSize bytes or \p nullptr when the pool is exhausted.
+		 */
+		void *allocate()
+		{
+			uint32_t head, next;
+
+			do {
+				head = this->load();
+
+				if(index(head) == Empty)
+					return nullptr;
+
+				next = tagged(this->_blocks[index(head)].next, head);
+			} while(!this->cas(head, next));
+
+			return this->_blocks[index(head)].data;
+		}
+
+		/**
+		 * @brief Return a block to the pool.
+		 * @param ptr Block obtained from allocate().
+		 */
+		void deallocate(void *ptr)
+		{
+			uint32_t head, next;
+			auto idx = static_cast<uint32_t>(reinterpret_cast<Block *>(ptr) - this->_blocks);
+
+			do {
+				head = this->load();
+				this->_blocks[idx].next = index(head);
+				next = tagged(idx, head);
+			} while(!this->cas(head, next));
+		}
+
+		bool contains(const void *ptr) const
+		{
+			auto p = reinterpret_cast<const uint8_t *>(ptr);
+			auto base = reinterpret_cast<const uint8_t *>(this->_blocks);
+
+			return p >= base && p < base + sizeof(this->_blocks);
+		}
+
+		constexpr size_t blocks() const
+		{
+			return Blocks;
+		}
+
+		/**
+		 * @brief Memory of all blocks, e.g. to register it with the kernel for fixed buffer I/O.
+		 */
+		void *data()
+		{
+			return this->_blocks;
+		}
+
+		constexpr size_t size() const
+		{
+			return sizeof(Block) * Blocks;
+		}
+
+	private:
+		static constexpr uint32_t Empty = 0xFFFF;
+
+		union Block {
+			uint32_t next;
+			alignas(max_align_t) uint8_t data[BlockSize];
+		};
+
+		Block _blocks[Blocks];
+
+		lwiot::Atomic<uint32_t> _head;
+
+		uint32_t load() const
+		{
+			return this->_head.load(memory_order_acquire);
+		}
+
+		bool cas(uint32_t expected, uint32_t desired)
+		{
+			return this->_head.compare_exchange_weak(expected, desired, memory_order_acq_rel);
+		}
+
+		static constexpr uint32_t index(uint32_t head)
+		{
+			return head & 0xFFFFU;
+		}
+
+		static constexpr uint32_t tagged(uint32_t idx, uint32_t oldhead)
+		{
+			return (((oldhead >> 16U) + 1U) << 16U) | idx;
+		}
+	};
+
+	/**
+	 * @brief Allocator that serves single objects from a BlockPool.
+	 * @tparam T Object type.
+	 * @tparam Blocks Number of blocks in the default pool.
+	 *
+	 * Requests for more than one object, or requests made while the pool is exhausted, are
+	 * served from the heap. All allocators of the same type share a static pool unless a pool
+	 * is passed explicitly.
+	 */
+	template <typename T, size_t Blocks>
+	struct PoolAllocator {
+	public:
+		typedef T ObjectType;
+		typedef BlockPool<sizeof(T), Blocks> PoolType;
+
+		template <typename U>
+		struct rebind {
+			typedef PoolAllocator<U, Blocks> other;
+		};
+
+		explicit PoolAllocator() : _pool(&PoolAllocator::pool())
+		{
+		}
+
+		explicit PoolAllocator(PoolType& pool) : _pool(&pool)
+		{
+		}
+
+		ObjectType* allocate(size_t num) const noexcept
+		{
+			void *data = nullptr;
+
+			if(num == 1)
+				data = this->_pool->allocate();
+
+			if(data == nullptr)
+				data = lwiot_mem_alloc(num * sizeof(ObjectType));
+
+			return reinterpret_cast<ObjectType*>(data);
+		}
+
+		void deallocate(ObjectType* obj, size_t num) const noexcept
+		{
+			if(obj == nullptr || num == 0UL)
+				return;
+
+			if(this->_pool->contains(obj))
+				this->_pool->deallocate(obj);
+			else
+				lwiot_mem_free(obj);
+		}
+
+		CONSTEXPR void move(ObjectType *obj, ObjectType& t)
+		{
+			new(obj) ObjectType(stl::move(t));
+		}
+
+		CONSTEXPR void construct(ObjectType *obj, const ObjectType& t) const
+		{
+			new(obj) ObjectType(t);
+		}
+
+		CONSTEXPR void destroy(ObjectType* obj) const
+		{
+			obj->~ObjectType();
+		}
+
+		static PoolType& pool()
+		{
+			static PoolType _default;
+			return _default;
+		}
+
+	private:
+		PoolType* _pool;
+	};
+}
+#endif
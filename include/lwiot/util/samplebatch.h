@@ -0,0 +1,128 @@
+/*
+ * Structure-of-arrays batch of sensor samples.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+
+#ifndef CONFIG_SAMPLE_BATCH_ALIGN
+#define CONFIG_SAMPLE_BATCH_ALIGN 16
+#endif
+
+namespace lwiot
+{
+	struct SensorReading;
+
+	/**
+	 * @brief Fixed capacity batch of samples, stored as a structure of arrays.
+	 *
+	 * Timestamps, sensor identifiers and values are kept in three separate arrays, each of which
+	 * starts at a CONFIG_SAMPLE_BATCH_ALIGN byte boundary. Kernels that only look at the values,
+	 * such as the filters in lwiot::dsp, run over one contiguous float array that the compiler
+	 * can vectorize. Encoders write a whole batch as one message, so the framing is paid once
+	 * per batch instead of once per reading.
+	 *
+	 * The arrays are allocated once, when the batch is created; adding samples never allocates.
+	 */
+	class SampleBatch {
+	public:
+		explicit SampleBatch(size_t capacity);
+		virtual ~SampleBatch();
+
+		SampleBatch(const SampleBatch&) = delete;
+		SampleBatch& operator=(const SampleBatch&) = delete;
+
+		/**
+		 * @brief Append a sample.
+		 * @param timestamp Time of the sample in milliseconds.
+		 * @param sensor Sensor identifier.
+		 * @param value Sample value.
+		 * @return False if the batch is full.
+		 */
+		bool add(time_t timestamp, uint16_t sensor, float value)
+		{
+			if(this->_size >= this->_capacity)
+				return false;
+
+			this->_timestamps[this->_size] = timestamp;
+			this->_sensors[this->_size] = sensor;
+			this->_values[this->_size] = value;
+			this->_size++;
+
+			return true;
+		}
+
+		/**
+		 * @brief Append the values of a SensorScheduler reading. Failed readings are skipped.
+		 * @return The number of samples added.
+		 */
+		size_t add(const SensorReading& reading);
+
+		/**
+		 * @brief Copy the values of \p sensor into \p output.
+		 * @return The number of values copied, at most \p length.
+		 */
+		size_t gather(uint16_t sensor, float *output, size_t length) const;
+
+		void clear()
+		{
+			this->_size = 0;
+		}
+
+		size_t size() const
+		{
+			return this->_size;
+		}
+
+		size_t capacity() const
+		{
+			return this->_capacity;
+		}
+
+		bool empty() const
+		{
+			return this->_size == 0;
+		}
+
+		bool full() const
+		{
+			return this->_size == this->_capacity;
+		}
+
+		const time_t *timestamps() const
+		{
+			return this->_timestamps;
+		}
+
+		const uint16_t *sensors() const
+		{
+			return this->_sensors;
+		}
+
+		float *values()
+		{
+			return this->_values;
+		}
+
+		const float *values() const
+		{
+			return this->_values;
+		}
+
+	private:
+		uint8_t *_storage;
+		time_t *_timestamps;
+		uint16_t *_sensors;
+		float *_values;
+		size_t _size;
+		size_t _capacity;
+	};
+}
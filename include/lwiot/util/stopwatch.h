@@ -0,0 +1,92 @@
+/*
+ * Stopwatch definition.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/kernel/clock.h>
+
+namespace lwiot
+{
+	/**
+	 * @brief Measure elapsed time using the monotonic Clock.
+	 *
+	 * The elapsed time accumulates over consecutive start() / stop() pairs, until reset() is called.
+	 */
+	class Stopwatch {
+	public:
+		explicit Stopwatch(bool running = false) : _start(0), _elapsed(0), _running(false)
+		{
+			if(running)
+				this->start();
+		}
+
+		void start()
+		{
+			if(this->_running)
+				return;
+
+			this->_start = Clock::now();
+			this->_running = true;
+		}
+
+		void stop()
+		{
+			if(!this->_running)
+				return;
+
+			this->_elapsed += Clock::now() - this->_start;
+			this->_running = false;
+		}
+
+		void reset()
+		{
+			this->_elapsed = 0;
+			this->_running = false;
+		}
+
+		void restart()
+		{
+			this->reset();
+			this->start();
+		}
+
+		inline bool isRunning() const
+		{
+			return this->_running;
+		}
+
+		/**
+		 * @brief Elapsed time in nanoseconds.
+		 */
+		uint64_t elapsed() const
+		{
+			if(this->_running)
+				return this->_elapsed + Clock::now() - this->_start;
+
+			return this->_elapsed;
+		}
+
+		inline uint64_t elapsedUs() const
+		{
+			return this->elapsed() / 1000ULL;
+		}
+
+		inline uint64_t elapsedMs() const
+		{
+			return this->elapsed() / 1000000ULL;
+		}
+
+	private:
+		uint64_t _start;
+		uint64_t _elapsed;
+		bool _running;
+	};
+}
@@ -0,0 +1,188 @@
+/*
+ * Compressed time-series store.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/uniquepointer.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/kernel/lock.h>
+
+#ifdef HAVE_UNISTD_H
+#include <lwiot/io/file.h>
+#endif
+
+#ifndef CONFIG_TIMESERIES_BLOCK
+#define CONFIG_TIMESERIES_BLOCK 512
+#endif
+
+namespace lwiot
+{
+	struct SensorReading;
+	class MeasurementVector;
+	class SampleBatch;
+	class SRAM23K256;
+
+	/**
+	 * @brief Compressed history of a single series of measurements.
+	 *
+	 * Points are packed into blocks of a fixed size using the Gorilla encoding. A timestamp is
+	 * stored as the change in the interval between samples, which is zero for a steady sample
+	 * rate, and a value as the XOR with the previous value, of which only the meaningful bits are
+	 * kept. A sample taken every second from a slowly changing signal takes two to four bytes,
+	 * instead of the sixteen of a raw timestamp and double.
+	 *
+	 * The newest block is kept in RAM and written when it is full, or by flush(). On storage the
+	 * blocks form a ring: when it is full, the oldest block is overwritten. The header of a block
+	 * holds the time range it covers, so a range query finds its first block using a binary
+	 * search and only decodes the blocks that it needs.
+	 *
+	 * Timestamps are in milliseconds and must not decrease.
+	 */
+	class TimeSeriesStore {
+	public:
+		/**
+		 * @brief Query callback.
+		 * @return False to stop the query.
+		 */
+		typedef Function<bool(time_t timestamp, double value)> Visitor;
+
+		explicit TimeSeriesStore(size_t blocks, size_t blocksize = CONFIG_TIMESERIES_BLOCK);
+		virtual ~TimeSeriesStore();
+
+		/**
+		 * @brief Append a point.
+		 * @return False if \p timestamp is older than the newest point, or a block could not be written.
+		 */
+		bool add(time_t timestamp, double value);
+
+		/**
+		 * @brief Append value \p index of a SensorScheduler reading. Failed readings are skipped.
+		 */
+		bool add(const SensorReading& reading, size_t index = 0);
+
+		/**
+		 * @brief Append the smoothed value of \p vector.
+		 */
+		bool add(time_t timestamp, const MeasurementVector& vector);
+
+		/**
+		 * @brief Append the samples of \p sensor in \p batch, taking the lock once.
+		 * @return The number of points appended. Appending stops at the first point that fails.
+		 */
+		size_t add(const SampleBatch& batch, uint16_t sensor);
+
+		/**
+		 * @brief Write the block that is being filled, so that its points survive a reset.
+		 */
+		bool flush();
+
+		/**
+		 * @brief Hand the points from \p from up to and including \p to to \p visitor, oldest first.
+		 *
+		 * The store is only locked while a block is read, so points can be added during a query.
+		 * Blocks that are overwritten while the query runs are skipped.
+		 *
+		 * @return The number of points handed to \p visitor.
+		 */
+		size_t query(time_t from, time_t to, const Visitor& visitor);
+
+		bool empty();
+		void clear();
+
+	protected:
+		static constexpr size_t BlockHeader = 28;
+
+		virtual bool read(size_t offset, void *data, size_t length) = 0;
+		virtual bool write(size_t offset, const void *data, size_t length) = 0;
+
+		size_t storage() const
+		{
+			return this->_blocks * this->_blocksize;
+		}
+
+	private:
+		struct State {
+			size_t bits;
+			size_t count;
+			int64_t first;
+			int64_t last;
+			int64_t delta;
+			uint64_t value;
+			int leading;
+			int trailing;
+		};
+
+		struct Header {
+			uint32_t sequence;
+			size_t count;
+			int64_t first;
+			int64_t last;
+		};
+
+		Lock _lock;
+		size_t _blocks;
+		size_t _blocksize;
+		uint8_t *_block;
+		State _state;
+		size_t _head;
+		size_t _sealed;
+		uint32_t _sequence;
+		bool _loaded;
+
+		void scan();
+		void reset();
+		bool append(int64_t ts, double value);
+		bool seal();
+		void finish(uint8_t *block, uint32_t sequence, const State& state) const;
+		bool header(size_t slot, Header& header);
+		bool fetch(uint32_t sequence, uint8_t *block);
+		size_t find(time_t from);
+		size_t decode(const uint8_t *block, time_t from, time_t to, const Visitor& visitor, bool& stop) const;
+	};
+
+#ifdef HAVE_UNISTD_H
+	/**
+	 * @brief Time-series store in a file, which is created when it does not exist yet.
+	 */
+	class FileTimeSeriesStore : public TimeSeriesStore {
+	public:
+		explicit FileTimeSeriesStore(const String& path, size_t blocks = 256, size_t blocksize = CONFIG_TIMESERIES_BLOCK);
+		~FileTimeSeriesStore() override = default;
+
+	protected:
+		bool read(size_t offset, void *data, size_t length) override;
+		bool write(size_t offset, const void *data, size_t length) override;
+
+	private:
+		UniquePointer<File> _file;
+	};
+#endif
+
+	/**
+	 * @brief Time-series store in a 23K256 SRAM, from address \p base onwards.
+	 */
+	class SramTimeSeriesStore : public TimeSeriesStore {
+	public:
+		explicit SramTimeSeriesStore(SRAM23K256& sram, size_t base = 0, size_t blocks = 64,
+		                             size_t blocksize = CONFIG_TIMESERIES_BLOCK);
+		~SramTimeSeriesStore() override = default;
+
+	protected:
+		bool read(size_t offset, void *data, size_t length) override;
+		bool write(size_t offset, const void *data, size_t length) override;
+
+	private:
+		SRAM23K256& _sram;
+		size_t _base;
+	};
+}
@@ -0,0 +1,150 @@
+/*
+ * Tokenized (binary) logging.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/stream.h>
+#include <lwiot/format.h>
+
+#ifndef CONFIG_STANDALONE
+#include <lwiot/util/logbackend.h>
+#endif
+
+/* Largest encoded record, including its length byte. At most 256. */
+#ifndef CONFIG_LOG_TOKEN_RECORD_SIZE
+#define CONFIG_LOG_TOKEN_RECORD_SIZE 64
+#endif
+
+#if defined(__GNUC__) && !defined(__APPLE__)
+#define LWIOT_TOKEN_SECTION __attribute__((section("lwiot_tokens"), used))
+#else
+#define LWIOT_TOKEN_SECTION
+#endif
+
+/**
+ * @brief Log a line through a TokenizedLogger.
+ * @param __logger TokenizedLogger to write to.
+ * @param __fmt Format string literal, see lwiot::format().
+ *
+ * Only a token of \p __fmt is sent, which is computed at compile time. The format string itself is
+ * stored in the lwiot_tokens section, from which scripts/detokenize.py builds the token database.
+ * The format string is checked against the arguments, as with LWIOT_FMT().
+ */
+#define LWIOT_LOG_TOKENIZED(__logger, __fmt, ...) \
+	LWIOT_LOG_TOKENIZED_LEVEL(__logger, lwiot::LogLevel::Info, __fmt, ##__VA_ARGS__)
+
+#define LWIOT_LOG_TOKENIZED_LEVEL(__logger, __level, __fmt, ...) \
+	do { \
+		static const char __lwiot_token_entry[] LWIOT_TOKEN_SECTION = __fmt; \
+		(void) __lwiot_token_entry; \
+		(__logger).log(__level, LWIOT_FMT(__fmt), ##__VA_ARGS__); \
+	} while(0)
+
+namespace lwiot
+{
+	namespace detail
+	{
+		/* FNV-1a of the format string. Token 0 is used for lines that are sent as text. */
+		constexpr uint32_t log_token(const char *fmt, uint32_t hash = 2166136261U)
+		{
+			return *fmt == '\0' ? hash : log_token(fmt + 1, (hash ^ static_cast<uint8_t>(*fmt)) * 16777619U);
+		}
+
+		/*
+		 * Encode a record, and return its length including the length byte. Strings are cut off, and
+		 * arguments that do not fit are left out.
+		 */
+		extern DLL_EXPORT size_t encode_log_record(uint8_t *output, size_t size, LogLevel level, uint32_t token,
+		                                           time_t tick, const FormatArg *args, size_t num);
+	}
+
+	/**
+	 * @brief Logger that sends a token and the raw arguments of a line, instead of the text.
+	 *
+	 * Every record is a length byte, followed by:
+	 * - the token of the format string, 4 bytes little endian;
+	 * - the tick, as a variable length integer;
+	 * - the level in the upper and the number of arguments in the lower nibble of a byte;
+	 * - the kind of every argument, a nibble each;
+	 * - the arguments. Integers are variable length (zigzag encoded if signed), floating point
+	 *   numbers are single precision when that is exact and double precision otherwise, and strings
+	 *   are a length followed by the characters.
+	 *
+	 * scripts/detokenize.py turns the records back into text, using the format strings of the
+	 * firmware. Use LWIOT_LOG_TOKENIZED() to log:
+	 *
+	 * @code
+	 * lwiot::TokenizedLogger log(uart);
+	 * LWIOT_LOG_TOKENIZED(log, "Temperature: {:.1} C", temperature);
+	 * @endcode
+	 *
+	 * The format strings are not needed at run time. Keep the lwiot_tokens section out of flash by
+	 * placing it in a non-loaded section of the linker script:
+	 *
+	 * @code
+	 * lwiot_tokens 0 (INFO) : { KEEP(*(lwiot_tokens)) }
+	 * @endcode
+	 */
+	class TokenizedLogger {
+	public:
+		explicit TokenizedLogger(Stream& output);
+#ifndef CONFIG_STANDALONE
+		explicit TokenizedLogger(AsyncLogBackend& backend);
+#endif
+
+		template <typename Literal, typename... Args,
+				typename = traits::EnableIf_t<traits::IsConvirtable<Literal, detail::FormatLiteral>::value>>
+		bool log(LogLevel level, Literal fmt, const Args&... args)
+		{
+			static_assert(detail::is_valid_format<Args...>(Literal::get()), "Format string does not match its arguments");
+			constexpr uint32_t token = detail::log_token(Literal::get());
+			const detail::FormatArg values[] = { detail::FormatTraitsOf<Args>::make(args)..., detail::FormatArg() };
+
+			return this->write(level, token, values, sizeof...(Args));
+		}
+
+		/**
+		 * @brief Write a record.
+		 * @return False if the record was dropped, or not written completely.
+		 */
+		bool write(LogLevel level, uint32_t token, const detail::FormatArg *args, size_t num);
+
+	private:
+		Stream *_output;
+#ifndef CONFIG_STANDALONE
+		AsyncLogBackend *_backend;
+#endif
+	};
+
+#ifndef CONFIG_STANDALONE
+	/**
+	 * @brief Sink that writes tokenized records to a stream.
+	 *
+	 * Records from a TokenizedLogger are written as they are. Lines from a Logger are sent as a
+	 * record with token 0, and the subsystem, text and LogRecord flags as arguments, so both can
+	 * share a link.
+	 */
+	class TokenizedLogSink : public LogSink {
+	public:
+		explicit TokenizedLogSink(Stream& output);
+
+		void write(const LogRecord& record) override;
+		void flush() override;
+
+	private:
+		Stream& _output;
+		uint8_t _buffer[CONFIG_LOG_BATCH_SIZE];
+		size_t _length;
+	};
+#endif
+}
@@ -0,0 +1,137 @@
+/*
+ * Tracing spans.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stream.h>
+#include <lwiot/function.h>
+#include <lwiot/kernel/clock.h>
+#include <lwiot/kernel/atomic.h>
+
+/* Number of spans kept per thread, a power of two. */
+#ifndef CONFIG_TRACE_EVENTS
+#define CONFIG_TRACE_EVENTS 256
+#endif
+
+/* Number of threads that can record spans at the same time. */
+#ifndef CONFIG_TRACE_THREADS
+#define CONFIG_TRACE_THREADS 8
+#endif
+
+#define __TRACE_CONCAT(a, b) a ## b
+#define __TRACE_NAME(line) __TRACE_CONCAT(__trace_span_, line)
+
+/**
+ * @brief Record the time from here to the end of the enclosing scope as a span named \p name.
+ * @param name String literal, or another string that outlives the trace.
+ *
+ * Spans are only recorded when built with CONFIG_TRACE, and compile to nothing otherwise.
+ * @see Tracer
+ */
+#if defined(CONFIG_TRACE) && !defined(CONFIG_STANDALONE)
+#define TRACE_SPAN(name) lwiot::TraceSpan __TRACE_NAME(__LINE__)(name)
+#else
+#define TRACE_SPAN(name)
+#endif
+
+namespace lwiot
+{
+	/**
+	 * @brief Span of time spent by a thread.
+	 */
+	struct TraceEvent {
+		const char *name;
+		uint64_t begin; //!< Clock::now() at the start of the span.
+		uint32_t duration; //!< Length of the span in nanoseconds, saturated.
+		uint16_t thread; //!< Number of the recording thread, starting at 1.
+	};
+
+	/**
+	 * @brief Collects spans from all threads and writes them in the Chrome trace format.
+	 *
+	 * A thread takes one of CONFIG_TRACE_THREADS ring buffers when it records its first span, and
+	 * returns it when it exits. Recording a span writes to the buffer of the thread only, so it
+	 * takes no locks and no atomic read-modify-write. When a buffer is full the oldest spans are
+	 * overwritten, and spans of threads that found no free buffer are dropped.
+	 *
+	 * write() may be called from any thread. It writes the spans recorded since the previous
+	 * write as one JSON document, which chrome://tracing and ui.perfetto.dev open as-is:
+	 *
+	 * @code
+	 * void handle(const XBeeResponse& response)
+	 * {
+	 *     TRACE_SPAN("handle");
+	 *     ...
+	 * }
+	 *
+	 * FILE *file = fopen("trace.json", "w");
+	 * lwiot::Tracer::write(file);
+	 * @endcode
+	 */
+	class Tracer {
+	public:
+		/**
+		 * @brief Output callback of write().
+		 * @return False to stop writing.
+		 */
+		typedef Function<bool(const char *data, size_t length)> Writer;
+
+		/**
+		 * @brief Record a span for the calling thread.
+		 */
+		static void record(const char *name, uint64_t begin, uint64_t end);
+
+		/**
+		 * @brief Name the calling thread in the trace.
+		 * @param name String that outlives the trace.
+		 */
+		static void setThreadName(const char *name);
+
+		/**
+		 * @brief Write the spans recorded since the previous write, as a JSON document.
+		 * @return False if \p writer stopped the output.
+		 */
+		static bool write(const Writer& writer);
+		static bool write(FILE *file);
+		static bool write(Stream& stream);
+
+		/**
+		 * @brief Number of spans that were lost, because they were overwritten before they were
+		 *        written or because their thread had no buffer.
+		 */
+		static size_t dropped();
+	};
+
+	/**
+	 * @brief Records a span from its construction to its destruction.
+	 * @see TRACE_SPAN
+	 */
+	class TraceSpan {
+	public:
+		explicit TraceSpan(const char *name) : _name(name), _begin(Clock::now())
+		{
+		}
+
+		~TraceSpan()
+		{
+			Tracer::record(this->_name, this->_begin, Clock::now());
+		}
+
+		TraceSpan(const TraceSpan&) = delete;
+		TraceSpan& operator=(const TraceSpan&) = delete;
+
+	private:
+		const char *_name;
+		uint64_t _begin;
+	};
+}
@@ -0,0 +1,274 @@
+#!/usr/bin/env python3
+#
+# Turn tokenized log records back into text
+#
+# Author: Michel Megens
+# Email:  dev@bietje.net
+# Date:   15/10/2026
+#
+
+# pylint: disable=C0330,W0312,C0111,C0103,W0702
+
+import re
+import sys
+import csv
+import struct
+import argparse
+
+SECTION = 'lwiot_tokens'
+LEVELS = ['debug', 'info', 'warning', 'error']
+FIELD = re.compile(r'\{\{|\}\}|\{(?::(?:\.([0-9]))?([xXbo])?)?\}')
+
+KIND_SIGNED = 1
+KIND_UNSIGNED = 2
+KIND_FLOAT = 3
+KIND_CHAR = 4
+KIND_BOOL = 5
+KIND_STRING = 6
+KIND_POINTER = 7
+KIND_DOUBLE = 8
+
+
+class DecodeError(Exception):
+	pass
+
+
+def token_of(fmt):
+	value = 2166136261
+
+	for byte in fmt.encode('utf-8'):
+		value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+
+	return value
+
+
+def read_elf_strings(path):
+	with open(path, 'rb') as elf:
+		data = elf.read()
+
+	if data[:4] != b'\x7fELF':
+		raise DecodeError('%s is not an ELF file' % path)
+
+	order = '<' if data[5] == 1 else '>'
+
+	if data[4] == 2:
+		shoff, = struct.unpack_from(order + 'Q', data, 0x28)
+		shentsize, shnum, shstrndx = struct.unpack_from(order + 'HHH', data, 0x3A)
+		header = order + 'IIQQQQIIQQ'
+	else:
+		shoff, = struct.unpack_from(order + 'I', data, 0x20)
+		shentsize, shnum, shstrndx = struct.unpack_from(order + 'HHH', data, 0x2E)
+		header = order + 'IIIIIIIIII'
+
+	sections = [struct.unpack_from(header, data, shoff + idx * shentsize) for idx in range(shnum)]
+	names = sections[shstrndx]
+	strings = []
+
+	for section in sections:
+		start = names[4] + section[0]
+		name = data[start:data.index(b'\0', start)].decode('ascii')
+
+		if name != SECTION:
+			continue
+
+		content = data[section[4]:section[4] + section[5]]
+		strings += [entry.decode('utf-8') for entry in content.split(b'\0') if entry]
+
+	return strings
+
+
+def load_database(path):
+	tokens = {}
+
+	try:
+		strings = read_elf_strings(path)
+	except DecodeError:
+		with open(path, 'r') as db:
+			strings = [row[1] for row in csv.reader(db) if len(row) >= 2]
+
+	for fmt in strings:
+		token = token_of(fmt)
+
+		if token in tokens and tokens[token] != fmt:
+			sys.stderr.write('Token collision: "%s" and "%s"\n' % (tokens[token], fmt))
+
+		tokens[token] = fmt
+
+	return tokens
+
+
+def read_varint(data, idx):
+	value = 0
+	shift = 0
+
+	while True:
+		if idx >= len(data):
+			raise DecodeError('Truncated integer')
+
+		byte = data[idx]
+		value |= (byte & 0x7F) << shift
+		shift += 7
+		idx += 1
+
+		if byte < 0x80:
+			return value, idx
+
+
+def decode_record(payload):
+	token, = struct.unpack_from('<I', payload, 0)
+	tick, idx = read_varint(payload, 4)
+	level = payload[idx] >> 4
+	num = payload[idx] & 0xF
+	idx += 1
+
+	kinds = []
+
+	for arg in range(num):
+		byte = payload[idx + arg // 2]
+		kinds.append(byte >> 4 if arg & 1 else byte & 0xF)
+
+	idx += (num + 1) // 2
+	args = []
+
+	for kind in kinds:
+		if kind == KIND_FLOAT:
+			args.append((kind, struct.unpack_from('<f', payload, idx)[0]))
+			idx += 4
+		elif kind == KIND_DOUBLE:
+			args.append((kind, struct.unpack_from('<d', payload, idx)[0]))
+			idx += 8
+		elif kind == KIND_STRING:
+			length, idx = read_varint(payload, idx)
+			args.append((kind, payload[idx:idx + length].decode('utf-8', 'replace')))
+			idx += length
+		else:
+			value, idx = read_varint(payload, idx)
+
+			if kind == KIND_SIGNED:
+				value = (value >> 1) ^ -(value & 1)
+
+			args.append((kind, value))
+
+	return token, tick, level, args
+
+
+def format_arg(kind, value, precision, base):
+	if kind == KIND_CHAR:
+		return chr(value)
+
+	if kind == KIND_BOOL:
+		return 'true' if value else 'false'
+
+	if kind == KIND_STRING:
+		return value
+
+	if kind == KIND_POINTER:
+		return '0x%x' % value
+
+	if kind in (KIND_FLOAT, KIND_DOUBLE):
+		return '%.*f' % (6 if precision is None else int(precision), value)
+
+	if base is None:
+		return str(value)
+
+	digits = {'x': '%x', 'X': '%X', 'o': '%o'}.get(base)
+	text = digits % abs(value) if digits else bin(abs(value))[2:]
+
+	return '-' + text if value < 0 else text
+
+
+def format_record(fmt, args):
+	args = list(args)
+
+	def field(match):
+		if match.group(0) in ('{{', '}}'):
+			return match.group(0)[0]
+
+		if not args:
+			return match.group(0)
+
+		kind, value = args.pop(0)
+		return format_arg(kind, value, match.group(1), match.group(2))
+
+	return FIELD.sub(field, fmt)
+
+
+def decode(tokens, data, output):
+	idx = 0
+	line_open = False
+
+	while idx < len(data):
+		length = data[idx]
+		payload = data[idx + 1:idx + 1 + length]
+		idx += length + 1
+
+		if len(payload) < length:
+			break
+
+		token, tick, level, args = decode_record(payload)
+
+		# Text from a Logger: the subsystem, the text and the LogRecord flags.
+		if token == 0 and len(args) == 3:
+			subsystem, text, flags = args[0][1], args[1][1], args[2][1]
+
+			if flags & 1:
+				if subsystem:
+					output.write('[%u][lwiot][%s]: ' % (tick, subsystem))
+				else:
+					output.write('[%u][lwIoT]: ' % tick)
+
+			output.write(text)
+			line_open = not flags & 2
+
+			if not line_open:
+				output.write('\n')
+			continue
+
+		if line_open:
+			output.write('\n')
+			line_open = False
+
+		if token not in tokens:
+			output.write('[%u][%s]: <unknown token 0x%08x>\n' % (tick, LEVELS[level & 3], token))
+			continue
+
+		output.write('[%u][%s]: %s\n' % (tick, LEVELS[level & 3], format_record(tokens[token], args)))
+
+
+def main():
+	parser = argparse.ArgumentParser(description='Tokenized log tool')
+	commands = parser.add_subparsers(dest='command')
+
+	tokens = commands.add_parser('tokens', help='Write the token database of a firmware image')
+	tokens.add_argument('elf', help='Firmware image')
+	tokens.add_argument('-o', '--output', help='CSV file to write', required=True)
+
+	decoder = commands.add_parser('decode', help='Decode tokenized log records')
+	decoder.add_argument('database', help='Firmware image or token database')
+	decoder.add_argument('input', nargs='?', help='Captured records, standard input by default')
+
+	args = parser.parse_args()
+
+	if args.command == 'tokens':
+		database = load_database(args.elf)
+
+		with open(args.output, 'w') as output:
+			writer = csv.writer(output, lineterminator='\n')
+
+			for token, fmt in sorted(database.items()):
+				writer.writerow(['%08x' % token, fmt])
+	elif args.command == 'decode':
+		database = load_database(args.database)
+
+		if args.input:
+			with open(args.input, 'rb') as data:
+				decode(database, data.read(), sys.stdout)
+		else:
+			decode(database, sys.stdin.buffer.read(), sys.stdout)
+	else:
+		parser.print_help()
+		sys.exit(1)
+
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,143 @@
+/*
+ * Wall clock cache on top of a real time clock.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/realtimeclock.h>
+#include <lwiot/cachedclock.h>
+
+namespace lwiot
+{
+	CachedClock::CachedClock(RealTimeClock &rtc, time_t resync) : _rtc(rtc), _interval(resync), _valid(false),
+		_stale(false), _base_tick(0), _base(0), _anchor_tick(0), _anchor(0), _last(0), _drift(0)
+	{
+	}
+
+	int64_t CachedClock::estimate(time_t tick) const
+	{
+		auto elapsed = static_cast<int64_t>(tick - this->_base_tick);
+
+		return this->_base + elapsed + elapsed * this->_drift / 1000000;
+	}
+
+	/* Start measuring the drift from \p time onwards. */
+	void CachedClock::anchor(int64_t time, time_t tick)
+	{
+		this->_anchor = this->_base = time;
+		this->_anchor_tick = this->_base_tick = tick;
+		this->_valid = true;
+	}
+
+	void CachedClock::discipline(time_t epoch, time_t tick)
+	{
+		auto low = static_cast<int64_t>(epoch) * 1000;
+		auto high = low + 999;
+
+		if(!this->_valid) {
+			this->anchor(low, tick);
+			return;
+		}
+
+		auto estimate = this->estimate(tick);
+		auto corrected = estimate < low ? low : (estimate > high ? high : estimate);
+		auto error = corrected - estimate;
+		auto span = static_cast<int64_t>(tick - this->_anchor_tick);
+		auto elapsed = static_cast<int64_t>(tick - this->_base_tick);
+
+		/* More than drift can explain: the reference was changed. Start over. */
+		if(error > 1000 + elapsed * CONFIG_CLOCK_MAX_DRIFT / 1000000 ||
+			-error > 1000 + elapsed * CONFIG_CLOCK_MAX_DRIFT / 1000000) {
+			this->anchor(low, tick);
+			this->_drift = 0;
+			this->_last = 0;
+			return;
+		}
+
+		/*
+		 * The reference only counts whole seconds, so the rate is measured over everything since
+		 * the anchor, which makes the error of the measurement shrink over time.
+		 */
+		if(span >= static_cast<int64_t>(this->_interval) && span > 0) {
+			auto drift = ((corrected - this->_anchor) - span) * 1000000 / span;
+
+			if(drift > CONFIG_CLOCK_MAX_DRIFT)
+				drift = CONFIG_CLOCK_MAX_DRIFT;
+			else if(drift < -CONFIG_CLOCK_MAX_DRIFT)
+				drift = -CONFIG_CLOCK_MAX_DRIFT;
+
+			this->_drift = static_cast<int32_t>(drift);
+		}
+
+		this->_base = corrected;
+		this->_base_tick = tick;
+	}
+
+	int64_t CachedClock::current()
+	{
+		auto tick = lwiot_tick_ms();
+
+		if(!this->_valid || this->_stale || tick - this->_base_tick >= this->_interval) {
+			this->discipline(this->_rtc.now().timestamp(), tick);
+			this->_stale = false;
+		}
+
+		auto time = this->estimate(tick);
+
+		if(time < this->_last)
+			return this->_last;
+
+		this->_last = time;
+		return time;
+	}
+
+	DateTime CachedClock::now()
+	{
+		ScopedLock lock(this->_lock);
+		return DateTime(static_cast<time_t>(this->current() / 1000));
+	}
+
+	time_t CachedClock::milliseconds()
+	{
+		ScopedLock lock(this->_lock);
+		return static_cast<time_t>(this->current());
+	}
+
+	void CachedClock::set(const DateTime &dt)
+	{
+		ScopedLock lock(this->_lock);
+
+		this->_rtc.set(dt);
+		this->anchor(static_cast<int64_t>(dt.timestamp()) * 1000, lwiot_tick_ms());
+		this->_drift = 0;
+		this->_last = 0;
+	}
+
+	void CachedClock::sync(time_t epoch)
+	{
+		ScopedLock lock(this->_lock);
+
+		this->discipline(epoch, lwiot_tick_ms());
+		this->_rtc.set(DateTime(epoch));
+	}
+
+	void CachedClock::invalidate()
+	{
+		ScopedLock lock(this->_lock);
+
+		this->_stale = true;
+	}
+
+	int32_t CachedClock::drift() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_drift;
+	}
+}
@@ -12,6 +12,7 @@
 #include <lwiot/types.h>
 #include <lwiot/realtimeclock.h>
 #include <lwiot/util/datetime.h>
+#include <lwiot/stl/smallvector.h>
 #include <lwiot/device/dsrealtimeclock.h>
 
 #define RTC_SECONDS 0x00
@@ -105,7 +106,7 @@ namespace lwiot
 	DateTime DsRealTimeClock::now()
 	{
 		I2CMessage tx(1), rx(ReadLength);
-		stl::Vector<I2CMessage> msgs;
+		stl::SmallVector<I2CMessage, 2> msgs;
 		struct tm tm{};
 		time_t stamp;
 
@@ -188,7 +189,7 @@ namespace lwiot
 	uint8_t DsRealTimeClock::read(uint8_t addr)
 	{
 		I2CMessage tx(1), rx(1);
-		stl::Vector<I2CMessage> msgs;
+		stl::SmallVector<I2CMessage, 2> msgs;
 
 		tx.setAddress(SlaveAddress, false);
 		tx.markAsReadOperation(false);
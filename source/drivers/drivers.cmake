@@ -1,6 +1,7 @@
 SET(DRIVER_SOURCES
 	drivers/clock/realtimeclock.cpp
 	drivers/clock/dsrealtimeclock.cpp
+	drivers/clock/cachedclock.cpp
 
 	drivers/clock/dsrealtimeclock.cpp
 	drivers/clock/realtimeclock.cpp
@@ -7,109 +7,120 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <lwiot.h>
 
 #include <lwiot/types.h>
 #include <lwiot/error.h>
 #include <lwiot/io/i2cbus.h>
 #include <lwiot/io/i2cmessage.h>
+#include <lwiot/stl/smallvector.h>
 #include <lwiot/device/eeprom24c02.h>
-#include <lwiot/scopedlock.h>
 
 namespace lwiot
 {
-	Eeprom24C02::Eeprom24C02(lwiot::I2CBus &bus) : _bus(bus), _lock(false)
+	Eeprom24C02::Eeprom24C02(lwiot::I2CBus &bus) : BlockDevice(Eeprom24C02::Size, Eeprom24C02::PageSize),
+		_bus(bus), _busy(false)
 	{
 	}
 
-	void Eeprom24C02::write(uint8_t addr, uint8_t byte)
+	Eeprom24C02::~Eeprom24C02()
 	{
-		uint8_t data[] = {addr, byte};
-		ScopedLock lock(this->_lock);
+		this->flush();
+	}
 
-		this->_bus.send(Eeprom24C02::SlaveAddress, data, sizeof(data));
+	void Eeprom24C02::write(uint8_t addr, uint8_t byte)
+	{
+		if(this->write(addr, &byte, sizeof(byte)) < 0) {
+			print_dbg("Unable to write byte to 24C02!\n");
+		}
 	}
 
 	uint8_t Eeprom24C02::read(uint8_t addr)
 	{
-		I2CMessage rx(1);
-		I2CMessage tx(1);
-		stl::Vector<I2CMessage> msgs;
-		ScopedLock lock(this->_lock);
+		uint8_t byte = 0;
 
-		tx.setRepeatedStart(true);
-		tx.write(addr);
-		tx.setAddress(Eeprom24C02::SlaveAddress, false, false);
-		rx.setAddress(Eeprom24C02::SlaveAddress, false, true);
-
-		msgs.pushback(stl::move(tx));
-		msgs.pushback(stl::move(rx));
-
-		if(!this->_bus.transfer(msgs) || rx.length() == 0UL) {
-			print_dbg("Unable to read byte from 24C02! Msg size: %u\n", rx.available());
-			return 0;
+		if(this->read(addr, &byte, sizeof(byte)) < 0) {
+			print_dbg("Unable to read byte from 24C02!\n");
 		}
 
-		rx = stl::move(msgs.back());
-		return rx.at(0);
+		return byte;
 	}
 
-	ssize_t Eeprom24C02::write(uint8_t addr, const void *data, size_t length)
+	bool Eeprom24C02::poll()
 	{
-		size_t idx;
-		uint8_t  address, current;
-		const uint8_t *ptr;
+		if(!this->_busy)
+			return true;
 
-		current = length < Eeprom24C02::PageSize ? static_cast<uint8_t>(length) : Eeprom24C02::PageSize;
-		length -= current;
-		address = addr;
-		ptr = static_cast<const uint8_t *>(data);
-		idx = 0UL;
+		auto start = lwiot_tick_ms();
 
+		/* The chip does not acknowledge its address until the page write finished. */
 		do {
-			I2CMessage msg(current + 1);
-
-			msg.write(address);
-			for(auto i = 0UL; i < current; i++) {
-				msg.write(ptr[idx++]);
-			}
+			I2CMessage msg(1);
 
+			msg.writeUnchecked(0);
 			msg.setAddress(Eeprom24C02::SlaveAddress, false, false);
-			if(!this->_bus.transfer(msg)) {
-				print_dbg("Unable to write bytes to 24C02 chip!\n");
-				return -EINVALID;
+
+			if(this->_bus.transfer(msg)) {
+				this->_busy = false;
+				return true;
 			}
+		} while(lwiot_tick_ms() - start < CONFIG_EEPROM_WRITE_TIME);
+
+		print_dbg("24C02 did not finish its page write!\n");
+		this->_busy = false;
+		return false;
+	}
+
+	bool Eeprom24C02::writeBurst(size_t addr, const void *data, size_t length)
+	{
+		I2CMessage msg(length + 1);
+
+		if(!this->poll())
+			return false;
+
+		msg.writeUnchecked(static_cast<uint8_t>(addr));
+		msg.writeUnchecked(static_cast<const uint8_t *>(data), length);
+		msg.setAddress(Eeprom24C02::SlaveAddress, false, false);
 
-			address += current;
-			current = length < Eeprom24C02::PageSize ? static_cast<uint8_t>(length) : Eeprom24C02::PageSize;
-			length -= current;
-			lwiot_sleep(10);
-		} while(current > 0);
+		if(!this->_bus.transfer(msg)) {
+			print_dbg("Unable to write bytes to 24C02 chip!\n");
+			return false;
+		}
 
-		return length;
+		this->_busy = true;
+		return true;
 	}
 
-	ssize_t Eeprom24C02::read(uint8_t addr, void *data, size_t length)
+	bool Eeprom24C02::readBurst(size_t addr, void *data, size_t length)
 	{
 		I2CMessage tx(1), rx(length);
-		stl::Vector<I2CMessage> msgs;
-		ScopedLock lock(this->_lock);
+		stl::SmallVector<I2CMessage, 2> msgs;
+
+		if(!this->poll())
+			return false;
 
 		tx.setRepeatedStart(true);
 		tx.setAddress(Eeprom24C02::SlaveAddress, false, false);
-		tx.write(addr);
+		tx.write(static_cast<uint8_t>(addr));
 		rx.setAddress(Eeprom24C02::SlaveAddress, false, true);
 
 		msgs.pushback(stl::move(tx));
 		msgs.pushback(stl::move(rx));
 
-		if(!this->_bus.transfer(msgs) || rx.length() != length) {
-			print_dbg("Failed to read from 24C02. Received length: %lu\n", rx.length());
-			return -EINVALID;
+		if(!this->_bus.transfer(msgs)) {
+			print_dbg("Failed to read from 24C02!\n");
+			return false;
 		}
 
 		rx = stl::move(msgs.back());
-		memcpy(data, rx.data(), rx.length());
-		return rx.length();
+
+		if(rx.length() != length) {
+			print_dbg("Failed to read from 24C02. Received length: %lu\n", rx.length());
+			return false;
+		}
+
+		memcpy(data, rx.data(), length);
+		return true;
 	}
 }
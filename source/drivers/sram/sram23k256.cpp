@@ -7,6 +7,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <lwiot.h>
 
 #include <lwiot/types.h>
@@ -35,14 +36,20 @@
 
 namespace lwiot
 {
-	SRAM23K256::SRAM23K256(int cs) : _cs(cs)
+	SRAM23K256::SRAM23K256(int cs) : BlockDevice(SRAM23K256::Size, SRAM23K256::Size), _cs(cs)
 	{
 	}
 
-	SRAM23K256::SRAM23K256(lwiot::SpiBus &bus, int cs) : _bus(bus), _cs(cs)
+	SRAM23K256::SRAM23K256(lwiot::SpiBus &bus, int cs) : BlockDevice(SRAM23K256::Size, SRAM23K256::Size),
+		_bus(bus), _cs(cs)
 	{
 	}
 
+	SRAM23K256::~SRAM23K256()
+	{
+		this->flush();
+	}
+
 	void SRAM23K256::mode(uint16_t mode)
 	{
 		SpiMessage msg(2, this->_cs);
@@ -56,41 +63,58 @@ namespace lwiot
 		}
 	}
 
-	void SRAM23K256::write(size_t addr, const lwiot::ByteBuffer &buffer)
+	void SRAM23K256::command(SpiMessage& msg, uint8_t cmd, size_t addr) const
 	{
-		SpiMessage msg(buffer.count() + 3, this->_cs);
+		msg << cmd;
+		msg << static_cast<uint8_t>((addr >> 8) & 0xFF);
+		msg << static_cast<uint8_t>(addr & 0xFF);
+		msg.setHold(true);
+	}
 
-		auto& tx = msg.txdata();
-		tx.write(WRDA);
-		tx.write((addr >> 8) & 0xFF);
-		tx.write(addr & 0xFF);
+	bool SRAM23K256::writeBurst(size_t addr, const void *data, size_t length)
+	{
+		stl::Vector<SpiMessage> msgs;
 
-		buffer.foreach([&tx](uint8_t value) {
-			tx.write(value);
-		});
+		msgs.reserve(2);
+		this->command(msgs.emplace_back(3, this->_cs), WRDA, addr);
+		msgs.emplace_back(length, this->_cs).txdata().write(data, length);
 
-		if(!this->_bus->transfer(msg)) {
+		if(!this->_bus->transfer(msgs)) {
 			print_dbg("Unable to write data to SRAM chip!\n");
+			return false;
 		}
+
+		return true;
 	}
 
-	ByteBuffer SRAM23K256::read(size_t addr, size_t length)
+	bool SRAM23K256::readBurst(size_t addr, void *data, size_t length)
 	{
-		SpiMessage msg(length+3, this->_cs);
-		ByteBuffer rv(length);
-		auto& tx = msg.txdata();
+		stl::Vector<SpiMessage> msgs;
 
-		tx.write(RDDA);
-		tx.write((addr >> 8) & 0xFF);
-		tx.write( addr & 0xFF);
+		msgs.reserve(2);
+		this->command(msgs.emplace_back(3, this->_cs), RDDA, addr);
+		msgs.emplace_back(length, this->_cs);
 
-		if(!this->_bus->transfer(msg)) {
+		if(!this->_bus->transfer(msgs)) {
 			print_dbg("Unable to read from SRAM chip!\n");
-			return stl::move(rv);
+			return false;
 		}
 
-		auto data = msg.rxdata().data();
-		rv.write(data + 3, length);
+		memcpy(data, msgs[1].rxdata().data(), length);
+		return true;
+	}
+
+	void SRAM23K256::write(size_t addr, const lwiot::ByteBuffer &buffer)
+	{
+		this->write(addr, buffer.data(), buffer.index());
+	}
+
+	ByteBuffer SRAM23K256::read(size_t addr, size_t length)
+	{
+		ByteBuffer rv(length);
+
+		if(this->read(addr, rv.data(), length) == static_cast<ssize_t>(length))
+			rv.setIndex(length);
 
 		return stl::move(rv);
 	}
@@ -20,6 +20,7 @@ void lwiot_init(void)
 	srand(time(NULL));
 	log_init(stdout);
 	lwiot_timers_init();
+	lwiot_delay_calibrate();
 
 #ifdef CONFIG_STANDALONE
 	no_os_init();
@@ -32,4 +32,18 @@ namespace lwiot
 	{
 		return this->read(pin);
 	}
+
+	bool AdcChip::startContinuous(const int *pins, size_t num, uint32_t rate, AdcSampler& sampler)
+	{
+		UNUSED(pins);
+		UNUSED(num);
+		UNUSED(rate);
+		UNUSED(sampler);
+
+		return false;
+	}
+
+	void AdcChip::stopContinuous()
+	{
+	}
 }
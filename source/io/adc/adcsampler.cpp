@@ -0,0 +1,171 @@
+/*
+ * Continuous ADC sampler.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/kernel/uniquelock.h>
+#include <lwiot/kernel/deadlinetimer.h>
+
+#include <lwiot/io/adcchip.h>
+#include <lwiot/io/adcsampler.h>
+
+namespace lwiot
+{
+	AdcSampler::AdcSampler(AdcChip& chip) : Thread("adc"), _chip(chip), _lock(false),
+		_ready(EventType::Counting, 1), _rate(0), _buffer(nullptr), _length(0), _block(0),
+		_head(0), _tail(0), _skip(0), _overruns(0), _running(false), _hardware(false)
+	{
+	}
+
+	AdcSampler::~AdcSampler()
+	{
+		this->end();
+	}
+
+	bool AdcSampler::begin(const stl::Vector<int>& pins, uint32_t rate, uint16_t *buffer, size_t length,
+						   size_t block, const BlockHandler& handler)
+	{
+		if(pins.size() == 0 || rate == 0 || buffer == nullptr)
+			return false;
+
+		if(block == 0 || block % pins.size() != 0 || length == 0 || length % block != 0)
+			return false;
+
+		ScopedLock lock(this->_lock);
+
+		if(this->_running)
+			return false;
+
+		this->_pins = pins;
+		this->_rate = rate;
+		this->_handler = handler;
+		this->_buffer = buffer;
+		this->_length = length;
+		this->_block = block;
+
+		this->_head = 0;
+		this->_tail = 0;
+		this->_skip = 0;
+		this->_overruns = 0;
+
+		this->_hardware = this->_chip.startContinuous(this->_pins.data(), this->_pins.size(), rate, *this);
+		this->_running = true;
+		this->start();
+
+		return true;
+	}
+
+	void AdcSampler::end()
+	{
+		UniqueLock<Lock> lock(this->_lock);
+
+		if(!this->_running)
+			return;
+
+		this->_running = false;
+		lock.unlock();
+
+		if(this->_hardware)
+			this->_chip.stopContinuous();
+
+		this->_ready.signal();
+		this->join();
+	}
+
+	size_t AdcSampler::overruns() const
+	{
+		return this->_overruns;
+	}
+
+	uint32_t AdcSampler::rate() const
+	{
+		return this->_rate;
+	}
+
+	const stl::Vector<int>& AdcSampler::pins() const
+	{
+		return this->_pins;
+	}
+
+	void RAM_ATTR AdcSampler::push(uint16_t sample)
+	{
+		auto head = this->_head;
+
+		if(this->_skip > 0) {
+			this->_skip = this->_skip - 1;
+			return;
+		}
+
+		/* Drop whole blocks, so that the samples stay in pin order. */
+		if(head % this->_block == 0 && head - this->_tail >= this->_length) {
+			this->_overruns = this->_overruns + 1;
+			this->_skip = this->_block - 1;
+			return;
+		}
+
+		this->_buffer[head % this->_length] = sample;
+		this->_head = ++head;
+
+		if(this->_hardware && head % this->_block == 0)
+			this->_ready.signalFromIrq();
+	}
+
+	void AdcSampler::sample()
+	{
+		for(auto pin : this->_pins)
+			this->push(static_cast<uint16_t>(this->_chip.read(pin)));
+	}
+
+	void AdcSampler::dispatch()
+	{
+		while(this->_head - this->_tail >= this->_block) {
+			this->_handler(this->_buffer + this->_tail % this->_length, this->_block);
+			this->_tail = this->_tail + this->_block;
+		}
+	}
+
+	void AdcSampler::run()
+	{
+		DeadlineTimer deadline;
+
+		if(this->_hardware) {
+			while(this->_running) {
+				this->_ready.wait(100);
+				this->dispatch();
+			}
+
+			return;
+		}
+
+		const auto period = lwiot_delay_ns_to_cycles(1000000000UL / this->_rate);
+		const auto ms = lwiot_delay_ns_to_cycles(1000000);
+
+		while(this->_running) {
+			this->sample();
+			this->dispatch();
+
+			auto next = deadline.deadline() + period;
+			auto now = lwiot_delay_counter();
+
+			if(static_cast<int64_t>(next - now) < 0) {
+				/* Skip the frames that were missed rather than taking them late. */
+				next += ((now - next) / period + 1) * period;
+				this->_overruns = this->_overruns + 1;
+			}
+
+			if(next - now > 2 * ms)
+				lwiot_sleep(static_cast<int>((next - now) / ms) - 1);
+
+			deadline.expiresAt(next);
+			deadline.wait();
+		}
+	}
+}
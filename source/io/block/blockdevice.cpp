@@ -0,0 +1,174 @@
+/*
+ * Byte addressable block device.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/error.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/io/blockdevice.h>
+
+namespace lwiot
+{
+	BlockDevice::BlockDevice(size_t size, size_t page) : _lock(false), _size(size), _page(page),
+		_start(0), _end(0), _ahead_addr(0), _ahead_length(0)
+	{
+		this->_unit = page < CONFIG_BLOCK_DEVICE_CACHE ? page : CONFIG_BLOCK_DEVICE_CACHE;
+	}
+
+	size_t BlockDevice::size() const
+	{
+		return this->_size;
+	}
+
+	size_t BlockDevice::pageSize() const
+	{
+		return this->_page;
+	}
+
+	ssize_t BlockDevice::read(size_t addr, void *data, size_t length)
+	{
+		auto out = static_cast<uint8_t *>(data);
+
+		if(addr + length > this->_size || addr + length < addr)
+			return -EINVALID;
+
+		ScopedLock lock(this->_lock);
+
+		if(length < CONFIG_BLOCK_DEVICE_READAHEAD) {
+			if(addr < this->_ahead_addr || addr + length > this->_ahead_addr + this->_ahead_length) {
+				auto ahead = this->_size - addr;
+
+				if(ahead > CONFIG_BLOCK_DEVICE_READAHEAD)
+					ahead = CONFIG_BLOCK_DEVICE_READAHEAD;
+
+				this->_ahead_length = 0;
+
+				if(!this->readBurst(addr, this->_ahead, ahead))
+					return -EINVALID;
+
+				this->_ahead_addr = addr;
+				this->_ahead_length = ahead;
+				this->update(this->_start, this->_cache + this->_start % this->_unit, this->_end - this->_start);
+			}
+
+			memcpy(out, this->_ahead + (addr - this->_ahead_addr), length);
+			return length;
+		}
+
+		if(!this->readBurst(addr, out, length))
+			return -EINVALID;
+
+		/* Cached data is newer than the data on the chip. */
+		auto start = this->_start > addr ? this->_start : addr;
+		auto end = this->_end < addr + length ? this->_end : addr + length;
+
+		if(start < end)
+			memcpy(out + (start - addr), this->_cache + start % this->_unit, end - start);
+
+		return length;
+	}
+
+	ssize_t BlockDevice::write(size_t addr, const void *data, size_t length)
+	{
+		auto in = static_cast<const uint8_t *>(data);
+		auto rv = length;
+
+		if(addr + length > this->_size || addr + length < addr)
+			return -EINVALID;
+
+		ScopedLock lock(this->_lock);
+
+		this->update(addr, in, length);
+
+		while(length > 0) {
+			size_t num;
+
+			if(addr % this->_unit == 0 && length >= this->_unit) {
+				auto page = this->_page - addr % this->_page;
+
+				num = length - length % this->_unit;
+				num = num < page ? num : page;
+
+				/* Whole units replace whatever was cached for them. */
+				if(this->_start >= addr && this->_end <= addr + num)
+					this->_start = this->_end = 0;
+
+				if(!this->writeBurst(addr, in, num))
+					return -EINVALID;
+			} else {
+				num = this->_unit - addr % this->_unit;
+				num = num < length ? num : length;
+
+				if(!this->cache(addr, in, num)) {
+					if(!this->writeback())
+						return -EINVALID;
+
+					this->cache(addr, in, num);
+				}
+
+				if(this->_end - this->_start == this->_unit && !this->writeback())
+					return -EINVALID;
+			}
+
+			addr += num;
+			in += num;
+			length -= num;
+		}
+
+		return rv;
+	}
+
+	bool BlockDevice::flush()
+	{
+		ScopedLock lock(this->_lock);
+		return this->writeback();
+	}
+
+	bool BlockDevice::cache(size_t addr, const uint8_t *data, size_t length)
+	{
+		auto end = addr + length;
+
+		if(this->_start == this->_end) {
+			this->_start = addr;
+			this->_end = end;
+		} else if(addr / this->_unit == this->_start / this->_unit && addr <= this->_end && end >= this->_start) {
+			this->_start = addr < this->_start ? addr : this->_start;
+			this->_end = end > this->_end ? end : this->_end;
+		} else {
+			return false;
+		}
+
+		memcpy(this->_cache + addr % this->_unit, data, length);
+		return true;
+	}
+
+	bool BlockDevice::writeback()
+	{
+		if(this->_start == this->_end)
+			return true;
+
+		auto ok = this->writeBurst(this->_start, this->_cache + this->_start % this->_unit, this->_end - this->_start);
+
+		this->_start = this->_end = 0;
+		return ok;
+	}
+
+	void BlockDevice::update(size_t addr, const uint8_t *data, size_t length)
+	{
+		auto start = this->_ahead_addr > addr ? this->_ahead_addr : addr;
+		auto end = this->_ahead_addr + this->_ahead_length;
+
+		end = end < addr + length ? end : addr + length;
+
+		if(start < end)
+			memcpy(this->_ahead + (start - this->_ahead_addr), data + (start - addr), end - start);
+	}
+}
@@ -9,16 +9,25 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 #include <lwiot.h>
 
+#ifdef HAVE_STAT_H
+#include <sys/stat.h>
+#endif
+
+#include <lwiot/error.h>
 #include <lwiot/scopedlock.h>
 #include <lwiot/stream.h>
+#include <lwiot/bytebuffer.h>
 
 #include <lwiot/io/file.h>
 
 namespace lwiot
 {
-	File::File(const lwiot::String &fname, lwiot::FileMode mode) : _lock(new Lock(false)), _mode(mode)
+	File::File(const lwiot::String &fname, lwiot::FileMode mode, size_t buffer) : _lock(makeShared<Lock>(false)),
+		_name(fname), _mode(mode), _size(0), _buffer(nullptr), _capacity(0), _offset(0), _start(0), _length(0),
+		_dirty(false), _append(mode == FileMode::Append || mode == FileMode::ReadWriteAppend)
 	{
 		char fmode[3] = {0,0,0};
 
@@ -29,18 +38,33 @@ namespace lwiot
 			return;
 
 		fseek(this->_io, 0L, SEEK_END);
-		this->_available = ftell(this->_io);
+		this->_size = ftell(this->_io);
 		fseek(this->_io, 0L, SEEK_SET);
+
+		if(buffer == 0)
+			return;
+
+		this->_buffer = static_cast<uint8_t*>(lwiot_mem_alloc(buffer));
+
+		if(this->_buffer == nullptr)
+			return;
+
+		/* Replace the stdio buffer, rather than copying everything twice. */
+		setvbuf(this->_io, nullptr, _IONBF, 0);
+		this->_capacity = buffer;
 	}
 
 	File::~File()
 	{
 		ScopedLock lock(this->_lock.get());
 
-		if(this->_io == nullptr)
-			return;
+		if(this->_io != nullptr) {
+			this->commit();
+			fclose(this->_io);
+		}
 
-		fclose(this->_io);
+		if(this->_buffer != nullptr)
+			lwiot_mem_free(this->_buffer);
 	}
 
 	void File::fileModeToString(lwiot::FileMode mode, char *m)
@@ -80,10 +104,241 @@ namespace lwiot
 		strcpy(m, tmp);
 	}
 
+	File::operator bool() const
+	{
+		return this->_io != nullptr;
+	}
+
+	const String& File::name() const
+	{
+		return this->_name;
+	}
+
+	size_t File::size() const
+	{
+		return this->_size;
+	}
+
+	time_t File::modified() const
+	{
+#ifdef HAVE_STAT_H
+		struct stat info;
+
+		if(this->_io != nullptr && fstat(fileno(this->_io), &info) == 0)
+			return info.st_mtime;
+#endif
+
+		return 0;
+	}
+
+	bool File::seek(size_t offset)
+	{
+		ScopedLock lock(this->_lock.get());
+
+		if(this->_io == nullptr || offset > this->_size)
+			return false;
+
+		/* Every access seeks the stdio stream itself, so only the position is recorded. */
+		this->_offset = offset;
+		return true;
+	}
+
+	bool File::flush()
+	{
+		ScopedLock lock(this->_lock.get());
+
+		if(this->_io == nullptr)
+			return false;
+
+		return this->commit() && fflush(this->_io) == 0;
+	}
+
+	int File::descriptor() const
+	{
+		return this->_io != nullptr ? fileno(this->_io) : -1;
+	}
+
 	size_t File::available() const
 	{
 		ScopedLock lock(this->_lock.get());
-		return this->_available;
+		return this->_size - this->_offset;
+	}
+
+	bool File::buffered() const
+	{
+		return this->_capacity > 0;
+	}
+
+	bool File::commit()
+	{
+		if(!this->_dirty)
+			return true;
+
+		this->_dirty = false;
+
+		if(!this->_append && fseek(this->_io, static_cast<long>(this->_start), SEEK_SET) != 0) {
+			this->_length = 0;
+			return false;
+		}
+
+		auto rv = fwrite(this->_buffer, 1, this->_length, this->_io) == this->_length;
+
+		this->_length = 0;
+		return rv;
+	}
+
+	bool File::fill()
+	{
+		auto base = this->_offset - this->_offset % this->_capacity;
+
+		this->commit();
+		this->_length = 0;
+
+		if(fseek(this->_io, static_cast<long>(base), SEEK_SET) != 0)
+			return false;
+
+		this->_start = base;
+		this->_length = fread(this->_buffer, 1, this->_capacity, this->_io);
+
+		return this->_offset < this->_start + this->_length;
+	}
+
+	ssize_t File::load(void *output, size_t length)
+	{
+		auto data = static_cast<uint8_t*>(output);
+		size_t num = 0;
+
+		if(this->_io == nullptr)
+			return -EINVALID;
+
+		if(this->_offset + length > this->_size)
+			length = this->_size - this->_offset;
+
+		if(!this->buffered()) {
+			if(fseek(this->_io, static_cast<long>(this->_offset), SEEK_SET) != 0)
+				return -EINVALID;
+
+			num = fread(output, 1, length, this->_io);
+			this->_offset += num;
+
+			return num;
+		}
+
+		this->commit();
+
+		while(num < length) {
+			auto todo = length - num;
+
+			if(this->_length > 0 && this->_offset >= this->_start && this->_offset < this->_start + this->_length) {
+				auto offset = this->_offset - this->_start;
+				auto chunk = this->_length - offset;
+
+				if(chunk > todo)
+					chunk = todo;
+
+				memcpy(data + num, this->_buffer + offset, chunk);
+				this->_offset += chunk;
+				num += chunk;
+				continue;
+			}
+
+			/* Read whole blocks straight into the output buffer. */
+			if(todo >= this->_capacity && this->_offset % this->_capacity == 0) {
+				todo -= todo % this->_capacity;
+
+				if(fseek(this->_io, static_cast<long>(this->_offset), SEEK_SET) != 0)
+					break;
+
+				auto rv = fread(data + num, 1, todo, this->_io);
+
+				this->_offset += rv;
+				num += rv;
+
+				if(rv != todo)
+					break;
+
+				continue;
+			}
+
+			if(!this->fill())
+				break;
+		}
+
+		return num;
+	}
+
+	ssize_t File::store(const void *input, size_t length)
+	{
+		auto data = static_cast<const uint8_t*>(input);
+		auto pos = this->_append ? this->_size : this->_offset;
+		size_t num = 0;
+
+		if(this->_io == nullptr)
+			return -EINVALID;
+
+		if(!this->buffered()) {
+			if(!this->_append && fseek(this->_io, static_cast<long>(pos), SEEK_SET) != 0)
+				return -EINVALID;
+
+			num = fwrite(input, 1, length, this->_io);
+			pos += num;
+		} else {
+			/* Drop read data, the write might overlap it. */
+			if(!this->_dirty)
+				this->_length = 0;
+
+			while(num < length) {
+				auto todo = length - num;
+
+				if(this->_dirty && pos != this->_start + this->_length && !this->commit())
+					break;
+
+				if(!this->_dirty) {
+					this->_start = pos;
+					this->_length = 0;
+				}
+
+				/* Only fill up to the next block boundary, so that every write is aligned. */
+				auto limit = this->_capacity - this->_start % this->_capacity;
+
+				if(this->_length == 0 && todo >= this->_capacity && pos % this->_capacity == 0) {
+					todo -= todo % this->_capacity;
+
+					if(!this->_append && fseek(this->_io, static_cast<long>(pos), SEEK_SET) != 0)
+						break;
+
+					auto rv = fwrite(data + num, 1, todo, this->_io);
+
+					pos += rv;
+					num += rv;
+
+					if(rv != todo)
+						break;
+
+					continue;
+				}
+
+				if(todo > limit - this->_length)
+					todo = limit - this->_length;
+
+				memcpy(this->_buffer + this->_length, data + num, todo);
+				this->_length += todo;
+				this->_dirty = true;
+				pos += todo;
+				num += todo;
+
+				if(this->_length == limit && !this->commit())
+					break;
+			}
+		}
+
+		if(pos > this->_size)
+			this->_size = pos;
+
+		if(!this->_append)
+			this->_offset = pos;
+
+		return num;
 	}
 
 	Stream &File::operator<<(char x)
@@ -172,31 +427,100 @@ namespace lwiot
 	uint8_t File::read()
 	{
 		ScopedLock lock(this->_lock.get());
+		uint8_t byte;
+
+		if(this->load(&byte, sizeof(byte)) != sizeof(byte))
+			return static_cast<uint8_t>(EOF);
 
-		this->_available--;
-		return static_cast<uint8_t>(getc(this->_io));
+		return byte;
 	}
 
 	ssize_t File::read(void *output, const size_t &length)
 	{
 		ScopedLock lock(this->_lock.get());
+		return this->load(output, length);
+	}
+
+	ssize_t File::readUntil(char delim, ByteBuffer& output)
+	{
+		ScopedLock lock(this->_lock.get());
+		ssize_t num = 0;
+
+		if(this->_io == nullptr)
+			return -EINVALID;
+
+		if(!this->buffered()) {
+			uint8_t byte;
+
+			while(this->load(&byte, sizeof(byte)) == sizeof(byte)) {
+				if(byte == static_cast<uint8_t>(delim))
+					return num;
+
+				output.write(byte);
+				num++;
+			}
 
-		auto bytes = fread(output, length, 1, this->_io) * length;
-		this->_available -= bytes;
+			return num > 0 ? num : -ENOTFOUND;
+		}
+
+		while(this->_offset < this->_size) {
+			if(this->_dirty || this->_offset < this->_start || this->_offset >= this->_start + this->_length) {
+				if(!this->fill())
+					break;
+			}
+
+			auto start = this->_buffer + (this->_offset - this->_start);
+			auto length = this->_length - (this->_offset - this->_start);
+			auto end = static_cast<uint8_t*>(memchr(start, delim, length));
+
+			if(end != nullptr) {
+				output.write(start, end - start);
+				num += end - start;
+				this->_offset += end - start + 1;
+
+				return num;
+			}
 
-		return bytes;
+			output.write(start, length);
+			num += length;
+			this->_offset += length;
+		}
+
+		return num > 0 ? num : -ENOTFOUND;
+	}
+
+	ssize_t File::readLine(ByteBuffer& line)
+	{
+		auto rv = this->readUntil('\n', line);
+
+		if(rv > 0 && line[line.index() - 1] == '\r') {
+			line.setIndex(line.index() - 1);
+			rv--;
+		}
+
+		return rv;
+	}
+
+	RawBuffer File::peekSpan()
+	{
+		ScopedLock lock(this->_lock.get());
+
+		if(this->_dirty || this->_offset < this->_start || this->_offset >= this->_start + this->_length)
+			return RawBuffer();
+
+		return RawBuffer(this->_buffer + (this->_offset - this->_start), this->_start + this->_length - this->_offset);
 	}
 
 	bool File::write(uint8_t byte)
 	{
 		ScopedLock lock(this->_lock.get());
-		return fputc(byte, this->_io) != EOF;
+		return this->store(&byte, sizeof(byte)) == sizeof(byte);
 	}
 
 	ssize_t File::write(const void *bytes, const size_t &length)
 	{
 		ScopedLock lock(this->_lock.get());
-		return fwrite(bytes, length, 1, this->_io) * length;
+		return this->store(bytes, length);
 	}
 
 	ssize_t File::write(const String &format, ...)
@@ -206,10 +530,27 @@ namespace lwiot
 		va_list list;
 		ssize_t rv;
 
+		if(this->_io == nullptr || !this->commit())
+			return -EINVALID;
+
+		if(!this->_append)
+			fseek(this->_io, static_cast<long>(this->_offset), SEEK_SET);
+
 		va_start(list, format.c_str());
 		rv = vfprintf(this->_io, format.c_str(), list);
 		va_end(list);
 
+		if(rv <= 0)
+			return rv;
+
+		auto end = static_cast<size_t>(ftell(this->_io));
+
+		if(end > this->_size)
+			this->_size = end;
+
+		if(!this->_append)
+			this->_offset = end;
+
 		return rv;
 	}
 }
@@ -0,0 +1,183 @@
+/*
+ * Read-only memory mapped data.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#ifdef HAVE_MMAN_H
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/stl/move.h>
+#include <lwiot/io/file.h>
+#include <lwiot/io/mappedregion.h>
+
+namespace lwiot
+{
+	MappedRegion::MappedRegion() : _data(nullptr), _size(0), _kind(Kind::None)
+	{
+	}
+
+	MappedRegion::MappedRegion(const void *address, size_t size) : _data(static_cast<const uint8_t*>(address)),
+		_size(size), _kind(Kind::Borrowed)
+	{
+	}
+
+	MappedRegion::MappedRegion(const String& path) : MappedRegion()
+	{
+		this->map(path);
+	}
+
+	MappedRegion::~MappedRegion()
+	{
+		this->unmap();
+	}
+
+	MappedRegion::MappedRegion(MappedRegion&& other) noexcept : _data(other._data), _size(other._size),
+		_kind(other._kind)
+	{
+		other._data = nullptr;
+		other._size = 0;
+		other._kind = Kind::None;
+	}
+
+	MappedRegion& MappedRegion::operator=(MappedRegion&& rhs) noexcept
+	{
+		if(this == &rhs)
+			return *this;
+
+		this->unmap();
+
+		this->_data = rhs._data;
+		this->_size = rhs._size;
+		this->_kind = rhs._kind;
+
+		rhs._data = nullptr;
+		rhs._size = 0;
+		rhs._kind = Kind::None;
+
+		return *this;
+	}
+
+	bool MappedRegion::map(const String& path)
+	{
+		this->unmap();
+
+#ifdef HAVE_MMAN_H
+		struct stat info;
+		int fd = open(path.c_str(), O_RDONLY);
+
+		if(fd < 0)
+			return false;
+
+		if(fstat(fd, &info) != 0) {
+			close(fd);
+			return false;
+		}
+
+		/* The mapping stays valid after the descriptor is closed. */
+		if(info.st_size > 0) {
+			auto address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+			if(address == MAP_FAILED) {
+				close(fd);
+				return false;
+			}
+
+			this->_data = static_cast<const uint8_t*>(address);
+		}
+
+		close(fd);
+
+		this->_size = info.st_size;
+		this->_kind = Kind::Mapped;
+
+		return true;
+#else
+		File file(path, FileMode::Read, 0);
+
+		if(!file)
+			return false;
+
+		auto size = file.size();
+		auto data = static_cast<uint8_t*>(lwiot_mem_alloc(size > 0 ? size : 1));
+
+		if(data == nullptr)
+			return false;
+
+		if(file.read(data, size) != static_cast<ssize_t>(size)) {
+			lwiot_mem_free(data);
+			return false;
+		}
+
+		this->_data = data;
+		this->_size = size;
+		this->_kind = Kind::Heap;
+
+		return true;
+#endif
+	}
+
+	void MappedRegion::unmap()
+	{
+		switch(this->_kind) {
+#ifdef HAVE_MMAN_H
+		case Kind::Mapped:
+			if(this->_data != nullptr)
+				munmap(const_cast<uint8_t*>(this->_data), this->_size);
+			break;
+#endif
+
+		case Kind::Heap:
+			lwiot_mem_free(const_cast<uint8_t*>(this->_data));
+			break;
+
+		default:
+			break;
+		}
+
+		this->_data = nullptr;
+		this->_size = 0;
+		this->_kind = Kind::None;
+	}
+
+	MappedRegion::operator bool() const
+	{
+		return this->_kind != Kind::None;
+	}
+
+	const uint8_t *MappedRegion::data() const
+	{
+		return this->_data;
+	}
+
+	size_t MappedRegion::size() const
+	{
+		return this->_size;
+	}
+
+	RawBuffer MappedRegion::span() const
+	{
+		return RawBuffer(const_cast<uint8_t*>(this->_data), this->_size);
+	}
+
+	StringView MappedRegion::view() const
+	{
+		return StringView(reinterpret_cast<const char*>(this->_data), this->_size);
+	}
+
+	bool MappedRegion::mapped() const
+	{
+		return this->_kind == Kind::Mapped || this->_kind == Kind::Borrowed;
+	}
+}
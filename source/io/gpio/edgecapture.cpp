@@ -0,0 +1,101 @@
+/*
+ * GPIO edge capture.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/gpiochip.h>
+#include <lwiot/io/gpiopin.h>
+#include <lwiot/io/irqslot.h>
+#include <lwiot/io/edgecapture.h>
+
+namespace lwiot
+{
+	EdgeCapture::EdgeCapture() : _chip(nullptr), _pin(-1), _per_ms(0), _count(0), _overflow(false)
+	{
+	}
+
+	EdgeCapture::~EdgeCapture()
+	{
+		this->stop();
+	}
+
+	bool EdgeCapture::start(const GpioPin& pin)
+	{
+		this->stop();
+		this->reset();
+
+		this->_chip = &pin.chip();
+		this->_pin = pin.pin();
+
+		return this->_slot.attach(*this->_chip, this->_pin, IrqRisingFalling, &EdgeCapture::handler, this);
+	}
+
+	void EdgeCapture::stop()
+	{
+		this->_slot.detach();
+	}
+
+	void EdgeCapture::reset()
+	{
+		this->_count = 0;
+		this->_overflow = false;
+
+		if(this->_per_ms == 0)
+			this->_per_ms = lwiot_delay_ns_to_cycles(1000000);
+	}
+
+	size_t EdgeCapture::count() const
+	{
+		return this->_count;
+	}
+
+	bool EdgeCapture::overflow() const
+	{
+		return this->_overflow;
+	}
+
+	const EdgeCapture::Edge& EdgeCapture::edge(size_t idx) const
+	{
+		return this->_edges[idx];
+	}
+
+	uint32_t EdgeCapture::duration(size_t idx) const
+	{
+		uint64_t cycles;
+
+		if(idx + 1 >= this->_count || this->_per_ms == 0)
+			return 0;
+
+		cycles = static_cast<uint32_t>(this->_edges[idx + 1].stamp - this->_edges[idx].stamp);
+		return static_cast<uint32_t>(cycles * 1000ULL / this->_per_ms);
+	}
+
+	void RAM_ATTR EdgeCapture::record(uint32_t stamp, bool level)
+	{
+		auto count = this->_count;
+
+		if(count >= Capacity) {
+			this->_overflow = true;
+			return;
+		}
+
+		this->_edges[count].stamp = stamp;
+		this->_edges[count].level = level;
+		this->_count = count + 1;
+	}
+
+	void RAM_ATTR EdgeCapture::handler(void* arg)
+	{
+		auto capture = static_cast<EdgeCapture*>(arg);
+		auto stamp = static_cast<uint32_t>(lwiot_delay_counter());
+
+		capture->record(stamp, capture->_chip->read(capture->_pin));
+	}
+}
@@ -9,7 +9,10 @@
 
 #include <lwiot/io/gpiochip.h>
 #include <lwiot/io/gpiopin.h>
+#include <lwiot/io/waveform.h>
+#include <lwiot/io/staticpin.h>
 #include <lwiot/error.h>
+#include <lwiot/kernel/deadlinetimer.h>
 
 extern lwiot::GpioPin iopins[];
 
@@ -60,6 +63,49 @@ namespace lwiot
 		return this->_nr;
 	}
 
+	bool GpioChip::fastPin(int pin, GpioFastPin& fast) const
+	{
+		return false;
+	}
+
+	bool GpioChip::waveform(int pin, const Waveform& wave)
+	{
+		GpioFastPin fast;
+		DeadlineTimer deadline;
+		size_t idx = 0;
+		auto total = wave.samples();
+		bool direct;
+
+		if(wave.resolution() < CONFIG_WAVEFORM_MIN_RESOLUTION)
+			return false;
+
+		direct = this->fastPin(pin, fast);
+		enter_critical();
+		deadline.expiresAfter(0);
+
+		while(idx < total) {
+			auto level = wave.sample(idx);
+			uint32_t run = 0;
+
+			/* Write once per run of equal samples. */
+			while(idx < total && wave.sample(idx) == level) {
+				run++;
+				idx++;
+			}
+
+			if(direct)
+				fast.write(level);
+			else
+				this->write(pin, level);
+
+			deadline.extend(run * wave.resolution());
+			deadline.wait();
+		}
+
+		exit_critical();
+		return true;
+	}
+
 	void GpioChip::input(int pin)
 	{
 		this->mode(pin, INPUT);
@@ -72,23 +118,26 @@ namespace lwiot
 
 	uint8_t GpioChip::shiftIn(int dpin, int cpin, bool lsb, uint8_t count, int delay)
 	{
+		GpioFastPin data, clock;
 		uint8_t value;
 
 		if(count > 8)
 			return 0;
 
+		/* Skip the virtual calls per bit when both pins can be reached through their registers. */
+		if(this->fastPin(dpin, data) && this->fastPin(cpin, clock))
+			return lwiot::shiftIn(data, clock, lsb, count, delay);
+
 		value = 0;
 
 		for(int idx = 0; idx < count; idx++) {
 			this->write(cpin, true);
 			lwiot_udelay(delay);
 
-			if(lsb) {
-				value |= static_cast<uint8_t>(this->read(dpin));
-			} else {
-				auto tmp = this->read(dpin << ((count - 1) - idx));
-				value |= static_cast<uint8_t>(tmp);
-			}
+			if(lsb)
+				value |= static_cast<uint8_t>(this->read(dpin) << idx);
+			else
+				value |= static_cast<uint8_t>(this->read(dpin) << ((count - 1) - idx));
 
 			this->write(cpin, false);
 			lwiot_udelay(delay);
@@ -99,6 +148,13 @@ namespace lwiot
 
 	int GpioChip::shiftOut(int dpin, int cpin, bool lsb, uint8_t val, uint8_t count, int delay)
 	{
+		GpioFastPin data, clock;
+
+		if(this->fastPin(dpin, data) && this->fastPin(cpin, clock)) {
+			lwiot::shiftOut(data, clock, lsb, val, count, delay);
+			return -EOK;
+		}
+
 		for(auto idx = 0; idx < count; idx++) {
 			if(lsb)
 				this->write(dpin, !!(val & (1 << idx)));
@@ -113,4 +169,42 @@ namespace lwiot
 
 		return -EOK;
 	}
+
+	static inline unsigned int port_width(unsigned int pins)
+	{
+		return pins < 32U ? pins : 32U;
+	}
+
+	void GpioChip::writeMask(uint32_t set, uint32_t clear)
+	{
+		auto width = port_width(this->_nr);
+
+		for(unsigned int pin = 0; pin < width; pin++) {
+			auto mask = 1UL << pin;
+
+			if(set & mask)
+				this->write(pin, true);
+			else if(clear & mask)
+				this->write(pin, false);
+		}
+	}
+
+	uint32_t GpioChip::readPort() const
+	{
+		auto width = port_width(this->_nr);
+		uint32_t value = 0;
+
+		for(unsigned int pin = 0; pin < width; pin++) {
+			if(this->read(pin))
+				value |= 1UL << pin;
+		}
+
+		return value;
+	}
+
+	void GpioChip::toggleMask(uint32_t mask)
+	{
+		auto value = this->readPort();
+		this->writeMask(~value & mask, value & mask);
+	}
 }
@@ -26,6 +26,10 @@ namespace lwiot
 		this->_open_drain = false;
 	}
 
+	GpioPin::GpioPin(const GpioPin& pin) : _open_drain(pin._open_drain), _pin(pin._pin), _chip(pin._chip)
+	{
+	}
+
 	GpioPin::~GpioPin() = default;
 
 	GpioPin& GpioPin::operator =(int num)
@@ -136,6 +140,21 @@ namespace lwiot
 		return this->_pin;
 	}
 
+	GpioChip& GpioPin::chip() const
+	{
+		return this->_chip;
+	}
+
+	bool GpioPin::fastPin(GpioFastPin& fast) const
+	{
+		return this->_chip.fastPin(this->_pin, fast);
+	}
+
+	bool GpioPin::waveform(const Waveform& wave)
+	{
+		return this->_chip.waveform(this->_pin, wave);
+	}
+
 	bool GpioPin::operator ==(const GpioPin& pin)
 	{
 		return this->_pin == pin.pin();
@@ -0,0 +1,107 @@
+/*
+ * GPIO interrupt with a context argument.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/gpiochip.h>
+#include <lwiot/io/irqslot.h>
+
+namespace lwiot
+{
+	IrqSlot* IrqSlot::_slots[CONFIG_IRQ_SLOTS];
+
+	template <int Slot>
+	void IrqSlot::dispatch()
+	{
+		auto slot = _slots[Slot];
+
+		if(slot)
+			slot->_handler(slot->_arg);
+	}
+
+	template <int Num>
+	struct IrqSlot::Handlers {
+		static irq_handler_t get(int slot)
+		{
+			return slot == Num - 1 ? &IrqSlot::dispatch<Num - 1> : Handlers<Num - 1>::get(slot);
+		}
+	};
+
+	template <>
+	struct IrqSlot::Handlers<0> {
+		static irq_handler_t get(int slot)
+		{
+			UNUSED(slot);
+			return nullptr;
+		}
+	};
+
+	IrqSlot::IrqSlot() : _chip(nullptr), _pin(-1), _slot(-1), _handler(nullptr), _arg(nullptr)
+	{
+	}
+
+	IrqSlot::~IrqSlot()
+	{
+		this->detach();
+	}
+
+	bool IrqSlot::attach(GpioChip& chip, int pin, IrqEdge edge, Handler handler, void* arg)
+	{
+		int slot = -1;
+
+		this->detach();
+
+		this->_handler = handler;
+		this->_arg = arg;
+
+		enter_critical();
+
+		for(int idx = 0; idx < CONFIG_IRQ_SLOTS; idx++) {
+			if(_slots[idx] == nullptr) {
+				_slots[idx] = this;
+				slot = idx;
+				break;
+			}
+		}
+
+		exit_critical();
+
+		if(slot < 0)
+			return false;
+
+		this->_chip = &chip;
+		this->_pin = pin;
+		this->_slot = slot;
+
+		chip.attachIrqHandler(pin, Handlers<CONFIG_IRQ_SLOTS>::get(slot), edge);
+		return true;
+	}
+
+	void IrqSlot::detach()
+	{
+		if(this->_slot < 0)
+			return;
+
+		this->_chip->detachIrqHandler(this->_pin);
+
+		enter_critical();
+		_slots[this->_slot] = nullptr;
+		exit_critical();
+
+		this->_slot = -1;
+		this->_chip = nullptr;
+		this->_pin = -1;
+	}
+
+	bool IrqSlot::attached() const
+	{
+		return this->_slot >= 0;
+	}
+}
@@ -0,0 +1,124 @@
+/*
+ * Parallel GPIO bus.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/gpiochip.h>
+#include <lwiot/io/parallelbus.h>
+
+namespace lwiot
+{
+	ParallelBus::ParallelBus(GpioChip& chip, const int *pins, size_t width, int strobe, bool active_low) :
+		_chip(chip), _width(0), _shift(-1), _data(0), _strobe_pin(-1), _strobe(0), _active_low(active_low)
+	{
+		if(width > CONFIG_PARALLEL_BUS_WIDTH)
+			width = CONFIG_PARALLEL_BUS_WIDTH;
+
+		for(size_t idx = 0; idx < width; idx++) {
+			if(pins[idx] < 0 || pins[idx] >= 32)
+				break;
+
+			this->_pins[idx] = pins[idx];
+			this->_data |= 1UL << pins[idx];
+			this->_width++;
+		}
+
+		if(strobe >= 0 && strobe < 32) {
+			this->_strobe_pin = strobe;
+			this->_strobe = 1UL << strobe;
+		}
+
+		if(this->_width > 0) {
+			this->_shift = this->_pins[0];
+
+			for(size_t idx = 1; idx < this->_width; idx++) {
+				if(this->_pins[idx] != this->_pins[0] + static_cast<int>(idx)) {
+					this->_shift = -1;
+					break;
+				}
+			}
+		}
+	}
+
+	void ParallelBus::begin()
+	{
+		for(size_t idx = 0; idx < this->_width; idx++)
+			this->_chip.output(this->_pins[idx]);
+
+		if(this->_strobe_pin >= 0)
+			this->_chip.output(this->_strobe_pin);
+
+		if(this->_active_low)
+			this->_chip.writeMask(this->_strobe, this->_data);
+		else
+			this->_chip.writeMask(0, this->_data | this->_strobe);
+	}
+
+	size_t ParallelBus::width() const
+	{
+		return this->_width;
+	}
+
+	uint32_t ParallelBus::expand(uint16_t value) const
+	{
+		uint32_t port = 0;
+
+		if(this->_shift >= 0)
+			return (static_cast<uint32_t>(value) << this->_shift) & this->_data;
+
+		for(size_t idx = 0; idx < this->_width; idx++) {
+			if(value & (1U << idx))
+				port |= 1UL << this->_pins[idx];
+		}
+
+		return port;
+	}
+
+	void ParallelBus::write(uint16_t value)
+	{
+		auto set = this->expand(value);
+		auto clear = this->_data & ~set;
+
+		if(this->_strobe == 0) {
+			this->_chip.writeMask(set, clear);
+			return;
+		}
+
+		if(this->_active_low) {
+			this->_chip.writeMask(set, clear | this->_strobe);
+			this->_chip.writeMask(this->_strobe, 0);
+		} else {
+			this->_chip.writeMask(set | this->_strobe, clear);
+			this->_chip.writeMask(0, this->_strobe);
+		}
+	}
+
+	void ParallelBus::write(const uint8_t *data, size_t length)
+	{
+		for(size_t idx = 0; idx < length; idx++)
+			this->write(static_cast<uint16_t>(data[idx]));
+	}
+
+	uint16_t ParallelBus::read() const
+	{
+		auto port = this->_chip.readPort();
+		uint16_t value = 0;
+
+		if(this->_shift >= 0)
+			return static_cast<uint16_t>((port & this->_data) >> this->_shift);
+
+		for(size_t idx = 0; idx < this->_width; idx++) {
+			if(port & (1UL << this->_pins[idx]))
+				value |= 1U << idx;
+		}
+
+		return value;
+	}
+}
@@ -0,0 +1,94 @@
+/*
+ * Sampled pulse train.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/waveform.h>
+
+namespace lwiot
+{
+	constexpr WaveformSymbol Waveform::Ws2812Zero;
+	constexpr WaveformSymbol Waveform::Ws2812One;
+
+	Waveform::Waveform(uint32_t resolution) : _samples(0), _resolution(resolution > 0 ? resolution : 1)
+	{
+	}
+
+	void Waveform::clear()
+	{
+		this->_buffer.clear();
+		this->_samples = 0;
+	}
+
+	void Waveform::reserve(size_t samples)
+	{
+		this->_buffer.reserve((samples + 7) / 8);
+	}
+
+	void Waveform::append(bool level, uint32_t ns)
+	{
+		auto count = (ns + this->_resolution / 2) / this->_resolution;
+
+		if(count == 0 && ns > 0)
+			count = 1;
+
+		for(uint32_t idx = 0; idx < count; idx++) {
+			auto bit = this->_samples % 8;
+
+			if(bit == 0)
+				this->_buffer.pushback(0);
+
+			if(level)
+				this->_buffer[this->_samples / 8] |= static_cast<uint8_t>(0x80U >> bit);
+
+			this->_samples++;
+		}
+	}
+
+	void Waveform::encode(const uint8_t *data, size_t length, const WaveformSymbol& zero, const WaveformSymbol& one)
+	{
+		for(size_t idx = 0; idx < length; idx++) {
+			for(int bit = 7; bit >= 0; bit--) {
+				auto& symbol = (data[idx] >> bit) & 1 ? one : zero;
+
+				this->append(true, symbol.high);
+				this->append(false, symbol.low);
+			}
+		}
+	}
+
+	bool Waveform::sample(size_t idx) const
+	{
+		if(idx >= this->_samples)
+			return false;
+
+		return (this->_buffer[idx / 8] & (0x80U >> (idx % 8))) != 0;
+	}
+
+	size_t Waveform::samples() const
+	{
+		return this->_samples;
+	}
+
+	const uint8_t *Waveform::data() const
+	{
+		return this->_buffer.size() ? &this->_buffer[0] : nullptr;
+	}
+
+	size_t Waveform::size() const
+	{
+		return this->_buffer.size();
+	}
+
+	uint32_t Waveform::resolution() const
+	{
+		return this->_resolution;
+	}
+}
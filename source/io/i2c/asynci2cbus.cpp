@@ -0,0 +1,200 @@
+/*
+ * Asynchronous I2C bus engine.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/error.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/kernel/uniquelock.h>
+
+#include <lwiot/io/i2calgorithm.h>
+#include <lwiot/io/asynci2cbus.h>
+
+namespace lwiot
+{
+	static uint16_t address_of(const I2CTransaction* transaction)
+	{
+		return transaction->messages()[0].address();
+	}
+
+	AsyncI2CBus::AsyncI2CBus(const I2CBus& bus) : Thread("i2cbus"), _bus(bus), _lock(false), _running(false)
+	{
+	}
+
+	AsyncI2CBus::~AsyncI2CBus()
+	{
+		this->end();
+	}
+
+	void AsyncI2CBus::begin()
+	{
+		ScopedLock lock(this->_lock);
+
+		if(this->_running)
+			return;
+
+		this->_running = true;
+		this->start();
+	}
+
+	void AsyncI2CBus::end()
+	{
+		UniqueLock<Lock> lock(this->_lock);
+
+		if(!this->_running)
+			return;
+
+		this->_running = false;
+		lock.unlock();
+
+		this->_work.signal();
+		this->join();
+	}
+
+	bool AsyncI2CBus::submit(I2CTransaction& transaction)
+	{
+		if(transaction._msgs.size() == 0)
+			return false;
+
+		UniqueLock<Lock> lock(this->_lock);
+
+		if(!this->_running || transaction._queued)
+			return false;
+
+		UniqueLock<Lock> state(transaction._lock);
+
+		transaction._queued = true;
+		transaction._complete = false;
+		transaction._ok = false;
+		transaction._attempts = 0;
+		transaction._due = 0;
+		state.unlock();
+
+		this->_queue.push_back(&transaction);
+		lock.unlock();
+
+		this->_work.signal();
+		return true;
+	}
+
+	size_t AsyncI2CBus::pending() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_queue.size();
+	}
+
+	I2CTransaction* AsyncI2CBus::next(time_t now, time_t& due)
+	{
+		due = 0;
+
+		for(auto transaction : this->_queue) {
+			auto address = address_of(transaction);
+			auto blocked = false;
+
+			/* Only the oldest transaction to a device may go, so that devices see them in order. */
+			for(auto other : this->_queue) {
+				if(other == transaction)
+					break;
+
+				if(address_of(other) == address) {
+					blocked = true;
+					break;
+				}
+			}
+
+			if(blocked)
+				continue;
+
+			if(transaction->_due <= now)
+				return transaction;
+
+			if(due == 0 || transaction->_due < due)
+				due = transaction->_due;
+		}
+
+		return nullptr;
+	}
+
+	void AsyncI2CBus::remove(I2CTransaction* transaction)
+	{
+		for(auto iter = this->_queue.begin(); iter != this->_queue.end(); ++iter) {
+			if(*iter != transaction)
+				continue;
+
+			this->_queue.erase(iter);
+			break;
+		}
+	}
+
+	void AsyncI2CBus::complete(I2CTransaction* transaction, bool ok)
+	{
+		UniqueLock<Lock> lock(this->_lock);
+		UniqueLock<Lock> state(transaction->_lock);
+
+		transaction->_queued = false;
+		transaction->_ok = ok;
+		state.unlock();
+		lock.unlock();
+
+		if(transaction->_handler)
+			transaction->_handler(ok);
+
+		/* The handler may have submitted the transaction again. */
+		lock.lock();
+		state.lock();
+
+		if(transaction->_queued)
+			return;
+
+		transaction->_complete = true;
+		transaction->_done.broadcast();
+	}
+
+	void AsyncI2CBus::run()
+	{
+		UniqueLock<Lock> lock(this->_lock);
+
+		while(this->_running) {
+			time_t due;
+			auto now = lwiot_tick_ms();
+			auto transaction = this->next(now, due);
+
+			if(transaction == nullptr) {
+				this->_work.wait(lock, due == 0 ? FOREVER : static_cast<int>(due - now));
+				continue;
+			}
+
+			lock.unlock();
+			auto rv = this->_bus.attempt(transaction->_msgs);
+			lock.lock();
+
+			transaction->_attempts++;
+
+			if(rv == -ETRYAGAIN && transaction->_attempts < MAX_RETRIES) {
+				transaction->_due = lwiot_tick_ms() + this->_bus.algorithm()->delay();
+				continue;
+			}
+
+			this->remove(transaction);
+			lock.unlock();
+			this->complete(transaction, rv > 0);
+			lock.lock();
+		}
+
+		while(this->_queue.size() > 0) {
+			auto transaction = this->_queue.front();
+
+			this->remove(transaction);
+			lock.unlock();
+			this->complete(transaction, false);
+			lock.lock();
+		}
+	}
+}
@@ -0,0 +1,353 @@
+/*
+ * Bit-banged I2C algorithm on direct port registers.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/error.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/io/watchdog.h>
+#include <lwiot/io/fastgpioi2calgorithm.h>
+
+#define BUSY_WAIT 10
+#define READ_FLAG 0x1U
+
+#define WRITE_BIT(__byte, __mask) \
+	do { \
+		int __rv = this->writeBit(((__byte) & (__mask)) != 0); \
+		if(unlikely(__rv < 0)) \
+			return __rv; \
+	} while(0)
+
+#define READ_BIT(__value) \
+	do { \
+		int __rv = this->readBit(); \
+		if(unlikely(__rv < 0)) \
+			return __rv; \
+		__value = static_cast<uint8_t>((__value << 1) | __rv); \
+	} while(0)
+
+namespace lwiot
+{
+	FastGpioI2CAlgorithm::FastGpioI2CAlgorithm(int sda, int scl, uint32_t frequency) :
+		FastGpioI2CAlgorithm(GpioPin(sda), GpioPin(scl), frequency)
+	{
+	}
+
+	FastGpioI2CAlgorithm::FastGpioI2CAlgorithm(const GpioPin& sda, const GpioPin& scl, uint32_t frequency) :
+		GpioI2CAlgorithm(sda, scl, frequency), _sda(), _scl(), _fast(false), _half(0), _timeout(0),
+		_deadline(0), _lock(false)
+	{
+		this->_fast = sda.fastPin(this->_sda) && scl.fastPin(this->_scl);
+		this->calibrate(frequency);
+
+		if(!this->_fast) {
+			print_dbg("I2C pins have no register access, using GpioPin!\n");
+		}
+	}
+
+	bool FastGpioI2CAlgorithm::isFast() const
+	{
+		return this->_fast;
+	}
+
+	void FastGpioI2CAlgorithm::setFrequency(const uint32_t& freq)
+	{
+		GpioI2CAlgorithm::setFrequency(freq);
+
+		ScopedLock lock(this->_lock);
+		this->calibrate(freq);
+	}
+
+	void FastGpioI2CAlgorithm::calibrate(uint32_t frequency)
+	{
+		if(frequency == 0U)
+			return;
+
+		this->_half = lwiot_delay_ns_to_cycles(static_cast<uint32_t>(1000000000ULL / (2ULL * frequency)));
+		this->_timeout = lwiot_delay_ns_to_cycles(FastGpioI2CAlgorithm::Timeout * 1000000U);
+	}
+
+	inline void RAM_ATTR FastGpioI2CAlgorithm::wait()
+	{
+		auto now = lwiot_delay_counter();
+
+		this->_deadline += this->_half;
+
+		/* After running late, the next edge is half a period after the last one. */
+		if(unlikely(static_cast<int64_t>(this->_deadline - now) <= 0))
+			this->_deadline = now + this->_half;
+
+		lwiot_delay_until(this->_deadline);
+	}
+
+	inline bool RAM_ATTR FastGpioI2CAlgorithm::sclhi()
+	{
+		this->_scl.high();
+		this->wait();
+
+		if(likely(this->_scl.read()))
+			return true;
+
+		/* The slave stretches the clock; the high period starts when it releases SCL. */
+		auto start = lwiot_delay_counter();
+
+		while(!this->_scl.read()) {
+			if(lwiot_delay_counter() - start > this->_timeout)
+				return false;
+		}
+
+		this->_deadline = lwiot_delay_counter();
+		this->wait();
+
+		return true;
+	}
+
+	bool FastGpioI2CAlgorithm::busy() const
+	{
+		if(this->_scl.read() && this->_sda.read())
+			return false;
+
+		lwiot_udelay(BUSY_WAIT);
+		return !(this->_scl.read() && this->_sda.read());
+	}
+
+	void RAM_ATTR FastGpioI2CAlgorithm::start()
+	{
+		this->_deadline = lwiot_delay_counter();
+		this->_sda.low();
+		this->wait();
+		this->_scl.low();
+	}
+
+	bool RAM_ATTR FastGpioI2CAlgorithm::repstart()
+	{
+		this->_sda.high();
+		this->wait();
+
+		if(unlikely(!this->sclhi()))
+			return false;
+
+		this->_sda.low();
+		this->wait();
+		this->_scl.low();
+
+		return true;
+	}
+
+	void RAM_ATTR FastGpioI2CAlgorithm::stop()
+	{
+		this->_sda.low();
+		this->wait();
+		this->sclhi();
+		this->_sda.high();
+		this->wait();
+	}
+
+	inline int RAM_ATTR FastGpioI2CAlgorithm::writeBit(bool bit)
+	{
+		this->_sda.write(bit);
+		this->wait();
+
+		if(unlikely(!this->sclhi()))
+			return -ETMO;
+
+		/* Another master pulled SDA low while this one released it. */
+		if(unlikely(bit && !this->_sda.read()))
+			return -ETRYAGAIN;
+
+		this->_scl.low();
+		return -EOK;
+	}
+
+	inline int RAM_ATTR FastGpioI2CAlgorithm::readBit()
+	{
+		bool bit;
+
+		this->wait();
+
+		if(unlikely(!this->sclhi()))
+			return -ETMO;
+
+		bit = this->_sda.read();
+		this->_scl.low();
+
+		return bit ? 1 : 0;
+	}
+
+	int RAM_ATTR FastGpioI2CAlgorithm::write(uint8_t byte)
+	{
+		bool ack;
+
+		WRITE_BIT(byte, 0x80U);
+		WRITE_BIT(byte, 0x40U);
+		WRITE_BIT(byte, 0x20U);
+		WRITE_BIT(byte, 0x10U);
+		WRITE_BIT(byte, 0x08U);
+		WRITE_BIT(byte, 0x04U);
+		WRITE_BIT(byte, 0x02U);
+		WRITE_BIT(byte, 0x01U);
+
+		this->_sda.high();
+		this->wait();
+
+		if(unlikely(!this->sclhi()))
+			return -ETMO;
+
+		ack = !this->_sda.read();
+		this->_scl.low();
+
+		return ack;
+	}
+
+	int RAM_ATTR FastGpioI2CAlgorithm::read(uint8_t& byte, bool ack)
+	{
+		uint8_t value = 0;
+
+		this->_sda.high();
+
+		READ_BIT(value);
+		READ_BIT(value);
+		READ_BIT(value);
+		READ_BIT(value);
+		READ_BIT(value);
+		READ_BIT(value);
+		READ_BIT(value);
+		READ_BIT(value);
+
+		byte = value;
+
+		this->_sda.write(!ack);
+		this->wait();
+
+		if(unlikely(!this->sclhi()))
+			return -ETMO;
+
+		this->_scl.low();
+		return -EOK;
+	}
+
+	int RAM_ATTR FastGpioI2CAlgorithm::begin(uint8_t addr)
+	{
+		int rv = -EINVALID;
+
+		for(auto idx = 0; idx < MAX_RETRIES; idx++) {
+			rv = this->write(addr);
+
+			if(rv > 0)
+				break;
+
+			this->stop();
+			this->start();
+		}
+
+		return rv;
+	}
+
+	bool RAM_ATTR FastGpioI2CAlgorithm::begin(const I2CMessage& msg)
+	{
+		uint8_t addr;
+
+		if(!msg.is10Bit()) {
+			addr = static_cast<uint8_t>(msg.address() << 1);
+
+			if(msg.isRead())
+				addr |= READ_FLAG;
+
+			return this->begin(addr) > 0;
+		}
+
+		/* 0xF0 prefix and the two upper address bits, written first. */
+		addr = static_cast<uint8_t>(0xF0 | ((msg.address() >> 7) & 0x6));
+
+		if(this->begin(addr) <= 0 || this->write(static_cast<uint8_t>(msg.address() & 0xFF)) <= 0)
+			return false;
+
+		if(!msg.isRead())
+			return true;
+
+		return this->repstart() && this->begin(addr | READ_FLAG) > 0;
+	}
+
+	ssize_t FastGpioI2CAlgorithm::transfer(I2CMessage *msgs, size_t num)
+	{
+		ssize_t total = 0L;
+		int rv = -EOK;
+		ScopedLock lock(this->_lock);
+
+		if(this->busy())
+			return -ETRYAGAIN;
+
+		enter_critical();
+		this->start();
+
+		for(size_t idx = 0; idx < num && rv >= 0; idx++) {
+			auto& msg = msgs[idx];
+			auto length = msg.count();
+
+			if(idx != 0) {
+				if(msg.repstart()) {
+					if(!this->repstart()) {
+						rv = -ETMO;
+						break;
+					}
+				} else {
+					this->stop();
+					this->start();
+				}
+			}
+
+			if(!this->begin(msg)) {
+				print_dbg("Device address NACKed!\n");
+				rv = -EINVALID;
+				break;
+			}
+
+			if(msg.isRead()) {
+				for(size_t byte = 0; byte < length && rv >= 0; byte++)
+					rv = this->read(msg[byte], byte + 1 != length);
+
+				msg.setIndex(length);
+			} else {
+				for(size_t byte = 0; byte < length && rv >= 0; byte++) {
+					rv = this->write(msg[byte]);
+
+					if(rv == 0) {
+						print_dbg("write-byte: NACK received!\n");
+						rv = -EINVALID;
+					}
+				}
+			}
+
+			total += length;
+			wdt.reset();
+		}
+
+		this->stop();
+		exit_critical();
+
+		return rv >= 0 ? total : rv;
+	}
+
+	ssize_t FastGpioI2CAlgorithm::transfer(I2CMessage& msg)
+	{
+		if(!this->_fast)
+			return GpioI2CAlgorithm::transfer(msg);
+
+		return this->transfer(&msg, 1);
+	}
+
+	ssize_t FastGpioI2CAlgorithm::transfer(stl::Vector<I2CMessage>& msgs)
+	{
+		if(!this->_fast)
+			return GpioI2CAlgorithm::transfer(msgs);
+
+		return this->transfer(msgs.data(), msgs.size());
+	}
+}
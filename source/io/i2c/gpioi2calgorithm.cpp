@@ -31,7 +31,7 @@ namespace lwiot
 	}
 
 	GpioI2CAlgorithm::GpioI2CAlgorithm(const lwiot::GpioPin &sda, const lwiot::GpioPin &scl, uint32_t frequency) :
-		I2CAlgorithm(I2CAlgorithm::DefaultRetryDelay, frequency), _scl(scl), _sda(sda), _udelay(0), _lock(false)
+		I2CAlgorithm(I2CAlgorithm::DefaultRetryDelay, frequency), _scl(scl), _sda(sda), _delay(0), _lock(false)
 	{
 		this->_scl.setOpenDrain();
 		this->_sda.setOpenDrain();
@@ -39,8 +39,8 @@ namespace lwiot
 		this->_scl << true;
 		this->_sda << true;
 
-		this->_udelay = this->calcDelay(frequency);
-		this->_halftime = (this->_udelay + 1) / 2;
+		this->_delay = this->calcDelay(frequency);
+		this->_halftime = (this->_delay + 1) / 2;
 	}
 
 	GpioI2CAlgorithm::~GpioI2CAlgorithm()
@@ -54,23 +54,22 @@ namespace lwiot
 		ScopedLock lock(this->_lock);
 
 		I2CAlgorithm::setFrequency(freq);
-		this->_udelay = this->calcDelay(freq);
-		this->_halftime = (this->_udelay + 1) / 2;
+		this->_delay = this->calcDelay(freq);
+		this->_halftime = (this->_delay + 1) / 2;
 	}
 
 	int GpioI2CAlgorithm::calcDelay(const uint32_t &frequency) const
 	{
-		double freq, tval;
+		int64_t tval;
 
 		if(frequency == 0U)
 			return -EINVALID;
 
-		freq = static_cast<double>(frequency);
-		tval = 1.0 / (2.0 * freq);
-		tval -= 0.000002;
-		tval *= 1e6;
+		/* Half a clock period, minus the time it takes to toggle a pin. */
+		tval = 1000000000LL / (2LL * frequency);
+		tval -= GpioI2CAlgorithm::ToggleTime;
 
-		return static_cast<int>(tval);
+		return tval < 0 ? 0 : static_cast<int>(tval);
 	}
 
 	void RAM_ATTR GpioI2CAlgorithm::repstart() const
@@ -79,14 +78,14 @@ namespace lwiot
 		this->sclhi();
 		this->_sda << false;
 
-		lwiot_udelay(this->_udelay);
+		lwiot_ndelay(this->_delay);
 		this->scllow();
 	}
 
 	void RAM_ATTR GpioI2CAlgorithm::start() const
 	{
 		this->_sda << false;
-		lwiot_udelay(this->_udelay);
+		lwiot_ndelay(this->_delay);
 		this->scllow();
 	}
 
@@ -95,25 +94,25 @@ namespace lwiot
 		this->sdalow();
 		this->sclhi();
 		this->_sda(true);
-		lwiot_udelay(this->_udelay);
+		lwiot_ndelay(this->_delay);
 	}
 
 	void RAM_ATTR GpioI2CAlgorithm::sdahi() const
 	{
 		this->_sda << true;
-		lwiot_udelay(this->_halftime);
+		lwiot_ndelay(this->_halftime);
 	}
 
 	void RAM_ATTR GpioI2CAlgorithm::sdalow() const
 	{
 		this->_sda << false;
-		lwiot_udelay(this->_halftime);
+		lwiot_ndelay(this->_halftime);
 	}
 
 	void RAM_ATTR GpioI2CAlgorithm::scllow() const
 	{
 		this->_scl << false;
-		lwiot_udelay(this->_halftime);
+		lwiot_ndelay(this->_halftime);
 	}
 
 	int RAM_ATTR GpioI2CAlgorithm::sclhi() const
@@ -122,7 +121,7 @@ namespace lwiot
 		bool scl;
 
 		this->_scl << true;
-		lwiot_udelay(this->_udelay);
+		lwiot_ndelay(this->_delay);
 		tmo = lwiot_tick_ms() + GpioI2CAlgorithm::Timeout;
 
 		do {
@@ -165,7 +164,7 @@ namespace lwiot
 		if(ack)
 			this->_sda(false);
 
-		lwiot_udelay(this->_halftime);
+		lwiot_ndelay(this->_halftime);
 
 		if(this->sclhi() < 0) {
 			log << "ACK / NACK timeout" << Logger::newline;
@@ -187,7 +186,7 @@ namespace lwiot
 				break;
 
 			this->stop();
-			lwiot_udelay(this->_udelay);
+			lwiot_ndelay(this->_delay);
 			this->start();
 		}
 
@@ -209,7 +208,7 @@ namespace lwiot
 
 			bit = (byte >> idx) & GpioI2CAlgorithm::LsbValue;
 			this->_sda << bit;
-			lwiot_udelay(this->_halftime);
+			lwiot_ndelay(this->_halftime);
 
 			/*
 			 * Treat timeouts and loss of arbitration as errors. Technically, according to
@@ -277,12 +276,12 @@ namespace lwiot
 				value |= GpioI2CAlgorithm::LsbValue;
 
 			if(unlikely(bit == GpioI2CAlgorithm::MsbPosition))
-				delay = this->_udelay / 2;
+				delay = this->_delay / 2;
 			else
-				delay = this->_udelay;
+				delay = this->_delay;
 
 			this->_scl << false;
-			lwiot_udelay(delay);
+			lwiot_ndelay(delay);
 
 			return -EOK;
 		};
@@ -25,7 +25,7 @@ namespace lwiot
 {
 	HardwareI2CAlgorithm::HardwareI2CAlgorithm(const GpioPin &sclpin, const GpioPin &sdapin, uint32_t frequency) :
 			I2CAlgorithm(I2CAlgorithm::DefaultRetryDelay, frequency),
-			_scl(sclpin), _sda(sdapin), log("hw-i2c"), _lock(new Lock(false))
+			_scl(sclpin), _sda(sdapin), log("hw-i2c"), _lock(makeShared<Lock>(false))
 	{
 		this->_scl.setOpenDrain();
 		this->_sda.setOpenDrain();
@@ -129,7 +129,6 @@ namespace lwiot
 
 	ssize_t HardwareI2CAlgorithm::transfer(I2CMessage& msg)
 	{
-		uint8_t *data;
 		uint16_t addr;
 		bool success;
 		ssize_t rv;
@@ -140,26 +139,13 @@ namespace lwiot
 			return -ETRYAGAIN;
 		}
 
-		data = msg.data();
 		addr = msg.address();
 
 		addr <<= 1;
 		addr |= msg.isRead();
 
 		this->start(addr, false);
-
-		if(msg.isRead()) {
-			auto count = msg.count();
-
-			if(count > 1)
-				this->read(data, count - 1, true);
-
-			this->read(&data[count - 1], false);
-			msg.setIndex(count);
-		} else {
-			this->write(data, msg.count(), true);
-		}
-
+		this->queue(msg);
 		this->stop();
 
 		success = this->transfer();
@@ -188,23 +174,11 @@ namespace lwiot
 
 		for(auto& msg : msgs) {
 			auto address = msg.address();
-			auto data = msg.data();
 
 			address = address << 1U | msg.isRead();
 			this->start(address, started);
 			started = true;
-
-			if(msg.isRead()) {
-				auto count = msg.count();
-
-				if(count > 1)
-					this->read(data, count - 1, true);
-
-				this->read(&data[count - 1], false);
-				msg.setIndex(count);
-			} else {
-				this->write(data, msg.count(), true);
-			}
+			this->queue(msg);
 
 			total += msg.count();
 
@@ -225,6 +199,40 @@ namespace lwiot
 		return total;
 	}
 
+	void HardwareI2CAlgorithm::queue(I2CMessage& msg)
+	{
+		auto data = msg.data();
+		auto count = msg.count();
+
+		if(!msg.isRead()) {
+			if(count >= CONFIG_I2C_BULK_THRESHOLD)
+				this->writeBulk(data, count, true);
+			else
+				this->write(data, count, true);
+
+			return;
+		}
+
+		/* The last byte of a read is not acknowledged. */
+		if(count > CONFIG_I2C_BULK_THRESHOLD)
+			this->readBulk(data, count - 1, true);
+		else if(count > 1)
+			this->read(data, count - 1, true);
+
+		this->read(&data[count - 1], false);
+		msg.setIndex(count);
+	}
+
+	void HardwareI2CAlgorithm::writeBulk(const uint8_t *bytes, size_t length, bool ack)
+	{
+		this->write(bytes, length, ack);
+	}
+
+	void HardwareI2CAlgorithm::readBulk(uint8_t *bytes, size_t length, bool ack)
+	{
+		this->read(bytes, length, ack);
+	}
+
 #define MAX_RETRIES 3
 
 	bool HardwareI2CAlgorithm::transfer() const
@@ -28,7 +28,7 @@ namespace lwiot
 		this->_algo = bus._algo;
 	}
 
-	I2CBus::I2CBus(I2CAlgorithm *algo) : _algo(algo), _lock(new Lock(false))
+	I2CBus::I2CBus(I2CAlgorithm *algo) : _algo(algo), _lock(makeShared<Lock>(true, true))
 	{
 	}
 
@@ -53,6 +53,16 @@ namespace lwiot
 		return this->_algo.get();
 	}
 
+	void I2CBus::lock()
+	{
+		this->_lock->lock();
+	}
+
+	void I2CBus::unlock()
+	{
+		this->_lock->unlock();
+	}
+
 	bool I2CBus::transfer(stl::Vector<I2CMessage>& msgs)
 	{
 		int rv = -EINVALID;
@@ -62,7 +72,10 @@ namespace lwiot
 			rv = this->_algo->transfer(msgs);
 
 			if(rv == -ETRYAGAIN) {
+				/* Let other users of the bus in while the device is busy. */
+				lock.unlock();
 				lwiot_sleep(this->_algo->delay());
+				lock.lock();
 				continue;
 			} else {
 				break;
@@ -72,6 +85,12 @@ namespace lwiot
 		return rv > 0;
 	}
 
+	int I2CBus::attempt(stl::Vector<I2CMessage>& msgs)
+	{
+		ScopedLock lock(*this->_lock);
+		return static_cast<int>(this->_algo->transfer(msgs));
+	}
+
 	bool I2CBus::transfer(I2CMessage& msg)
 	{
 		int rv = -EINVALID;
@@ -81,7 +100,10 @@ namespace lwiot
 			rv = this->_algo->transfer(msg);
 
 			if(rv == -ETRYAGAIN) {
+				/* Let other users of the bus in while the device is busy. */
+				lock.unlock();
 				lwiot_sleep(this->_algo->delay());
+				lock.lock();
 				continue;
 			} else {
 				break;
@@ -0,0 +1,90 @@
+/*
+ * Queued I2C transaction.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/kernel/uniquelock.h>
+#include <lwiot/io/i2ctransaction.h>
+
+namespace lwiot
+{
+	I2CTransaction::I2CTransaction() : I2CTransaction(CompletionHandler())
+	{
+	}
+
+	I2CTransaction::I2CTransaction(const CompletionHandler& handler) : _handler(handler), _lock(false),
+		_queued(false), _complete(false), _ok(false), _attempts(0), _due(0)
+	{
+	}
+
+	void I2CTransaction::add(const I2CMessage& msg)
+	{
+		this->_msgs.push_back(msg);
+	}
+
+	void I2CTransaction::add(I2CMessage&& msg)
+	{
+		this->_msgs.push_back(stl::forward<I2CMessage>(msg));
+	}
+
+	void I2CTransaction::clear()
+	{
+		this->_msgs.clear();
+	}
+
+	stl::Vector<I2CMessage>& I2CTransaction::messages()
+	{
+		return this->_msgs;
+	}
+
+	const stl::Vector<I2CMessage>& I2CTransaction::messages() const
+	{
+		return this->_msgs;
+	}
+
+	void I2CTransaction::setHandler(const CompletionHandler& handler)
+	{
+		this->_handler = handler;
+	}
+
+	bool I2CTransaction::wait(int tmo)
+	{
+		UniqueLock<Lock> lock(this->_lock);
+		auto start = lwiot_tick_ms();
+
+		while(!this->_complete) {
+			if(tmo == FOREVER) {
+				this->_done.wait(lock);
+				continue;
+			}
+
+			auto remaining = tmo - static_cast<int>(lwiot_tick_ms() - start);
+
+			if(remaining <= 0)
+				return false;
+
+			this->_done.wait(lock, remaining);
+		}
+
+		return this->_ok;
+	}
+
+	bool I2CTransaction::isComplete() const
+	{
+		UniqueLock<Lock> lock(this->_lock);
+		return this->_complete;
+	}
+
+	bool I2CTransaction::isSuccess() const
+	{
+		UniqueLock<Lock> lock(this->_lock);
+		return this->_complete && this->_ok;
+	}
+}
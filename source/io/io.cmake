@@ -5,12 +5,16 @@
 SET(DIR ${PROJECT_SOURCE_DIR}/source/io)
 
 if(HAVE_UNISTD_H)
-	SET(FILEIO_SRC io/fs/file.cpp)
+	SET(FILEIO_SRC io/fs/file.cpp io/fs/mappedregion.cpp)
 endif()
 
 SET(IO_SOURCES
 	io/gpio/gpiochip.cpp
 	io/gpio/gpiopin.cpp
+	io/gpio/irqslot.cpp
+	io/gpio/edgecapture.cpp
+	io/gpio/parallelbus.cpp
+	io/gpio/waveform.cpp
 
 	io/adc/adcchip.cpp
 	io/adc/adcpin.cpp
@@ -29,14 +33,19 @@ SET(IO_SOURCES
 
 	io/wdt/watchdog.cpp
 
+	io/block/blockdevice.cpp
+
 	io/spi/spimessage.cpp
 	io/spi/spibus.cpp
+	io/spi/spidevice.cpp
+	io/spi/spiwaveform.cpp
 
 	io/i2c/i2cmessage.cpp
 	io/i2c/i2calgorithm.cpp
 	io/i2c/hardwarei2calgorithm.cpp
 	io/i2c/i2cbus.cpp
 	io/i2c/gpioi2calgorithm.cpp
+	io/i2c/fastgpioi2calgorithm.cpp
 
 	${FILEIO_SRC}
 )
@@ -11,6 +11,7 @@
 
 #include <lwiot/lwiot.h>
 #include <lwiot/io/gpiopin.h>
+#include <lwiot/io/edgecapture.h>
 #include <lwiot/log.h>
 #include <lwiot/stl/vector.h>
 #include <lwiot/kernel/lock.h>
@@ -19,7 +20,7 @@
 
 namespace lwiot
 {
-	DhtBus::DhtBus(const GpioPin& pin) : _pin(pin), _lock(false)
+	DhtBus::DhtBus(const GpioPin& pin) : _pin(pin), _lock(false), _capture(nullptr)
 	{
 		ScopedLock lock(this->_lock);
 
@@ -27,6 +28,11 @@ namespace lwiot
 		this->_pin << false;
 	}
 
+	DhtBus::DhtBus(const GpioPin& pin, EdgeCapture& capture) : DhtBus(pin)
+	{
+		this->_capture = &capture;
+	}
+
 	DhtBus::~DhtBus()
 	{
 		ScopedLock lock(this->_lock);
@@ -55,24 +61,17 @@ namespace lwiot
 		return false;
 	}
 
-#define INIT_DELAY 250000U
-#define START_DELAY 50000U
-
-	bool DhtBus::_read(stl::Vector<bool>& bits)
+	void DhtBus::start()
 	{
-		uint32_t low, high;
+		ScopedLock lock(this->_lock);
 
 		this->_pin.mode(PinMode::OUTPUT);
-		this->_pin.write(true);
-
-		lwiot_udelay(START_DELAY);
-		lwiot_udelay(START_DELAY);
-		lwiot_udelay(START_DELAY);
-		lwiot_udelay(START_DELAY);
-		lwiot_udelay(START_DELAY);
-
 		this->_pin.write(false);
-		lwiot_udelay(10 * 1000);
+	}
+
+	bool DhtBus::_read(stl::Vector<bool>& bits)
+	{
+		uint32_t low, high;
 
 		this->_pin.write(true);
 		lwiot_udelay(40);
@@ -113,15 +112,70 @@ namespace lwiot
 		return true;
 	}
 
-	bool DhtBus::read(stl::Vector<bool>& bits)
+	bool DhtBus::decode(stl::Vector<bool>& bits)
+	{
+		size_t highs[DhtBus::Bits];
+		size_t found = 0;
+		auto& capture = *this->_capture;
+
+		if(capture.overflow()) {
+			print_dbg("[DHT]: Capture overflow\n");
+			return false;
+		}
+
+		/*
+		 * Every bit is a low pulse followed by a high pulse of which the length gives the
+		 * value. Walk back from the end, so that the release of the line and the response of
+		 * the sensor are skipped; the high pulse after the last bit never ends.
+		 */
+		for(auto idx = capture.count(); idx > 1 && found < DhtBus::Bits; idx--) {
+			auto& edge = capture.edge(idx - 2);
+
+			if(edge.level && !capture.edge(idx - 1).level && idx > 2 && !capture.edge(idx - 3).level)
+				highs[found++] = idx - 2;
+		}
+
+		if(found != DhtBus::Bits) {
+			print_dbg("[DHT]: Captured %u bits\n", found);
+			return false;
+		}
+
+		while(found--) {
+			auto high = highs[found];
+			bits.pushback(capture.duration(high) > capture.duration(high - 1));
+		}
+
+		return true;
+	}
+
+	bool DhtBus::finish(stl::Vector<bool>& bits)
 	{
 		bool retval;
 		ScopedLock lock(this->_lock);
 
+		if(this->_capture) {
+			if(!this->_capture->start(this->_pin))
+				return false;
+
+			this->_pin.mode(PinMode::INPUT_PULLUP);
+			lwiot_sleep(DhtBus::CaptureTime);
+			this->_capture->stop();
+
+			return this->decode(bits);
+		}
+
 		enter_critical();
 		retval = this->_read(bits);
 		exit_critical();
 
 		return retval;
 	}
+
+	bool DhtBus::read(stl::Vector<bool>& bits)
+	{
+		this->start();
+		lwiot_sleep(DhtBus::StartTime);
+
+		return this->finish(bits);
+	}
 }
@@ -7,6 +7,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <lwiot/lwiot.h>
 #include <lwiot/io/gpiopin.h>
@@ -20,7 +21,8 @@
 
 namespace lwiot
 {
-	OneWireBus::OneWireBus(const GpioPin& pin) : _pin(pin), _lock(false), _log("1-wire", stdout)
+	OneWireBus::OneWireBus(const GpioPin& pin) : _pin(pin), _lock(false), _log("1-wire", stdout),
+		_rom(0), _last_discrepancy(0), _last_device(false)
 	{
 		ScopedLock lock(this->_lock);
 
@@ -42,7 +44,11 @@ namespace lwiot
 	bool OneWireBus::reset()
 	{
 		ScopedLock lock(this->_lock);
+		return this->presence();
+	}
 
+	bool OneWireBus::presence()
+	{
 		this->_pin.mode(PinMode::OUTPUT_OPEN_DRAIN);
 		this->_pin.write(true);
 
@@ -58,7 +64,7 @@ namespace lwiot
 		bool retval = !this->_pin;
 		exit_critical();
 
-		if(this->wait(410))
+		if(!this->wait(410))
 			return false;
 
 		return retval;
@@ -148,7 +154,7 @@ namespace lwiot
 		this->_pin << true;
 		lwiot_udelay(11);
 
-		value = this->_pin;
+		value = this->_pin.read();
 		exit_critical();
 		lwiot_udelay(48);
 
@@ -208,14 +214,21 @@ namespace lwiot
 	}
 
 #define SELECT_ROM 0x55U
+#define SKIP_ROM   0xCCU
+#define SEARCH_ROM 0xF0U
 
 	bool OneWireBus::select(const onewire_addr_t& addr)
 	{
-		onewire_addr_t address = addr;
 		ScopedLock lock(this->_lock);
+		return this->address(addr);
+	}
+
+	bool OneWireBus::address(const onewire_addr_t& addr)
+	{
+		onewire_addr_t address = addr;
 
 		if(!this->write((uint8_t)SELECT_ROM))
-			return true;
+			return false;
 
 		for(auto i = 0U; i < sizeof(addr); i++) {
 			if(!this->write(static_cast<uint8_t>(address & 0xFF)))
@@ -225,4 +238,163 @@ namespace lwiot
 		}
 		return true;
 	}
+
+	bool OneWireBus::skip()
+	{
+		ScopedLock lock(this->_lock);
+		return this->write((uint8_t)SKIP_ROM);
+	}
+
+	void OneWireBus::resetSearch()
+	{
+		ScopedLock lock(this->_lock);
+
+		this->_rom = 0;
+		this->_last_discrepancy = 0;
+		this->_last_device = false;
+	}
+
+	bool OneWireBus::search(onewire_addr_t& addr)
+	{
+		ScopedLock lock(this->_lock);
+		return this->next(addr);
+	}
+
+	bool OneWireBus::next(onewire_addr_t& addr)
+	{
+		int last_zero = 0;
+		uint8_t rom[sizeof(onewire_addr_t)];
+
+		if(this->_last_device)
+			return false;
+
+		if(!this->presence() || !this->write((uint8_t)SEARCH_ROM))
+			return false;
+
+		for(int bit = 1; bit <= 64; bit++) {
+			bool id, complement, direction;
+			auto mask = 1ULL << (bit - 1);
+
+			if(this->read(id) != -EOK || this->read(complement) != -EOK)
+				return false;
+
+			if(id && complement) {
+				/* No device took part in this bit */
+				this->_last_discrepancy = 0;
+				return false;
+			}
+
+			if(id != complement) {
+				direction = id;
+			} else {
+				if(bit < this->_last_discrepancy)
+					direction = (this->_rom & mask) != 0;
+				else
+					direction = bit == this->_last_discrepancy;
+
+				if(!direction)
+					last_zero = bit;
+			}
+
+			if(direction)
+				this->_rom |= mask;
+			else
+				this->_rom &= ~mask;
+
+			if(!this->write(direction))
+				return false;
+		}
+
+		for(auto idx = 0U; idx < sizeof(rom); idx++)
+			rom[idx] = static_cast<uint8_t>(this->_rom >> (idx * 8));
+
+		if(OneWireBus::crc8(rom, sizeof(rom)) != 0) {
+			this->_log << "ROM search CRC error" << Logger::newline;
+			return false;
+		}
+
+		this->_last_discrepancy = last_zero;
+		this->_last_device = last_zero == 0;
+
+		addr = this->_rom;
+		return true;
+	}
+
+	size_t OneWireBus::scan()
+	{
+		onewire_addr_t addr;
+
+		ScopedLock lock(this->_lock);
+
+		this->_rom = 0;
+		this->_last_discrepancy = 0;
+		this->_last_device = false;
+		this->_devices.clear();
+
+		while(this->next(addr))
+			this->_devices.pushback(addr);
+
+		return this->_devices.size();
+	}
+
+	const stl::Vector<onewire_addr_t>& OneWireBus::devices() const
+	{
+		return this->_devices;
+	}
+
+	bool OneWireBus::broadcast(uint8_t command)
+	{
+		ScopedLock lock(this->_lock);
+
+		if(!this->presence())
+			return false;
+
+		return this->write((uint8_t)SKIP_ROM) && this->write(command);
+	}
+
+	size_t OneWireBus::read(uint8_t command, uint8_t *data, size_t length, bool crc)
+	{
+		size_t valid = 0;
+		ScopedLock lock(this->_lock);
+
+		for(auto addr : this->_devices) {
+			bool ok = this->presence() && this->address(addr) && this->write(command);
+
+			for(auto idx = 0U; ok && idx < length; idx++)
+				ok = this->read(data[idx]);
+
+			if(ok && crc)
+				ok = OneWireBus::crc8(data, length) == 0;
+
+			if(ok)
+				valid++;
+			else
+				memset(data, 0xFF, length);
+
+			data += length;
+		}
+
+		return valid;
+	}
+
+	uint8_t OneWireBus::crc8(const uint8_t *data, size_t length)
+	{
+		uint8_t crc = 0;
+
+		while(length--) {
+			auto byte = *data++;
+
+			for(int idx = 0; idx < 8; idx++) {
+				auto mix = (crc ^ byte) & 0x01;
+
+				crc >>= 1;
+				if(mix)
+					crc ^= 0x8C;
+
+				byte >>= 1;
+			}
+		}
+
+		return crc;
+	}
 }
@@ -0,0 +1,208 @@
+/*
+ * Timer driven LED animations.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/io/leddriver.h>
+#include <lwiot/io/rgbleddriver.h>
+#include <lwiot/io/ledanimator.h>
+
+namespace lwiot
+{
+	LedAnimator::LedAnimator(int tick) : _lock(false), _timer(TimerType::Periodic, tick), _running(false)
+	{
+	}
+
+	LedAnimator::~LedAnimator()
+	{
+		ScopedLock lock(this->_lock);
+
+		this->_animations.clear();
+		this->_timer.stop();
+		this->_running = false;
+	}
+
+	double LedAnimator::ease(Easing easing, double t)
+	{
+		switch(easing) {
+		case Easing::EaseIn:
+			return t * t;
+
+		case Easing::EaseOut:
+			return 1.0 - (1.0 - t) * (1.0 - t);
+
+		case Easing::EaseInOut:
+			return t * t * (3.0 - 2.0 * t);
+
+		default:
+		case Easing::Linear:
+			return t;
+		}
+	}
+
+	void LedAnimator::fade(LedDriver& led, double brightness, int ms, Easing easing)
+	{
+		Animation animation;
+
+		if(brightness < 0.0)
+			brightness = 0.0;
+
+		if(ms <= 0) {
+			this->cancel(led);
+			led.setBrightness(brightness);
+			return;
+		}
+
+		animation.led = &led;
+		animation.rgb = nullptr;
+		animation.from = led.brightness();
+		animation.to = brightness;
+		animation.start = lwiot_tick_ms();
+		animation.duration = ms;
+		animation.easing = easing;
+		animation.repeat = false;
+		animation.hardware = false;
+
+		/* The hardware only fades linearly. */
+		if(easing == Easing::Linear)
+			animation.hardware = led.channel().fade(brightness, ms);
+
+		this->add(animation);
+	}
+
+	void LedAnimator::fade(RgbLedDriver& led, uint8_t r, uint8_t g, uint8_t b, int ms, Easing easing)
+	{
+		this->cancel(led);
+
+		this->fade(led.red(), static_cast<double>(r) / UINT8_MAX * 100.0, ms, easing);
+		this->fade(led.green(), static_cast<double>(g) / UINT8_MAX * 100.0, ms, easing);
+		this->fade(led.blue(), static_cast<double>(b) / UINT8_MAX * 100.0, ms, easing);
+	}
+
+	void LedAnimator::rotate(RgbLedDriver& led, int period, double s, double v, bool repeat)
+	{
+		Animation animation;
+
+		if(period <= 0)
+			return;
+
+		this->cancel(led);
+
+		animation.led = nullptr;
+		animation.rgb = &led;
+		animation.from = s;
+		animation.to = v;
+		animation.start = lwiot_tick_ms();
+		animation.duration = period;
+		animation.easing = Easing::Linear;
+		animation.repeat = repeat;
+		animation.hardware = false;
+
+		this->add(animation);
+	}
+
+	void LedAnimator::cancel(LedDriver& led)
+	{
+		ScopedLock lock(this->_lock);
+		this->remove(&led, nullptr);
+	}
+
+	void LedAnimator::cancel(RgbLedDriver& led)
+	{
+		ScopedLock lock(this->_lock);
+
+		this->remove(nullptr, &led);
+		this->remove(&led.red(), nullptr);
+		this->remove(&led.green(), nullptr);
+		this->remove(&led.blue(), nullptr);
+	}
+
+	size_t LedAnimator::active() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_animations.size();
+	}
+
+	void LedAnimator::add(const Animation& animation)
+	{
+		ScopedLock lock(this->_lock);
+
+		this->remove(animation.led, animation.rgb);
+		this->_animations.pushback(animation);
+
+		if(!this->_running) {
+			this->_running = true;
+			this->_timer.start([this]() {
+				this->tick();
+			});
+		}
+	}
+
+	void LedAnimator::remove(const LedDriver* led, const RgbLedDriver* rgb)
+	{
+		stl::Vector<Animation> keep;
+
+		for(auto& animation : this->_animations) {
+			if(led != nullptr && animation.led == led)
+				continue;
+
+			if(rgb != nullptr && animation.rgb == rgb)
+				continue;
+
+			keep.pushback(animation);
+		}
+
+		this->_animations = keep;
+	}
+
+	void LedAnimator::tick()
+	{
+		stl::Vector<Animation> keep;
+		ScopedLock lock(this->_lock);
+		auto now = lwiot_tick_ms();
+
+		for(auto& animation : this->_animations) {
+			auto t = static_cast<double>(now - animation.start) / animation.duration;
+			auto done = t >= 1.0;
+
+			if(done)
+				t = 1.0;
+
+			if(animation.led != nullptr) {
+				/* A hardware fade only has to be recorded once it is done. */
+				if(!animation.hardware || done) {
+					auto eased = LedAnimator::ease(animation.easing, t);
+					animation.led->setBrightness(animation.from + (animation.to - animation.from) * eased);
+				}
+			} else {
+				if(done && animation.repeat) {
+					animation.start += (now - animation.start) / animation.duration * animation.duration;
+					t = static_cast<double>(now - animation.start) / animation.duration;
+					done = false;
+				}
+
+				auto hue = static_cast<int>(t * 360.0) % 360;
+				animation.rgb->setHSV(hue, animation.from, animation.to);
+			}
+
+			if(!done)
+				keep.pushback(animation);
+		}
+
+		this->_animations = keep;
+
+		if(this->_animations.size() == 0) {
+			this->_timer.stop();
+			this->_running = false;
+		}
+	}
+}
@@ -17,22 +17,54 @@
 
 namespace lwiot
 {
-	PwmChannel::PwmChannel() : _pin(-1) {}
+	PwmChannel::PwmChannel() : _pin(-1), _level(0) {}
 
-	PwmChannel::PwmChannel(int pin) : _pin(pin)
+	PwmChannel::PwmChannel(int pin) : _pin(pin), _level(0)
 	{ }
 
-	PwmChannel::PwmChannel(const GpioPin& pin) : _pin(pin)
+	PwmChannel::PwmChannel(const GpioPin& pin) : _pin(pin), _level(0)
 	{ }
 
-	const double& PwmChannel::duty() const
+	double PwmChannel::duty() const
 	{
-		return this->_duty;
+		return static_cast<double>(this->_level) * 100.0 / this->resolution();
 	}
 
 	void PwmChannel::setDutyCycle(const double& duty)
 	{
-		this->_duty = duty;
+		auto max = this->resolution();
+
+		if(duty <= 0.0)
+			this->_level = 0;
+		else if(duty >= 100.0)
+			this->_level = max;
+		else
+			this->_level = static_cast<uint32_t>(duty * max / 100.0 + 0.5);
+	}
+
+	uint32_t PwmChannel::level() const
+	{
+		return this->_level;
+	}
+
+	void PwmChannel::setLevel(uint32_t level)
+	{
+		auto max = this->resolution();
+
+		this->_level = level > max ? max : level;
+	}
+
+	uint32_t PwmChannel::resolution() const
+	{
+		return (1UL << CONFIG_PWM_RESOLUTION) - 1;
+	}
+
+	bool PwmChannel::fade(const double& duty, int ms)
+	{
+		UNUSED(duty);
+		UNUSED(ms);
+
+		return false;
 	}
 
 	void PwmChannel::setGpioPin(const GpioPin& pin)
@@ -66,5 +66,11 @@ namespace lwiot
 		for(auto channel : this->_channels) {
 			channel->update(this->_freq);
 		}
+
+		this->commit();
+	}
+
+	void PwmTimer::commit()
+	{
 	}
 }
@@ -8,7 +8,6 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <lwiot.h>
-#include <math.h>
 
 #include <lwiot/system.h>
 
@@ -34,19 +33,33 @@ namespace lwiot
 		this->_blue = b;
 	}
 
-	void RgbLedDriver::set(uint8_t r, uint8_t g, uint8_t b)
+	LedDriver& RgbLedDriver::red()
 	{
-		double r_percent;
-		double g_percent;
-		double b_percent;
+		return this->_red;
+	}
 
-		r_percent = (static_cast<double>(r) / UINT8_MAX) * 100.0;
-		g_percent = (static_cast<double>(g) / UINT8_MAX) * 100.0;
-		b_percent = (static_cast<double>(b) / UINT8_MAX) * 100.0;
+	LedDriver& RgbLedDriver::green()
+	{
+		return this->_green;
+	}
 
-		this->_red.setBrightness(r_percent);
-		this->_green.setBrightness(g_percent);
-		this->_blue.setBrightness(b_percent);
+	LedDriver& RgbLedDriver::blue()
+	{
+		return this->_blue;
+	}
+
+	void RgbLedDriver::set(uint8_t r, uint8_t g, uint8_t b)
+	{
+		this->_red.set(r);
+		this->_green.set(g);
+		this->_blue.set(b);
+	}
+
+	void RgbLedDriver::setGamma(bool enabled)
+	{
+		this->_red.setGamma(enabled);
+		this->_green.setGamma(enabled);
+		this->_blue.setGamma(enabled);
 	}
 
 	void RgbLedDriver::fadeBrightness(bool out, int ms, double stepsize)
@@ -135,26 +148,51 @@ namespace lwiot
 		}
 	}
 
+	uint8_t RgbLedDriver::toByte(double value)
+	{
+		if(value <= 0.0)
+			return 0;
+
+		if(value >= 1.0)
+			return UINT8_MAX;
+
+		return static_cast<uint8_t>(value * UINT8_MAX + 0.5);
+	}
+
+	void RgbLedDriver::setHSV(int h, double s, double v)
+	{
+		uint8_t r, g, b;
+
+		hsvToRgb(h, toByte(s), toByte(v), r, g, b);
+		this->set(r, g, b);
+	}
+
 	/*
 	 * This implementation is based on:
 	 *
 	 *  -> https://github.com/BretStateham/RGBLED/blob/master/RGBLED.cpp
 	 *  -> http://www.splinter.com.au/converting-hsv-to-rgb-colour-using-c/
 	 */
-	void RgbLedDriver::setHSV(int h, double s, double v)
+	void RgbLedDriver::hsvToRgb(int h, uint8_t s, uint8_t v, uint8_t& r, uint8_t& g, uint8_t& b)
 	{
-		double r = 0;
-		double g = 0;
-		double b = 0;
+		int region, f;
+		uint8_t pv, qv, tv;
+
+		h %= 360;
 
-		auto i = static_cast<int>(::floor(h / 60.0));
+		if(h < 0)
+			h += 360;
 
-		double f = h / 60.0 - i;
-		double pv = v * (1 - s);
-		double qv = v * (1 - s * f);
-		double tv = v * (1 - s * (1 - f));
+		region = h / 60;
+		/* Position within the region, 0 - 255. */
+		f = (h - region * 60) * UINT8_MAX / 60;
 
-		switch(i) {
+		pv = static_cast<uint8_t>(v * (UINT8_MAX - s) / UINT8_MAX);
+		qv = static_cast<uint8_t>(v * (UINT8_MAX - s * f / UINT8_MAX) / UINT8_MAX);
+		tv = static_cast<uint8_t>(v * (UINT8_MAX - s * (UINT8_MAX - f) / UINT8_MAX) / UINT8_MAX);
+
+		switch(region) {
+		default:
 		case 0:
 			r = v;
 			g = tv;
@@ -172,6 +210,7 @@ namespace lwiot
 			g = v;
 			b = tv;
 			break;
+
 		case 3:
 			r = pv;
 			g = qv;
@@ -189,25 +228,7 @@ namespace lwiot
 			g = pv;
 			b = qv;
 			break;
-
-		default:
-			print_dbg("Invalid HSV value!\n");
-			return;
 		}
-
-		r *= 255;
-		g *= 255;
-		b *= 255;
-
-		clamp(r, 0, 255);
-		clamp(g, 0, 255);
-		clamp(b, 0, 255);
-
-		auto red = static_cast<uint8_t> (r);
-		auto green = static_cast<uint8_t> (g);
-		auto blue = static_cast<uint8_t> (b);
-
-		this->set(red, green, blue);
 	}
 
 	void RgbLedDriver::rotate(int ms)
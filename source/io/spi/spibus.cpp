@@ -14,11 +14,13 @@
 #include <lwiot/bufferedstream.h>
 #include <lwiot/io/spimessage.h>
 #include <lwiot/io/spibus.h>
+#include <lwiot/scopedlock.h>
 
 namespace lwiot
 {
 	SpiBus::SpiBus(int mosi, int miso, int clk, uint32_t freq) :
-		_miso(miso), _mosi(mosi), _clk(clk), _freq(freq)
+		_miso(miso), _mosi(mosi), _clk(clk), _freq(freq), _mode(SpiMode::Mode0),
+		_selected(-1), _lock(true)
 	{
 	}
 
@@ -27,6 +29,11 @@ namespace lwiot
 		return this->_freq;
 	}
 
+	const SpiMode& SpiBus::mode() const
+	{
+		return this->_mode;
+	}
+
 	const GpioPin& SpiBus::miso() const
 	{
 		return this->_miso;
@@ -47,11 +54,62 @@ namespace lwiot
 		this->_freq = freq;
 	}
 
+	void SpiBus::setMode(SpiMode mode)
+	{
+		this->_mode = mode;
+	}
+
+	void SpiBus::configure(uint32_t freq, SpiMode mode)
+	{
+		ScopedLock lock(this->_lock);
+
+		if(freq != this->_freq) {
+			this->setFrequency(freq);
+			this->_freq = freq;
+		}
+
+		if(mode != this->_mode) {
+			this->setMode(mode);
+			this->_mode = mode;
+		}
+	}
+
+	void SpiBus::select(const SpiMessage& msg)
+	{
+		if(this->_selected.pin() == msg.cspin().pin())
+			return;
+
+		this->release();
+		this->_selected = msg.cspin();
+		this->_selected.write(false);
+	}
+
+	void SpiBus::release(const SpiMessage& msg)
+	{
+		if(msg.hold())
+			return;
+
+		this->release();
+	}
+
+	void SpiBus::release()
+	{
+		if(this->_selected.pin() < 0)
+			return;
+
+		this->_selected.write(true);
+		this->_selected = -1;
+	}
+
 	bool SpiBus::transfer(stl::Vector<SpiMessage>& msgs)
 	{
+		ScopedLock lock(this->_lock);
+
 		for(SpiMessage& msg : msgs) {
-			if(!this->transfer(msg))
+			if(!this->transfer(msg)) {
+				this->release();
 				return false;
+			}
 		}
 
 		return true;
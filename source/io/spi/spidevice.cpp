@@ -0,0 +1,74 @@
+/*
+ * SPI slave device.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/io/spibus.h>
+#include <lwiot/io/spidevice.h>
+
+namespace lwiot
+{
+	SpiDevice::SpiDevice(SpiBus& bus, int cs, uint32_t freq, SpiMode mode) :
+		_bus(bus), _cs(cs), _freq(freq), _mode(mode)
+	{
+		this->_cs.mode(PinMode::OUTPUT);
+		this->_cs.write(true);
+	}
+
+	const GpioPin& SpiDevice::cs() const
+	{
+		return this->_cs;
+	}
+
+	const uint32_t& SpiDevice::frequency() const
+	{
+		return this->_freq;
+	}
+
+	const SpiMode& SpiDevice::mode() const
+	{
+		return this->_mode;
+	}
+
+	SpiBus& SpiDevice::bus() const
+	{
+		return this->_bus;
+	}
+
+	void SpiDevice::setFrequency(uint32_t freq)
+	{
+		this->_freq = freq;
+	}
+
+	void SpiDevice::setMode(SpiMode mode)
+	{
+		this->_mode = mode;
+	}
+
+	bool SpiDevice::transfer(SpiMessage& msg)
+	{
+		ScopedLock lock(this->_bus._lock);
+
+		this->_bus.configure(this->_freq, this->_mode);
+		return this->_bus.transfer(msg);
+	}
+
+	bool SpiDevice::transfer(stl::Vector<SpiMessage>& msgs)
+	{
+		ScopedLock lock(this->_bus._lock);
+		auto last = msgs.size();
+
+		for(auto& msg : msgs)
+			msg.setHold(--last != 0);
+
+		this->_bus.configure(this->_freq, this->_mode);
+		return this->_bus.transfer(msgs);
+	}
+}
@@ -21,7 +21,7 @@ namespace lwiot
 	}
 
 	SpiMessage::SpiMessage(const size_t &size, const lwiot::GpioPin &pin) :
-		_tx(size, true), _rx(size, true), _idx(0), _size(size), _cspin(pin)
+		_tx(size, true), _rx(size, true), _idx(0), _size(size), _cspin(pin), _hold(false)
 	{
 	}
 
@@ -46,6 +46,16 @@ namespace lwiot
 		return this->_cspin;
 	}
 
+	void SpiMessage::setHold(bool hold)
+	{
+		this->_hold = hold;
+	}
+
+	bool SpiMessage::hold() const
+	{
+		return this->_hold;
+	}
+
 	SpiMessage& SpiMessage::operator<<(const uint8_t *msg)
 	{
 		while(*msg) {
@@ -0,0 +1,39 @@
+/*
+ * Waveform output on the MOSI line of an SPI bus.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/spibus.h>
+#include <lwiot/io/spimessage.h>
+#include <lwiot/io/waveform.h>
+#include <lwiot/io/spiwaveform.h>
+
+namespace lwiot
+{
+	SpiWaveform::SpiWaveform(SpiBus& bus, int cs) : _bus(bus), _cs(cs)
+	{
+	}
+
+	bool SpiWaveform::write(const Waveform& wave)
+	{
+		auto data = wave.data();
+
+		if(wave.size() == 0)
+			return true;
+
+		SpiMessage msg(wave.size(), this->_cs);
+
+		for(size_t idx = 0; idx < wave.size(); idx++)
+			msg << data[idx];
+
+		this->_bus.configure(1000000000UL / wave.resolution(), SpiMode::Mode0);
+		return this->_bus.transfer(msg);
+	}
+}
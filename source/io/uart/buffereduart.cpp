@@ -0,0 +1,214 @@
+/*
+ * Interrupt driven, buffered UART.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/error.h>
+#include <lwiot/io/uart.h>
+#include <lwiot/io/buffereduart.h>
+
+namespace lwiot
+{
+	BufferedUart::BufferedUart(int tx, int rx, long baud, uint32_t config, size_t rxsize, size_t txsize) :
+		BufferedUart(GpioPin(tx), GpioPin(rx), baud, config, rxsize, txsize)
+	{
+	}
+
+	BufferedUart::BufferedUart(const GpioPin& tx, const GpioPin& rx, long baud, uint32_t config,
+							   size_t rxsize, size_t txsize) : Uart(tx, rx, baud, config),
+		_rx(rxsize), _tx(txsize), _rx_event(EventType::Counting, 1), _tx_event(EventType::Counting, 1),
+		_received(0), _consumed(0), _frame(0), _overruns(0), _transmitting(false)
+	{
+	}
+
+	static int remaining(time_t deadline, int tmo)
+	{
+		time_t now;
+
+		if(tmo == FOREVER)
+			return FOREVER;
+
+		now = lwiot_tick_ms();
+		return now >= deadline ? -1 : static_cast<int>(deadline - now);
+	}
+
+	size_t BufferedUart::available() const
+	{
+		return this->_rx.available();
+	}
+
+	size_t BufferedUart::overruns() const
+	{
+		return this->_overruns.load();
+	}
+
+	uint8_t BufferedUart::read()
+	{
+		uint8_t byte;
+
+		if(this->read(&byte, sizeof(byte), static_cast<int>(this->_timeout)) != sizeof(byte))
+			return static_cast<uint8_t>(EOF);
+
+		return byte;
+	}
+
+	ssize_t BufferedUart::read(void *output, const size_t& length)
+	{
+		return this->read(output, length, static_cast<int>(this->_timeout));
+	}
+
+	ssize_t BufferedUart::take(void *output, size_t length)
+	{
+		auto num = this->_rx.read(output, length);
+
+		this->_consumed.fetch_add(num);
+		return num;
+	}
+
+	ssize_t BufferedUart::read(void *output, size_t length, int tmo)
+	{
+		auto deadline = lwiot_tick_ms() + tmo;
+		auto data = static_cast<uint8_t*>(output);
+		size_t num = 0;
+
+		while(num < length) {
+			num += this->take(data + num, length - num);
+
+			if(num == length)
+				break;
+
+			auto wait = remaining(deadline, tmo);
+
+			if(wait < 0 || (!this->_rx_event.wait(wait) && remaining(deadline, tmo) < 0))
+				break;
+		}
+
+		if(num == 0 && length > 0)
+			return -ETMO;
+
+		return num;
+	}
+
+	ssize_t BufferedUart::readFrame(void *output, size_t length, int tmo)
+	{
+		auto deadline = lwiot_tick_ms() + tmo;
+
+		/* Bytes taken by read() may already have passed the last idle mark. */
+		while(static_cast<ssize_t>(this->_frame.load() - this->_consumed.load()) <= 0) {
+			auto wait = remaining(deadline, tmo);
+
+			if(wait < 0)
+				return -ETMO;
+
+			this->_rx_event.wait(wait);
+		}
+
+		auto pending = this->_frame.load() - this->_consumed.load();
+
+		if(length > pending)
+			length = pending;
+
+		return this->take(output, length);
+	}
+
+	bool BufferedUart::write(uint8_t byte)
+	{
+		return this->write(&byte, sizeof(byte)) == sizeof(byte);
+	}
+
+	ssize_t BufferedUart::write(const void *bytes, const size_t& length)
+	{
+		auto deadline = lwiot_tick_ms() + this->_timeout;
+		auto tmo = static_cast<int>(this->_timeout);
+		auto data = static_cast<const uint8_t*>(bytes);
+		size_t num = 0;
+
+		while(true) {
+			num += this->_tx.write(data + num, length - num);
+
+			/* Start the transmitter if it went idle. */
+			if(!this->_transmitting.exchange(true))
+				this->startTransmit();
+
+			if(num == length)
+				break;
+
+			auto wait = remaining(deadline, tmo);
+
+			if(wait < 0 || (!this->_tx_event.wait(wait) && remaining(deadline, tmo) < 0))
+				break;
+		}
+
+		return num;
+	}
+
+	bool BufferedUart::flush(int tmo)
+	{
+		auto deadline = lwiot_tick_ms() + tmo;
+
+		while(this->_tx.available() > 0 || this->_transmitting.load()) {
+			auto wait = remaining(deadline, tmo);
+
+			if(wait < 0)
+				return false;
+
+			this->_tx_event.wait(wait);
+		}
+
+		return true;
+	}
+
+	size_t RAM_ATTR BufferedUart::received(const uint8_t *data, size_t length)
+	{
+		auto num = static_cast<size_t>(this->_rx.write(data, length));
+
+		this->_received.fetch_add(num);
+
+		if(num < length)
+			this->_overruns.fetch_add(length - num);
+
+		if(num > 0)
+			this->_rx_event.signalFromIrq();
+
+		return num;
+	}
+
+	void RAM_ATTR BufferedUart::idle()
+	{
+		auto received = this->_received.load();
+
+		if(this->_frame.exchange(received) != received)
+			this->_rx_event.signalFromIrq();
+	}
+
+	size_t RAM_ATTR BufferedUart::transmit(uint8_t *data, size_t length)
+	{
+		auto num = this->_tx.read(data, length);
+
+		if(num == 0) {
+			this->_transmitting.store(false);
+
+			/*
+			 * A writer may have queued data after the ring was found empty, but before the flag
+			 * was cleared. It did not start the transmitter, so continue here.
+			 */
+			if(this->_tx.available() == 0 || this->_transmitting.exchange(true)) {
+				this->_tx_event.signalFromIrq();
+				return 0;
+			}
+
+			num = this->_tx.read(data, length);
+		}
+
+		this->_tx_event.signalFromIrq();
+		return num;
+	}
+}
@@ -0,0 +1,199 @@
+/*
+ * Watchdog supervision of threads.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/kernel/uniquelock.h>
+#include <lwiot/io/watchdogsupervisor.h>
+
+namespace lwiot
+{
+	Heartbeat::Heartbeat(WatchdogSupervisor& supervisor, const char *name, uint32_t tmo) : _supervisor(supervisor)
+	{
+		this->_last = supervisor.attach(name, tmo);
+	}
+
+	Heartbeat::~Heartbeat()
+	{
+		if(this->_last != nullptr)
+			this->_supervisor.detach(this->_last);
+	}
+
+	bool Heartbeat::registered() const
+	{
+		return this->_last != nullptr;
+	}
+
+	WatchdogSupervisor::WatchdogSupervisor(Watchdog& watchdog, int interval) : Thread("wdt-supervisor"),
+		_watchdog(watchdog), _interval(interval), _lock(false), _running(false)
+	{
+		for(auto& slot : this->_slots) {
+			slot.name = nullptr;
+			slot.timeout = 0;
+			slot.used = false;
+			slot.reported = false;
+		}
+	}
+
+	WatchdogSupervisor::~WatchdogSupervisor()
+	{
+		this->end();
+	}
+
+	bool WatchdogSupervisor::begin(uint32_t tmo)
+	{
+		UniqueLock<Lock> lock(this->_lock);
+
+		if(this->_running)
+			return false;
+
+		/* The watchdog would expire before it is fed for the first time. */
+		if(static_cast<uint32_t>(this->_interval) >= tmo) {
+			print_dbg("Watchdog timeout of %u ms is shorter than the supervision interval\n", tmo);
+			return false;
+		}
+
+		if(!this->_watchdog.enable(tmo))
+			return false;
+
+		this->_running = true;
+		lock.unlock();
+
+		this->start();
+		return true;
+	}
+
+	void WatchdogSupervisor::end()
+	{
+		UniqueLock<Lock> lock(this->_lock);
+
+		if(!this->_running)
+			return;
+
+		this->_running = false;
+		lock.unlock();
+
+		this->_wakeup.signal();
+		this->join();
+		this->_watchdog.disable();
+	}
+
+	void WatchdogSupervisor::setStallHandler(const StallHandler& handler)
+	{
+		ScopedLock lock(this->_lock);
+		this->_handler = handler;
+	}
+
+	Atomic<uint32_t> *WatchdogSupervisor::attach(const char *name, uint32_t tmo)
+	{
+		ScopedLock lock(this->_lock);
+
+		for(auto& slot : this->_slots) {
+			if(slot.used)
+				continue;
+
+			slot.name = name;
+			slot.timeout = tmo;
+			slot.used = true;
+			slot.reported = false;
+			slot.last.store(static_cast<uint32_t>(lwiot_tick_ms()));
+
+			return &slot.last;
+		}
+
+		print_dbg("No free watchdog slot for %s\n", name);
+		return nullptr;
+	}
+
+	void WatchdogSupervisor::detach(Atomic<uint32_t> *last)
+	{
+		ScopedLock lock(this->_lock);
+
+		for(auto& slot : this->_slots) {
+			if(&slot.last == last)
+				slot.used = false;
+		}
+	}
+
+	/* Ages are computed on 32 bit ticks, so they are correct across a wrap of the tick. */
+	bool WatchdogSupervisor::check()
+	{
+		HeartbeatStatus stalls[CONFIG_WATCHDOG_HEARTBEATS];
+		size_t num = 0;
+		bool healthy = true;
+		UniqueLock<Lock> lock(this->_lock);
+		auto now = static_cast<uint32_t>(lwiot_tick_ms());
+
+		for(auto& slot : this->_slots) {
+			if(!slot.used)
+				continue;
+
+			auto age = now - slot.last.load(memory_order_relaxed);
+
+			if(age <= slot.timeout) {
+				slot.reported = false;
+				continue;
+			}
+
+			healthy = false;
+
+			if(slot.reported)
+				continue;
+
+			slot.reported = true;
+			stalls[num++] = { slot.name, slot.timeout, age, true };
+		}
+
+		auto handler = this->_handler;
+		lock.unlock();
+
+		for(size_t idx = 0; idx < num; idx++) {
+			print_dbg("Thread %s stalled for %u ms\n", stalls[idx].name, stalls[idx].age);
+
+			if(handler)
+				handler(stalls[idx]);
+		}
+
+		if(healthy)
+			this->_watchdog.reset();
+
+		return healthy;
+	}
+
+	stl::Vector<HeartbeatStatus> WatchdogSupervisor::report() const
+	{
+		ScopedLock lock(this->_lock);
+		stl::Vector<HeartbeatStatus> rv(CONFIG_WATCHDOG_HEARTBEATS);
+		auto now = static_cast<uint32_t>(lwiot_tick_ms());
+
+		for(auto& slot : this->_slots) {
+			if(!slot.used)
+				continue;
+
+			auto age = now - slot.last.load(memory_order_relaxed);
+			rv.push_back({ slot.name, slot.timeout, age, age > slot.timeout });
+		}
+
+		return rv;
+	}
+
+	void WatchdogSupervisor::run()
+	{
+		UniqueLock<Lock> lock(this->_lock);
+
+		while(this->_running) {
+			lock.unlock();
+			this->check();
+			this->_wakeup.wait(this->_interval);
+			lock.lock();
+		}
+	}
+}
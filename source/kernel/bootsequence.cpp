@@ -0,0 +1,378 @@
+/*
+ * Parallel start up of components with dependencies.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/kernel/uniquelock.h>
+#include <lwiot/kernel/bootsequence.h>
+#include <lwiot/kernel/clock.h>
+#include <lwiot/util/trace.h>
+
+namespace lwiot
+{
+	static const char *status_name(BootStatus status)
+	{
+		switch(status) {
+		case BootStatus::Running:
+			return "running";
+
+		case BootStatus::Done:
+			return "done";
+
+		case BootStatus::Failed:
+			return "failed";
+
+		case BootStatus::Skipped:
+			return "skipped";
+
+		default:
+			return "pending";
+		}
+	}
+
+	BootSequence::BootSequence(Executor& executor) : _executor(executor), _lock(false), _done(EventType::Counting),
+		_started(false), _unknown(false), _epoch(0), _last(0)
+	{
+	}
+
+	BootSequence::~BootSequence()
+	{
+		/* Initializers that are still queued refer to this object; the executor must be running. */
+		this->wait();
+
+		for(auto component : this->_components)
+			delete component;
+	}
+
+	BootSequence& BootSequence::add(const String& name, const Initializer& init, bool lazy)
+	{
+		ScopedLock g(this->_lock);
+		auto component = new Component();
+
+		component->name = name;
+		component->init = init;
+		component->lazy = lazy;
+		component->wanted = false;
+		component->status = BootStatus::Pending;
+		component->queued = 0;
+		component->started = 0;
+		component->finished = 0;
+
+		this->_components.push_back(component);
+		return *this;
+	}
+
+	BootSequence& BootSequence::after(const String& name, const String& dependency)
+	{
+		ScopedLock g(this->_lock);
+		auto idx = this->find(name);
+
+		if(idx < 0) {
+			print_dbg("Boot component %s is unknown\n", name.c_str());
+			this->_unknown = true;
+			return *this;
+		}
+
+		this->_components[idx]->after.push_back(dependency);
+		return *this;
+	}
+
+	int BootSequence::find(const String& name) const
+	{
+		for(size_t idx = 0; idx < this->_components.size(); idx++) {
+			if(this->_components[idx]->name == name)
+				return static_cast<int>(idx);
+		}
+
+		return -1;
+	}
+
+	/* Resolve the dependency names, once, and check that they can be satisfied. */
+	bool BootSequence::prepare()
+	{
+		if(this->_started)
+			return true;
+
+		if(this->_unknown)
+			return false;
+
+		for(auto component : this->_components) {
+			component->dependencies.clear();
+
+			for(auto& name : component->after) {
+				auto idx = this->find(name);
+
+				if(idx < 0) {
+					print_dbg("Boot component %s depends on unknown %s\n", component->name.c_str(), name.c_str());
+					return false;
+				}
+
+				component->dependencies.push_back(static_cast<size_t>(idx));
+			}
+		}
+
+		stl::Vector<uint8_t> marks(this->_components.size());
+
+		for(size_t idx = 0; idx < this->_components.size(); idx++)
+			marks.push_back(0);
+
+		for(size_t idx = 0; idx < this->_components.size(); idx++) {
+			if(!this->acyclic(idx, marks)) {
+				print_dbg("Boot dependencies of %s form a cycle\n", this->_components[idx]->name.c_str());
+				return false;
+			}
+		}
+
+		this->_epoch = Clock::now();
+		this->_last = this->_epoch;
+		this->_started = true;
+
+		return true;
+	}
+
+	/* Depth first search; marks are 0 for unvisited, 1 while on the path and 2 once checked. */
+	bool BootSequence::acyclic(size_t idx, stl::Vector<uint8_t>& marks) const
+	{
+		if(marks[idx] == 2)
+			return true;
+
+		if(marks[idx] == 1)
+			return false;
+
+		marks[idx] = 1;
+
+		for(auto dependency : this->_components[idx]->dependencies) {
+			if(!this->acyclic(dependency, marks))
+				return false;
+		}
+
+		marks[idx] = 2;
+		return true;
+	}
+
+	void BootSequence::want(size_t idx)
+	{
+		auto component = this->_components[idx];
+
+		if(component->wanted)
+			return;
+
+		component->wanted = true;
+
+		for(auto dependency : component->dependencies)
+			this->want(dependency);
+	}
+
+	/*
+	 * Post the wanted components whose dependencies are done, and skip those with a failed
+	 * dependency. Skipping one can skip others, so repeat until nothing changes. Must be called
+	 * with the lock held.
+	 */
+	void BootSequence::dispatch()
+	{
+		bool changed = true;
+
+		while(changed) {
+			changed = false;
+
+			for(size_t idx = 0; idx < this->_components.size(); idx++) {
+				auto component = this->_components[idx];
+				auto ready = true;
+				auto failed = false;
+
+				if(!component->wanted || component->status != BootStatus::Pending)
+					continue;
+
+				for(auto dependency : component->dependencies) {
+					auto status = this->_components[dependency]->status;
+
+					ready = ready && status == BootStatus::Done;
+					failed = failed || status == BootStatus::Failed || status == BootStatus::Skipped;
+				}
+
+				if(failed) {
+					component->status = BootStatus::Skipped;
+					changed = true;
+					continue;
+				}
+
+				if(!ready)
+					continue;
+
+				component->status = BootStatus::Running;
+				component->queued = Clock::now();
+
+				if(!this->_executor.post([this, idx]() { this->run(idx); })) {
+					component->status = BootStatus::Failed;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	void BootSequence::run(size_t idx)
+	{
+		UniqueLock<Lock> lock(this->_lock);
+		auto component = this->_components[idx];
+
+		component->started = Clock::now();
+		lock.unlock();
+
+		auto ok = component->init ? component->init() : true;
+		auto now = Clock::now();
+
+#ifdef CONFIG_TRACE
+		Tracer::record(component->name.c_str(), component->started, now);
+#endif
+
+		lock.lock();
+		component->finished = now;
+		component->status = ok ? BootStatus::Done : BootStatus::Failed;
+
+		if(now > this->_last)
+			this->_last = now;
+
+		this->dispatch();
+
+		/* Once the lock is released, wait() may return and the sequence may be destroyed. */
+		this->_done.broadcast();
+	}
+
+	bool BootSequence::finished(size_t idx) const
+	{
+		auto status = this->_components[idx]->status;
+		return status != BootStatus::Pending && status != BootStatus::Running;
+	}
+
+	bool BootSequence::start()
+	{
+		ScopedLock g(this->_lock);
+
+		if(!this->prepare())
+			return false;
+
+		for(size_t idx = 0; idx < this->_components.size(); idx++) {
+			if(!this->_components[idx]->lazy)
+				this->want(idx);
+		}
+
+		this->dispatch();
+		return true;
+	}
+
+	bool BootSequence::wait(int tmo)
+	{
+		ScopedLock g(this->_lock);
+		auto start = lwiot_tick_ms();
+
+		while(true) {
+			auto done = true;
+			auto busy = false;
+
+			for(size_t idx = 0; idx < this->_components.size(); idx++) {
+				if(!this->_components[idx]->wanted)
+					continue;
+
+				busy = busy || !this->finished(idx);
+				done = done && this->_components[idx]->status == BootStatus::Done;
+			}
+
+			if(!busy)
+				return done;
+
+			auto remaining = FOREVER;
+
+			if(tmo != FOREVER) {
+				remaining = tmo - static_cast<int>(lwiot_tick_ms() - start);
+
+				if(remaining <= 0)
+					return false;
+			}
+
+			this->_done.wait(g, remaining);
+		}
+	}
+
+	bool BootSequence::require(const String& name, int tmo)
+	{
+		ScopedLock g(this->_lock);
+		auto start = lwiot_tick_ms();
+		auto idx = this->find(name);
+
+		if(idx < 0 || !this->prepare())
+			return false;
+
+		this->want(static_cast<size_t>(idx));
+		this->dispatch();
+
+		while(!this->finished(static_cast<size_t>(idx))) {
+			auto remaining = FOREVER;
+
+			if(tmo != FOREVER) {
+				remaining = tmo - static_cast<int>(lwiot_tick_ms() - start);
+
+				if(remaining <= 0)
+					return false;
+			}
+
+			this->_done.wait(g, remaining);
+		}
+
+		return this->_components[idx]->status == BootStatus::Done;
+	}
+
+	BootStatus BootSequence::status(const String& name) const
+	{
+		ScopedLock g(this->_lock);
+		auto idx = this->find(name);
+
+		return idx < 0 ? BootStatus::Pending : this->_components[idx]->status;
+	}
+
+	stl::Vector<BootStep> BootSequence::steps() const
+	{
+		ScopedLock g(this->_lock);
+		stl::Vector<BootStep> rv(this->_components.size());
+
+		for(auto component : this->_components) {
+			BootStep step;
+
+			step.name = component->name;
+			step.status = component->status;
+			step.queued = component->queued != 0 ? component->queued - this->_epoch : 0;
+			step.started = component->started != 0 ? component->started - this->_epoch : 0;
+			step.duration = component->finished != 0 ? component->finished - component->started : 0;
+
+			rv.push_back(stl::move(step));
+		}
+
+		return rv;
+	}
+
+	uint64_t BootSequence::elapsed() const
+	{
+		ScopedLock g(this->_lock);
+		return this->_last - this->_epoch;
+	}
+
+	void BootSequence::report(Logger& logger) const
+	{
+		auto steps = this->steps();
+
+		for(auto& step : steps) {
+			logger.println("boot: {} {} after {} us, took {} us", step.name.c_str(), status_name(step.status),
+				static_cast<unsigned long>(step.started / 1000), static_cast<unsigned long>(step.duration / 1000));
+		}
+
+		logger.println("boot: finished in {} us", static_cast<unsigned long>(this->elapsed() / 1000));
+	}
+}
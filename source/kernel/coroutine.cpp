@@ -0,0 +1,171 @@
+/*
+ * Stackless coroutines.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#include <lwiot/stream.h>
+#include <lwiot/scopedlock.h>
+
+#include <lwiot/kernel/coroutine.h>
+#include <lwiot/kernel/executor.h>
+
+#include <lwiot/stl/move.h>
+
+namespace lwiot
+{
+	Coroutine::Coroutine() : _co_line(0), _lock(false), _event(), _executor(nullptr), _done(true),
+		_stream(nullptr), _bytes(0), _deadline(0), _timedout(false)
+	{
+	}
+
+	bool Coroutine::start(Executor& executor)
+	{
+		ScopedLock lock(this->_lock);
+
+		if(!this->_done)
+			return false;
+
+		this->_executor = &executor;
+		this->_done = false;
+		this->_co_line = 0;
+		this->_stream = nullptr;
+		this->_deadline = 0;
+		this->_timedout = false;
+
+		if(!executor.post([this]() { this->resume(); })) {
+			this->_done = true;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool Coroutine::done() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_done;
+	}
+
+	bool Coroutine::join(int tmo)
+	{
+		ScopedLock lock(this->_lock);
+
+		while(!this->_done) {
+			if(!this->_event.wait(lock, tmo))
+				return this->_done;
+		}
+
+		return true;
+	}
+
+	void Coroutine::sleep(int ms)
+	{
+		this->_stream = nullptr;
+		this->_deadline = lwiot_tick_ms() + ms;
+	}
+
+	void Coroutine::waitReadable(const Stream& stream, size_t bytes, int tmo)
+	{
+		this->_stream = &stream;
+		this->_bytes = bytes;
+		this->_timedout = false;
+		this->_deadline = tmo == FOREVER ? 0 : lwiot_tick_ms() + tmo;
+	}
+
+	bool Coroutine::poll()
+	{
+		if(this->_stream != nullptr) {
+			if(this->_stream->available() >= this->_bytes) {
+				this->_stream = nullptr;
+				return true;
+			}
+
+			if(this->_deadline == 0 || lwiot_tick_ms() < this->_deadline)
+				return false;
+
+			this->_stream = nullptr;
+			this->_timedout = true;
+			return true;
+		}
+
+		return lwiot_tick_ms() >= this->_deadline;
+	}
+
+	bool Coroutine::timedOut() const
+	{
+		return this->_timedout;
+	}
+
+	int Coroutine::delay(time_t now) const
+	{
+		if(this->_deadline == 0)
+			return CONFIG_COROUTINE_POLL_INTERVAL;
+
+		auto diff = this->_deadline > now ? this->_deadline - now : 0;
+
+		if(this->_stream != nullptr && diff > CONFIG_COROUTINE_POLL_INTERVAL)
+			return CONFIG_COROUTINE_POLL_INTERVAL;
+
+		return static_cast<int>(diff);
+	}
+
+	void Coroutine::resume()
+	{
+		auto state = this->run();
+		bool queued;
+
+		switch(state) {
+		case CoroutineState::Yielded:
+			queued = this->_executor->post([this]() { this->resume(); });
+			break;
+
+		case CoroutineState::Waiting:
+			queued = this->_executor->schedule(this->delay(lwiot_tick_ms()), [this]() { this->resume(); });
+			break;
+
+		default:
+			queued = false;
+			break;
+		}
+
+		if(queued)
+			return;
+
+		/* Finished, or the executor is stopping. */
+		ScopedLock lock(this->_lock);
+
+		this->_done = true;
+		this->_event.signal();
+	}
+
+#ifdef HAVE_COROUTINES
+	AsyncCoroutine::AsyncCoroutine(Async&& async) : Coroutine(), _async(stl::move(async))
+	{
+		if(this->_async.handle())
+			this->_async.handle().promise().owner = this;
+	}
+
+	CoroutineState AsyncCoroutine::run()
+	{
+		auto handle = this->_async.handle();
+
+		if(!handle || handle.done())
+			return CoroutineState::Done;
+
+		auto& promise = handle.promise();
+
+		if(promise.state == CoroutineState::Waiting && !this->poll())
+			return CoroutineState::Waiting;
+
+		promise.state = CoroutineState::Yielded;
+		handle.resume();
+
+		return handle.done() ? CoroutineState::Done : promise.state;
+	}
+#endif
+}
@@ -0,0 +1,106 @@
+/*
+ * Calibrated busy-wait delays.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+
+#ifndef CONFIG_DELAY_CALIBRATION_MS
+#define CONFIG_DELAY_CALIBRATION_MS 10
+#endif
+
+#define OVERHEAD_SAMPLES 16
+
+/* Counter ticks per millisecond and the number of ticks taken by the delay call itself. */
+static uint64_t cycles_per_ms;
+static uint64_t overhead;
+
+uint64_t RAM_ATTR lwiot_delay_counter(void)
+{
+#if defined(HAVE_CYCLE_COUNTER)
+	return lwiot_cycles();
+#elif defined(HAVE_TICK_NS)
+	return lwiot_tick_ns();
+#else
+	return (uint64_t) lwiot_tick() * 1000ULL;
+#endif
+}
+
+static uint64_t delay_measure_rate(void)
+{
+#ifdef HAVE_CYCLE_COUNTER
+	uint64_t start, end;
+	time_t begin, now;
+
+	begin = lwiot_tick();
+
+	/* Start on a tick edge, so that the tick resolution does not skew the result. */
+	while((now = lwiot_tick()) == begin);
+
+	start = lwiot_delay_counter();
+	begin = now;
+
+	while((now = lwiot_tick()) - begin < CONFIG_DELAY_CALIBRATION_MS * 1000);
+
+	end = lwiot_delay_counter();
+	return (end - start) * 1000ULL / (uint64_t) (now - begin);
+#else
+	/* The fallback counters count nanoseconds. */
+	return 1000000ULL;
+#endif
+}
+
+void lwiot_delay_calibrate(void)
+{
+	uint64_t start, elapsed, best;
+	int idx;
+
+	cycles_per_ms = delay_measure_rate();
+	overhead = 0;
+	best = UINT64_MAX;
+
+	for(idx = 0; idx < OVERHEAD_SAMPLES; idx++) {
+		start = lwiot_delay_counter();
+		lwiot_ndelay(0);
+		elapsed = lwiot_delay_counter() - start;
+
+		if(elapsed < best)
+			best = elapsed;
+	}
+
+	overhead = best;
+	print_dbg("Delay calibrated: %llu cycles/ms, %llu cycles overhead\n",
+		(unsigned long long) cycles_per_ms, (unsigned long long) overhead);
+}
+
+uint64_t RAM_ATTR lwiot_delay_ns_to_cycles(uint32_t ns)
+{
+	if(unlikely(cycles_per_ms == 0))
+		lwiot_delay_calibrate();
+
+	return (uint64_t) ns * cycles_per_ms / 1000000ULL;
+}
+
+void RAM_ATTR lwiot_delay_until(uint64_t deadline)
+{
+	while((int64_t) (deadline - lwiot_delay_counter()) > 0);
+}
+
+void RAM_ATTR lwiot_ndelay(uint32_t ns)
+{
+	uint64_t start, cycles;
+
+	start = lwiot_delay_counter();
+	cycles = lwiot_delay_ns_to_cycles(ns);
+
+	if(cycles <= overhead)
+		return;
+
+	lwiot_delay_until(start + cycles - overhead);
+}
@@ -6,101 +6,349 @@
  */
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <lwiot.h>
 
 #include <lwiot/kernel/event.h>
+#include <lwiot/kernel/idlemanager.h>
 #include <lwiot/log.h>
 #include <lwiot/error.h>
 
 namespace lwiot {
-	Event::Event(int length) : _event(nullptr), _waiters(0)
+	/*
+	 * A waiter that waits for several events has a node queued on each of them, all sharing a
+	 * single fired slot. Signalers claim the waiter by setting that slot, so only one of them
+	 * wakes it. Under an RTOS the claim happens inside the critical section that guards the
+	 * event state; hosted ports guard event state with a per-event lock, so claims on multi
+	 * waiters take a global lock as well.
+	 */
+	static bool claim(int* fired, int index, bool multi)
 	{
-		this->_event = lwiot_event_create(length);
+		if(!multi) {
+			*fired = index;
+			return true;
+		}
+
+#ifndef HAVE_RTOS
+		static Lock lock(false);
+		ScopedLock g(lock);
+#endif
+
+		if(*fired >= 0)
+			return false;
+
+		*fired = index;
+		return true;
+	}
+
+	Event::Event(int length) : Event(EventType::Binary)
+	{
+		UNUSED(length);
+	}
+
+	Event::Event(EventType type, int max) : _lock(false), _head(nullptr), _tail(nullptr), _sequence(0),
+		_type(type), _count(0), _max(max)
+	{
+		if(this->_max < 1)
+			this->_max = 1;
 	}
 
-	Event::Event(lwiot::Event &&event) noexcept : _event(nullptr), _waiters(0), _lock(stl::move(event._lock))
+	Event::Event(lwiot::Event &&event) noexcept : _lock(stl::move(event._lock)), _parkers(stl::move(event._parkers)),
+		_head(nullptr), _tail(nullptr), _sequence(0), _type(event._type), _count(event._count), _max(event._max)
 	{
-		this->_event = event._event;
-		event._event = nullptr;
+		assert(event._head == nullptr);
+		event._count = 0;
 	}
 
 	Event::~Event()
 	{
-		if(this->_event == nullptr)
-			return;
+		assert(this->_head == nullptr);
+
+		for(auto parker : this->_parkers)
+			lwiot_event_destroy(parker);
 
-		lwiot_event_destroy(this->_event);
-		this->_event = nullptr;
+		this->_parkers.clear();
 	}
 
 	Event& Event::operator=(lwiot::Event &&rhs) noexcept
 	{
-		this->_event = rhs._event;
-		rhs._event = nullptr;
-		this->_waiters = rhs._waiters;
+		assert(this->_head == nullptr && rhs._head == nullptr);
+
+		for(auto parker : this->_parkers)
+			lwiot_event_destroy(parker);
+
 		this->_lock = stl::move(rhs._lock);
+		this->_parkers = stl::move(rhs._parkers);
+		this->_type = rhs._type;
+		this->_count = rhs._count;
+		this->_max = rhs._max;
+		rhs._count = 0;
 
 		return *this;
 	}
 
-	const lwiot_event_t* Event::getEvent() const
+	void Event::lockState() const
 	{
-		return this->_event;
+#ifdef HAVE_RTOS
+		enter_critical();
+#else
+		this->_lock.lock();
+#endif
 	}
 
-	void Event::wait()
+	void Event::unlockState() const
 	{
-		this->wait(FOREVER);
+#ifdef HAVE_RTOS
+		exit_critical();
+#else
+		this->_lock.unlock();
+#endif
 	}
 
-	bool Event::wait(int tmo)
+	lwiot_event_t* Event::takeParker()
 	{
-		if(!this->_event)
-			return false;
+		lwiot_event_t* parker = nullptr;
 
 		this->_lock.lock();
-		++this->_waiters;
-		this->_lock.unlock();
 
-		auto result = lwiot_event_wait(this->_event, tmo) == -EOK;
+		if(this->_parkers.size() > 0) {
+			parker = this->_parkers.back();
+			this->_parkers.popback();
+		}
 
-		this->_lock.lock();
-		--this->_waiters;
 		this->_lock.unlock();
 
-		return result;
+		if(parker == nullptr)
+			parker = lwiot_event_create(1);
+
+		return parker;
+	}
+
+	void Event::releaseParker(lwiot_event_t *parker)
+	{
+		ScopedLock g(this->_lock);
+		this->_parkers.push_back(parker);
+	}
+
+	bool Event::enqueue(WaitNode &node, int *fired, int index, lwiot_event_t *parker)
+	{
+		node.next = node.prev = nullptr;
+		node.fired = fired;
+		node.index = index;
+		node.multi = parker != nullptr;
+		node.parker = parker ? parker : this->takeParker();
+
+		this->lockState();
+
+		if(this->_count > 0 && claim(fired, index, node.multi)) {
+			this->_count--;
+			node.queued = false;
+			this->unlockState();
+
+			if(!node.multi)
+				this->releaseParker(node.parker);
+
+			return true;
+		}
+
+		node.sequence = this->_sequence++;
+		node.queued = true;
+		node.prev = this->_tail;
+
+		if(this->_tail)
+			this->_tail->next = &node;
+		else
+			this->_head = &node;
+
+		this->_tail = &node;
+		this->unlockState();
+
+		return false;
+	}
+
+	void Event::unlink(WaitNode &node)
+	{
+		if(node.prev)
+			node.prev->next = node.next;
+		else
+			this->_head = node.next;
+
+		if(node.next)
+			node.next->prev = node.prev;
+		else
+			this->_tail = node.prev;
+
+		node.next = node.prev = nullptr;
+		node.queued = false;
+	}
+
+	/*
+	 * Dequeue waiters until one of them is claimed. Must be called with the state guard
+	 * held. Without a sequence limit, a signal that finds no waiter is stored as a token
+	 * on counting events.
+	 */
+	lwiot_event_t* Event::wake(const uint32_t* limit)
+	{
+		while(this->_head != nullptr) {
+			auto node = this->_head;
+
+			if(limit && static_cast<int32_t>(node->sequence - *limit) >= 0)
+				return nullptr;
+
+			this->unlink(*node);
+
+			if(claim(node->fired, node->index, node->multi))
+				return node->parker;
+		}
+
+		if(limit == nullptr && this->_type == EventType::Counting && this->_count < this->_max)
+			this->_count++;
+
+		return nullptr;
+	}
+
+	bool Event::park(WaitNode &node, int tmo)
+	{
+		auto parker = node.parker;
+		IdleManager::Deadline deadline(tmo != FOREVER ? lwiot_tick() + static_cast<time_t>(tmo) * 1000 : 0);
+		auto rv = lwiot_event_wait(parker, tmo) == -EOK;
+
+		if(!rv) {
+			this->lockState();
+
+			if(node.queued) {
+				this->unlink(node);
+				this->unlockState();
+				this->releaseParker(parker);
+				return false;
+			}
+
+			/* Claimed just after the timeout expired; consume the signal that is on its way. */
+			this->unlockState();
+			lwiot_event_wait(parker, FOREVER);
+		}
+
+		this->releaseParker(parker);
+		return true;
+	}
+
+	void Event::wait()
+	{
+		this->wait(FOREVER);
+	}
+
+	bool Event::wait(int tmo)
+	{
+		WaitNode node;
+		int fired = -1;
+
+		if(this->enqueue(node, &fired, 0, nullptr))
+			return true;
+
+		return this->park(node, tmo);
 	}
 
 	bool Event::wait(lwiot::ScopedLock &guard, int tmo)
 	{
+		WaitNode node;
+		int fired = -1;
+
+		/*
+		 * Queue up before the guard is dropped. Otherwise a signal sent between
+		 * unlocking the guard and waiting on the event would be discarded.
+		 */
+		if(this->enqueue(node, &fired, 0, nullptr))
+			return true;
+
 		guard.unlock();
-		auto rv = this->wait(tmo);
+		auto rv = this->park(node, tmo);
 		guard.lock();
 
 		return rv;
 	}
 
+	int Event::waitAny(Event* events[], size_t num, int tmo)
+	{
+		WaitNode nodes[CONFIG_EVENT_WAIT_MAX];
+		int fired = -1;
+		size_t idx;
+		bool woken = false;
+
+		if(num == 0 || num > CONFIG_EVENT_WAIT_MAX)
+			return -EINVALID;
+
+		auto parker = events[0]->takeParker();
+
+		for(idx = 0; idx < num; idx++) {
+			if(events[idx]->enqueue(nodes[idx], &fired, static_cast<int>(idx), parker)) {
+				woken = true;
+				idx++;
+				break;
+			}
+		}
+
+		if(!woken) {
+			IdleManager::Deadline deadline(tmo != FOREVER ? lwiot_tick() + static_cast<time_t>(tmo) * 1000 : 0);
+			woken = lwiot_event_wait(parker, tmo) == -EOK;
+		}
+
+		/* After this no signaler can claim the waiter anymore. */
+		for(size_t registered = 0; registered < idx; registered++) {
+			auto event = events[registered];
+
+			event->lockState();
+
+			if(nodes[registered].queued)
+				event->unlink(nodes[registered]);
+
+			event->unlockState();
+		}
+
+		if(!woken && fired >= 0)
+			lwiot_event_wait(parker, FOREVER);
+
+		events[0]->releaseParker(parker);
+		return fired >= 0 ? fired : -ETMO;
+	}
+
 	void Event::signal()
 	{
-		if(!this->_event)
-			return;
+		this->lockState();
+		auto parker = this->wake(nullptr);
+		this->unlockState();
 
-		ScopedLock g(this->_lock);
-		if(this->_waiters == 0)
-			return;
+		if(parker)
+			lwiot_event_signal(parker);
+	}
 
-		g.unlock();
-		lwiot_event_signal(this->_event);
+	void Event::broadcast()
+	{
+		uint32_t limit;
+		lwiot_event_t* parker;
+
+		this->lockState();
+		limit = this->_sequence;
+
+		while((parker = this->wake(&limit)) != nullptr) {
+			this->unlockState();
+			lwiot_event_signal(parker);
+			this->lockState();
+		}
+
+		this->unlockState();
 	}
 
 	void Event::signalFromIrq()
 	{
-		if(!this->_event)
-			return;
-
-		if(this->_waiters == 0)
-			return;
+#ifdef HAVE_RTOS
+		this->lockState();
+		auto parker = this->wake(nullptr);
+		this->unlockState();
 
-		lwiot_event_signal_irq(this->_event);
+		if(parker)
+			lwiot_event_signal_irq(parker);
+#else
+		this->signal();
+#endif
 	}
 }
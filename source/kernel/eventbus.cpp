@@ -0,0 +1,137 @@
+/*
+ * Typed publish/subscribe event bus.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/kernel/eventbus.h>
+#include <lwiot/kernel/thread.h>
+
+namespace lwiot
+{
+	EventBus::EventBus() : _lock(false), _channels(nullptr), _epoch(0), _readers()
+	{
+	}
+
+	EventBus::~EventBus()
+	{
+		auto channel = this->_channels.load();
+
+		while(channel != nullptr) {
+			auto next = channel->next;
+
+			delete channel;
+			channel = next;
+		}
+	}
+
+	EventBus::Channel *EventBus::find(const void *topic) const
+	{
+		for(auto channel = this->_channels.load(); channel != nullptr; channel = channel->next) {
+			if(channel->topic == topic)
+				return channel;
+		}
+
+		return nullptr;
+	}
+
+	bool EventBus::attach(const void *topic, detail::EventSubscriber *subscriber)
+	{
+		ScopedLock lock(this->_lock);
+		auto channel = this->find(topic);
+
+		/* Channels are only added at the head and never removed, so publishers can walk the list. */
+		if(channel == nullptr) {
+			channel = new Channel(topic);
+			channel->next = this->_channels.load();
+			this->_channels.store(channel);
+		}
+
+		for(auto& slot : channel->slots) {
+			detail::EventSubscriber *expected = nullptr;
+
+			if(slot.compare_exchange_strong(expected, subscriber))
+				return true;
+		}
+
+		return false;
+	}
+
+	void EventBus::detach(const void *topic, detail::EventSubscriber *subscriber)
+	{
+		ScopedLock lock(this->_lock);
+		auto channel = this->find(topic);
+
+		if(channel == nullptr)
+			return;
+
+		for(auto& slot : channel->slots) {
+			auto expected = subscriber;
+
+			if(slot.compare_exchange_strong(expected, nullptr))
+				break;
+		}
+
+		this->synchronize();
+	}
+
+	/*
+	 * Wait for the publishers that may have seen a slot before it was cleared. Publishers count
+	 * themselves in the reader counter of the current epoch. Flipping the epoch sends new
+	 * publishers to the other counter, so the old one drains; doing it twice covers publishers
+	 * that read the epoch just before a flip.
+	 */
+	void EventBus::synchronize()
+	{
+		for(int phase = 0; phase < 2; phase++) {
+			auto old = this->_epoch.fetch_add(1) & 1;
+
+			while(this->_readers[old].load() != 0)
+				Thread::yield();
+		}
+	}
+
+	size_t EventBus::dispatch(const void *topic, const void *message)
+	{
+		size_t delivered = 0;
+		auto channel = this->find(topic);
+
+		if(channel == nullptr)
+			return 0;
+
+		auto epoch = this->_epoch.load() & 1;
+		this->_readers[epoch].fetch_add(1);
+
+		for(auto& slot : channel->slots) {
+			auto subscriber = slot.load();
+
+			if(subscriber != nullptr && subscriber->deliver(message))
+				delivered++;
+		}
+
+		this->_readers[epoch].fetch_sub(1);
+		return delivered;
+	}
+
+	size_t EventBus::count(const void *topic) const
+	{
+		size_t num = 0;
+		auto channel = this->find(topic);
+
+		if(channel == nullptr)
+			return 0;
+
+		for(auto& slot : channel->slots) {
+			if(slot.load() != nullptr)
+				num++;
+		}
+
+		return num;
+	}
+}
@@ -0,0 +1,499 @@
+/*
+ * Task executor backed by a fixed pool of worker threads.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/scopedlock.h>
+
+#include <lwiot/kernel/executor.h>
+#include <lwiot/kernel/thread.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/stl/move.h>
+
+#ifdef CONFIG_WORK_STEALING
+/* Number of local tasks after which a worker looks at the central queue. */
+#define EXECUTOR_SHARED_INTERVAL 32
+/* Maximum number of tasks moved from the central queue to a worker deque at once. */
+#define EXECUTOR_BATCH_SIZE 16
+#endif
+
+namespace lwiot
+{
+#ifdef CONFIG_WORK_STEALING
+	thread_local Executor::Worker* Executor::_current = nullptr;
+#endif
+
+	/*
+	 * Both task queues are binary heaps. Ready tasks are ordered on priority, delayed tasks on
+	 * their due time. Ties are broken using the sequence number, which keeps the order stable.
+	 */
+	template <typename T>
+	static inline bool ready_before(const T* a, const T* b)
+	{
+		if(a->priority != b->priority)
+			return a->priority > b->priority;
+
+		return static_cast<int32_t>(a->sequence - b->sequence) < 0;
+	}
+
+	template <typename T>
+	static inline bool due_before(const T* a, const T* b)
+	{
+		if(a->due != b->due)
+			return a->due < b->due;
+
+		return static_cast<int32_t>(a->sequence - b->sequence) < 0;
+	}
+
+	template <typename T, typename Compare>
+	static void heap_push(stl::Vector<T*>& heap, T* entry, Compare before)
+	{
+		size_t idx = heap.size();
+
+		heap.push_back(entry);
+
+		while(idx > 0) {
+			auto parent = (idx - 1) / 2;
+
+			if(!before(heap[idx], heap[parent]))
+				break;
+
+			stl::swap(heap[idx], heap[parent]);
+			idx = parent;
+		}
+	}
+
+	template <typename T, typename Compare>
+	static T* heap_pop(stl::Vector<T*>& heap, Compare before)
+	{
+		auto top = heap[0];
+		size_t idx = 0;
+
+		heap[0] = heap.back();
+		heap.popback();
+
+		while(true) {
+			auto child = idx * 2 + 1;
+			auto first = idx;
+
+			if(child < heap.size() && before(heap[child], heap[first]))
+				first = child;
+
+			if(child + 1 < heap.size() && before(heap[child + 1], heap[first]))
+				first = child + 1;
+
+			if(first == idx)
+				break;
+
+			stl::swap(heap[idx], heap[first]);
+			idx = first;
+		}
+
+		return top;
+	}
+
+	Executor::Worker::Worker(const String& name, Executor& executor) : Thread(name), _executor(executor)
+	{
+	}
+
+	Executor::Worker::Worker(const String& name, int priority, size_t stacksize, Executor& executor) :
+		Thread(name, priority, stacksize), _executor(executor)
+	{
+	}
+
+	void Executor::Worker::run()
+	{
+		this->_executor.work(*this);
+
+		/*
+		 * Do not return before the executor stops this thread: Thread::stop() only destroys
+		 * threads that are still running.
+		 */
+		while(this->isRunning())
+			Thread::sleep(1);
+	}
+
+	Executor::Executor(const String& name, int workers) : Executor(name, workers, -1, 0)
+	{
+	}
+
+	Executor::Executor(const String& name, int workers, int priority, size_t stacksize) :
+		_lock(false), _event(), _running(false), _sequence(0)
+#ifdef CONFIG_WORK_STEALING
+		, _idle(0)
+#endif
+	{
+		if(workers < 1)
+			workers = 1;
+
+		for(int idx = 0; idx < workers; idx++) {
+			String wname(name);
+
+			wname += "-";
+			wname += String(idx);
+
+			if(priority >= 0 && stacksize > 0)
+				this->_workers.push_back(new Worker(wname, priority, stacksize, *this));
+			else
+				this->_workers.push_back(new Worker(wname, *this));
+		}
+	}
+
+	Executor::~Executor()
+	{
+		this->stop();
+
+		for(auto worker : this->_workers)
+			delete worker;
+
+		this->_workers.clear();
+	}
+
+	void Executor::start()
+	{
+		ScopedLock lock(this->_lock);
+
+		if(this->_running)
+			return;
+
+		this->_running = true;
+		lock.unlock();
+
+		for(auto worker : this->_workers)
+			worker->start();
+	}
+
+	void Executor::stop()
+	{
+		ScopedLock lock(this->_lock);
+
+		if(!this->_running)
+			return;
+
+		this->_running = false;
+		lock.unlock();
+
+		/* Exiting workers pass the signal on to the next one. */
+		this->_event.signal();
+
+		for(auto worker : this->_workers)
+			worker->stop();
+
+		lock.lock();
+		this->clear();
+	}
+
+	bool Executor::post(const Task& task, int priority)
+	{
+		return this->enqueue(task, 0, priority);
+	}
+
+	bool Executor::schedule(int ms, const Task& task, int priority)
+	{
+		if(ms <= 0)
+			return this->post(task, priority);
+
+		return this->enqueue(task, lwiot_tick_ms() + ms, priority);
+	}
+
+	size_t Executor::pending() const
+	{
+		ScopedLock lock(this->_lock);
+		auto pending = this->_ready.size() + this->_delayed.size();
+
+#ifdef CONFIG_WORK_STEALING
+		for(auto worker : this->_workers)
+			pending += worker->deque.size();
+#endif
+
+		return pending;
+	}
+
+	bool Executor::running() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_running;
+	}
+
+	bool Executor::enqueue(const Task& task, time_t due, int priority)
+	{
+		if(!task)
+			return false;
+
+#ifdef CONFIG_WORK_STEALING
+		if(due == 0 && priority == 0 && _current != nullptr && _current->ownedBy(this)) {
+			auto entry = new Entry;
+
+			entry->task = task;
+			entry->due = 0;
+			entry->priority = 0;
+			entry->sequence = 0;
+
+			if(this->pushLocal(entry))
+				return true;
+
+			delete entry;
+		}
+#endif
+
+		ScopedLock lock(this->_lock);
+
+		if(!this->_running)
+			return false;
+
+		auto entry = new Entry;
+
+		entry->task = task;
+		entry->due = due;
+		entry->priority = priority;
+		entry->sequence = this->_sequence++;
+
+		if(due == 0) {
+			heap_push(this->_ready, entry, ready_before<Entry>);
+		} else {
+			auto first = this->_delayed.size() == 0 || due_before(entry, this->_delayed[0]);
+
+			heap_push(this->_delayed, entry, due_before<Entry>);
+
+			/* Idle workers only have to wake up if the first deadline moved forward. */
+			if(!first)
+				return true;
+		}
+
+		lock.unlock();
+		this->_event.signal();
+
+		return true;
+	}
+
+	void Executor::promote(time_t now)
+	{
+		while(this->_delayed.size() > 0 && this->_delayed[0]->due <= now) {
+			auto entry = heap_pop(this->_delayed, due_before<Entry>);
+			heap_push(this->_ready, entry, ready_before<Entry>);
+		}
+	}
+
+	int Executor::timeout(time_t now) const
+	{
+		if(this->_delayed.size() == 0)
+			return FOREVER;
+
+		auto diff = this->_delayed[0]->due - now;
+
+		/* A timeout of 0 would mean forever. */
+		return diff < 1 ? 1 : static_cast<int>(diff);
+	}
+
+#ifdef CONFIG_WORK_STEALING
+	bool Executor::pushLocal(Entry* entry)
+	{
+		if(!_current->deque.push(entry))
+			return false;
+
+		this->wakeIdle();
+		return true;
+	}
+
+	void Executor::wakeIdle()
+	{
+		/*
+		 * Idle workers increment the idle count, and check for work, while holding the lock. When
+		 * the count is non-zero, taking the lock guarantees the worker either found the new work
+		 * or is waiting for the signal.
+		 */
+		if(this->_idle.load() == 0)
+			return;
+
+		ScopedLock lock(this->_lock);
+		this->_event.signal();
+	}
+
+	Executor::Entry* Executor::acquire(Worker& worker, time_t now)
+	{
+		Entry* batch[EXECUTOR_BATCH_SIZE];
+		size_t num;
+
+		this->promote(now);
+
+		if(this->_ready.size() == 0)
+			return nullptr;
+
+		auto entry = heap_pop(this->_ready, ready_before<Entry>);
+
+		/* Take a fair share of the central queue, leaving the rest to the other workers. */
+		num = this->_ready.size() / this->_workers.size();
+
+		if(num == 0 && this->_ready.size() > 0)
+			num = 1;
+
+		if(num > EXECUTOR_BATCH_SIZE)
+			num = EXECUTOR_BATCH_SIZE;
+
+		for(size_t idx = 0; idx < num; idx++)
+			batch[idx] = heap_pop(this->_ready, ready_before<Entry>);
+
+		/* The owner pops from the bottom: push in reverse to keep the queue order. */
+		while(num > 0) {
+			auto next = batch[--num];
+
+			if(!worker.deque.push(next))
+				heap_push(this->_ready, next, ready_before<Entry>);
+		}
+
+		if(this->_idle.load() > 0 && (worker.deque.size() > 0 || this->_ready.size() > 0))
+			this->_event.signal();
+
+		return entry;
+	}
+
+	Executor::Entry* Executor::steal(const Worker& worker)
+	{
+		for(auto victim : this->_workers) {
+			if(victim == &worker)
+				continue;
+
+			auto entry = victim->deque.steal();
+
+			if(entry != nullptr)
+				return entry;
+		}
+
+		return nullptr;
+	}
+
+	bool Executor::stealable() const
+	{
+		for(auto worker : this->_workers) {
+			if(worker->deque.size() > 0)
+				return true;
+		}
+
+		return false;
+	}
+
+	void Executor::work(Worker& worker)
+	{
+		ScopedLock lock(this->_lock);
+		uint32_t count = 0;
+
+		_current = &worker;
+		lock.unlock();
+
+		while(true) {
+			Entry* entry = nullptr;
+
+			/* Local work first, but make sure the central queue does not starve. */
+			if(++count % EXECUTOR_SHARED_INTERVAL != 0)
+				entry = worker.deque.pop();
+
+			if(entry == nullptr) {
+				lock.lock();
+
+				if(!this->_running)
+					break;
+
+				entry = this->acquire(worker, lwiot_tick_ms());
+				lock.unlock();
+			}
+
+			if(entry == nullptr)
+				entry = worker.deque.pop();
+
+			if(entry == nullptr)
+				entry = this->steal(worker);
+
+			if(entry == nullptr) {
+				lock.lock();
+
+				if(!this->_running)
+					break;
+
+				this->_idle.fetch_add(1);
+
+				auto now = lwiot_tick_ms();
+				this->promote(now);
+
+				if(this->_ready.size() == 0 && !this->stealable())
+					this->_event.wait(lock, this->timeout(now));
+
+				this->_idle.fetch_sub(1);
+				lock.unlock();
+				continue;
+			}
+
+			entry->task();
+			delete entry;
+		}
+
+		_current = nullptr;
+		lock.unlock();
+		this->_event.signal();
+	}
+#else
+	void Executor::work(Worker& worker)
+	{
+		ScopedLock lock(this->_lock);
+
+		UNUSED(worker);
+
+		while(this->_running) {
+			auto now = lwiot_tick_ms();
+
+			this->promote(now);
+
+			if(this->_ready.size() == 0) {
+				this->_event.wait(lock, this->timeout(now));
+				continue;
+			}
+
+			auto entry = heap_pop(this->_ready, ready_before<Entry>);
+			auto more = this->_ready.size() > 0;
+
+			lock.unlock();
+
+			/* Wake up another worker for the remaining tasks. */
+			if(more)
+				this->_event.signal();
+
+			entry->task();
+			delete entry;
+
+			lock.lock();
+		}
+
+		lock.unlock();
+		this->_event.signal();
+	}
+#endif
+
+	void Executor::clear()
+	{
+		for(auto entry : this->_ready)
+			delete entry;
+
+		for(auto entry : this->_delayed)
+			delete entry;
+
+		this->_ready.clear();
+		this->_delayed.clear();
+
+#ifdef CONFIG_WORK_STEALING
+		/* The workers have stopped, so popping their deques is safe. */
+		for(auto worker : this->_workers) {
+			Entry* entry;
+
+			while((entry = worker->deque.pop()) != nullptr)
+				delete entry;
+		}
+#endif
+	}
+}
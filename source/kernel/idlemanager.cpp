@@ -0,0 +1,256 @@
+/*
+ * Power-aware idle management.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/idlemanager.h>
+
+namespace lwiot
+{
+	/*
+	 * Ports with a tickless idle call in from the idle task, where blocking on a mutex is not
+	 * allowed. Under an RTOS the state is therefore guarded by a critical section, like the
+	 * event state; walking the deadlines is short.
+	 */
+	static IdleManager::Deadline *deadlines;
+	static int wakelocks;
+
+	static time_t started;
+	static time_t wake;
+	static size_t late;
+	static time_t latency;
+	static time_t asleep;
+	static IdleStatistics stats;
+
+#ifndef HAVE_RTOS
+	/* Intentionally never freed: deadlines with static storage may outlive static destructors. */
+	static Lock& guard()
+	{
+		static auto instance = new Lock(false);
+		return *instance;
+	}
+#endif
+
+	static void lockState()
+	{
+#ifdef HAVE_RTOS
+		enter_critical();
+#else
+		guard().lock();
+#endif
+	}
+
+	static void unlockState()
+	{
+#ifdef HAVE_RTOS
+		exit_critical();
+#else
+		guard().unlock();
+#endif
+	}
+
+	IdleManager::Deadline::Deadline(time_t expiry) : _next(nullptr), _prev(nullptr), _expiry(0)
+	{
+		if(expiry != 0)
+			this->set(expiry);
+	}
+
+	IdleManager::Deadline::~Deadline()
+	{
+		this->clear();
+	}
+
+	void IdleManager::Deadline::set(time_t expiry)
+	{
+		lockState();
+
+		if(this->_expiry == 0 && expiry != 0) {
+			this->_prev = nullptr;
+			this->_next = deadlines;
+
+			if(deadlines)
+				deadlines->_prev = this;
+
+			deadlines = this;
+		} else if(this->_expiry != 0 && expiry == 0) {
+			if(this->_prev)
+				this->_prev->_next = this->_next;
+			else
+				deadlines = this->_next;
+
+			if(this->_next)
+				this->_next->_prev = this->_prev;
+
+			this->_next = this->_prev = nullptr;
+		}
+
+		this->_expiry = expiry;
+		unlockState();
+	}
+
+	void IdleManager::Deadline::clear()
+	{
+		if(this->_expiry != 0)
+			this->set(0);
+	}
+
+	time_t IdleManager::Deadline::expiry() const
+	{
+		return this->_expiry;
+	}
+
+	IdleManager::WakeLock::WakeLock()
+	{
+		lockState();
+		wakelocks++;
+		unlockState();
+	}
+
+	IdleManager::WakeLock::~WakeLock()
+	{
+		lockState();
+		wakelocks--;
+		unlockState();
+	}
+
+	time_t IdleManager::next()
+	{
+		time_t rv = 0;
+
+		lockState();
+
+		for(auto deadline = deadlines; deadline != nullptr; deadline = deadline->_next) {
+			if(rv == 0 || deadline->_expiry < rv)
+				rv = deadline->_expiry;
+		}
+
+		unlockState();
+
+#ifdef HAVE_TIMER_EXPIRY
+		auto timer = lwiot_timers_next_expiry();
+
+		if(timer != 0 && (rv == 0 || timer < rv))
+			rv = timer;
+#endif
+
+		return rv;
+	}
+
+	int IdleManager::enter(int ms)
+	{
+		auto deadline = IdleManager::next();
+		auto now = lwiot_tick();
+		auto budget = ms == FOREVER || ms > CONFIG_IDLE_MAX_SLEEP ? CONFIG_IDLE_MAX_SLEEP : ms;
+
+		/* Round down: waking up early only results in another idle period. */
+		if(deadline != 0) {
+			auto until = deadline > now ? static_cast<int64_t>((deadline - now) / 1000) : 0;
+
+			if(until < budget)
+				budget = static_cast<int>(until);
+		}
+
+		lockState();
+
+		if(wakelocks > 0 || budget < CONFIG_IDLE_MIN_SLEEP) {
+			stats.skipped++;
+			unlockState();
+			return 0;
+		}
+
+		stats.sleeps++;
+		started = now;
+		wake = now + static_cast<time_t>(budget) * 1000;
+		unlockState();
+
+		return budget;
+	}
+
+	void IdleManager::exit()
+	{
+		auto now = lwiot_tick();
+
+		lockState();
+
+		if(started == 0) {
+			unlockState();
+			return;
+		}
+
+		asleep += now - started;
+
+		if(now < wake) {
+			stats.early++;
+		} else {
+			auto delay = now - wake;
+
+			late++;
+			latency += delay;
+
+			if(delay > stats.worst)
+				stats.worst = delay;
+		}
+
+		started = 0;
+		unlockState();
+	}
+
+	bool IdleManager::idle(int tmo)
+	{
+		auto ms = IdleManager::enter(tmo);
+
+		if(ms == 0)
+			return false;
+
+#ifdef HAVE_LIGHT_SLEEP
+		lwiot_light_sleep(ms);
+#else
+		lwiot_sleep(ms);
+#endif
+
+		IdleManager::exit();
+		return true;
+	}
+
+	IdleStatistics IdleManager::statistics()
+	{
+		lockState();
+
+		auto rv = stats;
+		rv.asleep = asleep / 1000;
+		rv.latency = late > 0 ? latency / late : 0;
+
+		unlockState();
+		return rv;
+	}
+
+	void IdleManager::reset()
+	{
+		lockState();
+
+		memset(&stats, 0, sizeof(stats));
+		late = 0;
+		latency = 0;
+		asleep = 0;
+
+		unlockState();
+	}
+}
+
+int lwiot_idle_enter(int ms)
+{
+	return lwiot::IdleManager::enter(ms);
+}
+
+void lwiot_idle_exit(void)
+{
+	lwiot::IdleManager::exit();
+}
@@ -14,7 +14,7 @@
 #include <lwiot/error.h>
 
 namespace lwiot {
-	Lock::Lock(bool recursive) : _mtx(new LockValue(recursive))
+	Lock::Lock(bool recursive, bool inherit) : _mtx(new LockValue(recursive, inherit))
 	{
 	}
 
@@ -0,0 +1,178 @@
+/*
+ * Reader-writer lock implementation.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#include <lwiot/scopedlock.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/sharedlock.h>
+
+namespace lwiot
+{
+#if defined(HAVE_RWLOCK)
+	SharedLock::SharedLock() : _rwlock(lwiot_rwlock_create())
+	{
+	}
+
+	SharedLock::~SharedLock()
+	{
+		lwiot_rwlock_destroy(this->_rwlock);
+	}
+
+	void SharedLock::lock()
+	{
+		lwiot_rwlock_write_lock(this->_rwlock);
+	}
+
+	bool SharedLock::try_lock()
+	{
+		return lwiot_rwlock_write_trylock(this->_rwlock);
+	}
+
+	void SharedLock::unlock()
+	{
+		lwiot_rwlock_write_unlock(this->_rwlock);
+	}
+
+	void SharedLock::lock_shared()
+	{
+		lwiot_rwlock_read_lock(this->_rwlock);
+	}
+
+	bool SharedLock::try_lock_shared()
+	{
+		return lwiot_rwlock_read_trylock(this->_rwlock);
+	}
+
+	void SharedLock::unlock_shared()
+	{
+		lwiot_rwlock_read_unlock(this->_rwlock);
+	}
+#elif defined(CONFIG_STANDALONE)
+	SharedLock::SharedLock() : _lock(false)
+	{
+	}
+
+	SharedLock::~SharedLock() = default;
+
+	void SharedLock::lock()
+	{
+		this->_lock.lock();
+	}
+
+	bool SharedLock::try_lock()
+	{
+		return this->_lock.try_lock();
+	}
+
+	void SharedLock::unlock()
+	{
+		this->_lock.unlock();
+	}
+
+	void SharedLock::lock_shared()
+	{
+		this->_lock.lock();
+	}
+
+	bool SharedLock::try_lock_shared()
+	{
+		return this->_lock.try_lock();
+	}
+
+	void SharedLock::unlock_shared()
+	{
+		this->_lock.unlock();
+	}
+#else
+	/*
+	 * Readers and writers wait on separate events. Releasing the lock wakes a writer if one is
+	 * waiting, otherwise a reader. Readers that get in wake the next waiting reader, so all of
+	 * them are let in.
+	 */
+	SharedLock::SharedLock() : _lock(false), _active(0), _waiting_readers(0), _waiting_writers(0),
+		_writer(false)
+	{
+	}
+
+	SharedLock::~SharedLock() = default;
+
+	void SharedLock::lock()
+	{
+		ScopedLock lock(this->_lock);
+
+		this->_waiting_writers++;
+
+		while(this->_writer || this->_active > 0)
+			this->_writers.wait(lock, FOREVER);
+
+		this->_waiting_writers--;
+		this->_writer = true;
+	}
+
+	bool SharedLock::try_lock()
+	{
+		ScopedLock lock(this->_lock);
+
+		if(this->_writer || this->_active > 0)
+			return false;
+
+		this->_writer = true;
+		return true;
+	}
+
+	void SharedLock::unlock()
+	{
+		ScopedLock lock(this->_lock);
+
+		this->_writer = false;
+
+		if(this->_waiting_writers > 0)
+			this->_writers.signal();
+		else if(this->_waiting_readers > 0)
+			this->_readers.signal();
+	}
+
+	void SharedLock::lock_shared()
+	{
+		ScopedLock lock(this->_lock);
+
+		this->_waiting_readers++;
+
+		while(this->_writer || this->_waiting_writers > 0)
+			this->_readers.wait(lock, FOREVER);
+
+		this->_waiting_readers--;
+		this->_active++;
+
+		if(this->_waiting_readers > 0)
+			this->_readers.signal();
+	}
+
+	bool SharedLock::try_lock_shared()
+	{
+		ScopedLock lock(this->_lock);
+
+		if(this->_writer || this->_waiting_writers > 0)
+			return false;
+
+		this->_active++;
+		return true;
+	}
+
+	void SharedLock::unlock_shared()
+	{
+		ScopedLock lock(this->_lock);
+
+		this->_active--;
+
+		if(this->_active == 0 && this->_waiting_writers > 0)
+			this->_writers.signal();
+	}
+#endif
+}
@@ -11,6 +11,7 @@
 
 #include <lwiot/lwiot.h>
 #include <lwiot/kernel/thread.h>
+#include <lwiot/kernel/threadregistry.h>
 #include <lwiot/log.h>
 
 #include <lwiot/stl/move.h>
@@ -27,27 +28,43 @@ namespace lwiot
 	{
 	}
 
-	Thread::Thread(const char *name, void *argument) : _internal(nullptr), _prio(-1), stacksize(0), _name(name)
+	Thread::Thread(const char *name, void *argument) : _internal(nullptr), _prio(-1), stacksize(0), _affinity(0),
+		_storage(nullptr), _stack(nullptr), _name(name)
 	{
 		this->_running = false;
 		this->_argument = argument;
 	}
 
 	Thread::Thread(const String& name, int priority, size_t stacksize, void* argument) :
-		_argument(nullptr), _running(false), _internal(nullptr), _prio(priority), stacksize(stacksize), _name(name)
+		_argument(nullptr), _running(false), _internal(nullptr), _prio(priority), stacksize(stacksize), _affinity(0),
+		_storage(nullptr), _stack(nullptr), _name(name)
 	{
 		this->_running = false;
 		this->_argument = argument;
 	}
 
+	Thread::Thread(const String& name, int priority, size_t stacksize, lwiot_thread_t* storage, void* stack,
+			void* argument) : _argument(argument), _running(false), _internal(nullptr), _prio(priority),
+		stacksize(stacksize), _affinity(0), _storage(storage), _stack(stack), _name(name)
+	{
+	}
+
 	Thread::Thread(const lwiot::String &name, void *argument) : Thread(name.c_str(), argument)
 	{
 	}
 
 	Thread::Thread(lwiot::Thread &&other) noexcept :
 		_argument(other._argument), _running(other._running), _internal(other._internal), _join(stl::move(other._join)),
-		_lock(stl::move(other._lock)), _prio(other._prio), stacksize(other.stacksize), _name(stl::move(other._name))
+		_lock(stl::move(other._lock)), _prio(other._prio), stacksize(other.stacksize),
+		_affinity(other._affinity), _storage(other._storage), _stack(other._stack), _name(stl::move(other._name))
 	{
+		other._internal = nullptr;
+		other._running = false;
+
+		ThreadRegistry::remove(&other);
+
+		if(this->_internal != nullptr)
+			ThreadRegistry::add(this);
 	}
 
 	Thread::~Thread()
@@ -58,6 +75,8 @@ namespace lwiot
 			g.unlock();
 			this->stop();
 		}
+
+		ThreadRegistry::remove(this);
 	}
 
 	Thread& Thread::operator=(lwiot::Thread &&rhs) noexcept
@@ -73,6 +92,15 @@ namespace lwiot
 
 		using stl::swap;
 		swap(*this, rhs);
+
+		ThreadRegistry::remove(this);
+		ThreadRegistry::remove(&rhs);
+
+		if(this->_internal != nullptr)
+			ThreadRegistry::add(this);
+
+		if(rhs._internal != nullptr)
+			ThreadRegistry::add(&rhs);
 	}
 
 	void Thread::start()
@@ -83,17 +111,34 @@ namespace lwiot
 		this->_running = true;
 		assert(this->_name.length() != 0);
 
-		if(this->_prio >= 0 && this->stacksize > 0UL) {
-			attrs.name = this->_name.c_str();
-			attrs.argument = this;
-			attrs.priority = this->_prio;
-			attrs.stacksize = this->stacksize;
-			attrs.handle = thread_starter;
+		attrs.name = this->_name.c_str();
+		attrs.argument = this;
+		attrs.priority = this->_prio;
+		attrs.stacksize = this->stacksize;
+		attrs.affinity = this->_affinity;
+		attrs.handle = thread_starter;
+
+#ifdef HAVE_STATIC_THREAD
+		if(this->_storage != nullptr && this->_stack != nullptr) {
+			if(lwiot_thread_create_static(this->_storage, &attrs, this->_stack) != -EOK) {
+				this->_running = false;
+				return;
+			}
+
+			this->_internal = this->_storage;
+			ThreadRegistry::add(this);
+			return;
+		}
+#endif
 
+		if((this->_prio >= 0 && this->stacksize > 0UL) || this->_affinity != 0) {
 			this->_internal = lwiot_thread_create_raw(&attrs);
 		} else {
 			this->_internal = lwiot_thread_create(thread_starter, this->_name.c_str(), this);
 		}
+
+		if(this->_internal != nullptr)
+			ThreadRegistry::add(this);
 	}
 
 	void Thread::join()
@@ -102,7 +147,9 @@ namespace lwiot
 
 		if(this->_running) {
 			this->_join.wait(g, FOREVER);
+			ThreadRegistry::remove(this);
 			lwiot_thread_destroy(this->_internal);
+			this->_internal = nullptr;
 		}
 	}
 
@@ -115,9 +162,79 @@ namespace lwiot
 
 		this->_running = false;
 		this->_join.signal();
+		ThreadRegistry::remove(this);
+
+		auto internal = this->_internal;
+		this->_internal = nullptr;
 
 		g.unlock();
-		lwiot_thread_destroy(this->_internal);
+		lwiot_thread_destroy(internal);
+	}
+
+	void Thread::collect(ThreadStatistics &stats) const
+	{
+		stats.name = this->_name;
+		stats.priority = this->_prio;
+		stats.running = this->_running;
+		stats.stackSize = this->stacksize;
+		stats.stackHighWaterMark = 0;
+		stats.cpuTime = 0;
+		stats.contextSwitches = 0;
+
+#ifdef HAVE_THREAD_STATS
+		lwiot_thread_stats raw{};
+
+		if(this->_internal == nullptr || lwiot_thread_stats(this->_internal, &raw) != -EOK)
+			return;
+
+		if(raw.stack_size != 0)
+			stats.stackSize = raw.stack_size;
+
+		stats.stackHighWaterMark = raw.stack_free;
+		stats.cpuTime = raw.cpu_time;
+		stats.contextSwitches = raw.switches;
+#endif
+	}
+
+	bool Thread::statistics(ThreadStatistics &stats) const
+	{
+		ScopedLock g(this->_lock);
+
+		if(this->_internal == nullptr)
+			return false;
+
+		this->collect(stats);
+		return true;
+	}
+
+	size_t Thread::stackHighWaterMark() const
+	{
+		ThreadStatistics stats;
+
+		if(!this->statistics(stats))
+			return 0;
+
+		return stats.stackHighWaterMark;
+	}
+
+	uint64_t Thread::cpuTime() const
+	{
+		ThreadStatistics stats;
+
+		if(!this->statistics(stats))
+			return 0;
+
+		return stats.cpuTime;
+	}
+
+	uint32_t Thread::contextSwitches() const
+	{
+		ThreadStatistics stats;
+
+		if(!this->statistics(stats))
+			return 0;
+
+		return stats.contextSwitches;
 	}
 
 	void Thread::pre_run()
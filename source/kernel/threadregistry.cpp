@@ -0,0 +1,90 @@
+/*
+ * Registry of running threads.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <lwiot.h>
+
+#include <lwiot/scopedlock.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/thread.h>
+#include <lwiot/kernel/threadregistry.h>
+#include <lwiot/stl/vector.h>
+
+namespace lwiot
+{
+	struct Registry {
+		Registry() : lock(false)
+		{ }
+
+		Lock lock;
+		stl::Vector<Thread*> threads;
+	};
+
+	/*
+	 * Intentionally never freed: threads with static storage duration may unregister after
+	 * static destructors have run.
+	 */
+	static Registry& registry()
+	{
+		static auto instance = new Registry();
+		return *instance;
+	}
+
+	/*
+	 * Lock order is thread lock first, registry lock second. Threads do not change their
+	 * port handle while registered, so the snapshot does not need the thread locks.
+	 */
+	stl::Vector<ThreadStatistics> ThreadRegistry::snapshot()
+	{
+		auto& reg = registry();
+		ScopedLock g(reg.lock);
+		stl::Vector<ThreadStatistics> rv(reg.threads.size());
+
+		for(auto thread : reg.threads) {
+			ThreadStatistics stats;
+
+			thread->collect(stats);
+			rv.push_back(stl::move(stats));
+		}
+
+		return rv;
+	}
+
+	size_t ThreadRegistry::count()
+	{
+		auto& reg = registry();
+		ScopedLock g(reg.lock);
+
+		return reg.threads.size();
+	}
+
+	void ThreadRegistry::add(Thread *thread)
+	{
+		auto& reg = registry();
+		ScopedLock g(reg.lock);
+
+		for(auto entry : reg.threads) {
+			if(entry == thread)
+				return;
+		}
+
+		reg.threads.push_back(thread);
+	}
+
+	void ThreadRegistry::remove(Thread *thread)
+	{
+		auto& reg = registry();
+		ScopedLock g(reg.lock);
+
+		for(size_t idx = 0; idx < reg.threads.size(); idx++) {
+			if(reg.threads[idx] == thread) {
+				reg.threads.erase(idx);
+				return;
+			}
+		}
+	}
+}
@@ -66,6 +66,11 @@ namespace lwiot {
 		return *this;
 	}
 
+	void Timer::setPeriod(unsigned long ms)
+	{
+		lwiot_timer_set_period(this->timer, ms > 0 ? static_cast<int>(ms) : 1);
+	}
+
 	time_t Timer::expiry()
 	{
 		return lwiot_timer_get_expiry(this->timer);
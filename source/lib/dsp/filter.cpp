@@ -0,0 +1,194 @@
+/*
+ * FIR and biquad filters.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/util/dsp.h>
+
+#define DSP_PI 3.14159265358979323846f
+
+namespace lwiot
+{
+	namespace dsp
+	{
+		Fir::Fir(const float *taps, size_t length) : _taps(length), _delay(length * 2), _pos(0), _phase(0)
+		{
+			for(size_t idx = 0; idx < length; idx++)
+				this->_taps.pushback(taps[idx]);
+
+			this->reset();
+		}
+
+		Fir::Fir(const stl::Vector<float>& taps) : _taps(taps), _delay(taps.size() * 2), _pos(0), _phase(0)
+		{
+			this->reset();
+		}
+
+		Fir Fir::average(size_t length)
+		{
+			stl::Vector<float> taps(length);
+
+			for(size_t idx = 0; idx < length; idx++)
+				taps.pushback(1.0f / static_cast<float>(length));
+
+			return Fir(taps);
+		}
+
+		void Fir::reset()
+		{
+			this->_delay.clear();
+
+			for(size_t idx = 0; idx < this->_taps.size() * 2; idx++)
+				this->_delay.pushback(0.0f);
+
+			this->_pos = 0;
+			this->_phase = 0;
+		}
+
+		float Fir::step(float sample)
+		{
+			auto length = this->_taps.size();
+			const float *taps = &this->_taps[0];
+			const float *window;
+			float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			size_t idx;
+
+			this->_pos = this->_pos == 0 ? length - 1 : this->_pos - 1;
+			this->_delay[this->_pos] = sample;
+			this->_delay[this->_pos + length] = sample;
+
+			/* Newest sample first, the oldest one is length - 1 samples further. */
+			window = &this->_delay[this->_pos];
+
+			for(idx = 0; idx + 4 <= length; idx += 4) {
+				acc[0] += taps[idx] * window[idx];
+				acc[1] += taps[idx + 1] * window[idx + 1];
+				acc[2] += taps[idx + 2] * window[idx + 2];
+				acc[3] += taps[idx + 3] * window[idx + 3];
+			}
+
+			for(; idx < length; idx++)
+				acc[0] += taps[idx] * window[idx];
+
+			return acc[0] + acc[1] + acc[2] + acc[3];
+		}
+
+		void Fir::process(const float *in, float *out, size_t length)
+		{
+			if(this->_taps.size() == 0)
+				return;
+
+			for(size_t idx = 0; idx < length; idx++)
+				out[idx] = this->step(in[idx]);
+		}
+
+		size_t Fir::decimate(const float *in, float *out, size_t length, size_t factor)
+		{
+			size_t num = 0;
+
+			if(this->_taps.size() == 0 || factor == 0)
+				return 0;
+
+			for(size_t idx = 0; idx < length; idx++) {
+				auto value = this->step(in[idx]);
+
+				if(this->_phase == 0)
+					out[num++] = value;
+
+				this->_phase = (this->_phase + 1) % factor;
+			}
+
+			return num;
+		}
+
+		Biquad::Biquad(float b0, float b1, float b2, float a1, float a2) :
+			_b0(b0), _b1(b1), _b2(b2), _a1(a1), _a2(a2), _z1(0.0f), _z2(0.0f)
+		{
+		}
+
+		void Biquad::reset()
+		{
+			this->_z1 = 0.0f;
+			this->_z2 = 0.0f;
+		}
+
+		float Biquad::process(float sample)
+		{
+			auto out = this->_b0 * sample + this->_z1;
+
+			this->_z1 = this->_b1 * sample - this->_a1 * out + this->_z2;
+			this->_z2 = this->_b2 * sample - this->_a2 * out;
+
+			return out;
+		}
+
+		void Biquad::process(const float *in, float *out, size_t length)
+		{
+			auto z1 = this->_z1;
+			auto z2 = this->_z2;
+
+			/* Keep the state in registers for the whole block. */
+			for(size_t idx = 0; idx < length; idx++) {
+				auto x = in[idx];
+				auto y = this->_b0 * x + z1;
+
+				z1 = this->_b1 * x - this->_a1 * y + z2;
+				z2 = this->_b2 * x - this->_a2 * y;
+				out[idx] = y;
+			}
+
+			this->_z1 = z1;
+			this->_z2 = z2;
+		}
+
+		static Biquad normalized(float b0, float b1, float b2, float a0, float a1, float a2)
+		{
+			return Biquad(b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0);
+		}
+
+		Biquad Biquad::lowpass(float fs, float f0, float q)
+		{
+			auto w0 = 2.0f * DSP_PI * f0 / fs;
+			auto cosw = cosf(w0);
+			auto alpha = sinf(w0) / (2.0f * q);
+
+			return normalized((1.0f - cosw) / 2.0f, 1.0f - cosw, (1.0f - cosw) / 2.0f,
+							  1.0f + alpha, -2.0f * cosw, 1.0f - alpha);
+		}
+
+		Biquad Biquad::highpass(float fs, float f0, float q)
+		{
+			auto w0 = 2.0f * DSP_PI * f0 / fs;
+			auto cosw = cosf(w0);
+			auto alpha = sinf(w0) / (2.0f * q);
+
+			return normalized((1.0f + cosw) / 2.0f, -(1.0f + cosw), (1.0f + cosw) / 2.0f,
+							  1.0f + alpha, -2.0f * cosw, 1.0f - alpha);
+		}
+
+		Biquad Biquad::bandpass(float fs, float f0, float q)
+		{
+			auto w0 = 2.0f * DSP_PI * f0 / fs;
+			auto alpha = sinf(w0) / (2.0f * q);
+
+			return normalized(alpha, 0.0f, -alpha, 1.0f + alpha, -2.0f * cosf(w0), 1.0f - alpha);
+		}
+
+		Biquad Biquad::notch(float fs, float f0, float q)
+		{
+			auto w0 = 2.0f * DSP_PI * f0 / fs;
+			auto cosw = cosf(w0);
+			auto alpha = sinf(w0) / (2.0f * q);
+
+			return normalized(1.0f, -2.0f * cosw, 1.0f, 1.0f + alpha, -2.0f * cosw, 1.0f - alpha);
+		}
+	}
+}
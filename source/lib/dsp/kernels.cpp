@@ -0,0 +1,87 @@
+/*
+ * Signal processing kernels for blocks of samples.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/util/dsp.h>
+
+/*
+ * The loops below keep several independent accumulators, so that the compiler can unroll
+ * and vectorize them without changing the order of the additions.
+ */
+
+namespace lwiot
+{
+	namespace dsp
+	{
+		void convert(const uint16_t *in, float *out, size_t length, float offset, float scale)
+		{
+			for(size_t idx = 0; idx < length; idx++)
+				out[idx] = (static_cast<float>(in[idx]) - offset) * scale;
+		}
+
+		float mean(const float *data, size_t length)
+		{
+			float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			size_t idx;
+
+			if(length == 0)
+				return 0.0f;
+
+			for(idx = 0; idx + 4 <= length; idx += 4) {
+				acc[0] += data[idx];
+				acc[1] += data[idx + 1];
+				acc[2] += data[idx + 2];
+				acc[3] += data[idx + 3];
+			}
+
+			for(; idx < length; idx++)
+				acc[0] += data[idx];
+
+			return (acc[0] + acc[1] + acc[2] + acc[3]) / static_cast<float>(length);
+		}
+
+		float rms(const float *data, size_t length)
+		{
+			float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			size_t idx;
+
+			if(length == 0)
+				return 0.0f;
+
+			for(idx = 0; idx + 4 <= length; idx += 4) {
+				acc[0] += data[idx] * data[idx];
+				acc[1] += data[idx + 1] * data[idx + 1];
+				acc[2] += data[idx + 2] * data[idx + 2];
+				acc[3] += data[idx + 3] * data[idx + 3];
+			}
+
+			for(; idx < length; idx++)
+				acc[0] += data[idx] * data[idx];
+
+			return sqrtf((acc[0] + acc[1] + acc[2] + acc[3]) / static_cast<float>(length));
+		}
+
+		float peak(const float *data, size_t length)
+		{
+			float max = 0.0f;
+
+			for(size_t idx = 0; idx < length; idx++) {
+				auto value = fabsf(data[idx]);
+
+				if(value > max)
+					max = value;
+			}
+
+			return max;
+		}
+	}
+}
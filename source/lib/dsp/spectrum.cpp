@@ -0,0 +1,118 @@
+/*
+ * FFT and Goertzel detector.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/util/dsp.h>
+
+#define DSP_PI 3.14159265358979323846
+
+namespace lwiot
+{
+	namespace dsp
+	{
+		bool fft(float *re, float *im, size_t length)
+		{
+			if(length == 0 || (length & (length - 1)) != 0)
+				return false;
+
+			/* Bit reversal permutation */
+			for(size_t i = 1, j = 0; i < length; i++) {
+				size_t bit = length >> 1;
+
+				for(; j & bit; bit >>= 1)
+					j ^= bit;
+
+				j ^= bit;
+
+				if(i < j) {
+					auto tr = re[i];
+					auto ti = im[i];
+
+					re[i] = re[j];
+					im[i] = im[j];
+					re[j] = tr;
+					im[j] = ti;
+				}
+			}
+
+			for(size_t size = 2; size <= length; size <<= 1) {
+				auto half = size >> 1;
+				auto theta = -2.0 * DSP_PI / static_cast<double>(size);
+				auto wr = static_cast<float>(cos(theta));
+				auto wi = static_cast<float>(sin(theta));
+
+				for(size_t start = 0; start < length; start += size) {
+					float cr = 1.0f;
+					float ci = 0.0f;
+
+					for(size_t k = 0; k < half; k++) {
+						auto a = start + k;
+						auto b = a + half;
+						auto tr = re[b] * cr - im[b] * ci;
+						auto ti = re[b] * ci + im[b] * cr;
+
+						re[b] = re[a] - tr;
+						im[b] = im[a] - ti;
+						re[a] += tr;
+						im[a] += ti;
+
+						auto next = cr * wr - ci * wi;
+						ci = cr * wi + ci * wr;
+						cr = next;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		void magnitude(const float *re, const float *im, float *out, size_t length)
+		{
+			for(size_t idx = 0; idx < length; idx++)
+				out[idx] = sqrtf(re[idx] * re[idx] + im[idx] * im[idx]);
+		}
+
+		Goertzel::Goertzel(float fs, float frequency, size_t length) : _length(length)
+		{
+			auto bin = floor(0.5 + static_cast<double>(length) * frequency / fs);
+			this->_coeff = static_cast<float>(2.0 * cos(2.0 * DSP_PI * bin / static_cast<double>(length)));
+		}
+
+		float Goertzel::power(const float *data) const
+		{
+			float s1 = 0.0f;
+			float s2 = 0.0f;
+
+			for(size_t idx = 0; idx < this->_length; idx++) {
+				auto s0 = data[idx] + this->_coeff * s1 - s2;
+
+				s2 = s1;
+				s1 = s0;
+			}
+
+			return s1 * s1 + s2 * s2 - this->_coeff * s1 * s2;
+		}
+
+		float Goertzel::amplitude(const float *data) const
+		{
+			if(this->_length == 0)
+				return 0.0f;
+
+			return 2.0f * sqrtf(this->power(data)) / static_cast<float>(this->_length);
+		}
+
+		size_t Goertzel::length() const
+		{
+			return this->_length;
+		}
+	}
+}
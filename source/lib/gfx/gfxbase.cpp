@@ -7,12 +7,15 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <lwiot.h>
 
 #include <lwiot/types.h>
 #include <lwiot/log.h>
 #include <lwiot/printer.h>
 #include <lwiot/gfxbase.h>
+#include <lwiot/glyphcache.h>
+#include <lwiot/gfxcanvas.h>
 
 #ifdef AVR
 #include <avr/io.h>
@@ -1005,6 +1008,17 @@ namespace lwiot
 			if(!_cp437 && (c >= 176))
 				c++; // Handle 'classic' charset behavior
 
+			if(size == 1) {
+				uint8_t columns[6];
+
+				for(int8_t i = 0; i < 5; i++)
+					columns[i] = pgm_read_byte(&default_font[c * 5 + i]);
+
+				columns[5] = 0;
+				drawColumnBitmap(x, y, columns, bg != color ? 6 : 5, 8, color, bg, bg != color);
+				return;
+			}
+
 			startWrite();
 			for(int8_t i = 0; i < 5; i++) { // Char bitmap = 5 columns
 				uint8_t line = pgm_read_byte(&default_font[c * 5 + i]);
@@ -1036,6 +1050,14 @@ namespace lwiot
 			// newlines, returns, non-printable characters, etc.  Calling
 			// drawChar() directly with 'bad' characters of font may cause mayhem!
 
+			const GlyphCache::Glyph *cached = size == 1 ? glyphs.lookup(gfxFont, c) : nullptr;
+
+			if(cached != nullptr) {
+				drawColumnBitmap(x + cached->xOffset, y + cached->yOffset, cached->columns,
+				                 cached->width, cached->height, color, color, false);
+				return;
+			}
+
 			c -= (uint8_t) pgm_read_byte(&gfxFont->first);
 			GFXglyph *glyph = &((pgm_read_pointer(&gfxFont->glyph, GFXglyph))[c]);
 			uint8_t *bitmap = pgm_read_pointer(&gfxFont->bitmap, uint8_t);
@@ -1091,6 +1113,45 @@ namespace lwiot
 		} // End classic vs custom font
 	}
 
+	void GfxBase::drawColumnBitmap(int16_t x, int16_t y, const uint8_t* columns, int16_t w, int16_t h,
+	                               uint16_t color, uint16_t bg, bool opaque)
+	{
+		startWrite();
+		for(int16_t j = 0; j < h; j++) {
+			for(int16_t i = 0; i < w; i++) {
+				if(columns[(j / 8) * w + i] & (1 << (j & 7)))
+					writePixel(x + i, y + j, color);
+				else if(opaque)
+					writePixel(x + i, y + j, bg);
+			}
+		}
+		endWrite();
+	}
+
+	void GfxBase::blit(const GfxCanvas1& canvas, int16_t x, int16_t y, uint16_t color, uint16_t bg)
+	{
+		auto columns = static_cast<const uint8_t*>(canvas.buffer());
+
+		if(columns != nullptr)
+			drawColumnBitmap(x, y, columns, canvas.WIDTH, canvas.HEIGHT, color, bg, true);
+	}
+
+	void GfxBase::blit(const GfxCanvas8& canvas, int16_t x, int16_t y)
+	{
+		auto pixels = static_cast<uint8_t*>(canvas.buffer());
+
+		if(pixels != nullptr)
+			drawGrayscaleBitmap(x, y, pixels, canvas.WIDTH, canvas.HEIGHT);
+	}
+
+	void GfxBase::blit(const GfxCanvas16& canvas, int16_t x, int16_t y)
+	{
+		auto pixels = static_cast<uint16_t*>(canvas.buffer());
+
+		if(pixels != nullptr)
+			drawRGBBitmap(x, y, pixels, canvas.WIDTH, canvas.HEIGHT);
+	}
+
 	size_t GfxBase::write(uint8_t c)
 	{
 		if(!gfxFont) { // 'Classic' built-in font
@@ -1216,6 +1277,43 @@ namespace lwiot
 		gfxFont = (GFXfont *) f;
 	}
 
+	bool GfxBase::setFont(const uint8_t *image, size_t size)
+	{
+		auto header = reinterpret_cast<const GFXfontImage *>(image);
+		auto glyph = reinterpret_cast<const GFXglyph *>(image + sizeof(*header));
+
+		if(image == nullptr || size < sizeof(*header) || memcmp(header->magic, "GFXF", 4) != 0)
+			return false;
+
+		if(header->first > header->last || reinterpret_cast<uintptr_t>(glyph) % alignof(GFXglyph) != 0)
+			return false;
+
+		size_t count = header->last - header->first + 1;
+		size_t offset = sizeof(*header) + count * sizeof(GFXglyph);
+
+		if(size < offset)
+			return false;
+
+		for(size_t idx = 0; idx < count; idx++) {
+			size_t bits = glyph[idx].width * glyph[idx].height;
+
+			if(offset + glyph[idx].bitmapOffset + (bits + 7) / 8 > size)
+				return false;
+		}
+
+		this->imageFont.bitmap = const_cast<uint8_t *>(image + offset);
+		this->imageFont.glyph = const_cast<GFXglyph *>(glyph);
+		this->imageFont.first = header->first;
+		this->imageFont.last = header->last;
+		this->imageFont.yAdvance = header->yAdvance;
+
+		/* The image may have replaced an earlier one at the same address. */
+		this->glyphs.clear();
+		this->setFont(&this->imageFont);
+
+		return true;
+	}
+
 	void GfxBase::charBounds(char c, int16_t *x, int16_t *y, int16_t *minx, int16_t *miny, int16_t *maxx, int16_t *maxy)
 	{
 		if(gfxFont) {
@@ -0,0 +1,151 @@
+/*
+ * Off-screen canvasses.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/gfxbase.h>
+#include <lwiot/gfxcanvas.h>
+
+#define canvas_swap(a, b) { int16_t t = a; a = b; b = t; }
+
+namespace lwiot
+{
+	GfxCanvas::GfxCanvas(int16_t w, int16_t h, size_t size) : GfxBase(w, h), _size(size)
+	{
+		this->_buffer = lwiot_mem_zalloc(size);
+	}
+
+	GfxCanvas::~GfxCanvas()
+	{
+		if(this->_buffer != nullptr)
+			lwiot_mem_free(this->_buffer);
+	}
+
+	void* GfxCanvas::buffer() const
+	{
+		return this->_buffer;
+	}
+
+	bool GfxCanvas::map(int16_t& x, int16_t& y) const
+	{
+		if(this->_buffer == nullptr || x < 0 || y < 0 || x >= this->_width || y >= this->_height)
+			return false;
+
+		switch(this->rotation) {
+		case 1:
+			canvas_swap(x, y);
+			x = WIDTH - x - 1;
+			break;
+
+		case 2:
+			x = WIDTH - x - 1;
+			y = HEIGHT - y - 1;
+			break;
+
+		case 3:
+			canvas_swap(x, y);
+			y = HEIGHT - y - 1;
+			break;
+
+		default:
+			break;
+		}
+
+		return true;
+	}
+
+	GfxCanvas1::GfxCanvas1(int16_t w, int16_t h) : GfxCanvas(w, h, w * ((h + 7) / 8))
+	{
+	}
+
+	void GfxCanvas1::drawPixel(int16_t x, int16_t y, uint16_t color)
+	{
+		if(!this->map(x, y))
+			return;
+
+		auto byte = &static_cast<uint8_t*>(this->_buffer)[(y / 8) * WIDTH + x];
+
+		if(color)
+			*byte |= 1U << (y & 7);
+		else
+			*byte &= ~(1U << (y & 7));
+	}
+
+	void GfxCanvas1::fillScreen(uint16_t color)
+	{
+		if(this->_buffer != nullptr)
+			memset(this->_buffer, color ? 0xFF : 0x00, this->_size);
+	}
+
+	bool GfxCanvas1::getPixel(int16_t x, int16_t y) const
+	{
+		if(!this->map(x, y))
+			return false;
+
+		return (static_cast<uint8_t*>(this->_buffer)[(y / 8) * WIDTH + x] >> (y & 7)) & 1U;
+	}
+
+	GfxCanvas8::GfxCanvas8(int16_t w, int16_t h) : GfxCanvas(w, h, w * h)
+	{
+	}
+
+	void GfxCanvas8::drawPixel(int16_t x, int16_t y, uint16_t color)
+	{
+		if(!this->map(x, y))
+			return;
+
+		static_cast<uint8_t*>(this->_buffer)[y * WIDTH + x] = color;
+	}
+
+	void GfxCanvas8::fillScreen(uint16_t color)
+	{
+		if(this->_buffer != nullptr)
+			memset(this->_buffer, color, this->_size);
+	}
+
+	uint8_t GfxCanvas8::getPixel(int16_t x, int16_t y) const
+	{
+		if(!this->map(x, y))
+			return 0;
+
+		return static_cast<uint8_t*>(this->_buffer)[y * WIDTH + x];
+	}
+
+	GfxCanvas16::GfxCanvas16(int16_t w, int16_t h) : GfxCanvas(w, h, w * h * sizeof(uint16_t))
+	{
+	}
+
+	void GfxCanvas16::drawPixel(int16_t x, int16_t y, uint16_t color)
+	{
+		if(!this->map(x, y))
+			return;
+
+		static_cast<uint16_t*>(this->_buffer)[y * WIDTH + x] = color;
+	}
+
+	void GfxCanvas16::fillScreen(uint16_t color)
+	{
+		auto pixels = static_cast<uint16_t*>(this->_buffer);
+
+		if(pixels == nullptr)
+			return;
+
+		for(size_t idx = 0; idx < this->_size / sizeof(uint16_t); idx++)
+			pixels[idx] = color;
+	}
+
+	uint16_t GfxCanvas16::getPixel(int16_t x, int16_t y) const
+	{
+		if(!this->map(x, y))
+			return 0;
+
+		return static_cast<uint16_t*>(this->_buffer)[y * WIDTH + x];
+	}
+}
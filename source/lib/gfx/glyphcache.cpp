@@ -0,0 +1,116 @@
+/*
+ * Cache of rasterized font glyphs.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/gfxbase.h>
+#include <lwiot/glyphcache.h>
+
+#ifdef AVR
+#include <avr/pgmspace.h>
+#define pgm_read_pointer(addr, type) ((type *)pgm_read_word(addr))
+#else
+#define pgm_read_pointer(addr, type) (*(type * const *)(addr))
+#endif
+
+#ifndef pgm_read_byte
+#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+#endif
+
+#ifndef pgm_read_word
+#define pgm_read_word(addr) (*(const unsigned short *)(addr))
+#endif
+
+namespace lwiot
+{
+	GlyphCache::GlyphCache() : _clock(0)
+	{
+		memset(this->_glyphs, 0, sizeof(this->_glyphs));
+	}
+
+	GlyphCache::~GlyphCache()
+	{
+		this->clear();
+	}
+
+	void GlyphCache::clear()
+	{
+		for(auto& glyph : this->_glyphs) {
+			if(glyph.columns != nullptr)
+				lwiot_mem_free(glyph.columns);
+
+			memset(&glyph, 0, sizeof(glyph));
+		}
+	}
+
+	const GlyphCache::Glyph* GlyphCache::lookup(const GFXfont* font, uint8_t c)
+	{
+		Glyph* victim = &this->_glyphs[0];
+
+		this->_clock++;
+
+		for(auto& glyph : this->_glyphs) {
+			if(glyph.columns != nullptr && glyph.font == font && glyph.c == c) {
+				glyph.used = this->_clock;
+				return &glyph;
+			}
+
+			if(glyph.used < victim->used)
+				victim = &glyph;
+		}
+
+		if(victim->columns != nullptr) {
+			lwiot_mem_free(victim->columns);
+			victim->columns = nullptr;
+		}
+
+		if(!rasterize(*victim, font, c))
+			return nullptr;
+
+		victim->used = this->_clock;
+		return victim;
+	}
+
+	bool GlyphCache::rasterize(Glyph& glyph, const GFXfont* font, uint8_t c)
+	{
+		auto info = &pgm_read_pointer(&font->glyph, GFXglyph)[c - pgm_read_byte(&font->first)];
+		auto bitmap = pgm_read_pointer(&font->bitmap, uint8_t);
+		uint16_t offset = pgm_read_word(&info->bitmapOffset);
+		uint8_t bits = 0;
+
+		glyph.font = font;
+		glyph.c = c;
+		glyph.width = pgm_read_byte(&info->width);
+		glyph.height = pgm_read_byte(&info->height);
+		glyph.xOffset = pgm_read_byte(&info->xOffset);
+		glyph.yOffset = pgm_read_byte(&info->yOffset);
+
+		if(glyph.width == 0 || glyph.height == 0)
+			return false;
+
+		glyph.columns = static_cast<uint8_t*>(lwiot_mem_zalloc(glyph.width * ((glyph.height + 7U) / 8U)));
+
+		if(glyph.columns == nullptr)
+			return false;
+
+		/* Glyph bitmaps are a single bit stream of rows, most significant bit first. */
+		for(uint16_t idx = 0, y = 0; y < glyph.height; y++) {
+			for(uint8_t x = 0; x < glyph.width; x++, idx++, bits <<= 1) {
+				if((idx & 7) == 0)
+					bits = pgm_read_byte(&bitmap[offset++]);
+
+				if(bits & 0x80)
+					glyph.columns[(y / 8) * glyph.width + x] |= 1U << (y & 7);
+			}
+		}
+
+		return true;
+	}
+}
@@ -10,11 +10,14 @@
 #include <lwiot.h>
 
 #include <lwiot/kernel/lock.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/stl/move.h>
 #include <lwiot/log.h>
 #include <lwiot/types.h>
 #include <lwiot/io/i2cbus.h>
-#include <lwiot/io/i2cmessage.h>
+#include <lwiot/io/spibus.h>
 #include <lwiot/gfxbase.h>
+#include <lwiot/device/ssd1306transport.h>
 #include <lwiot/device/ssd1306display.h>
 
 /* Commands */
@@ -65,8 +68,18 @@
 
 #define ssd1306_swap(a, b) { int16_t t = a; a = b; b = t; }
 
-/* Display buffer */
-static uint8_t buffer[SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8] = {
+#ifdef AVR
+#include <avr/pgmspace.h>
+#endif
+
+#ifndef pgm_read_byte
+#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+#endif
+
+#define SSD1306_BUFFER_SIZE (SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8)
+
+/* Splash screen, loaded into the frame buffer on construction */
+static const uint8_t splash[SSD1306_BUFFER_SIZE] = {
 		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
 		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
 		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -140,13 +153,28 @@ static uint8_t buffer[SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8] = {
 
 namespace lwiot
 {
-	Ssd1306Display::Ssd1306Display(lwiot::I2CBus &bus, uint8_t addr) : GfxBase(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT),
-	                                                                   _bus(bus), _i2caddr(addr)
+	Ssd1306Display::Ssd1306Display(lwiot::I2CBus &bus, uint8_t addr) :
+		Ssd1306Display(new Ssd1306I2CTransport(bus, addr))
 	{
 	}
 
+	Ssd1306Display::Ssd1306Display(SpiBus& bus, int cs, const GpioPin& dc, const GpioPin& rst, uint32_t freq) :
+		Ssd1306Display(new Ssd1306SpiTransport(bus, cs, dc, rst, freq))
+	{
+	}
+
+	Ssd1306Display::Ssd1306Display(Ssd1306Transport* transport) : GfxBase(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT),
+		_transport(transport), _front(nullptr), _double(false), _lock(false)
+	{
+		this->_buffer = this->_transport->allocate(SSD1306_BUFFER_SIZE);
+		memcpy(this->_buffer, splash, sizeof(splash));
+		this->_pending.dirty = false;
+		this->invalidate();
+	}
+
 	void Ssd1306Display::begin()
 	{
+		this->_transport->reset();
 		this->writeCommand(SSD1306_DISPLAYOFF);
 		this->writeCommand(SSD1306_SETDISPLAYCLOCKDIV);
 		this->writeCommand(0x80);
@@ -192,22 +220,24 @@ namespace lwiot
 		this->writeCommand(SSD1306_DEACTIVATE_SCROLL);
 
 		this->writeCommand(SSD1306_DISPLAYON);
+		this->invalidate();
 	}
 
 	void Ssd1306Display::writeCommand(uint8_t cmd)
 	{
-		I2CMessage msg(2);
-
-		msg.write(0);
-		msg.write(cmd);
-		msg.setAddress(Ssd1306Display::SlaveAddress, false, false);
-
-		if(!this->_bus.transfer(msg)) {
+		if(!this->_transport->command(&cmd, 1)) {
 			print_dbg("Unable to send SSD1306 command!\n");
 			return;
 		}
 	}
 
+	void Ssd1306Display::writeCommands(const uint8_t* cmds, size_t num)
+	{
+		if(!this->_transport->command(cmds, num)) {
+			print_dbg("Unable to send SSD1306 commands!\n");
+		}
+	}
+
 	void Ssd1306Display::drawPixel(int16_t x, int16_t y, uint16_t color)
 	{
 		if((x < 0) || (x >= width()) || (y < 0) || (y >= height()))
@@ -231,17 +261,19 @@ namespace lwiot
 			break;
 		}
 
+		this->markDirty(x, y, x, y);
+
 		switch(color) {
 		case WHITE:
-			buffer[x + (y / 8) * SSD1306_LCDWIDTH] |= (1 << (y & 7));
+			this->_buffer[x + (y / 8) * SSD1306_LCDWIDTH] |= (1 << (y & 7));
 			break;
 
 		case BLACK:
-			buffer[x + (y / 8) * SSD1306_LCDWIDTH] &= ~(1 << (y & 7));
+			this->_buffer[x + (y / 8) * SSD1306_LCDWIDTH] &= ~(1 << (y & 7));
 			break;
 
 		case INVERSE:
-			buffer[x + (y / 8) * SSD1306_LCDWIDTH] ^= (1 << (y & 7));
+			this->_buffer[x + (y / 8) * SSD1306_LCDWIDTH] ^= (1 << (y & 7));
 			break;
 
 		default:
@@ -259,7 +291,8 @@ namespace lwiot
 
 	void Ssd1306Display::clear(void)
 	{
-		memset(buffer, 0, (SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8));
+		memset(this->_buffer, 0, SSD1306_BUFFER_SIZE);
+		this->invalidate();
 	}
 
 	void Ssd1306Display::dim(bool dim)
@@ -275,39 +308,398 @@ namespace lwiot
 		this->writeCommand(contrast);
 	}
 
+	void Ssd1306Display::Window::add(const Window& other)
+	{
+		if(!other.dirty)
+			return;
+
+		if(!this->dirty) {
+			*this = other;
+			return;
+		}
+
+		if(other.x0 < this->x0)
+			this->x0 = other.x0;
+
+		if(other.x1 > this->x1)
+			this->x1 = other.x1;
+
+		if(other.p0 < this->p0)
+			this->p0 = other.p0;
+
+		if(other.p1 > this->p1)
+			this->p1 = other.p1;
+	}
+
+	void Ssd1306Display::invalidate()
+	{
+		this->_drawn.dirty = true;
+		this->_drawn.x0 = 0;
+		this->_drawn.x1 = SSD1306_LCDWIDTH - 1;
+		this->_drawn.p0 = 0;
+		this->_drawn.p1 = SSD1306_LCDHEIGHT / 8 - 1;
+	}
+
+	void Ssd1306Display::markDirty(int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+	{
+		Window window;
+
+		window.dirty = true;
+		window.x0 = x0;
+		window.x1 = x1;
+		window.p0 = y0 / 8;
+		window.p1 = y1 / 8;
+
+		this->_drawn.add(window);
+	}
+
+	bool Ssd1306Display::enableDoubleBuffering()
+	{
+		ScopedLock lock(this->_lock);
+
+		if(this->_double)
+			return true;
+
+		auto front = this->_transport->allocate(SSD1306_BUFFER_SIZE);
+
+		if(front == nullptr)
+			return false;
+
+		memcpy(front, this->_buffer, SSD1306_BUFFER_SIZE);
+		this->_front = front;
+		this->_double = true;
+
+		return true;
+	}
+
+	void Ssd1306Display::swap()
+	{
+		ScopedLock lock(this->_lock);
+
+		if(!this->_double) {
+			this->_pending.add(this->_drawn);
+			this->_drawn.dirty = false;
+			this->flush();
+			return;
+		}
+
+		auto back = this->_front;
+
+		this->_front = this->_buffer;
+		this->_buffer = back;
+		memcpy(this->_buffer, this->_front, SSD1306_BUFFER_SIZE);
+
+		this->_pending.add(this->_drawn);
+		this->_drawn.dirty = false;
+	}
+
 	void Ssd1306Display::display(void)
 	{
-		this->writeCommand(SSD1306_COLUMNADDR);
-		this->writeCommand(0);
-		this->writeCommand(SSD1306_LCDWIDTH - 1);
+		ScopedLock lock(this->_lock);
 
-		this->writeCommand(SSD1306_PAGEADDR);
-		this->writeCommand(0);
-#if SSD1306_LCDHEIGHT == 64
-		this->writeCommand(7);
-#endif
-#if SSD1306_LCDHEIGHT == 32
-		this->writeCommand(3); // Page end address
-#endif
-#if SSD1306_LCDHEIGHT == 16
-		this->writeCommand(1); // Page end address
-#endif
+		if(!this->_double) {
+			this->_pending.add(this->_drawn);
+			this->_drawn.dirty = false;
+		}
+
+		this->flush();
+	}
+
+	void Ssd1306Display::flush()
+	{
+		auto frame = this->_double ? this->_front : this->_buffer;
+		auto& window = this->_pending;
+
+		if(!window.dirty)
+			return;
+
+		const uint8_t address[] = {
+			SSD1306_COLUMNADDR, window.x0, window.x1,
+			SSD1306_PAGEADDR, window.p0, window.p1
+		};
+
+		this->writeCommands(address, sizeof(address));
+
+		if(!this->_transport->data(frame, SSD1306_LCDWIDTH, window.x0, window.x1, window.p0, window.p1)) {
+			print_dbg("Unable to send SSD1306 frame!\n");
+			return;
+		}
+
+		window.dirty = false;
+	}
+
+	/*
+	 * Apply \p color to the bits of \p mask in \p num consecutive bytes. Full bytes of a solid color are
+	 * written with memset(), the rest a word at a time.
+	 */
+	static void span(uint8_t* bytes, size_t num, uint8_t mask, uint16_t color)
+	{
+		uint32_t wide = mask * 0x01010101UL;
+		uint32_t word;
 
+		if(mask == 0xFF && (color == WHITE || color == BLACK)) {
+			memset(bytes, color == WHITE ? 0xFF : 0x00, num);
+			return;
+		}
+
+		for(; num >= sizeof(word); num -= sizeof(word), bytes += sizeof(word)) {
+			memcpy(&word, bytes, sizeof(word));
+
+			switch(color) {
+			case WHITE:
+				word |= wide;
+				break;
 
-		for(uint16_t i = 0; i < (SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8); i++) {
-			I2CMessage msg(17);
+			case BLACK:
+				word &= ~wide;
+				break;
 
-			msg.setAddress(this->_i2caddr, false, false);
-			msg.setRepeatedStart(false);
-			msg.write(0x40);
+			case INVERSE:
+				word ^= wide;
+				break;
 
-			for(uint8_t x = 0; x < 16; x++) {
-				msg.write(buffer[i]);
-				i++;
+			default:
+				break;
 			}
-			i--;
 
-			this->_bus.transfer(msg);
+			memcpy(bytes, &word, sizeof(word));
+		}
+
+		for(; num > 0; num--, bytes++) {
+			switch(color) {
+			case WHITE:
+				*bytes |= mask;
+				break;
+
+			case BLACK:
+				*bytes &= ~mask;
+				break;
+
+			case INVERSE:
+				*bytes ^= mask;
+				break;
+
+			default:
+				break;
+			}
+		}
+	}
+
+	/*
+	 * Transpose an 8x8 block of bits: \p rows holds eight bitmap rows, most significant bit left, and
+	 * \p columns receives eight display columns, least significant bit on top.
+	 */
+	static void transpose(const uint8_t rows[8], uint8_t columns[8])
+	{
+		uint32_t x, y, t;
+
+		x = static_cast<uint32_t>(rows[7]) << 24 | static_cast<uint32_t>(rows[6]) << 16 |
+		    static_cast<uint32_t>(rows[5]) << 8 | rows[4];
+		y = static_cast<uint32_t>(rows[3]) << 24 | static_cast<uint32_t>(rows[2]) << 16 |
+		    static_cast<uint32_t>(rows[1]) << 8 | rows[0];
+
+		t = (x ^ (x >> 7)) & 0x00AA00AAUL;
+		x = x ^ t ^ (t << 7);
+		t = (y ^ (y >> 7)) & 0x00AA00AAUL;
+		y = y ^ t ^ (t << 7);
+
+		t = (x ^ (x >> 14)) & 0x0000CCCCUL;
+		x = x ^ t ^ (t << 14);
+		t = (y ^ (y >> 14)) & 0x0000CCCCUL;
+		y = y ^ t ^ (t << 14);
+
+		t = (x & 0xF0F0F0F0UL) | ((y >> 4) & 0x0F0F0F0FUL);
+		y = ((x << 4) & 0xF0F0F0F0UL) | (y & 0x0F0F0F0FUL);
+		x = t;
+
+		columns[0] = x >> 24;
+		columns[1] = x >> 16;
+		columns[2] = x >> 8;
+		columns[3] = x;
+		columns[4] = y >> 24;
+		columns[5] = y >> 16;
+		columns[6] = y >> 8;
+		columns[7] = y;
+	}
+
+	void Ssd1306Display::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+	{
+		switch(rotation) {
+		case 1:
+			ssd1306_swap(x, y);
+			ssd1306_swap(w, h);
+			x = WIDTH - x - w;
+			break;
+
+		case 2:
+			x = WIDTH - x - w;
+			y = HEIGHT - y - h;
+			break;
+
+		case 3:
+			ssd1306_swap(x, y);
+			ssd1306_swap(w, h);
+			y = HEIGHT - y - h;
+			break;
+
+		default:
+			break;
+		}
+
+		this->rawFillRect(x, y, w, h, color);
+	}
+
+	void Ssd1306Display::rawFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+	{
+		if(x < 0) {
+			w += x;
+			x = 0;
+		}
+
+		if(y < 0) {
+			h += y;
+			y = 0;
+		}
+
+		if(x + w > WIDTH)
+			w = WIDTH - x;
+
+		if(y + h > HEIGHT)
+			h = HEIGHT - y;
+
+		if(w <= 0 || h <= 0)
+			return;
+
+		this->markDirty(x, y, x + w - 1, y + h - 1);
+
+		for(int16_t page = y / 8; page <= (y + h - 1) / 8; page++) {
+			int16_t top = page * 8;
+			uint8_t mask = 0xFF;
+
+			if(y > top)
+				mask &= 0xFF << (y - top);
+
+			if(y + h < top + 8)
+				mask &= 0xFF >> (top + 8 - y - h);
+
+			span(&this->_buffer[page * SSD1306_LCDWIDTH + x], w, mask, color);
+		}
+	}
+
+	void Ssd1306Display::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h,
+	                                uint16_t color)
+	{
+		this->blitBitmap(x, y, bitmap, w, h, color, color, false, true);
+	}
+
+	void Ssd1306Display::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h,
+	                                uint16_t color, uint16_t bg)
+	{
+		this->blitBitmap(x, y, bitmap, w, h, color, bg, true, true);
+	}
+
+	void Ssd1306Display::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color)
+	{
+		this->blitBitmap(x, y, bitmap, w, h, color, color, false, false);
+	}
+
+	void Ssd1306Display::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h,
+	                                uint16_t color, uint16_t bg)
+	{
+		this->blitBitmap(x, y, bitmap, w, h, color, bg, true, false);
+	}
+
+	void Ssd1306Display::blitBitmap(int16_t x, int16_t y, const uint8_t* bitmap, int16_t w, int16_t h,
+	                                uint16_t color, uint16_t bg, bool opaque, bool progmem)
+	{
+		int16_t stride = (w + 7) / 8;
+		uint8_t rows[8], columns[8];
+
+		if(rotation != 0) {
+			auto ram = const_cast<uint8_t*>(bitmap);
+
+			if(opaque && progmem)
+				GfxBase::drawBitmap(x, y, bitmap, w, h, color, bg);
+			else if(opaque)
+				GfxBase::drawBitmap(x, y, ram, w, h, color, bg);
+			else if(progmem)
+				GfxBase::drawBitmap(x, y, bitmap, w, h, color);
+			else
+				GfxBase::drawBitmap(x, y, ram, w, h, color);
+
+			return;
+		}
+
+		if(w <= 0 || h <= 0 || x >= WIDTH || y >= HEIGHT || x + w <= 0 || y + h <= 0)
+			return;
+
+		/* Eight bitmap rows at a time are turned into display columns and written a byte per column. */
+		for(int16_t band = 0; band < h; band += 8) {
+			int16_t num = h - band < 8 ? h - band : 8;
+			uint8_t mask = 0xFF >> (8 - num);
+
+			for(int16_t idx = 0; idx < stride; idx++) {
+				const uint8_t* src = &bitmap[band * stride + idx];
+
+				for(int16_t row = 0; row < 8; row++, src += stride)
+					rows[row] = row < num ? (progmem ? pgm_read_byte(src) : *src) : 0;
+
+				transpose(rows, columns);
+
+				for(int16_t col = 0; col < 8 && idx * 8 + col < w; col++)
+					this->column(x + idx * 8 + col, y + band, columns[col], mask, color, bg, opaque);
+			}
+		}
+
+		this->markDirty(x < 0 ? 0 : x, y < 0 ? 0 : y, x + w > WIDTH ? WIDTH - 1 : x + w - 1,
+		                y + h > HEIGHT ? HEIGHT - 1 : y + h - 1);
+	}
+
+	void Ssd1306Display::drawColumnBitmap(int16_t x, int16_t y, const uint8_t* columns, int16_t w, int16_t h,
+	                                      uint16_t color, uint16_t bg, bool opaque)
+	{
+		if(rotation != 0) {
+			GfxBase::drawColumnBitmap(x, y, columns, w, h, color, bg, opaque);
+			return;
+		}
+
+		if(w <= 0 || h <= 0 || x >= WIDTH || y >= HEIGHT || x + w <= 0 || y + h <= 0)
+			return;
+
+		for(int16_t band = 0; band < h; band += 8) {
+			int16_t num = h - band < 8 ? h - band : 8;
+			uint8_t mask = 0xFF >> (8 - num);
+
+			for(int16_t col = 0; col < w; col++)
+				this->column(x + col, y + band, *columns++, mask, color, bg, opaque);
+		}
+
+		this->markDirty(x < 0 ? 0 : x, y < 0 ? 0 : y, x + w > WIDTH ? WIDTH - 1 : x + w - 1,
+		                y + h > HEIGHT ? HEIGHT - 1 : y + h - 1);
+	}
+
+	void Ssd1306Display::column(int16_t x, int16_t y, uint8_t bits, uint8_t mask, uint16_t color,
+	                            uint16_t bg, bool opaque)
+	{
+		int16_t page = y >= 0 ? y / 8 : -((7 - y) / 8);
+		auto shift = y - page * 8;
+		uint16_t fg = static_cast<uint16_t>(bits & mask) << shift;
+		uint16_t back = static_cast<uint16_t>(~bits & mask) << shift;
+
+		if(x < 0 || x >= WIDTH)
+			return;
+
+		/* A column of eight pixels covers at most two pages. */
+		for(int16_t idx = 0; idx < 2; idx++, page++, fg >>= 8, back >>= 8) {
+			if(page < 0 || page >= HEIGHT / 8)
+				continue;
+
+			auto byte = &this->_buffer[page * SSD1306_LCDWIDTH + x];
+
+			span(byte, 1, fg & 0xFF, color);
+
+			if(opaque)
+				span(byte, 1, back & 0xFF, bg);
 		}
 	}
 
@@ -332,7 +724,8 @@ namespace lwiot
 			return;
 		}
 
-		pBuf = buffer;
+		this->markDirty(x, y, x + w - 1, y);
+		pBuf = this->_buffer;
 		pBuf += ((y / 8) * SSD1306_LCDWIDTH);
 		pBuf += x;
 		mask = 1 << (y & 7);
@@ -422,8 +815,9 @@ namespace lwiot
 
 		y = __y;
 		h = __h;
+		this->markDirty(x, y, x, y + h - 1);
 
-		pBuf = buffer;
+		pBuf = this->_buffer;
 		pBuf += ((y / 8) * SSD1306_LCDWIDTH);
 		pBuf += x;
 		mod = (y & 7);
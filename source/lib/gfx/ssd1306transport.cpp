@@ -0,0 +1,186 @@
+/*
+ * SSD1306 bus transports.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/stl/move.h>
+#include <lwiot/io/gpiopin.h>
+#include <lwiot/io/i2cbus.h>
+#include <lwiot/io/i2cmessage.h>
+#include <lwiot/io/spibus.h>
+#include <lwiot/io/spidevice.h>
+#include <lwiot/io/spimessage.h>
+#include <lwiot/device/ssd1306transport.h>
+
+#define SSD1306_CONTROL_CMD 0x00
+#define SSD1306_CONTROL_DATA 0x40
+
+#define SSD1306_RESET_LOW_MS  10
+#define SSD1306_RESET_WAIT_MS 1
+
+namespace lwiot
+{
+	void Ssd1306Transport::reset()
+	{
+	}
+
+	Ssd1306I2CTransport::Ssd1306I2CTransport(I2CBus& bus, uint8_t addr) : _bus(bus), _addr(addr), _count(0), _size(0)
+	{
+	}
+
+	bool Ssd1306I2CTransport::command(const uint8_t* cmds, size_t num)
+	{
+		I2CMessage msg(num + 1);
+
+		msg.writeUnchecked(SSD1306_CONTROL_CMD);
+		msg.writeUnchecked(cmds, num);
+		msg.setAddress(this->_addr, false, false);
+
+		return this->_bus.transfer(msg);
+	}
+
+	uint8_t* Ssd1306I2CTransport::allocate(size_t size)
+	{
+		if(this->_count >= MaxFrames)
+			return nullptr;
+
+		I2CMessage msg(size + 1);
+
+		if(msg.data() == nullptr)
+			return nullptr;
+
+		msg.setAddress(this->_addr, false, false);
+		msg.setRepeatedStart(false);
+		msg.writeUnchecked(SSD1306_CONTROL_DATA);
+		memset(msg.data() + 1, 0, size);
+		msg.setIndex(size + 1);
+
+		this->_size = size;
+		this->_frames[this->_count] = stl::move(msg);
+
+		return this->_frames[this->_count++].data() + 1;
+	}
+
+	bool Ssd1306I2CTransport::data(const uint8_t* frame, size_t stride, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1)
+	{
+		size_t columns = x1 - x0 + 1U;
+		size_t pages = p1 - p0 + 1U;
+
+		if(columns * pages == this->_size) {
+			for(size_t idx = 0; idx < this->_count; idx++) {
+				if(this->_frames[idx].data() + 1 == frame)
+					return this->_bus.transfer(this->_frames[idx]);
+			}
+		}
+
+		/* The window is sent page by page, and is only contiguous in the frame buffer within a page. */
+		I2CMessage msg(columns * pages + 1);
+
+		msg.setAddress(this->_addr, false, false);
+		msg.setRepeatedStart(false);
+		msg.writeUnchecked(SSD1306_CONTROL_DATA);
+
+		for(auto page = p0; page <= p1; page++)
+			msg.writeUnchecked(&frame[page * stride + x0], columns);
+
+		return this->_bus.transfer(msg);
+	}
+
+	Ssd1306SpiTransport::Ssd1306SpiTransport(SpiBus& bus, int cs, const GpioPin& dc, const GpioPin& rst, uint32_t freq) :
+		_device(bus, cs, freq, SpiMode::Mode0), _dc(dc), _rst(rst), _data(true), _size(0)
+	{
+		/* Frame buffers are handed out by address, so the messages must never move. */
+		this->_frames.reserve(MaxFrames);
+
+		this->_dc.mode(PinMode::OUTPUT);
+		this->_dc.write(true);
+
+		if(this->_rst.pin() >= 0) {
+			this->_rst.mode(PinMode::OUTPUT);
+			this->_rst.write(true);
+		}
+	}
+
+	void Ssd1306SpiTransport::reset()
+	{
+		if(this->_rst.pin() < 0)
+			return;
+
+		this->_rst.write(true);
+		lwiot_sleep(SSD1306_RESET_WAIT_MS);
+		this->_rst.write(false);
+		lwiot_sleep(SSD1306_RESET_LOW_MS);
+		this->_rst.write(true);
+		lwiot_sleep(SSD1306_RESET_WAIT_MS);
+	}
+
+	void Ssd1306SpiTransport::select(bool data)
+	{
+		if(this->_data == data)
+			return;
+
+		this->_dc.write(data);
+		this->_data = data;
+	}
+
+	bool Ssd1306SpiTransport::command(const uint8_t* cmds, size_t num)
+	{
+		SpiMessage msg(num, this->_device.cs());
+
+		msg.txdata().writeUnchecked(cmds, num);
+		this->select(false);
+
+		return this->_device.transfer(msg);
+	}
+
+	uint8_t* Ssd1306SpiTransport::allocate(size_t size)
+	{
+		if(this->_frames.size() >= MaxFrames)
+			return nullptr;
+
+		this->_frames.pushback(SpiMessage(size, this->_device.cs()));
+
+		auto& msg = this->_frames.back();
+		auto frame = msg.txdata().data();
+
+		if(frame == nullptr || msg.rxdata().data() == nullptr) {
+			this->_frames.popback();
+			return nullptr;
+		}
+
+		memset(frame, 0, size);
+		this->_size = size;
+
+		return frame;
+	}
+
+	bool Ssd1306SpiTransport::data(const uint8_t* frame, size_t stride, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1)
+	{
+		size_t columns = x1 - x0 + 1U;
+		size_t pages = p1 - p0 + 1U;
+
+		this->select(true);
+
+		if(columns * pages == this->_size) {
+			for(auto& msg : this->_frames) {
+				if(msg.txdata().data() == frame)
+					return this->_device.transfer(msg);
+			}
+		}
+
+		SpiMessage msg(columns * pages, this->_device.cs());
+
+		for(auto page = p0; page <= p1; page++)
+			msg.txdata().writeUnchecked(&frame[page * stride + x0], columns);
+
+		return this->_device.transfer(msg);
+	}
+}
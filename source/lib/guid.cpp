@@ -6,22 +6,101 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <assert.h>
 #include <lwiot.h>
 
 #include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/clock.h>
 #include <lwiot/log.h>
 #include <lwiot/util/guid.h>
 
 namespace lwiot
 {
-	Guid::Guid()
+	/* Text form of every byte value. */
+	static const char hex_pairs[] =
+		"000102030405060708090a0b0c0d0e0f"
+		"101112131415161718191a1b1c1d1e1f"
+		"202122232425262728292a2b2c2d2e2f"
+		"303132333435363738393a3b3c3d3e3f"
+		"404142434445464748494a4b4c4d4e4f"
+		"505152535455565758595a5b5c5d5e5f"
+		"606162636465666768696a6b6c6d6e6f"
+		"707172737475767778797a7b7c7d7e7f"
+		"808182838485868788898a8b8c8d8e8f"
+		"909192939495969798999a9b9c9d9e9f"
+		"a0a1a2a3a4a5a6a7a8a9aaabacadaeaf"
+		"b0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+		"c0c1c2c3c4c5c6c7c8c9cacbcccdcecf"
+		"d0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+		"e0e1e2e3e4e5e6e7e8e9eaebecedeeef"
+		"f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+	/* Value of every ASCII hex digit; 0xFF for other characters. */
+	static const uint8_t hex_nibbles[128] = {
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	};
+
+	/* Offset of the first character of every byte in the text form. */
+	static const uint8_t text_offsets[Guid::GUID_SIZE] = {
+		0, 2, 4, 6, 9, 11, 14, 16, 19, 21, 24, 26, 28, 30, 32, 34
+	};
+
+	static constexpr uint64_t Golden = 0x9E3779B97F4A7C15ULL;
+
+	/* SplitMix64 finalizer. */
+	static inline uint64_t mix(uint64_t value)
 	{
-		for(int idx = 0; idx < Guid::GUID_SIZE; idx++) {
-			this->_bytes[idx] = this->random();
+		value = (value ^ (value >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+		value = (value ^ (value >> 27U)) * 0x94D049BB133111EBULL;
+
+		return value ^ (value >> 31U);
+	}
+
+	static void random_bytes(uint8_t *output, size_t length)
+	{
+#ifdef HAVE_RANDOM_BYTES
+		if(lwiot_random_bytes(output, length) == -EOK)
+			return;
+#endif
+
+		static Atomic<uint64_t> counter(0);
+		static const uint64_t seed = mix((static_cast<uint64_t>(rand()) << 32U) ^ static_cast<uint64_t>(rand()) ^
+			Clock::now() ^ reinterpret_cast<uintptr_t>(&counter));
+
+		while(length > 0) {
+			auto value = mix(seed + counter.fetch_add(Golden, memory_order_relaxed));
+			auto num = length < sizeof(value) ? length : sizeof(value);
+
+			memcpy(output, &value, num);
+			output += num;
+			length -= num;
 		}
 	}
 
+	Guid::Guid()
+	{
+		random_bytes(this->_bytes, Guid::GUID_SIZE);
+
+		this->_bytes[6] = (this->_bytes[6] & 0x0F) | 0x40;
+		this->_bytes[8] = (this->_bytes[8] & 0x3F) | 0x80;
+	}
+
+	Guid::Guid(const uint8_t *bytes)
+	{
+		memcpy(this->_bytes, bytes, Guid::GUID_SIZE);
+	}
+
 	Guid::Guid(const lwiot::Guid &other)
 	{
 		memcpy(this->_bytes, other._bytes, Guid::GUID_SIZE);
@@ -44,81 +123,146 @@ namespace lwiot
 		return *this;
 	}
 
-	bool Guid::operator==(const lwiot::Guid &other)
+	bool Guid::operator==(const lwiot::Guid &other) const
 	{
 		return memcmp(this->_bytes, other._bytes, Guid::GUID_SIZE) == 0;
 	}
 
-	bool Guid::operator==(const lwiot::String &str)
+	bool Guid::operator==(const StringView &str) const
+	{
+		Guid other(this->_bytes);
+
+		return Guid::parse(str, other) && *this == other;
+	}
+
+	bool Guid::operator!=(const lwiot::Guid &other) const
 	{
-		return this->toString() == str;
+		return !(*this == other);
 	}
 
-	bool Guid::operator!=(const lwiot::Guid &other)
+	bool Guid::operator!=(const StringView &other) const
 	{
 		return !(*this == other);
 	}
 
-	bool Guid::operator!=(const lwiot::String &other)
+	bool Guid::operator<(const Guid &other) const
 	{
-		return this->toString() != other;
+		return memcmp(this->_bytes, other._bytes, Guid::GUID_SIZE) < 0;
 	}
 
-	uint8_t Guid::randomBit() const
+	Guid Guid::v4()
 	{
-		return rand() & 0x1;
+		return Guid();
 	}
 
-	uint8_t Guid::improveRandomBit() const
+	Guid Guid::v7()
 	{
-		int x;
+		static Atomic<uint64_t> last(0);
 
-		while(true) {
-			x = this->randomBit();
-			x |= this->randomBit() << 1;
+		/*
+		 * The time in milliseconds followed by a 12 bit counter. The counter keeps GUIDs that are
+		 * created within the same millisecond in order; it overflows into the time.
+		 */
+		auto now = static_cast<uint64_t>(time(nullptr)) * 1000ULL << 12U;
+		auto current = last.load(memory_order_relaxed);
+		uint64_t next;
 
-			if(x == 1)
-				return 0;
+		do {
+			next = current + 1 > now ? current + 1 : now;
+		} while(!last.compare_exchange_weak(current, next, memory_order_relaxed));
 
-			if(x == 2)
-				return 1;
-		}
+		Guid guid;
+
+		guid.stamp(static_cast<int64_t>(next >> 12U), static_cast<uint16_t>(next & 0xFFF));
+		return guid;
+	}
+
+	Guid Guid::v7(int64_t ms)
+	{
+		Guid guid;
+
+		guid.stamp(ms, static_cast<uint16_t>((guid._bytes[6] << 8U) | guid._bytes[7]));
+		return guid;
+	}
+
+	void Guid::stamp(int64_t ms, uint16_t counter)
+	{
+		for(int idx = 0; idx < 6; idx++)
+			this->_bytes[idx] = static_cast<uint8_t>(ms >> (40 - idx * 8));
+
+		this->_bytes[6] = 0x70 | ((counter >> 8U) & 0x0F);
+		this->_bytes[7] = static_cast<uint8_t>(counter);
 	}
 
-	uint8_t Guid::random() const
+	bool Guid::parse(const StringView &text, Guid &guid)
 	{
-		uint8_t result;
+		auto data = text.data();
+		uint8_t bytes[Guid::GUID_SIZE];
+
+		if(text.length() != Guid::STRING_LENGTH)
+			return false;
 
-		result = 0;
-		for(uint8_t idx = 8; idx--;) {
-			result += result + randomBit();
+		if(data[8] != '-' || data[13] != '-' || data[18] != '-' || data[23] != '-')
+			return false;
+
+		for(int idx = 0; idx < Guid::GUID_SIZE; idx++) {
+			auto high = static_cast<uint8_t>(data[text_offsets[idx]]);
+			auto low = static_cast<uint8_t>(data[text_offsets[idx] + 1]);
+
+			if((high | low) & 0x80)
+				return false;
+
+			high = hex_nibbles[high];
+			low = hex_nibbles[low];
+
+			if((high | low) & 0xF0)
+				return false;
+
+			bytes[idx] = static_cast<uint8_t>((high << 4U) | low);
 		}
 
-		return result;
+		memcpy(guid._bytes, bytes, Guid::GUID_SIZE);
+		return true;
+	}
+
+	char *Guid::formatTo(char *output) const
+	{
+		for(int idx = 0; idx < Guid::GUID_SIZE; idx++)
+			memcpy(&output[text_offsets[idx]], &hex_pairs[this->_bytes[idx] * 2], 2);
+
+		output[8] = output[13] = output[18] = output[23] = '-';
+		output[Guid::STRING_LENGTH] = '\0';
+
+		return output;
 	}
 
 	String Guid::toString() const
 	{
-		String string = "";
-		const char *hex = "0123456789abcdef";
+		char buffer[Guid::STRING_LENGTH + 1];
+
+		return String(this->formatTo(buffer));
+	}
+
+	int Guid::version() const
+	{
+		return this->_bytes[6] >> 4U;
+	}
 
-		for(int i = 0; i < Guid::GUID_SIZE; i++) {
-			if(i == 4)
-				string += "-";
-			if(i == 6)
-				string += "-";
-			if(i == 8)
-				string += "-";
-			if(i == 10)
-				string += "-";
+	int64_t Guid::timestamp() const
+	{
+		int64_t ms = 0;
 
-			auto top = this->_bytes[i] >> 4;
-			auto bottom = this->_bytes[i] & 0x0f;
+		if(this->version() != 7)
+			return -1;
 
-			string += hex[top];
-			string += hex[bottom];
-		}
+		for(int idx = 0; idx < 6; idx++)
+			ms = (ms << 8) | this->_bytes[idx];
 
-		return string;
+		return ms;
+	}
+
+	const uint8_t *Guid::bytes() const
+	{
+		return this->_bytes;
 	}
 }
@@ -0,0 +1,182 @@
+/*
+ * CBOR encoding of JSON documents.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/util/cbor.h>
+#include <lwiot/util/json.h>
+
+namespace lwiot
+{
+	void serializeCbor(const JsonVariant& variant, CborWriter& writer)
+	{
+		if(variant.is<JsonArray&>()) {
+			auto& array = variant.as<JsonArray&>();
+
+			writer.beginArray(array.size());
+
+			for(auto& value : array)
+				serializeCbor(value, writer);
+		} else if(variant.is<JsonObject&>()) {
+			auto& object = variant.as<JsonObject&>();
+
+			writer.beginMap(object.size());
+
+			for(auto& pair : object) {
+				writer.write(pair.key);
+				serializeCbor(pair.value, writer);
+			}
+		} else if(variant.is<const char *>()) {
+			writer.write(variant.as<const char *>());
+		} else if(variant.is<bool>()) {
+			writer.write(variant.as<bool>());
+		} else if(variant.is<long>()) {
+			writer.write(variant.as<int64_t>());
+		} else if(variant.is<double>()) {
+			writer.write(variant.as<double>());
+		} else {
+			writer.writeNull();
+		}
+	}
+
+	void serializeCbor(const JsonVariant& variant, ByteBuffer& output)
+	{
+		CborWriter writer(output);
+		serializeCbor(variant, writer);
+	}
+
+	static const char *copy(JsonBuffer& buffer, const CborReader::Item& item)
+	{
+		auto length = static_cast<size_t>(item.value);
+		auto str = static_cast<char *>(buffer.alloc(length + 1));
+
+		if(str == nullptr)
+			return nullptr;
+
+		memcpy(str, item.data, length);
+		str[length] = '\0';
+
+		return str;
+	}
+
+	static bool parse(JsonBuffer& buffer, CborReader& reader, CborReader::Item& item, JsonVariant& result, size_t depth)
+	{
+		using Type = CborReader::Type;
+
+		while(item.type == Type::Tag) {
+			if(!reader.next(item))
+				return false;
+		}
+
+		switch(item.type) {
+		case Type::Unsigned:
+		case Type::Negative:
+			if(item.value > INT64_MAX)
+				return false;
+
+			result = JsonVariant(item.integer());
+			return true;
+
+		case Type::Float:
+			result = JsonVariant(item.number, 6);
+			return true;
+
+		case Type::Bool:
+			result = JsonVariant(item.value != 0);
+			return true;
+
+		case Type::Text: {
+			auto str = copy(buffer, item);
+
+			if(str == nullptr)
+				return false;
+
+			result = JsonVariant(str);
+			return true;
+		}
+
+		case Type::Bytes:
+		case Type::Null:
+		case Type::Undefined:
+			result = JsonVariant(static_cast<const char *>(nullptr));
+			return true;
+
+		case Type::Break:
+		case Type::Tag:
+			return false;
+
+		default:
+			break;
+		}
+
+		if(depth >= CONFIG_CBOR_NESTING)
+			return false;
+
+		CborReader::Item child;
+		JsonVariant value;
+		bool indefinite = item.indefinite;
+		uint64_t count = item.value;
+
+		if(item.type == Type::Array) {
+			auto& array = buffer.createArray();
+
+			for(uint64_t idx = 0; indefinite || idx < count; idx++) {
+				if(!reader.next(child))
+					return false;
+
+				if(indefinite && child.type == Type::Break)
+					break;
+
+				if(!parse(buffer, reader, child, value, depth + 1) || !array.add(value))
+					return false;
+			}
+
+			result = JsonVariant(array);
+			return array.success();
+		}
+
+		auto& object = buffer.createObject();
+
+		for(uint64_t idx = 0; indefinite || idx < count; idx++) {
+			if(!reader.next(child))
+				return false;
+
+			if(indefinite && child.type == Type::Break)
+				break;
+
+			if(child.type != Type::Text)
+				return false;
+
+			auto key = copy(buffer, child);
+
+			if(key == nullptr || !reader.next(child))
+				return false;
+
+			if(!parse(buffer, reader, child, value, depth + 1) || !object.set(key, value))
+				return false;
+		}
+
+		result = JsonVariant(object);
+		return object.success();
+	}
+
+	bool parseCbor(JsonBuffer& buffer, const void *data, size_t length, JsonVariant& result)
+	{
+		CborReader reader(data, length);
+		CborReader::Item item;
+
+		if(!reader.next(item) || !parse(buffer, reader, item, result, 0))
+			return false;
+
+		return reader.done();
+	}
+}
@@ -6,6 +6,7 @@
 // If you like this project, please add a star!
 
 #include <ArduinoJson/Internals/Comments.hpp>
+#include <ArduinoJson/Internals/Scanner.hpp>
 
 inline static const char *skipCStyleComment(const char *ptr) {
   ptr += 2;
@@ -31,7 +32,7 @@ const char *ArduinoJson::Internals::skipSpacesAndComments(const char *ptr) {
       case '\t':
       case '\r':
       case '\n':
-        ptr++;
+        ptr = scanSpaces(ptr + 1);
         continue;
       case '/':
         switch (ptr[1]) {
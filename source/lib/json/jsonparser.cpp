@@ -5,10 +5,13 @@
 // https://github.com/bblanchon/ArduinoJson
 // If you like this project, please add a star!
 
+#include <string.h>
+
 #include <ArduinoJson/Internals/JsonParser.hpp>
 
 #include <ArduinoJson/Internals/Comments.hpp>
 #include <ArduinoJson/Internals/Encoding.hpp>
+#include <ArduinoJson/Internals/Scanner.hpp>
 #include <ArduinoJson/JsonArray.hpp>
 #include <ArduinoJson/JsonBuffer.hpp>
 #include <ArduinoJson/JsonObject.hpp>
@@ -151,8 +154,16 @@ const char *JsonParser::parseString() {
 
   if (isQuote(c)) {  // quotes
     char stopChar = c;
+    readPtr++;
     for (;;) {
-      c = *++readPtr;
+      // copy the run up to the next quote, backslash or NUL in one go
+      const char *endPtr = scanString(readPtr, stopChar);
+      size_t length = static_cast<size_t>(endPtr - readPtr);
+      memmove(writePtr, readPtr, length);
+      writePtr += length;
+      readPtr = endPtr;
+
+      c = *readPtr;
       if (c == '\0') break;
 
       if (c == stopChar) {
@@ -160,13 +171,12 @@ const char *JsonParser::parseString() {
         break;
       }
 
-      if (c == '\\') {
-        // replace char
-        c = Encoding::unescapeChar(*++readPtr);
-        if (c == '\0') break;
-      }
+      // replace char
+      c = Encoding::unescapeChar(*++readPtr);
+      if (c == '\0') break;
 
       *writePtr++ = c;
+      readPtr++;
     }
   } else {  // no quotes
     for (;;) {
@@ -0,0 +1,531 @@
+/*
+ * Streaming JSON reader.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/error.h>
+#include <lwiot/stream.h>
+#include <lwiot/util/jsonreader.h>
+
+namespace lwiot
+{
+	JsonReader::JsonReader(Stream &input) : _input(&input), _data(_buffer), _pos(0), _length(0), _token_length(0),
+		_depth(0), _pending(Event::End), _first(false), _started(false), _error(false), _truncated(false)
+	{
+		this->_token[0] = '\0';
+	}
+
+	JsonReader::JsonReader(const void *json, size_t length) : _input(nullptr), _data(static_cast<const char *>(json)),
+		_pos(0), _length(length), _token_length(0), _depth(0), _pending(Event::End), _first(false), _started(false),
+		_error(false), _truncated(false)
+	{
+		this->_token[0] = '\0';
+	}
+
+	int JsonReader::peek()
+	{
+		if(this->_pos == this->_length) {
+			if(this->_input == nullptr)
+				return -1;
+
+			/* Only ask for what is there, so that a socket does not block on the end of the document. */
+			auto length = this->_input->available();
+
+			if(length == 0)
+				length = 1;
+			else if(length > sizeof(this->_buffer))
+				length = sizeof(this->_buffer);
+
+			auto rv = this->_input->read(this->_buffer, length);
+
+			if(rv <= 0)
+				return -1;
+
+			this->_pos = 0;
+			this->_length = static_cast<size_t>(rv);
+		}
+
+		return static_cast<uint8_t>(this->_data[this->_pos]);
+	}
+
+	int JsonReader::get()
+	{
+		auto c = this->peek();
+
+		if(c >= 0)
+			this->_pos++;
+
+		return c;
+	}
+
+	int JsonReader::space()
+	{
+		int c;
+
+		while((c = this->peek()) == ' ' || c == '\t' || c == '\r' || c == '\n')
+			this->_pos++;
+
+		return c;
+	}
+
+	JsonReader::Event JsonReader::fail()
+	{
+		this->_error = true;
+		return Event::Error;
+	}
+
+	JsonReader::Event JsonReader::next()
+	{
+		if(this->_error)
+			return Event::Error;
+
+		if(this->_pending != Event::End) {
+			if(this->_depth == CONFIG_JSON_READER_NESTING)
+				return this->fail();
+
+			auto& level = this->_levels[this->_depth];
+
+			if(this->_depth > 0) {
+				auto& parent = this->_levels[this->_depth - 1];
+				level.key = static_cast<uint16_t>(parent.key + parent.length);
+			} else {
+				level.key = 0;
+			}
+
+			level.length = 0;
+			level.index = 0;
+			level.array = this->_pending == Event::BeginArray;
+
+			this->_depth++;
+			this->_first = true;
+			this->_pending = Event::End;
+		}
+
+		if(this->_depth == 0) {
+			if(this->_started)
+				return Event::End;
+
+			this->_started = true;
+
+			if(this->space() < 0)
+				return this->fail();
+
+			return this->value();
+		}
+
+		auto& level = this->_levels[this->_depth - 1];
+		auto c = this->space();
+
+		if(c == (level.array ? ']' : '}')) {
+			this->_pos++;
+			this->_depth--;
+			this->_first = false;
+
+			return level.array ? Event::EndArray : Event::EndObject;
+		}
+
+		if(!this->_first) {
+			if(c != ',')
+				return this->fail();
+
+			this->_pos++;
+			this->space();
+
+			if(level.array)
+				level.index++;
+		}
+
+		this->_first = false;
+
+		if(!level.array) {
+			if(!this->key(level) || this->space() != ':')
+				return this->fail();
+
+			this->_pos++;
+			this->space();
+		}
+
+		return this->value();
+	}
+
+	JsonReader::Event JsonReader::value()
+	{
+		auto c = this->peek();
+
+		this->_token_length = 0;
+		this->_token[0] = '\0';
+
+		switch(c) {
+		case '{':
+			this->_pos++;
+			this->_pending = Event::BeginObject;
+			return Event::BeginObject;
+
+		case '[':
+			this->_pos++;
+			this->_pending = Event::BeginArray;
+			return Event::BeginArray;
+
+		case '"':
+			this->_pos++;
+
+			if(!this->string(this->_token, CONFIG_JSON_READER_TOKEN, this->_token_length))
+				return this->fail();
+
+			this->_token[this->_token_length] = '\0';
+			return Event::String;
+
+		case 't':
+			return this->literal("true") ? Event::Bool : this->fail();
+
+		case 'f':
+			return this->literal("false") ? Event::Bool : this->fail();
+
+		case 'n':
+			return this->literal("null") ? Event::Null : this->fail();
+
+		default:
+			break;
+		}
+
+		if(c != '-' && (c < '0' || c > '9'))
+			return this->fail();
+
+		while(c >= 0 && (strchr("0123456789+-.eE", c) != nullptr)) {
+			if(this->_token_length == CONFIG_JSON_READER_TOKEN)
+				return this->fail();
+
+			this->_token[this->_token_length++] = static_cast<char>(c);
+			this->_pos++;
+			c = this->peek();
+		}
+
+		this->_token[this->_token_length] = '\0';
+
+		char *end;
+		strtod(this->_token, &end);
+
+		if(end != this->_token + this->_token_length)
+			return this->fail();
+
+		return Event::Number;
+	}
+
+	bool JsonReader::literal(const char *text)
+	{
+		for(auto ptr = text; *ptr != '\0'; ptr++) {
+			if(this->get() != *ptr)
+				return false;
+
+			this->_token[this->_token_length++] = *ptr;
+		}
+
+		this->_token[this->_token_length] = '\0';
+		return true;
+	}
+
+	bool JsonReader::key(Level &level)
+	{
+		size_t length = 0;
+
+		if(this->get() != '"')
+			return false;
+
+		if(!this->string(this->_path + level.key, CONFIG_JSON_READER_PATH - level.key, length))
+			return false;
+
+		level.length = static_cast<uint16_t>(length);
+		return true;
+	}
+
+	void JsonReader::append(char *output, size_t capacity, size_t &length, char c)
+	{
+		if(length < capacity)
+			output[length++] = c;
+		else
+			this->_truncated = true;
+	}
+
+	bool JsonReader::string(char *output, size_t capacity, size_t &length)
+	{
+		for(;;) {
+			auto c = this->get();
+
+			/* The end of the input, or a control character. */
+			if(c < ' ')
+				return false;
+
+			if(c == '"')
+				return true;
+
+			if(c == '\\') {
+				if(!this->escape(output, capacity, length))
+					return false;
+
+				continue;
+			}
+
+			this->append(output, capacity, length, static_cast<char>(c));
+		}
+	}
+
+	bool JsonReader::hex(uint32_t &value)
+	{
+		value = 0;
+
+		for(int idx = 0; idx < 4; idx++) {
+			auto c = this->get();
+
+			if(c >= '0' && c <= '9')
+				c -= '0';
+			else if(c >= 'a' && c <= 'f')
+				c -= 'a' - 10;
+			else if(c >= 'A' && c <= 'F')
+				c -= 'A' - 10;
+			else
+				return false;
+
+			value = value << 4 | static_cast<uint32_t>(c);
+		}
+
+		return true;
+	}
+
+	bool JsonReader::escape(char *output, size_t capacity, size_t &length)
+	{
+		uint32_t code;
+		auto c = this->get();
+
+		switch(c) {
+		case '"':
+		case '\\':
+		case '/':
+			this->append(output, capacity, length, static_cast<char>(c));
+			return true;
+
+		case 'b':
+			this->append(output, capacity, length, '\b');
+			return true;
+
+		case 'f':
+			this->append(output, capacity, length, '\f');
+			return true;
+
+		case 'n':
+			this->append(output, capacity, length, '\n');
+			return true;
+
+		case 'r':
+			this->append(output, capacity, length, '\r');
+			return true;
+
+		case 't':
+			this->append(output, capacity, length, '\t');
+			return true;
+
+		case 'u':
+			break;
+
+		default:
+			return false;
+		}
+
+		if(!this->hex(code))
+			return false;
+
+		/* Characters outside of the basic plane are written as a surrogate pair. */
+		if(code >= 0xD800 && code < 0xDC00) {
+			uint32_t low;
+
+			if(this->get() != '\\' || this->get() != 'u' || !this->hex(low) || low < 0xDC00 || low > 0xDFFF)
+				return false;
+
+			code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+		}
+
+		if(code < 0x80) {
+			this->append(output, capacity, length, static_cast<char>(code));
+		} else if(code < 0x800) {
+			this->append(output, capacity, length, static_cast<char>(0xC0 | code >> 6));
+			this->append(output, capacity, length, static_cast<char>(0x80 | (code & 0x3F)));
+		} else if(code < 0x10000) {
+			this->append(output, capacity, length, static_cast<char>(0xE0 | code >> 12));
+			this->append(output, capacity, length, static_cast<char>(0x80 | (code >> 6 & 0x3F)));
+			this->append(output, capacity, length, static_cast<char>(0x80 | (code & 0x3F)));
+		} else {
+			this->append(output, capacity, length, static_cast<char>(0xF0 | code >> 18));
+			this->append(output, capacity, length, static_cast<char>(0x80 | (code >> 12 & 0x3F)));
+			this->append(output, capacity, length, static_cast<char>(0x80 | (code >> 6 & 0x3F)));
+			this->append(output, capacity, length, static_cast<char>(0x80 | (code & 0x3F)));
+		}
+
+		return true;
+	}
+
+	bool JsonReader::skip()
+	{
+		if(this->_pending == Event::End)
+			return true;
+
+		auto depth = this->_depth;
+
+		for(;;) {
+			auto event = this->next();
+
+			if(event == Event::Error || event == Event::End)
+				return false;
+
+			if((event == Event::EndObject || event == Event::EndArray) && this->_depth == depth)
+				return true;
+		}
+	}
+
+	ssize_t JsonReader::select(const StringView &path, const Visitor &visitor)
+	{
+		ssize_t count = 0;
+
+		for(;;) {
+			auto event = this->next();
+
+			switch(event) {
+			case Event::Error:
+				return -EINVALID;
+
+			case Event::End:
+				return count;
+
+			case Event::EndObject:
+			case Event::EndArray:
+				continue;
+
+			default:
+				break;
+			}
+
+			if(!this->matches(path))
+				continue;
+
+			count++;
+
+			if(!visitor(*this, event))
+				return count;
+		}
+	}
+
+	bool JsonReader::matches(const StringView &path) const
+	{
+		auto ptr = path.begin();
+		auto end = path.end();
+
+		if(ptr != end && *ptr == '$')
+			ptr++;
+
+		for(size_t idx = 0; idx < this->_depth; idx++) {
+			auto& level = this->_levels[idx];
+			const char *start;
+
+			if(ptr == end)
+				return false;
+
+			if(*ptr == '.') {
+				start = ++ptr;
+
+				while(ptr != end && *ptr != '.' && *ptr != '[')
+					ptr++;
+			} else if(*ptr == '[') {
+				start = ++ptr;
+
+				while(ptr != end && *ptr != ']')
+					ptr++;
+
+				if(ptr == end)
+					return false;
+			} else {
+				return false;
+			}
+
+			StringView component(start, static_cast<size_t>(ptr - start));
+
+			if(*(start - 1) == '[')
+				ptr++;
+
+			if(component == "*")
+				continue;
+
+			if(level.array) {
+				if(*(start - 1) != '[' || component.size() == 0)
+					return false;
+
+				size_t index = 0;
+
+				for(auto c : component) {
+					if(c < '0' || c > '9')
+						return false;
+
+					index = index * 10 + static_cast<size_t>(c - '0');
+				}
+
+				if(index != level.index)
+					return false;
+			} else if(*(start - 1) != '.' || component != StringView(this->_path + level.key, level.length)) {
+				return false;
+			}
+		}
+
+		return ptr == end;
+	}
+
+	StringView JsonReader::key() const
+	{
+		if(this->_depth == 0)
+			return StringView();
+
+		auto& level = this->_levels[this->_depth - 1];
+
+		if(level.array)
+			return StringView();
+
+		return StringView(this->_path + level.key, level.length);
+	}
+
+	size_t JsonReader::index() const
+	{
+		if(this->_depth == 0)
+			return 0;
+
+		return this->_levels[this->_depth - 1].index;
+	}
+
+	size_t JsonReader::depth() const
+	{
+		return this->_depth;
+	}
+
+	StringView JsonReader::string() const
+	{
+		return StringView(this->_token, this->_token_length);
+	}
+
+	double JsonReader::number() const
+	{
+		return strtod(this->_token, nullptr);
+	}
+
+	int64_t JsonReader::integer() const
+	{
+		return strtoll(this->_token, nullptr, 10);
+	}
+
+	bool JsonReader::boolean() const
+	{
+		return this->_token[0] == 't';
+	}
+}
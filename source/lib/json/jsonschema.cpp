@@ -0,0 +1,347 @@
+/*
+ * Compiled JSON bindings for plain structures.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stream.h>
+#include <lwiot/util/jsonreader.h>
+#include <lwiot/util/jsonschema.h>
+#include <lwiot/util/numberformat.h>
+
+#include <ArduinoJson/Arduino/StreamPrinter.hpp>
+#include <ArduinoJson/Internals/DynamicStringBuilder.hpp>
+#include <ArduinoJson/Internals/Encoding.hpp>
+
+namespace lwiot
+{
+	typedef JsonReader::Event Event;
+
+	static uint32_t hash(const StringView& key)
+	{
+		uint32_t hash = 2166136261U;
+
+		for(auto c : key)
+			hash = (hash ^ static_cast<uint8_t>(c)) * 16777619U;
+
+		return hash;
+	}
+
+	const JsonSchema::Field *JsonSchema::find(const StringView &key) const
+	{
+		auto code = hash(key);
+
+		for(size_t idx = 0; idx < this->_count; idx++) {
+			auto& field = this->_fields[idx];
+
+			if(field.hash == code && key == field.name)
+				return &field;
+		}
+
+		return nullptr;
+	}
+
+	/* Store an integer in a field of \p width bytes; the field does not have to be aligned. */
+	static void store(uint8_t *ptr, size_t width, int64_t value)
+	{
+		switch(width) {
+		case 1: {
+			auto narrow = static_cast<int8_t>(value);
+			memcpy(ptr, &narrow, sizeof(narrow));
+			break;
+		}
+
+		case 2: {
+			auto narrow = static_cast<int16_t>(value);
+			memcpy(ptr, &narrow, sizeof(narrow));
+			break;
+		}
+
+		case 4: {
+			auto narrow = static_cast<int32_t>(value);
+			memcpy(ptr, &narrow, sizeof(narrow));
+			break;
+		}
+
+		default:
+			memcpy(ptr, &value, sizeof(value));
+			break;
+		}
+	}
+
+	static int64_t load(const uint8_t *ptr, size_t width, bool sign)
+	{
+		switch(width) {
+		case 1: {
+			uint8_t value;
+			memcpy(&value, ptr, sizeof(value));
+			return sign ? static_cast<int8_t>(value) : value;
+		}
+
+		case 2: {
+			uint16_t value;
+			memcpy(&value, ptr, sizeof(value));
+			return sign ? static_cast<int16_t>(value) : value;
+		}
+
+		case 4: {
+			uint32_t value;
+			memcpy(&value, ptr, sizeof(value));
+			return sign ? static_cast<int32_t>(value) : static_cast<int64_t>(value);
+		}
+
+		default: {
+			int64_t value;
+			memcpy(&value, ptr, sizeof(value));
+			return value;
+		}
+		}
+	}
+
+	static bool read_value(const JsonSchema::Field& field, JsonReader& reader, Event event, uint8_t *ptr)
+	{
+		if(event == Event::Null)
+			return true;
+
+		switch(field.type) {
+		case JsonSchema::Type::Bool:
+			if(event != Event::Bool)
+				return false;
+
+			*reinterpret_cast<bool *>(ptr) = reader.boolean();
+			return true;
+
+		case JsonSchema::Type::Signed:
+		case JsonSchema::Type::Unsigned:
+			if(event != Event::Number)
+				return false;
+
+			store(ptr, field.width, field.type == JsonSchema::Type::Unsigned ?
+				static_cast<int64_t>(strtoull(reader.string().data(), nullptr, 10)) : reader.integer());
+			return true;
+
+		case JsonSchema::Type::Float:
+			if(event != Event::Number)
+				return false;
+
+			if(field.width == sizeof(float)) {
+				auto value = static_cast<float>(reader.number());
+				memcpy(ptr, &value, sizeof(value));
+			} else {
+				auto value = reader.number();
+				memcpy(ptr, &value, sizeof(value));
+			}
+
+			return true;
+
+		case JsonSchema::Type::String: {
+			if(event != Event::String)
+				return false;
+
+			auto value = reader.string();
+			auto length = value.size() < field.width - 1 ? value.size() : field.width - 1;
+
+			memcpy(ptr, value.data(), length);
+			ptr[length] = '\0';
+			return true;
+		}
+
+		case JsonSchema::Type::Object:
+			return event == Event::BeginObject && field.schema().read(reader, ptr, false);
+		}
+
+		return false;
+	}
+
+	static bool read_field(const JsonSchema::Field& field, JsonReader& reader, Event event, uint8_t *ptr)
+	{
+		if(field.count == 0 || event == Event::Null)
+			return read_value(field, reader, event, ptr);
+
+		if(event != Event::BeginArray)
+			return false;
+
+		/* Elements that do not fit are skipped. */
+		for(size_t idx = 0; ; idx++) {
+			event = reader.next();
+
+			if(event == Event::EndArray)
+				return true;
+
+			if(idx < field.count) {
+				if(!read_value(field, reader, event, ptr + idx * field.width))
+					return false;
+			} else if(event == Event::Error || event == Event::End || !reader.skip()) {
+				return false;
+			}
+		}
+	}
+
+	bool JsonSchema::read(JsonReader &reader, void *object, bool begin) const
+	{
+		auto base = static_cast<uint8_t *>(object);
+
+		if(begin && reader.next() != Event::BeginObject)
+			return false;
+
+		for(;;) {
+			auto event = reader.next();
+
+			if(event == Event::EndObject)
+				return true;
+
+			if(event == Event::Error || event == Event::End)
+				return false;
+
+			auto field = this->find(reader.key());
+
+			if(field == nullptr) {
+				if(!reader.skip())
+					return false;
+
+				continue;
+			}
+
+			if(!read_field(*field, reader, event, base + field->offset))
+				return false;
+		}
+	}
+
+	/* Strings need not be terminated when they fill their field. */
+	static size_t write_string(json::Printer& output, const char *value, size_t width)
+	{
+		size_t n = output.write('"');
+
+		for(size_t idx = 0; idx < width && value[idx] != '\0'; ) {
+			auto start = idx;
+
+			while(idx < width && value[idx] != '\0' && !ArduinoJson::Internals::Encoding::escapeChar(value[idx]) &&
+				static_cast<uint8_t>(value[idx]) >= ' ')
+				idx++;
+
+			if(idx != start)
+				n += output.write(reinterpret_cast<const uint8_t *>(value + start), idx - start);
+
+			if(idx == width || value[idx] == '\0')
+				break;
+
+			auto special = ArduinoJson::Internals::Encoding::escapeChar(value[idx]);
+			char escaped[8];
+
+			if(special)
+				snprintf(escaped, sizeof(escaped), "\\%c", special);
+			else
+				snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<uint8_t>(value[idx]));
+
+			n += output.print(escaped);
+			idx++;
+		}
+
+		return n + output.write('"');
+	}
+
+	static size_t write_value(const JsonSchema::Field& field, json::Printer& output, const uint8_t *ptr)
+	{
+		char buffer[NumberFormat::DecimalBufferSize];
+
+		switch(field.type) {
+		case JsonSchema::Type::Bool:
+			return output.print(*reinterpret_cast<const bool *>(ptr) ? "true" : "false");
+
+		case JsonSchema::Type::Signed:
+			NumberFormat::formatSigned(buffer, load(ptr, field.width, true));
+			return output.print(buffer);
+
+		case JsonSchema::Type::Unsigned:
+			NumberFormat::formatUnsigned(buffer, static_cast<uint64_t>(load(ptr, field.width, false)));
+			return output.print(buffer);
+
+		case JsonSchema::Type::Float: {
+			double value;
+
+			if(field.width == sizeof(float)) {
+				float narrow;
+
+				memcpy(&narrow, ptr, sizeof(narrow));
+				value = narrow;
+				snprintf(buffer, sizeof(buffer), "%.7g", value);
+			} else {
+				memcpy(&value, ptr, sizeof(value));
+				snprintf(buffer, sizeof(buffer), "%.15g", value);
+			}
+
+			/* JSON has no representation for these. */
+			if(isnan(value) || isinf(value))
+				return output.print("null");
+
+			return output.print(buffer);
+		}
+
+		case JsonSchema::Type::String:
+			return write_string(output, reinterpret_cast<const char *>(ptr), field.width);
+
+		case JsonSchema::Type::Object:
+			return field.schema().write(output, ptr);
+		}
+
+		return 0;
+	}
+
+	size_t JsonSchema::write(json::Printer &output, const void *object) const
+	{
+		auto base = static_cast<const uint8_t *>(object);
+		size_t n = output.write('{');
+
+		for(size_t idx = 0; idx < this->_count; idx++) {
+			auto& field = this->_fields[idx];
+			auto ptr = base + field.offset;
+
+			if(idx > 0)
+				n += output.write(',');
+
+			n += write_string(output, field.name, strlen(field.name));
+			n += output.write(':');
+
+			if(field.count == 0) {
+				n += write_value(field, output, ptr);
+				continue;
+			}
+
+			n += output.write('[');
+
+			for(size_t num = 0; num < field.count; num++) {
+				if(num > 0)
+					n += output.write(',');
+
+				n += write_value(field, output, ptr + num * field.width);
+			}
+
+			n += output.write(']');
+		}
+
+		return n + output.write('}');
+	}
+
+	size_t writeJson(Stream &output, const JsonSchema &schema, const void *object)
+	{
+		json::StreamPrinter printer(output);
+		auto n = schema.write(printer, object);
+
+		return printer.flush() ? n : 0;
+	}
+
+	size_t writeJson(String &output, const JsonSchema &schema, const void *object)
+	{
+		ArduinoJson::Internals::DynamicStringBuilder builder(output);
+		return schema.write(builder, object);
+	}
+}
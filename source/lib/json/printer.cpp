@@ -7,27 +7,36 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <lwiot.h>
 #include <stdint.h>
 
+#include <lwiot/stream.h>
+
 #include <ArduinoJson/Arduino/Printer.hpp>
+#include <ArduinoJson/Arduino/StreamPrinter.hpp>
 
 namespace lwiot { namespace json
 {
 	Printer::Printer()
 	{ }
 
-	size_t Printer::print(const char *s)
+	size_t Printer::write(const uint8_t *buffer, size_t size)
 	{
 		size_t n = 0;
 
-		while(*s) {
-			n += this->write(*s++);
+		while(size--) {
+			n += this->write(*buffer++);
 		}
 
 		return n;
 	}
 
+	size_t Printer::print(const char *s)
+	{
+		return this->write(reinterpret_cast<const uint8_t *>(s), strlen(s));
+	}
+
 	size_t Printer::print(ArduinoJson::Internals::JsonFloat value, int digits /* = 2 */)
 	{
 		char tmp[32];
@@ -70,5 +79,63 @@ namespace lwiot { namespace json
 	{
 		return write('\r') + write('\n');
 	}
+
+	BufferedPrinter::BufferedPrinter() : _length(0), _failed(false)
+	{ }
+
+	size_t BufferedPrinter::write(uint8_t c)
+	{
+		if(this->_length == sizeof(this->_buffer) && !this->flush())
+			return 0;
+
+		this->_buffer[this->_length++] = c;
+		return 1;
+	}
+
+	size_t BufferedPrinter::write(const uint8_t *buffer, size_t size)
+	{
+		size_t n = 0;
+
+		while(n < size) {
+			if(this->_length == sizeof(this->_buffer) && !this->flush())
+				break;
+
+			auto length = sizeof(this->_buffer) - this->_length;
+
+			if(length > size - n)
+				length = size - n;
+
+			memcpy(this->_buffer + this->_length, buffer + n, length);
+			this->_length += length;
+			n += length;
+		}
+
+		return n;
+	}
+
+	bool BufferedPrinter::flush()
+	{
+		if(this->_failed)
+			return false;
+
+		if(this->_length > 0 && !this->emit(this->_buffer, this->_length))
+			this->_failed = true;
+
+		this->_length = 0;
+		return !this->_failed;
+	}
+
+	StreamPrinter::StreamPrinter(Stream &stream) : _stream(stream)
+	{ }
+
+	StreamPrinter::~StreamPrinter()
+	{
+		this->flush();
+	}
+
+	bool StreamPrinter::emit(const uint8_t *data, size_t length)
+	{
+		return this->_stream.write(data, length) == static_cast<ssize_t>(length);
+	}
 }
 }
@@ -0,0 +1,72 @@
+/*
+ * JSON encoding of sample batches.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/util/json.h>
+#include <lwiot/util/numberformat.h>
+#include <lwiot/util/samplebatch.h>
+
+namespace lwiot
+{
+	template <typename Func>
+	static void array(ByteBuffer& output, const char *key, size_t size, Func&& format)
+	{
+		char number[NumberFormat::DecimalBufferSize];
+
+		output.write(key, strlen(key));
+
+		for(size_t idx = 0; idx < size; idx++) {
+			if(idx > 0)
+				output.write(',');
+
+			output.write(number, format(number, idx));
+		}
+
+		output.write(']');
+	}
+
+	size_t serializeJson(const SampleBatch& batch, ByteBuffer& output, uint8_t precision)
+	{
+		char number[NumberFormat::DecimalBufferSize];
+		auto start = output.index();
+		auto size = batch.size();
+		auto timestamps = batch.timestamps();
+		auto sensors = batch.sensors();
+		auto values = batch.values();
+		auto base = static_cast<int64_t>(size > 0 ? timestamps[0] : 0);
+
+		output.write("{\"t\":", 5);
+		output.write(number, NumberFormat::formatSigned(number, base));
+
+		array(output, ",\"dt\":[", size, [&](char *out, size_t idx) {
+			return NumberFormat::formatSigned(out, static_cast<int64_t>(timestamps[idx]) - base);
+		});
+
+		array(output, ",\"s\":[", size, [&](char *out, size_t idx) {
+			return NumberFormat::formatUnsigned(out, sensors[idx]);
+		});
+
+		array(output, ",\"v\":[", size, [&](char *out, size_t idx) -> size_t {
+			if(!isfinite(values[idx])) {
+				memcpy(out, "null", 5);
+				return 4;
+			}
+
+			return NumberFormat::formatFloat(out, values[idx], precision);
+		});
+
+		output.write('}');
+		return output.index() - start;
+	}
+}
@@ -0,0 +1,154 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#include <stdint.h>
+
+#include <ArduinoJson/Internals/Scanner.hpp>
+
+// The vectorized scanners test 16 characters at a time. Loads are aligned to
+// 16 bytes, so they never cross a page boundary: reading past the terminating
+// NUL is harmless, but the address sanitizer has to be told so.
+#if defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#define JSON_SCAN_SSE2
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define JSON_SCAN_NEON
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#define JSON_NO_SANITIZE __attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define JSON_NO_SANITIZE __attribute__((no_sanitize_address))
+#endif
+#endif
+
+#ifndef JSON_NO_SANITIZE
+#define JSON_NO_SANITIZE
+#endif
+
+using namespace ArduinoJson::Internals;
+
+#if defined(JSON_SCAN_SSE2)
+
+// Scans from the 16 byte block holding ptr until matches() finds something.
+// Matches in front of ptr are masked out of the first block.
+template <typename TMatcher>
+JSON_NO_SANITIZE inline static const char *scanBlocks(const char *ptr,
+                                                      TMatcher matches) {
+  uintptr_t offset = reinterpret_cast<uintptr_t>(ptr) & 15;
+  const char *block = ptr - offset;
+  unsigned mask = matches(_mm_load_si128(
+                      reinterpret_cast<const __m128i *>(block))) &
+                  (0xFFFFu << offset);
+
+  while (mask == 0) {
+    block += 16;
+    mask = matches(_mm_load_si128(reinterpret_cast<const __m128i *>(block)));
+  }
+
+  return block + __builtin_ctz(mask);
+}
+
+const char *ArduinoJson::Internals::scanString(const char *ptr, char quote) {
+  const __m128i quotes = _mm_set1_epi8(quote);
+  const __m128i slashes = _mm_set1_epi8('\\');
+  const __m128i zeros = _mm_setzero_si128();
+
+  return scanBlocks(ptr, [&](__m128i chars) -> unsigned {
+    __m128i found = _mm_or_si128(_mm_cmpeq_epi8(chars, quotes),
+                                 _mm_cmpeq_epi8(chars, slashes));
+    found = _mm_or_si128(found, _mm_cmpeq_epi8(chars, zeros));
+    return static_cast<unsigned>(_mm_movemask_epi8(found));
+  });
+}
+
+const char *ArduinoJson::Internals::scanSpaces(const char *ptr) {
+  const __m128i spaces = _mm_set1_epi8(' ');
+  const __m128i tabs = _mm_set1_epi8('\t');
+  const __m128i returns = _mm_set1_epi8('\r');
+  const __m128i newlines = _mm_set1_epi8('\n');
+
+  return scanBlocks(ptr, [&](__m128i chars) -> unsigned {
+    __m128i found = _mm_or_si128(_mm_cmpeq_epi8(chars, spaces),
+                                 _mm_cmpeq_epi8(chars, tabs));
+    found = _mm_or_si128(found, _mm_cmpeq_epi8(chars, returns));
+    found = _mm_or_si128(found, _mm_cmpeq_epi8(chars, newlines));
+    return ~static_cast<unsigned>(_mm_movemask_epi8(found)) & 0xFFFFu;
+  });
+}
+
+#elif defined(JSON_SCAN_NEON)
+
+// NEON has no movemask: narrowing the comparison result gives a 64 bit mask
+// with four bits for every character instead.
+static inline uint64_t toMask(uint8x16_t found) {
+  uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(found), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+}
+
+template <typename TMatcher>
+JSON_NO_SANITIZE inline static const char *scanBlocks(const char *ptr,
+                                                      TMatcher matches) {
+  uintptr_t offset = reinterpret_cast<uintptr_t>(ptr) & 15;
+  const char *block = ptr - offset;
+  uint64_t mask = matches(vld1q_u8(reinterpret_cast<const uint8_t *>(block))) &
+                  (~0ULL << (offset * 4));
+
+  while (mask == 0) {
+    block += 16;
+    mask = matches(vld1q_u8(reinterpret_cast<const uint8_t *>(block)));
+  }
+
+  return block + __builtin_ctzll(mask) / 4;
+}
+
+const char *ArduinoJson::Internals::scanString(const char *ptr, char quote) {
+  const uint8x16_t quotes = vdupq_n_u8(static_cast<uint8_t>(quote));
+  const uint8x16_t slashes = vdupq_n_u8('\\');
+
+  return scanBlocks(ptr, [&](uint8x16_t chars) -> uint64_t {
+    uint8x16_t found =
+        vorrq_u8(vceqq_u8(chars, quotes), vceqq_u8(chars, slashes));
+    return toMask(vorrq_u8(found, vceqzq_u8(chars)));
+  });
+}
+
+const char *ArduinoJson::Internals::scanSpaces(const char *ptr) {
+  const uint8x16_t spaces = vdupq_n_u8(' ');
+  const uint8x16_t tabs = vdupq_n_u8('\t');
+  const uint8x16_t returns = vdupq_n_u8('\r');
+  const uint8x16_t newlines = vdupq_n_u8('\n');
+
+  return scanBlocks(ptr, [&](uint8x16_t chars) -> uint64_t {
+    uint8x16_t found = vorrq_u8(vceqq_u8(chars, spaces), vceqq_u8(chars, tabs));
+    found = vorrq_u8(found, vceqq_u8(chars, returns));
+    found = vorrq_u8(found, vceqq_u8(chars, newlines));
+    return toMask(vmvnq_u8(found));
+  });
+}
+
+#else
+
+const char *ArduinoJson::Internals::scanString(const char *ptr, char quote) {
+  for (;;) {
+    char c = *ptr;
+    if (c == quote || c == '\\' || c == '\0') return ptr;
+    ptr++;
+  }
+}
+
+const char *ArduinoJson::Internals::scanSpaces(const char *ptr) {
+  for (;;) {
+    char c = *ptr;
+    if (c != ' ' && c != '\t' && c != '\r' && c != '\n') return ptr;
+    ptr++;
+  }
+}
+
+#endif
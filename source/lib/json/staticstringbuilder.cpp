@@ -7,6 +7,8 @@
 
 #include <ArduinoJson/Internals/StaticStringBuilder.hpp>
 
+#include <string.h>
+
 using namespace ArduinoJson::Internals;
 
 size_t StaticStringBuilder::write(uint8_t c) {
@@ -16,3 +18,12 @@ size_t StaticStringBuilder::write(uint8_t c) {
   buffer[length] = '\0';
   return 1;
 }
+
+size_t StaticStringBuilder::write(const uint8_t *data, size_t size) {
+  if (size > capacity - length) size = capacity - length;
+
+  memcpy(buffer + length, data, size);
+  length += size;
+  buffer[length] = '\0';
+  return size;
+}
@@ -0,0 +1,559 @@
+/*
+ * Log-structured key-value store.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/error.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/stl/move.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/device/eeprom24c02.h>
+#include <lwiot/device/sram23k256.h>
+#include <lwiot/util/keyvaluestore.h>
+
+#define SECTOR_MAGIC0 'K'
+#define SECTOR_MAGIC1 'V'
+#define RECORD_MAGIC  0xA5
+
+#define TOMBSTONE     0xFFFF
+
+namespace lwiot
+{
+	static constexpr size_t EepromSize = 256;
+	static constexpr size_t SramSize = 32768;
+
+	/* CRC-16/CCITT */
+	static uint16_t crc16(uint16_t crc, const uint8_t *data, size_t length)
+	{
+		for(size_t idx = 0; idx < length; idx++) {
+			crc ^= static_cast<uint16_t>(data[idx] << 8);
+
+			for(int bit = 0; bit < 8; bit++)
+				crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+		}
+
+		return crc;
+	}
+
+	/* Records are bound to the sequence number of their sector. */
+	static uint16_t checksum(uint32_t sequence, const uint8_t *header, const uint8_t *body, size_t length)
+	{
+		const uint8_t seq[] = {
+			static_cast<uint8_t>(sequence >> 24), static_cast<uint8_t>(sequence >> 16),
+			static_cast<uint8_t>(sequence >> 8), static_cast<uint8_t>(sequence)
+		};
+
+		/* Covers the key and value lengths in the record header. */
+		return crc16(crc16(crc16(0xFFFF, seq, sizeof(seq)), header + 1, 3), body, length);
+	}
+
+	KeyValueStore::KeyValueStore(size_t sectors, size_t sectorsize) :
+		_sectors(sectors), _sectorsize(sectorsize), _sequences(new uint32_t[sectors]), _stale(new size_t[sectors]),
+		_head(0), _head_offset(SectorHeader), _tail(0), _free(sectors), _next(1), _loaded(false), _compacting(false)
+	{
+		memset(this->_sequences, 0, sizeof(*this->_sequences) * sectors);
+		memset(this->_stale, 0, sizeof(*this->_stale) * sectors);
+	}
+
+	KeyValueStore::~KeyValueStore()
+	{
+		delete[] this->_sequences;
+		delete[] this->_stale;
+	}
+
+	/* Read the sector headers and replay every record into the index. Done once. */
+	void KeyValueStore::scan()
+	{
+		uint8_t header[SectorHeader];
+		bool found = false;
+
+		if(this->_loaded)
+			return;
+
+		this->_loaded = true;
+
+		for(size_t idx = 0; idx < this->_sectors; idx++) {
+			uint32_t sequence = 0;
+
+			this->_sequences[idx] = 0;
+			this->_stale[idx] = 0;
+
+			if(!this->read(idx * this->_sectorsize, header, sizeof(header)))
+				continue;
+
+			if(header[0] != SECTOR_MAGIC0 || header[1] != SECTOR_MAGIC1)
+				continue;
+
+			if(crc16(0xFFFF, header, 6) != ((header[6] << 8) | header[7]))
+				continue;
+
+			for(int byte = 2; byte < 6; byte++)
+				sequence = (sequence << 8) | header[byte];
+
+			this->_sequences[idx] = sequence;
+
+			if(sequence == 0)
+				continue;
+
+			this->_free--;
+
+			if(!found || sequence < this->_sequences[this->_tail])
+				this->_tail = idx;
+
+			if(!found || sequence > this->_sequences[this->_head])
+				this->_head = idx;
+
+			found = true;
+		}
+
+		if(!found)
+			return;
+
+		this->_next = this->_sequences[this->_head] + 1;
+
+		/* Sectors are taken in ring order, so the used ones run from the tail to the head. */
+		for(auto idx = this->_tail; idx != this->_head; idx = (idx + 1) % this->_sectors)
+			this->replay(idx);
+
+		this->_head_offset = this->replay(this->_head);
+	}
+
+	/* Apply the records in \p sector to the index; returns the end of the last record. */
+	size_t KeyValueStore::replay(size_t sector)
+	{
+		auto sequence = this->_sequences[sector];
+		size_t offset = SectorHeader;
+		uint8_t header[RecordHeader];
+
+		if(sequence == 0)
+			return offset;
+
+		while(offset + RecordHeader <= this->_sectorsize) {
+			auto base = sector * this->_sectorsize + offset;
+
+			if(!this->read(base, header, sizeof(header)) || header[0] != RECORD_MAGIC || header[1] == 0)
+				break;
+
+			size_t keylen = header[1];
+			size_t length = (header[2] << 8) | header[3];
+			auto tombstone = length == TOMBSTONE;
+			auto size = keylen + (tombstone ? 0 : length);
+
+			if(offset + RecordHeader + size > this->_sectorsize)
+				break;
+
+			ByteBuffer body(size, true);
+
+			if(!this->read(base + RecordHeader, body.data(), size))
+				break;
+
+			if(checksum(sequence, header, body.data(), size) != ((header[4] << 8) | header[5]))
+				break;
+
+			String key(reinterpret_cast<const char *>(body.data()), keylen);
+
+			this->discard(key);
+
+			if(tombstone)
+				this->_stale[sector] += RecordHeader + size;
+			else
+				this->_index.add(key, Location{ sector, offset, length });
+
+			offset += RecordHeader + size;
+		}
+
+		return offset;
+	}
+
+	/* Forget the current record of \p key, which now only takes up space. */
+	void KeyValueStore::discard(const StringView &key)
+	{
+		auto iter = this->_index.find(key);
+
+		if(iter == this->_index.end())
+			return;
+
+		auto& location = iter->value;
+
+		this->_stale[location.sector] += RecordHeader + key.length() + location.length;
+		this->_index.remove(iter->key);
+	}
+
+	bool KeyValueStore::open(size_t sector)
+	{
+		auto sequence = this->_next++;
+		uint8_t header[] = {
+			SECTOR_MAGIC0, SECTOR_MAGIC1,
+			static_cast<uint8_t>(sequence >> 24), static_cast<uint8_t>(sequence >> 16),
+			static_cast<uint8_t>(sequence >> 8), static_cast<uint8_t>(sequence), 0, 0
+		};
+		auto crc = crc16(0xFFFF, header, 6);
+
+		header[6] = static_cast<uint8_t>(crc >> 8);
+		header[7] = static_cast<uint8_t>(crc & 0xFF);
+
+		if(!this->write(sector * this->_sectorsize, header, sizeof(header)))
+			return false;
+
+		if(this->_sequences[this->_head] == 0)
+			this->_tail = sector;
+
+		this->_sequences[sector] = sequence;
+		this->_stale[sector] = 0;
+		this->_head = sector;
+		this->_head_offset = SectorHeader;
+		this->_free--;
+
+		return true;
+	}
+
+	void KeyValueStore::release(size_t sector)
+	{
+		const uint8_t header[SectorHeader] = {};
+
+		this->write(sector * this->_sectorsize, header, sizeof(header));
+
+		if(this->_sequences[sector] != 0)
+			this->_free++;
+
+		this->_sequences[sector] = 0;
+		this->_stale[sector] = 0;
+	}
+
+	/* Make room for \p length bytes in the head sector. */
+	bool KeyValueStore::reserve(size_t length)
+	{
+		size_t rounds = 0;
+
+		while(this->_sequences[this->_head] == 0 || this->_head_offset + length > this->_sectorsize) {
+			if(this->_sequences[this->_head] == 0) {
+				if(!this->open(this->_head))
+					return false;
+
+				continue;
+			}
+
+			/* The last free sector is only taken by compaction. */
+			if(this->_free > 1 || (this->_free == 1 && this->_compacting)) {
+				const uint8_t end = 0;
+
+				/* Seal the sector, so that nothing behind its last record is taken for a record. */
+				if(this->_head_offset < this->_sectorsize)
+					this->write(this->_head * this->_sectorsize + this->_head_offset, &end, sizeof(end));
+
+				if(!this->open((this->_head + 1) % this->_sectors))
+					return false;
+
+				continue;
+			}
+
+			/*
+			 * Compaction only makes room when there are stale records. Those may be in any sector,
+			 * so the ring is rotated at most once to reach them.
+			 */
+			if(this->_compacting || rounds++ >= this->_sectors || !this->stale() || !this->collect())
+				return false;
+		}
+
+		return true;
+	}
+
+	bool KeyValueStore::stale() const
+	{
+		for(size_t idx = 0; idx < this->_sectors; idx++) {
+			if(this->_stale[idx] != 0)
+				return true;
+		}
+
+		return false;
+	}
+
+	/* Move the current records out of the tail sector and release it. */
+	bool KeyValueStore::collect()
+	{
+		stl::Vector<String> keys;
+		auto tail = this->_tail;
+		bool result = true;
+
+		if(tail == this->_head || this->_sequences[tail] == 0)
+			return false;
+
+		for(auto& entry : this->_index) {
+			if(entry.value.sector == tail)
+				keys.pushback(entry.key);
+		}
+
+		this->_compacting = true;
+
+		for(auto& key : keys) {
+			auto location = this->_index.at(key);
+			ByteBuffer value(location.length + 1, true);
+			auto offset = tail * this->_sectorsize + location.offset + RecordHeader + key.length();
+
+			result = this->read(offset, value.data(), location.length) &&
+				this->append(key, value.data(), location.length, false);
+
+			if(!result)
+				break;
+		}
+
+		this->_compacting = false;
+
+		if(!result)
+			return false;
+
+		this->release(tail);
+		this->_tail = (tail + 1) % this->_sectors;
+
+		return true;
+	}
+
+	bool KeyValueStore::append(const StringView &key, const void *value, size_t length, bool tombstone)
+	{
+		auto size = key.length() + (tombstone ? 0 : length);
+
+		if(!this->reserve(RecordHeader + size))
+			return false;
+
+		ByteBuffer body(size, true);
+
+		body.write(key.data(), key.length());
+
+		if(!tombstone)
+			body.write(value, length);
+
+		auto encoded = tombstone ? TOMBSTONE : length;
+		uint8_t header[] = {
+			RECORD_MAGIC, static_cast<uint8_t>(key.length()),
+			static_cast<uint8_t>(encoded >> 8), static_cast<uint8_t>(encoded & 0xFF), 0, 0
+		};
+		auto crc = checksum(this->_sequences[this->_head], header, body.data(), size);
+
+		header[4] = static_cast<uint8_t>(crc >> 8);
+		header[5] = static_cast<uint8_t>(crc & 0xFF);
+
+		/* The header goes last: a record is not there until it is complete. */
+		auto offset = this->_head * this->_sectorsize + this->_head_offset;
+
+		if(!this->write(offset + RecordHeader, body.data(), size) || !this->write(offset, header, sizeof(header)))
+			return false;
+
+		this->discard(key);
+
+		if(tombstone)
+			this->_stale[this->_head] += RecordHeader + size;
+		else
+			this->_index.add(String(key.data(), key.length()), Location{ this->_head, this->_head_offset, length });
+
+		this->_head_offset += RecordHeader + size;
+		return true;
+	}
+
+	bool KeyValueStore::set(const StringView &key, const void *value, size_t length)
+	{
+		ScopedLock lock(this->_lock);
+
+		if(key.length() == 0 || key.length() > UINT8_MAX || length >= TOMBSTONE)
+			return false;
+
+		if(SectorHeader + RecordHeader + key.length() + length > this->_sectorsize)
+			return false;
+
+		this->scan();
+		return this->append(key, value, length, false);
+	}
+
+	bool KeyValueStore::set(const StringView &key, const ByteBuffer &value)
+	{
+		return this->set(key, value.data(), value.index());
+	}
+
+	ssize_t KeyValueStore::get(const StringView &key, void *value, size_t length)
+	{
+		ScopedLock lock(this->_lock);
+
+		this->scan();
+
+		auto iter = this->_index.find(key);
+
+		if(iter == this->_index.end())
+			return -ENOTFOUND;
+
+		auto& location = iter->value;
+		auto offset = location.sector * this->_sectorsize + location.offset + RecordHeader + key.length();
+
+		if(length > location.length)
+			length = location.length;
+
+		if(length > 0 && !this->read(offset, value, length))
+			return -EINVALID;
+
+		return location.length;
+	}
+
+	bool KeyValueStore::get(const StringView &key, ByteBuffer &value)
+	{
+		ScopedLock lock(this->_lock);
+
+		this->scan();
+
+		auto iter = this->_index.find(key);
+
+		if(iter == this->_index.end())
+			return false;
+
+		auto& location = iter->value;
+		auto offset = location.sector * this->_sectorsize + location.offset + RecordHeader + key.length();
+		ByteBuffer result(location.length + 1, true);
+
+		if(!this->read(offset, result.data(), location.length))
+			return false;
+
+		result.setIndex(location.length);
+		value = stl::move(result);
+
+		return true;
+	}
+
+	bool KeyValueStore::remove(const StringView &key)
+	{
+		ScopedLock lock(this->_lock);
+
+		this->scan();
+
+		if(!this->_index.contains(key))
+			return false;
+
+		return this->append(key, nullptr, 0, true);
+	}
+
+	bool KeyValueStore::contains(const StringView &key)
+	{
+		ScopedLock lock(this->_lock);
+
+		this->scan();
+		return this->_index.contains(key);
+	}
+
+	size_t KeyValueStore::size()
+	{
+		ScopedLock lock(this->_lock);
+
+		this->scan();
+		return this->_index.size();
+	}
+
+	void KeyValueStore::clear()
+	{
+		ScopedLock lock(this->_lock);
+
+		this->scan();
+
+		for(size_t idx = 0; idx < this->_sectors; idx++)
+			this->release(idx);
+
+		this->_index.clear();
+		this->_head = this->_tail = 0;
+
+		/* Keep the newest sequence number in storage, so that it is never handed out again. */
+		this->open(0);
+	}
+
+	bool KeyValueStore::compact()
+	{
+		ScopedLock lock(this->_lock);
+
+		this->scan();
+
+		if(this->_tail == this->_head || this->_stale[this->_tail] == 0)
+			return false;
+
+		return this->collect();
+	}
+
+#ifdef HAVE_UNISTD_H
+	FileKeyValueStore::FileKeyValueStore(const String &path, size_t sectors, size_t sectorsize) :
+		KeyValueStore(sectors, sectorsize), _file(new File(path, FileMode::ReadWriteNoCreate))
+	{
+		if(*this->_file && this->_file->size() >= this->storage())
+			return;
+
+		/* Create the file with every sector free. */
+		File create(path, FileMode::Write);
+		uint8_t zero[SectorHeader] = {};
+
+		for(size_t offset = 0; create && offset < this->storage(); offset += sizeof(zero))
+			create.write(zero, sizeof(zero));
+
+		create.flush();
+		this->_file.reset(new File(path, FileMode::ReadWriteNoCreate));
+	}
+
+	bool FileKeyValueStore::read(size_t offset, void *data, size_t length)
+	{
+		if(!*this->_file || !this->_file->seek(offset))
+			return false;
+
+		return this->_file->read(data, length) == static_cast<ssize_t>(length);
+	}
+
+	bool FileKeyValueStore::write(size_t offset, const void *data, size_t length)
+	{
+		if(!*this->_file || offset + length > this->storage() || !this->_file->seek(offset))
+			return false;
+
+		return this->_file->write(data, length) == static_cast<ssize_t>(length) && this->_file->flush();
+	}
+#endif
+
+	SramKeyValueStore::SramKeyValueStore(SRAM23K256& sram, size_t base, size_t sectors, size_t sectorsize) :
+		KeyValueStore(sectors, sectorsize), _sram(sram), _base(base)
+	{
+	}
+
+	bool SramKeyValueStore::read(size_t offset, void *data, size_t length)
+	{
+		if(this->_base + offset + length > SramSize)
+			return false;
+
+		return this->_sram.read(this->_base + offset, data, length) == static_cast<ssize_t>(length);
+	}
+
+	bool SramKeyValueStore::write(size_t offset, const void *data, size_t length)
+	{
+		if(this->_base + offset + length > SramSize)
+			return false;
+
+		return this->_sram.write(this->_base + offset, data, length) == static_cast<ssize_t>(length);
+	}
+
+	EepromKeyValueStore::EepromKeyValueStore(Eeprom24C02& eeprom, uint8_t base, size_t sectors, size_t sectorsize) :
+		KeyValueStore(sectors, sectorsize), _eeprom(eeprom), _base(base)
+	{
+	}
+
+	bool EepromKeyValueStore::read(size_t offset, void *data, size_t length)
+	{
+		if(this->_base + offset + length > EepromSize)
+			return false;
+
+		return this->_eeprom.read(this->_base + offset, data, length) == static_cast<ssize_t>(length);
+	}
+
+	bool EepromKeyValueStore::write(size_t offset, const void *data, size_t length)
+	{
+		if(this->_base + offset + length > EepromSize)
+			return false;
+
+		return this->_eeprom.write(this->_base + offset, data, length) >= 0 && this->_eeprom.flush();
+	}
+}
@@ -5,6 +5,10 @@ SET(JSON_SOURCES
 	lib/json/jsonbuffer.cpp
 	lib/json/jsonobject.cpp
 	lib/json/jsonvariant.cpp
+	lib/json/cbor.cpp
+	lib/json/samplebatch.cpp
+	lib/json/jsonreader.cpp
+	lib/json/jsonschema.cpp
 
 	lib/json/comments.cpp
 	lib/json/encoding.cpp
@@ -14,6 +18,7 @@ SET(JSON_SOURCES
 	lib/json/prettyfier.cpp
 	lib/json/staticstringbuilder.cpp
 	lib/json/printer.cpp
+	lib/json/scanner.cpp
 )
 endif()
 
@@ -66,17 +71,33 @@ endif()
 
 SET(LIB_SOURCES
 	lib/streams/bufferedstream.cpp
+	lib/streams/ringbufferstream.cpp
 	lib/streams/stream.cpp
 	lib/streams/printer.cpp
+	lib/streams/compression.cpp
+	lib/streams/heatshrink.cpp
+	lib/streams/deflate.cpp
+	lib/streams/compressedstream.cpp
 
 	lib/gfx/gfxbase.cpp
+	lib/gfx/gfxcanvas.cpp
+	lib/gfx/glyphcache.cpp
 	lib/gfx/ssd1306display.cpp
+	lib/gfx/ssd1306transport.cpp
 
 	lib/count.cpp
 	lib/measurementvector.cpp
+	lib/samplebatch.cpp
 	lib/sharedpointercount.cpp
 	lib/guid.cpp
 
+	lib/dsp/kernels.cpp
+	lib/dsp/filter.cpp
+	lib/dsp/spectrum.cpp
+
+	lib/kvstore/keyvaluestore.cpp
+	lib/timeseries/timeseriesstore.cpp
+
 	${JSON_SOURCES}
 	${TIME_SOURCES}
 )
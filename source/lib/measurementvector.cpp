@@ -19,12 +19,13 @@
 
 namespace lwiot
 {
-	MeasurementVector::MeasurementVector(int num) : _measurements(stl::move(num))
+	MeasurementVector::MeasurementVector(int num) : _measurements(stl::move(num)), _squares(0.0)
 	{
 	}
 
-	MeasurementVector::MeasurementVector(const stl::Vector<double> &_measurements) : _measurements(_measurements)
+	MeasurementVector::MeasurementVector(const stl::Vector<double> &_measurements) : _measurements(_measurements), _squares(0.0)
 	{
+		this->sum();
 	}
 
 	MeasurementVector::~MeasurementVector()
@@ -35,6 +36,7 @@ namespace lwiot
 	MeasurementVector &MeasurementVector::operator=(const stl::Vector<double> &rhs)
 	{
 		this->_measurements = rhs;
+		this->sum();
 		return *this;
 	}
 
@@ -65,25 +67,25 @@ namespace lwiot
 	void MeasurementVector::add(const double &data)
 	{
 		this->_measurements.add(data);
+		this->_squares += data * data;
 	}
 
 	void MeasurementVector::clear()
 	{
 		this->_measurements.clear();
+		this->_squares = 0.0;
 	}
 
-	double MeasurementVector::smooth() const
+	void MeasurementVector::sum()
 	{
-		double data;
+		this->_squares = 0.0;
 
-		data = 0.0F;
-		for(stl::Vector<double>::const_iterator iter = this->_measurements.begin();
-				iter != this->_measurements.end(); ++iter) {
-			auto tmp = *iter * *iter;
-			data += tmp;
-		}
+		for(auto value : this->_measurements)
+			this->_squares += value * value;
+	}
 
-		data /= this->_measurements.length();
-		return sqrt(data);
+	double MeasurementVector::smooth() const
+	{
+		return sqrt(this->_squares / this->_measurements.length());
 	}
 }
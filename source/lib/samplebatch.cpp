@@ -0,0 +1,72 @@
+/*
+ * Structure-of-arrays batch of sensor samples.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/device/sensorscheduler.h>
+#include <lwiot/util/samplebatch.h>
+
+namespace lwiot
+{
+	static constexpr size_t align(size_t size)
+	{
+		return (size + CONFIG_SAMPLE_BATCH_ALIGN - 1) & ~static_cast<size_t>(CONFIG_SAMPLE_BATCH_ALIGN - 1);
+	}
+
+	/* One allocation holds the three arrays; it is over allocated to align the first one. */
+	SampleBatch::SampleBatch(size_t capacity) : _size(0), _capacity(capacity)
+	{
+		auto timestamps = align(capacity * sizeof(time_t));
+		auto sensors = align(capacity * sizeof(uint16_t));
+		auto values = align(capacity * sizeof(float));
+
+		this->_storage = new uint8_t[timestamps + sensors + values + CONFIG_SAMPLE_BATCH_ALIGN];
+
+		auto base = reinterpret_cast<uint8_t *>(align(reinterpret_cast<uintptr_t>(this->_storage)));
+
+		this->_timestamps = reinterpret_cast<time_t *>(base);
+		this->_sensors = reinterpret_cast<uint16_t *>(base + timestamps);
+		this->_values = reinterpret_cast<float *>(base + timestamps + sensors);
+	}
+
+	SampleBatch::~SampleBatch()
+	{
+		delete[] this->_storage;
+	}
+
+	size_t SampleBatch::add(const SensorReading& reading)
+	{
+		size_t added = 0;
+
+		if(!reading.ok)
+			return 0;
+
+		for(uint8_t idx = 0; idx < reading.count; idx++) {
+			if(!this->add(reading.timestamp, static_cast<uint16_t>(reading.sensor), reading.values[idx]))
+				break;
+
+			added++;
+		}
+
+		return added;
+	}
+
+	size_t SampleBatch::gather(uint16_t sensor, float *output, size_t length) const
+	{
+		size_t num = 0;
+
+		for(size_t idx = 0; idx < this->_size && num < length; idx++) {
+			if(this->_sensors[idx] == sensor)
+				output[num++] = this->_values[idx];
+		}
+
+		return num;
+	}
+}
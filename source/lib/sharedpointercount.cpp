@@ -34,13 +34,16 @@ namespace lwiot
 
 	long SharedPointerCount::useCount() const
 	{
-		return this->_count->load();
+		if(this->_count == nullptr)
+			return 0L;
+
+		return this->_count->count.load(memory_order_relaxed);
 	}
 
 	void SharedPointerCount::acquire() const noexcept
 	{
 		assert(this->_count != nullptr);
-		this->_count->fetch_add(1L);
+		this->_count->count.fetch_add(1L, memory_order_relaxed);
 	}
 }
 
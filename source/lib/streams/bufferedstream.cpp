@@ -11,16 +11,23 @@
 #include <lwiot/log.h>
 #include <lwiot/stream.h>
 #include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/bytebuffer.h>
 #include <lwiot/bufferedstream.h>
 
 #define BUFFEREDSTREAM_DEFAULT_SIZE 32
 
 namespace lwiot {
-	BufferedStream::BufferedStream(int size) : Stream(), Countable(size)
+	BufferedStream::BufferedStream(int size) : BufferedStream(size, Growing)
+	{ }
+
+	BufferedStream::BufferedStream(int size, Mode mode) : Stream(), Countable(size)
 	{
 		this->_data = (uint8_t*)lwiot_mem_zalloc(size);
 		this->rd_idx = 0;
 		this->wr_idx = 0;
+		this->_used = 0;
+		this->_mode = mode;
 	}
 
 	BufferedStream::BufferedStream() : BufferedStream(BUFFEREDSTREAM_DEFAULT_SIZE)
@@ -33,11 +40,13 @@ namespace lwiot {
 		this->_data = static_cast<uint8_t*>(lwiot_mem_zalloc(size));
 		this->rd_idx = other.rd_idx;
 		this->wr_idx = other.wr_idx;
+		this->_used = other._used;
+		this->_mode = other._mode;
 		memcpy(static_cast<void*>(this->_data), static_cast<const void*>(other.data()), size);
 	}
 
 #if __cplusplus >= 201103L || defined(__GXX_EXPERIMENTAL_CXX0X__) || defined(WIN32)
-	BufferedStream::BufferedStream(BufferedStream&& other)
+	BufferedStream::BufferedStream(BufferedStream&& other) : Stream(), Countable(0), _data(nullptr)
 	{
 		this->move(other);
 	}
@@ -56,32 +65,27 @@ namespace lwiot {
 		return *this;
 	}
 
+	BufferedStream& BufferedStream::operator=(BufferedStream&& other)
+	{
+		this->move(other);
+		return *this;
+	}
+
 	void BufferedStream::move(BufferedStream& other)
 	{
-		if(this->_data) {
-			if(other._data && this->_count >= other._count) {
-				memcpy(reinterpret_cast<void*>(this->_data),
-				       reinterpret_cast<void*>(other._data),
-					   other.count());
-				this->_count = other.count();
-				this->wr_idx = other.wr_idx;
-				this->rd_idx = other.rd_idx;
-
-				other.wr_idx = other.rd_idx = 0;
-				other._count = 0;
-				return;
-			}
-		} else {
+		if(this->_data)
 			lwiot_mem_free(this->_data);
-		}
 
 		this->_data = (uint8_t*)other.data();
 		this->wr_idx = other.wr_idx;
 		this->rd_idx = other.rd_idx;
+		this->_used = other._used;
+		this->_mode = other._mode;
 		this->_count = other.count();
 
-		other._data = reinterpret_cast<uint8_t*>(lwiot_mem_alloc(BUFFEREDSTREAM_DEFAULT_SIZE));
+		other._data = reinterpret_cast<uint8_t*>(lwiot_mem_zalloc(BUFFEREDSTREAM_DEFAULT_SIZE));
 		other.wr_idx = other.rd_idx = 0;
+		other._used = 0;
 		other._count = BUFFEREDSTREAM_DEFAULT_SIZE;
 	}
 #endif
@@ -95,6 +99,9 @@ namespace lwiot {
 		this->_data = static_cast<uint8_t*>(lwiot_mem_zalloc(size));
 		this->rd_idx = bfs.rd_idx;
 		this->wr_idx = bfs.wr_idx;
+		this->_used = bfs._used;
+		this->_mode = bfs._mode;
+		this->_count = size;
 		memcpy(static_cast<void*>(this->_data), static_cast<const void*>(bfs.data()), size);
 
 		return *this;
@@ -102,22 +109,39 @@ namespace lwiot {
 
 	uint8_t BufferedStream::read()
 	{
+		if(this->_mode == Circular) {
+			if(this->_used == 0)
+				return 0;
+
+			auto byte = this->_data[this->rd_idx];
+			this->commitRead(1);
+
+			return byte;
+		}
+
 		return this->_data[this->rd_idx++];
 	}
 
 	ssize_t BufferedStream::read(void *buffer, const size_t& length)
 	{
-		auto max = this->length();
-		size_t to_read;
+		auto output = static_cast<uint8_t*>(buffer);
+		auto to_read = this->available();
+		size_t done = 0;
 
-		if(this->rd_idx + length > max) {
-			to_read = max;
-		} else {
+		if(length < to_read)
 			to_read = length;
-		}
 
-		memcpy((void*)buffer, this->_data, to_read);
-		this->rd_idx += to_read;
+		while(done < to_read) {
+			auto span = this->readableSpan();
+			auto num = span.size();
+
+			if(num > to_read - done)
+				num = to_read - done;
+
+			memcpy(output + done, span.buffer(), num);
+			this->commitRead(num);
+			done += num;
+		}
 
 		return to_read;
 	}
@@ -132,24 +156,114 @@ namespace lwiot {
 
 	bool BufferedStream::write(uint8_t byte)
 	{
-		*this << byte;
-		return true;
+		return this->append(&byte, sizeof(byte)) == sizeof(byte);
 	}
 
 	ssize_t BufferedStream::write(const void *data, const size_t& length)
 	{
-		this->append((const void*)data, length);
-		return length;
+		return this->append((const void*)data, length);
 	}
 
 	size_t BufferedStream::available() const
 	{
+		if(this->_mode == Circular)
+			return this->_used;
+
 		auto written = this->wr_idx;
 
 		written -= this->rd_idx;
 		return written;
 	}
 
+	BufferedStream::Mode BufferedStream::mode() const
+	{
+		return this->_mode;
+	}
+
+	bool BufferedStream::full() const
+	{
+		if(this->_mode == Circular)
+			return this->_used == this->count();
+
+		return false;
+	}
+
+	RawBuffer BufferedStream::readableSpan() const
+	{
+		size_t num;
+
+		if(this->_mode == Circular) {
+			num = this->count() - this->rd_idx;
+
+			if(num > this->_used)
+				num = this->_used;
+		} else {
+			num = this->wr_idx - this->rd_idx;
+		}
+
+		return RawBuffer(this->_data + this->rd_idx, num);
+	}
+
+	RawBuffer BufferedStream::writableSpan()
+	{
+		size_t num;
+
+		if(this->_mode == Circular) {
+			num = this->count() - this->wr_idx;
+
+			if(num > this->count() - this->_used)
+				num = this->count() - this->_used;
+		} else {
+			if(this->wr_idx == this->count())
+				this->grow();
+
+			num = this->count() - this->wr_idx;
+		}
+
+		return RawBuffer(this->_data + this->wr_idx, num);
+	}
+
+	void BufferedStream::commitRead(size_t num)
+	{
+		if(num > this->available())
+			num = this->available();
+
+		if(this->_mode != Circular) {
+			this->rd_idx += num;
+			return;
+		}
+
+		this->rd_idx += num;
+		this->_used -= num;
+
+		if(this->rd_idx >= this->count())
+			this->rd_idx -= this->count();
+
+		/* Start over at the beginning of the buffer to keep the free space contiguous. */
+		if(this->_used == 0)
+			this->rd_idx = this->wr_idx = 0;
+	}
+
+	void BufferedStream::commitWrite(size_t num)
+	{
+		if(this->_mode != Circular) {
+			if(num > this->count() - this->wr_idx)
+				num = this->count() - this->wr_idx;
+
+			this->wr_idx += num;
+			return;
+		}
+
+		if(num > this->count() - this->_used)
+			num = this->count() - this->_used;
+
+		this->wr_idx += num;
+		this->_used += num;
+
+		if(this->wr_idx >= this->count())
+			this->wr_idx -= this->count();
+	}
+
 	const void *BufferedStream::data() const
 	{
 		return this->_data;
@@ -267,8 +381,27 @@ namespace lwiot {
 		return this->wr_idx;
 	}
 
-	void BufferedStream::append(const void* data, size_t length)
+	size_t BufferedStream::append(const void* data, size_t length)
 	{
+		if(this->_mode == Circular) {
+			auto bytes = static_cast<const uint8_t*>(data);
+			size_t done = 0;
+
+			while(done < length && !this->full()) {
+				auto span = this->writableSpan();
+				auto num = span.size();
+
+				if(num > length - done)
+					num = length - done;
+
+				memcpy(span.buffer(), bytes + done, num);
+				this->commitWrite(num);
+				done += num;
+			}
+
+			return done;
+		}
+
 		if((length + this->wr_idx) > this->count()) {
 			const auto newsize = this->wr_idx + length;
 			if(newsize < this->count() * 2U)
@@ -279,6 +412,8 @@ namespace lwiot {
 
 		memcpy(this->_data + this->wr_idx, data, length);
 		this->wr_idx += length;
+
+		return length;
 	}
 
 	void BufferedStream::grow()
@@ -290,17 +425,28 @@ namespace lwiot {
 	{
 		uint8_t *buf;
 		auto newsize = num;
+		auto old = this->count();
 
 		Countable::grow(static_cast<size_t>(num));
 		newsize += this->count();
 		buf = (uint8_t*) lwiot_mem_zalloc(newsize);
-		memcpy(buf, this->_data, this->count());
+		memcpy(buf, this->_data, old);
 		lwiot_mem_free(this->_data);
 		this->_data = buf;
 	}
 
 	String BufferedStream::toString()
 	{
+		if(this->_mode == Circular) {
+			auto first = this->readableSpan();
+			String str(static_cast<const char*>(first.buffer()), first.size());
+
+			if(first.size() < this->_used)
+				str.append(StringView((const char*)this->_data, this->_used - first.size()));
+
+			return str;
+		}
+
 		this->_data[this->wr_idx] = '\0';
 		String str((const char*)this->_data);
 
@@ -0,0 +1,277 @@
+/*
+ * Compressing and decompressing stream adapters.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/error.h>
+#include <lwiot/stream.h>
+#include <lwiot/compression.h>
+#include <lwiot/compressedstream.h>
+
+static_assert(CONFIG_CODEC_STREAM_BUFFER >= 16, "CONFIG_CODEC_STREAM_BUFFER is too small");
+
+namespace lwiot
+{
+	static Codec *compressor(CompressionFormat format, uint8_t window, uint8_t lookahead)
+	{
+		if(format == CompressionFormat::Heatshrink)
+			return new HeatshrinkEncoder(window != 0 ? window : CONFIG_HEATSHRINK_WINDOW,
+			                             lookahead != 0 ? lookahead : CONFIG_HEATSHRINK_LOOKAHEAD);
+
+		return new DeflateEncoder(format == CompressionFormat::Gzip, window != 0 ? window : CONFIG_DEFLATE_WINDOW,
+		                          lookahead != 0 ? lookahead : CONFIG_DEFLATE_LOOKAHEAD);
+	}
+
+	static Codec *decompressor(CompressionFormat format, uint8_t window, uint8_t lookahead)
+	{
+		if(format == CompressionFormat::Heatshrink)
+			return new HeatshrinkDecoder(window != 0 ? window : CONFIG_HEATSHRINK_WINDOW,
+			                             lookahead != 0 ? lookahead : CONFIG_HEATSHRINK_LOOKAHEAD);
+
+		return new InflateDecoder(format == CompressionFormat::Gzip, window != 0 ? window : CONFIG_INFLATE_WINDOW);
+	}
+
+	CodecStream::CodecStream(Stream& inner, Codec *codec) : Stream(), _inner(inner), _codec(codec), _error(false)
+	{
+		this->rewind();
+	}
+
+	CodecStream::~CodecStream()
+	{
+		delete this->_codec;
+	}
+
+	void CodecStream::rewind()
+	{
+		this->_start = 0;
+		this->_end = 0;
+		this->_head = 0;
+		this->_tail = 0;
+		this->_eof = false;
+		this->_finished = false;
+	}
+
+	bool CodecStream::failed() const
+	{
+		return this->_error || this->_codec->failed();
+	}
+
+	size_t CodecStream::available() const
+	{
+		return this->_end - this->_start + this->_inner.available();
+	}
+
+	uint8_t CodecStream::read()
+	{
+		uint8_t byte = 0;
+
+		this->read(&byte, sizeof(byte));
+		return byte;
+	}
+
+	/* The codec output is staged, so that codecs always have room for a whole token. */
+	ssize_t CodecStream::read(void *output, const size_t& length)
+	{
+		auto out = static_cast<uint8_t *>(output);
+		size_t produced = 0;
+
+		while(produced < length) {
+			if(this->_head < this->_tail) {
+				auto num = this->_tail - this->_head;
+
+				num = num < length - produced ? num : length - produced;
+				memcpy(out + produced, this->_output + this->_head, num);
+				this->_head += num;
+				produced += num;
+				continue;
+			}
+
+			if(this->_finished || this->_codec->failed())
+				break;
+
+			if(this->_start == this->_end && !this->_eof) {
+				auto rv = this->_inner.read(this->_input, sizeof(this->_input));
+
+				this->_start = 0;
+				this->_end = rv > 0 ? static_cast<size_t>(rv) : 0;
+				this->_eof = rv <= 0;
+			}
+
+			size_t used = 0;
+
+			this->_head = 0;
+
+			if(this->_start == this->_end) {
+				this->_tail = this->_codec->finish(this->_output, sizeof(this->_output));
+				this->_finished = this->_tail == 0;
+				continue;
+			}
+
+			this->_tail = this->_codec->process(this->_input + this->_start, this->_end - this->_start, used,
+			                                    this->_output, sizeof(this->_output));
+			this->_start += used;
+
+			/* A decoder that reached the end of its stream leaves the rest of the input alone. */
+			if(this->_tail == 0 && used == 0)
+				break;
+		}
+
+		return produced;
+	}
+
+	bool CodecStream::write(uint8_t byte)
+	{
+		return this->write(&byte, sizeof(byte)) == sizeof(byte);
+	}
+
+	ssize_t CodecStream::write(const void *bytes, const size_t& length)
+	{
+		uint8_t output[CONFIG_CODEC_STREAM_BUFFER];
+		auto data = static_cast<const uint8_t *>(bytes);
+		size_t left = length;
+
+		while(true) {
+			size_t used;
+			auto num = this->_codec->process(data, left, used, output, sizeof(output));
+
+			if(num != 0 && this->_inner.write(output, num) != static_cast<ssize_t>(num)) {
+				this->_error = true;
+				return -EINVALID;
+			}
+
+			data += used;
+			left -= used;
+
+			if(num == 0 && used == 0)
+				break;
+		}
+
+		if(this->failed())
+			return -EINVALID;
+
+		return length - left;
+	}
+
+	bool CodecStream::finish()
+	{
+		uint8_t output[CONFIG_CODEC_STREAM_BUFFER];
+		size_t num;
+
+		while((num = this->_codec->finish(output, sizeof(output))) != 0) {
+			if(this->_inner.write(output, num) != static_cast<ssize_t>(num)) {
+				this->_error = true;
+				break;
+			}
+		}
+
+		auto ok = !this->failed();
+
+		this->_codec->reset();
+		this->_error = false;
+		this->rewind();
+
+		return ok;
+	}
+
+	Stream& CodecStream::operator<<(char x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& CodecStream::operator<<(short x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& CodecStream::operator<<(int x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& CodecStream::operator<<(const long& x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& CodecStream::operator<<(const long long& x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& CodecStream::operator<<(unsigned char x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& CodecStream::operator<<(unsigned short x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& CodecStream::operator<<(unsigned int x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& CodecStream::operator<<(const unsigned long& x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& CodecStream::operator<<(const unsigned long long& x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& CodecStream::operator<<(const double& flt)
+	{
+		this->write(&flt, sizeof(flt));
+		return *this;
+	}
+
+	Stream& CodecStream::operator<<(const float& flt)
+	{
+		this->write(&flt, sizeof(flt));
+		return *this;
+	}
+
+	Stream& CodecStream::operator<<(const char *cstr)
+	{
+		this->write(cstr, strlen(cstr));
+		return *this;
+	}
+
+	Stream& CodecStream::operator<<(const String& str)
+	{
+		this->write(str.c_str(), str.length());
+		return *this;
+	}
+
+	CompressingStream::CompressingStream(Stream& inner, CompressionFormat format, uint8_t window, uint8_t lookahead) :
+		CodecStream(inner, compressor(format, window, lookahead))
+	{
+	}
+
+	DecompressingStream::DecompressingStream(Stream& inner, CompressionFormat format, uint8_t window, uint8_t lookahead) :
+		CodecStream(inner, decompressor(format, window, lookahead))
+	{
+	}
+}
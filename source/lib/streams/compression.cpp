@@ -0,0 +1,237 @@
+/*
+ * Streaming compression codecs.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/compression.h>
+
+#define HASH_BYTES 3
+
+namespace lwiot
+{
+	Codec::Codec() : _failed(false), _done(false)
+	{
+	}
+
+	size_t Codec::finish(uint8_t *output, size_t size)
+	{
+		UNUSED(output);
+		UNUSED(size);
+
+		return 0;
+	}
+
+	bool Codec::failed() const
+	{
+		return this->_failed;
+	}
+
+	bool Codec::done() const
+	{
+		return this->_done;
+	}
+
+	namespace detail
+	{
+		LzMatcher::LzMatcher(uint8_t window, size_t longest, size_t shortest) :
+			_window(1U << window), _longest(longest), _shortest(shortest), _start(0), _end(0)
+		{
+			uint8_t bits = window < 8 ? 8 : (window > 12 ? 12 : window);
+
+			this->_hash = 1U << bits;
+			this->_data = static_cast<uint8_t *>(lwiot_mem_alloc(this->_window * 2));
+			this->_prev = static_cast<uint16_t *>(lwiot_mem_alloc(this->_window * sizeof(uint16_t)));
+			this->_head = static_cast<uint16_t *>(lwiot_mem_alloc(this->_hash * sizeof(uint16_t)));
+
+			this->reset();
+		}
+
+		LzMatcher::~LzMatcher()
+		{
+			lwiot_mem_free(this->_data);
+			lwiot_mem_free(this->_prev);
+			lwiot_mem_free(this->_head);
+		}
+
+		void LzMatcher::reset()
+		{
+			this->_start = 0;
+			this->_end = 0;
+
+			/* Position 0 doubles as the end of a chain, so it is never matched against. */
+			memset(this->_head, 0, this->_hash * sizeof(uint16_t));
+			memset(this->_prev, 0, this->_window * sizeof(uint16_t));
+		}
+
+		size_t LzMatcher::hash(size_t pos) const
+		{
+			uint32_t value = this->_data[pos] | this->_data[pos + 1] << 8 | this->_data[pos + 2] << 16;
+			return (value * 2654435761U) >> 16 & (this->_hash - 1);
+		}
+
+		/* Drop the oldest window, which is out of reach of the current position. */
+		void LzMatcher::slide()
+		{
+			memmove(this->_data, this->_data + this->_window, this->_window);
+			this->_start -= this->_window;
+			this->_end -= this->_window;
+
+			for(size_t idx = 0; idx < this->_hash; idx++)
+				this->_head[idx] = this->_head[idx] > this->_window ? this->_head[idx] - this->_window : 0;
+
+			for(size_t idx = 0; idx < this->_window; idx++)
+				this->_prev[idx] = this->_prev[idx] > this->_window ? this->_prev[idx] - this->_window : 0;
+		}
+
+		size_t LzMatcher::fill(const uint8_t *data, size_t length)
+		{
+			if(this->_end == this->_window * 2 && this->_start >= this->_window)
+				this->slide();
+
+			auto num = this->_window * 2 - this->_end;
+
+			num = num < length ? num : length;
+			memcpy(this->_data + this->_end, data, num);
+			this->_end += num;
+
+			return num;
+		}
+
+		size_t LzMatcher::lookahead() const
+		{
+			return this->_end - this->_start;
+		}
+
+		size_t LzMatcher::longest() const
+		{
+			return this->_longest;
+		}
+
+		uint8_t LzMatcher::current() const
+		{
+			return this->_data[this->_start];
+		}
+
+		size_t LzMatcher::match(size_t& distance) const
+		{
+			auto limit = this->lookahead() < this->_longest ? this->lookahead() : this->_longest;
+			size_t best = 0;
+
+			if(limit < HASH_BYTES || limit < this->_shortest)
+				return 0;
+
+			size_t candidate = this->_head[this->hash(this->_start)];
+			auto data = this->_data;
+
+			for(int chain = 0; candidate != 0 && chain < CONFIG_COMPRESSION_CHAIN; chain++) {
+				if(candidate >= this->_start || this->_start - candidate > this->_window)
+					break;
+
+				size_t length = 0;
+
+				while(length < limit && data[candidate + length] == data[this->_start + length])
+					length++;
+
+				if(length > best) {
+					best = length;
+					distance = this->_start - candidate;
+
+					if(length == limit)
+						break;
+				}
+
+				size_t next = this->_prev[candidate & (this->_window - 1)];
+
+				if(next >= candidate)
+					break;
+
+				candidate = next;
+			}
+
+			return best >= this->_shortest ? best : 0;
+		}
+
+		void LzMatcher::advance(size_t num)
+		{
+			while(num-- > 0) {
+				if(this->_start + HASH_BYTES <= this->_end) {
+					auto key = this->hash(this->_start);
+
+					this->_prev[this->_start & (this->_window - 1)] = this->_head[key];
+					this->_head[key] = this->_start;
+				}
+
+				this->_start++;
+			}
+		}
+
+		BitWriter::BitWriter(bool msb) : _msb(msb), _output(nullptr), _size(0), _written(0)
+		{
+			this->reset();
+		}
+
+		void BitWriter::reset()
+		{
+			this->_bits = 0;
+			this->_count = 0;
+		}
+
+		void BitWriter::attach(uint8_t *output, size_t size)
+		{
+			this->_output = output;
+			this->_size = size;
+			this->_written = 0;
+		}
+
+		size_t BitWriter::written() const
+		{
+			return this->_written;
+		}
+
+		size_t BitWriter::space() const
+		{
+			return this->_size - this->_written;
+		}
+
+		/* Callers check space() first; values are at most 16 bits. */
+		void BitWriter::put(uint32_t value, uint8_t num)
+		{
+			value &= (1U << num) - 1;
+
+			if(this->_msb) {
+				this->_bits = this->_bits << num | value;
+				this->_count += num;
+
+				while(this->_count >= 8) {
+					this->_count -= 8;
+					this->_output[this->_written++] = this->_bits >> this->_count;
+				}
+
+				this->_bits &= (1U << this->_count) - 1;
+			} else {
+				this->_bits |= value << this->_count;
+				this->_count += num;
+
+				while(this->_count >= 8) {
+					this->_output[this->_written++] = this->_bits;
+					this->_bits >>= 8;
+					this->_count -= 8;
+				}
+			}
+		}
+
+		void BitWriter::align()
+		{
+			if(this->_count != 0)
+				this->put(0, 8 - this->_count);
+		}
+	}
+}
@@ -0,0 +1,739 @@
+/*
+ * Deflate and gzip compression.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/compression.h>
+
+/*
+ * The longest token is a 13 bit length and an 18 bit distance, on top of the bits that did not
+ * fill a byte yet. The end of the stream is an end of block code and the 8 byte gzip trailer.
+ */
+#define TOKEN_BYTES 5
+#define TRAILER_BYTES 10
+#define GZIP_HEADER_SIZE 10
+
+#define GZIP_FHCRC    0x02
+#define GZIP_FEXTRA   0x04
+#define GZIP_FNAME    0x08
+#define GZIP_FCOMMENT 0x10
+
+namespace lwiot
+{
+	static const uint16_t length_base[29] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+	};
+
+	static const uint8_t length_extra[29] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+	};
+
+	static const uint16_t distance_base[30] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+	};
+
+	static const uint8_t distance_extra[30] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+	};
+
+	static const uint8_t code_order[19] = {
+		16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+	};
+
+	/* CRC-32 (IEEE 802.3), four bits at a time to keep the table small. */
+	static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t length)
+	{
+		static const uint32_t table[16] = {
+			0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+			0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+		};
+
+		crc = ~crc;
+
+		for(size_t idx = 0; idx < length; idx++) {
+			crc = table[(crc ^ data[idx]) & 0xF] ^ (crc >> 4);
+			crc = table[(crc ^ (data[idx] >> 4)) & 0xF] ^ (crc >> 4);
+		}
+
+		return ~crc;
+	}
+
+	/* Huffman codes are sent starting with their most significant bit. */
+	static uint16_t reverse(uint16_t code, uint8_t length)
+	{
+		uint16_t value = 0;
+
+		while(length-- > 0) {
+			value = (value << 1) | (code & 1);
+			code >>= 1;
+		}
+
+		return value;
+	}
+
+	static uint8_t window_bits(uint8_t window)
+	{
+		return window < 9 ? 9 : (window > 15 ? 15 : window);
+	}
+
+	static size_t longest_match(uint8_t lookahead)
+	{
+		lookahead = lookahead < 3 ? 3 : (lookahead > 9 ? 9 : lookahead);
+		return (1U << lookahead) > 258 ? 258 : 1U << lookahead;
+	}
+
+	DeflateEncoder::DeflateEncoder(bool gzip, uint8_t window, uint8_t lookahead) : Codec(), _gzip(gzip),
+		_matcher(window_bits(window), longest_match(lookahead), 3), _writer(false)
+	{
+		this->reset();
+	}
+
+	void DeflateEncoder::reset()
+	{
+		this->_matcher.reset();
+		this->_writer.reset();
+		this->_started = false;
+		this->_flushed = false;
+		this->_crc = 0;
+		this->_size = 0;
+	}
+
+	/* The whole stream is one final block with fixed codes. */
+	void DeflateEncoder::start()
+	{
+		static const uint8_t header[GZIP_HEADER_SIZE] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF };
+
+		if(this->_gzip) {
+			for(auto byte : header)
+				this->_writer.put(byte, 8);
+		}
+
+		this->_writer.put(1, 1);
+		this->_writer.put(1, 2);
+		this->_started = true;
+	}
+
+	void DeflateEncoder::symbol(uint16_t value)
+	{
+		if(value < 144)
+			this->_writer.put(reverse(0x30 + value, 8), 8);
+		else if(value < 256)
+			this->_writer.put(reverse(0x190 + value - 144, 9), 9);
+		else if(value < 280)
+			this->_writer.put(reverse(value - 256, 7), 7);
+		else
+			this->_writer.put(reverse(0xC0 + value - 280, 8), 8);
+	}
+
+	void DeflateEncoder::encode(bool last)
+	{
+		auto& matcher = this->_matcher;
+
+		while(this->_writer.space() >= TOKEN_BYTES) {
+			if(matcher.lookahead() == 0 || (!last && matcher.lookahead() < matcher.longest()))
+				break;
+
+			size_t distance;
+			auto length = matcher.match(distance);
+
+			if(length == 0) {
+				this->symbol(matcher.current());
+				matcher.advance(1);
+				continue;
+			}
+
+			int code = 28;
+			while(length_base[code] > length)
+				code--;
+
+			this->symbol(257 + code);
+			this->_writer.put(length - length_base[code], length_extra[code]);
+
+			code = 29;
+			while(distance_base[code] > distance)
+				code--;
+
+			this->_writer.put(reverse(code, 5), 5);
+			this->_writer.put(distance - distance_base[code], distance_extra[code]);
+			matcher.advance(length);
+		}
+	}
+
+	size_t DeflateEncoder::process(const uint8_t *input, size_t length, size_t& used, uint8_t *output, size_t size)
+	{
+		used = 0;
+		this->_writer.attach(output, size);
+
+		if(!this->_started) {
+			if(size < GZIP_HEADER_SIZE + 1)
+				return 0;
+
+			this->start();
+		}
+
+		while(true) {
+			auto written = this->_writer.written();
+			auto num = this->_matcher.fill(input + used, length - used);
+
+			this->_crc = crc32(this->_crc, input + used, num);
+			this->_size += num;
+			used += num;
+			this->encode(false);
+
+			if(num == 0 && written == this->_writer.written())
+				break;
+		}
+
+		return this->_writer.written();
+	}
+
+	size_t DeflateEncoder::finish(uint8_t *output, size_t size)
+	{
+		this->_writer.attach(output, size);
+
+		if(!this->_started) {
+			if(size < GZIP_HEADER_SIZE + 1)
+				return 0;
+
+			this->start();
+		}
+
+		this->encode(true);
+
+		if(!this->_flushed && this->_matcher.lookahead() == 0 && this->_writer.space() >= TRAILER_BYTES) {
+			this->symbol(256);
+			this->_writer.align();
+
+			if(this->_gzip) {
+				for(int idx = 0; idx < 4; idx++)
+					this->_writer.put(this->_crc >> (idx * 8), 8);
+
+				for(int idx = 0; idx < 4; idx++)
+					this->_writer.put(this->_size >> (idx * 8), 8);
+			}
+
+			this->_flushed = true;
+		}
+
+		return this->_writer.written();
+	}
+
+	InflateDecoder::InflateDecoder(bool gzip, uint8_t window) : Codec(), _gzip(gzip),
+		_window(window < 8 ? 8 : (window > 15 ? 15 : window))
+	{
+		this->_buffer = static_cast<uint8_t *>(lwiot_mem_alloc(1U << this->_window));
+		this->_lencode.symbol = this->_symbols;
+		this->_distcode.symbol = this->_symbols + 288;
+		this->reset();
+	}
+
+	InflateDecoder::~InflateDecoder()
+	{
+		lwiot_mem_free(this->_buffer);
+	}
+
+	void InflateDecoder::reset()
+	{
+		this->_failed = false;
+		this->_done = false;
+		this->_head = 0;
+		this->_total = 0;
+		this->_state = this->_gzip ? State::Header : State::Block;
+		this->_bits = 0;
+		this->_count = 0;
+		this->_last = false;
+		this->_flags = 0;
+		this->_remaining = 0;
+		this->_distance = 0;
+		this->_crc = 0;
+		this->_index = 0;
+	}
+
+	/* Load whole bytes until num bits are available. Bits are consumed LSB first. */
+	bool InflateDecoder::need(uint8_t num)
+	{
+		while(this->_count < num && this->_used < this->_length) {
+			this->_bits |= static_cast<uint32_t>(this->_input[this->_used++]) << this->_count;
+			this->_count += 8;
+		}
+
+		return this->_count >= num;
+	}
+
+	uint32_t InflateDecoder::bits(uint8_t num)
+	{
+		uint32_t value = num < 32 ? this->_bits & ((1U << num) - 1) : this->_bits;
+
+		this->_bits = num < 32 ? this->_bits >> num : 0;
+		this->_count -= num;
+
+		return value;
+	}
+
+	/*
+	 * Decode a symbol of a canonical Huffman code, one bit at a time. Bits are only consumed once a
+	 * whole code is available. Returns -1 if more input is needed, or -2 for an invalid code.
+	 */
+	int InflateDecoder::decode(const Huffman& table)
+	{
+		int code = 0, first = 0, index = 0;
+
+		for(uint8_t length = 1; length < 16; length++) {
+			if(!this->need(length))
+				return -1;
+
+			code |= (this->_bits >> (length - 1)) & 1;
+			int count = table.count[length];
+
+			if(code - count < first) {
+				this->bits(length);
+				return table.symbol[index + (code - first)];
+			}
+
+			index += count;
+			first += count;
+			first <<= 1;
+			code <<= 1;
+		}
+
+		return -2;
+	}
+
+	bool InflateDecoder::build(Huffman& table, const uint8_t *lengths, size_t num)
+	{
+		uint16_t offsets[16];
+		int left = 1;
+
+		memset(table.count, 0, sizeof(table.count));
+
+		for(size_t idx = 0; idx < num; idx++)
+			table.count[lengths[idx]]++;
+
+		table.count[0] = 0;
+
+		for(int length = 1; length < 16; length++) {
+			left <<= 1;
+			left -= table.count[length];
+
+			if(left < 0)
+				return false;
+		}
+
+		offsets[1] = 0;
+
+		for(int length = 1; length < 15; length++)
+			offsets[length + 1] = offsets[length] + table.count[length];
+
+		for(size_t idx = 0; idx < num; idx++) {
+			if(lengths[idx] != 0)
+				table.symbol[offsets[lengths[idx]]++] = idx;
+		}
+
+		return true;
+	}
+
+	void InflateDecoder::fixed()
+	{
+		size_t idx = 0;
+
+		for(; idx < 144; idx++)
+			this->_lengths[idx] = 8;
+		for(; idx < 256; idx++)
+			this->_lengths[idx] = 9;
+		for(; idx < 280; idx++)
+			this->_lengths[idx] = 7;
+		for(; idx < 288; idx++)
+			this->_lengths[idx] = 8;
+		for(; idx < 288 + 30; idx++)
+			this->_lengths[idx] = 5;
+
+		this->build(this->_lencode, this->_lengths, 288);
+		this->build(this->_distcode, this->_lengths + 288, 30);
+	}
+
+	void InflateDecoder::emit(uint8_t *output, size_t& produced, uint8_t value)
+	{
+		output[produced++] = value;
+		this->_buffer[this->_head++ & ((1U << this->_window) - 1)] = value;
+		this->_total++;
+
+		if(this->_gzip)
+			this->_crc = crc32(this->_crc, &value, 1);
+	}
+
+	void InflateDecoder::end()
+	{
+		if(!this->_last) {
+			this->_state = State::Block;
+		} else if(this->_gzip) {
+			this->bits(this->_count % 8);
+			this->_index = 0;
+			this->_state = State::Trailer;
+		} else {
+			this->_done = true;
+			this->_state = State::End;
+		}
+	}
+
+	size_t InflateDecoder::finish(uint8_t *output, size_t size)
+	{
+		UNUSED(output);
+		UNUSED(size);
+
+		if(!this->_done)
+			this->_failed = true;
+
+		return 0;
+	}
+
+	size_t InflateDecoder::process(const uint8_t *input, size_t length, size_t& used, uint8_t *output, size_t size)
+	{
+		size_t produced = 0;
+
+		this->_input = input;
+		this->_length = length;
+		this->_used = 0;
+
+		while(produced < size && !this->_failed && this->_state != State::End) {
+			if(!this->step(output, size, produced))
+				break;
+		}
+
+		used = this->_used;
+		return produced;
+	}
+
+	/*
+	 * Advance the state machine. Returns false if it cannot advance until more input arrives, or
+	 * when the input is malformed, in which case _failed is set.
+	 */
+	bool InflateDecoder::step(uint8_t *output, size_t size, size_t& produced)
+	{
+		int symbol;
+
+		switch(this->_state) {
+		case State::Header:
+			while(this->_index < GZIP_HEADER_SIZE) {
+				if(!this->need(8))
+					return false;
+
+				auto byte = this->bits(8);
+
+				if((this->_index == 0 && byte != 0x1F) || (this->_index == 1 && byte != 0x8B) ||
+				   (this->_index == 2 && byte != 8))
+					break;
+
+				if(this->_index == 3)
+					this->_flags = byte;
+
+				this->_index++;
+			}
+
+			if(this->_index < GZIP_HEADER_SIZE)
+				break;
+
+			this->_state = State::HeaderExtraLength;
+			return true;
+
+		case State::HeaderExtraLength:
+			if((this->_flags & GZIP_FEXTRA) == 0) {
+				this->_state = State::HeaderName;
+				return true;
+			}
+
+			if(!this->need(16))
+				return false;
+
+			this->_remaining = this->bits(16);
+			this->_state = State::HeaderExtra;
+			return true;
+
+		case State::HeaderExtra:
+			while(this->_remaining > 0) {
+				if(!this->need(8))
+					return false;
+
+				this->bits(8);
+				this->_remaining--;
+			}
+
+			this->_state = State::HeaderName;
+			return true;
+
+		case State::HeaderName:
+		case State::HeaderComment:
+			if((this->_flags & (this->_state == State::HeaderName ? GZIP_FNAME : GZIP_FCOMMENT)) != 0) {
+				do {
+					if(!this->need(8))
+						return false;
+				} while(this->bits(8) != 0);
+			}
+
+			this->_state = this->_state == State::HeaderName ? State::HeaderComment : State::HeaderCrc;
+			return true;
+
+		case State::HeaderCrc:
+			if((this->_flags & GZIP_FHCRC) != 0) {
+				if(!this->need(16))
+					return false;
+
+				this->bits(16);
+			}
+
+			this->_state = State::Block;
+			return true;
+
+		case State::Block:
+			if(!this->need(3))
+				return false;
+
+			this->_last = this->bits(1) != 0;
+
+			switch(this->bits(2)) {
+			case 0:
+				this->bits(this->_count % 8);
+				this->_state = State::StoredLength;
+				return true;
+
+			case 1:
+				this->fixed();
+				this->_state = State::Symbol;
+				return true;
+
+			case 2:
+				this->_state = State::Tables;
+				return true;
+
+			default:
+				break;
+			}
+
+			break;
+
+		case State::StoredLength:
+			if(!this->need(32))
+				return false;
+
+			this->_remaining = this->bits(16);
+
+			if(this->_remaining != (~this->bits(16) & 0xFFFF))
+				break;
+
+			this->_state = State::Stored;
+			return true;
+
+		case State::Stored:
+			while(this->_remaining > 0 && produced < size) {
+				if(!this->need(8))
+					return false;
+
+				this->emit(output, produced, this->bits(8));
+				this->_remaining--;
+			}
+
+			if(this->_remaining == 0)
+				this->end();
+
+			return true;
+
+		case State::Tables:
+			if(!this->need(14))
+				return false;
+
+			this->_nlen = this->bits(5) + 257;
+			this->_ndist = this->bits(5) + 1;
+			this->_ncode = this->bits(4) + 4;
+
+			if(this->_nlen > 286 || this->_ndist > 30)
+				break;
+
+			memset(this->_lengths, 0, 19);
+			this->_index = 0;
+			this->_state = State::LengthCodes;
+			return true;
+
+		case State::LengthCodes:
+			while(this->_index < this->_ncode) {
+				if(!this->need(3))
+					return false;
+
+				this->_lengths[code_order[this->_index++]] = this->bits(3);
+			}
+
+			if(!this->build(this->_lencode, this->_lengths, 19))
+				break;
+
+			this->_index = 0;
+			this->_remaining = 0;
+			this->_state = State::Lengths;
+			return true;
+
+		case State::Lengths:
+			while(this->_index < this->_nlen + this->_ndist) {
+				uint8_t length = 0;
+				size_t repeat;
+
+				/* A repeat code that waits for its extra bits is kept in _remaining. */
+				if(this->_remaining == 0) {
+					symbol = this->decode(this->_lencode);
+
+					if(symbol == -1)
+						return false;
+
+					if(symbol < 0)
+						break;
+
+					if(symbol < 16) {
+						this->_lengths[this->_index++] = symbol;
+						continue;
+					}
+
+					this->_remaining = symbol;
+				}
+
+				if(this->_remaining == 16) {
+					if(!this->need(2))
+						return false;
+
+					if(this->_index == 0)
+						break;
+
+					length = this->_lengths[this->_index - 1];
+					repeat = 3 + this->bits(2);
+				} else if(this->_remaining == 17) {
+					if(!this->need(3))
+						return false;
+
+					repeat = 3 + this->bits(3);
+				} else {
+					if(!this->need(7))
+						return false;
+
+					repeat = 11 + this->bits(7);
+				}
+
+				this->_remaining = 0;
+
+				if(this->_index + repeat > static_cast<size_t>(this->_nlen + this->_ndist))
+					break;
+
+				while(repeat-- > 0)
+					this->_lengths[this->_index++] = length;
+			}
+
+			if(this->_index < this->_nlen + this->_ndist || this->_lengths[256] == 0)
+				break;
+
+			if(!this->build(this->_lencode, this->_lengths, this->_nlen) ||
+			   !this->build(this->_distcode, this->_lengths + this->_nlen, this->_ndist))
+				break;
+
+			this->_state = State::Symbol;
+			return true;
+
+		case State::Symbol:
+			symbol = this->decode(this->_lencode);
+
+			if(symbol == -1)
+				return false;
+
+			if(symbol < 0 || symbol > 285)
+				break;
+
+			if(symbol < 256) {
+				this->emit(output, produced, symbol);
+				return true;
+			}
+
+			if(symbol == 256) {
+				this->end();
+				return true;
+			}
+
+			this->_index = symbol - 257;
+			this->_state = State::Length;
+			return true;
+
+		case State::Length:
+			if(!this->need(length_extra[this->_index]))
+				return false;
+
+			this->_remaining = length_base[this->_index] + this->bits(length_extra[this->_index]);
+			this->_state = State::Distance;
+			return true;
+
+		case State::Distance:
+			symbol = this->decode(this->_distcode);
+
+			if(symbol == -1)
+				return false;
+
+			if(symbol < 0 || symbol >= 30)
+				break;
+
+			this->_index = symbol;
+			this->_state = State::DistanceExtra;
+			return true;
+
+		case State::DistanceExtra:
+			if(!this->need(distance_extra[this->_index]))
+				return false;
+
+			this->_distance = distance_base[this->_index] + this->bits(distance_extra[this->_index]);
+
+			if(this->_distance > this->_total || this->_distance > (1U << this->_window))
+				break;
+
+			this->_state = State::Copy;
+			return true;
+
+		case State::Copy:
+			while(this->_remaining > 0 && produced < size) {
+				this->emit(output, produced, this->_buffer[(this->_head - this->_distance) & ((1U << this->_window) - 1)]);
+				this->_remaining--;
+			}
+
+			if(this->_remaining == 0)
+				this->_state = State::Symbol;
+
+			return true;
+
+		case State::Trailer:
+			if(!this->need(32))
+				return false;
+
+			if(this->_index == 0) {
+				if(this->bits(16) != (this->_crc & 0xFFFF) || this->bits(16) != (this->_crc >> 16))
+					break;
+
+				this->_index = 1;
+				return true;
+			}
+
+			if(this->bits(16) != (this->_total & 0xFFFF) || this->bits(16) != ((this->_total >> 16) & 0xFFFF))
+				break;
+
+			this->_done = true;
+			this->_state = State::End;
+			return true;
+
+		case State::End:
+			return false;
+		}
+
+		this->_failed = true;
+		return false;
+	}
+}
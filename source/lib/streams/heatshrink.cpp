@@ -0,0 +1,222 @@
+/*
+ * Heatshrink compression.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/compression.h>
+
+/* A back reference is at most 30 bits, on top of the bits that did not fill a byte yet. */
+#define TOKEN_BYTES 5
+
+namespace lwiot
+{
+	static uint8_t window_bits(uint8_t window)
+	{
+		return window < 4 ? 4 : (window > 15 ? 15 : window);
+	}
+
+	static uint8_t lookahead_bits(uint8_t window, uint8_t lookahead)
+	{
+		window = window_bits(window);
+		return lookahead < 3 ? 3 : (lookahead >= window ? window - 1 : lookahead);
+	}
+
+	/* A back reference has to be shorter in bits than the literals it replaces. */
+	static size_t break_even(uint8_t window, uint8_t lookahead)
+	{
+		return (1 + window_bits(window) + lookahead_bits(window, lookahead)) / 9 + 1;
+	}
+
+	HeatshrinkEncoder::HeatshrinkEncoder(uint8_t window, uint8_t lookahead) : Codec(),
+		_window(window_bits(window)), _lookahead(lookahead_bits(window, lookahead)),
+		_matcher(window_bits(window), 1U << lookahead_bits(window, lookahead), break_even(window, lookahead)),
+		_writer(true), _flushed(false)
+	{
+	}
+
+	void HeatshrinkEncoder::reset()
+	{
+		this->_matcher.reset();
+		this->_writer.reset();
+		this->_flushed = false;
+	}
+
+	/* Positions are only encoded once a full match could follow them, unless the input ended. */
+	void HeatshrinkEncoder::encode(bool last)
+	{
+		auto& matcher = this->_matcher;
+
+		while(this->_writer.space() >= TOKEN_BYTES) {
+			if(matcher.lookahead() == 0 || (!last && matcher.lookahead() < matcher.longest()))
+				break;
+
+			size_t distance;
+			auto length = matcher.match(distance);
+
+			if(length != 0) {
+				this->_writer.put(0, 1);
+				this->_writer.put(distance - 1, this->_window);
+				this->_writer.put(length - 1, this->_lookahead);
+				matcher.advance(length);
+			} else {
+				this->_writer.put(1, 1);
+				this->_writer.put(matcher.current(), 8);
+				matcher.advance(1);
+			}
+		}
+	}
+
+	size_t HeatshrinkEncoder::process(const uint8_t *input, size_t length, size_t& used, uint8_t *output, size_t size)
+	{
+		used = 0;
+		this->_writer.attach(output, size);
+
+		while(true) {
+			auto written = this->_writer.written();
+			auto num = this->_matcher.fill(input + used, length - used);
+
+			used += num;
+			this->encode(false);
+
+			if(num == 0 && written == this->_writer.written())
+				break;
+		}
+
+		return this->_writer.written();
+	}
+
+	size_t HeatshrinkEncoder::finish(uint8_t *output, size_t size)
+	{
+		this->_writer.attach(output, size);
+		this->encode(true);
+
+		if(!this->_flushed && this->_matcher.lookahead() == 0 && this->_writer.space() > 0) {
+			this->_writer.align();
+			this->_flushed = true;
+		}
+
+		return this->_writer.written();
+	}
+
+	HeatshrinkDecoder::HeatshrinkDecoder(uint8_t window, uint8_t lookahead) : Codec(),
+		_window(window_bits(window)), _lookahead(lookahead_bits(window, lookahead))
+	{
+		this->_buffer = static_cast<uint8_t *>(lwiot_mem_alloc(1U << this->_window));
+		this->reset();
+	}
+
+	HeatshrinkDecoder::~HeatshrinkDecoder()
+	{
+		lwiot_mem_free(this->_buffer);
+	}
+
+	void HeatshrinkDecoder::reset()
+	{
+		this->_state = State::Tag;
+		this->_byte = 0;
+		this->_mask = 0;
+		this->_bits = 0;
+		this->_count = 0;
+		this->_offset = 0;
+		this->_copy = 0;
+		this->_head = 0;
+
+		memset(this->_buffer, 0, 1U << this->_window);
+	}
+
+	/* Bits are read MSB first. Bits taken before the input ran out are kept for the next call. */
+	bool HeatshrinkDecoder::take(const uint8_t *input, size_t length, size_t& used, uint8_t num, uint16_t& value)
+	{
+		while(this->_count < num) {
+			if(this->_mask == 0) {
+				if(used == length)
+					return false;
+
+				this->_byte = input[used++];
+				this->_mask = 0x80;
+			}
+
+			this->_bits = (this->_bits << 1) | ((this->_byte & this->_mask) != 0 ? 1 : 0);
+			this->_mask >>= 1;
+			this->_count++;
+		}
+
+		value = this->_bits;
+		this->_bits = 0;
+		this->_count = 0;
+		return true;
+	}
+
+	void HeatshrinkDecoder::push(uint8_t value)
+	{
+		this->_buffer[this->_head & ((1U << this->_window) - 1)] = value;
+		this->_head++;
+	}
+
+	size_t HeatshrinkDecoder::process(const uint8_t *input, size_t length, size_t& used, uint8_t *output, size_t size)
+	{
+		size_t produced = 0;
+		uint16_t value;
+
+		used = 0;
+
+		while(produced < size) {
+			switch(this->_state) {
+			case State::Tag:
+				if(!this->take(input, length, used, 1, value))
+					return produced;
+
+				this->_state = value != 0 ? State::Literal : State::Index;
+				break;
+
+			case State::Literal:
+				if(!this->take(input, length, used, 8, value))
+					return produced;
+
+				this->push(value);
+				output[produced++] = value;
+				this->_state = State::Tag;
+				break;
+
+			case State::Index:
+				if(!this->take(input, length, used, this->_window, value))
+					return produced;
+
+				this->_offset = value + 1;
+				this->_state = State::Count;
+				break;
+
+			case State::Count:
+				if(!this->take(input, length, used, this->_lookahead, value))
+					return produced;
+
+				this->_copy = value + 1;
+				this->_state = State::Copy;
+				break;
+
+			case State::Copy:
+				while(this->_copy > 0 && produced < size) {
+					auto c = this->_buffer[(this->_head - this->_offset) & ((1U << this->_window) - 1)];
+
+					this->push(c);
+					output[produced++] = c;
+					this->_copy--;
+				}
+
+				if(this->_copy == 0)
+					this->_state = State::Tag;
+				break;
+			}
+		}
+
+		return produced;
+	}
+}
@@ -14,6 +14,7 @@
 #include <lwiot/log.h>
 #include <lwiot/types.h>
 #include <lwiot/printer.h>
+#include <lwiot/util/numberformat.h>
 
 extern "C" {
 #include <time.h>
@@ -93,12 +94,10 @@ namespace lwiot
 		if(base == 0) {
 			return write(n);
 		} else if(base == 10) {
-			if(n < 0) {
-				int t = print('-');
-				n = -n;
-				return printNumber(n, 10) + t;
-			}
-			return printNumber(n, 10);
+			char buf[NumberFormat::BufferSize];
+			auto length = NumberFormat::formatSigned(buf, n);
+
+			return write(buf, length);
 		} else {
 			return printNumber(n, base);
 		}
@@ -221,70 +220,17 @@ namespace lwiot
 
 	size_t Printer::printNumber(unsigned long n, uint8_t base)
 	{
-		char buf[8 * sizeof(long) + 1]; // Assumes 8-bit chars plus zero byte.
-		char *str = &buf[sizeof(buf) - 1];
-
-		*str = '\0';
-
-		// prevent crash if called with base == 1
-		if(base < 2) {
-			base = 10;
-		}
-
-		do {
-			unsigned long m = n;
-			n /= base;
-			char c = m - base * n;
-			*--str = c < 10 ? c + '0' : c + 'A' - 10;
-		} while(n);
+		char buf[NumberFormat::BufferSize];
+		auto length = NumberFormat::formatUnsigned(buf, n, base);
 
-		return write(str);
+		return write(buf, length);
 	}
 
 	size_t Printer::printFloat(double number, uint8_t digits)
 	{
-		size_t n = 0;
-
-		if(isnan(number)) {
-			return print("nan");
-		}
-		if(isinf(number)) {
-			return print("inf");
-		}
-		if(number > 4294967040.0) {
-			return print("ovf");
-		}
-		if(number < -4294967040.0) {
-			return print("ovf");
-		}
+		char buf[NumberFormat::BufferSize];
+		auto length = NumberFormat::formatFloat(buf, number, digits);
 
-		if(number < 0.0) {
-			n += print('-');
-			number = -number;
-		}
-
-		double rounding = 0.5;
-		for(uint8_t i = 0; i < digits; ++i) {
-			rounding /= 10.0;
-		}
-
-		number += rounding;
-
-		unsigned long int_part = (unsigned long) number;
-		double remainder = number - (double) int_part;
-		n += print(int_part);
-
-		if(digits > 0) {
-			n += print(".");
-		}
-
-		while(digits-- > 0) {
-			remainder *= 10.0;
-			int to_print = int(remainder);
-			n += print(to_print);
-			remainder -= to_print;
-		}
-
-		return n;
+		return write(buf, length);
 	}
-}
\ No newline at end of file
+}
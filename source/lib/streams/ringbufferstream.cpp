@@ -0,0 +1,193 @@
+/*
+ * Lock-free ring buffer stream implementation.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/stream.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/ringbufferstream.h>
+
+namespace lwiot
+{
+	RingBufferStream::RingBufferStream(size_t capacity) : Stream(), _head(0), _tail(0)
+	{
+		size_t size = 1;
+
+		while(size < capacity)
+			size <<= 1U;
+
+		this->_data = static_cast<uint8_t*>(lwiot_mem_alloc(size));
+		this->_mask = size - 1;
+	}
+
+	RingBufferStream::~RingBufferStream()
+	{
+		lwiot_mem_free(this->_data);
+	}
+
+	size_t RingBufferStream::available() const
+	{
+		return this->_head.load() - this->_tail.load();
+	}
+
+	size_t RingBufferStream::capacity() const
+	{
+		return this->_mask + 1;
+	}
+
+	bool RingBufferStream::full() const
+	{
+		return this->available() == this->capacity();
+	}
+
+	uint8_t RingBufferStream::read()
+	{
+		uint8_t byte = 0;
+
+		this->read(&byte, sizeof(byte));
+		return byte;
+	}
+
+	ssize_t RingBufferStream::read(void *output, const size_t& length)
+	{
+		auto tail = this->_tail.load();
+		auto num = this->_head.load() - tail;
+
+		if(num > length)
+			num = length;
+
+		if(num == 0)
+			return 0;
+
+		auto offset = tail & this->_mask;
+		auto first = this->capacity() - offset;
+
+		if(first > num)
+			first = num;
+
+		memcpy(output, &this->_data[offset], first);
+		memcpy(static_cast<uint8_t*>(output) + first, this->_data, num - first);
+		this->_tail.fetch_add(num);
+
+		return num;
+	}
+
+	bool RingBufferStream::write(uint8_t byte)
+	{
+		return this->write(&byte, sizeof(byte)) == sizeof(byte);
+	}
+
+	ssize_t RingBufferStream::write(const void *bytes, const size_t& length)
+	{
+		auto head = this->_head.load();
+		auto num = this->capacity() - (head - this->_tail.load());
+
+		if(num > length)
+			num = length;
+
+		if(num == 0)
+			return 0;
+
+		auto offset = head & this->_mask;
+		auto first = this->capacity() - offset;
+
+		if(first > num)
+			first = num;
+
+		memcpy(&this->_data[offset], bytes, first);
+		memcpy(this->_data, static_cast<const uint8_t*>(bytes) + first, num - first);
+		this->_head.fetch_add(num);
+
+		return num;
+	}
+
+	Stream& RingBufferStream::operator<<(char x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& RingBufferStream::operator<<(short x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& RingBufferStream::operator<<(int x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& RingBufferStream::operator<<(const long& x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& RingBufferStream::operator<<(const long long& x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& RingBufferStream::operator<<(unsigned char x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& RingBufferStream::operator<<(unsigned short x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& RingBufferStream::operator<<(unsigned int x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& RingBufferStream::operator<<(const unsigned long& x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& RingBufferStream::operator<<(const unsigned long long& x)
+	{
+		this->write(&x, sizeof(x));
+		return *this;
+	}
+
+	Stream& RingBufferStream::operator<<(const double& flt)
+	{
+		this->write(&flt, sizeof(flt));
+		return *this;
+	}
+
+	Stream& RingBufferStream::operator<<(const float& flt)
+	{
+		this->write(&flt, sizeof(flt));
+		return *this;
+	}
+
+	Stream& RingBufferStream::operator<<(const char *cstr)
+	{
+		this->write(cstr, strlen(cstr));
+		return *this;
+	}
+
+	Stream& RingBufferStream::operator<<(const String& str)
+	{
+		this->write(str.c_str(), str.length());
+		return *this;
+	}
+}
@@ -11,7 +11,9 @@
 
 #include <lwiot/types.h>
 #include <lwiot/log.h>
+#include <lwiot/error.h>
 #include <lwiot/stream.h>
+#include <lwiot/bytebuffer.h>
 
 namespace lwiot {
 	Stream::Stream() : Stream(1000)
@@ -64,22 +66,49 @@ namespace lwiot {
 
 	String Stream::readStringUntil(char terminator)
 	{
-		String retval;
-		int c;
+		ByteBuffer buffer;
+
+		if(this->readUntil(terminator, buffer) < 0)
+			return String("");
+
+		return String(reinterpret_cast<const char*>(buffer.data()), buffer.index());
+	}
+
+	ssize_t Stream::readUntil(char delim, ByteBuffer& output)
+	{
+		ssize_t num = 0;
 		time_t tmo = lwiot_tick_ms() + this->_timeout;
+		auto c = static_cast<char>(this->read());
+
+		while(c != delim) {
+			if(this->_timeout > 0 && lwiot_tick_ms() > tmo)
+				return -ETMO;
+
+			output.write(static_cast<uint8_t>(c));
+			num++;
+			c = static_cast<char>(this->read());
+		}
+
+		return num;
+	}
 
-		c = this->read();
+	ssize_t Stream::skipUntil(char delim)
+	{
+		ssize_t num = 0;
+		time_t tmo = lwiot_tick_ms() + this->_timeout;
 
-		while(c >= 0 && c != terminator) {
-			if(this->_timeout > 0 && lwiot_tick_ms() > tmo) {
-				return String("");
-			}
+		while(static_cast<char>(this->read()) != delim) {
+			if(this->_timeout > 0 && lwiot_tick_ms() > tmo)
+				return -ETMO;
 
-			retval += (char)c;
-			c = this->read();
+			num++;
 		}
 
+		return num;
+	}
 
-		return retval;
+	RawBuffer Stream::peekSpan()
+	{
+		return RawBuffer();
 	}
 }
@@ -35,111 +35,47 @@
 
 #include "time.h"
 
+/* Days from 1970-01-01 to 2000-01-01. */
+#define Y2K_DAYS 10957L
+
 void
 gmtime_r(const time_t * timer, struct tm * timeptr)
 {
-    int32_t         fract;
-    ldiv_t          lresult;
-    div_t           result;
-    uint16_t        days, n, leapyear, years;
+    uint32_t        fract, days;
+    uint32_t        z, era, doe, yoe, doy, mp;
+    int16_t         year;
 
     /* break down timer into whole and fractional parts of 1 day */
-    days = *timer / 86400UL;
-    fract = *timer % 86400UL;
+    days = *timer / ONE_DAY;
+    fract = *timer % ONE_DAY;
 
-    /*
-            Extract hour, minute, and second from the fractional day
-        */
-    lresult = ldiv(fract, 60L);
-    timeptr->tm_sec = lresult.rem;
-    result = div(lresult.quot, 60);
-    timeptr->tm_min = result.rem;
-    timeptr->tm_hour = result.quot;
+    /* Extract hour, minute, and second from the fractional day */
+    timeptr->tm_sec = fract % 60;
+    fract /= 60;
+    timeptr->tm_min = fract % 60;
+    timeptr->tm_hour = fract / 60;
 
     /* Determine day of week ( the epoch was a Saturday ) */
-    n = days + SATURDAY;
-    n %= 7;
-    timeptr->tm_wday = n;
-
-    /*
-        * Our epoch year has the property of being at the conjunction of all three 'leap cycles',
-        * 4, 100, and 400 years ( though we can ignore the 400 year cycle in this library).
-        *
-        * Using this property, we can easily 'map' the time stamp into the leap cycles, quickly
-        * deriving the year and day of year, along with the fact of whether it is a leap year.
-        */
-
-    /* map into a 100 year cycle */
-    lresult = ldiv((long) days, 36525L);
-    years = 100 * lresult.quot;
-
-    /* map into a 4 year cycle */
-    lresult = ldiv(lresult.rem, 1461L);
-    years += 4 * lresult.quot;
-    days = lresult.rem;
-    if (years > 100)
-        days++;
-
-    /*
-         * 'years' is now at the first year of a 4 year leap cycle, which will always be a leap year,
-         * unless it is 100. 'days' is now an index into that cycle.
-         */
-    leapyear = 1;
-    if (years == 100)
-        leapyear = 0;
-
-    /* compute length, in days, of first year of this cycle */
-    n = 364 + leapyear;
+    timeptr->tm_wday = (days + SATURDAY) % 7;
 
     /*
-     * if the number of days remaining is greater than the length of the
-     * first year, we make one more division.
+     * Map the day onto a calendar that starts on March 1st, which puts the leap day at the end of
+     * the year, and derive the date in constant time. See
+     * http://howardhinnant.github.io/date_algorithms.html (civil_from_days). The time stamp
+     * never lies before 1970, so the era of 400 years is never negative.
      */
-    if (days > n) {
-        days -= leapyear;
-        leapyear = 0;
-        result = div(days, 365);
-        years += result.quot;
-        days = result.rem;
-    }
-    timeptr->tm_year = 100 + years;
-    timeptr->tm_yday = days;
-
-    /*
-            Given the year, day of year, and leap year indicator, we can break down the
-            month and day of month. If the day of year is less than 59 (or 60 if a leap year), then
-            we handle the Jan/Feb month pair as an exception.
-        */
-    n = 59 + leapyear;
-    if (days < n) {
-        /* special case: Jan/Feb month pair */
-        result = div(days, 31);
-        timeptr->tm_mon = result.quot;
-        timeptr->tm_mday = result.rem;
-    } else {
-        /*
-            The remaining 10 months form a regular pattern of 31 day months alternating with 30 day
-            months, with a 'phase change' between July and August (153 days after March 1).
-            We proceed by mapping our position into either March-July or August-December.
-            */
-        days -= n;
-        result = div(days, 153);
-        timeptr->tm_mon = 2 + result.quot * 5;
-
-        /* map into a 61 day pair of months */
-        result = div(result.rem, 61);
-        timeptr->tm_mon += result.quot * 2;
-
-        /* map into a month */
-        result = div(result.rem, 31);
-        timeptr->tm_mon += result.quot;
-        timeptr->tm_mday = result.rem;
-    }
-
-    /*
-            Cleanup and return
-        */
+    z = days + Y2K_DAYS + 719468L;
+    era = z / 146097L;
+    doe = z - era * 146097L;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+
+    timeptr->tm_mday = doy - (153 * mp + 2) / 5 + 1;
+    timeptr->tm_mon = mp < 10 ? mp + 2 : mp - 10;
+    year = yoe + era * 400 + (timeptr->tm_mon < 2);
+
+    timeptr->tm_year = year - 1900;
+    timeptr->tm_yday = timeptr->tm_mon < 2 ? doy - 306 : doy + 59 + is_leap_year(year);
     timeptr->tm_isdst = 0;  /* gmt is never in DST */
-    timeptr->tm_mday++; /* tm_mday is 1 based */
-
 }
@@ -36,68 +36,31 @@
 
 #include "time.h"
 
+/* Days from 1970-01-01 to 2000-01-01. */
+#define Y2K_DAYS 10957L
+
 time_t
 mk_gmtime(const struct tm * timeptr)
 {
-
     time_t          ret;
-    uint32_t        tmp;
-    int16_t         n, m, d, leaps;
+    uint32_t        tmp, era, yoe, doy, doe;
+    int16_t         year, month;
 
     /*
-        Determine elapsed whole days since the epoch to the beginning of this year. Since our epoch is
-        at a conjunction of the leap cycles, we can do this rather quickly.
-        */
-    n = timeptr->tm_year - 100;
-    leaps = 0;
-    if (n) {
-        m = n - 1;
-        leaps = m / 4;
-        leaps -= m / 100;
-        leaps++;
-    }
-    tmp = 365UL * n + leaps;
-
-    /*
-                Derive the day of year from month and day of month. We use the pattern of 31 day months
-                followed by 30 day months to our advantage, but we must 'special case' Jan/Feb, and
-                account for a 'phase change' between July and August (153 days after March 1).
-            */
-    d = timeptr->tm_mday - 1;   /* tm_mday is one based */
-
-    /* handle Jan/Feb as a special case */
-    if (timeptr->tm_mon < 2) {
-        if (timeptr->tm_mon)
-            d += 31;
-
-    } else {
-        n = 59 + is_leap_year(timeptr->tm_year + 1900);
-        d += n;
-        n = timeptr->tm_mon - MARCH;
-
-        /* account for phase change */
-        if (n > (JULY - MARCH))
-            d += 153;
-        n %= 5;
-
-        /*
-         * n is now an index into a group of alternating 31 and 30
-         * day months... 61 day pairs.
-         */
-        m = n / 2;
-        m *= 61;
-        d += m;
-
-        /*
-         * if n is odd, we are in the second half of the
-         * month pair
-         */
-        if (n & 1)
-            d += 31;
-    }
-
-    /* Add day of year to elapsed days, and convert to seconds */
-    tmp += d;
+     * Determine the elapsed days since the epoch in constant time, on a calendar that starts on
+     * March 1st. See http://howardhinnant.github.io/date_algorithms.html (days_from_civil).
+     */
+    year = timeptr->tm_year + 1900;
+    month = timeptr->tm_mon + 1;
+    year -= month <= 2;
+
+    era = year / 400;
+    yoe = year - era * 400;
+    doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + timeptr->tm_mday - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    /* convert to seconds */
+    tmp = era * 146097L + doe - 719468L - Y2K_DAYS;
     tmp *= ONE_DAY;
     ret = tmp;
 
@@ -0,0 +1,580 @@
+/*
+ * Compressed time-series store.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/device/sram23k256.h>
+#include <lwiot/device/sensorscheduler.h>
+#include <lwiot/util/measurementvector.h>
+#include <lwiot/util/samplebatch.h>
+#include <lwiot/util/timeseriesstore.h>
+
+#define BLOCK_MAGIC0 'T'
+#define BLOCK_MAGIC1 'S'
+
+/* Largest encoding of a point: a 32 bit timestamp and a value with a new window. */
+#define MAX_POINT_BITS (4 + 32 + 2 + 5 + 6 + 64)
+
+namespace lwiot
+{
+	static constexpr size_t SramSize = 32768;
+
+	/* CRC-16/CCITT */
+	static uint16_t crc16(uint16_t crc, const uint8_t *data, size_t length)
+	{
+		for(size_t idx = 0; idx < length; idx++) {
+			crc ^= static_cast<uint16_t>(data[idx] << 8);
+
+			for(int bit = 0; bit < 8; bit++)
+				crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+		}
+
+		return crc;
+	}
+
+	static void store(uint8_t *data, uint64_t value, int bytes)
+	{
+		for(int idx = bytes - 1; idx >= 0; idx--) {
+			data[idx] = static_cast<uint8_t>(value & 0xFF);
+			value >>= 8;
+		}
+	}
+
+	static uint64_t load(const uint8_t *data, int bytes)
+	{
+		uint64_t value = 0;
+
+		for(int idx = 0; idx < bytes; idx++)
+			value = (value << 8) | data[idx];
+
+		return value;
+	}
+
+	static void put(uint8_t *data, size_t &bit, uint64_t value, int count)
+	{
+		while(count-- > 0) {
+			uint8_t mask = 0x80 >> (bit & 7);
+
+			if((value >> count) & 1)
+				data[bit >> 3] |= mask;
+			else
+				data[bit >> 3] &= ~mask;
+
+			bit++;
+		}
+	}
+
+	static uint64_t get(const uint8_t *data, size_t &bit, int count)
+	{
+		uint64_t value = 0;
+
+		while(count-- > 0) {
+			value = (value << 1) | ((data[bit >> 3] >> (7 - (bit & 7))) & 1);
+			bit++;
+		}
+
+		return value;
+	}
+
+	static int64_t extend(uint64_t value, int bits)
+	{
+		return static_cast<int64_t>(value << (64 - bits)) >> (64 - bits);
+	}
+
+	TimeSeriesStore::TimeSeriesStore(size_t blocks, size_t blocksize) :
+		_blocks(blocks), _blocksize(blocksize), _block(new uint8_t[blocksize]), _head(0), _sealed(0),
+		_sequence(1), _loaded(false)
+	{
+		memset(&this->_state, 0, sizeof(this->_state));
+		this->reset();
+	}
+
+	TimeSeriesStore::~TimeSeriesStore()
+	{
+		delete[] this->_block;
+	}
+
+	/* Start a new block. The newest timestamp is kept, to keep timestamps in order. */
+	void TimeSeriesStore::reset()
+	{
+		memset(this->_block, 0, this->_blocksize);
+
+		this->_state.bits = 0;
+		this->_state.count = 0;
+		this->_state.delta = 0;
+		this->_state.leading = -1;
+		this->_state.trailing = 0;
+	}
+
+	bool TimeSeriesStore::header(size_t slot, Header &header)
+	{
+		uint8_t raw[24];
+
+		if(!this->read(slot * this->_blocksize, raw, sizeof(raw)))
+			return false;
+
+		if(raw[0] != BLOCK_MAGIC0 || raw[1] != BLOCK_MAGIC1)
+			return false;
+
+		header.sequence = static_cast<uint32_t>(load(raw + 2, 4));
+		header.count = static_cast<size_t>(load(raw + 6, 2));
+		header.first = static_cast<int64_t>(load(raw + 8, 8));
+		header.last = static_cast<int64_t>(load(raw + 16, 8));
+
+		return header.sequence != 0;
+	}
+
+	/*
+	 * Find the newest block; new points go into the slot after it. Stored blocks are not
+	 * appended to, so a block that was flushed before a reset stays partly empty.
+	 */
+	void TimeSeriesStore::scan()
+	{
+		Header best, header;
+		bool found = false;
+
+		if(this->_loaded)
+			return;
+
+		this->_loaded = true;
+
+		for(size_t slot = 0; slot < this->_blocks; slot++) {
+			if(!this->header(slot, header) || (found && header.sequence < best.sequence))
+				continue;
+
+			best = header;
+			this->_head = slot;
+			found = true;
+		}
+
+		if(!found)
+			return;
+
+		auto slot = this->_head;
+
+		this->_sequence = best.sequence + 1;
+		this->_state.last = best.last;
+		this->_head = (slot + 1) % this->_blocks;
+
+		/* Count the consecutive blocks that lead up to the newest one. */
+		while(this->_sealed < this->_blocks - 1 && this->header(slot, header) &&
+			header.sequence == best.sequence - this->_sealed) {
+			this->_sealed++;
+			slot = (slot + this->_blocks - 1) % this->_blocks;
+		}
+	}
+
+	/* Fill in the header of \p block. */
+	void TimeSeriesStore::finish(uint8_t *block, uint32_t sequence, const State &state) const
+	{
+		block[0] = BLOCK_MAGIC0;
+		block[1] = BLOCK_MAGIC1;
+		store(block + 2, sequence, 4);
+		store(block + 6, state.count, 2);
+		store(block + 8, static_cast<uint64_t>(state.first), 8);
+		store(block + 16, static_cast<uint64_t>(state.last), 8);
+
+		auto crc = crc16(crc16(0xFFFF, block, 24), block + BlockHeader, this->_blocksize - BlockHeader);
+
+		store(block + 24, crc, 2);
+		block[26] = block[27] = 0;
+	}
+
+	bool TimeSeriesStore::seal()
+	{
+		this->finish(this->_block, this->_sequence, this->_state);
+
+		if(!this->write(this->_head * this->_blocksize, this->_block, this->_blocksize))
+			return false;
+
+		this->_head = (this->_head + 1) % this->_blocks;
+		this->_sequence++;
+
+		/* The slot after the head holds the oldest block, which is about to be overwritten. */
+		if(this->_sealed < this->_blocks - 1)
+			this->_sealed++;
+
+		this->reset();
+		return true;
+	}
+
+	bool TimeSeriesStore::add(time_t timestamp, double value)
+	{
+		ScopedLock lock(this->_lock);
+
+		this->scan();
+		return this->append(static_cast<int64_t>(timestamp), value);
+	}
+
+	size_t TimeSeriesStore::add(const SampleBatch &batch, uint16_t sensor)
+	{
+		ScopedLock lock(this->_lock);
+		auto timestamps = batch.timestamps();
+		auto sensors = batch.sensors();
+		auto values = batch.values();
+		size_t num = 0;
+
+		this->scan();
+
+		for(size_t idx = 0; idx < batch.size(); idx++) {
+			if(sensors[idx] != sensor)
+				continue;
+
+			if(!this->append(static_cast<int64_t>(timestamps[idx]), static_cast<double>(values[idx])))
+				break;
+
+			num++;
+		}
+
+		return num;
+	}
+
+	/* Encode a point into the block that is being filled. Must be called with the lock held. */
+	bool TimeSeriesStore::append(int64_t ts, double value)
+	{
+		auto& state = this->_state;
+		auto payload = this->_block + BlockHeader;
+		uint64_t bits;
+
+		if(ts < state.last)
+			return false;
+
+		if(state.count > 0) {
+			auto dod = (ts - state.last) - state.delta;
+			auto full = state.bits + MAX_POINT_BITS > (this->_blocksize - BlockHeader) * 8;
+
+			if((full || state.count == UINT16_MAX || dod < INT32_MIN || dod > INT32_MAX) && !this->seal())
+				return false;
+		}
+
+		memcpy(&bits, &value, sizeof(bits));
+
+		if(state.count == 0) {
+			state.first = state.last = ts;
+			state.value = bits;
+			state.count = 1;
+			put(payload, state.bits, bits, 64);
+
+			return true;
+		}
+
+		auto delta = ts - state.last;
+		auto dod = delta - state.delta;
+
+		if(dod == 0) {
+			put(payload, state.bits, 0, 1);
+		} else if(dod >= -64 && dod <= 63) {
+			put(payload, state.bits, 2, 2);
+			put(payload, state.bits, static_cast<uint64_t>(dod), 7);
+		} else if(dod >= -256 && dod <= 255) {
+			put(payload, state.bits, 6, 3);
+			put(payload, state.bits, static_cast<uint64_t>(dod), 9);
+		} else if(dod >= -2048 && dod <= 2047) {
+			put(payload, state.bits, 14, 4);
+			put(payload, state.bits, static_cast<uint64_t>(dod), 12);
+		} else {
+			put(payload, state.bits, 15, 4);
+			put(payload, state.bits, static_cast<uint64_t>(dod), 32);
+		}
+
+		auto xored = bits ^ state.value;
+
+		if(xored == 0) {
+			put(payload, state.bits, 0, 1);
+		} else {
+			int leading = __builtin_clzll(xored);
+			int trailing = __builtin_ctzll(xored);
+
+			if(leading > 31)
+				leading = 31;
+
+			if(state.leading >= 0 && leading >= state.leading && trailing >= state.trailing) {
+				/* The meaningful bits fit in the window of the previous value. */
+				put(payload, state.bits, 2, 2);
+				put(payload, state.bits, xored >> state.trailing, 64 - state.leading - state.trailing);
+			} else {
+				auto significant = 64 - leading - trailing;
+
+				put(payload, state.bits, 3, 2);
+				put(payload, state.bits, static_cast<uint64_t>(leading), 5);
+				put(payload, state.bits, static_cast<uint64_t>(significant & 0x3F), 6);
+				put(payload, state.bits, xored >> trailing, significant);
+
+				state.leading = leading;
+				state.trailing = trailing;
+			}
+		}
+
+		state.delta = delta;
+		state.last = ts;
+		state.value = bits;
+		state.count++;
+
+		return true;
+	}
+
+	bool TimeSeriesStore::add(const SensorReading &reading, size_t index)
+	{
+		if(!reading.ok || index >= reading.count)
+			return false;
+
+		return this->add(reading.timestamp, static_cast<double>(reading.values[index]));
+	}
+
+	bool TimeSeriesStore::add(time_t timestamp, const MeasurementVector &vector)
+	{
+		return this->add(timestamp, vector.smooth());
+	}
+
+	bool TimeSeriesStore::flush()
+	{
+		ScopedLock lock(this->_lock);
+
+		this->scan();
+
+		if(this->_state.count == 0)
+			return true;
+
+		this->finish(this->_block, this->_sequence, this->_state);
+		return this->write(this->_head * this->_blocksize, this->_block, this->_blocksize);
+	}
+
+	/* Copy the block with \p sequence into \p block. */
+	bool TimeSeriesStore::fetch(uint32_t sequence, uint8_t *block)
+	{
+		if(sequence == this->_sequence) {
+			memcpy(block, this->_block, this->_blocksize);
+			this->finish(block, sequence, this->_state);
+
+			return this->_state.count > 0;
+		}
+
+		if(sequence > this->_sequence || this->_sequence - sequence > this->_sealed)
+			return false;
+
+		auto slot = (this->_head + this->_blocks - (this->_sequence - sequence)) % this->_blocks;
+
+		if(!this->read(slot * this->_blocksize, block, this->_blocksize))
+			return false;
+
+		if(block[0] != BLOCK_MAGIC0 || block[1] != BLOCK_MAGIC1 || load(block + 2, 4) != sequence)
+			return false;
+
+		auto crc = crc16(crc16(0xFFFF, block, 24), block + BlockHeader, this->_blocksize - BlockHeader);
+		return crc == load(block + 24, 2);
+	}
+
+	/* Sequence number of the first block that may hold points at or after \p from. */
+	size_t TimeSeriesStore::find(time_t from)
+	{
+		size_t low = 0;
+		size_t high = this->_sealed;
+		Header header;
+
+		while(low < high) {
+			auto middle = (low + high) / 2;
+			auto slot = (this->_head + this->_blocks - this->_sealed + middle) % this->_blocks;
+
+			if(!this->header(slot, header) || header.last < static_cast<int64_t>(from))
+				low = middle + 1;
+			else
+				high = middle;
+		}
+
+		return this->_sequence - this->_sealed + low;
+	}
+
+	size_t TimeSeriesStore::decode(const uint8_t *block, time_t from, time_t to, const Visitor &visitor, bool &stop) const
+	{
+		auto payload = block + BlockHeader;
+		auto count = static_cast<size_t>(load(block + 6, 2));
+		auto ts = static_cast<int64_t>(load(block + 8, 8));
+		auto begin = static_cast<int64_t>(from);
+		auto end = static_cast<int64_t>(to);
+		int64_t delta = 0;
+		int leading = 0, trailing = 0;
+		size_t bit = 0;
+		size_t visited = 0;
+		double value;
+
+		auto bits = get(payload, bit, 64);
+
+		for(size_t idx = 0; idx < count; idx++) {
+			if(idx > 0) {
+				int64_t dod = 0;
+
+				if(get(payload, bit, 1)) {
+					if(!get(payload, bit, 1))
+						dod = extend(get(payload, bit, 7), 7);
+					else if(!get(payload, bit, 1))
+						dod = extend(get(payload, bit, 9), 9);
+					else if(!get(payload, bit, 1))
+						dod = extend(get(payload, bit, 12), 12);
+					else
+						dod = extend(get(payload, bit, 32), 32);
+				}
+
+				delta += dod;
+				ts += delta;
+
+				if(get(payload, bit, 1)) {
+					if(get(payload, bit, 1)) {
+						leading = static_cast<int>(get(payload, bit, 5));
+						auto significant = static_cast<int>(get(payload, bit, 6));
+
+						if(significant == 0)
+							significant = 64;
+
+						trailing = 64 - leading - significant;
+					}
+
+					bits ^= get(payload, bit, 64 - leading - trailing) << trailing;
+				}
+			}
+
+			if(ts < begin)
+				continue;
+
+			if(ts > end) {
+				stop = true;
+				break;
+			}
+
+			memcpy(&value, &bits, sizeof(value));
+			visited++;
+
+			if(!visitor(static_cast<time_t>(ts), value)) {
+				stop = true;
+				break;
+			}
+		}
+
+		return visited;
+	}
+
+	size_t TimeSeriesStore::query(time_t from, time_t to, const Visitor &visitor)
+	{
+		ByteBuffer block(this->_blocksize, true);
+		uint32_t sequence;
+		size_t visited = 0;
+		bool stop = false;
+
+		this->_lock.lock();
+		this->scan();
+		sequence = static_cast<uint32_t>(this->find(from));
+		this->_lock.unlock();
+
+		while(!stop) {
+			this->_lock.lock();
+
+			auto newest = this->_sequence;
+			auto found = this->fetch(sequence, block.data());
+
+			this->_lock.unlock();
+
+			if(sequence > newest)
+				break;
+
+			sequence++;
+
+			if(!found)
+				continue;
+
+			if(static_cast<int64_t>(load(block.data() + 8, 8)) > static_cast<int64_t>(to))
+				break;
+
+			visited += this->decode(block.data(), from, to, visitor, stop);
+		}
+
+		return visited;
+	}
+
+	bool TimeSeriesStore::empty()
+	{
+		ScopedLock lock(this->_lock);
+
+		this->scan();
+		return this->_sealed == 0 && this->_state.count == 0;
+	}
+
+	void TimeSeriesStore::clear()
+	{
+		ScopedLock lock(this->_lock);
+		const uint8_t header[BlockHeader] = {};
+
+		for(size_t slot = 0; slot < this->_blocks; slot++)
+			this->write(slot * this->_blocksize, header, sizeof(header));
+
+		this->_head = 0;
+		this->_sealed = 0;
+		this->_state.last = 0;
+		this->_loaded = true;
+		this->reset();
+	}
+
+#ifdef HAVE_UNISTD_H
+	FileTimeSeriesStore::FileTimeSeriesStore(const String &path, size_t blocks, size_t blocksize) :
+		TimeSeriesStore(blocks, blocksize), _file(new File(path, FileMode::ReadWriteNoCreate))
+	{
+		if(*this->_file && this->_file->size() >= this->storage())
+			return;
+
+		/* Create the file with every block empty. */
+		File create(path, FileMode::Write);
+		uint8_t zero[BlockHeader] = {};
+
+		for(size_t offset = 0; create && offset < this->storage(); offset += sizeof(zero))
+			create.write(zero, sizeof(zero));
+
+		create.flush();
+		this->_file.reset(new File(path, FileMode::ReadWriteNoCreate));
+	}
+
+	bool FileTimeSeriesStore::read(size_t offset, void *data, size_t length)
+	{
+		if(!*this->_file || !this->_file->seek(offset))
+			return false;
+
+		return this->_file->read(data, length) == static_cast<ssize_t>(length);
+	}
+
+	bool FileTimeSeriesStore::write(size_t offset, const void *data, size_t length)
+	{
+		if(!*this->_file || offset + length > this->storage() || !this->_file->seek(offset))
+			return false;
+
+		return this->_file->write(data, length) == static_cast<ssize_t>(length) && this->_file->flush();
+	}
+#endif
+
+	SramTimeSeriesStore::SramTimeSeriesStore(SRAM23K256& sram, size_t base, size_t blocks, size_t blocksize) :
+		TimeSeriesStore(blocks, blocksize), _sram(sram), _base(base)
+	{
+	}
+
+	bool SramTimeSeriesStore::read(size_t offset, void *data, size_t length)
+	{
+		if(this->_base + offset + length > SramSize)
+			return false;
+
+		return this->_sram.read(this->_base + offset, data, length) == static_cast<ssize_t>(length);
+	}
+
+	bool SramTimeSeriesStore::write(size_t offset, const void *data, size_t length)
+	{
+		if(this->_base + offset + length > SramSize)
+			return false;
+
+		return this->_sram.write(this->_base + offset, data, length) == static_cast<ssize_t>(length);
+	}
+}
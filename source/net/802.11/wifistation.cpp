@@ -6,16 +6,36 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <lwiot.h>
 
+#include <lwiot/log.h>
 #include <lwiot/stl/string.h>
+#include <lwiot/stl/hash.h>
+#include <lwiot/util/keyvaluestore.h>
 
 #include <lwiot/network/ipaddress.h>
 #include <lwiot/network/wifistation.h>
 
 namespace lwiot
 {
-	WifiStation::WifiStation() : _addr(0U), _status(WL_DISCONNECTED), _ssid(""), _password("")
+	/* Stored link: version, SSID hash, BSSID, channel and four IPv4 addresses. */
+	static constexpr uint8_t LinkVersion = 1;
+	static constexpr size_t LinkLength = 1 + sizeof(uint32_t) + 6 + 1 + 4 * 4;
+
+	static IPAddress read_address(const uint8_t *data)
+	{
+		return IPAddress(data[0], data[1], data[2], data[3]);
+	}
+
+	static void write_address(uint8_t *data, const IPAddress& addr)
+	{
+		for(int idx = 0; idx < 4; idx++)
+			data[idx] = addr[idx];
+	}
+
+	WifiStation::WifiStation() : _addr(0U), _status(WL_DISCONNECTED), _ssid(""), _password(""), _store(nullptr),
+		_timing()
 	{
 	}
 
@@ -57,4 +77,169 @@ namespace lwiot
 		this->_password = "";
 		this->_status = WL_DISCONNECTED;
 	}
+
+	bool WifiStation::connect(const String& ssid, const String& password, int tmo)
+	{
+		Link link;
+		time_t associated;
+		auto start = lwiot_tick_ms();
+
+		memset(&this->_timing, 0, sizeof(this->_timing));
+
+		if(this->_store != nullptr && this->load(ssid, link)) {
+			this->_addr = IPAddress(0U);
+			this->_status = WL_IDLE_STATUS;
+
+			if(this->resume(ssid, password, link)) {
+				if(this->await(start, CONFIG_WIFI_FAST_TIMEOUT, false)) {
+					associated = lwiot_tick_ms();
+
+					if(this->await(start, CONFIG_WIFI_FAST_TIMEOUT, true)) {
+						this->_timing.fast = true;
+						this->_timing.stored = true;
+						this->_timing.associate = associated - start;
+						this->_timing.address = lwiot_tick_ms() - associated;
+						this->_timing.total = lwiot_tick_ms() - start;
+
+						return true;
+					}
+				}
+
+				print_dbg("Fast reconnect to %s failed, scanning instead\n", ssid.c_str());
+				this->disconnect();
+				this->_store->remove(CONFIG_WIFI_LINK_KEY);
+			}
+		}
+
+		auto begin = lwiot_tick_ms();
+
+		this->_timing.resume = begin - start;
+		this->_addr = IPAddress(0U);
+		this->_status = WL_IDLE_STATUS;
+		this->connectTo(ssid, password);
+
+		if(!this->await(begin, tmo, false)) {
+			this->_timing.total = lwiot_tick_ms() - start;
+			return false;
+		}
+
+		associated = lwiot_tick_ms();
+		this->_timing.associate = associated - begin;
+
+		if(!this->await(begin, tmo, true)) {
+			this->_timing.total = lwiot_tick_ms() - start;
+			return false;
+		}
+
+		this->_timing.address = lwiot_tick_ms() - associated;
+		this->_timing.total = lwiot_tick_ms() - start;
+
+		if(this->_store != nullptr && this->link(link))
+			this->_timing.stored = this->save(ssid, link);
+
+		return true;
+	}
+
+	void WifiStation::setFastReconnect(KeyValueStore& store)
+	{
+		this->_store = &store;
+	}
+
+	void WifiStation::clearFastReconnect()
+	{
+		if(this->_store == nullptr)
+			return;
+
+		this->_store->remove(CONFIG_WIFI_LINK_KEY);
+		this->_store = nullptr;
+	}
+
+	const WifiStation::Timing& WifiStation::timing() const
+	{
+		return this->_timing;
+	}
+
+	bool WifiStation::link(Link& link) const
+	{
+		UNUSED(link);
+		return false;
+	}
+
+	bool WifiStation::resume(const String& ssid, const String& password, const Link& link)
+	{
+		UNUSED(ssid);
+		UNUSED(password);
+		UNUSED(link);
+
+		return false;
+	}
+
+	bool WifiStation::await(time_t start, int tmo, bool address) const
+	{
+		while(lwiot_tick_ms() - start < static_cast<time_t>(tmo)) {
+			auto status = this->_status;
+
+			if(status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL)
+				return false;
+
+			if(status == WL_CONNECTED && (!address || static_cast<uint32_t>(this->_addr) != 0))
+				return true;
+
+			lwiot_sleep(CONFIG_WIFI_POLL_INTERVAL);
+		}
+
+		return false;
+	}
+
+	bool WifiStation::load(const String& ssid, Link& link) const
+	{
+		uint8_t record[LinkLength];
+		uint32_t hash;
+
+		if(this->_store->get(CONFIG_WIFI_LINK_KEY, record, sizeof(record)) != static_cast<ssize_t>(sizeof(record)))
+			return false;
+
+		memcpy(&hash, &record[1], sizeof(hash));
+
+		if(record[0] != LinkVersion || hash != static_cast<uint32_t>(stl::Hash<String>()(ssid)))
+			return false;
+
+		memcpy(link.bssid, &record[5], sizeof(link.bssid));
+		link.channel = record[11];
+		link.address = read_address(&record[12]);
+		link.gateway = read_address(&record[16]);
+		link.netmask = read_address(&record[20]);
+		link.dns = read_address(&record[24]);
+
+		return true;
+	}
+
+	bool WifiStation::save(const String& ssid, const Link& link) const
+	{
+		uint8_t record[LinkLength];
+		uint32_t hash = static_cast<uint32_t>(stl::Hash<String>()(ssid));
+
+		record[0] = LinkVersion;
+		memcpy(&record[1], &hash, sizeof(hash));
+		memcpy(&record[5], link.bssid, sizeof(link.bssid));
+		record[11] = link.channel;
+		write_address(&record[12], link.address);
+		write_address(&record[16], link.gateway);
+		write_address(&record[20], link.netmask);
+		write_address(&record[24], link.dns);
+
+		/* Rewriting an identical record would only wear the store. */
+		uint8_t current[LinkLength];
+
+		if(this->_store->get(CONFIG_WIFI_LINK_KEY, current, sizeof(current)) == static_cast<ssize_t>(sizeof(current)) &&
+				memcmp(current, record, sizeof(record)) == 0)
+			return true;
+
+		if(!this->_store->set(CONFIG_WIFI_LINK_KEY, record, sizeof(record))) {
+			print_dbg("Unable to store WiFi link\n");
+			return false;
+		}
+
+		return true;
+	}
 }
@@ -9,15 +9,44 @@
 #include <stdio.h>
 #include <lwiot.h>
 
+#include <lwiot/stl/vector.h>
 #include <lwiot/network/stdnet.h>
 
 #include <lwiot/network/xbee/xbee.h>
 #include <lwiot/network/xbee/asyncxbee.h>
+#include <lwiot/kernel/clock.h>
+#include <lwiot/util/trace.h>
 
 namespace lwiot
 {
-	AsyncXbee::AsyncXbee() : Thread("axbee"), _lock(false), _running(false)
+	enum TxStatus {
+		TxIdle,
+		TxPending,
+		TxSuccess,
+		TxFailed
+	};
+
+	AsyncXbee::AsyncXbee() : Thread("axbee"), _lock(false), _running(false),
+		_rx(EventType::Counting), _tx_lock(false), _tx_done(EventType::Counting), _tx_status(TxIdle),
+		_buffer(nullptr), _at_lock(false), _write_lock(false), _window_lock(false), _completing(0)
+	{
+		for(auto& pending : this->_pending)
+			pending.id = 0;
+
+		for(auto& entry : this->_outstanding) {
+			entry.id = 0;
+			entry.sent = false;
+		}
+
+		/* A receiver that ran out of frames continues as soon as one is released. */
+		this->_frames.setReleaseHandler([this]() {
+			this->_rx.signal();
+		});
+	}
+
+	static uint64_t destination(const ZigbeeAddress& addr)
 	{
+		return addr.is64Bit() ? addr.getAddress64() : addr.getAddress16();
 	}
 
 	AsyncXbee::AsyncXbee(lwiot::XBee &xb) : AsyncXbee()
@@ -51,8 +80,17 @@ namespace lwiot
 
 	AsyncXbee::~AsyncXbee()
 	{
-		ScopedLock lock(this->_lock);
+		UniqueLock<Lock> lock(this->_lock);
+		auto running = this->_running;
+
 		this->_running = false;
+		lock.unlock();
+
+		/* The receive thread decodes from the ring, which goes with this object. */
+		if(running && this->_ring) {
+			this->_rx.signal();
+			this->join();
+		}
 	}
 
 	void AsyncXbee::setHandler(const ResponseHandler &handler)
@@ -61,21 +99,709 @@ namespace lwiot
 		this->_handler = handler;
 	}
 
+	void AsyncXbee::setFrameHandler(const FrameHandler &handler)
+	{
+		ScopedLock lock(this->_lock);
+		this->_frame_handler = handler;
+	}
+
+	void AsyncXbee::setReceiveMode(ReceiveMode mode)
+	{
+		ScopedLock lock(this->_lock);
+
+		if(mode == ReceiveMode::Pushed) {
+			if(!this->_ring)
+				this->_ring.reset(new detail::SpscRing(CONFIG_XBEE_RX_RING));
+		} else {
+			this->_ring.reset();
+		}
+
+		this->_xb._ring = this->_ring.get();
+	}
+
+	size_t AsyncXbee::receive(const void *data, size_t length)
+	{
+		if(!this->_ring)
+			return 0;
+
+		auto rv = this->_ring->push(data, length);
+
+		XBEE_PROFILE(if(rv < length) this->_xb._stats.overrun(length - rv));
+
+		this->_rx.signal();
+		return rv;
+	}
+
+	size_t AsyncXbee::receiveFromIrq(const void *data, size_t length)
+	{
+		if(!this->_ring)
+			return 0;
+
+		auto rv = this->_ring->push(data, length);
+
+		XBEE_PROFILE(if(rv < length) this->_xb._stats.overrun(length - rv));
+
+		this->_rx.signalFromIrq();
+		return rv;
+	}
+
+	XBeeStats AsyncXbee::stats() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_xb.stats();
+	}
+
 	void AsyncXbee::run()
+	{
+		if(this->_ring)
+			this->decode();
+		else
+			this->poll();
+	}
+
+	void AsyncXbee::decode()
 	{
 		while(true) {
-			Thread::sleep(100);
+			this->_rx.wait(this->timeout());
 			UniqueLock<Lock> lock(this->_lock);
 
-			if(!this->_running || !this->_handler)
+			if(!this->_running || !(this->_handler || this->_frame_handler))
 				break;
 
+			XBEE_PROFILE(this->_xb._stats.queued(this->_ring->size()));
+
+			this->expire(lock);
+			this->retransmit(lock);
+
+			/* Decode everything in the ring, or until every frame is in use. */
+			while(this->arm()) {
+				this->_xb.readPacket();
+
+				auto& response = this->_xb.getResponse();
+
+				if(response.isError())
+					continue;
+
+				if(!response.isAvailable())
+					break;
+
+				auto frame = this->take();
+				auto& parsed = frame.response();
+
+				if(this->deliver(parsed, lock) || this->acknowledge(parsed) || this->complete(parsed, lock))
+					continue;
+
+				this->dispatch(frame, lock);
+			}
+		}
+	}
+
+	bool AsyncXbee::arm()
+	{
+		if(this->_buffer != nullptr)
+			return true;
+
+		/* The parser may only switch buffers between frames. */
+		if(this->_xb._pos != 0)
+			return false;
+
+		this->_buffer = this->_frames.acquire();
+
+		if(this->_buffer == nullptr)
+			return false;
+
+		this->_xb._response.setFrameData(this->_buffer);
+		return true;
+	}
+
+	XBeeFrame AsyncXbee::take()
+	{
+		auto frame = this->_frames.commit(this->_xb.getResponse());
+
+		this->_buffer = nullptr;
+		this->_xb._response.setFrameData(this->_xb._responseFrameData);
+		this->_xb.resetResponse();
+		this->arm();
+
+		return frame;
+	}
+
+	void AsyncXbee::dispatch(const XBeeFrame &frame, UniqueLock<Lock> &lock)
+	{
+		auto handler = this->_handler;
+		auto frame_handler = this->_frame_handler;
+
+#ifdef CONFIG_XBEE_PROFILING
+		/* Frames are dispatched right after they were parsed, before the next one is. */
+		auto completed = this->_xb._completed;
+		auto called = Clock::now();
+#endif
+
+		/* Handlers run without the lock, so that they can transmit. */
+		lock.unlock();
+
+		{
+			TRACE_SPAN("xbee-dispatch");
+
+			if(frame_handler)
+				frame_handler(frame);
+			else
+				handler(frame.response());
+		}
+
+		lock.lock();
+
+#ifdef CONFIG_XBEE_PROFILING
+		this->_xb._stats.dispatched(frame.response().getApiId(), completed, called, Clock::now());
+#endif
+	}
+
+	bool AsyncXbee::acknowledge(XBeeResponse &response)
+	{
+		bool success;
+
+		if(response.getApiId() == ZB_TX_STATUS_RESPONSE) {
+			ZBTxStatusResponse status;
+
+			response.getZBTxStatusResponse(status);
+			success = status.isSuccess();
+		} else if(response.getApiId() == TX_STATUS_RESPONSE) {
+			TxStatusResponse status;
+
+			response.getTxStatusResponse(status);
+			success = status.isSuccess();
+		} else {
+			return false;
+		}
+
+		int expected = TxPending;
+
+		/* A status that nobody waits for is passed to the handler. */
+		if(!this->_tx_status.compare_exchange_strong(expected, success ? TxSuccess : TxFailed))
+			return false;
+
+		this->_tx_done.signal();
+		return true;
+	}
+
+	bool AsyncXbee::complete(XBeeResponse &response, UniqueLock<Lock> &lock)
+	{
+		AtCommandResponse at;
+		CommandHandler handler;
+
+		if(response.getApiId() != AT_COMMAND_RESPONSE)
+			return false;
+
+		response.getAtCommandResponse(at);
+
+		/* Responses to commands that were not issued through command() go to the handler. */
+		if(!this->claim(at.getFrameId(), handler))
+			return false;
+
+		ByteBuffer value(at.getValueLength() + 1U);
+		auto ok = at.isOk();
+
+		value.write(at.getValue(), at.getValueLength());
+		lock.unlock();
+		handler(ok, value);
+		lock.lock();
+
+		return true;
+	}
+
+	/* Time until the first command or transmission times out. */
+	int AsyncXbee::timeout() const
+	{
+		time_t deadline = 0;
+
+		{
+			ScopedLock pending(this->_at_lock);
+
+			for(auto& entry : this->_pending) {
+				if(entry.id != 0 && (deadline == 0 || entry.deadline < deadline))
+					deadline = entry.deadline;
+			}
+		}
+
+		{
+			ScopedLock window(this->_window_lock);
+
+			for(auto& entry : this->_outstanding) {
+				if(entry.id != 0 && (deadline == 0 || entry.deadline < deadline))
+					deadline = entry.deadline;
+			}
+		}
+
+		if(deadline == 0)
+			return FOREVER;
+
+		auto now = lwiot_tick_ms();
+		return deadline > now ? static_cast<int>(deadline - now) : 1;
+	}
+
+	void AsyncXbee::expire(UniqueLock<Lock> &lock)
+	{
+		auto now = lwiot_tick_ms();
+
+		while(true) {
+			UniqueLock<Lock> pending(this->_at_lock);
+			CommandHandler handler;
+
+			for(auto& entry : this->_pending) {
+				if(entry.id == 0 || entry.deadline > now)
+					continue;
+
+				handler = stl::move(entry.handler);
+				entry.id = 0;
+				break;
+			}
+
+			pending.unlock();
+
+			if(!handler)
+				break;
+
+			ByteBuffer empty;
+
+			lock.unlock();
+			handler(false, empty);
+			lock.lock();
+		}
+	}
+
+	bool AsyncXbee::claim(uint8_t id, CommandHandler &handler) const
+	{
+		ScopedLock lock(this->_at_lock);
+
+		for(auto& entry : this->_pending) {
+			if(entry.id != id)
+				continue;
+
+			handler = stl::move(entry.handler);
+			entry.id = 0;
+			return true;
+		}
+
+		return false;
+	}
+
+	uint8_t AsyncXbee::issue(const char *cmd, const uint8_t *value, size_t length, const CommandHandler &handler,
+	                         int tmo) const
+	{
+		AtCommandRequest rq((uint8_t *) cmd);
+		UniqueLock<Lock> lock(this->_ring ? this->_write_lock : this->_lock);
+		UniqueLock<Lock> pending(this->_at_lock);
+		PendingCommand *slot = nullptr;
+		uint8_t id = 0;
+
+		for(auto& entry : this->_pending) {
+			if(entry.id == 0) {
+				slot = &entry;
+				break;
+			}
+		}
+
+		if(slot == nullptr)
+			return 0;
+
+		/* Skip frame IDs that are still in flight after the counter wrapped. */
+		while(id == 0) {
+			id = this->_xb.getNextFrameId();
+
+			for(auto& entry : this->_pending) {
+				if(entry.id == id)
+					id = 0;
+			}
+		}
+
+		slot->id = id;
+		slot->deadline = lwiot_tick_ms() + tmo;
+		slot->handler = handler;
+		pending.unlock();
+
+		/* The receive thread has to wake up in time to expire the command. */
+		if(this->_ring)
+			this->_rx.signal();
+
+		if(length > 0) {
+			rq.setCommandValue((uint8_t *) value);
+			rq.setCommandValueLength(length);
+		}
+
+		/* The response is matched by the receive thread; no need to wait for it here. */
+		rq.setFrameId(id);
+		this->_xb.send(rq);
+
+		return id;
+	}
+
+	bool AsyncXbee::command(const char *cmd, const uint8_t *value, size_t length, const CommandHandler &handler,
+	                        int tmo) const
+	{
+		return this->issue(cmd, value, length, handler, tmo) != 0;
+	}
+
+	bool AsyncXbee::configure(const AtSetting *settings, size_t count, bool apply, int tmo) const
+	{
+		stl::Vector<uint8_t> ids(count + 1);
+		Event done(EventType::Counting, count + 1);
+		atomic_int_t failed(0);
+		int completed = 0;
+
+		auto handler = [&](bool ok, const ByteBuffer& value) {
+			if(!ok)
+				failed.store(1);
+
+			done.signal();
+		};
+
+		for(size_t idx = 0; idx < count; idx++) {
+			auto& setting = settings[idx];
+			auto id = this->issue(setting.command, setting.value, setting.length, handler, tmo);
+
+			if(id == 0)
+				failed.store(1);
+			else
+				ids.pushback(id);
+		}
+
+		if(apply) {
+			auto id = this->issue("AC", nullptr, 0, handler, tmo);
+
+			if(id == 0)
+				failed.store(1);
+			else
+				ids.pushback(id);
+		}
+
+		auto start = lwiot_tick_ms();
+
+		while(completed < static_cast<int>(ids.size())) {
+			auto remaining = tmo - static_cast<int>(lwiot_tick_ms() - start);
+
+			if(remaining <= 0 || !done.wait(remaining))
+				break;
+
+			completed++;
+		}
+
+		/* The handler refers to this stack frame; withdraw the commands that are still pending. */
+		for(size_t idx = 0; idx < ids.size(); idx++) {
+			CommandHandler pending;
+
+			if(this->claim(ids[idx], pending)) {
+				failed.store(1);
+				completed++;
+			}
+		}
+
+		while(completed < static_cast<int>(ids.size())) {
+			done.wait();
+			completed++;
+		}
+
+		return failed.load() == 0;
+	}
+
+	uint8_t AsyncXbee::nextTransmitId() const
+	{
+		uint8_t id = 0;
+
+		/* Frame IDs must be unique within the window, and differ from those of plain transmits. */
+		while(id == 0) {
+			id = this->_xb.getNextFrameId();
+
+			if(id == DEFAULT_FRAME_ID)
+				id = 0;
+
+			for(auto& entry : this->_outstanding) {
+				if(entry.id == id)
+					id = 0;
+			}
+		}
+
+		return id;
+	}
+
+	bool AsyncXbee::transmit(ZigbeeAddress addr, const ByteBuffer &buffer, const DeliveryHandler &handler) const
+	{
+		auto start = lwiot_tick_ms();
+
+		while(true) {
+			UniqueLock<Lock> lock(this->_ring ? this->_write_lock : this->_lock);
+			UniqueLock<Lock> window(this->_window_lock);
+
+			for(auto& entry : this->_outstanding) {
+				if(entry.id != 0)
+					continue;
+
+				entry.id = this->nextTransmitId();
+				entry.attempts = 1;
+				entry.sent = true;
+				entry.started = lwiot_tick_ms();
+				entry.deadline = entry.started + CONFIG_XBEE_TX_TIMEOUT;
+				entry.address = addr;
+				entry.payload = buffer;
+				entry.handler = handler;
+
+				auto id = entry.id;
+
+				window.unlock();
+
+				if(this->_ring)
+					this->_rx.signal();
+
+				this->_xb.send(addr, buffer, id);
+
+				return true;
+			}
+
+			lock.unlock();
+
+			auto remaining = CONFIG_XBEE_TX_TIMEOUT - static_cast<int>(lwiot_tick_ms() - start);
+
+			if(remaining <= 0 || !this->_window.wait(window, remaining))
+				return false;
+		}
+	}
+
+	bool AsyncXbee::flush(int tmo) const
+	{
+		auto start = lwiot_tick_ms();
+		UniqueLock<Lock> window(this->_window_lock);
+
+		while(true) {
+			bool idle = true;
+
+			for(auto& entry : this->_outstanding) {
+				if(entry.id != 0)
+					idle = false;
+			}
+
+			if(idle && this->_completing == 0)
+				return true;
+
+			if(tmo == FOREVER) {
+				this->_window.wait(window);
+				continue;
+			}
+
+			auto remaining = tmo - static_cast<int>(lwiot_tick_ms() - start);
+
+			if(remaining <= 0 || !this->_window.wait(window, remaining))
+				return false;
+		}
+	}
+
+	bool AsyncXbee::getDeliveryStats(uint64_t address, DeliveryStats &stats) const
+	{
+		ScopedLock lock(this->_window_lock);
+		auto iter = this->_delivery.find(address);
+
+		if(iter == this->_delivery.end())
+			return false;
+
+		stats = iter->value;
+		return true;
+	}
+
+	bool AsyncXbee::deliver(XBeeResponse &response, UniqueLock<Lock> &lock)
+	{
+		ZBTxStatusResponse status;
+
+		if(response.getApiId() != ZB_TX_STATUS_RESPONSE)
+			return false;
+
+		response.getZBTxStatusResponse(status);
+
+		auto now = lwiot_tick_ms();
+		auto success = status.isSuccess();
+		UniqueLock<Lock> window(this->_window_lock);
+
+		for(auto& entry : this->_outstanding) {
+			if(entry.id != status.getFrameId() || !entry.sent)
+				continue;
+
+			if(!success && this->retry(entry, now))
+				return true;
+
+			auto handler = this->finish(entry, success, now);
+
+			window.unlock();
+			lock.unlock();
+
+			if(handler)
+				handler(success);
+
+			this->settle();
+			lock.lock();
+			return true;
+		}
+
+		/* Not a windowed frame; it may belong to a plain transmit. */
+		return false;
+	}
+
+	void AsyncXbee::retransmit(UniqueLock<Lock> &lock)
+	{
+		while(true) {
+			auto now = lwiot_tick_ms();
+			UniqueLock<Lock> window(this->_window_lock);
+			Outstanding *due = nullptr;
+
+			for(auto& entry : this->_outstanding) {
+				if(entry.id != 0 && entry.deadline <= now) {
+					due = &entry;
+					break;
+				}
+			}
+
+			if(due == nullptr)
+				break;
+
+			if(due->sent) {
+				/* No transmit status arrived in time. */
+				if(this->retry(*due, now))
+					continue;
+
+				auto handler = this->finish(*due, false, now);
+
+				window.unlock();
+				lock.unlock();
+
+				if(handler)
+					handler(false);
+
+				this->settle();
+				lock.lock();
+				continue;
+			}
+
+			/*
+			 * Only this thread changes frames that are in the window, so the frame stays put
+			 * while the window is unlocked to take the write lock in the right order.
+			 */
+			window.unlock();
+
+			if(this->_ring)
+				this->_write_lock.lock();
+
+			window.lock();
+			due->id = this->nextTransmitId();
+			due->sent = true;
+			due->attempts++;
+			due->deadline = now + CONFIG_XBEE_TX_TIMEOUT;
+
+			auto id = due->id;
+
+			window.unlock();
+			this->_xb.send(due->address, due->payload, id);
+
+			if(this->_ring)
+				this->_write_lock.unlock();
+		}
+	}
+
+	bool AsyncXbee::retry(Outstanding &entry, time_t now)
+	{
+		if(entry.attempts > CONFIG_XBEE_TX_RETRIES)
+			return false;
+
+		entry.sent = false;
+		entry.deadline = now + (CONFIG_XBEE_TX_BACKOFF << (entry.attempts - 1));
+		this->_delivery[destination(entry.address)].retries++;
+
+		return true;
+	}
+
+	AsyncXbee::DeliveryHandler AsyncXbee::finish(Outstanding &entry, bool delivered, time_t now)
+	{
+		auto& stats = this->_delivery[destination(entry.address)];
+		auto handler = stl::move(entry.handler);
+
+		if(delivered) {
+			auto latency = now - entry.started;
+
+			stats.delivered++;
+			stats.latency += (latency - stats.latency) / static_cast<time_t>(stats.delivered);
+
+			if(latency > stats.maximum)
+				stats.maximum = latency;
+		} else {
+			stats.failed++;
+		}
+
+		entry.id = 0;
+		entry.sent = false;
+		entry.payload = ByteBuffer();
+		this->_completing++;
+		this->_window.broadcast();
+
+		return handler;
+	}
+
+	void AsyncXbee::settle()
+	{
+		ScopedLock lock(this->_window_lock);
+
+		/* Lets flush() return only after the delivery handlers have run. */
+		this->_completing--;
+		this->_window.broadcast();
+	}
+
+	template <typename Func>
+	bool AsyncXbee::transfer(Func&& send) const
+	{
+		if(!this->_ring) {
+			UniqueLock<Lock> lock(this->_lock);
+
+			send();
+			return this->validateTxRequest();
+		}
+
+		UniqueLock<Lock> lock(this->_tx_lock);
+
+		this->_tx_status.store(TxPending);
+
+		{
+			ScopedLock write(this->_write_lock);
+			send();
+		}
+
+		if(!this->_tx_done.wait(CONFIG_XBEE_TX_TIMEOUT)) {
+			int expected = TxPending;
+
+			if(this->_tx_status.compare_exchange_strong(expected, TxIdle))
+				return false;
+
+			/* The status arrived just after the timeout; its signal is on its way. */
+			this->_tx_done.wait();
+		}
+
+		return this->_tx_status.exchange(TxIdle) == TxSuccess;
+	}
+
+	void AsyncXbee::poll()
+	{
+		while(true) {
+			Thread::sleep(CONFIG_XBEE_RX_POLL);
+			UniqueLock<Lock> lock(this->_lock);
+
+			if(!this->_running || !(this->_handler || this->_frame_handler))
+				break;
+
+			this->expire(lock);
+			this->retransmit(lock);
+
+			if(!this->arm())
+				continue;
+
 			if(this->_xb.readPacket(500)) {
-				XBeeResponse rx;
+				auto frame = this->take();
+				auto& response = frame.response();
 
-				this->_xb.getResponse(rx);
-				this->_handler(rx);
-				this->_xb.resetResponse();
+				if(!this->deliver(response, lock) && !this->complete(response, lock))
+					this->dispatch(frame, lock);
 			}
 		}
 	}
@@ -137,6 +863,11 @@ namespace lwiot
 	void AsyncXbee::setDevice(lwiot::XBee &xb)
 	{
 		this->_xb = xb;
+
+		if(this->_buffer != nullptr)
+			this->_xb._response.setFrameData(this->_buffer);
+		else
+			this->_xb._response.setFrameData(this->_xb._responseFrameData);
 	}
 
 	XBee& AsyncXbee::getDevice()
@@ -146,7 +877,6 @@ namespace lwiot
 
 	bool AsyncXbee::transmit(const lwiot::String &data, uint16_t addr) const
 	{
-		UniqueLock<Lock> lock(this->_lock);
 		ZBExplicitTxRequest transmit;
 
 		transmit.setAddress64(0xFFFFFFFFFFFFFFFF);
@@ -157,41 +887,40 @@ namespace lwiot
 		transmit.setFrameId(DEFAULT_FRAME_ID);
 		transmit.setClusterId(DEFAULT_CLUSTER_ID);
 
-		this->_xb.send(transmit);
-		return this->validateTxRequest();
+		return this->transfer([&]() {
+			this->_xb.send(transmit);
+		});
 	}
 
 	bool AsyncXbee::transmit(const lwiot::String &data, uint64_t addr) const
 	{
-		UniqueLock<Lock> lock(this->_lock);
 		ZBExplicitTxRequest transmit;
 
 		transmit.setAddress64(addr);
-		transmit.setAddress16(0xFFFE);
+		transmit.setAddress16(this->_xb.resolve(addr));
 		transmit.setPayload((uint8_t *)data.c_str());
 		transmit.setPayloadLength(data.length());
 		transmit.setProfileId(DEFAULT_PROFILE_ID);
 		transmit.setFrameId(DEFAULT_FRAME_ID);
 		transmit.setClusterId(DEFAULT_CLUSTER_ID);
 
-		this->_xb.send(transmit);
-		return this->validateTxRequest();
+		return this->transfer([&]() {
+			this->_xb.send(transmit);
+		});
 	}
 
 	bool AsyncXbee::transmit(lwiot::ZigbeeAddress addr, const lwiot::ByteBuffer &buffer) const
 	{
-		UniqueLock<Lock> lock(this->_lock);
-
-		this->_xb.send(addr, buffer);
-		return this->validateTxRequest();
+		return this->transfer([&]() {
+			this->_xb.send(addr, buffer);
+		});
 	}
 
 	bool AsyncXbee::transmit(lwiot::ZigbeeAddress addr, const lwiot::ByteBuffer &buffer, uint16_t profile, uint16_t cluster) const
 	{
-		UniqueLock<Lock> lock(this->_lock);
-
-		this->_xb.send(addr, buffer, profile, cluster);
-		return this->validateTxRequest();
+		return this->transfer([&]() {
+			this->_xb.send(addr, buffer, profile, cluster);
+		});
 	}
 
 	uint16_t AsyncXbee::getParentAddress() const
@@ -202,10 +931,9 @@ namespace lwiot
 
 	bool AsyncXbee::send(lwiot::XBeeRequest &request) const
 	{
-		UniqueLock<Lock> lock(this->_lock);
-
-		this->_xb.send(request);
-		return this->validateTxRequest();
+		return this->transfer([&]() {
+			this->_xb.send(request);
+		});
 	}
 
 	void AsyncXbee::setSleepMode(lwiot::XBee::SleepMode mode) const
@@ -20,27 +20,29 @@
 
 #include <lwiot/stl/move.h>
 #include <lwiot/kernel/uniquelock.h>
+#include <lwiot/kernel/clock.h>
 #include <lwiot/network/stdnet.h>
 
 namespace lwiot
 {
-	XBee::XBee() : _response(XBeeResponse())
+	XBee::XBee() : _response(XBeeResponse()), _ring(nullptr), _nodes(nullptr), _started(0), _completed(0)
 	{
 		_pos = 0;
 		_escape = false;
 		_checksumTotal = 0;
 		_nextFrameId = 0;
+		_max_payload = 0;
 
 		_response.init();
 		_response.setFrameData(_responseFrameData);
 	}
 
-	XBee::XBee(const lwiot::XBee &xb)
+	XBee::XBee(const lwiot::XBee &xb) : _ring(nullptr), _nodes(nullptr), _started(0), _completed(0)
 	{
 		this->copy(xb);
 	}
 
-	XBee::XBee(const lwiot::XBee &&xb) noexcept
+	XBee::XBee(const lwiot::XBee &&xb) noexcept : _ring(nullptr), _nodes(nullptr), _started(0), _completed(0)
 	{
 		this->copy(xb);
 	}
@@ -90,10 +92,32 @@ namespace lwiot
 		this->_response = rhs._response;
 		this->_nextFrameId = rhs._nextFrameId;
 		this->_serial = rhs._serial;
+		this->_nodes = rhs._nodes;
+		this->_max_payload = rhs._max_payload;
 
 		memcpy(this->_responseFrameData, rhs._responseFrameData, MAX_FRAME_DATA_SIZE);
 	}
 
+	void XBee::setNodeTable(XBeeNodeTable *table)
+	{
+		this->_nodes = table;
+	}
+
+	XBeeNodeTable* XBee::getNodeTable() const
+	{
+		return this->_nodes;
+	}
+
+	uint16_t XBee::resolve(uint64_t address) const
+	{
+		uint16_t address16;
+
+		if(this->_nodes != nullptr && this->_nodes->lookup(address, address16))
+			return address16;
+
+		return 0xFFFE;
+	}
+
 	void XBee::writeToFlash()
 	{
 		uint8_t cmd[] = {'W', 'R'};
@@ -108,7 +132,7 @@ namespace lwiot
 		this->_response.reset();
 	}
 
-	void XBee::send(ZigbeeAddress addr, const lwiot::ByteBuffer &buffer) const
+	void XBee::send(ZigbeeAddress addr, const lwiot::ByteBuffer &buffer, uint8_t id) const
 	{
 		auto raw = buffer.data();
 		ZBTxRequest tx;
@@ -118,14 +142,14 @@ namespace lwiot
 
 		if(addr.is64Bit()) {
 			tx.setAddress64(addr.getAddress64());
-			tx.setAddress16(0xFFFE);
+			tx.setAddress16(this->resolve(addr.getAddress64()));
 		} else {
 			tx.setAddress64(0xFFFFFFFFFFFFFFFF);
 			tx.setAddress16(addr.getAddress16());
 		}
 
 		//print_dbg("Transmitting (%u) to 0x%X\n", buffer.index(), addr.getAddress16());
-		tx.setFrameId(DEFAULT_FRAME_ID);
+		tx.setFrameId(id);
 		this->send(tx);
 	}
 
@@ -136,7 +160,7 @@ namespace lwiot
 
 		if(addr.is64Bit()) {
 			tx.setAddress64(addr.getAddress64());
-			tx.setAddress16(0xFFFE);
+			tx.setAddress16(this->resolve(addr.getAddress64()));
 		} else {
 			tx.setAddress64(0xFFFFFFFFFFFFFFFF);
 			tx.setAddress16(addr.getAddress16());
@@ -149,41 +173,48 @@ namespace lwiot
 		this->send(tx);
 	}
 
+	static_assert(CONFIG_XBEE_TX_BUFFER >= 3, "The transmit buffer must hold the start byte and an escaped byte");
+
 	void XBee::send(XBeeRequest &request) const
 	{
-		sendByte(START_BYTE, false);
+		uint8_t frame[CONFIG_XBEE_TX_BUFFER];
+		uint8_t checksum = 0;
+		size_t pos = 0;
 
-		uint8_t msbLen = ((request.getFrameDataLength() + 2) >> 8) & 0xff;
-		uint8_t lsbLen = (request.getFrameDataLength() + 2) & 0xff;
+		/* The frame is escaped into a buffer and written at once, instead of a byte at a time. */
+		auto put = [&](uint8_t byte) {
+			if(pos + 2 > sizeof(frame)) {
+				this->write(frame, pos);
+				pos = 0;
+			}
 
-		sendByte(msbLen, true);
-		sendByte(lsbLen, true);
+			if(byte == START_BYTE || byte == ESCAPE || byte == XON || byte == XOFF) {
+				frame[pos++] = ESCAPE;
+				frame[pos++] = byte ^ 0x20;
+			} else {
+				frame[pos++] = byte;
+			}
+		};
 
-		sendByte(request.getApiId(), true);
-		sendByte(request.getFrameId(), true);
+		frame[pos++] = START_BYTE;
+		put(((request.getFrameDataLength() + 2) >> 8) & 0xff);
+		put((request.getFrameDataLength() + 2) & 0xff);
 
-		uint8_t checksum = 0;
+		put(request.getApiId());
+		put(request.getFrameId());
 
 		checksum += request.getApiId();
 		checksum += request.getFrameId();
 
 		for(int i = 0; i < request.getFrameDataLength(); i++) {
-			sendByte(request.getFrameData(i), true);
-			checksum += request.getFrameData(i);
-		}
-
-		checksum = 0xff - checksum;
-		sendByte(checksum, true);
-	}
+			auto byte = request.getFrameData(i);
 
-	void XBee::sendByte(uint8_t byte, bool escape) const
-	{
-		if(escape && (byte == START_BYTE || byte == ESCAPE || byte == XON || byte == XOFF)) {
-			write(ESCAPE);
-			write(byte ^ 0x20);
-		} else {
-			write(byte);
+			put(byte);
+			checksum += byte;
 		}
+
+		put(0xff - checksum);
+		this->write(frame, pos);
 	}
 
 	uint8_t XBee::getNextFrameId()
@@ -210,17 +241,35 @@ namespace lwiot
 
 	bool XBee::available()
 	{
+		if(this->_ring != nullptr)
+			return !this->_ring->empty();
+
 		return _serial->available();
 	}
 
 	uint8_t XBee::read()
 	{
+		uint8_t byte = 0;
+
+		XBEE_PROFILE(this->_stats.received(1));
+
+		/* Received data is pushed into the ring by the owner of the UART instead. */
+		if(this->_ring != nullptr) {
+			this->_ring->pop(&byte, sizeof(byte));
+			return byte;
+		}
+
 		return _serial->read();
 	}
 
-	void XBee::write(uint8_t val) const
+	const XBeeStats& XBee::stats() const
+	{
+		return this->_stats;
+	}
+
+	void XBee::write(const uint8_t *data, size_t length) const
 	{
-		_serial->write(val);
+		_serial->write(data, length);
 	}
 
 	XBeeResponse &XBee::getResponse()
@@ -256,11 +305,14 @@ namespace lwiot
 			b = read();
 
 			if(_pos > 0 && b == START_BYTE && ATAP == 2) {
+				XBEE_PROFILE(this->_stats.framingError());
 				_response.setErrorCode(UNEXPECTED_START_BYTE);
 				return;
 			}
 
 			if(_pos > 0 && b == ESCAPE) {
+				XBEE_PROFILE(this->_stats.escaped());
+
 				if(available()) {
 					b = read();
 					b = 0x20 ^ b;
@@ -282,6 +334,7 @@ namespace lwiot
 			switch(_pos) {
 			case 0:
 				if(b == START_BYTE) {
+					XBEE_PROFILE(this->_started = Clock::now());
 					_pos++;
 				}
 
@@ -304,6 +357,7 @@ namespace lwiot
 			default:
 #if MAX_FRAME_DATA_SIZE < UINT8_MAX
 				if(_pos > MAX_FRAME_DATA_SIZE) {
+					XBEE_PROFILE(this->_stats.framingError());
 					_response.setErrorCode(PACKET_EXCEEDS_BYTE_ARRAY_LENGTH);
 					return;
 				}
@@ -315,13 +369,20 @@ namespace lwiot
 						_response.setAvailable(true);
 
 						_response.setErrorCode(NO_ERROR);
+
+						XBEE_PROFILE(this->_completed = Clock::now());
+						XBEE_PROFILE(this->_stats.parsed(_response.getApiId(), this->_started, this->_completed));
 					} else {
+						XBEE_PROFILE(this->_stats.checksumError());
 						_response.setErrorCode(CHECKSUM_FAILURE);
 					}
 
 					_response.setFrameLength(_pos - 4);
 					_pos = 0;
 
+					if(_response.isAvailable() && this->_nodes != nullptr)
+						this->_nodes->learn(_response);
+
 					return;
 				} else {
 					_response.getFrameData()[_pos - 4] = b;
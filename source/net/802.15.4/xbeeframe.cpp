@@ -0,0 +1,129 @@
+/*
+ * Pool of received XBee frames.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/network/xbee/xbeeframe.h>
+
+namespace lwiot
+{
+	XBeeFrame::XBeeFrame() : _slot(nullptr)
+	{
+	}
+
+	XBeeFrame::XBeeFrame(Slot *slot) : _slot(slot)
+	{
+	}
+
+	XBeeFrame::XBeeFrame(const XBeeFrame& other) : _slot(other._slot)
+	{
+		if(this->_slot != nullptr)
+			this->_slot->references.fetch_add(1);
+	}
+
+	XBeeFrame::XBeeFrame(XBeeFrame&& other) noexcept : _slot(other._slot)
+	{
+		other._slot = nullptr;
+	}
+
+	XBeeFrame::~XBeeFrame()
+	{
+		this->reset();
+	}
+
+	XBeeFrame& XBeeFrame::operator=(const XBeeFrame& rhs)
+	{
+		if(this->_slot == rhs._slot)
+			return *this;
+
+		if(rhs._slot != nullptr)
+			rhs._slot->references.fetch_add(1);
+
+		this->reset();
+		this->_slot = rhs._slot;
+
+		return *this;
+	}
+
+	XBeeFrame& XBeeFrame::operator=(XBeeFrame&& rhs) noexcept
+	{
+		if(this != &rhs) {
+			this->reset();
+			this->_slot = rhs._slot;
+			rhs._slot = nullptr;
+		}
+
+		return *this;
+	}
+
+	XBeeResponse& XBeeFrame::response() const
+	{
+		return this->_slot->response;
+	}
+
+	void XBeeFrame::reset()
+	{
+		auto slot = this->_slot;
+
+		this->_slot = nullptr;
+
+		if(slot != nullptr && slot->references.fetch_sub(1) == 1)
+			slot->pool->release(slot);
+	}
+
+	void XBeeFramePool::setReleaseHandler(const ReleaseHandler& handler)
+	{
+		this->_released = handler;
+	}
+
+	uint8_t *XBeeFramePool::acquire()
+	{
+		auto block = this->_blocks.allocate();
+
+		if(block == nullptr)
+			return nullptr;
+
+		auto slot = new(block) XBeeFrame::Slot();
+
+		slot->pool = this;
+		return slot->data;
+	}
+
+	XBeeFrame XBeeFramePool::commit(XBeeResponse& parsed)
+	{
+		/* The frame data is the first member of a slot. */
+		auto slot = reinterpret_cast<XBeeFrame::Slot *>(parsed.getFrameData());
+
+		slot->response.setApiId(parsed.getApiId());
+		slot->response.setMsbLength(parsed.getMsbLength());
+		slot->response.setLsbLength(parsed.getLsbLength());
+		slot->response.setChecksum(parsed.getChecksum());
+		slot->response.setFrameLength(parsed.getFrameDataLength());
+		slot->response.setErrorCode(parsed.getErrorCode());
+		slot->response.setAvailable(parsed.isAvailable());
+		slot->response.setFrameData(slot->data);
+		slot->references.store(1);
+
+		return XBeeFrame(slot);
+	}
+
+	void XBeeFramePool::cancel(uint8_t *buffer)
+	{
+		this->release(reinterpret_cast<XBeeFrame::Slot *>(buffer));
+	}
+
+	void XBeeFramePool::release(XBeeFrame::Slot *slot)
+	{
+		slot->~Slot();
+		this->_blocks.deallocate(slot);
+
+		if(this->_released)
+			this->_released();
+	}
+}
@@ -0,0 +1,114 @@
+/*
+ * MQTT bridge for XBee end devices.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/network/xbee/constants.h>
+#include <lwiot/network/xbee/xbeemqttbridge.h>
+
+#define BRIDGE_PUBLISH     'P'
+#define BRIDGE_RETAIN      'R'
+#define BRIDGE_SUBSCRIBE   'S'
+#define BRIDGE_UNSUBSCRIBE 'U'
+#define BRIDGE_MESSAGE     'M'
+
+namespace lwiot
+{
+	XBeeMqttBridge::XBeeMqttBridge(AsyncMqttClient& client, AsyncXbee& xbee, const String& prefix) :
+		MqttBridge(client, prefix), _xbee(xbee)
+	{
+	}
+
+	String XBeeMqttBridge::name(uint64_t address)
+	{
+		char name[17];
+
+		snprintf(name, sizeof(name), "%08lX%08lX", static_cast<unsigned long>(address >> 32),
+		         static_cast<unsigned long>(address & 0xFFFFFFFFUL));
+		return String(name);
+	}
+
+	bool XBeeMqttBridge::handle(XBeeResponse& response)
+	{
+		ZBRxResponse plain;
+		ZBExplicitRxResponse explicit_rx;
+		ZBRxResponse *rx;
+
+		/* The data offset depends on the type of the response object. */
+		if(response.getApiId() == ZB_RX_RESPONSE) {
+			response.getZBRxResponse(plain);
+			rx = &plain;
+		} else if(response.getApiId() == ZB_EXPLICIT_RX_RESPONSE) {
+			response.getZBExplicitRxResponse(explicit_rx);
+			rx = &explicit_rx;
+		} else {
+			return false;
+		}
+
+		const char *data = reinterpret_cast<const char *>(rx->getData());
+		size_t length = rx->getDataLength();
+		uint64_t address = rx->getRemoteAddress64().get();
+		auto device = name(address);
+
+		if(length < 2)
+			return false;
+
+		if(!this->contains(device)) {
+			this->add(device, [this, address](const String& topic, const SharedByteBuffer& payload) {
+				this->forward(address, topic, payload);
+			});
+		}
+
+		switch(data[0]) {
+		case BRIDGE_PUBLISH:
+		case BRIDGE_RETAIN: {
+			auto end = static_cast<const char *>(memchr(data + 1, '\0', length - 1));
+
+			if(end == nullptr)
+				return false;
+
+			auto offset = static_cast<size_t>(end - data) + 1;
+			ByteBuffer payload(length - offset + 1);
+
+			payload.write(data + offset, length - offset);
+			return this->publish(device, String(data + 1), payload, data[0] == BRIDGE_RETAIN);
+		}
+
+		case BRIDGE_SUBSCRIBE:
+			if(length < 3 || data[1] > MqttClient::QOS2)
+				return false;
+
+			return this->subscribe(device, String(data + 2, length - 2), static_cast<MqttClient::QoS>(data[1]));
+
+		case BRIDGE_UNSUBSCRIBE:
+			return this->unsubscribe(device, String(data + 1, length - 1));
+
+		default:
+			return false;
+		}
+	}
+
+	void XBeeMqttBridge::forward(uint64_t address, const String& topic, const SharedByteBuffer& data)
+	{
+		ByteBuffer frame(topic.length() + data.size() + 2);
+		ZigbeeAddress addr;
+
+		frame.write(BRIDGE_MESSAGE);
+		frame.write(topic.c_str(), topic.length());
+		frame.write(static_cast<uint8_t>(0));
+		frame.write(data.data(), data.size());
+
+		addr.setAddress64(address);
+		this->_xbee.transmit(addr, frame);
+	}
+}
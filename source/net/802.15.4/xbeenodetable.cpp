@@ -0,0 +1,203 @@
+/*
+ * XBee node address table.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/scopedlock.h>
+#include <lwiot/network/xbee/xbeenodetable.h>
+
+#define ADDRESS_UNKNOWN 0xFFFE
+#define ADDRESS_BROADCAST 0xFFFFFFFFFFFFFFFFULL
+
+namespace lwiot
+{
+	static uint64_t read64(const uint8_t *data)
+	{
+		uint64_t value = 0;
+
+		for(int idx = 0; idx < 8; idx++)
+			value = (value << 8) | data[idx];
+
+		return value;
+	}
+
+	static uint16_t read16(const uint8_t *data)
+	{
+		return static_cast<uint16_t>((data[0] << 8) | data[1]);
+	}
+
+	XBeeNodeTable::XBeeNodeTable(time_t age) : _age(age), _lock(false)
+	{
+		this->clear();
+	}
+
+	void XBeeNodeTable::learn(XBeeResponse &response)
+	{
+		auto data = response.getFrameData();
+		auto length = response.getFrameDataLength();
+
+		switch(response.getApiId()) {
+		case ZB_RX_RESPONSE:
+		case ZB_EXPLICIT_RX_RESPONSE:
+		case ZB_IO_SAMPLE_RESPONSE:
+		case ZB_IO_NODE_IDENTIFIER_RESPONSE:
+		case ZB_MANY_TO_ONE_ROUTE_REQUEST:
+			/* Each of these starts with the 64-bit and 16-bit address of the sender. */
+			if(length >= 10)
+				this->learn(read64(data), read16(data + 8));
+			break;
+
+		case ZB_ROUTE_RECORD_INDICATOR: {
+			if(length < 12 || length < 12 + data[11] * 2)
+				break;
+
+			auto address64 = read64(data);
+			auto address16 = read16(data + 8);
+			uint8_t hops = data[11];
+
+			if(address16 == ADDRESS_UNKNOWN || address64 == ADDRESS_BROADCAST)
+				break;
+
+			ScopedLock lock(this->_lock);
+			auto node = this->insert(address64, address16, lwiot_tick_ms());
+
+			/* A route that does not fit is not cached; a partial route is useless. */
+			node->routed = hops <= CONFIG_XBEE_ROUTE_HOPS;
+
+			if(!node->routed)
+				break;
+
+			node->route.hops = hops;
+
+			for(uint8_t idx = 0; idx < hops; idx++)
+				node->route.addresses[idx] = read16(data + 12 + idx * 2);
+
+			break;
+		}
+
+		default:
+			break;
+		}
+	}
+
+	void XBeeNodeTable::learn(uint64_t address64, uint16_t address16)
+	{
+		if(address16 == ADDRESS_UNKNOWN || address64 == ADDRESS_BROADCAST)
+			return;
+
+		ScopedLock lock(this->_lock);
+		this->insert(address64, address16, lwiot_tick_ms());
+	}
+
+	bool XBeeNodeTable::lookup(uint64_t address64, uint16_t &address16) const
+	{
+		ScopedLock lock(this->_lock);
+		auto node = this->find(address64, lwiot_tick_ms());
+
+		if(node == nullptr)
+			return false;
+
+		address16 = node->address16;
+		return true;
+	}
+
+	bool XBeeNodeTable::route(uint64_t address64, Route &route) const
+	{
+		ScopedLock lock(this->_lock);
+		auto node = this->find(address64, lwiot_tick_ms());
+
+		if(node == nullptr || !node->routed)
+			return false;
+
+		route = node->route;
+		return true;
+	}
+
+	void XBeeNodeTable::forget(uint64_t address64)
+	{
+		ScopedLock lock(this->_lock);
+		auto node = this->find(address64, lwiot_tick_ms());
+
+		if(node != nullptr)
+			node->valid = false;
+	}
+
+	void XBeeNodeTable::clear()
+	{
+		ScopedLock lock(this->_lock);
+
+		for(auto& node : this->_nodes) {
+			node.valid = false;
+			node.routed = false;
+		}
+	}
+
+	size_t XBeeNodeTable::size() const
+	{
+		ScopedLock lock(this->_lock);
+		auto now = lwiot_tick_ms();
+		size_t count = 0;
+
+		for(auto& node : this->_nodes) {
+			if(node.valid && now - node.seen < this->_age)
+				count++;
+		}
+
+		return count;
+	}
+
+	XBeeNodeTable::Node *XBeeNodeTable::find(uint64_t address64, time_t now) const
+	{
+		for(auto& node : this->_nodes) {
+			if(!node.valid || node.address64 != address64)
+				continue;
+
+			if(now - node.seen >= this->_age) {
+				node.valid = false;
+				return nullptr;
+			}
+
+			return &node;
+		}
+
+		return nullptr;
+	}
+
+	XBeeNodeTable::Node *XBeeNodeTable::insert(uint64_t address64, uint16_t address16, time_t now)
+	{
+		auto node = this->find(address64, now);
+
+		if(node == nullptr) {
+			node = &this->_nodes[0];
+
+			/* Take a free or expired entry, or else the one that was refreshed longest ago. */
+			for(auto& entry : this->_nodes) {
+				if(!entry.valid || now - entry.seen >= this->_age) {
+					node = &entry;
+					break;
+				}
+
+				if(entry.seen < node->seen)
+					node = &entry;
+			}
+
+			node->address64 = address64;
+			node->valid = true;
+			node->routed = false;
+		} else if(node->address16 != address16) {
+			/* The node rejoined with a new network address; its old route is stale. */
+			node->routed = false;
+		}
+
+		node->address16 = address16;
+		node->seen = now;
+
+		return node;
+	}
+}
@@ -0,0 +1,182 @@
+/*
+ * Sleep aware transmit scheduling for XBee end devices.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/scopedlock.h>
+#include <lwiot/kernel/uniquelock.h>
+#include <lwiot/kernel/idlemanager.h>
+#include <lwiot/network/xbee/xbeesleepscheduler.h>
+
+namespace lwiot
+{
+	XBeeSleepScheduler::XBeeSleepScheduler(AsyncXbee& xbee, time_t period) : Thread("xbsleep"),
+		_xbee(xbee), _period(period), _lock(false), _running(false), _stats()
+	{
+	}
+
+	XBeeSleepScheduler::~XBeeSleepScheduler()
+	{
+		this->end();
+	}
+
+	void XBeeSleepScheduler::begin()
+	{
+		ScopedLock lock(this->_lock);
+
+		if(this->_running)
+			return;
+
+		this->_running = true;
+		this->start();
+	}
+
+	void XBeeSleepScheduler::end()
+	{
+		UniqueLock<Lock> lock(this->_lock);
+
+		if(!this->_running)
+			return;
+
+		this->_running = false;
+		lock.unlock();
+
+		this->_wake.signal();
+		this->join();
+	}
+
+	bool XBeeSleepScheduler::enqueue(const ZigbeeAddress& address, const ByteBuffer& payload,
+	                                 const AsyncXbee::DeliveryHandler& handler)
+	{
+		ScopedLock lock(this->_lock);
+		Message message;
+
+		if(this->_queue.size() >= CONFIG_XBEE_SLEEP_QUEUE) {
+			this->_stats.dropped++;
+			return false;
+		}
+
+		message.address = address;
+		message.payload = payload;
+		message.handler = handler;
+		this->_queue.push_back(stl::move(message));
+
+		return true;
+	}
+
+	void XBeeSleepScheduler::wake()
+	{
+		this->_wake.signal();
+	}
+
+	XBeeSleepScheduler::Statistics XBeeSleepScheduler::statistics() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_stats;
+	}
+
+	double XBeeSleepScheduler::dutyCycle() const
+	{
+		ScopedLock lock(this->_lock);
+		auto total = this->_stats.awake + this->_stats.asleep;
+
+		if(total == 0)
+			return 0.0;
+
+		return static_cast<double>(this->_stats.awake) / total;
+	}
+
+	void XBeeSleepScheduler::run()
+	{
+		UniqueLock<Lock> lock(this->_lock);
+		auto woke = lwiot_tick_ms();
+
+		while(this->_running) {
+			auto slept = lwiot_tick_ms();
+			auto remaining = this->_period - (slept - woke);
+
+			/* The period runs from wake up to wake up; an overrun wakes up right away. */
+			if(remaining > 0)
+				this->_wake.wait(lock, static_cast<int>(remaining));
+
+			this->_stats.asleep += lwiot_tick_ms() - slept;
+
+			if(!this->_running)
+				break;
+
+			woke = lwiot_tick_ms();
+			lock.unlock();
+			this->cycle();
+			lock.lock();
+		}
+	}
+
+	void XBeeSleepScheduler::cycle()
+	{
+		auto& device = this->_xbee.getDevice();
+		auto woke = lwiot_tick_ms();
+
+		/* The radio wake up is a deadline through the wait in run(); stay awake while it is up. */
+		IdleManager::WakeLock radio;
+
+		device.wakeUp();
+		Thread::sleep(CONFIG_XBEE_WAKE_TIME);
+
+		UniqueLock<Lock> lock(this->_lock);
+		stl::LinkedList<Message> batch(stl::move(this->_queue));
+
+		lock.unlock();
+
+		for(auto& message : batch)
+			this->transmit(message);
+
+		/* Stay awake no longer than a period, even if the parent does not answer. */
+		this->_xbee.flush(static_cast<int>(this->_period));
+		Thread::sleep(CONFIG_XBEE_POLL_TIME);
+		device.sleep();
+
+		auto awake = lwiot_tick_ms() - woke;
+
+		lock.lock();
+		this->_stats.cycles++;
+		this->_stats.awake += awake;
+
+		if(awake > this->_stats.longest)
+			this->_stats.longest = awake;
+	}
+
+	void XBeeSleepScheduler::transmit(Message& message)
+	{
+		auto handler = message.handler;
+		auto queued = this->_xbee.transmit(message.address, message.payload, [this, handler](bool delivered) {
+			UniqueLock<Lock> lock(this->_lock);
+
+			if(delivered)
+				this->_stats.sent++;
+			else
+				this->_stats.failed++;
+
+			lock.unlock();
+
+			if(handler)
+				handler(delivered);
+		});
+
+		if(queued)
+			return;
+
+		UniqueLock<Lock> lock(this->_lock);
+
+		this->_stats.dropped++;
+		lock.unlock();
+
+		if(handler)
+			handler(false);
+	}
+}
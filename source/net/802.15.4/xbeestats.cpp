@@ -0,0 +1,220 @@
+/*
+ * XBee receive path counters and latencies.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/network/xbee/xbeestats.h>
+
+#define NS_PER_US 1000ULL
+
+namespace lwiot
+{
+	namespace
+	{
+		struct GlobalStats {
+			atomic_uint64_t bytes;
+			atomic_uint32_t frames;
+			atomic_uint32_t escapes;
+			atomic_uint32_t checksum_errors;
+			atomic_uint32_t framing_errors;
+			atomic_uint32_t dropped;
+			atomic_uint32_t overruns;
+		};
+
+		GlobalStats totals;
+	}
+
+	static uint32_t elapsed(uint64_t start, uint64_t end)
+	{
+		return end > start ? static_cast<uint32_t>((end - start) / NS_PER_US) : 0;
+	}
+
+	XBeeStats::XBeeStats()
+	{
+		this->reset();
+	}
+
+	void XBeeStats::reset()
+	{
+		this->bytes = 0;
+		this->frames = this->escapes = 0;
+		this->checksum_errors = this->framing_errors = this->dropped = 0;
+		this->overruns = 0;
+		this->queue_depth = this->max_queue_depth = 0;
+		this->_types = 0;
+	}
+
+	XBeeStats::Latency* XBeeStats::slot(uint8_t type)
+	{
+		for(size_t idx = 0; idx < this->_types; idx++) {
+			if(this->_latency[idx].type == type)
+				return &this->_latency[idx];
+		}
+
+		if(this->_types >= CONFIG_XBEE_STATS_TYPES)
+			return nullptr;
+
+		auto latency = &this->_latency[this->_types++];
+
+		memset(latency, 0, sizeof(*latency));
+		latency->type = type;
+
+		return latency;
+	}
+
+	void XBeeStats::received(size_t bytes)
+	{
+		this->bytes += bytes;
+		totals.bytes.fetch_add(bytes);
+	}
+
+	void XBeeStats::escaped()
+	{
+		this->escapes++;
+		totals.escapes.fetch_add(1);
+	}
+
+	void XBeeStats::parsed(uint8_t type, uint64_t started, uint64_t completed)
+	{
+		auto latency = this->slot(type);
+		auto decode = elapsed(started, completed);
+
+		this->frames++;
+		totals.frames.fetch_add(1);
+
+		if(latency == nullptr)
+			return;
+
+		latency->frames++;
+		latency->decode += decode;
+
+		if(decode > latency->max_decode)
+			latency->max_decode = decode;
+	}
+
+	void XBeeStats::checksumError()
+	{
+		this->checksum_errors++;
+		this->dropped++;
+		totals.checksum_errors.fetch_add(1);
+		totals.dropped.fetch_add(1);
+	}
+
+	void XBeeStats::framingError()
+	{
+		this->framing_errors++;
+		this->dropped++;
+		totals.framing_errors.fetch_add(1);
+		totals.dropped.fetch_add(1);
+	}
+
+	void XBeeStats::overrun(size_t bytes)
+	{
+		this->overruns += bytes;
+		totals.overruns.fetch_add(bytes);
+	}
+
+	void XBeeStats::queued(size_t depth)
+	{
+		this->queue_depth = depth;
+
+		if(depth > this->max_queue_depth)
+			this->max_queue_depth = depth;
+	}
+
+	void XBeeStats::dispatched(uint8_t type, uint64_t completed, uint64_t called, uint64_t returned)
+	{
+		auto latency = this->slot(type);
+
+		if(latency == nullptr)
+			return;
+
+		auto dispatch = elapsed(completed, called);
+		auto handle = elapsed(called, returned);
+
+		latency->handled++;
+		latency->dispatch += dispatch;
+		latency->handle += handle;
+
+		if(dispatch > latency->max_dispatch)
+			latency->max_dispatch = dispatch;
+
+		if(handle > latency->max_handle)
+			latency->max_handle = handle;
+	}
+
+	const XBeeStats::Latency* XBeeStats::latency(uint8_t type) const
+	{
+		for(size_t idx = 0; idx < this->_types; idx++) {
+			if(this->_latency[idx].type == type)
+				return &this->_latency[idx];
+		}
+
+		return nullptr;
+	}
+
+	String XBeeStats::toString() const
+	{
+		char buffer[192];
+
+		snprintf(buffer, sizeof(buffer), "bytes=%llu frames=%lu escapes=%lu checksum_errors=%lu framing_errors=%lu "
+		         "dropped=%lu overruns=%lu queue_depth=%lu max_queue_depth=%lu",
+		         static_cast<unsigned long long>(this->bytes), static_cast<unsigned long>(this->frames),
+		         static_cast<unsigned long>(this->escapes), static_cast<unsigned long>(this->checksum_errors),
+		         static_cast<unsigned long>(this->framing_errors), static_cast<unsigned long>(this->dropped),
+		         static_cast<unsigned long>(this->overruns), static_cast<unsigned long>(this->queue_depth),
+		         static_cast<unsigned long>(this->max_queue_depth));
+
+		String rv(buffer);
+
+		for(size_t idx = 0; idx < this->_types; idx++) {
+			auto& latency = this->_latency[idx];
+			auto frames = latency.frames > 0 ? latency.frames : 1U;
+			auto handled = latency.handled > 0 ? latency.handled : 1U;
+
+			snprintf(buffer, sizeof(buffer), " 0x%02X.frames=%lu 0x%02X.decode=%lu 0x%02X.dispatch=%lu "
+			         "0x%02X.handle=%lu", latency.type, static_cast<unsigned long>(latency.frames), latency.type,
+			         static_cast<unsigned long>(latency.decode / frames), latency.type,
+			         static_cast<unsigned long>(latency.dispatch / handled), latency.type,
+			         static_cast<unsigned long>(latency.handle / handled));
+			rv += buffer;
+		}
+
+		return rv;
+	}
+
+	XBeeStats XBeeStats::global()
+	{
+		XBeeStats stats;
+
+		stats.bytes = totals.bytes.load();
+		stats.frames = totals.frames.load();
+		stats.escapes = totals.escapes.load();
+		stats.checksum_errors = totals.checksum_errors.load();
+		stats.framing_errors = totals.framing_errors.load();
+		stats.dropped = totals.dropped.load();
+		stats.overruns = totals.overruns.load();
+
+		return stats;
+	}
+
+	void XBeeStats::resetGlobal()
+	{
+		totals.bytes.store(0);
+		totals.frames.store(0);
+		totals.escapes.store(0);
+		totals.checksum_errors.store(0);
+		totals.framing_errors.store(0);
+		totals.dropped.store(0);
+		totals.overruns.store(0);
+	}
+}
@@ -0,0 +1,328 @@
+/*
+ * Fragmenting transport over XBee.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/scopedlock.h>
+#include <lwiot/kernel/uniquelock.h>
+#include <lwiot/network/xbee/constants.h>
+#include <lwiot/network/xbee/xbeetransport.h>
+
+#define TRANSPORT_DATA 0xF0
+#define TRANSPORT_POLL 0xF1
+#define TRANSPORT_ACK  0xF2
+
+/* Type, message ID, fragment index, fragment count and fragment size. */
+#define TRANSPORT_HEADER 5
+
+/* Time after which a sender that is not acknowledged gives up on a message. */
+#define TRANSPORT_LINGER (CONFIG_XBEE_TRANSPORT_TIMEOUT * (CONFIG_XBEE_TRANSPORT_RETRIES + 1))
+
+namespace lwiot
+{
+	static bool has(const uint8_t *bitmap, size_t index)
+	{
+		return (bitmap[index / 8] & (1U << (index % 8))) != 0;
+	}
+
+	XBeeTransport::XBeeTransport(AsyncXbee& xbee) : _xbee(xbee), _send_lock(false), _lock(false),
+		_destination(0), _id(0), _count(0), _acks(0)
+	{
+		for(auto& session : this->_sessions)
+			session.state = Free;
+
+		/* A restarted sender must not reuse the IDs of the messages it sent before. */
+#ifdef HAVE_RANDOM_BYTES
+		if(lwiot_random_bytes(&this->_id, sizeof(this->_id)) != -EOK)
+#endif
+		{
+			this->_id = static_cast<uint8_t>(rand());
+		}
+	}
+
+	void XBeeTransport::setHandler(const MessageHandler& handler)
+	{
+		ScopedLock lock(this->_lock);
+		this->_handler = handler;
+	}
+
+	size_t XBeeTransport::mtu() const
+	{
+		auto max = this->_xbee.getMaxPayloadSize();
+
+		/* The radio reports 0 until its maximum payload size was fetched. */
+		if(max <= TRANSPORT_HEADER)
+			return CONFIG_XBEE_TRANSPORT_MTU;
+
+		return max - TRANSPORT_HEADER;
+	}
+
+	bool XBeeTransport::send(uint64_t destination, const ByteBuffer& message)
+	{
+		ScopedLock serialize(this->_send_lock);
+		auto size = this->mtu();
+		auto length = message.index();
+		size_t count = length == 0 ? 1 : (length + size - 1) / size;
+
+		if(count > UINT8_MAX)
+			return false;
+
+		UniqueLock<Lock> lock(this->_lock);
+		int retries = 0;
+
+		this->_destination = destination;
+		this->_id++;
+		this->_count = static_cast<uint8_t>(count);
+		memset(this->_fragments, 0, sizeof(this->_fragments));
+
+		auto id = this->_id;
+		auto acks = this->_acks;
+
+		while(true) {
+			uint8_t burst[CONFIG_XBEE_TRANSPORT_WINDOW];
+			size_t fragments = 0;
+
+			for(size_t idx = 0; idx < count && fragments < CONFIG_XBEE_TRANSPORT_WINDOW; idx++) {
+				if(!has(this->_fragments, idx))
+					burst[fragments++] = static_cast<uint8_t>(idx);
+			}
+
+			if(fragments == 0)
+				break;
+
+			lock.unlock();
+
+			for(size_t idx = 0; idx < fragments; idx++) {
+				auto offset = burst[idx] * size;
+				auto chunk = length - offset < size ? length - offset : size;
+				ByteBuffer frame(TRANSPORT_HEADER + chunk);
+
+				frame.write(static_cast<uint8_t>(idx + 1 == fragments ? TRANSPORT_POLL : TRANSPORT_DATA));
+				frame.write(id);
+				frame.write(burst[idx]);
+				frame.write(static_cast<uint8_t>(count));
+				frame.write(static_cast<uint8_t>(size));
+				frame.write(message.data() + offset, chunk);
+
+				this->transmit(destination, frame);
+			}
+
+			lock.lock();
+
+			auto start = lwiot_tick_ms();
+
+			while(this->_acks == acks) {
+				auto remaining = CONFIG_XBEE_TRANSPORT_TIMEOUT - static_cast<int>(lwiot_tick_ms() - start);
+
+				if(remaining <= 0 || !this->_acked.wait(lock, remaining))
+					break;
+			}
+
+			if(this->_acks != acks) {
+				acks = this->_acks;
+				retries = 0;
+			} else if(++retries > CONFIG_XBEE_TRANSPORT_RETRIES) {
+				this->_count = 0;
+				return false;
+			}
+		}
+
+		this->_count = 0;
+		return true;
+	}
+
+	bool XBeeTransport::handle(XBeeResponse& response)
+	{
+		ZBRxResponse plain;
+		ZBExplicitRxResponse explicit_rx;
+		ZBRxResponse *rx;
+
+		/* The data offset depends on the type of the response object. */
+		if(response.getApiId() == ZB_RX_RESPONSE) {
+			response.getZBRxResponse(plain);
+			rx = &plain;
+		} else if(response.getApiId() == ZB_EXPLICIT_RX_RESPONSE) {
+			response.getZBExplicitRxResponse(explicit_rx);
+			rx = &explicit_rx;
+		} else {
+			return false;
+		}
+
+		auto data = rx->getData();
+		size_t length = rx->getDataLength();
+		uint64_t source = rx->getRemoteAddress64().get();
+
+		if(length < 3)
+			return false;
+
+		switch(data[0]) {
+		case TRANSPORT_DATA:
+		case TRANSPORT_POLL:
+			return this->receive(source, data, length);
+
+		case TRANSPORT_ACK:
+			this->update(source, data, length);
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	bool XBeeTransport::receive(uint64_t source, const uint8_t *data, size_t length)
+	{
+		if(length < TRANSPORT_HEADER)
+			return false;
+
+		uint8_t index = data[2];
+		uint8_t count = data[3];
+		uint8_t size = data[4];
+		size_t chunk = length - TRANSPORT_HEADER;
+
+		/* Every fragment but the last one is full. */
+		if(count == 0 || index >= count || size == 0 || chunk > size || (index + 1 < count && chunk != size))
+			return false;
+
+		auto now = lwiot_tick_ms();
+		auto session = this->session(source, data, now);
+
+		/* Every buffer is in use; the sender repeats the fragment later. */
+		if(session == nullptr)
+			return true;
+
+		if(session->count != count || session->size != size)
+			return true;
+
+		session->updated = now;
+
+		if(session->state == Receiving && !has(session->fragments, index)) {
+			memcpy(session->data.data() + index * size, data + TRANSPORT_HEADER, chunk);
+			session->fragments[index / 8] |= static_cast<uint8_t>(1U << (index % 8));
+			session->received++;
+
+			if(index + 1 == count)
+				session->data.setIndex(index * size + chunk);
+
+			if(session->received == count) {
+				session->state = Complete;
+				this->acknowledge(*session);
+
+				UniqueLock<Lock> lock(this->_lock);
+				auto handler = this->_handler;
+
+				lock.unlock();
+
+				if(handler)
+					handler(source, session->data);
+
+				return true;
+			}
+		}
+
+		if(data[0] == TRANSPORT_POLL)
+			this->acknowledge(*session);
+
+		return true;
+	}
+
+	XBeeTransport::Session *XBeeTransport::session(uint64_t source, const uint8_t *header, time_t now)
+	{
+		Session *session = nullptr;
+		uint8_t id = header[1];
+
+		for(auto& entry : this->_sessions) {
+			if(entry.state == Free || entry.source != source)
+				continue;
+
+			/*
+			 * Repeats of a delivered message are acknowledged again, until the sender would
+			 * have given up on it. After that, the same ID is a new message.
+			 */
+			if(entry.id == id && (entry.state == Receiving || now - entry.updated <= TRANSPORT_LINGER))
+				return &entry;
+
+			/* The sender moved on to its next message. */
+			session = &entry;
+		}
+
+		if(session == nullptr) {
+			/* Use a free buffer, or else the oldest one that is done or abandoned. */
+			for(auto& entry : this->_sessions) {
+				if(entry.state == Free) {
+					session = &entry;
+					break;
+				}
+
+				auto idle = now - entry.updated > TRANSPORT_LINGER;
+
+				if((entry.state == Complete || idle) && (session == nullptr || entry.updated < session->updated))
+					session = &entry;
+			}
+		}
+
+		if(session == nullptr)
+			return nullptr;
+
+		session->state = Receiving;
+		session->source = source;
+		session->id = id;
+		session->count = header[3];
+		session->size = header[4];
+		session->received = 0;
+		session->updated = now;
+		memset(session->fragments, 0, sizeof(session->fragments));
+
+		session->data.setIndex(0);
+		session->data.reserveExact(session->count * session->size);
+
+		return session;
+	}
+
+	void XBeeTransport::acknowledge(const Session& session)
+	{
+		size_t bytes = (session.count + 7U) / 8U;
+		ByteBuffer frame(3 + bytes);
+
+		frame.write(static_cast<uint8_t>(TRANSPORT_ACK));
+		frame.write(session.id);
+		frame.write(session.count);
+		frame.write(session.fragments, bytes);
+
+		this->transmit(session.source, frame);
+	}
+
+	void XBeeTransport::update(uint64_t source, const uint8_t *data, size_t length)
+	{
+		ScopedLock lock(this->_lock);
+		size_t bytes = (this->_count + 7U) / 8U;
+
+		if(this->_count == 0 || source != this->_destination || data[1] != this->_id || data[2] != this->_count)
+			return;
+
+		if(length < 3 + bytes)
+			return;
+
+		for(size_t idx = 0; idx < bytes; idx++)
+			this->_fragments[idx] |= data[3 + idx];
+
+		this->_acks++;
+		this->_acked.signal();
+	}
+
+	void XBeeTransport::transmit(uint64_t destination, const ByteBuffer& frame)
+	{
+		ZigbeeAddress addr;
+
+		addr.setAddress64(destination);
+
+		/* No need to wait for the transmit status; the acknowledgements tell what arrived. */
+		this->_xbee.transmit(addr, frame, AsyncXbee::DeliveryHandler());
+	}
+}
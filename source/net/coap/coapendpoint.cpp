@@ -0,0 +1,1061 @@
+/*
+ * CoAP client and server.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/error.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/stl/move.h>
+#include <lwiot/network/coap.h>
+#include <lwiot/network/coapendpoint.h>
+
+#define OBSERVE_WINDOW (1UL << 23)
+#define OBSERVE_MASK 0xFFFFFFUL
+#define OBSERVE_FRESHNESS 128000
+
+namespace lwiot
+{
+	static bool coap_method(uint8_t code, HTTPMethod& method)
+	{
+		switch(code) {
+		case COAP_EMPTY:
+			method = HTTP_ANY;
+			break;
+
+		case COAP_GET:
+			method = HTTP_GET;
+			break;
+
+		case COAP_POST:
+			method = HTTP_POST;
+			break;
+
+		case COAP_PUT:
+			method = HTTP_PUT;
+			break;
+
+		case COAP_DELETE:
+			method = HTTP_DELETE;
+			break;
+
+		case COAP_PATCH:
+			method = HTTP_PATCH;
+			break;
+
+		default:
+			return false;
+		}
+
+		return true;
+	}
+
+	/* RFC 7641, section 3.4: is notification (v2, t2) newer than (v1, t1)? */
+	static bool coap_fresher(uint32_t v1, time_t t1, uint32_t v2, time_t t2)
+	{
+		return (v1 < v2 && v2 - v1 < OBSERVE_WINDOW) || (v1 > v2 && v1 - v2 > OBSERVE_WINDOW) ||
+			t2 > t1 + OBSERVE_FRESHNESS;
+	}
+
+	static void coap_random(void *output, size_t length)
+	{
+		auto bytes = static_cast<uint8_t *>(output);
+
+#ifdef HAVE_RANDOM_BYTES
+		if(lwiot_random_bytes(output, length) != -EOK)
+#endif
+		{
+			for(size_t idx = 0; idx < length; idx++)
+				bytes[idx] = static_cast<uint8_t>(rand());
+		}
+	}
+
+	static inline bool coap_success(const CoapMessage& msg)
+	{
+		return (msg.code() >> 5) == 2;
+	}
+
+	CoapEndpoint::Retransmitter::Retransmitter(CoapEndpoint& endpoint) :
+		Timer("coap-timer", CONFIG_COAP_ACK_TIMEOUT, Continuous, nullptr), _endpoint(endpoint)
+	{
+	}
+
+	void CoapEndpoint::Retransmitter::tick()
+	{
+		this->_endpoint.expire();
+	}
+
+	void CoapEndpoint::Peer::set(const IPAddress& addr, uint16_t port, const CoapMessage& msg)
+	{
+		this->addr = addr;
+		this->port = port;
+		this->tokenLength = static_cast<uint8_t>(msg.tokenLength());
+		memcpy(this->token, msg.token(), msg.tokenLength());
+	}
+
+	bool CoapEndpoint::Peer::matches(const IPAddress& addr, uint16_t port) const
+	{
+		return this->port == port && this->addr == addr;
+	}
+
+	bool CoapEndpoint::Peer::matches(const IPAddress& addr, uint16_t port, const CoapMessage& msg) const
+	{
+		return this->matches(addr, port) && this->tokenLength == msg.tokenLength() &&
+			memcmp(this->token, msg.token(), this->tokenLength) == 0;
+	}
+
+	CoapEndpoint::CoapEndpoint() : Thread("coap-endpoint"), _lock(true), _timer(*this), _running(false),
+		_rx(nullptr), _duplicates(), _duplicate(0), _ackTimeout(CONFIG_COAP_ACK_TIMEOUT),
+		_maxRetransmit(CONFIG_COAP_MAX_RETRANSMIT), _id(0), _token(0), _handle(0), _stats()
+	{
+		coap_random(&this->_id, sizeof(this->_id));
+		coap_random(&this->_token, sizeof(this->_token));
+		this->_rx = static_cast<uint8_t *>(this->_pool.allocate());
+	}
+
+	CoapEndpoint::~CoapEndpoint()
+	{
+		this->end();
+
+		for(auto route : this->_routes)
+			delete route;
+
+		for(auto exchange : this->_exchanges)
+			delete exchange;
+
+		for(auto observer : this->_observers)
+			delete observer;
+
+		for(auto upload : this->_uploads)
+			delete upload;
+	}
+
+	void CoapEndpoint::begin(UdpServer *server)
+	{
+		ScopedLock lock(this->_lock);
+
+		if(this->_running)
+			return;
+
+		this->_udp.reset(server);
+		this->_running = true;
+		this->_timer.start();
+		lock.unlock();
+
+		this->start();
+	}
+
+	void CoapEndpoint::end()
+	{
+		ScopedLock lock(this->_lock);
+
+		if(!this->_running)
+			return;
+
+		this->_running = false;
+		lock.unlock();
+
+		this->_timer.stop();
+		this->stop();
+		this->_udp->close();
+	}
+
+	bool CoapEndpoint::on(const StringView& pattern, uint8_t method, const Handler& handler)
+	{
+		ScopedLock lock(this->_lock);
+		HTTPMethod http;
+
+		if(!coap_method(method, http))
+			return false;
+
+		auto route = new Route(handler);
+
+		if(!this->_router.add(pattern, http, route)) {
+			delete route;
+			return false;
+		}
+
+		this->_routes.pushback(route);
+		return true;
+	}
+
+	void CoapEndpoint::setAckTimeout(int ms, int retransmissions)
+	{
+		ScopedLock lock(this->_lock);
+
+		this->_ackTimeout = ms;
+		this->_maxRetransmit = retransmissions;
+	}
+
+	CoapEndpoint::Statistics CoapEndpoint::statistics() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_stats;
+	}
+
+	size_t CoapEndpoint::observers() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_observers.size();
+	}
+
+	void CoapEndpoint::run()
+	{
+		CoapMessage msg;
+		IPAddress addr;
+		uint16_t port;
+		bool running;
+
+		this->_lock.lock();
+		running = this->_running;
+		this->_udp->setTimeout(1);
+		this->_lock.unlock();
+
+		while(running) {
+			/* The receive buffer is only used here, so wait for datagrams without the lock. */
+			auto num = this->_udp->recvFrom(this->_rx, CONFIG_COAP_MESSAGE_SIZE, addr, port);
+			ScopedLock lock(this->_lock);
+
+			if(num > 0) {
+				this->_stats.received++;
+
+				if(!msg.parse(this->_rx, static_cast<size_t>(num))) {
+					/* Reject confirmable messages we cannot parse. */
+					if(num >= static_cast<ssize_t>(CoapMessage::HeaderSize) && ((this->_rx[0] >> 4) & 0x3) == 0)
+						this->empty(CoapType::Reset, addr, port, static_cast<uint16_t>((this->_rx[2] << 8) | this->_rx[3]));
+				} else if(msg.isRequest()) {
+					this->serve(msg, addr, port);
+				} else if(msg.isEmpty() && msg.type() == CoapType::Confirmable) {
+					this->empty(CoapType::Reset, addr, port, msg.id());
+				} else {
+					this->receive(msg, addr, port);
+				}
+			}
+
+			running = this->_running;
+		}
+	}
+
+	/*
+	 * Server
+	 */
+
+	void CoapEndpoint::serve(const CoapMessage& request, const IPAddress& addr, uint16_t port)
+	{
+		char path[CONFIG_COAP_PATH_LENGTH];
+		Upload *upload = nullptr;
+		uint8_t *buffer = nullptr;
+		size_t length = 0;
+
+		auto confirmable = request.type() == CoapType::Confirmable;
+
+		if(confirmable) {
+			auto dup = this->duplicate(addr, port, request.id());
+
+			if(dup != nullptr) {
+				this->_stats.duplicates++;
+
+				if(this->_udp->sendTo(dup->response, dup->length, addr, port) > 0)
+					this->_stats.sent++;
+
+				return;
+			}
+		} else if(request.type() != CoapType::NonConfirmable) {
+			return;
+		}
+
+		CoapMessage response(confirmable ? CoapType::Acknowledgement : CoapType::NonConfirmable, COAP_CONTENT,
+		                     confirmable ? request.id() : this->_id++);
+		response.setToken(request.token(), request.tokenLength());
+
+		auto size = request.path(path, sizeof(path));
+		StringView view(path, size);
+
+		if(size == 0) {
+			response.setCode(COAP_BAD_OPTION);
+		} else if(this->upload(request, addr, port, view, response, upload)) {
+			if(upload != nullptr) {
+				CoapMessage full(request);
+
+				full.removeOption(COAP_OPTION_BLOCK1);
+				full.setPayload(upload->body.data(), upload->body.index());
+				this->dispatch(full, view, response);
+				this->remove(upload);
+			} else {
+				this->dispatch(request, view, response);
+			}
+
+			this->observe(request, addr, port, view, response);
+			slice(request, response);
+		}
+
+		if(!this->send(response, addr, port, confirmable ? &buffer : nullptr, &length))
+			return;
+
+		if(confirmable)
+			this->remember(addr, port, request.id(), buffer, length);
+	}
+
+	/* Collect the blocks of a block-wise request. Returns true once the request is complete. */
+	bool CoapEndpoint::upload(const CoapMessage& request, const IPAddress& addr, uint16_t port, const StringView& path,
+	                          CoapMessage& response, Upload*& upload)
+	{
+		CoapBlock block;
+		Upload *entry = nullptr;
+
+		upload = nullptr;
+
+		if(!request.block(COAP_OPTION_BLOCK1, block))
+			return true;
+
+		for(auto candidate : this->_uploads) {
+			if(candidate->port == port && candidate->addr == addr && candidate->path == path) {
+				entry = candidate;
+				break;
+			}
+		}
+
+		if(block.num == 0) {
+			if(entry == nullptr) {
+				entry = new Upload();
+				entry->addr = addr;
+				entry->port = port;
+				entry->path = String(path.data(), path.length());
+				this->_uploads.pushback(entry);
+			}
+
+			entry->body.setIndex(0);
+			entry->next = 0;
+		}
+
+		if(entry == nullptr || block.num != entry->next) {
+			response.setCode(COAP_REQUEST_ENTITY_INCOMPLETE);
+			return false;
+		}
+
+		if(entry->body.index() + request.payloadLength() > CONFIG_COAP_MAX_BODY) {
+			response.setCode(COAP_REQUEST_ENTITY_TOO_LARGE);
+			response.addOption(COAP_OPTION_SIZE1, static_cast<uint32_t>(CONFIG_COAP_MAX_BODY));
+			this->remove(entry);
+			return false;
+		}
+
+		entry->body.write(request.payload(), request.payloadLength());
+		entry->next++;
+		entry->expires = lwiot_tick_ms() + CONFIG_COAP_EXCHANGE_LIFETIME;
+		response.setBlock(COAP_OPTION_BLOCK1, block);
+
+		if(block.more) {
+			response.setCode(COAP_CONTINUE);
+			return false;
+		}
+
+		upload = entry;
+		return true;
+	}
+
+	void CoapEndpoint::dispatch(const CoapMessage& request, const StringView& path, CoapMessage& response)
+	{
+		HttpPathArgs args;
+		HTTPMethod method;
+
+		if(!coap_method(request.code(), method))
+			method = HTTP_ANY;
+
+		auto route = static_cast<Route *>(this->_router.match(method, path, args));
+
+		if(route != nullptr) {
+			route->handler(request, response, args);
+			return;
+		}
+
+		response.setCode(COAP_NOT_FOUND);
+
+		for(int other = HTTP_GET; other <= HTTP_DELETE; other++) {
+			if(this->_router.match(static_cast<HTTPMethod>(other), path, args) != nullptr) {
+				response.setCode(COAP_METHOD_NOT_ALLOWED);
+				break;
+			}
+		}
+	}
+
+	void CoapEndpoint::observe(const CoapMessage& request, const IPAddress& addr, uint16_t port, const StringView& path,
+	                           CoapMessage& response)
+	{
+		Observer *observer = nullptr;
+		uint32_t value;
+
+		if(request.code() != COAP_GET || !request.option(COAP_OPTION_OBSERVE, value))
+			return;
+
+		for(auto candidate : this->_observers) {
+			if(candidate->peer.matches(addr, port, request)) {
+				observer = candidate;
+				break;
+			}
+		}
+
+		if(value != 0 || !coap_success(response)) {
+			if(observer != nullptr)
+				this->remove(observer);
+
+			return;
+		}
+
+		if(observer == nullptr) {
+			if(this->_observers.size() >= CONFIG_COAP_OBSERVERS)
+				return;
+
+			observer = new Observer();
+			observer->peer.set(addr, port, request);
+			observer->path = String(path.data(), path.length());
+			this->_observers.pushback(observer);
+		}
+
+		observer->sequence = (observer->sequence + 1) & OBSERVE_MASK;
+		observer->last = response.id();
+		response.addOption(COAP_OPTION_OBSERVE, observer->sequence);
+	}
+
+	/* Cut the representation in \p response down to the block that was asked for. */
+	void CoapEndpoint::slice(const CoapMessage& request, CoapMessage& response)
+	{
+		CoapBlock block(0, false, CoapBlock::fit(CONFIG_COAP_BLOCK_SIZE));
+		CoapBlock requested;
+		size_t offset;
+
+		auto length = response.payloadLength();
+		auto preferred = request.block(COAP_OPTION_BLOCK2, requested);
+
+		if(preferred) {
+			block.num = requested.num;
+
+			if(requested.size < block.size)
+				block.size = requested.size;
+		}
+
+		if(!coap_success(response) || (!preferred && length <= block.size))
+			return;
+
+		offset = block.num * block.size;
+
+		if(offset >= length && offset != 0) {
+			response.setCode(COAP_BAD_OPTION);
+			response.setPayload(nullptr, 0);
+			response.removeOption(COAP_OPTION_OBSERVE);
+			return;
+		}
+
+		block.more = offset + block.size < length;
+		response.setBlock(COAP_OPTION_BLOCK2, block);
+
+		if(block.num == 0)
+			response.addOption(COAP_OPTION_SIZE2, static_cast<uint32_t>(length));
+
+		response.setPayload(response.payload() + offset, block.more ? block.size : length - offset);
+	}
+
+	size_t CoapEndpoint::notify(const StringView& path, bool confirmable)
+	{
+		char buffer[CONFIG_COAP_PATH_LENGTH];
+		ScopedLock lock(this->_lock);
+		size_t count = 0;
+
+		if(!this->_running || path.length() > sizeof(buffer))
+			return 0;
+
+		memcpy(buffer, path.data(), path.length());
+		StringView view(buffer, path.length());
+
+		for(size_t idx = 0; idx < this->_observers.size(); idx++) {
+			auto observer = this->_observers[idx];
+
+			if(!(observer->path == view))
+				continue;
+
+			CoapMessage request(CoapType::NonConfirmable, COAP_GET);
+			CoapMessage response(confirmable ? CoapType::Confirmable : CoapType::NonConfirmable, COAP_CONTENT, this->_id++);
+
+			request.setToken(observer->peer.token, observer->peer.tokenLength);
+			request.setPath(view);
+			response.setToken(observer->peer.token, observer->peer.tokenLength);
+			this->dispatch(request, view, response);
+
+			/* A resource that is gone ends the observation with the error. */
+			if(!coap_success(response)) {
+				this->send(response, observer->peer.addr, observer->peer.port);
+				this->remove(observer);
+				idx--;
+				continue;
+			}
+
+			observer->sequence = (observer->sequence + 1) & OBSERVE_MASK;
+			observer->last = response.id();
+			response.addOption(COAP_OPTION_OBSERVE, observer->sequence);
+			slice(request, response);
+
+			if(!confirmable) {
+				if(this->send(response, observer->peer.addr, observer->peer.port))
+					count++;
+
+				continue;
+			}
+
+			/* A newer notification replaces one that is still being retransmitted. */
+			for(auto exchange : this->_exchanges) {
+				if(exchange->notification && exchange->peer.matches(observer->peer.addr, observer->peer.port, response)) {
+					this->remove(exchange);
+					break;
+				}
+			}
+
+			auto exchange = new Exchange();
+
+			exchange->peer = observer->peer;
+			exchange->notification = true;
+			this->_exchanges.pushback(exchange);
+
+			if(this->transmit(exchange, response))
+				count++;
+			else
+				this->remove(exchange);
+		}
+
+		return count;
+	}
+
+	void CoapEndpoint::remove(Upload *upload)
+	{
+		for(size_t idx = 0; idx < this->_uploads.size(); idx++) {
+			if(this->_uploads[idx] == upload) {
+				this->_uploads.erase(idx);
+				break;
+			}
+		}
+
+		delete upload;
+	}
+
+	void CoapEndpoint::remove(Observer *observer)
+	{
+		for(size_t idx = 0; idx < this->_observers.size(); idx++) {
+			if(this->_observers[idx] == observer) {
+				this->_observers.erase(idx);
+				break;
+			}
+		}
+
+		delete observer;
+	}
+
+	/*
+	 * Client
+	 */
+
+	bool CoapEndpoint::request(const IPAddress& addr, uint16_t port, CoapMessage& request, const ResponseHandler& handler)
+	{
+		ScopedLock lock(this->_lock);
+		uint32_t observe;
+		bool sent;
+
+		if(!this->_running || !request.isRequest())
+			return false;
+
+		request.setId(this->_id++);
+
+		if(request.tokenLength() == 0) {
+			auto token = this->_token++;
+			request.setToken(&token, sizeof(token));
+		}
+
+		auto exchange = new Exchange();
+
+		exchange->peer.set(addr, port, request);
+		exchange->handle = ++this->_handle;
+		exchange->observe = request.code() == COAP_GET && request.option(COAP_OPTION_OBSERVE, observe) && observe == 0;
+		exchange->handler = handler;
+		this->_exchanges.pushback(exchange);
+
+		auto length = request.payloadLength();
+		auto size = CoapBlock::fit(CONFIG_COAP_BLOCK_SIZE);
+
+		if(length > size) {
+			CoapMessage first(request);
+
+			exchange->upload.write(request.payload(), length);
+			first.setBlock(COAP_OPTION_BLOCK1, CoapBlock(0, true, size));
+			first.addOption(COAP_OPTION_SIZE1, static_cast<uint32_t>(length));
+			first.setPayload(exchange->upload.data(), size);
+			sent = this->transmit(exchange, first);
+		} else {
+			sent = this->transmit(exchange, request);
+		}
+
+		if(!sent)
+			this->remove(exchange);
+
+		return sent;
+	}
+
+	bool CoapEndpoint::get(const IPAddress& addr, uint16_t port, const StringView& path, const ResponseHandler& handler)
+	{
+		CoapMessage msg(CoapType::Confirmable, COAP_GET);
+
+		if(!msg.setPath(path))
+			return false;
+
+		return this->request(addr, port, msg, handler);
+	}
+
+	int CoapEndpoint::observe(const IPAddress& addr, uint16_t port, const StringView& path, const ResponseHandler& handler)
+	{
+		CoapMessage msg(CoapType::Confirmable, COAP_GET);
+		ScopedLock lock(this->_lock);
+
+		if(!msg.setPath(path) || !msg.addOption(COAP_OPTION_OBSERVE, 0U))
+			return -EINVALID;
+
+		if(!this->request(addr, port, msg, handler))
+			return -ENOMEMORY;
+
+		return this->_handle;
+	}
+
+	void CoapEndpoint::cancel(int observation)
+	{
+		ScopedLock lock(this->_lock);
+
+		for(auto exchange : this->_exchanges) {
+			if(exchange->handle == observation && exchange->observe) {
+				this->remove(exchange);
+				return;
+			}
+		}
+	}
+
+	void CoapEndpoint::receive(const CoapMessage& msg, const IPAddress& addr, uint16_t port)
+	{
+		if(msg.type() == CoapType::Reset) {
+			auto exchange = this->find(addr, port, msg.id());
+
+			if(exchange != nullptr) {
+				this->fail(exchange);
+				return;
+			}
+
+			for(auto observer : this->_observers) {
+				if(observer->peer.matches(addr, port) && observer->last == msg.id()) {
+					this->remove(observer);
+					return;
+				}
+			}
+
+			return;
+		}
+
+		if(msg.type() == CoapType::Acknowledgement) {
+			auto exchange = this->find(addr, port, msg.id());
+
+			if(exchange == nullptr || exchange->acknowledged)
+				return;
+
+			exchange->acknowledged = true;
+
+			if(exchange->notification) {
+				this->remove(exchange);
+			} else if(msg.isEmpty()) {
+				/* The response follows separately. */
+				exchange->due = lwiot_tick_ms() + CONFIG_COAP_RESPONSE_TIMEOUT;
+				this->arm(lwiot_tick_ms());
+			} else if(exchange->peer.matches(addr, port, msg)) {
+				this->complete(exchange, msg);
+			}
+
+			return;
+		}
+
+		if(!msg.isResponse())
+			return;
+
+		auto exchange = this->find(addr, port, msg);
+
+		if(exchange == nullptr) {
+			/* Also tells the server about observations that were cancelled. */
+			this->empty(CoapType::Reset, addr, port, msg.id());
+			return;
+		}
+
+		if(msg.type() == CoapType::Confirmable)
+			this->empty(CoapType::Acknowledgement, addr, port, msg.id());
+
+		exchange->acknowledged = true;
+		this->complete(exchange, msg);
+	}
+
+	void CoapEndpoint::complete(Exchange *exchange, const CoapMessage& response)
+	{
+		CoapBlock block;
+		uint32_t sequence;
+
+		if(response.code() == COAP_CONTINUE && exchange->upload.index() > 0) {
+			if(!response.block(COAP_OPTION_BLOCK1, block) ||
+			   !this->follow(exchange, COAP_OPTION_BLOCK1, CoapBlock(block.num + 1, false, block.size)))
+				this->fail(exchange);
+
+			return;
+		}
+
+		if(exchange->observe && response.option(COAP_OPTION_OBSERVE, sequence)) {
+			auto now = lwiot_tick_ms();
+
+			if(exchange->notified != 0 && !coap_fresher(exchange->sequence, exchange->notified, sequence, now))
+				return;
+
+			exchange->sequence = sequence;
+			exchange->notified = now;
+		}
+
+		if(!coap_success(response) || !response.block(COAP_OPTION_BLOCK2, block)) {
+			this->deliver(exchange, response);
+			return;
+		}
+
+		if(block.num == 0)
+			exchange->download.setIndex(0);
+
+		if(block.num * block.size != exchange->download.index() ||
+		   exchange->download.index() + response.payloadLength() > CONFIG_COAP_MAX_BODY) {
+			this->fail(exchange);
+			return;
+		}
+
+		exchange->download.write(response.payload(), response.payloadLength());
+
+		if(block.more) {
+			if(!this->follow(exchange, COAP_OPTION_BLOCK2, CoapBlock(block.num + 1, false, block.size)))
+				this->fail(exchange);
+
+			return;
+		}
+
+		/* The message refers to the body, which has to outlive the exchange. */
+		CoapMessage full(response);
+		ByteBuffer body(stl::move(exchange->download));
+
+		full.removeOption(COAP_OPTION_BLOCK2);
+		full.setPayload(body.data(), body.index());
+		this->deliver(exchange, full);
+	}
+
+	void CoapEndpoint::deliver(Exchange *exchange, const CoapMessage& response)
+	{
+		auto handler = exchange->handler;
+
+		/* An observation stays registered until it is cancelled or the server gives up on it. */
+		if(exchange->observe && exchange->notified != 0 && coap_success(response)) {
+			exchange->due = 0;
+			exchange->download.setIndex(0);
+
+			if(handler)
+				handler(&response);
+
+			return;
+		}
+
+		this->remove(exchange);
+
+		if(handler)
+			handler(&response);
+	}
+
+	/* Send the next block of an upload or ask for the next block of a response. */
+	bool CoapEndpoint::follow(Exchange *exchange, uint16_t option, const CoapBlock& block)
+	{
+		CoapMessage msg;
+
+		if(!msg.parse(exchange->message, exchange->length))
+			return false;
+
+		msg.setId(this->_id++);
+		msg.removeOption(COAP_OPTION_OBSERVE);
+		msg.removeOption(COAP_OPTION_BLOCK1);
+		msg.removeOption(COAP_OPTION_BLOCK2);
+		msg.removeOption(COAP_OPTION_SIZE1);
+
+		if(option == COAP_OPTION_BLOCK1) {
+			size_t offset = block.num * block.size;
+			auto total = exchange->upload.index();
+
+			if(offset >= total)
+				return false;
+
+			auto length = total - offset > block.size ? block.size : total - offset;
+
+			msg.setBlock(COAP_OPTION_BLOCK1, CoapBlock(block.num, offset + length < total, block.size));
+			msg.setPayload(exchange->upload.data() + offset, length);
+		} else {
+			msg.setBlock(COAP_OPTION_BLOCK2, block);
+			msg.setPayload(nullptr, 0);
+		}
+
+		return this->transmit(exchange, msg);
+	}
+
+	bool CoapEndpoint::transmit(Exchange *exchange, const CoapMessage& msg)
+	{
+		uint8_t *buffer;
+		size_t length;
+
+		/* Encode before the previous message is released, msg may refer to it. */
+		if(!this->send(msg, exchange->peer.addr, exchange->peer.port, &buffer, &length))
+			return false;
+
+		auto now = lwiot_tick_ms();
+
+		this->release(exchange->message);
+		exchange->message = buffer;
+		exchange->length = length;
+		exchange->id = msg.id();
+		exchange->confirmable = msg.type() == CoapType::Confirmable;
+		exchange->acknowledged = false;
+		exchange->attempts = 0;
+		exchange->timeout = this->initialTimeout();
+		exchange->due = now + (exchange->confirmable ? exchange->timeout : CONFIG_COAP_RESPONSE_TIMEOUT);
+
+		this->arm(now);
+		return true;
+	}
+
+	CoapEndpoint::Exchange *CoapEndpoint::find(const IPAddress& addr, uint16_t port, uint16_t id) const
+	{
+		for(auto exchange : this->_exchanges) {
+			if(exchange->message != nullptr && exchange->id == id && exchange->peer.matches(addr, port))
+				return exchange;
+		}
+
+		return nullptr;
+	}
+
+	CoapEndpoint::Exchange *CoapEndpoint::find(const IPAddress& addr, uint16_t port, const CoapMessage& msg) const
+	{
+		for(auto exchange : this->_exchanges) {
+			if(!exchange->notification && exchange->peer.matches(addr, port, msg))
+				return exchange;
+		}
+
+		return nullptr;
+	}
+
+	void CoapEndpoint::remove(Exchange *exchange)
+	{
+		for(size_t idx = 0; idx < this->_exchanges.size(); idx++) {
+			if(this->_exchanges[idx] == exchange) {
+				this->_exchanges.erase(idx);
+				break;
+			}
+		}
+
+		this->release(exchange->message);
+		delete exchange;
+	}
+
+	void CoapEndpoint::fail(Exchange *exchange)
+	{
+		auto handler = exchange->handler;
+
+		/* Observers that do not acknowledge or reject a notification are gone. */
+		if(exchange->notification) {
+			for(auto observer : this->_observers) {
+				if(observer->peer.matches(exchange->peer.addr, exchange->peer.port) &&
+				   observer->peer.tokenLength == exchange->peer.tokenLength &&
+				   memcmp(observer->peer.token, exchange->peer.token, exchange->peer.tokenLength) == 0) {
+					this->remove(observer);
+					break;
+				}
+			}
+		}
+
+		this->remove(exchange);
+
+		if(handler)
+			handler(nullptr);
+	}
+
+	/*
+	 * Shared
+	 */
+
+	void CoapEndpoint::expire()
+	{
+		ScopedLock lock(this->_lock);
+
+		if(!this->_running)
+			return;
+
+		auto now = lwiot_tick_ms();
+
+		for(size_t idx = 0; idx < this->_exchanges.size();) {
+			auto exchange = this->_exchanges[idx];
+
+			if(exchange->due == 0 || exchange->due > now) {
+				idx++;
+				continue;
+			}
+
+			if(exchange->confirmable && !exchange->acknowledged && exchange->attempts < this->_maxRetransmit) {
+				exchange->attempts++;
+				exchange->timeout *= 2;
+				exchange->due = now + exchange->timeout;
+				this->_stats.retransmissions++;
+
+				if(this->_udp->sendTo(exchange->message, exchange->length, exchange->peer.addr, exchange->peer.port) > 0)
+					this->_stats.sent++;
+
+				idx++;
+				continue;
+			}
+
+			/* The handler may add or remove exchanges, start over. */
+			this->_stats.timeouts++;
+			this->fail(exchange);
+			idx = 0;
+		}
+
+		for(size_t idx = 0; idx < this->_uploads.size();) {
+			if(this->_uploads[idx]->expires <= now)
+				this->remove(this->_uploads[idx]);
+			else
+				idx++;
+		}
+
+		for(auto& dup : this->_duplicates) {
+			if(dup.response != nullptr && dup.expires <= now) {
+				this->release(dup.response);
+				dup.response = nullptr;
+			}
+		}
+
+		this->arm(now);
+	}
+
+	void CoapEndpoint::arm(time_t now)
+	{
+		time_t next = 0;
+		bool first = true;
+
+		for(auto exchange : this->_exchanges) {
+			if(exchange->due == 0)
+				continue;
+
+			if(first || exchange->due < next)
+				next = exchange->due;
+
+			first = false;
+		}
+
+		if(first)
+			return;
+
+		this->_timer.setPeriod(static_cast<unsigned long>(next > now ? next - now : 1));
+		this->_timer.reset();
+	}
+
+	uint8_t *CoapEndpoint::acquire()
+	{
+		auto block = this->_pool.allocate();
+
+		/* Cached responses only save work, give them up first. The oldest is the next to be overwritten. */
+		for(size_t idx = 0; block == nullptr && idx < CONFIG_COAP_DUPLICATES; idx++) {
+			auto& dup = this->_duplicates[(this->_duplicate + idx) % CONFIG_COAP_DUPLICATES];
+
+			if(dup.response == nullptr)
+				continue;
+
+			this->release(dup.response);
+			dup.response = nullptr;
+			block = this->_pool.allocate();
+		}
+
+		return static_cast<uint8_t *>(block);
+	}
+
+	void CoapEndpoint::release(uint8_t *buffer)
+	{
+		if(buffer != nullptr)
+			this->_pool.deallocate(buffer);
+	}
+
+	bool CoapEndpoint::send(const CoapMessage& msg, const IPAddress& addr, uint16_t port, uint8_t **keep, size_t *length)
+	{
+		auto buffer = this->acquire();
+
+		if(buffer == nullptr)
+			return false;
+
+		auto num = msg.encode(buffer, CONFIG_COAP_MESSAGE_SIZE);
+
+		if(num < 0 || this->_udp->sendTo(buffer, static_cast<size_t>(num), addr, port) != num) {
+			this->release(buffer);
+			return false;
+		}
+
+		this->_stats.sent++;
+
+		if(keep == nullptr) {
+			this->release(buffer);
+			return true;
+		}
+
+		*keep = buffer;
+		*length = static_cast<size_t>(num);
+		return true;
+	}
+
+	void CoapEndpoint::empty(CoapType type, const IPAddress& addr, uint16_t port, uint16_t id)
+	{
+		CoapMessage msg(type, COAP_EMPTY, id);
+		this->send(msg, addr, port);
+	}
+
+	void CoapEndpoint::remember(const IPAddress& addr, uint16_t port, uint16_t id, uint8_t *response, size_t length)
+	{
+		auto& dup = this->_duplicates[this->_duplicate];
+
+		this->release(dup.response);
+		dup.addr = addr;
+		dup.port = port;
+		dup.id = id;
+		dup.response = response;
+		dup.length = length;
+		dup.expires = lwiot_tick_ms() + CONFIG_COAP_EXCHANGE_LIFETIME;
+
+		this->_duplicate = (this->_duplicate + 1) % CONFIG_COAP_DUPLICATES;
+	}
+
+	const CoapEndpoint::Duplicate *CoapEndpoint::duplicate(const IPAddress& addr, uint16_t port, uint16_t id) const
+	{
+		auto now = lwiot_tick_ms();
+
+		for(const auto& dup : this->_duplicates) {
+			if(dup.response != nullptr && dup.id == id && dup.port == port && dup.addr == addr && dup.expires > now)
+				return &dup;
+		}
+
+		return nullptr;
+	}
+
+	time_t CoapEndpoint::initialTimeout()
+	{
+		uint16_t random = 0;
+
+		/* Between ACK_TIMEOUT and ACK_TIMEOUT * ACK_RANDOM_FACTOR (1.5). */
+		coap_random(&random, sizeof(random));
+		return this->_ackTimeout + random % (this->_ackTimeout / 2 + 1);
+	}
+}
@@ -0,0 +1,503 @@
+/*
+ * CoAP message encoding and parsing.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/error.h>
+#include <lwiot/network/coap.h>
+
+#define COAP_VERSION 1
+#define PAYLOAD_MARKER 0xFF
+
+namespace lwiot
+{
+	uint32_t CoapBlock::encode() const
+	{
+		uint32_t szx = 0;
+
+		while((16U << szx) < this->size && szx < 6)
+			szx++;
+
+		return (this->num << 4) | (this->more ? 0x8U : 0U) | szx;
+	}
+
+	bool CoapBlock::decode(uint32_t value, CoapBlock& block)
+	{
+		auto szx = value & 0x7U;
+
+		/* Size exponent 7 is reserved for BERT, which is only defined for CoAP over TCP. */
+		if(szx == 7)
+			return false;
+
+		block.num = value >> 4;
+		block.more = (value & 0x8U) != 0;
+		block.size = static_cast<uint16_t>(16U << szx);
+
+		return true;
+	}
+
+	uint16_t CoapBlock::fit(size_t size)
+	{
+		uint16_t block = 1024;
+
+		while(block > 16 && block > size)
+			block >>= 1;
+
+		return block;
+	}
+
+	CoapMessage::CoapMessage() : CoapMessage(CoapType::Confirmable, COAP_EMPTY, 0)
+	{
+	}
+
+	CoapMessage::CoapMessage(CoapType type, uint8_t code, uint16_t id) : _type(type), _code(code), _id(id),
+		_token(), _tokenLength(0), _options(), _storage(), _used(0), _payload(nullptr), _payloadLength(0), _body()
+	{
+	}
+
+	CoapMessage::CoapMessage(const CoapMessage& other) : CoapMessage()
+	{
+		this->copy(other);
+	}
+
+	CoapMessage& CoapMessage::operator=(const CoapMessage& other)
+	{
+		if(this != &other)
+			this->copy(other);
+
+		return *this;
+	}
+
+	/* Options in the storage of the other message are moved into ours, the others keep pointing at their datagram. */
+	void CoapMessage::copy(const CoapMessage& other)
+	{
+		this->_type = other._type;
+		this->_code = other._code;
+		this->_id = other._id;
+		this->_tokenLength = other._tokenLength;
+		memcpy(this->_token, other._token, sizeof(this->_token));
+
+		memcpy(this->_storage, other._storage, other._used);
+		this->_used = other._used;
+		this->_options.clear();
+
+		for(auto option : other._options) {
+			auto begin = other._storage;
+
+			if(option.value >= begin && option.value < begin + sizeof(other._storage))
+				option.value = this->_storage + (option.value - begin);
+
+			this->_options.pushback(option);
+		}
+
+		this->_payload = other._payload;
+		this->_payloadLength = other._payloadLength;
+		this->_body = other._body;
+	}
+
+	bool CoapMessage::isRequest() const
+	{
+		return this->_code != COAP_EMPTY && (this->_code >> 5) == 0;
+	}
+
+	bool CoapMessage::isResponse() const
+	{
+		auto cls = this->_code >> 5;
+		return cls >= 2 && cls <= 5;
+	}
+
+	void CoapMessage::setToken(const void *token, size_t length)
+	{
+		if(length > MaxToken)
+			length = MaxToken;
+
+		memcpy(this->_token, token, length);
+		this->_tokenLength = static_cast<uint8_t>(length);
+	}
+
+	bool CoapMessage::sameToken(const CoapMessage& other) const
+	{
+		return this->_tokenLength == other._tokenLength && memcmp(this->_token, other._token, this->_tokenLength) == 0;
+	}
+
+	bool CoapMessage::addOption(uint16_t number, const void *value, size_t length)
+	{
+		Option option;
+		size_t idx;
+
+		if(length > sizeof(this->_storage) - this->_used)
+			return false;
+
+		option.number = number;
+		option.length = static_cast<uint16_t>(length);
+		option.value = this->_storage + this->_used;
+
+		memcpy(this->_storage + this->_used, value, length);
+		this->_used += length;
+
+		/* Options are encoded as deltas, so keep them sorted by number. */
+		for(idx = this->_options.size(); idx > 0 && this->_options[idx - 1].number > number; idx--);
+
+		this->_options.insert(idx, option);
+		return true;
+	}
+
+	bool CoapMessage::addOption(uint16_t number, const StringView& value)
+	{
+		return this->addOption(number, value.data(), value.length());
+	}
+
+	bool CoapMessage::addOption(uint16_t number, uint32_t value)
+	{
+		uint8_t bytes[sizeof(value)];
+		size_t length = 0;
+
+		for(int shift = 24; shift >= 0; shift -= 8) {
+			if(length == 0 && (value >> shift) == 0)
+				continue;
+
+			bytes[length++] = static_cast<uint8_t>(value >> shift);
+		}
+
+		return this->addOption(number, bytes, length);
+	}
+
+	void CoapMessage::removeOption(uint16_t number)
+	{
+		for(size_t idx = this->_options.size(); idx > 0; idx--) {
+			if(this->_options[idx - 1].number == number)
+				this->_options.erase(idx - 1);
+		}
+	}
+
+	bool CoapMessage::option(uint16_t number, RawBuffer& value, size_t index) const
+	{
+		for(const auto& option : this->_options) {
+			if(option.number != number)
+				continue;
+
+			if(index-- > 0)
+				continue;
+
+			value = RawBuffer(const_cast<uint8_t *>(option.value), option.length);
+			return true;
+		}
+
+		return false;
+	}
+
+	bool CoapMessage::option(uint16_t number, uint32_t& value) const
+	{
+		RawBuffer raw;
+
+		if(!this->option(number, raw) || raw.size() > sizeof(value))
+			return false;
+
+		auto bytes = static_cast<const uint8_t *>(raw.buffer());
+		value = 0;
+
+		for(size_t idx = 0; idx < raw.size(); idx++)
+			value = (value << 8) | bytes[idx];
+
+		return true;
+	}
+
+	bool CoapMessage::hasOption(uint16_t number) const
+	{
+		RawBuffer raw;
+		return this->option(number, raw);
+	}
+
+	bool CoapMessage::setPath(const StringView& path)
+	{
+		auto query = path.find('?');
+		auto segments = path.substr(0, query);
+		size_t start = 0;
+
+		while(start < segments.length()) {
+			auto end = segments.find('/', start);
+
+			if(end == StringView::npos)
+				end = segments.length();
+
+			if(end > start && !this->addOption(COAP_OPTION_URI_PATH, segments.substr(start, end - start)))
+				return false;
+
+			start = end + 1;
+		}
+
+		if(query == StringView::npos)
+			return true;
+
+		start = query + 1;
+
+		while(start < path.length()) {
+			auto end = path.find('&', start);
+
+			if(end == StringView::npos)
+				end = path.length();
+
+			if(end > start && !this->addOption(COAP_OPTION_URI_QUERY, path.substr(start, end - start)))
+				return false;
+
+			start = end + 1;
+		}
+
+		return true;
+	}
+
+	size_t CoapMessage::path(char *buffer, size_t length) const
+	{
+		size_t used = 0;
+
+		for(const auto& option : this->_options) {
+			if(option.number != COAP_OPTION_URI_PATH)
+				continue;
+
+			if(used + option.length + 1 >= length)
+				return 0;
+
+			buffer[used++] = '/';
+			memcpy(buffer + used, option.value, option.length);
+			used += option.length;
+		}
+
+		if(used == 0) {
+			if(length < 2)
+				return 0;
+
+			buffer[used++] = '/';
+		}
+
+		buffer[used] = '\0';
+		return used;
+	}
+
+	String CoapMessage::path() const
+	{
+		String result;
+		RawBuffer segment;
+
+		for(size_t idx = 0; this->option(COAP_OPTION_URI_PATH, segment, idx); idx++) {
+			result += "/";
+			result += String(static_cast<const char *>(segment.buffer()), segment.size());
+		}
+
+		if(result.length() == 0)
+			result = "/";
+
+		return result;
+	}
+
+	bool CoapMessage::block(uint16_t number, CoapBlock& block) const
+	{
+		uint32_t value;
+
+		if(!this->option(number, value))
+			return false;
+
+		return CoapBlock::decode(value, block);
+	}
+
+	bool CoapMessage::setBlock(uint16_t number, const CoapBlock& block)
+	{
+		this->removeOption(number);
+		return this->addOption(number, block.encode());
+	}
+
+	bool CoapMessage::setContentFormat(uint16_t format)
+	{
+		this->removeOption(COAP_OPTION_CONTENT_FORMAT);
+		return this->addOption(COAP_OPTION_CONTENT_FORMAT, static_cast<uint32_t>(format));
+	}
+
+	const uint8_t *CoapMessage::payload() const
+	{
+		return this->_payload != nullptr ? this->_payload : this->_body.data();
+	}
+
+	size_t CoapMessage::payloadLength() const
+	{
+		return this->_payload != nullptr ? this->_payloadLength : this->_body.index();
+	}
+
+	void CoapMessage::setPayload(const void *data, size_t length)
+	{
+		this->_payload = static_cast<const uint8_t *>(data);
+		this->_payloadLength = length;
+	}
+
+	ByteBuffer& CoapMessage::body()
+	{
+		this->_payload = nullptr;
+		this->_payloadLength = 0;
+
+		return this->_body;
+	}
+
+	static bool read_extended(const uint8_t *& p, const uint8_t *end, uint32_t& value)
+	{
+		if(value == 13) {
+			if(end - p < 1)
+				return false;
+
+			value = 13U + *p++;
+		} else if(value == 14) {
+			if(end - p < 2)
+				return false;
+
+			value = 269U + ((static_cast<uint32_t>(p[0]) << 8) | p[1]);
+			p += 2;
+		} else if(value == 15) {
+			return false;
+		}
+
+		return true;
+	}
+
+	bool CoapMessage::parse(const void *data, size_t length)
+	{
+		auto p = static_cast<const uint8_t *>(data);
+		auto end = p + length;
+		uint32_t number = 0;
+
+		if(length < HeaderSize || (p[0] >> 6) != COAP_VERSION)
+			return false;
+
+		this->_type = static_cast<CoapType>((p[0] >> 4) & 0x3);
+		this->_tokenLength = p[0] & 0xF;
+		this->_code = p[1];
+		this->_id = static_cast<uint16_t>((p[2] << 8) | p[3]);
+		this->_options.clear();
+		this->_used = 0;
+		this->_payload = nullptr;
+		this->_payloadLength = 0;
+		this->_body.setIndex(0);
+		p += HeaderSize;
+
+		if(this->_tokenLength > MaxToken || static_cast<size_t>(end - p) < this->_tokenLength)
+			return false;
+
+		/* An empty message is only the header. */
+		if(this->_code == COAP_EMPTY)
+			return length == HeaderSize && this->_tokenLength == 0;
+
+		memcpy(this->_token, p, this->_tokenLength);
+		p += this->_tokenLength;
+
+		while(p < end && *p != PAYLOAD_MARKER) {
+			uint32_t delta = *p >> 4;
+			uint32_t size = *p & 0xF;
+			Option option;
+
+			p++;
+
+			if(!read_extended(p, end, delta) || !read_extended(p, end, size))
+				return false;
+
+			if(static_cast<size_t>(end - p) < size)
+				return false;
+
+			number += delta;
+
+			if(number > 0xFFFF)
+				return false;
+
+			option.number = static_cast<uint16_t>(number);
+			option.length = static_cast<uint16_t>(size);
+			option.value = p;
+			this->_options.pushback(option);
+
+			p += size;
+		}
+
+		if(p < end) {
+			/* A payload marker must be followed by a payload. */
+			if(++p == end)
+				return false;
+
+			this->_payload = p;
+			this->_payloadLength = static_cast<size_t>(end - p);
+		}
+
+		return true;
+	}
+
+	static uint8_t *write_nibble(uint32_t value, uint8_t& nibble, uint8_t *p)
+	{
+		if(value < 13) {
+			nibble = static_cast<uint8_t>(value);
+		} else if(value < 269) {
+			nibble = 13;
+			*p++ = static_cast<uint8_t>(value - 13);
+		} else {
+			nibble = 14;
+			*p++ = static_cast<uint8_t>((value - 269) >> 8);
+			*p++ = static_cast<uint8_t>(value - 269);
+		}
+
+		return p;
+	}
+
+	ssize_t CoapMessage::encode(void *buffer, size_t size) const
+	{
+		auto start = static_cast<uint8_t *>(buffer);
+		auto p = start;
+		auto end = start + size;
+		uint16_t last = 0;
+
+		if(size < HeaderSize + this->_tokenLength)
+			return -ENOMEMORY;
+
+		*p++ = static_cast<uint8_t>((COAP_VERSION << 6) | (static_cast<uint8_t>(this->_type) << 4) | this->_tokenLength);
+		*p++ = this->_code;
+		*p++ = static_cast<uint8_t>(this->_id >> 8);
+		*p++ = static_cast<uint8_t>(this->_id);
+
+		if(this->_code == COAP_EMPTY)
+			return HeaderSize;
+
+		memcpy(p, this->_token, this->_tokenLength);
+		p += this->_tokenLength;
+
+		for(const auto& option : this->_options) {
+			uint8_t header[5];
+			uint8_t delta, length;
+
+			auto q = write_nibble(option.number - last, delta, header + 1);
+			q = write_nibble(option.length, length, q);
+			header[0] = static_cast<uint8_t>((delta << 4) | length);
+
+			auto needed = static_cast<size_t>(q - header) + option.length;
+
+			if(static_cast<size_t>(end - p) < needed)
+				return -ENOMEMORY;
+
+			memcpy(p, header, static_cast<size_t>(q - header));
+			p += q - header;
+			memcpy(p, option.value, option.length);
+			p += option.length;
+			last = option.number;
+		}
+
+		auto length = this->payloadLength();
+
+		if(length > 0) {
+			if(static_cast<size_t>(end - p) < length + 1)
+				return -ENOMEMORY;
+
+			*p++ = PAYLOAD_MARKER;
+			memcpy(p, this->payload(), length);
+			p += length;
+		}
+
+		return p - start;
+	}
+}
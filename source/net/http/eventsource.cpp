@@ -0,0 +1,96 @@
+/*
+ * Server-Sent Events endpoint.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/util/numberformat.h>
+#include <lwiot/network/httpserver.h>
+#include <lwiot/network/eventsource.h>
+
+namespace lwiot
+{
+	EventSource::EventSource(size_t subscribers) : HttpPushEndpoint(subscribers), _frame(), _retry(0)
+	{
+	}
+
+	void EventSource::setRetry(int ms)
+	{
+		ScopedLock lock(this->_lock);
+		this->_retry = ms;
+	}
+
+	void EventSource::field(StringView name, StringView value)
+	{
+		this->_frame.append(reinterpret_cast<const uint8_t *>(name.data()), name.length());
+		this->_frame.append(reinterpret_cast<const uint8_t *>(": "), 2);
+		this->_frame.append(reinterpret_cast<const uint8_t *>(value.data()), value.length());
+		this->_frame.write('\n');
+	}
+
+	size_t EventSource::broadcast(StringView data, StringView event, StringView id)
+	{
+		ScopedLock lock(this->_lock);
+		BufferChain frame;
+		size_t pos = 0;
+
+		if(this->subscribers() == 0)
+			return 0;
+
+		this->_frame.setIndex(0);
+
+		if(!event.empty())
+			this->field("event", event);
+
+		if(!id.empty())
+			this->field("id", id);
+
+		/* Every line of the data is a field of its own; the client joins them again. */
+		do {
+			auto end = data.find('\n', pos);
+
+			if(end == StringView::npos)
+				end = data.length();
+
+			this->field("data", data.substr(pos, end - pos));
+			pos = end + 1;
+		} while(pos <= data.length());
+
+		this->_frame.write('\n');
+		frame.append(this->_frame);
+
+		return this->writeAll(frame);
+	}
+
+	size_t EventSource::heartbeat()
+	{
+		BufferChain frame;
+
+		frame.append(":\n\n", 3);
+		return this->writeAll(frame);
+	}
+
+	UniquePointer<TcpClient> EventSource::handshake(HttpServer &server)
+	{
+		server.sendHeader("Cache-Control", "no-cache");
+		auto client = server.takeOver(200, "text/event-stream");
+
+		if(client && this->_retry > 0) {
+			char line[NumberFormat::DecimalBufferSize + 10] = "retry: ";
+			auto length = 7 + NumberFormat::formatUnsigned(line + 7, static_cast<unsigned>(this->_retry));
+
+			line[length++] = '\n';
+			line[length++] = '\n';
+			client->write(line, length);
+		}
+
+		return client;
+	}
+}
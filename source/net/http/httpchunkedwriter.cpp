@@ -0,0 +1,327 @@
+/*
+ * HTTP chunked body writer.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <lwiot/error.h>
+#include <lwiot/bufferchain.h>
+#include <lwiot/util/numberformat.h>
+#include <lwiot/network/httpchunkedwriter.h>
+
+/* Room for the size line of a chunk in front of the data, and for its CRLF behind it. */
+#define CHUNK_HEAD 10
+#define CHUNK_TAIL 2
+
+#ifdef HAVE_ZLIB
+#define NO_FLUSH Z_NO_FLUSH
+#define SYNC_FLUSH Z_SYNC_FLUSH
+#define FINISH Z_FINISH
+#else
+#define NO_FLUSH 0
+#define SYNC_FLUSH 0
+#define FINISH 0
+#endif
+
+namespace lwiot
+{
+#ifdef HAVE_ZLIB
+	static voidpf zlib_alloc(voidpf opaque, uInt items, uInt size)
+	{
+		return lwiot_mem_alloc(items * size);
+	}
+
+	static void zlib_free(voidpf opaque, voidpf address)
+	{
+		lwiot_mem_free(address);
+	}
+#endif
+
+	HttpChunkedWriter::HttpChunkedWriter(size_t size) : _client(nullptr), _buffer(), _size(size), _length(0),
+		_chunked(false), _failed(false), _stream(nullptr)
+	{
+	}
+
+	HttpChunkedWriter::~HttpChunkedWriter()
+	{
+		this->release();
+	}
+
+	bool HttpChunkedWriter::supports(HttpContentCoding coding)
+	{
+#ifdef HAVE_ZLIB
+		return true;
+#else
+		return coding == HttpContentCoding::Identity;
+#endif
+	}
+
+	StringView HttpChunkedWriter::name(HttpContentCoding coding)
+	{
+		switch(coding) {
+		case HttpContentCoding::Gzip:
+			return "gzip";
+
+		case HttpContentCoding::Deflate:
+			return "deflate";
+
+		default:
+			return "identity";
+		}
+	}
+
+	bool HttpChunkedWriter::begin(TcpClient &client, bool chunked, HttpContentCoding coding)
+	{
+		if(this->active())
+			this->release();
+
+		if(!supports(coding))
+			return false;
+
+#ifdef HAVE_ZLIB
+		if(coding != HttpContentCoding::Identity) {
+			auto stream = static_cast<z_stream *>(lwiot_mem_alloc(sizeof(z_stream)));
+			/* Gzip framing is selected by adding 16 to the window size. */
+			auto bits = CONFIG_HTTP_DEFLATE_WINDOW_BITS + (coding == HttpContentCoding::Gzip ? 16 : 0);
+
+			memset(stream, 0, sizeof(*stream));
+			stream->zalloc = zlib_alloc;
+			stream->zfree = zlib_free;
+
+			if(deflateInit2(stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, bits, CONFIG_HTTP_DEFLATE_MEM_LEVEL,
+			                Z_DEFAULT_STRATEGY) != Z_OK) {
+				lwiot_mem_free(stream);
+				return false;
+			}
+
+			this->_stream = stream;
+		}
+#endif
+
+		this->_buffer.reserveExact(CHUNK_HEAD + this->_size + CHUNK_TAIL);
+		this->_client = &client;
+		this->_chunked = chunked;
+		this->_failed = false;
+		this->_length = 0;
+
+		return true;
+	}
+
+	ssize_t HttpChunkedWriter::write(const void *data, size_t length)
+	{
+		ssize_t rv;
+
+		if(!this->active() || this->_failed)
+			return -EINVALID;
+
+		if(length == 0)
+			return 0;
+
+		if(this->_stream != nullptr)
+			rv = this->compress(data, length, NO_FLUSH);
+		else
+			rv = this->append(data, length);
+
+		return rv < 0 ? rv : length;
+	}
+
+	bool HttpChunkedWriter::flush()
+	{
+		if(!this->active() || this->_failed)
+			return false;
+
+		if(this->_stream != nullptr && this->compress(nullptr, 0, SYNC_FLUSH) < 0)
+			return false;
+
+		return this->sendChunk();
+	}
+
+	bool HttpChunkedWriter::end()
+	{
+		bool rv;
+
+		if(!this->active())
+			return false;
+
+		if(!this->_failed && this->_stream != nullptr)
+			this->compress(nullptr, 0, FINISH);
+
+		rv = !this->_failed && this->sendChunk();
+
+		if(rv && this->_chunked) {
+			rv = this->wait() && this->_client->write("0\r\n\r\n", 5) == 5;
+		}
+
+		this->release();
+		return rv;
+	}
+
+	bool HttpChunkedWriter::active() const
+	{
+		return this->_client != nullptr;
+	}
+
+	bool HttpChunkedWriter::failed() const
+	{
+		return this->_failed;
+	}
+
+	ssize_t HttpChunkedWriter::append(const void *data, size_t length)
+	{
+		auto bytes = static_cast<const uint8_t *>(data);
+		auto buffer = this->_buffer.data() + CHUNK_HEAD;
+
+		while(length > 0) {
+			/* Data that fills a chunk by itself is sent without copying it. */
+			if(this->_length == 0 && length >= this->_size)
+				return this->sendDirect(bytes, length) ? 0 : -ETMO;
+
+			auto num = this->_size - this->_length;
+
+			if(num > length)
+				num = length;
+
+			memcpy(buffer + this->_length, bytes, num);
+			this->_length += num;
+			bytes += num;
+			length -= num;
+
+			if(this->_length == this->_size && !this->sendChunk())
+				return -ETMO;
+		}
+
+		return 0;
+	}
+
+	ssize_t HttpChunkedWriter::compress(const void *data, size_t length, int mode)
+	{
+#ifdef HAVE_ZLIB
+		auto stream = static_cast<z_stream *>(this->_stream);
+
+		stream->next_in = static_cast<Bytef *>(const_cast<void *>(data));
+		stream->avail_in = length;
+
+		do {
+			stream->next_out = this->_buffer.data() + CHUNK_HEAD + this->_length;
+			stream->avail_out = this->_size - this->_length;
+
+			if(deflate(stream, mode) == Z_STREAM_ERROR) {
+				this->fail();
+				return -EINVALID;
+			}
+
+			this->_length = this->_size - stream->avail_out;
+
+			if(stream->avail_out == 0 && !this->sendChunk())
+				return -ETMO;
+		} while(stream->avail_out == 0 || stream->avail_in > 0);
+
+		return 0;
+#else
+		return -ENOTSUPPORTED;
+#endif
+	}
+
+	bool HttpChunkedWriter::sendChunk()
+	{
+		auto data = this->_buffer.data();
+		size_t start = CHUNK_HEAD;
+		size_t total = this->_length;
+
+		if(this->_length == 0)
+			return true;
+
+		if(!this->wait())
+			return false;
+
+		if(this->_chunked) {
+			char size[NumberFormat::BufferSize];
+			auto num = NumberFormat::formatUnsigned(size, this->_length, 16);
+
+			/* The size line is written right in front of the data, the chunk goes out in one piece. */
+			start = CHUNK_HEAD - num - 2;
+			memcpy(data + start, size, num);
+			memcpy(data + CHUNK_HEAD - 2, "\r\n", 2);
+			memcpy(data + CHUNK_HEAD + this->_length, "\r\n", 2);
+			total += num + 4;
+		}
+
+		this->_length = 0;
+
+		if(this->_client->write(data + start, total) != static_cast<ssize_t>(total)) {
+			this->fail();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool HttpChunkedWriter::sendDirect(const void *data, size_t length)
+	{
+		char size[NumberFormat::BufferSize + 2];
+		BufferChain chain;
+		size_t total = length;
+
+		if(!this->wait())
+			return false;
+
+		if(this->_chunked) {
+			auto num = NumberFormat::formatUnsigned(size, length, 16);
+
+			memcpy(size + num, "\r\n", 2);
+			chain.append(size, num + 2);
+			total += num + 4;
+		}
+
+		chain.append(data, length);
+
+		if(this->_chunked)
+			chain.append("\r\n", 2);
+
+		if(this->_client->write(chain) != static_cast<ssize_t>(total)) {
+			this->fail();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool HttpChunkedWriter::wait()
+	{
+		if(this->_client->writable(CONFIG_HTTP_CHUNK_TIMEOUT))
+			return true;
+
+		this->fail();
+		return false;
+	}
+
+	void HttpChunkedWriter::fail()
+	{
+		this->_failed = true;
+		this->_length = 0;
+	}
+
+	void HttpChunkedWriter::release()
+	{
+#ifdef HAVE_ZLIB
+		if(this->_stream != nullptr) {
+			deflateEnd(static_cast<z_stream *>(this->_stream));
+			lwiot_mem_free(this->_stream);
+		}
+#endif
+
+		this->_stream = nullptr;
+		this->_client = nullptr;
+		this->_length = 0;
+	}
+}
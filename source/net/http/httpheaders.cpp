@@ -0,0 +1,170 @@
+/*
+ * Perfect hash of the well-known HTTP header names.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/network/httpheaders.h>
+
+namespace lwiot
+{
+	namespace http
+	{
+		static constexpr StringView names[HeaderCount] = {
+			"Accept",
+			"Accept-Charset",
+			"Accept-Encoding",
+			"Accept-Language",
+			"Authorization",
+			"Cache-Control",
+			"Connection",
+			"Content-Disposition",
+			"Content-Encoding",
+			"Content-Length",
+			"Content-Type",
+			"Cookie",
+			"Date",
+			"Expect",
+			"Host",
+			"If-Match",
+			"If-Modified-Since",
+			"If-None-Match",
+			"If-Range",
+			"If-Unmodified-Since",
+			"Keep-Alive",
+			"Origin",
+			"Pragma",
+			"Range",
+			"Referer",
+			"Sec-WebSocket-Extensions",
+			"Sec-WebSocket-Key",
+			"Sec-WebSocket-Protocol",
+			"Sec-WebSocket-Version",
+			"Transfer-Encoding",
+			"Upgrade",
+			"User-Agent",
+			"X-Forwarded-For",
+			"X-Requested-With"
+		};
+
+		static constexpr size_t Buckets = (HeaderCount + 1) / 2;
+
+		/*
+		 * Hash and displace: the name hash picks a bucket, and the seed of that bucket moves each
+		 * of its names into a slot of its own. There are as many slots as names.
+		 */
+		struct PerfectHash {
+			uint8_t seeds[Buckets];
+			uint8_t slots[HeaderCount];
+			bool valid;
+		};
+
+		static constexpr size_t slot_of(uint32_t hash, uint8_t seed)
+		{
+			hash ^= seed * 0x9E3779B9U;
+			hash ^= hash >> 16;
+			hash *= 0x85EBCA6BU;
+			hash ^= hash >> 13;
+
+			return hash % HeaderCount;
+		}
+
+		/* Find a seed for every bucket, the largest buckets first. */
+		static constexpr PerfectHash generate()
+		{
+			PerfectHash table = {};
+			uint8_t sizes[Buckets] = {};
+			bool taken[HeaderCount] = {};
+			size_t largest = 0;
+
+			for(size_t idx = 0; idx < HeaderCount; idx++) {
+				auto size = ++sizes[hash(names[idx]) % Buckets];
+
+				if(size > largest)
+					largest = size;
+			}
+
+			for(size_t size = largest; size > 0; size--) {
+				for(size_t bucket = 0; bucket < Buckets; bucket++) {
+					if(sizes[bucket] != size)
+						continue;
+
+					bool placed = false;
+
+					for(unsigned seed = 0; seed < 256 && !placed; seed++) {
+						bool used[HeaderCount] = {};
+
+						placed = true;
+
+						for(size_t idx = 0; idx < HeaderCount && placed; idx++) {
+							auto value = hash(names[idx]);
+
+							if(value % Buckets != bucket)
+								continue;
+
+							auto slot = slot_of(value, static_cast<uint8_t>(seed));
+
+							placed = !taken[slot] && !used[slot];
+							used[slot] = true;
+						}
+
+						if(!placed)
+							continue;
+
+						table.seeds[bucket] = static_cast<uint8_t>(seed);
+
+						for(size_t idx = 0; idx < HeaderCount; idx++) {
+							auto value = hash(names[idx]);
+
+							if(value % Buckets != bucket)
+								continue;
+
+							auto slot = slot_of(value, static_cast<uint8_t>(seed));
+
+							taken[slot] = true;
+							table.slots[slot] = static_cast<uint8_t>(idx);
+						}
+					}
+
+					if(!placed)
+						return table;
+				}
+			}
+
+			table.valid = true;
+			return table;
+		}
+
+		static constexpr PerfectHash table = generate();
+		static_assert(table.valid, "No perfect hash for the well-known header names");
+
+		Header lookup(StringView name)
+		{
+			return lookup(name, hash(name));
+		}
+
+		Header lookup(StringView name, uint32_t hash)
+		{
+			auto idx = table.slots[slot_of(hash, table.seeds[hash % Buckets])];
+
+			if(!names[idx].equalsIgnoreCase(name))
+				return Header::Unknown;
+
+			return static_cast<Header>(idx);
+		}
+
+		StringView name(Header header)
+		{
+			auto idx = static_cast<size_t>(header);
+
+			return idx < HeaderCount ? names[idx] : StringView();
+		}
+	}
+}
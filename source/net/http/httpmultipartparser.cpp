@@ -0,0 +1,338 @@
+/*
+ * Streaming multipart/form-data parser.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/network/httpmultipartparser.h>
+
+#define MAX_BOUNDARY_LENGTH 70
+
+namespace lwiot
+{
+	/* Find a parameter of a Content-Disposition value, such as name="file". */
+	static bool disposition_param(StringView value, StringView key, StringView& result)
+	{
+		auto pos = value.find(';');
+
+		while(pos != StringView::npos) {
+			auto start = pos + 1;
+			auto end = start;
+			bool quoted = false;
+
+			while(end < value.length() && (quoted || value[end] != ';')) {
+				if(value[end] == '"')
+					quoted = !quoted;
+
+				end++;
+			}
+
+			auto param = value.substr(start, end - start).trim();
+			auto eq = param.find('=');
+
+			if(eq != StringView::npos && param.substr(0, eq).trim().equalsIgnoreCase(key)) {
+				auto text = param.substr(eq + 1).trim();
+
+				if(text.length() >= 2 && text[0] == '"' && text[text.length() - 1] == '"')
+					text = text.substr(1, text.length() - 2);
+
+				result = text;
+				return true;
+			}
+
+			pos = end < value.length() ? end : StringView::npos;
+		}
+
+		return false;
+	}
+
+	HttpMultipartParser::HttpMultipartParser(StringView boundary, size_t size) : _buffer(nullptr), _size(size),
+		_length(0), _state(Preamble), _failed(false), _delimiter("\r\n--")
+	{
+		this->_delimiter += boundary.toString();
+
+		auto length = this->_delimiter.length();
+
+		if(boundary.empty() || boundary.length() > MAX_BOUNDARY_LENGTH || size <= length * 2) {
+			this->_failed = true;
+			return;
+		}
+
+		this->_buffer = new uint8_t[size];
+
+		/* The first delimiter may start the body, so it is not always preceded by a line break. */
+		this->_buffer[0] = '\r';
+		this->_buffer[1] = '\n';
+		this->_length = 2;
+
+		auto pattern = reinterpret_cast<const uint8_t*>(this->_delimiter.c_str());
+
+		for(auto& skip : this->_skip)
+			skip = static_cast<uint8_t>(length);
+
+		for(size_t idx = 0; idx < length - 1; idx++)
+			this->_skip[pattern[idx]] = static_cast<uint8_t>(length - 1 - idx);
+	}
+
+	HttpMultipartParser::~HttpMultipartParser()
+	{
+		delete[] this->_buffer;
+	}
+
+	void HttpMultipartParser::onBegin(const BeginHandler& handler)
+	{
+		this->_begin = handler;
+	}
+
+	void HttpMultipartParser::onData(const DataHandler& handler)
+	{
+		this->_data = handler;
+	}
+
+	void HttpMultipartParser::onEnd(const EndHandler& handler)
+	{
+		this->_end = handler;
+	}
+
+	bool HttpMultipartParser::done() const
+	{
+		return this->_state == Done;
+	}
+
+	bool HttpMultipartParser::failed() const
+	{
+		return this->_failed;
+	}
+
+	uint8_t *HttpMultipartParser::buffer(size_t& length)
+	{
+		if(this->_failed) {
+			length = 0;
+			return nullptr;
+		}
+
+		length = this->_size - this->_length;
+		return this->_buffer + this->_length;
+	}
+
+	size_t HttpMultipartParser::feed(const void *data, size_t length)
+	{
+		auto bytes = static_cast<const uint8_t*>(data);
+		size_t total = 0;
+
+		while(total < length) {
+			size_t room;
+			auto output = this->buffer(room);
+
+			if(room == 0)
+				break;
+
+			if(room > length - total)
+				room = length - total;
+
+			memcpy(output, bytes + total, room);
+			this->commit(room);
+			total += room;
+		}
+
+		return total;
+	}
+
+	void HttpMultipartParser::commit(size_t length)
+	{
+		size_t pos = 0;
+
+		if(this->_failed || this->_state == Done)
+			return;
+
+		this->_length += length;
+
+		while(this->process(pos)) {
+		}
+
+		if(this->_state == Done) {
+			this->_length = 0;
+			return;
+		}
+
+		memmove(this->_buffer, this->_buffer + pos, this->_length - pos);
+		this->_length -= pos;
+
+		/* Nothing more can be consumed once the buffer is full of unprocessed data. */
+		if(this->_length == this->_size)
+			this->_failed = true;
+	}
+
+	bool HttpMultipartParser::process(size_t& pos)
+	{
+		if(this->_failed)
+			return false;
+
+		switch(this->_state) {
+		case Preamble: {
+			auto length = this->_delimiter.length();
+			auto idx = this->search(pos);
+
+			if(idx == StringView::npos) {
+				if(this->_length - pos >= length)
+					pos = this->_length - (length - 1);
+
+				return false;
+			}
+
+			pos = idx + length;
+			this->_state = Delimiter;
+			return true;
+		}
+
+		case Delimiter:
+			return this->parseDelimiter(pos);
+
+		case Headers:
+			return this->parseHeaders(pos);
+
+		case Body:
+			return this->parseBody(pos);
+
+		default:
+			return false;
+		}
+	}
+
+	size_t HttpMultipartParser::search(size_t pos) const
+	{
+		auto pattern = reinterpret_cast<const uint8_t*>(this->_delimiter.c_str());
+		auto length = this->_delimiter.length();
+		auto last = pattern[length - 1];
+
+		while(this->_length - pos >= length) {
+			auto c = this->_buffer[pos + length - 1];
+
+			if(c == last && memcmp(this->_buffer + pos, pattern, length - 1) == 0)
+				return pos;
+
+			pos += this->_skip[c];
+		}
+
+		return StringView::npos;
+	}
+
+	bool HttpMultipartParser::parseDelimiter(size_t& pos)
+	{
+		auto idx = pos;
+
+		if(this->_length - idx < 2)
+			return false;
+
+		if(this->_buffer[idx] == '-' && this->_buffer[idx + 1] == '-') {
+			this->_state = Done;
+			return false;
+		}
+
+		/* Transport padding may follow the boundary. */
+		while(idx < this->_length && (this->_buffer[idx] == ' ' || this->_buffer[idx] == '\t'))
+			idx++;
+
+		if(this->_length - idx < 2)
+			return false;
+
+		if(this->_buffer[idx] != '\r' || this->_buffer[idx + 1] != '\n') {
+			this->_failed = true;
+			return false;
+		}
+
+		pos = idx + 2;
+		this->_state = Headers;
+		return true;
+	}
+
+	bool HttpMultipartParser::parseHeaders(size_t& pos)
+	{
+		StringView text(reinterpret_cast<const char*>(this->_buffer + pos), this->_length - pos);
+		HttpMultipartPart part;
+		size_t end = 0;
+
+		if(!text.startsWith("\r\n")) {
+			end = text.find("\r\n\r\n");
+
+			if(end == StringView::npos)
+				return false;
+
+			end += 2;
+		}
+
+		part.file = false;
+
+		for(size_t start = 0; start < end;) {
+			auto eol = text.find("\r\n", start);
+			auto line = text.substr(start, eol - start);
+			auto colon = line.find(':');
+
+			start = eol + 2;
+
+			if(colon == StringView::npos)
+				continue;
+
+			auto name = line.substr(0, colon).trim();
+			auto value = line.substr(colon + 1).trim();
+
+			if(name.equalsIgnoreCase("Content-Disposition")) {
+				disposition_param(value, "name", part.name);
+				part.file = disposition_param(value, "filename", part.filename);
+			} else if(name.equalsIgnoreCase("Content-Type")) {
+				part.type = value;
+			}
+		}
+
+		pos += end + 2;
+		this->_state = Body;
+
+		if(this->_begin && !this->_begin(part)) {
+			this->_failed = true;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool HttpMultipartParser::parseBody(size_t& pos)
+	{
+		auto length = this->_delimiter.length();
+		auto idx = this->search(pos);
+
+		if(idx == StringView::npos) {
+			if(this->_length - pos < length)
+				return false;
+
+			/* The last bytes could be the start of a delimiter that is still being received. */
+			auto safe = this->_length - (length - 1);
+
+			if(this->_data && !this->_data(this->_buffer + pos, safe - pos))
+				this->_failed = true;
+
+			pos = safe;
+			return false;
+		}
+
+		if(idx > pos && this->_data && !this->_data(this->_buffer + pos, idx - pos)) {
+			this->_failed = true;
+			return false;
+		}
+
+		pos = idx + length;
+		this->_state = Delimiter;
+
+		if(this->_end && !this->_end()) {
+			this->_failed = true;
+			return false;
+		}
+
+		return true;
+	}
+}
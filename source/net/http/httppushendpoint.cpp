@@ -0,0 +1,160 @@
+/*
+ * HTTP push endpoint.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/stl/move.h>
+#include <lwiot/network/stdnet.h>
+#include <lwiot/network/httpserver.h>
+#include <lwiot/network/httppushendpoint.h>
+
+namespace lwiot
+{
+	HttpPushEndpoint::HttpPushEndpoint(size_t subscribers) : _lock(true), _clients(new UniquePointer<TcpClient>[subscribers]),
+		_max(subscribers), _count(0)
+	{
+	}
+
+	HttpPushEndpoint::~HttpPushEndpoint()
+	{
+		for(size_t idx = 0; idx < this->_max; idx++) {
+			if(this->_clients[idx])
+				this->_clients[idx]->close();
+		}
+
+		delete[] this->_clients;
+	}
+
+	void HttpPushEndpoint::accept(HttpServer &server)
+	{
+		ScopedLock lock(this->_lock);
+		size_t slot = 0;
+
+		while(slot < this->_max && this->_clients[slot])
+			slot++;
+
+		if(slot == this->_max) {
+			server.send(503, "text/plain", "Too many subscribers");
+			return;
+		}
+
+		auto client = this->handshake(server);
+
+		if(!client)
+			return;
+
+		this->_clients[slot] = stl::move(client);
+		this->_count++;
+		this->attached(slot);
+	}
+
+	void HttpPushEndpoint::process()
+	{
+		ScopedLock lock(this->_lock);
+
+		for(size_t idx = 0; idx < this->_max; idx++) {
+			auto client = this->_clients[idx].get();
+
+			if(client == nullptr)
+				continue;
+
+			if(client->available() > 0) {
+				if(!this->receive(idx, *client))
+					this->drop(idx);
+			} else if(!client->alive()) {
+				this->drop(idx);
+			}
+		}
+	}
+
+	void HttpPushEndpoint::close()
+	{
+		ScopedLock lock(this->_lock);
+
+		for(size_t idx = 0; idx < this->_max; idx++)
+			this->drop(idx);
+	}
+
+	size_t HttpPushEndpoint::subscribers() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_count;
+	}
+
+	bool HttpPushEndpoint::receive(size_t idx, TcpClient &client)
+	{
+		auto span = client.peekSpan();
+
+		client.skip(span.size());
+		return true;
+	}
+
+	void HttpPushEndpoint::attached(size_t idx)
+	{
+	}
+
+	void HttpPushEndpoint::detached(size_t idx)
+	{
+	}
+
+	size_t HttpPushEndpoint::writeAll(const BufferChain &frame)
+	{
+		ScopedLock lock(this->_lock);
+		size_t count = 0;
+
+		for(size_t idx = 0; idx < this->_max; idx++) {
+			auto client = this->_clients[idx].get();
+
+			/* A subscriber that is behind misses the frame, instead of holding up the others. */
+			if(client == nullptr || !client->writable(SOCKET_POLL_NOWAIT))
+				continue;
+
+			if(this->writeTo(idx, frame))
+				count++;
+		}
+
+		return count;
+	}
+
+	bool HttpPushEndpoint::writeTo(size_t idx, const BufferChain &frame)
+	{
+		ScopedLock lock(this->_lock);
+		auto client = this->subscriber(idx);
+
+		if(client == nullptr)
+			return false;
+
+		if(client->write(frame) != static_cast<ssize_t>(frame.length())) {
+			this->drop(idx);
+			return false;
+		}
+
+		return true;
+	}
+
+	TcpClient *HttpPushEndpoint::subscriber(size_t idx) const
+	{
+		return idx < this->_max ? this->_clients[idx].get() : nullptr;
+	}
+
+	void HttpPushEndpoint::drop(size_t idx)
+	{
+		ScopedLock lock(this->_lock);
+
+		if(idx >= this->_max || !this->_clients[idx])
+			return;
+
+		this->detached(idx);
+		this->_clients[idx]->close();
+		this->_clients[idx].reset();
+		this->_count--;
+	}
+}
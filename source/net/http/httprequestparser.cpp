@@ -0,0 +1,342 @@
+/*
+ * Incremental HTTP request head parser.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/network/httprequestparser.h>
+
+namespace lwiot
+{
+	static_assert(CONFIG_HTTP_MAX_HEADERS < 256, "Header indices are stored in a byte");
+
+	static int hex_value(char c)
+	{
+		if(c >= '0' && c <= '9')
+			return c - '0';
+		if(c >= 'a' && c <= 'f')
+			return c - 'a' + 10;
+		if(c >= 'A' && c <= 'F')
+			return c - 'A' + 10;
+
+		return -1;
+	}
+
+	/* Decode the character at \p idx, advancing \p idx past it. */
+	static char decode_char(StringView text, size_t& idx)
+	{
+		auto c = text[idx++];
+
+		if(c == '+')
+			return ' ';
+
+		if(c == '%' && idx + 1 < text.length() && hex_value(text[idx]) >= 0 && hex_value(text[idx + 1]) >= 0) {
+			c = static_cast<char>(hex_value(text[idx]) << 4 | hex_value(text[idx + 1]));
+			idx += 2;
+		}
+
+		return c;
+	}
+
+	static bool is_token(char c)
+	{
+		return c > 0x20 && c < 0x7F && strchr("()<>@,;:\\\"/[]?={}", c) == nullptr;
+	}
+
+	static StringView trim_whitespace(StringView text)
+	{
+		size_t start = 0;
+		size_t end = text.length();
+
+		while(start < end && (text[start] == ' ' || text[start] == '\t'))
+			start++;
+
+		while(end > start && (text[end - 1] == ' ' || text[end - 1] == '\t'))
+			end--;
+
+		return text.substr(start, end - start);
+	}
+
+	HttpRequestParser::HttpRequestParser(size_t size) : _buffer(new char[size]), _size(size)
+	{
+		this->reset();
+	}
+
+	HttpRequestParser::~HttpRequestParser()
+	{
+		delete[] this->_buffer;
+	}
+
+	void HttpRequestParser::reset()
+	{
+		this->_length = 0;
+		this->_newlines = 0;
+		this->_done = false;
+		this->_failed = false;
+		this->_count = 0;
+		this->_version = 0;
+		memset(this->_known, 0, sizeof(this->_known));
+
+		this->_method = this->_target = this->_path = this->_query = StringView();
+	}
+
+	size_t HttpRequestParser::feed(const void *data, size_t length)
+	{
+		auto bytes = static_cast<const char*>(data);
+		size_t idx;
+
+		for(idx = 0; idx < length && !this->_done && !this->_failed; idx++) {
+			auto c = bytes[idx];
+
+			/* Empty lines in front of the request line are ignored. */
+			if(this->_length == 0 && (c == '\r' || c == '\n'))
+				continue;
+
+			if(this->_length == this->_size) {
+				this->_failed = true;
+				break;
+			}
+
+			this->_buffer[this->_length++] = c;
+
+			/*
+			 * Count the line breaks since the last character that is not part of one. The head
+			 * ends at the second one, so both CRLF CRLF and a bare LF LF are accepted.
+			 */
+			if(c == '\n') {
+				if(++this->_newlines == 2) {
+					this->_done = this->parse();
+					this->_failed = !this->_done;
+				}
+			} else if(c != '\r') {
+				this->_newlines = 0;
+			}
+		}
+
+		return idx;
+	}
+
+	bool HttpRequestParser::parse()
+	{
+		StringView head(this->_buffer, this->_length);
+		bool first = true;
+		size_t pos = 0;
+
+		while(pos < head.length()) {
+			auto end = head.find('\n', pos);
+
+			if(end == StringView::npos)
+				end = head.length();
+
+			auto line = head.substr(pos, end - pos);
+			pos = end + 1;
+
+			if(line.length() > 0 && line[line.length() - 1] == '\r')
+				line = line.substr(0, line.length() - 1);
+
+			if(line.empty())
+				break;
+
+			if(first) {
+				if(!this->parseRequestLine(line))
+					return false;
+
+				first = false;
+				continue;
+			}
+
+			if(!this->parseHeader(line))
+				return false;
+		}
+
+		return !first;
+	}
+
+	bool HttpRequestParser::parseRequestLine(StringView line)
+	{
+		auto method_end = line.find(' ');
+
+		if(method_end == StringView::npos || method_end == 0)
+			return false;
+
+		auto target_end = line.find(' ', method_end + 1);
+
+		if(target_end == StringView::npos || target_end == method_end + 1)
+			return false;
+
+		this->_method = line.substr(0, method_end);
+
+		for(auto c : this->_method) {
+			if(!is_token(c))
+				return false;
+		}
+
+		this->_target = line.substr(method_end + 1, target_end - method_end - 1);
+
+		auto version = line.substr(target_end + 1);
+
+		if(version.length() != 8 || !version.startsWith("HTTP/1.") || version[7] < '0' || version[7] > '9')
+			return false;
+
+		this->_version = version[7] - '0';
+
+		auto query = this->_target.find('?');
+
+		if(query == StringView::npos) {
+			this->_path = this->_target;
+		} else {
+			this->_path = this->_target.substr(0, query);
+			this->_query = this->_target.substr(query + 1);
+		}
+
+		return true;
+	}
+
+	bool HttpRequestParser::parseHeader(StringView line)
+	{
+		/* Obsolete line folding is rejected, as RFC 7230 allows. */
+		if(line[0] == ' ' || line[0] == '\t')
+			return false;
+
+		auto colon = line.find(':');
+
+		if(colon == StringView::npos || colon == 0 || this->_count == CONFIG_HTTP_MAX_HEADERS)
+			return false;
+
+		auto& header = this->_headers[this->_count++];
+
+		header.name = line.substr(0, colon);
+		header.value = trim_whitespace(line.substr(colon + 1));
+
+		for(auto c : header.name) {
+			if(!is_token(c))
+				return false;
+		}
+
+		header.id = http::lookup(header.name);
+
+		if(header.id != http::Header::Unknown && this->_known[static_cast<size_t>(header.id)] == 0)
+			this->_known[static_cast<size_t>(header.id)] = static_cast<uint8_t>(this->_count);
+
+		return true;
+	}
+
+	bool HttpRequestParser::done() const
+	{
+		return this->_done;
+	}
+
+	bool HttpRequestParser::failed() const
+	{
+		return this->_failed;
+	}
+
+	bool HttpRequestParser::started() const
+	{
+		return this->_length > 0;
+	}
+
+	StringView HttpRequestParser::method() const
+	{
+		return this->_method;
+	}
+
+	StringView HttpRequestParser::target() const
+	{
+		return this->_target;
+	}
+
+	StringView HttpRequestParser::path() const
+	{
+		return this->_path;
+	}
+
+	StringView HttpRequestParser::query() const
+	{
+		return this->_query;
+	}
+
+	int HttpRequestParser::version() const
+	{
+		return this->_version;
+	}
+
+	size_t HttpRequestParser::headers() const
+	{
+		return this->_count;
+	}
+
+	StringView HttpRequestParser::headerName(size_t idx) const
+	{
+		return idx < this->_count ? this->_headers[idx].name : StringView();
+	}
+
+	StringView HttpRequestParser::headerValue(size_t idx) const
+	{
+		return idx < this->_count ? this->_headers[idx].value : StringView();
+	}
+
+	http::Header HttpRequestParser::headerId(size_t idx) const
+	{
+		return idx < this->_count ? this->_headers[idx].id : http::Header::Unknown;
+	}
+
+	StringView HttpRequestParser::header(StringView name) const
+	{
+		auto id = http::lookup(name);
+
+		if(id != http::Header::Unknown)
+			return this->header(id);
+
+		for(size_t idx = 0; idx < this->_count; idx++) {
+			if(this->_headers[idx].id == http::Header::Unknown && this->_headers[idx].name.equalsIgnoreCase(name))
+				return this->_headers[idx].value;
+		}
+
+		return StringView();
+	}
+
+	StringView HttpRequestParser::header(http::Header id) const
+	{
+		auto idx = static_cast<size_t>(id);
+
+		if(idx >= http::HeaderCount || this->_known[idx] == 0)
+			return StringView();
+
+		return this->_headers[this->_known[idx] - 1].value;
+	}
+
+	String HttpRequestParser::decode(StringView text)
+	{
+		String decoded;
+		size_t idx = 0;
+
+		decoded.reserve(text.length());
+
+		while(idx < text.length())
+			decoded += decode_char(text, idx);
+
+		return decoded;
+	}
+
+	bool HttpRequestParser::decodedEquals(StringView encoded, StringView plain)
+	{
+		size_t idx = 0;
+		size_t pos = 0;
+
+		while(idx < encoded.length()) {
+			if(pos == plain.length() || decode_char(encoded, idx) != plain[pos])
+				return false;
+
+			pos++;
+		}
+
+		return pos == plain.length();
+	}
+}
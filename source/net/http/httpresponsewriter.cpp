@@ -0,0 +1,224 @@
+/*
+ * HTTP response writer.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/bufferchain.h>
+#include <lwiot/util/numberformat.h>
+#include <lwiot/network/httpresponsewriter.h>
+
+/* Room for the longest status line, in front of the headers. */
+#define HEAD_ROOM 48
+#define STATUS_PREFIX (sizeof("HTTP/1.1 200 ") - 1)
+
+namespace lwiot
+{
+	struct StatusLine {
+		int code;
+		const char *line;
+		size_t length;
+	};
+
+#define STATUS(__code, __reason) \
+	{ __code, "HTTP/1.1 " #__code " " __reason "\r\n", sizeof("HTTP/1.1 " #__code " " __reason "\r\n") - 1 }
+
+	/* Sorted by code. */
+	static constexpr StatusLine status_lines[] = {
+		STATUS(100, "Continue"),
+		STATUS(101, "Switching Protocols"),
+		STATUS(200, "OK"),
+		STATUS(201, "Created"),
+		STATUS(202, "Accepted"),
+		STATUS(203, "Non-Authoritative Information"),
+		STATUS(204, "No Content"),
+		STATUS(205, "Reset Content"),
+		STATUS(206, "Partial Content"),
+		STATUS(300, "Multiple Choices"),
+		STATUS(301, "Moved Permanently"),
+		STATUS(302, "Found"),
+		STATUS(303, "See Other"),
+		STATUS(304, "Not Modified"),
+		STATUS(305, "Use Proxy"),
+		STATUS(307, "Temporary Redirect"),
+		STATUS(400, "Bad Request"),
+		STATUS(401, "Unauthorized"),
+		STATUS(402, "Payment Required"),
+		STATUS(403, "Forbidden"),
+		STATUS(404, "Not Found"),
+		STATUS(405, "Method Not Allowed"),
+		STATUS(406, "Not Acceptable"),
+		STATUS(407, "Proxy Authentication Required"),
+		STATUS(408, "Request Time-out"),
+		STATUS(409, "Conflict"),
+		STATUS(410, "Gone"),
+		STATUS(411, "Length Required"),
+		STATUS(412, "Precondition Failed"),
+		STATUS(413, "Request Entity Too Large"),
+		STATUS(414, "Request-URI Too Large"),
+		STATUS(415, "Unsupported Media Type"),
+		STATUS(416, "Requested range not satisfiable"),
+		STATUS(417, "Expectation Failed"),
+		STATUS(426, "Upgrade Required"),
+		STATUS(500, "Internal Server Error"),
+		STATUS(501, "Not Implemented"),
+		STATUS(502, "Bad Gateway"),
+		STATUS(503, "Service Unavailable"),
+		STATUS(504, "Gateway Time-out"),
+		STATUS(505, "HTTP Version not supported"),
+	};
+
+#undef STATUS
+
+	static const StatusLine *find_status(int code)
+	{
+		size_t low = 0;
+		size_t high = sizeof(status_lines) / sizeof(status_lines[0]);
+
+		while(low < high) {
+			auto mid = (low + high) / 2;
+
+			if(status_lines[mid].code == code)
+				return &status_lines[mid];
+
+			if(status_lines[mid].code < code)
+				low = mid + 1;
+			else
+				high = mid;
+		}
+
+		return nullptr;
+	}
+
+	HttpResponseWriter::HttpResponseWriter(size_t size) : _buffer(size > HEAD_ROOM ? size : HEAD_ROOM * 2),
+		_start(HEAD_ROOM)
+	{
+		this->_buffer.setIndex(HEAD_ROOM);
+	}
+
+	StringView HttpResponseWriter::reason(int code)
+	{
+		auto status = find_status(code);
+
+		if(status == nullptr)
+			return StringView();
+
+		return StringView(status->line + STATUS_PREFIX, status->length - STATUS_PREFIX - 2);
+	}
+
+	void HttpResponseWriter::reserve(size_t length)
+	{
+		auto needed = this->_buffer.index() + length;
+
+		if(needed <= this->_buffer.count())
+			return;
+
+		if(needed < this->_buffer.count() * 2)
+			needed = this->_buffer.count() * 2;
+
+		this->_buffer.reserveExact(needed);
+	}
+
+	void HttpResponseWriter::begin(uint8_t version, int code)
+	{
+		auto status = find_status(code);
+		char line[NumberFormat::DecimalBufferSize + 12];
+		const char *text;
+		size_t length;
+
+		if(status != nullptr) {
+			text = status->line;
+			length = status->length;
+		} else {
+			memcpy(line, "HTTP/1.1 ", STATUS_PREFIX - 4);
+			length = STATUS_PREFIX - 4;
+			length += NumberFormat::formatUnsigned(line + length, static_cast<unsigned>(code));
+			memcpy(line + length, " \r\n", 3);
+			length += 3;
+			text = line;
+		}
+
+		this->_start = HEAD_ROOM - length;
+		memcpy(this->_buffer.data() + this->_start, text, length);
+
+		if(version == 0)
+			this->_buffer.data()[this->_start + 7] = '0';
+	}
+
+	void HttpResponseWriter::header(StringView name, StringView value, bool first)
+	{
+		auto length = name.length() + value.length() + 4;
+		auto index = this->_buffer.index();
+
+		this->reserve(length);
+
+		auto data = this->_buffer.data();
+		auto output = data + index;
+
+		if(first) {
+			memmove(data + HEAD_ROOM + length, data + HEAD_ROOM, index - HEAD_ROOM);
+			output = data + HEAD_ROOM;
+		}
+
+		memcpy(output, name.data(), name.length());
+		output += name.length();
+		*output++ = ':';
+		*output++ = ' ';
+		memcpy(output, value.data(), value.length());
+		output += value.length();
+		*output++ = '\r';
+		*output = '\n';
+
+		this->_buffer.setIndex(index + length);
+	}
+
+	void HttpResponseWriter::header(StringView name, size_t value)
+	{
+		char text[NumberFormat::DecimalBufferSize];
+		auto length = NumberFormat::formatUnsigned(text, value);
+
+		this->header(name, StringView(text, length));
+	}
+
+	void HttpResponseWriter::append(StringView lines)
+	{
+		this->reserve(lines.length());
+		this->_buffer.writeUnchecked(lines.data(), lines.length());
+	}
+
+	ssize_t HttpResponseWriter::send(TcpClient &client, const void *body, size_t length)
+	{
+		BufferChain chain;
+
+		if(this->_start == HEAD_ROOM)
+			this->begin(1, 200);
+
+		this->append("\r\n");
+		chain.append(this->_buffer.data() + this->_start, this->_buffer.index() - this->_start);
+
+		if(length > 0)
+			chain.append(body, length);
+
+		auto rv = client.write(chain);
+
+		this->clear();
+		return rv;
+	}
+
+	void HttpResponseWriter::clear()
+	{
+		this->_buffer.setIndex(HEAD_ROOM);
+		this->_start = HEAD_ROOM;
+	}
+
+	bool HttpResponseWriter::empty() const
+	{
+		return this->_buffer.index() == HEAD_ROOM;
+	}
+}
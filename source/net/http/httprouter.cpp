@@ -0,0 +1,227 @@
+/*
+ * HTTP route table.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/network/httprouter.h>
+
+namespace lwiot
+{
+	/* Split the first segment off a path that starts with a separator. */
+	static bool next_segment(StringView& path, StringView& segment)
+	{
+		if(path.empty() || path[0] != '/')
+			return false;
+
+		auto end = path.find('/', 1);
+
+		if(end == StringView::npos)
+			end = path.length();
+
+		segment = path.substr(1, end - 1);
+		path = path.substr(end);
+
+		return true;
+	}
+
+	static bool is_param(StringView segment)
+	{
+		return segment.length() >= 2 && segment[0] == '{' && segment[segment.length() - 1] == '}';
+	}
+
+	HttpRouter::Node::Node(StringView segment) : segment(segment.toString()), param(nullptr), handlers(), wildcard(),
+		named(false), wildcard_named(false)
+	{
+	}
+
+	HttpRouter::Node::~Node()
+	{
+		for(auto node : this->children)
+			delete node;
+
+		delete this->param;
+	}
+
+	HttpRouter::HttpRouter() : _root(new Node(""))
+	{
+	}
+
+	HttpRouter::~HttpRouter()
+	{
+		delete this->_root;
+	}
+
+	void HttpRouter::clear()
+	{
+		delete this->_root;
+		this->_root = new Node("");
+	}
+
+	bool HttpRouter::empty() const
+	{
+		const auto root = this->_root;
+
+		if(root->param != nullptr || root->children.size() > 0)
+			return false;
+
+		for(int idx = 0; idx < Methods; idx++) {
+			if(root->handlers[idx] != nullptr || root->wildcard[idx] != nullptr)
+				return false;
+		}
+
+		return true;
+	}
+
+	HttpRouter::Node* HttpRouter::child(const Node* node, StringView segment, size_t* position)
+	{
+		size_t low = 0;
+		size_t high = node->children.size();
+
+		while(low < high) {
+			auto mid = low + (high - low) / 2;
+			auto rv = StringView(node->children[mid]->segment).compare(segment);
+
+			if(rv == 0)
+				return node->children[mid];
+
+			if(rv < 0)
+				low = mid + 1;
+			else
+				high = mid;
+		}
+
+		if(position != nullptr)
+			*position = low;
+
+		return nullptr;
+	}
+
+	bool HttpRouter::add(StringView pattern, HTTPMethod method, RequestHandler* handler)
+	{
+		stl::Vector<String> names;
+		StringView segment;
+		auto node = this->_root;
+		bool wildcard = false;
+
+		while(next_segment(pattern, segment)) {
+			if(segment.equals("*") && pattern.empty()) {
+				wildcard = true;
+				break;
+			}
+
+			if(is_param(segment)) {
+				if(node->param == nullptr)
+					node->param = new Node("");
+
+				names.push_back(segment.substr(1, segment.length() - 2).toString());
+				node = node->param;
+				continue;
+			}
+
+			size_t position;
+			auto next = child(node, segment, &position);
+
+			if(next == nullptr) {
+				next = new Node(segment);
+				node->children.insert(position, next);
+			}
+
+			node = next;
+		}
+
+		if(!pattern.empty()) {
+			print_dbg("Invalid route pattern: %.*s\n", static_cast<int>(pattern.length()), pattern.data());
+			return false;
+		}
+
+		if(names.size() > CONFIG_HTTP_PATH_ARGS - (wildcard ? 1 : 0))
+			return false;
+
+		auto slots = wildcard ? node->wildcard : node->handlers;
+
+		if(slots[method] != nullptr)
+			return false;
+
+		slots[method] = handler;
+
+		/* Routes that end in the same node have their parameters in the same positions; the first
+		   registration names them. */
+		if(wildcard && !node->wildcard_named) {
+			names.push_back("*");
+			node->wildcard_names = names;
+			node->wildcard_named = true;
+		} else if(!wildcard && !node->named) {
+			node->names = names;
+			node->named = true;
+		}
+
+		return true;
+	}
+
+	RequestHandler* HttpRouter::pick(RequestHandler* const * handlers, HTTPMethod method)
+	{
+		return handlers[method] != nullptr ? handlers[method] : handlers[HTTP_ANY];
+	}
+
+	RequestHandler* HttpRouter::match(const Node* node, HTTPMethod method, StringView path, HttpPathArgs& args)
+	{
+		RequestHandler* handler;
+		StringView segment;
+
+		if(path.empty()) {
+			handler = pick(node->handlers, method);
+
+			if(handler != nullptr)
+				args.names = &node->names;
+
+			return handler;
+		}
+
+		auto rest = path;
+
+		if(!next_segment(rest, segment))
+			return nullptr;
+
+		auto next = child(node, segment, nullptr);
+
+		if(next != nullptr && (handler = match(next, method, rest, args)) != nullptr)
+			return handler;
+
+		if(node->param != nullptr && args.count < CONFIG_HTTP_PATH_ARGS) {
+			auto count = args.count;
+
+			args.values[args.count++] = segment;
+
+			if((handler = match(node->param, method, rest, args)) != nullptr)
+				return handler;
+
+			args.count = count;
+		}
+
+		handler = pick(node->wildcard, method);
+
+		if(handler != nullptr && args.count < CONFIG_HTTP_PATH_ARGS) {
+			args.values[args.count++] = path.substr(1);
+			args.names = &node->wildcard_names;
+			return handler;
+		}
+
+		return nullptr;
+	}
+
+	RequestHandler* HttpRouter::match(HTTPMethod method, StringView path, HttpPathArgs& args) const
+	{
+		args.count = 0;
+		args.names = nullptr;
+
+		return match(this->_root, method, path, args);
+	}
+}
@@ -9,6 +9,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <lwiot.h>
 
 #include <lwiot/types.h>
@@ -18,6 +19,7 @@
 #include <lwiot/network/requesthandler.h>
 #include <lwiot/function.h>
 #include <lwiot/network/httpserver.h>
+#include <lwiot/network/httpmultipartparser.h>
 #include <lwiot/kernel/thread.h>
 #include <lwiot/network/base64.h>
 
@@ -26,6 +28,14 @@
 #include <lwiot/network/tcpclient.h>
 #include <lwiot/stl/move.h>
 #include <lwiot/bytebuffer.h>
+#include <lwiot/bufferchain.h>
+#include <lwiot/util/numberformat.h>
+#include <lwiot/util/json.h>
+#include <lwiot/util/metrics.h>
+
+#ifdef HAVE_UNISTD_H
+#include <lwiot/io/file.h>
+#endif
 
 #include "mimetable.h"
 #include "requesthandlerimpl.h"
@@ -44,30 +54,51 @@ namespace lwiot
 {
 	HttpServer::HttpServer(TcpServer* server)
 			: _server(server), _currentMethod(HTTP_ANY), _currentVersion(0), _currentStatus(HC_NONE),
-			  _statusChange(0), _currentHandler(nullptr), _firstHandler(nullptr), _lastHandler(nullptr),
-			  _currentArgCount(0), _currentArgs(nullptr), _headerKeysCount(0), _currentHeaders(nullptr),
-			  _contentLength(0), _chunked(false)
+			  _statusChange(0), _currentHandler(nullptr), _routed(false), _currentArgCount(0), _currentArgs(nullptr), _headerKeysCount(0), _currentHeaders(nullptr),
+			  _headerSlots(nullptr), _headerMask(0),
+			  _contentLength(0), _chunked(false), _keepAlive(false), _connections(nullptr), _maxConnections(0),
+			  _idleTimeout(CONFIG_HTTP_KEEPALIVE_TIMEOUT), _pipelining(false), _response(&_writer), _currentParser(nullptr)
 	{
+		_keepAliveHeader = String(F("Keep-Alive: timeout=")) + String(_idleTimeout / 1000) + "\r\n";
 	}
 
 	HttpServer::~HttpServer()
 	{
+		delete[] _connections;
 		_server->close();
 
 		delete[]_currentHeaders;
-		delete[] _currentArgs;
+		delete[]_headerSlots;
 
-		RequestHandler *handler = _firstHandler;
+		while(!_handlers.empty()) {
+			RequestHandler *handler = &_handlers.front();
 
-		while(handler) {
-			RequestHandler *next = handler->next();
+			_handlers.pop_front();
 			delete handler;
-			handler = next;
 		}
+
+		while(!_routes.empty()) {
+			RequestHandler *handler = &_routes.front();
+
+			_routes.pop_front();
+			delete handler;
+		}
+
+		while(!_endpoints.empty())
+			_endpoints.pop_front();
 	}
 
 	bool HttpServer::begin()
 	{
+		this->_router.clear();
+
+		for(auto& route : this->_routes) {
+			auto& handler = static_cast<FunctionRequestHandler&>(route);
+			this->_router.add(handler.uri(), handler.method(), &handler);
+		}
+
+		this->_routed = true;
+
 		this->_server->connect();
 		auto value = this->_server->bind();
 		this->_server->setTimeout(HTTP_MAX_SEND_WAIT);
@@ -85,10 +116,19 @@ namespace lwiot
 	String HttpServer::_getRandomHexString()
 	{
 		char buffer[33];  // buffer to hold 32 Hex Digit + /0
+		uint32_t r[4];
 		int i;
-		int r = rand();
+
+#ifdef HAVE_RANDOM_BYTES
+		if(lwiot_random_bytes(r, sizeof(r)) != -EOK)
+#endif
+		{
+			for(i = 0; i < 4; i++)
+				r[i] = rand();
+		}
+
 		for(i = 0; i < 4; i++) {
-			sprintf(buffer + (i * 8), "%08x", r);
+			sprintf(buffer + (i * 8), "%08x", static_cast<unsigned int>(r[i]));
 		}
 		return String(buffer);
 	}
@@ -127,7 +167,12 @@ namespace lwiot
 	void HttpServer::on(const String &uri, HTTPMethod method, HttpServer::THandlerFunction fn,
 	                    HttpServer::THandlerFunction ufn)
 	{
-		_addRequestHandler(new FunctionRequestHandler(fn, ufn, uri, method));
+		auto handler = new FunctionRequestHandler(fn, ufn, uri, method);
+
+		_routes.push_back(*handler);
+
+		if(_routed)
+			_router.add(uri, method, handler);
 	}
 
 	void HttpServer::addHandler(RequestHandler *handler)
@@ -135,21 +180,227 @@ namespace lwiot
 		_addRequestHandler(handler);
 	}
 
+#ifdef HAVE_UNISTD_H
+	void HttpServer::serveStatic(const String &uri, const String &path, const char *cacheHeader)
+	{
+		_addRequestHandler(new StaticFileHandler(uri, path, cacheHeader));
+	}
+
+	void HttpServer::serveStatic(const String &uri, const MappedRegion &region, const char *contentType,
+	                             const char *cacheHeader)
+	{
+		_addRequestHandler(new StaticRegionHandler(uri, region, contentType, cacheHeader));
+	}
+#endif
+
+	void HttpServer::addEndpoint(const String &uri, HttpPushEndpoint &endpoint)
+	{
+		_addRequestHandler(new PushRequestHandler(uri, endpoint));
+		_endpoints.push_back(endpoint);
+	}
+
+	void HttpServer::serveTimeSeries(const String &uri, TimeSeriesStore &store)
+	{
+		_addRequestHandler(new TimeSeriesHandler(uri, store));
+	}
+
+	void HttpServer::serveMetrics(const String &uri, metrics::Registry &registry)
+	{
+		_addRequestHandler(new MetricsHandler(uri, registry));
+	}
+
+	void HttpServer::serveMetrics(const String &uri)
+	{
+		this->serveMetrics(uri, metrics::Registry::global());
+	}
+
+	void HttpServer::serveCanned(const String &uri, int code, const String &headers, const String &body)
+	{
+		CannedResponse canned;
+
+		canned.request = String(F("GET ")) + uri;
+		canned.response = String(F("HTTP/1.1 ")) + String(code) + " " + _responseCodeToString(code) + "\r\n";
+		canned.response += headers;
+		canned.response += String(F("Content-Length: ")) + String(body.length()) + "\r\n";
+		canned.response += F("Connection: close\r\n\r\n");
+		canned.response += body;
+
+		this->_canned.push_back(stl::move(canned));
+	}
+
+	bool HttpServer::_serveCanned(TcpClient &client)
+	{
+		if(this->_canned.size() == 0)
+			return false;
+
+		auto span = client.peekSpan();
+		StringView data(static_cast<const char *>(span.buffer()), span.size());
+
+		for(auto &canned : this->_canned) {
+			StringView request(canned.request);
+
+			if(!data.startsWith(request) || data.size() <= request.size())
+				continue;
+
+			auto next = data[request.size()];
+
+			if(next != ' ' && next != '?')
+				continue;
+
+			auto end = data.find("\r\n\r\n");
+
+			if(end == StringView::npos)
+				return false;
+
+			client.skip(end + 4);
+			client.write(canned.response.c_str(), canned.response.length());
+			return true;
+		}
+
+		return false;
+	}
+
 	void HttpServer::_addRequestHandler(RequestHandler *handler)
 	{
-		if(!_lastHandler) {
-			_firstHandler = handler;
-			_lastHandler = handler;
-		} else {
-			_lastHandler->next(handler);
-			_lastHandler = handler;
+		_handlers.push_back(*handler);
+	}
+
+	void HttpServer::setMaxConnections(size_t connections, int idle)
+	{
+		delete[] _connections;
+
+		_connections = connections > 0 ? new Connection[connections]() : nullptr;
+		_maxConnections = connections;
+		_idleTimeout = idle;
+		_keepAliveHeader = String(F("Keep-Alive: timeout=")) + String(idle / 1000) + "\r\n";
+	}
+
+	void HttpServer::setPipelining(bool enabled)
+	{
+		_pipelining = enabled;
+	}
+
+	void HttpServer::_acceptConnection()
+	{
+		for(size_t idx = 0; idx < _maxConnections; idx++) {
+			auto &connection = _connections[idx];
+
+			if(connection.client)
+				continue;
+
+			if(!this->_server->pending(SOCKET_POLL_NOWAIT))
+				return;
+
+			auto client = stl::move(this->_server->accept());
+
+			if(!client || !client->connected())
+				return;
+
+			client->setTimeout(HTTP_MAX_SEND_WAIT);
+			client->setOption(SOCKET_OPT_NODELAY, 1);
+
+			connection.client = stl::move(client);
+			connection.parser.reset();
+			connection.active = lwiot_tick_ms();
+			connection.requests = 0;
+		}
+	}
+
+	bool HttpServer::_serveConnection(Connection &connection)
+	{
+		bool keep = false;
+
+		_currentClient = stl::move(connection.client);
+		_response = &connection.writer;
+
+		for(int depth = 0; depth < CONFIG_HTTP_PIPELINE_DEPTH; depth++) {
+			if(!connection.parser.started() && this->_serveCanned(*_currentClient)) {
+				keep = false;
+				break;
+			}
+
+			/* A partial head is completed on a later pass, instead of waiting for it here. */
+			if(!_readRequestHead(*_currentClient, connection.parser, false)) {
+				keep = !connection.parser.failed();
+				break;
+			}
+
+			keep = _parseRequest(*_currentClient, connection.parser);
+
+			if(keep) {
+				connection.requests++;
+
+				if(connection.requests >= CONFIG_HTTP_KEEPALIVE_REQUESTS)
+					_keepAlive = false;
+
+				_contentLength = CONTENT_LENGTH_NOT_SET;
+				_handleRequest();
+				/* The connection may have been taken over by the handler. */
+				keep = _currentClient && _keepAlive && _currentClient->connected();
+				connection.active = lwiot_tick_ms();
+			}
+
+			connection.parser.reset();
+			_currentUpload.reset();
+			this->_releaseRequest();
+
+			/* Without pipelining, the other connections get their turn first. */
+			if(!keep || !_pipelining || _currentClient->available() == 0)
+				break;
 		}
+
+		connection.client = stl::move(_currentClient);
+		_response = &_writer;
+
+		return keep;
+	}
+
+	void HttpServer::_handleConnections()
+	{
+		bool busy = false;
+
+		this->_acceptConnection();
+
+		for(size_t idx = 0; idx < _maxConnections; idx++) {
+			auto &connection = _connections[idx];
+
+			if(!connection.client)
+				continue;
+
+			/* The idle time runs from the last response, so a slow partial request times out too. */
+			auto idle = lwiot_tick_ms() - connection.active > _idleTimeout;
+
+			if(!idle && connection.client->available() > 0) {
+				busy = true;
+
+				if(this->_serveConnection(connection) || !connection.client)
+					continue;
+			} else if(!idle && connection.client->alive()) {
+				continue;
+			}
+
+			connection.parser.reset();
+
+			connection.client->close();
+			connection.client.reset();
+		}
+
+		if(!busy)
+			lwiot_sleep(10);
 	}
 
 	void HttpServer::handleClient()
 	{
 		bool keep_client = false;
 
+		for(auto &endpoint : _endpoints)
+			endpoint.process();
+
+		if(_connections != nullptr) {
+			this->_handleConnections();
+			return;
+		}
+
 		if(_currentStatus == HC_NONE) {
 			this->_currentClient.reset();
 			this->_currentClient = stl::move(this->_server->accept());
@@ -161,6 +412,7 @@ namespace lwiot
 				return;
 
 			_currentClient->setTimeout(HTTP_MAX_SEND_WAIT);
+			_currentClient->setOption(SOCKET_OPT_NODELAY, 1);
 			_currentStatus = HC_WAIT_READ;
 			_statusChange = lwiot_tick_ms();
 		}
@@ -174,11 +426,16 @@ namespace lwiot
 
 			case HC_WAIT_READ:
 				if(this->_currentClient->available()) {
-					if(_parseRequest(*_currentClient)) {
+					_parser.reset();
+
+					/* Canned responses close the connection. */
+					if(this->_serveCanned(*_currentClient)) {
+						break;
+					} else if(_readRequestHead(*_currentClient, _parser, true) && _parseRequest(*_currentClient, _parser)) {
 						_contentLength = CONTENT_LENGTH_NOT_SET;
 						_handleRequest();
 
-						if(_currentClient->connected()) {
+						if(_currentClient && _currentClient->connected()) {
 							_currentStatus = HC_WAIT_CLOSE;
 							_statusChange = lwiot_tick_ms();
 							keep_client = true;
@@ -198,14 +455,25 @@ namespace lwiot
 		}
 
 		if(!keep_client) {
-			this->_currentClient->close();
+			if(this->_currentClient)
+				this->_currentClient->close();
+
 			_currentStatus = HC_NONE;
 			_currentUpload.reset();
+			this->_releaseRequest();
 		}
 	}
 
 	void HttpServer::close()
 	{
+		for(size_t idx = 0; idx < _maxConnections; idx++) {
+			if(_connections[idx].client) {
+				_connections[idx].client->close();
+				_connections[idx].client.reset();
+				_connections[idx].parser.reset();
+			}
+		}
+
 		_server->close();
 		_currentStatus = HC_NONE;
 		if(!_headerKeysCount)
@@ -214,6 +482,11 @@ namespace lwiot
 
 	bool HttpServer::hasClient() const
 	{
+		for(size_t idx = 0; idx < _maxConnections; idx++) {
+			if(_connections[idx].client)
+				return true;
+		}
+
 		if(!this->_currentClient)
 			return false;
 
@@ -225,18 +498,9 @@ namespace lwiot
 		close();
 	}
 
-	void HttpServer::sendHeader(const String &name, const String &value, bool first)
+	void HttpServer::sendHeader(StringView name, StringView value, bool first)
 	{
-		String headerLine = name;
-		headerLine += F(": ");
-		headerLine += value;
-		headerLine += "\r\n";
-
-		if(first) {
-			_responseHeaders = headerLine + _responseHeaders;
-		} else {
-			_responseHeaders += headerLine;
-		}
+		_response->header(name, value, first);
 	}
 
 	void HttpServer::setContentLength(size_t contentLength)
@@ -244,43 +508,59 @@ namespace lwiot
 		_contentLength = contentLength;
 	}
 
-	void HttpServer::_prepareHeader(String &response, int code, const char *content_type, size_t contentLength)
+	void HttpServer::_prepareHeader(int code, const char *content_type, size_t contentLength)
 	{
-		response = String(F("HTTP/1.")) + String(_currentVersion) + ' ';
-		response += String(code);
-		response += ' ';
-		response += _responseCodeToString(code);
-		response += "\r\n";
+		auto &response = *_response;
+
+		response.begin(_currentVersion, code);
 
 		using namespace mime;
 		if(!content_type)
 			content_type = mimeTable[html].mimeType;
 
-		sendHeader(String(F("Content-Type")), String(FPSTR(content_type)), true);
-		if(_contentLength == CONTENT_LENGTH_NOT_SET) {
-			sendHeader(String(FPSTR(Content_Length)), String(contentLength));
+		response.header(F("Content-Type"), FPSTR(content_type), true);
+
+		/* These responses end with the header, they have no length to announce. */
+		bool bodyless = code < 200 || code == 204 || code == 304;
+
+		if(bodyless) {
+			_contentLength = 0;
+		} else if(_contentLength == CONTENT_LENGTH_NOT_SET) {
+			response.header(FPSTR(Content_Length), contentLength);
 		} else if(_contentLength != CONTENT_LENGTH_UNKNOWN) {
-			sendHeader(String(FPSTR(Content_Length)), String(_contentLength));
+			response.header(FPSTR(Content_Length), _contentLength);
 		} else if(_contentLength == CONTENT_LENGTH_UNKNOWN && _currentVersion) { //HTTP/1.1 or above client
 			_chunked = true;
-			sendHeader(String(F("Accept-Ranges")), String(F("none")));
-			sendHeader(String(F("Transfer-Encoding")), String(F("chunked")));
+			response.append(http::TransferChunked);
 		}
-		sendHeader(String(F("Connection")), String(F("close")));
 
-		response += _responseHeaders;
-		response += "\r\n";
-		_responseHeaders = "";
+		/* Without a length or chunking, closing the connection is what ends the response. */
+		if(_contentLength == CONTENT_LENGTH_UNKNOWN && !_chunked)
+			_keepAlive = false;
+
+		if(_keepAlive) {
+			response.append(http::ConnectionKeepAlive);
+			response.append(_keepAliveHeader);
+		} else {
+			response.append(http::ConnectionClose);
+		}
 	}
 
 	void HttpServer::send(int code, const char *content_type, const String &content)
 	{
-		String header;
 		// Can we asume the following?
 		//if(code == 200 && content.length() == 0 && _contentLength == CONTENT_LENGTH_NOT_SET)
 		//  _contentLength = CONTENT_LENGTH_UNKNOWN;
-		_prepareHeader(header, code, content_type, content.length());
-		_currentClientWrite(header.c_str(), header.length());
+		_prepareHeader(code, content_type, content.length());
+
+		/* The head and the body go out in a single write. */
+		if(!_chunked) {
+			_response->send(*_currentClient, content.c_str(), content.length());
+			return;
+		}
+
+		_response->send(*_currentClient);
+
 		if(content.length())
 			sendContent(content);
 	}
@@ -295,32 +575,163 @@ namespace lwiot
 		send(code, content_type.c_str(), content);
 	}
 
+	/* Passes JSON output on as response content. */
+	class JsonContentPrinter : public json::BufferedPrinter {
+	public:
+		explicit JsonContentPrinter(HttpServer& server) : _server(server)
+		{
+		}
+
+		~JsonContentPrinter() override
+		{
+			this->flush();
+		}
+
+	protected:
+		bool emit(const uint8_t *data, size_t length) override
+		{
+			this->_server.sendContent(data, length);
+			return true;
+		}
+
+	private:
+		HttpServer& _server;
+	};
+
+	void HttpServer::sendJson(int code, const JsonVariant &json)
+	{
+		_prepareHeader(code, mime::mimeTable[mime::json].mimeType, json.measureLength());
+		_response->send(*_currentClient);
+
+		JsonContentPrinter printer(*this);
+		json.printTo(printer);
+	}
+
+	/* Render the size line of a chunk. */
+	static size_t chunk_size(char *output, size_t length)
+	{
+		auto num = NumberFormat::formatUnsigned(output, length, 16);
+
+		output[num++] = '\r';
+		output[num++] = '\n';
+		return num;
+	}
+
 	void HttpServer::sendContent(const String &content)
 	{
-		const char *footer = "\r\n";
-		size_t len = content.length();
+		sendContent(content.c_str(), content.length());
+	}
 
-		if(_chunked) {
-			auto *chunkSize = (char *) malloc(11);
-			if(chunkSize) {
-#ifdef HAVE_LWIP
-				sprintf(chunkSize, "%x%s", len, footer);
-#else
-				sprintf(chunkSize, "%lx%s", len, footer);
-#endif
-				_currentClientWrite(chunkSize, strlen(chunkSize));
-				free(chunkSize);
-			}
+	void HttpServer::sendContent(const void *data, size_t len)
+	{
+		char size[NumberFormat::BufferSize + 2];
+		BufferChain chain;
+
+		if(_stream.active()) {
+			writeChunk(data, len);
+			return;
 		}
-		_currentClientWrite(content.c_str(), len);
-		if(_chunked) {
-			_currentClient->write(footer, 2);
-			if(len == 0) {
-				_chunked = false;
-			}
+
+		if(!_chunked) {
+			_currentClientWrite(static_cast<const char *>(data), len);
+			return;
 		}
+
+		chain.append(size, chunk_size(size, len));
+
+		if(len > 0)
+			chain.append(data, len);
+
+		chain.append("\r\n", 2);
+		_currentClient->write(chain);
+
+		if(len == 0)
+			_chunked = false;
+	}
+
+	bool HttpServer::beginChunked(int code, const char *contentType, HttpContentCoding coding)
+	{
+		auto name = HttpChunkedWriter::name(coding);
+
+		if(coding != HttpContentCoding::Identity && (!HttpChunkedWriter::supports(coding) || !acceptsEncoding(name)))
+			coding = HttpContentCoding::Identity;
+
+		if(coding != HttpContentCoding::Identity)
+			sendHeader(F("Content-Encoding"), name);
+
+		_contentLength = CONTENT_LENGTH_UNKNOWN;
+		_prepareHeader(code, contentType, 0);
+
+		if(_response->send(*_currentClient) < 0) {
+			_chunked = false;
+			_keepAlive = false;
+			return false;
+		}
+
+		return _stream.begin(*_currentClient, _chunked, coding);
 	}
 
+	UniquePointer<TcpClient> HttpServer::takeOver(int code, const char *contentType)
+	{
+		auto &response = *_response;
+
+		response.begin(_currentVersion, code);
+
+		if(contentType != nullptr)
+			response.header(F("Content-Type"), FPSTR(contentType), true);
+
+		_keepAlive = false;
+
+		if(response.send(*_currentClient) < 0)
+			return UniquePointer<TcpClient>();
+
+		return stl::move(_currentClient);
+	}
+
+	ssize_t HttpServer::writeChunk(const void *data, size_t length)
+	{
+		auto rv = _stream.write(data, length);
+
+		if(rv < 0)
+			_keepAlive = false;
+
+		return rv;
+	}
+
+	ssize_t HttpServer::writeChunk(StringView data)
+	{
+		return writeChunk(data.data(), data.length());
+	}
+
+	bool HttpServer::endChunked()
+	{
+		auto rv = _stream.end();
+
+		_chunked = false;
+
+		if(!rv)
+			_keepAlive = false;
+
+		return rv;
+	}
+
+#ifdef HAVE_UNISTD_H
+	size_t HttpServer::sendContent(File &file, size_t offset, size_t length)
+	{
+		char size[NumberFormat::BufferSize + 2];
+
+		if(_chunked)
+			_currentClientWrite(size, chunk_size(size, length));
+
+		auto rv = _currentClient->sendFile(file, offset, length);
+
+		if(_chunked)
+			_currentClient->write("\r\n", 2);
+
+		return rv > 0 ? static_cast<size_t>(rv) : 0;
+	}
+#endif
+
 	void HttpServer::_streamFileCore( size_t fileSize, const String &fileName, const String &contentType)
 	{
 		using namespace mime;
@@ -334,26 +745,56 @@ namespace lwiot
 	}
 
 
-	String HttpServer::arg(const String& name)
+	String HttpServer::pathArg(int i)
+	{
+		if(i >= 0 && static_cast<size_t>(i) < _pathArgs.count)
+			return _pathArgs.values[i].toString();
+		return "";
+	}
+
+	String HttpServer::pathArg(StringView name)
+	{
+		if(_pathArgs.names == nullptr)
+			return "";
+
+		for(size_t i = 0; i < _pathArgs.count && i < _pathArgs.names->size(); ++i) {
+			if(StringView((*_pathArgs.names)[i]).equals(name))
+				return _pathArgs.values[i].toString();
+		}
+		return "";
+	}
+
+	int HttpServer::pathArgs()
+	{
+		return static_cast<int>(_pathArgs.count);
+	}
+
+	String HttpServer::arg(StringView name)
 	{
 		for(int i = 0; i < _currentArgCount; ++i) {
-			if(_currentArgs[i].key == name)
+			if(_argumentIs(_currentArgs[i], name)) {
+				_decodeArgument(_currentArgs[i]);
 				return _currentArgs[i].value;
+			}
 		}
 		return "";
 	}
 
 	String HttpServer::arg(int i)
 	{
-		if(i < _currentArgCount)
+		if(i < _currentArgCount) {
+			_decodeArgument(_currentArgs[i]);
 			return _currentArgs[i].value;
+		}
 		return "";
 	}
 
 	String HttpServer::argName(int i)
 	{
-		if(i < _currentArgCount)
+		if(i < _currentArgCount) {
+			_decodeArgument(_currentArgs[i]);
 			return _currentArgs[i].key;
+		}
 		return "";
 	}
 
@@ -362,35 +803,80 @@ namespace lwiot
 		return _currentArgCount;
 	}
 
-	bool HttpServer::hasArg(const String& name)
+	bool HttpServer::hasArg(StringView name)
 	{
 		for(int i = 0; i < _currentArgCount; ++i) {
-			if(_currentArgs[i].key == name)
+			if(_argumentIs(_currentArgs[i], name))
 				return true;
 		}
 		return false;
 	}
 
 
-	String HttpServer::header(const String& name)
+	String HttpServer::header(StringView name)
 	{
-		for(int i = 0; i < _headerKeysCount; ++i) {
-			if(_currentHeaders[i].key.equalsIgnoreCase(name))
-				return _currentHeaders[i].value;
-		}
-		return "";
+		auto idx = _findHeader(name);
+
+		if(idx < 0)
+			return "";
+
+		return _currentHeaders[idx].value;
 	}
 
+	/*
+	 * The keys are indexed by an open-addressed table of one-based indices, at most half full, so
+	 * that a lookup while the request is parsed takes a single probe most of the time.
+	 */
 	void HttpServer::collectHeaders(const char *headerKeys[],  size_t headerKeysCount)
 	{
 		_headerKeysCount = headerKeysCount + 1;
 
 		delete[]_currentHeaders;
+		delete[]_headerSlots;
+
 		_currentHeaders = new RequestArgument[_headerKeysCount];
 		_currentHeaders[0].key = FPSTR(AUTHORIZATION_HEADER);
 		for(int i = 1; i < _headerKeysCount; i++) {
 			_currentHeaders[i].key = headerKeys[i - 1];
 		}
+
+		size_t slots = 4;
+
+		while(slots < static_cast<size_t>(_headerKeysCount) * 2)
+			slots <<= 1;
+
+		_headerMask = slots - 1;
+		_headerSlots = new uint8_t[slots];
+		memset(_headerSlots, 0, slots);
+
+		for(int i = 0; i < _headerKeysCount && i < UINT8_MAX; i++) {
+			StringView key(_currentHeaders[i].key);
+
+			if(_findHeader(key) >= 0)
+				continue;
+
+			auto slot = http::hash(key) & _headerMask;
+
+			while(_headerSlots[slot] != 0)
+				slot = (slot + 1) & _headerMask;
+
+			_headerSlots[slot] = static_cast<uint8_t>(i + 1);
+		}
+	}
+
+	int HttpServer::_findHeader(StringView name) const
+	{
+		if(_headerSlots == nullptr)
+			return -1;
+
+		for(auto slot = http::hash(name) & _headerMask; _headerSlots[slot] != 0; slot = (slot + 1) & _headerMask) {
+			auto idx = _headerSlots[slot] - 1;
+
+			if(name.equalsIgnoreCase(_currentHeaders[idx].key))
+				return idx;
+		}
+
+		return -1;
 	}
 
 	String HttpServer::header(int i)
@@ -412,12 +898,64 @@ namespace lwiot
 		return _headerKeysCount;
 	}
 
-	bool HttpServer::hasHeader(const String& name)
+	bool HttpServer::hasHeader(StringView name)
 	{
-		for(int i = 0; i < _headerKeysCount; ++i) {
-			if((_currentHeaders[i].key.equalsIgnoreCase(name)) && (_currentHeaders[i].value.length() > 0))
+		auto idx = _findHeader(name);
+
+		return idx >= 0 && _currentHeaders[idx].value.length() > 0;
+	}
+
+	StringView HttpServer::requestHeader(StringView name) const
+	{
+		if(_currentParser == nullptr)
+			return StringView();
+
+		return _currentParser->header(name);
+	}
+
+	StringView HttpServer::requestHeader(http::Header id) const
+	{
+		if(_currentParser == nullptr)
+			return StringView();
+
+		return _currentParser->header(id);
+	}
+
+	bool HttpServer::acceptsEncoding(StringView coding) const
+	{
+		auto value = requestHeader(http::Header::AcceptEncoding);
+		size_t pos = 0;
+
+		while(pos < value.length()) {
+			auto end = value.find(',', pos);
+
+			if(end == StringView::npos)
+				end = value.length();
+
+			auto entry = value.substr(pos, end - pos).trim();
+			auto params = entry.find(';');
+			pos = end + 1;
+
+			if(!entry.substr(0, params).trim().equalsIgnoreCase(coding))
+				continue;
+
+			if(params == StringView::npos)
+				return true;
+
+			/* A quality of zero explicitly refuses the coding. */
+			auto q = entry.substr(params + 1).trim();
+
+			if(!q.startsWith("q="))
 				return true;
+
+			for(auto c : q.substr(2)) {
+				if(c != '0' && c != '.')
+					return true;
+			}
+
+			return false;
 		}
+
 		return false;
 	}
 
@@ -459,102 +997,22 @@ namespace lwiot
 			_finalizeResponse();
 		}
 		_currentUri = "";
+		_pathArgs.count = 0;
 	}
 
 
 	void HttpServer::_finalizeResponse()
 	{
-		if(_chunked) {
+		if(_stream.active()) {
+			endChunked();
+		} else if(_chunked) {
 			sendContent("");
 		}
 	}
 
 	String HttpServer::_responseCodeToString(int code)
 	{
-		switch(code) {
-		case 100:
-			return F("Continue");
-		case 101:
-			return F("Switching Protocols");
-		case 200:
-			return F("OK");
-		case 201:
-			return F("Created");
-		case 202:
-			return F("Accepted");
-		case 203:
-			return F("Non-Authoritative Information");
-		case 204:
-			return F("No Content");
-		case 205:
-			return F("Reset Content");
-		case 206:
-			return F("Partial Content");
-		case 300:
-			return F("Multiple Choices");
-		case 301:
-			return F("Moved Permanently");
-		case 302:
-			return F("Found");
-		case 303:
-			return F("See Other");
-		case 304:
-			return F("Not Modified");
-		case 305:
-			return F("Use Proxy");
-		case 307:
-			return F("Temporary Redirect");
-		case 400:
-			return F("Bad Request");
-		case 401:
-			return F("Unauthorized");
-		case 402:
-			return F("Payment Required");
-		case 403:
-			return F("Forbidden");
-		case 404:
-			return F("Not Found");
-		case 405:
-			return F("Method Not Allowed");
-		case 406:
-			return F("Not Acceptable");
-		case 407:
-			return F("Proxy Authentication Required");
-		case 408:
-			return F("Request Time-out");
-		case 409:
-			return F("Conflict");
-		case 410:
-			return F("Gone");
-		case 411:
-			return F("Length Required");
-		case 412:
-			return F("Precondition Failed");
-		case 413:
-			return F("Request Entity Too Large");
-		case 414:
-			return F("Request-URI Too Large");
-		case 415:
-			return F("Unsupported Media Type");
-		case 416:
-			return F("Requested range not satisfiable");
-		case 417:
-			return F("Expectation Failed");
-		case 500:
-			return F("Internal Server Error");
-		case 501:
-			return F("Not Implemented");
-		case 502:
-			return F("Bad Gateway");
-		case 503:
-			return F("Service Unavailable");
-		case 504:
-			return F("Gateway Time-out");
-		case 505:
-			return F("HTTP Version not supported");
-		default:
-			return F("");
-		}
+		return HttpResponseWriter::reason(code).toString();
 	}
 
 	static char *readBytesWithTimeout(TcpClient &client, size_t maxLength, size_t &dataLength, int timeout_ms)
@@ -569,6 +1027,9 @@ namespace lwiot
 			if(!newLength) {
 				break;
 			}
+			/* Leave a pipelined request that follows the body in the stream. */
+			if(newLength > maxLength - dataLength)
+				newLength = maxLength - dataLength;
 			if(!buf) {
 				buf = (char *) malloc(newLength + 1);
 				if(!buf) {
@@ -589,39 +1050,78 @@ namespace lwiot
 		return buf;
 	}
 
-	bool HttpServer::_parseRequest(TcpClient &client)
+	void HttpServer::_releaseRequest()
+	{
+		_currentArgs = nullptr;
+		_currentArgCount = 0;
+		_currentParser = nullptr;
+		_response->clear();
+		_arena.reset();
+	}
+
+	bool HttpServer::_readRequestHead(TcpClient &client, HttpRequestParser &parser, bool wait)
+	{
+		while(!parser.done() && !parser.failed()) {
+			if(!wait && client.available() == 0)
+				return false;
+
+			auto span = client.peekSpan();
+
+			if(span.size() > 0) {
+				client.skip(parser.feed(span.buffer(), span.size()));
+				continue;
+			}
+
+			/* Clients without a read-ahead buffer are read one byte at a time. */
+			uint8_t byte;
+
+			if(client.available() == 0 || client.read(&byte, sizeof(byte)) != sizeof(byte))
+				return false;
+
+			parser.feed(&byte, sizeof(byte));
+		}
+
+		return parser.done();
+	}
+
+	static size_t parse_length(StringView value)
+	{
+		size_t length = 0;
+
+		for(auto c : value) {
+			if(c < '0' || c > '9')
+				break;
+
+			length = length * 10 + (c - '0');
+		}
+
+		return length;
+	}
+
+	bool HttpServer::_parseRequest(TcpClient &client, HttpRequestParser &parser)
 	{
-		// Read the first line of HTTP request
-		String req = client.readStringUntil('\r');
-		client.readStringUntil('\n');
+		this->_releaseRequest();
+
 		//reset header value
 		for(int i = 0; i < _headerKeysCount; ++i) {
 			_currentHeaders[i].value = String();
 		}
 
-		// First line of HTTP request looks like "GET /path HTTP/1.1"
-		// Retrieve the "/path" part by finding the spaces
-		int addr_start = req.indexOf(' ');
-		int addr_end = req.indexOf(' ', addr_start + 1);
-		if(addr_start == -1 || addr_end == -1) {
+		if(!parser.done()) {
 #ifdef DEBUG_ESP_HTTP_SERVER
-			DEBUG_OUTPUT.print("Invalid request: ");
-	DEBUG_OUTPUT.println(req);
+			print_dbg("Invalid request!\n");
 #endif
 			return false;
 		}
 
-		String methodStr = req.substring(0, addr_start);
-		String url = req.substring(addr_start + 1, addr_end);
-		String versionEnd = req.substring(addr_end + 8);
-		_currentVersion = atoi(versionEnd.c_str());
-		String searchStr = "";
-		int hasSearch = url.indexOf('?');
-		if(hasSearch != -1) {
-			searchStr = url.substring(hasSearch + 1);
-			url = url.substring(0, hasSearch);
-		}
-		_currentUri = url;
+		auto methodStr = parser.method();
+		auto searchStr = parser.query();
+
+		_currentParser = &parser;
+
+		_currentVersion = parser.version();
+		_keepAlive = _connections != nullptr && _currentVersion > 0;
+		_currentUri = parser.path().toString();
 		_chunked = false;
 
 		HTTPMethod method = HTTP_GET;
@@ -638,73 +1138,62 @@ namespace lwiot
 		}
 		_currentMethod = method;
 
-#ifdef DEBUG_ESP_HTTP_SERVER
-		DEBUG_OUTPUT.print("method: ");
-  DEBUG_OUTPUT.print(methodStr);
-  DEBUG_OUTPUT.print(" url: ");
-  DEBUG_OUTPUT.print(url);
-  DEBUG_OUTPUT.print(" search: ");
-  DEBUG_OUTPUT.println(searchStr);
-#endif
-
 		//attach handler
-		RequestHandler *handler;
-		for(handler = _firstHandler; handler; handler = handler->next()) {
-			if(handler->canHandle(_currentMethod, _currentUri))
-				break;
-		}
-		_currentHandler = handler;
+		_currentHandler = _router.match(_currentMethod, _currentUri, _pathArgs);
 
-		String formData;
-		// below is needed only when POST type request
-		if(method == HTTP_POST || method == HTTP_PUT || method == HTTP_PATCH || method == HTTP_DELETE) {
-			String boundaryStr;
-			String headerName;
-			String headerValue;
-			bool isForm = false;
-			bool isEncoded = false;
-			uint32_t contentLength = 0;
-			//parse headers
-			while(true) {
-				req = client.readStringUntil('\r');
-				client.readStringUntil('\n');
-				if(req == "")
-					break;//no moar headers
-				int headerDiv = req.indexOf(':');
-				if(headerDiv == -1) {
+		if(!_currentHandler) {
+			for(auto &handler : _handlers) {
+				if(handler.canHandle(_currentMethod, _currentUri)) {
+					_currentHandler = &handler;
 					break;
 				}
-				headerName = req.substring(0, headerDiv);
-				headerValue = req.substring(headerDiv + 1);
-				headerValue.trim();
-				_collectHeader(headerName.c_str(), headerValue.c_str());
-
-#ifdef DEBUG_ESP_HTTP_SERVER
-				DEBUG_OUTPUT.print("headerName: ");
-	  DEBUG_OUTPUT.println(headerName);
-	  DEBUG_OUTPUT.print("headerValue: ");
-	  DEBUG_OUTPUT.println(headerValue);
-#endif
+			}
+		}
 
-				if(headerName.equalsIgnoreCase(FPSTR(Content_Type))) {
-					using namespace mime;
-					if(headerValue.startsWith(FPSTR(mimeTable[txt].mimeType))) {
-						isForm = false;
-					} else if(headerValue.startsWith(F("application/x-www-form-urlencoded"))) {
-						isForm = false;
-						isEncoded = true;
-					} else if(headerValue.startsWith(F("multipart/"))) {
-						boundaryStr = headerValue.substring(headerValue.indexOf('=') + 1);
-						boundaryStr.replace("\"", "");
-						isForm = true;
-					}
-				} else if(headerName.equalsIgnoreCase(F("Content-Length"))) {
-					contentLength = headerValue.toInt();
-				} else if(headerName.equalsIgnoreCase(F("Host"))) {
-					_hostHeader = headerValue;
+		String boundaryStr;
+		bool isForm = false;
+		bool isEncoded = false;
+		size_t contentLength = 0;
+
+		for(size_t idx = 0; idx < parser.headers(); idx++) {
+			auto headerName = parser.headerName(idx);
+			auto headerValue = parser.headerValue(idx);
+
+			_collectHeader(headerName, headerValue);
+
+			switch(parser.headerId(idx)) {
+			case http::Header::ContentType:
+				if(headerValue.startsWith(FPSTR(mime::mimeTable[mime::txt].mimeType))) {
+					isForm = false;
+				} else if(headerValue.startsWith(F("application/x-www-form-urlencoded"))) {
+					isForm = false;
+					isEncoded = true;
+				} else if(headerValue.startsWith(F("multipart/"))) {
+					boundaryStr = headerValue.substr(headerValue.find('=') + 1).toString();
+					boundaryStr.replace("\"", "");
+					isForm = true;
 				}
+				break;
+
+			case http::Header::ContentLength:
+				contentLength = parse_length(headerValue);
+				break;
+
+			case http::Header::Host:
+				_hostHeader = headerValue.toString();
+				break;
+
+			case http::Header::Connection:
+				_parseConnectionHeader(headerValue);
+				break;
+
+			default:
+				break;
 			}
+		}
 
+		// below is needed only when POST type request
+		if(method == HTTP_POST || method == HTTP_PUT || method == HTTP_PATCH || method == HTTP_DELETE) {
 			if(!isForm) {
 				size_t plainLength;
 				char *plainBuf = readBytesWithTimeout(client, contentLength, plainLength, HTTP_MAX_POST_WAIT);
@@ -714,12 +1203,22 @@ namespace lwiot
 				}
 				if(contentLength > 0) {
 					if(isEncoded) {
-						//url encoded form
-						if(searchStr != "")
-							searchStr += '&';
-						searchStr += plainBuf;
+						//url encoded form, its arguments follow those in the URL
+						auto data = static_cast<char *>(_arena.allocate(searchStr.length() + 1 + plainLength, 1));
+						size_t offset = 0;
+
+						if(!searchStr.empty()) {
+							memcpy(data, searchStr.data(), searchStr.length());
+							offset = searchStr.length();
+							data[offset++] = '&';
+						}
+
+						memcpy(data + offset, plainBuf, plainLength);
+						_parseArguments(StringView(data, offset + plainLength));
+					} else {
+						_parseArguments(searchStr);
 					}
-					_parseArguments(searchStr);
+
 					if(!isEncoded) {
 						//plain post json or other data
 						RequestArgument &arg = _currentArgs[_currentArgCount++];
@@ -745,328 +1244,274 @@ namespace lwiot
 				}
 			}
 		} else {
-			String headerName;
-			String headerValue;
-
-			while(true) {
-				req = client.readStringUntil('\r');
-				client.readStringUntil('\n');
-				if(req == "")
-					break;
-				int headerDiv = req.indexOf(':');
-				if(headerDiv == -1) {
-					break;
-				}
-				headerName = req.substring(0, headerDiv);
-				headerValue = req.substring(headerDiv + 2);
-				_collectHeader(headerName.c_str(), headerValue.c_str());
-
-				if(headerName.equalsIgnoreCase("Host")) {
-					_hostHeader = headerValue;
-				}
-			}
-
 			_parseArguments(searchStr);
 		}
 
 		return true;
 	}
 
-	bool HttpServer::_collectHeader(const char *headerName, const char *headerValue)
+	void HttpServer::_parseConnectionHeader(StringView value)
 	{
-		for(int i = 0; i < _headerKeysCount; i++) {
-			if(_currentHeaders[i].key.equalsIgnoreCase(headerName)) {
-				_currentHeaders[i].value = headerValue;
-				return true;
+		size_t pos = 0;
+
+		while(pos <= value.length()) {
+			auto end = value.find(',', pos);
+
+			if(end == StringView::npos)
+				end = value.length();
+
+			auto option = value.substr(pos, end - pos).trim();
+			pos = end + 1;
+
+			if(option.equalsIgnoreCase("close")) {
+				_keepAlive = false;
+				return;
 			}
+
+			if(option.equalsIgnoreCase("keep-alive"))
+				_keepAlive = _connections != nullptr;
 		}
-		return false;
 	}
 
-	void HttpServer::_parseArguments(const String& data)
+	bool HttpServer::_collectHeader(StringView headerName, StringView headerValue)
 	{
+		auto idx = _findHeader(headerName);
 
-		delete[] _currentArgs;
+		if(idx < 0)
+			return false;
 
-		_currentArgs = nullptr;
+		_currentHeaders[idx].value = headerValue.toString();
+		return true;
+	}
 
-		if(data.length() == 0) {
-			_currentArgCount = 0;
-			_currentArgs = new RequestArgument[1];
-			return;
-		}
-		_currentArgCount = 1;
+	/*
+	 * The arguments point into data, which has to live until the request is released. They are
+	 * decoded when they are accessed.
+	 */
+	void HttpServer::_parseArguments(StringView data)
+	{
+		size_t count = 1;
 
-		for(int i = 0; i < (int) data.length();) {
-			i = data.indexOf('&', i);
-			if(i == -1)
-				break;
-			++i;
-			++_currentArgCount;
+		for(auto c : data) {
+			if(c == '&')
+				count++;
 		}
 
-		_currentArgs = new RequestArgument[_currentArgCount + 1];
-		int pos = 0;
-		int iarg;
+		/* One extra slot for the plain body argument. */
+		_currentArgs = _arena.create<RequestArgument>(count + 1);
+		_currentArgCount = 0;
 
-		for(iarg = 0; iarg < _currentArgCount;) {
-			int equal_sign_index = data.indexOf('=', pos);
-			int next_arg_index = data.indexOf('&', pos);
+		size_t pos = 0;
 
-			if((equal_sign_index == -1) || ((equal_sign_index > next_arg_index) && (next_arg_index != -1))) {
-				if(next_arg_index == -1)
-					break;
-				pos = next_arg_index + 1;
-				continue;
-			}
+		while(pos < data.length()) {
+			auto next = data.find('&', pos);
 
-			RequestArgument &arg = _currentArgs[iarg];
-			arg.key = urlDecode(data.substring(pos, equal_sign_index));
-			arg.value = urlDecode(data.substring(equal_sign_index + 1, next_arg_index));
-			++iarg;
+			if(next == StringView::npos)
+				next = data.length();
 
-			if(next_arg_index == -1)
-				break;
+			auto pair = data.substr(pos, next - pos);
+			auto equals = pair.find('=');
+			pos = next + 1;
+
+			if(equals == StringView::npos)
+				continue;
 
-			pos = next_arg_index + 1;
+			RequestArgument &arg = _currentArgs[_currentArgCount++];
+			arg.encodedKey = pair.substr(0, equals);
+			arg.encodedValue = pair.substr(equals + 1);
+			arg.encoded = true;
 		}
-		_currentArgCount = iarg;
 	}
 
-	void HttpServer::_uploadWriteByte(uint8_t b)
+	void HttpServer::_decodeArgument(RequestArgument &arg)
 	{
-		if(_currentUpload->currentSize == HTTP_UPLOAD_BUFLEN) {
-			if(_currentHandler && _currentHandler->canUpload(_currentUri))
-				_currentHandler->upload(*this, _currentUri, *_currentUpload);
-			_currentUpload->totalSize += _currentUpload->currentSize;
-			_currentUpload->currentSize = 0;
-		}
-		_currentUpload->buf[_currentUpload->currentSize++] = b;
+		if(!arg.encoded)
+			return;
+
+		arg.key = HttpRequestParser::decode(arg.encodedKey);
+		arg.value = HttpRequestParser::decode(arg.encodedValue);
+		arg.encoded = false;
+	}
+
+	bool HttpServer::_argumentIs(const RequestArgument &arg, StringView name)
+	{
+		if(arg.encoded)
+			return HttpRequestParser::decodedEquals(arg.encodedKey, name);
+
+		return arg.key == name;
+	}
+
+	void HttpServer::_uploadCallback()
+	{
+		if(_currentHandler && _currentHandler->canUpload(_currentUri))
+			_currentHandler->upload(*this, _currentUri, *_currentUpload);
+	}
+
+	void HttpServer::_uploadFlush()
+	{
+		_uploadCallback();
+		_currentUpload->totalSize += _currentUpload->currentSize;
+		_currentUpload->currentSize = 0;
 	}
 
-	uint8_t HttpServer::_uploadReadByte(TcpClient &client)
+	bool HttpServer::_uploadWrite(const uint8_t *data, size_t length)
 	{
-		int res = client.read();
-		if(res == -1) {
-			while(!client.available() && client.connected())
-				Thread::yield();
-			res = client.read();
+		auto &upload = *_currentUpload;
+
+		if(upload.sink != nullptr) {
+			upload.totalSize += length;
+			return upload.sink->write(data, length);
 		}
-		return (uint8_t) res;
+
+		while(length > 0) {
+			if(upload.currentSize == HTTP_UPLOAD_BUFLEN)
+				_uploadFlush();
+
+			auto num = HTTP_UPLOAD_BUFLEN - upload.currentSize;
+
+			if(num > length)
+				num = length;
+
+			memcpy(upload.buf + upload.currentSize, data, num);
+			upload.currentSize += num;
+			data += num;
+			length -= num;
+		}
+
+		return true;
 	}
 
 	bool HttpServer::_parseForm(TcpClient &client, const String& boundary, uint32_t len)
 	{
-		(void) len;
-		String line;
-		int retry = 0;
-		do {
-			line = client.readStringUntil('\r');
-			++retry;
-		} while(line.length() == 0 && retry < 3);
-
-		client.readStringUntil('\n');
-		//start reading the form
-		if(line == ("--" + boundary)) {
-			auto *postArgs = new RequestArgument[32];
-			int postArgsLen = 0;
-			while(true) {
-				String argName;
-				String argValue;
-				String argType;
-				String argFilename;
-				bool argIsFile = false;
-
-				line = client.readStringUntil('\r');
-				client.readStringUntil('\n');
-				if(line.length() > 19 && line.substring(0, 19).equalsIgnoreCase(F("Content-Disposition"))) {
-					int nameStart = line.indexOf('=');
-					if(nameStart != -1) {
-						argName = line.substring(nameStart + 2);
-						nameStart = argName.indexOf('=');
-						if(nameStart == -1) {
-							argName = argName.substring(0, argName.length() - 1);
-						} else {
-							argFilename = argName.substring(nameStart + 2, argName.length() - 1);
-							argName = argName.substring(0, argName.indexOf('"'));
-							argIsFile = true;
-
-							//use GET to set the filename if uploading using blob
-							if(argFilename == F("blob") && hasArg(FPSTR(filename)))
-								argFilename = arg(FPSTR(filename));
-						}
+		HttpMultipartParser parser(boundary);
+		struct {
+			RequestArgument *args;
+			int count;
+			RequestArgument *field;
+			bool uploading;
+		} form = { _arena.create<RequestArgument>(32), 0, nullptr, false };
+
+		if(form.args == nullptr || parser.failed())
+			return false;
 
-						using namespace mime;
-						argType = FPSTR(mimeTable[txt].mimeType);
-						line = client.readStringUntil('\r');
-						client.readStringUntil('\n');
-						if(line.length() > 12 && line.substring(0, 12).equalsIgnoreCase(FPSTR(Content_Type))) {
-							argType = line.substring(line.indexOf(':') + 2);
-							//skip next line
-							client.readStringUntil('\r');
-							client.readStringUntil('\n');
-						}
+		parser.onBegin([this, &form](const HttpMultipartPart &part) {
+			form.field = nullptr;
 
-						if(!argIsFile) {
-							while(true) {
-								line = client.readStringUntil('\r');
-								client.readStringUntil('\n');
-								if(line.startsWith("--" + boundary))
-									break;
-								if(argValue.length() > 0)
-									argValue += "\n";
-								argValue += line;
-							}
-
-							RequestArgument &arg = postArgs[postArgsLen++];
-							arg.key = argName;
-							arg.value = argValue;
-
-							if(line == ("--" + boundary + "--")) {
-								break;
-							}
-						} else {
-							_currentUpload.reset(new HTTPUpload());
-							_currentUpload->status = UPLOAD_FILE_START;
-							_currentUpload->name = argName;
-							_currentUpload->filename = argFilename;
-							_currentUpload->type = argType;
-							_currentUpload->totalSize = 0;
-							_currentUpload->currentSize = 0;
-
-							if(_currentHandler && _currentHandler->canUpload(_currentUri))
-								_currentHandler->upload(*this, _currentUri, *_currentUpload);
-							_currentUpload->status = UPLOAD_FILE_WRITE;
-							uint8_t argByte = _uploadReadByte(client);
-readfile:
-							while(argByte != 0x0D) {
-								if(!client.connected())
-									return _parseFormUploadAborted();
-								_uploadWriteByte(argByte);
-								argByte = _uploadReadByte(client);
-							}
-
-							argByte = _uploadReadByte(client);
-							if(!client.connected())
-								return _parseFormUploadAborted();
-							if(argByte == 0x0A) {
-								argByte = _uploadReadByte(client);
-								if(!client.connected())
-									return _parseFormUploadAborted();
-								if((char) argByte != '-') {
-									//continue reading the file
-									_uploadWriteByte(0x0D);
-									_uploadWriteByte(0x0A);
-									goto readfile;
-								} else {
-									argByte = _uploadReadByte(client);
-									if(!client.connected())
-										return _parseFormUploadAborted();
-									if((char) argByte != '-') {
-										//continue reading the file
-										_uploadWriteByte(0x0D);
-										_uploadWriteByte(0x0A);
-										_uploadWriteByte((uint8_t) ('-'));
-										goto readfile;
-									}
-								}
-
-
-								ByteBuffer endBuf(boundary.length());
-
-								client.read(endBuf.data(), boundary.length());
-								endBuf.setIndex(boundary.length());
-
-								if(strstr((const char *) endBuf.data(), boundary.c_str()) != nullptr) {
-									if(_currentHandler && _currentHandler->canUpload(_currentUri))
-										_currentHandler->upload(*this, _currentUri, *_currentUpload);
-									_currentUpload->totalSize += _currentUpload->currentSize;
-									_currentUpload->status = UPLOAD_FILE_END;
-									if(_currentHandler && _currentHandler->canUpload(_currentUri))
-										_currentHandler->upload(*this, _currentUri, *_currentUpload);
-
-									line = client.readStringUntil(0x0D);
-									client.readStringUntil(0x0A);
-									if(line == "--") {
-										break;
-									}
-
-									continue;
-								} else {
-									_uploadWriteByte(0x0D);
-									_uploadWriteByte(0x0A);
-									_uploadWriteByte((uint8_t) ('-'));
-									_uploadWriteByte((uint8_t) ('-'));
-									uint32_t i = 0;
-									while(i < boundary.length()) {
-										_uploadWriteByte(endBuf[i++]);
-									}
-									argByte = _uploadReadByte(client);
-									goto readfile;
-								}
-							} else {
-								_uploadWriteByte(0x0D);
-								goto readfile;
-							}
-						}
-					}
+			if(!part.file) {
+				if(form.count < 32) {
+					form.field = &form.args[form.count++];
+					form.field->key = part.name.toString();
 				}
-			}
 
-			int iarg;
-			int totalArgs = ((32 - postArgsLen) < _currentArgCount) ? (32 - postArgsLen) : _currentArgCount;
-			for(iarg = 0; iarg < totalArgs; iarg++) {
-				RequestArgument &arg = postArgs[postArgsLen++];
-				arg.key = _currentArgs[iarg].key;
-				arg.value = _currentArgs[iarg].value;
+				return true;
 			}
 
-			delete[] _currentArgs;
-			_currentArgs = new RequestArgument[postArgsLen];
-			for(iarg = 0; iarg < postArgsLen; iarg++) {
-				RequestArgument &arg = _currentArgs[iarg];
-				arg.key = postArgs[iarg].key;
-				arg.value = postArgs[iarg].value;
-			}
-			_currentArgCount = iarg;
-			delete[] postArgs;
+			using namespace mime;
+			_currentUpload.reset(new HTTPUpload());
+			_currentUpload->status = UPLOAD_FILE_START;
+			_currentUpload->name = part.name.toString();
+			_currentUpload->filename = part.filename.toString();
+			_currentUpload->type = part.type.empty() ? String(FPSTR(mimeTable[txt].mimeType)) : part.type.toString();
+			_currentUpload->totalSize = 0;
+			_currentUpload->currentSize = 0;
+			_currentUpload->sink = nullptr;
+
+			//use GET to set the filename if uploading using blob
+			if(_currentUpload->filename == F("blob") && hasArg(FPSTR(filename)))
+				_currentUpload->filename = arg(FPSTR(filename));
+
+			form.uploading = true;
+			_uploadCallback();
+			_currentUpload->status = UPLOAD_FILE_WRITE;
+			return true;
+		});
+
+		parser.onData([this, &form](const uint8_t *data, size_t length) {
+			if(form.field != nullptr)
+				form.field->value.append(StringView(reinterpret_cast<const char *>(data), length));
+			else if(form.uploading)
+				return _uploadWrite(data, length);
+
+			return true;
+		});
+
+		parser.onEnd([this, &form]() {
+			if(!form.uploading)
+				return true;
+
+			form.uploading = false;
+
+			if(_currentUpload->sink == nullptr)
+				_uploadFlush();
+			else if(!_currentUpload->sink->finish())
+				return _parseFormUploadAborted();
+
+			_currentUpload->status = UPLOAD_FILE_END;
+			_uploadCallback();
 			return true;
+		});
+
+		/* Without a content length the body ends at the final delimiter. */
+		size_t remaining = len;
+
+		while(!parser.failed() && (len > 0 ? remaining > 0 : !parser.done())) {
+			size_t room;
+			auto buffer = parser.buffer(room);
+			auto start = lwiot_tick_ms();
+
+			if(len > 0 && room > remaining)
+				room = remaining;
+
+			while(client.available() == 0 && client.connected() && lwiot_tick_ms() - start < HTTP_MAX_POST_WAIT)
+				lwiot_sleep(1);
+
+			if(client.available() == 0)
+				break;
+
+			auto rv = client.read(buffer, room);
+
+			if(rv <= 0)
+				break;
+
+			parser.commit(rv);
+			remaining -= rv;
 		}
 
-		return false;
+		if(!parser.done()) {
+			if(form.uploading)
+				return _parseFormUploadAborted();
+
+			return false;
+		}
+
+		auto postArgs = form.args;
+		int postArgsLen = form.count;
+		int iarg;
+		int totalArgs = ((32 - postArgsLen) < _currentArgCount) ? (32 - postArgsLen) : _currentArgCount;
+		for(iarg = 0; iarg < totalArgs; iarg++) {
+			postArgs[postArgsLen++] = _currentArgs[iarg];
+		}
+
+		_currentArgs = _arena.create<RequestArgument>(postArgsLen);
+		for(iarg = 0; iarg < postArgsLen; iarg++) {
+			_currentArgs[iarg] = postArgs[iarg];
+		}
+		_currentArgCount = iarg;
+		return true;
 	}
 
 	String HttpServer::urlDecode(const String &text)
 	{
-		String decoded = "";
-		char temp[] = "0x00";
-		unsigned int len = text.length();
-		unsigned int i = 0;
-		while(i < len) {
-			char decodedChar;
-			char encodedChar = text.charAt(i++);
-			if((encodedChar == '%') && (i + 1 < len)) {
-				temp[2] = text.charAt(i++);
-				temp[3] = text.charAt(i++);
-
-				decodedChar = strtol(temp, nullptr, 16);
-			} else {
-				if(encodedChar == '+') {
-					decodedChar = ' ';
-				} else {
-					decodedChar = encodedChar;  // normal ascii char
-				}
-			}
-			decoded += decodedChar;
-		}
-		return decoded;
+		return HttpRequestParser::decode(text);
 	}
 
 	bool HttpServer::_parseFormUploadAborted()
 	{
+		if(_currentUpload->sink != nullptr)
+			_currentUpload->sink->abort();
+
 		_currentUpload->status = UPLOAD_FILE_ABORTED;
-		if(_currentHandler && _currentHandler->canUpload(_currentUri))
-			_currentHandler->upload(*this, _currentUri, *_currentUpload);
+		_uploadCallback();
 		return false;
 	}
 }
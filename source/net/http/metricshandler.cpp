@@ -0,0 +1,52 @@
+/*
+ * HTTP metrics handler.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/util/metrics.h>
+#include <lwiot/network/httpserver.h>
+
+#include "requesthandlerimpl.h"
+
+namespace lwiot
+{
+	MetricsHandler::MetricsHandler(const String &uri, metrics::Registry &registry) : _uri(uri), _registry(registry)
+	{
+	}
+
+	bool MetricsHandler::canHandle(HTTPMethod requestMethod, const String &requestUri)
+	{
+		return requestMethod == HTTP_GET && StringView(requestUri) == StringView(this->_uri);
+	}
+
+	bool MetricsHandler::handle(HttpServer &server, HTTPMethod requestMethod, const String &requestUri)
+	{
+		if(!this->canHandle(requestMethod, requestUri))
+			return false;
+
+		auto json = server.arg("format") == "json";
+		auto writer = [&](const char *data, size_t length) {
+			return server.writeChunk(data, length) >= 0;
+		};
+
+		if(!server.beginChunked(200, json ? "application/json" : "text/plain; version=0.0.4"))
+			return true;
+
+		if(json)
+			this->_registry.writeJson(writer);
+		else
+			this->_registry.writePrometheus(writer);
+
+		server.endChunked();
+		return true;
+	}
+}
@@ -31,22 +31,22 @@ namespace lwiot
 		{
 		}
 
-		bool canHandle(HTTPMethod requestMethod, String requestUri) override
+		/*
+		 * Function handlers are found through the HttpRouter, which has already matched the
+		 * URI against the route pattern. Only the method is checked here.
+		 */
+		bool canHandle(HTTPMethod requestMethod, const String& requestUri) override
 		{
-			if(_method != HTTP_ANY && _method != requestMethod)
-				return false;
-
-			return (requestUri != _uri) == 0;
-
+			UNUSED(requestUri);
+			return _method == HTTP_ANY || _method == requestMethod;
 		}
 
-		bool canUpload(String requestUri) override
+		bool canUpload(const String& requestUri) override
 		{
-			return !(!_ufn || !canHandle(HTTP_POST, requestUri));
-
+			return _ufn && canHandle(HTTP_POST, requestUri);
 		}
 
-		bool handle(HttpServer &server, HTTPMethod requestMethod, String requestUri) override
+		bool handle(HttpServer &server, HTTPMethod requestMethod, const String& requestUri) override
 		{
 			if(!canHandle(requestMethod, requestUri))
 				return false;
@@ -55,16 +55,122 @@ namespace lwiot
 			return true;
 		}
 
-		void upload(HttpServer &server, String requestUri, HTTPUpload &upload) override
+		void upload(HttpServer &server, const String& requestUri, HTTPUpload &upload) override
 		{
 			if(canUpload(requestUri))
 				_ufn(server);
 		}
 
+		const String& uri() const
+		{
+			return _uri;
+		}
+
+		HTTPMethod method() const
+		{
+			return _method;
+		}
+
 	protected:
 		HttpServer::THandlerFunction _fn;
 		HttpServer::THandlerFunction _ufn;
 		String _uri;
 		HTTPMethod _method;
 	};
+
+	class PushRequestHandler : public RequestHandler {
+	public:
+		PushRequestHandler(const String &uri, HttpPushEndpoint &endpoint) : _uri(uri), _endpoint(endpoint)
+		{
+		}
+
+		bool canHandle(HTTPMethod requestMethod, const String& requestUri) override
+		{
+			return requestMethod == HTTP_GET && requestUri == _uri;
+		}
+
+		bool handle(HttpServer &server, HTTPMethod requestMethod, const String& requestUri) override
+		{
+			if(!canHandle(requestMethod, requestUri))
+				return false;
+
+			_endpoint.accept(server);
+			return true;
+		}
+
+	protected:
+		String _uri;
+		HttpPushEndpoint &_endpoint;
+	};
+
+	class TimeSeriesStore;
+
+	class TimeSeriesHandler : public RequestHandler {
+	public:
+		TimeSeriesHandler(const String &uri, TimeSeriesStore &store);
+
+		bool canHandle(HTTPMethod requestMethod, const String& requestUri) override;
+		bool handle(HttpServer &server, HTTPMethod requestMethod, const String& requestUri) override;
+
+	protected:
+		String _uri;
+		TimeSeriesStore &_store;
+	};
+
+	namespace metrics
+	{
+		class Registry;
+	}
+
+	class MetricsHandler : public RequestHandler {
+	public:
+		MetricsHandler(const String &uri, metrics::Registry &registry);
+
+		bool canHandle(HTTPMethod requestMethod, const String& requestUri) override;
+		bool handle(HttpServer &server, HTTPMethod requestMethod, const String& requestUri) override;
+
+	protected:
+		String _uri;
+		metrics::Registry &_registry;
+	};
+
+#ifdef HAVE_UNISTD_H
+	class File;
+
+	class StaticFileHandler : public RequestHandler {
+	public:
+		StaticFileHandler(const String &uri, const String &path, const char *cacheHeader);
+
+		bool canHandle(HTTPMethod requestMethod, const String& requestUri) override;
+		bool handle(HttpServer &server, HTTPMethod requestMethod, const String& requestUri) override;
+
+	protected:
+		String _uri;
+		String _path;
+		const char *_cacheHeader;
+		bool _directory;
+
+	private:
+		bool resolve(const String &requestUri, String &path) const;
+		void sendFile(HttpServer &server, File &file, const char *contentType, bool gzip, bool variant);
+	};
+
+	class MappedRegion;
+
+	class StaticRegionHandler : public RequestHandler {
+	public:
+		StaticRegionHandler(const String &uri, const MappedRegion &region, const char *contentType,
+		                    const char *cacheHeader);
+
+		bool canHandle(HTTPMethod requestMethod, const String& requestUri) override;
+		bool handle(HttpServer &server, HTTPMethod requestMethod, const String& requestUri) override;
+
+	protected:
+		String _uri;
+		const MappedRegion &_region;
+		const char *_contentType;
+		const char *_cacheHeader;
+		char _etag[24];
+	};
+#endif
 }
@@ -0,0 +1,381 @@
+/*
+ * HTTP static file handler.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <lwiot.h>
+
+#ifdef HAVE_STAT_H
+#include <sys/stat.h>
+#endif
+
+#include <lwiot/types.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/io/file.h>
+#include <lwiot/io/mappedregion.h>
+#include <lwiot/uniquepointer.h>
+#include <lwiot/network/httpserver.h>
+
+#include "mimetable.h"
+#include "requesthandlerimpl.h"
+
+namespace lwiot
+{
+	static const char *content_type(StringView path)
+	{
+		using namespace mime;
+
+		for(int idx = 0; idx < none; idx++) {
+			if(path.endsWith(mimeTable[idx].endsWith))
+				return mimeTable[idx].mimeType;
+		}
+
+		return mimeTable[none].mimeType;
+	}
+
+	static bool is_file(const String &path)
+	{
+#ifdef HAVE_STAT_H
+		struct stat info;
+
+		return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+#else
+		File file(path, FileMode::Read);
+		return static_cast<bool>(file);
+#endif
+	}
+
+	static bool http_date(time_t stamp, char *output, size_t length)
+	{
+		struct tm gmt;
+
+		if(stamp == 0)
+			return false;
+
+#ifdef WIN32
+		_gmtime64_s(&gmt, &stamp);
+#else
+		gmtime_r(&stamp, &gmt);
+#endif
+		return strftime(output, length, "%a, %d %b %Y %H:%M:%S GMT", &gmt) > 0;
+	}
+
+	static bool parse_number(StringView text, size_t &value)
+	{
+		value = 0;
+
+		if(text.empty())
+			return false;
+
+		for(auto c : text) {
+			if(c < '0' || c > '9')
+				return false;
+
+			value = value * 10 + (c - '0');
+		}
+
+		return true;
+	}
+
+	/* Check whether a list of entity tags, such as an If-None-Match value, contains etag. */
+	static bool etag_matches(StringView list, StringView etag)
+	{
+		size_t pos = 0;
+
+		while(pos <= list.length()) {
+			auto end = list.find(',', pos);
+
+			if(end == StringView::npos)
+				end = list.length();
+
+			auto tag = list.substr(pos, end - pos).trim();
+			pos = end + 1;
+
+			/* Weak comparison: a W/ prefix does not matter for GET requests. */
+			if(tag.startsWith("W/"))
+				tag = tag.substr(2);
+
+			if(tag == "*" || tag == etag)
+				return true;
+		}
+
+		return false;
+	}
+
+	/*
+	 * Parse a single byte range: "bytes=first-last", "bytes=first-" or "bytes=-suffix". Returns 1 for
+	 * a satisfiable range, -1 for one that lies outside the file and 0 for a range that should be
+	 * ignored, which includes requests for multiple ranges.
+	 */
+	static int parse_range(StringView value, size_t size, size_t &offset, size_t &length)
+	{
+		size_t first, last;
+
+		if(!value.startsWith("bytes="))
+			return 0;
+
+		auto spec = value.substr(6).trim();
+		auto dash = spec.find('-');
+
+		if(dash == StringView::npos || spec.find(',') != StringView::npos)
+			return 0;
+
+		auto start = spec.substr(0, dash).trim();
+		auto end = spec.substr(dash + 1).trim();
+
+		if(start.empty()) {
+			if(!parse_number(end, last))
+				return 0;
+
+			if(last == 0 || size == 0)
+				return -1;
+
+			length = last > size ? size : last;
+			offset = size - length;
+			return 1;
+		}
+
+		if(!parse_number(start, first))
+			return 0;
+
+		if(first >= size)
+			return -1;
+
+		last = size - 1;
+
+		if(!end.empty()) {
+			size_t value_end;
+
+			if(!parse_number(end, value_end) || value_end < first)
+				return 0;
+
+			if(value_end < last)
+				last = value_end;
+		}
+
+		offset = first;
+		length = last - first + 1;
+		return 1;
+	}
+
+	/*
+	 * Send the validators and the caching headers, and answer conditional and range requests.
+	 * Returns false when the response has already been sent (304 or 416). Otherwise the status
+	 * code and the part of the entity to send are stored in code, offset and length.
+	 */
+	static bool prepare_entity(HttpServer &server, const char *etag, const char *modified, const char *cacheHeader,
+	                           size_t size, int &code, size_t &offset, size_t &length)
+	{
+		server.sendHeader("ETag", etag);
+
+		if(modified != nullptr)
+			server.sendHeader("Last-Modified", modified);
+
+		if(cacheHeader != nullptr)
+			server.sendHeader("Cache-Control", cacheHeader);
+
+		/* If-Modified-Since is only compared when there is no If-None-Match. Clients send back the
+		   Last-Modified value as it was received, so an exact match suffices. */
+		auto match = server.requestHeader(http::Header::IfNoneMatch);
+		auto fresh = match.empty() ? modified != nullptr &&
+		                             server.requestHeader(http::Header::IfModifiedSince) == StringView(modified) :
+		             etag_matches(match, etag);
+
+		if(fresh) {
+			server.send(304);
+			return false;
+		}
+
+		server.sendHeader("Accept-Ranges", "bytes");
+
+		offset = 0;
+		length = size;
+		code = 200;
+
+		auto range = server.requestHeader(http::Header::Range);
+		auto condition = server.requestHeader(http::Header::IfRange);
+
+		/* A stale If-Range turns a range request into a request for the whole entity. */
+		if(!range.empty() && (condition.empty() || condition == StringView(etag) ||
+		                      (modified != nullptr && condition == StringView(modified)))) {
+			auto rv = parse_range(range, size, offset, length);
+
+			if(rv < 0) {
+				server.sendHeader("Content-Range", String("bytes */") + String(size));
+				server.send(416);
+				return false;
+			}
+
+			if(rv > 0) {
+				code = 206;
+				server.sendHeader("Content-Range", String("bytes ") + String(offset) + "-" +
+				                  String(offset + length - 1) + "/" + String(size));
+			} else {
+				offset = 0;
+				length = size;
+			}
+		}
+
+		return true;
+	}
+
+	StaticFileHandler::StaticFileHandler(const String &uri, const String &path, const char *cacheHeader) :
+		_uri(uri), _path(path), _cacheHeader(cacheHeader), _directory(path.endsWith("/"))
+	{
+		if(this->_directory && this->_uri.endsWith("/"))
+			this->_uri = this->_uri.substring(0, this->_uri.length() - 1);
+	}
+
+	bool StaticFileHandler::canHandle(HTTPMethod requestMethod, const String &requestUri)
+	{
+		StringView uri(requestUri);
+
+		if(requestMethod != HTTP_GET)
+			return false;
+
+		if(!this->_directory)
+			return uri == StringView(this->_uri);
+
+		return uri.startsWith(this->_uri) && (uri.length() == this->_uri.length() || uri[this->_uri.length()] == '/');
+	}
+
+	bool StaticFileHandler::resolve(const String &requestUri, String &path) const
+	{
+		if(!this->_directory) {
+			path = this->_path;
+			return true;
+		}
+
+		auto rest = StringView(requestUri).substr(this->_uri.length());
+		size_t pos = 0;
+
+		/* Never leave the served directory. */
+		while(pos <= rest.length()) {
+			auto end = rest.find('/', pos);
+
+			if(end == StringView::npos)
+				end = rest.length();
+
+			if(rest.substr(pos, end - pos) == "..")
+				return false;
+
+			pos = end + 1;
+		}
+
+		if(rest.startsWith("/"))
+			rest = rest.substr(1);
+
+		path = this->_path;
+		path += rest.toString();
+
+		if(path.endsWith("/"))
+			path += "index.html";
+
+		return true;
+	}
+
+	bool StaticFileHandler::handle(HttpServer &server, HTTPMethod requestMethod, const String &requestUri)
+	{
+		using namespace mime;
+		String path;
+
+		if(!this->canHandle(requestMethod, requestUri) || !this->resolve(requestUri, path))
+			return false;
+
+		auto type = content_type(path);
+		String compressed = path + mimeTable[gz].endsWith;
+		bool variant = !path.endsWith(mimeTable[gz].endsWith) && is_file(compressed);
+		bool gzip = variant && server.acceptsEncoding("gzip");
+
+		if(!gzip && !is_file(path))
+			return false;
+
+		File file(gzip ? compressed : path, FileMode::Read);
+
+		if(!file)
+			return false;
+
+		this->sendFile(server, file, type, gzip, variant);
+		return true;
+	}
+
+	void StaticFileHandler::sendFile(HttpServer &server, File &file, const char *contentType, bool gzip, bool variant)
+	{
+		char etag[40];
+		char modified[32];
+		auto size = file.size();
+		auto dated = http_date(file.modified(), modified, sizeof(modified));
+
+		snprintf(etag, sizeof(etag), "\"%lx-%lx\"", static_cast<unsigned long>(file.modified()),
+		         static_cast<unsigned long>(size));
+
+		if(variant)
+			server.sendHeader("Vary", "Accept-Encoding");
+
+		if(gzip)
+			server.sendHeader("Content-Encoding", "gzip");
+
+		size_t offset, length;
+		int code;
+
+		if(!prepare_entity(server, etag, dated ? modified : nullptr, this->_cacheHeader, size, code, offset, length))
+			return;
+
+		server.setContentLength(length);
+		server.send(code, contentType, String());
+
+		if(length > 0)
+			server.sendContent(file, offset, length);
+	}
+
+	StaticRegionHandler::StaticRegionHandler(const String &uri, const MappedRegion &region, const char *contentType,
+	                                         const char *cacheHeader) :
+		_uri(uri), _region(region), _contentType(contentType), _cacheHeader(cacheHeader)
+	{
+		uint32_t hash = 2166136261UL;
+
+		/* The content does not change, so its FNV-1a hash makes a strong validator. */
+		for(size_t idx = 0; idx < region.size(); idx++) {
+			hash ^= region.data()[idx];
+			hash *= 16777619UL;
+		}
+
+		snprintf(this->_etag, sizeof(this->_etag), "\"%lx-%lx\"", static_cast<unsigned long>(hash),
+		         static_cast<unsigned long>(region.size()));
+
+		if(this->_contentType == nullptr)
+			this->_contentType = content_type(uri);
+	}
+
+	bool StaticRegionHandler::canHandle(HTTPMethod requestMethod, const String &requestUri)
+	{
+		return requestMethod == HTTP_GET && StringView(requestUri) == StringView(this->_uri);
+	}
+
+	bool StaticRegionHandler::handle(HttpServer &server, HTTPMethod requestMethod, const String &requestUri)
+	{
+		size_t offset, length;
+		int code;
+
+		if(!this->canHandle(requestMethod, requestUri) || !this->_region)
+			return false;
+
+		if(!prepare_entity(server, this->_etag, nullptr, this->_cacheHeader, this->_region.size(), code, offset, length))
+			return true;
+
+		server.setContentLength(length);
+		server.send(code, this->_contentType, String());
+
+		if(length > 0)
+			server.sendContent(this->_region.data() + offset, length);
+
+		return true;
+	}
+}
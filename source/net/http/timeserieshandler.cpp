@@ -0,0 +1,76 @@
+/*
+ * HTTP time-series download handler.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/util/timeseriesstore.h>
+#include <lwiot/network/httpserver.h>
+
+#include "requesthandlerimpl.h"
+
+namespace lwiot
+{
+	static time_t time_arg(HttpServer &server, StringView name, time_t fallback)
+	{
+		if(!server.hasArg(name))
+			return fallback;
+
+		return static_cast<time_t>(strtoull(server.arg(name).c_str(), nullptr, 10));
+	}
+
+	TimeSeriesHandler::TimeSeriesHandler(const String &uri, TimeSeriesStore &store) : _uri(uri), _store(store)
+	{
+	}
+
+	bool TimeSeriesHandler::canHandle(HTTPMethod requestMethod, const String &requestUri)
+	{
+		return requestMethod == HTTP_GET && StringView(requestUri) == StringView(this->_uri);
+	}
+
+	bool TimeSeriesHandler::handle(HttpServer &server, HTTPMethod requestMethod, const String &requestUri)
+	{
+		if(!this->canHandle(requestMethod, requestUri))
+			return false;
+
+		auto from = time_arg(server, "from", 0);
+		auto to = time_arg(server, "to", static_cast<time_t>(INT64_MAX));
+		auto json = server.arg("format") == "json";
+		bool first = true;
+		char line[48];
+
+		if(!server.beginChunked(200, json ? "application/json" : "text/csv"))
+			return true;
+
+		server.writeChunk(json ? "[" : "timestamp,value\n");
+
+		this->_store.query(from, to, [&](time_t timestamp, double value) {
+			int length;
+
+			if(json)
+				length = snprintf(line, sizeof(line), "%s[%llu,%.10g]", first ? "" : ",",
+				                  static_cast<unsigned long long>(timestamp), value);
+			else
+				length = snprintf(line, sizeof(line), "%llu,%.10g\n", static_cast<unsigned long long>(timestamp), value);
+
+			first = false;
+			return server.writeChunk(line, static_cast<size_t>(length)) >= 0;
+		});
+
+		if(json)
+			server.writeChunk("]");
+
+		server.endChunked();
+		return true;
+	}
+}
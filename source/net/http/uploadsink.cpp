@@ -0,0 +1,33 @@
+/*
+ * HTTP upload sink.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/network/uploadsink.h>
+
+namespace lwiot
+{
+	bool UploadSink::finish()
+	{
+		return true;
+	}
+
+	void UploadSink::abort()
+	{
+	}
+
+	StreamUploadSink::StreamUploadSink(Stream& stream) : _stream(stream)
+	{
+	}
+
+	bool StreamUploadSink::write(const uint8_t *data, size_t length)
+	{
+		return this->_stream.write(data, length) == static_cast<ssize_t>(length);
+	}
+}
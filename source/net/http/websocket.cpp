@@ -0,0 +1,453 @@
+/*
+ * WebSocket (RFC 6455) server endpoint.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/network/sha1.h>
+#include <lwiot/network/base64.h>
+#include <lwiot/network/httpserver.h>
+#include <lwiot/network/websocket.h>
+
+#define WEBSOCKET_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+namespace lwiot
+{
+	namespace websocket
+	{
+		size_t header(uint8_t *output, Opcode opcode, size_t length)
+		{
+			output[0] = 0x80 | opcode;
+
+			if(length < 126) {
+				output[1] = static_cast<uint8_t>(length);
+				return 2;
+			}
+
+			if(length <= 0xFFFF) {
+				output[1] = 126;
+				output[2] = static_cast<uint8_t>(length >> 8);
+				output[3] = static_cast<uint8_t>(length);
+				return 4;
+			}
+
+			output[1] = 127;
+
+			for(int idx = 0; idx < 8; idx++)
+				output[9 - idx] = static_cast<uint8_t>(static_cast<uint64_t>(length) >> (idx * 8));
+
+			return MaxHeader;
+		}
+
+		void accept(StringView key, char *output)
+		{
+			uint8_t digest[SHA1_DIGEST_SIZE];
+			sha1_context_t ctx;
+
+			sha1_init(&ctx);
+			sha1_update(&ctx, key.data(), key.length());
+			sha1_update(&ctx, WEBSOCKET_GUID, sizeof(WEBSOCKET_GUID) - 1);
+			sha1_final(&ctx, digest);
+
+			base64_encode_chars(reinterpret_cast<const char *>(digest), sizeof(digest), output);
+		}
+	}
+
+	/* Parser */
+
+	WebSocketParser::WebSocketParser(size_t max) : _message(), _max(max)
+	{
+		this->reset();
+	}
+
+	void WebSocketParser::reset()
+	{
+		this->_message.setIndex(0);
+		this->_fragmented = false;
+		this->_messageOpcode = websocket::Continuation;
+		this->_error = 0;
+		this->_state = Head;
+		this->_headLength = 0;
+		this->_headNeeded = 2;
+		this->_controlLength = 0;
+	}
+
+	void WebSocketParser::next()
+	{
+		if(this->_state != Done)
+			return;
+
+		if(!(this->_frameOpcode & 0x8)) {
+			this->_message.setIndex(0);
+			this->_fragmented = false;
+		}
+
+		this->_state = Head;
+		this->_headLength = 0;
+		this->_headNeeded = 2;
+		this->_controlLength = 0;
+	}
+
+	size_t WebSocketParser::feed(const void *data, size_t length)
+	{
+		auto bytes = static_cast<const uint8_t *>(data);
+		size_t consumed = 0;
+
+		while(consumed < length && (this->_state == Head || this->_state == Payload)) {
+			if(this->_state == Head) {
+				this->_head[this->_headLength++] = bytes[consumed++];
+
+				/* The second byte tells how long the rest of the header is. */
+				if(this->_headLength == 2) {
+					auto size = this->_head[1] & 0x7F;
+
+					this->_headNeeded = 2 + (size == 126 ? 2 : size == 127 ? 8 : 0) + (this->_head[1] & 0x80 ? 4 : 0);
+				}
+
+				if(this->_headLength == this->_headNeeded)
+					this->parseHead();
+
+				continue;
+			}
+
+			auto num = length - consumed;
+
+			if(num > this->_remaining)
+				num = static_cast<size_t>(this->_remaining);
+
+			uint8_t *output;
+
+			if(this->_frameOpcode & 0x8) {
+				output = this->_control + this->_controlLength;
+				this->_controlLength += num;
+			} else {
+				output = this->_message.data() + this->_message.index();
+				this->_message.setIndex(this->_message.index() + num);
+			}
+
+			for(size_t idx = 0; idx < num; idx++)
+				output[idx] = bytes[consumed + idx] ^ this->_mask[(this->_offset + idx) & 3];
+
+			consumed += num;
+			this->_offset += num;
+			this->_remaining -= num;
+
+			if(this->_remaining == 0)
+				this->endFrame();
+		}
+
+		return consumed;
+	}
+
+	void WebSocketParser::parseHead()
+	{
+		auto opcode = static_cast<websocket::Opcode>(this->_head[0] & 0x0F);
+		auto size = this->_head[1] & 0x7F;
+		auto mask = this->_head + this->_headLength - 4;
+		uint64_t length = size;
+
+		/* No extensions are negotiated, so the reserved bits must be clear. Clients must mask. */
+		if((this->_head[0] & 0x70) != 0 || (this->_head[1] & 0x80) == 0) {
+			this->fail(websocket::ProtocolError);
+			return;
+		}
+
+		if(size == 126) {
+			length = static_cast<uint64_t>(this->_head[2]) << 8 | this->_head[3];
+		} else if(size == 127) {
+			length = 0;
+
+			for(int idx = 2; idx < 10; idx++)
+				length = length << 8 | this->_head[idx];
+		}
+
+		this->_fin = (this->_head[0] & 0x80) != 0;
+		this->_frameOpcode = opcode;
+
+		switch(opcode) {
+		case websocket::Close:
+		case websocket::Ping:
+		case websocket::Pong:
+			if(!this->_fin || length > sizeof(this->_control)) {
+				this->fail(websocket::ProtocolError);
+				return;
+			}
+			break;
+
+		case websocket::Continuation:
+			if(!this->_fragmented) {
+				this->fail(websocket::ProtocolError);
+				return;
+			}
+			break;
+
+		case websocket::Text:
+		case websocket::Binary:
+			if(this->_fragmented) {
+				this->fail(websocket::ProtocolError);
+				return;
+			}
+
+			this->_messageOpcode = opcode;
+			this->_fragmented = true;
+			break;
+
+		default:
+			this->fail(websocket::ProtocolError);
+			return;
+		}
+
+		if(!(opcode & 0x8)) {
+			if(length > this->_max - this->_message.index()) {
+				this->fail(websocket::MessageTooBig);
+				return;
+			}
+
+			this->_message.reserveExact(this->_message.index() + static_cast<size_t>(length));
+		}
+
+		memcpy(this->_mask, mask, sizeof(this->_mask));
+		this->_remaining = length;
+		this->_offset = 0;
+		this->_state = Payload;
+
+		if(length == 0)
+			this->endFrame();
+	}
+
+	void WebSocketParser::endFrame()
+	{
+		if((this->_frameOpcode & 0x8) || this->_fin) {
+			this->_state = Done;
+			return;
+		}
+
+		this->_state = Head;
+		this->_headLength = 0;
+		this->_headNeeded = 2;
+	}
+
+	void WebSocketParser::fail(uint16_t code)
+	{
+		this->_state = Failed;
+		this->_error = code;
+	}
+
+	bool WebSocketParser::done() const
+	{
+		return this->_state == Done;
+	}
+
+	bool WebSocketParser::failed() const
+	{
+		return this->_state == Failed;
+	}
+
+	uint16_t WebSocketParser::error() const
+	{
+		return this->_error;
+	}
+
+	websocket::Opcode WebSocketParser::opcode() const
+	{
+		return (this->_frameOpcode & 0x8) ? this->_frameOpcode : this->_messageOpcode;
+	}
+
+	const uint8_t *WebSocketParser::payload() const
+	{
+		return (this->_frameOpcode & 0x8) ? this->_control : this->_message.data();
+	}
+
+	size_t WebSocketParser::length() const
+	{
+		return (this->_frameOpcode & 0x8) ? this->_controlLength : this->_message.index();
+	}
+
+	StringView WebSocketParser::text() const
+	{
+		return StringView(reinterpret_cast<const char *>(this->payload()), this->length());
+	}
+
+	/* Endpoint */
+
+	WebSocketEndpoint::WebSocketEndpoint(size_t subscribers) : HttpPushEndpoint(subscribers),
+		_parsers(new WebSocketParser[subscribers])
+	{
+	}
+
+	WebSocketEndpoint::~WebSocketEndpoint()
+	{
+		delete[] this->_parsers;
+	}
+
+	void WebSocketEndpoint::onConnect(const ConnectionHandler &handler)
+	{
+		ScopedLock lock(this->_lock);
+		this->_connect = handler;
+	}
+
+	void WebSocketEndpoint::onDisconnect(const ConnectionHandler &handler)
+	{
+		ScopedLock lock(this->_lock);
+		this->_disconnect = handler;
+	}
+
+	void WebSocketEndpoint::onMessage(const MessageHandler &handler)
+	{
+		ScopedLock lock(this->_lock);
+		this->_message = handler;
+	}
+
+	size_t WebSocketEndpoint::broadcast(StringView text)
+	{
+		return this->broadcastFrame(websocket::Text, text.data(), text.length());
+	}
+
+	size_t WebSocketEndpoint::broadcast(const void *data, size_t length)
+	{
+		return this->broadcastFrame(websocket::Binary, data, length);
+	}
+
+	bool WebSocketEndpoint::send(size_t client, StringView text)
+	{
+		return this->sendFrame(client, websocket::Text, text.data(), text.length());
+	}
+
+	bool WebSocketEndpoint::send(size_t client, const void *data, size_t length)
+	{
+		return this->sendFrame(client, websocket::Binary, data, length);
+	}
+
+	void WebSocketEndpoint::disconnect(size_t client, uint16_t code)
+	{
+		ScopedLock lock(this->_lock);
+
+		this->sendClose(client, code);
+		this->drop(client);
+	}
+
+	UniquePointer<TcpClient> WebSocketEndpoint::handshake(HttpServer &server)
+	{
+		char accept[32];
+		auto key = server.requestHeader(http::Header::SecWebSocketKey);
+
+		if(server.requestHeader(http::Header::SecWebSocketVersion) != StringView("13")) {
+			server.sendHeader("Sec-WebSocket-Version", "13");
+			server.send(426, "text/plain", "WebSocket version 13 required");
+			return UniquePointer<TcpClient>();
+		}
+
+		if(key.empty() || !server.requestHeader(http::Header::Upgrade).equalsIgnoreCase("websocket")) {
+			server.send(400, "text/plain", "Invalid WebSocket handshake");
+			return UniquePointer<TcpClient>();
+		}
+
+		websocket::accept(key, accept);
+
+		server.sendHeader("Upgrade", "websocket");
+		server.sendHeader("Connection", "Upgrade");
+		server.sendHeader("Sec-WebSocket-Accept", accept);
+
+		return server.takeOver(101);
+	}
+
+	bool WebSocketEndpoint::receive(size_t idx, TcpClient &client)
+	{
+		auto &parser = this->_parsers[idx];
+
+		while(this->subscriber(idx) != nullptr && client.available() > 0) {
+			auto span = client.peekSpan();
+
+			if(span.size() == 0)
+				break;
+
+			client.skip(parser.feed(span.buffer(), span.size()));
+
+			if(parser.failed()) {
+				this->sendClose(idx, parser.error());
+				return false;
+			}
+
+			if(!parser.done())
+				continue;
+
+			switch(parser.opcode()) {
+			case websocket::Ping:
+				this->sendFrame(idx, websocket::Pong, parser.payload(), parser.length());
+				break;
+
+			case websocket::Close:
+				/* Echo the status code to complete the close handshake. */
+				this->sendFrame(idx, websocket::Close, parser.payload(), parser.length() >= 2 ? 2 : 0);
+				return false;
+
+			case websocket::Pong:
+				break;
+
+			default:
+				if(this->_message)
+					this->_message(*this, idx, parser);
+				break;
+			}
+
+			parser.next();
+		}
+
+		return true;
+	}
+
+	void WebSocketEndpoint::attached(size_t idx)
+	{
+		this->_parsers[idx].reset();
+
+		if(this->_connect)
+			this->_connect(*this, idx);
+	}
+
+	void WebSocketEndpoint::detached(size_t idx)
+	{
+		if(this->_disconnect)
+			this->_disconnect(*this, idx);
+	}
+
+	size_t WebSocketEndpoint::broadcastFrame(websocket::Opcode opcode, const void *data, size_t length)
+	{
+		uint8_t head[websocket::MaxHeader];
+		BufferChain frame;
+
+		frame.append(head, websocket::header(head, opcode, length));
+
+		if(length > 0)
+			frame.append(data, length);
+
+		return this->writeAll(frame);
+	}
+
+	bool WebSocketEndpoint::sendFrame(size_t idx, websocket::Opcode opcode, const void *data, size_t length)
+	{
+		uint8_t head[websocket::MaxHeader];
+		BufferChain frame;
+
+		frame.append(head, websocket::header(head, opcode, length));
+
+		if(length > 0)
+			frame.append(data, length);
+
+		return this->writeTo(idx, frame);
+	}
+
+	void WebSocketEndpoint::sendClose(size_t idx, uint16_t code)
+	{
+		uint8_t status[] = { static_cast<uint8_t>(code >> 8), static_cast<uint8_t>(code) };
+
+		this->sendFrame(idx, websocket::Close, status, sizeof(status));
+	}
+}
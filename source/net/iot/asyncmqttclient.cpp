@@ -11,21 +11,49 @@
 
 #include <lwiot/function.h>
 #include <lwiot/scopedlock.h>
+#include <lwiot/bufferchain.h>
 
 #include <lwiot/stl/string.h>
 #include <lwiot/stl/map.h>
+#include <lwiot/stl/smallvector.h>
 
 #include <lwiot/network/asyncmqttclient.h>
 
-#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/kernel/executor.h>
 #include <lwiot/kernel/uniquetrylock.h>
 #include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/uniquelock.h>
+#include <lwiot/kernel/sharedlock.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/scopedsharedlock.h>
+
+#include "mqtt.h"
 
 namespace lwiot
 {
 	AsyncMqttClient::AsyncMqttClient(int tmo) :
-		MqttClient(), _executor("mqtt"), _lock(false),
-		_running(false), _will_qos(0), _will_retain(false), _clean(true), _tmo(tmo)
+		MqttClient(), _private_executor(new Executor("mqtt", 2)), _executor(*_private_executor), _lock(false),
+		_client(nullptr), _running(false), _active(false), _backoff_min(CONFIG_MQTT_BACKOFF_MIN),
+		_backoff_max(CONFIG_MQTT_BACKOFF_MAX), _backoff(CONFIG_MQTT_BACKOFF_MIN), _next_attempt(0),
+		_seed((static_cast<uint32_t>(lwiot_tick()) ^ static_cast<uint32_t>(reinterpret_cast<uintptr_t>(this))) | 1U),
+		_will_qos(0), _will_retain(false), _clean(true), _tmo(tmo), _inflight(), _stalled(nullptr),
+		_window(CONFIG_MQTT_MAX_INFLIGHT), _retry(CONFIG_MQTT_RETRY_INTERVAL), _store(nullptr), _log(nullptr),
+		_replay_batch(CONFIG_MQTT_REPLAY_BATCH), _replay_interval(CONFIG_MQTT_REPLAY_INTERVAL), _replayed(0), _online(false),
+		_space(EventType::Counting, 1), _policy(static_cast<int>(OverflowPolicy::Block)), _flushes(0),
+		_flush_posted(false), _msgid(0), _dropped(0)
+	{
+	}
+
+	AsyncMqttClient::AsyncMqttClient(Executor& executor, int tmo) :
+		MqttClient(), _private_executor(), _executor(executor), _lock(false),
+		_client(nullptr), _running(false), _active(false), _backoff_min(CONFIG_MQTT_BACKOFF_MIN),
+		_backoff_max(CONFIG_MQTT_BACKOFF_MAX), _backoff(CONFIG_MQTT_BACKOFF_MIN), _next_attempt(0),
+		_seed((static_cast<uint32_t>(lwiot_tick()) ^ static_cast<uint32_t>(reinterpret_cast<uintptr_t>(this))) | 1U),
+		_will_qos(0), _will_retain(false), _clean(true), _tmo(tmo), _inflight(), _stalled(nullptr),
+		_window(CONFIG_MQTT_MAX_INFLIGHT), _retry(CONFIG_MQTT_RETRY_INTERVAL), _store(nullptr), _log(nullptr),
+		_replay_batch(CONFIG_MQTT_REPLAY_BATCH), _replay_interval(CONFIG_MQTT_REPLAY_INTERVAL), _replayed(0), _online(false),
+		_space(EventType::Counting, 1), _policy(static_cast<int>(OverflowPolicy::Block)), _flushes(0),
+		_flush_posted(false), _msgid(0), _dropped(0)
 	{
 	}
 
@@ -39,11 +67,24 @@ namespace lwiot
 	{
 		ScopedLock lock(this->_lock);
 
-		if(!this->_running)
-			return;
+		if(this->_running) {
+			lock.unlock();
+			this->stop();
+			lock.lock();
+		}
 
-		lock.unlock();
-		this->stop();
+		while(this->_flushes.load() > 0 && this->_executor.running())
+			this->_idle.wait(lock, CONFIG_MQTT_ASYNC_POLL);
+
+		while(auto entry = this->_queue.pop())
+			delete entry;
+
+		for(auto& entry : this->_inflight) {
+			delete entry;
+			entry = nullptr;
+		}
+
+		delete this->_stalled;
 	}
 
 	void AsyncMqttClient::setReconnectHandler(const lwiot::AsyncMqttClient::ReconnectHandler &handler)
@@ -52,6 +93,94 @@ namespace lwiot
 		this->_reconnect_handler = handler;
 	}
 
+	void AsyncMqttClient::setReconnectBackoff(int min, int max)
+	{
+		ScopedLock lock(this->_lock);
+
+		this->_backoff_min = min > 0 ? min : 1;
+		this->_backoff_max = max > this->_backoff_min ? max : this->_backoff_min;
+		this->_backoff = this->_backoff_min;
+	}
+
+	void AsyncMqttClient::setOverflowPolicy(OverflowPolicy policy)
+	{
+		this->_policy.store(static_cast<int>(policy));
+	}
+
+	void AsyncMqttClient::setQoS(const lwiot::String &topic, QoS qos)
+	{
+		UniqueLock<SharedLock> guard(this->_qos_lock);
+		this->_qos.add(topic, qos);
+	}
+
+	void AsyncMqttClient::setInflightWindow(size_t window)
+	{
+		ScopedLock lock(this->_lock);
+
+		if(window < 1)
+			window = 1;
+
+		this->_window = window > CONFIG_MQTT_MAX_INFLIGHT ? CONFIG_MQTT_MAX_INFLIGHT : window;
+
+		if(this->_stalled != nullptr)
+			this->schedule();
+	}
+
+	void AsyncMqttClient::setRetryInterval(int ms)
+	{
+		ScopedLock lock(this->_lock);
+		this->_retry = ms > 0 ? ms : 0;
+	}
+
+	void AsyncMqttClient::setSessionStore(MqttSessionStore &store)
+	{
+		ScopedLock lock(this->_lock);
+
+		this->_store = &store;
+		store.load([this](uint16_t id, const ByteBuffer& packet) {
+			for(auto& entry : this->_inflight) {
+				if(entry != nullptr)
+					continue;
+
+				entry = new Outbound;
+				entry->packet.append(packet.data(), packet.index());
+				entry->id = id;
+				entry->sent = 0;
+
+				/* Do not hand out the identifiers of restored messages again soon. */
+				if(id > this->_msgid.load())
+					this->_msgid.store(id);
+
+				return;
+			}
+		});
+	}
+
+	void AsyncMqttClient::setOfflineLog(MqttOfflineLog &log)
+	{
+		ScopedLock lock(this->_lock);
+		this->_log = &log;
+	}
+
+	void AsyncMqttClient::setReplayRate(size_t batch, int ms)
+	{
+		ScopedLock lock(this->_lock);
+
+		this->_replay_batch = batch > 0 ? batch : 1;
+		this->_replay_interval = ms > 0 ? ms : 0;
+	}
+
+	MqttClient::QoS AsyncMqttClient::qos(const lwiot::String &topic) const
+	{
+		ScopedSharedLock guard(this->_qos_lock);
+		auto iter = this->_qos.find(topic);
+
+		if(iter == this->_qos.end())
+			return QOS0;
+
+		return iter->value;
+	}
+
 	bool AsyncMqttClient::start(lwiot::TcpClient &client)
 	{
 		UniqueTryLock<Lock> lock(this->_lock, this->_tmo);
@@ -59,13 +188,24 @@ namespace lwiot
 		if(!lock.locked())
 			return false;
 
+		if(this->_running)
+			return false;
+
+		if(this->_private_executor)
+			this->_private_executor->start();
+
+		this->_client = &client;
 		this->begin(client);
+		this->setCallback([this](const String& topic, const SharedByteBuffer& buffer) {
+			this->invoke(topic, buffer);
+		});
+
 		this->_running = true;
-		this->_executor.start([&]() -> void {
-			this->run();
+		this->_active = this->_executor.post([this]() {
+			this->step();
 		});
 
-		return true;
+		return this->_active;
 	}
 
 	void AsyncMqttClient::stop()
@@ -78,66 +218,116 @@ namespace lwiot
 		}
 
 		this->_running = false;
+		this->_wakeup.signal();
 
-		lock.unlock();
-		Thread::sleep(200);
-		lock.lock();
+		/* Wait for the pending loop step to notice. */
+		while(this->_active && this->_executor.running())
+			this->_idle.wait(lock, CONFIG_MQTT_ASYNC_POLL);
+
+		this->_active = false;
+
+		while(this->_flushes.load() > 0 && this->_executor.running())
+			this->_idle.wait(lock, CONFIG_MQTT_ASYNC_POLL);
+
+		if(this->_private_executor) {
+			lock.unlock();
+			this->_private_executor->stop();
+			lock.lock();
+		}
 
-		this->_executor.stop();
-		this->_executor.join();
 		this->disconnect();
+		this->_online.store(false);
 	}
 
-	void AsyncMqttClient::run()
+	void AsyncMqttClient::step()
 	{
-		this->_lock.lock();
-		auto running = this->_running;
+		ScopedLock lock(this->_lock);
 
-		this->setCallback([&](const String& topic, const ByteBuffer& buffer) {
-			this->invoke(topic, buffer);
-		});
+		if(!this->_running) {
+			this->_active = false;
+			this->_idle.signal();
+			return;
+		}
+
+		if(MqttClient::connected()) {
+			/* Handle everything that has arrived, then wait for more without the lock. */
+			this->loop();
 
-		this->_lock.unlock();
+			while(MqttClient::connected() && this->_client->available() > 0 && this->loop())
+				;
 
-		while(running) {
-			ScopedLock lock(this->_lock);
+			this->drain();
+			this->retry();
+			this->replay();
 
-			while(!MqttClient::connected() && this->_running && this->_id.length() != 0) {
+			if(MqttClient::connected()) {
 				lock.unlock();
-				Thread::sleep(100);
+				auto ready = this->_client->readable(CONFIG_MQTT_ASYNC_POLL);
 				lock.lock();
 
-				if(!this->reconnect())
-					continue;
-
-				MqttClient::connect(this->_id, this->_user, this->_pass,
-				                    this->_will_topic, this->_will_qos,
-				                    this->_will_retain, this->_will, this->_clean);
+				/* Readable without data means the broker closed the connection. */
+				if(ready && MqttClient::connected() && !this->_client->alive())
+					this->_client->close();
+			}
+		} else if(this->_id.length() != 0 && lwiot_tick_ms() >= this->_next_attempt) {
+			this->restore(lock);
+		} else {
+			time_t delay = CONFIG_MQTT_ASYNC_POLL;
 
-				lock.unlock();
-				Thread::sleep(100);
-				lock.lock();
+			if(this->_id.length() != 0 && this->_next_attempt - lwiot_tick_ms() < delay)
+				delay = this->_next_attempt - lwiot_tick_ms();
 
-				if(MqttClient::connected()) {
-					this->_handlers.clear();
+			lock.unlock();
+			this->_wakeup.wait(static_cast<int>(delay > 0 ? delay : 1));
+			lock.lock();
+		}
 
-					lock.unlock();
-					this->_reconnect_handler();
-					Thread::sleep(100);
-					lock.lock();
-				}
+		this->_online.store(MqttClient::connected());
+		this->_active = this->_running && this->_executor.post([this]() {
+			this->step();
+		});
 
-				lock.unlock();
-				Thread::sleep(100);
-				lock.lock();
-			}
+		if(!this->_active)
+			this->_idle.signal();
+	}
 
-			this->loop();
-			running = this->_running;
+	void AsyncMqttClient::restore(ScopedLock& lock)
+	{
+		if(this->reconnect()) {
+			MqttClient::connect(this->_id, this->_user, this->_pass,
+			                    this->_will_topic, this->_will_qos,
+			                    this->_will_retain, this->_will, this->_clean);
+		}
 
-			lock.unlock();
-			Thread::sleep(100);
+		if(!MqttClient::connected()) {
+			this->_next_attempt = lwiot_tick_ms() + this->jitter(this->_backoff);
+			this->_backoff = this->_backoff > this->_backoff_max / 2 ? this->_backoff_max : this->_backoff * 2;
+			return;
 		}
+
+		this->_backoff = this->_backoff_min;
+		this->resend();
+		this->drain();
+
+		UniqueLock<SharedLock> guard(this->_handler_lock);
+
+		this->_handlers.clear();
+		guard.unlock();
+
+		lock.unlock();
+		if(this->_reconnect_handler)
+			this->_reconnect_handler();
+		lock.lock();
+	}
+
+	int AsyncMqttClient::jitter(int delay)
+	{
+		/* Xorshift is plenty to spread out retries. */
+		this->_seed ^= this->_seed << 13;
+		this->_seed ^= this->_seed >> 17;
+		this->_seed ^= this->_seed << 5;
+
+		return delay - static_cast<int>(this->_seed % static_cast<uint32_t>(delay / 2 + 1));
 	}
 
 	bool AsyncMqttClient::unsubscribe(const lwiot::String &topic)
@@ -147,17 +337,339 @@ namespace lwiot
 		if(!lock.locked())
 			return false;
 
+		UniqueLock<SharedLock> guard(this->_handler_lock);
+
+		this->_handlers.remove(TopicTrie<TopicHandler>::unshare(topic));
+		guard.unlock();
+
 		return MqttClient::unsubscribe(topic);
 	}
 
 	bool AsyncMqttClient::publish(const lwiot::String &topic, const lwiot::ByteBuffer &data, bool retained)
+	{
+		return this->publish(topic, data, retained, UserProperties());
+	}
+
+	bool AsyncMqttClient::publish(const lwiot::String &topic, const lwiot::ByteBuffer &data, bool retained,
+	                              const UserProperties& properties)
+	{
+		if(this->_log != nullptr && (!this->_online.load() || !this->_log->empty()))
+			return this->_log->append(topic, data, retained);
+
+		auto entry = this->prepare(topic, data, retained, properties);
+
+		if(entry == nullptr || !this->enqueue(entry)) {
+			delete entry;
+			return false;
+		}
+
+		this->schedule();
+		return true;
+	}
+
+	AsyncMqttClient::Outbound* AsyncMqttClient::prepare(const lwiot::String &topic, const lwiot::ByteBuffer &data,
+	                                                    bool retained, const UserProperties &properties)
+	{
+		auto qos = this->qos(topic);
+		uint16_t id = 0;
+
+		/* Packet identifiers are never zero. */
+		while(qos != QOS0 && id == 0)
+			id = this->_msgid.fetch_add(1) + 1;
+
+		auto entry = new Outbound;
+
+		entry->id = id;
+
+		if(!this->encode(entry->packet, topic, data, retained, qos, id, properties)) {
+			delete entry;
+			return nullptr;
+		}
+
+		return entry;
+	}
+
+	bool AsyncMqttClient::publish(const lwiot::String &topic, Stream &source, size_t length, bool retained)
+	{
+		UniqueTryLock<Lock> lock(this->_lock, this->_tmo);
+
+		if(!lock.locked())
+			return false;
+
+		this->drain();
+		return MqttClient::publish(topic, source, length, retained);
+	}
+
+	bool AsyncMqttClient::publishJson(const lwiot::String &topic, const JsonVariant &json, bool retained)
 	{
 		UniqueTryLock<Lock> lock(this->_lock, this->_tmo);
 
 		if(!lock.locked())
 			return false;
 
-		return MqttClient::publish(topic, data, retained);
+		this->drain();
+		return MqttClient::publishJson(topic, json, retained);
+	}
+
+	bool AsyncMqttClient::enqueue(Outbound* entry)
+	{
+		auto start = lwiot_tick_ms();
+
+		while(!this->_queue.push(entry)) {
+			if(this->_policy.load() == static_cast<int>(OverflowPolicy::DropOldest)) {
+				auto oldest = this->_queue.pop();
+
+				if(oldest != nullptr) {
+					this->_dropped.fetch_add(1);
+					delete oldest;
+				}
+
+				continue;
+			}
+
+			time_t elapsed = lwiot_tick_ms() - start;
+
+			if(elapsed >= this->_tmo)
+				return false;
+
+			this->_space.wait(static_cast<int>(this->_tmo - elapsed));
+		}
+
+		return true;
+	}
+
+	void AsyncMqttClient::schedule()
+	{
+		uint8_t posted = 0;
+
+		if(!this->_flush_posted.compare_exchange_strong(posted, 1))
+			return;
+
+		this->_flushes.fetch_add(1);
+
+		if(!this->_executor.post([this]() { this->flush(); })) {
+			this->_flushes.fetch_sub(1);
+			this->_flush_posted.store(0);
+		}
+	}
+
+	void AsyncMqttClient::flush()
+	{
+		ScopedLock lock(this->_lock);
+
+		/* Cleared first: anything queued from here on needs another flush. */
+		this->_flush_posted.store(0);
+
+		if(this->_running)
+			this->drain();
+
+		if(this->_flushes.fetch_sub(1) == 1)
+			this->_idle.signal();
+	}
+
+	/*
+	 * Write the queued packets, several at a time. QoS 1 and 2 packets move to the in-flight
+	 * table until the broker acknowledges them; when the window is full, the packet waits in
+	 * _stalled.
+	 */
+	void AsyncMqttClient::drain()
+	{
+		Outbound* batch[CONFIG_MQTT_COALESCE];
+
+		while(MqttClient::connected()) {
+			BufferChain chain;
+			size_t count = 0;
+
+			while(count < CONFIG_MQTT_COALESCE) {
+				auto entry = this->_stalled;
+
+				if(entry != nullptr) {
+					this->_stalled = nullptr;
+				} else if((entry = this->_queue.pop()) != nullptr) {
+					this->_space.signal();
+				} else {
+					break;
+				}
+
+				if(entry->id != 0) {
+					Outbound** slot = nullptr;
+					size_t used = 0;
+
+					for(auto& inflight : this->_inflight) {
+						if(inflight != nullptr)
+							used++;
+						else if(slot == nullptr)
+							slot = &inflight;
+					}
+
+					/* The broker's receive maximum limits the window as well. */
+					if(slot == nullptr || used >= this->_window || used >= MqttClient::receiveMaximum()) {
+						this->_stalled = entry;
+						break;
+					}
+
+					*slot = entry;
+					entry->sent = lwiot_tick_ms();
+
+					if(this->_store != nullptr)
+						this->_store->save(entry->id, entry->packet.data(), entry->packet.index());
+				}
+
+				if(entry->id == 0)
+					this->alias(entry->packet);
+
+				chain.append(entry->packet.data(), entry->packet.index());
+				batch[count++] = entry;
+			}
+
+			if(count == 0)
+				return;
+
+			if(!this->send(chain))
+				this->_client->close();
+
+			for(size_t idx = 0; idx < count; idx++) {
+				if(batch[idx]->id == 0)
+					delete batch[idx];
+			}
+
+			if(this->_stalled != nullptr)
+				return;
+		}
+	}
+
+	/* Send every unacknowledged packet again. PUBLISH packets get the DUP flag. */
+	void AsyncMqttClient::resend()
+	{
+		BufferChain chain;
+		auto now = lwiot_tick_ms();
+
+		for(auto entry : this->_inflight) {
+			if(entry == nullptr)
+				continue;
+
+			if((entry->packet[0] & 0xF0) == (MQTTPUBLISH))
+				entry->packet[0] |= 0x08;
+
+			entry->sent = now;
+			chain.append(entry->packet.data(), entry->packet.index());
+		}
+
+		if(!chain.empty() && !this->send(chain))
+			this->_client->close();
+	}
+
+	/* Send the packets that were not acknowledged within the retry interval again. */
+	void AsyncMqttClient::retry()
+	{
+		BufferChain chain;
+		auto now = lwiot_tick_ms();
+
+		if(this->_retry == 0 || !MqttClient::connected())
+			return;
+
+		for(auto entry : this->_inflight) {
+			if(entry == nullptr || now - entry->sent < this->_retry)
+				continue;
+
+			if((entry->packet[0] & 0xF0) == (MQTTPUBLISH))
+				entry->packet[0] |= 0x08;
+
+			entry->sent = now;
+			chain.append(entry->packet.data(), entry->packet.index());
+		}
+
+		if(!chain.empty() && !this->send(chain))
+			this->_client->close();
+	}
+
+	/*
+	 * Move a batch of messages from the offline log to the queue, once per replay interval. A
+	 * message stays in the log until there is room for it in the queue.
+	 */
+	void AsyncMqttClient::replay()
+	{
+		auto now = lwiot_tick_ms();
+
+		if(this->_log == nullptr || !MqttClient::connected() || now - this->_replayed < this->_replay_interval)
+			return;
+
+		this->_replayed = now;
+
+		auto count = this->_log->replay(this->_replay_batch, [this](const String& topic, const ByteBuffer& data, bool retained) {
+			auto entry = this->prepare(topic, data, retained, UserProperties());
+
+			/* A message that cannot be encoded would block the log forever. */
+			if(entry == nullptr)
+				return true;
+
+			if(!this->_queue.push(entry)) {
+				delete entry;
+				return false;
+			}
+
+			return true;
+		});
+
+		if(count > 0)
+			this->drain();
+	}
+
+	void AsyncMqttClient::transmit(Outbound *entry)
+	{
+		BufferChain chain;
+
+		chain.append(entry->packet.data(), entry->packet.index());
+		entry->sent = lwiot_tick_ms();
+
+		if(!this->send(chain))
+			this->_client->close();
+	}
+
+	void AsyncMqttClient::complete(Outbound*& entry)
+	{
+		if(this->_store != nullptr)
+			this->_store->remove(entry->id);
+
+		delete entry;
+		entry = nullptr;
+
+		if(this->_stalled != nullptr)
+			this->schedule();
+	}
+
+	/*
+	 * QoS 1: PUBLISH, PUBACK. QoS 2: PUBLISH, PUBREC, then PUBREL, PUBCOMP. After the PUBREC the
+	 * PUBREL takes the place of the PUBLISH, so that a reconnect or retry sends the right packet.
+	 */
+	void AsyncMqttClient::acknowledged(Ack ack, uint16_t id)
+	{
+		for(auto& entry : this->_inflight) {
+			if(entry == nullptr || entry->id != id)
+				continue;
+
+			auto type = entry->packet[0] & 0xF0;
+			auto qos = entry->packet[0] & 0x06;
+
+			if(ack == Ack::PubAck && type == (MQTTPUBLISH) && qos == MQTTQOS1) {
+				this->complete(entry);
+			} else if(ack == Ack::PubRec && ((type == (MQTTPUBLISH) && qos == MQTTQOS2) || type == (MQTTPUBREL))) {
+				entry->packet.setIndex(0);
+				entry->packet.writeUnchecked((MQTTPUBREL) | 0x02);
+				entry->packet.writeUnchecked(2);
+				entry->packet.writeUnchecked(static_cast<uint8_t>(id >> 8));
+				entry->packet.writeUnchecked(static_cast<uint8_t>(id & 0xFF));
+
+				if(this->_store != nullptr)
+					this->_store->save(id, entry->packet.data(), entry->packet.index());
+
+				this->transmit(entry);
+			} else if((ack == Ack::PubComp && type == (MQTTPUBREL)) || ack == Ack::Rejected) {
+				this->complete(entry);
+			}
+
+			return;
+		}
 	}
 
 	bool AsyncMqttClient::connect(const lwiot::String &id, const lwiot::String &user, const lwiot::String &pass,
@@ -177,28 +689,64 @@ namespace lwiot
 		this->_will_retain = willRetain;
 		this->_will_topic = willTopic;
 		this->_clean = cleanSession;
+		this->_backoff = this->_backoff_min;
+		this->_next_attempt = 0;
+		this->_wakeup.signal();
+
+		if(!MqttClient::connect(id, user, pass, willTopic, willQos, willRetain, willMessage, cleanSession))
+			return false;
+
+		this->_online.store(true);
+		this->resend();
+		this->drain();
 
-		return MqttClient::connect(id, user, pass, willTopic, willQos, willRetain, willMessage, cleanSession);
+		return true;
 	}
 
 	bool AsyncMqttClient::subscribe(const String &topic, AsyncMqttClient::AsyncHandler handler, QoS qos)
+	{
+		TopicHandler wrapper;
+
+		if(handler) {
+			wrapper = [handler](const String&, const SharedByteBuffer& data) {
+				handler(data);
+			};
+		}
+
+		return this->route(topic, stl::move(wrapper), qos);
+	}
+
+	bool AsyncMqttClient::route(const String &topic, AsyncMqttClient::TopicHandler handler, QoS qos)
 	{
 		UniqueTryLock<Lock> lock(this->_lock, this->_tmo);
 
 		if(!lock.locked())
 			return false;
 
-		this->_handlers.add(topic, stl::move(handler));
+		UniqueLock<SharedLock> guard(this->_handler_lock);
+
+		if(!this->_handlers.add(TopicTrie<TopicHandler>::unshare(topic), handler))
+			return false;
+
+		guard.unlock();
+
 		return MqttClient::subscribe(topic, qos);
 	}
 
-	void AsyncMqttClient::invoke(const lwiot::String &topic, const lwiot::ByteBuffer &data) const
+	void AsyncMqttClient::invoke(const lwiot::String &topic, const lwiot::SharedByteBuffer &data) const
 	{
-		const AsyncHandler& handler = this->_handlers[topic];
+		ScopedSharedLock guard(this->_handler_lock);
+		stl::SmallVector<TopicHandler, 4> handlers;
 
-		if(!handler)
-			return;
+		this->_handlers.match(topic, [&handlers](const TopicHandler& handler) {
+			if(handler)
+				handlers.pushback(handler);
+		});
+
+		/* Handlers may (un)subscribe, so they cannot run with the trie locked. */
+		guard.unlock();
 
-		handler(data);
+		for(auto& handler : handlers)
+			handler(topic, data);
 	}
 }
@@ -0,0 +1,68 @@
+/*
+ * Periodic MQTT metrics snapshots.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/util/cbor.h>
+#include <lwiot/util/metrics.h>
+#include <lwiot/network/mqttclient.h>
+#include <lwiot/network/metricspublisher.h>
+
+namespace lwiot
+{
+	MetricsPublisher::MetricsPublisher(MqttClient &client, const String &topic, Format format, time_t interval) :
+		MetricsPublisher(client, topic, metrics::Registry::global(), format, interval)
+	{
+	}
+
+	MetricsPublisher::MetricsPublisher(MqttClient &client, const String &topic, metrics::Registry &registry,
+	                                   Format format, time_t interval) : _client(client), _topic(topic),
+		_registry(registry), _format(format), _interval(interval), _last(0), _published(false)
+	{
+	}
+
+	bool MetricsPublisher::poll()
+	{
+		auto now = lwiot_tick_ms();
+
+		if(this->_published && now - this->_last < this->_interval)
+			return true;
+
+		/* Retry on the next interval when the client is offline, rather than on every poll. */
+		this->_last = now;
+		this->_published = true;
+
+		return this->publish();
+	}
+
+	bool MetricsPublisher::publish()
+	{
+		ByteBuffer payload;
+
+		this->encode(payload);
+		return this->_client.publish(this->_topic, payload, false);
+	}
+
+	void MetricsPublisher::encode(ByteBuffer &output) const
+	{
+		if(this->_format == Format::Cbor) {
+			CborWriter writer(output);
+
+			this->_registry.writeCbor(writer);
+			return;
+		}
+
+		this->_registry.writeJson([&output](const char *data, size_t length) {
+			output.write(data, length);
+			return true;
+		});
+	}
+}
@@ -26,6 +26,12 @@
 #define MQTTQOS1        (1 << 1)
 #define MQTTQOS2        (2 << 1)
 
+/* MQTT 5 properties */
+#define MQTT_PROP_RECEIVE_MAXIMUM     0x21
+#define MQTT_PROP_TOPIC_ALIAS_MAXIMUM 0x22
+#define MQTT_PROP_TOPIC_ALIAS         0x23
+#define MQTT_PROP_USER_PROPERTY       0x26
+
 /* MQTT state machine */
 #define MQTT_CONNECTION_TIMEOUT     -4
 #define MQTT_CONNECTION_LOST        -3
@@ -40,6 +46,7 @@
 
 #define MQTT_VERSION_3_1      3
 #define MQTT_VERSION_3_1_1    4
+#define MQTT_VERSION_5        5
 
 #ifndef MQTT_VERSION
 #define MQTT_VERSION MQTT_VERSION_3_1_1
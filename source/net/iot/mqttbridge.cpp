@@ -0,0 +1,276 @@
+/*
+ * MQTT bridge that multiplexes many devices over one client session.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/network/mqttbridge.h>
+
+#include <lwiot/stl/move.h>
+
+namespace lwiot
+{
+	MqttBridge::MqttBridge(AsyncMqttClient& client, const String& prefix) : _client(client), _prefix(prefix)
+	{
+	}
+
+	MqttBridge::~MqttBridge()
+	{
+		ScopedLock guard(this->_subscriptions);
+
+		/* The client would otherwise route messages to a bridge that no longer exists. */
+		for(auto& entry : this->_filters)
+			this->_client.unsubscribe(this->topic("+", entry.key));
+	}
+
+	bool MqttBridge::valid(const String& device)
+	{
+		return device.length() != 0 && device.indexOf('/') < 0 && device.indexOf('+') < 0 && device.indexOf('#') < 0;
+	}
+
+	String MqttBridge::topic(const String& device, const String& filter) const
+	{
+		String topic(this->_prefix);
+
+		topic += "/";
+		topic += device;
+		topic += "/";
+		topic += filter;
+
+		return topic;
+	}
+
+	bool MqttBridge::add(const String& device, const Handler& handler)
+	{
+		if(!valid(device))
+			return false;
+
+		ScopedLock guard(this->_subscriptions);
+		ScopedLock lock(this->_lock);
+
+		if(this->_devices.contains(device))
+			return false;
+
+		Device entry;
+
+		entry.handler = handler;
+		this->_devices.add(device, stl::move(entry));
+
+		return true;
+	}
+
+	bool MqttBridge::remove(const String& device)
+	{
+		ScopedLock guard(this->_subscriptions);
+		stl::Vector<String> filters;
+
+		this->_lock.lock();
+		auto iter = this->_devices.find(device);
+
+		if(iter == this->_devices.end()) {
+			this->_lock.unlock();
+			return false;
+		}
+
+		filters = stl::move(iter->value.filters);
+		this->_devices.remove(device);
+		this->_lock.unlock();
+
+		for(size_t idx = 0; idx < filters.size(); idx++)
+			this->release(filters[idx]);
+
+		return true;
+	}
+
+	bool MqttBridge::subscribe(const String& device, const String& filter, MqttClient::QoS qos)
+	{
+		ScopedLock guard(this->_subscriptions);
+		bool shared, rv = true;
+
+		if(filter.length() == 0)
+			return false;
+
+		this->_lock.lock();
+		auto iter = this->_devices.find(device);
+
+		if(iter == this->_devices.end()) {
+			this->_lock.unlock();
+			return false;
+		}
+
+		auto& filters = iter->value.filters;
+
+		for(size_t idx = 0; idx < filters.size(); idx++) {
+			if(filters[idx] == filter) {
+				this->_lock.unlock();
+				return true;
+			}
+		}
+
+		shared = this->_filters.contains(filter);
+		this->_lock.unlock();
+
+		/*
+		 * The client lock is held while messages are dispatched, so it is never taken with ours. A
+		 * subscription that fails, for example because the client is offline, is still recorded:
+		 * resubscribe() makes it once the connection is restored.
+		 */
+		if(!shared)
+			rv = this->route(filter, qos);
+
+		ScopedLock lock(this->_lock);
+
+		if(shared) {
+			this->_filters[filter].references++;
+		} else {
+			Filter entry;
+
+			entry.references = 1;
+			entry.qos = qos;
+			this->_filters.add(filter, entry);
+		}
+
+		this->_devices[device].filters.pushback(filter);
+		return rv;
+	}
+
+	bool MqttBridge::unsubscribe(const String& device, const String& filter)
+	{
+		ScopedLock guard(this->_subscriptions);
+
+		this->_lock.lock();
+		auto iter = this->_devices.find(device);
+
+		if(iter == this->_devices.end()) {
+			this->_lock.unlock();
+			return false;
+		}
+
+		auto& filters = iter->value.filters;
+
+		for(size_t idx = 0; idx < filters.size(); idx++) {
+			if(filters[idx] == filter) {
+				filters.erase(idx);
+				this->_lock.unlock();
+				this->release(filter);
+
+				return true;
+			}
+		}
+
+		this->_lock.unlock();
+		return false;
+	}
+
+	bool MqttBridge::publish(const String& device, const String& topic, const ByteBuffer& data, bool retained)
+	{
+		if(!this->contains(device))
+			return false;
+
+		return this->_client.publish(this->topic(device, topic), data, retained);
+	}
+
+	bool MqttBridge::resubscribe()
+	{
+		ScopedLock guard(this->_subscriptions);
+		stl::Vector<String> filters;
+		stl::Vector<MqttClient::QoS> levels;
+		bool rv = true;
+
+		this->_lock.lock();
+
+		for(auto& entry : this->_filters) {
+			filters.pushback(entry.key);
+			levels.pushback(entry.value.qos);
+		}
+
+		this->_lock.unlock();
+
+		for(size_t idx = 0; idx < filters.size(); idx++)
+			rv = this->route(filters[idx], levels[idx]) && rv;
+
+		return rv;
+	}
+
+	bool MqttBridge::contains(const String& device) const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_devices.contains(device);
+	}
+
+	size_t MqttBridge::devices() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_devices.size();
+	}
+
+	size_t MqttBridge::subscriptions() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_filters.size();
+	}
+
+	bool MqttBridge::route(const String& filter, MqttClient::QoS qos)
+	{
+		return this->_client.route(this->topic("+", filter), [this, filter](const String& topic, const SharedByteBuffer& data) {
+			this->dispatch(filter, topic, data);
+		}, qos);
+	}
+
+	void MqttBridge::release(const String& filter)
+	{
+		this->_lock.lock();
+		auto iter = this->_filters.find(filter);
+
+		if(iter == this->_filters.end() || --iter->value.references != 0) {
+			this->_lock.unlock();
+			return;
+		}
+
+		this->_filters.remove(filter);
+		this->_lock.unlock();
+
+		if(!this->_client.unsubscribe(this->topic("+", filter))) {
+			print_dbg("MQTT bridge: unable to unsubscribe from %s\n", filter.c_str());
+		}
+	}
+
+	void MqttBridge::dispatch(const String& filter, const String& topic, const SharedByteBuffer& data)
+	{
+		auto offset = this->_prefix.length() + 1;
+		auto end = topic.indexOf('/', offset);
+		Handler handler;
+
+		if(end < 0)
+			return;
+
+		auto device = topic.substring(offset, static_cast<unsigned int>(end));
+
+		this->_lock.lock();
+		auto iter = this->_devices.find(device);
+
+		if(iter != this->_devices.end()) {
+			auto& filters = iter->value.filters;
+
+			for(size_t idx = 0; idx < filters.size(); idx++) {
+				if(filters[idx] == filter) {
+					handler = iter->value.handler;
+					break;
+				}
+			}
+		}
+
+		this->_lock.unlock();
+
+		if(handler)
+			handler(topic.substring(static_cast<unsigned int>(end) + 1), data);
+	}
+}
@@ -10,12 +10,14 @@
 #include <lwiot.h>
 
 #include <lwiot/stream.h>
+#include <lwiot/bufferchain.h>
 
 #include <lwiot/network/ipaddress.h>
 #include <lwiot/network/mqttclient.h>
 
 #include <lwiot/stl/referencewrapper.h>
 #include <lwiot/kernel/thread.h>
+#include <lwiot/util/trace.h>
 
 #include "mqtt.h"
 
@@ -51,7 +53,141 @@
 
 namespace lwiot
 {
-	MqttClient::MqttClient() : _stream(nullptr), _state(MQTT_DISCONNECTED), _buffer(MQTT_MAX_PACKET_SIZE, true)
+	/* Write \p value as a variable byte integer. */
+	static size_t varint(uint8_t *out, size_t value)
+	{
+		size_t pos = 0;
+
+		do {
+			uint8_t digit = value % 128;
+
+			value /= 128;
+			out[pos++] = value > 0 ? digit | 0x80 : digit;
+		} while(value > 0);
+
+		return pos;
+	}
+
+	static size_t varintSize(size_t value)
+	{
+		size_t size = 1;
+
+		for(; value >= 128; value /= 128)
+			size++;
+
+		return size;
+	}
+
+	/* Decode a variable byte integer. Returns the number of bytes used, or 0 if it is malformed. */
+	static size_t decode(const uint8_t *data, size_t length, size_t& value)
+	{
+		size_t multiplier = 1;
+
+		value = 0;
+
+		for(size_t idx = 0; idx < length && idx < 4; idx++) {
+			value += (data[idx] & 0x7F) * multiplier;
+			multiplier *= 128;
+
+			if((data[idx] & 0x80) == 0)
+				return idx + 1;
+		}
+
+		return 0;
+	}
+
+	/* Size of the value of property \p id, or 0 if it does not fit in \p avail bytes. */
+	static size_t propertySize(uint8_t id, const uint8_t *value, size_t avail)
+	{
+		size_t size;
+
+		switch(id) {
+		case 0x01: case 0x17: case 0x19: case 0x24: case 0x25: case 0x28: case 0x29: case 0x2A:
+			size = 1;
+			break;
+
+		case 0x13: case MQTT_PROP_RECEIVE_MAXIMUM: case MQTT_PROP_TOPIC_ALIAS_MAXIMUM: case MQTT_PROP_TOPIC_ALIAS:
+			size = 2;
+			break;
+
+		case 0x02: case 0x11: case 0x18: case 0x27:
+			size = 4;
+			break;
+
+		case 0x0B: {
+			size_t identifier;
+
+			size = decode(value, avail, identifier);
+			break;
+		}
+
+		case 0x03: case 0x08: case 0x09: case 0x12: case 0x15: case 0x16: case 0x1A: case 0x1C: case 0x1F:
+			if(avail < 2)
+				return 0;
+
+			size = 2 + ((value[0] << 8) | value[1]);
+			break;
+
+		case MQTT_PROP_USER_PROPERTY:
+			if(avail < 2)
+				return 0;
+
+			size = 2 + ((value[0] << 8) | value[1]);
+
+			if(avail < size + 2)
+				return 0;
+
+			size += 2 + ((value[size] << 8) | value[size + 1]);
+			break;
+
+		default:
+			return 0;
+		}
+
+		return size <= avail ? size : 0;
+	}
+
+	/* Size of the properties of a PUBLISH, without the property length. */
+	static size_t propertiesSize(const MqttClient::UserProperties& properties, uint16_t alias)
+	{
+		size_t size = alias != 0 ? 3 : 0;
+
+		for(auto& property : properties)
+			size += 5 + property.first.length() + property.second.length();
+
+		return size;
+	}
+
+	static size_t writeString(uint8_t *out, const String& str)
+	{
+		out[0] = str.length() >> 8;
+		out[1] = str.length() & 0xFF;
+		memcpy(out + 2, str.c_str(), str.length());
+
+		return 2 + str.length();
+	}
+
+	static size_t writeProperties(uint8_t *out, const MqttClient::UserProperties& properties, uint16_t alias)
+	{
+		auto pos = varint(out, propertiesSize(properties, alias));
+
+		if(alias != 0) {
+			out[pos++] = MQTT_PROP_TOPIC_ALIAS;
+			out[pos++] = alias >> 8;
+			out[pos++] = alias & 0xFF;
+		}
+
+		for(auto& property : properties) {
+			out[pos++] = MQTT_PROP_USER_PROPERTY;
+			pos += writeString(out + pos, property.first);
+			pos += writeString(out + pos, property.second);
+		}
+
+		return pos;
+	}
+
+	MqttClient::MqttClient() : _stream(nullptr), _state(MQTT_DISCONNECTED), _buffer(MQTT_MAX_PACKET_SIZE, true),
+		_incoming(), _version(Version::V311), _reason(0), _receive_max(UINT16_MAX), _alias_max(0)
 	{
 	}
 
@@ -68,6 +204,9 @@ namespace lwiot
 
 		this->_io = client;
 		this->_io->setTimeout(MQTT_TIMEOUT);
+
+		/* MQTT packets are small and latency bound, don't let Nagle hold them back. */
+		this->_io->setOption(SOCKET_OPT_NODELAY, 1);
 	}
 
 	bool MqttClient::reconnect()
@@ -90,41 +229,328 @@ namespace lwiot
 
 	bool MqttClient::publish(const lwiot::String &topic, const lwiot::ByteBuffer &data, bool retained)
 	{
+		return this->publish(topic, data, retained, UserProperties());
+	}
+
+	bool MqttClient::publish(const lwiot::String &topic, const lwiot::ByteBuffer &data, bool retained,
+	                         const UserProperties& properties)
+	{
+		TRACE_SPAN("mqtt-publish");
 		auto plength = data.count();
 		auto rv = false;
 		uint8_t header = MQTTPUBLISH;
 
 		if(this->isConnected()) {
-			if(MQTT_MAX_PACKET_SIZE < MQTT_MAX_HEADER_SIZE + 2 + topic.length() + plength)
+			auto v5 = this->_version == Version::V5;
+			size_t psize = v5 ? propertiesSize(properties, 1) : 0;
+
+			/* Sized as if a new alias is assigned, which takes the most space. */
+			if(v5)
+				psize += varintSize(psize);
+
+			if(MQTT_MAX_PACKET_SIZE < MQTT_MAX_HEADER_SIZE + 2 + topic.length() + psize + plength)
 				return false;
 
 			this->_buffer.reset();
 
 			// Leave room in the buffer for header and variable length field
 			uint16_t length = MQTT_MAX_HEADER_SIZE;
-			length = this->write(topic, length);
+			bool known = false;
+			uint16_t alias = v5 ? this->alias(topic, known) : 0;
 
-			for(auto i = 0; i < plength; i++) {
-				this->_buffer[length++] = data[i];
+			if(known) {
+				this->_buffer[length++] = 0;
+				this->_buffer[length++] = 0;
+			} else {
+				length = this->write(topic, length);
 			}
 
+			if(v5)
+				length += writeProperties(this->_buffer.data() + length, properties, alias);
+
 			if(retained)
 				header |= 1;
 
-			rv = this->write(header, length - MQTT_MAX_HEADER_SIZE);
+			/* The payload is sent straight from `data', only the header is assembled in the buffer. */
+			RawBuffer payload(data.data(), plength);
+			rv = this->write(header, length - MQTT_MAX_HEADER_SIZE, payload);
 		}
 
 		return rv;
 	}
 
+	bool MqttClient::beginPublish(const lwiot::String &topic, size_t length, bool retained)
+	{
+		uint8_t header = MQTTPUBLISH;
+
+		if(!this->isConnected())
+			return false;
+
+		/* The topic still has to fit in the buffer, the payload does not. */
+		if(MQTT_MAX_PACKET_SIZE < MQTT_MAX_HEADER_SIZE + 3 + topic.length() ||
+		   length > MQTT_MAX_REMAINING_LENGTH - 3 - topic.length())
+			return false;
+
+		this->_buffer.reset();
+
+		uint16_t pos = this->write(topic, MQTT_MAX_HEADER_SIZE);
+
+		if(this->_version == Version::V5)
+			this->_buffer[pos++] = 0;
+
+		size_t vlength = pos - MQTT_MAX_HEADER_SIZE;
+
+		if(retained)
+			header |= 1;
+
+		auto hlen = this->build(header, vlength + length);
+		auto rv = this->_io->write(this->_buffer.data() + MQTT_MAX_HEADER_SIZE - hlen, hlen + vlength);
+
+		return rv == static_cast<ssize_t>(hlen + vlength);
+	}
+
+	/* A packet that cannot be completed leaves the connection out of sync. */
+	void MqttClient::abortPublish()
+	{
+		this->_state = MQTT_CONNECTION_LOST;
+		this->_io->close();
+	}
+
+	bool MqttClient::publish(const lwiot::String &topic, Stream &source, size_t length, bool retained)
+	{
+		uint8_t chunk[CONFIG_MQTT_CHUNK_SIZE];
+
+		if(!this->beginPublish(topic, length, retained))
+			return false;
+
+		while(length > 0) {
+			auto rv = source.read(chunk, length < sizeof(chunk) ? length : sizeof(chunk));
+
+			if(rv <= 0 || this->_io->write(chunk, rv) != rv) {
+				this->abortPublish();
+				return false;
+			}
+
+			length -= rv;
+		}
+
+		this->_lastOutActivity = lwiot_tick_ms();
+		return true;
+	}
+
+	bool MqttClient::publishJson(const lwiot::String &topic, const JsonVariant &json, bool retained)
+	{
+		if(!this->beginPublish(topic, json.measureLength(), retained))
+			return false;
+
+		json::StreamPrinter printer(this->_io.get());
+		json.printTo(printer);
+
+		if(!printer.flush()) {
+			this->abortPublish();
+			return false;
+		}
+
+		this->_lastOutActivity = lwiot_tick_ms();
+		return true;
+	}
+
+	bool MqttClient::encode(ByteBuffer& packet, const lwiot::String &topic, const lwiot::ByteBuffer &data,
+	                        bool retained, QoS qos, uint16_t id, const UserProperties& properties) const
+	{
+		auto v5 = this->_version == Version::V5;
+		size_t length = 2 + topic.length() + data.count();
+		uint8_t header = MQTTPUBLISH | (qos == QOS0 ? MQTTQOS0 : qos == QOS1 ? MQTTQOS1 : MQTTQOS2);
+
+		if(qos != QOS0)
+			length += 2;
+
+		if(v5) {
+			auto psize = propertiesSize(properties, 0);
+			length += varintSize(psize) + psize;
+		}
+
+		if(MQTT_MAX_PACKET_SIZE < MQTT_MAX_HEADER_SIZE + length)
+			return false;
+
+		if(retained)
+			header |= 1;
+
+		packet.reserveExact(packet.index() + MQTT_MAX_HEADER_SIZE + length);
+		packet.writeUnchecked(header);
+
+		auto remaining = length;
+
+		do {
+			uint8_t digit = remaining % 128;
+
+			remaining /= 128;
+			packet.writeUnchecked(remaining > 0 ? digit | 0x80 : digit);
+		} while(remaining > 0);
+
+		packet.writeUnchecked(static_cast<uint8_t>(topic.length() >> 8));
+		packet.writeUnchecked(static_cast<uint8_t>(topic.length() & 0xFF));
+		packet.writeUnchecked(topic.c_str(), topic.length());
+
+		if(qos != QOS0) {
+			packet.writeUnchecked(static_cast<uint8_t>(id >> 8));
+			packet.writeUnchecked(static_cast<uint8_t>(id & 0xFF));
+		}
+
+		if(v5)
+			packet.setIndex(packet.index() + writeProperties(packet.data() + packet.index(), properties, 0));
+
+		packet.writeUnchecked(data.data(), data.count());
+		return true;
+	}
+
+	void MqttClient::alias(ByteBuffer& packet)
+	{
+		auto data = packet.data();
+		auto size = packet.index();
+		size_t rl, plen;
+
+		if(this->_version != Version::V5 || this->_alias_max == 0 || size < 2)
+			return;
+
+		if((data[0] & 0xF0) != (MQTTPUBLISH) || (data[0] & 0x06) != MQTTQOS0)
+			return;
+
+		auto rlen = decode(data + 1, size - 1, rl);
+
+		if(rlen == 0 || 1 + rlen + rl != size)
+			return;
+
+		auto pos = 1 + rlen;
+		size_t tl = (data[pos] << 8) | data[pos + 1];
+		auto props = pos + 2 + tl;
+
+		if(tl == 0 || props >= size)
+			return;
+
+		auto plenlen = decode(data + props, size - props, plen);
+		bool known;
+
+		if(plenlen == 0)
+			return;
+
+		auto alias = this->alias(StringView(reinterpret_cast<const char *>(data + pos + 2), tl), known);
+
+		if(alias == 0)
+			return;
+
+		/* Header, remaining length, topic or an empty one, property length, alias; then the old properties and payload. */
+		auto tail = props + plenlen;
+		auto tailsize = size - tail;
+		size_t ntl = known ? 0 : tl;
+		auto nplen = plen + 3;
+		auto nrl = 2 + ntl + varintSize(nplen) + 3 + tailsize;
+		auto ntail = 1 + varintSize(nrl) + 2 + ntl + varintSize(nplen) + 3;
+
+		packet.reserveExact(ntail + tailsize);
+		data = packet.data();
+
+		/* When the topic stays, everything only moves up, so the topic is moved after the tail. */
+		memmove(data + ntail, data + tail, tailsize);
+
+		if(!known)
+			memmove(data + 1 + varintSize(nrl) + 2, data + pos + 2, tl);
+
+		pos = 1 + varint(data + 1, nrl);
+		data[pos++] = ntl >> 8;
+		data[pos++] = ntl & 0xFF;
+		pos += ntl;
+		pos += varint(data + pos, nplen);
+		data[pos++] = MQTT_PROP_TOPIC_ALIAS;
+		data[pos++] = alias >> 8;
+		data[pos++] = alias & 0xFF;
+
+		packet.setIndex(ntail + tailsize);
+	}
+
+	/* Alias for \p topic, or 0. \p known tells whether the broker already knows the alias. */
+	uint16_t MqttClient::alias(StringView topic, bool& known)
+	{
+		known = false;
+
+		if(this->_version != Version::V5)
+			return 0;
+
+		for(uint16_t idx = 0; idx < this->_alias_max; idx++) {
+			if(this->_aliases[idx].length() == 0) {
+				this->_aliases[idx] = topic.toString();
+				return idx + 1;
+			}
+
+			if(topic.equals(StringView(this->_aliases[idx]))) {
+				known = true;
+				return idx + 1;
+			}
+		}
+
+		return 0;
+	}
+
+	/*
+	 * Parse the properties at \p data, starting with their length. The receive maximum and topic
+	 * alias maximum of a CONNACK are stored, as are user properties. Returns the number of bytes
+	 * used, or 0 if the properties are malformed.
+	 */
+	size_t MqttClient::parseProperties(const uint8_t *data, size_t length)
+	{
+		size_t size;
+		auto used = decode(data, length, size);
+
+		this->_properties.clear();
+
+		if(used == 0 || used + size > length)
+			return 0;
+
+		for(auto idx = used; idx < used + size; ) {
+			auto id = data[idx++];
+			auto value = data + idx;
+			auto vsize = propertySize(id, value, used + size - idx);
+
+			if(vsize == 0)
+				return 0;
+
+			if(id == MQTT_PROP_RECEIVE_MAXIMUM) {
+				this->_receive_max = (value[0] << 8) | value[1];
+			} else if(id == MQTT_PROP_TOPIC_ALIAS_MAXIMUM) {
+				uint16_t max = (value[0] << 8) | value[1];
+				this->_alias_max = max < CONFIG_MQTT_TOPIC_ALIASES ? max : CONFIG_MQTT_TOPIC_ALIASES;
+			} else if(id == MQTT_PROP_USER_PROPERTY) {
+				size_t nl = (value[0] << 8) | value[1];
+				size_t vl = (value[2 + nl] << 8) | value[3 + nl];
+
+				this->_properties.pushback(stl::Pair<String, String>(
+					String(reinterpret_cast<const char *>(value) + 2, nl),
+					String(reinterpret_cast<const char *>(value) + 4 + nl, vl)));
+			}
+
+			idx += vsize;
+		}
+
+		return used + size;
+	}
+
+	bool MqttClient::send(const BufferChain& chain)
+	{
+		if(!this->isConnected())
+			return false;
+
+		auto rc = this->_io->write(chain);
+
+		this->_lastOutActivity = lwiot_tick_ms();
+		return rc >= 0 && static_cast<size_t>(rc) == chain.length();
+	}
+
 	bool MqttClient::subscribe(const lwiot::String &topic, lwiot::MqttClient::QoS qos)
 	{
 		auto rv = false;
 
-		if(qos > 1)
-
-			if(MQTT_MAX_PACKET_SIZE < 9 + topic.length())
-				return rv;
+		if(qos > QOS2 || MQTT_MAX_PACKET_SIZE < 10 + topic.length())
+			return rv;
 
 		if(this->isConnected()) {
 			this->_buffer.reset();
@@ -137,6 +563,10 @@ namespace lwiot
 
 			this->_buffer[length++] = (this->_nextMsgId >> 8);
 			this->_buffer[length++] = (this->_nextMsgId & 0xFF);
+
+			if(this->_version == Version::V5)
+				this->_buffer[length++] = 0;
+
 			length = this->write(topic, length);
 			this->_buffer[length++] = qos;
 
@@ -150,7 +580,7 @@ namespace lwiot
 	{
 		auto rv = false;
 
-		if(MQTT_MAX_PACKET_SIZE < 9 + topic.length())
+		if(MQTT_MAX_PACKET_SIZE < 10 + topic.length())
 			return rv;
 
 		if(isConnected()) {
@@ -162,6 +592,10 @@ namespace lwiot
 
 			this->_buffer[length++] = (this->_nextMsgId >> 8);
 			this->_buffer[length++] = (this->_nextMsgId & 0xFF);
+
+			if(this->_version == Version::V5)
+				this->_buffer[length++] = 0;
+
 			length = this->write(topic, length);
 			rv = write(MQTTUNSUBSCRIBE | MQTTQOS1, length - MQTT_MAX_HEADER_SIZE);
 		}
@@ -188,29 +622,42 @@ namespace lwiot
 
 	bool MqttClient::write(uint8_t header, size_t length)
 	{
-		uint16_t rc;
-		uint8_t hlen = this->build(header, length);
+		return this->write(header, length, RawBuffer());
+	}
+
+	bool MqttClient::write(uint8_t header, size_t length, const RawBuffer& payload)
+	{
+		uint8_t hlen = this->build(header, length + payload.size());
+		BufferChain chain;
+
+		chain.append(this->_buffer.data() + (MQTT_MAX_HEADER_SIZE - hlen), length + hlen);
+		chain.append(payload);
 
 #ifdef MQTT_MAX_TRANSFER_SIZE
-		uint8_t *writeBuf = this->_buffer.data() + (MQTT_MAX_HEADER_SIZE - hlen);
-		uint16_t bytesRemaining = length + hlen;  //Match the length type
-		uint8_t bytesToWrite;
 		bool result = true;
 
-		while((bytesRemaining > 0) && result) {
-			bytesToWrite = (bytesRemaining > MQTT_MAX_TRANSFER_SIZE) ? MQTT_MAX_TRANSFER_SIZE : bytesRemaining;
-			rc = this->_io->write(writeBuf, bytesToWrite);
-			result = (rc == bytesToWrite);
-			bytesRemaining -= rc;
-			writeBuf += rc;
+		for(const auto& segment : chain) {
+			auto writeBuf = static_cast<const uint8_t*>(segment.buffer());
+			uint16_t bytesRemaining = segment.size();  //Match the length type
+			uint8_t bytesToWrite;
+			uint16_t rc;
+
+			while((bytesRemaining > 0) && result) {
+				bytesToWrite = (bytesRemaining > MQTT_MAX_TRANSFER_SIZE) ? MQTT_MAX_TRANSFER_SIZE : bytesRemaining;
+				rc = this->_io->write(writeBuf, bytesToWrite);
+				result = (rc == bytesToWrite);
+				bytesRemaining -= rc;
+				writeBuf += rc;
+			}
 		}
 
+		this->_lastOutActivity = lwiot_tick_ms();
 		return result;
 #else
-		rc = this->_io->write(this->_buffer.data() + (MQTT_MAX_HEADER_SIZE - hlen), length + hlen);
+		auto rc = this->_io->write(chain);
 		this->_lastOutActivity = lwiot_tick_ms();
 
-		return (rc == hlen + length);
+		return rc >= 0 && static_cast<size_t>(rc) == chain.length();
 #endif
 	}
 
@@ -254,11 +701,12 @@ namespace lwiot
 		uint16_t len = 0;
 		auto buffer = this->_buffer.data();
 		bool isPublish;
-		uint32_t multiplier = 1;
-		uint16_t length = 0;
+		size_t multiplier = 1;
+		size_t length = 0;
 		uint8_t digit = 0;
 		uint16_t skip = 0;
 		uint8_t start = 0;
+		bool oversize = false;
 
 		this->_buffer.reset();
 
@@ -284,6 +732,11 @@ namespace lwiot
 		} while((digit & 128) != 0);
 		*data = len - 1;
 
+		if(isPublish && this->_chunk && length > MQTT_MAX_PACKET_SIZE - len) {
+			this->readChunked(length, *data);
+			return 0;
+		}
+
 		if(isPublish) {
 			// Read in topic length to calculate bytes to skip over for Stream writing
 			if(!this->read(buffer, &len))
@@ -299,7 +752,7 @@ namespace lwiot
 			}
 		}
 
-		for(uint16_t i = start; i < length; i++) {
+		for(size_t i = start; i < length; i++) {
 			if(!this->read(&digit))
 				return 0;
 			if(this->_stream) {
@@ -308,18 +761,109 @@ namespace lwiot
 				}
 			}
 			if(len < MQTT_MAX_PACKET_SIZE) {
-				buffer[len] = digit;
+				buffer[len++] = digit;
+			} else {
+				oversize = true;
 			}
-			len++;
 		}
 
-		if(!this->_stream && len > MQTT_MAX_PACKET_SIZE) {
+		if(!this->_stream && oversize) {
 			len = 0;
 		}
 
 		return len;
 	}
 
+	/*
+	 * Hand the payload of an oversize PUBLISH to the chunk handler as it comes in. The topic is
+	 * read into the buffer first, after which the whole buffer is used for payload chunks.
+	 */
+	void MqttClient::readChunked(size_t length, uint8_t llen)
+	{
+		auto buffer = this->_buffer.data();
+		auto qos = buffer[0] & 0x06;
+		uint16_t pos = llen + 1;
+		uint16_t id = 0;
+
+		if(!this->read(buffer, &pos) || !this->read(buffer, &pos))
+			return;
+
+		size_t tl = (buffer[llen + 1] << 8) + buffer[llen + 2];
+		size_t overhead = 2 + tl + (qos != MQTTQOS0 ? 2 : 0);
+
+		if(pos + tl > MQTT_MAX_PACKET_SIZE || overhead > length) {
+			this->_state = MQTT_DISCONNECTED;
+			this->_io->close();
+			return;
+		}
+
+		for(size_t idx = 0; idx < tl; idx++) {
+			if(!this->read(buffer, &pos))
+				return;
+		}
+
+		String topic(reinterpret_cast<const char *>(buffer) + llen + 3, tl);
+
+		if(qos != MQTTQOS0) {
+			uint8_t msb, lsb;
+
+			if(!this->read(&msb) || !this->read(&lsb))
+				return;
+
+			id = (msb << 8) | lsb;
+		}
+
+		if(this->_version == Version::V5) {
+			size_t plen = 0;
+
+			/* The topic has been copied, so the properties can be read to the start of the buffer. */
+			for(pos = 0; pos == 0 || (buffer[pos - 1] & 0x80) != 0; ) {
+				if(pos == 4 || !this->read(buffer, &pos))
+					return;
+			}
+
+			decode(buffer, pos, plen);
+
+			if(pos + plen > MQTT_MAX_PACKET_SIZE || overhead + pos + plen > length) {
+				this->_state = MQTT_DISCONNECTED;
+				this->_io->close();
+				return;
+			}
+
+			for(size_t idx = 0; idx < plen; idx++) {
+				if(!this->read(buffer, &pos))
+					return;
+			}
+
+			this->parseProperties(buffer, pos);
+			overhead += pos;
+		}
+
+		auto total = length - overhead;
+		auto deliver = qos != MQTTQOS2 || this->receive(id);
+
+		for(size_t offset = 0; offset < total; ) {
+			auto needed = total - offset;
+			auto rv = this->_io->read(buffer, needed < MQTT_MAX_PACKET_SIZE ? needed : MQTT_MAX_PACKET_SIZE);
+
+			if(rv <= 0) {
+				this->_state = MQTT_CONNECTION_LOST;
+				this->_io->close();
+				return;
+			}
+
+			if(deliver)
+				this->_chunk(topic, offset, RawBuffer(buffer, rv), total);
+
+			offset += rv;
+		}
+
+		this->_lastInActivity = lwiot_tick_ms();
+
+		if(qos != MQTTQOS0)
+			this->acknowledge(qos == MQTTQOS1 ? MQTTPUBACK : MQTTPUBREC, id);
+	}
+
 	bool MqttClient::connect(const lwiot::String &id, const lwiot::String &user, const lwiot::String &pass)
 	{
 		return this->connect(id, user, pass, "", QOS0, false, "", true);
@@ -340,14 +884,22 @@ namespace lwiot
 				uint16_t length = MQTT_MAX_HEADER_SIZE;
 				unsigned int j;
 
+				auto v5 = this->_version == Version::V5;
+
 				this->_buffer.reset();
 				this->_nextMsgId = 1;
+				this->_receive_max = UINT16_MAX;
+				this->_alias_max = 0;
+
+				/* Topic aliases only last as long as the connection. */
+				for(auto& alias : this->_aliases)
+					alias = String();
 
 #if MQTT_VERSION == MQTT_VERSION_3_1
 				uint8_t d[9] = {0x00,0x06,'M','Q','I','s','d','p', MQTT_VERSION};
 #define MQTT_HEADER_VERSION_LENGTH 9
 #elif MQTT_VERSION == MQTT_VERSION_3_1_1
-				uint8_t d[7] = {0x00, 0x04, 'M', 'Q', 'T', 'T', MQTT_VERSION};
+				uint8_t d[7] = {0x00, 0x04, 'M', 'Q', 'T', 'T', static_cast<uint8_t>(v5 ? MQTT_VERSION_5 : MQTT_VERSION)};
 #define MQTT_HEADER_VERSION_LENGTH 7
 #endif
 				for(j = 0; j < MQTT_HEADER_VERSION_LENGTH; j++) {
@@ -376,9 +928,20 @@ namespace lwiot
 				this->_buffer[length++] = ((MQTT_KEEPALIVE) >> 8);
 				this->_buffer[length++] = ((MQTT_KEEPALIVE) & 0xFF);
 
+				/* Receive maximum: the number of QoS 2 messages that can be deduplicated at once. */
+				if(v5) {
+					this->_buffer[length++] = 3;
+					this->_buffer[length++] = MQTT_PROP_RECEIVE_MAXIMUM;
+					this->_buffer[length++] = CONFIG_MQTT_MAX_INFLIGHT >> 8;
+					this->_buffer[length++] = CONFIG_MQTT_MAX_INFLIGHT & 0xFF;
+				}
+
 				CHECK_STRING_LENGTH(length, id)
 				length = this->write(id, length);
 				if(willTopic.length() > 0) {
+					if(v5)
+						this->_buffer[length++] = 0;
+
 					CHECK_STRING_LENGTH(length, willTopic)
 					length = this->write(willTopic, length);
 					CHECK_STRING_LENGTH(length, willMessage)
@@ -410,14 +973,19 @@ namespace lwiot
 				uint8_t llen;
 				uint16_t len = this->readPacket(&llen);
 
-				if(len == 4) {
-					if(this->_buffer[3] == 0) {
+				if(len == 4 || (v5 && len > 4)) {
+					this->_reason = this->_buffer[llen + 2];
+
+					if(v5 && this->parseProperties(this->_buffer.data() + llen + 3, len - llen - 3) == 0)
+						this->_reason = 0x81;
+
+					if(this->_reason == 0) {
 						this->_lastInActivity = lwiot_tick_ms();
 						this->_pingOutstanding = false;
 						_state = MQTT_CONNECTED;
 						return true;
 					} else {
-						_state = this->_buffer[3];
+						_state = this->_reason;
 					}
 				}
 
@@ -432,12 +1000,12 @@ namespace lwiot
 		return true;
 	}
 
-	size_t MqttClient::build(uint8_t header, uint16_t length) const
+	size_t MqttClient::build(uint8_t header, size_t length) const
 	{
 		uint8_t lengthbuf[4];
 		uint8_t digit;
 		uint8_t pos = 0, llen = 0;
-		uint16_t l = length;
+		size_t l = length;
 
 		do {
 			digit = l % 128;
@@ -500,27 +1068,35 @@ namespace lwiot
 						this->_buffer[llen + 2 + tl] = 0;
 						char *topic = (char *) this->_buffer.data() + llen + 2;
 
-						if((this->_buffer[0] & 0x06) == MQTTQOS1) {
-							msgId = (this->_buffer[llen + 3 + tl] << 8) + this->_buffer[llen + 3 + tl + 1];
-							payload = this->_buffer.data() + llen + 3 + tl + 2;
-							ByteBuffer buf(len - llen - 3 - tl - 2);
-							buf.write(payload, len - llen - 3 - tl - 2);
+						auto qos = this->_buffer[0] & 0x06;
+						size_t offset = llen + 3 + tl;
 
-							this->_cb(topic, buf);
+						if(qos == MQTTQOS1 || qos == MQTTQOS2) {
+							msgId = (this->_buffer[offset] << 8) + this->_buffer[offset + 1];
+							offset += 2;
+						}
 
-							this->_buffer[0] = MQTTPUBACK;
-							this->_buffer[1] = 2;
-							this->_buffer[2] = (msgId >> 8);
-							this->_buffer[3] = (msgId & 0xFF);
-							this->_io->write(this->_buffer.data(), 4);
-							this->_lastOutActivity = t;
-
-						} else {
-							payload = this->_buffer.data() + llen + 3 + tl;
-							ByteBuffer buf(len - llen - 3 - tl);
-							buf.write(payload, len - llen - 3 - tl);
-							this->_cb(topic, buf);
+						if(this->_version == Version::V5) {
+							auto used = offset < len ? this->parseProperties(this->_buffer.data() + offset, len - offset) : 0;
+
+							if(used == 0) {
+								this->_state = MQTT_DISCONNECTED;
+								this->_io->close();
+								return false;
+							}
+
+							offset += used;
 						}
+
+						payload = this->_buffer.data() + offset;
+						SharedByteBuffer buf(payload, len - offset);
+
+						/* A QoS 2 message is delivered once, even if the broker sends it again before PUBREL. */
+						if(qos != MQTTQOS2 || this->receive(msgId))
+							this->_cb(topic, buf);
+
+						if(qos == MQTTQOS1 || qos == MQTTQOS2)
+							this->acknowledge(qos == MQTTQOS1 ? MQTTPUBACK : MQTTPUBREC, msgId);
 					}
 				} else if(type == MQTTPINGREQ) {
 					this->_buffer[0] = MQTTPINGRESP;
@@ -528,6 +1104,38 @@ namespace lwiot
 					this->_io->write(this->_buffer.data(), 2);
 				} else if(type == MQTTPINGRESP) {
 					this->_pingOutstanding = false;
+				} else if(type == MQTTPUBACK || type == MQTTPUBREC || type == MQTTPUBCOMP) {
+					msgId = (this->_buffer[llen + 1] << 8) + this->_buffer[llen + 2];
+					this->_reason = len > llen + 3 ? this->_buffer[llen + 3] : 0;
+
+					auto ack = type == MQTTPUBACK ? Ack::PubAck : type == MQTTPUBREC ? Ack::PubRec : Ack::PubComp;
+
+					/* A PUBREC with an error ends the exchange, no PUBREL follows. */
+					if(type == MQTTPUBREC && this->_reason >= 0x80)
+						ack = Ack::Rejected;
+
+					this->acknowledged(ack, msgId);
+				} else if(type == MQTTSUBACK) {
+					size_t offset = llen + 3;
+
+					if(this->_version == Version::V5 && offset < len) {
+						auto used = this->parseProperties(this->_buffer.data() + offset, len - offset);
+						offset = used != 0 ? offset + used : len;
+					}
+
+					if(offset < len)
+						this->_reason = this->_buffer[offset];
+				} else if(type == MQTTDISCONNECT) {
+					/* Only MQTT 5 brokers disconnect a client, with a reason code. */
+					this->_reason = len > llen + 1 ? this->_buffer[llen + 1] : 0;
+					this->_state = MQTT_DISCONNECTED;
+					this->_io->close();
+
+					return false;
+				} else if(type == MQTTPUBREL) {
+					msgId = (this->_buffer[llen + 1] << 8) + this->_buffer[llen + 2];
+					this->release(msgId);
+					this->acknowledge(MQTTPUBCOMP, msgId);
 				}
 			} else if(!this->isConnected()) {
 				return false;
@@ -537,6 +1145,44 @@ namespace lwiot
 		return true;
 	}
 
+	void MqttClient::acknowledge(uint8_t type, uint16_t id)
+	{
+		uint8_t packet[] = { type, 2, static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id & 0xFF) };
+
+		/* PUBREL has the reserved flags set to 0b0010. */
+		if(type == MQTTPUBREL)
+			packet[0] |= 0x02;
+
+		this->_io->write(packet, sizeof(packet));
+		this->_lastOutActivity = lwiot_tick_ms();
+	}
+
+	bool MqttClient::receive(uint16_t id)
+	{
+		uint16_t *slot = nullptr;
+
+		for(auto& entry : this->_incoming) {
+			if(entry == id)
+				return false;
+
+			if(entry == 0 && slot == nullptr)
+				slot = &entry;
+		}
+
+		if(slot != nullptr)
+			*slot = id;
+
+		return true;
+	}
+
+	void MqttClient::release(uint16_t id)
+	{
+		for(auto& entry : this->_incoming) {
+			if(entry == id)
+				entry = 0;
+		}
+	}
+
 	void MqttClient::disconnect()
 	{
 		uint8_t buf[] = {MQTTDISCONNECT, 0};
@@ -0,0 +1,446 @@
+/*
+ * Store-and-forward log for MQTT messages published while offline.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/io/file.h>
+#include <lwiot/device/eeprom24c02.h>
+#include <lwiot/device/sram23k256.h>
+#include <lwiot/network/mqttofflinelog.h>
+
+#define SEGMENT_MAGIC0 'M'
+#define SEGMENT_MAGIC1 'L'
+#define RECORD_MAGIC   0xA5
+
+#define RECORD_PENDING 0x50
+#define RECORD_SENT    0x00
+#define RECORD_RETAIN  0x01
+
+namespace lwiot
+{
+	static constexpr size_t EepromSize = 256;
+	static constexpr size_t SramSize = 32768;
+
+	/* CRC-16/CCITT */
+	static uint16_t crc16(uint16_t crc, const uint8_t *data, size_t length)
+	{
+		for(size_t idx = 0; idx < length; idx++) {
+			crc ^= static_cast<uint16_t>(data[idx] << 8);
+
+			for(int bit = 0; bit < 8; bit++)
+				crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+		}
+
+		return crc;
+	}
+
+	/* Records are bound to the sequence number of their segment. */
+	static uint16_t checksum(uint32_t sequence, const uint8_t *body, size_t length)
+	{
+		const uint8_t seq[] = {
+			static_cast<uint8_t>(sequence >> 24), static_cast<uint8_t>(sequence >> 16),
+			static_cast<uint8_t>(sequence >> 8), static_cast<uint8_t>(sequence)
+		};
+
+		return crc16(crc16(0xFFFF, seq, sizeof(seq)), body, length);
+	}
+
+	MqttOfflineLog::MqttOfflineLog(size_t segments, size_t segsize) :
+		_segments(segments), _segsize(segsize), _sequences(new uint32_t[segments]), _head(0),
+		_head_offset(SegmentHeader), _tail(0), _tail_offset(SegmentHeader), _next(1), _pending(0),
+		_dropped(0), _loaded(false)
+	{
+		memset(this->_sequences, 0, sizeof(*this->_sequences) * segments);
+	}
+
+	MqttOfflineLog::~MqttOfflineLog()
+	{
+		delete[] this->_sequences;
+	}
+
+	/* Read the segment headers and find the end of the newest segment. Done once. */
+	void MqttOfflineLog::scan()
+	{
+		uint8_t header[SegmentHeader];
+		bool found = false;
+		size_t end;
+
+		if(this->_loaded)
+			return;
+
+		this->_loaded = true;
+
+		for(size_t idx = 0; idx < this->_segments; idx++) {
+			uint32_t sequence = 0;
+
+			this->_sequences[idx] = 0;
+
+			if(!this->read(idx * this->_segsize, header, sizeof(header)))
+				continue;
+
+			if(header[0] != SEGMENT_MAGIC0 || header[1] != SEGMENT_MAGIC1)
+				continue;
+
+			if(crc16(0xFFFF, header, 6) != ((header[6] << 8) | header[7]))
+				continue;
+
+			for(int byte = 2; byte < 6; byte++)
+				sequence = (sequence << 8) | header[byte];
+
+			this->_sequences[idx] = sequence;
+
+			if(sequence == 0)
+				continue;
+
+			if(!found || sequence < this->_sequences[this->_head])
+				this->_head = idx;
+
+			if(!found || sequence > this->_sequences[this->_tail])
+				this->_tail = idx;
+
+			found = true;
+		}
+
+		if(!found)
+			return;
+
+		this->_next = this->_sequences[this->_tail] + 1;
+		this->_head_offset = SegmentHeader;
+
+		for(auto idx = this->_head; idx != this->_tail; idx = (idx + 1) % this->_segments)
+			this->_pending += this->walk(idx, end, false);
+
+		/* Only the newest segment can end in a record that was cut short. */
+		this->_pending += this->walk(this->_tail, this->_tail_offset, true);
+	}
+
+	bool MqttOfflineLog::header(size_t segment, size_t offset, Record &record)
+	{
+		uint8_t header[RecordHeader];
+
+		if(offset + RecordHeader > this->_segsize)
+			return false;
+
+		if(!this->read(segment * this->_segsize + offset, header, sizeof(header)) || header[0] != RECORD_MAGIC)
+			return false;
+
+		record.state = header[1];
+		record.length = (header[2] << 8) | header[3];
+		record.crc = (header[4] << 8) | header[5];
+
+		return offset + RecordHeader + record.length <= this->_segsize;
+	}
+
+	bool MqttOfflineLog::verify(size_t segment, size_t offset, const Record &record)
+	{
+		ByteBuffer body(record.length, true);
+
+		if(!this->read(segment * this->_segsize + offset + RecordHeader, body.data(), record.length))
+			return false;
+
+		return checksum(this->_sequences[segment], body.data(), record.length) == record.crc;
+	}
+
+	/* Count the pending records in \p segment; \p end is set to the end of the last record. */
+	size_t MqttOfflineLog::walk(size_t segment, size_t &end, bool check)
+	{
+		size_t pending = 0;
+		Record record;
+
+		end = SegmentHeader;
+
+		if(this->_sequences[segment] == 0)
+			return 0;
+
+		while(this->header(segment, end, record)) {
+			if(check && !this->verify(segment, end, record))
+				break;
+
+			if(record.state == RECORD_PENDING)
+				pending++;
+
+			end += RecordHeader + record.length;
+		}
+
+		return pending;
+	}
+
+	bool MqttOfflineLog::open(size_t segment)
+	{
+		auto sequence = this->_next++;
+		uint8_t header[] = {
+			SEGMENT_MAGIC0, SEGMENT_MAGIC1,
+			static_cast<uint8_t>(sequence >> 24), static_cast<uint8_t>(sequence >> 16),
+			static_cast<uint8_t>(sequence >> 8), static_cast<uint8_t>(sequence), 0, 0
+		};
+		auto crc = crc16(0xFFFF, header, 6);
+
+		header[6] = static_cast<uint8_t>(crc >> 8);
+		header[7] = static_cast<uint8_t>(crc & 0xFF);
+
+		if(!this->write(segment * this->_segsize, header, sizeof(header)))
+			return false;
+
+		if(this->_sequences[this->_head] == 0) {
+			this->_head = segment;
+			this->_head_offset = SegmentHeader;
+		}
+
+		this->_sequences[segment] = sequence;
+		this->_tail = segment;
+		this->_tail_offset = SegmentHeader;
+
+		return true;
+	}
+
+	void MqttOfflineLog::release(size_t segment)
+	{
+		const uint8_t header[SegmentHeader] = {};
+
+		this->write(segment * this->_segsize, header, sizeof(header));
+		this->_sequences[segment] = 0;
+	}
+
+	bool MqttOfflineLog::append(const String &topic, const ByteBuffer &payload, bool retained)
+	{
+		ScopedLock lock(this->_lock);
+		auto length = 3 + topic.length() + payload.index();
+
+		this->scan();
+
+		if(RecordHeader + length + SegmentHeader > this->_segsize || length > UINT16_MAX)
+			return false;
+
+		if(this->_sequences[this->_tail] == 0) {
+			if(!this->open(this->_tail))
+				return false;
+		} else if(this->_tail_offset + RecordHeader + length > this->_segsize) {
+			const uint8_t end = 0;
+			auto next = (this->_tail + 1) % this->_segments;
+
+			/* Seal the segment, so that nothing behind its last record is taken for a record. */
+			if(this->_tail_offset < this->_segsize)
+				this->write(this->_tail * this->_segsize + this->_tail_offset, &end, sizeof(end));
+
+			if(this->_sequences[next] != 0) {
+				size_t offset;
+				auto lost = this->walk(next, offset, false);
+
+				this->_dropped += lost;
+				this->_pending -= lost;
+				this->release(next);
+
+				if(next == this->_head) {
+					this->_head = (next + 1) % this->_segments;
+					this->_head_offset = SegmentHeader;
+				}
+			}
+
+			if(!this->open(next))
+				return false;
+		}
+
+		ByteBuffer body(length, true);
+
+		body.write(static_cast<uint8_t>(retained ? RECORD_RETAIN : 0));
+		body.write(static_cast<uint8_t>(topic.length() >> 8));
+		body.write(static_cast<uint8_t>(topic.length() & 0xFF));
+		body.write(reinterpret_cast<const uint8_t *>(topic.c_str()), topic.length());
+		body.write(payload.data(), payload.index());
+
+		auto crc = checksum(this->_sequences[this->_tail], body.data(), length);
+		const uint8_t header[] = {
+			RECORD_MAGIC, RECORD_PENDING,
+			static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length & 0xFF),
+			static_cast<uint8_t>(crc >> 8), static_cast<uint8_t>(crc & 0xFF)
+		};
+
+		/* The header goes last: a record is not there until it is complete. */
+		auto offset = this->_tail * this->_segsize + this->_tail_offset;
+
+		if(!this->write(offset + RecordHeader, body.data(), length) || !this->write(offset, header, sizeof(header)))
+			return false;
+
+		this->_tail_offset += RecordHeader + length;
+		this->_pending++;
+
+		return true;
+	}
+
+	size_t MqttOfflineLog::replay(size_t max, const Visitor &visitor)
+	{
+		ScopedLock lock(this->_lock);
+		const uint8_t sent = RECORD_SENT;
+		size_t count = 0;
+		Record record;
+
+		this->scan();
+
+		while(count < max && this->_pending > 0) {
+			auto segment = this->_head;
+			auto offset = this->_head_offset;
+			auto last = segment == this->_tail;
+			bool valid = this->_sequences[segment] != 0 && (!last || offset < this->_tail_offset) &&
+				this->header(segment, offset, record);
+			ByteBuffer body;
+
+			if(valid && record.state == RECORD_PENDING) {
+				body = ByteBuffer(record.length, true);
+				body.setIndex(record.length);
+
+				valid = this->read(segment * this->_segsize + offset + RecordHeader, body.data(), record.length) &&
+					checksum(this->_sequences[segment], body.data(), record.length) == record.crc;
+			}
+
+			if(!valid) {
+				/* Nothing left where new records are written: the count was off. */
+				if(last) {
+					this->_pending = 0;
+					break;
+				}
+
+				this->release(segment);
+				this->_head = (segment + 1) % this->_segments;
+				this->_head_offset = SegmentHeader;
+				continue;
+			}
+
+			this->_head_offset += RecordHeader + record.length;
+
+			if(record.state != RECORD_PENDING)
+				continue;
+
+			size_t tl = (body[1] << 8) | body[2];
+
+			if(3 + tl > record.length)
+				continue;
+
+			String topic(reinterpret_cast<const char *>(body.data() + 3), tl);
+			ByteBuffer payload(record.length - 3 - tl, true);
+
+			payload.write(body.data() + 3 + tl, record.length - 3 - tl);
+
+			if(!visitor(topic, payload, (body[0] & RECORD_RETAIN) != 0)) {
+				this->_head_offset = offset;
+				break;
+			}
+
+			this->write(segment * this->_segsize + offset + 1, &sent, sizeof(sent));
+			this->_pending--;
+			count++;
+		}
+
+		return count;
+	}
+
+	bool MqttOfflineLog::empty()
+	{
+		return this->pending() == 0;
+	}
+
+	size_t MqttOfflineLog::pending()
+	{
+		ScopedLock lock(this->_lock);
+
+		this->scan();
+		return this->_pending;
+	}
+
+	void MqttOfflineLog::clear()
+	{
+		ScopedLock lock(this->_lock);
+
+		for(size_t idx = 0; idx < this->_segments; idx++)
+			this->release(idx);
+
+		this->_head = this->_tail = 0;
+		this->_head_offset = this->_tail_offset = SegmentHeader;
+		this->_pending = 0;
+		this->_loaded = true;
+	}
+
+	MqttFileOfflineLog::MqttFileOfflineLog(const String &path, size_t segments, size_t segsize) :
+		MqttOfflineLog(segments, segsize), _file(new File(path, FileMode::ReadWriteNoCreate))
+	{
+		if(*this->_file && this->_file->size() >= this->size())
+			return;
+
+		/* Create the file with every segment free. */
+		File create(path, FileMode::Write);
+		uint8_t zero[SegmentHeader] = {};
+
+		for(size_t offset = 0; create && offset < this->size(); offset += sizeof(zero))
+			create.write(zero, sizeof(zero));
+
+		create.flush();
+		this->_file.reset(new File(path, FileMode::ReadWriteNoCreate));
+	}
+
+	bool MqttFileOfflineLog::read(size_t offset, void *data, size_t length)
+	{
+		if(!*this->_file || !this->_file->seek(offset))
+			return false;
+
+		return this->_file->read(data, length) == static_cast<ssize_t>(length);
+	}
+
+	bool MqttFileOfflineLog::write(size_t offset, const void *data, size_t length)
+	{
+		if(!*this->_file || offset + length > this->size() || !this->_file->seek(offset))
+			return false;
+
+		return this->_file->write(data, length) == static_cast<ssize_t>(length) && this->_file->flush();
+	}
+
+	MqttSramOfflineLog::MqttSramOfflineLog(SRAM23K256& sram, size_t base, size_t segments, size_t segsize) :
+		MqttOfflineLog(segments, segsize), _sram(sram), _base(base)
+	{
+	}
+
+	bool MqttSramOfflineLog::read(size_t offset, void *data, size_t length)
+	{
+		if(this->_base + offset + length > SramSize)
+			return false;
+
+		return this->_sram.read(this->_base + offset, data, length) == static_cast<ssize_t>(length);
+	}
+
+	bool MqttSramOfflineLog::write(size_t offset, const void *data, size_t length)
+	{
+		if(this->_base + offset + length > SramSize)
+			return false;
+
+		return this->_sram.write(this->_base + offset, data, length) == static_cast<ssize_t>(length);
+	}
+
+	MqttEepromOfflineLog::MqttEepromOfflineLog(Eeprom24C02& eeprom, uint8_t base, size_t segments, size_t segsize) :
+		MqttOfflineLog(segments, segsize), _eeprom(eeprom), _base(base)
+	{
+	}
+
+	bool MqttEepromOfflineLog::read(size_t offset, void *data, size_t length)
+	{
+		if(this->_base + offset + length > EepromSize)
+			return false;
+
+		return this->_eeprom.read(this->_base + offset, data, length) == static_cast<ssize_t>(length);
+	}
+
+	bool MqttEepromOfflineLog::write(size_t offset, const void *data, size_t length)
+	{
+		if(this->_base + offset + length > EepromSize)
+			return false;
+
+		return this->_eeprom.write(this->_base + offset, data, length) >= 0 && this->_eeprom.flush();
+	}
+}
@@ -0,0 +1,198 @@
+/*
+ * Persistent storage for unacknowledged MQTT messages.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/io/file.h>
+#include <lwiot/device/eeprom24c02.h>
+#include <lwiot/network/mqttsessionstore.h>
+
+namespace lwiot
+{
+	static constexpr size_t EepromSize = 256;
+
+	MqttSlotSessionStore::MqttSlotSessionStore(size_t slots, size_t slotsize) :
+		_slots(slots), _slotsize(slotsize), _ids(new uint16_t[slots]), _loaded(false)
+	{
+		memset(this->_ids, 0, sizeof(*this->_ids) * slots);
+	}
+
+	MqttSlotSessionStore::~MqttSlotSessionStore()
+	{
+		delete[] this->_ids;
+	}
+
+	/* The identifiers are read from the medium once and cached. */
+	void MqttSlotSessionStore::scan()
+	{
+		uint8_t header[SlotHeader];
+
+		if(this->_loaded)
+			return;
+
+		for(size_t idx = 0; idx < this->_slots; idx++) {
+			if(!this->read(idx * this->_slotsize, header, sizeof(header)))
+				header[0] = header[1] = 0;
+
+			this->_ids[idx] = (header[0] << 8) | header[1];
+		}
+
+		this->_loaded = true;
+	}
+
+	size_t MqttSlotSessionStore::find(uint16_t id)
+	{
+		this->scan();
+
+		for(size_t idx = 0; idx < this->_slots; idx++) {
+			if(this->_ids[idx] == id)
+				return idx;
+		}
+
+		return this->_slots;
+	}
+
+	bool MqttSlotSessionStore::save(uint16_t id, const uint8_t *packet, size_t length)
+	{
+		if(id == 0 || length + SlotHeader > this->_slotsize)
+			return false;
+
+		auto slot = this->find(id);
+
+		if(slot == this->_slots)
+			slot = this->find(0);
+
+		if(slot == this->_slots)
+			return false;
+
+		uint8_t header[] = {
+			static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id & 0xFF),
+			static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length & 0xFF)
+		};
+
+		/* Write the packet before the header, so that a slot is never taken by half a packet. */
+		auto offset = slot * this->_slotsize;
+
+		if(!this->write(offset + SlotHeader, packet, length) || !this->write(offset, header, sizeof(header)))
+			return false;
+
+		this->_ids[slot] = id;
+		return true;
+	}
+
+	void MqttSlotSessionStore::remove(uint16_t id)
+	{
+		const uint8_t header[SlotHeader] = {};
+		auto slot = this->find(id);
+
+		if(id == 0 || slot == this->_slots)
+			return;
+
+		this->write(slot * this->_slotsize, header, sizeof(header));
+		this->_ids[slot] = 0;
+	}
+
+	void MqttSlotSessionStore::load(const Visitor& visitor)
+	{
+		uint8_t header[SlotHeader];
+
+		this->scan();
+
+		for(size_t idx = 0; idx < this->_slots; idx++) {
+			if(this->_ids[idx] == 0)
+				continue;
+
+			auto offset = idx * this->_slotsize;
+
+			if(!this->read(offset, header, sizeof(header)))
+				continue;
+
+			size_t length = (header[2] << 8) | header[3];
+
+			if(length + SlotHeader > this->_slotsize)
+				continue;
+
+			ByteBuffer packet(length, true);
+
+			packet.setIndex(length);
+
+			if(this->read(offset + SlotHeader, packet.data(), length))
+				visitor(this->_ids[idx], packet);
+		}
+	}
+
+	void MqttSlotSessionStore::clear()
+	{
+		const uint8_t header[SlotHeader] = {};
+
+		for(size_t idx = 0; idx < this->_slots; idx++) {
+			this->write(idx * this->_slotsize, header, sizeof(header));
+			this->_ids[idx] = 0;
+		}
+
+		this->_loaded = true;
+	}
+
+	MqttFileSessionStore::MqttFileSessionStore(const lwiot::String &path, size_t slots, size_t slotsize) :
+		MqttSlotSessionStore(slots, slotsize), _file(new File(path, FileMode::ReadWriteNoCreate))
+	{
+		if(*this->_file && this->_file->size() >= this->size())
+			return;
+
+		/* Create the file with every slot free. */
+		File create(path, FileMode::Write);
+		uint8_t zero[SlotHeader] = {};
+
+		for(size_t offset = 0; create && offset < this->size(); offset += sizeof(zero))
+			create.write(zero, sizeof(zero));
+
+		create.flush();
+		this->_file.reset(new File(path, FileMode::ReadWriteNoCreate));
+	}
+
+	bool MqttFileSessionStore::read(size_t offset, void *data, size_t length)
+	{
+		if(!*this->_file || !this->_file->seek(offset))
+			return false;
+
+		return this->_file->read(data, length) == static_cast<ssize_t>(length);
+	}
+
+	bool MqttFileSessionStore::write(size_t offset, const void *data, size_t length)
+	{
+		if(!*this->_file || offset + length > this->size() || !this->_file->seek(offset))
+			return false;
+
+		return this->_file->write(data, length) == static_cast<ssize_t>(length) && this->_file->flush();
+	}
+
+	MqttEepromSessionStore::MqttEepromSessionStore(Eeprom24C02& eeprom, uint8_t base, size_t slots, size_t slotsize) :
+		MqttSlotSessionStore(slots, slotsize), _eeprom(eeprom), _base(base)
+	{
+	}
+
+	bool MqttEepromSessionStore::read(size_t offset, void *data, size_t length)
+	{
+		if(this->_base + offset + length > EepromSize)
+			return false;
+
+		return this->_eeprom.read(this->_base + offset, data, length) == static_cast<ssize_t>(length);
+	}
+
+	bool MqttEepromSessionStore::write(size_t offset, const void *data, size_t length)
+	{
+		if(this->_base + offset + length > EepromSize)
+			return false;
+
+		return this->_eeprom.write(this->_base + offset, data, length) >= 0 && this->_eeprom.flush();
+	}
+}
@@ -4,34 +4,80 @@ elseif(WIN32)
 	SET(SOCKETS net/sockets/win32.c)
 endif()
 
+if(HAVE_UNISTD_H)
+	SET(STATIC_FILE_SRC net/http/staticfilehandler.cpp)
+endif()
+
+if(HAVE_LWIP)
+	SET(NETCONN_SRC
+		net/tcp/netconntcpclient.cpp
+		net/udp/netconnudpserver.cpp
+		net/util/netconn.cpp
+	)
+endif()
+
 SET(NET_SOURCES
 	${SOCKETS}
 	net/tcp/tcpclient.cpp
 	net/tcp/sockettcpclient.cpp
 	net/tcp/tcpserver.cpp
 	net/tcp/sockettcpserver.cpp
+	net/tcp/tcpacceptorpool.cpp
 	net/tcp/securetcpclient.cpp
+	net/tcp/securetcpserver.cpp
+	net/tcp/connectionpool.cpp
+	net/tcp/tlssessioncache.cpp
+	${NETCONN_SRC}
 
 	net/udp/udpclient.cpp
 	net/udp/udpserver.cpp
 	net/udp/socketudpclient.cpp
 	net/udp/socketudpserver.cpp
+	net/udp/datagrambatch.cpp
 	net/udp/dnsserver.cpp
 	net/udp/dnsclient.cpp
 
 	net/util/base64.c
+	net/util/base64stream.cpp
+	net/util/sha1.c
+	net/util/sha256.c
 	net/util/captiveportal.cpp
 	net/util/ipaddress.cpp
 	net/util/ntpclient.cpp
+	net/util/eventloop.cpp
+	net/util/socketstats.cpp
+	net/util/sysloglogsink.cpp
 
 	net/http/httpserver.cpp
+	net/http/httprouter.cpp
+	net/http/httprequestparser.cpp
+	net/http/httpheaders.cpp
+	net/http/httpresponsewriter.cpp
+	net/http/httpchunkedwriter.cpp
+	net/http/httpmultipartparser.cpp
+	net/http/uploadsink.cpp
+	net/http/httppushendpoint.cpp
+	net/http/websocket.cpp
+	net/http/eventsource.cpp
+	net/http/timeserieshandler.cpp
+	net/http/metricshandler.cpp
+	${STATIC_FILE_SRC}
 	net/http/mimetable.cpp
 	net/http/mimetable.h
 	net/http/requesthandlerimpl.h
 
+	net/coap/coapmessage.cpp
+	net/coap/coapendpoint.cpp
+
+	net/ota/deltaupdate.cpp
+
 	net/802.11/wifiaccesspoint.cpp
 	net/802.11/wifistation.cpp
 
 	net/iot/mqttclient.cpp
 	net/iot/asyncmqttclient.cpp
+	net/iot/mqttsessionstore.cpp
+	net/iot/mqttofflinelog.cpp
+	net/iot/mqttbridge.cpp
+	net/iot/metricspublisher.cpp
 )
@@ -0,0 +1,333 @@
+/*
+ * Streaming delta firmware update.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/network/deltaupdate.h>
+
+#define DELTA_MAGIC "ENDSLEY/BSDIFF43"
+#define DELTA_MAGIC_SIZE 16
+#define DELTA_CONTROL_SIZE 24
+#define DELTA_CHUNK 32
+
+namespace lwiot
+{
+	/* bsdiff stores offsets as a 63 bit magnitude and a sign bit, least significant byte first. */
+	static int64_t offtin(const uint8_t *buf)
+	{
+		uint64_t value = buf[7] & 0x7F;
+
+		for(int idx = 6; idx >= 0; idx--)
+			value = (value << 8) | buf[idx];
+
+		return (buf[7] & 0x80) != 0 ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+	}
+
+	DeltaUpdate::DeltaUpdate(BlockDevice& source, BlockDevice& target) : _source(source), _target(target),
+		_decoder(CONFIG_DELTA_WINDOW, CONFIG_DELTA_LOOKAHEAD), _check(false)
+	{
+		this->reset();
+	}
+
+	void DeltaUpdate::expect(const uint8_t *digest)
+	{
+		memcpy(this->_expected, digest, SHA256_DIGEST_SIZE);
+		this->_check = true;
+	}
+
+	void DeltaUpdate::reset()
+	{
+		this->_decoder.reset();
+		sha256_init(&this->_sha);
+
+		this->_state = State::Header;
+		this->_error = Error::None;
+		this->_used = 0;
+		this->_old = 0;
+		this->_new = 0;
+		this->_size = 0;
+		this->_run = 0;
+		this->_extra = 0;
+		this->_seek = 0;
+		this->_fill = 0;
+
+		memset(this->_digest, 0, sizeof(this->_digest));
+	}
+
+	size_t DeltaUpdate::size() const
+	{
+		return this->_size;
+	}
+
+	size_t DeltaUpdate::written() const
+	{
+		return this->_new;
+	}
+
+	DeltaUpdate::Error DeltaUpdate::error() const
+	{
+		return this->_error;
+	}
+
+	const uint8_t *DeltaUpdate::digest() const
+	{
+		return this->_digest;
+	}
+
+	bool DeltaUpdate::fail(Error error)
+	{
+		if(this->_state != State::Failed) {
+			print_dbg("Delta update failed: %i\n", static_cast<int>(error));
+			this->_error = error;
+			this->_state = State::Failed;
+		}
+
+		return false;
+	}
+
+	bool DeltaUpdate::write(const uint8_t *data, size_t length)
+	{
+		uint8_t output[DELTA_CHUNK];
+
+		if(this->_state == State::Failed)
+			return false;
+
+		if(this->_state == State::Header && !this->header(data, length))
+			return false;
+
+		while(true) {
+			size_t used;
+			auto num = this->_decoder.process(data, length, used, output, sizeof(output));
+
+			if(num == 0 && used == 0)
+				break;
+
+			if(!this->apply(output, num))
+				return false;
+
+			data += used;
+			length -= used;
+		}
+
+		return true;
+	}
+
+	bool DeltaUpdate::header(const uint8_t *&data, size_t& length)
+	{
+		auto num = DELTA_HEADER_SIZE - this->_used;
+
+		if(num > length)
+			num = length;
+
+		memcpy(this->_record + this->_used, data, num);
+		this->_used += num;
+		data += num;
+		length -= num;
+
+		if(this->_used < DELTA_HEADER_SIZE)
+			return true;
+
+		auto size = offtin(this->_record + DELTA_MAGIC_SIZE);
+
+		if(memcmp(this->_record, DELTA_MAGIC, DELTA_MAGIC_SIZE) != 0 || size < 0)
+			return this->fail(Error::Format);
+
+		if(static_cast<uint64_t>(size) > this->_target.size())
+			return this->fail(Error::Target);
+
+		this->_size = static_cast<size_t>(size);
+		this->_used = 0;
+		this->_state = this->_size == 0 ? State::Done : State::Control;
+
+		return true;
+	}
+
+	/* Each control record adds a run of diff bytes to the old image, appends extra bytes and seeks. */
+	bool DeltaUpdate::control()
+	{
+		auto add = offtin(this->_record);
+		auto extra = offtin(this->_record + 8);
+		auto remaining = static_cast<int64_t>(this->_size - this->_new);
+
+		this->_used = 0;
+
+		if(add < 0 || extra < 0 || add > remaining || extra > remaining - add)
+			return this->fail(Error::Format);
+
+		this->_run = static_cast<size_t>(add);
+		this->_extra = static_cast<size_t>(extra);
+		this->_seek = offtin(this->_record + 16);
+		this->_state = State::Diff;
+		this->next();
+
+		return true;
+	}
+
+	void DeltaUpdate::next()
+	{
+		if(this->_state == State::Diff && this->_run == 0) {
+			this->_run = this->_extra;
+			this->_state = State::Extra;
+		}
+
+		if(this->_state == State::Extra && this->_run == 0) {
+			this->_old += this->_seek;
+			this->_state = this->_new == this->_size ? State::Done : State::Control;
+		}
+	}
+
+	bool DeltaUpdate::apply(const uint8_t *data, size_t length)
+	{
+		while(length > 0) {
+			size_t num;
+
+			switch(this->_state) {
+			case State::Control:
+				num = DELTA_CONTROL_SIZE - this->_used;
+				num = num < length ? num : length;
+
+				memcpy(this->_record + this->_used, data, num);
+				this->_used += num;
+
+				if(this->_used == DELTA_CONTROL_SIZE && !this->control())
+					return false;
+				break;
+
+			case State::Diff:
+			case State::Extra:
+				num = this->_run < length ? this->_run : length;
+
+				if(!(this->_state == State::Diff ? this->diff(data, num) : this->emit(data, num)))
+					return false;
+
+				this->_run -= num;
+				this->next();
+				break;
+
+			default:
+				/* Data after the end of the new image. */
+				return this->fail(Error::Format);
+			}
+
+			data += num;
+			length -= num;
+		}
+
+		return true;
+	}
+
+	/* Add diff bytes to the old image. Bytes outside the source, which a valid patch never uses, count as zero. */
+	bool DeltaUpdate::diff(const uint8_t *data, size_t length)
+	{
+		uint8_t old[DELTA_CHUNK];
+		auto limit = static_cast<int64_t>(this->_source.size());
+
+		while(length > 0) {
+			auto num = length < sizeof(old) ? length : sizeof(old);
+			auto start = this->_old < 0 ? 0 : this->_old;
+			auto end = this->_old + static_cast<int64_t>(num);
+
+			end = end > limit ? limit : end;
+			memset(old, 0, num);
+
+			if(start < end) {
+				auto count = static_cast<size_t>(end - start);
+
+				if(this->_source.read(static_cast<size_t>(start), old + (start - this->_old), count) != static_cast<ssize_t>(count))
+					return this->fail(Error::Source);
+			}
+
+			for(size_t idx = 0; idx < num; idx++)
+				old[idx] += data[idx];
+
+			if(!this->emit(old, num))
+				return false;
+
+			this->_old += num;
+			data += num;
+			length -= num;
+		}
+
+		return true;
+	}
+
+	bool DeltaUpdate::emit(const uint8_t *data, size_t length)
+	{
+		sha256_update(&this->_sha, data, length);
+
+		while(length > 0) {
+			auto num = sizeof(this->_block) - this->_fill;
+
+			num = num < length ? num : length;
+			memcpy(this->_block + this->_fill, data, num);
+			this->_fill += num;
+			this->_new += num;
+			data += num;
+			length -= num;
+
+			if(this->_fill == sizeof(this->_block) && !this->flush())
+				return false;
+		}
+
+		return true;
+	}
+
+	bool DeltaUpdate::flush()
+	{
+		if(this->_fill == 0)
+			return true;
+
+		if(this->_target.write(this->_new - this->_fill, this->_block, this->_fill) != static_cast<ssize_t>(this->_fill))
+			return this->fail(Error::Target);
+
+		this->_fill = 0;
+		return true;
+	}
+
+	bool DeltaUpdate::finish()
+	{
+		if(this->_state == State::Failed)
+			return false;
+
+		if(this->_state != State::Done)
+			return this->fail(Error::Size);
+
+		if(!this->flush() || !this->_target.flush())
+			return this->fail(Error::Target);
+
+		sha256_final(&this->_sha, this->_digest);
+
+		if(this->_check && memcmp(this->_digest, this->_expected, SHA256_DIGEST_SIZE) != 0)
+			return this->fail(Error::Digest);
+
+		return true;
+	}
+
+	void DeltaUpdate::abort()
+	{
+		this->_state = State::Failed;
+	}
+
+	bool DeltaUpdate::receive(size_t offset, const RawBuffer& span, size_t total)
+	{
+		if(offset == 0)
+			this->reset();
+
+		if(!this->write(static_cast<const uint8_t *>(span.buffer()), span.size()))
+			return false;
+
+		if(offset + span.size() < total)
+			return true;
+
+		return this->finish();
+	}
+}
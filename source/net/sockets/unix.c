@@ -5,6 +5,8 @@
  * @email  dev@bietje.net
  */
 
+#define _GNU_SOURCE
+
 #include "unix_sockets.h"
 
 #include <stdlib.h>
@@ -17,17 +19,36 @@
 #include <lwiot/error.h>
 #include <lwiot/network/stdnet.h>
 
+#include <poll.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
 #define IP6_SIZE 16
+#define IOV_BATCH_SIZE 16
+#define UDP_BATCH_SIZE 16
 
 #ifndef CONFIG_CLIENT_QUEUE_LENGTH
-#define CONFIG_CLIENT_QUEUE_LENGTH 10
+#define CONFIG_CLIENT_QUEUE_LENGTH SOMAXCONN
 #endif
 
+#ifndef CONFIG_CONNECT_ATTEMPT_DELAY
+#define CONFIG_CONNECT_ATTEMPT_DELAY 250
+#endif
+
+#define CONNECT_ATTEMPTS_MAX 8
+
 void socket_set_timeout(socket_t* sock, time_t tmo)
 {
 	struct timeval timeout;
@@ -39,23 +60,279 @@ void socket_set_timeout(socket_t* sock, time_t tmo)
 	setsockopt(*sock, SOL_SOCKET, SO_SNDTIMEO, (char*)&timeout, sizeof(timeout));
 }
 
-static bool ip4_connect(socket_t* sock, remote_addr_t* addr)
+static bool socket_is_ipv6(int fd)
+{
+	struct sockaddr_storage addr;
+	socklen_t length;
+
+	length = sizeof(addr);
+
+	if(getsockname(fd, (struct sockaddr*)&addr, &length) < 0)
+		return false;
+
+	return addr.ss_family == AF_INET6;
+}
+
+static int socket_option_level(int fd, socket_option_t option, int *level, int *name)
+{
+	bool ipv6;
+
+	switch(option) {
+	case SOCKET_OPT_NODELAY:
+		*level = IPPROTO_TCP;
+		*name = TCP_NODELAY;
+		break;
+
+	case SOCKET_OPT_KEEPALIVE:
+		*level = SOL_SOCKET;
+		*name = SO_KEEPALIVE;
+		break;
+
+#ifdef TCP_KEEPIDLE
+	case SOCKET_OPT_KEEPIDLE:
+		*level = IPPROTO_TCP;
+		*name = TCP_KEEPIDLE;
+		break;
+#endif
+
+#ifdef TCP_KEEPINTVL
+	case SOCKET_OPT_KEEPINTVL:
+		*level = IPPROTO_TCP;
+		*name = TCP_KEEPINTVL;
+		break;
+#endif
+
+#ifdef TCP_KEEPCNT
+	case SOCKET_OPT_KEEPCNT:
+		*level = IPPROTO_TCP;
+		*name = TCP_KEEPCNT;
+		break;
+#endif
+
+	case SOCKET_OPT_SNDBUF:
+		*level = SOL_SOCKET;
+		*name = SO_SNDBUF;
+		break;
+
+	case SOCKET_OPT_RCVBUF:
+		*level = SOL_SOCKET;
+		*name = SO_RCVBUF;
+		break;
+
+#ifdef TCP_QUICKACK
+	case SOCKET_OPT_QUICKACK:
+		*level = IPPROTO_TCP;
+		*name = TCP_QUICKACK;
+		break;
+#endif
+
+#ifdef SO_REUSEPORT
+	case SOCKET_OPT_REUSEPORT:
+		*level = SOL_SOCKET;
+		*name = SO_REUSEPORT;
+		break;
+#endif
+
+	case SOCKET_OPT_BROADCAST:
+		*level = SOL_SOCKET;
+		*name = SO_BROADCAST;
+		break;
+
+	case SOCKET_OPT_MULTICAST_TTL:
+		ipv6 = socket_is_ipv6(fd);
+		*level = ipv6 ? IPPROTO_IPV6 : IPPROTO_IP;
+		*name = ipv6 ? IPV6_MULTICAST_HOPS : IP_MULTICAST_TTL;
+		break;
+
+	case SOCKET_OPT_MULTICAST_LOOP:
+		ipv6 = socket_is_ipv6(fd);
+		*level = ipv6 ? IPPROTO_IPV6 : IPPROTO_IP;
+		*name = ipv6 ? IPV6_MULTICAST_LOOP : IP_MULTICAST_LOOP;
+		break;
+
+	default:
+		return -ENOTSUPPORTED;
+	}
+
+	return -EOK;
+}
+
+int socket_set_option(socket_t *sock, socket_option_t option, int value)
+{
+	int level, name;
+
+	if(sock == NULL)
+		return -EINVALID;
+
+	if(socket_option_level(*sock, option, &level, &name) != -EOK)
+		return -ENOTSUPPORTED;
+
+	return setsockopt(*sock, level, name, &value, sizeof(value)) < 0 ? -EINVALID : -EOK;
+}
+
+int socket_get_option(socket_t *sock, socket_option_t option, int *value)
 {
-	struct sockaddr_in sockaddr;
+	socklen_t length;
+	int level, name;
+
+	if(sock == NULL || value == NULL)
+		return -EINVALID;
+
+	if(socket_option_level(*sock, option, &level, &name) != -EOK)
+		return -ENOTSUPPORTED;
+
+	length = sizeof(*value);
+	return getsockopt(*sock, level, name, value, &length) < 0 ? -EINVALID : -EOK;
+}
+
+int socket_tcp_info(socket_t *sock, socket_tcp_info_t *info)
+{
+#if defined(__linux__) && defined(TCP_INFO)
+	struct tcp_info raw;
+	socklen_t length;
+
+	if(sock == NULL || info == NULL)
+		return -EINVALID;
+
+	length = sizeof(raw);
+	memset(&raw, 0, sizeof(raw));
+
+	if(getsockopt(*sock, IPPROTO_TCP, TCP_INFO, &raw, &length) < 0)
+		return -EINVALID;
+
+	info->rtt = raw.tcpi_rtt;
+	info->rtt_var = raw.tcpi_rttvar;
+	info->retransmits = raw.tcpi_total_retrans;
+	info->cwnd = raw.tcpi_snd_cwnd;
+
+	return -EOK;
+#else
+	UNUSED(sock);
+	UNUSED(info);
+
+	return -ENOTSUPPORTED;
+#endif
+}
+
+bool socket_would_block(void)
+{
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+static void sockaddr_to_remote(const struct sockaddr_storage *addr, remote_addr_t *remote)
+{
+	const struct sockaddr_in *ip;
+	const struct sockaddr_in6 *ip6;
+
+	if(addr->ss_family == AF_INET6) {
+		ip6 = (const struct sockaddr_in6*) addr;
+
+		/* Dual stack listeners see IPv4 peers as v4-mapped IPv6 addresses. */
+		if(IN6_IS_ADDR_V4MAPPED(&ip6->sin6_addr)) {
+			remote->version = 4;
+			remote->port = ip6->sin6_port;
+			memcpy(&remote->addr.ip4_addr.ip, ip6->sin6_addr.s6_addr + 12, sizeof(remote->addr.ip4_addr.ip));
+			return;
+		}
+
+		remote->version = 6;
+		remote->port = ip6->sin6_port;
+		memcpy(remote->addr.ip6_addr.ip, ip6->sin6_addr.s6_addr, IP6_SIZE);
+	} else {
+		ip = (const struct sockaddr_in*) addr;
+		remote->version = 4;
+		remote->port = ip->sin_port;
+		remote->addr.ip4_addr.ip = ip->sin_addr.s_addr;
+	}
+}
+
+static socklen_t remote_to_sockaddr(const remote_addr_t *remote, struct sockaddr_storage *addr)
+{
+	struct sockaddr_in *ip;
+	struct sockaddr_in6 *ip6;
+
+	memset(addr, 0, sizeof(*addr));
+
+	if(remote->version == 6) {
+		ip6 = (struct sockaddr_in6*) addr;
+		ip6->sin6_family = AF_INET6;
+		ip6->sin6_port = remote->port;
+		memcpy(ip6->sin6_addr.s6_addr, remote->addr.ip6_addr.ip, IP6_SIZE);
+		return sizeof(*ip6);
+	}
+
+	ip = (struct sockaddr_in*) addr;
+	ip->sin_family = AF_INET;
+	ip->sin_port = remote->port;
+	ip->sin_addr.s_addr = remote->addr.ip4_addr.ip;
+	return sizeof(*ip);
+}
+
+static int socket_connect(int fd, const struct sockaddr *addr, socklen_t length, int tmo)
+{
+	struct pollfd pfd;
+	socklen_t optlen;
+	int flags, rv, error;
+
+	if(tmo == FOREVER)
+		return connect(fd, addr, length) < 0 ? -EINVALID : -EOK;
+
+	flags = fcntl(fd, F_GETFL, 0);
+	fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+	rv = connect(fd, addr, length);
+
+	if(rv < 0 && errno == EINPROGRESS) {
+		pfd.fd = fd;
+		pfd.events = POLLOUT;
+		pfd.revents = 0;
+
+		do {
+			rv = poll(&pfd, 1, tmo);
+		} while(rv < 0 && errno == EINTR);
+
+		if(rv == 0) {
+			rv = -ETMO;
+		} else if(rv > 0) {
+			optlen = sizeof(error);
+			error = 0;
+			getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &optlen);
+			rv = error == 0 ? -EOK : -EINVALID;
+		} else {
+			rv = -EINVALID;
+		}
+	} else if(rv < 0) {
+		rv = -EINVALID;
+	}
+
+	fcntl(fd, F_SETFL, flags);
+	return rv;
+}
+
+static int tcp_socket_open(const remote_addr_t *remote)
+{
+	int fd;
 	int enable = 1;
 
-	sockaddr.sin_family = AF_INET;
-	sockaddr.sin_port = addr->port;
-	sockaddr.sin_addr.s_addr = addr->addr.ip4_addr.ip;
-	bzero(&sockaddr.sin_zero, sizeof(sockaddr.sin_zero));
+	fd = socket(remote->version == 6 ? AF_INET6 : AF_INET, SOCK_STREAM, 0);
+
+	if(fd >= 0)
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int));
+
+	return fd;
+}
+
+static bool ip_connect(socket_t* sock, remote_addr_t* addr, int tmo)
+{
+	struct sockaddr_storage sockaddr;
+	socklen_t length;
+
+	length = remote_to_sockaddr(addr, &sockaddr);
+	*sock = tcp_socket_open(addr);
 
-	*sock = socket(AF_INET, SOCK_STREAM, 0);
 	if(*sock < 0)
 		return false;
 
-	setsockopt(*sock, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int));
-
-	if(connect(*sock, (struct sockaddr*) &sockaddr, sizeof(struct sockaddr)) < 0) {
+	if(socket_connect(*sock, (struct sockaddr*) &sockaddr, length, tmo) != -EOK) {
 		close(*sock);
 		return false;
 	}
@@ -63,30 +340,147 @@ static bool ip4_connect(socket_t* sock, remote_addr_t* addr)
 	return true;
 }
 
-static bool ip6_connect(socket_t* sock, remote_addr_t* addr)
+socket_t* tcp_socket_create_timeout(remote_addr_t* remote, int tmo)
 {
-	print_dbg("IPv6 not yet supported!");
-	return false;
+	socket_t *sock;
+
+	sock = lwiot_mem_zalloc(sizeof(sock));
+	assert(sock);
+
+	if(!ip_connect(sock, remote, tmo)) {
+		lwiot_mem_free(sock);
+		return NULL;
+	}
+
+	return sock;
 }
 
 socket_t* tcp_socket_create(remote_addr_t* remote)
 {
+	return tcp_socket_create_timeout(remote, FOREVER);
+}
+
+/* Start a non-blocking connect. Returns the descriptor, or -1 if the attempt failed right away. */
+static int connect_attempt(const remote_addr_t *remote, bool *connected)
+{
+	struct sockaddr_storage sockaddr;
+	socklen_t length;
+	int fd;
+
+	length = remote_to_sockaddr(remote, &sockaddr);
+	fd = tcp_socket_open(remote);
+
+	if(fd < 0)
+		return -1;
+
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+	*connected = connect(fd, (struct sockaddr*) &sockaddr, length) == 0;
+
+	if(!*connected && errno != EINPROGRESS) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+socket_t* tcp_socket_create_any(remote_addr_t* remotes, size_t num, int tmo, size_t *index)
+{
+	struct pollfd fds[CONNECT_ATTEMPTS_MAX];
+	size_t started, active, idx;
+	time_t now, deadline, next;
+	int winner, wait, error, rv;
+	socklen_t optlen;
 	socket_t *sock;
-	bool result;
+	bool connected;
 
-	sock = lwiot_mem_zalloc(sizeof(sock));
-	assert(sock);
+	if(index != NULL)
+		*index = 0;
 
-	if(remote->version == 6)
-		result = ip6_connect(sock, remote);
-	else
-		result = ip4_connect(sock, remote);
+	if(num == 1)
+		return tcp_socket_create_timeout(remotes, tmo);
 
-	if(!result) {
-		lwiot_mem_free(sock);
-		return NULL;
+	if(num > CONNECT_ATTEMPTS_MAX)
+		num = CONNECT_ATTEMPTS_MAX;
+
+	now = lwiot_tick_ms();
+	deadline = now + tmo;
+	next = now;
+	started = active = 0;
+	winner = -1;
+
+	while(winner < 0) {
+		now = lwiot_tick_ms();
+
+		if(tmo != FOREVER && now >= deadline)
+			break;
+
+		if(started < num && now >= next) {
+			connected = false;
+			fds[started].fd = connect_attempt(&remotes[started], &connected);
+			fds[started].events = POLLOUT;
+			fds[started].revents = 0;
+
+			if(connected)
+				winner = started;
+			else if(fds[started].fd >= 0)
+				active++;
+
+			started++;
+			next = active > 0 ? now + CONFIG_CONNECT_ATTEMPT_DELAY : now;
+			continue;
+		}
+
+		if(active == 0 && started == num)
+			break;
+
+		wait = started < num ? (int) (next - now) : -1;
+
+		if(tmo != FOREVER && (wait < 0 || deadline - now < wait))
+			wait = (int) (deadline - now);
+
+		rv = poll(fds, started, wait);
+
+		if(rv < 0 && errno != EINTR)
+			break;
+
+		for(idx = 0; rv > 0 && idx < started; idx++) {
+			if(fds[idx].fd < 0 || fds[idx].revents == 0)
+				continue;
+
+			optlen = sizeof(error);
+			error = 0;
+			getsockopt(fds[idx].fd, SOL_SOCKET, SO_ERROR, &error, &optlen);
+
+			if(error == 0 && (fds[idx].revents & POLLOUT)) {
+				winner = idx;
+				break;
+			}
+
+			/* Failed attempts make way for the next address immediately. */
+			close(fds[idx].fd);
+			fds[idx].fd = -1;
+			active--;
+			next = lwiot_tick_ms();
+		}
+	}
+
+	for(idx = 0; idx < started; idx++) {
+		if(fds[idx].fd >= 0 && (int) idx != winner)
+			close(fds[idx].fd);
 	}
 
+	if(winner < 0)
+		return NULL;
+
+	if(index != NULL)
+		*index = (size_t) winner;
+
+	fcntl(fds[winner].fd, F_SETFL, fcntl(fds[winner].fd, F_GETFL, 0) & ~O_NONBLOCK);
+	sock = lwiot_mem_zalloc(sizeof(sock));
+	assert(sock);
+	*sock = fds[winner].fd;
+
 	return sock;
 }
 
@@ -105,6 +499,112 @@ ssize_t tcp_socket_send(socket_t* socket, const void* data, size_t length)
 	return send(fd, data, length, 0);
 }
 
+ssize_t tcp_socket_sendv(socket_t* socket, const socket_buffer_t* buffers, size_t num)
+{
+	struct iovec iov[IOV_BATCH_SIZE];
+	struct msghdr msg;
+	ssize_t total, rv;
+	size_t idx, batch, expected;
+
+	assert(socket);
+	assert(buffers || num == 0);
+
+	total = 0;
+
+	while(num > 0) {
+		batch = num > IOV_BATCH_SIZE ? IOV_BATCH_SIZE : num;
+		expected = 0;
+
+		for(idx = 0; idx < batch; idx++) {
+			iov[idx].iov_base = (void*) buffers[idx].data;
+			iov[idx].iov_len = buffers[idx].length;
+			expected += buffers[idx].length;
+		}
+
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+		msg.msg_iovlen = batch;
+
+		rv = sendmsg(*socket, &msg, 0);
+
+		if(rv < 0)
+			return total > 0 ? total : rv;
+
+		total += rv;
+
+		if((size_t)rv < expected)
+			break;
+
+		buffers += batch;
+		num -= batch;
+	}
+
+	return total;
+}
+
+#ifdef __linux__
+ssize_t tcp_socket_sendfile(socket_t* socket, int fd, size_t offset, size_t length)
+{
+	off_t pos;
+	ssize_t rv;
+	size_t total;
+
+	assert(socket);
+
+	pos = (off_t) offset;
+	total = 0;
+
+	while(total < length) {
+		rv = sendfile(*socket, fd, &pos, length - total);
+
+		if(rv < 0 && total == 0 && (errno == EINVAL || errno == ENOSYS))
+			return -ENOTSUPPORTED;
+
+		if(rv <= 0)
+			return total > 0 ? (ssize_t) total : rv;
+
+		total += rv;
+	}
+
+	return total;
+}
+#else
+ssize_t tcp_socket_sendfile(socket_t* socket, int fd, size_t offset, size_t length)
+{
+	size_t start, total;
+	uint8_t *map;
+	ssize_t rv;
+
+	assert(socket);
+
+	if(length == 0)
+		return 0;
+
+	/* Mappings start at a page boundary. */
+	start = offset - offset % (size_t) sysconf(_SC_PAGESIZE);
+	map = mmap(NULL, length + offset - start, PROT_READ, MAP_PRIVATE, fd, (off_t) start);
+
+	if(map == MAP_FAILED)
+		return -ENOTSUPPORTED;
+
+	total = 0;
+
+	while(total < length) {
+		rv = send(*socket, map + offset - start + total, length - total, 0);
+
+		if(rv <= 0) {
+			munmap(map, length + offset - start);
+			return total > 0 ? (ssize_t) total : rv;
+		}
+
+		total += rv;
+	}
+
+	munmap(map, length + offset - start);
+	return total;
+}
+#endif
+
 ssize_t tcp_socket_read(socket_t* socket, void* data, size_t length)
 {
 	int fd;
@@ -145,55 +645,238 @@ socket_t* udp_socket_create(remote_addr_t* remote)
 
 ssize_t udp_send_to(socket_t* socket, const void *data, size_t length, remote_addr_t* remote)
 {
-	struct sockaddr_in ip;
-	struct sockaddr_in6 ip6;
+	struct sockaddr_storage addr;
+	socklen_t socklen;
+
+	socklen = remote_to_sockaddr(remote, &addr);
+	return sendto(*socket, data, length, 0, (struct sockaddr*)&addr, socklen);
+}
+
+ssize_t udp_recv_from(socket_t* socket, void *data, size_t length, remote_addr_t* remote)
+{
+	struct sockaddr_storage addr;
+	socklen_t socklen;
 	ssize_t rv;
 
-	if(remote->version == 6) {
-		memcpy(ip6.sin6_addr.__in6_u.__u6_addr8, remote->addr.ip6_addr.ip, IP6_SIZE);
-		ip6.sin6_family = AF_INET6;
-		ip6.sin6_port = remote->port;
-		rv = sendto(*socket, data, length, 0, (struct sockaddr*)&ip6, sizeof(ip6));
+	socklen = sizeof(addr);
+	rv = recvfrom(*socket, data, length, 0, (struct sockaddr*)&addr, &socklen);
+
+	if(rv < 0)
+		return rv;
+
+	sockaddr_to_remote(&addr, remote);
+	return rv;
+}
+
+static int udp_socket_membership(socket_t *socket, const remote_addr_t *group, bool join)
+{
+	struct ip_mreq mreq;
+	struct ipv6_mreq mreq6;
+	int rv;
+
+	if(socket == NULL || group == NULL)
+		return -EINVALID;
+
+	if(group->version == 6) {
+		memset(&mreq6, 0, sizeof(mreq6));
+		memcpy(mreq6.ipv6mr_multiaddr.s6_addr, group->addr.ip6_addr.ip, IP6_SIZE);
+		rv = setsockopt(*socket, IPPROTO_IPV6, join ? IPV6_JOIN_GROUP : IPV6_LEAVE_GROUP, &mreq6, sizeof(mreq6));
 	} else {
-		ip.sin_family = AF_INET;
-		ip.sin_port = remote->port;
-		ip.sin_addr.s_addr = remote->addr.ip4_addr.ip;
-		rv = sendto(*socket, data, length, 0, (struct sockaddr*)&ip, sizeof(ip));
+		memset(&mreq, 0, sizeof(mreq));
+		mreq.imr_multiaddr.s_addr = group->addr.ip4_addr.ip;
+		mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+		rv = setsockopt(*socket, IPPROTO_IP, join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP, &mreq, sizeof(mreq));
 	}
 
-	return rv;
+	return rv < 0 ? -EINVALID : -EOK;
 }
 
-ssize_t udp_recv_from(socket_t* socket, void *data, size_t length, remote_addr_t* remote)
+int udp_socket_join_group(socket_t *socket, const remote_addr_t *group)
 {
-	struct sockaddr_in ip;
-	struct sockaddr_in6 ip6;
-	ssize_t rv;
+	return udp_socket_membership(socket, group, true);
+}
+
+int udp_socket_leave_group(socket_t *socket, const remote_addr_t *group)
+{
+	return udp_socket_membership(socket, group, false);
+}
+
+ssize_t udp_broadcast(socket_t *socket, const void *data, size_t length, uint16_t port)
+{
+	remote_addr_t remote;
+	int enable = 1;
+
+	if(socket == NULL)
+		return -EINVALID;
+
+	if(setsockopt(*socket, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable)) < 0)
+		return -EINVALID;
+
+	memset(&remote, 0, sizeof(remote));
+	remote.version = 4;
+	remote.port = port;
+	remote.addr.ip4_addr.ip = htonl(INADDR_BROADCAST);
+
+	return udp_send_to(socket, data, length, &remote);
+}
+
+static ssize_t udp_batch_error(void)
+{
+	return errno == EAGAIN || errno == EWOULDBLOCK ? -ETMO : -EINVALID;
+}
+
+#ifdef __linux__
+/*
+ * Datagrams are moved UDP_BATCH_SIZE at a time with a single system call. Only the first
+ * datagram is waited for, the rest of the batch takes whatever is already queued.
+ */
+ssize_t udp_recv_batch(socket_t *socket, socket_datagram_t *datagrams, size_t num)
+{
+	struct mmsghdr msgs[UDP_BATCH_SIZE];
+	struct iovec iov[UDP_BATCH_SIZE];
+	struct sockaddr_storage addrs[UDP_BATCH_SIZE];
+	size_t received, chunk, idx;
+	int flags, rv;
+
+	assert(socket);
+	assert(datagrams || num == 0);
+
+	flags = MSG_WAITFORONE;
+
+	for(received = 0; received < num; received += (size_t) rv) {
+		chunk = num - received;
+		if(chunk > UDP_BATCH_SIZE)
+			chunk = UDP_BATCH_SIZE;
+
+		memset(msgs, 0, sizeof(msgs[0]) * chunk);
+
+		for(idx = 0; idx < chunk; idx++) {
+			iov[idx].iov_base = datagrams[received + idx].data;
+			iov[idx].iov_len = datagrams[received + idx].length;
+			msgs[idx].msg_hdr.msg_iov = &iov[idx];
+			msgs[idx].msg_hdr.msg_iovlen = 1;
+			msgs[idx].msg_hdr.msg_name = &addrs[idx];
+			msgs[idx].msg_hdr.msg_namelen = sizeof(addrs[idx]);
+		}
+
+		rv = recvmmsg(*socket, msgs, (unsigned int) chunk, flags, NULL);
+
+		if(rv <= 0) {
+			if(received == 0)
+				return udp_batch_error();
+
+			break;
+		}
+
+		for(idx = 0; idx < (size_t) rv; idx++) {
+			datagrams[received + idx].length = msgs[idx].msg_len;
+			sockaddr_to_remote(&addrs[idx], &datagrams[received + idx].remote);
+		}
+
+		if((size_t) rv < chunk) {
+			received += (size_t) rv;
+			break;
+		}
+
+		flags = MSG_DONTWAIT;
+	}
+
+	return (ssize_t) received;
+}
+
+ssize_t udp_send_batch(socket_t *socket, const socket_datagram_t *datagrams, size_t num)
+{
+	struct mmsghdr msgs[UDP_BATCH_SIZE];
+	struct iovec iov[UDP_BATCH_SIZE];
+	struct sockaddr_storage addrs[UDP_BATCH_SIZE];
+	size_t sent, chunk, idx;
+	int rv;
+
+	assert(socket);
+	assert(datagrams || num == 0);
+
+	for(sent = 0; sent < num; sent += (size_t) rv) {
+		chunk = num - sent;
+		if(chunk > UDP_BATCH_SIZE)
+			chunk = UDP_BATCH_SIZE;
+
+		memset(msgs, 0, sizeof(msgs[0]) * chunk);
+
+		for(idx = 0; idx < chunk; idx++) {
+			iov[idx].iov_base = datagrams[sent + idx].data;
+			iov[idx].iov_len = datagrams[sent + idx].length;
+			msgs[idx].msg_hdr.msg_iov = &iov[idx];
+			msgs[idx].msg_hdr.msg_iovlen = 1;
+			msgs[idx].msg_hdr.msg_name = &addrs[idx];
+			msgs[idx].msg_hdr.msg_namelen = remote_to_sockaddr(&datagrams[sent + idx].remote, &addrs[idx]);
+		}
+
+		rv = sendmmsg(*socket, msgs, (unsigned int) chunk, 0);
+
+		if(rv <= 0) {
+			if(sent == 0)
+				return udp_batch_error();
+
+			break;
+		}
+	}
+
+	return (ssize_t) sent;
+}
+#else
+ssize_t udp_recv_batch(socket_t *socket, socket_datagram_t *datagrams, size_t num)
+{
+	struct sockaddr_storage addr;
 	socklen_t socklen;
+	size_t idx;
+	ssize_t rv;
 
-	if(remote->version == 6) {
-		socklen = sizeof(ip6);
-		rv = recvfrom(*socket, data, length, 0, (struct sockaddr*)&ip6, &socklen);
+	assert(socket);
+	assert(datagrams || num == 0);
 
-		if(rv < 0)
-			return rv;
+	for(idx = 0; idx < num; idx++) {
+		socklen = sizeof(addr);
+		rv = recvfrom(*socket, datagrams[idx].data, datagrams[idx].length, idx == 0 ? 0 : MSG_DONTWAIT,
+				(struct sockaddr*) &addr, &socklen);
 
-		remote->port = ip6.sin6_port;
-		memcpy(remote->addr.ip6_addr.ip, ip6.sin6_addr.__in6_u.__u6_addr8, IP6_SIZE);
-	} else {
-		socklen = sizeof(ip);
-		rv = recvfrom(*socket, data, length, 0, (struct sockaddr*)&ip, &socklen);
+		if(rv < 0) {
+			if(idx == 0)
+				return udp_batch_error();
 
-		if(rv < 0)
-			return rv;
+			break;
+		}
 
-		remote->port = ip.sin_port;
-		remote->addr.ip4_addr.ip = ip.sin_addr.s_addr;
+		datagrams[idx].length = (size_t) rv;
+		sockaddr_to_remote(&addr, &datagrams[idx].remote);
 	}
 
-	return rv;
+	return (ssize_t) idx;
 }
 
+ssize_t udp_send_batch(socket_t *socket, const socket_datagram_t *datagrams, size_t num)
+{
+	struct sockaddr_storage addr;
+	socklen_t socklen;
+	size_t idx;
+
+	assert(socket);
+	assert(datagrams || num == 0);
+
+	for(idx = 0; idx < num; idx++) {
+		socklen = remote_to_sockaddr(&datagrams[idx].remote, &addr);
+
+		if(sendto(*socket, datagrams[idx].data, datagrams[idx].length, 0, (struct sockaddr*) &addr, socklen) < 0) {
+			if(idx == 0)
+				return udp_batch_error();
+
+			break;
+		}
+	}
+
+	return (ssize_t) idx;
+}
+#endif
+
 void socket_close(socket_t* socket)
 {
 	assert(socket);
@@ -201,12 +884,67 @@ void socket_close(socket_t* socket)
 	lwiot_mem_free(socket);
 }
 
+#ifndef CONFIG_SOCKET_POLL_STACK
+#define CONFIG_SOCKET_POLL_STACK 16
+#endif
+
+int socket_poll(socket_poll_t *sockets, size_t num, int tmo)
+{
+	struct pollfd local[CONFIG_SOCKET_POLL_STACK], *fds;
+	size_t idx;
+	int rv;
+
+	if(sockets == NULL || num == 0)
+		return -EINVALID;
+
+	/* Small sets, the common case, are polled without touching the heap. */
+	fds = num <= CONFIG_SOCKET_POLL_STACK ? local : lwiot_mem_alloc(num * sizeof(*fds));
+
+	if(fds == NULL)
+		return -ENOMEMORY;
+
+	for(idx = 0; idx < num; idx++) {
+		fds[idx].fd = *sockets[idx].socket;
+		fds[idx].events = 0;
+		fds[idx].revents = 0;
+
+		if(sockets[idx].events & SOCKET_POLL_READ)
+			fds[idx].events |= POLLIN;
+
+		if(sockets[idx].events & SOCKET_POLL_WRITE)
+			fds[idx].events |= POLLOUT;
+	}
+
+	do {
+		rv = poll(fds, num, tmo == FOREVER ? -1 : (tmo < 0 ? 0 : tmo));
+	} while(rv < 0 && errno == EINTR);
+
+	for(idx = 0; rv >= 0 && idx < num; idx++) {
+		sockets[idx].revents = 0;
+
+		if(fds[idx].revents & POLLIN)
+			sockets[idx].revents |= SOCKET_POLL_READ;
+
+		if(fds[idx].revents & POLLOUT)
+			sockets[idx].revents |= SOCKET_POLL_WRITE;
+
+		if(fds[idx].revents & (POLLERR | POLLHUP | POLLNVAL))
+			sockets[idx].revents |= SOCKET_POLL_ERROR;
+	}
+
+	if(fds != local)
+		lwiot_mem_free(fds);
+
+	return rv < 0 ? -EINVALID : rv;
+}
+
 /* SERVER OPS */
 socket_t* server_socket_create(socket_type_t type, bool ipv6)
 {
 	socket_t *sock;
 	int fd;
 	int domain;
+	int enable = 1;
 
 	if(ipv6)
 		domain = PF_INET6;
@@ -217,6 +955,10 @@ socket_t* server_socket_create(socket_type_t type, bool ipv6)
 		fd = socket(domain, SOCK_DGRAM, 0);
 	} else {
 		fd = socket(domain, SOCK_STREAM, 0);
+
+		/* Rebinding must not wait for connections the server closed to leave TIME_WAIT. */
+		if(fd >= 0)
+			setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
 	}
 
 	if(fd < 0) {
@@ -261,6 +1003,7 @@ static bool bind_ipv4(const socket_t* sock, remote_addr_t* addr, uint16_t port)
 	fd = *sock;
 	assert(fd >= 0);
 
+	memset(&server, 0, sizeof(server));
 	server.sin_port = port;
 	server.sin_family = AF_INET;
 	server.sin_addr.s_addr = addr->addr.ip4_addr.ip;
@@ -271,14 +1014,19 @@ static bool bind_ipv4(const socket_t* sock, remote_addr_t* addr, uint16_t port)
 static bool bind_ipv6(const socket_t* sock, remote_addr_t* addr, uint16_t port)
 {
 	int fd;
+	int v6only = 0;
 	struct sockaddr_in6 server;
 
 	fd = *sock;
 	assert(fd >= 0);
 
+	/* Listen on IPv4 as well, whatever the system default is. */
+	setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof(v6only));
+
+	memset(&server, 0, sizeof(server));
 	server.sin6_port = port;
 	server.sin6_family = AF_INET6;
-	memcpy(server.sin6_addr.__in6_u.__u6_addr8, addr->addr.ip6_addr.ip, sizeof(addr->addr.ip6_addr.ip));
+	memcpy(server.sin6_addr.s6_addr, addr->addr.ip6_addr.ip, sizeof(addr->addr.ip6_addr.ip));
 
 	return bind(fd, (struct sockaddr*)&server, sizeof(server)) < 0 ? false : true;
 }
@@ -304,11 +1052,15 @@ bool server_socket_bind(socket_t* sock, bind_addr_t addr, uint16_t port)
 		return bind_ipv4(sock, &remote, port);
 
 	case BIND_ADDR_LB:
-		remote.addr.ip4_addr.ip = INADDR_LOOPBACK;
+		remote.addr.ip4_addr.ip = htonl(INADDR_LOOPBACK);
 		return bind_ipv4(sock, &remote, port);
 
 	case BIND6_ADDR_ANY:
-		memcpy(remote.addr.ip6_addr.ip, in6addr_any.__in6_u.__u6_addr8, sizeof(remote.addr.ip6_addr.ip));
+		memcpy(remote.addr.ip6_addr.ip, in6addr_any.s6_addr, sizeof(remote.addr.ip6_addr.ip));
+		return bind_ipv6(sock, &remote, port);
+
+	case BIND6_ADDR_LB:
+		memcpy(remote.addr.ip6_addr.ip, in6addr_loopback.s6_addr, sizeof(remote.addr.ip6_addr.ip));
 		return bind_ipv6(sock, &remote, port);
 	}
 }
@@ -340,6 +1092,33 @@ socket_t* server_socket_accept(socket_t* socket)
 	return client;
 }
 
+size_t server_socket_accept_many(socket_t *socket, socket_t **clients, size_t num)
+{
+	struct pollfd pfd;
+	size_t idx;
+
+	assert(socket);
+	assert(clients || num == 0);
+
+	for(idx = 0; idx < num; idx++) {
+		if(idx > 0) {
+			pfd.fd = *socket;
+			pfd.events = POLLIN;
+			pfd.revents = 0;
+
+			if(poll(&pfd, 1, 0) <= 0 || (pfd.revents & POLLIN) == 0)
+				break;
+		}
+
+		clients[idx] = server_socket_accept(socket);
+
+		if(clients[idx] == NULL)
+			break;
+	}
+
+	return idx;
+}
+
 /* DNS */
 int dns_resolve_host(const char *host, remote_addr_t* addr)
 {
@@ -372,3 +1151,48 @@ int dns_resolve_host(const char *host, remote_addr_t* addr)
 	return -EOK;
 }
 
+int dns_resolve_host_all(const char *host, remote_addr_t *addrs, size_t num)
+{
+	struct addrinfo hints, *res, *p, *next[2];
+	size_t count;
+	int family, turn;
+
+	memset(&hints, 0, sizeof hints);
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	if(getaddrinfo(host, NULL, &hints, &res) != 0)
+		return -EINVALID;
+
+	/* Alternate between the families, starting with the one the resolver prefers. */
+	family = res->ai_family;
+	next[0] = next[1] = res;
+	count = 0;
+	turn = 0;
+
+	while(count < num) {
+		p = next[turn];
+
+		while(p != NULL && (p->ai_family == family) != (turn == 0))
+			p = p->ai_next;
+
+		if(p == NULL) {
+			next[turn] = NULL;
+
+			if(next[turn ^ 1] == NULL)
+				break;
+
+			turn ^= 1;
+			continue;
+		}
+
+		sockaddr_to_remote((const struct sockaddr_storage*) p->ai_addr, &addrs[count++]);
+		next[turn] = p->ai_next;
+
+		if(next[turn ^ 1] != NULL)
+			turn ^= 1;
+	}
+
+	freeaddrinfo(res);
+	return (int) count;
+}
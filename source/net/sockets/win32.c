@@ -18,6 +18,7 @@
 #include <lwiot/network/stdnet.h>
 
 #include <WS2tcpip.h>
+#include <mstcpip.h>
 #include <Windows.h>
 
 #pragma comment(lib, "Ws2_32.lib")
@@ -25,58 +26,743 @@
 #define IP6_SIZE 16
 
 #ifndef CONFIG_CLIENT_QUEUE_LENGTH
-#define CONFIG_CLIENT_QUEUE_LENGTH 10
+#define CONFIG_CLIENT_QUEUE_LENGTH SOMAXCONN
 #endif
 
-static bool ip4_connect(socket_t* sock, remote_addr_t* addr)
+#ifndef CONFIG_CONNECT_ATTEMPT_DELAY
+#define CONFIG_CONNECT_ATTEMPT_DELAY 250
+#endif
+
+#define CONNECT_ATTEMPTS_MAX 8
+#define SENDV_BUFFERS_MAX 16
+
+#ifdef CONFIG_WIN32_IOCP
+#include <MSWSock.h>
+
+#ifndef CONFIG_WIN32_IOCP_THREADS
+#define CONFIG_WIN32_IOCP_THREADS 0 /* One per processor. */
+#endif
+
+/* Poll interval for write readiness, which the completion port does not report. */
+#define IOCP_WRITE_INTERVAL 10
+#define IOCP_ADDRESS_LENGTH (sizeof(struct sockaddr_storage) + 16)
+
+#define IOCP_READABLE 0x1U
+#define IOCP_ERROR    0x2U
+
+/*
+ * Readiness is emulated with an overlapped zero byte WSARecv (or AcceptEx on listeners) per
+ * socket. Its completion marks the socket readable, after which the data is read synchronously,
+ * so the buffers of the caller never have to outlive a call. The probe is armed again by the
+ * first socket_poll() after the socket was read, which makes readiness level triggered like
+ * WSAPoll.
+ *
+ * The socket_t handed out is the first member of the state, and the state is reference
+ * counted, so that a completion of a socket that was closed in the meantime does not touch freed
+ * memory. The port and its threads live until the process exits.
+ */
+typedef struct iocp_socket {
+	socket_t fd;
+	volatile LONG refs;
+	OVERLAPPED overlapped;
+	uint32_t flags;
+	bool pending;
+	bool associated;
+	bool fallback;
+	bool datagram;
+	bool listener;
+	bool closed;
+	int family;
+	SOCKET accepted;
+	char addresses[2 * IOCP_ADDRESS_LENGTH];
+} iocp_socket_t;
+
+static struct {
+	INIT_ONCE once;
+	HANDLE port;
+	CRITICAL_SECTION lock;
+	CONDITION_VARIABLE completed;
+	uint32_t generation;
+	LPFN_ACCEPTEX accept;
+} iocp = { INIT_ONCE_STATIC_INIT };
+
+static iocp_socket_t *iocp_socket(socket_t *socket)
 {
-	struct sockaddr_in sockaddr;
-	const char enable = 1;
+	return (iocp_socket_t*) socket;
+}
+
+static void iocp_release(iocp_socket_t *state)
+{
+	if(InterlockedDecrement(&state->refs) != 0)
+		return;
+
+	if(state->accepted != INVALID_SOCKET)
+		closesocket(state->accepted);
+
+	lwiot_mem_free(state);
+}
+
+static DWORD WINAPI iocp_worker(LPVOID arg)
+{
+	iocp_socket_t *state;
+	OVERLAPPED *overlapped;
+	ULONG_PTR key;
+	DWORD bytes;
+	BOOL ok;
+
+	UNUSED(arg);
+
+	for(;;) {
+		overlapped = NULL;
+		ok = GetQueuedCompletionStatus(iocp.port, &bytes, &key, &overlapped, INFINITE);
+
+		if(overlapped == NULL)
+			break;
+
+		state = CONTAINING_RECORD(overlapped, iocp_socket_t, overlapped);
+		EnterCriticalSection(&iocp.lock);
+		state->pending = false;
+
+		/* Failed datagram probes are reported by the next recvfrom(), e.g. an ICMP port unreachable. */
+		if(ok || state->datagram) {
+			state->flags |= IOCP_READABLE;
+		} else if(!state->closed) {
+			state->flags |= IOCP_ERROR;
+		}
+
+		if(!ok && state->accepted != INVALID_SOCKET) {
+			closesocket(state->accepted);
+			state->accepted = INVALID_SOCKET;
+		}
+
+		iocp.generation++;
+		LeaveCriticalSection(&iocp.lock);
+		WakeAllConditionVariable(&iocp.completed);
+
+		iocp_release(state);
+	}
+
+	return 0;
+}
+
+static BOOL CALLBACK iocp_init(PINIT_ONCE once, PVOID param, PVOID *context)
+{
+	SYSTEM_INFO info;
+	DWORD threads, idx;
+	HANDLE thread;
+
+	UNUSED(once);
+	UNUSED(param);
+	UNUSED(context);
 
-	sockaddr.sin_family = AF_INET;
-	sockaddr.sin_port = addr->port;
-	sockaddr.sin_addr.s_addr = addr->addr.ip4_addr.ip;
-	memset(&sockaddr.sin_zero, 0, sizeof(sockaddr.sin_zero));
+	threads = CONFIG_WIN32_IOCP_THREADS;
+
+	if(threads == 0) {
+		GetSystemInfo(&info);
+		threads = info.dwNumberOfProcessors;
+	}
+
+	InitializeCriticalSection(&iocp.lock);
+	InitializeConditionVariable(&iocp.completed);
+	iocp.port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, threads);
+
+	if(iocp.port == NULL)
+		return TRUE;
+
+	for(idx = 0; idx < threads; idx++) {
+		thread = CreateThread(NULL, 0, iocp_worker, NULL, 0, NULL);
+
+		if(thread == NULL) {
+			print_dbg("Unable to start completion port thread: %lu\n", GetLastError());
+			continue;
+		}
+
+		CloseHandle(thread);
+	}
+
+	return TRUE;
+}
+
+static bool iocp_start(void)
+{
+	InitOnceExecuteOnce(&iocp.once, iocp_init, NULL, NULL);
+	return iocp.port != NULL;
+}
+
+static int iocp_post_accept(iocp_socket_t *state)
+{
+	GUID guid = WSAID_ACCEPTEX;
+	LPFN_ACCEPTEX accept;
+	DWORD bytes;
+
+	if(iocp.accept == NULL) {
+		if(WSAIoctl(state->fd, SIO_GET_EXTENSION_FUNCTION_POINTER, &guid, sizeof(guid),
+				&accept, sizeof(accept), &bytes, NULL, NULL) != 0)
+			return -ENOTSUPPORTED;
+
+		iocp.accept = accept;
+	}
+
+	state->accepted = WSASocket(state->family, SOCK_STREAM, IPPROTO_TCP, NULL, 0, WSA_FLAG_OVERLAPPED);
+
+	if(state->accepted == INVALID_SOCKET)
+		return -ENOMEMORY;
+
+	if(!iocp.accept(state->fd, state->accepted, state->addresses, 0, IOCP_ADDRESS_LENGTH,
+			IOCP_ADDRESS_LENGTH, &bytes, &state->overlapped) && WSAGetLastError() != ERROR_IO_PENDING) {
+		closesocket(state->accepted);
+		state->accepted = INVALID_SOCKET;
+		return -EINVALID;
+	}
+
+	return -EOK;
+}
 
-	*sock = socket(AF_INET, SOCK_STREAM, 0);
-	if(*sock < 0)
+static int iocp_post_probe(iocp_socket_t *state)
+{
+	WSABUF buffer;
+	DWORD bytes, flags;
+
+	buffer.buf = NULL;
+	buffer.len = 0;
+	bytes = 0;
+
+	/* A zero byte read would discard the datagram. */
+	flags = state->datagram ? MSG_PEEK : 0;
+
+	if(WSARecv(state->fd, &buffer, 1, &bytes, &flags, &state->overlapped, NULL) != 0 &&
+			WSAGetLastError() != WSA_IO_PENDING)
+		return -EINVALID;
+
+	return -EOK;
+}
+
+/* Must be called with the lock held. */
+static void iocp_arm(iocp_socket_t *state)
+{
+	int type, length, rv;
+
+	if(state->pending || state->fallback || state->flags != 0)
+		return;
+
+	if(!state->associated) {
+		length = sizeof(type);
+		type = SOCK_STREAM;
+		getsockopt(state->fd, SOL_SOCKET, SO_TYPE, (char *) &type, &length);
+
+		state->datagram = type == SOCK_DGRAM;
+		state->associated = true;
+
+		/* Sockets created elsewhere may not allow overlapped I/O; poll those instead. */
+		if(CreateIoCompletionPort((HANDLE) (SOCKET) state->fd, iocp.port, 0, 0) == NULL) {
+			state->fallback = true;
+			return;
+		}
+	}
+
+	memset(&state->overlapped, 0, sizeof(state->overlapped));
+	InterlockedIncrement(&state->refs);
+	state->pending = true;
+
+	rv = state->listener ? iocp_post_accept(state) : iocp_post_probe(state);
+
+	if(rv != -EOK) {
+		state->pending = false;
+		InterlockedDecrement(&state->refs);
+
+		if(rv == -ENOTSUPPORTED)
+			state->fallback = true;
+		else
+			state->flags |= IOCP_ERROR;
+	}
+}
+
+/* The socket is about to be read: clear its readiness so that the next poll arms a new probe. */
+static void iocp_consume(socket_t *socket)
+{
+	if(!iocp_start())
+		return;
+
+	EnterCriticalSection(&iocp.lock);
+	iocp_socket(socket)->flags &= ~IOCP_READABLE;
+	LeaveCriticalSection(&iocp.lock);
+}
+
+/* Take the connection of a completed AcceptEx, waiting for one that is in progress. */
+static SOCKET iocp_accepted(socket_t *socket)
+{
+	iocp_socket_t *state;
+	SOCKET fd;
+
+	if(!iocp_start())
+		return INVALID_SOCKET;
+
+	state = iocp_socket(socket);
+	EnterCriticalSection(&iocp.lock);
+
+	while(state->pending)
+		SleepConditionVariableCS(&iocp.completed, &iocp.lock, INFINITE);
+
+	fd = state->accepted;
+	state->accepted = INVALID_SOCKET;
+	state->flags &= ~IOCP_READABLE;
+	LeaveCriticalSection(&iocp.lock);
+
+	if(fd != INVALID_SOCKET)
+		setsockopt(fd, SOL_SOCKET, SO_UPDATE_ACCEPT_CONTEXT, (char *) &state->fd, sizeof(SOCKET));
+
+	return fd;
+}
+
+static socket_t *socket_alloc(SOCKET fd)
+{
+	iocp_socket_t *state;
+
+	state = lwiot_mem_zalloc(sizeof(*state));
+	assert(state);
+
+	state->fd = (socket_t) fd;
+	state->refs = 1;
+	state->accepted = INVALID_SOCKET;
+
+	return &state->fd;
+}
+
+static void socket_free(socket_t *socket)
+{
+	iocp_socket_t *state;
+
+	state = iocp_socket(socket);
+
+	if(iocp_start()) {
+		EnterCriticalSection(&iocp.lock);
+		state->closed = true;
+		LeaveCriticalSection(&iocp.lock);
+	}
+
+	/* Cancels the pending probe, whose completion drops the last reference. */
+	closesocket(state->fd);
+	iocp_release(state);
+}
+#else
+static socket_t *socket_alloc(SOCKET fd)
+{
+	socket_t *sock;
+
+	sock = lwiot_mem_zalloc(sizeof(*sock));
+	assert(sock);
+	*sock = (socket_t) fd;
+
+	return sock;
+}
+
+static void socket_free(socket_t *socket)
+{
+	closesocket(*socket);
+	lwiot_mem_free(socket);
+}
+#endif
+
+static bool socket_is_ipv6(SOCKET fd)
+{
+	struct sockaddr_storage addr;
+	int length;
+
+	length = sizeof(addr);
+
+	if(getsockname(fd, (struct sockaddr*)&addr, &length) != 0)
 		return false;
 
-	setsockopt(*sock, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int));
+	return addr.ss_family == AF_INET6;
+}
+
+static int socket_option_level(SOCKET fd, socket_option_t option, int *level, int *name)
+{
+	bool ipv6;
+
+	switch(option) {
+	case SOCKET_OPT_NODELAY:
+		*level = IPPROTO_TCP;
+		*name = TCP_NODELAY;
+		break;
+
+	case SOCKET_OPT_KEEPALIVE:
+		*level = SOL_SOCKET;
+		*name = SO_KEEPALIVE;
+		break;
+
+#ifdef TCP_KEEPIDLE
+	case SOCKET_OPT_KEEPIDLE:
+		*level = IPPROTO_TCP;
+		*name = TCP_KEEPIDLE;
+		break;
+#endif
+
+#ifdef TCP_KEEPINTVL
+	case SOCKET_OPT_KEEPINTVL:
+		*level = IPPROTO_TCP;
+		*name = TCP_KEEPINTVL;
+		break;
+#endif
+
+#ifdef TCP_KEEPCNT
+	case SOCKET_OPT_KEEPCNT:
+		*level = IPPROTO_TCP;
+		*name = TCP_KEEPCNT;
+		break;
+#endif
+
+	case SOCKET_OPT_SNDBUF:
+		*level = SOL_SOCKET;
+		*name = SO_SNDBUF;
+		break;
+
+	case SOCKET_OPT_RCVBUF:
+		*level = SOL_SOCKET;
+		*name = SO_RCVBUF;
+		break;
+
+	case SOCKET_OPT_BROADCAST:
+		*level = SOL_SOCKET;
+		*name = SO_BROADCAST;
+		break;
+
+	case SOCKET_OPT_MULTICAST_TTL:
+		ipv6 = socket_is_ipv6(fd);
+		*level = ipv6 ? IPPROTO_IPV6 : IPPROTO_IP;
+		*name = ipv6 ? IPV6_MULTICAST_HOPS : IP_MULTICAST_TTL;
+		break;
+
+	case SOCKET_OPT_MULTICAST_LOOP:
+		ipv6 = socket_is_ipv6(fd);
+		*level = ipv6 ? IPPROTO_IPV6 : IPPROTO_IP;
+		*name = ipv6 ? IPV6_MULTICAST_LOOP : IP_MULTICAST_LOOP;
+		break;
+
+	default:
+		return -ENOTSUPPORTED;
+	}
+
+	return -EOK;
+}
+
+int socket_set_option(socket_t *sock, socket_option_t option, int value)
+{
+	int level, name;
+
+	if(sock == NULL)
+		return -EINVALID;
+
+	if(socket_option_level(*sock, option, &level, &name) != -EOK)
+		return -ENOTSUPPORTED;
+
+	return setsockopt(*sock, level, name, (char *) &value, sizeof(value)) != 0 ? -EINVALID : -EOK;
+}
+
+int socket_get_option(socket_t *sock, socket_option_t option, int *value)
+{
+	int level, name, length;
+
+	if(sock == NULL || value == NULL)
+		return -EINVALID;
+
+	if(socket_option_level(*sock, option, &level, &name) != -EOK)
+		return -ENOTSUPPORTED;
+
+	length = sizeof(*value);
+	return getsockopt(*sock, level, name, (char *) value, &length) != 0 ? -EINVALID : -EOK;
+}
+
+int socket_tcp_info(socket_t *sock, socket_tcp_info_t *info)
+{
+#ifdef SIO_TCP_INFO
+	TCP_INFO_v0 raw;
+	DWORD version, length;
+
+	if(sock == NULL || info == NULL)
+		return -EINVALID;
+
+	version = 0;
+	length = 0;
+
+	if(WSAIoctl(*sock, SIO_TCP_INFO, &version, sizeof(version), &raw, sizeof(raw), &length, NULL, NULL) != 0)
+		return -EINVALID;
+
+	info->rtt = raw.RttUs;
+	info->rtt_var = 0;
+	info->retransmits = raw.FastRetrans + raw.TimeoutEpisodes;
+	info->cwnd = raw.Mss != 0 ? raw.Cwnd / raw.Mss : 0;
+
+	return -EOK;
+#else
+	UNUSED(sock);
+	UNUSED(info);
+
+	return -ENOTSUPPORTED;
+#endif
+}
+
+bool socket_would_block(void)
+{
+	int error = WSAGetLastError();
+	return error == WSAEWOULDBLOCK || error == WSAETIMEDOUT;
+}
+
+static void sockaddr_to_remote(const struct sockaddr_storage *addr, remote_addr_t *remote)
+{
+	const struct sockaddr_in *ip;
+	const struct sockaddr_in6 *ip6;
+
+	if(addr->ss_family == AF_INET6) {
+		ip6 = (const struct sockaddr_in6*) addr;
+
+		/* Dual stack listeners see IPv4 peers as v4-mapped IPv6 addresses. */
+		if(IN6_IS_ADDR_V4MAPPED(&ip6->sin6_addr)) {
+			remote->version = 4;
+			remote->port = ip6->sin6_port;
+			memcpy(&remote->addr.ip4_addr.ip, ip6->sin6_addr.u.Byte + 12, sizeof(remote->addr.ip4_addr.ip));
+			return;
+		}
+
+		remote->version = 6;
+		remote->port = ip6->sin6_port;
+		memcpy(remote->addr.ip6_addr.ip, ip6->sin6_addr.u.Byte, IP6_SIZE);
+	} else {
+		ip = (const struct sockaddr_in*) addr;
+		remote->version = 4;
+		remote->port = ip->sin_port;
+		remote->addr.ip4_addr.ip = ip->sin_addr.s_addr;
+	}
+}
+
+static int remote_to_sockaddr(const remote_addr_t *remote, struct sockaddr_storage *addr)
+{
+	struct sockaddr_in *ip;
+	struct sockaddr_in6 *ip6;
+
+	memset(addr, 0, sizeof(*addr));
+
+	if(remote->version == 6) {
+		ip6 = (struct sockaddr_in6*) addr;
+		ip6->sin6_family = AF_INET6;
+		ip6->sin6_port = remote->port;
+		memcpy(ip6->sin6_addr.u.Byte, remote->addr.ip6_addr.ip, IP6_SIZE);
+		return sizeof(*ip6);
+	}
+
+	ip = (struct sockaddr_in*) addr;
+	ip->sin_family = AF_INET;
+	ip->sin_port = remote->port;
+	ip->sin_addr.s_addr = remote->addr.ip4_addr.ip;
+	return sizeof(*ip);
+}
+
+static int socket_connect(SOCKET fd, const struct sockaddr *addr, int length, int tmo)
+{
+	WSAPOLLFD pfd;
+	u_long mode;
+	int rv, error, optlen;
+
+	if(tmo == FOREVER)
+		return connect(fd, addr, length) != 0 ? -EINVALID : -EOK;
+
+	mode = 1;
+	ioctlsocket(fd, FIONBIO, &mode);
+	rv = connect(fd, addr, length);
+
+	if(rv != 0 && WSAGetLastError() == WSAEWOULDBLOCK) {
+		pfd.fd = fd;
+		pfd.events = POLLWRNORM;
+		pfd.revents = 0;
+		rv = WSAPoll(&pfd, 1, tmo);
+
+		if(rv == 0) {
+			rv = -ETMO;
+		} else if(rv > 0) {
+			optlen = sizeof(error);
+			error = 0;
+			getsockopt(fd, SOL_SOCKET, SO_ERROR, (char *) &error, &optlen);
+			rv = error == 0 && (pfd.revents & POLLWRNORM) ? -EOK : -EINVALID;
+		} else {
+			rv = -EINVALID;
+		}
+	} else if(rv != 0) {
+		rv = -EINVALID;
+	}
+
+	mode = 0;
+	ioctlsocket(fd, FIONBIO, &mode);
+	return rv;
+}
+
+static SOCKET tcp_socket_open(const remote_addr_t *remote)
+{
+	SOCKET fd;
+	const char enable = 1;
+
+	fd = socket(remote->version == 6 ? AF_INET6 : AF_INET, SOCK_STREAM, 0);
+
+	if(fd != INVALID_SOCKET)
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int));
+
+	return fd;
+}
+
+static bool ip_connect(SOCKET* fd, remote_addr_t* addr, int tmo)
+{
+	struct sockaddr_storage sockaddr;
+	int length;
 
-	if(connect(*sock, (struct sockaddr*) &sockaddr, sizeof(struct sockaddr)) < 0) {
-		closesocket(*sock);
+	length = remote_to_sockaddr(addr, &sockaddr);
+	*fd = tcp_socket_open(addr);
+
+	if(*fd == INVALID_SOCKET)
+		return false;
+
+	if(socket_connect(*fd, (struct sockaddr*) &sockaddr, length, tmo) != -EOK) {
+		closesocket(*fd);
 		return false;
 	}
 
 	return true;
 }
 
-static bool ip6_connect(socket_t* sock, remote_addr_t* addr)
+socket_t* tcp_socket_create_timeout(remote_addr_t* remote, int tmo)
 {
-	print_dbg("IPv6 not yet supported!");
-	return false;
+	SOCKET fd;
+
+	if(!ip_connect(&fd, remote, tmo))
+		return NULL;
+
+	return socket_alloc(fd);
 }
 
 socket_t* tcp_socket_create(remote_addr_t* remote)
 {
-	socket_t *sock;
-	bool result;
+	return tcp_socket_create_timeout(remote, FOREVER);
+}
 
-	sock = lwiot_mem_zalloc(sizeof(sock));
-	assert(sock);
+/* Start a non-blocking connect. Returns INVALID_SOCKET if the attempt failed right away. */
+static SOCKET connect_attempt(const remote_addr_t *remote, bool *connected)
+{
+	struct sockaddr_storage sockaddr;
+	u_long mode = 1;
+	SOCKET fd;
+	int length;
 
-	if(remote->version == 6)
-		result = ip6_connect(sock, remote);
-	else
-		result = ip4_connect(sock, remote);
+	length = remote_to_sockaddr(remote, &sockaddr);
+	fd = tcp_socket_open(remote);
 
-	if(!result) {
-		lwiot_mem_free(sock);
-		return NULL;
+	if(fd == INVALID_SOCKET)
+		return fd;
+
+	ioctlsocket(fd, FIONBIO, &mode);
+	*connected = connect(fd, (struct sockaddr*) &sockaddr, length) == 0;
+
+	if(!*connected && WSAGetLastError() != WSAEWOULDBLOCK) {
+		closesocket(fd);
+		return INVALID_SOCKET;
 	}
 
-	return sock;
+	return fd;
+}
+
+socket_t* tcp_socket_create_any(remote_addr_t* remotes, size_t num, int tmo, size_t *index)
+{
+	WSAPOLLFD fds[CONNECT_ATTEMPTS_MAX];
+	size_t started, active, idx;
+	time_t now, deadline, next;
+	int winner, wait, error, optlen, rv;
+	u_long mode;
+	bool connected;
+
+	if(index != NULL)
+		*index = 0;
+
+	if(num == 1)
+		return tcp_socket_create_timeout(remotes, tmo);
+
+	if(num > CONNECT_ATTEMPTS_MAX)
+		num = CONNECT_ATTEMPTS_MAX;
+
+	now = lwiot_tick_ms();
+	deadline = now + tmo;
+	next = now;
+	started = active = 0;
+	winner = -1;
+
+	while(winner < 0) {
+		now = lwiot_tick_ms();
+
+		if(tmo != FOREVER && now >= deadline)
+			break;
+
+		if(started < num && now >= next) {
+			connected = false;
+			fds[started].fd = connect_attempt(&remotes[started], &connected);
+			fds[started].events = POLLWRNORM;
+			fds[started].revents = 0;
+
+			if(connected)
+				winner = (int) started;
+			else if(fds[started].fd != INVALID_SOCKET)
+				active++;
+
+			started++;
+			next = active > 0 ? now + CONFIG_CONNECT_ATTEMPT_DELAY : now;
+			continue;
+		}
+
+		if(active == 0 && started == num)
+			break;
+
+		wait = started < num ? (int) (next - now) : -1;
+
+		if(tmo != FOREVER && (wait < 0 || deadline - now < wait))
+			wait = (int) (deadline - now);
+
+		/* WSAPoll ignores entries with an invalid socket. */
+		rv = WSAPoll(fds, (ULONG) started, wait);
+
+		if(rv == SOCKET_ERROR)
+			break;
+
+		for(idx = 0; rv > 0 && idx < started; idx++) {
+			if(fds[idx].fd == INVALID_SOCKET || fds[idx].revents == 0)
+				continue;
+
+			optlen = sizeof(error);
+			error = 0;
+			getsockopt(fds[idx].fd, SOL_SOCKET, SO_ERROR, (char *) &error, &optlen);
+
+			if(error == 0 && (fds[idx].revents & POLLWRNORM)) {
+				winner = (int) idx;
+				break;
+			}
+
+			/* Failed attempts make way for the next address immediately. */
+			closesocket(fds[idx].fd);
+			fds[idx].fd = INVALID_SOCKET;
+			active--;
+			next = lwiot_tick_ms();
+		}
+	}
+
+	for(idx = 0; idx < started; idx++) {
+		if(fds[idx].fd != INVALID_SOCKET && (int) idx != winner)
+			closesocket(fds[idx].fd);
+	}
+
+	if(winner < 0)
+		return NULL;
+
+	if(index != NULL)
+		*index = (size_t) winner;
+
+	mode = 0;
+	ioctlsocket(fds[winner].fd, FIONBIO, &mode);
+
+	return socket_alloc(fds[winner].fd);
 }
 
 void socket_set_timeout(socket_t *sock, int tmo)
@@ -100,6 +786,54 @@ ssize_t tcp_socket_send(socket_t* socket, const void* data, size_t length)
 	return send(fd, data, length, 0);
 }
 
+/* Gather the buffers into a single WSASend, SENDV_BUFFERS_MAX at a time. */
+ssize_t tcp_socket_sendv(socket_t* socket, const socket_buffer_t* buffers, size_t num)
+{
+	WSABUF wsabufs[SENDV_BUFFERS_MAX];
+	size_t idx, count, length;
+	ssize_t total;
+	DWORD sent;
+
+	assert(socket);
+	assert(buffers || num == 0);
+
+	total = 0;
+
+	while(num > 0) {
+		count = num < SENDV_BUFFERS_MAX ? num : SENDV_BUFFERS_MAX;
+		length = 0;
+
+		for(idx = 0; idx < count; idx++) {
+			wsabufs[idx].buf = (char *) buffers[idx].data;
+			wsabufs[idx].len = (ULONG) buffers[idx].length;
+			length += buffers[idx].length;
+		}
+
+		if(WSASend(*socket, wsabufs, (DWORD) count, &sent, 0, NULL, NULL) != 0)
+			return total > 0 ? total : -EINVALID;
+
+		total += sent;
+
+		if(sent < length)
+			break;
+
+		buffers += count;
+		num -= count;
+	}
+
+	return total;
+}
+
+ssize_t tcp_socket_sendfile(socket_t* socket, int fd, size_t offset, size_t length)
+{
+	UNUSED(socket);
+	UNUSED(fd);
+	UNUSED(offset);
+	UNUSED(length);
+
+	return -ENOTSUPPORTED;
+}
+
 ssize_t tcp_socket_read(socket_t* socket, void* data, size_t length)
 {
 	int fd;
@@ -111,95 +845,294 @@ ssize_t tcp_socket_read(socket_t* socket, void* data, size_t length)
 	if(length == 0)
 		return 0;
 
+#ifdef CONFIG_WIN32_IOCP
+	iocp_consume(socket);
+#endif
 	return recv(fd, data, length, 0);
 }
 
 socket_t* udp_socket_create(remote_addr_t* remote)
 {
-	socket_t *sock;
 	int fd;
 
-	sock = lwiot_mem_zalloc(sizeof(sock));
-	assert(sock);
-
 	if(remote->version == 6) {
 		fd = socket(PF_INET6, SOCK_DGRAM, 0);
 	} else {
 		fd = socket(PF_INET, SOCK_DGRAM, 0);
 	}
 
-	if(fd < 0) {
-		lwiot_mem_free(sock);
+	if(fd < 0)
 		return NULL;
-	}
-
-	*sock = fd;
 
-	return sock;
+	return socket_alloc(fd);
 }
 
 ssize_t udp_send_to(socket_t* socket, const void *data, size_t length, remote_addr_t* remote)
 {
-	struct sockaddr_in ip;
-	struct sockaddr_in6 ip6;
+	struct sockaddr_storage addr;
+	int socklen;
+
+	socklen = remote_to_sockaddr(remote, &addr);
+	return sendto(*socket, data, (int) length, 0, (struct sockaddr*)&addr, socklen);
+}
+
+ssize_t udp_recv_from(socket_t* socket, void *data, size_t length, remote_addr_t* remote)
+{
+	struct sockaddr_storage addr;
+	socklen_t socklen;
 	ssize_t rv;
 
-	if(remote->version == 6) {
-		memcpy(ip6.sin6_addr.u.Byte, remote->addr.ip6_addr.ip, IP6_SIZE);
-		ip6.sin6_family = AF_INET6;
-		ip6.sin6_port = remote->port;
-		rv = sendto(*socket, data, length, 0, (struct sockaddr*)&ip6, sizeof(ip6));
+	socklen = sizeof(addr);
+#ifdef CONFIG_WIN32_IOCP
+	iocp_consume(socket);
+#endif
+	rv = recvfrom(*socket, data, (int) length, 0, (struct sockaddr*)&addr, &socklen);
+
+	if(rv < 0)
+		return rv;
+
+	sockaddr_to_remote(&addr, remote);
+	return rv;
+}
+
+static int udp_socket_membership(socket_t *socket, const remote_addr_t *group, bool join)
+{
+	struct ip_mreq mreq;
+	struct ipv6_mreq mreq6;
+	int rv;
+
+	if(socket == NULL || group == NULL)
+		return -EINVALID;
+
+	if(group->version == 6) {
+		memset(&mreq6, 0, sizeof(mreq6));
+		memcpy(mreq6.ipv6mr_multiaddr.s6_addr, group->addr.ip6_addr.ip, IP6_SIZE);
+		rv = setsockopt(*socket, IPPROTO_IPV6, join ? IPV6_JOIN_GROUP : IPV6_LEAVE_GROUP,
+			(char *) &mreq6, sizeof(mreq6));
 	} else {
-		ip.sin_family = AF_INET;
-		ip.sin_port = remote->port;
-		ip.sin_addr.s_addr = remote->addr.ip4_addr.ip;
-		rv = sendto(*socket, data, length, 0, (struct sockaddr*)&ip, sizeof(ip));
+		memset(&mreq, 0, sizeof(mreq));
+		mreq.imr_multiaddr.s_addr = group->addr.ip4_addr.ip;
+		mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+		rv = setsockopt(*socket, IPPROTO_IP, join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP,
+			(char *) &mreq, sizeof(mreq));
 	}
 
-	return rv;
+	return rv != 0 ? -EINVALID : -EOK;
 }
 
-ssize_t udp_recv_from(socket_t* socket, void *data, size_t length, remote_addr_t* remote)
+int udp_socket_join_group(socket_t *socket, const remote_addr_t *group)
 {
-	struct sockaddr_in ip;
-	struct sockaddr_in6 ip6;
-	ssize_t rv;
-	socklen_t socklen;
+	return udp_socket_membership(socket, group, true);
+}
 
-	if(remote->version == 6) {
-		socklen = sizeof(ip6);
-		rv = recvfrom(*socket, data, length, 0, (struct sockaddr*)&ip6, &socklen);
+int udp_socket_leave_group(socket_t *socket, const remote_addr_t *group)
+{
+	return udp_socket_membership(socket, group, false);
+}
 
-		if(rv < 0)
-			return rv;
+ssize_t udp_broadcast(socket_t *socket, const void *data, size_t length, uint16_t port)
+{
+	remote_addr_t remote;
+	int enable = 1;
 
-		remote->port = ip6.sin6_port;
-		memcpy(remote->addr.ip6_addr.ip, ip6.sin6_addr.u.Byte, IP6_SIZE);
-	} else {
-		socklen = sizeof(ip);
-		rv = recvfrom(*socket, data, length, 0, (struct sockaddr*)&ip, &socklen);
+	if(socket == NULL)
+		return -EINVALID;
 
-		if(rv < 0)
-			return rv;
+	if(setsockopt(*socket, SOL_SOCKET, SO_BROADCAST, (char *) &enable, sizeof(enable)) != 0)
+		return -EINVALID;
 
-		remote->port = ip.sin_port;
-		remote->addr.ip4_addr.ip = ip.sin_addr.s_addr;
-	}
+	memset(&remote, 0, sizeof(remote));
+	remote.version = 4;
+	remote.port = port;
+	remote.addr.ip4_addr.ip = htonl(INADDR_BROADCAST);
 
-	return rv;
+	return udp_send_to(socket, data, length, &remote);
 }
 
 void socket_close(socket_t* socket)
 {
 	assert(socket);
-	closesocket(*socket);
-	lwiot_mem_free(socket);
+	socket_free(socket);
+}
+
+#ifndef CONFIG_SOCKET_POLL_STACK
+#define CONFIG_SOCKET_POLL_STACK 16
+#endif
+
+#ifdef CONFIG_WIN32_IOCP
+/* Write readiness, and read readiness of sockets without a probe, straight from the stack. */
+static int iocp_poll_direct(socket_poll_t *sockets, size_t num, WSAPOLLFD *fds)
+{
+	iocp_socket_t *state;
+	size_t idx;
+	int rv;
+
+	for(idx = 0; idx < num; idx++) {
+		state = iocp_socket(sockets[idx].socket);
+		fds[idx].fd = INVALID_SOCKET;
+		fds[idx].events = 0;
+		fds[idx].revents = 0;
+
+		if(sockets[idx].events & SOCKET_POLL_WRITE)
+			fds[idx].events |= POLLWRNORM;
+
+		if(state->fallback && (sockets[idx].events & SOCKET_POLL_READ))
+			fds[idx].events |= POLLRDNORM;
+
+		if(fds[idx].events != 0)
+			fds[idx].fd = state->fd;
+	}
+
+	rv = WSAPoll(fds, (ULONG) num, 0);
+
+	for(idx = 0; rv > 0 && idx < num; idx++) {
+		if(fds[idx].revents & POLLRDNORM)
+			sockets[idx].revents |= SOCKET_POLL_READ;
+
+		if(fds[idx].revents & POLLWRNORM)
+			sockets[idx].revents |= SOCKET_POLL_WRITE;
+
+		if(fds[idx].revents & (POLLERR | POLLHUP | POLLNVAL))
+			sockets[idx].revents |= SOCKET_POLL_ERROR;
+	}
+
+	return rv == SOCKET_ERROR ? -EINVALID : -EOK;
 }
 
+int socket_poll(socket_poll_t *sockets, size_t num, int tmo)
+{
+	WSAPOLLFD local[CONFIG_SOCKET_POLL_STACK], *fds;
+	iocp_socket_t *state;
+	uint32_t generation;
+	time_t deadline, now;
+	bool direct;
+	size_t idx;
+	DWORD wait;
+	int ready;
+
+	if(sockets == NULL || num == 0)
+		return -EINVALID;
+
+	if(!iocp_start())
+		return -EINVALID;
+
+	fds = num <= CONFIG_SOCKET_POLL_STACK ? local : lwiot_mem_alloc(num * sizeof(*fds));
+
+	if(fds == NULL)
+		return -ENOMEMORY;
+
+	deadline = lwiot_tick_ms() + tmo;
+	ready = 0;
+
+	for(;;) {
+		direct = false;
+		EnterCriticalSection(&iocp.lock);
+
+		for(idx = 0; idx < num; idx++) {
+			state = iocp_socket(sockets[idx].socket);
+			sockets[idx].revents = 0;
+
+			if(sockets[idx].events & SOCKET_POLL_READ)
+				iocp_arm(state);
+
+			if((sockets[idx].events & SOCKET_POLL_READ) && (state->flags & IOCP_READABLE))
+				sockets[idx].revents |= SOCKET_POLL_READ;
+
+			if(state->flags & IOCP_ERROR)
+				sockets[idx].revents |= SOCKET_POLL_ERROR;
+
+			if((sockets[idx].events & SOCKET_POLL_WRITE) || state->fallback)
+				direct = true;
+		}
+
+		generation = iocp.generation;
+		LeaveCriticalSection(&iocp.lock);
+
+		if(direct && iocp_poll_direct(sockets, num, fds) != -EOK) {
+			ready = -EINVALID;
+			break;
+		}
+
+		for(idx = 0; idx < num; idx++) {
+			if(sockets[idx].revents != 0)
+				ready++;
+		}
+
+		now = lwiot_tick_ms();
+
+		if(ready > 0 || tmo < 0 || (tmo != FOREVER && now >= deadline))
+			break;
+
+		wait = tmo == FOREVER ? INFINITE : (DWORD) (deadline - now);
+
+		if(direct && wait > IOCP_WRITE_INTERVAL)
+			wait = IOCP_WRITE_INTERVAL;
+
+		EnterCriticalSection(&iocp.lock);
+
+		if(generation == iocp.generation)
+			SleepConditionVariableCS(&iocp.completed, &iocp.lock, wait);
+
+		LeaveCriticalSection(&iocp.lock);
+	}
+
+	if(fds != local)
+		lwiot_mem_free(fds);
+
+	return ready;
+}
+#else
+int socket_poll(socket_poll_t *sockets, size_t num, int tmo)
+{
+	WSAPOLLFD local[CONFIG_SOCKET_POLL_STACK], *fds;
+	size_t idx;
+	int rv;
+
+	if(sockets == NULL || num == 0)
+		return -EINVALID;
+
+	fds = num <= CONFIG_SOCKET_POLL_STACK ? local : lwiot_mem_alloc(num * sizeof(*fds));
+
+	if(fds == NULL)
+		return -ENOMEMORY;
+
+	for(idx = 0; idx < num; idx++) {
+		fds[idx].fd = *sockets[idx].socket;
+		fds[idx].events = 0;
+		fds[idx].revents = 0;
+
+		if(sockets[idx].events & SOCKET_POLL_READ)
+			fds[idx].events |= POLLRDNORM;
+
+		if(sockets[idx].events & SOCKET_POLL_WRITE)
+			fds[idx].events |= POLLWRNORM;
+	}
+
+	rv = WSAPoll(fds, (ULONG) num, tmo == FOREVER ? -1 : (tmo < 0 ? 0 : tmo));
+
+	for(idx = 0; rv != SOCKET_ERROR && idx < num; idx++) {
+		sockets[idx].revents = 0;
+
+		if(fds[idx].revents & POLLRDNORM)
+			sockets[idx].revents |= SOCKET_POLL_READ;
+
+		if(fds[idx].revents & POLLWRNORM)
+			sockets[idx].revents |= SOCKET_POLL_WRITE;
+
+		if(fds[idx].revents & (POLLERR | POLLHUP | POLLNVAL))
+			sockets[idx].revents |= SOCKET_POLL_ERROR;
+	}
+
+	if(fds != local)
+		lwiot_mem_free(fds);
+
+	return rv == SOCKET_ERROR ? -EINVALID : rv;
+}
+#endif
+
 /* SERVER OPS */
 socket_t* server_socket_create(socket_type_t type, bool ipv6)
 {
-	socket_t *sock;
 	int fd;
 	int domain;
 
@@ -219,10 +1152,7 @@ socket_t* server_socket_create(socket_type_t type, bool ipv6)
 		return NULL;
 	}
 
-	sock = lwiot_mem_zalloc(sizeof(sock));
-	*sock = fd;
-
-	return sock;
+	return socket_alloc(fd);
 }
 
 static size_t socket_available(const socket_t* socket)
@@ -249,6 +1179,65 @@ size_t udp_socket_available(socket_t* socket)
 	return socket_available(socket);
 }
 
+/* Winsock has no batched datagram calls: only datagrams that are already queued are taken after the first. */
+ssize_t udp_recv_batch(socket_t *socket, socket_datagram_t *datagrams, size_t num)
+{
+	struct sockaddr_storage addr;
+	socklen_t socklen;
+	size_t idx;
+	int rv;
+
+	assert(socket);
+	assert(datagrams || num == 0);
+
+#ifdef CONFIG_WIN32_IOCP
+	iocp_consume(socket);
+#endif
+	for(idx = 0; idx < num; idx++) {
+		if(idx > 0 && udp_socket_available(socket) == 0)
+			break;
+
+		socklen = sizeof(addr);
+		rv = recvfrom(*socket, datagrams[idx].data, (int) datagrams[idx].length, 0,
+				(struct sockaddr*) &addr, &socklen);
+
+		if(rv < 0) {
+			if(idx == 0)
+				return WSAGetLastError() == WSAETIMEDOUT ? -ETMO : -EINVALID;
+
+			break;
+		}
+
+		datagrams[idx].length = (size_t) rv;
+		sockaddr_to_remote(&addr, &datagrams[idx].remote);
+	}
+
+	return (ssize_t) idx;
+}
+
+ssize_t udp_send_batch(socket_t *socket, const socket_datagram_t *datagrams, size_t num)
+{
+	struct sockaddr_storage addr;
+	int socklen;
+	size_t idx;
+
+	assert(socket);
+	assert(datagrams || num == 0);
+
+	for(idx = 0; idx < num; idx++) {
+		socklen = remote_to_sockaddr(&datagrams[idx].remote, &addr);
+
+		if(sendto(*socket, datagrams[idx].data, (int) datagrams[idx].length, 0, (struct sockaddr*) &addr, socklen) < 0) {
+			if(idx == 0)
+				return -EINVALID;
+
+			break;
+		}
+	}
+
+	return (ssize_t) idx;
+}
+
 static bool bind_ipv4(const socket_t* sock, remote_addr_t* addr, uint16_t port)
 {
 	int fd;
@@ -257,6 +1246,7 @@ static bool bind_ipv4(const socket_t* sock, remote_addr_t* addr, uint16_t port)
 	fd = *sock;
 	assert(fd >= 0);
 
+	memset(&server, 0, sizeof(server));
 	server.sin_port = port;
 	server.sin_family = AF_INET;
 	server.sin_addr.s_addr = addr->addr.ip4_addr.ip;
@@ -267,11 +1257,16 @@ static bool bind_ipv4(const socket_t* sock, remote_addr_t* addr, uint16_t port)
 static bool bind_ipv6(const socket_t* sock, remote_addr_t* addr, uint16_t port)
 {
 	int fd;
+	DWORD v6only = 0;
 	struct sockaddr_in6 server;
 
 	fd = *sock;
 	assert(fd >= 0);
 
+	/* Winsock defaults to IPv6 only; listen on IPv4 as well. */
+	setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, (const char *) &v6only, sizeof(v6only));
+
+	memset(&server, 0, sizeof(server));
 	server.sin6_port = port;
 	server.sin6_family = AF_INET6;
 	memcpy(server.sin6_addr.u.Byte, addr->addr.ip6_addr.ip, sizeof(addr->addr.ip6_addr.ip));
@@ -300,40 +1295,92 @@ bool server_socket_bind(socket_t* sock, bind_addr_t addr, uint16_t port)
 		return bind_ipv4(sock, &remote, port);
 
 	case BIND_ADDR_LB:
-		remote.addr.ip4_addr.ip = INADDR_LOOPBACK;
+		remote.addr.ip4_addr.ip = htonl(INADDR_LOOPBACK);
 		return bind_ipv4(sock, &remote, port);
 
 	case BIND6_ADDR_ANY:
 		memcpy(remote.addr.ip6_addr.ip, in6addr_any.u.Byte, sizeof(remote.addr.ip6_addr.ip));
 		return bind_ipv6(sock, &remote, port);
+
+	case BIND6_ADDR_LB:
+		memcpy(remote.addr.ip6_addr.ip, in6addr_loopback.u.Byte, sizeof(remote.addr.ip6_addr.ip));
+		return bind_ipv6(sock, &remote, port);
 	}
 }
 
 bool server_socket_listen(socket_t *socket)
 {
+#ifdef CONFIG_WIN32_IOCP
+	struct sockaddr_storage addr;
+	int length;
+#endif
 	int rv;
 
 	assert(socket);
 	rv = listen(*socket, CONFIG_CLIENT_QUEUE_LENGTH);
 
-	return rv < 0 ? false : true;
+	if(rv < 0)
+		return false;
+
+#ifdef CONFIG_WIN32_IOCP
+	/* Listeners are polled with AcceptEx, which needs the family of the accepted sockets. */
+	length = sizeof(addr);
+
+	if(getsockname(*socket, (struct sockaddr*) &addr, &length) == 0) {
+		iocp_socket(socket)->family = addr.ss_family;
+		iocp_socket(socket)->listener = true;
+	}
+#endif
+
+	return true;
 }
 
 socket_t* server_socket_accept(socket_t* socket)
 {
-	int sock;
-	socket_t *client;
+	SOCKET sock;
 
 	assert(socket);
+
+#ifdef CONFIG_WIN32_IOCP
+	sock = iocp_accepted(socket);
+
+	if(sock != INVALID_SOCKET)
+		return socket_alloc(sock);
+#endif
+
 	sock = accept(*socket, NULL, NULL);
 
-	if(sock < 0)
+	if(sock == INVALID_SOCKET)
 		return NULL;
 
-	client = lwiot_mem_zalloc(sizeof(socket));
-	assert(client);
-	*client = sock;
-	return client;
+	return socket_alloc(sock);
+}
+
+size_t server_socket_accept_many(socket_t *socket, socket_t **clients, size_t num)
+{
+	WSAPOLLFD pfd;
+	size_t idx;
+
+	assert(socket);
+	assert(clients || num == 0);
+
+	for(idx = 0; idx < num; idx++) {
+		if(idx > 0) {
+			pfd.fd = *socket;
+			pfd.events = POLLRDNORM;
+			pfd.revents = 0;
+
+			if(WSAPoll(&pfd, 1, 0) <= 0 || (pfd.revents & POLLRDNORM) == 0)
+				break;
+		}
+
+		clients[idx] = server_socket_accept(socket);
+
+		if(clients[idx] == NULL)
+			break;
+	}
+
+	return idx;
 }
 
 /* DNS */
@@ -367,3 +1414,49 @@ int dns_resolve_host(const char *host, remote_addr_t* addr)
 	freeaddrinfo(res); // free the linked list
 	return -EOK;
 }
+
+int dns_resolve_host_all(const char *host, remote_addr_t *addrs, size_t num)
+{
+	struct addrinfo hints, *res, *p, *next[2];
+	size_t count;
+	int family, turn;
+
+	memset(&hints, 0, sizeof hints);
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	if(getaddrinfo(host, NULL, &hints, &res) != 0)
+		return -EINVALID;
+
+	/* Alternate between the families, starting with the one the resolver prefers. */
+	family = res->ai_family;
+	next[0] = next[1] = res;
+	count = 0;
+	turn = 0;
+
+	while(count < num) {
+		p = next[turn];
+
+		while(p != NULL && (p->ai_family == family) != (turn == 0))
+			p = p->ai_next;
+
+		if(p == NULL) {
+			next[turn] = NULL;
+
+			if(next[turn ^ 1] == NULL)
+				break;
+
+			turn ^= 1;
+			continue;
+		}
+
+		sockaddr_to_remote((const struct sockaddr_storage*) p->ai_addr, &addrs[count++]);
+		next[turn] = p->ai_next;
+
+		if(next[turn ^ 1] != NULL)
+			turn ^= 1;
+	}
+
+	freeaddrinfo(res);
+	return (int) count;
+}
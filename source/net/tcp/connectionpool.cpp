@@ -0,0 +1,312 @@
+/*
+ * Pool of reusable TCP connections.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/error.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/network/connectionpool.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/securetcpclient.h>
+
+namespace lwiot
+{
+	ConnectionPool::Lease::Lease() : _pool(nullptr), _connection(nullptr)
+	{
+	}
+
+	ConnectionPool::Lease::Lease(ConnectionPool *pool, Connection *connection) : _pool(pool), _connection(connection)
+	{
+	}
+
+	ConnectionPool::Lease::Lease(Lease &&other) noexcept : _pool(other._pool), _connection(other._connection)
+	{
+		other._pool = nullptr;
+		other._connection = nullptr;
+	}
+
+	ConnectionPool::Lease::~Lease()
+	{
+		this->release();
+	}
+
+	ConnectionPool::Lease& ConnectionPool::Lease::operator=(Lease &&other) noexcept
+	{
+		if(this == &other)
+			return *this;
+
+		this->release();
+
+		this->_pool = other._pool;
+		this->_connection = other._connection;
+		other._pool = nullptr;
+		other._connection = nullptr;
+
+		return *this;
+	}
+
+	ConnectionPool::Lease::operator bool() const
+	{
+		return this->_connection != nullptr;
+	}
+
+	TcpClient& ConnectionPool::Lease::client() const
+	{
+		assert(this->_connection);
+		return *this->_connection->client;
+	}
+
+	TcpClient& ConnectionPool::Lease::operator*() const
+	{
+		return this->client();
+	}
+
+	TcpClient* ConnectionPool::Lease::operator->() const
+	{
+		return &this->client();
+	}
+
+	void ConnectionPool::Lease::release()
+	{
+		if(this->_connection == nullptr)
+			return;
+
+		this->_pool->giveBack(this->_connection, true);
+		this->_pool = nullptr;
+		this->_connection = nullptr;
+	}
+
+	void ConnectionPool::Lease::discard()
+	{
+		if(this->_connection == nullptr)
+			return;
+
+		this->_pool->giveBack(this->_connection, false);
+		this->_pool = nullptr;
+		this->_connection = nullptr;
+	}
+
+	ConnectionPool::ConnectionPool(size_t perhost, int idle) : _lock(false), _perhost(perhost), _idle(idle),
+		_connect_tmo(FOREVER), _record_size(CONFIG_TLS_RECORD_SIZE)
+	{
+	}
+
+	ConnectionPool::~ConnectionPool()
+	{
+		ScopedLock lock(this->_lock);
+
+		/* Outstanding leases must not outlive the pool. */
+		for(auto connection : this->_connections)
+			assert(!connection->leased);
+
+		while(this->_connections.size() > 0)
+			this->remove(this->_connections.size() - 1);
+	}
+
+	ConnectionPool::Lease ConnectionPool::acquire(const String &host, uint16_t port, bool secure)
+	{
+		ScopedLock lock(this->_lock);
+		size_t count = 0;
+
+		this->expire(lwiot_tick_ms());
+
+		for(size_t idx = 0; idx < this->_connections.size(); ) {
+			auto connection = this->_connections[idx];
+
+			if(connection->port != port || connection->secure != secure || connection->host != host) {
+				idx++;
+				continue;
+			}
+
+			if(connection->leased) {
+				count++;
+				idx++;
+				continue;
+			}
+
+			if(!connection->client->alive()) {
+				this->remove(idx);
+				continue;
+			}
+
+			connection->leased = true;
+			return Lease(this, connection);
+		}
+
+		if(count >= this->_perhost)
+			return Lease();
+
+		/* Reserve the slot, so that the connect can run without holding the lock. */
+		auto connection = new Connection();
+
+		connection->host = host;
+		connection->port = port;
+		connection->secure = secure;
+		connection->leased = true;
+		connection->client = nullptr;
+		this->_connections.push_back(connection);
+
+		lock.unlock();
+		auto client = this->create(host, port, secure);
+		lock.lock();
+
+		if(client == nullptr) {
+			for(size_t idx = 0; idx < this->_connections.size(); idx++) {
+				if(this->_connections[idx] == connection) {
+					this->remove(idx);
+					break;
+				}
+			}
+
+			return Lease();
+		}
+
+		connection->client = client;
+		return Lease(this, connection);
+	}
+
+	void ConnectionPool::setConnectTimeout(int ms)
+	{
+		this->_connect_tmo = ms;
+	}
+
+	void ConnectionPool::setServerCertificate(const String &cert)
+	{
+		this->_cert = cert;
+	}
+
+	void ConnectionPool::setRecordSize(size_t size)
+	{
+		this->_record_size = size;
+	}
+
+	void ConnectionPool::purge()
+	{
+		ScopedLock lock(this->_lock);
+
+		this->expire(lwiot_tick_ms());
+
+		for(size_t idx = 0; idx < this->_connections.size(); ) {
+			auto connection = this->_connections[idx];
+
+			if(!connection->leased && !connection->client->alive()) {
+				this->remove(idx);
+				continue;
+			}
+
+			idx++;
+		}
+	}
+
+	void ConnectionPool::clear()
+	{
+		ScopedLock lock(this->_lock);
+
+		for(size_t idx = 0; idx < this->_connections.size(); ) {
+			if(!this->_connections[idx]->leased) {
+				this->remove(idx);
+				continue;
+			}
+
+			idx++;
+		}
+	}
+
+	size_t ConnectionPool::size() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_connections.size();
+	}
+
+	size_t ConnectionPool::idle() const
+	{
+		ScopedLock lock(this->_lock);
+		size_t count = 0;
+
+		for(auto connection : this->_connections) {
+			if(!connection->leased)
+				count++;
+		}
+
+		return count;
+	}
+
+	TcpClient *ConnectionPool::create(const String &host, uint16_t port, bool secure)
+	{
+		TcpClient *client;
+
+		if(secure) {
+			auto tls = new SecureTcpClient();
+
+			tls->setServerCertificate(this->_cert);
+			tls->setSessionCache(&this->_sessions);
+			tls->setRecordSize(this->_record_size);
+			client = tls;
+		} else {
+			client = new SocketTcpClient();
+		}
+
+		client->setConnectTimeout(this->_connect_tmo);
+
+		if(!client->connect(host, port)) {
+			delete client;
+			return nullptr;
+		}
+
+		return client;
+	}
+
+	void ConnectionPool::giveBack(Connection *connection, bool reuse)
+	{
+		ScopedLock lock(this->_lock);
+
+		if(reuse && connection->client->connected()) {
+			connection->leased = false;
+			connection->used = lwiot_tick_ms();
+			return;
+		}
+
+		for(size_t idx = 0; idx < this->_connections.size(); idx++) {
+			if(this->_connections[idx] == connection) {
+				this->remove(idx);
+				return;
+			}
+		}
+	}
+
+	void ConnectionPool::remove(size_t idx)
+	{
+		auto connection = this->_connections[idx];
+
+		this->_connections.erase(idx);
+
+		if(connection->client != nullptr) {
+			connection->client->close();
+			delete connection->client;
+		}
+
+		delete connection;
+	}
+
+	void ConnectionPool::expire(time_t now)
+	{
+		for(size_t idx = 0; idx < this->_connections.size(); ) {
+			auto connection = this->_connections[idx];
+
+			if(!connection->leased && now - connection->used >= this->_idle) {
+				this->remove(idx);
+				continue;
+			}
+
+			idx++;
+		}
+	}
+}
@@ -0,0 +1,503 @@
+/*
+ * TCP client and server on the lwIP netconn API.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/error.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/bufferchain.h>
+#include <lwiot/uniquepointer.h>
+
+#include <lwiot/network/stdnet.h>
+#include <lwiot/network/netconn.h>
+#include <lwiot/network/netconntcpclient.h>
+
+namespace lwiot
+{
+	NetconnTcpClient::NetconnTcpClient() : TcpClient(), _conn(nullptr), _rx(nullptr), _offset(0), _eof(false)
+	{
+	}
+
+	NetconnTcpClient::NetconnTcpClient(struct netconn *conn) : TcpClient(), _conn(conn), _rx(nullptr), _offset(0), _eof(false)
+	{
+		ip_addr_t addr;
+		u16_t port;
+
+		if(conn != nullptr && netconn_peer(conn, &addr, &port) == ERR_OK) {
+			this->_remote_addr = netconn::fromIpAddr(addr);
+			this->_remote_port = to_netorders(port);
+		}
+	}
+
+	NetconnTcpClient::NetconnTcpClient(const IPAddress& addr, uint16_t port) : TcpClient(), _conn(nullptr), _rx(nullptr),
+		_offset(0), _eof(false)
+	{
+		this->connect(addr, port);
+	}
+
+	NetconnTcpClient::NetconnTcpClient(const String& host, uint16_t port) : TcpClient(), _conn(nullptr), _rx(nullptr),
+		_offset(0), _eof(false)
+	{
+		this->connect(host, port);
+	}
+
+	NetconnTcpClient::~NetconnTcpClient()
+	{
+		this->close();
+	}
+
+	NetconnTcpClient::operator bool() const
+	{
+		return this->connected();
+	}
+
+	bool NetconnTcpClient::connected() const
+	{
+		return this->_conn != nullptr;
+	}
+
+	bool NetconnTcpClient::alive() const
+	{
+		if(!this->connected())
+			return false;
+
+		auto self = const_cast<NetconnTcpClient*>(this);
+		auto rv = self->fetch(SOCKET_POLL_NOWAIT);
+
+		return rv > 0 || rv == -ETMO;
+	}
+
+	bool NetconnTcpClient::readable(int tmo) const
+	{
+		if(!this->connected())
+			return false;
+
+		auto self = const_cast<NetconnTcpClient*>(this);
+		return self->fetch(tmo) != -ETMO;
+	}
+
+	size_t NetconnTcpClient::available() const
+	{
+		auto self = const_cast<NetconnTcpClient*>(this);
+		auto rv = self->fetch(SOCKET_POLL_NOWAIT);
+
+		return rv > 0 ? rv : 0;
+	}
+
+	/*
+	 * Make sure unread data is available. A new chain is only taken from the stack once the
+	 * current one is consumed, so that _rx never holds on to more than a single receive.
+	 */
+	ssize_t NetconnTcpClient::fetch(int tmo)
+	{
+		struct pbuf *p;
+		err_t err;
+
+		if(this->_rx != nullptr)
+			return this->_rx->tot_len - this->_offset;
+
+		if(this->_eof || this->_conn == nullptr)
+			return 0;
+
+		if(tmo == SOCKET_POLL_NOWAIT) {
+			netconn_set_nonblocking(this->_conn, 1);
+		} else {
+			netconn_set_recvtimeout(this->_conn, tmo);
+		}
+
+		p = nullptr;
+		err = netconn_recv_tcp_pbuf(this->_conn, &p);
+
+		netconn_set_nonblocking(this->_conn, 0);
+		netconn_set_recvtimeout(this->_conn, this->_timeout * 1000);
+
+		if(err == ERR_TIMEOUT || err == ERR_WOULDBLOCK)
+			return -ETMO;
+
+		if(err != ERR_OK) {
+			this->_eof = true;
+
+			if(err == ERR_CLSD)
+				return 0;
+
+			this->_stats.received(-EINVALID);
+			return -EINVALID;
+		}
+
+		this->_stats.received(p->tot_len);
+		this->_rx = p;
+		this->_offset = 0;
+
+		return p->tot_len;
+	}
+
+	void NetconnTcpClient::consume(size_t length)
+	{
+		this->_offset += length;
+
+		if(this->_offset >= this->_rx->tot_len)
+			this->release();
+	}
+
+	void NetconnTcpClient::release()
+	{
+		if(this->_rx != nullptr)
+			pbuf_free(this->_rx);
+
+		this->_rx = nullptr;
+		this->_offset = 0;
+	}
+
+	ssize_t NetconnTcpClient::read(void *output, const size_t& length)
+	{
+		auto rv = this->fetch(this->_timeout * 1000);
+
+		if(rv <= 0)
+			return rv;
+
+		auto num = length < static_cast<size_t>(rv) ? length : static_cast<size_t>(rv);
+
+		pbuf_copy_partial(this->_rx, output, num, this->_offset);
+		this->consume(num);
+
+		return num;
+	}
+
+	RawBuffer NetconnTcpClient::peekSpan()
+	{
+		u16_t offset;
+
+		if(this->fetch(this->_timeout * 1000) <= 0)
+			return RawBuffer();
+
+		auto p = pbuf_skip(this->_rx, this->_offset, &offset);
+		return RawBuffer(static_cast<uint8_t*>(p->payload) + offset, p->len - offset);
+	}
+
+	size_t NetconnTcpClient::skip(size_t length)
+	{
+		if(this->_rx == nullptr)
+			return 0;
+
+		auto left = this->_rx->tot_len - this->_offset;
+
+		if(length > left)
+			length = left;
+
+		this->consume(length);
+		return length;
+	}
+
+	SharedByteBuffer NetconnTcpClient::receiveSegment()
+	{
+		u16_t offset;
+
+		if(this->fetch(this->_timeout * 1000) <= 0)
+			return SharedByteBuffer();
+
+		auto p = pbuf_skip(this->_rx, this->_offset, &offset);
+		auto segment = netconn::share(p, offset);
+
+		this->consume(segment.size());
+		return segment;
+	}
+
+	ssize_t NetconnTcpClient::readUntil(char delim, ByteBuffer& output)
+	{
+		return this->consumeUntil(delim, &output);
+	}
+
+	ssize_t NetconnTcpClient::skipUntil(char delim)
+	{
+		return this->consumeUntil(delim, nullptr);
+	}
+
+	/*
+	 * Consume up to and including the delimiter, adding the data before it to output. The
+	 * search runs over the pbuf chain, so the data is copied once, if at all.
+	 */
+	ssize_t NetconnTcpClient::consumeUntil(char delim, ByteBuffer *output)
+	{
+		ssize_t num = 0;
+
+		while(true) {
+			auto rv = this->fetch(this->_timeout * 1000);
+
+			if(rv < 0)
+				return num > 0 ? num : rv;
+
+			if(rv == 0)
+				return num;
+
+			auto idx = pbuf_memfind(this->_rx, &delim, 1, this->_offset);
+			auto found = idx != 0xFFFF;
+			size_t length = found ? idx - this->_offset : rv;
+
+			if(output != nullptr)
+				this->copy(*output, length);
+
+			num += length;
+			this->consume(found ? length + 1 : length);
+
+			if(found)
+				return num;
+		}
+	}
+
+	void NetconnTcpClient::copy(ByteBuffer& output, size_t length) const
+	{
+		u16_t offset;
+		auto p = pbuf_skip(this->_rx, this->_offset, &offset);
+
+		for(; p != nullptr && length > 0; p = p->next, offset = 0) {
+			size_t num = p->len - offset;
+
+			if(num > length)
+				num = length;
+
+			output.write(static_cast<const uint8_t*>(p->payload) + offset, num);
+			length -= num;
+		}
+	}
+
+	ssize_t NetconnTcpClient::write(const void *bytes, const size_t& length)
+	{
+		size_t written = 0;
+
+		if(this->_conn == nullptr)
+			return -EINVALID;
+
+		auto err = netconn_write_partly(this->_conn, bytes, length, NETCONN_COPY, &written);
+		ssize_t rv = err == ERR_OK ? static_cast<ssize_t>(written) : -EINVALID;
+
+		this->_stats.sent(rv);
+		return rv;
+	}
+
+	/* NETCONN_MORE lets the stack coalesce the segments instead of sending each on its own. */
+	ssize_t NetconnTcpClient::write(const BufferChain& chain)
+	{
+		ssize_t total = 0;
+		size_t idx = 0;
+
+		if(this->_conn == nullptr)
+			return -EINVALID;
+
+		for(const auto& segment : chain) {
+			u8_t flags = NETCONN_COPY;
+			size_t written = 0;
+
+			if(++idx < chain.segments())
+				flags |= NETCONN_MORE;
+
+			auto err = netconn_write_partly(this->_conn, segment.buffer(), segment.size(), flags, &written);
+
+			if(err != ERR_OK) {
+				this->_stats.sent(-EINVALID);
+				return total > 0 ? total : -EINVALID;
+			}
+
+			total += written;
+		}
+
+		this->_stats.sent(total);
+		return total;
+	}
+
+	bool NetconnTcpClient::connect(const IPAddress& addr, uint16_t port)
+	{
+		ip_addr_t ip;
+
+		this->close();
+		this->_remote_addr = addr;
+		this->_remote_port = to_netorders(port);
+
+#if LWIP_IPV6
+		this->_conn = netconn_new(addr.isIPv6() ? NETCONN_TCP_IPV6 : NETCONN_TCP);
+#else
+		this->_conn = netconn_new(NETCONN_TCP);
+#endif
+
+		if(this->_conn == nullptr)
+			return false;
+
+		netconn::toIpAddr(addr, ip);
+
+		auto start = lwiot_tick_ms();
+		auto err = netconn_connect(this->_conn, &ip, port);
+
+		this->_stats.connected(err == ERR_OK, start);
+
+		if(err != ERR_OK) {
+			netconn_delete(this->_conn);
+			this->_conn = nullptr;
+			return false;
+		}
+
+		this->_eof = false;
+		netconn_set_recvtimeout(this->_conn, this->_timeout * 1000);
+
+		return true;
+	}
+
+	bool NetconnTcpClient::connect(const String& host, uint16_t port)
+	{
+		ip_addr_t ip;
+
+		if(netconn_gethostbyname(host.c_str(), &ip) != ERR_OK)
+			return false;
+
+		return this->connect(netconn::fromIpAddr(ip), port);
+	}
+
+	void NetconnTcpClient::setTimeout(time_t seconds)
+	{
+		TcpClient::setTimeout(seconds);
+
+		if(this->_conn != nullptr)
+			netconn_set_recvtimeout(this->_conn, seconds * 1000);
+	}
+
+	void NetconnTcpClient::close()
+	{
+		this->release();
+
+		if(this->_conn == nullptr)
+			return;
+
+		netconn_close(this->_conn);
+		netconn_delete(this->_conn);
+		this->_conn = nullptr;
+		this->_eof = false;
+	}
+
+	NetconnTcpServer::NetconnTcpServer() : TcpServer(), _conn(nullptr), _backlog(nullptr), _timeout(0)
+	{
+	}
+
+	NetconnTcpServer::NetconnTcpServer(const IPAddress& addr, uint16_t port) : TcpServer(addr, port), _conn(nullptr),
+		_backlog(nullptr), _timeout(0)
+	{
+		this->connect();
+		this->bind();
+	}
+
+	NetconnTcpServer::~NetconnTcpServer()
+	{
+		this->close();
+	}
+
+	void NetconnTcpServer::connect()
+	{
+		this->close();
+
+#if LWIP_IPV6
+		this->_conn = netconn_new(this->address().isIPv6() ? NETCONN_TCP_IPV6 : NETCONN_TCP);
+#else
+		this->_conn = netconn_new(NETCONN_TCP);
+#endif
+	}
+
+	bool NetconnTcpServer::bind(const IPAddress& addr, uint16_t port)
+	{
+		TcpServer::bind(addr, port);
+
+		if(this->_conn == nullptr)
+			this->connect();
+
+		return this->bind();
+	}
+
+	bool NetconnTcpServer::bind() const
+	{
+		ip_addr_t ip;
+
+		if(this->_conn == nullptr) {
+			print_dbg("Invalid netconn, unable to bind!\n");
+			return false;
+		}
+
+		netconn::toIpAddr(this->_bind_addr, ip);
+
+		if(netconn_bind(this->_conn, &ip, to_hostorders(this->_bind_port)) != ERR_OK) {
+			print_dbg("Unable to bind TCP server netconn!\n");
+			return false;
+		}
+
+		return netconn_listen_with_backlog(this->_conn, BacklogSize) == ERR_OK;
+	}
+
+	UniquePointer<TcpClient> NetconnTcpServer::accept()
+	{
+		struct netconn *conn = this->_backlog;
+
+		this->_backlog = nullptr;
+
+		if(conn == nullptr && netconn_accept(this->_conn, &conn) != ERR_OK)
+			return UniquePointer<TcpClient>();
+
+		return UniquePointer<TcpClient>(new NetconnTcpClient(conn));
+	}
+
+	/* A netconn cannot be polled, so a pending connection is accepted and kept for accept(). */
+	bool NetconnTcpServer::pending(int tmo)
+	{
+		struct netconn *conn = nullptr;
+
+		if(this->_conn == nullptr)
+			return false;
+
+		if(this->_backlog != nullptr)
+			return true;
+
+		if(tmo == SOCKET_POLL_NOWAIT) {
+			netconn_set_nonblocking(this->_conn, 1);
+		} else {
+			netconn_set_recvtimeout(this->_conn, tmo);
+		}
+
+		auto err = netconn_accept(this->_conn, &conn);
+
+		netconn_set_nonblocking(this->_conn, 0);
+		netconn_set_recvtimeout(this->_conn, this->_timeout * 1000);
+
+		if(err != ERR_OK)
+			return false;
+
+		this->_backlog = conn;
+		return true;
+	}
+
+	void NetconnTcpServer::setTimeout(time_t seconds)
+	{
+		this->_timeout = seconds;
+
+		if(this->_conn != nullptr)
+			netconn_set_recvtimeout(this->_conn, seconds * 1000);
+	}
+
+	void NetconnTcpServer::close()
+	{
+		if(this->_backlog != nullptr) {
+			netconn_close(this->_backlog);
+			netconn_delete(this->_backlog);
+			this->_backlog = nullptr;
+		}
+
+		if(this->_conn == nullptr)
+			return;
+
+		netconn_close(this->_conn);
+		netconn_delete(this->_conn);
+		this->_conn = nullptr;
+	}
+}
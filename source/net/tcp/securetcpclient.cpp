@@ -11,6 +11,7 @@
 
 #include <lwiot/log.h>
 #include <lwiot/types.h>
+#include <lwiot/bufferchain.h>
 
 #include <lwiot/network/tcpclient.h>
 #include <lwiot/network/stdnet.h>
@@ -18,24 +19,40 @@
 
 namespace lwiot
 {
-	SecureTcpClient::SecureTcpClient() : TcpClient(), _socket(nullptr), _host("")
+	SecureTcpClient::SecureTcpClient() : TcpClient(), _socket(nullptr), _handshake(Handshake::Done),
+		_handshake_start(0), _handshake_tmo(0), _host(""), _sessions(nullptr), _tickets(true),
+		_record_size(CONFIG_TLS_RECORD_SIZE)
 	{
 	}
 
 	SecureTcpClient::SecureTcpClient(const lwiot::IPAddress &addr, uint16_t port, const String& host) :
-		TcpClient(addr, port), _socket(nullptr), _host(host)
+		TcpClient(addr, port), _socket(nullptr), _handshake(Handshake::Done), _handshake_start(0),
+		_handshake_tmo(0), _host(host), _sessions(nullptr), _tickets(true), _record_size(CONFIG_TLS_RECORD_SIZE)
+	{
+	}
+
+	SecureTcpClient::SecureTcpClient(secure_socket_t *socket, int tmo) : TcpClient(), _socket(socket),
+		_handshake(Handshake::Pending), _handshake_start(lwiot_tick_ms()), _handshake_tmo(tmo), _host(""),
+		_sessions(nullptr), _tickets(true), _record_size(CONFIG_TLS_RECORD_SIZE)
 	{
 	}
 
 	SecureTcpClient::SecureTcpClient(const lwiot::SecureTcpClient &other) :
-		TcpClient(other.remote(), other.port()), _socket(nullptr), _host(other._host)
+		TcpClient(other.remote(), other.port()), _socket(nullptr), _handshake(Handshake::Done),
+		_handshake_start(0), _handshake_tmo(0), _host(other._host), _sessions(nullptr), _tickets(true),
+		_record_size(CONFIG_TLS_RECORD_SIZE)
 	{
+		this->copySettings(other);
 	}
 
 	SecureTcpClient::SecureTcpClient(lwiot::SecureTcpClient &&other) :
-		TcpClient(other.remote(), other.port()), _socket(other._socket), _host(other._host)
+		TcpClient(other.remote(), other.port()), _socket(other._socket), _handshake(other._handshake),
+		_handshake_start(other._handshake_start), _handshake_tmo(other._handshake_tmo), _host(other._host),
+		_sessions(nullptr), _tickets(true), _record_size(CONFIG_TLS_RECORD_SIZE)
 	{
+		this->copySettings(other);
 		other._socket = nullptr;
+		other._handshake = Handshake::Done;
 		other._remote_port = 0;
 		other._remote_addr = IPAddress();
 		other._host = "";
@@ -53,6 +70,7 @@ namespace lwiot
 		}
 
 		this->_host = client._host;
+		this->copySettings(client);
 		this->connect(client.remote(), client.port());
 		return *this;
 	}
@@ -64,11 +82,16 @@ namespace lwiot
 		}
 
 		this->_host = other._host;
+		this->copySettings(other);
 		this->_remote_addr = other.remote();
 		this->_remote_port = other.port();
 		this->_socket = other._socket;
+		this->_handshake = other._handshake;
+		this->_handshake_start = other._handshake_start;
+		this->_handshake_tmo = other._handshake_tmo;
 
 		other._socket = nullptr;
+		other._handshake = Handshake::Done;
 		other._remote_port = 0;
 		other._remote_addr = IPAddress();
 		other._host = "";
@@ -102,17 +125,46 @@ namespace lwiot
 
 	bool SecureTcpClient::connect()
 	{
-		ssl_context_t context = {0,0,0};
+		ssl_context_t context;
 		remote_addr_t remote;
+		secure_session_t *session = nullptr;
 
+		memset(&context, 0, sizeof(context));
 		this->remote().toRemoteAddress(remote);
 		remote.port = this->port();
 
 		context.root_ca = this->_cert.c_str();
+		context.session_tickets = this->_tickets;
+		context.record_size = this->_record_size;
+#ifdef HAVE_RANDOM_BYTES
+		context.entropy = lwiot_random_bytes;
+#endif
+
+		if(this->_psk.index() > 0) {
+			context.psk = this->_psk.data();
+			context.psk_length = this->_psk.index();
+			context.psk_identity = this->_psk_identity.c_str();
+		}
 
+		if(this->_sessions != nullptr) {
+			session = this->_sessions->take(this->_host);
+			context.session = session;
+		}
+
+		auto start = lwiot_tick_ms();
+		this->_handshake = Handshake::Done;
 		this->_socket = secure_socket_create();
 		assert(this->_socket);
 		auto value = secure_socket_connect(this->_socket, this->_host.c_str(), &remote, &context);
+		this->_stats.connected(value, start);
+
+#ifdef HAVE_TLS_SESSIONS
+		if(session != nullptr)
+			secure_session_free(session);
+
+		if(value && this->_sessions != nullptr)
+			this->_sessions->put(this->_host, secure_socket_get_session(this->_socket));
+#endif
 
 		if(!value) {
 			secure_socket_close(this->_socket);
@@ -133,6 +185,66 @@ namespace lwiot
 		this->_host = host;
 	}
 
+	void SecureTcpClient::setSessionCache(TlsSessionCache *cache)
+	{
+		this->_sessions = cache;
+	}
+
+	void SecureTcpClient::setSessionTickets(bool enabled)
+	{
+		this->_tickets = enabled;
+	}
+
+	void SecureTcpClient::setPreSharedKey(const lwiot::String &identity, const ByteBuffer &key)
+	{
+		this->_psk_identity = identity;
+		this->_psk = key;
+	}
+
+	void SecureTcpClient::setRecordSize(size_t size)
+	{
+		this->_record_size = size;
+	}
+
+	void SecureTcpClient::copySettings(const lwiot::SecureTcpClient &other)
+	{
+		this->_cert = other._cert;
+		this->_sessions = other._sessions;
+		this->_tickets = other._tickets;
+		this->_psk_identity = other._psk_identity;
+		this->_psk = other._psk;
+		this->_record_size = other._record_size;
+	}
+
+	/*
+	 * Advance a server side handshake. Without \p wait it only processes the data that has
+	 * arrived, so that a client that connects and sends nothing does not hold up the caller.
+	 */
+	bool SecureTcpClient::handshake(bool wait) const
+	{
+		while(this->_handshake == Handshake::Pending) {
+			auto rv = secure_socket_handshake(this->_socket);
+
+			if(rv > 0) {
+				this->_handshake = Handshake::Done;
+				break;
+			}
+
+			if(rv < 0 || lwiot_tick_ms() - this->_handshake_start > this->_handshake_tmo) {
+				print_dbg("TLS handshake with client failed!\n");
+				this->_handshake = Handshake::Failed;
+				break;
+			}
+
+			if(!wait)
+				break;
+
+			lwiot_sleep(1);
+		}
+
+		return this->_handshake == Handshake::Done;
+	}
+
 	void SecureTcpClient::close()
 	{
 		if(this->_socket == nullptr)
@@ -140,6 +252,7 @@ namespace lwiot
 
 		secure_socket_close(this->_socket);
 		this->_socket = nullptr;
+		this->_handshake = Handshake::Done;
 	}
 
 	ssize_t SecureTcpClient::read(void *output, const size_t &length)
@@ -147,7 +260,13 @@ namespace lwiot
 		assert(this->_socket);
 		assert(output);
 
-		return secure_socket_recv(this->_socket, output, length);
+		if(!this->handshake(true))
+			return -1;
+
+		auto rv = secure_socket_recv(this->_socket, output, length);
+
+		this->_stats.received(rv);
+		return rv;
 	}
 
 	ssize_t SecureTcpClient::write(const void *bytes, const size_t &length)
@@ -155,18 +274,86 @@ namespace lwiot
 		assert(this->_socket);
 		assert(bytes);
 
-		return secure_socket_send(this->_socket, bytes, length);
+		if(!this->handshake(true))
+			return -1;
+
+		auto rv = secure_socket_send(this->_socket, bytes, length);
+
+		this->_stats.sent(rv);
+		return rv;
+	}
+
+	ssize_t SecureTcpClient::write(const BufferChain &chain)
+	{
+		uint8_t staging[CONFIG_TLS_COALESCE_SIZE];
+		size_t staged = 0;
+		ssize_t total = 0;
+
+		assert(this->_socket);
+
+		if(!this->handshake(true))
+			return -1;
+
+		auto flush = [&]() -> bool {
+			if(staged == 0)
+				return true;
+
+			auto rv = secure_socket_send(this->_socket, staging, staged);
+			this->_stats.sent(rv);
+
+			if(rv < 0) {
+				total = total > 0 ? total : rv;
+				return false;
+			}
+
+			total += rv;
+
+			if(static_cast<size_t>(rv) < staged)
+				return false;
+
+			staged = 0;
+			return true;
+		};
+
+		for(const auto& segment : chain) {
+			if(segment.size() > sizeof(staging) - staged && !flush())
+				return total;
+
+			if(segment.size() <= sizeof(staging) - staged) {
+				memcpy(staging + staged, segment.buffer(), segment.size());
+				staged += segment.size();
+				continue;
+			}
+
+			auto rv = secure_socket_send(this->_socket, segment.buffer(), segment.size());
+			this->_stats.sent(rv);
+
+			if(rv < 0)
+				return total > 0 ? total : rv;
+
+			total += rv;
+
+			if(static_cast<size_t>(rv) < segment.size())
+				return total;
+		}
+
+		flush();
+		return total;
 	}
 
 	size_t SecureTcpClient::available() const
 	{
 		assert(this->_socket);
+
+		if(!this->handshake(false))
+			return 0;
+
 		return secure_socket_available(this->_socket);
 	}
 
 	bool SecureTcpClient::connected() const
 	{
-		return this->_socket != nullptr;
+		return this->_socket != nullptr && this->_handshake != Handshake::Failed;
 	}
 
 	SecureTcpClient::operator bool() const
@@ -0,0 +1,162 @@
+/*
+ * TLS TCP server wrapper.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/stl/string.h>
+
+#include <lwiot/network/stdnet.h>
+#include <lwiot/network/securetcpclient.h>
+#include <lwiot/network/securetcpserver.h>
+
+namespace lwiot
+{
+	SecureTcpServer::SecureTcpServer() : SocketTcpServer(), _server(nullptr), _sessions(CONFIG_TLS_SERVER_SESSIONS),
+		_lifetime(CONFIG_TLS_SESSION_LIFETIME), _tickets(true), _record_size(CONFIG_TLS_RECORD_SIZE),
+		_handshake_tmo(CONFIG_TLS_HANDSHAKE_TIMEOUT)
+	{
+	}
+
+	SecureTcpServer::SecureTcpServer(BindAddress addr, uint16_t port, const String& cert, const String& key) :
+		SocketTcpServer(addr, port), _server(nullptr), _cert(cert), _key(key), _sessions(CONFIG_TLS_SERVER_SESSIONS),
+		_lifetime(CONFIG_TLS_SESSION_LIFETIME), _tickets(true), _record_size(CONFIG_TLS_RECORD_SIZE),
+		_handshake_tmo(CONFIG_TLS_HANDSHAKE_TIMEOUT)
+	{
+	}
+
+	SecureTcpServer::SecureTcpServer(const IPAddress& addr, uint16_t port, const String& cert, const String& key) :
+		SocketTcpServer(addr, port), _server(nullptr), _cert(cert), _key(key), _sessions(CONFIG_TLS_SERVER_SESSIONS),
+		_lifetime(CONFIG_TLS_SESSION_LIFETIME), _tickets(true), _record_size(CONFIG_TLS_RECORD_SIZE),
+		_handshake_tmo(CONFIG_TLS_HANDSHAKE_TIMEOUT)
+	{
+	}
+
+	SecureTcpServer::~SecureTcpServer()
+	{
+		if(this->_server != nullptr)
+			secure_server_destroy(this->_server);
+	}
+
+	void SecureTcpServer::setCertificate(const String& cert, const String& key)
+	{
+		this->_cert = cert;
+		this->_key = key;
+	}
+
+	void SecureTcpServer::setSessionCache(size_t size, int lifetime)
+	{
+		this->_sessions = size;
+		this->_lifetime = lifetime;
+	}
+
+	void SecureTcpServer::setSessionTickets(bool enabled)
+	{
+		this->_tickets = enabled;
+	}
+
+	void SecureTcpServer::setRecordSize(size_t size)
+	{
+		this->_record_size = size;
+	}
+
+	void SecureTcpServer::setHandshakeTimeout(int tmo)
+	{
+		this->_handshake_tmo = tmo;
+	}
+
+	void SecureTcpServer::connect()
+	{
+		ssl_server_context_t context;
+
+		SocketTcpServer::connect();
+
+		if(this->_server != nullptr)
+			secure_server_destroy(this->_server);
+
+		memset(&context, 0, sizeof(context));
+		context.cert = this->_cert.c_str();
+		context.key = this->_key.c_str();
+		context.session_cache_size = this->_sessions;
+		context.session_lifetime = this->_lifetime;
+		context.session_tickets = this->_tickets;
+		context.record_size = this->_record_size;
+#ifdef HAVE_RANDOM_BYTES
+		context.entropy = lwiot_random_bytes;
+#endif
+
+		this->_server = secure_server_create(&context);
+
+		/* Without a certificate every client would be dropped, so do not listen at all. */
+		if(this->_server == nullptr) {
+			print_dbg("Unable to load the TLS server certificate!\n");
+			this->close();
+		}
+	}
+
+	UniquePointer<TcpClient> SecureTcpServer::secure(socket_t *socket)
+	{
+		UniquePointer<TcpClient> rv;
+
+		if(socket == nullptr)
+			return rv;
+
+		if(this->_server == nullptr) {
+			socket_close(socket);
+			return rv;
+		}
+
+		auto secure = secure_socket_accept(this->_server, socket);
+
+		if(secure == nullptr) {
+			print_dbg("Unable to set up a TLS connection!\n");
+			return rv;
+		}
+
+		/* The handshake runs on the connection, so a slow client does not hold up the server. */
+		rv.reset(new SecureTcpClient(secure, this->_handshake_tmo));
+		return rv;
+	}
+
+	UniquePointer<TcpClient> SecureTcpServer::accept()
+	{
+		if(this->handle() == nullptr)
+			return UniquePointer<TcpClient>();
+
+		return this->secure(server_socket_accept(this->handle()));
+	}
+
+	/*
+	 * Clients whose TLS state can not be set up are dropped, so fewer connections than were
+	 * accepted from the backlog may be returned.
+	 */
+	size_t SecureTcpServer::acceptMany(UniquePointer<TcpClient> *clients, size_t num)
+	{
+		socket_t *sockets[AcceptBatch];
+		size_t accepted = 0;
+
+		if(this->handle() == nullptr)
+			return 0;
+
+		if(num > AcceptBatch)
+			num = AcceptBatch;
+
+		auto count = server_socket_accept_many(this->handle(), sockets, num);
+
+		for(size_t idx = 0; idx < count; idx++) {
+			auto client = this->secure(sockets[idx]);
+
+			if(client)
+				clients[accepted++] = stl::move(client);
+		}
+
+		return accepted;
+	}
+}
@@ -7,6 +7,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <lwiot.h>
 #include <assert.h>
 
@@ -18,43 +19,48 @@
 #include <lwiot/network/stdnet.h>
 #include <lwiot/network/sockettcpclient.h>
 #include <lwiot/stl/move.h>
+#include <lwiot/stl/smallvector.h>
+
+#ifdef HAVE_UNISTD_H
+#include <lwiot/io/file.h>
+#endif
 
 namespace lwiot
 {
-	SocketTcpClient::SocketTcpClient() : TcpClient(), _socket(nullptr)
+	SocketTcpClient::SocketTcpClient() : TcpClient(), _socket(nullptr), _options(), _option_mask(0)
 	{
 	}
 
-	SocketTcpClient::SocketTcpClient(const lwiot::IPAddress &addr, uint16_t port) : TcpClient(addr, port), _socket(nullptr)
+	SocketTcpClient::SocketTcpClient(const lwiot::IPAddress &addr, uint16_t port) : TcpClient(addr, port), _socket(nullptr),
+		_options(), _option_mask(0)
 	{
 		this->connect();
 	}
 
-	SocketTcpClient::SocketTcpClient(const lwiot::String &host, uint16_t port) : TcpClient(IPAddress(), port), _socket(nullptr)
+	SocketTcpClient::SocketTcpClient(const lwiot::String &host, uint16_t port) : TcpClient(IPAddress(), port), _socket(nullptr),
+		_options(), _option_mask(0)
 	{
-		remote_addr_t remote;
-
-		remote.version = 4;
-		dns_resolve_host(host.c_str(), &remote);
-
-		this->_remote_addr = stl::move(IPAddress(remote));
-
-		this->connect();
+		this->connect(host, port);
 	}
 
-	SocketTcpClient::SocketTcpClient(const SocketTcpClient &other) : TcpClient(other._remote_addr, other._remote_port), _socket(nullptr)
+	SocketTcpClient::SocketTcpClient(const SocketTcpClient &other) : TcpClient(other._remote_addr, other._remote_port), _socket(nullptr),
+		_options(), _option_mask(0)
 	{
+		this->copyOptions(other);
 		this->connect();
 	}
 
 	SocketTcpClient::SocketTcpClient(lwiot::SocketTcpClient &&other) noexcept :
-		TcpClient(other._remote_addr, other._remote_port), _socket(nullptr)
+		TcpClient(other._remote_addr, other._remote_port), _socket(nullptr), _options(), _option_mask(0)
 	{
+		this->copyOptions(other);
 		this->_socket = other._socket;
+		this->_readahead = stl::move(other._readahead);
+		this->_stats = other._stats;
 		other._socket = nullptr;
 	}
 
-	SocketTcpClient::SocketTcpClient(socket_t *raw) : TcpClient()
+	SocketTcpClient::SocketTcpClient(socket_t *raw) : TcpClient(), _options(), _option_mask(0)
 	{
 		this->_socket = raw;
 	}
@@ -74,6 +80,7 @@ namespace lwiot
 		if(this->connected())
 			this->close();
 
+		this->copyOptions(client);
 		this->connect(client._remote_addr, client._remote_port);
 		return *this;
 	}
@@ -89,6 +96,9 @@ namespace lwiot
 		this->_remote_addr = stl::move( client._remote_addr);
 		this->_remote_port = client._remote_port;
 		this->_socket = client._socket;
+		this->_readahead = stl::move(client._readahead);
+		this->_stats = client._stats;
+		this->copyOptions(client);
 
 		client._socket = nullptr;
 		client._remote_port = 0;
@@ -101,6 +111,54 @@ namespace lwiot
 		return this->_socket != nullptr;
 	}
 
+	bool SocketTcpClient::alive() const
+	{
+		socket_poll_t poll;
+
+		if(!this->connected())
+			return false;
+
+		poll.socket = this->_socket;
+		poll.events = SOCKET_POLL_READ;
+
+		auto rv = socket_poll(&poll, 1, SOCKET_POLL_NOWAIT);
+
+		if(rv <= 0)
+			return rv == 0;
+
+		/* Readable without data means the peer closed the connection. */
+		return (poll.revents & SOCKET_POLL_ERROR) == 0 && tcp_socket_available(this->_socket) > 0;
+	}
+
+	bool SocketTcpClient::writable(int tmo) const
+	{
+		socket_poll_t poll;
+
+		if(!this->connected())
+			return false;
+
+		poll.socket = this->_socket;
+		poll.events = SOCKET_POLL_WRITE;
+
+		return socket_poll(&poll, 1, tmo) > 0 && (poll.revents & SOCKET_POLL_ERROR) == 0;
+	}
+
+	bool SocketTcpClient::readable(int tmo) const
+	{
+		socket_poll_t poll;
+
+		if(!this->connected())
+			return false;
+
+		if(this->_readahead.available() > 0)
+			return true;
+
+		poll.socket = this->_socket;
+		poll.events = SOCKET_POLL_READ;
+
+		return socket_poll(&poll, 1, tmo) > 0;
+	}
+
 	SocketTcpClient::operator bool() const
 	{
 		return this->connected();
@@ -135,30 +193,42 @@ namespace lwiot
 			this->close();
 		}
 
-		this->_socket = tcp_socket_create(&remote);
+		auto start = lwiot_tick_ms();
+		this->_socket = tcp_socket_create_timeout(&remote, this->_connect_tmo);
+		this->_stats.connected(this->_socket != nullptr, start);
+
+		if(this->_socket == nullptr)
+			return false;
 
 		if(this->_timeout != 0)
 			this->setTimeout(this->_timeout);
 
-		return this->_socket != nullptr;
+		this->applyOptions();
+		return true;
 	}
 
 	bool SocketTcpClient::connect(const lwiot::String &host, uint16_t port)
 	{
-		const char *hname;
-		remote_addr_t remote;
+		remote_addr_t remotes[CONFIG_TCP_CONNECT_ADDRESSES];
+		size_t index;
+		int num;
 
-		hname = host.c_str();
-		if(dns_resolve_host(hname, &remote) != -EOK)
+		/* Race the IPv6 and IPv4 addresses of the host, so that a broken path does not stall us. */
+		num = dns_resolve_host_all(host.c_str(), remotes, CONFIG_TCP_CONNECT_ADDRESSES);
+
+		if(num <= 0)
 			return false;
 
-		remote.port = to_netorders(port);
+		for(int idx = 0; idx < num; idx++)
+			remotes[idx].port = to_netorders(port);
 
 		if(this->_socket != nullptr) {
 			this->close();
 		}
 
-		this->_socket = tcp_socket_create(&remote);
+		auto start = lwiot_tick_ms();
+		this->_socket = tcp_socket_create_any(remotes, num, this->_connect_tmo, &index);
+		this->_stats.connected(this->_socket != nullptr, start);
 
 		if(this->_socket == nullptr)
 			return false;
@@ -166,12 +236,53 @@ namespace lwiot
 		if(this->_timeout != 0)
 			this->setTimeout(this->_timeout);
 
+		this->applyOptions();
+
 		this->_remote_port = to_netorders(port);
-		this->_remote_addr = stl::move(IPAddress(remote));
+		this->_remote_addr = IPAddress(remotes[index]);
 
 		return true;
 	}
 
+	bool SocketTcpClient::setOption(socket_option_t option, int value)
+	{
+		if(option < 0 || option >= SOCKET_OPT_MAX)
+			return false;
+
+		if(this->connected() && socket_set_option(this->_socket, option, value) != -EOK)
+			return false;
+
+		this->_options[option] = value;
+		this->_option_mask |= 1U << option;
+
+		return true;
+	}
+
+	void SocketTcpClient::applyOptions()
+	{
+		for(int idx = 0; idx < SOCKET_OPT_MAX; idx++) {
+			if((this->_option_mask & (1U << idx)) == 0)
+				continue;
+
+			socket_set_option(this->_socket, static_cast<socket_option_t>(idx), this->_options[idx]);
+		}
+	}
+
+	void SocketTcpClient::copyOptions(const SocketTcpClient& other)
+	{
+		memcpy(this->_options, other._options, sizeof(this->_options));
+		this->_option_mask = other._option_mask;
+		this->_connect_tmo = other._connect_tmo;
+	}
+
+	SocketStats SocketTcpClient::stats() const
+	{
+		auto stats = this->_stats;
+
+		stats.sample(this->_socket);
+		return stats;
+	}
+
 	void SocketTcpClient::close()
 	{
 		if(!this->connected())
@@ -179,21 +290,67 @@ namespace lwiot
 
 		socket_close(this->_socket);
 		this->_socket = nullptr ;
+		this->dropReadAhead();
 	}
 
 	size_t SocketTcpClient::available() const
 	{
-		return tcp_socket_available(this->_socket);
+		return this->_readahead.available() + tcp_socket_available(this->_socket);
 	}
 
 	ssize_t SocketTcpClient::write(const void *bytes, const size_t &length)
 	{
-		return tcp_socket_send(this->_socket, bytes, length);
+		auto rv = tcp_socket_send(this->_socket, bytes, length);
+
+		this->_stats.sent(rv);
+		return rv;
+	}
+
+	ssize_t SocketTcpClient::write(const BufferChain& chain)
+	{
+		stl::SmallVector<socket_buffer_t, BufferChain::InlineSegments> buffers(chain.segments());
+
+		for(const auto& segment : chain) {
+			socket_buffer_t buffer;
+
+			buffer.data = segment.buffer();
+			buffer.length = segment.size();
+			buffers.pushback(buffer);
+		}
+
+		auto rv = tcp_socket_sendv(this->_socket, buffers.data(), buffers.size());
+
+		this->_stats.sent(rv);
+		return rv;
+	}
+
+#ifdef HAVE_UNISTD_H
+	ssize_t SocketTcpClient::sendFile(File& file, size_t offset, size_t length)
+	{
+		if(!file.flush())
+			return -EINVALID;
+
+		auto rv = tcp_socket_sendfile(this->_socket, file.descriptor(), offset, length);
+
+		if(rv == -ENOTSUPPORTED)
+			return TcpClient::sendFile(file, offset, length);
+
+		this->_stats.sent(rv);
+		return rv;
 	}
+#endif
 
 	ssize_t SocketTcpClient::read(void *output, const size_t &length)
 	{
-		return tcp_socket_read(this->_socket, output, length);
+		return this->readBuffered(output, length);
+	}
+
+	ssize_t SocketTcpClient::receive(void *output, size_t length)
+	{
+		auto rv = tcp_socket_read(this->_socket, output, length);
+
+		this->_stats.received(rv);
+		return rv;
 	}
 
 	void SocketTcpClient::setTimeout(time_t seconds)
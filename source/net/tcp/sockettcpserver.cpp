@@ -18,6 +18,7 @@
 #include <lwiot/network/ipaddress.h>
 #include <lwiot/network/sockettcpclient.h>
 #include <lwiot/network/sockettcpserver.h>
+#include <lwiot/util/objectpool.h>
 
 #if !defined(HAVE_LWIP) && !defined(WIN32)
 #include <sys/ioctl.h>
@@ -31,6 +32,23 @@ extern "C" {
 
 namespace lwiot
 {
+#if CONFIG_TCP_CLIENT_POOL > 0
+	static ObjectPool<SocketTcpClient, CONFIG_TCP_CLIENT_POOL> client_pool;
+#endif
+
+	/* Accepted clients come from the pool, and from the heap once it is exhausted. */
+	static TcpClient *make_client(socket_t *socket)
+	{
+#if CONFIG_TCP_CLIENT_POOL > 0
+		auto client = client_pool.create(socket);
+
+		if(client != nullptr)
+			return client;
+#endif
+
+		return new SocketTcpClient(socket);
+	}
+
 	SocketTcpServer::SocketTcpServer() : TcpServer()
 	{
 		this->_socket = server_socket_create(SOCKET_STREAM, false);
@@ -169,9 +187,60 @@ namespace lwiot
 	UniquePointer<TcpClient> SocketTcpServer::accept()
 	{
 		auto socket = server_socket_accept(this->_socket);
-		auto client = new SocketTcpClient(socket);
-		UniquePointer<TcpClient> wrapped(client);
+		UniquePointer<TcpClient> wrapped(make_client(socket));
 
 		return wrapped;
 	}
+
+	size_t SocketTcpServer::acceptMany(UniquePointer<TcpClient> *clients, size_t num)
+	{
+		socket_t *sockets[AcceptBatch];
+		socket_poll_t pending;
+		size_t accepted, count;
+
+		accepted = 0;
+		pending.socket = this->_socket;
+		pending.events = SOCKET_POLL_READ;
+
+		while(accepted < num) {
+			auto chunk = num - accepted;
+
+			if(chunk > AcceptBatch)
+				chunk = AcceptBatch;
+
+			/* Only the first chunk may wait, the others drain what is already pending. */
+			if(accepted > 0 && socket_poll(&pending, 1, SOCKET_POLL_NOWAIT) <= 0)
+				break;
+
+			count = server_socket_accept_many(this->_socket, sockets, chunk);
+
+			for(size_t idx = 0; idx < count; idx++)
+				clients[accepted + idx].reset(make_client(sockets[idx]));
+
+			accepted += count;
+
+			if(count < chunk)
+				break;
+		}
+
+		return accepted;
+	}
+
+	bool SocketTcpServer::pending(int tmo)
+	{
+		socket_poll_t poll;
+
+		if(this->_socket == nullptr)
+			return false;
+
+		poll.socket = this->_socket;
+		poll.events = SOCKET_POLL_READ;
+
+		return socket_poll(&poll, 1, tmo) > 0;
+	}
+
+	bool SocketTcpServer::setOption(socket_option_t option, int value)
+	{
+		return socket_set_option(this->_socket, option, value) == -EOK;
+	}
 }
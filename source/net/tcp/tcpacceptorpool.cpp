@@ -0,0 +1,124 @@
+/*
+ * Pool of TCP acceptor threads.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/error.h>
+#include <lwiot/network/stdnet.h>
+#include <lwiot/network/tcpacceptorpool.h>
+
+namespace lwiot
+{
+	TcpAcceptorPool::TcpAcceptorPool(size_t threads, int interval) : _size(threads > 0 ? threads : 1),
+		_interval(interval), _running(false)
+	{
+	}
+
+	TcpAcceptorPool::~TcpAcceptorPool()
+	{
+		this->stop();
+	}
+
+	bool TcpAcceptorPool::start(BindAddress addr, uint16_t port, const Handler& handler)
+	{
+		return this->start(IPAddress::fromBindAddress(addr), port, handler);
+	}
+
+	bool TcpAcceptorPool::start(const IPAddress& addr, uint16_t port, const Handler& handler)
+	{
+		if(this->_running)
+			return false;
+
+		this->_handler = handler;
+
+		for(size_t idx = 0; idx < this->_size; idx++) {
+			auto server = new SocketTcpServer();
+			auto shared = server->setOption(SOCKET_OPT_REUSEPORT, 1);
+
+			this->_servers.push_back(server);
+
+			if(!server->bind(addr, port)) {
+				this->release();
+				return false;
+			}
+
+			/* Without port sharing a second listener can't bind the port: serve from one socket. */
+			if(!shared)
+				break;
+		}
+
+		this->_running = true;
+
+		for(auto server : this->_servers) {
+			auto thread = new FunctionalThread("tcp-acceptor");
+
+			this->_threads.push_back(thread);
+			thread->start([this, server]() {
+				this->serve(server);
+			});
+		}
+
+		return true;
+	}
+
+	void TcpAcceptorPool::stop()
+	{
+		if(!this->_running)
+			return;
+
+		this->_running = false;
+
+		for(auto thread : this->_threads)
+			thread->join();
+
+		this->release();
+	}
+
+	size_t TcpAcceptorPool::listeners() const
+	{
+		return this->_servers.size();
+	}
+
+	void TcpAcceptorPool::serve(SocketTcpServer *server)
+	{
+		UniquePointer<TcpClient> clients[CONFIG_ACCEPTOR_BATCH];
+		socket_poll_t listener;
+
+		listener.socket = server->handle();
+		listener.events = SOCKET_POLL_READ;
+
+		while(this->_running) {
+			if(socket_poll(&listener, 1, this->_interval) <= 0)
+				continue;
+
+			if(listener.revents & SOCKET_POLL_ERROR)
+				break;
+
+			auto num = server->acceptMany(clients, CONFIG_ACCEPTOR_BATCH);
+
+			for(size_t idx = 0; idx < num; idx++) {
+				this->_handler(clients[idx]);
+				clients[idx].reset();
+			}
+		}
+	}
+
+	void TcpAcceptorPool::release()
+	{
+		for(auto thread : this->_threads)
+			delete thread;
+
+		for(auto server : this->_servers)
+			delete server;
+
+		this->_threads.clear();
+		this->_servers.clear();
+	}
+}
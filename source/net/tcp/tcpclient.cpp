@@ -7,6 +7,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <lwiot.h>
 
 #include <lwiot/types.h>
@@ -15,19 +16,76 @@
 #include <lwiot/network/tcpclient.h>
 #include <lwiot/error.h>
 #include <lwiot/network/stdnet.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/bufferedstream.h>
+
+#ifdef HAVE_UNISTD_H
+#include <lwiot/io/file.h>
+#endif
 
 namespace lwiot
 {
-	TcpClient::TcpClient() : _remote_addr((uint32_t)0), _remote_port(0)
+	TcpClient::TcpClient() : _remote_addr((uint32_t)0), _remote_port(0),
+		_readahead(CONFIG_TCP_READAHEAD_SIZE, BufferedStream::Circular), _connect_tmo(FOREVER)
+	{
+	}
+
+	TcpClient::TcpClient(const lwiot::IPAddress &addr, uint16_t port) : _remote_addr(addr), _remote_port(to_netorders(port)),
+		_readahead(CONFIG_TCP_READAHEAD_SIZE, BufferedStream::Circular), _connect_tmo(FOREVER)
+	{
+	}
+
+	TcpClient::TcpClient(const lwiot::String &host, uint16_t port) : _remote_addr((uint32_t)0), _remote_port(to_netorders(port)),
+		_readahead(CONFIG_TCP_READAHEAD_SIZE, BufferedStream::Circular), _connect_tmo(FOREVER)
+	{
+	}
+
+	bool TcpClient::alive() const
+	{
+		return this->connected();
+	}
+
+	bool TcpClient::writable(int tmo) const
+	{
+		UNUSED(tmo);
+		return this->connected();
+	}
+
+	bool TcpClient::readable(int tmo) const
+	{
+		auto start = lwiot_tick_ms();
+
+		while(this->available() == 0) {
+			if(!this->connected() || tmo == SOCKET_POLL_NOWAIT || (tmo != FOREVER && lwiot_tick_ms() - start >= tmo))
+				return false;
+
+			lwiot_sleep(1);
+		}
+
+		return true;
+	}
+
+	bool TcpClient::setOption(socket_option_t option, int value)
+	{
+		UNUSED(option);
+		UNUSED(value);
+
+		return false;
+	}
+
+	void TcpClient::setConnectTimeout(int ms)
 	{
+		this->_connect_tmo = ms;
 	}
 
-	TcpClient::TcpClient(const lwiot::IPAddress &addr, uint16_t port) : _remote_addr(addr), _remote_port(to_netorders(port))
+	SocketStats TcpClient::stats() const
 	{
+		return this->_stats;
 	}
 
-	TcpClient::TcpClient(const lwiot::String &host, uint16_t port) : _remote_addr((uint32_t)0), _remote_port(to_netorders(port))
+	void TcpClient::resetStats()
 	{
+		this->_stats.reset();
 	}
 
 	TcpClient& TcpClient::operator=(lwiot::TcpClient &&client)
@@ -68,6 +126,173 @@ namespace lwiot
 		return to_netorders(this->_remote_port);
 	}
 
+	ssize_t TcpClient::write(const BufferChain& chain)
+	{
+		ssize_t total = 0;
+
+		for(const auto& segment : chain) {
+			auto rv = this->write(segment.buffer(), segment.size());
+
+			if(rv < 0)
+				return total > 0 ? total : rv;
+
+			total += rv;
+
+			if(static_cast<size_t>(rv) < segment.size())
+				break;
+		}
+
+		return total;
+	}
+
+#ifdef HAVE_UNISTD_H
+	ssize_t TcpClient::sendFile(File& file, size_t offset, size_t length)
+	{
+		uint8_t buffer[CONFIG_TCP_FILE_CHUNK_SIZE];
+		ssize_t total = 0;
+
+		if(!file.seek(offset))
+			return -EINVALID;
+
+		while(static_cast<size_t>(total) < length) {
+			size_t num = length - total;
+
+			if(num > sizeof(buffer))
+				num = sizeof(buffer);
+
+			if(file.read(buffer, num) != static_cast<ssize_t>(num))
+				return total > 0 ? total : -EINVALID;
+
+			auto rv = this->write(buffer, num);
+
+			if(rv < 0)
+				return total > 0 ? total : rv;
+
+			total += rv;
+
+			if(static_cast<size_t>(rv) < num)
+				break;
+		}
+
+		return total;
+	}
+#endif
+
+	ssize_t TcpClient::receive(void *output, size_t length)
+	{
+		return -ENOTSUPPORTED;
+	}
+
+	ssize_t TcpClient::fill()
+	{
+		auto span = this->_readahead.writableSpan();
+
+		if(span.size() == 0)
+			return 0;
+
+		auto rv = this->receive(span.buffer(), span.size());
+
+		if(rv > 0)
+			this->_readahead.commitWrite(rv);
+
+		return rv;
+	}
+
+	ssize_t TcpClient::readBuffered(void *output, size_t length)
+	{
+		if(this->_readahead.available() == 0) {
+			/* Large reads go straight into the output buffer. */
+			if(length >= this->_readahead.size())
+				return this->receive(output, length);
+
+			auto rv = this->fill();
+
+			if(rv <= 0)
+				return rv;
+		}
+
+		return this->_readahead.read(output, length);
+	}
+
+	void TcpClient::dropReadAhead()
+	{
+		this->_readahead.commitRead(this->_readahead.available());
+	}
+
+	ssize_t TcpClient::readUntil(char delim, ByteBuffer& output)
+	{
+		auto rv = this->consumeUntil(delim, &output);
+
+		if(rv == -ENOTSUPPORTED)
+			return Stream::readUntil(delim, output);
+
+		return rv;
+	}
+
+	ssize_t TcpClient::skipUntil(char delim)
+	{
+		auto rv = this->consumeUntil(delim, nullptr);
+
+		if(rv == -ENOTSUPPORTED)
+			return Stream::skipUntil(delim);
+
+		return rv;
+	}
+
+	ssize_t TcpClient::consumeUntil(char delim, ByteBuffer *output)
+	{
+		ssize_t num = 0;
+
+		while(true) {
+			auto span = this->_readahead.readableSpan();
+
+			if(span.size() == 0) {
+				auto rv = this->fill();
+
+				if(rv == -ENOTSUPPORTED)
+					return rv;
+
+				/* The socket timed out or the connection was closed. */
+				if(rv < 0)
+					return -ETMO;
+				else if(rv == 0)
+					return num;
+
+				continue;
+			}
+
+			auto bytes = static_cast<const uint8_t*>(span.buffer());
+			auto end = static_cast<const uint8_t*>(memchr(bytes, delim, span.size()));
+			size_t length = end ? end - bytes : span.size();
+
+			if(output)
+				output->write(bytes, length);
+
+			num += length;
+			this->_readahead.commitRead(end ? length + 1 : length);
+
+			if(end)
+				return num;
+		}
+	}
+
+	RawBuffer TcpClient::peekSpan()
+	{
+		if(this->_readahead.available() == 0 && this->fill() <= 0)
+			return RawBuffer();
+
+		return this->_readahead.readableSpan();
+	}
+
+	size_t TcpClient::skip(size_t length)
+	{
+		if(length > this->_readahead.available())
+			length = this->_readahead.available();
+
+		this->_readahead.commitRead(length);
+		return length;
+	}
+
 	uint8_t TcpClient::read()
 	{
 		uint8_t tmp;
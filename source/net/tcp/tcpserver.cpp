@@ -38,6 +38,21 @@ namespace lwiot
 	{
 	}
 
+	size_t TcpServer::acceptMany(UniquePointer<TcpClient> *clients, size_t num)
+	{
+		if(num == 0)
+			return 0;
+
+		clients[0] = this->accept();
+		return clients[0] ? 1 : 0;
+	}
+
+	bool TcpServer::pending(int tmo)
+	{
+		UNUSED(tmo);
+		return true;
+	}
+
 	TcpServer& TcpServer::operator=(const lwiot::TcpServer &server)
 	{
 		this->_bind_addr = server._bind_addr;
@@ -0,0 +1,147 @@
+/*
+ * Cache of resumable TLS sessions.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/network/stdnet.h>
+#include <lwiot/network/tlssessioncache.h>
+
+namespace lwiot
+{
+	static void release_session(secure_session_t *session)
+	{
+#ifdef HAVE_TLS_SESSIONS
+		secure_session_free(session);
+#else
+		UNUSED(session);
+#endif
+	}
+
+	TlsSessionCache::TlsSessionCache(size_t capacity, int lifetime) : _lock(false), _capacity(capacity),
+		_lifetime(lifetime)
+	{
+	}
+
+	TlsSessionCache::~TlsSessionCache()
+	{
+		this->clear();
+	}
+
+	secure_session_t *TlsSessionCache::take(const String &host)
+	{
+		ScopedLock lock(this->_lock);
+		secure_session_t *session;
+
+		this->expire(lwiot_tick_ms());
+		auto idx = this->find(host);
+
+		if(idx < 0)
+			return nullptr;
+
+		session = this->_entries[idx]->session;
+		this->_entries[idx]->session = nullptr;
+		this->erase(idx);
+
+		return session;
+	}
+
+	void TlsSessionCache::put(const String &host, secure_session_t *session)
+	{
+		ScopedLock lock(this->_lock);
+		size_t oldest = 0;
+
+		if(session == nullptr)
+			return;
+
+		if(this->_capacity == 0) {
+			release_session(session);
+			return;
+		}
+
+		auto idx = this->find(host);
+
+		if(idx >= 0)
+			this->erase(idx);
+
+		if(this->_entries.size() >= this->_capacity) {
+			for(size_t i = 1; i < this->_entries.size(); i++) {
+				if(this->_entries[i]->stored < this->_entries[oldest]->stored)
+					oldest = i;
+			}
+
+			this->erase(oldest);
+		}
+
+		auto entry = new Entry;
+
+		entry->host = host;
+		entry->session = session;
+		entry->stored = lwiot_tick_ms();
+		this->_entries.pushback(entry);
+	}
+
+	void TlsSessionCache::remove(const String &host)
+	{
+		ScopedLock lock(this->_lock);
+		auto idx = this->find(host);
+
+		if(idx >= 0)
+			this->erase(idx);
+	}
+
+	void TlsSessionCache::clear()
+	{
+		ScopedLock lock(this->_lock);
+
+		while(this->_entries.size() > 0)
+			this->erase(this->_entries.size() - 1);
+	}
+
+	size_t TlsSessionCache::size() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_entries.size();
+	}
+
+	ssize_t TlsSessionCache::find(const String &host) const
+	{
+		for(size_t idx = 0; idx < this->_entries.size(); idx++) {
+			if(this->_entries[idx]->host == host)
+				return idx;
+		}
+
+		return -1;
+	}
+
+	void TlsSessionCache::erase(size_t idx)
+	{
+		auto entry = this->_entries[idx];
+
+		this->_entries.erase(idx);
+
+		if(entry->session != nullptr)
+			release_session(entry->session);
+
+		delete entry;
+	}
+
+	void TlsSessionCache::expire(time_t now)
+	{
+		for(size_t idx = 0; idx < this->_entries.size(); ) {
+			if(now - this->_entries[idx]->stored >= this->_lifetime) {
+				this->erase(idx);
+				continue;
+			}
+
+			idx++;
+		}
+	}
+}
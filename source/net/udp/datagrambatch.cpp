@@ -0,0 +1,125 @@
+/*
+ * Batch of UDP datagrams.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/heap.h>
+#include <lwiot/network/datagrambatch.h>
+
+namespace lwiot
+{
+	DatagramBatch::DatagramBatch(size_t capacity, size_t mtu) : _capacity(capacity), _mtu(mtu), _size(0)
+	{
+		this->_buffer = static_cast<uint8_t*>(lwiot_heap_alloc(capacity * mtu, LWIOT_HEAP_TAG_NET));
+		this->_datagrams = static_cast<socket_datagram_t*>(
+				lwiot_heap_zalloc(capacity * sizeof(socket_datagram_t), LWIOT_HEAP_TAG_NET));
+
+		assert(this->_buffer != nullptr || capacity == 0);
+		assert(this->_datagrams != nullptr || capacity == 0);
+
+		for(size_t idx = 0; idx < capacity; idx++)
+			this->_datagrams[idx].data = this->_buffer + idx * mtu;
+	}
+
+	DatagramBatch::~DatagramBatch()
+	{
+		lwiot_heap_free(this->_datagrams);
+		lwiot_heap_free(this->_buffer);
+	}
+
+	size_t DatagramBatch::capacity() const
+	{
+		return this->_capacity;
+	}
+
+	size_t DatagramBatch::size() const
+	{
+		return this->_size;
+	}
+
+	size_t DatagramBatch::mtu() const
+	{
+		return this->_mtu;
+	}
+
+	void DatagramBatch::clear()
+	{
+		this->_size = 0;
+	}
+
+	bool DatagramBatch::add(const void *data, size_t length, const IPAddress &addr, uint16_t port)
+	{
+		if(this->_size >= this->_capacity || length > this->_mtu)
+			return false;
+
+		auto& dgram = this->_datagrams[this->_size];
+
+		memcpy(dgram.data, data, length);
+		dgram.length = length;
+		addr.toRemoteAddress(dgram.remote);
+		dgram.remote.port = to_netorders(port);
+
+		this->_size++;
+		return true;
+	}
+
+	uint8_t *DatagramBatch::data(size_t idx)
+	{
+		assert(idx < this->_capacity);
+		return static_cast<uint8_t*>(this->_datagrams[idx].data);
+	}
+
+	const uint8_t *DatagramBatch::data(size_t idx) const
+	{
+		assert(idx < this->_capacity);
+		return static_cast<const uint8_t*>(this->_datagrams[idx].data);
+	}
+
+	size_t DatagramBatch::length(size_t idx) const
+	{
+		assert(idx < this->_size);
+		return this->_datagrams[idx].length;
+	}
+
+	IPAddress DatagramBatch::address(size_t idx) const
+	{
+		assert(idx < this->_size);
+		return IPAddress(this->_datagrams[idx].remote);
+	}
+
+	uint16_t DatagramBatch::port(size_t idx) const
+	{
+		assert(idx < this->_size);
+		return to_hostorders(this->_datagrams[idx].remote.port);
+	}
+
+	socket_datagram_t *DatagramBatch::prepare(size_t num)
+	{
+		if(num > this->_capacity)
+			num = this->_capacity;
+
+		for(size_t idx = 0; idx < num; idx++)
+			this->_datagrams[idx].length = this->_mtu;
+
+		this->_size = 0;
+		return this->_datagrams;
+	}
+
+	socket_datagram_t *DatagramBatch::datagrams() const
+	{
+		return this->_datagrams;
+	}
+
+	void DatagramBatch::setSize(size_t size)
+	{
+		assert(size <= this->_capacity);
+		this->_size = size;
+	}
+}
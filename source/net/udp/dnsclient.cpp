@@ -6,6 +6,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <lwiot.h>
 
 #include <lwiot/network/udpclient.h>
@@ -16,22 +17,236 @@
 
 namespace lwiot
 {
-	DnsClient::DnsClient() : _lock(false)
+	DnsClient::DnsClient(int ttl, int negative) : _lock(false), _ttl(ttl), _negative(negative)
 	{
 	}
 
+	DnsClient::~DnsClient()
+	{
+		UniqueLock<Lock> lock(this->_lock);
+
+		while(this->_entries.size() > 0)
+			this->erase(this->_entries.size() - 1);
+	}
+
 	IPAddress DnsClient::lookup(const lwiot::String &domain) const
 	{
+		IPAddress address;
+
 		if(domain.length() <= 0)
 			return IPAddress();
 
+		if(this->cached(domain, address))
+			return address;
+
+		auto found = DnsClient::resolve(domain, address);
+		this->store(domain, address, found);
+
+		return address;
+	}
+
+	bool DnsClient::lookup(const lwiot::String &domain, Executor &executor, const Handler &handler)
+	{
+		IPAddress address;
+
+		if(domain.length() <= 0)
+			return false;
+
+		UniqueLock<Lock> lock(this->_lock);
+
+		this->expire(lwiot_tick_ms());
+		auto idx = this->find(domain);
+
+		if(idx >= 0) {
+			auto entry = this->_entries[idx];
+
+			if(entry->pending) {
+				entry->waiters.push_back(handler);
+				return true;
+			}
+
+			address = entry->address;
+			lock.unlock();
+
+			handler(domain, address);
+			return true;
+		}
+
+		auto entry = new Entry;
+
+		entry->host = domain;
+		entry->found = false;
+		entry->pending = true;
+		entry->expires = 0;
+		entry->waiters.push_back(handler);
+		this->insert(entry);
+		lock.unlock();
+
+		String host(domain);
+		auto queued = executor.post([this, host]() {
+			IPAddress result;
+			auto found = DnsClient::resolve(host, result);
+
+			this->complete(host, result, found);
+		});
+
+		if(!queued) {
+			lock.lock();
+			idx = this->find(domain);
+
+			if(idx >= 0)
+				this->erase(idx);
+		}
+
+		return queued;
+	}
+
+	bool DnsClient::cached(const lwiot::String &domain, IPAddress &address) const
+	{
 		UniqueLock<Lock> lock(this->_lock);
-		auto raw = domain.c_str();
+
+		this->expire(lwiot_tick_ms());
+		auto idx = this->find(domain);
+
+		if(idx < 0 || this->_entries[idx]->pending)
+			return false;
+
+		address = this->_entries[idx]->address;
+		return true;
+	}
+
+	void DnsClient::flush()
+	{
+		UniqueLock<Lock> lock(this->_lock);
+
+		for(size_t idx = 0; idx < this->_entries.size(); ) {
+			if(!this->_entries[idx]->pending) {
+				this->erase(idx);
+				continue;
+			}
+
+			idx++;
+		}
+	}
+
+	bool DnsClient::resolve(const lwiot::String &domain, IPAddress &address)
+	{
 		remote_addr_t remote;
 
-		if(dns_resolve_host(raw, &remote) != -EOK)
-			return IPAddress(0,0,0,0);
+		memset(&remote, 0, sizeof(remote));
+#ifdef HAVE_IP6
+		remote.version = 0;
+#else
+		remote.version = 4;
+#endif
+
+		if(dns_resolve_host(domain.c_str(), &remote) != -EOK) {
+			address = IPAddress(0,0,0,0);
+			return false;
+		}
+
+		address = IPAddress(remote);
+		return true;
+	}
+
+	ssize_t DnsClient::find(const lwiot::String &domain) const
+	{
+		for(size_t idx = 0; idx < this->_entries.size(); idx++) {
+			if(this->_entries[idx]->host == domain)
+				return idx;
+		}
+
+		return -1;
+	}
+
+	void DnsClient::insert(Entry *entry) const
+	{
+		if(this->_entries.size() >= CONFIG_DNS_CACHE_SIZE) {
+			ssize_t oldest = -1;
+
+			for(size_t idx = 0; idx < this->_entries.size(); idx++) {
+				auto candidate = this->_entries[idx];
+
+				if(candidate->pending)
+					continue;
+
+				if(oldest < 0 || candidate->expires < this->_entries[oldest]->expires)
+					oldest = idx;
+			}
+
+			if(oldest >= 0)
+				this->erase(oldest);
+		}
+
+		this->_entries.pushback(entry);
+	}
+
+	void DnsClient::store(const lwiot::String &domain, const IPAddress &address, bool found) const
+	{
+		UniqueLock<Lock> lock(this->_lock);
+		auto idx = this->find(domain);
+		Entry *entry;
+
+		/* Leave pending entries alone; the running query will complete them. */
+		if(idx >= 0 && this->_entries[idx]->pending)
+			return;
+
+		if(idx >= 0) {
+			entry = this->_entries[idx];
+		} else {
+			entry = new Entry;
+			entry->host = domain;
+			entry->pending = false;
+			this->insert(entry);
+		}
+
+		entry->address = address;
+		entry->found = found;
+		entry->expires = lwiot_tick_ms() + (found ? this->_ttl : this->_negative);
+	}
+
+	void DnsClient::complete(const lwiot::String &domain, const IPAddress &address, bool found)
+	{
+		stl::Vector<Handler> waiters;
+		UniqueLock<Lock> lock(this->_lock);
+		auto idx = this->find(domain);
+
+		if(idx < 0)
+			return;
+
+		auto entry = this->_entries[idx];
+
+		entry->address = address;
+		entry->found = found;
+		entry->pending = false;
+		entry->expires = lwiot_tick_ms() + (found ? this->_ttl : this->_negative);
+		waiters = stl::move(entry->waiters);
+		entry->waiters.clear();
+		lock.unlock();
+
+		for(auto& waiter : waiters)
+			waiter(domain, address);
+	}
+
+	void DnsClient::erase(size_t idx) const
+	{
+		auto entry = this->_entries[idx];
+
+		this->_entries.erase(idx);
+		delete entry;
+	}
+
+	void DnsClient::expire(time_t now) const
+	{
+		for(size_t idx = 0; idx < this->_entries.size(); ) {
+			auto entry = this->_entries[idx];
+
+			if(!entry->pending && now >= entry->expires) {
+				this->erase(idx);
+				continue;
+			}
 
-		return stl::move(IPAddress(remote));
+			idx++;
+		}
 	}
 }
@@ -6,6 +6,7 @@
  */
 
 #include <lwiot.h>
+#include <ctype.h>
 
 #include <lwiot/network/stdnet.h>
 #include <lwiot/network/udpclient.h>
@@ -13,7 +14,6 @@
 #include <lwiot/network/dnsserver.h>
 
 #include <lwiot/stl/move.h>
-#include <lwiot/bytebuffer.h>
 
 static void setn16(void *pp, int16_t n)
 {
@@ -39,6 +39,11 @@ static uint16_t local_ntohs(uint16_t *in)
 	return ((p[0] << 8) & 0xff00) | (p[1] & 0xff);
 }
 
+static uint16_t get16(const char *p)
+{
+	return ((p[0] << 8) & 0xff00) | (p[1] & 0xff);
+}
+
 static char *label_to_str(char *packet, char *labelPtr, int packetSz, char *res, int resMaxLen)
 {
 	int i, j, k;
@@ -101,12 +106,16 @@ namespace lwiot
 	DnsServer::DnsServer() : Thread("dns-server")
 	{
 		this->_udp_msg = (char*) lwiot_mem_zalloc(DNS_LEN);
+		this->_reply = (char*) lwiot_mem_zalloc(DNS_LEN);
+		this->_label = (char*) lwiot_mem_zalloc(DNS_LEN);
 	}
 
 	DnsServer::~DnsServer()
 	{
 		this->_udp->close();
 		lwiot_mem_free(this->_udp_msg);
+		lwiot_mem_free(this->_reply);
+		lwiot_mem_free(this->_label);
 	}
 
 	void DnsServer::end()
@@ -138,35 +147,137 @@ namespace lwiot
 
 	void DnsServer::map(const lwiot::String &hostname, const lwiot::IPAddress &addr)
 	{
-		this->_table.add(hostname, addr);
+		char packet[DNS_LEN];
+		Record record;
+		String name(hostname);
+		uint32_t ip = addr;
+		auto ipaddr = reinterpret_cast<const uint8_t *>(&ip);
+
+		if(name.length() > DNS_LEN - sizeof(DnsHeader) - sizeof(DnsQuestionFooter) - sizeof(DnsResourceFooter) - 8)
+			return;
+
+		name.toLowerCase();
+
+		/* Header, question and an answer that points back at the name in the question. */
+		auto hdr = reinterpret_cast<DnsHeader *>(packet);
+		memset(hdr, 0, sizeof(*hdr));
+		hdr->flags = FLAG_QR | FLAG_AA;
+		setn16(&hdr->qdcount, 1);
+		setn16(&hdr->ancount, 1);
+
+		auto p = str_to_label(const_cast<char *>(name.c_str()), packet + sizeof(*hdr), DNS_LEN - sizeof(*hdr));
+		auto qf = reinterpret_cast<DnsQuestionFooter *>(p);
+		setn16(&qf->type, QTYPE_A);
+		setn16(&qf->q_class, QCLASS_IN);
+		p += sizeof(*qf);
+
+		*p++ = static_cast<char>(0xC0);
+		*p++ = sizeof(*hdr);
+
+		auto rf = reinterpret_cast<DnsResourceFooter *>(p);
+		setn16(&rf->type, QTYPE_A);
+		setn16(&rf->r_class, QCLASS_IN);
+		setn32(&rf->ttl, CONFIG_DNS_SERVER_TTL);
+		setn16(&rf->rdlength, 4);
+		p += sizeof(*rf);
+		memcpy(p, ipaddr, 4);
+		p += 4;
+
+		record.address = addr;
+		record.reply.reserveExact(static_cast<size_t>(p - packet));
+		record.reply.writeUnchecked(packet, static_cast<size_t>(p - packet));
+
+		ScopedLock lock(this->_lock);
+		this->_table.add(stl::move(name), stl::move(record));
+	}
+
+	bool DnsServer::hasRecord(const stl::StringView &record) const
+	{
+		return this->_table.contains(record);
 	}
 
 	void DnsServer::run()
 	{
-		size_t num;
+		IPAddress peer;
+		uint16_t port;
+		ssize_t num;
 		bool running_;
 
 		this->_lock.lock();
 		running_ = this->_running;
+		this->_udp->setTimeout(1);
 		this->_lock.unlock();
 
 		while(running_) {
 			Thread::yield();
 			ScopedLock lock(this->_lock);
-			memset(this->_udp_msg, 0, DNS_LEN);
-			num = DNS_LEN;
 
-			this->_udp->setTimeout(1);
-			auto client = this->_udp->recv(this->_udp_msg, num);
+			num = this->_udp->recvFrom(this->_udp_msg, DNS_LEN, peer, port);
 
-			if(client)
-				this->respond(*client, this->_udp_msg, num);
+			if(num > 0 && !this->answer(peer, port, this->_udp_msg, static_cast<size_t>(num)))
+				this->respond(peer, port, this->_udp_msg, static_cast<size_t>(num));
 
 			running_ = this->_running;
 		}
 	}
 
-	void DnsServer::respond(lwiot::UdpClient &client, DnsHeader *hdr, lwiot::DnsReplyCode drc)
+	bool DnsServer::answer(const IPAddress& peer, uint16_t port, const char *data, size_t length)
+	{
+		auto hdr = reinterpret_cast<const DnsHeader *>(data);
+		size_t idx = sizeof(DnsHeader);
+		size_t n = 0;
+
+		if(length < sizeof(DnsHeader) || length > DNS_LEN)
+			return false;
+
+		/* Only standard queries with a single question, optionally with an EDNS record. */
+		if((hdr->flags & ~FLAG_RD) != 0 || get16(data + 4) != 1 || hdr->ancount || hdr->nscount)
+			return false;
+
+		while(idx < length && data[idx] != 0) {
+			auto len = static_cast<uint8_t>(data[idx++]);
+
+			if(len > 63 || idx + len >= length)
+				return false;
+
+			if(n != 0)
+				this->_label[n++] = '.';
+
+			for(auto end = idx + len; idx < end; idx++)
+				this->_label[n++] = static_cast<char>(tolower(static_cast<uint8_t>(data[idx])));
+		}
+
+		idx++;
+
+		if(idx + sizeof(DnsQuestionFooter) > length)
+			return false;
+
+		if(get16(data + idx) != QTYPE_A || get16(data + idx + 2) != QCLASS_IN)
+			return false;
+
+		idx += sizeof(DnsQuestionFooter);
+
+		auto entry = this->_table.find(stl::StringView(this->_label, n));
+
+		if(entry == this->_table.end())
+			return false;
+
+		auto& reply = entry->value.reply;
+
+		if(reply.index() != idx + 2 + sizeof(DnsResourceFooter) + 4)
+			return false;
+
+		/* Echo the ID and the question, so that the case of the name is kept. */
+		memcpy(this->_reply, reply.data(), reply.index());
+		memcpy(this->_reply, data, sizeof(hdr->id));
+		memcpy(this->_reply + sizeof(DnsHeader), data + sizeof(DnsHeader), idx - sizeof(DnsHeader));
+		reinterpret_cast<DnsHeader *>(this->_reply)->flags |= hdr->flags & FLAG_RD;
+
+		this->_udp->sendTo(this->_reply, reply.index(), peer, port);
+		return true;
+	}
+
+	void DnsServer::respond(const IPAddress& peer, uint16_t port, DnsHeader *hdr, lwiot::DnsReplyCode drc)
 	{
 		hdr->rcode = static_cast<uint8_t>(drc);
 		hdr->flags |= FLAG_QR;
@@ -176,19 +287,17 @@ namespace lwiot
 		hdr->nscount = 0;
 		hdr->qdcount = 0;
 
-		client.write(hdr, sizeof(*hdr));
+		this->_udp->sendTo(hdr, sizeof(*hdr), peer, port);
 	}
 
-	void DnsServer::respond(UdpClient &client, char *data, const size_t &length)
+	void DnsServer::respond(const IPAddress& peer, uint16_t port, char *data, const size_t &length)
 	{
 		int i;
 		uint32_t addr;
 		uint8_t *ipaddr;
-		lwiot::ByteBuffer replybuffer(DNS_LEN);
-		lwiot::ByteBuffer buffer(DNS_LEN);
 
-		char *rawbuffer = (char *) buffer.data();
-		char *rawreply = (char *) replybuffer.data();
+		char *rawbuffer = this->_label;
+		char *rawreply = this->_reply;
 		char *rend = rawreply + length;
 		char *p = data;
 
@@ -210,6 +319,7 @@ namespace lwiot
 		if(hdr->flags & FLAG_TC)
 			return;
 
+		memset(rawreply, 0, DNS_LEN);
 		memcpy(rawreply, data, length);
 		rhdr->flags |= FLAG_QR;
 
@@ -220,21 +330,26 @@ namespace lwiot
 			if(p == nullptr)
 				return;
 
+			for(char *c = rawbuffer; *c != '\0'; c++)
+				*c = static_cast<char>(tolower(static_cast<uint8_t>(*c)));
+
 			qf = (DnsQuestionFooter *) p;
 			p += sizeof(DnsQuestionFooter);
 			print_dbg("DNS: Q (type 0x%X class 0x%X) for %s\n",
 					local_ntohs(&qf->type), local_ntohs(&qf->q_class), rawbuffer);
-			stl::String record(rawbuffer);
+			stl::StringView record(rawbuffer);
 
 			if(local_ntohs(&qf->type) == QTYPE_A) {
 				DnsResourceFooter *rf;
 
-				if(!this->_table.contains(record)) {
-					DnsServer::respond(client, hdr, DnsReplyCode::NonExistentDomain);
+				auto entry = this->_table.find(record);
+
+				if(entry == this->_table.end()) {
+					this->respond(peer, port, hdr, DnsReplyCode::NonExistentDomain);
 					return;
 				}
 
-				addr = this->_table.at(record);
+				addr = entry->value.address;
 				rend = str_to_label(rawbuffer, rend, DNS_LEN - (rend - rawreply));
 				rf = (DnsResourceFooter *) rend;
 
@@ -288,6 +403,6 @@ namespace lwiot
 			}
 		}
 
-		client.write(rawreply, static_cast<size_t>(rend - rawreply));
+		this->_udp->sendTo(rawreply, static_cast<size_t>(rend - rawreply), peer, port);
 	}
 }
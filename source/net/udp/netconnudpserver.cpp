@@ -0,0 +1,207 @@
+/*
+ * UDP server on the lwIP netconn API.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/error.h>
+
+#include <lwiot/network/stdnet.h>
+#include <lwiot/network/netconn.h>
+#include <lwiot/network/socketudpclient.h>
+#include <lwiot/network/netconnudpserver.h>
+
+namespace lwiot
+{
+	NetconnUdpServer::NetconnUdpServer() : UdpServer(), _conn(nullptr)
+	{
+	}
+
+	NetconnUdpServer::NetconnUdpServer(bind_addr_t addr, uint16_t port) :
+		UdpServer(IPAddress::fromBindAddress(addr), port), _conn(nullptr)
+	{
+	}
+
+	NetconnUdpServer::NetconnUdpServer(const IPAddress& addr, uint16_t port) : UdpServer(addr, port), _conn(nullptr)
+	{
+	}
+
+	NetconnUdpServer::~NetconnUdpServer()
+	{
+		this->close();
+	}
+
+	void NetconnUdpServer::close()
+	{
+		if(this->_conn == nullptr)
+			return;
+
+		netconn_delete(this->_conn);
+		this->_conn = nullptr;
+	}
+
+	bool NetconnUdpServer::bind(bind_addr_t addr, uint16_t port)
+	{
+		UdpServer::bind(IPAddress::fromBindAddress(addr), port);
+		return this->bind();
+	}
+
+	bool NetconnUdpServer::bind(const IPAddress& addr, uint16_t port)
+	{
+		UdpServer::bind(addr, port);
+		return this->bind();
+	}
+
+	bool NetconnUdpServer::bind()
+	{
+		ip_addr_t ip;
+
+		if(this->_conn == nullptr) {
+#if LWIP_IPV6
+			this->_conn = netconn_new(this->address().isIPv6() ? NETCONN_UDP_IPV6 : NETCONN_UDP);
+#else
+			this->_conn = netconn_new(NETCONN_UDP);
+#endif
+		}
+
+		if(this->_conn == nullptr)
+			return false;
+
+		netconn::toIpAddr(this->address(), ip);
+		return netconn_bind(this->_conn, &ip, to_hostorders(this->port())) == ERR_OK;
+	}
+
+	void NetconnUdpServer::setTimeout(int tmo)
+	{
+		assert(this->_conn);
+		netconn_set_recvtimeout(this->_conn, tmo * 1000);
+	}
+
+	struct netbuf *NetconnUdpServer::next(IPAddress& addr, uint16_t& port, err_t& err)
+	{
+		struct netbuf *buf = nullptr;
+
+		if(this->_conn == nullptr) {
+			err = ERR_CONN;
+			return nullptr;
+		}
+
+		err = netconn_recv(this->_conn, &buf);
+
+		if(err != ERR_OK)
+			return nullptr;
+
+		addr = netconn::fromIpAddr(*netbuf_fromaddr(buf));
+		port = netbuf_fromport(buf);
+
+		return buf;
+	}
+
+	ssize_t NetconnUdpServer::recvFrom(void *buffer, size_t length, IPAddress& addr, uint16_t& port)
+	{
+		err_t err;
+		auto buf = this->next(addr, port, err);
+
+		if(buf == nullptr)
+			return err == ERR_TIMEOUT ? -ETMO : -EINVALID;
+
+		auto num = netbuf_copy(buf, buffer, length);
+
+		netbuf_delete(buf);
+		return num;
+	}
+
+	UniquePointer<UdpClient> NetconnUdpServer::recv(void *buffer, size_t& length)
+	{
+		UniquePointer<UdpClient> client;
+		IPAddress addr;
+		uint16_t port;
+
+		auto num = this->recvFrom(buffer, length, addr, port);
+
+		if(num < 0)
+			return client;
+
+		length = static_cast<size_t>(num);
+		client.reset(new SocketUdpClient(addr, port));
+
+		return client;
+	}
+
+	ssize_t NetconnUdpServer::receive(SharedByteBuffer& datagram, IPAddress& addr, uint16_t& port)
+	{
+		err_t err;
+		auto buf = this->next(addr, port, err);
+
+		if(buf == nullptr)
+			return err == ERR_TIMEOUT ? -ETMO : -EINVALID;
+
+		auto p = buf->p;
+
+		if(p->next == nullptr) {
+			datagram = netconn::share(p);
+		} else {
+			ByteBuffer copy(p->tot_len, true);
+
+			for(auto q = p; q != nullptr; q = q->next)
+				copy.write(static_cast<const uint8_t*>(q->payload), q->len);
+
+			datagram = SharedByteBuffer(stl::move(copy));
+		}
+
+		netbuf_delete(buf);
+		return datagram.size();
+	}
+
+	bool NetconnUdpServer::joinGroup(const IPAddress& group)
+	{
+		ip_addr_t ip;
+
+		if(this->_conn == nullptr || !group.isMulticast())
+			return false;
+
+		netconn::toIpAddr(group, ip);
+		return netconn_join_leave_group(this->_conn, &ip, IP_ADDR_ANY, NETCONN_JOIN) == ERR_OK;
+	}
+
+	bool NetconnUdpServer::leaveGroup(const IPAddress& group)
+	{
+		ip_addr_t ip;
+
+		if(this->_conn == nullptr)
+			return false;
+
+		netconn::toIpAddr(group, ip);
+		return netconn_join_leave_group(this->_conn, &ip, IP_ADDR_ANY, NETCONN_LEAVE) == ERR_OK;
+	}
+
+	ssize_t NetconnUdpServer::sendTo(const void *data, size_t length, const IPAddress& addr, uint16_t port)
+	{
+		ip_addr_t ip;
+		auto buf = netbuf_new();
+
+		if(buf == nullptr || this->_conn == nullptr) {
+			netbuf_delete(buf);
+			return -ENOMEMORY;
+		}
+
+		netconn::toIpAddr(addr, ip);
+
+		if(netbuf_ref(buf, data, length) != ERR_OK) {
+			netbuf_delete(buf);
+			return -ENOMEMORY;
+		}
+
+		auto err = netconn_sendto(this->_conn, buf, &ip, port);
+
+		netbuf_delete(buf);
+		return err == ERR_OK ? static_cast<ssize_t>(length) : -EINVALID;
+	}
+}
@@ -21,12 +21,12 @@
 
 namespace lwiot
 {
-	SocketUdpClient::SocketUdpClient() : UdpClient(), _socket(nullptr), _noclose(false)
+	SocketUdpClient::SocketUdpClient() : UdpClient(), _socket(nullptr), _noclose(false), _bound(false)
 	{
 	}
 
 	SocketUdpClient::SocketUdpClient(const IPAddress &addr, uint16_t port, socket_t* srv) :
-		UdpClient(addr, port), _socket(srv)
+		UdpClient(addr, port), _socket(srv), _bound(srv != nullptr)
 	{
 		if(srv == nullptr)
 			this->init();
@@ -34,7 +34,7 @@ namespace lwiot
 			this->_noclose = true;
 	}
 
-	SocketUdpClient::SocketUdpClient(const lwiot::String &host, uint16_t port) : UdpClient(host, port)
+	SocketUdpClient::SocketUdpClient(const lwiot::String &host, uint16_t port) : UdpClient(host, port), _bound(false)
 	{
 		this->init();
 	}
@@ -68,6 +68,17 @@ namespace lwiot
 		this->address().toRemoteAddress(remote);
 		this->_socket = udp_socket_create(&remote);
 		this->_noclose = false;
+		this->_bound = false;
+	}
+
+	bool SocketUdpClient::open()
+	{
+		if(this->_socket == nullptr) {
+			this->resolve();
+			this->init();
+		}
+
+		return this->_socket != nullptr;
 	}
 
 	SocketUdpClient::~SocketUdpClient()
@@ -89,38 +100,89 @@ namespace lwiot
 		socket_set_timeout(this->_socket, seconds);
 	}
 
-	ssize_t SocketUdpClient::write(const void *buffer, const size_t& length)
+	bool SocketUdpClient::setOption(socket_option_t option, int value)
+	{
+		if(!this->open())
+			return false;
+
+		return socket_set_option(this->_socket, option, value) == -EOK;
+	}
+
+	/* Members receive on the port of the group, so the socket is bound to it on first join. */
+	bool SocketUdpClient::joinGroup(const IPAddress& group)
 	{
 		remote_addr_t remote;
 
-		if(this->_socket == nullptr) {
-			this->resolve();
-			this->init();
+		if(!group.isMulticast() || !this->open())
+			return false;
+
+		if(!this->_bound) {
+			auto any = IPAddress::fromBindAddress(group.isIPv6() ? BIND6_ADDR_ANY : BIND_ADDR_ANY);
+
+			any.toRemoteAddress(remote);
+
+			if(!server_socket_bind_to(this->_socket, &remote, this->port()))
+				return false;
+
+			this->_bound = true;
 		}
 
+		group.toRemoteAddress(remote);
+		return udp_socket_join_group(this->_socket, &remote) == -EOK;
+	}
+
+	bool SocketUdpClient::leaveGroup(const IPAddress& group)
+	{
+		remote_addr_t remote;
+
 		if(this->_socket == nullptr)
+			return false;
+
+		group.toRemoteAddress(remote);
+		return udp_socket_leave_group(this->_socket, &remote) == -EOK;
+	}
+
+	ssize_t SocketUdpClient::broadcast(const void *data, size_t length, uint16_t port)
+	{
+		if(!this->open())
+			return -EINVALID;
+
+		auto rv = udp_broadcast(this->_socket, data, length, to_netorders(port));
+		this->_stats.sent(rv);
+
+		return rv;
+	}
+
+	ssize_t SocketUdpClient::write(const void *buffer, const size_t& length)
+	{
+		remote_addr_t remote;
+
+		if(!this->open())
 			return -EINVALID;
 
 		this->address().toRemoteAddress(remote);
 		remote.version = this->address().version();
 		remote.port = this->port();
-		return udp_send_to(this->_socket, buffer, length, &remote);
+
+		auto rv = udp_send_to(this->_socket, buffer, length, &remote);
+		this->_stats.sent(rv);
+
+		return rv;
 	}
 
 	ssize_t SocketUdpClient::read(void *buffer, const size_t& length)
 	{
 		remote_addr_t remote;
 
-		if(this->_socket == nullptr) {
-			this->resolve();
-			this->init();
-		}
-
-		if(this->_socket == nullptr)
+		if(!this->open())
 			return -EINVALID;
 
 		remote.version = this->address().version();
-		return udp_recv_from(this->_socket, buffer, length, &remote);
+
+		auto rv = udp_recv_from(this->_socket, buffer, length, &remote);
+		this->_stats.received(rv);
+
+		return rv;
 	}
 
 	size_t SocketUdpClient::available() const
@@ -18,9 +18,14 @@
 #include <lwiot/network/udpclient.h>
 #include <lwiot/network/socketudpserver.h>
 #include <lwiot/network/socketudpclient.h>
+#include <lwiot/util/objectpool.h>
 
 namespace lwiot
 {
+#if CONFIG_UDP_CLIENT_POOL > 0
+	static ObjectPool<SocketUdpClient, CONFIG_UDP_CLIENT_POOL> client_pool;
+#endif
+
 	SocketUdpServer::SocketUdpServer() : UdpServer()
 	{
 		this->_socket = server_socket_create(SOCKET_DGRAM, this->address().isIPv6());
@@ -93,9 +98,89 @@ namespace lwiot
 		length = static_cast<size_t>(num);
 		/* Convert to host order, as UdpClient expects the port number to be supplied in host order */
 		remote.port = to_hostorders(remote.port);
-		auto raw = new SocketUdpClient(IPAddress(remote), remote.port, this->_socket);
+		IPAddress addr(remote);
+		UdpClient *raw = nullptr;
+
+		/* Datagram senders come from the pool, and from the heap once it is exhausted. */
+#if CONFIG_UDP_CLIENT_POOL > 0
+		raw = client_pool.create(addr, remote.port, this->_socket);
+#endif
+
+		if(raw == nullptr)
+			raw = new SocketUdpClient(addr, remote.port, this->_socket);
+
 		client.reset(raw);
 
 		return client;
 	}
+
+	ssize_t SocketUdpServer::recvFrom(void *buffer, size_t length, IPAddress &addr, uint16_t &port)
+	{
+		remote_addr_t remote;
+
+		remote.version = this->address().version();
+		auto num = udp_recv_from(this->_socket, buffer, length, &remote);
+
+		if(num < 0)
+			return num;
+
+		addr = IPAddress(remote);
+		port = to_hostorders(remote.port);
+
+		return num;
+	}
+
+	ssize_t SocketUdpServer::sendTo(const void *data, size_t length, const IPAddress &addr, uint16_t port)
+	{
+		remote_addr_t remote;
+
+		addr.toRemoteAddress(remote);
+		remote.port = to_netorders(port);
+
+		return udp_send_to(this->_socket, data, length, &remote);
+	}
+
+	ssize_t SocketUdpServer::recvBatch(DatagramBatch &batch, size_t num)
+	{
+		auto datagrams = batch.prepare(num);
+
+		if(num > batch.capacity())
+			num = batch.capacity();
+
+		auto rv = udp_recv_batch(this->_socket, datagrams, num);
+
+		if(rv > 0)
+			batch.setSize(static_cast<size_t>(rv));
+
+		return rv;
+	}
+
+	ssize_t SocketUdpServer::sendBatch(const DatagramBatch &batch)
+	{
+		return udp_send_batch(this->_socket, batch.datagrams(), batch.size());
+	}
+
+	bool SocketUdpServer::joinGroup(const IPAddress& group)
+	{
+		remote_addr_t remote;
+
+		if(!group.isMulticast())
+			return false;
+
+		group.toRemoteAddress(remote);
+		return udp_socket_join_group(this->_socket, &remote) == -EOK;
+	}
+
+	bool SocketUdpServer::leaveGroup(const IPAddress& group)
+	{
+		remote_addr_t remote;
+
+		group.toRemoteAddress(remote);
+		return udp_socket_leave_group(this->_socket, &remote) == -EOK;
+	}
+
+	bool SocketUdpServer::setOption(socket_option_t option, int value)
+	{
+		return socket_set_option(this->_socket, option, value) == -EOK;
+	}
 }
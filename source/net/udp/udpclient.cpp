@@ -45,6 +45,55 @@ namespace lwiot
 		return this->_port;
 	}
 
+	bool UdpClient::setOption(socket_option_t option, int value)
+	{
+		UNUSED(option);
+		UNUSED(value);
+
+		return false;
+	}
+
+	bool UdpClient::joinGroup(const IPAddress& group)
+	{
+		UNUSED(group);
+		return false;
+	}
+
+	bool UdpClient::leaveGroup(const IPAddress& group)
+	{
+		UNUSED(group);
+		return false;
+	}
+
+	ssize_t UdpClient::broadcast(const void *data, size_t length, uint16_t port)
+	{
+		UNUSED(data);
+		UNUSED(length);
+		UNUSED(port);
+
+		return -ENOTSUPPORTED;
+	}
+
+	bool UdpClient::setMulticastTtl(int hops)
+	{
+		return this->setOption(SOCKET_OPT_MULTICAST_TTL, hops);
+	}
+
+	bool UdpClient::setMulticastLoopback(bool enable)
+	{
+		return this->setOption(SOCKET_OPT_MULTICAST_LOOP, enable ? 1 : 0);
+	}
+
+	const SocketStats& UdpClient::stats() const
+	{
+		return this->_stats;
+	}
+
+	void UdpClient::resetStats()
+	{
+		this->_stats.reset();
+	}
+
 	void UdpClient::resolve()
 	{
 		remote_addr_t remote;
@@ -25,6 +25,56 @@ namespace lwiot
 	{
 	}
 
+	ssize_t UdpServer::recvFrom(void *buffer, size_t length, IPAddress &addr, uint16_t &port)
+	{
+		auto client = this->recv(buffer, length);
+
+		if(!client)
+			return -ETMO;
+
+		addr = client->address();
+		port = to_hostorders(client->port());
+
+		return static_cast<ssize_t>(length);
+	}
+
+	ssize_t UdpServer::sendTo(const void *data, size_t length, const IPAddress &addr, uint16_t port)
+	{
+		UNUSED(data);
+		UNUSED(length);
+		UNUSED(addr);
+		UNUSED(port);
+
+		return -ENOTSUPPORTED;
+	}
+
+	ssize_t UdpServer::recvBatch(DatagramBatch &batch, size_t num)
+	{
+		auto datagrams = batch.prepare(num);
+
+		if(num == 0 || batch.capacity() == 0)
+			return 0;
+
+		auto length = batch.mtu();
+		auto client = this->recv(datagrams->data, length);
+
+		if(!client)
+			return -ETMO;
+
+		datagrams->length = length;
+		client->address().toRemoteAddress(datagrams->remote);
+		datagrams->remote.port = client->port();
+		batch.setSize(1);
+
+		return 1;
+	}
+
+	ssize_t UdpServer::sendBatch(const DatagramBatch &batch)
+	{
+		UNUSED(batch);
+		return -ENOTSUPPORTED;
+	}
+
 	UdpServer::UdpServer(const IPAddress& addr, uint16_t port) :
 		_bind_addr(addr), _bind_port(to_netorders(port))
 	{
@@ -6,6 +6,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <lwiot.h>
 #include <stdio.h>
 
@@ -13,17 +14,214 @@
 #include <lwiot/log.h>
 #include <lwiot/network/base64.h>
 
-static int base64_decode_value_signed(int8_t value_in)
+/*
+ * Hosted builds encode and decode 16 characters at a time when the compiler targets SSSE3 or
+ * AArch64. Everything else, and whatever is left over, goes through the lookup tables, a group
+ * of 3 bytes and 4 characters at a time.
+ */
+#if defined(__GNUC__) && defined(__SSSE3__)
+#include <tmmintrin.h>
+#define BASE64_SSSE3
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define BASE64_NEON
+#endif
+
+static const char encoding[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* -1 for characters that are skipped, -2 for padding. */
+static const int8_t decoding[256] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+	52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -2, -1, -1,
+	-1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+	15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+	-1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+	41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+#if defined(BASE64_SSSE3)
+/* Encode 12 bytes, loaded as 16. See W. Mula, D. Lemire, "Faster Base64 Encoding and Decoding Using AVX2 Instructions". */
+static inline __m128i base64_encode_vector(__m128i in)
+{
+	__m128i indices, result, less;
+	const __m128i shift = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+	                                    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+	in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+	indices = _mm_or_si128(
+		_mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040)),
+		_mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010)));
+
+	result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+	less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+	result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+
+	return _mm_add_epi8(_mm_shuffle_epi8(shift, result), indices);
+}
+
+/* Decode 16 characters into 12 bytes. Returns 0 if any of them is not part of the alphabet. */
+static inline int base64_decode_vector(const char *input, uint8_t *output)
+{
+	const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A,
+	                                     0x1B, 0x1B, 0x1B, 0x1A);
+	const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+	                                     0x10, 0x10, 0x10, 0x10);
+	const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i mask = _mm_set1_epi8(0x2F);
+	__m128i in, hi, lo, roll;
+	uint8_t bytes[16];
+
+	in = _mm_loadu_si128((const __m128i *) input);
+	hi = _mm_and_si128(_mm_srli_epi32(in, 4), mask);
+	lo = _mm_and_si128(in, mask);
+
+	if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(_mm_shuffle_epi8(lut_lo, lo), _mm_shuffle_epi8(lut_hi, hi)),
+	                                    _mm_setzero_si128())) != 0xFFFF)
+		return 0;
+
+	roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(in, mask), hi));
+	in = _mm_add_epi8(in, roll);
+	in = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+	in = _mm_madd_epi16(in, _mm_set1_epi32(0x00011000));
+	in = _mm_shuffle_epi8(in, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+	_mm_storeu_si128((__m128i *) bytes, in);
+	memcpy(output, bytes, 12);
+	return 1;
+}
+#elif defined(BASE64_NEON)
+static inline uint8x16x4_t base64_load_table(const uint8_t *table)
+{
+	uint8x16x4_t result;
+
+	result.val[0] = vld1q_u8(table);
+	result.val[1] = vld1q_u8(table + 16);
+	result.val[2] = vld1q_u8(table + 32);
+	result.val[3] = vld1q_u8(table + 48);
+
+	return result;
+}
+
+static inline uint8x16_t base64_encode_vector(uint8x16_t in)
+{
+	const uint8x16_t shuffle = { 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10 };
+	uint32x4_t lanes, indices;
+
+	/* Every 32 bit lane holds the bytes b1 b0 b2 b1 of its group, as in the SSSE3 version. */
+	lanes = vreinterpretq_u32_u8(vqtbl1q_u8(in, shuffle));
+	indices = vshrq_n_u32(vandq_u32(lanes, vdupq_n_u32(0x0000fc00)), 10);
+	indices = vorrq_u32(indices, vshlq_n_u32(vandq_u32(lanes, vdupq_n_u32(0x000003f0)), 4));
+	indices = vorrq_u32(indices, vshrq_n_u32(vandq_u32(lanes, vdupq_n_u32(0x0fc00000)), 6));
+	indices = vorrq_u32(indices, vshlq_n_u32(vandq_u32(lanes, vdupq_n_u32(0x003f0000)), 8));
+
+	return vqtbl4q_u8(base64_load_table((const uint8_t *) encoding), vreinterpretq_u8_u32(indices));
+}
+
+static inline int base64_decode_vector(const char *input, uint8_t *output)
 {
-	static const int8_t decoding[] = {62, -1, -1, -1, 63, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -2, -1,
-	                                  -1, -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
-	                                  21, 22, 23, 24, 25, -1, -1, -1, -1, -1, -1, 26, 27, 28, 29, 30, 31, 32, 33, 34,
-	                                  35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51};
-	static const int8_t decoding_size = sizeof(decoding);
-	value_in -= 43;
-	if(value_in < 0 || value_in > decoding_size)
-		return -1;
-	return decoding[(int) value_in];
+	uint8x16_t in, values, invalid;
+	uint8_t v[16];
+	int idx;
+
+	/* Characters are translated with a 64 byte lookup, one for each half of the ASCII range. */
+	in = vld1q_u8((const uint8_t *) input);
+	invalid = vcgtq_u8(in, vdupq_n_u8(127));
+
+	values = vqtbl4q_u8(base64_load_table((const uint8_t *) decoding), in);
+	values = vorrq_u8(values, vqtbl4q_u8(base64_load_table((const uint8_t *) decoding + 64),
+	                                     vsubq_u8(in, vdupq_n_u8(64))));
+	invalid = vorrq_u8(invalid, vcgtq_u8(values, vdupq_n_u8(63)));
+
+	if(vmaxvq_u8(invalid) != 0)
+		return 0;
+
+	vst1q_u8(v, values);
+
+	for(idx = 0; idx < 4; idx++) {
+		output[idx * 3] = (uint8_t) ((v[idx * 4] << 2) | (v[idx * 4 + 1] >> 4));
+		output[idx * 3 + 1] = (uint8_t) ((v[idx * 4 + 1] << 4) | (v[idx * 4 + 2] >> 2));
+		output[idx * 3 + 2] = (uint8_t) ((v[idx * 4 + 2] << 6) | v[idx * 4 + 3]);
+	}
+
+	return 1;
+}
+#endif
+
+/* Encode \p groups groups of 3 bytes. */
+static void base64_encode_groups(const uint8_t *input, size_t groups, char *output)
+{
+#if defined(BASE64_SSSE3)
+	/* The vector loads 16 bytes for 12, so the last group is left to the tables. */
+	for(; groups > 5; groups -= 4) {
+		_mm_storeu_si128((__m128i *) output, base64_encode_vector(_mm_loadu_si128((const __m128i *) input)));
+		input += 12;
+		output += 16;
+	}
+#elif defined(BASE64_NEON)
+	for(; groups > 5; groups -= 4) {
+		vst1q_u8((uint8_t *) output, base64_encode_vector(vld1q_u8(input)));
+		input += 12;
+		output += 16;
+	}
+#endif
+
+	for(; groups > 0; groups--) {
+		uint32_t value = ((uint32_t) input[0] << 16) | ((uint32_t) input[1] << 8) | input[2];
+
+		output[0] = encoding[value >> 18];
+		output[1] = encoding[(value >> 12) & 0x3F];
+		output[2] = encoding[(value >> 6) & 0x3F];
+		output[3] = encoding[value & 0x3F];
+
+		input += 3;
+		output += 4;
+	}
+}
+
+/*
+ * Decode complete groups of 4 characters from the alphabet, and stop in front of the first group that
+ * holds anything else. Returns the number of bytes written.
+ */
+static size_t base64_decode_groups(const uint8_t **input, const uint8_t *end, uint8_t *output)
+{
+	const uint8_t *ptr = *input;
+	uint8_t *start = output;
+
+#if defined(BASE64_SSSE3) || defined(BASE64_NEON)
+	while(end - ptr >= 16 && base64_decode_vector((const char *) ptr, output)) {
+		ptr += 16;
+		output += 12;
+	}
+#endif
+
+	while(end - ptr >= 4) {
+		int8_t a = decoding[ptr[0]], b = decoding[ptr[1]], c = decoding[ptr[2]], d = decoding[ptr[3]];
+		uint32_t value;
+
+		if((a | b | c | d) < 0)
+			break;
+
+		value = ((uint32_t) a << 18) | ((uint32_t) b << 12) | ((uint32_t) c << 6) | (uint32_t) d;
+		output[0] = (uint8_t) (value >> 16);
+		output[1] = (uint8_t) (value >> 8);
+		output[2] = (uint8_t) value;
+
+		ptr += 4;
+		output += 3;
+	}
+
+	*input = ptr;
+	return (size_t) (output - start);
 }
 
 void base64_init_decodestate(base64_decodestate *state_in)
@@ -32,88 +230,76 @@ void base64_init_decodestate(base64_decodestate *state_in)
 	state_in->plainchar = 0;
 }
 
-static int base64_decode_block_signed(const int8_t *code_in, const int length_in, int8_t *plaintext_out,
-                                      base64_decodestate *state_in)
+int base64_decode_value(char value_in)
 {
-	const int8_t *codechar = code_in;
-	int8_t *plainchar = plaintext_out;
+	return decoding[(uint8_t) value_in];
+}
+
+int base64_decode_block(const char *code_in, const int length_in, char *plaintext_out, base64_decodestate *state_in)
+{
+	const uint8_t *codechar = (const uint8_t *) code_in;
+	const uint8_t *end = codechar + length_in;
+	uint8_t *plainchar = (uint8_t *) plaintext_out;
+	uint8_t partial = (uint8_t) state_in->plainchar;
+	base64_decodestep step = state_in->step;
 	int8_t fragment;
 
-	*plainchar = state_in->plainchar;
+	while(codechar < end) {
+		/* Whole groups are decoded in bulk, anything else one character at a time. */
+		if(step == step_a) {
+			plainchar += base64_decode_groups(&codechar, end, plainchar);
 
-	switch(state_in->step) {
-		while(1) {
+			if(codechar == end)
+				break;
+		}
+
+		fragment = decoding[*codechar++];
+
+		if(fragment < 0)
+			continue;
+
+		switch(step) {
 		case step_a:
-			do {
-				if(codechar == code_in + length_in) {
-					state_in->step = step_a;
-					state_in->plainchar = *plainchar;
-					return plainchar - plaintext_out;
-				}
-				fragment = (int8_t) base64_decode_value_signed(*codechar++);
-			} while(fragment < 0);
-			*plainchar = (fragment & 0x03f) << 2;
+			partial = (uint8_t) (fragment << 2);
+			step = step_b;
+			break;
+
 		case step_b:
-			do {
-				if(codechar == code_in + length_in) {
-					state_in->step = step_b;
-					state_in->plainchar = *plainchar;
-					return plainchar - plaintext_out;
-				}
-				fragment = (int8_t) base64_decode_value_signed(*codechar++);
-			} while(fragment < 0);
-			*plainchar++ |= (fragment & 0x030) >> 4;
-			*plainchar = (fragment & 0x00f) << 4;
+			*plainchar++ = partial | (fragment >> 4);
+			partial = (uint8_t) (fragment << 4);
+			step = step_c;
+			break;
+
 		case step_c:
-			do {
-				if(codechar == code_in + length_in) {
-					state_in->step = step_c;
-					state_in->plainchar = *plainchar;
-					return plainchar - plaintext_out;
-				}
-				fragment = (int8_t) base64_decode_value_signed(*codechar++);
-			} while(fragment < 0);
-			*plainchar++ |= (fragment & 0x03c) >> 2;
-			*plainchar = (fragment & 0x003) << 6;
+			*plainchar++ = partial | (fragment >> 2);
+			partial = (uint8_t) (fragment << 6);
+			step = step_d;
+			break;
+
 		case step_d:
-			do {
-				if(codechar == code_in + length_in) {
-					state_in->step = step_d;
-					state_in->plainchar = *plainchar;
-					return plainchar - plaintext_out;
-				}
-				fragment = (int8_t) base64_decode_value_signed(*codechar++);
-			} while(fragment < 0);
-			*plainchar++ |= (fragment & 0x03f);
+			*plainchar++ = partial | fragment;
+			step = step_a;
+			break;
 		}
 	}
-	/* control should not reach here */
-	return plainchar - plaintext_out;
+
+	state_in->step = step;
+	state_in->plainchar = (char) partial;
+	return (int) (plainchar - (uint8_t *) plaintext_out);
 }
 
-static int base64_decode_chars_signed(const int8_t *code_in, const int length_in, int8_t *plaintext_out)
+int base64_decode_chars(const char *code_in, const int length_in, char *plaintext_out)
 {
 	base64_decodestate _state;
+	int len;
+
 	base64_init_decodestate(&_state);
-	int len = base64_decode_block_signed(code_in, length_in, plaintext_out, &_state);
+	len = base64_decode_block(code_in, length_in, plaintext_out, &_state);
+
 	if(len > 0)
 		plaintext_out[len] = 0;
-	return len;
-}
-
-int base64_decode_value(char value_in)
-{
-	return base64_decode_value_signed(*((int8_t *) &value_in));
-}
-
-int base64_decode_block(const char *code_in, const int length_in, char *plaintext_out, base64_decodestate *state_in)
-{
-	return base64_decode_block_signed((int8_t *) code_in, length_in, (int8_t *) plaintext_out, state_in);
-}
 
-int base64_decode_chars(const char *code_in, const int length_in, char *plaintext_out)
-{
-	return base64_decode_chars_signed((int8_t *) code_in, length_in, (int8_t *) plaintext_out);
+	return len;
 }
 
 void base64_init_encodestate(base64_encodestate *state_in)
@@ -133,7 +319,6 @@ void base64_init_encodestate_nonewlines(base64_encodestate *state_in)
 
 char base64_encode_value(char value_in)
 {
-	static const char *encoding = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 	if(value_in > 63)
 		return '=';
 	return encoding[(int) value_in];
@@ -147,6 +332,26 @@ int base64_encode_block(const char *plaintext_in, int length_in, char *code_out,
 	char result;
 	char fragment;
 
+	/* Whole groups are encoded in bulk, up to the end of the line. */
+	if(state_in->step == step_A) {
+		while(plaintextend - plainchar >= 3) {
+			size_t groups = (size_t) (plaintextend - plainchar) / 3;
+
+			if(state_in->stepsnewline > 0 && groups > (size_t) (BASE64_CHARS_PER_LINE / 4 - state_in->stepcount))
+				groups = (size_t) (BASE64_CHARS_PER_LINE / 4 - state_in->stepcount);
+
+			base64_encode_groups((const uint8_t *) plainchar, groups, codechar);
+			plainchar += groups * 3;
+			codechar += groups * 4;
+			state_in->stepcount += (int) groups;
+
+			if((state_in->stepcount == BASE64_CHARS_PER_LINE / 4) && (state_in->stepsnewline > 0)) {
+				*codechar++ = '\n';
+				state_in->stepcount = 0;
+			}
+		}
+	}
+
 	result = state_in->result;
 
 	switch(state_in->step) {
@@ -0,0 +1,116 @@
+/*
+ * Streaming base 64 encoder and decoder.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/error.h>
+#include <lwiot/stream.h>
+#include <lwiot/network/base64.h>
+#include <lwiot/network/base64stream.h>
+
+static_assert(CONFIG_BASE64_BUFFER >= 32, "CONFIG_BASE64_BUFFER is too small");
+
+/*
+ * Input taken per round. It encodes to at most 4/5th of the buffer, plus a carried group and the
+ * line breaks, which leaves room for the terminator written by base64_encode_blockend().
+ */
+#define ENCODE_CHUNK ((CONFIG_BASE64_BUFFER / 5) * 3)
+
+namespace lwiot
+{
+	static ssize_t flush(Stream& output, const char *data, int length)
+	{
+		if(length <= 0)
+			return 0;
+
+		if(output.write(data, static_cast<size_t>(length)) != length)
+			return -EINVALID;
+
+		return length;
+	}
+
+	Base64Encoder::Base64Encoder(Stream &output, bool newlines) : _output(output), _newlines(newlines)
+	{
+		if(newlines)
+			base64_init_encodestate(&this->_state);
+		else
+			base64_init_encodestate_nonewlines(&this->_state);
+	}
+
+	ssize_t Base64Encoder::update(const void *data, size_t length)
+	{
+		auto input = static_cast<const char *>(data);
+		char buffer[CONFIG_BASE64_BUFFER];
+		ssize_t total = 0;
+
+		while(length > 0) {
+			auto chunk = length > ENCODE_CHUNK ? ENCODE_CHUNK : length;
+			auto rv = flush(this->_output, buffer,
+			                base64_encode_block(input, static_cast<int>(chunk), buffer, &this->_state));
+
+			if(rv < 0)
+				return rv;
+
+			total += rv;
+			input += chunk;
+			length -= chunk;
+		}
+
+		return total;
+	}
+
+	ssize_t Base64Encoder::final()
+	{
+		char buffer[8];
+		auto rv = flush(this->_output, buffer, base64_encode_blockend(buffer, &this->_state));
+
+		if(this->_newlines)
+			base64_init_encodestate(&this->_state);
+		else
+			base64_init_encodestate_nonewlines(&this->_state);
+
+		return rv;
+	}
+
+	Base64Decoder::Base64Decoder(Stream &output) : _output(output)
+	{
+		base64_init_decodestate(&this->_state);
+	}
+
+	ssize_t Base64Decoder::update(const char *data, size_t length)
+	{
+		char buffer[CONFIG_BASE64_BUFFER];
+		constexpr size_t chunk_size = CONFIG_BASE64_BUFFER / 3 * 4;
+		ssize_t total = 0;
+
+		while(length > 0) {
+			auto chunk = length > chunk_size ? chunk_size : length;
+			auto rv = flush(this->_output, buffer,
+			                base64_decode_block(data, static_cast<int>(chunk), buffer, &this->_state));
+
+			if(rv < 0)
+				return rv;
+
+			total += rv;
+			data += chunk;
+			length -= chunk;
+		}
+
+		return total;
+	}
+
+	ssize_t Base64Decoder::final()
+	{
+		auto step = this->_state.step;
+
+		base64_init_decodestate(&this->_state);
+		return step == step_b ? -EINVALID : 0;
+	}
+}
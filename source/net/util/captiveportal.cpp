@@ -15,6 +15,7 @@
 #include <lwiot/network/udpclient.h>
 #include <lwiot/network/udpserver.h>
 #include <lwiot/network/captiveportal.h>
+#include <lwiot/network/httpserver.h>
 #include <lwiot/stl/move.h>
 
 static void setn16(void *pp, int16_t n)
@@ -42,6 +43,11 @@ static uint16_t local_ntohs(uint16_t *in)
 	return ((p[0] << 8) & 0xff00) | (p[1] & 0xff);
 }
 
+static uint16_t get16(const char *p)
+{
+	return ((p[0] << 8) & 0xff00) | (p[1] & 0xff);
+}
+
 static char *label_to_str(char *packet, char *labelPtr, int packetSz, char *res, int resMaxLen)
 {
 	int i, j, k;
@@ -104,12 +110,27 @@ namespace lwiot
 		Thread("cp", nullptr), _lock(false), _udp(server), _captor(captor), _running(false), _bind_addr(addr), _port(port)
 	{
 		this->udp_msg = (char*) lwiot_mem_zalloc(DNS_LEN);
+		this->_reply = (char*) lwiot_mem_zalloc(DNS_LEN);
+		this->_label = (char*) lwiot_mem_zalloc(DNS_LEN);
+
+		uint32_t ip = this->_captor;
+		auto rf = reinterpret_cast<DnsResourceFooter *>(this->_answer + 2);
+
+		this->_answer[0] = static_cast<char>(0xC0);
+		this->_answer[1] = sizeof(DnsHeader);
+		setn16(&rf->type, QTYPE_A);
+		setn16(&rf->r_class, QCLASS_IN);
+		setn32(&rf->ttl, 0);
+		setn16(&rf->rdlength, 4);
+		memcpy(this->_answer + 2 + sizeof(*rf), &ip, sizeof(ip));
 	}
 
 	CaptivePortal::~CaptivePortal()
 	{
 		this->_udp->close();
 		lwiot_mem_free(this->udp_msg);
+		lwiot_mem_free(this->_reply);
+		lwiot_mem_free(this->_label);
 	}
 
 	void CaptivePortal::end()
@@ -146,11 +167,69 @@ namespace lwiot
 		this->begin();
 	}
 
-	void CaptivePortal::respond(lwiot::UdpClient &client, char *data, const size_t &length)
+	void CaptivePortal::redirectProbes(HttpServer &server, const String &page) const
+	{
+		static const char *probes[] = {
+			"/generate_204", "/gen_204", /* Android */
+			"/hotspot-detect.html", "/library/test/success.html", /* Apple */
+			"/connecttest.txt", "/ncsi.txt", "/redirect", /* Windows */
+			"/canonical.html", "/success.txt" /* Firefox */
+		};
+
+		auto location = String("Location: http://") + this->_captor.toString() + page + "\r\n";
+
+		for(auto probe : probes)
+			server.serveCanned(probe, 302, location);
+	}
+
+	bool CaptivePortal::answer(const IPAddress& peer, uint16_t port, const char *data, size_t length)
+	{
+		auto hdr = reinterpret_cast<const DnsHeader *>(data);
+		size_t idx = sizeof(DnsHeader);
+
+		if(length < sizeof(DnsHeader) || length > DNS_LEN)
+			return false;
+
+		/* Only standard queries with a single question, optionally with an EDNS record. */
+		if((hdr->flags & ~FLAG_RD) != 0 || get16(data + 4) != 1 || hdr->ancount || hdr->nscount)
+			return false;
+
+		while(idx < length && data[idx] != 0) {
+			auto len = static_cast<uint8_t>(data[idx]);
+
+			if(len > 63)
+				return false;
+
+			idx += len + 1;
+		}
+
+		idx++;
+
+		if(idx + sizeof(DnsQuestionFooter) > length)
+			return false;
+
+		if(get16(data + idx) != QTYPE_A || get16(data + idx + 2) != QCLASS_IN)
+			return false;
+
+		idx += sizeof(DnsQuestionFooter);
+
+		auto rhdr = reinterpret_cast<DnsHeader *>(this->_reply);
+
+		memcpy(this->_reply, data, idx);
+		memcpy(this->_reply + idx, this->_answer, sizeof(this->_answer));
+		rhdr->flags |= FLAG_QR;
+		setn16(&rhdr->ancount, 1);
+		rhdr->arcount = 0;
+
+		this->_udp->sendTo(this->_reply, idx + sizeof(this->_answer), peer, port);
+		return true;
+	}
+
+	void CaptivePortal::respond(const IPAddress& peer, uint16_t port, char *data, const size_t &length)
 	{
 		int i;
-		char *buff = (char *) lwiot_mem_zalloc(DNS_LEN);
-		char *reply = (char *) lwiot_mem_zalloc(DNS_LEN);
+		char *buff = this->_label;
+		char *reply = this->_reply;
 		char *rend = reply + length;
 		char *p = data;
 		uint32_t addr;
@@ -164,23 +243,24 @@ namespace lwiot
 		p += sizeof(DnsHeader);
 
 		if(length > DNS_LEN)
-			goto finish;
+			return;
 
 		if(length < sizeof(DnsHeader))
-			goto finish;
+			return;
 
 		if(hdr->ancount || hdr->nscount || hdr->arcount)
-			goto finish;
+			return;
 
 		if(hdr->flags & FLAG_TC)
-			goto finish;
+			return;
 
+		memset(reply, 0, DNS_LEN);
 		memcpy(reply, data, length);
 		rhdr->flags |= FLAG_QR;
 		for(i = 0; i < local_ntohs(&hdr->qdcount); i++) {
 			p = label_to_str(data, p, length, buff, DNS_LEN);
 			if(p == nullptr)
-				goto finish;
+				return;
 
 			DnsQuestionFooter *qf = (DnsQuestionFooter *) p;
 			p += sizeof(DnsQuestionFooter);
@@ -188,7 +268,7 @@ namespace lwiot
 			if(local_ntohs(&qf->type) == QTYPE_A) {
 				rend = str_to_label(buff, rend, DNS_LEN - (rend - reply));
 				if(rend == NULL)
-					goto finish;
+					return;
 				DnsResourceFooter *rf = (DnsResourceFooter *) rend;
 				rend += sizeof(DnsResourceFooter);
 				setn16(&rf->type, QTYPE_A);
@@ -231,36 +311,29 @@ namespace lwiot
 			}
 		}
 
-		client.write(reply, static_cast<size_t>(rend - reply));
-
-finish:
-		if(buff != nullptr)
-			lwiot_mem_free(buff);
-
-		if(reply != nullptr)
-			lwiot_mem_free(reply);
+		this->_udp->sendTo(reply, static_cast<size_t>(rend - reply), peer, port);
 	}
 
 	void CaptivePortal::run()
 	{
-		size_t num;
+		IPAddress peer;
+		uint16_t port;
+		ssize_t num;
 		bool running_;
 
 		this->_lock.lock();
 		running_ = this->_running;
+		this->_udp->setTimeout(1);
 		this->_lock.unlock();
 
 		while(running_) {
 			Thread::yield();
 			ScopedLock lock(this->_lock);
-			memset(udp_msg, 0, DNS_LEN);
-			num = DNS_LEN;
 
-			this->_udp->setTimeout(10000);
-			auto client = this->_udp->recv(udp_msg, num);
+			num = this->_udp->recvFrom(udp_msg, DNS_LEN, peer, port);
 
-			if(client)
-				this->respond(*client, udp_msg, num);
+			if(num > 0 && !this->answer(peer, port, udp_msg, static_cast<size_t>(num)))
+				this->respond(peer, port, udp_msg, static_cast<size_t>(num));
 
 			running_ = this->_running;
 		}
@@ -0,0 +1,182 @@
+/*
+ * Socket event loop implementation.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/error.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/network/eventloop.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+#include <lwiot/network/socketudpserver.h>
+
+namespace lwiot
+{
+	EventLoop::EventLoop(int interval) : _lock(false), _running(false), _interval(interval)
+	{
+	}
+
+	int EventLoop::find(socket_t *socket) const
+	{
+		for(auto idx = 0UL; idx < this->_entries.size(); idx++) {
+			if(this->_entries[idx].socket == socket)
+				return static_cast<int>(idx);
+		}
+
+		return -1;
+	}
+
+	bool EventLoop::add(socket_t *socket, uint32_t events, const Handler& handler)
+	{
+		ScopedLock lock(this->_lock);
+		Entry entry;
+
+		if(socket == nullptr || !handler || this->find(socket) >= 0)
+			return false;
+
+		entry.socket = socket;
+		entry.events = events;
+		entry.handler = handler;
+		this->_entries.pushback(stl::move(entry));
+
+		return true;
+	}
+
+	bool EventLoop::add(SocketTcpClient &client, uint32_t events, const Handler &handler)
+	{
+		return this->add(client.handle(), events, handler);
+	}
+
+	bool EventLoop::add(SocketTcpServer &server, const Handler &handler)
+	{
+		return this->add(server.handle(), SOCKET_POLL_READ, handler);
+	}
+
+	bool EventLoop::add(SocketUdpServer &server, const Handler &handler)
+	{
+		return this->add(server.handle(), SOCKET_POLL_READ, handler);
+	}
+
+	bool EventLoop::accept(SocketTcpServer &server, const AcceptHandler &handler)
+	{
+		auto *listener = &server;
+
+		return this->add(server.handle(), SOCKET_POLL_READ, [listener, handler](uint32_t events) {
+			UniquePointer<TcpClient> clients[CONFIG_EVENTLOOP_ACCEPT_BATCH];
+
+			if(events & SOCKET_POLL_ERROR)
+				return;
+
+			auto num = listener->acceptMany(clients, CONFIG_EVENTLOOP_ACCEPT_BATCH);
+
+			for(size_t idx = 0; idx < num; idx++)
+				handler(clients[idx]);
+		});
+	}
+
+	bool EventLoop::modify(socket_t *socket, uint32_t events)
+	{
+		ScopedLock lock(this->_lock);
+		auto idx = this->find(socket);
+
+		if(idx < 0)
+			return false;
+
+		this->_entries[idx].events = events;
+		return true;
+	}
+
+	bool EventLoop::remove(socket_t *socket)
+	{
+		ScopedLock lock(this->_lock);
+		auto idx = this->find(socket);
+
+		if(idx < 0)
+			return false;
+
+		this->_entries.erase(static_cast<size_t>(idx));
+		return true;
+	}
+
+	size_t EventLoop::size() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_entries.size();
+	}
+
+	int EventLoop::poll(int tmo)
+	{
+		socket_poll_t entry{};
+		Handler handler;
+		int rv, called;
+
+		/*
+		 * Poll a snapshot of the registrations. Handlers are looked up again before they are
+		 * called, so that a handler that removes another socket also cancels its dispatch.
+		 */
+		this->_lock.lock();
+		this->_polls.clear();
+
+		for(auto& registration : this->_entries) {
+			entry.socket = registration.socket;
+			entry.events = registration.events;
+			entry.revents = 0;
+			this->_polls.pushback(entry);
+		}
+
+		this->_lock.unlock();
+
+		/* Only the thread running the loop uses the poll set, it is reused between iterations. */
+		if(this->_polls.size() == 0) {
+			lwiot_sleep(tmo == FOREVER ? this->_interval : tmo);
+			return 0;
+		}
+
+		rv = socket_poll(&this->_polls[0], this->_polls.size(), tmo);
+
+		if(rv <= 0)
+			return rv;
+
+		called = 0;
+
+		for(auto& result : this->_polls) {
+			if(result.revents == 0)
+				continue;
+
+			this->_lock.lock();
+			auto idx = this->find(result.socket);
+
+			if(idx >= 0)
+				handler = this->_entries[idx].handler;
+
+			this->_lock.unlock();
+
+			if(idx < 0)
+				continue;
+
+			handler(result.revents);
+			called++;
+		}
+
+		return called;
+	}
+
+	void EventLoop::run()
+	{
+		this->_running = true;
+
+		while(this->_running)
+			this->poll(this->_interval);
+	}
+
+	void EventLoop::stop()
+	{
+		this->_running = false;
+	}
+}
@@ -17,43 +17,27 @@
 
 #include <lwiot/types.h>
 #include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/stl/hash.h>
 
 #include <lwiot/network/ipaddress.h>
 #include <lwiot/network/stdnet.h>
 
 namespace lwiot
 {
-	IPAddress::IPAddress() : _version(4)
-	{
-		this->_address.dword[0] = 0;
-	}
-
-	IPAddress::IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t forth) : _version(4)
-	{
-		this->_address.bytes[0] = first;
-		this->_address.bytes[1] = second;
-		this->_address.bytes[2] = third;
-		this->_address.bytes[3] = forth;
-	}
-
-	IPAddress::IPAddress(uint32_t addr) : _version(4)
-	{
-		this->_address.dword[0] = to_netorderl(addr);
-	}
+	static const char hex[] = "0123456789abcdef";
 
 	IPAddress::IPAddress(const uint8_t *addr) : IPAddress(addr[0], addr[1], addr[2], addr[3])
 	{ }
 
-	IPAddress::IPAddress(const remote_addr_t& remote)
+	IPAddress::IPAddress(const remote_addr_t& remote) : IPAddress()
 	{
 		if(remote.version == 6) {
 			memcpy(this->_address.bytes, remote.addr.ip6_addr.ip, sizeof(remote.addr.ip6_addr.ip));
 			this->_version = 6;
 		} else {
 			this->_address.dword[0] = remote.addr.ip4_addr.ip;
-			this->_version = 4;
 		}
-
 	}
 
 	const uint8_t *IPAddress::raw() const
@@ -63,51 +47,250 @@ namespace lwiot
 
 	String IPAddress::toString() const
 	{
-		char tmp[16];
+		char tmp[MaxStringLength];
 
-		memset((void*)tmp, 0, sizeof(tmp));
-		sprintf(tmp, "%u.%u.%u.%u", this->_address.bytes[0], this->_address.bytes[1],
-				this->_address.bytes[2], this->_address.bytes[3]);
+		this->formatTo(tmp, sizeof(tmp));
 		return String(tmp);
 	}
 
-	IPAddress IPAddress::fromString(const char *str)
+	static char *format_byte(char *ptr, uint8_t value)
 	{
-		IPAddress retval;
+		if(value >= 100) {
+			*ptr++ = static_cast<char>('0' + value / 100);
+			value %= 100;
+			*ptr++ = static_cast<char>('0' + value / 10);
+		} else if(value >= 10) {
+			*ptr++ = static_cast<char>('0' + value / 10);
+		}
 
-		int acc = 0;
-		uint8_t dots = 0;
+		*ptr++ = static_cast<char>('0' + value % 10);
+		return ptr;
+	}
 
-		while (*str) {
-			auto c = *str++;
-			if (c >= '0' && c <= '9') {
-				acc = acc * 10 + (c - '0');
+	size_t IPAddress::formatTo(char *buffer, size_t length) const
+	{
+		char tmp[MaxStringLength];
+		char *ptr = tmp;
+		size_t size;
 
-				if (acc > 255)
-					return retval;
+		if(this->_version == 6) {
+			size = this->format6(tmp);
+		} else {
+			for(int idx = 0; idx < 4; idx++) {
+				if(idx > 0)
+					*ptr++ = '.';
 
-			} else if (c == '.') {
-				if (dots == 3)
-					return retval;
+				ptr = format_byte(ptr, this->_address.bytes[idx]);
+			}
+
+			size = static_cast<size_t>(ptr - tmp);
+		}
+
+		if(size >= length)
+			return 0;
+
+		memcpy(buffer, tmp, size);
+		buffer[size] = '\0';
+		return size;
+	}
 
-				retval._address.bytes[dots++] = (uint8_t)acc;
-				acc = 0;
-			} else {
-				return retval;
+	size_t IPAddress::format6(char *buffer) const
+	{
+		int start = -1, length = 0;
+		int run, idx;
+		char *ptr = buffer;
+
+		/* Compress the longest run of zero groups, as in RFC 5952. */
+		for(idx = 0; idx < 8; idx += run > 0 ? run : 1) {
+			for(run = 0; idx + run < 8 && this->group(idx + run) == 0; run++);
+
+			if(run > length && run > 1) {
+				start = idx;
+				length = run;
 			}
 		}
 
-		if (dots != 3)
-			return retval;
+		for(idx = 0; idx < 8; ) {
+			if(idx == start) {
+				*ptr++ = ':';
+				*ptr++ = ':';
+				idx += length;
+				continue;
+			}
+
+			if(idx > 0 && idx != start + length)
+				*ptr++ = ':';
+
+			auto value = this->group(idx);
+			bool leading = true;
+
+			for(int shift = 12; shift >= 0; shift -= 4) {
+				auto digit = (value >> shift) & 0xF;
+
+				if(leading && digit == 0 && shift > 0)
+					continue;
+
+				leading = false;
+				*ptr++ = hex[digit];
+			}
+
+			idx++;
+		}
+
+		return static_cast<size_t>(ptr - buffer);
+	}
+
+	/* Dotted decimal, without leading zeros. Returns the end of the address, or nullptr. */
+	static const char *parse4(const char *ptr, const char *end, uint8_t *output)
+	{
+		for(int idx = 0; idx < 4; idx++) {
+			unsigned value = 0;
+			int digits = 0;
+
+			if(idx > 0) {
+				if(ptr == end || *ptr != '.')
+					return nullptr;
+
+				ptr++;
+			}
+
+			for(; ptr != end && digits < 4; digits++, ptr++) {
+				unsigned digit = static_cast<unsigned>(*ptr - '0');
+
+				if(digit > 9)
+					break;
+
+				value = value * 10 + digit;
+			}
+
+			if(digits == 0 || value > 255 || (digits > 1 && ptr[-digits] == '0'))
+				return nullptr;
+
+			output[idx] = static_cast<uint8_t>(value);
+		}
+
+		return ptr;
+	}
+
+	static int hex_value(char c)
+	{
+		unsigned digit = static_cast<unsigned>(c - '0');
+
+		if(digit < 10)
+			return static_cast<int>(digit);
+
+		digit = static_cast<unsigned>((c | 0x20) - 'a');
+		return digit < 6 ? static_cast<int>(digit) + 10 : -1;
+	}
+
+	static bool parse6(const char *ptr, const char *end, uint8_t *output)
+	{
+		uint8_t bytes[16];
+		int count = 0, gap = -1;
 
-		retval._address.bytes[3] = (uint8_t)acc;
-		retval._version = 4;
+		if(end - ptr >= 2 && ptr[0] == ':' && ptr[1] == ':') {
+			gap = 0;
+			ptr += 2;
+		}
+
+		while(ptr != end) {
+			const char *start = ptr;
+			unsigned value = 0;
+			int digits, digit;
+
+			if(count == 8)
+				return false;
+
+			for(digits = 0; ptr != end && digits < 5 && (digit = hex_value(*ptr)) >= 0; digits++, ptr++)
+				value = value << 4 | static_cast<unsigned>(digit);
+
+			/* An IPv4 address can take the place of the last two groups. */
+			if(ptr != end && *ptr == '.') {
+				if(count > 6 || parse4(start, end, bytes + count * 2) != end)
+					return false;
+
+				count += 2;
+				break;
+			}
+
+			if(digits == 0 || digits > 4)
+				return false;
+
+			bytes[count * 2] = static_cast<uint8_t>(value >> 8);
+			bytes[count * 2 + 1] = static_cast<uint8_t>(value);
+			count++;
+
+			if(ptr == end)
+				break;
+
+			if(*ptr++ != ':' || ptr == end)
+				return false;
+
+			if(*ptr == ':') {
+				if(gap >= 0)
+					return false;
+
+				gap = count;
+				ptr++;
+			}
+		}
+
+		if(gap < 0) {
+			if(count != 8)
+				return false;
+
+			memcpy(output, bytes, sizeof(bytes));
+			return true;
+		}
+
+		if(count == 8)
+			return false;
+
+		auto tail = (count - gap) * 2;
+
+		memset(output, 0, 16);
+		memcpy(output, bytes, static_cast<size_t>(gap) * 2);
+		memcpy(output + 16 - tail, bytes + gap * 2, static_cast<size_t>(tail));
+		return true;
+	}
+
+	bool IPAddress::parse(const StringView& str, IPAddress& address)
+	{
+		IPAddress result;
+		auto end = str.data() + str.length();
+
+		for(auto c : str) {
+			if(c == ':') {
+				if(!parse6(str.data(), end, result._address.bytes))
+					return false;
+
+				result._version = 6;
+				address = result;
+				return true;
+			}
+		}
+
+		if(parse4(str.data(), end, result._address.bytes) != end)
+			return false;
+
+		address = result;
+		return true;
+	}
+
+	IPAddress IPAddress::fromString(const char *str)
+	{
+		IPAddress retval;
+
+		IPAddress::parse(StringView(str), retval);
 		return retval;
 	}
 
 	IPAddress IPAddress::fromString(const String& str)
 	{
-		return IPAddress::fromString(str.c_str());
+		IPAddress retval;
+
+		IPAddress::parse(StringView(str), retval);
+		return retval;
 	}
 
 	IPAddress& IPAddress::operator=(const uint8_t *address)
@@ -118,18 +301,12 @@ namespace lwiot
 
 	IPAddress& IPAddress::operator=(uint32_t address)
 	{
+		memset(this->_address.bytes, 0, sizeof(this->_address.bytes));
 		this->_address.dword[0] = address;
 		this->_version = 4;
 		return *this;
 	}
 
-	IPAddress& IPAddress::operator=(const IPAddress& addr)
-	{
-		memcpy(this->_address.bytes, addr._address.bytes, sizeof(addr._address.bytes));
-		this->_version = addr._version;
-		return *this;
-	}
-
 	bool IPAddress::operator==(const uint8_t* addr) const
 	{
 		return memcmp(addr, this->_address.bytes, sizeof(this->_address.bytes)) == 0;
@@ -142,7 +319,28 @@ namespace lwiot
 
 	bool IPAddress::operator==(const IPAddress& addr) const
 	{
-		return memcmp(addr.raw(), this->_address.bytes, sizeof(this->_address.bytes)) == 0;
+		return this->_version == addr._version &&
+			memcmp(addr.raw(), this->_address.bytes, sizeof(this->_address.bytes)) == 0;
+	}
+
+	bool IPAddress::isMulticast() const
+	{
+		if(this->_version == 6)
+			return this->_address.bytes[0] == 0xFF;
+
+		return (this->_address.bytes[0] & 0xF0) == 0xE0;
+	}
+
+	size_t IPAddress::hash() const
+	{
+		uint64_t high, low;
+
+		if(this->_version == 4)
+			return stl::detail::hash_integer(this->_address.dword[0]);
+
+		memcpy(&high, this->_address.bytes, sizeof(high));
+		memcpy(&low, this->_address.bytes + sizeof(high), sizeof(low));
+		return stl::detail::hash_integer(high ^ stl::detail::hash_integer(low));
 	}
 
 	IPAddress::operator uint32_t() const
@@ -193,18 +391,15 @@ namespace lwiot
 			break;
 
 		case BIND6_ADDR_ANY:
-		memset(ip._address.bytes, 0, sizeof(ip._address.bytes));
-		/*case BIND6_ADDR_LB:
-#ifdef HAVE_BIG_ENDIAN
-			uint32_t raw = 1;
-#else
-			uint32_t raw = 16777216;
-#endif
-			ip._address.dword[0] = raw;
-			ip._address.dword[1] = 0;
-			ip._address.dword[2] = 0;
-			ip._address.dword[3] = 0;
-			break;*/
+			memset(ip._address.bytes, 0, sizeof(ip._address.bytes));
+			ip._version = 6;
+			break;
+
+		case BIND6_ADDR_LB:
+			memset(ip._address.bytes, 0, sizeof(ip._address.bytes));
+			ip._address.bytes[15] = 1;
+			ip._version = 6;
+			break;
 		}
 
 		return ip;
@@ -0,0 +1,85 @@
+/*
+ * Helpers for the lwIP netconn API.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/bytebuffer.h>
+#include <lwiot/sharedpointer.h>
+#include <lwiot/sharedbytebuffer.h>
+#include <lwiot/network/stdnet.h>
+#include <lwiot/network/netconn.h>
+
+namespace lwiot
+{
+	namespace netconn
+	{
+		/* Lends the payload of a pbuf to SharedByteBuffer views. */
+		class PbufByteBuffer : public ByteBuffer {
+		public:
+			explicit PbufByteBuffer(struct pbuf *p) :
+				ByteBuffer(static_cast<uint8_t*>(p->payload), p->len), _pbuf(p)
+			{
+				pbuf_ref(p);
+			}
+
+			~PbufByteBuffer() override
+			{
+				this->release();
+				pbuf_free(this->_pbuf);
+			}
+
+		private:
+			struct pbuf *_pbuf;
+		};
+
+		void toIpAddr(const IPAddress& addr, ip_addr_t& ip)
+		{
+			remote_addr_t remote;
+
+			addr.toRemoteAddress(remote);
+			ip_addr_set_zero(&ip);
+
+#if LWIP_IPV6
+			if(remote.version == 6) {
+				IP_SET_TYPE_VAL(ip, IPADDR_TYPE_V6);
+				memcpy(ip_2_ip6(&ip)->addr, remote.addr.ip6_addr.ip, sizeof(ip_2_ip6(&ip)->addr));
+				return;
+			}
+#endif
+
+			ip_addr_set_ip4_u32(&ip, remote.addr.ip4_addr.ip);
+		}
+
+		IPAddress fromIpAddr(const ip_addr_t& ip)
+		{
+			remote_addr_t remote;
+
+			memset(&remote, 0, sizeof(remote));
+
+#if LWIP_IPV6
+			if(IP_IS_V6(&ip)) {
+				remote.version = 6;
+				memcpy(remote.addr.ip6_addr.ip, ip_2_ip6(&ip)->addr, sizeof(remote.addr.ip6_addr.ip));
+				return IPAddress(remote);
+			}
+#endif
+
+			remote.version = 4;
+			remote.addr.ip4_addr.ip = ip4_addr_get_u32(ip_2_ip4(&ip));
+
+			return IPAddress(remote);
+		}
+
+		SharedByteBuffer share(struct pbuf *p, size_t offset)
+		{
+			SharedPointer<ByteBuffer> storage(new PbufByteBuffer(p));
+			return SharedByteBuffer(storage).slice(offset);
+		}
+	}
+}
@@ -7,84 +7,268 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <lwiot.h>
 
+#include <lwiot/types.h>
+#include <lwiot/scopedlock.h>
 #include <lwiot/network/udpclient.h>
 #include <lwiot/network/ipaddress.h>
 #include <lwiot/network/ntpclient.h>
 
-#include <lwiot/stl/referencewrapper.h>
+static uint32_t get32(const uint8_t *p)
+{
+	return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+		(static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+static void set32(uint8_t *p, uint32_t value)
+{
+	p[0] = value >> 24;
+	p[1] = (value >> 16) & 0xFF;
+	p[2] = (value >> 8) & 0xFF;
+	p[3] = value & 0xFF;
+}
+
+static int64_t clamp(int64_t value, int64_t limit)
+{
+	return value > limit ? limit : (value < -limit ? -limit : value);
+}
 
 namespace lwiot
 {
-	NtpClient::NtpClient() : _current_epoch(0UL), _last_update(0UL)
+	NtpClient::NtpClient() : _servers(), _count(0), _lock(false), _synchronized(false), _base_tick(0), _base(0),
+		_slew(0), _drift(0), _offset(0), _delay(0), _sequence(0)
 	{
 	}
 
-	NtpClient::NtpClient(lwiot::UdpClient &client) :
-		_client(client), _current_epoch(0ULL), _last_update(0ULL)
+	NtpClient::NtpClient(lwiot::UdpClient &client) : NtpClient()
 	{
+		this->addServer(client);
 	}
 
 	void NtpClient::begin(lwiot::UdpClient &client)
 	{
-		this->_client = client;
+		if(this->_count == 0)
+			this->_count = 1;
+
+		this->_servers[0] = &client;
 		this->begin();
 	}
 
 	void NtpClient::begin()
 	{
-		this->_client->begin();
-		this->_client->setTimeout(2);
+		for(size_t idx = 0; idx < this->_count; idx++) {
+			this->_servers[idx]->begin();
+			this->_servers[idx]->setTimeout(2);
+		}
+	}
+
+	bool NtpClient::addServer(lwiot::UdpClient &client)
+	{
+		if(this->_count >= CONFIG_NTP_SERVERS)
+			return false;
+
+		this->_servers[this->_count++] = &client;
+		return true;
+	}
+
+	/* Convert an NTP timestamp to UNIX time in milliseconds. */
+	static int64_t ntp_to_ms(const uint8_t *timestamp, unsigned long seventy_years)
+	{
+		int64_t seconds = get32(timestamp);
+		int64_t fraction = get32(timestamp + 4);
+
+		/* Timestamps with the top bit clear are taken to be in the era that starts in 2036. */
+		if(seconds < 0x80000000LL)
+			seconds += 0x100000000LL;
+
+		return (seconds - static_cast<int64_t>(seventy_years)) * 1000 + ((fraction * 1000) >> 32);
 	}
 
-	void NtpClient::sendRequest() const
+	bool NtpClient::query(UdpClient &client, Sample &sample)
 	{
-		ByteBuffer buffer(NtpClient::NTP_PACKET_SIZE, true);
+		uint8_t request[NtpClient::NTP_PACKET_SIZE];
+		uint8_t reply[NtpClient::NTP_PACKET_SIZE];
+		auto sent = lwiot_tick_ms();
+
+		memset(request, 0, sizeof(request));
+		request[0] = 0b11100011;
+		request[1] = 0;
+		request[2] = 6;
+		request[3] = 0xEC;
+		request[12] = 49;
+		request[13] = 0x4E;
+		request[14] = 49;
+		request[15] = 52;
+
+		/* The server echoes the transmit timestamp, which identifies the answer to this request. */
+		set32(request + 40, static_cast<uint32_t>(sent));
+		set32(request + 44, ++this->_sequence);
+
+		if(client.write(request, sizeof(request)) != sizeof(request))
+			return false;
 
-		buffer[0] = 0b11100011;
-		buffer[1] = 0;
-		buffer[2] = 6;
-		buffer[3] = 0xEC;
+		/* Late answers to earlier requests are skipped. */
+		for(int attempt = 0; attempt < 3; attempt++) {
+			auto rv = client.read(reply, sizeof(reply));
+			auto received = lwiot_tick_ms();
 
-		/* Bytes 4 through 11 are zero. Initialised by the constructor */
-		buffer[12]  = 49;
-		buffer[13]  = 0x4E;
-		buffer[14]  = 49;
-		buffer[15] = 52;
+			if(rv <= 0)
+				return false;
 
-		this->_client->write(buffer.data(), NtpClient::NTP_PACKET_SIZE);
+			if(rv < NtpClient::NTP_PACKET_SIZE || memcmp(reply + 24, request + 40, 8) != 0)
+				continue;
+
+			/* Only server answers that are in sync. */
+			if((reply[0] & 0x7) != 4 || (reply[0] >> 6) == 3 || reply[1] == 0 || reply[1] > 15)
+				return false;
+
+			auto rx = ntp_to_ms(reply + 32, NtpClient::SEVENTY_YEARS);
+			auto tx = ntp_to_ms(reply + 40, NtpClient::SEVENTY_YEARS);
+			auto delay = static_cast<int64_t>(received - sent) - (tx - rx);
+
+			if(delay < 0)
+				delay = 0;
+
+			sample.time = tx + delay / 2;
+			sample.tick = received;
+			sample.delay = delay;
+			return true;
+		}
+
+		return false;
 	}
 
-#define merge(h, l) ((h << 8) | l)
+	int64_t NtpClient::estimate(time_t tick) const
+	{
+		auto elapsed = static_cast<int64_t>(tick - this->_base_tick);
+		auto time = this->_base + elapsed + elapsed * this->_drift / 1000000;
+
+		return time + clamp(this->_slew, elapsed * CONFIG_NTP_SLEW_RATE / 1000000);
+	}
+
+	void NtpClient::discipline(int64_t offset, time_t tick)
+	{
+		auto now = this->estimate(tick);
+		auto elapsed = static_cast<int64_t>(tick - this->_base_tick);
+
+		this->_offset = static_cast<int32_t>(clamp(offset, INT32_MAX));
+
+		if(!this->_synchronized || offset > CONFIG_NTP_STEP || -offset > CONFIG_NTP_STEP) {
+			this->_base = now + offset;
+			this->_base_tick = tick;
+			this->_slew = 0;
+			this->_synchronized = true;
+			return;
+		}
+
+		/*
+		 * Whatever built up on top of the correction that was still being slewed, is drift of the
+		 * tick counter. It is only measured over longer periods, since the ticks have a resolution of
+		 * a millisecond, and only half of it is taken to keep noise out.
+		 */
+		if(elapsed >= CONFIG_NTP_DRIFT_INTERVAL) {
+			auto remaining = this->_slew - clamp(this->_slew, elapsed * CONFIG_NTP_SLEW_RATE / 1000000);
+			auto drift = this->_drift + (offset - remaining) * 1000000 / elapsed / 2;
+
+			this->_drift = static_cast<int32_t>(clamp(drift, CONFIG_NTP_MAX_DRIFT));
+		}
+
+		this->_base = now;
+		this->_base_tick = tick;
+		this->_slew = offset;
+	}
 
-#define UPDATE_DELAY 500
 	bool NtpClient::update()
 	{
-		ByteBuffer buffer(NtpClient::NTP_PACKET_SIZE, true);
-		uint32_t hi, lo, result;
+		Sample best[CONFIG_NTP_SERVERS];
+		int64_t offsets[CONFIG_NTP_SERVERS];
+		size_t found = 0;
 
-		this->sendRequest();
+		for(size_t idx = 0; idx < this->_count; idx++) {
+			auto& sample = best[found];
+			bool valid = false;
 
-		if(unlikely(this->_client->read(buffer.data(), buffer.count()) <= 0))
+			/* The answer with the shortest round trip suffered the least from queueing. */
+			for(int num = 0; num < CONFIG_NTP_SAMPLES; num++) {
+				Sample current;
+
+				if(!this->query(*this->_servers[idx], current) || current.delay > CONFIG_NTP_MAX_DELAY)
+					continue;
+
+				if(!valid || current.delay < sample.delay) {
+					sample = current;
+					valid = true;
+				}
+			}
+
+			if(valid)
+				found++;
+		}
+
+		if(found == 0)
 			return false;
 
-		this->_last_update = lwiot_tick_ms() - UPDATE_DELAY;
-		hi = merge(buffer[40], buffer[41]);
-		lo = merge(buffer[42], buffer[43]);
-		result = (hi << 16) | lo;
-		this->_current_epoch = result - NtpClient::SEVENTY_YEARS;
+		ScopedLock lock(this->_lock);
+
+		for(size_t idx = 0; idx < found; idx++)
+			offsets[idx] = best[idx].time - this->estimate(best[idx].tick);
+
+		/* Sort the servers by offset, and follow the median. */
+		for(size_t idx = 1; idx < found; idx++) {
+			for(size_t num = idx; num > 0 && offsets[num - 1] > offsets[num]; num--) {
+				auto offset = offsets[num];
+				auto sample = best[num];
+
+				offsets[num] = offsets[num - 1];
+				best[num] = best[num - 1];
+				offsets[num - 1] = offset;
+				best[num - 1] = sample;
+			}
+		}
+
+		auto middle = found / 2;
+		auto offset = found % 2 ? offsets[middle] : (offsets[middle - 1] + offsets[middle]) / 2;
+
+		this->_delay = static_cast<uint32_t>(best[middle].delay);
+		this->discipline(offset, lwiot_tick_ms());
 
 		return true;
 	}
 
+	int64_t NtpClient::milliseconds() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->estimate(lwiot_tick_ms());
+	}
+
 	time_t NtpClient::time() const
 	{
-		time_t rv;
+		return static_cast<time_t>(this->milliseconds() / 1000);
+	}
+
+	bool NtpClient::synchronized() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_synchronized;
+	}
 
-		rv = lwiot_tick_ms() - this->_last_update;
-		rv /= 1000;
-		rv += this->_current_epoch;
-		return rv;
+	int32_t NtpClient::offset() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_offset;
+	}
+
+	uint32_t NtpClient::delay() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_delay;
+	}
+
+	int32_t NtpClient::drift() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_drift;
 	}
 }
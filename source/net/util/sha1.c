@@ -0,0 +1,135 @@
+/*
+ * SHA-1 hash (FIPS 180-4).
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/network/sha1.h>
+
+#define ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static void sha1_transform(uint32_t *state, const uint8_t *block)
+{
+	uint32_t w[80];
+	uint32_t a, b, c, d, e, f, k, tmp;
+	int idx;
+
+	for(idx = 0; idx < 16; idx++) {
+		w[idx] = (uint32_t) block[idx * 4] << 24 | (uint32_t) block[idx * 4 + 1] << 16 |
+		         (uint32_t) block[idx * 4 + 2] << 8 | (uint32_t) block[idx * 4 + 3];
+	}
+
+	for(idx = 16; idx < 80; idx++)
+		w[idx] = ROTL(w[idx - 3] ^ w[idx - 8] ^ w[idx - 14] ^ w[idx - 16], 1);
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+
+	for(idx = 0; idx < 80; idx++) {
+		if(idx < 20) {
+			f = (b & c) | (~b & d);
+			k = 0x5A827999;
+		} else if(idx < 40) {
+			f = b ^ c ^ d;
+			k = 0x6ED9EBA1;
+		} else if(idx < 60) {
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8F1BBCDC;
+		} else {
+			f = b ^ c ^ d;
+			k = 0xCA62C1D6;
+		}
+
+		tmp = ROTL(a, 5) + f + e + k + w[idx];
+		e = d;
+		d = c;
+		c = ROTL(b, 30);
+		b = a;
+		a = tmp;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+}
+
+void sha1_init(sha1_context_t *ctx)
+{
+	ctx->state[0] = 0x67452301;
+	ctx->state[1] = 0xEFCDAB89;
+	ctx->state[2] = 0x98BADCFE;
+	ctx->state[3] = 0x10325476;
+	ctx->state[4] = 0xC3D2E1F0;
+	ctx->length = 0;
+	ctx->used = 0;
+}
+
+void sha1_update(sha1_context_t *ctx, const void *data, size_t length)
+{
+	const uint8_t *bytes = data;
+	size_t num;
+
+	ctx->length += length;
+
+	while(length > 0) {
+		num = SHA1_BLOCK_SIZE - ctx->used;
+
+		if(num > length)
+			num = length;
+
+		memcpy(ctx->block + ctx->used, bytes, num);
+		ctx->used += num;
+		bytes += num;
+		length -= num;
+
+		if(ctx->used == SHA1_BLOCK_SIZE) {
+			sha1_transform(ctx->state, ctx->block);
+			ctx->used = 0;
+		}
+	}
+}
+
+void sha1_final(sha1_context_t *ctx, uint8_t *digest)
+{
+	uint64_t bits = ctx->length * 8;
+	int idx;
+
+	ctx->block[ctx->used++] = 0x80;
+
+	if(ctx->used > SHA1_BLOCK_SIZE - 8) {
+		memset(ctx->block + ctx->used, 0, SHA1_BLOCK_SIZE - ctx->used);
+		sha1_transform(ctx->state, ctx->block);
+		ctx->used = 0;
+	}
+
+	memset(ctx->block + ctx->used, 0, SHA1_BLOCK_SIZE - 8 - ctx->used);
+
+	for(idx = 0; idx < 8; idx++)
+		ctx->block[SHA1_BLOCK_SIZE - 1 - idx] = (uint8_t) (bits >> (idx * 8));
+
+	sha1_transform(ctx->state, ctx->block);
+
+	for(idx = 0; idx < SHA1_DIGEST_SIZE; idx++)
+		digest[idx] = (uint8_t) (ctx->state[idx / 4] >> (24 - (idx % 4) * 8));
+}
+
+void sha1(const void *data, size_t length, uint8_t *digest)
+{
+	sha1_context_t ctx;
+
+	sha1_init(&ctx);
+	sha1_update(&ctx, data, length);
+	sha1_final(&ctx, digest);
+}
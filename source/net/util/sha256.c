@@ -0,0 +1,151 @@
+/*
+ * SHA-256 hash (FIPS 180-4).
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/network/sha256.h>
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static const uint32_t sha256_k[64] = {
+	0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+	0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+	0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+	0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+	0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+	0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+	0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+	0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+static void sha256_transform(uint32_t *state, const uint8_t *block)
+{
+	uint32_t w[64];
+	uint32_t a, b, c, d, e, f, g, h, s0, s1, t1, t2;
+	int idx;
+
+	for(idx = 0; idx < 16; idx++) {
+		w[idx] = (uint32_t) block[idx * 4] << 24 | (uint32_t) block[idx * 4 + 1] << 16 |
+		         (uint32_t) block[idx * 4 + 2] << 8 | (uint32_t) block[idx * 4 + 3];
+	}
+
+	for(idx = 16; idx < 64; idx++) {
+		s0 = ROTR(w[idx - 15], 7) ^ ROTR(w[idx - 15], 18) ^ (w[idx - 15] >> 3);
+		s1 = ROTR(w[idx - 2], 17) ^ ROTR(w[idx - 2], 19) ^ (w[idx - 2] >> 10);
+		w[idx] = w[idx - 16] + s0 + w[idx - 7] + s1;
+	}
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+	f = state[5];
+	g = state[6];
+	h = state[7];
+
+	for(idx = 0; idx < 64; idx++) {
+		s1 = ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25);
+		t1 = h + s1 + ((e & f) ^ (~e & g)) + sha256_k[idx] + w[idx];
+		s0 = ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22);
+		t2 = s0 + ((a & b) ^ (a & c) ^ (b & c));
+
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+	state[5] += f;
+	state[6] += g;
+	state[7] += h;
+}
+
+void sha256_init(sha256_context_t *ctx)
+{
+	ctx->state[0] = 0x6A09E667;
+	ctx->state[1] = 0xBB67AE85;
+	ctx->state[2] = 0x3C6EF372;
+	ctx->state[3] = 0xA54FF53A;
+	ctx->state[4] = 0x510E527F;
+	ctx->state[5] = 0x9B05688C;
+	ctx->state[6] = 0x1F83D9AB;
+	ctx->state[7] = 0x5BE0CD19;
+	ctx->length = 0;
+	ctx->used = 0;
+}
+
+void sha256_update(sha256_context_t *ctx, const void *data, size_t length)
+{
+	const uint8_t *bytes = data;
+	size_t num;
+
+	ctx->length += length;
+
+	while(length > 0) {
+		num = SHA256_BLOCK_SIZE - ctx->used;
+
+		if(num > length)
+			num = length;
+
+		memcpy(ctx->block + ctx->used, bytes, num);
+		ctx->used += num;
+		bytes += num;
+		length -= num;
+
+		if(ctx->used == SHA256_BLOCK_SIZE) {
+			sha256_transform(ctx->state, ctx->block);
+			ctx->used = 0;
+		}
+	}
+}
+
+void sha256_final(sha256_context_t *ctx, uint8_t *digest)
+{
+	uint64_t bits = ctx->length * 8;
+	int idx;
+
+	ctx->block[ctx->used++] = 0x80;
+
+	if(ctx->used > SHA256_BLOCK_SIZE - 8) {
+		memset(ctx->block + ctx->used, 0, SHA256_BLOCK_SIZE - ctx->used);
+		sha256_transform(ctx->state, ctx->block);
+		ctx->used = 0;
+	}
+
+	memset(ctx->block + ctx->used, 0, SHA256_BLOCK_SIZE - 8 - ctx->used);
+
+	for(idx = 0; idx < 8; idx++)
+		ctx->block[SHA256_BLOCK_SIZE - 1 - idx] = (uint8_t) (bits >> (idx * 8));
+
+	sha256_transform(ctx->state, ctx->block);
+
+	for(idx = 0; idx < SHA256_DIGEST_SIZE; idx++)
+		digest[idx] = (uint8_t) (ctx->state[idx / 4] >> (24 - (idx % 4) * 8));
+}
+
+void sha256(const void *data, size_t length, uint8_t *digest)
+{
+	sha256_context_t ctx;
+
+	sha256_init(&ctx);
+	sha256_update(&ctx, data, length);
+	sha256_final(&ctx, digest);
+}
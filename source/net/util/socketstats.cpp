@@ -0,0 +1,157 @@
+/*
+ * Socket traffic and latency counters.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <lwiot.h>
+
+#include <lwiot/error.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/network/stdnet.h>
+#include <lwiot/network/socketstats.h>
+
+namespace lwiot
+{
+	namespace
+	{
+		struct GlobalStats {
+			atomic_uint64_t bytes_in;
+			atomic_uint64_t bytes_out;
+			atomic_uint32_t reads;
+			atomic_uint32_t writes;
+			atomic_uint32_t would_block;
+			atomic_uint32_t errors;
+			atomic_uint32_t connects;
+			atomic_uint32_t connect_failures;
+		};
+
+		GlobalStats totals;
+	}
+
+	SocketStats::SocketStats()
+	{
+		this->reset();
+	}
+
+	void SocketStats::reset()
+	{
+		this->bytes_in = this->bytes_out = 0;
+		this->reads = this->writes = 0;
+		this->would_block = this->errors = 0;
+		this->connects = this->connect_failures = 0;
+		this->connect_time = 0;
+		this->rtt = this->retransmits = 0;
+	}
+
+	static void account_failure(SocketStats& stats)
+	{
+		if(socket_would_block()) {
+			stats.would_block++;
+			totals.would_block.fetch_add(1);
+		} else {
+			stats.errors++;
+			totals.errors.fetch_add(1);
+		}
+	}
+
+	void SocketStats::received(ssize_t rv)
+	{
+		this->reads++;
+		totals.reads.fetch_add(1);
+
+		if(rv < 0) {
+			account_failure(*this);
+			return;
+		}
+
+		this->bytes_in += rv;
+		totals.bytes_in.fetch_add(rv);
+	}
+
+	void SocketStats::sent(ssize_t rv)
+	{
+		this->writes++;
+		totals.writes.fetch_add(1);
+
+		if(rv < 0) {
+			account_failure(*this);
+			return;
+		}
+
+		this->bytes_out += rv;
+		totals.bytes_out.fetch_add(rv);
+	}
+
+	void SocketStats::connected(bool ok, time_t start)
+	{
+		this->connect_time = lwiot_tick_ms() - start;
+
+		if(ok) {
+			this->connects++;
+			totals.connects.fetch_add(1);
+		} else {
+			this->connect_failures++;
+			totals.connect_failures.fetch_add(1);
+		}
+	}
+
+	void SocketStats::sample(socket_t *socket)
+	{
+		socket_tcp_info_t info;
+
+		if(socket == nullptr || socket_tcp_info(socket, &info) != -EOK)
+			return;
+
+		this->rtt = info.rtt;
+		this->retransmits = info.retransmits;
+	}
+
+	String SocketStats::toString() const
+	{
+		char buffer[256];
+
+		snprintf(buffer, sizeof(buffer), "bytes_in=%llu bytes_out=%llu reads=%lu writes=%lu would_block=%lu "
+		         "errors=%lu connects=%lu connect_failures=%lu connect_time=%ld rtt=%lu retransmits=%lu",
+		         static_cast<unsigned long long>(this->bytes_in), static_cast<unsigned long long>(this->bytes_out),
+		         static_cast<unsigned long>(this->reads), static_cast<unsigned long>(this->writes),
+		         static_cast<unsigned long>(this->would_block), static_cast<unsigned long>(this->errors),
+		         static_cast<unsigned long>(this->connects), static_cast<unsigned long>(this->connect_failures),
+		         static_cast<long>(this->connect_time), static_cast<unsigned long>(this->rtt),
+		         static_cast<unsigned long>(this->retransmits));
+
+		return String(buffer);
+	}
+
+	SocketStats SocketStats::global()
+	{
+		SocketStats stats;
+
+		stats.bytes_in = totals.bytes_in.load();
+		stats.bytes_out = totals.bytes_out.load();
+		stats.reads = totals.reads.load();
+		stats.writes = totals.writes.load();
+		stats.would_block = totals.would_block.load();
+		stats.errors = totals.errors.load();
+		stats.connects = totals.connects.load();
+		stats.connect_failures = totals.connect_failures.load();
+
+		return stats;
+	}
+
+	void SocketStats::resetGlobal()
+	{
+		totals.bytes_in.store(0);
+		totals.bytes_out.store(0);
+		totals.reads.store(0);
+		totals.writes.store(0);
+		totals.would_block.store(0);
+		totals.errors.store(0);
+		totals.connects.store(0);
+		totals.connect_failures.store(0);
+	}
+}
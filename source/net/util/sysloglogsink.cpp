@@ -0,0 +1,76 @@
+/*
+ * Syslog sink for the asynchronous logging backend.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/format.h>
+#include <lwiot/util/logbackend.h>
+#include <lwiot/network/udpclient.h>
+#include <lwiot/network/sysloglogsink.h>
+
+namespace lwiot
+{
+	static int severity(LogLevel level)
+	{
+		switch(level) {
+		case LogLevel::Debug:
+			return 7;
+
+		case LogLevel::Warning:
+			return 4;
+
+		case LogLevel::Error:
+			return 3;
+
+		default:
+			return 6;
+		}
+	}
+
+	SyslogLogSink::SyslogLogSink(UdpClient &client, const String &hostname) :
+		_client(client), _hostname(hostname), _length(0)
+	{
+	}
+
+	void SyslogLogSink::write(const LogRecord &record)
+	{
+		/* A line that was never ended is sent as it is. */
+		if((record.flags & LogRecord::Start) && this->_length > 0)
+			this->send();
+
+		if(this->_length == 0) {
+			auto priority = CONFIG_LOG_SYSLOG_FACILITY * 8 + severity(record.level);
+			auto app = record.subsystem[0] != '\0' ? static_cast<const char *>(record.subsystem) : "lwiot";
+
+			this->_length = lwiot::format(this->_line, sizeof(this->_line), "<{}>1 - {} {} - - - ", priority,
+			                              this->_hostname, app);
+
+			if(this->_length >= sizeof(this->_line))
+				this->_length = sizeof(this->_line) - 1;
+		}
+
+		auto length = sizeof(this->_line) - this->_length;
+
+		if(record.length < length)
+			length = record.length;
+
+		memcpy(this->_line + this->_length, record.payload, length);
+		this->_length += length;
+
+		if(record.flags & LogRecord::End)
+			this->send();
+	}
+
+	void SyslogLogSink::send()
+	{
+		this->_client.write(this->_line, this->_length);
+		this->_length = 0;
+	}
+}
@@ -27,6 +27,7 @@
 #define CMD_REPSTA 4U
 #define CMD_RD 8U
 #define CMD_ACK 16U
+#define CMD_BULK 32U
 
 struct i2c_msg {
 	uint8_t *buff;
@@ -155,6 +156,18 @@ namespace lwiot
 			msg_num += 1;
 		}
 
+		void HardwareI2CAlgorithm::writeBulk(const uint8_t *bytes, size_t length, bool ack)
+		{
+			this->write(bytes, length, ack);
+			xfer_msgs[msg_index - 1].flags |= CMD_BULK;
+		}
+
+		void HardwareI2CAlgorithm::readBulk(uint8_t *bytes, size_t length, bool ack)
+		{
+			this->read(bytes, length, ack);
+			xfer_msgs[msg_index - 1].flags |= CMD_BULK;
+		}
+
 		int HardwareI2CAlgorithm::flush() const
 		{
 
@@ -171,10 +184,21 @@ namespace lwiot
 					i2c_write_start(msg->buff[0]);
 				}
 
-				if((msg->flags & CMD_RD) != 0) {
+				if((msg->flags & CMD_RD) != 0 && (msg->flags & CMD_BULK) != 0) {
+					i2c_read_block(msg->buff, msg->len, (msg->flags & CMD_ACK) != 0);
+				} else if((msg->flags & CMD_RD) != 0) {
 					for(int j = 0; j < msg->len; j++) {
 						msg->buff[j] = i2c_read((msg->flags & CMD_ACK) != 0);
 					}
+				} else if((msg->flags & CMD_BULK) != 0) {
+					uint8_t ack = i2c_write_block(msg->buff, msg->len) != 0;
+					uint8_t expected = (msg->flags & CMD_ACK) != 0;
+
+					if(ack ^ expected) {
+						exit_critical();
+						print_dbg("ACK not received!");
+						return -EINVALID;
+					}
 				} else {
 					for(int j = 0; j < msg->len; j++) {
 						uint8_t ack = i2c_write(msg->buff[j]) != 0;
@@ -27,6 +27,32 @@ namespace lwiot
 		this->_values[pin] = value;
 	}
 
+	void HostedGpioChip::writeMask(uint32_t set, uint32_t clear)
+	{
+		print_dbg("Writing port: set %08x clear %08x\n", set, clear);
+
+		for(int pin = 0; pin < 32; pin++) {
+			uint32_t mask = 1UL << pin;
+
+			if(set & mask)
+				this->_values[pin] = true;
+			else if(clear & mask)
+				this->_values[pin] = false;
+		}
+	}
+
+	uint32_t HostedGpioChip::readPort() const
+	{
+		uint32_t value = 0;
+
+		for(auto& entry : this->_values) {
+			if(entry.first < 32 && entry.second)
+				value |= 1UL << entry.first;
+		}
+
+		return value;
+	}
+
 	void HostedGpioChip::odWrite(int pin, bool value)
 	{
 		this->write(pin, value);
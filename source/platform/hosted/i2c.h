@@ -21,9 +21,11 @@ extern uint8_t i2c_write_start(uint8_t address);
 extern void i2c_write_stop(void);
 
 extern uint8_t i2c_write(uint8_t data);
+extern uint8_t i2c_write_block(const uint8_t *data, size_t length);
 
 extern uint8_t i2c_read_ack(void);
 extern uint8_t i2c_read_nack(void);
 extern uint8_t i2c_read(bool ack);
+extern void i2c_read_block(uint8_t *data, size_t length, bool ack);
 
 CDECL_END
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <lwiot.h>
 
 #include <lwiot/log.h>
@@ -28,6 +29,12 @@ uint8_t i2c_write(uint8_t data)
 	return false;
 }
 
+uint8_t i2c_write_block(const uint8_t *data, size_t length)
+{
+	print_dbg("I2C write block: %lu bytes\n", (unsigned long) length);
+	return false;
+}
+
 uint8_t i2c_read_ack(void)
 {
 	print_dbg("I2C read byte. ACK expected!\n");
@@ -52,6 +59,12 @@ uint8_t i2c_read(bool ack)
 	return byte;
 }
 
+void i2c_read_block(uint8_t *data, size_t length, bool ack)
+{
+	print_dbg("I2C read block: %lu bytes. %s expected!\n", (unsigned long) length, ack ? "ACK" : "NACK");
+	memset(data, ack ? 0xAA : 0xAB, length);
+}
+
 void i2c_write_stop(void)
 {
 	print_dbg("I2C stop issued!\n");
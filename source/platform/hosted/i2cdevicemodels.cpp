@@ -0,0 +1,996 @@
+/*
+ * Register level models of I2C devices for the hosted I2C simulator.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/scopedlock.h>
+#include <lwiot/hosted/i2cdevicemodels.h>
+
+#define NS_PER_US 1000ULL
+#define NS_PER_MS 1000000ULL
+
+#define BMP280_CHIP_ID 0x58
+#define BMP280_REG_CALIBRATION 0x88
+#define BMP280_REG_ID 0xD0
+#define BMP280_REG_RESET 0xE0
+#define BMP280_REG_STATUS 0xF3
+#define BMP280_REG_CTRL_MEAS 0xF4
+#define BMP280_REG_CONFIG 0xF5
+#define BMP280_REG_DATA 0xF7
+#define BMP280_RESET_WORD 0xB6
+#define BMP280_STATUS_MEASURING 0x08
+
+#define SHT31_MEAS_HIGHREP 0x2400
+#define SHT31_MEAS_MEDREP 0x240B
+#define SHT31_MEAS_LOWREP 0x2416
+#define SHT31_MEAS_HIGHREP_STRETCH 0x2C06
+#define SHT31_MEAS_MEDREP_STRETCH 0x2C0D
+#define SHT31_MEAS_LOWREP_STRETCH 0x2C10
+#define SHT31_READSTATUS 0xF32D
+#define SHT31_CLEARSTATUS 0x3041
+#define SHT31_SOFTRESET 0x30A2
+#define SHT31_HEATEREN 0x306D
+#define SHT31_HEATERDIS 0x3066
+#define SHT31_STATUS_HEATER 0x2000
+#define SHT31_STATUS_RESET 0x0010
+#define SHT31_STATUS_COMMAND 0x0002
+#define SHT31_STATUS_FLAGS 0x8C12
+
+#define CCS811_STATUS 0x00
+#define CCS811_MEAS_MODE 0x01
+#define CCS811_ALG_RESULT_DATA 0x02
+#define CCS811_RAW_DATA 0x03
+#define CCS811_ENV_DATA 0x05
+#define CCS811_NTC 0x06
+#define CCS811_THRESHOLDS 0x10
+#define CCS811_HW_ID 0x20
+#define CCS811_HW_VERSION 0x21
+#define CCS811_FW_BOOT_VERSION 0x23
+#define CCS811_FW_APP_VERSION 0x24
+#define CCS811_ERROR_ID 0xE0
+#define CCS811_APP_START 0xF4
+#define CCS811_SW_RESET 0xFF
+#define CCS811_HW_ID_CODE 0x81
+#define CCS811_ERROR_WRITE_REG 0x01
+#define CCS811_ERROR_READ_REG 0x02
+#define CCS811_ERROR_MEAS_MODE 0x04
+
+#define SSD1306_MEMORYMODE 0x20
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+#define SSD1306_SETCONTRAST 0x81
+#define SSD1306_NORMALDISPLAY 0xA6
+#define SSD1306_INVERTDISPLAY 0xA7
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+#define SSD1306_PAGESTART 0xB0
+#define SSD1306_CONTROL_CO 0x80
+#define SSD1306_CONTROL_DATA 0x40
+#define SSD1306_MODE_HORIZONTAL 0
+#define SSD1306_MODE_VERTICAL 1
+#define SSD1306_MODE_PAGE 2
+
+namespace lwiot
+{
+	namespace hosted
+	{
+		static uint8_t crc8(const uint8_t *data, size_t length)
+		{
+			uint8_t crc = 0xFF;
+
+			for(size_t idx = 0; idx < length; idx++) {
+				crc ^= data[idx];
+
+				for(int bit = 0; bit < 8; bit++)
+					crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : (crc << 1);
+			}
+
+			return crc;
+		}
+
+		static uint16_t scale(double value, double offset, double range)
+		{
+			auto raw = (value + offset) * 65535.0 / range + 0.5;
+
+			if(raw < 0)
+				return 0;
+
+			if(raw > 65535.0)
+				return 0xFFFF;
+
+			return static_cast<uint16_t>(raw);
+		}
+
+		/*
+		 * BMP280
+		 */
+
+		Bmp280Model::Bmp280Model(uint16_t address) : SimulatedI2CDevice(address), _pointer(0), _addressed(false),
+			_pressure(415148), _temperature(519888), _conversions(0)
+		{
+			const int16_t calibration[] = {
+				27504, 26435, -1000, static_cast<int16_t>(36477), -10685, 3024, 2855, 140, -7, 15500, -14600, 6000
+			};
+
+			for(size_t idx = 0; idx < sizeof(calibration) / sizeof(calibration[0]); idx++) {
+				auto value = static_cast<uint16_t>(calibration[idx]);
+
+				this->_calibration[idx * 2] = static_cast<uint8_t>(value);
+				this->_calibration[idx * 2 + 1] = static_cast<uint8_t>(value >> 8);
+			}
+
+			this->reset();
+		}
+
+		void Bmp280Model::setRaw(int32_t pressure, int32_t temperature)
+		{
+			ScopedLock lock(this->_lock);
+
+			this->_pressure = pressure;
+			this->_temperature = temperature;
+		}
+
+		uint32_t Bmp280Model::conversions() const
+		{
+			ScopedLock lock(this->_lock);
+			return this->_conversions;
+		}
+
+		void Bmp280Model::reset()
+		{
+			const uint8_t data[] = { 0x80, 0x00, 0x00, 0x80, 0x00, 0x00 };
+
+			this->_ctrl = 0;
+			this->_config = 0;
+			this->_started = 0;
+			this->_cycles = 0;
+			memcpy(this->_data, data, sizeof(data));
+			memcpy(this->_shadow, data, sizeof(data));
+		}
+
+		static int oversampling(uint8_t setting)
+		{
+			return setting == 0 ? 0 : 1 << ((setting > 5 ? 5 : setting) - 1);
+		}
+
+		/* Typical measurement time from the datasheet: 1 ms, plus 2 ms per sample and 0.5 ms for pressure. */
+		uint64_t Bmp280Model::conversionTime() const
+		{
+			auto temperature = oversampling(this->_ctrl >> 5);
+			auto pressure = oversampling((this->_ctrl >> 2) & 0x7);
+			uint64_t us = 1000 + 2000 * temperature;
+
+			if(pressure > 0)
+				us += 2000 * pressure + 500;
+
+			return us * NS_PER_US;
+		}
+
+		uint64_t Bmp280Model::period() const
+		{
+			const uint32_t standby[] = { 500, 62500, 125000, 250000, 500000, 1000000, 2000000, 4000000 };
+			return this->conversionTime() + standby[this->_config >> 5] * NS_PER_US;
+		}
+
+		void Bmp280Model::update(uint64_t now)
+		{
+			auto mode = this->_ctrl & 0x3;
+			auto time = this->conversionTime();
+			uint32_t cycles;
+
+			if(mode == 0 || now < this->_started + time)
+				return;
+
+			if(mode == 0x3) {
+				cycles = static_cast<uint32_t>((now - this->_started - time) / this->period()) + 1;
+			} else {
+				cycles = 1;
+				this->_ctrl &= ~0x3;
+			}
+
+			if(cycles == this->_cycles)
+				return;
+
+			this->_conversions += cycles - this->_cycles;
+			this->_cycles = cycles;
+
+			auto pressure = static_cast<uint32_t>(this->_pressure) << 4;
+			auto temperature = static_cast<uint32_t>(this->_temperature) << 4;
+
+			this->_data[0] = static_cast<uint8_t>(pressure >> 16);
+			this->_data[1] = static_cast<uint8_t>(pressure >> 8);
+			this->_data[2] = static_cast<uint8_t>(pressure);
+			this->_data[3] = static_cast<uint8_t>(temperature >> 16);
+			this->_data[4] = static_cast<uint8_t>(temperature >> 8);
+			this->_data[5] = static_cast<uint8_t>(temperature);
+		}
+
+		uint8_t Bmp280Model::status(uint64_t now) const
+		{
+			auto mode = this->_ctrl & 0x3;
+			auto time = this->conversionTime();
+
+			if(mode == 0x3 && (now - this->_started) % this->period() < time)
+				return BMP280_STATUS_MEASURING;
+
+			if((mode == 0x1 || mode == 0x2) && now < this->_started + time)
+				return BMP280_STATUS_MEASURING;
+
+			return 0;
+		}
+
+		uint8_t Bmp280Model::registerValue(uint8_t reg) const
+		{
+			if(reg >= BMP280_REG_CALIBRATION && reg < BMP280_REG_CALIBRATION + sizeof(this->_calibration))
+				return this->_calibration[reg - BMP280_REG_CALIBRATION];
+
+			if(reg >= BMP280_REG_DATA && reg < BMP280_REG_DATA + sizeof(this->_shadow))
+				return this->_shadow[reg - BMP280_REG_DATA];
+
+			switch(reg) {
+			case BMP280_REG_ID:
+				return BMP280_CHIP_ID;
+
+			case BMP280_REG_STATUS:
+				return this->status(this->now());
+
+			case BMP280_REG_CTRL_MEAS:
+				return this->_ctrl;
+
+			case BMP280_REG_CONFIG:
+				return this->_config;
+
+			default:
+				return 0;
+			}
+		}
+
+		bool Bmp280Model::start(bool read)
+		{
+			this->update(this->now());
+
+			if(read)
+				memcpy(this->_shadow, this->_data, sizeof(this->_data));
+			else
+				this->_addressed = false;
+
+			return true;
+		}
+
+		/* Writes are pairs of a register address and its value. */
+		bool Bmp280Model::write(uint8_t byte)
+		{
+			if(!this->_addressed) {
+				this->_pointer = byte;
+				this->_addressed = true;
+				return true;
+			}
+
+			this->_addressed = false;
+
+			switch(this->_pointer) {
+			case BMP280_REG_RESET:
+				if(byte == BMP280_RESET_WORD)
+					this->reset();
+				break;
+
+			case BMP280_REG_CTRL_MEAS:
+				this->_ctrl = byte;
+				this->_started = this->now();
+				this->_cycles = 0;
+				break;
+
+			case BMP280_REG_CONFIG:
+				this->_config = byte;
+				break;
+
+			default:
+				break;
+			}
+
+			return true;
+		}
+
+		uint8_t Bmp280Model::read()
+		{
+			return this->registerValue(this->_pointer++);
+		}
+
+		void Bmp280Model::stop()
+		{
+			this->_addressed = false;
+		}
+
+		/*
+		 * SHT31
+		 */
+
+		Sht31Model::Sht31Model(uint16_t address) : SimulatedI2CDevice(address), _status(SHT31_STATUS_RESET),
+			_command(0), _received(0), _busy(0), _stretch(false), _available(0), _index(0), _measurements(0)
+		{
+			this->_temperature = scale(25.0, 45.0, 175.0);
+			this->_humidity = scale(50.0, 0.0, 100.0);
+		}
+
+		void Sht31Model::setTemperature(double celsius)
+		{
+			ScopedLock lock(this->_lock);
+			this->_temperature = scale(celsius, 45.0, 175.0);
+		}
+
+		void Sht31Model::setHumidity(double percent)
+		{
+			ScopedLock lock(this->_lock);
+			this->_humidity = scale(percent, 0.0, 100.0);
+		}
+
+		bool Sht31Model::heater() const
+		{
+			ScopedLock lock(this->_lock);
+			return (this->_status & SHT31_STATUS_HEATER) != 0;
+		}
+
+		uint32_t Sht31Model::measurements() const
+		{
+			ScopedLock lock(this->_lock);
+			return this->_measurements;
+		}
+
+		bool Sht31Model::start(bool read)
+		{
+			auto now = this->now();
+
+			if(now < this->_busy) {
+				if(!read || !this->_stretch)
+					return false;
+
+				this->stretch(this->_busy - now);
+			}
+
+			this->_index = 0;
+
+			if(read)
+				return this->_available > 0;
+
+			this->_received = 0;
+			return true;
+		}
+
+		bool Sht31Model::write(uint8_t byte)
+		{
+			this->_command = static_cast<uint16_t>(this->_command << 8 | byte);
+
+			if(++this->_received == 2)
+				this->execute(this->_command);
+
+			return true;
+		}
+
+		uint8_t Sht31Model::read()
+		{
+			if(this->_index < this->_available)
+				return this->_output[this->_index++];
+
+			return 0xFF;
+		}
+
+		/* Results can be read once. */
+		void Sht31Model::stop()
+		{
+			if(this->_index > 0)
+				this->_available = 0;
+
+			this->_index = 0;
+		}
+
+		void Sht31Model::execute(uint16_t command)
+		{
+			switch(command) {
+			case SHT31_MEAS_HIGHREP:
+				this->measure(15 * NS_PER_MS, false);
+				break;
+
+			case SHT31_MEAS_MEDREP:
+				this->measure(6 * NS_PER_MS, false);
+				break;
+
+			case SHT31_MEAS_LOWREP:
+				this->measure(4 * NS_PER_MS, false);
+				break;
+
+			case SHT31_MEAS_HIGHREP_STRETCH:
+				this->measure(15 * NS_PER_MS, true);
+				break;
+
+			case SHT31_MEAS_MEDREP_STRETCH:
+				this->measure(6 * NS_PER_MS, true);
+				break;
+
+			case SHT31_MEAS_LOWREP_STRETCH:
+				this->measure(4 * NS_PER_MS, true);
+				break;
+
+			case SHT31_READSTATUS:
+				this->output(this->_status, 0);
+				this->_available = 3;
+				break;
+
+			case SHT31_CLEARSTATUS:
+				this->_status &= ~SHT31_STATUS_FLAGS;
+				break;
+
+			case SHT31_SOFTRESET:
+				this->_status = SHT31_STATUS_RESET;
+				this->_available = 0;
+				this->_stretch = false;
+				this->_busy = this->now() + 1500 * NS_PER_US;
+				break;
+
+			case SHT31_HEATEREN:
+				this->_status |= SHT31_STATUS_HEATER;
+				break;
+
+			case SHT31_HEATERDIS:
+				this->_status &= ~SHT31_STATUS_HEATER;
+				break;
+
+			default:
+				this->_status |= SHT31_STATUS_COMMAND;
+				return;
+			}
+
+			this->_status &= ~SHT31_STATUS_COMMAND;
+		}
+
+		void Sht31Model::measure(uint64_t duration, bool stretch)
+		{
+			this->_busy = this->now() + duration;
+			this->_stretch = stretch;
+			this->_measurements++;
+
+			this->output(this->_temperature, 0);
+			this->output(this->_humidity, 3);
+			this->_available = 6;
+		}
+
+		void Sht31Model::output(uint16_t word, size_t offset)
+		{
+			this->_output[offset] = static_cast<uint8_t>(word >> 8);
+			this->_output[offset + 1] = static_cast<uint8_t>(word);
+			this->_output[offset + 2] = crc8(&this->_output[offset], 2);
+		}
+
+		/*
+		 * CCS811
+		 */
+
+		Ccs811Model::Ccs811Model(uint16_t address) : SimulatedI2CDevice(address), _eco2(400), _tvoc(0),
+			_vref(0x0300), _vntc(0x0300), _mailbox(0), _addressed(false), _reading(false), _length(0), _index(0)
+		{
+			this->reset();
+		}
+
+		void Ccs811Model::setResult(uint16_t eco2, uint16_t tvoc)
+		{
+			ScopedLock lock(this->_lock);
+
+			this->_eco2 = eco2;
+			this->_tvoc = tvoc;
+		}
+
+		void Ccs811Model::setNtc(uint16_t vref, uint16_t vntc)
+		{
+			ScopedLock lock(this->_lock);
+
+			this->_vref = vref;
+			this->_vntc = vntc;
+		}
+
+		bool Ccs811Model::application() const
+		{
+			ScopedLock lock(this->_lock);
+			return this->_app;
+		}
+
+		uint8_t Ccs811Model::driveMode() const
+		{
+			ScopedLock lock(this->_lock);
+			return (this->_mode >> 4) & 0x7;
+		}
+
+		uint32_t Ccs811Model::results() const
+		{
+			ScopedLock lock(this->_lock);
+			return this->_produced;
+		}
+
+		void Ccs811Model::reset()
+		{
+			this->_app = false;
+			this->_mode = 0;
+			this->_error = 0;
+			this->_started = 0;
+			this->_produced = 0;
+			this->_consumed = 0;
+
+			memset(this->_env, 0, sizeof(this->_env));
+			memset(this->_thresholds, 0, sizeof(this->_thresholds));
+		}
+
+		void Ccs811Model::update(uint64_t now)
+		{
+			const uint64_t periods[] = { 0, 1000, 10000, 60000, 250 };
+			auto mode = (this->_mode >> 4) & 0x7;
+
+			if(!this->_app || mode == 0 || mode >= sizeof(periods) / sizeof(periods[0]))
+				return;
+
+			this->_produced = static_cast<uint32_t>((now - this->_started) / (periods[mode] * NS_PER_MS));
+		}
+
+		uint8_t Ccs811Model::status() const
+		{
+			uint8_t status = 0x10;
+
+			if(this->_app)
+				status |= 0x80;
+
+			if(this->_produced > this->_consumed)
+				status |= 0x08;
+
+			if(this->_error != 0)
+				status |= 0x01;
+
+			return status;
+		}
+
+		bool Ccs811Model::start(bool read)
+		{
+			this->update(this->now());
+			this->_reading = read;
+			this->_index = 0;
+
+			if(!read) {
+				this->_addressed = false;
+				this->_length = 0;
+			}
+
+			return true;
+		}
+
+		bool Ccs811Model::write(uint8_t byte)
+		{
+			if(!this->_addressed) {
+				this->_mailbox = byte;
+				this->_addressed = true;
+				return true;
+			}
+
+			if(this->_length < sizeof(this->_input))
+				this->_input[this->_length++] = byte;
+
+			return true;
+		}
+
+		uint8_t Ccs811Model::read()
+		{
+			return this->output(this->_index++);
+		}
+
+		void Ccs811Model::stop()
+		{
+			if(!this->_reading && this->_addressed)
+				this->execute();
+
+			if(this->_reading && this->_index > 0) {
+				if(this->_mailbox == CCS811_ALG_RESULT_DATA)
+					this->_consumed = this->_produced;
+				else if(this->_mailbox == CCS811_ERROR_ID)
+					this->_error = 0;
+			}
+
+			this->_reading = false;
+			this->_addressed = false;
+		}
+
+		void Ccs811Model::execute()
+		{
+			const uint8_t sequence[] = { 0x11, 0xE5, 0x72, 0x8A };
+
+			/* A write of only the mailbox selects it for reading. */
+			if(this->_length == 0) {
+				if(this->_mailbox == CCS811_APP_START)
+					this->_app = true;
+
+				return;
+			}
+
+			switch(this->_mailbox) {
+			case CCS811_SW_RESET:
+				if(this->_length == sizeof(sequence) && memcmp(this->_input, sequence, sizeof(sequence)) == 0)
+					this->reset();
+				break;
+
+			case CCS811_MEAS_MODE:
+				if(!this->_app) {
+					this->_error |= CCS811_ERROR_WRITE_REG;
+					break;
+				}
+
+				if(((this->_input[0] >> 4) & 0x7) > 4) {
+					this->_error |= CCS811_ERROR_MEAS_MODE;
+					break;
+				}
+
+				this->_mode = this->_input[0];
+				this->_started = this->now();
+				this->_produced = 0;
+				this->_consumed = 0;
+				break;
+
+			case CCS811_ENV_DATA:
+				memcpy(this->_env, this->_input, sizeof(this->_env));
+				break;
+
+			case CCS811_THRESHOLDS:
+				memcpy(this->_thresholds, this->_input, sizeof(this->_thresholds));
+				break;
+
+			default:
+				this->_error |= CCS811_ERROR_WRITE_REG;
+				break;
+			}
+		}
+
+		uint8_t Ccs811Model::output(size_t index)
+		{
+			switch(this->_mailbox) {
+			case CCS811_STATUS:
+				return this->status();
+
+			case CCS811_MEAS_MODE:
+				return this->_mode;
+
+			case CCS811_ALG_RESULT_DATA: {
+				const uint8_t result[] = {
+					static_cast<uint8_t>(this->_eco2 >> 8), static_cast<uint8_t>(this->_eco2),
+					static_cast<uint8_t>(this->_tvoc >> 8), static_cast<uint8_t>(this->_tvoc),
+					this->status(), this->_error, 0, 0
+				};
+
+				return index < sizeof(result) ? result[index] : 0;
+			}
+
+			case CCS811_RAW_DATA:
+				return 0;
+
+			case CCS811_NTC: {
+				const uint8_t ntc[] = {
+					static_cast<uint8_t>(this->_vref >> 8), static_cast<uint8_t>(this->_vref),
+					static_cast<uint8_t>(this->_vntc >> 8), static_cast<uint8_t>(this->_vntc)
+				};
+
+				return index < sizeof(ntc) ? ntc[index] : 0;
+			}
+
+			case CCS811_HW_ID:
+				return CCS811_HW_ID_CODE;
+
+			case CCS811_HW_VERSION:
+				return 0x12;
+
+			case CCS811_FW_BOOT_VERSION:
+			case CCS811_FW_APP_VERSION:
+				return index == 0 ? 0x10 : 0;
+
+			case CCS811_ERROR_ID:
+				return this->_error;
+
+			default:
+				this->_error |= CCS811_ERROR_READ_REG;
+				return 0;
+			}
+		}
+
+		/*
+		 * 24C02
+		 */
+
+		Eeprom24C02Model::Eeprom24C02Model(uint16_t address, uint64_t cycle) : SimulatedI2CDevice(address),
+			_dirty(0), _page(0), _pointer(0), _addressed(false), _cycle(cycle), _busy(0), _writes(0)
+		{
+			memset(this->_memory, 0xFF, sizeof(this->_memory));
+		}
+
+		uint8_t Eeprom24C02Model::peek(uint8_t address) const
+		{
+			ScopedLock lock(this->_lock);
+			return this->_memory[address];
+		}
+
+		uint32_t Eeprom24C02Model::writeCycles() const
+		{
+			ScopedLock lock(this->_lock);
+			return this->_writes;
+		}
+
+		bool Eeprom24C02Model::start(bool read)
+		{
+			if(this->now() < this->_busy)
+				return false;
+
+			if(!read) {
+				this->_addressed = false;
+				this->_dirty = 0;
+			}
+
+			return true;
+		}
+
+		bool Eeprom24C02Model::write(uint8_t byte)
+		{
+			if(!this->_addressed) {
+				this->_pointer = byte;
+				this->_page = byte & ~(PageSize - 1);
+				this->_addressed = true;
+				return true;
+			}
+
+			auto offset = this->_pointer & (PageSize - 1);
+
+			this->_latch[offset] = byte;
+			this->_dirty |= 1U << offset;
+			this->_pointer = this->_page | ((offset + 1) & (PageSize - 1));
+
+			return true;
+		}
+
+		uint8_t Eeprom24C02Model::read()
+		{
+			return this->_memory[this->_pointer++];
+		}
+
+		void Eeprom24C02Model::stop()
+		{
+			this->_addressed = false;
+
+			if(this->_dirty == 0)
+				return;
+
+			for(size_t idx = 0; idx < PageSize; idx++) {
+				if(this->_dirty & (1U << idx))
+					this->_memory[this->_page + idx] = this->_latch[idx];
+			}
+
+			this->_dirty = 0;
+			this->_busy = this->now() + this->_cycle;
+			this->_writes++;
+		}
+
+		/*
+		 * SSD1306
+		 */
+
+		Ssd1306Model::Ssd1306Model(uint16_t address) : SimulatedI2CDevice(address), _control(true),
+			_continuation(false), _data(false), _received(0), _expected(0), _mode(SSD1306_MODE_PAGE),
+			_column(0), _page(0), _columns{0, Width - 1}, _pages{0, Pages - 1}, _on(false), _inverted(false),
+			_contrast(0x7F), _written(0), _commands(0)
+		{
+			memset(this->_ram, 0, sizeof(this->_ram));
+		}
+
+		bool Ssd1306Model::pixel(int x, int y) const
+		{
+			ScopedLock lock(this->_lock);
+
+			if(x < 0 || x >= Width || y < 0 || y >= Pages * 8)
+				return false;
+
+			return (this->_ram[(y / 8) * Width + x] >> (y & 7)) & 1;
+		}
+
+		const uint8_t *Ssd1306Model::ram() const
+		{
+			return this->_ram;
+		}
+
+		bool Ssd1306Model::on() const
+		{
+			ScopedLock lock(this->_lock);
+			return this->_on;
+		}
+
+		bool Ssd1306Model::inverted() const
+		{
+			ScopedLock lock(this->_lock);
+			return this->_inverted;
+		}
+
+		uint8_t Ssd1306Model::contrast() const
+		{
+			ScopedLock lock(this->_lock);
+			return this->_contrast;
+		}
+
+		uint32_t Ssd1306Model::dataWritten() const
+		{
+			ScopedLock lock(this->_lock);
+			return this->_written;
+		}
+
+		uint32_t Ssd1306Model::commands() const
+		{
+			ScopedLock lock(this->_lock);
+			return this->_commands;
+		}
+
+		bool Ssd1306Model::start(bool read)
+		{
+			this->_control = true;
+			return true;
+		}
+
+		/*
+		 * A message starts with a control byte. Without the continuation bit, the remaining bytes are all
+		 * commands or all data. With it, every byte is preceded by a control byte of its own.
+		 */
+		bool Ssd1306Model::write(uint8_t byte)
+		{
+			if(this->_control) {
+				this->_continuation = (byte & SSD1306_CONTROL_CO) != 0;
+				this->_data = (byte & SSD1306_CONTROL_DATA) != 0;
+				this->_control = false;
+				return true;
+			}
+
+			if(this->_data)
+				this->store(byte);
+			else
+				this->command(byte);
+
+			this->_control = this->_continuation;
+			return true;
+		}
+
+		/* Status byte: bit 6 is set while the display is off. */
+		uint8_t Ssd1306Model::read()
+		{
+			return this->_on ? 0x00 : 0x40;
+		}
+
+		void Ssd1306Model::command(uint8_t byte)
+		{
+			this->_command[this->_received++] = byte;
+
+			if(this->_received == 1) {
+				switch(byte) {
+				case SSD1306_MEMORYMODE:
+				case SSD1306_SETCONTRAST:
+				case 0x8D: case 0xA8: case 0xD3: case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+					this->_expected = 2;
+					break;
+
+				case SSD1306_COLUMNADDR:
+				case SSD1306_PAGEADDR:
+				case 0xA3:
+					this->_expected = 3;
+					break;
+
+				case 0x29: case 0x2A:
+					this->_expected = 6;
+					break;
+
+				case 0x26: case 0x27:
+					this->_expected = 7;
+					break;
+
+				default:
+					this->_expected = 1;
+					break;
+				}
+			}
+
+			if(this->_received < this->_expected)
+				return;
+
+			this->execute();
+			this->_received = 0;
+		}
+
+		void Ssd1306Model::execute()
+		{
+			auto cmd = this->_command[0];
+
+			this->_commands++;
+
+			if(cmd < 0x10) {
+				this->_column = (this->_column & 0xF0) | cmd;
+				return;
+			}
+
+			if(cmd < 0x20) {
+				this->_column = static_cast<uint8_t>((this->_column & 0x0F) | ((cmd & 0x7) << 4));
+				return;
+			}
+
+			if(cmd >= SSD1306_PAGESTART && cmd < SSD1306_PAGESTART + Pages) {
+				this->_page = cmd & 0x7;
+				return;
+			}
+
+			switch(cmd) {
+			case SSD1306_MEMORYMODE:
+				this->_mode = this->_command[1] & 0x3;
+				break;
+
+			case SSD1306_COLUMNADDR:
+				this->_columns[0] = this->_command[1] & 0x7F;
+				this->_columns[1] = this->_command[2] & 0x7F;
+				this->_column = this->_columns[0];
+				break;
+
+			case SSD1306_PAGEADDR:
+				this->_pages[0] = this->_command[1] & 0x7;
+				this->_pages[1] = this->_command[2] & 0x7;
+				this->_page = this->_pages[0];
+				break;
+
+			case SSD1306_SETCONTRAST:
+				this->_contrast = this->_command[1];
+				break;
+
+			case SSD1306_NORMALDISPLAY:
+			case SSD1306_INVERTDISPLAY:
+				this->_inverted = cmd == SSD1306_INVERTDISPLAY;
+				break;
+
+			case SSD1306_DISPLAYOFF:
+			case SSD1306_DISPLAYON:
+				this->_on = cmd == SSD1306_DISPLAYON;
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		void Ssd1306Model::store(uint8_t byte)
+		{
+			this->_ram[this->_page * Width + this->_column] = byte;
+			this->_written++;
+
+			switch(this->_mode) {
+			case SSD1306_MODE_HORIZONTAL:
+				if(this->_column < this->_columns[1]) {
+					this->_column++;
+					break;
+				}
+
+				this->_column = this->_columns[0];
+				this->_page = this->_page < this->_pages[1] ? this->_page + 1 : this->_pages[0];
+				break;
+
+			case SSD1306_MODE_VERTICAL:
+				if(this->_page < this->_pages[1]) {
+					this->_page++;
+					break;
+				}
+
+				this->_page = this->_pages[0];
+				this->_column = this->_column < this->_columns[1] ? this->_column + 1 : this->_columns[0];
+				break;
+
+			default:
+				this->_column = this->_column < this->_columns[1] ? this->_column + 1 : this->_columns[0];
+				break;
+			}
+		}
+	}
+}
@@ -25,6 +25,7 @@
 #define CMD_REPSTA 4U
 #define CMD_RD 8U
 #define CMD_ACK 16U
+#define CMD_BULK 32U
 
 struct i2c_msg {
 	uint8_t *buff;
@@ -121,6 +122,12 @@ void i2c_write_buffer(const uint8_t *bytes, size_t length, bool ack)
 	msg_num += 1;
 }
 
+void i2c_write_bulk(const uint8_t *bytes, size_t length, bool ack)
+{
+	i2c_write_buffer(bytes, length, ack);
+	xfer_msgs[msg_index - 1].flags |= CMD_BULK;
+}
+
 void i2c_read_byte(uint8_t* byte, bool ack)
 {
 	struct i2c_msg *msg ;
@@ -155,6 +162,12 @@ void i2c_read_buffer(uint8_t* bytes, size_t length, bool ack)
 	msg_num += 1;
 }
 
+void i2c_read_bulk(uint8_t* bytes, size_t length, bool ack)
+{
+	i2c_read_buffer(bytes, length, ack);
+	xfer_msgs[msg_index - 1].flags |= CMD_BULK;
+}
+
 int i2c_write_buffers()
 {
 	struct i2c_msg *msg;
@@ -170,10 +183,21 @@ int i2c_write_buffers()
 			i2c_write_start(msg->buff[0]);
 		}
 
-		if((msg->flags & CMD_RD) != 0) {
+		if((msg->flags & CMD_RD) != 0 && (msg->flags & CMD_BULK) != 0) {
+			i2c_read_block(msg->buff, msg->len, (msg->flags & CMD_ACK) != 0);
+		} else if((msg->flags & CMD_RD) != 0) {
 			for(int j = 0; j < msg->len; j++) {
 				msg->buff[j] = i2c_read((msg->flags & CMD_ACK) != 0);
 			}
+		} else if((msg->flags & CMD_BULK) != 0) {
+			uint8_t ack = i2c_write_block(msg->buff, msg->len) != 0;
+			uint8_t expected = (msg->flags & CMD_ACK) != 0;
+
+			if(ack ^ expected) {
+				exit_critical();
+				print_dbg("ACK not received!");
+				return -EINVALID;
+			}
 		} else {
 			for(int j = 0; j < msg->len; j++) {
 				uint8_t ack = i2c_write(msg->buff[j]) != 0;
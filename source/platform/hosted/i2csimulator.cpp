@@ -0,0 +1,278 @@
+/*
+ * Hosted I2C bus simulator.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/error.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/kernel/clock.h>
+#include <lwiot/hosted/i2csimulator.h>
+
+#define NS_PER_SEC 1000000000ULL
+
+/* Start or stop condition, and a byte followed by its ACK. */
+#define CONDITION_BITS 1
+#define BYTE_BITS 9
+
+namespace lwiot
+{
+	namespace hosted
+	{
+		SimulatedI2CDevice::SimulatedI2CDevice(uint16_t address) : _lock(false), _address(address), _bus(nullptr)
+		{
+		}
+
+		SimulatedI2CDevice::~SimulatedI2CDevice()
+		{
+			if(this->_bus != nullptr)
+				this->_bus->detach(*this);
+		}
+
+		uint16_t SimulatedI2CDevice::address() const
+		{
+			return this->_address;
+		}
+
+		bool SimulatedI2CDevice::start(bool read)
+		{
+			return true;
+		}
+
+		void SimulatedI2CDevice::stop()
+		{
+		}
+
+		uint64_t SimulatedI2CDevice::now() const
+		{
+			if(this->_bus == nullptr)
+				return 0;
+
+			return this->_bus->clock();
+		}
+
+		void SimulatedI2CDevice::stretch(uint64_t ns)
+		{
+			if(this->_bus != nullptr)
+				this->_bus->advance(ns);
+		}
+
+		I2CSimulator::I2CSimulator(uint32_t frequency, Timing timing) : I2CAlgorithm(1, frequency),
+			_timing(timing), _epoch(Clock::now()), _elapsed(0), _stats(), _lock(false)
+		{
+		}
+
+		I2CSimulator::~I2CSimulator()
+		{
+			for(auto device : this->_devices)
+				device->_bus = nullptr;
+		}
+
+		void I2CSimulator::attach(SimulatedI2CDevice& device)
+		{
+			ScopedLock lock(this->_lock);
+
+			if(device._bus == this)
+				return;
+
+			device._bus = this;
+			this->_devices.push_back(&device);
+		}
+
+		void I2CSimulator::detach(SimulatedI2CDevice& device)
+		{
+			ScopedLock lock(this->_lock);
+
+			for(auto it = this->_devices.begin(); it != this->_devices.end(); ++it) {
+				if(*it != &device)
+					continue;
+
+				this->_devices.erase(it);
+				device._bus = nullptr;
+				break;
+			}
+		}
+
+		uint64_t I2CSimulator::now() const
+		{
+			ScopedLock lock(this->_lock);
+			return this->clock();
+		}
+
+		I2CSimulator::Statistics I2CSimulator::statistics() const
+		{
+			ScopedLock lock(this->_lock);
+			return this->_stats;
+		}
+
+		void I2CSimulator::resetStatistics()
+		{
+			ScopedLock lock(this->_lock);
+			this->_stats = Statistics();
+		}
+
+		uint64_t I2CSimulator::duration(size_t bytes) const
+		{
+			return this->bits(CONDITION_BITS + BYTE_BITS * (bytes + 1));
+		}
+
+		uint64_t I2CSimulator::clock() const
+		{
+			auto now = Clock::now() - this->_epoch;
+
+			if(this->_timing == Timing::Virtual)
+				now += this->_elapsed;
+
+			return now;
+		}
+
+		uint64_t I2CSimulator::bits(uint64_t count) const
+		{
+			return count * NS_PER_SEC / this->_frequency;
+		}
+
+		void I2CSimulator::advance(uint64_t ns)
+		{
+			this->_stats.busy += ns;
+
+			if(this->_timing == Timing::Virtual) {
+				this->_elapsed += ns;
+				return;
+			}
+
+			auto end = Clock::now() + ns;
+
+			while(Clock::now() < end) {
+			}
+		}
+
+		SimulatedI2CDevice *I2CSimulator::find(uint16_t address) const
+		{
+			for(auto device : this->_devices) {
+				if(device->address() == address)
+					return device;
+			}
+
+			return nullptr;
+		}
+
+		bool I2CSimulator::message(SimulatedI2CDevice *device, I2CMessage& msg)
+		{
+			auto read = msg.isRead();
+			size_t length = read ? msg.count() : msg.length();
+			size_t idx;
+
+			this->_stats.messages++;
+			this->advance(this->bits(CONDITION_BITS + BYTE_BITS * (msg.is10Bit() ? 2 : 1)));
+
+			if(device == nullptr) {
+				this->_stats.nacks++;
+				return false;
+			}
+
+			ScopedLock lock(device->_lock);
+
+			if(!device->start(read)) {
+				this->_stats.nacks++;
+				return false;
+			}
+
+			for(idx = 0; idx < length; idx++) {
+				if(read) {
+					msg[idx] = device->read();
+					continue;
+				}
+
+				if(!device->write(msg[idx])) {
+					this->_stats.nacks++;
+					idx++;
+					break;
+				}
+			}
+
+			this->_stats.bytes += idx;
+			this->advance(this->bits(BYTE_BITS * idx));
+
+			if(read)
+				msg.setIndex(idx);
+
+			return idx == length;
+		}
+
+		void I2CSimulator::stop(SimulatedI2CDevice *device)
+		{
+			this->advance(this->bits(CONDITION_BITS));
+
+			if(device == nullptr)
+				return;
+
+			ScopedLock lock(device->_lock);
+			device->stop();
+		}
+
+		ssize_t I2CSimulator::transfer(I2CMessage& msg)
+		{
+			ScopedLock lock(this->_lock);
+			auto device = this->find(msg.address());
+			bool ok;
+
+			this->_stats.transfers++;
+			ok = this->message(device, msg);
+			this->stop(device);
+
+			if(!ok)
+				return -EINVALID;
+
+			return msg.isRead() ? msg.count() : msg.length();
+		}
+
+		ssize_t I2CSimulator::transfer(stl::Vector<I2CMessage>& msgs)
+		{
+			ScopedLock lock(this->_lock);
+			SimulatedI2CDevice *device = nullptr;
+			ssize_t total = 0;
+			bool ok = true;
+
+			this->_stats.transfers++;
+
+			for(auto& msg : msgs) {
+				auto next = this->find(msg.address());
+
+				/* A repeated start to another address ends the transaction of the previous device. */
+				if(device != nullptr && next != device) {
+					ScopedLock guard(device->_lock);
+					device->stop();
+				}
+
+				device = next;
+				ok = this->message(device, msg);
+
+				if(!ok)
+					break;
+
+				total += msg.isRead() ? msg.count() : msg.length();
+
+				if(msg.repstart())
+					continue;
+
+				this->stop(device);
+				device = nullptr;
+			}
+
+			if(!ok) {
+				this->stop(device);
+				return -EINVALID;
+			}
+
+			if(device != nullptr)
+				this->stop(device);
+
+			return total;
+		}
+	}
+}
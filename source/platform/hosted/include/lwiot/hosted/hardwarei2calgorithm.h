@@ -39,6 +39,8 @@ namespace lwiot
 			void write(const uint8_t *bytes, size_t length, bool ack) override;
 			void read(uint8_t *byte, bool ack) override;
 			void read(uint8_t *bytes, size_t length, bool ack) override;
+			void writeBulk(const uint8_t *bytes, size_t length, bool ack) override;
+			void readBulk(uint8_t *bytes, size_t length, bool ack) override;
 			int flush() const override;
 			void reset() override;
 		};
@@ -35,6 +35,9 @@ namespace lwiot
 		void attachIrqHandler(int pin, irq_handler_t handler, IrqEdge edge) override;
 		void detachIrqHandler(int pin) override ;
 
+		void writeMask(uint32_t set, uint32_t clear) override;
+		uint32_t readPort() const override;
+
 	private:
 		std::map<int, bool> _values;
 	};
@@ -0,0 +1,269 @@
+/*
+ * Register level models of I2C devices for the hosted I2C simulator.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/hosted/i2csimulator.h>
+
+namespace lwiot
+{
+	namespace hosted
+	{
+		/**
+		 * @brief BMP280 pressure and temperature sensor.
+		 *
+		 * Calibration data and the default readings are the example of the datasheet, which
+		 * compensate to 25.08 degrees Celsius and 100653 Pa. Conversions take the typical time
+		 * for the oversampling settings in ctrl_meas, in forced as well as in normal mode, and
+		 * the data registers are shadowed while they are burst read.
+		 */
+		class Bmp280Model : public SimulatedI2CDevice {
+		public:
+			explicit Bmp280Model(uint16_t address = 0x77);
+
+			/**
+			 * @brief Set the 20-bit ADC values of the next conversions.
+			 */
+			void setRaw(int32_t pressure, int32_t temperature);
+
+			/**
+			 * @brief Number of conversions that completed.
+			 */
+			uint32_t conversions() const;
+
+		protected:
+			bool start(bool read) override;
+			bool write(uint8_t byte) override;
+			uint8_t read() override;
+			void stop() override;
+
+		private:
+			uint8_t _calibration[24];
+			uint8_t _ctrl;
+			uint8_t _config;
+			uint8_t _pointer;
+			bool _addressed;
+			int32_t _pressure;
+			int32_t _temperature;
+			uint8_t _data[6];
+			uint8_t _shadow[6];
+			uint64_t _started;
+			uint32_t _cycles;
+			uint32_t _conversions;
+
+			void reset();
+			void update(uint64_t now);
+			uint64_t conversionTime() const;
+			uint64_t period() const;
+			uint8_t status(uint64_t now) const;
+			uint8_t registerValue(uint8_t reg) const;
+		};
+
+		/**
+		 * @brief SHT31 humidity and temperature sensor.
+		 *
+		 * Single shot measurements take the maximum conversion time of their repeatability.
+		 * While a measurement runs the sensor does not acknowledge its address, unless the
+		 * command enabled clock stretching, in which case a read stretches the clock until the
+		 * result is ready. Results and the status register are sent with their CRC.
+		 */
+		class Sht31Model : public SimulatedI2CDevice {
+		public:
+			explicit Sht31Model(uint16_t address = 0x44);
+
+			void setTemperature(double celsius);
+			void setHumidity(double percent);
+
+			bool heater() const;
+			uint32_t measurements() const;
+
+		protected:
+			bool start(bool read) override;
+			bool write(uint8_t byte) override;
+			uint8_t read() override;
+			void stop() override;
+
+		private:
+			uint16_t _temperature;
+			uint16_t _humidity;
+			uint16_t _status;
+			uint16_t _command;
+			size_t _received;
+			uint64_t _busy;
+			bool _stretch;
+			uint8_t _output[6];
+			size_t _available;
+			size_t _index;
+			uint32_t _measurements;
+
+			void execute(uint16_t command);
+			void measure(uint64_t duration, bool stretch);
+			void output(uint16_t word, size_t offset);
+		};
+
+		/**
+		 * @brief CCS811 air quality sensor.
+		 *
+		 * The sensor starts in boot mode and runs its application after APP_START. Writes go to
+		 * mailboxes and take effect at the stop condition. In application mode a result is
+		 * produced every period of the drive mode in MEAS_MODE, counted from the moment the
+		 * mode was set, and reading ALG_RESULT_DATA clears DATA_READY until the next one.
+		 */
+		class Ccs811Model : public SimulatedI2CDevice {
+		public:
+			explicit Ccs811Model(uint16_t address = 0x5B);
+
+			/**
+			 * @brief Set the eCO2 (ppm) and TVOC (ppb) values of the next results.
+			 */
+			void setResult(uint16_t eco2, uint16_t tvoc);
+
+			/**
+			 * @brief Set the NTC voltages, which default to the same value, i.e. 25 degrees.
+			 */
+			void setNtc(uint16_t vref, uint16_t vntc);
+
+			bool application() const;
+			uint8_t driveMode() const;
+			uint32_t results() const;
+
+		protected:
+			bool start(bool read) override;
+			bool write(uint8_t byte) override;
+			uint8_t read() override;
+			void stop() override;
+
+		private:
+			bool _app;
+			uint8_t _mode;
+			uint8_t _error;
+			uint64_t _started;
+			uint32_t _produced;
+			uint32_t _consumed;
+			uint16_t _eco2;
+			uint16_t _tvoc;
+			uint16_t _vref;
+			uint16_t _vntc;
+			uint8_t _env[4];
+			uint8_t _thresholds[5];
+
+			uint8_t _mailbox;
+			bool _addressed;
+			bool _reading;
+			uint8_t _input[8];
+			size_t _length;
+			size_t _index;
+
+			void reset();
+			void update(uint64_t now);
+			void execute();
+			uint8_t status() const;
+			uint8_t output(size_t index);
+		};
+
+		/**
+		 * @brief 24C02 EEPROM of 256 bytes.
+		 *
+		 * Page writes wrap around within their 8 byte page and are committed at the stop
+		 * condition, after which the chip does not acknowledge its address for the duration of
+		 * the write cycle. Reads continue from the address pointer and wrap around the array.
+		 */
+		class Eeprom24C02Model : public SimulatedI2CDevice {
+		public:
+			explicit Eeprom24C02Model(uint16_t address = 0x50, uint64_t cycle = DefaultWriteCycle);
+
+			uint8_t peek(uint8_t address) const;
+			uint32_t writeCycles() const;
+
+			static constexpr size_t Size = 256;
+			static constexpr size_t PageSize = 8;
+			static constexpr uint64_t DefaultWriteCycle = 5000000ULL;
+
+		protected:
+			bool start(bool read) override;
+			bool write(uint8_t byte) override;
+			uint8_t read() override;
+			void stop() override;
+
+		private:
+			uint8_t _memory[Size];
+			uint8_t _latch[PageSize];
+			uint8_t _dirty;
+			uint8_t _page;
+			uint8_t _pointer;
+			bool _addressed;
+			uint64_t _cycle;
+			uint64_t _busy;
+			uint32_t _writes;
+		};
+
+		/**
+		 * @brief SSD1306 OLED controller with 128 x 64 pixels of display RAM.
+		 *
+		 * Commands and data are told apart by the control byte at the start of a message, and
+		 * command arguments may be sent in later messages. Data is written to the display RAM
+		 * in horizontal, vertical or page addressing mode, within the column and page windows
+		 * set by COLUMNADDR and PAGEADDR, which makes the cost of partial refreshes visible.
+		 */
+		class Ssd1306Model : public SimulatedI2CDevice {
+		public:
+			explicit Ssd1306Model(uint16_t address = 0x3C);
+
+			bool pixel(int x, int y) const;
+			const uint8_t *ram() const;
+
+			bool on() const;
+			bool inverted() const;
+			uint8_t contrast() const;
+
+			/**
+			 * @brief Number of bytes written to the display RAM.
+			 */
+			uint32_t dataWritten() const;
+			uint32_t commands() const;
+
+			static constexpr int Width = 128;
+			static constexpr int Pages = 8;
+
+		protected:
+			bool start(bool read) override;
+			bool write(uint8_t byte) override;
+			uint8_t read() override;
+
+		private:
+			uint8_t _ram[Width * Pages];
+			bool _control;
+			bool _continuation;
+			bool _data;
+
+			uint8_t _command[8];
+			size_t _received;
+			size_t _expected;
+
+			uint8_t _mode;
+			uint8_t _column;
+			uint8_t _page;
+			uint8_t _columns[2];
+			uint8_t _pages[2];
+
+			bool _on;
+			bool _inverted;
+			uint8_t _contrast;
+			uint32_t _written;
+			uint32_t _commands;
+
+			void command(uint8_t byte);
+			void execute();
+			void store(uint8_t byte);
+		};
+	}
+}
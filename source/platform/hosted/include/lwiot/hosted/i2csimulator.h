@@ -0,0 +1,179 @@
+/*
+ * Hosted I2C bus simulator.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/i2calgorithm.h>
+#include <lwiot/io/i2cmessage.h>
+
+#include <lwiot/kernel/lock.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/stl/linkedlist.h>
+
+namespace lwiot
+{
+	namespace hosted
+	{
+		class I2CSimulator;
+
+		/**
+		 * @brief Model of an I2C slave on an I2CSimulator.
+		 *
+		 * The simulator calls the model for every bus condition, in the order in which they
+		 * appear on the wire: start() for the address byte, write() or read() for each data
+		 * byte and stop() once the transaction ends. A repeated start is a start() without a
+		 * stop() in between.
+		 *
+		 * Models keep their state, such as the register pointer or a pending conversion,
+		 * across transactions like the real chip does. Time comes from now(), which includes
+		 * the time spent on the bus. The simulator holds _lock while it talks to the model, and
+		 * setters of derived models take it too, so that tests can change inputs while another
+		 * thread uses the bus.
+		 */
+		class SimulatedI2CDevice {
+		public:
+			explicit SimulatedI2CDevice(uint16_t address);
+			virtual ~SimulatedI2CDevice();
+
+			SimulatedI2CDevice(const SimulatedI2CDevice&) = delete;
+			SimulatedI2CDevice& operator=(const SimulatedI2CDevice&) = delete;
+
+			uint16_t address() const;
+
+		protected:
+			friend class I2CSimulator;
+
+			/**
+			 * @brief Address phase of a (repeated) start.
+			 * @param read Whether the master reads from the device.
+			 * @return False to NACK the address, as devices do while they are busy.
+			 */
+			virtual bool start(bool read);
+
+			/**
+			 * @brief Data byte written by the master.
+			 * @return False to NACK the byte.
+			 */
+			virtual bool write(uint8_t byte) = 0;
+			virtual uint8_t read() = 0;
+			virtual void stop();
+
+			/**
+			 * @brief Current time of the bus, in nanoseconds.
+			 */
+			uint64_t now() const;
+
+			/**
+			 * @brief Hold SCL low for \p ns nanoseconds, like a device that stretches the clock.
+			 */
+			void stretch(uint64_t ns);
+
+			mutable Lock _lock;
+
+		private:
+			uint16_t _address;
+			I2CSimulator *_bus;
+		};
+
+		/**
+		 * @brief I2C algorithm that runs transfers against simulated devices.
+		 *
+		 * Every transfer costs the time that the bits take on a real bus at frequency(): a bit
+		 * for each start and stop condition, and nine bits (including the ACK) for each address
+		 * and data byte. Clock stretching by a device adds to that. A transfer stops at the
+		 * first NACK and fails with -EINVALID, which is what drivers see when a chip is absent
+		 * or busy.
+		 *
+		 * With Timing::Virtual, transfers return right away and their bus time is added to the
+		 * clock of the devices, on top of the time that passes on the host. This keeps the
+		 * statistics the same from run to run regardless of the load of the host, as long as
+		 * drivers do not poll a busy device. Timing::RealTime busy-waits for the bus time
+		 * instead, so that the host clock matches what a device would see, at the cost of
+		 * repeatable timing.
+		 *
+		 * @code
+		 * auto sim = new lwiot::hosted::I2CSimulator(400000);
+		 * lwiot::hosted::Bmp280Model bmp;
+		 * lwiot::I2CBus bus(sim);
+		 *
+		 * sim->attach(bmp);
+		 * lwiot::Bmp280Sensor sensor(bus);
+		 * sensor.begin();
+		 * printf("Bus time: %llu ns\n", sim->statistics().busy);
+		 * @endcode
+		 */
+		class I2CSimulator : public I2CAlgorithm {
+		public:
+			enum class Timing {
+				Virtual,
+				RealTime
+			};
+
+			struct Statistics {
+				uint64_t transfers; //!< Calls of transfer().
+				uint64_t messages;  //!< Messages, each with its own (repeated) start.
+				uint64_t bytes;     //!< Data bytes, excluding addresses.
+				uint64_t nacks;     //!< Addresses and data bytes that were not acknowledged.
+				uint64_t busy;      //!< Time the bus was in use, in nanoseconds.
+			};
+
+			explicit I2CSimulator(uint32_t frequency = DefaultFrequency, Timing timing = Timing::Virtual);
+			~I2CSimulator() override;
+
+			I2CSimulator(const I2CSimulator&) = delete;
+			I2CSimulator& operator=(const I2CSimulator&) = delete;
+
+			/**
+			 * @brief Connect \p device to the bus.
+			 * @note The device must stay alive while it is attached.
+			 */
+			void attach(SimulatedI2CDevice& device);
+			void detach(SimulatedI2CDevice& device);
+
+			/**
+			 * @brief Current time of the bus, in nanoseconds since it was created.
+			 */
+			uint64_t now() const;
+
+			Statistics statistics() const;
+			void resetStatistics();
+
+			/**
+			 * @brief Bus time of a single message of \p bytes data bytes, including its start
+			 *        and address byte, but not the stop.
+			 */
+			uint64_t duration(size_t bytes) const;
+
+			ssize_t transfer(I2CMessage& msg) override;
+			ssize_t transfer(stl::Vector<I2CMessage>& msgs) override;
+
+			static constexpr uint32_t DefaultFrequency = 100000UL;
+
+		private:
+			friend class SimulatedI2CDevice;
+
+			Timing _timing;
+			uint64_t _epoch;
+			uint64_t _elapsed;
+			Statistics _stats;
+			mutable Lock _lock;
+			stl::LinkedList<SimulatedI2CDevice*> _devices;
+
+			uint64_t clock() const;
+			uint64_t bits(uint64_t count) const;
+			void advance(uint64_t ns);
+			SimulatedI2CDevice *find(uint16_t address) const;
+			bool message(SimulatedI2CDevice *device, I2CMessage& msg);
+			void stop(SimulatedI2CDevice *device);
+		};
+	}
+}
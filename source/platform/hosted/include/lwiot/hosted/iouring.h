@@ -0,0 +1,181 @@
+/*
+ * Completion based socket and file I/O on Linux io_uring.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/function.h>
+#include <lwiot/uniquepointer.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/network/stdnet.h>
+#include <lwiot/util/poolallocator.h>
+
+#ifndef CONFIG_IO_URING_ENTRIES
+#define CONFIG_IO_URING_ENTRIES 256
+#endif
+
+struct io_uring_sqe;
+
+namespace lwiot
+{
+	class File;
+	class TcpClient;
+	class SocketTcpClient;
+	class SocketTcpServer;
+
+	namespace hosted
+	{
+		/**
+		 * @brief Submit socket and file I/O to an io_uring and call a handler when it completes.
+		 *
+		 * Where EventLoop waits for readiness and leaves the I/O to the handlers, the ring does
+		 * the I/O itself: a single io_uring_enter() submits all operations queued since the last
+		 * poll() and collects the completions of earlier ones, so the number of system calls no
+		 * longer grows with the number of sockets.
+		 *
+		 * Receive buffers may come from a memory region registered with registerBuffers(), such
+		 * as a BlockPool. Reads into that region use the fixed buffer operations, which saves
+		 * the kernel mapping the pages on every read.
+		 *
+		 * Operations can be queued from any thread. Handlers run on the thread calling poll(),
+		 * with the number of bytes transferred or a negative errno value; -ECANCELED after
+		 * cancel() and -ETIME for an expired timeout. The buffers and sockets of an operation
+		 * must stay valid until its handler was called.
+		 *
+		 * @code
+		 * lwiot::BlockPool<2048, 64> pool;
+		 * lwiot::hosted::IoUring ring;
+		 *
+		 * ring.registerBuffers(pool);
+		 * auto buffer = pool.allocate();
+		 *
+		 * ring.recv(client.handle(), buffer, 2048, [&](ssize_t bytes) {
+		 *	process(buffer, bytes);
+		 *	pool.deallocate(buffer);
+		 * });
+		 *
+		 * ring.run();
+		 * @endcode
+		 */
+		class IoUring {
+		public:
+			typedef Function<void(ssize_t result)> Handler;
+			typedef Function<void(UniquePointer<TcpClient>& client)> AcceptHandler;
+
+			explicit IoUring(unsigned entries = CONFIG_IO_URING_ENTRIES, int interval = 100);
+			virtual ~IoUring();
+
+			IoUring(const IoUring&) = delete;
+			IoUring& operator=(const IoUring&) = delete;
+
+			/**
+			 * @brief Check whether the kernel provides io_uring; it may be disabled or filtered.
+			 */
+			bool valid() const;
+
+			/**
+			 * @brief Register \p length bytes at \p base for fixed buffer reads.
+			 * @note Only a single region can be registered; it must outlive the ring.
+			 */
+			bool registerBuffers(void *base, size_t length);
+
+			template <size_t BlockSize, size_t Blocks>
+			bool registerBuffers(BlockPool<BlockSize, Blocks>& pool)
+			{
+				return this->registerBuffers(pool.data(), pool.size());
+			}
+
+			bool recv(socket_t* socket, void *buffer, size_t length, const Handler& handler);
+			bool send(socket_t* socket, const void *data, size_t length, const Handler& handler);
+
+			/**
+			 * @brief Accept a single connection on \p server.
+			 *
+			 * The handler gets a null pointer when accepting failed. Queue the next accept() from
+			 * the handler to keep accepting.
+			 */
+			bool accept(SocketTcpServer& server, const AcceptHandler& handler);
+
+			/**
+			 * @brief Read up to \p length bytes at \p offset of \p file.
+			 * @note Reads bypass the buffer of the file; flush() buffered writes first.
+			 */
+			bool read(File& file, size_t offset, void *buffer, size_t length, const Handler& handler);
+
+			/**
+			 * @brief Call \p handler with -ETIME after \p ms milliseconds.
+			 */
+			bool timeout(int ms, const Handler& handler);
+
+			/**
+			 * @brief Cancel all operations on \p socket, e.g. before it is closed.
+			 *
+			 * Closing a socket does not end the operations on it, as the ring holds its own
+			 * reference. The handlers are still called, with -ECANCELED.
+			 */
+			bool cancel(socket_t* socket);
+
+			/**
+			 * @brief Number of operations that were queued and did not complete yet.
+			 */
+			size_t pending() const;
+
+			/**
+			 * @brief Submit queued operations, wait for completions and call their handlers.
+			 * @param tmo Timeout in milliseconds, FOREVER to wait for the first completion.
+			 * @return The number of handlers called, or a negative error code.
+			 */
+			int poll(int tmo = FOREVER);
+
+			/**
+			 * @brief Poll until stop() is called.
+			 * @note Waits at most \p interval milliseconds at a time, which bounds the delay of stop().
+			 */
+			void run();
+			void stop();
+
+		private:
+			struct Operation;
+
+			struct Queue {
+				unsigned *head;
+				unsigned *tail;
+				unsigned *mask;
+				unsigned *array;
+				void *entries;
+			};
+
+			int _fd;
+			void *_ring;
+			size_t _ringSize;
+			void *_sqes;
+			size_t _sqesSize;
+			Queue _sq;
+			Queue _cq;
+			unsigned _entries;
+			unsigned _queued;
+			uint8_t *_region;
+			size_t _regionSize;
+
+			mutable Lock _lock;
+			Operation *_operations;
+			size_t _pending;
+			AtomicBool _running;
+			int _interval;
+
+			bool push(io_uring_sqe& sqe, Operation *op);
+			bool fixed(const void *buffer, size_t length) const;
+			void complete(Operation *op, int result);
+			int enter(unsigned submit, unsigned wait, int tmo);
+		};
+	}
+}
@@ -0,0 +1,133 @@
+/*
+ * Hosted XBee mesh simulator.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/function.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/ringbufferstream.h>
+
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+
+#include <lwiot/stl/linkedlist.h>
+
+namespace lwiot
+{
+	namespace hosted
+	{
+		/**
+		 * @brief Serial stream of a simulated XBee coordinator and its mesh.
+		 *
+		 * Frames written to the stream are handled like an XBee in API mode 2 would: AT commands
+		 * are answered right away, and transmit requests are answered with a transmit status
+		 * after the round trip time of the mesh. Frames that are lost fail with a network ACK
+		 * failure, and transmissions without a 16-bit address take another round trip for
+		 * address discovery. Remote nodes echo the frames they receive, if configured to.
+		 *
+		 * While started, the simulated nodes send RX frames to the coordinator at a fixed rate.
+		 * The payload of these frames starts with the Clock::now() time at which the frame was
+		 * generated, in host byte order, followed by the 32-bit sequence number of the frame.
+		 *
+		 * The output is limited to the configured serial throughput. It is read from the stream,
+		 * or pushed to a receiver such as AsyncXbee::receive(), like a UART driver would.
+		 */
+		class XBeeSimulator : public RingBufferStream {
+		public:
+			struct Config {
+				size_t nodes;      //!< Number of remote nodes.
+				double rate;       //!< RX frames per second, per node.
+				size_t payload;    //!< Size of the RX payload; at least 12 bytes.
+				time_t latency;    //!< One way latency through the mesh, in milliseconds.
+				double loss;       //!< Probability that a frame is lost.
+				size_t throughput; //!< Serial throughput in bytes per second, or 0 for no limit.
+				bool echo;         //!< Nodes send every frame they receive back.
+			};
+
+			struct Statistics {
+				uint64_t generated;   //!< RX frames sent to the coordinator.
+				uint64_t lost;        //!< RX frames lost in the mesh.
+				uint64_t transmitted; //!< Transmit requests written by the host.
+				uint64_t failed;      //!< Transmit requests that were lost in the mesh.
+				uint64_t bytes;       //!< Bytes sent to the host.
+			};
+
+			typedef Function<void(const uint8_t *data, size_t length)> Receiver;
+
+			explicit XBeeSimulator(const Config& config, size_t capacity = 65536);
+			~XBeeSimulator() override;
+
+			XBeeSimulator(const XBeeSimulator&) = delete;
+			XBeeSimulator& operator=(const XBeeSimulator&) = delete;
+
+			/**
+			 * @brief Push output to \p receiver instead of buffering it for read().
+			 * @note Set the receiver before the host writes its first frame.
+			 */
+			void setReceiver(const Receiver& receiver);
+
+			/**
+			 * @brief Start sending RX frames from the remote nodes.
+			 */
+			void start();
+			void stop();
+
+			Statistics statistics() const;
+
+			/**
+			 * @brief 64-bit address of remote node \p node, counting from 0.
+			 */
+			static uint64_t address(size_t node);
+
+			bool write(uint8_t byte) override;
+			ssize_t write(const void *bytes, const size_t& length) override;
+			using Stream::write;
+
+		private:
+			struct Pending {
+				uint64_t due;
+				ByteBuffer frame;
+			};
+
+			Config _config;
+			Receiver _receiver;
+			mutable Lock _lock;
+			FunctionalThread _thread;
+			Atomic<bool> _running;
+			volatile bool _generating;
+
+			stl::LinkedList<Pending> _pending;
+			Statistics _stats;
+			uint64_t _next;
+			uint64_t _tokens;
+			uint64_t _refilled;
+			uint32_t _sequence;
+			size_t _node;
+			uint32_t _random;
+
+			ByteBuffer _input;
+			size_t _length;
+			bool _escape;
+
+			void run();
+			void generate(uint64_t now);
+			bool emit(const ByteBuffer& frame);
+			void refill(uint64_t now);
+			void parse(uint8_t byte);
+			void handle(const uint8_t *frame, size_t length);
+			void command(const uint8_t *frame, size_t length);
+			void transmit(const uint8_t *frame, size_t length, size_t offset);
+			void schedule(ByteBuffer&& frame, uint64_t due);
+			bool lose();
+		};
+	}
+}
@@ -0,0 +1,454 @@
+/*
+ * Completion based socket and file I/O on Linux io_uring.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <lwiot.h>
+
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include <lwiot/error.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/io/file.h>
+#include <lwiot/network/tcpclient.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+#include <lwiot/hosted/iouring.h>
+
+namespace lwiot
+{
+	namespace hosted
+	{
+		struct IoUring::Operation {
+			Operation *prev;
+			Operation *next;
+			Handler handler;
+			AcceptHandler accept;
+			__kernel_timespec timeout;
+		};
+
+		/* The ring buffers are shared with the kernel, which reads and writes them concurrently. */
+		static inline unsigned load_acquire(const unsigned *ptr)
+		{
+			return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+		}
+
+		static inline void store_release(unsigned *ptr, unsigned value)
+		{
+			__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+		}
+
+		IoUring::IoUring(unsigned entries, int interval) : _fd(-1), _ring(MAP_FAILED), _ringSize(0),
+			_sqes(MAP_FAILED), _sqesSize(0), _sq(), _cq(), _entries(0), _queued(0), _region(nullptr),
+			_regionSize(0), _lock(false), _operations(nullptr), _pending(0), _running(false), _interval(interval)
+		{
+			io_uring_params params;
+			uint8_t *ring;
+
+			memset(&params, 0, sizeof(params));
+			this->_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+
+			if(this->_fd < 0)
+				return;
+
+			/* Timed waits need the extended arguments of io_uring_enter(), Linux 5.11. */
+			if((params.features & IORING_FEAT_SINGLE_MMAP) == 0 || (params.features & IORING_FEAT_EXT_ARG) == 0) {
+				close(this->_fd);
+				this->_fd = -1;
+				return;
+			}
+
+			this->_ringSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+
+			if(params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe) > this->_ringSize)
+				this->_ringSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+			this->_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+			this->_ring = mmap(nullptr, this->_ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+				this->_fd, IORING_OFF_SQ_RING);
+			this->_sqes = mmap(nullptr, this->_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+				this->_fd, IORING_OFF_SQES);
+
+			if(this->_ring == MAP_FAILED || this->_sqes == MAP_FAILED) {
+				print_dbg("Unable to map io_uring: %s\n", strerror(errno));
+				return;
+			}
+
+			ring = static_cast<uint8_t*>(this->_ring);
+			this->_entries = params.sq_entries;
+
+			this->_sq.head = reinterpret_cast<unsigned*>(ring + params.sq_off.head);
+			this->_sq.tail = reinterpret_cast<unsigned*>(ring + params.sq_off.tail);
+			this->_sq.mask = reinterpret_cast<unsigned*>(ring + params.sq_off.ring_mask);
+			this->_sq.array = reinterpret_cast<unsigned*>(ring + params.sq_off.array);
+			this->_sq.entries = this->_sqes;
+
+			this->_cq.head = reinterpret_cast<unsigned*>(ring + params.cq_off.head);
+			this->_cq.tail = reinterpret_cast<unsigned*>(ring + params.cq_off.tail);
+			this->_cq.mask = reinterpret_cast<unsigned*>(ring + params.cq_off.ring_mask);
+			this->_cq.array = nullptr;
+			this->_cq.entries = ring + params.cq_off.cqes;
+		}
+
+		IoUring::~IoUring()
+		{
+			Operation *next;
+
+			/* Closing the ring cancels whatever is still in flight, without completions. */
+			if(this->_ring != MAP_FAILED)
+				munmap(this->_ring, this->_ringSize);
+
+			if(this->_sqes != MAP_FAILED)
+				munmap(this->_sqes, this->_sqesSize);
+
+			if(this->_fd >= 0)
+				close(this->_fd);
+
+			for(auto op = this->_operations; op != nullptr; op = next) {
+				next = op->next;
+				delete op;
+			}
+		}
+
+		bool IoUring::valid() const
+		{
+			return this->_fd >= 0 && this->_ring != MAP_FAILED && this->_sqes != MAP_FAILED;
+		}
+
+		bool IoUring::registerBuffers(void *base, size_t length)
+		{
+			iovec region;
+
+			if(!this->valid() || base == nullptr || length == 0 || this->_region != nullptr)
+				return false;
+
+			region.iov_base = base;
+			region.iov_len = length;
+
+			if(syscall(__NR_io_uring_register, this->_fd, IORING_REGISTER_BUFFERS, &region, 1) < 0) {
+				print_dbg("Unable to register io_uring buffers: %s\n", strerror(errno));
+				return false;
+			}
+
+			this->_region = static_cast<uint8_t*>(base);
+			this->_regionSize = length;
+
+			return true;
+		}
+
+		bool IoUring::fixed(const void *buffer, size_t length) const
+		{
+			auto ptr = static_cast<const uint8_t*>(buffer);
+
+			return this->_region != nullptr && ptr >= this->_region && ptr + length <= this->_region + this->_regionSize;
+		}
+
+		int IoUring::enter(unsigned submit, unsigned wait, int tmo)
+		{
+			io_uring_getevents_arg arg;
+			__kernel_timespec ts;
+			unsigned flags;
+			long rv;
+
+			memset(&arg, 0, sizeof(arg));
+			flags = wait > 0 ? IORING_ENTER_GETEVENTS : 0;
+
+			if(wait > 0 && tmo != FOREVER) {
+				ts.tv_sec = tmo / 1000;
+				ts.tv_nsec = (tmo % 1000) * 1000000L;
+				arg.ts = reinterpret_cast<uint64_t>(&ts);
+				flags |= IORING_ENTER_EXT_ARG;
+			}
+
+			rv = syscall(__NR_io_uring_enter, this->_fd, submit, wait, flags,
+				(flags & IORING_ENTER_EXT_ARG) ? &arg : nullptr, sizeof(arg));
+
+			return rv < 0 ? -errno : static_cast<int>(rv);
+		}
+
+		bool IoUring::push(io_uring_sqe& sqe, Operation *op)
+		{
+			ScopedLock lock(this->_lock);
+			unsigned tail, index;
+
+			if(!this->valid()) {
+				delete op;
+				return false;
+			}
+
+			tail = *this->_sq.tail;
+
+			/* Hand the queue to the kernel when it is full; it is only submitted by poll() otherwise. */
+			if(tail - load_acquire(this->_sq.head) >= this->_entries) {
+				auto submitted = this->enter(this->_queued, 0, FOREVER);
+
+				if(submitted > 0)
+					this->_queued -= static_cast<unsigned>(submitted);
+
+				if(tail - load_acquire(this->_sq.head) >= this->_entries) {
+					delete op;
+					return false;
+				}
+			}
+
+			sqe.user_data = reinterpret_cast<uint64_t>(op);
+			index = tail & *this->_sq.mask;
+			memcpy(static_cast<io_uring_sqe*>(this->_sq.entries) + index, &sqe, sizeof(sqe));
+			this->_sq.array[index] = index;
+			store_release(this->_sq.tail, tail + 1);
+			this->_queued++;
+
+			op->prev = nullptr;
+			op->next = this->_operations;
+
+			if(this->_operations != nullptr)
+				this->_operations->prev = op;
+
+			this->_operations = op;
+			this->_pending++;
+
+			return true;
+		}
+
+		bool IoUring::recv(socket_t *socket, void *buffer, size_t length, const Handler& handler)
+		{
+			io_uring_sqe sqe;
+
+			if(socket == nullptr || buffer == nullptr)
+				return false;
+
+			memset(&sqe, 0, sizeof(sqe));
+			sqe.fd = *socket;
+			sqe.addr = reinterpret_cast<uint64_t>(buffer);
+			sqe.len = static_cast<uint32_t>(length);
+
+			/* A read of a socket is a receive without flags, and only reads take fixed buffers. */
+			if(this->fixed(buffer, length)) {
+				sqe.opcode = IORING_OP_READ_FIXED;
+				sqe.buf_index = 0;
+				sqe.off = static_cast<uint64_t>(-1);
+			} else {
+				sqe.opcode = IORING_OP_RECV;
+			}
+
+			auto op = new Operation();
+			op->handler = handler;
+
+			return this->push(sqe, op);
+		}
+
+		bool IoUring::send(socket_t *socket, const void *data, size_t length, const Handler& handler)
+		{
+			io_uring_sqe sqe;
+
+			if(socket == nullptr || data == nullptr)
+				return false;
+
+			memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = IORING_OP_SEND;
+			sqe.fd = *socket;
+			sqe.addr = reinterpret_cast<uint64_t>(data);
+			sqe.len = static_cast<uint32_t>(length);
+			sqe.msg_flags = MSG_NOSIGNAL;
+
+			auto op = new Operation();
+			op->handler = handler;
+
+			return this->push(sqe, op);
+		}
+
+		bool IoUring::accept(SocketTcpServer& server, const AcceptHandler& handler)
+		{
+			io_uring_sqe sqe;
+
+			if(server.handle() == nullptr || !handler)
+				return false;
+
+			memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = IORING_OP_ACCEPT;
+			sqe.fd = *server.handle();
+
+			auto op = new Operation();
+			op->accept = handler;
+
+			return this->push(sqe, op);
+		}
+
+		bool IoUring::read(File& file, size_t offset, void *buffer, size_t length, const Handler& handler)
+		{
+			io_uring_sqe sqe;
+			int fd;
+
+			fd = file.descriptor();
+
+			if(fd < 0 || buffer == nullptr)
+				return false;
+
+			memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = this->fixed(buffer, length) ? IORING_OP_READ_FIXED : IORING_OP_READ;
+			sqe.fd = fd;
+			sqe.off = offset;
+			sqe.addr = reinterpret_cast<uint64_t>(buffer);
+			sqe.len = static_cast<uint32_t>(length);
+
+			auto op = new Operation();
+			op->handler = handler;
+
+			return this->push(sqe, op);
+		}
+
+		bool IoUring::timeout(int ms, const Handler& handler)
+		{
+			io_uring_sqe sqe;
+
+			if(ms < 0)
+				return false;
+
+			auto op = new Operation();
+			op->handler = handler;
+			op->timeout.tv_sec = ms / 1000;
+			op->timeout.tv_nsec = (ms % 1000) * 1000000L;
+
+			memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = IORING_OP_TIMEOUT;
+			sqe.fd = -1;
+			sqe.addr = reinterpret_cast<uint64_t>(&op->timeout);
+			sqe.len = 1;
+
+			return this->push(sqe, op);
+		}
+
+		bool IoUring::cancel(socket_t *socket)
+		{
+			io_uring_sqe sqe;
+
+			if(socket == nullptr)
+				return false;
+
+			memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = IORING_OP_ASYNC_CANCEL;
+			sqe.fd = *socket;
+			sqe.cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+
+			return this->push(sqe, new Operation());
+		}
+
+		size_t IoUring::pending() const
+		{
+			ScopedLock lock(this->_lock);
+			return this->_pending;
+		}
+
+		void IoUring::complete(Operation *op, int result)
+		{
+			this->_lock.lock();
+
+			if(op->prev != nullptr)
+				op->prev->next = op->next;
+			else
+				this->_operations = op->next;
+
+			if(op->next != nullptr)
+				op->next->prev = op->prev;
+
+			this->_pending--;
+			this->_lock.unlock();
+
+			if(op->accept) {
+				UniquePointer<TcpClient> client;
+
+				if(result >= 0) {
+					auto raw = static_cast<socket_t*>(lwiot_mem_zalloc(sizeof(socket_t)));
+
+					*raw = result;
+					client.reset(new SocketTcpClient(raw));
+				}
+
+				op->accept(client);
+			} else if(op->handler) {
+				op->handler(result);
+			}
+
+			delete op;
+		}
+
+		int IoUring::poll(int tmo)
+		{
+			unsigned submit, head, tail;
+			io_uring_cqe *cqe;
+			int rv, called;
+
+			if(!this->valid())
+				return -EINVALID;
+
+			this->_lock.lock();
+			submit = this->_queued;
+			this->_queued = 0;
+			auto idle = this->_pending == 0;
+			this->_lock.unlock();
+
+			if(idle) {
+				lwiot_sleep(tmo == FOREVER ? this->_interval : (tmo < 0 ? 0 : tmo));
+				return 0;
+			}
+
+			/* One system call submits everything queued and waits for the first completion. */
+			rv = this->enter(submit, tmo < 0 ? 0 : 1, tmo);
+
+			if(rv < 0 && rv != -ETIME && rv != -EINTR && rv != -EBUSY)
+				return -EINVALID;
+
+			/* The kernel may take fewer entries when its completion queue is full. */
+			if(rv >= 0 && static_cast<unsigned>(rv) < submit) {
+				ScopedLock lock(this->_lock);
+				this->_queued += submit - static_cast<unsigned>(rv);
+			}
+
+			called = 0;
+			head = *this->_cq.head;
+			tail = load_acquire(this->_cq.tail);
+
+			/* Release every entry before its handler runs, which may queue new operations. */
+			while(head != tail) {
+				cqe = static_cast<io_uring_cqe*>(this->_cq.entries) + (head & *this->_cq.mask);
+
+				auto op = reinterpret_cast<Operation*>(cqe->user_data);
+				auto result = cqe->res;
+
+				store_release(this->_cq.head, ++head);
+				this->complete(op, result);
+				called++;
+
+				if(head == tail)
+					tail = load_acquire(this->_cq.tail);
+			}
+
+			return called;
+		}
+
+		void IoUring::run()
+		{
+			this->_running = true;
+
+			while(this->_running)
+				this->poll(this->_interval);
+		}
+
+		void IoUring::stop()
+		{
+			this->_running = false;
+		}
+	}
+}
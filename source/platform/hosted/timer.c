@@ -17,11 +17,20 @@
 #include <lwiot.h>
 
 #include <lwiot/error.h>
-#include <lwiot/util/list.h>
 #include <lwiot/log.h>
 
-static struct list_head timers = STATIC_INIT_LIST_HEAD(timers);
+#define TIMER_HEAP_INITIAL_SIZE 16
+
+/*
+ * Running timers are kept in a binary min-heap, ordered on their expiry time. The timer thread
+ * sleeps until the first timer expires, or until it is woken up because the first expiry changed.
+ */
+static lwiot_timer_t **timers;
+static size_t timers_size;
+static size_t timers_capacity;
+
 static lwiot_mutex_t *timer_lock;
+static lwiot_event_t *timer_event;
 static lwiot_thread_t *timer_thread;
 static volatile bool running;
 
@@ -35,11 +44,154 @@ static inline void timers_unlock(void)
 	lwiot_mutex_unlock(timer_lock);
 }
 
+static inline void timers_swap(size_t a, size_t b)
+{
+	lwiot_timer_t *tmp;
+
+	tmp = timers[a];
+	timers[a] = timers[b];
+	timers[b] = tmp;
+
+	timers[a]->index = a;
+	timers[b]->index = b;
+}
+
+static void timers_sift_up(size_t idx)
+{
+	size_t parent;
+
+	while(idx > 0) {
+		parent = (idx - 1) / 2;
+
+		if(timers[parent]->expiry <= timers[idx]->expiry)
+			break;
+
+		timers_swap(parent, idx);
+		idx = parent;
+	}
+}
+
+static void timers_sift_down(size_t idx)
+{
+	size_t child, smallest;
+
+	while(true) {
+		smallest = idx;
+		child = idx * 2 + 1;
+
+		if(child < timers_size && timers[child]->expiry < timers[smallest]->expiry)
+			smallest = child;
+
+		child++;
+		if(child < timers_size && timers[child]->expiry < timers[smallest]->expiry)
+			smallest = child;
+
+		if(smallest == idx)
+			break;
+
+		timers_swap(idx, smallest);
+		idx = smallest;
+	}
+}
+
+/* Restore the heap property after the expiry of the timer at `idx' has changed. */
+static inline void timers_update(size_t idx)
+{
+	timers_sift_up(idx);
+	timers_sift_down(idx);
+}
+
+static void timers_push(lwiot_timer_t *timer)
+{
+	size_t size;
+
+	if(timers_size == timers_capacity) {
+		size = timers_capacity ? timers_capacity * 2 : TIMER_HEAP_INITIAL_SIZE;
+		timers = lwiot_mem_realloc(timers, size * sizeof(*timers));
+		assert(timers);
+		timers_capacity = size;
+	}
+
+	timer->index = timers_size;
+	timers[timers_size++] = timer;
+	timers_sift_up(timer->index);
+}
+
+static void timers_remove(lwiot_timer_t *timer)
+{
+	size_t idx, last;
+
+	idx = timer->index;
+	last = --timers_size;
+
+	if(idx != last) {
+		timers_swap(idx, last);
+		timers_update(idx);
+	}
+}
+
+/* Wake up the timer thread if `timer' is the first timer to expire. */
+static inline void timers_notify(lwiot_timer_t *timer)
+{
+	if(timers_size > 0 && timers[0] == timer)
+		lwiot_event_signal(timer_event);
+}
+
+static int timers_next_timeout(time_t now)
+{
+	time_t diff;
+
+	if(timers_size == 0)
+		return FOREVER;
+
+	if(timers[0]->expiry <= now)
+		return -1;
+
+	/* Round up: waking up early only results in another wait. */
+	diff = (timers[0]->expiry - now + 999) / 1000;
+	return diff > INT32_MAX ? INT32_MAX : (int) diff;
+}
+
+static void timer_reschedule(lwiot_timer_t *timer, time_t now)
+{
+	time_t missed;
+
+	if(!(timer->flags & TIMER_PERIODIC_FLAG)) {
+		timer->expiry = now + timer->tmo;
+		return;
+	}
+
+	/* A zero period has nothing to catch up on: keep it due. */
+	if(timer->tmo == 0) {
+		timer->expiry = now;
+		return;
+	}
+
+	missed = (now - timer->expiry) / timer->tmo;
+
+	switch(timer->flags & TIMER_CATCHUP_MASK) {
+	case TIMER_CATCHUP_BURST:
+		timer->expiry += timer->tmo;
+		break;
+
+	case TIMER_CATCHUP_COALESCE:
+		if(missed > 0)
+			timer->expiry = now + timer->tmo;
+		else
+			timer->expiry += timer->tmo;
+		break;
+
+	default:
+		timer->expiry += (missed + 1) * timer->tmo;
+		break;
+	}
+}
+
 static void timer_thread_handle(void *arg)
 {
-	struct list_head *entry, *tmp;
 	lwiot_timer_t *timer;
 	time_t now;
+	int tmo;
 
 	UNUSED(arg);
 
@@ -52,24 +204,26 @@ static void timer_thread_handle(void *arg)
 		}
 
 		now = lwiot_tick();
-		list_for_each_safe(entry, tmp, &timers) {
-			timer = list_entry(entry, struct timer, entry);
-			if(now >= timer->expiry) {
-				timers_unlock();
-				timer->handle(timer, timer->arg);
-				timers_lock();
-
-				if(timer->state == TIMER_RUNNING && timer->oneshot) {
-					list_del(entry);
-					timer->state = TIMER_STOPPED;
-				} else {
-					timer->expiry = now + timer->tmo;
-				}
-			}
+		tmo = timers_next_timeout(now);
+
+		if(tmo >= 0) {
+			timers_unlock();
+			lwiot_event_wait(timer_event, tmo);
+			continue;
 		}
-		timers_unlock();
 
-		lwiot_sleep(1);
+		timer = timers[0];
+
+		if(timer->oneshot) {
+			timers_remove(timer);
+			timer->state = TIMER_STOPPED;
+		} else {
+			timer_reschedule(timer, now);
+			timers_sift_down(0);
+		}
+
+		timers_unlock();
+		timer->handle(timer, timer->arg);
 	}
 }
 
@@ -78,6 +232,8 @@ void lwiot_timers_init(void)
 	const char *tmp = "timer-thread";
 
 	timer_lock = lwiot_mutex_create(0);
+	timer_event = lwiot_event_create(1);
+
 	timers_lock();
 	running = true;
 	timers_unlock();
@@ -90,8 +246,16 @@ void lwiot_timers_destroy(void)
 	timers_lock();
 	running = false;
 	timers_unlock();
+
+	lwiot_event_signal(timer_event);
 	lwiot_thread_destroy(timer_thread);
+	lwiot_event_destroy(timer_event);
 	lwiot_mutex_destroy(timer_lock);
+
+	lwiot_mem_free(timers);
+	timers = NULL;
+	timers_size = 0;
+	timers_capacity = 0;
 }
 
 lwiot_timer_t* lwiot_timer_create(const char *name, int ms, uint32_t flags, void *arg, void (*cb)(lwiot_timer_t *timer, void *arg))
@@ -104,13 +268,14 @@ lwiot_timer_t* lwiot_timer_create(const char *name, int ms, uint32_t flags, void
 	timer->handle = cb;
 	timer->tmo = ms * 1000U;
 	timer->arg = arg;
+	timer->flags = flags;
 
 	if(flags & TIMER_ONSHOT_FLAG)
 		timer->oneshot = true;
 	else
 		timer->oneshot = false;
 
-	list_head_init(&timer->entry);
+	timer->index = 0;
 	timer->state = TIMER_CREATED;
 
 	return timer;
@@ -118,29 +283,35 @@ lwiot_timer_t* lwiot_timer_create(const char *name, int ms, uint32_t flags, void
 
 void lwiot_timer_reset(lwiot_timer_t* timer)
 {
-	if(timer->state != TIMER_RUNNING) {
-		lwiot_timer_start(timer);
-		return;
-	}
-
 	/*
 	 * Lock the global timer lock, as we are updating an
 	 * active timer.
 	 */
 	timers_lock();
+	if(timer->state != TIMER_RUNNING) {
+		timers_unlock();
+		lwiot_timer_start(timer);
+		return;
+	}
+
 	timer->expiry = lwiot_tick() + timer->tmo;
+	timers_update(timer->index);
+	timers_notify(timer);
 	timers_unlock();
 }
 
 int lwiot_timer_start(lwiot_timer_t *timer)
 {
-	if(timer->state == TIMER_RUNNING)
+	timers_lock();
+	if(timer->state == TIMER_RUNNING) {
+		timers_unlock();
 		return -EINVALID;
+	}
 
-	timers_lock();
 	timer->expiry = lwiot_tick() + timer->tmo;
 	timer->state = TIMER_RUNNING;
-	list_add(&timer->entry, &timers);
+	timers_push(timer);
+	timers_notify(timer);
 	timers_unlock();
 
 	return -EOK;
@@ -155,7 +326,7 @@ int lwiot_timer_stop(lwiot_timer_t *timer)
 	}
 
 	timer->state = TIMER_STOPPED;
-	list_del(&timer->entry);
+	timers_remove(timer);
 	timers_unlock();
 
 	return -EOK;
@@ -193,5 +364,18 @@ int lwiot_timer_set_period(lwiot_timer_t *timer, int ms)
 
 time_t lwiot_timer_get_expiry(lwiot_timer_t *timer)
 {
-	return timer->expiry /= 1000U;
+	return timer->expiry / 1000U;
+}
+
+time_t lwiot_timers_next_expiry(void)
+{
+	time_t expiry = 0;
+
+	timers_lock();
+
+	if(timers_size > 0)
+		expiry = timers[0]->expiry;
+
+	timers_unlock();
+	return expiry;
 }
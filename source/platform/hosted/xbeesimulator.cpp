@@ -0,0 +1,441 @@
+/*
+ * Hosted XBee mesh simulator.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/scopedlock.h>
+#include <lwiot/kernel/uniquelock.h>
+#include <lwiot/kernel/clock.h>
+#include <lwiot/network/xbee/constants.h>
+#include <lwiot/hosted/xbeesimulator.h>
+
+#define NS_PER_MS 1000000ULL
+#define NS_PER_SEC 1000000000ULL
+
+#define NODE_ADDRESS 0x0013A20041000000ULL
+#define BROADCAST_ADDRESS64 0xFFFFFFFFFFFFFFFFULL
+#define UNKNOWN_ADDRESS 0xFFFE
+
+#define AT_COMMAND_REQUEST 0x08
+#define MAX_PAYLOAD 84
+#define STAMP_SIZE 12
+
+namespace lwiot
+{
+	namespace hosted
+	{
+		static void write64(ByteBuffer& buffer, uint64_t value)
+		{
+			for(int idx = 7; idx >= 0; idx--)
+				buffer.write(static_cast<uint8_t>(value >> (idx * 8)));
+		}
+
+		static void write16(ByteBuffer& buffer, uint16_t value)
+		{
+			buffer.write(static_cast<uint8_t>(value >> 8));
+			buffer.write(static_cast<uint8_t>(value));
+		}
+
+		static uint64_t read64(const uint8_t *data)
+		{
+			uint64_t value = 0;
+
+			for(int idx = 0; idx < 8; idx++)
+				value = (value << 8) | data[idx];
+
+			return value;
+		}
+
+		XBeeSimulator::XBeeSimulator(const Config& config, size_t capacity) : RingBufferStream(capacity),
+			_config(config), _lock(false), _thread("xbeesim"), _running(true), _generating(false),
+			_stats(), _next(0), _tokens(0), _refilled(Clock::now()), _sequence(0), _node(0),
+			_random(0x2545F491), _input(MAX_FRAME_DATA_SIZE + 4, true), _length(0), _escape(false)
+		{
+			if(this->_config.payload < STAMP_SIZE)
+				this->_config.payload = STAMP_SIZE;
+
+			/* API ID, 64-bit and 16-bit source address and receive options. */
+			if(this->_config.payload > MAX_FRAME_DATA_SIZE - 12)
+				this->_config.payload = MAX_FRAME_DATA_SIZE - 12;
+
+			this->_thread.start([this]() {
+				this->run();
+			});
+		}
+
+		XBeeSimulator::~XBeeSimulator()
+		{
+			this->_running.store(false);
+			this->_thread.join();
+		}
+
+		void XBeeSimulator::setReceiver(const Receiver& receiver)
+		{
+			ScopedLock lock(this->_lock);
+			this->_receiver = receiver;
+		}
+
+		void XBeeSimulator::start()
+		{
+			ScopedLock lock(this->_lock);
+
+			this->_next = Clock::now();
+			this->_generating = this->_config.nodes > 0 && this->_config.rate > 0;
+		}
+
+		void XBeeSimulator::stop()
+		{
+			ScopedLock lock(this->_lock);
+			this->_generating = false;
+		}
+
+		XBeeSimulator::Statistics XBeeSimulator::statistics() const
+		{
+			ScopedLock lock(this->_lock);
+			return this->_stats;
+		}
+
+		uint64_t XBeeSimulator::address(size_t node)
+		{
+			return NODE_ADDRESS + node + 1;
+		}
+
+		bool XBeeSimulator::write(uint8_t byte)
+		{
+			return this->write(&byte, sizeof(byte)) == sizeof(byte);
+		}
+
+		ssize_t XBeeSimulator::write(const void *bytes, const size_t& length)
+		{
+			auto data = static_cast<const uint8_t *>(bytes);
+			ScopedLock lock(this->_lock);
+
+			for(size_t idx = 0; idx < length; idx++)
+				this->parse(data[idx]);
+
+			return length;
+		}
+
+		void XBeeSimulator::parse(uint8_t byte)
+		{
+			if(byte == START_BYTE) {
+				this->_input.setIndex(0);
+				this->_input.write(byte);
+				this->_escape = false;
+				return;
+			}
+
+			if(this->_input.index() == 0)
+				return;
+
+			if(byte == ESCAPE) {
+				this->_escape = true;
+				return;
+			}
+
+			if(this->_escape) {
+				byte ^= 0x20;
+				this->_escape = false;
+			}
+
+			if(this->_input.index() >= this->_input.count()) {
+				this->_input.setIndex(0);
+				return;
+			}
+
+			this->_input.write(byte);
+
+			auto data = this->_input.data();
+			auto received = this->_input.index();
+
+			if(received == 3)
+				this->_length = (data[1] << 8) | data[2];
+
+			/* Start byte, length, frame data and checksum. */
+			if(received < 3 || received < this->_length + 4)
+				return;
+
+			uint8_t checksum = 0;
+
+			for(size_t idx = 3; idx < received; idx++)
+				checksum += data[idx];
+
+			if(checksum == 0xFF)
+				this->handle(data + 3, this->_length);
+
+			this->_input.setIndex(0);
+		}
+
+		void XBeeSimulator::handle(const uint8_t *frame, size_t length)
+		{
+			if(length < 2)
+				return;
+
+			switch(frame[0]) {
+			case AT_COMMAND_REQUEST:
+				this->command(frame, length);
+				break;
+
+			case ZB_TX_REQUEST:
+				this->transmit(frame, length, 14);
+				break;
+
+			case ZB_EXPLICIT_TX_REQUEST:
+				this->transmit(frame, length, 20);
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		void XBeeSimulator::command(const uint8_t *frame, size_t length)
+		{
+			if(length < 4)
+				return;
+
+			ByteBuffer response(16, true);
+
+			response.write(static_cast<uint8_t>(AT_COMMAND_RESPONSE));
+			response.write(frame[1]);
+			response.write(frame[2]);
+			response.write(frame[3]);
+			response.write(static_cast<uint8_t>(AT_OK));
+
+			/* Queries get a value, everything else is accepted as is. */
+			if(length == 4) {
+				if(frame[2] == 'N' && frame[3] == 'P')
+					write16(response, MAX_PAYLOAD);
+				else if(frame[2] == 'M' && frame[3] == 'Y')
+					write16(response, 0);
+				else if(frame[2] == 'S' && frame[3] == 'H')
+					response.write(reinterpret_cast<const uint8_t *>("\x00\x13\xA2\x00"), 4);
+				else if(frame[2] == 'S' && frame[3] == 'L')
+					response.write(reinterpret_cast<const uint8_t *>("\x40\x00\x00\x00"), 4);
+			}
+
+			this->schedule(stl::move(response), Clock::now());
+		}
+
+		void XBeeSimulator::transmit(const uint8_t *frame, size_t length, size_t offset)
+		{
+			if(length < offset)
+				return;
+
+			auto id = frame[1];
+			auto destination = read64(frame + 2);
+			uint16_t address16 = (frame[10] << 8) | frame[11];
+			auto now = Clock::now();
+			auto trip = 2 * this->_config.latency * NS_PER_MS;
+			size_t node;
+			uint8_t status = SUCCESS;
+			uint8_t discovery = 0;
+
+			this->_stats.transmitted++;
+
+			if(destination == BROADCAST_ADDRESS64)
+				node = address16 - 1;
+			else
+				node = static_cast<size_t>(destination - NODE_ADDRESS - 1);
+
+			if(node >= this->_config.nodes) {
+				status = ADDRESS_NOT_FOUND;
+			} else {
+				/* The radio first has to discover the network address of the node. */
+				if(address16 == UNKNOWN_ADDRESS) {
+					discovery = 1;
+					now += trip;
+				}
+
+				if(this->lose()) {
+					status = NETWORK_ACK_FAILURE;
+					this->_stats.failed++;
+				}
+			}
+
+			if(id != 0) {
+				ByteBuffer response(8, true);
+
+				response.write(static_cast<uint8_t>(ZB_TX_STATUS_RESPONSE));
+				response.write(id);
+				write16(response, node < this->_config.nodes ? static_cast<uint16_t>(node + 1) : UNKNOWN_ADDRESS);
+				response.write(static_cast<uint8_t>(0));
+				response.write(status);
+				response.write(discovery);
+
+				this->schedule(stl::move(response), now + trip);
+			}
+
+			if(!this->_config.echo || status != SUCCESS)
+				return;
+
+			ByteBuffer echo(length - offset + 12, true);
+
+			echo.write(static_cast<uint8_t>(ZB_RX_RESPONSE));
+			write64(echo, address(node));
+			write16(echo, static_cast<uint16_t>(node + 1));
+			echo.write(static_cast<uint8_t>(1));
+			echo.write(frame + offset, length - offset);
+
+			this->schedule(stl::move(echo), now + trip);
+		}
+
+		void XBeeSimulator::schedule(ByteBuffer&& frame, uint64_t due)
+		{
+			Pending pending;
+
+			pending.due = due;
+			pending.frame = stl::move(frame);
+			this->_pending.push_back(stl::move(pending));
+		}
+
+		bool XBeeSimulator::lose()
+		{
+			/* Xorshift; good enough to spread the losses. */
+			this->_random ^= this->_random << 13;
+			this->_random ^= this->_random >> 17;
+			this->_random ^= this->_random << 5;
+
+			return this->_random < this->_config.loss * UINT32_MAX;
+		}
+
+		void XBeeSimulator::refill(uint64_t now)
+		{
+			if(this->_config.throughput == 0)
+				return;
+
+			auto elapsed = now - this->_refilled;
+			auto tokens = elapsed * this->_config.throughput / NS_PER_SEC;
+
+			if(tokens == 0)
+				return;
+
+			/* Allow bursts of up to 10 ms worth of data. */
+			auto burst = this->_config.throughput / 100 + MAX_FRAME_DATA_SIZE * 2;
+
+			this->_tokens += tokens;
+			this->_refilled += tokens * NS_PER_SEC / this->_config.throughput;
+
+			if(this->_tokens > burst)
+				this->_tokens = burst;
+		}
+
+		bool XBeeSimulator::emit(const ByteBuffer& frame)
+		{
+			uint8_t output[(MAX_FRAME_DATA_SIZE + 4) * 2];
+			uint8_t checksum = 0;
+			size_t length = 0;
+
+			auto put = [&](uint8_t byte) {
+				if(byte == START_BYTE || byte == ESCAPE || byte == XON || byte == XOFF) {
+					output[length++] = ESCAPE;
+					output[length++] = byte ^ 0x20;
+				} else {
+					output[length++] = byte;
+				}
+			};
+
+			output[length++] = START_BYTE;
+			put(static_cast<uint8_t>(frame.index() >> 8));
+			put(static_cast<uint8_t>(frame.index()));
+
+			for(size_t idx = 0; idx < frame.index(); idx++) {
+				put(frame.data()[idx]);
+				checksum += frame.data()[idx];
+			}
+
+			put(0xFF - checksum);
+
+			if(this->_config.throughput != 0) {
+				if(this->_tokens < length)
+					return false;
+
+				this->_tokens -= length;
+			}
+
+			if(this->_receiver)
+				this->_receiver(output, length);
+			else
+				RingBufferStream::write(output, length);
+
+			this->_stats.bytes += length;
+			return true;
+		}
+
+		void XBeeSimulator::generate(uint64_t now)
+		{
+			auto interval = static_cast<uint64_t>(NS_PER_SEC / (this->_config.rate * this->_config.nodes));
+
+			/* Traffic that the serial port could not keep up with is never generated. */
+			if(now > this->_next + NS_PER_SEC / 10)
+				this->_next = now;
+
+			while(this->_next <= now) {
+				auto node = this->_node;
+				auto sequence = this->_sequence;
+
+				if(this->lose()) {
+					this->_stats.lost++;
+				} else {
+					ByteBuffer frame(this->_config.payload + 12, true);
+					auto stamp = Clock::now();
+
+					frame.write(static_cast<uint8_t>(ZB_RX_RESPONSE));
+					write64(frame, address(node));
+					write16(frame, static_cast<uint16_t>(node + 1));
+					frame.write(static_cast<uint8_t>(1));
+					frame.write(&stamp, sizeof(stamp));
+					frame.write(&sequence, sizeof(sequence));
+
+					for(size_t idx = STAMP_SIZE; idx < this->_config.payload; idx++)
+						frame.write(static_cast<uint8_t>(idx));
+
+					if(!this->emit(frame))
+						return;
+
+					this->_stats.generated++;
+				}
+
+				this->_sequence++;
+				this->_node = (node + 1) % this->_config.nodes;
+				this->_next += interval;
+			}
+		}
+
+		void XBeeSimulator::run()
+		{
+			while(this->_running.load()) {
+				UniqueLock<Lock> lock(this->_lock);
+				auto now = Clock::now();
+
+				this->refill(now);
+
+				/* Erasing ends the iteration, so every frame that is sent starts a new one. */
+				while(true) {
+					auto iter = this->_pending.begin();
+
+					while(iter != this->_pending.end() && (*iter).due > now)
+						++iter;
+
+					if(iter == this->_pending.end() || !this->emit((*iter).frame))
+						break;
+
+					this->_pending.erase(iter);
+				}
+
+				if(this->_generating)
+					this->generate(now);
+
+				lock.unlock();
+				lwiot_sleep(1);
+			}
+		}
+	}
+}
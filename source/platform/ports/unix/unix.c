@@ -6,11 +6,13 @@
  * Email:  dev@bietje.net
  */
 
+#define _GNU_SOURCE
 #include <lwiot_arch.h>
 
-#define _GNU_SOURCE
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
+#include <limits.h>
 #include <stdint.h>
 #include <time.h>
 #include <assert.h>
@@ -18,22 +20,31 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <sched.h>
+#include <errno.h>
+#include <fcntl.h>
 
 #include <sys/time.h>
+#include <sys/resource.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 #include <lwiot/util/list.h>
 #include <lwiot/log.h>
 #include <lwiot/error.h>
 
-time_t lwiot_tick(void)
+uint64_t lwiot_tick_ns(void)
 {
-	time_t rv;
-	struct timeval tv;
+	struct timespec ts;
 
-	gettimeofday(&tv, NULL);
-	rv = (time_t) (tv.tv_sec * 1000000ULL);
-	rv += tv.tv_usec;
-	return rv;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+time_t lwiot_tick(void)
+{
+	return (time_t) (lwiot_tick_ns() / 1000ULL);
 }
 
 time_t lwiot_tick_ms(void)
@@ -41,6 +52,55 @@ time_t lwiot_tick_ms(void)
 	return lwiot_tick() / 1000ULL;
 }
 
+int lwiot_random_bytes(void *output, size_t length)
+{
+	uint8_t *bytes = output;
+	ssize_t rv;
+	int fd;
+
+#if defined(__linux__) && defined(SYS_getrandom)
+	while(length > 0) {
+		rv = syscall(SYS_getrandom, bytes, length, 0);
+
+		if(rv < 0) {
+			if(errno == EINTR)
+				continue;
+
+			break;
+		}
+
+		bytes += rv;
+		length -= rv;
+	}
+
+	if(length == 0)
+		return -EOK;
+#endif
+
+	fd = open("/dev/urandom", O_RDONLY);
+
+	if(fd < 0)
+		return -EINVALID;
+
+	while(length > 0) {
+		rv = read(fd, bytes, length);
+
+		if(rv <= 0) {
+			if(rv < 0 && errno == EINTR)
+				continue;
+
+			close(fd);
+			return -EINVALID;
+		}
+
+		bytes += rv;
+		length -= rv;
+	}
+
+	close(fd);
+	return -EOK;
+}
+
 void lwiot_mem_free(void *ptr)
 {
 	free(ptr);
@@ -68,13 +128,70 @@ void *lwiot_mem_zalloc(size_t size)
  * THREAD FUNCTIONS
  */
 
+#ifndef CONFIG_UNIX_MIN_STACK_SIZE
+#define CONFIG_UNIX_MIN_STACK_SIZE (256 * 1024)
+#endif
+
+#define STACK_PAINT 0xA5
+
+static void unix_thread_usage(uint64_t *cpu, uint32_t *switches)
+{
+#ifdef RUSAGE_THREAD
+	struct rusage usage;
+
+	if(getrusage(RUSAGE_THREAD, &usage) == 0) {
+		*cpu = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL;
+		*cpu += usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+		*switches = (uint32_t) (usage.ru_nvcsw + usage.ru_nivcsw);
+	}
+#endif
+}
+
+static uint32_t unix_thread_switches(int lwp)
+{
+	uint32_t total = 0;
+#ifdef __linux__
+	char path[64], line[128];
+	unsigned long value;
+	FILE *file;
+
+	if(lwp <= 0)
+		return 0;
+
+	snprintf(path, sizeof(path), "/proc/self/task/%d/status", lwp);
+
+	if((file = fopen(path, "r")) == NULL)
+		return 0;
+
+	while(fgets(line, sizeof(line), file) != NULL) {
+		if(sscanf(line, "voluntary_ctxt_switches: %lu", &value) == 1 ||
+			sscanf(line, "nonvoluntary_ctxt_switches: %lu", &value) == 1)
+			total += (uint32_t) value;
+	}
+
+	fclose(file);
+#endif
+	return total;
+}
+
 static void *unix_thread_starter(void *arg)
 {
 	struct thread *tp;
+	uint64_t cpu = 0;
+	uint32_t switches = 0;
 
 	tp = (struct thread *)arg;
+#ifdef __linux__
+	__atomic_store_n(&tp->lwp, (int) syscall(SYS_gettid), __ATOMIC_RELEASE);
+#endif
 	tp->handle(tp->arg);
 
+	/* Usage counters of a thread are gone once it exits, keep the final values. */
+	unix_thread_usage(&cpu, &switches);
+	tp->cpu_time = cpu;
+	tp->switches = switches;
+	__atomic_store_n(&tp->finished, true, __ATOMIC_RELEASE);
+
 	return NULL;
 }
 
@@ -84,10 +201,102 @@ void lwiot_thread_yield()
 	sched_yield();
 }
 
+static void unix_thread_affinity(pthread_attr_t *attr, uint32_t affinity)
+{
+#ifdef __linux__
+	cpu_set_t set;
+	int core;
+
+	if(affinity == 0)
+		return;
+
+	CPU_ZERO(&set);
+
+	for(core = 0; core < 32; core++) {
+		if(affinity & (1U << core))
+			CPU_SET(core, &set);
+	}
+
+	pthread_attr_setaffinity_np(attr, sizeof(set), &set);
+#else
+	(void) attr;
+	(void) affinity;
+#endif
+}
+
+/*
+ * Threads with an explicit stack size run on a painted stack, so that the high-water mark
+ * can be measured. Hosted code needs more stack than the same code on a MCU, so small sizes
+ * are rounded up to CONFIG_UNIX_MIN_STACK_SIZE.
+ */
 lwiot_thread_t* lwiot_thread_create_raw(const struct lwiot_thread_attributes *attrs)
 {
+	lwiot_thread_t *tp;
+	pthread_attr_t attr;
+	size_t size, page;
+
 	assert(attrs);
-	return lwiot_thread_create(attrs->handle, attrs->name, attrs->argument);
+
+	if(attrs->stacksize == 0 && attrs->affinity == 0)
+		return lwiot_thread_create(attrs->handle, attrs->name, attrs->argument);
+
+	tp = lwiot_mem_zalloc(sizeof(*tp));
+	assert(tp);
+	assert(attrs->handle);
+
+	pthread_attr_init(&attr);
+
+	if(attrs->stacksize != 0) {
+		page = (size_t) sysconf(_SC_PAGESIZE);
+		size = attrs->stacksize < CONFIG_UNIX_MIN_STACK_SIZE ? CONFIG_UNIX_MIN_STACK_SIZE : attrs->stacksize;
+		size = (size + page - 1) & ~(page - 1);
+
+		if(posix_memalign(&tp->stack, page, size) != 0) {
+			pthread_attr_destroy(&attr);
+			lwiot_mem_free(tp);
+			return NULL;
+		}
+
+		memset(tp->stack, STACK_PAINT, size);
+		tp->stacksize = size;
+		pthread_attr_setstack(&attr, tp->stack, size);
+	}
+
+	unix_thread_affinity(&attr, attrs->affinity);
+	tp->arg = attrs->argument;
+	tp->handle = attrs->handle;
+
+	pthread_create(&tp->tid, &attr, unix_thread_starter, tp);
+	pthread_attr_destroy(&attr);
+
+	return tp;
+}
+
+int lwiot_thread_create_static(lwiot_thread_t *tp, const struct lwiot_thread_attributes *attrs, void *stack)
+{
+	pthread_attr_t attr;
+	int rv;
+
+	if(tp == NULL || attrs == NULL || attrs->handle == NULL || stack == NULL || attrs->stacksize < PTHREAD_STACK_MIN)
+		return -EINVALID;
+
+	memset(tp, 0, sizeof(*tp));
+	memset(stack, STACK_PAINT, attrs->stacksize);
+
+	tp->stack = stack;
+	tp->stacksize = attrs->stacksize;
+	tp->is_static = true;
+	tp->arg = attrs->argument;
+	tp->handle = attrs->handle;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstack(&attr, stack, attrs->stacksize);
+	unix_thread_affinity(&attr, attrs->affinity);
+
+	rv = pthread_create(&tp->tid, &attr, unix_thread_starter, tp);
+	pthread_attr_destroy(&attr);
+
+	return rv == 0 ? -EOK : -EINVALID;
 }
 
 lwiot_thread_t* lwiot_thread_create(thread_handle_t handle, const char *name, void *arg)
@@ -112,15 +321,79 @@ int lwiot_thread_destroy(lwiot_thread_t *tp)
 	pthread_join(tp->tid, NULL);
 	tp->handle = NULL;
 	tp->arg = NULL;
+
+	if(tp->is_static)
+		return -EOK;
+
+	if(tp->stack)
+		free(tp->stack);
+
 	lwiot_mem_free(tp);
 
 	return -EOK;
 }
 
+int lwiot_thread_stats(lwiot_thread_t *tp, struct lwiot_thread_stats *stats)
+{
+	clockid_t clock;
+	struct timespec ts;
+	const uint8_t *stack;
+	size_t idx;
+
+	if(tp == NULL || stats == NULL)
+		return -EINVALID;
+
+	memset(stats, 0, sizeof(*stats));
+
+	if(tp->stack) {
+		/* The stack grows down, paint left at the low end has never been used. */
+		stack = tp->stack;
+		for(idx = 0; idx < tp->stacksize && stack[idx] == STACK_PAINT; idx++);
+
+		stats->stack_size = tp->stacksize;
+		stats->stack_free = idx;
+	}
+
+	if(!__atomic_load_n(&tp->finished, __ATOMIC_ACQUIRE)) {
+		if(pthread_equal(tp->tid, pthread_self())) {
+			unix_thread_usage(&stats->cpu_time, &stats->switches);
+			return -EOK;
+		}
+
+		if(pthread_getcpuclockid(tp->tid, &clock) == 0 && clock_gettime(clock, &ts) == 0) {
+			stats->cpu_time = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+			stats->switches = unix_thread_switches(__atomic_load_n(&tp->lwp, __ATOMIC_ACQUIRE));
+			return -EOK;
+		}
+	}
+
+	if(__atomic_load_n(&tp->finished, __ATOMIC_ACQUIRE)) {
+		stats->cpu_time = tp->cpu_time;
+		stats->switches = tp->switches;
+	}
+
+	return -EOK;
+}
+
 /*
  * MUTEX FUNCTIONS
  */
 
+#ifndef CONFIG_MUTEX_SPIN_COUNT
+#define CONFIG_MUTEX_SPIN_COUNT 100
+#endif
+
+static void timespec_create_from_tmo(struct timespec *spec, int tmo);
+
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
 lwiot_mutex_t* lwiot_mutex_create(const uint32_t flags)
 {
 	lwiot_mutex_t *mtx;
@@ -136,7 +409,13 @@ lwiot_mutex_t* lwiot_mutex_create(const uint32_t flags)
 		pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_NORMAL);
 	}
 
+#ifdef _POSIX_THREAD_PRIO_INHERIT
+	if(flags & MTX_PRIO_INHERIT)
+		pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+#endif
+
 	pthread_mutex_init(&mtx->mtx, &attr);
+	pthread_mutexattr_destroy(&attr);
 	return mtx;
 }
 
@@ -151,11 +430,26 @@ int lwiot_mutex_destroy(lwiot_mutex_t *mtx)
 
 int lwiot_mutex_lock(lwiot_mutex_t *mtx, int tmo)
 {
+	struct timespec timeout;
+	int spin;
+
 	assert(mtx);
-	UNUSED(tmo);
 
-	pthread_mutex_lock(&mtx->mtx);
-	return -EOK;
+	/* Most critical sections are short: spin for a while before parking the thread. */
+	for(spin = 0; spin < CONFIG_MUTEX_SPIN_COUNT; spin++) {
+		if(pthread_mutex_trylock(&mtx->mtx) == 0)
+			return -EOK;
+
+		cpu_relax();
+	}
+
+	if(tmo == FOREVER) {
+		pthread_mutex_lock(&mtx->mtx);
+		return -EOK;
+	}
+
+	timespec_create_from_tmo(&timeout, tmo);
+	return pthread_mutex_timedlock(&mtx->mtx, &timeout) == 0 ? -EOK : -ETMO;
 }
 
 void lwiot_mutex_unlock(lwiot_mutex_t *mtx)
@@ -164,6 +458,74 @@ void lwiot_mutex_unlock(lwiot_mutex_t *mtx)
 	pthread_mutex_unlock(&mtx->mtx);
 }
 
+/*
+ * READER-WRITER LOCKS
+ */
+
+lwiot_rwlock_t* lwiot_rwlock_create(void)
+{
+	lwiot_rwlock_t *lock;
+	pthread_rwlockattr_t attr;
+
+	lock = lwiot_mem_zalloc(sizeof(*lock));
+	assert(lock);
+	pthread_rwlockattr_init(&attr);
+
+#ifdef __GLIBC__
+	/* glibc prefers readers by default, which can starve writers. */
+	pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+
+	pthread_rwlock_init(&lock->lock, &attr);
+	pthread_rwlockattr_destroy(&attr);
+
+	return lock;
+}
+
+void lwiot_rwlock_destroy(lwiot_rwlock_t *lock)
+{
+	assert(lock);
+
+	pthread_rwlock_destroy(&lock->lock);
+	lwiot_mem_free(lock);
+}
+
+void lwiot_rwlock_read_lock(lwiot_rwlock_t *lock)
+{
+	assert(lock);
+	pthread_rwlock_rdlock(&lock->lock);
+}
+
+bool lwiot_rwlock_read_trylock(lwiot_rwlock_t *lock)
+{
+	assert(lock);
+	return pthread_rwlock_tryrdlock(&lock->lock) == 0;
+}
+
+void lwiot_rwlock_read_unlock(lwiot_rwlock_t *lock)
+{
+	assert(lock);
+	pthread_rwlock_unlock(&lock->lock);
+}
+
+void lwiot_rwlock_write_lock(lwiot_rwlock_t *lock)
+{
+	assert(lock);
+	pthread_rwlock_wrlock(&lock->lock);
+}
+
+bool lwiot_rwlock_write_trylock(lwiot_rwlock_t *lock)
+{
+	assert(lock);
+	return pthread_rwlock_trywrlock(&lock->lock) == 0;
+}
+
+void lwiot_rwlock_write_unlock(lwiot_rwlock_t *lock)
+{
+	assert(lock);
+	pthread_rwlock_unlock(&lock->lock);
+}
+
 void lwiot_sleep(int ms)
 {
 	time_t us;
@@ -193,12 +555,10 @@ lwiot_event_t* lwiot_event_create(int length)
 static void timespec_create_from_tmo(struct timespec *spec, int tmo)
 {
 	struct timeval tv;
-	time_t tvsec;
 
 	assert(spec);
 	gettimeofday(&tv, NULL);
-	time(&tvsec);
-	spec->tv_sec = tvsec + (tmo / 1000);
+	spec->tv_sec = tv.tv_sec + (tmo / 1000);
 	spec->tv_nsec = tv.tv_usec * 1000 + (1000 * 1000 * (tmo % 1000));
 	spec->tv_sec += spec->tv_nsec / (NANOSECOND);
 	spec->tv_nsec %= NANOSECOND;
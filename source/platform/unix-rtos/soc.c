@@ -14,9 +14,20 @@
 
 static pthread_mutex_t crit_section_mtx = PTHREAD_MUTEX_INITIALIZER;
 
+#ifndef CONFIG_UDELAY_SLEEP_US
+#define CONFIG_UDELAY_SLEEP_US 1000
+#endif
+
+/*
+ * The scheduler can not wake a sleeping thread with microsecond precision. Short delays are
+ * busy-waits, long delays give the CPU away.
+ */
 void lwiot_udelay(uint32_t us)
 {
-	usleep(us);
+	if(us < CONFIG_UDELAY_SLEEP_US)
+		lwiot_ndelay(us * 1000U);
+	else
+		usleep(us);
 }
 
 void enter_critical()
@@ -23,14 +23,38 @@ typedef DLL_EXPORT struct mutex {
 #define HAVE_MUTEX
 } lwiot_mutex_t;
 
+#ifndef HAVE_RTOS
+typedef DLL_EXPORT struct rwlock {
+	pthread_rwlock_t lock;
+#define HAVE_RWLOCK
+} lwiot_rwlock_t;
+#endif
+
 typedef DLL_EXPORT struct thread {
 	char name[16];
 	pthread_t tid;
 	void(*handle)(void *arg);
 	void  *arg;
+
+	void *stack;
+	size_t stacksize;
+	int lwp;
+	bool finished;
+	uint64_t cpu_time;
+	uint32_t switches;
+	bool is_static;
 #define HAVE_THREAD
 } lwiot_thread_t;
 
+#ifndef HAVE_RTOS
+#define HAVE_THREAD_STATS
+#define HAVE_STATIC_THREAD
+#define HAVE_TICK_NS
+#define HAVE_TIMER_EXPIRY
+#endif
+
+#define HAVE_RANDOM_BYTES
+
 typedef DLL_EXPORT struct event {
 	pthread_mutex_t mtx;
 	pthread_cond_t cond;
@@ -40,9 +64,10 @@ typedef DLL_EXPORT struct event {
 } lwiot_event_t;
 
 typedef DLL_EXPORT struct timer {
-	struct list_head entry;
+	size_t index;
 	void (*handle)(struct timer *timer, void *arg);
 	bool oneshot;
+	uint32_t flags;
 	time_t expiry;
 	int tmo;
 	void *arg;
@@ -20,19 +20,31 @@ extern "C" {
 #endif
 
 typedef struct DLL_EXPORT mutex {
-	HANDLE mtx;
+	CRITICAL_SECTION cs;
 #define HAVE_MUTEX
 } lwiot_mutex_t;
 
+typedef struct DLL_EXPORT rwlock {
+	SRWLOCK lock;
+#define HAVE_RWLOCK
+} lwiot_rwlock_t;
+
 typedef struct DLL_EXPORT thread {
 	char name[16];
 	HANDLE tp;
 	DWORD tid;
 	void *arg;
 	void(*handle)(void *param);
+	bool is_static;
 #define HAVE_THREAD
 } lwiot_thread_t;
 
+#define HAVE_THREAD_STATS
+#define HAVE_STATIC_THREAD
+#define HAVE_TICK_NS
+#define HAVE_TIMER_EXPIRY
+#define HAVE_RANDOM_BYTES
+
 typedef struct DLL_EXPORT event {
 	CRITICAL_SECTION cs;
 	CONDITION_VARIABLE cond;
@@ -42,9 +54,10 @@ typedef struct DLL_EXPORT event {
 } lwiot_event_t;
 
 typedef DLL_EXPORT struct timer {
-	struct list_head entry;
+	size_t index;
 	void (*handle)(struct timer *timer, void *arg);
 	bool oneshot;
+	uint32_t flags;
 	time_t expiry;
 	int tmo;
 	void *arg;
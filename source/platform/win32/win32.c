@@ -23,20 +23,28 @@
 
 #include <WinSock2.h>
 #include <Windows.h>
+#include <bcrypt.h>
 
-#define WIN32_EPOCH_ADJUSTMENT 11644473600000000ULL
-time_t lwiot_tick(void)
+uint64_t lwiot_tick_ns(void)
 {
-	time_t rv;
-	FILETIME ft;
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	uint64_t seconds, remainder;
+
+	/* The frequency is fixed at boot, a racing first call stores the same value. */
+	if(frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+
+	QueryPerformanceCounter(&counter);
+	seconds = counter.QuadPart / frequency.QuadPart;
+	remainder = counter.QuadPart % frequency.QuadPart;
 
-	GetSystemTimeAsFileTime(&ft);
-	rv = ft.dwHighDateTime;
-	rv <<= 32;
-	rv |= ft.dwLowDateTime;
-	rv /= 10;
+	return seconds * 1000000000ULL + remainder * 1000000000ULL / frequency.QuadPart;
+}
 
-	return rv - WIN32_EPOCH_ADJUSTMENT;
+time_t lwiot_tick(void)
+{
+	return (time_t) (lwiot_tick_ns() / 1000ULL);
 }
 
 time_t lwiot_tick_ms(void)
@@ -44,6 +52,14 @@ time_t lwiot_tick_ms(void)
 	return lwiot_tick() / 1000ULL;
 }
 
+int lwiot_random_bytes(void *output, size_t length)
+{
+	NTSTATUS status;
+
+	status = BCryptGenRandom(NULL, output, (ULONG) length, BCRYPT_USE_SYSTEM_PREFERRED_RNG);
+	return BCRYPT_SUCCESS(status) ? -EOK : -EINVALID;
+}
+
 void lwiot_mem_free(void *ptr)
 {
 	free(ptr);
@@ -82,7 +98,45 @@ static DWORD WINAPI EStackThreadStarter(LPVOID lpParam)
 
 lwiot_thread_t* lwiot_thread_create_raw(const struct lwiot_thread_attributes *attrs)
 {
-	return lwiot_thread_create(attrs->handle, attrs->name, attrs->argument);
+	lwiot_thread_t *tp;
+
+	tp = lwiot_thread_create(attrs->handle, attrs->name, attrs->argument);
+
+	if(tp != NULL && attrs->affinity != 0)
+		SetThreadAffinityMask(tp->tp, (DWORD_PTR) attrs->affinity);
+
+	return tp;
+}
+
+/*
+ * Win32 does not run threads on a caller supplied stack. Only the control block is static, the
+ * stack is reserved by the OS.
+ */
+int lwiot_thread_create_static(lwiot_thread_t *tp, const struct lwiot_thread_attributes *attrs, void *stack)
+{
+	UNUSED(stack);
+
+	if(tp == NULL || attrs == NULL || attrs->handle == NULL)
+		return -EINVALID;
+
+	memset(tp, 0, sizeof(*tp));
+	tp->handle = attrs->handle;
+	tp->arg = attrs->argument;
+	tp->is_static = true;
+
+	if(attrs->name != NULL)
+		strncpy(tp->name, attrs->name, sizeof(tp->name) - 1);
+
+	tp->tp = CreateThread(NULL, attrs->stacksize, (LPTHREAD_START_ROUTINE)EStackThreadStarter, tp,
+		STACK_SIZE_PARAM_IS_A_RESERVATION, &tp->tid);
+
+	if(!tp->tp)
+		return -EINVALID;
+
+	if(attrs->affinity != 0)
+		SetThreadAffinityMask(tp->tp, (DWORD_PTR) attrs->affinity);
+
+	return -EOK;
 }
 
 lwiot_thread_t* lwiot_thread_create(thread_handle_t handle, const char *name, void *arg)
@@ -125,7 +179,33 @@ int lwiot_thread_destroy(lwiot_thread_t *tp)
 	tp->tp = NULL;
 	tp->arg = NULL;
 	tp->tid = 0;
-	lwiot_mem_free(tp);
+
+	if(!tp->is_static)
+		lwiot_mem_free(tp);
+
+	return -EOK;
+}
+
+int lwiot_thread_stats(lwiot_thread_t *tp, struct lwiot_thread_stats *stats)
+{
+	FILETIME created, exited, kernel, user;
+	ULARGE_INTEGER ktime, utime;
+
+	if(tp == NULL || stats == NULL)
+		return -EINVALID;
+
+	/* Win32 does not report stack usage or context switches of a thread. */
+	memset(stats, 0, sizeof(*stats));
+
+	if(GetThreadTimes(tp->tp, &created, &exited, &kernel, &user)) {
+		ktime.LowPart = kernel.dwLowDateTime;
+		ktime.HighPart = kernel.dwHighDateTime;
+		utime.LowPart = user.dwLowDateTime;
+		utime.HighPart = user.dwHighDateTime;
+
+		/* FILETIME counts in units of 100 ns. */
+		stats->cpu_time = (ktime.QuadPart + utime.QuadPart) / 10ULL;
+	}
 
 	return -EOK;
 }
@@ -134,20 +214,25 @@ int lwiot_thread_destroy(lwiot_thread_t *tp)
  * MUTEX FUNCTIONS
  */
 
+#ifndef CONFIG_MUTEX_SPIN_COUNT
+#define CONFIG_MUTEX_SPIN_COUNT 100
+#endif
+
+/*
+ * Critical sections spin before they wait on a kernel object, and do not enter the kernel
+ * at all when uncontended. Like the Win32 mutexes they replace, they are always recursive.
+ */
 lwiot_mutex_t* lwiot_mutex_create(const uint32_t flags)
 {
 	lwiot_mutex_t *mtx;
 
+	UNUSED(flags);
 	mtx = lwiot_mem_zalloc(sizeof(*mtx));
 	assert(mtx);
 
-	if(flags & MTX_RECURSIVE) {
-		print_dbg("Recursive mutexes not supported on this platform!\n");
-	}
-
-	mtx->mtx = CreateMutex(NULL, FALSE, NULL);
-	if(!mtx->mtx) {
+	if(!InitializeCriticalSectionAndSpinCount(&mtx->cs, CONFIG_MUTEX_SPIN_COUNT)) {
 		print_dbg("Couldn't create mutex object\n");
+		lwiot_mem_free(mtx);
 		return NULL;
 	}
 
@@ -163,45 +248,90 @@ int lwiot_mutex_destroy(lwiot_mutex_t *mtx)
 {
 	assert(mtx);
 
-	CloseHandle(mtx->mtx);
+	DeleteCriticalSection(&mtx->cs);
 	lwiot_mem_free(mtx);
 	return -EOK;
 }
 
 int lwiot_mutex_lock(lwiot_mutex_t *mtx, int tmo)
 {
-	DWORD result;
-	int rv;
-
-	if(tmo)
-		result = WaitForSingleObject(mtx->mtx, tmo);
-	else
-		result = WaitForSingleObject(mtx->mtx, INFINITE);
-
-	switch(result) {
-	case WAIT_OBJECT_0:
-		rv = -EOK;
-		break;
-
-	case WAIT_TIMEOUT:
-		print_dbg("Mutex unlock timeout!\n");
-		rv = -EINVALID;
-		break;
-
-	case WAIT_ABANDONED:
-	default:
-		print_dbg("Unable to lock mutex! (Error code: %u)\n", result);
-		rv = -EINVALID;
-		break;
+	ULONGLONG deadline;
+
+	assert(mtx);
+
+	if(tmo == FOREVER) {
+		EnterCriticalSection(&mtx->cs);
+		return -EOK;
+	}
+
+	/* Critical sections cannot be waited on with a timeout. */
+	deadline = GetTickCount64() + tmo;
+
+	while(!TryEnterCriticalSection(&mtx->cs)) {
+		if(GetTickCount64() >= deadline)
+			return -ETMO;
+
+		SwitchToThread();
 	}
 
-	return rv;
+	return -EOK;
 }
 
 void lwiot_mutex_unlock(lwiot_mutex_t *mtx)
 {
-	if(!ReleaseMutex(mtx->mtx))
-		print_dbg("Unable to release mutex!\n");
+	LeaveCriticalSection(&mtx->cs);
+}
+
+/*
+ * READER-WRITER LOCKS
+ */
+
+lwiot_rwlock_t* lwiot_rwlock_create(void)
+{
+	lwiot_rwlock_t *lock;
+
+	lock = lwiot_mem_zalloc(sizeof(*lock));
+	assert(lock);
+	InitializeSRWLock(&lock->lock);
+
+	return lock;
+}
+
+void lwiot_rwlock_destroy(lwiot_rwlock_t *lock)
+{
+	/* SRW locks do not own any resources. */
+	assert(lock);
+	lwiot_mem_free(lock);
+}
+
+void lwiot_rwlock_read_lock(lwiot_rwlock_t *lock)
+{
+	AcquireSRWLockShared(&lock->lock);
+}
+
+bool lwiot_rwlock_read_trylock(lwiot_rwlock_t *lock)
+{
+	return TryAcquireSRWLockShared(&lock->lock) != 0;
+}
+
+void lwiot_rwlock_read_unlock(lwiot_rwlock_t *lock)
+{
+	ReleaseSRWLockShared(&lock->lock);
+}
+
+void lwiot_rwlock_write_lock(lwiot_rwlock_t *lock)
+{
+	AcquireSRWLockExclusive(&lock->lock);
+}
+
+bool lwiot_rwlock_write_trylock(lwiot_rwlock_t *lock)
+{
+	return TryAcquireSRWLockExclusive(&lock->lock) != 0;
+}
+
+void lwiot_rwlock_write_unlock(lwiot_rwlock_t *lock)
+{
+	ReleaseSRWLockExclusive(&lock->lock);
 }
 
 void lwiot_sleep(int ms)
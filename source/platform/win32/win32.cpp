@@ -13,7 +13,15 @@
 #include <thread>
 #include <chrono>
 
+#ifndef CONFIG_UDELAY_SLEEP_US
+#define CONFIG_UDELAY_SLEEP_US 1000
+#endif
+
 extern "C" void lwiot_udelay(uint32_t us)
 {
-	std::this_thread::sleep_for(std::chrono::microseconds(us));
+	/* Windows sleeps with millisecond granularity at best, busy-wait on short delays. */
+	if(us < CONFIG_UDELAY_SLEEP_US)
+		lwiot_ndelay(us * 1000U);
+	else
+		std::this_thread::sleep_for(std::chrono::microseconds(us));
 }
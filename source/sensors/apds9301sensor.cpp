@@ -13,9 +13,11 @@
 #include <lwiot/types.h>
 #include <lwiot/error.h>
 #include <lwiot/log.h>
-#include <lwiot/io/i2cmessage.h>
 #include <lwiot/io/i2cbus.h>
+#include <lwiot/io/gpiochip.h>
 #include <lwiot/kernel/lock.h>
+#include <lwiot/device/registerdevice.h>
+#include <lwiot/device/datareadyinterrupt.h>
 #include <lwiot/device/apds9301sensor.h>
 
 #define APDS_DEBUG 1
@@ -39,10 +41,14 @@
 #define DATA1HI_REG 0x8F
 
 #define CMD_REG 0x20
+#define CLEAR_CMD 0xC0
+
+#define INTERRUPT_LEVEL 0x10
+#define INTERRUPT_PERSIST_MASK 0xF
 
 namespace lwiot
 {
-	Apds9301Sensor::Apds9301Sensor(I2CBus &bus, uint8_t addr) : _bus(bus), _addr(addr)
+	Apds9301Sensor::Apds9301Sensor(I2CBus &bus, uint8_t addr) : _regs(bus, addr, CMD_REG), _persist(0), _lux(0.0)
 	{
 	}
 
@@ -54,6 +60,8 @@ namespace lwiot
 			print_dbg("Unable to enable APDS sensor!\n");
 		}
 
+		a = a && this->_regs.cache(TIMING_REG, 1);
+
 		auto b = this->setGain(false);
 
 		if(!b) {
@@ -183,6 +191,120 @@ namespace lwiot
 		return true;
 	}
 
+	time_t Apds9301Sensor::integration()
+	{
+		switch(this->getIntegrationTime()) {
+		case INT_TIME_13_7_MS:
+			return 14;
+
+		case INT_TIME_101_MS:
+			return 101;
+
+		default:
+		case INT_TIME_402_MS:
+			return 402;
+		}
+	}
+
+	bool Apds9301Sensor::enableInterrupt(GpioChip& chip, int pin)
+	{
+		/* INT is an open drain, active low level output. */
+		if(!this->_irq.attach(chip, pin, IrqFalling))
+			return false;
+
+		if(this->write(INTERRUPT_REG, (uint8_t) (INTERRUPT_LEVEL | this->_persist)) && this->clearInterrupt())
+			return true;
+
+		this->_irq.detach();
+		return false;
+	}
+
+	void Apds9301Sensor::disableInterrupt()
+	{
+		this->write(INTERRUPT_REG, (uint8_t) 0x0);
+		this->_irq.detach();
+	}
+
+	bool Apds9301Sensor::setThresholds(uint16_t low, uint16_t high, uint8_t persist)
+	{
+		this->_persist = persist & INTERRUPT_PERSIST_MASK;
+
+		if(!this->write(THRESHLOWLOW_REG, low) || !this->write(THRESHHILOW_REG, high))
+			return false;
+
+		if(!this->_irq.attached())
+			return true;
+
+		return this->write(INTERRUPT_REG, (uint8_t) (INTERRUPT_LEVEL | this->_persist));
+	}
+
+	bool Apds9301Sensor::clearInterrupt()
+	{
+		return this->_regs.write(CLEAR_CMD, nullptr, 0);
+	}
+
+	bool Apds9301Sensor::startMeasurement()
+	{
+		/* Rearm the interrupt, so that it fires for a cycle that ends after this point. */
+		if(this->_irq.attached()) {
+			if(!this->clearInterrupt())
+				return false;
+
+			this->_irq.clear();
+		}
+
+		this->schedule(this->integration());
+		return true;
+	}
+
+	bool Apds9301Sensor::ready()
+	{
+		if(!this->_irq.attached())
+			return AsyncSensor::ready();
+
+		if(!this->busy())
+			return false;
+
+		if(this->_irq.pending())
+			return true;
+
+		/* With a threshold window the level can stay inside it for a long time. */
+		if(this->remaining() == 0)
+			this->schedule(this->integration());
+
+		return false;
+	}
+
+	void Apds9301Sensor::await(time_t ms)
+	{
+		if(this->_irq.attached())
+			this->_irq.wait(static_cast<int>(ms));
+		else
+			AsyncSensor::await(ms);
+	}
+
+	bool Apds9301Sensor::collect()
+	{
+		if(!this->ready())
+			return false;
+
+		this->complete();
+		this->_irq.clear();
+
+		return this->getLux(this->_lux);
+	}
+
+	size_t Apds9301Sensor::values(float* values, size_t count) const
+	{
+		const float results[] = {static_cast<float>(this->_lux)};
+		return AsyncSensor::store(values, count, results, sizeof(results) / sizeof(results[0]));
+	}
+
+	double Apds9301Sensor::lux() const
+	{
+		return this->_lux;
+	}
+
 	bool Apds9301Sensor::getGain(bool& gain)
 	{
 		uint8_t value;
@@ -224,70 +346,25 @@ namespace lwiot
 
 	bool Apds9301Sensor::write(uint8_t addr, uint8_t byte)
 	{
-		uint8_t data[] = {
-				addr, byte
-		};
-
-		return this->_bus.send(this->_addr, data, sizeof data);
+		return this->_regs.write8(addr, byte);
 	}
 
 	bool Apds9301Sensor::write(uint8_t addr, uint16_t word)
 	{
-		uint8_t address = CMD_REG | addr;
 		uint8_t data[] = {
-				address, (uint8_t) (word & 0xFF), (uint8_t) ((word >> BITS_PER_BYTE) & 0xFF)
+				(uint8_t) (word & 0xFF), (uint8_t) ((word >> BITS_PER_BYTE) & 0xFF)
 		};
 
-		return this->_bus.send(this->_addr, data, sizeof data);
+		return this->_regs.write(addr, data, sizeof data);
 	}
 
 	bool Apds9301Sensor::read(uint8_t addr, uint16_t &word)
 	{
-		uint16_t data = 0;
-		lwiot::I2CMessage wr(1), rd(2);
-		lwiot::stl::Vector<lwiot::I2CMessage> msgs;
-
-		wr.write(CMD_REG | addr);
-		wr.setAddress(this->_addr, false, false);
-		wr.setRepeatedStart(true);
-
-		rd.setRepeatedStart(false);
-		rd.setAddress(this->_addr, false, true);
-
-		msgs.pushback(stl::move(wr));
-		msgs.pushback(stl::move(rd));
-
-		if(!this->_bus.transfer(msgs))
-			return false;
-
-		rd = stl::move(msgs.back());
-		data = rd[0] | (rd[1] << BITS_PER_BYTE);
-		print_dbg("Data: %u\n", data);
-
-		word = data;
-		return true;
+		return this->_regs.read16(addr, word, true);
 	}
 
 	bool Apds9301Sensor::read(uint8_t addr, uint8_t &byte)
 	{
-		lwiot::I2CMessage wr(1), rd(1);
-		lwiot::stl::Vector<lwiot::I2CMessage> msgs;
-
-		wr.write(addr);
-		wr.setAddress(this->_addr, false, false);
-		wr.setRepeatedStart(true);
-		rd.setRepeatedStart(false);
-		rd.setAddress(this->_addr, false, true);
-
-		msgs.pushback(stl::move(wr));
-		msgs.pushback(stl::move(rd));
-
-		if(!this->_bus.transfer(msgs))
-			return false;
-
-		rd = stl::move(msgs.back());
-		byte = rd[0];
-
-		return true;
+		return this->_regs.read8(addr, byte);
 	}
 }
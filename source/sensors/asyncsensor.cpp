@@ -0,0 +1,105 @@
+/*
+ * Non-blocking sensor measurements.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/device/asyncsensor.h>
+
+namespace lwiot
+{
+	AsyncSensor::AsyncSensor() : _deadline(0), _busy(false)
+	{
+	}
+
+	bool AsyncSensor::ready()
+	{
+		return this->_busy && this->remaining() == 0;
+	}
+
+	size_t AsyncSensor::values(float* values, size_t count) const
+	{
+		UNUSED(values);
+		UNUSED(count);
+
+		return 0;
+	}
+
+	size_t AsyncSensor::store(float* values, size_t count, const float* results, size_t num)
+	{
+		if(num > count)
+			num = count;
+
+		for(size_t idx = 0; idx < num; idx++)
+			values[idx] = results[idx];
+
+		return num;
+	}
+
+	bool AsyncSensor::busy() const
+	{
+		return this->_busy;
+	}
+
+	time_t AsyncSensor::remaining() const
+	{
+		auto now = lwiot_tick_ms();
+
+		if(!this->_busy || this->_deadline <= now)
+			return 0;
+
+		return this->_deadline - now;
+	}
+
+	void AsyncSensor::schedule(time_t ms)
+	{
+		this->_deadline = lwiot_tick_ms() + ms;
+		this->_busy = true;
+	}
+
+	void AsyncSensor::complete()
+	{
+		this->_busy = false;
+	}
+
+	void AsyncSensor::await(time_t ms)
+	{
+		lwiot_sleep(static_cast<int>(ms));
+	}
+
+	bool AsyncSensor::sample(int tmo)
+	{
+		if(!this->startMeasurement())
+			return false;
+
+		auto deadline = lwiot_tick_ms() + tmo;
+
+		while(!this->ready()) {
+			auto now = lwiot_tick_ms();
+
+			if(!this->busy() || now >= deadline) {
+				this->complete();
+				return false;
+			}
+
+			/* Sensors that poll a status register are ready whenever they are; check every tick. */
+			auto wait = this->remaining();
+
+			if(wait == 0)
+				wait = 1;
+
+			if(now + wait > deadline)
+				wait = deadline - now;
+
+			this->await(wait);
+		}
+
+		return this->collect();
+	}
+}
@@ -45,13 +45,9 @@
 
 namespace lwiot
 {
-	static inline void bmp_delay(int ms)
-	{
-		lwiot_sleep(ms);
-	}
-
 	Bmp085Sensor::Bmp085Sensor(lwiot::I2CBus &bus) : BmpSensor(Bmp085Sensor::SlaveAddress, bus),
-		_pressure(0.0f), _temperature(0.0f), _calibrate(true), _oversampling(BMP_ULTRA_HIRES)
+		_pressure(0), _temperature(0), _calibrate(true), _oversampling(BMP_ULTRA_HIRES),
+		_stage(Stage::Temperature), _ut(0)
 	{
 	}
 
@@ -65,6 +61,9 @@ namespace lwiot
 			return;
 		}
 
+		/* AC1 up to and including MD. */
+		this->cache(BMP_A1_REG, 22);
+
 		this->ac1 = this->readS16(BMP_A1_REG);
 		this->ac2 = this->readS16(BMP_A2_REG);
 		this->ac3 = this->readS16(BMP_A3_REG);
@@ -86,6 +85,14 @@ namespace lwiot
 		if(this->_calibrate)
 			return 0.0f;
 
+		return this->_temperature / 10.0f;
+	}
+
+	int32_t Bmp085Sensor::temperatureDeciCelsius() const
+	{
+		if(this->_calibrate)
+			return 0;
+
 		return this->_temperature;
 	}
 
@@ -98,55 +105,85 @@ namespace lwiot
 	}
 
 #define TEMPERATURE_DELAY 5
-	uint16_t Bmp085Sensor::readTemperature()
+	time_t Bmp085Sensor::pressureDelay() const
 	{
+		switch(this->_oversampling) {
+		case BMP_LOWPOWER:
+			return 5;
+
+		case BMP_STANDARD:
+			return 8;
+
+		case BMP_HIRES:
+			return 14;
+
+		default:
+		case BMP_ULTRA_HIRES:
+			return 26;
+		}
+	}
+
+	bool Bmp085Sensor::startMeasurement()
+	{
+		if(this->_calibrate)
+			return false;
+
 		this->write(BMP_CONTROL, BMP_READ_TEMPERATURE_CMD);
-		bmp_delay(TEMPERATURE_DELAY);
-		return this->read16(BMP_READ_TEMPDATA);
+		this->_stage = Stage::Temperature;
+		this->schedule(TEMPERATURE_DELAY);
+
+		return true;
 	}
 
-	uint32_t Bmp085Sensor::readPressure()
+	bool Bmp085Sensor::ready()
 	{
-		int msdelay;
-		uint32_t raw;
-		uint16_t raw16;
-		uint8_t raw8;
+		if(!AsyncSensor::ready())
+			return false;
+
+		if(this->_stage == Stage::Pressure)
+			return true;
 
+		this->_ut = this->read16(BMP_READ_TEMPDATA);
 		this->write(BMP_CONTROL, BMP_READ_PRESSURE_CMD + (this->_oversampling << 6));
+		this->_stage = Stage::Pressure;
+		this->schedule(this->pressureDelay());
 
-		switch(this->_oversampling) {
-		case BMP_LOWPOWER:
-			msdelay = 5;
-			break;
+		return false;
+	}
 
-		case BMP_STANDARD:
-			msdelay = 8;
-			break;
+	bool Bmp085Sensor::collect()
+	{
+		if(!this->ready())
+			return false;
 
-		case BMP_HIRES:
-			msdelay = 14;
-			break;
+		this->complete();
 
-		case BMP_ULTRA_HIRES:
-			msdelay = 26;
-			break;
-		default:
-			return 0;
-		}
+		auto up = this->readPressure();
+		auto b5 = this->computeB5(this->_ut);
+
+		this->_temperature = this->calculateTemperature(b5);
+		this->_pressure = this->calculatePressure(b5, up);
+
+		return true;
+	}
+
+	size_t Bmp085Sensor::values(float* values, size_t count) const
+	{
+		const float results[] = {static_cast<float>(this->_pressure), this->_temperature / 10.0f};
+		return AsyncSensor::store(values, count, results, sizeof(results) / sizeof(results[0]));
+	}
 
-		bmp_delay(msdelay);
-		raw16 = this->read16(BMP_READ_PRESDATA);
-		raw8 = this->read8(BMP_READ_PRESDATA + sizeof(raw16));
+	uint32_t Bmp085Sensor::readPressure()
+	{
+		uint32_t raw;
 
-		raw = raw16;
-		raw <<= BITS_PER_BYTE;
-		raw |= raw8;
+		raw = this->read24(BMP_READ_PRESDATA);
 		raw >>= (8 - this->_oversampling);
 
 		return raw;
 	}
 
-	int32_t Bmp085Sensor::computeB5(int32_t ut)
+	int32_t Bmp085Sensor::computeB5(int32_t ut) const
 	{
 		int32_t x1, x2;
 
@@ -155,25 +192,16 @@ namespace lwiot
 		return x1 + x2;
 	}
 
-	float Bmp085Sensor::calculateTemperature()
+	int32_t Bmp085Sensor::calculateTemperature(int32_t b5) const
 	{
-		float temp;
-		auto ut = this->readTemperature();
-		auto b5 = this->computeB5(ut);
-
-		temp = (b5 + 8) >> 4;
-		return temp / 10.0f;
+		return (b5 + 8) >> 4;
 	}
 
-	int32_t Bmp085Sensor::calculatePressure()
+	int32_t Bmp085Sensor::calculatePressure(int32_t b5, int32_t up) const
 	{
-		int32_t up, ut, b5, b6, x1, x2, x3, p, b3;
+		int32_t b6, x1, x2, x3, p, b3;
 		uint32_t b4, b7;
 
-		ut = this->readTemperature();
-		up = this->readPressure();
-		b5 = this->computeB5(ut);
-
 		b6 = b5 - 4000;
 		x1 = ((int32_t)this->b2 * ((b6 * b6) >> 12)) >> 11;
 		x2 = ((int32_t)this->ac2 * b6) >> 11;
@@ -200,8 +228,7 @@ namespace lwiot
 		if(this->_calibrate)
 			return;
 
-		this->_temperature = this->calculateTemperature();
-		this->_pressure = this->calculatePressure();
+		this->sample();
 	}
 
 	void Bmp085Sensor::read(int32_t &pressure, float &temperature)
@@ -211,6 +238,6 @@ namespace lwiot
 
 		this->read();
 		pressure = this->_pressure;
-		temperature = this->_temperature;
+		temperature = this->temperature();
 	}
 }
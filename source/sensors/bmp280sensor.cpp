@@ -20,12 +20,15 @@
 namespace lwiot
 {
 	Bmp280Sensor::Bmp280Sensor(lwiot::I2CBus &bus) : BmpSensor(Bmp280Sensor::SlaveAddress, bus),
-		 _pressure(0), _temperature(0.0), _calibrate(true)
+		 _pressure(0), _temperature(0), _calibrate(true)
 	{
 	}
 
 	void Bmp280Sensor::begin()
 	{
+		/* T1 up to and including P9. */
+		this->cache(BMP280_REGISTER_DIG_T1, 24);
+
 		this->_data.dig_T1 = this->read16_LE(BMP280_REGISTER_DIG_T1);
 		this->_data.dig_T2 = this->readS16_LE(BMP280_REGISTER_DIG_T2);
 		this->_data.dig_T3 = this->readS16_LE(BMP280_REGISTER_DIG_T3);
@@ -46,38 +49,62 @@ namespace lwiot
 		this->_calibrate = false;
 	}
 
-	int32_t Bmp280Sensor::readAdcPressure()
+	const int32_t &Bmp280Sensor::pressure() const
 	{
-		return this->read24(BMP280_REGISTER_PRESSUREDATA);
+		return this->_pressure;
 	}
 
-	int32_t Bmp280Sensor::readAdcTemperature()
+	float Bmp280Sensor::temperature() const
 	{
-		return this->read24(BMP280_REGISTER_TEMPDATA);
+		return this->_temperature / 100.0f;
 	}
 
-	const int32_t &Bmp280Sensor::pressure() const
+	int32_t Bmp280Sensor::temperatureCentiCelsius() const
 	{
-		return this->_pressure;
+		return this->_temperature;
 	}
 
-	const float &Bmp280Sensor::temperature() const
+	bool Bmp280Sensor::startMeasurement()
 	{
-		return this->_temperature;
+		if(this->_calibrate)
+			return false;
+
+		this->schedule(0);
+		return true;
 	}
 
-	void Bmp280Sensor::read()
+	bool Bmp280Sensor::collect()
 	{
-		if(this->_calibrate)
-			return;
+		uint8_t raw[6];
+		int32_t adcP, adcT;
+
+		if(!this->ready())
+			return false;
+
+		this->complete();
+
+		/* The data registers are shadowed during a burst read, so both values belong together. */
+		if(!BmpSensor::read(BMP280_REGISTER_PRESSUREDATA, raw, sizeof(raw)))
+			return false;
+
+		adcP = (raw[0] << 16) | (raw[1] << 8) | raw[2];
+		adcT = (raw[3] << 16) | (raw[4] << 8) | raw[5];
+
+		this->_temperature = this->computeTemperature(adcT);
+		this->_pressure = this->computePressure(adcP);
+
+		return true;
+	}
 
-		auto adcT = this->readAdcTemperature();
-		lwiot_sleep(20);
+	size_t Bmp280Sensor::values(float* values, size_t count) const
+	{
+		const float results[] = {static_cast<float>(this->_pressure), this->temperature()};
+		return AsyncSensor::store(values, count, results, sizeof(results) / sizeof(results[0]));
+	}
 
-		this->_temperature = this->computeTemperature(adcT) / 100.0;
-		auto adcP = 0;
-		auto pvalue = this->computePressure(adcP);
-		this->_pressure = pvalue;
+	void Bmp280Sensor::read()
+	{
+		this->sample();
 	}
 
 	void Bmp280Sensor::read(int32_t &pressure, float &temperature)
@@ -85,14 +112,46 @@ namespace lwiot
 		this->read();
 
 		pressure = this->_pressure;
-		temperature = this->_temperature;
+		temperature = this->temperature();
 	}
 
-	int32_t Bmp280Sensor::computePressure(int32_t input)
+#ifdef CONFIG_BMP280_PRESSURE_32BIT
+	int32_t Bmp280Sensor::computePressure(int32_t adc_P)
+	{
+		BMP280_S32_t var1, var2;
+		BMP280_U32_t p;
+
+		adc_P >>= 4;
+
+		var1 = (((BMP280_S32_t)this->_tfine)>>1) - (BMP280_S32_t)64000;
+		var2 = (((var1>>2) * (var1>>2)) >> 11 ) * ((BMP280_S32_t)this->_data.dig_P6);
+		var2 = var2 + ((var1*((BMP280_S32_t)this->_data.dig_P5))<<1);
+		var2 = (var2>>2)+(((BMP280_S32_t)this->_data.dig_P4)<<16);
+		var1 = (((this->_data.dig_P3 * (((var1>>2) * (var1>>2)) >> 13 )) >> 3) +
+		        ((((BMP280_S32_t)this->_data.dig_P2) * var1)>>1))>>18;
+		var1 = ((((32768+var1))*((BMP280_S32_t)this->_data.dig_P1))>>15);
+
+		if (var1 == 0) {
+			return 0;  // avoid exception caused by division by zero
+		}
+
+		p = (((BMP280_U32_t)(((BMP280_S32_t)1048576)-adc_P)-(var2>>12)))*3125;
+		if (p < 0x80000000)
+			p = (p << 1) / ((BMP280_U32_t)var1);
+		else
+			p = (p / (BMP280_U32_t)var1) * 2;
+
+		var1 = (((BMP280_S32_t)this->_data.dig_P9) * ((BMP280_S32_t)(((p>>3) * (p>>3))>>13)))>>12;
+		var2 = (((BMP280_S32_t)(p>>2)) * ((BMP280_S32_t)this->_data.dig_P8))>>13;
+
+		p = (BMP280_U32_t)((BMP280_S32_t)p + ((var1 + var2 + this->_data.dig_P7) >> 4));
+		return static_cast<int32_t>(p);
+	}
+#else
+	int32_t Bmp280Sensor::computePressure(int32_t adc_P)
 	{
 		int64_t var1, var2, p;
 
-		int32_t adc_P = this->read24(BMP280_REGISTER_PRESSUREDATA);
 		adc_P >>= 4;
 
 		var1 = ((int64_t)this->_tfine) - 128000;
@@ -111,9 +170,11 @@ namespace lwiot
 		var1 = (((int64_t)this->_data.dig_P9) * (p>>13) * (p>>13)) >> 25;
 		var2 = (((int64_t)this->_data.dig_P8) * p) >> 19;
 
+		/* Q24.8 Pa */
 		p = ((p + var1 + var2) >> 8) + (((int64_t)this->_data.dig_P7)<<4);
-		return static_cast<int32_t>((float)p/256.0);
+		return static_cast<int32_t>(p >> 8);
 	}
+#endif
 
 	int32_t Bmp280Sensor::computeTemperature(int32_t adc_T) const
 	{
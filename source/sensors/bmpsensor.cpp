@@ -14,18 +14,18 @@
 #include <lwiot/log.h>
 #include <lwiot/io/i2cbus.h>
 #include <lwiot/io/i2cmessage.h>
+#include <lwiot/device/registerdevice.h>
 #include <lwiot/device/bmpsensor.h>
 
 namespace lwiot
 {
-	BmpSensor::BmpSensor(uint8_t addr, lwiot::I2CBus &bus) : _addr(addr), _bus(bus)
+	BmpSensor::BmpSensor(uint8_t addr, lwiot::I2CBus &bus) : _regs(bus, addr)
 	{
 	}
 
 	void BmpSensor::write(uint8_t reg, uint8_t value)
 	{
-		const uint8_t data[] = {reg, value};
-		this->_bus.send(this->_addr, data, sizeof(data));
+		this->_regs.write8(reg, value);
 	}
 
 	uint8_t BmpSensor::read8(uint8_t reg)
@@ -83,30 +83,11 @@ namespace lwiot
 
 	bool BmpSensor::read(uint8_t reg, uint8_t *rv, size_t num)
 	{
-		I2CMessage wr(1), rd(num);
-		stl::Vector<I2CMessage> msgs;
-		size_t idx;
-
-		wr.write(reg);
-		wr.setAddress(this->_addr, false, false);
-		wr.setRepeatedStart(true);
-		rd.setAddress(this->_addr, false, true);
-
-		msgs.pushback(stl::move(wr));
-		msgs.pushback(stl::move(rd));
-
-		if(!this->_bus.transfer(msgs)) {
-			print_dbg("Unable to write %u bytes to BMP sensor\n", num);
-			return false;
-		}
-
-		rd = stl::move(msgs.back());
-		idx = 0UL;
-
-		for(auto byte : rd) {
-			rv[idx++] = byte;
-		}
+		return this->_regs.read(reg, rv, num);
+	}
 
-		return true;
+	bool BmpSensor::cache(uint8_t reg, size_t num)
+	{
+		return this->_regs.cache(reg, num);
 	}
 }
@@ -12,15 +12,18 @@
 #include <lwiot/lwiot.h>
 #include <lwiot/types.h>
 #include <lwiot/io/i2cbus.h>
-#include <lwiot/io/i2cmessage.h>
+#include <lwiot/io/gpiochip.h>
+#include <lwiot/device/registerdevice.h>
+#include <lwiot/device/datareadyinterrupt.h>
 #include <lwiot/device/ccs811sensor.h>
 
 #define CCS_HW_ID_CODE 0x81
 #define CCS811_REF_RESISTOR 100000
+#define CCS811_POLL_INTERVAL 10
 
 namespace lwiot
 {
-	Ccs811Sensor::Ccs811Sensor(lwiot::I2CBus &bus) : _bus(bus)
+	Ccs811Sensor::Ccs811Sensor(lwiot::I2CBus &bus) : _regs(bus, SlaveAddress), _collected(0)
 	{
 	}
 
@@ -60,60 +63,51 @@ namespace lwiot
 
 	bool Ccs811Sensor::write(uint8_t reg, uint8_t value)
 	{
-		uint8_t data[] = {reg, value};
-		return this->_bus.send(Ccs811Sensor::SlaveAddress, &data, sizeof data);
+		return this->_regs.write8(reg, value);
 	}
 
 	bool Ccs811Sensor::write(uint8_t reg, const void *data, size_t length)
 	{
-		I2CMessage msg(length + 1);
-
-		msg.setRepeatedStart(false);
-		msg.setAddress(Ccs811Sensor::SlaveAddress, false, false);
-		msg.write(reg);
-
-		if(length && data)
-			msg.write(static_cast<const uint8_t *>(data), length);
-
-		return this->_bus.transfer(msg);
+		return this->_regs.write(reg, static_cast<const uint8_t*>(data), data ? length : 0);
 	}
 
 	bool Ccs811Sensor::read(uint8_t reg, uint8_t *buf, size_t length)
 	{
-		I2CMessage wr(1), rd(length);
-		stl::Vector<I2CMessage> msgs;
+		return this->_regs.read(reg, buf, length);
+	}
 
-		wr.setAddress(SlaveAddress, false, false);
-		wr.setRepeatedStart(true);
-		wr.write(reg);
-		rd.setAddress(SlaveAddress, false, true);
+	void Ccs811Sensor::setInterrupt(bool enabled)
+	{
+		if(enabled)
+			this->_mode.interrupt_datardy = 1;
+		else
+			this->_mode.interrupt_datardy = 0;
 
-		msgs.pushback(stl::move(wr));
-		msgs.pushback(stl::move(rd));
+		this->write(CCS811_MEAS_MODE, this->_mode.get());
+	}
 
-		if(!this->_bus.transfer(msgs)) {
-			print_dbg("Unable to read %u bytes to CCS811 sensor\n", length);
+	bool Ccs811Sensor::enableInterrupt(GpioChip& chip, int pin, bool threshold)
+	{
+		/* nINT is an open drain output that is driven low while a result is waiting. */
+		if(!this->_irq.attach(chip, pin, IrqFalling))
 			return false;
-		}
 
-		rd = stl::move(msgs.back());
-		auto idx = 0UL;
+		this->_mode.interrupt_datardy = 1;
+		this->_mode.interrupt_threshold = threshold ? 1 : 0;
 
-		for(auto byte : rd) {
-			buf[idx++] = byte;
-		}
+		if(this->write(CCS811_MEAS_MODE, this->_mode.get()))
+			return true;
 
-		return true;
+		this->_irq.detach();
+		return false;
 	}
 
-	void Ccs811Sensor::setInterrupt(bool enabled)
+	void Ccs811Sensor::disableInterrupt()
 	{
-		if(enabled)
-			this->_mode.interrupt_datardy = 1;
-		else
-			this->_mode.interrupt_datardy = 0;
-
+		this->_mode.interrupt_datardy = 0;
+		this->_mode.interrupt_threshold = 0;
 		this->write(CCS811_MEAS_MODE, this->_mode.get());
+		this->_irq.detach();
 	}
 
 	bool Ccs811Sensor::available()
@@ -169,14 +163,105 @@ namespace lwiot
 		return ntc_temp - this->_temp_offset;
 	}
 
+	time_t Ccs811Sensor::period() const
+	{
+		switch(this->_mode.drive_mode) {
+		case CCS811_DRIVE_MODE_1SEC:
+			return 1000;
+
+		case CCS811_DRIVE_MODE_10SEC:
+			return 10000;
+
+		case CCS811_DRIVE_MODE_60SEC:
+			return 60000;
+
+		case CCS811_DRIVE_MODE_250MS:
+			return 250;
+
+		default:
+			return 0;
+		}
+	}
+
+	bool Ccs811Sensor::startMeasurement()
+	{
+		auto period = this->period();
+
+		if(period == 0)
+			return false;
+
+		auto due = this->_collected + period;
+		auto now = lwiot_tick_ms();
+
+		this->schedule(due > now ? due - now : 0);
+		return true;
+	}
+
+	bool Ccs811Sensor::ready()
+	{
+		if(this->_irq.attached()) {
+			if(!this->busy())
+				return false;
+
+			if(this->_irq.pending())
+				return true;
+
+			/* With threshold interrupts a result can take many periods; check back without using the bus. */
+			if(this->remaining() == 0)
+				this->schedule(this->period());
+
+			return false;
+		}
+
+		if(!AsyncSensor::ready())
+			return false;
+
+		if(this->available())
+			return true;
+
+		this->schedule(CCS811_POLL_INTERVAL);
+		return false;
+	}
+
+	bool Ccs811Sensor::collect()
+	{
+		if(!this->busy() || (this->remaining() > 0 && !this->_irq.pending()))
+			return false;
+
+		this->complete();
+		this->_irq.clear();
+
+		return this->read();
+	}
+
+	void Ccs811Sensor::await(time_t ms)
+	{
+		if(this->_irq.attached())
+			this->_irq.wait(static_cast<int>(ms));
+		else
+			AsyncSensor::await(ms);
+	}
+
+	size_t Ccs811Sensor::values(float* values, size_t count) const
+	{
+		const float results[] = {static_cast<float>(this->_eco2), static_cast<float>(this->_tvoc)};
+		return AsyncSensor::store(values, count, results, sizeof(results) / sizeof(results[0]));
+	}
+
 	bool Ccs811Sensor::read()
 	{
-		uint8_t buf[8];
+		uint8_t buf[6];
 
-		if(!available())
+		/* eCO2, TVOC, STATUS and ERROR_ID. */
+		if(!this->read(CCS811_ALG_RESULT_DATA, buf, sizeof(buf)))
 			return false;
 
-		this->read(CCS811_ALG_RESULT_DATA, buf, sizeof(buf));
+		this->_status.set(buf[4]);
+
+		if(!this->_status.data_ready)
+			return false;
+
+		this->_collected = lwiot_tick_ms();
 		this->_eco2 = (static_cast<uint16_t>(buf[0]) << 8) | (static_cast<uint16_t>(buf[1]));
 		this->_tvoc = (static_cast<uint16_t>(buf[2]) << 8) | (static_cast<uint16_t>(buf[3]));
 
@@ -188,24 +273,8 @@ namespace lwiot
 
 	uint8_t Ccs811Sensor::read8(uint8_t reg)
 	{
-		I2CMessage wr(1), rd(1);
-		stl::Vector<I2CMessage> msgs;
-
-		wr.setAddress(SlaveAddress, false, false);
-		wr.setRepeatedStart(true);
-		wr.write(reg);
-		rd.setAddress(SlaveAddress, false, true);
-
-		msgs.pushback(stl::move(wr));
-		msgs.pushback(stl::move(rd));
-
-		if(!this->_bus.transfer(msgs)) {
-			print_dbg("Unable to read byte from CCS811 sensor\n");
-			return 0;
-		}
-
-		rd = stl::move(msgs.back());
-		return rd.at(0);
+		uint8_t value;
+		return this->_regs.read8(reg, value) ? value : 0;
 	}
 
 	uint8_t Ccs811Sensor::error()
@@ -218,8 +287,8 @@ namespace lwiot
 
 	void Ccs811Sensor::setThresholds(uint16_t low, uint16_t medium, uint8_t hysteresis)
 	{
-		uint8_t data[] = {(uint8_t)((low >> 8) & 0xF), (uint8_t)(low & 0xF),
-		                  (uint8_t)((medium >> 8) & 0xF), (uint8_t)(medium & 0xF), hysteresis};
+		uint8_t data[] = {(uint8_t)((low >> 8) & 0xFF), (uint8_t)(low & 0xFF),
+		                  (uint8_t)((medium >> 8) & 0xFF), (uint8_t)(medium & 0xFF), hysteresis};
 		this->write(CCS811_THRESHOLDS, data, 5);
 	}
 
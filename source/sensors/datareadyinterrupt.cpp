@@ -0,0 +1,94 @@
+/*
+ * Sensor data ready interrupt.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/io/gpiochip.h>
+#include <lwiot/io/irqslot.h>
+#include <lwiot/device/datareadyinterrupt.h>
+
+namespace lwiot
+{
+#ifdef CONFIG_STANDALONE
+	DataReadyInterrupt::DataReadyInterrupt() : _pending(false)
+	{
+	}
+#else
+	DataReadyInterrupt::DataReadyInterrupt() : _pending(false),
+		_event(EventType::Counting, 1)
+	{
+	}
+#endif
+
+	DataReadyInterrupt::~DataReadyInterrupt()
+	{
+		this->detach();
+	}
+
+	bool DataReadyInterrupt::attach(GpioChip& chip, int pin, IrqEdge edge)
+	{
+		this->_pending = false;
+		chip.input(pin);
+
+		return this->_slot.attach(chip, pin, edge, &DataReadyInterrupt::fire, this);
+	}
+
+	void DataReadyInterrupt::detach()
+	{
+		this->_slot.detach();
+	}
+
+	bool DataReadyInterrupt::attached() const
+	{
+		return this->_slot.attached();
+	}
+
+	bool DataReadyInterrupt::pending() const
+	{
+		return this->_pending;
+	}
+
+	void DataReadyInterrupt::clear()
+	{
+		this->_pending = false;
+	}
+
+	void DataReadyInterrupt::fire(void* arg)
+	{
+		auto irq = static_cast<DataReadyInterrupt*>(arg);
+
+		irq->_pending = true;
+
+#ifndef CONFIG_STANDALONE
+		irq->_event.signalFromIrq();
+#endif
+	}
+
+	bool DataReadyInterrupt::wait(int tmo)
+	{
+		auto deadline = lwiot_tick_ms() + tmo;
+
+		while(!this->_pending) {
+			auto now = lwiot_tick_ms();
+
+			if(now >= deadline)
+				break;
+
+#ifdef CONFIG_STANDALONE
+			lwiot_sleep(1);
+#else
+			/* A signal that was left over from an earlier interrupt only costs a loop. */
+			this->_event.wait(static_cast<int>(deadline - now));
+#endif
+		}
+
+		return this->_pending;
+	}
+}
@@ -11,6 +11,7 @@
 
 #include <lwiot/io/gpiopin.h>
 #include <lwiot/io/dhtbus.h>
+#include <lwiot/stl/smallvector.h>
 #include <lwiot/device/dhtsensor.h>
 
 #ifndef BIT
@@ -19,8 +20,86 @@
 
 namespace lwiot
 {
-	DhtSensor::DhtSensor(const GpioPin& pin, dht_type_t type) : _io(pin), _type(type)
+#define DHT11_INTERVAL 1000
+#define DHT22_INTERVAL 2000
+
+	DhtSensor::DhtSensor(const GpioPin& pin, dht_type_t type) : _io(pin), _type(type), _started(false),
+		_sampled(false), _last(0), _humidity(0.0f), _temperature(0.0f)
+	{
+	}
+
+	DhtSensor::DhtSensor(const GpioPin& pin, EdgeCapture& capture, dht_type_t type) : _io(pin, capture),
+		_type(type), _started(false), _sampled(false), _last(0), _humidity(0.0f), _temperature(0.0f)
+	{
+	}
+
+	time_t DhtSensor::interval() const
+	{
+		return this->_type == DHT11 ? DHT11_INTERVAL : DHT22_INTERVAL;
+	}
+
+	bool DhtSensor::startMeasurement()
+	{
+		auto now = lwiot_tick_ms();
+		time_t wait = 0;
+
+		if(this->_sampled && this->_last + this->interval() > now)
+			wait = this->_last + this->interval() - now;
+
+		this->_started = false;
+		this->schedule(wait);
+
+		return true;
+	}
+
+	bool DhtSensor::ready()
 	{
+		if(!AsyncSensor::ready())
+			return false;
+
+		if(this->_started)
+			return true;
+
+		this->_io.start();
+		this->_started = true;
+		this->schedule(DhtBus::StartTime);
+
+		return false;
+	}
+
+	bool DhtSensor::collect()
+	{
+		int16_t h, t;
+
+		if(!this->ready())
+			return false;
+
+		this->complete();
+		this->_started = false;
+
+		if(!this->read(h, t))
+			return false;
+
+		this->_humidity = static_cast<float>(h) / 10;
+		this->_temperature = static_cast<float>(t) / 10;
+
+		return true;
+	}
+
+	size_t DhtSensor::values(float* values, size_t count) const
+	{
+		const float results[] = {this->_humidity, this->_temperature};
+		return AsyncSensor::store(values, count, results, sizeof(results) / sizeof(results[0]));
+	}
+
+	float DhtSensor::humidity() const
+	{
+		return this->_humidity;
+	}
+
+	float DhtSensor::temperature() const
+	{
+		return this->_temperature;
 	}
 
 	const dht_type_t& DhtSensor::type() const
@@ -48,13 +127,16 @@ namespace lwiot
 
 	bool DhtSensor::read(int16_t& humidity, int16_t& temperature)
 	{
-		stl::Vector<bool> bits(DhtBus::Bits);
+		stl::SmallVector<bool, DhtBus::Bits> bits;
 		uint8_t data[DhtBus::Bits / BITS_PER_BYTE];
 		int idx;
 
 		memset((void*)data, 0, sizeof(data));
 
-		if(!this->_io.read(bits))
+		this->_sampled = true;
+		this->_last = lwiot_tick_ms();
+
+		if(!this->_io.finish(bits))
 			return false;
 
 		idx = 0;
@@ -77,13 +159,11 @@ namespace lwiot
 
 	bool DhtSensor::read(float& humidity, float& temperature)
 	{
-		int16_t h, t;
-
-		if(!this->read(h, t))
+		if(!this->sample(static_cast<int>(this->interval()) + CONFIG_ASYNC_SENSOR_TIMEOUT))
 			return false;
 
-		humidity = static_cast<float>(h) / 10;
-		temperature = static_cast<float>(t) / 10;
+		humidity = this->_humidity;
+		temperature = this->_temperature;
 		return true;
 	}
 }
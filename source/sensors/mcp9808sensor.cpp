@@ -15,6 +15,7 @@
 #include <lwiot/log.h>
 
 #include <lwiot/io/i2cmessage.h>
+#include <lwiot/stl/smallvector.h>
 #include <lwiot/io/i2cbus.h>
 #include <lwiot/kernel/lock.h>
 
@@ -39,10 +40,12 @@
 #define MCP9808_REG_MANUF_ID 0x06
 #define MCP9808_REG_DEVICE_ID 0x07
 #define MCP9808_REG_RESOLUTION 0x08
+#define MCP9808_RESOLUTION_DEFAULT 3
 
 namespace lwiot
 {
-	MCP9808Sensor::MCP9808Sensor() : _lock(false)
+	MCP9808Sensor::MCP9808Sensor() : _lock(false), _resolution(MCP9808_RESOLUTION_DEFAULT), _woken(0),
+		_temperature(NAN)
 	{
 	}
 
@@ -63,6 +66,7 @@ namespace lwiot
 			return false;
 
 		this->write16(MCP9808_REG_CONFIG, 0);
+		this->_woken = lwiot_tick_ms();
 		return true;
 	}
 
@@ -84,6 +88,7 @@ namespace lwiot
 		conf_reg = this->read16(MCP9808_REG_CONFIG);
 		conf = conf_reg & ~MCP9808_REG_CONFIG_SHUTDOWN;
 		this->write16(MCP9808_REG_CONFIG, conf);
+		this->_woken = lwiot_tick_ms();
 	}
 
 	void MCP9808Sensor::setResolution(int resolution)
@@ -92,6 +97,55 @@ namespace lwiot
 
 		reso = resolution & 0x3;
 		this->write8(MCP9808_REG_RESOLUTION, reso);
+		this->_resolution = reso;
+	}
+
+	time_t MCP9808Sensor::conversionTime() const
+	{
+		switch(this->_resolution) {
+		case 0:
+			return 30;
+
+		case 1:
+			return 65;
+
+		case 2:
+			return 130;
+
+		default:
+			return 250;
+		}
+	}
+
+	bool MCP9808Sensor::startMeasurement()
+	{
+		auto due = this->_woken + this->conversionTime();
+		auto now = lwiot_tick_ms();
+
+		this->schedule(due > now ? due - now : 0);
+		return true;
+	}
+
+	bool MCP9808Sensor::collect()
+	{
+		if(!this->ready())
+			return false;
+
+		this->complete();
+		this->_temperature = this->read();
+
+		return !isnan(this->_temperature);
+	}
+
+	size_t MCP9808Sensor::values(float* values, size_t count) const
+	{
+		const float results[] = {this->_temperature};
+		return AsyncSensor::store(values, count, results, sizeof(results) / sizeof(results[0]));
+	}
+
+	float MCP9808Sensor::temperature() const
+	{
+		return this->_temperature;
 	}
 
 	float MCP9808Sensor::read()
@@ -115,7 +169,7 @@ namespace lwiot
 	uint8_t MCP9808Sensor::read8(uint8_t reg)
 	{
 		I2CMessage rx(1), tx(1);
-		stl::Vector<I2CMessage> msgs;
+		stl::SmallVector<I2CMessage, 2> msgs;
 
 		tx.setAddress(this->_addr, false, false);
 		tx.write(reg);
@@ -166,7 +220,7 @@ namespace lwiot
 	uint16_t MCP9808Sensor::read16(uint8_t reg)
 	{
 		I2CMessage rx(2), tx(1);
-		stl::Vector<I2CMessage> msgs;
+		stl::SmallVector<I2CMessage, 2> msgs;
 		uint16_t value;
 
 		tx.setAddress(this->_addr, false, false);
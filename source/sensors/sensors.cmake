@@ -1,4 +1,6 @@
 SET(SENSOR_SOURCES
+	sensors/asyncsensor.cpp
+	sensors/datareadyinterrupt.cpp
 	sensors/dhtsensor.cpp
 	sensors/bmpsensor.cpp
 	sensors/bmp085sensor.cpp
@@ -0,0 +1,86 @@
+/*
+ * Timer driven sensor sampling.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/kernel/timer.h>
+#include <lwiot/device/asyncsensor.h>
+#include <lwiot/device/sensorsampler.h>
+
+namespace lwiot
+{
+	SensorSampler::SensorSampler(AsyncSensor& sensor, time_t interval, const Handler& handler) :
+		Timer("sampler", static_cast<unsigned long>(interval), Continuous, nullptr),
+		_sensor(sensor), _interval(interval), _handler(handler), _started(0)
+	{
+	}
+
+	AsyncSensor& SensorSampler::sensor() const
+	{
+		return this->_sensor;
+	}
+
+	time_t SensorSampler::interval() const
+	{
+		return this->_interval;
+	}
+
+	void SensorSampler::start()
+	{
+		this->trigger();
+		Timer::start();
+	}
+
+	void SensorSampler::arm(time_t ms)
+	{
+		this->setPeriod(static_cast<unsigned long>(ms));
+		this->reset();
+	}
+
+	void SensorSampler::trigger()
+	{
+		this->_started = lwiot_tick_ms();
+
+		if(this->_sensor.startMeasurement()) {
+			this->setPeriod(static_cast<unsigned long>(this->_sensor.remaining()));
+			return;
+		}
+
+		this->setPeriod(static_cast<unsigned long>(this->_interval));
+
+		if(this->_handler)
+			this->_handler(this->_sensor, false);
+	}
+
+	void SensorSampler::tick()
+	{
+		if(this->_sensor.busy()) {
+			if(!this->_sensor.ready()) {
+				this->arm(this->_sensor.remaining());
+				return;
+			}
+
+			auto ok = this->_sensor.collect();
+
+			if(this->_handler)
+				this->_handler(this->_sensor, ok);
+
+			auto elapsed = lwiot_tick_ms() - this->_started;
+
+			if(elapsed < this->_interval) {
+				this->arm(this->_interval - elapsed);
+				return;
+			}
+		}
+
+		this->trigger();
+		this->reset();
+	}
+}
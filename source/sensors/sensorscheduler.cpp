@@ -0,0 +1,272 @@
+/*
+ * Multi-sensor sampling scheduler.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/error.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/io/i2cbus.h>
+#include <lwiot/kernel/timer.h>
+#include <lwiot/device/asyncsensor.h>
+#include <lwiot/device/sensorscheduler.h>
+
+namespace lwiot
+{
+	SensorScheduler::SensorScheduler() : Timer("sensors", CONFIG_SENSOR_SCHEDULER_GRANULARITY, Continuous, nullptr),
+		_lock(false), _running(false), _epoch(0), _dropped(0), _overruns(0), _wakeups(0)
+	{
+	}
+
+	SensorScheduler::~SensorScheduler()
+	{
+		this->stop();
+	}
+
+	int SensorScheduler::add(AsyncSensor& sensor, time_t period, time_t conversion)
+	{
+		return this->add(sensor, I2CBus(), period, conversion);
+	}
+
+	int SensorScheduler::add(AsyncSensor& sensor, const I2CBus& bus, time_t period, time_t conversion)
+	{
+		ScopedLock lock(this->_lock);
+		Entry entry;
+
+		if(period <= 0)
+			return -EINVALID;
+
+		/* Round the period up to the granularity, so that related periods share sample times. */
+		period = (period + CONFIG_SENSOR_SCHEDULER_GRANULARITY - 1) / CONFIG_SENSOR_SCHEDULER_GRANULARITY;
+		period *= CONFIG_SENSOR_SCHEDULER_GRANULARITY;
+
+		entry.sensor = &sensor;
+		entry.bus = bus;
+		entry.shared = bus.algorithm() != nullptr;
+		entry.period = period;
+		entry.conversion = conversion < period ? conversion : period;
+		entry.due = 0;
+		entry.started = 0;
+		entry.learn = conversion <= 0;
+
+		if(this->_running) {
+			auto now = lwiot_tick_ms();
+
+			this->align(entry, now);
+			this->_entries.push_back(stl::move(entry));
+			this->arm(now);
+		} else {
+			this->_entries.push_back(stl::move(entry));
+		}
+
+		return static_cast<int>(this->_entries.size() - 1);
+	}
+
+	void SensorScheduler::start()
+	{
+		ScopedLock lock(this->_lock);
+
+		if(this->_running)
+			return;
+
+		auto now = lwiot_tick_ms();
+
+		this->_epoch = now;
+		this->_running = true;
+
+		for(auto& entry : this->_entries)
+			this->align(entry, now);
+
+		Timer::start();
+		this->arm(now);
+	}
+
+	void SensorScheduler::stop()
+	{
+		ScopedLock lock(this->_lock);
+
+		if(!this->_running)
+			return;
+
+		this->_running = false;
+		Timer::stop();
+	}
+
+	bool SensorScheduler::read(SensorReading& reading)
+	{
+		return this->_readings.pop(reading);
+	}
+
+	size_t SensorScheduler::available() const
+	{
+		return this->_readings.size();
+	}
+
+	uint32_t SensorScheduler::dropped() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_dropped;
+	}
+
+	uint32_t SensorScheduler::overruns() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_overruns;
+	}
+
+	uint32_t SensorScheduler::wakeups() const
+	{
+		ScopedLock lock(this->_lock);
+		return this->_wakeups;
+	}
+
+	bool SensorScheduler::sameBus(const Entry& a, const Entry& b)
+	{
+		return a.shared && b.shared && a.bus.algorithm() == b.bus.algorithm();
+	}
+
+	void SensorScheduler::align(Entry& entry, time_t now)
+	{
+		auto earliest = now + entry.conversion - this->_epoch;
+		auto samples = (earliest + entry.period - 1) / entry.period;
+
+		entry.due = this->_epoch + samples * entry.period;
+	}
+
+	void SensorScheduler::push(size_t id, const Entry& entry, bool ok)
+	{
+		SensorReading reading;
+
+		reading.sensor = static_cast<int>(id);
+		reading.timestamp = lwiot_tick_ms();
+		reading.ok = ok;
+		reading.count = 0;
+
+		if(ok)
+			reading.count = static_cast<uint8_t>(entry.sensor->values(reading.values, CONFIG_SENSOR_READING_VALUES));
+
+		if(!this->_readings.push(reading))
+			this->_dropped++;
+	}
+
+	void SensorScheduler::collect(size_t id, Entry& entry)
+	{
+		auto ok = entry.sensor->collect();
+		auto now = lwiot_tick_ms();
+
+		this->push(id, entry, ok);
+
+		if(entry.learn) {
+			auto conversion = now - entry.started;
+			entry.conversion = conversion < entry.period ? conversion : entry.period;
+		}
+
+		entry.due += entry.period;
+
+		while(entry.due <= now) {
+			entry.due += entry.period;
+			this->_overruns++;
+		}
+	}
+
+	void SensorScheduler::trigger(size_t id, Entry& entry, time_t now)
+	{
+		entry.started = now;
+
+		if(entry.sensor->startMeasurement()) {
+			/* Sensors that are ready right away are collected in the same batch. */
+			if(entry.sensor->remaining() == 0 && entry.sensor->ready())
+				this->collect(id, entry);
+
+			return;
+		}
+
+		this->push(id, entry, false);
+		entry.due += entry.period;
+	}
+
+	void SensorScheduler::batch(size_t first, time_t now)
+	{
+		auto& head = this->_entries[first];
+
+		if(head.shared)
+			head.bus.lock();
+
+		for(size_t idx = first; idx < this->_entries.size(); idx++) {
+			auto& entry = this->_entries[idx];
+
+			if(idx != first && !sameBus(head, entry))
+				continue;
+
+			if(entry.sensor->busy()) {
+				if(entry.sensor->ready())
+					this->collect(idx, entry);
+
+				continue;
+			}
+
+			if(entry.due - entry.conversion <= now + CONFIG_SENSOR_SCHEDULER_SLACK)
+				this->trigger(idx, entry, now);
+		}
+
+		if(head.shared)
+			head.bus.unlock();
+	}
+
+	void SensorScheduler::arm(time_t now)
+	{
+		time_t next = 0;
+		bool first = true;
+
+		for(auto& entry : this->_entries) {
+			time_t at;
+
+			if(entry.sensor->busy()) {
+				auto remaining = entry.sensor->remaining();
+				at = now + (remaining > 0 ? remaining : 1);
+			} else {
+				at = entry.due - entry.conversion;
+			}
+
+			if(first || at < next)
+				next = at;
+
+			first = false;
+		}
+
+		if(first)
+			return;
+
+		this->setPeriod(static_cast<unsigned long>(next > now ? next - now : 1));
+		this->reset();
+	}
+
+	void SensorScheduler::tick()
+	{
+		ScopedLock lock(this->_lock);
+
+		if(!this->_running)
+			return;
+
+		auto now = lwiot_tick_ms();
+		this->_wakeups++;
+
+		for(size_t idx = 0; idx < this->_entries.size(); idx++) {
+			bool handled = false;
+
+			for(size_t prev = 0; prev < idx && !handled; prev++)
+				handled = sameBus(this->_entries[prev], this->_entries[idx]);
+
+			if(!handled)
+				this->batch(idx, now);
+		}
+
+		this->arm(lwiot_tick_ms());
+	}
+}
@@ -79,6 +79,19 @@ namespace lwiot
 
 	/* COPYRIGHT Adafruit industries */
 	bool Sgp30Sensor::read(uint8_t *cmd, int len, uint16_t ms, uint16_t *result, int readlen)
+	{
+		if(!this->command(cmd, len))
+			return false;
+
+		lwiot_sleep(ms);
+
+		if(readlen == 0)
+			return true;
+
+		return this->response(result, readlen);
+	}
+
+	bool Sgp30Sensor::command(uint8_t *cmd, int len)
 	{
 		I2CMessage tx(len);
 
@@ -86,19 +99,18 @@ namespace lwiot
 		tx.setRepeatedStart(false);
 		tx.markAsReadOperation(false);
 
-		for(auto idx = 0; idx < len; idx++)
-			tx.write(cmd[idx]);
+		tx.append(cmd, len);
 
 		if(!this->_bus->transfer(tx)) {
 			print_dbg("Unable to write SGP30 command!\n");
 			return false;
 		}
 
-		lwiot_sleep(ms);
-
-		if(readlen == 0)
-			return true;
+		return true;
+	}
 
+	bool Sgp30Sensor::response(uint16_t *result, int readlen)
+	{
 		auto rxlen = readlen * (SGP30_WORD_LEN + 1);
 		I2CMessage rx(rxlen);
 
@@ -136,19 +148,46 @@ namespace lwiot
 		return this->read(cmd, sizeof(cmd), 10);
 	}
 
-	bool Sgp30Sensor::measure()
+#define MEASUREMENT_DELAY 12
+	bool Sgp30Sensor::startMeasurement()
 	{
 		uint8_t cmd[2];
-		uint16_t reply[2];
 
 		cmd[0] = 0x20;
 		cmd[1] = 0x08;
 
-		if(!this->read(cmd, sizeof(cmd), 12, reply, 2))
+		if(!this->command(cmd, sizeof(cmd)))
+			return false;
+
+		this->schedule(MEASUREMENT_DELAY);
+		return true;
+	}
+
+	bool Sgp30Sensor::collect()
+	{
+		uint16_t reply[2];
+
+		if(!this->ready())
+			return false;
+
+		this->complete();
+
+		if(!this->response(reply, 2))
 			return false;
 
 		this->_co2 = reply[0];
 		this->_tvoc = reply[1];
 		return true;
 	}
+
+	size_t Sgp30Sensor::values(float* values, size_t count) const
+	{
+		const float results[] = {static_cast<float>(this->_co2), static_cast<float>(this->_tvoc)};
+		return AsyncSensor::store(values, count, results, sizeof(results) / sizeof(results[0]));
+	}
+
+	bool Sgp30Sensor::measure()
+	{
+		return this->sample();
+	}
 }
@@ -34,15 +34,15 @@ static uint8_t crc8(const uint8_t *data, int len)
 
 namespace lwiot
 {
-	Sht31Sensor::Sht31Sensor()
+	Sht31Sensor::Sht31Sensor() : _result{0, 0, false}
 	{
 	}
 
-	Sht31Sensor::Sht31Sensor(lwiot::I2CBus &io) : _bus(io)
+	Sht31Sensor::Sht31Sensor(lwiot::I2CBus &io) : _bus(io), _result{0, 0, false}
 	{
 	}
 
-	void Sht31Sensor::writeCommaned(uint16_t cmd)
+	bool Sht31Sensor::writeCommaned(uint16_t cmd)
 	{
 		lwiot::I2CMessage tx(2);
 
@@ -55,17 +55,55 @@ namespace lwiot
 
 		if(!this->_bus->transfer(tx)) {
 			print_dbg("Unable to write SHT31 command!\n");
+			return false;
 		}
+
+		return true;
 	}
 
-	double Sht31Sensor::temperature()
+	double Sht31Sensor::temperature() const
 	{
-		return this->_result.temperature;
+		if(!this->_result.valid)
+			return 0.0;
+
+#ifdef CONFIG_SENSOR_FIXED_POINT
+		return this->temperatureMilliCelsius() / 1000.0;
+#else
+		/* Algorithm taken from Sensiron datasheet */
+		return -45.0 + 175.0 * this->_result.temperature / 0xFFFF;
+#endif
 	}
 
-	double Sht31Sensor::humidity()
+	double Sht31Sensor::humidity() const
 	{
-		return this->_result.humidity;
+		if(!this->_result.valid)
+			return 0.0;
+
+#ifdef CONFIG_SENSOR_FIXED_POINT
+		return this->humidityMilliPercent() / 1000.0;
+#else
+		return 100.0 * this->_result.humidity / 0xFFFF;
+#endif
+	}
+
+	/*
+	 * Sensirion reference conversion: T = -45 + 175 * ST / 2^16 and RH = 100 * SRH / 2^16,
+	 * scaled by 1000 and with the constants premultiplied so that the products fit 32 bits.
+	 */
+	int32_t Sht31Sensor::temperatureMilliCelsius() const
+	{
+		if(!this->_result.valid)
+			return 0;
+
+		return ((21875 * static_cast<int32_t>(this->_result.temperature)) >> 13) - 45000;
+	}
+
+	int32_t Sht31Sensor::humidityMilliPercent() const
+	{
+		if(!this->_result.valid)
+			return 0;
+
+		return (12500 * static_cast<int32_t>(this->_result.humidity)) >> 13;
 	}
 
 	void Sht31Sensor::setHeaterStatus(bool enable)
@@ -85,36 +123,51 @@ namespace lwiot
 	bool Sht31Sensor::begin()
 	{
 		this->reset();
-		this->_result.humidity = 0.0;
-		this->_result.temperature = 0.0;
+		this->_result.valid = false;
 
 		return true;
 	}
 
+#define MEASUREMENT_DELAY 20
+	bool Sht31Sensor::startMeasurement()
+	{
+		if(!this->writeCommaned(SHT31_MEAS_HIGHREP))
+			return false;
+
+		this->schedule(MEASUREMENT_DELAY);
+		return true;
+	}
+
 	void Sht31Sensor::measure()
+	{
+		this->sample();
+	}
+
+	bool Sht31Sensor::collect()
 	{
 		I2CMessage rx(6);
 		uint16_t st, srh;
 
-		this->writeCommaned(SHT31_MEAS_HIGHREP);
-		lwiot_sleep(20);
+		if(!this->ready())
+			return false;
 
+		this->complete();
 		rx.setAddress(SHT31_DEFAULT_ADDR, false);
 		rx.markAsReadOperation(true);
 		rx.setRepeatedStart(false);
 
 		if(!this->_bus->transfer(rx)) {
 			print_dbg("Unable to measure SHT31");
+			return false;
 		}
 
-		/* Algorithm taken from Sensiron datasheet */
 		st = rx[0];
 		st <<= 8;
 		st |= rx[1];
 
 		if(rx[2] != crc8(rx.data(), 2)) {
 			print_dbg("SHT31 CRC8 1 failed!\n");
-			return;
+			return false;
 		}
 
 		srh = rx[3];
@@ -123,29 +176,30 @@ namespace lwiot
 
 		if(rx[5] != crc8(rx.data() + 3, 2)) {
 			print_dbg("SHT31 CRC8 2 failed!\n");
-			return;
+			return false;
 		}
 
-		double stemp = st;
-		double shum = srh;
-
-		stemp *= 175;
-		stemp /= 0xffff;
-		stemp = -45 + stemp;
-		this->_result.temperature = stemp;
+		this->_result.temperature = st;
+		this->_result.humidity = srh;
+		this->_result.valid = true;
 
-		//  Serial.print("SRH = "); Serial.println(SRH);
-		shum *= 100;
-		shum /= 0xFFFF;
+		return true;
+	}
 
-		this->_result.humidity = shum;
+	size_t Sht31Sensor::values(float* values, size_t count) const
+	{
+#ifdef CONFIG_SENSOR_FIXED_POINT
+		const float results[] = {this->temperatureMilliCelsius() / 1000.0f, this->humidityMilliPercent() / 1000.0f};
+#else
+		const float results[] = {static_cast<float>(this->temperature()), static_cast<float>(this->humidity())};
+#endif
+		return AsyncSensor::store(values, count, results, sizeof(results) / sizeof(results[0]));
 	}
 
 	void Sht31Sensor::setBus(lwiot::I2CBus &io)
 	{
 		this->_bus = io;
-		this->_result.humidity = 0.0;
-		this->_result.temperature = 0.0;
+		this->_result.valid = false;
 
 		this->reset();
 	}
@@ -0,0 +1,132 @@
+/*
+ * Allocation tracking for tests.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/util/allocationguard.h>
+
+#ifdef CONFIG_ALLOC_TRACKING
+#include <new>
+
+namespace
+{
+	struct AllocationCounters {
+		size_t allocations;
+		size_t frees;
+		size_t bytes;
+	};
+
+	thread_local AllocationCounters counters = { 0, 0, 0 };
+}
+
+extern "C" void lwiot_mem_track_alloc(size_t size)
+{
+	counters.allocations++;
+	counters.bytes += size;
+}
+
+extern "C" void lwiot_mem_track_free(void)
+{
+	counters.frees++;
+}
+
+/*
+ * Route new and delete through the port, so that objects are counted like every other
+ * allocation.
+ */
+void *operator new(size_t size)
+{
+	auto ptr = lwiot_mem_alloc(size != 0 ? size : 1);
+
+	if(ptr == nullptr)
+		throw std::bad_alloc();
+
+	return ptr;
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+	lwiot_mem_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	lwiot_mem_free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+	lwiot_mem_free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+	lwiot_mem_free(ptr);
+}
+#endif
+
+namespace lwiot
+{
+	ScopedAllocationGuard::ScopedAllocationGuard(size_t limit) : _limit(limit)
+	{
+		this->reset();
+	}
+
+	void ScopedAllocationGuard::reset()
+	{
+#ifdef CONFIG_ALLOC_TRACKING
+		this->_allocations = counters.allocations;
+		this->_frees = counters.frees;
+		this->_bytes = counters.bytes;
+#else
+		this->_allocations = this->_frees = this->_bytes = 0;
+#endif
+	}
+
+	size_t ScopedAllocationGuard::allocations() const
+	{
+#ifdef CONFIG_ALLOC_TRACKING
+		return counters.allocations - this->_allocations;
+#else
+		return 0;
+#endif
+	}
+
+	size_t ScopedAllocationGuard::frees() const
+	{
+#ifdef CONFIG_ALLOC_TRACKING
+		return counters.frees - this->_frees;
+#else
+		return 0;
+#endif
+	}
+
+	size_t ScopedAllocationGuard::bytes() const
+	{
+#ifdef CONFIG_ALLOC_TRACKING
+		return counters.bytes - this->_bytes;
+#else
+		return 0;
+#endif
+	}
+
+	bool ScopedAllocationGuard::ok() const
+	{
+		if(this->_limit == 0)
+			return this->allocations() == 0;
+
+		return this->bytes() <= this->_limit;
+	}
+}
@@ -0,0 +1,146 @@
+/*
+ * Monotonic arena allocator.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/util/arenaallocator.h>
+
+namespace lwiot
+{
+	Arena::Arena(size_t blocksize) : _head(nullptr), _external(nullptr), _finalizers(nullptr), _blocksize(blocksize)
+	{
+	}
+
+	Arena::Arena(void *buffer, size_t size) : Arena(DefaultBlockSize)
+	{
+		if(buffer == nullptr || size <= sizeof(Block))
+			return;
+
+		this->_external = static_cast<Block *>(buffer);
+		this->_external->next = nullptr;
+		this->_external->size = size - sizeof(Block);
+		this->_external->used = 0;
+		this->_head = this->_external;
+	}
+
+	Arena::~Arena()
+	{
+		this->reset();
+		this->release();
+	}
+
+	void *Arena::allocate(size_t size, size_t alignment)
+	{
+		void *data = nullptr;
+
+		if(this->_head != nullptr)
+			data = this->allocate(this->_head, size, alignment);
+
+		if(data != nullptr)
+			return data;
+
+		auto blocksize = size + alignment > this->_blocksize ? size + alignment : this->_blocksize;
+		auto block = this->allocateBlock(blocksize);
+
+		if(block == nullptr)
+			return nullptr;
+
+		block->next = this->_head;
+		this->_head = block;
+
+		return this->allocate(block, size, alignment);
+	}
+
+	void Arena::reset()
+	{
+		for(auto fin = this->_finalizers; fin != nullptr; fin = fin->next)
+			fin->destroy(fin->data, fin->num);
+
+		this->_finalizers = nullptr;
+
+		if(this->_head == nullptr)
+			return;
+
+		if(this->_head->next == nullptr) {
+			this->_head->used = 0;
+			return;
+		}
+
+		auto peak = this->used();
+
+		this->release();
+
+		if(peak > this->_blocksize)
+			this->_blocksize = peak;
+	}
+
+	size_t Arena::used() const
+	{
+		size_t total = 0;
+
+		for(auto block = this->_head; block != nullptr; block = block->next)
+			total += block->used;
+
+		return total;
+	}
+
+	size_t Arena::capacity() const
+	{
+		size_t total = 0;
+
+		for(auto block = this->_head; block != nullptr; block = block->next)
+			total += block->size;
+
+		return total;
+	}
+
+	void *Arena::allocate(Block *block, size_t size, size_t alignment)
+	{
+		auto base = reinterpret_cast<uintptr_t>(block + 1);
+		auto current = base + block->used;
+		auto aligned = (current + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+
+		if(aligned + size > base + block->size)
+			return nullptr;
+
+		block->used = aligned + size - base;
+		return reinterpret_cast<void *>(aligned);
+	}
+
+	Arena::Block *Arena::allocateBlock(size_t size)
+	{
+		auto block = static_cast<Block *>(lwiot_mem_alloc(sizeof(Block) + size));
+
+		if(block == nullptr)
+			return nullptr;
+
+		block->next = nullptr;
+		block->size = size;
+		block->used = 0;
+
+		return block;
+	}
+
+	void Arena::release()
+	{
+		for(auto block = this->_head; block != nullptr;) {
+			auto next = block->next;
+
+			if(block != this->_external)
+				lwiot_mem_free(block);
+
+			block = next;
+		}
+
+		this->_head = this->_external;
+
+		if(this->_external != nullptr)
+			this->_external->used = 0;
+	}
+}
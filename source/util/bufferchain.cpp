@@ -0,0 +1,72 @@
+/*
+ * Scatter/gather buffer chain.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/bytebuffer.h>
+#include <lwiot/bufferchain.h>
+
+namespace lwiot
+{
+	BufferChain::BufferChain() : _segments(), _length(0)
+	{
+	}
+
+	BufferChain::BufferChain(size_t segments) : _segments(segments), _length(0)
+	{
+	}
+
+	BufferChain& BufferChain::append(const void *data, size_t length)
+	{
+		if(data == nullptr || length == 0)
+			return *this;
+
+		this->_segments.emplace_back(const_cast<void*>(data), length);
+		this->_length += length;
+
+		return *this;
+	}
+
+	BufferChain& BufferChain::append(const RawBuffer& raw)
+	{
+		return this->append(raw.buffer(), raw.size());
+	}
+
+	BufferChain& BufferChain::append(const ByteBuffer& buffer)
+	{
+		return this->append(buffer.data(), buffer.index());
+	}
+
+	void BufferChain::clear()
+	{
+		this->_segments.clear();
+		this->_length = 0;
+	}
+
+	size_t BufferChain::copyTo(void *output, size_t length) const
+	{
+		auto dst = static_cast<uint8_t*>(output);
+		size_t copied = 0;
+
+		for(const auto& segment : this->_segments) {
+			auto num = segment.size();
+
+			if(num > length - copied)
+				num = length - copied;
+
+			memcpy(dst + copied, segment.buffer(), num);
+			copied += num;
+
+			if(copied == length)
+				break;
+		}
+
+		return copied;
+	}
+}
@@ -36,6 +36,22 @@ namespace lwiot
 		this->move(other);
 	}
 
+	ByteBuffer::ByteBuffer(uint8_t *external, size_t size) :
+		Countable(size), _index(size), _data(external), _exactfit(true), _default(0)
+	{
+	}
+
+	uint8_t *ByteBuffer::release()
+	{
+		auto data = this->_data;
+
+		this->_data = nullptr;
+		this->_count = 0;
+		this->_index = 0;
+
+		return data;
+	}
+
 	ByteBuffer::~ByteBuffer()
 	{
 		if(this->_data)
@@ -148,10 +164,10 @@ namespace lwiot
 		size_t needed, avail;
 		const uint8_t *bytes = (const uint8_t*) data;
 
-		if(unlikely(bytes == nullptr)) {
+		if(unlikely(this->_data == nullptr)) {
 			auto size = num >= BYTEBUFFER_DEFAULT_SIZE ? num : BYTEBUFFER_DEFAULT_SIZE;
 			this->_data = static_cast<uint8_t *>(lwiot_mem_zalloc(size));
-			this->_count = BYTEBUFFER_DEFAULT_SIZE;
+			this->_count = size;
 			this->_index = 0;
 		}
 
@@ -174,6 +190,23 @@ namespace lwiot
 		this->_index += num;
 	}
 
+	ByteBuffer& ByteBuffer::append(const uint8_t *bytes, size_t num)
+	{
+		if(unlikely(num == 0))
+			return *this;
+
+		this->reserveExact(this->_index + num);
+		this->writeUnchecked(bytes, num);
+
+		return *this;
+	}
+
+	void ByteBuffer::reserveExact(size_t size)
+	{
+		if(size > this->count())
+			this->grow(size - this->count());
+	}
+
 	bool ByteBuffer::operator !=(const ByteBuffer& rhs) const
 	{
 		return !(*this == rhs);
@@ -0,0 +1,382 @@
+/*
+ * CBOR encoder and decoder.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/util/cbor.h>
+#include <lwiot/util/samplebatch.h>
+
+#define CBOR_FALSE      0xF4
+#define CBOR_TRUE       0xF5
+#define CBOR_NULL       0xF6
+#define CBOR_UNDEFINED  0xF7
+#define CBOR_HALF       0xF9
+#define CBOR_FLOAT      0xFA
+#define CBOR_DOUBLE     0xFB
+#define CBOR_BREAK      0xFF
+#define CBOR_INDEFINITE 31
+
+namespace lwiot
+{
+	CborWriter::CborWriter(ByteBuffer &output) : _output(output)
+	{
+	}
+
+	/* Room for \p length more bytes. The buffer doubles, so writing item by item stays cheap. */
+	uint8_t* CborWriter::reserve(size_t length)
+	{
+		auto index = this->_output.index();
+
+		if(index + length > this->_output.count()) {
+			auto size = this->_output.count() * 2;
+			this->_output.reserveExact(size > index + length ? size : index + length);
+		}
+
+		this->_output.setIndex(index + length);
+		return this->_output.data() + index;
+	}
+
+	CborWriter& CborWriter::head(uint8_t major, uint64_t value)
+	{
+		uint8_t *out;
+		size_t bytes;
+		uint8_t info;
+
+		major <<= 5;
+
+		if(value < 24) {
+			*this->reserve(1) = major | static_cast<uint8_t>(value);
+			return *this;
+		} else if(value <= UINT8_MAX) {
+			bytes = 1;
+			info = 24;
+		} else if(value <= UINT16_MAX) {
+			bytes = 2;
+			info = 25;
+		} else if(value <= UINT32_MAX) {
+			bytes = 4;
+			info = 26;
+		} else {
+			bytes = 8;
+			info = 27;
+		}
+
+		out = this->reserve(bytes + 1);
+		*out++ = major | info;
+
+		for(size_t idx = bytes; idx > 0; idx--) {
+			out[idx - 1] = static_cast<uint8_t>(value & 0xFF);
+			value >>= 8;
+		}
+
+		return *this;
+	}
+
+	CborWriter& CborWriter::beginArray(size_t size)
+	{
+		return this->head(Array, size);
+	}
+
+	CborWriter& CborWriter::beginMap(size_t size)
+	{
+		return this->head(Map, size);
+	}
+
+	CborWriter& CborWriter::beginArray()
+	{
+		*this->reserve(1) = (Array << 5) | CBOR_INDEFINITE;
+		return *this;
+	}
+
+	CborWriter& CborWriter::beginMap()
+	{
+		*this->reserve(1) = (Map << 5) | CBOR_INDEFINITE;
+		return *this;
+	}
+
+	CborWriter& CborWriter::end()
+	{
+		*this->reserve(1) = CBOR_BREAK;
+		return *this;
+	}
+
+	CborWriter& CborWriter::write(bool value)
+	{
+		*this->reserve(1) = value ? CBOR_TRUE : CBOR_FALSE;
+		return *this;
+	}
+
+	CborWriter& CborWriter::write(float value)
+	{
+		uint32_t bits;
+		auto out = this->reserve(5);
+
+		memcpy(&bits, &value, sizeof(bits));
+		*out++ = CBOR_FLOAT;
+
+		for(int idx = 3; idx >= 0; idx--) {
+			out[idx] = static_cast<uint8_t>(bits & 0xFF);
+			bits >>= 8;
+		}
+
+		return *this;
+	}
+
+	CborWriter& CborWriter::write(const SampleBatch &batch)
+	{
+		auto size = batch.size();
+		auto timestamps = batch.timestamps();
+		auto sensors = batch.sensors();
+		auto values = batch.values();
+		auto base = static_cast<int64_t>(size > 0 ? timestamps[0] : 0);
+
+		this->beginMap(4);
+		this->write("t").write(base);
+		this->write("dt").beginArray(size);
+
+		for(size_t idx = 0; idx < size; idx++)
+			this->write(static_cast<int64_t>(timestamps[idx]) - base);
+
+		this->write("s").beginArray(size);
+
+		for(size_t idx = 0; idx < size; idx++)
+			this->write(sensors[idx]);
+
+		this->write("v").beginArray(size);
+
+		for(size_t idx = 0; idx < size; idx++)
+			this->write(values[idx]);
+
+		return *this;
+	}
+
+	CborWriter& CborWriter::write(double value)
+	{
+		uint64_t bits;
+
+		if(static_cast<double>(static_cast<float>(value)) == value || isnan(value))
+			return this->write(static_cast<float>(value));
+
+		auto out = this->reserve(9);
+
+		memcpy(&bits, &value, sizeof(bits));
+		*out++ = CBOR_DOUBLE;
+
+		for(int idx = 7; idx >= 0; idx--) {
+			out[idx] = static_cast<uint8_t>(bits & 0xFF);
+			bits >>= 8;
+		}
+
+		return *this;
+	}
+
+	CborWriter& CborWriter::write(const char *value)
+	{
+		if(value == nullptr)
+			return this->writeNull();
+
+		return this->write(StringView(value));
+	}
+
+	CborWriter& CborWriter::write(const String& value)
+	{
+		return this->write(StringView(value));
+	}
+
+	CborWriter& CborWriter::write(const StringView& value)
+	{
+		this->head(Text, value.length());
+		memcpy(this->reserve(value.length()), value.data(), value.length());
+
+		return *this;
+	}
+
+	CborWriter& CborWriter::writeBytes(const void *data, size_t length)
+	{
+		this->head(Bytes, length);
+		memcpy(this->reserve(length), data, length);
+
+		return *this;
+	}
+
+	CborWriter& CborWriter::writeNull()
+	{
+		*this->reserve(1) = CBOR_NULL;
+		return *this;
+	}
+
+	CborReader::CborReader(const void *data, size_t length) :
+		_data(static_cast<const uint8_t *>(data)), _length(length), _pos(0)
+	{
+	}
+
+	bool CborReader::argument(uint8_t info, uint64_t &value)
+	{
+		size_t bytes;
+
+		if(info < 24) {
+			value = info;
+			return true;
+		}
+
+		if(info > 27)
+			return false;
+
+		bytes = static_cast<size_t>(1) << (info - 24);
+
+		if(this->_length - this->_pos < bytes)
+			return false;
+
+		value = 0;
+
+		for(size_t idx = 0; idx < bytes; idx++)
+			value = (value << 8) | this->_data[this->_pos++];
+
+		return true;
+	}
+
+	static double half(uint16_t bits)
+	{
+		int exponent = (bits >> 10) & 0x1F;
+		int mantissa = bits & 0x3FF;
+		double value;
+
+		if(exponent == 0)
+			value = ldexp(mantissa, -24);
+		else if(exponent != 31)
+			value = ldexp(mantissa + 1024, exponent - 25);
+		else
+			value = mantissa == 0 ? INFINITY : NAN;
+
+		return (bits & 0x8000) ? -value : value;
+	}
+
+	bool CborReader::next(Item &item)
+	{
+		if(this->_pos >= this->_length)
+			return false;
+
+		auto initial = this->_data[this->_pos++];
+		auto major = initial >> 5;
+		auto info = initial & 0x1F;
+
+		item.indefinite = false;
+		item.value = 0;
+		item.number = 0;
+		item.data = nullptr;
+
+		if(major == 7) {
+			uint64_t bits;
+
+			switch(initial) {
+			case CBOR_FALSE:
+			case CBOR_TRUE:
+				item.type = Type::Bool;
+				item.value = initial == CBOR_TRUE;
+				return true;
+
+			case CBOR_NULL:
+				item.type = Type::Null;
+				return true;
+
+			case CBOR_UNDEFINED:
+				item.type = Type::Undefined;
+				return true;
+
+			case CBOR_BREAK:
+				item.type = Type::Break;
+				return true;
+
+			case CBOR_HALF:
+			case CBOR_FLOAT:
+			case CBOR_DOUBLE:
+				if(!this->argument(info, bits))
+					return false;
+
+				item.type = Type::Float;
+
+				if(initial == CBOR_HALF) {
+					item.number = half(static_cast<uint16_t>(bits));
+				} else if(initial == CBOR_FLOAT) {
+					float value;
+					auto raw = static_cast<uint32_t>(bits);
+
+					memcpy(&value, &raw, sizeof(value));
+					item.number = value;
+				} else {
+					memcpy(&item.number, &bits, sizeof(item.number));
+				}
+
+				return true;
+
+			default:
+				/* Other simple values are unassigned. */
+				return false;
+			}
+		}
+
+		item.type = static_cast<Type>(major);
+
+		if(info == CBOR_INDEFINITE) {
+			if(item.type != Type::Array && item.type != Type::Map)
+				return false;
+
+			item.indefinite = true;
+			return true;
+		}
+
+		if(!this->argument(info, item.value))
+			return false;
+
+		if(item.type == Type::Bytes || item.type == Type::Text) {
+			if(item.value > this->_length - this->_pos)
+				return false;
+
+			item.data = this->_data + this->_pos;
+			this->_pos += static_cast<size_t>(item.value);
+		}
+
+		return true;
+	}
+
+	bool CborReader::skip(const Item &item, size_t depth)
+	{
+		Item child;
+		uint64_t count;
+
+		if(depth >= CONFIG_CBOR_NESTING)
+			return false;
+
+		if(item.type == Type::Tag)
+			count = 1;
+		else if(item.type == Type::Array)
+			count = item.value;
+		else if(item.type == Type::Map)
+			count = item.value * 2;
+		else
+			return true;
+
+		for(uint64_t idx = 0; item.indefinite || idx < count; idx++) {
+			if(!this->next(child))
+				return false;
+
+			if(child.type == Type::Break)
+				return item.indefinite;
+
+			if(!this->skip(child, depth + 1))
+				return false;
+		}
+
+		return true;
+	}
+}
@@ -13,9 +13,60 @@
 #include <lwiot.h>
 
 #include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
 #include <lwiot/types.h>
 #include <lwiot/util/datetime.h>
 
+#define SECONDS_PER_DAY 86400
+#define NO_DAY INT64_MIN
+
+/* Division that rounds towards minus infinity, for times before the epoch. */
+static int64_t floor_div(int64_t value, int64_t divisor)
+{
+	auto quotient = value / divisor;
+	return (value % divisor < 0) ? quotient - 1 : quotient;
+}
+
+static void put2(char *output, int value)
+{
+	output[0] = static_cast<char>('0' + value / 10);
+	output[1] = static_cast<char>('0' + value % 10);
+}
+
+static void put_date(char *output, int64_t days)
+{
+	int64_t year;
+	int month, day;
+
+	lwiot::DateTime::civilFromDays(days, year, month, day);
+
+	put2(output, static_cast<int>(year / 100));
+	put2(output + 2, static_cast<int>(year % 100));
+	output[4] = '-';
+	put2(output + 5, month);
+	output[7] = '-';
+	put2(output + 8, day);
+	output[10] = 'T';
+}
+
+static void put_time(char *output, int64_t seconds)
+{
+	put2(output, static_cast<int>(seconds / 3600));
+	output[2] = ':';
+	put2(output + 3, static_cast<int>(seconds / 60 % 60));
+	output[5] = ':';
+	put2(output + 6, static_cast<int>(seconds % 60));
+}
+
+static void put_milliseconds(char *output, int milliseconds)
+{
+	output[0] = '.';
+	output[1] = static_cast<char>('0' + milliseconds / 100);
+	put2(output + 2, milliseconds % 100);
+	output[4] = 'Z';
+	output[5] = '\0';
+}
+
 namespace lwiot
 {
 	DateTime::DateTime() : DateTime(time(NULL))
@@ -26,8 +77,171 @@ namespace lwiot
 	{
 	}
 
-	DateTime::DateTime(const time_t& ts) : stamp(ts)
+	DateTime::DateTime(const time_t& ts) : stamp(ts), gmt(), gmt_day(NO_DAY)
+	{
+	}
+
+	/* See http://howardhinnant.github.io/date_algorithms.html */
+	int64_t DateTime::daysFromCivil(int64_t year, int month, int day)
+	{
+		year -= month <= 2;
+
+		auto era = (year >= 0 ? year : year - 399) / 400;
+		auto yoe = static_cast<unsigned>(year - era * 400);
+		auto doy = static_cast<unsigned>((153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1);
+		auto doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+		return era * 146097 + static_cast<int64_t>(doe) - 719468;
+	}
+
+	void DateTime::civilFromDays(int64_t days, int64_t &year, int &month, int &day)
+	{
+		days += 719468;
+
+		auto era = (days >= 0 ? days : days - 146096) / 146097;
+		auto doe = static_cast<unsigned>(days - era * 146097);
+		auto yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+		auto doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+		auto mp = (5 * doy + 2) / 153;
+
+		day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+		month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+		year = static_cast<int64_t>(yoe) + era * 400 + (month <= 2);
+	}
+
+	size_t DateTime::formatIso(char *output, time_t seconds, int milliseconds)
+	{
+		auto days = floor_div(seconds, SECONDS_PER_DAY);
+
+		put_date(output, days);
+		put_time(output + 11, seconds - days * SECONDS_PER_DAY);
+
+		if(milliseconds < 0) {
+			output[19] = 'Z';
+			output[20] = '\0';
+			return 20;
+		}
+
+		put_milliseconds(output + 19, milliseconds % 1000);
+		return 24;
+	}
+
+	/* Parse exactly \p count digits. */
+	static bool parse_digits(const StringView& text, size_t& idx, size_t count, int& value)
+	{
+		value = 0;
+
+		if(idx + count > text.size())
+			return false;
+
+		for(size_t end = idx + count; idx < end; idx++) {
+			if(text[idx] < '0' || text[idx] > '9')
+				return false;
+
+			value = value * 10 + (text[idx] - '0');
+		}
+
+		return true;
+	}
+
+	static bool parse_separator(const StringView& text, size_t& idx, char separator)
+	{
+		if(idx >= text.size() || text[idx] != separator)
+			return false;
+
+		idx++;
+		return true;
+	}
+
+	bool DateTime::parseIso(const StringView &text, time_t &seconds, int *milliseconds)
 	{
+		int year, month, day, hour, minute, second = 0, fraction = 0;
+		int64_t offset = 0;
+		size_t idx = 0;
+
+		if(!parse_digits(text, idx, 4, year) || !parse_separator(text, idx, '-') ||
+			!parse_digits(text, idx, 2, month) || !parse_separator(text, idx, '-') ||
+			!parse_digits(text, idx, 2, day))
+			return false;
+
+		if(idx >= text.size() || (text[idx] != 'T' && text[idx] != 't' && text[idx] != ' '))
+			return false;
+
+		idx++;
+
+		if(!parse_digits(text, idx, 2, hour) || !parse_separator(text, idx, ':') || !parse_digits(text, idx, 2, minute))
+			return false;
+
+		if(parse_separator(text, idx, ':')) {
+			if(!parse_digits(text, idx, 2, second))
+				return false;
+
+			if(parse_separator(text, idx, '.') || parse_separator(text, idx, ',')) {
+				int scale = 100;
+
+				if(idx >= text.size() || text[idx] < '0' || text[idx] > '9')
+					return false;
+
+				for(; idx < text.size() && text[idx] >= '0' && text[idx] <= '9'; idx++) {
+					fraction += (text[idx] - '0') * scale;
+					scale /= 10;
+				}
+			}
+		}
+
+		if(month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+			return false;
+
+		if(idx < text.size() && (text[idx] == 'Z' || text[idx] == 'z')) {
+			idx++;
+		} else if(idx < text.size() && (text[idx] == '+' || text[idx] == '-')) {
+			auto sign = text[idx++] == '-' ? -1 : 1;
+			int hours, minutes = 0;
+
+			if(!parse_digits(text, idx, 2, hours))
+				return false;
+
+			parse_separator(text, idx, ':');
+
+			if(idx < text.size() && !parse_digits(text, idx, 2, minutes))
+				return false;
+
+			offset = sign * (hours * 3600 + minutes * 60);
+		}
+
+		if(idx != text.size())
+			return false;
+
+		seconds = static_cast<time_t>(daysFromCivil(year, month, day) * SECONDS_PER_DAY + hour * 3600 +
+			minute * 60 + second - offset);
+
+		if(milliseconds != nullptr)
+			*milliseconds = fraction;
+
+		return true;
+	}
+
+	IsoFormatter::IsoFormatter() : _buffer(), _day(NO_DAY), _second(NO_DAY)
+	{
+	}
+
+	const char *IsoFormatter::format(int64_t milliseconds)
+	{
+		auto seconds = floor_div(milliseconds, 1000);
+		auto days = floor_div(seconds, SECONDS_PER_DAY);
+
+		if(days != this->_day) {
+			put_date(this->_buffer, days);
+			this->_day = days;
+		}
+
+		if(seconds != this->_second) {
+			put_time(this->_buffer + 11, seconds - days * SECONDS_PER_DAY);
+			this->_second = seconds;
+		}
+
+		put_milliseconds(this->_buffer + 19, static_cast<int>(milliseconds - seconds * 1000));
+		return this->_buffer;
 	}
 
 	DateTime DateTime::now()
@@ -107,6 +321,14 @@ namespace lwiot
 		return String(buffer);
 	}
 
+	String DateTime::toIsoString() const
+	{
+		char buffer[IsoBufferSize];
+
+		formatIso(buffer, this->stamp);
+		return String(buffer);
+	}
+
 	void DateTime::sync(const time_t& value)
 	{
 		this->stamp = value;
@@ -120,11 +342,28 @@ namespace lwiot
 
 	void DateTime::updateGmt() const
 	{
-#ifdef WIN32
-		_gmtime64_s(&this->gmt, &this->stamp);
-#else
-		gmtime_r(&this->stamp, &this->gmt);
-#endif
+		auto days = floor_div(this->stamp, SECONDS_PER_DAY);
+		auto seconds = static_cast<int>(this->stamp - days * SECONDS_PER_DAY);
+
+		/* Consecutive time stamps are mostly on the same day, which leaves only the time to update. */
+		if(days != this->gmt_day) {
+			int64_t year;
+			int month, day;
+
+			civilFromDays(days, year, month, day);
+
+			this->gmt.tm_year = static_cast<int>(year - 1900);
+			this->gmt.tm_mon = month - 1;
+			this->gmt.tm_mday = day;
+			this->gmt.tm_yday = static_cast<int>(days - daysFromCivil(year, 1, 1));
+			this->gmt.tm_wday = static_cast<int>(days + 4 - floor_div(days + 4, 7) * 7); /* 1970-01-01 was a Thursday. */
+			this->gmt.tm_isdst = 0;
+			this->gmt_day = days;
+		}
+
+		this->gmt.tm_hour = seconds / 3600;
+		this->gmt.tm_min = seconds / 60 % 60;
+		this->gmt.tm_sec = seconds % 60;
 	}
 
 	DateTime DateTime::operator+(const DateTime& dt) const
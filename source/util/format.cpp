@@ -0,0 +1,183 @@
+/*
+ * Type safe string formatting.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/format.h>
+#include <lwiot/util/numberformat.h>
+
+namespace lwiot
+{
+	namespace detail
+	{
+		class FormatWriter {
+		public:
+			explicit FormatWriter(char *output, size_t size) : _output(output), _size(size), _length(0)
+			{
+			}
+
+			void write(const char *data, size_t length)
+			{
+				if(this->_length < this->_size) {
+					auto num = this->_size - this->_length;
+
+					if(num > length)
+						num = length;
+
+					memcpy(this->_output + this->_length, data, num);
+				}
+
+				this->_length += length;
+			}
+
+			void write(char c)
+			{
+				this->write(&c, 1);
+			}
+
+			size_t finish()
+			{
+				if(this->_size == 0)
+					return this->_length;
+
+				auto end = this->_length < this->_size ? this->_length : this->_size - 1;
+
+				this->_output[end] = '\0';
+				return this->_length;
+			}
+
+		private:
+			char *_output;
+			size_t _size;
+			size_t _length;
+		};
+
+		static uint8_t spec_to_base(char type)
+		{
+			switch(type) {
+			case 'x':
+			case 'X':
+				return 16;
+
+			case 'o':
+				return 8;
+
+			case 'b':
+				return 2;
+
+			default:
+				return 10;
+			}
+		}
+
+		static void format_arg(FormatWriter& writer, const FormatSpec& spec, const FormatArg& arg)
+		{
+			char buffer[NumberFormat::BufferSize];
+			size_t length;
+			auto base = spec_to_base(spec.type);
+
+			switch(arg.kind) {
+			case FormatKind::Signed:
+				if(base == 10 || arg.i >= 0) {
+					length = base == 10 ? NumberFormat::formatSigned(buffer, arg.i) :
+						NumberFormat::formatUnsigned(buffer, static_cast<unsigned long long>(arg.i), base);
+				} else {
+					buffer[0] = '-';
+					length = NumberFormat::formatUnsigned(buffer + 1, 0ULL - static_cast<unsigned long long>(arg.i),
+					                                      base) + 1;
+				}
+				break;
+
+			case FormatKind::Unsigned:
+				length = NumberFormat::formatUnsigned(buffer, arg.u, base);
+				break;
+
+			case FormatKind::Float:
+				length = NumberFormat::formatFloat(buffer, arg.f, spec.precision < 0 ? 6 : spec.precision);
+				break;
+
+			case FormatKind::Char:
+				writer.write(static_cast<char>(arg.u));
+				return;
+
+			case FormatKind::Bool:
+				if(arg.u)
+					writer.write("true", 4);
+				else
+					writer.write("false", 5);
+				return;
+
+			case FormatKind::String:
+				writer.write(arg.s, arg.length);
+				return;
+
+			case FormatKind::Pointer:
+				buffer[0] = '0';
+				buffer[1] = 'x';
+				length = NumberFormat::formatUnsigned(buffer + 2, reinterpret_cast<uintptr_t>(arg.p), 16) + 2;
+				break;
+
+			default:
+				return;
+			}
+
+			/* NumberFormat emits upper case digits. */
+			if(spec.type != 'X') {
+				for(size_t idx = 0; idx < length; idx++) {
+					if(buffer[idx] >= 'A' && buffer[idx] <= 'F')
+						buffer[idx] += 'a' - 'A';
+				}
+			}
+
+			writer.write(buffer, length);
+		}
+
+		size_t vformat(char *output, size_t size, const char *fmt, const FormatArg *args, size_t num)
+		{
+			FormatWriter writer(output, size);
+			size_t arg = 0;
+			const char *start = fmt;
+
+			while(*fmt != '\0') {
+				if(*fmt != '{' && *fmt != '}') {
+					fmt++;
+					continue;
+				}
+
+				writer.write(start, fmt - start);
+
+				if(fmt[0] == fmt[1]) {
+					writer.write(fmt[0]);
+					fmt += 2;
+					start = fmt;
+					continue;
+				}
+
+				FormatSpec spec{'\0', -1};
+				auto length = fmt[0] == '{' ? parse_format_spec(fmt, spec) : 0;
+
+				if(length == 0 || arg >= num) {
+					/* Not a valid field: print it as-is. */
+					start = fmt;
+					fmt += length ? length : 1;
+					writer.write(start, fmt - start);
+				} else {
+					format_arg(writer, spec, args[arg++]);
+					fmt += length;
+				}
+
+				start = fmt;
+			}
+
+			writer.write(start, fmt - start);
+			return writer.finish();
+		}
+	}
+}
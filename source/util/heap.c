@@ -0,0 +1,270 @@
+/*
+ * Heap hooks and memory accounting.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/heap.h>
+#include <lwiot/error.h>
+
+/*
+ * Every allocation is prefixed by a header that records its size, tag and region, so that free
+ * and realloc can account it without help from the caller. The header is padded to keep the
+ * payload aligned for any type.
+ */
+typedef union heap_header {
+	struct {
+		size_t size;
+		uint8_t tag;
+		uint8_t region;
+	} info;
+
+	max_align_t align;
+} heap_header_t;
+
+struct heap_counters {
+	size_t current;
+	size_t peak;
+	size_t allocations;
+	size_t failures;
+};
+
+static void *heap_default_alloc(void *ctx, size_t size)
+{
+	UNUSED(ctx);
+	return lwiot_mem_alloc(size);
+}
+
+static void *heap_default_realloc(void *ctx, void *ptr, size_t size)
+{
+	UNUSED(ctx);
+	return lwiot_mem_realloc(ptr, size);
+}
+
+static void heap_default_free(void *ctx, void *ptr)
+{
+	UNUSED(ctx);
+	lwiot_mem_free(ptr);
+}
+
+static struct lwiot_heap_backend backends[LWIOT_HEAP_REGION_MAX] = {
+	{ heap_default_alloc, heap_default_realloc, heap_default_free, NULL },
+};
+
+static struct heap_counters counters[LWIOT_HEAP_TAG_MAX];
+
+#ifdef __GNUC__
+#define heap_add(__p, __v) __atomic_add_fetch(__p, __v, __ATOMIC_RELAXED)
+#define heap_sub(__p, __v) __atomic_sub_fetch(__p, __v, __ATOMIC_RELAXED)
+#define heap_load(__p) __atomic_load_n(__p, __ATOMIC_RELAXED)
+#define heap_store(__p, __v) __atomic_store_n(__p, __v, __ATOMIC_RELAXED)
+
+static void heap_raise(size_t *peak, size_t value)
+{
+	size_t old = heap_load(peak);
+
+	while(value > old) {
+		if(__atomic_compare_exchange_n(peak, &old, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			break;
+	}
+}
+#else
+static size_t heap_add(size_t *p, size_t v)
+{
+	size_t rv;
+
+	enter_critical();
+	rv = *p += v;
+	exit_critical();
+
+	return rv;
+}
+
+static size_t heap_sub(size_t *p, size_t v)
+{
+	size_t rv;
+
+	enter_critical();
+	rv = *p -= v;
+	exit_critical();
+
+	return rv;
+}
+
+#define heap_load(__p) (*(volatile size_t*) (__p))
+#define heap_store(__p, __v) (*(volatile size_t*) (__p) = (__v))
+
+static void heap_raise(size_t *peak, size_t value)
+{
+	enter_critical();
+
+	if(value > *peak)
+		*peak = value;
+
+	exit_critical();
+}
+#endif
+
+static void heap_account(uint8_t tag, size_t size)
+{
+	struct heap_counters *c = &counters[tag];
+
+	heap_add(&c->allocations, 1);
+	heap_raise(&c->peak, heap_add(&c->current, size));
+}
+
+static void heap_unaccount(uint8_t tag, size_t size)
+{
+	struct heap_counters *c = &counters[tag];
+
+	heap_sub(&c->current, size);
+	heap_sub(&c->allocations, 1);
+}
+
+static uint8_t heap_region(uint32_t flags)
+{
+	if((flags & LWIOT_HEAP_EXTERNAL) && backends[LWIOT_HEAP_REGION_EXTERNAL].alloc != NULL)
+		return LWIOT_HEAP_REGION_EXTERNAL;
+
+	return LWIOT_HEAP_REGION_DEFAULT;
+}
+
+int lwiot_heap_register(lwiot_heap_region_t region, const struct lwiot_heap_backend *backend)
+{
+	if(region >= LWIOT_HEAP_REGION_MAX || backend == NULL || backend->alloc == NULL || backend->free == NULL)
+		return -EINVALID;
+
+	backends[region] = *backend;
+	return -EOK;
+}
+
+void *lwiot_heap_alloc(size_t size, uint32_t flags)
+{
+	const struct lwiot_heap_backend *backend;
+	heap_header_t *hdr;
+	uint8_t tag, region;
+
+	tag = (uint8_t) (flags & LWIOT_HEAP_TAG_MASK);
+
+	if(tag >= LWIOT_HEAP_TAG_MAX || size > SIZE_MAX - sizeof(*hdr))
+		return NULL;
+
+	region = heap_region(flags);
+	backend = &backends[region];
+	hdr = backend->alloc(backend->ctx, sizeof(*hdr) + size);
+
+	if(hdr == NULL) {
+		heap_add(&counters[tag].failures, 1);
+		return NULL;
+	}
+
+	hdr->info.size = size;
+	hdr->info.tag = tag;
+	hdr->info.region = region;
+	heap_account(tag, size);
+
+	return hdr + 1;
+}
+
+void *lwiot_heap_zalloc(size_t size, uint32_t flags)
+{
+	void *ptr;
+
+	ptr = lwiot_heap_alloc(size, flags);
+
+	if(ptr != NULL)
+		memset(ptr, 0, size);
+
+	return ptr;
+}
+
+void *lwiot_heap_realloc(void *ptr, size_t size)
+{
+	const struct lwiot_heap_backend *backend;
+	heap_header_t *hdr, *newhdr;
+	size_t oldsize;
+	void *newptr;
+	uint8_t tag;
+
+	if(ptr == NULL)
+		return lwiot_heap_alloc(size, LWIOT_HEAP_TAG_DEFAULT);
+
+	hdr = (heap_header_t*) ptr - 1;
+	oldsize = hdr->info.size;
+	tag = hdr->info.tag;
+	backend = &backends[hdr->info.region];
+
+	if(size > SIZE_MAX - sizeof(*hdr))
+		return NULL;
+
+	if(backend->realloc == NULL) {
+		newptr = lwiot_heap_alloc(size, tag | (hdr->info.region == LWIOT_HEAP_REGION_EXTERNAL ? LWIOT_HEAP_EXTERNAL : 0));
+
+		if(newptr == NULL)
+			return NULL;
+
+		memcpy(newptr, ptr, oldsize < size ? oldsize : size);
+		lwiot_heap_free(ptr);
+		return newptr;
+	}
+
+	newhdr = backend->realloc(backend->ctx, hdr, sizeof(*hdr) + size);
+
+	if(newhdr == NULL) {
+		heap_add(&counters[tag].failures, 1);
+		return NULL;
+	}
+
+	heap_unaccount(tag, oldsize);
+	newhdr->info.size = size;
+	heap_account(tag, size);
+
+	return newhdr + 1;
+}
+
+void lwiot_heap_free(void *ptr)
+{
+	const struct lwiot_heap_backend *backend;
+	heap_header_t *hdr;
+
+	if(ptr == NULL)
+		return;
+
+	hdr = (heap_header_t*) ptr - 1;
+	backend = &backends[hdr->info.region];
+
+	heap_unaccount(hdr->info.tag, hdr->info.size);
+	backend->free(backend->ctx, hdr);
+}
+
+int lwiot_heap_statistics(lwiot_heap_tag_t tag, struct lwiot_heap_stats *stats)
+{
+	struct heap_counters *c;
+
+	if(tag >= LWIOT_HEAP_TAG_MAX || stats == NULL)
+		return -EINVALID;
+
+	c = &counters[tag];
+	stats->current = heap_load(&c->current);
+	stats->peak = heap_load(&c->peak);
+	stats->allocations = heap_load(&c->allocations);
+	stats->failures = heap_load(&c->failures);
+
+	return -EOK;
+}
+
+void lwiot_heap_reset_peak(lwiot_heap_tag_t tag)
+{
+	if(tag >= LWIOT_HEAP_TAG_MAX)
+		return;
+
+	/* Racing allocations may leave the peak slightly below the true value. */
+	heap_store(&counters[tag].peak, heap_load(&counters[tag].current));
+}
@@ -9,28 +9,136 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 #include <lwiot.h>
 
 #include <lwiot/stl/string.h>
 #include <lwiot/log.h>
+#include <lwiot/format.h>
+#ifndef CONFIG_STANDALONE
+#include <lwiot/util/logbackend.h>
+#endif
 
 namespace lwiot {
+	namespace
+	{
+		struct LogFilter {
+			constexpr LogFilter() : name(), custom(false), level(CONFIG_LOG_LEVEL)
+			{ }
+
+			char name[CONFIG_LOG_FILTER_NAME_LENGTH];
+			bool custom;
+			Atomic<uint8_t> level;
+		};
+
+		/*
+		 * The first filter holds the default level. Filters are constant initialized, so loggers
+		 * with static storage can be created in any order. They are claimed from a critical
+		 * section, which only happens when a logger is created or a level is set.
+		 */
+		LogFilter filters[CONFIG_LOG_FILTERS + 1];
+
+		LogFilter *find_filter(const String& subsys)
+		{
+			if(subsys.length() == 0)
+				return &filters[0];
+
+			LogFilter *free = nullptr;
+
+			for(size_t idx = 1; idx < CONFIG_LOG_FILTERS + 1; idx++) {
+				auto& filter = filters[idx];
+
+				if(filter.name[0] == '\0') {
+					if(free == nullptr)
+						free = &filter;
+
+					continue;
+				}
+
+				if(strncmp(filter.name, subsys.c_str(), sizeof(filter.name) - 1) == 0)
+					return &filter;
+			}
+
+			if(free == nullptr)
+				return nullptr;
+
+			strncpy(free->name, subsys.c_str(), sizeof(free->name) - 1);
+			free->level.store(filters[0].level.load());
+			return free;
+		}
+	}
+
 	Logger::NewLine Logger::newline;
+	AsyncLogBackend *Logger::backend = nullptr;
+
+	void Logger::setLevel(LogLevel level)
+	{
+		enter_critical();
+		filters[0].level.store(static_cast<uint8_t>(level));
+
+		for(size_t idx = 1; idx < CONFIG_LOG_FILTERS + 1; idx++) {
+			if(!filters[idx].custom)
+				filters[idx].level.store(static_cast<uint8_t>(level));
+		}
+
+		exit_critical();
+	}
+
+	bool Logger::setLevel(const String& subsys, LogLevel level)
+	{
+		if(subsys.length() == 0) {
+			Logger::setLevel(level);
+			return true;
+		}
+
+		enter_critical();
+		auto filter = find_filter(subsys);
+
+		if(filter != nullptr) {
+			filter->custom = true;
+			filter->level.store(static_cast<uint8_t>(level));
+		}
+
+		exit_critical();
+		return filter != nullptr;
+	}
+
+	void Logger::setBackend(AsyncLogBackend *value)
+	{
+		Logger::backend = value;
+	}
 
-	Logger::Logger(FILE *output) : _f_output(output), _newline(true)
+	Logger::Logger(FILE *output) : _f_output(output), _newline(true), _level(&filters[0].level)
 	{ }
 
-	Logger::Logger() : _f_output(stdout), _newline(true)
+	Logger::Logger() : _f_output(stdout), _newline(true), _level(&filters[0].level)
 	{
 	}
 
 	Logger::Logger(const String& subsys, FILE *output /* = stdout */) :
 		_f_output(output), _newline(true), _subsys(subsys)
 	{
+		enter_critical();
+		auto filter = find_filter(subsys);
+		exit_critical();
+
+		/* Subsystems without room for a filter of their own use the default level. */
+		this->_level = filter != nullptr ? &filter->level : &filters[0].level;
 	}
 
 	void Logger::print_newline(void)
 	{
+#ifndef CONFIG_STANDALONE
+		if(Logger::backend != nullptr) {
+			uint8_t flags = this->_newline ? LogRecord::Start | LogRecord::End : LogRecord::End;
+
+			Logger::backend->log(LogLevel::Info, this->_subsys.length() > 0 ? this->_subsys.c_str() : nullptr,
+			                     flags, "", 0);
+			this->_newline = true;
+			return;
+		}
+#endif
+
 #ifdef WIN32
 		this->format("\r\n");
 #else
@@ -105,6 +213,76 @@ namespace lwiot {
 		return *this;
 	}
 
+#ifdef WIN32
+#define LOG_LINE_END "\r\n"
+#else
+#define LOG_LINE_END "\n"
+#endif
+
+	size_t Logger::formatPrefix(char *output, size_t size, unsigned long long tick) const
+	{
+		if(this->_subsys.length() > 0)
+			return lwiot::format(output, size, "[{}][lwiot][{}]: ", tick, this->_subsys);
+
+		return lwiot::format(output, size, "[{}][lwIoT]: ", tick);
+	}
+
+	void Logger::writeLine(LogLevel level, const char *fmt, const detail::FormatArg *args, size_t num)
+	{
+		char buffer[CONFIG_LOG_LINE_LENGTH];
+		char *line = buffer;
+		size_t prefix = 0;
+		const size_t end = sizeof(LOG_LINE_END) - 1;
+
+		if(fmt == nullptr)
+			return;
+
+#ifndef CONFIG_STANDALONE
+		if(Logger::backend != nullptr) {
+			uint8_t flags = this->_newline ? LogRecord::Start | LogRecord::End : LogRecord::End;
+
+			Logger::backend->log(level, this->_subsys.length() > 0 ? this->_subsys.c_str() : nullptr,
+			                     flags, fmt, args, num);
+			this->_newline = true;
+			return;
+		}
+#endif
+
+		if(this->_f_output == nullptr)
+			return;
+
+		auto tick = static_cast<unsigned long long>(lwiot_tick_ms());
+
+		if(this->_newline)
+			prefix = this->formatPrefix(buffer, sizeof(buffer), tick);
+
+		auto length = prefix;
+
+		if(prefix < sizeof(buffer))
+			length += detail::vformat(buffer + prefix, sizeof(buffer) - prefix, fmt, args, num);
+		else
+			length += detail::vformat(nullptr, 0, fmt, args, num);
+
+		if(length + end >= sizeof(buffer)) {
+			line = (char *) lwiot_mem_alloc(length + end + 1);
+
+			if(line == nullptr)
+				return;
+
+			if(this->_newline)
+				this->formatPrefix(line, length + 1, tick);
+
+			detail::vformat(line + prefix, length - prefix + 1, fmt, args, num);
+		}
+
+		memcpy(line + length, LOG_LINE_END, end);
+		fwrite(line, 1, length + end, this->_f_output);
+		this->_newline = true;
+
+		if(line != buffer)
+			lwiot_mem_free(line);
+	}
+
 	void Logger::format(const char *fmt, ...)
 	{
 		va_list va;
@@ -113,6 +291,25 @@ namespace lwiot {
 		if(fmt == nullptr)
 			return;
 
+#ifndef CONFIG_STANDALONE
+		if(Logger::backend != nullptr) {
+			char buffer[CONFIG_LOG_LINE_LENGTH];
+
+			va_start(va, fmt);
+			auto length = vsnprintf(buffer, sizeof(buffer), fmt, va);
+			va_end(va);
+
+			if(length < 0)
+				return;
+
+			Logger::backend->log(LogLevel::Info, this->_subsys.length() > 0 ? this->_subsys.c_str() : nullptr,
+			                     this->_newline ? LogRecord::Start : 0, buffer,
+			                     static_cast<size_t>(length) < sizeof(buffer) ? static_cast<size_t>(length) : sizeof(buffer) - 1);
+			this->_newline = false;
+			return;
+		}
+#endif
+
 		if(this->_newline) {
 			this->_newline = false;
 			tick = lwiot_tick_ms();
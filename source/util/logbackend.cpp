@@ -0,0 +1,245 @@
+/*
+ * Asynchronous logging backend.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/format.h>
+#include <lwiot/util/logbackend.h>
+
+#ifdef WIN32
+#define LOG_LINE_END "\r\n"
+#else
+#define LOG_LINE_END "\n"
+#endif
+
+namespace lwiot
+{
+	size_t LogSink::format(const LogRecord &record, char *output, size_t size)
+	{
+		const size_t end = sizeof(LOG_LINE_END) - 1;
+		auto tick = static_cast<unsigned long long>(record.tick);
+		size_t length = 0;
+
+		if(record.flags & LogRecord::Start) {
+			if(record.subsystem[0] != '\0')
+				length = lwiot::format(output, size, "[{}][lwiot][{}]: ", tick,
+				                       static_cast<const char *>(record.subsystem));
+			else
+				length = lwiot::format(output, size, "[{}][lwIoT]: ", tick);
+
+			if(length >= size)
+				length = size - 1;
+		}
+
+		auto payload = record.length < size - length ? record.length : size - length;
+		memcpy(output + length, record.payload, payload);
+		length += payload;
+
+		if((record.flags & LogRecord::End) && length + end <= size) {
+			memcpy(output + length, LOG_LINE_END, end);
+			length += end;
+		}
+
+		return length;
+	}
+
+	TextLogSink::TextLogSink() : _length(0)
+	{
+	}
+
+	void TextLogSink::write(const LogRecord &record)
+	{
+		if(record.flags & LogRecord::Binary)
+			return;
+
+		/* Room for the prefix, the payload and the line ending. */
+		if(sizeof(this->_buffer) - this->_length < CONFIG_LOG_RECORD_SIZE + CONFIG_LOG_SUBSYS_LENGTH + 48)
+			this->flush();
+
+		this->_length += LogSink::format(record, this->_buffer + this->_length, sizeof(this->_buffer) - this->_length);
+	}
+
+	void TextLogSink::flush()
+	{
+		if(this->_length == 0)
+			return;
+
+		this->output(this->_buffer, this->_length);
+		this->_length = 0;
+	}
+
+	FileLogSink::FileLogSink(FILE *file) : _file(file)
+	{
+	}
+
+	void FileLogSink::output(const char *data, size_t length)
+	{
+		fwrite(data, 1, length, this->_file);
+		fflush(this->_file);
+	}
+
+	StreamLogSink::StreamLogSink(Stream &stream) : _stream(stream)
+	{
+	}
+
+	void StreamLogSink::output(const char *data, size_t length)
+	{
+		this->_stream.write(data, length);
+	}
+
+	AsyncLogBackend::AsyncLogBackend(LogSink &sink, Policy policy) : Thread("logger"), _sink(sink),
+		_policy(policy), _ready(EventType::Counting, 1), _idle(false), _running(false), _dropped(0)
+	{
+		for(auto& record : this->_records)
+			this->_free.push(&record);
+	}
+
+	AsyncLogBackend::~AsyncLogBackend()
+	{
+		this->end();
+	}
+
+	void AsyncLogBackend::begin()
+	{
+		if(this->_running)
+			return;
+
+		this->_running = true;
+		this->start();
+	}
+
+	void AsyncLogBackend::end()
+	{
+		if(!this->_running)
+			return;
+
+		this->_running = false;
+		this->_ready.signal();
+		this->join();
+	}
+
+	size_t AsyncLogBackend::dropped() const
+	{
+		return static_cast<size_t>(this->_dropped.load());
+	}
+
+	LogRecord *AsyncLogBackend::acquire(LogLevel level, const char *subsystem, uint8_t flags)
+	{
+		LogRecord *record;
+
+		while((record = this->_free.pop()) == nullptr) {
+			if(this->_policy == Policy::Drop || !this->_running) {
+				this->_dropped.fetch_add(1);
+				return nullptr;
+			}
+
+			if(this->_idle.exchange(false))
+				this->_ready.signal();
+
+			Thread::yield();
+		}
+
+		record->tick = lwiot_tick_ms();
+		record->level = level;
+		record->flags = flags;
+		record->length = 0;
+
+		size_t idx = 0;
+
+		if(subsystem != nullptr) {
+			for(; idx < sizeof(record->subsystem) - 1 && subsystem[idx] != '\0'; idx++)
+				record->subsystem[idx] = subsystem[idx];
+		}
+
+		record->subsystem[idx] = '\0';
+		return record;
+	}
+
+	void AsyncLogBackend::commit(LogRecord *record)
+	{
+		/* There are as many slots as records, so this never fails. */
+		this->_queue.push(record);
+
+		if(this->_idle.exchange(false))
+			this->_ready.signal();
+	}
+
+	bool AsyncLogBackend::log(LogLevel level, const char *subsystem, uint8_t flags, const char *fmt,
+	                          const detail::FormatArg *args, size_t num)
+	{
+		if(!this->_running)
+			return false;
+
+		auto record = this->acquire(level, subsystem, flags);
+
+		if(record == nullptr)
+			return false;
+
+		auto length = detail::vformat(record->payload, sizeof(record->payload), fmt, args, num);
+		record->length = static_cast<uint16_t>(length < sizeof(record->payload) ? length : sizeof(record->payload) - 1);
+
+		this->commit(record);
+		return true;
+	}
+
+	bool AsyncLogBackend::log(LogLevel level, const char *subsystem, uint8_t flags, const char *text, size_t length)
+	{
+		if(!this->_running)
+			return false;
+
+		auto record = this->acquire(level, subsystem, flags);
+
+		if(record == nullptr)
+			return false;
+
+		if(length > sizeof(record->payload))
+			length = sizeof(record->payload);
+
+		memcpy(record->payload, text, length);
+		record->length = static_cast<uint16_t>(length);
+
+		this->commit(record);
+		return true;
+	}
+
+	void AsyncLogBackend::drain()
+	{
+		LogRecord *record;
+		bool written = false;
+
+		while((record = this->_queue.pop()) != nullptr) {
+			this->_sink.write(*record);
+			this->_free.push(record);
+			written = true;
+		}
+
+		if(written)
+			this->_sink.flush();
+	}
+
+	void AsyncLogBackend::run()
+	{
+		while(this->_running) {
+			this->drain();
+
+			/* Producers only signal the event after this flag is set, which keeps their path short. */
+			this->_idle = true;
+
+			if(this->_queue.size() == 0 && this->_running)
+				this->_ready.wait(CONFIG_LOG_FLUSH_INTERVAL);
+
+			this->_idle = false;
+		}
+
+		this->drain();
+	}
+}
@@ -0,0 +1,424 @@
+/*
+ * Metrics registry.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/format.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/util/cbor.h>
+#include <lwiot/util/metrics.h>
+
+#ifndef CONFIG_METRICS_EXPORT_BUFFER
+#define CONFIG_METRICS_EXPORT_BUFFER 256
+#endif
+
+namespace lwiot
+{
+	namespace metrics
+	{
+		/* Collects the output of an exporter, so the writer is called with larger blocks. */
+		class ExportBuffer {
+		public:
+			explicit ExportBuffer(const Registry::Writer& writer) : _writer(writer), _length(0), _ok(true)
+			{
+			}
+
+			void write(const char *data, size_t length)
+			{
+				while(this->_ok && length > 0) {
+					if(this->_length == sizeof(this->_buffer))
+						this->flush();
+
+					auto size = sizeof(this->_buffer) - this->_length;
+
+					if(size > length)
+						size = length;
+
+					memcpy(this->_buffer + this->_length, data, size);
+					this->_length += size;
+					data += size;
+					length -= size;
+				}
+			}
+
+			void write(const char *text)
+			{
+				this->write(text, strlen(text));
+			}
+
+			template <typename... Args>
+			void format(const char *fmt, const Args&... args)
+			{
+				char line[64];
+				auto length = lwiot::format(line, sizeof(line), fmt, args...);
+
+				this->write(line, length < sizeof(line) ? length : sizeof(line) - 1);
+			}
+
+			bool flush()
+			{
+				if(this->_ok && this->_length > 0)
+					this->_ok = this->_writer(this->_buffer, this->_length);
+
+				this->_length = 0;
+				return this->_ok;
+			}
+
+			bool ok() const
+			{
+				return this->_ok;
+			}
+
+		private:
+			const Registry::Writer& _writer;
+			char _buffer[CONFIG_METRICS_EXPORT_BUFFER];
+			size_t _length;
+			bool _ok;
+		};
+
+		Metric::Metric(Registry &registry, Type type, const char *name, const char *help) :
+			_registry(registry), _type(type), _name(name), _help(help)
+		{
+			registry.add(*this);
+		}
+
+		Metric::~Metric()
+		{
+			this->_registry.remove(*this);
+		}
+
+		const char *Metric::name() const
+		{
+			return this->_name;
+		}
+
+		const char *Metric::help() const
+		{
+			return this->_help;
+		}
+
+		Metric::Type Metric::type() const
+		{
+			return this->_type;
+		}
+
+		Counter::Counter(const char *name, const char *help) : Counter(Registry::global(), name, help)
+		{
+		}
+
+		Counter::Counter(Registry &registry, const char *name, const char *help) :
+			Metric(registry, Type::Counter, name, help), _value(0)
+		{
+		}
+
+		void Counter::reset()
+		{
+			this->_value.store(0);
+		}
+
+		Gauge::Gauge(const char *name, const char *help) : Gauge(Registry::global(), name, help)
+		{
+		}
+
+		Gauge::Gauge(Registry &registry, const char *name, const char *help) :
+			Metric(registry, Type::Gauge, name, help), _value(0)
+		{
+		}
+
+		void Gauge::reset()
+		{
+			this->_value.store(0);
+		}
+
+		Histogram::Histogram(const char *name, const char *help) : Histogram(Registry::global(), name, help)
+		{
+		}
+
+		Histogram::Histogram(Registry &registry, const char *name, const char *help) :
+			Metric(registry, Type::Histogram, name, help), _buckets(), _sum(0)
+		{
+		}
+
+		size_t Histogram::bucket(value_type value)
+		{
+			if(value < 4)
+				return value;
+
+			size_t msb = 0;
+
+			for(auto bits = value; bits > 1; bits >>= 1)
+				msb++;
+
+			auto idx = (msb - 1) * 4 + ((value >> (msb - 2)) & 3);
+			return idx < Buckets ? idx : Buckets - 1;
+		}
+
+		Histogram::value_type Histogram::upperBound(size_t idx)
+		{
+			if(idx < 4)
+				return idx;
+
+			auto shift = idx / 4 - 1;
+			auto lower = static_cast<value_type>(4 + idx % 4) << shift;
+
+			return lower + (static_cast<value_type>(1) << shift) - 1;
+		}
+
+		Histogram::value_type Histogram::count() const
+		{
+			value_type count = 0;
+
+			for(auto& bucket : this->_buckets)
+				count += bucket.load(memory_order_relaxed);
+
+			return count;
+		}
+
+		Histogram::value_type Histogram::sum() const
+		{
+			return this->_sum.load(memory_order_relaxed);
+		}
+
+		Histogram::value_type Histogram::bucketCount(size_t idx) const
+		{
+			return idx < Buckets ? this->_buckets[idx].load(memory_order_relaxed) : 0;
+		}
+
+		void Histogram::reset()
+		{
+			for(auto& bucket : this->_buckets)
+				bucket.store(0);
+
+			this->_sum.store(0);
+		}
+
+		Registry::Registry() : _lock(false)
+		{
+		}
+
+		Registry::~Registry()
+		{
+			ScopedLock lock(this->_lock);
+			this->_metrics.clear();
+		}
+
+		Registry &Registry::global()
+		{
+			static Registry registry;
+			return registry;
+		}
+
+		void Registry::add(Metric &metric)
+		{
+			ScopedLock lock(this->_lock);
+			this->_metrics.push_back(metric);
+		}
+
+		void Registry::remove(Metric &metric)
+		{
+			ScopedLock lock(this->_lock);
+			this->_metrics.remove(metric);
+		}
+
+		size_t Registry::size() const
+		{
+			ScopedLock lock(this->_lock);
+			return this->_metrics.size();
+		}
+
+		void Registry::reset()
+		{
+			ScopedLock lock(this->_lock);
+
+			for(auto& metric : this->_metrics)
+				metric.reset();
+		}
+
+		Metric *Registry::find(const char *name) const
+		{
+			ScopedLock lock(this->_lock);
+
+			for(auto& metric : this->_metrics) {
+				if(strcmp(metric.name(), name) == 0)
+					return const_cast<Metric *>(&metric);
+			}
+
+			return nullptr;
+		}
+
+		static size_t last_bucket(const Histogram& histogram)
+		{
+			size_t last = 0;
+
+			for(size_t idx = 0; idx < Histogram::Buckets - 1; idx++) {
+				if(histogram.bucketCount(idx) != 0)
+					last = idx;
+			}
+
+			return last;
+		}
+
+		bool Registry::writePrometheus(const Writer &writer) const
+		{
+			static const char *const types[] = { "counter", "gauge", "histogram" };
+			ScopedLock lock(this->_lock);
+			ExportBuffer output(writer);
+
+			for(auto& metric : this->_metrics) {
+				auto name = metric.name();
+
+				if(metric.help() != nullptr) {
+					output.format("# HELP {} ", name);
+					output.write(metric.help());
+					output.write("\n", 1);
+				}
+
+				output.format("# TYPE {} {}\n", name, types[static_cast<uint8_t>(metric.type())]);
+
+				switch(metric.type()) {
+				case Metric::Type::Counter:
+					output.format("{} {}\n", name, static_cast<const Counter&>(metric).value());
+					break;
+
+				case Metric::Type::Gauge:
+					output.format("{} {}\n", name, static_cast<const Gauge&>(metric).value());
+					break;
+
+				case Metric::Type::Histogram: {
+					auto& histogram = static_cast<const Histogram&>(metric);
+					auto last = last_bucket(histogram);
+					Histogram::value_type count = 0;
+
+					for(size_t idx = 0; idx <= last; idx++) {
+						count += histogram.bucketCount(idx);
+						output.format("{}_bucket{{le=\"{}\"}} {}\n", name, Histogram::upperBound(idx), count);
+					}
+
+					count += histogram.bucketCount(Histogram::Buckets - 1);
+					output.format("{}_bucket{{le=\"+Inf\"}} {}\n", name, count);
+					output.format("{}_sum {}\n", name, histogram.sum());
+					output.format("{}_count {}\n", name, count);
+					break;
+				}
+				}
+
+				if(!output.ok())
+					return false;
+			}
+
+			return output.flush();
+		}
+
+		bool Registry::writeJson(const Writer &writer) const
+		{
+			ScopedLock lock(this->_lock);
+			ExportBuffer output(writer);
+			bool first = true;
+
+			output.write("{", 1);
+
+			for(auto& metric : this->_metrics) {
+				output.format("{}\"{}\":", first ? "" : ",", metric.name());
+				first = false;
+
+				switch(metric.type()) {
+				case Metric::Type::Counter:
+					output.format("{}", static_cast<const Counter&>(metric).value());
+					break;
+
+				case Metric::Type::Gauge:
+					output.format("{}", static_cast<const Gauge&>(metric).value());
+					break;
+
+				case Metric::Type::Histogram: {
+					auto& histogram = static_cast<const Histogram&>(metric);
+					bool bucket = true;
+
+					output.format("{{\"count\":{},\"sum\":{},\"buckets\":[", histogram.count(), histogram.sum());
+
+					for(size_t idx = 0; idx < Histogram::Buckets; idx++) {
+						auto count = histogram.bucketCount(idx);
+
+						if(count == 0)
+							continue;
+
+						if(idx == Histogram::Buckets - 1)
+							output.format("{}[null,{}]", bucket ? "" : ",", count);
+						else
+							output.format("{}[{},{}]", bucket ? "" : ",", Histogram::upperBound(idx), count);
+
+						bucket = false;
+					}
+
+					output.write("]}", 2);
+					break;
+				}
+				}
+
+				if(!output.ok())
+					return false;
+			}
+
+			output.write("}", 1);
+			return output.flush();
+		}
+
+		void Registry::writeCbor(CborWriter &writer) const
+		{
+			ScopedLock lock(this->_lock);
+
+			writer.beginMap(this->_metrics.size());
+
+			for(auto& metric : this->_metrics) {
+				writer.write(metric.name());
+
+				switch(metric.type()) {
+				case Metric::Type::Counter:
+					writer.write(static_cast<const Counter&>(metric).value());
+					break;
+
+				case Metric::Type::Gauge:
+					writer.write(static_cast<const Gauge&>(metric).value());
+					break;
+
+				case Metric::Type::Histogram: {
+					auto& histogram = static_cast<const Histogram&>(metric);
+
+					writer.beginMap(3);
+					writer.member("count", histogram.count());
+					writer.member("sum", histogram.sum());
+					writer.write("buckets");
+					writer.beginArray();
+
+					for(size_t idx = 0; idx < Histogram::Buckets; idx++) {
+						auto count = histogram.bucketCount(idx);
+
+						if(count == 0)
+							continue;
+
+						writer.beginArray(2);
+
+						if(idx == Histogram::Buckets - 1)
+							writer.writeNull();
+						else
+							writer.write(Histogram::upperBound(idx));
+
+						writer.write(count);
+					}
+
+					writer.end();
+					break;
+				}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,171 @@
+/*
+ * Allocation free number formatting.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/util/numberformat.h>
+
+namespace lwiot
+{
+	static const char digit_pairs[] =
+		"00010203040506070809"
+		"10111213141516171819"
+		"20212223242526272829"
+		"30313233343536373839"
+		"40414243444546474849"
+		"50515253545556575859"
+		"60616263646566676869"
+		"70717273747576777879"
+		"80818283848586878889"
+		"90919293949596979899";
+
+	static const char digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+	static const uint64_t powers_of_ten[] = {
+		1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+		1000000000ULL
+	};
+
+	/* Writes the digits of `value' backwards, ending just before `end'. Returns the first digit. */
+	static char *format_decimal(char *end, unsigned long long value)
+	{
+		/* 64-bit divisions are expensive on 32-bit targets; only use them while we have to. */
+		while(value > UINT32_MAX) {
+			auto idx = static_cast<size_t>(value % 100) * 2;
+
+			value /= 100;
+			*--end = digit_pairs[idx + 1];
+			*--end = digit_pairs[idx];
+		}
+
+		auto small = static_cast<uint32_t>(value);
+
+		while(small >= 100) {
+			auto idx = (small % 100) * 2;
+
+			small /= 100;
+			*--end = digit_pairs[idx + 1];
+			*--end = digit_pairs[idx];
+		}
+
+		if(small >= 10) {
+			*--end = digit_pairs[small * 2 + 1];
+			*--end = digit_pairs[small * 2];
+		} else {
+			*--end = static_cast<char>('0' + small);
+		}
+
+		return end;
+	}
+
+	size_t NumberFormat::formatUnsigned(char *output, unsigned long long value, uint8_t base)
+	{
+		char buffer[BufferSize];
+		char *end = buffer + sizeof(buffer);
+		char *start;
+
+		if(base < 2 || base > 36)
+			base = 10;
+
+		if(base == 10) {
+			start = format_decimal(end, value);
+		} else {
+			start = end;
+
+			do {
+				*--start = digits[value % base];
+				value /= base;
+			} while(value);
+		}
+
+		auto length = static_cast<size_t>(end - start);
+
+		memcpy(output, start, length);
+		output[length] = '\0';
+
+		return length;
+	}
+
+	size_t NumberFormat::formatSigned(char *output, long long value)
+	{
+		if(value >= 0)
+			return formatUnsigned(output, static_cast<unsigned long long>(value));
+
+		output[0] = '-';
+		return formatUnsigned(output + 1, 0ULL - static_cast<unsigned long long>(value)) + 1;
+	}
+
+	size_t NumberFormat::formatFloat(char *output, double value, uint8_t precision)
+	{
+		size_t length = 0;
+
+		if(isnan(value)) {
+			memcpy(output, "nan", 4);
+			return 3;
+		}
+
+		if(value < 0) {
+			output[length++] = '-';
+			value = -value;
+		}
+
+		if(isinf(value)) {
+			memcpy(output + length, "inf", 4);
+			return length + 3;
+		}
+
+		if(precision > MaxPrecision)
+			precision = MaxPrecision;
+
+		if(value >= 18446744073709551616.0) {
+			auto rv = snprintf(output + length, DecimalBufferSize - length, "%.*e", precision, value);
+			return length + rv;
+		}
+
+		auto scale = powers_of_ten[precision];
+		auto integral = static_cast<unsigned long long>(value);
+		auto scaled = (value - static_cast<double>(integral)) * scale;
+		auto fraction = static_cast<uint64_t>(scaled);
+		auto remainder = scaled - static_cast<double>(fraction);
+		auto last = precision ? fraction : integral;
+
+		/* Round half to even, like printf. */
+		if(remainder > 0.5 || (remainder == 0.5 && (last & 1U)))
+			fraction++;
+
+		if(fraction >= scale) {
+			integral++;
+			fraction -= scale;
+		}
+
+		length += formatUnsigned(output + length, integral);
+
+		if(precision == 0)
+			return length;
+
+		char buffer[BufferSize];
+		char *end = buffer + sizeof(buffer);
+		char *start = format_decimal(end, fraction);
+		auto num = static_cast<size_t>(end - start);
+
+		output[length++] = '.';
+
+		for(auto idx = num; idx < precision; idx++)
+			output[length++] = '0';
+
+		memcpy(output + length, start, num);
+		length += num;
+		output[length] = '\0';
+
+		return length;
+	}
+}
@@ -0,0 +1,108 @@
+/*
+ * Reference counted, immutable byte buffer.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/bytebuffer.h>
+#include <lwiot/sharedbytebuffer.h>
+#include <lwiot/stl/move.h>
+
+namespace lwiot
+{
+	SharedByteBuffer::SharedByteBuffer() : _storage(), _offset(0), _length(0)
+	{
+	}
+
+	SharedByteBuffer::SharedByteBuffer(const void *data, size_t length) : _storage(), _offset(0), _length(length)
+	{
+		if(length == 0)
+			return;
+
+		auto buffer = new ByteBuffer(length, true);
+
+		buffer->write(data, length);
+		this->_storage.reset(buffer);
+	}
+
+	SharedByteBuffer::SharedByteBuffer(const ByteBuffer& buffer) :
+		SharedByteBuffer(buffer.data(), buffer.index())
+	{
+	}
+
+	SharedByteBuffer::SharedByteBuffer(ByteBuffer&& buffer) :
+		_storage(new ByteBuffer(stl::move(buffer))), _offset(0), _length(0)
+	{
+		this->_length = this->_storage->index();
+	}
+
+	SharedByteBuffer::SharedByteBuffer(const SharedPointer<ByteBuffer>& storage) :
+		_storage(storage), _offset(0), _length(storage ? storage->index() : 0)
+	{
+	}
+
+	SharedByteBuffer::SharedByteBuffer(const SharedPointer<ByteBuffer>& storage, size_t offset, size_t length) :
+		_storage(storage), _offset(offset), _length(length)
+	{
+	}
+
+	SharedByteBuffer::SharedByteBuffer(SharedByteBuffer&& other) noexcept :
+		_storage(stl::move(other._storage)), _offset(other._offset), _length(other._length)
+	{
+		other._offset = 0;
+		other._length = 0;
+	}
+
+	SharedByteBuffer& SharedByteBuffer::operator=(SharedByteBuffer&& rhs) noexcept
+	{
+		this->_storage = stl::move(rhs._storage);
+		this->_offset = rhs._offset;
+		this->_length = rhs._length;
+
+		rhs._storage.reset();
+		rhs._offset = 0;
+		rhs._length = 0;
+
+		return *this;
+	}
+
+	SharedByteBuffer SharedByteBuffer::slice(size_t offset, size_t length) const
+	{
+		if(offset > this->_length)
+			offset = this->_length;
+
+		if(length > this->_length - offset)
+			length = this->_length - offset;
+
+		return SharedByteBuffer(this->_storage, this->_offset + offset, length);
+	}
+
+	ByteBuffer SharedByteBuffer::toByteBuffer() const
+	{
+		ByteBuffer buffer(this->_length, true);
+
+		buffer.write(this->data(), this->_length);
+		return buffer;
+	}
+
+	bool SharedByteBuffer::operator==(const SharedByteBuffer& rhs) const
+	{
+		if(this->_length != rhs._length)
+			return false;
+
+		if(this->data() == rhs.data() || this->_length == 0)
+			return true;
+
+		return memcmp(this->data(), rhs.data(), this->_length) == 0;
+	}
+
+	bool SharedByteBuffer::operator!=(const SharedByteBuffer& rhs) const
+	{
+		return !(*this == rhs);
+	}
+}
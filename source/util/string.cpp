@@ -28,6 +28,9 @@
 
 #include <lwiot/lwiot.h>
 #include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/stl/move.h>
+#include <lwiot/util/numberformat.h>
 
 #ifdef WIN32
 #pragma warning (disable : 4244)
@@ -44,6 +47,13 @@ namespace lwiot
 				copy(cstr, strlen(cstr));
 		}
 
+		String::String(const char *cstr, size_t length) : buffer(nullptr), capacity(0), len(0)
+		{
+			init();
+			if(cstr)
+				copy(cstr, length);
+		}
+
 		String::String(const lwiot::ByteBuffer &buf) : buffer(nullptr), capacity(0), len(0)
 		{
 			this->init();
@@ -83,77 +93,73 @@ namespace lwiot
 
 		String::String(unsigned char value, unsigned char base) : buffer(nullptr), capacity(0), len(0)
 		{
-			char buf[1 + 8 * sizeof(unsigned char)];
-			UNUSED(base);
+			char buf[NumberFormat::BufferSize];
 
 			init();
-			sprintf(buf, "%u", value);
-			*this = buf;
+			this->copy(buf, NumberFormat::formatUnsigned(buf, value, base));
 		}
 
 		String::String(int value, unsigned char base) : buffer(nullptr), capacity(0), len(0)
 		{
-			char buf[2 + 8 * sizeof(int)];
-			UNUSED(base);
+			char buf[NumberFormat::BufferSize];
+			auto length = base == 10 ? NumberFormat::formatSigned(buf, value) :
+				NumberFormat::formatUnsigned(buf, static_cast<unsigned int>(value), base);
 
 			init();
-			sprintf(buf, "%i", value);
-			*this = buf;
+			this->copy(buf, length);
 		}
 
 		String::String(unsigned int value, unsigned char base) : buffer(nullptr), capacity(0), len(0)
 		{
-			UNUSED(base);
-			char buf[1 + 8 * sizeof(unsigned int)];
+			char buf[NumberFormat::BufferSize];
 
 			init();
-			sprintf(buf, "%u", value);
-			*this = buf;
+			this->copy(buf, NumberFormat::formatUnsigned(buf, value, base));
 		}
 
 		String::String(long value, unsigned char base) : buffer(nullptr), capacity(0), len(0)
 		{
-			init();
-			char buf[2 + 8 * sizeof(long)];
+			char buf[NumberFormat::BufferSize];
+			auto length = base == 10 ? NumberFormat::formatSigned(buf, value) :
+				NumberFormat::formatUnsigned(buf, static_cast<unsigned long>(value), base);
 
-			UNUSED(base);
-			sprintf(buf, "%li", value);
-			*this = buf;
+			init();
+			this->copy(buf, length);
 		}
 
 		String::String(unsigned long value, unsigned char base) : buffer(nullptr), capacity(0), len(0)
 		{
-			init();
-			char buf[1 + 8 * sizeof(unsigned long)];
+			char buf[NumberFormat::BufferSize];
 
-			UNUSED(base);
-			sprintf(buf, "%lu", value);
-			*this = buf;
+			init();
+			this->copy(buf, NumberFormat::formatUnsigned(buf, value, base));
 		}
 
+		/*
+		 * The decimal places argument has never been honoured: floats are always formatted
+		 * with six decimals, like printf's %f.
+		 */
 		String::String(float value, unsigned char decimalPlaces) : buffer(nullptr), capacity(0), len(0)
 		{
-			init();
-			char buf[33];
+			char buf[NumberFormat::BufferSize];
 
 			UNUSED(decimalPlaces);
-			sprintf(buf, "%f", (double) value);
-			*this = buf;
+			init();
+			this->copy(buf, NumberFormat::formatFloat(buf, value, 6));
 		}
 
 		String::String(double value, unsigned char decimalPlaces) : buffer(nullptr), capacity(0), len(0)
 		{
-			init();
-			char buf[33];
+			char buf[NumberFormat::BufferSize];
 
 			UNUSED(decimalPlaces);
-			sprintf(buf, "%f", value);
-			*this = buf;
+			init();
+			this->copy(buf, NumberFormat::formatFloat(buf, value, 6));
 		}
 
 		String::~String()
 		{
-			if(buffer == nullptr)
+			if(buffer == nullptr || isInline())
 				return;
 			lwiot_mem_free(buffer);
 		}
@@ -171,7 +177,7 @@ namespace lwiot
 
 		void String::invalidate()
 		{
-			if(buffer)
+			if(buffer && !isInline())
 				lwiot_mem_free(buffer);
 			buffer = nullptr;
 			capacity = len = 0;
@@ -195,22 +201,35 @@ namespace lwiot
 
 		unsigned char String::changeBuffer(unsigned int maxStrLen)
 		{
-			unsigned char rv = 0;
-			char *newbuffer = (char *) lwiot_mem_realloc(buffer, maxStrLen + 1);
+			char *newbuffer;
 
-			if(capacity == 0) {
-				buffer = newbuffer;
-				capacity = maxStrLen;
+			if(buffer == nullptr && maxStrLen <= InlineCapacity) {
+				memset(inlineBuffer, 0, sizeof(inlineBuffer));
+				buffer = inlineBuffer;
+				capacity = InlineCapacity;
+				return 1;
+			}
+
+			if(buffer == nullptr || isInline()) {
+				newbuffer = (char *) lwiot_mem_alloc(maxStrLen + 1);
+
+				if(newbuffer == nullptr)
+					return 0;
 
 				memset(newbuffer, 0, maxStrLen + 1);
-				rv = 1;
-			} else if(newbuffer) {
-				buffer = newbuffer;
-				capacity = maxStrLen;
-				rv = 1;
+
+				if(buffer)
+					memcpy(newbuffer, buffer, len + 1);
+			} else {
+				newbuffer = (char *) lwiot_mem_realloc(buffer, maxStrLen + 1);
+
+				if(newbuffer == nullptr)
+					return 0;
 			}
 
-			return rv;
+			buffer = newbuffer;
+			capacity = maxStrLen;
+			return 1;
 		}
 
 		/*********************************************/
@@ -234,6 +253,7 @@ namespace lwiot
 
 			len = length;
 			memcpy(buffer, cstr, length);
+			buffer[length] = 0;
 
 			return *this;
 		}
@@ -247,12 +267,20 @@ namespace lwiot
 					strcpy(buffer, rhs.buffer);
 					len = rhs.len;
 					rhs.len = 0;
+					rhs.buffer[0] = 0;
 					return;
-				} else {
+				} else if(!isInline()) {
 					lwiot_mem_free(buffer);
 				}
 			}
-			buffer = rhs.buffer;
+
+			if(rhs.isInline()) {
+				memcpy(inlineBuffer, rhs.inlineBuffer, sizeof(inlineBuffer));
+				buffer = inlineBuffer;
+			} else {
+				buffer = rhs.buffer;
+			}
+
 			capacity = rhs.capacity;
 			len = rhs.len;
 			rhs.buffer = nullptr;
@@ -397,6 +425,116 @@ namespace lwiot
 			return concat(buf, (unsigned int) strlen(buf));
 		}
 
+		/*
+		 * Reserve room for another `extra' characters. The buffer grows geometrically, so a chain
+		 * of additions does not reallocate for every operand.
+		 */
+		unsigned char String::reserveForAppend(unsigned int extra)
+		{
+			auto needed = len + extra;
+
+			if(buffer && needed <= capacity)
+				return 1;
+
+			if(needed < capacity * 2)
+				needed = capacity * 2;
+
+			return reserve(needed);
+		}
+
+		void String::appendPieces(const detail::StringPiece *pieces, size_t num)
+		{
+			size_t total = len;
+
+			for(size_t idx = 0; idx < num; idx++) {
+				auto data = pieces[idx].data();
+
+				/* Growing the buffer would invalidate pieces that point into it. */
+				if(buffer && data >= buffer && data <= buffer + len) {
+					String copy(buffer, len);
+
+					copy.appendPieces(pieces, num);
+					*this = stl::move(copy);
+					return;
+				}
+
+				total += pieces[idx].length();
+			}
+
+			if(!reserve(total)) {
+				invalidate();
+				return;
+			}
+
+			for(size_t idx = 0; idx < num; idx++) {
+				memcpy(buffer + len, pieces[idx].data(), pieces[idx].length());
+				len += pieces[idx].length();
+			}
+
+			buffer[len] = 0;
+		}
+
+		namespace detail
+		{
+			StringPiece::StringPiece(const String &str) : _data(str.c_str() ? str.c_str() : ""), _length(str.length())
+			{
+			}
+
+			StringPiece::StringPiece(const StringView &str) : _data(str.data()), _length(str.length())
+			{
+			}
+
+			StringPiece::StringPiece(const char *cstr) : _data(cstr ? cstr : ""), _length(cstr ? strlen(cstr) : 0)
+			{
+			}
+
+			StringPiece::StringPiece(char c) : _data(nullptr), _length(1)
+			{
+				this->_local[0] = c;
+				this->_local[1] = '\0';
+			}
+
+			StringPiece::StringPiece(unsigned char num) : _data(nullptr)
+			{
+				this->_length = NumberFormat::formatUnsigned(this->_local, num);
+			}
+
+			StringPiece::StringPiece(int num) : _data(nullptr)
+			{
+				this->_length = NumberFormat::formatSigned(this->_local, num);
+			}
+
+			StringPiece::StringPiece(unsigned int num) : _data(nullptr)
+			{
+				this->_length = NumberFormat::formatUnsigned(this->_local, num);
+			}
+
+			StringPiece::StringPiece(long num) : _data(nullptr)
+			{
+				this->_length = NumberFormat::formatSigned(this->_local, num);
+			}
+
+			StringPiece::StringPiece(unsigned long num) : _data(nullptr)
+			{
+				this->_length = NumberFormat::formatUnsigned(this->_local, num);
+			}
+
+			StringPiece::StringPiece(long long num) : _data(nullptr)
+			{
+				this->_length = NumberFormat::formatSigned(this->_local, num);
+			}
+
+			StringPiece::StringPiece(unsigned long long num) : _data(nullptr)
+			{
+				this->_length = NumberFormat::formatUnsigned(this->_local, num);
+			}
+
+			StringPiece::StringPiece(double num) : _data(nullptr)
+			{
+				this->_length = NumberFormat::formatFloat(this->_local, num, 6);
+			}
+		}
+
 		/*********************************************/
 		/*  Concatenate                              */
 		/*********************************************/
@@ -404,6 +542,7 @@ namespace lwiot
 		StringSumHelper &operator+(const StringSumHelper &lhs, const String &rhs)
 		{
 			StringSumHelper &a = const_cast<StringSumHelper &>(lhs);
+			a.reserveForAppend(rhs.len);
 			if(!a.concat(rhs.buffer, rhs.len))
 				a.invalidate();
 			return a;
@@ -412,7 +551,10 @@ namespace lwiot
 		StringSumHelper &operator+(const StringSumHelper &lhs, const char *cstr)
 		{
 			StringSumHelper &a = const_cast<StringSumHelper &>(lhs);
-			if(!cstr || !a.concat(cstr, strlen(cstr)))
+			auto length = cstr ? strlen(cstr) : 0;
+
+			a.reserveForAppend(length);
+			if(!cstr || !a.concat(cstr, length))
 				a.invalidate();
 			return a;
 		}
@@ -420,6 +562,7 @@ namespace lwiot
 		StringSumHelper &operator+(const StringSumHelper &lhs, char c)
 		{
 			StringSumHelper &a = const_cast<StringSumHelper &>(lhs);
+			a.reserveForAppend(1);
 			if(!a.concat(c))
 				a.invalidate();
 			return a;
@@ -428,6 +571,7 @@ namespace lwiot
 		StringSumHelper &operator+(const StringSumHelper &lhs, unsigned char num)
 		{
 			StringSumHelper &a = const_cast<StringSumHelper &>(lhs);
+			a.reserveForAppend(3 * sizeof(num));
 			if(!a.concat(num))
 				a.invalidate();
 			return a;
@@ -436,6 +580,7 @@ namespace lwiot
 		StringSumHelper &operator+(const StringSumHelper &lhs, int num)
 		{
 			StringSumHelper &a = const_cast<StringSumHelper &>(lhs);
+			a.reserveForAppend(2 + 3 * sizeof(num));
 			if(!a.concat(num))
 				a.invalidate();
 			return a;
@@ -444,6 +589,7 @@ namespace lwiot
 		StringSumHelper &operator+(const StringSumHelper &lhs, unsigned int num)
 		{
 			StringSumHelper &a = const_cast<StringSumHelper &>(lhs);
+			a.reserveForAppend(1 + 3 * sizeof(num));
 			if(!a.concat(num))
 				a.invalidate();
 			return a;
@@ -452,6 +598,7 @@ namespace lwiot
 		StringSumHelper &operator+(const StringSumHelper &lhs, long num)
 		{
 			StringSumHelper &a = const_cast<StringSumHelper &>(lhs);
+			a.reserveForAppend(2 + 3 * sizeof(num));
 			if(!a.concat(num))
 				a.invalidate();
 			return a;
@@ -460,6 +607,7 @@ namespace lwiot
 		StringSumHelper &operator+(const StringSumHelper &lhs, unsigned long num)
 		{
 			StringSumHelper &a = const_cast<StringSumHelper &>(lhs);
+			a.reserveForAppend(1 + 3 * sizeof(num));
 			if(!a.concat(num))
 				a.invalidate();
 			return a;
@@ -468,6 +616,7 @@ namespace lwiot
 		StringSumHelper &operator+(const StringSumHelper &lhs, float num)
 		{
 			StringSumHelper &a = const_cast<StringSumHelper &>(lhs);
+			a.reserveForAppend(32);
 			if(!a.concat(num))
 				a.invalidate();
 			return a;
@@ -476,6 +625,7 @@ namespace lwiot
 		StringSumHelper &operator+(const StringSumHelper &lhs, double num)
 		{
 			StringSumHelper &a = const_cast<StringSumHelper &>(lhs);
+			a.reserveForAppend(32);
 			if(!a.concat(num))
 				a.invalidate();
 			return a;
@@ -0,0 +1,272 @@
+/*
+ * Tokenized (binary) logging.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/format.h>
+#include <lwiot/util/tokenizedlog.h>
+
+static_assert(CONFIG_LOG_TOKEN_RECORD_SIZE <= 256, "Tokenized records have a single length byte");
+
+#ifndef CONFIG_STANDALONE
+static_assert(CONFIG_LOG_TOKEN_RECORD_SIZE <= CONFIG_LOG_RECORD_SIZE, "Tokenized records must fit a log record");
+#endif
+
+namespace lwiot
+{
+	namespace detail
+	{
+		/* Argument kinds on the wire, a nibble each. */
+		enum TokenKind : uint8_t {
+			TokenSigned = 1,
+			TokenUnsigned,
+			TokenFloat,
+			TokenChar,
+			TokenBool,
+			TokenString,
+			TokenPointer,
+			TokenDouble
+		};
+
+		static size_t varint_size(unsigned long long value)
+		{
+			size_t size = 1;
+
+			while(value >= 0x80) {
+				value >>= 7;
+				size++;
+			}
+
+			return size;
+		}
+
+		static uint8_t *put_varint(uint8_t *output, unsigned long long value)
+		{
+			while(value >= 0x80) {
+				*output++ = static_cast<uint8_t>(value | 0x80);
+				value >>= 7;
+			}
+
+			*output++ = static_cast<uint8_t>(value);
+			return output;
+		}
+
+		static uint8_t *put_bytes(uint8_t *output, const void *data, size_t length)
+		{
+			auto bytes = static_cast<const uint8_t *>(data);
+
+			/* Little endian, whatever the host is. */
+#ifdef HAVE_BIG_ENDIAN
+			for(size_t idx = 0; idx < length; idx++)
+				output[idx] = bytes[length - idx - 1];
+#else
+			memcpy(output, bytes, length);
+#endif
+			return output + length;
+		}
+
+		size_t encode_log_record(uint8_t *output, size_t size, LogLevel level, uint32_t token, time_t tick,
+		                         const FormatArg *args, size_t num)
+		{
+			if(size > 256)
+				size = 256;
+
+			if(num > 15)
+				num = 15;
+
+			auto kinds = 6 + varint_size(static_cast<unsigned long long>(tick));
+
+			if(kinds + (num + 1) / 2 > size)
+				return 0;
+
+			auto ptr = put_bytes(output + 1, &token, sizeof(token));
+			ptr = put_varint(ptr, static_cast<unsigned long long>(tick));
+			auto header = ptr++;
+			ptr += (num + 1) / 2;
+
+			const auto end = output + size;
+			size_t idx;
+
+			for(idx = 0; idx < num; idx++) {
+				const auto& arg = args[idx];
+				unsigned long long value = 0;
+				uint8_t kind;
+
+				switch(arg.kind) {
+				case FormatKind::Signed:
+					kind = TokenSigned;
+					value = (static_cast<unsigned long long>(arg.i) << 1) ^ static_cast<unsigned long long>(arg.i >> 63);
+					break;
+
+				case FormatKind::Unsigned:
+					kind = TokenUnsigned;
+					value = arg.u;
+					break;
+
+				case FormatKind::Char:
+					kind = TokenChar;
+					value = arg.u;
+					break;
+
+				case FormatKind::Bool:
+					kind = TokenBool;
+					value = arg.u;
+					break;
+
+				case FormatKind::Pointer:
+					kind = TokenPointer;
+					value = reinterpret_cast<uintptr_t>(arg.p);
+					break;
+
+				case FormatKind::Float: {
+					auto single = static_cast<float>(arg.f);
+
+					if(static_cast<double>(single) == arg.f || arg.f != arg.f) {
+						if(end - ptr < 4)
+							goto done;
+
+						kind = TokenFloat;
+						ptr = put_bytes(ptr, &single, sizeof(single));
+					} else {
+						if(end - ptr < 8)
+							goto done;
+
+						kind = TokenDouble;
+						ptr = put_bytes(ptr, &arg.f, sizeof(arg.f));
+					}
+					break;
+				}
+
+				case FormatKind::String: {
+					auto room = static_cast<size_t>(end - ptr);
+					size_t length = arg.length;
+
+					if(room == 0)
+						goto done;
+
+					if(length + varint_size(length) > room)
+						length = room - varint_size(room);
+
+					kind = TokenString;
+					ptr = put_varint(ptr, length);
+					memcpy(ptr, arg.s, length);
+					ptr += length;
+					break;
+				}
+
+				default:
+					goto done;
+				}
+
+				if(kind != TokenFloat && kind != TokenDouble && kind != TokenString) {
+					if(static_cast<size_t>(end - ptr) < varint_size(value))
+						goto done;
+
+					ptr = put_varint(ptr, value);
+				}
+
+				if(idx & 1)
+					header[1 + idx / 2] |= static_cast<uint8_t>(kind << 4);
+				else
+					header[1 + idx / 2] = kind;
+			}
+
+done:
+			/* Arguments that did not fit are left out. */
+			*header = static_cast<uint8_t>(static_cast<uint8_t>(level) << 4 | idx);
+
+			if(idx < num) {
+				auto used = (idx + 1) / 2;
+
+				memmove(header + 1 + used, header + 1 + (num + 1) / 2, static_cast<size_t>(ptr - header - 1 - (num + 1) / 2));
+				ptr -= (num + 1) / 2 - used;
+
+				if(idx & 1)
+					header[used] &= 0x0F;
+			}
+
+			output[0] = static_cast<uint8_t>(ptr - output - 1);
+			return static_cast<size_t>(ptr - output);
+		}
+	}
+
+	TokenizedLogger::TokenizedLogger(Stream &output) : _output(&output)
+#ifndef CONFIG_STANDALONE
+		, _backend(nullptr)
+#endif
+	{
+	}
+
+#ifndef CONFIG_STANDALONE
+	TokenizedLogger::TokenizedLogger(AsyncLogBackend &backend) : _output(nullptr), _backend(&backend)
+	{
+	}
+#endif
+
+	bool TokenizedLogger::write(LogLevel level, uint32_t token, const detail::FormatArg *args, size_t num)
+	{
+		uint8_t record[CONFIG_LOG_TOKEN_RECORD_SIZE];
+		auto length = detail::encode_log_record(record, sizeof(record), level, token, lwiot_tick_ms(), args, num);
+
+		if(length == 0)
+			return false;
+
+#ifndef CONFIG_STANDALONE
+		if(this->_backend != nullptr)
+			return this->_backend->log(level, nullptr, LogRecord::Binary, reinterpret_cast<const char *>(record), length);
+#endif
+
+		return this->_output->write(record, length) == static_cast<ssize_t>(length);
+	}
+
+#ifndef CONFIG_STANDALONE
+	TokenizedLogSink::TokenizedLogSink(Stream &output) : _output(output), _length(0)
+	{
+	}
+
+	void TokenizedLogSink::write(const LogRecord &record)
+	{
+		if(sizeof(this->_buffer) - this->_length < CONFIG_LOG_RECORD_SIZE + 16)
+			this->flush();
+
+		if(record.flags & LogRecord::Binary) {
+			memcpy(this->_buffer + this->_length, record.payload, record.length);
+			this->_length += record.length;
+			return;
+		}
+
+		/* Text is sent as token 0, with the subsystem, the text and the flags as arguments. */
+		detail::FormatArg args[3];
+
+		args[0].kind = detail::FormatKind::String;
+		args[0].s = record.subsystem;
+		args[0].length = strlen(record.subsystem);
+		args[1].kind = detail::FormatKind::String;
+		args[1].s = record.payload;
+		args[1].length = record.length;
+		args[2].kind = detail::FormatKind::Unsigned;
+		args[2].u = record.flags;
+
+		this->_length += detail::encode_log_record(this->_buffer + this->_length, sizeof(this->_buffer) - this->_length,
+		                                           record.level, 0, record.tick, args, 3);
+	}
+
+	void TokenizedLogSink::flush()
+	{
+		if(this->_length == 0)
+			return;
+
+		this->_output.write(this->_buffer, this->_length);
+		this->_length = 0;
+	}
+#endif
+}
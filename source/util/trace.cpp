@@ -0,0 +1,213 @@
+/*
+ * Tracing spans.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/stream.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/util/trace.h>
+
+static_assert((CONFIG_TRACE_EVENTS & (CONFIG_TRACE_EVENTS - 1)) == 0, "CONFIG_TRACE_EVENTS must be a power of two");
+
+namespace lwiot
+{
+	namespace
+	{
+		struct TraceBuffer {
+			Atomic<uint8_t> used;
+			uint16_t thread;
+			const char *name;
+
+			/* Spans recorded, only written by the owning thread. */
+			Atomic<uint32_t> head;
+
+			/* Spans written out, only used under the write lock. */
+			uint32_t tail;
+
+			TraceEvent events[CONFIG_TRACE_EVENTS];
+		};
+
+		TraceBuffer buffers[CONFIG_TRACE_THREADS];
+		Atomic<uint16_t> threads(0);
+		Atomic<long> lost(0);
+
+		/* Returns the buffer of a thread when it exits. Spans that were not written yet are kept. */
+		struct ThreadBuffer {
+			~ThreadBuffer()
+			{
+				if(this->buffer != nullptr)
+					this->buffer->used.store(0, memory_order_release);
+			}
+
+			TraceBuffer *buffer;
+			bool claimed;
+		};
+
+		thread_local ThreadBuffer current = { nullptr, false };
+
+		TraceBuffer *thread_buffer()
+		{
+			if(current.claimed)
+				return current.buffer;
+
+			current.claimed = true;
+
+			for(auto& buffer : buffers) {
+				uint8_t expected = 0;
+
+				if(!buffer.used.compare_exchange_strong(expected, 1, memory_order_acquire, memory_order_relaxed))
+					continue;
+
+				buffer.thread = static_cast<uint16_t>(threads.fetch_add(1) + 1);
+				buffer.name = nullptr;
+				current.buffer = &buffer;
+				break;
+			}
+
+			return current.buffer;
+		}
+
+		Lock& write_lock()
+		{
+			static Lock lock;
+			return lock;
+		}
+
+		/* Copy a string into a JSON document, escaping what has to be. */
+		size_t escape(char *output, size_t size, const char *text)
+		{
+			size_t length = 0;
+
+			for(; *text != '\0' && length + 2 < size; text++) {
+				if(*text == '"' || *text == '\\')
+					output[length++] = '\\';
+
+				output[length++] = static_cast<uint8_t>(*text) < ' ' ? ' ' : *text;
+			}
+
+			output[length] = '\0';
+			return length;
+		}
+	}
+
+	void Tracer::record(const char *name, uint64_t begin, uint64_t end)
+	{
+		auto buffer = thread_buffer();
+
+		if(buffer == nullptr) {
+			lost.fetch_add(1, memory_order_relaxed);
+			return;
+		}
+
+		auto head = buffer->head.load(memory_order_relaxed);
+		auto& event = buffer->events[head & (CONFIG_TRACE_EVENTS - 1)];
+		auto duration = end - begin;
+
+		event.name = name;
+		event.begin = begin;
+		event.duration = duration > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(duration);
+		event.thread = buffer->thread;
+
+		buffer->head.store(head + 1, memory_order_release);
+	}
+
+	void Tracer::setThreadName(const char *name)
+	{
+		auto buffer = thread_buffer();
+
+		if(buffer != nullptr)
+			buffer->name = name;
+	}
+
+	size_t Tracer::dropped()
+	{
+		return static_cast<size_t>(lost.load(memory_order_relaxed));
+	}
+
+	bool Tracer::write(const Writer &writer)
+	{
+		ScopedLock lock(write_lock());
+		char line[192];
+		char name[64];
+		bool first = true;
+
+		if(!writer("{\"traceEvents\":[", 16))
+			return false;
+
+		for(auto& buffer : buffers) {
+			auto head = buffer.head.load(memory_order_acquire);
+			auto start = head - buffer.tail > CONFIG_TRACE_EVENTS ? head - CONFIG_TRACE_EVENTS : buffer.tail;
+
+			lost.fetch_add(static_cast<long>(start - buffer.tail), memory_order_relaxed);
+
+			if(buffer.used.load(memory_order_acquire) && buffer.name != nullptr) {
+				escape(name, sizeof(name), buffer.name);
+				auto length = snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+				                       "\"tid\":%u,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n",
+				                       static_cast<unsigned>(buffer.thread), name);
+
+				first = false;
+
+				if(!writer(line, static_cast<size_t>(length)))
+					return false;
+			}
+
+			for(auto idx = start; idx != head; idx++) {
+				auto event = buffer.events[idx & (CONFIG_TRACE_EVENTS - 1)];
+
+				/* The thread may have overwritten the span while it was copied. */
+				atomic_thread_fence(memory_order_acquire);
+
+				if(buffer.head.load(memory_order_relaxed) - idx > CONFIG_TRACE_EVENTS) {
+					lost.fetch_add(1, memory_order_relaxed);
+					continue;
+				}
+
+				escape(name, sizeof(name), event.name);
+				auto length = snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+				                       "\"ts\":%llu.%03u,\"dur\":%lu.%03u}", first ? "" : ",\n", name,
+				                       static_cast<unsigned>(event.thread),
+				                       static_cast<unsigned long long>(event.begin / 1000U),
+				                       static_cast<unsigned>(event.begin % 1000U),
+				                       static_cast<unsigned long>(event.duration / 1000U),
+				                       static_cast<unsigned>(event.duration % 1000U));
+
+				first = false;
+
+				if(!writer(line, static_cast<size_t>(length)))
+					return false;
+			}
+
+			buffer.tail = head;
+		}
+
+		return writer("]}\n", 3);
+	}
+
+	bool Tracer::write(FILE *file)
+	{
+		auto rv = Tracer::write([file](const char *data, size_t length) {
+			return fwrite(data, 1, length, file) == length;
+		});
+
+		fflush(file);
+		return rv;
+	}
+
+	bool Tracer::write(Stream &stream)
+	{
+		return Tracer::write([&stream](const char *data, size_t length) {
+			return stream.write(data, length) == static_cast<ssize_t>(length);
+		});
+	}
+}
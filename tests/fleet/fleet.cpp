@@ -0,0 +1,364 @@
+/*
+ * Hosted fleet load runner.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define HAVE_MALLINFO2 1
+#endif
+
+#include <lwiot/log.h>
+#include <lwiot/kernel/coroutine.h>
+
+#include "fleet.h"
+#include "gateway.h"
+#include "nodes.h"
+
+#define KIND_COUNT static_cast<size_t>(Kind::Count)
+
+namespace fleet
+{
+	static const char *kind_names[] = { "MQTT", "HTTP", "XBee" };
+
+	size_t Histogram::index(uint64_t value)
+	{
+		if(value < SubBuckets)
+			return value;
+
+		auto exponent = 63 - __builtin_clzll(value);
+		auto sub = (value >> (exponent - 4)) & (SubBuckets - 1);
+
+		return (exponent - 3) * SubBuckets + sub;
+	}
+
+	uint64_t Histogram::upper(size_t idx)
+	{
+		if(idx < SubBuckets)
+			return idx;
+
+		auto exponent = idx / SubBuckets + 3;
+		auto sub = idx % SubBuckets;
+		auto lower = static_cast<uint64_t>(SubBuckets + sub) << (exponent - 4);
+
+		return lower + (1ULL << (exponent - 4)) - 1;
+	}
+
+	void Histogram::record(uint64_t value)
+	{
+		auto max = this->_max.load(lwiot::memory_order_relaxed);
+
+		this->_buckets[index(value)].fetch_add(1, lwiot::memory_order_relaxed);
+
+		while(value > max && !this->_max.compare_exchange_weak(max, value, lwiot::memory_order_relaxed))
+			;
+	}
+
+	void Histogram::reset()
+	{
+		for(auto& bucket : this->_buckets)
+			bucket.store(0, lwiot::memory_order_relaxed);
+
+		this->_max.store(0, lwiot::memory_order_relaxed);
+	}
+
+	uint64_t Histogram::count() const
+	{
+		uint64_t count = 0;
+
+		for(auto& bucket : this->_buckets)
+			count += bucket.load(lwiot::memory_order_relaxed);
+
+		return count;
+	}
+
+	uint64_t Histogram::max() const
+	{
+		return this->_max.load(lwiot::memory_order_relaxed);
+	}
+
+	uint64_t Histogram::percentile(double fraction) const
+	{
+		auto count = this->count();
+		uint64_t seen = 0;
+
+		if(count == 0)
+			return 0;
+
+		auto rank = static_cast<uint64_t>(fraction * static_cast<double>(count) + 0.5);
+
+		if(rank == 0)
+			rank = 1;
+
+		for(size_t idx = 0; idx < Buckets; idx++) {
+			seen += this->_buckets[idx].load(lwiot::memory_order_relaxed);
+
+			if(seen >= rank) {
+				auto value = upper(idx);
+				return value < this->max() ? value : this->max();
+			}
+		}
+
+		return this->max();
+	}
+
+	void Statistics::reset()
+	{
+		this->sent.store(0);
+		this->received.store(0);
+		this->bytes.store(0);
+		this->errors.store(0);
+		this->timeouts.store(0);
+		this->connects.store(0);
+		this->latency.reset();
+	}
+
+	Fleet::Fleet(const Options& options) : _options(options), _executor("fleet", options.workers),
+		_running(false), _gateway(nullptr), _elapsed(0), _resident{0, 0}, _heap{0, 0}
+	{
+	}
+
+	Fleet::~Fleet()
+	{
+		this->stop();
+	}
+
+	bool Fleet::running() const
+	{
+		return this->_running.load() != 0;
+	}
+
+	const Options& Fleet::options() const
+	{
+		return this->_options;
+	}
+
+	lwiot::Executor& Fleet::executor()
+	{
+		return this->_executor;
+	}
+
+	Statistics& Fleet::statistics(Kind kind)
+	{
+		return this->_stats[static_cast<size_t>(kind)];
+	}
+
+	int Fleet::delay(size_t idx, size_t count) const
+	{
+		if(count == 0)
+			return 0;
+
+		return static_cast<int>(static_cast<uint64_t>(this->_options.ramp) * idx / count);
+	}
+
+	uint64_t Fleet::generated() const
+	{
+		uint64_t generated = 0;
+
+		for(auto site : this->_sites)
+			generated += site->statistics().generated;
+
+		return generated;
+	}
+
+	bool Fleet::run()
+	{
+		auto total = this->_options.mqtt + this->_options.http + this->_options.sites;
+		size_t idx = 0;
+
+		if(this->_options.local) {
+			this->_gateway = new Gateway(this->_options);
+
+			if(!this->_gateway->start()) {
+				delete this->_gateway;
+				this->_gateway = nullptr;
+				return false;
+			}
+		}
+
+		this->_resident[0] = resident();
+		this->_heap[0] = heap();
+		this->_running = true;
+		this->_executor.start();
+
+		/* Interleave the kinds, so that each is started over the whole ramp. */
+		for(size_t num = 0; idx < total; num++) {
+			if(num < this->_options.mqtt) {
+				this->_nodes.pushback(new MqttNode(*this, num, this->delay(idx, total)));
+				idx++;
+			}
+
+			if(num < this->_options.http) {
+				this->_nodes.pushback(new HttpNode(*this, this->_options.mqtt + num, this->delay(idx, total)));
+				idx++;
+			}
+
+			if(num < this->_options.sites) {
+				this->_sites.pushback(new XBeeSite(*this, this->delay(idx, total)));
+				idx++;
+			}
+		}
+
+		for(auto node : this->_nodes)
+			node->start(this->_executor);
+
+		for(auto site : this->_sites)
+			site->start(this->_executor);
+
+		lwiot_sleep(this->_options.ramp + this->_options.interval);
+
+		for(auto& stats : this->_stats)
+			stats.reset();
+
+		auto generated = this->generated();
+		auto start = lwiot_tick_ms();
+
+		lwiot_sleep(this->_options.duration * 1000);
+
+		for(size_t kind = 0; kind < KIND_COUNT; kind++)
+			this->_results[kind] = this->_stats[kind];
+
+		this->_results[static_cast<size_t>(Kind::XBee)].sent = this->generated() - generated;
+		this->_elapsed = lwiot_tick_ms() - start;
+		this->_resident[1] = resident();
+		this->_heap[1] = heap();
+
+		this->stop();
+		return true;
+	}
+
+	void Fleet::stop()
+	{
+		this->_running = false;
+
+		for(auto node : this->_nodes)
+			node->join(CONFIG_FLEET_TIMEOUT + CONFIG_FLEET_BACKOFF);
+
+		for(auto site : this->_sites) {
+			site->stop();
+			site->join(CONFIG_FLEET_TIMEOUT);
+		}
+
+		this->_executor.stop();
+
+		for(auto node : this->_nodes)
+			delete node;
+
+		for(auto site : this->_sites)
+			delete site;
+
+		this->_nodes.clear();
+		this->_sites.clear();
+
+		if(this->_gateway != nullptr) {
+			this->_gateway->stop();
+			delete this->_gateway;
+			this->_gateway = nullptr;
+		}
+	}
+
+	bool Fleet::report(FILE *output) const
+	{
+		size_t counts[] = { this->_options.mqtt, this->_options.http, this->_options.sites * this->_options.xbee };
+		auto seconds = static_cast<double>(this->_elapsed) / 1000.0;
+		size_t nodes = 0;
+		bool ok = true;
+
+		if(seconds <= 0.0)
+			return false;
+
+		fprintf(output, "Fleet of %u MQTT, %u HTTP and %u XBee nodes (%u sites), a sample every %d ms, "
+				"measured for %.1f s against %s\n\n", static_cast<unsigned>(counts[0]),
+				static_cast<unsigned>(counts[1]), static_cast<unsigned>(counts[2]),
+				static_cast<unsigned>(this->_options.sites), this->_options.interval, seconds,
+				this->_options.local ? "the local gateway" : this->_options.gateway.toString().c_str());
+
+		fprintf(output, "%-6s %7s %9s %10s %10s %9s %9s %8s %8s %8s %8s %8s %8s %8s\n", "", "nodes", "connected",
+				"sent", "received", "msg/s", "KiB/s", "p50 ms", "p90 ms", "p99 ms", "max ms", "timeouts",
+				"errors", "connects");
+
+		for(size_t kind = 0; kind < KIND_COUNT; kind++) {
+			auto& stats = this->_results[kind];
+
+			if(counts[kind] == 0)
+				continue;
+
+			auto received = stats.received.load();
+
+			nodes += counts[kind];
+			fprintf(output, "%-6s %7u %9d %10llu %10llu %9.1f %9.1f %8.2f %8.2f %8.2f %8.2f %8llu %8llu %8llu\n",
+					kind_names[kind], static_cast<unsigned>(counts[kind]), stats.connected.load(),
+					static_cast<unsigned long long>(stats.sent.load()),
+					static_cast<unsigned long long>(received),
+					static_cast<double>(received) / seconds,
+					static_cast<double>(stats.bytes.load()) / 1024.0 / seconds,
+					static_cast<double>(stats.latency.percentile(0.50)) / 1000.0,
+					static_cast<double>(stats.latency.percentile(0.90)) / 1000.0,
+					static_cast<double>(stats.latency.percentile(0.99)) / 1000.0,
+					static_cast<double>(stats.latency.max()) / 1000.0,
+					static_cast<unsigned long long>(stats.timeouts.load()),
+					static_cast<unsigned long long>(stats.errors.load()),
+					static_cast<unsigned long long>(stats.connects.load()));
+
+			if(received == 0 || stats.errors.load() != 0)
+				ok = false;
+		}
+
+		auto growth = this->_resident[1] > this->_resident[0] ? this->_resident[1] - this->_resident[0] : 0;
+
+		fprintf(output, "\nMemory: %.1f MiB resident, %.1f MiB for the fleet", this->_resident[1] / 1048576.0,
+				growth / 1048576.0);
+
+		if(nodes > 0)
+			fprintf(output, ", %.1f KiB per node", growth / 1024.0 / static_cast<double>(nodes));
+
+		if(this->_heap[1] > 0) {
+			auto heap = this->_heap[1] > this->_heap[0] ? this->_heap[1] - this->_heap[0] : 0;
+			fprintf(output, " (heap: %.1f MiB)", heap / 1048576.0);
+		}
+
+		fprintf(output, "\n\nMQTT and HTTP latencies are round trips to the gateway; XBee latencies are one way "
+				"through the simulated mesh, including %d ms of latency. Nodes poll their sockets every %d ms, "
+				"which bounds the resolution.%s\n", CONFIG_FLEET_XBEE_LATENCY, CONFIG_COROUTINE_POLL_INTERVAL,
+				this->_options.local ? " The memory figures include the local gateway." : "");
+
+		return ok;
+	}
+
+	size_t resident()
+	{
+		char line[128];
+		size_t kib = 0;
+		auto file = fopen("/proc/self/status", "r");
+
+		if(file == nullptr)
+			return 0;
+
+		while(fgets(line, sizeof(line), file) != nullptr) {
+			if(strncmp(line, "VmRSS:", 6) == 0) {
+				kib = strtoul(line + 6, nullptr, 10);
+				break;
+			}
+		}
+
+		fclose(file);
+		return kib * 1024;
+	}
+
+	size_t heap()
+	{
+#ifdef HAVE_MALLINFO2
+		auto info = mallinfo2();
+		return info.uordblks + info.hblkhd;
+#else
+		return 0;
+#endif
+	}
+}
@@ -0,0 +1,167 @@
+/*
+ * Hosted fleet load runner.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/executor.h>
+#include <lwiot/network/ipaddress.h>
+#include <lwiot/stl/vector.h>
+
+#ifndef CONFIG_FLEET_TIMEOUT
+#define CONFIG_FLEET_TIMEOUT 5000
+#endif
+
+#ifndef CONFIG_FLEET_BACKOFF
+#define CONFIG_FLEET_BACKOFF 1000
+#endif
+
+namespace fleet
+{
+	class Gateway;
+	class Node;
+	class XBeeSite;
+
+	enum class Kind {
+		Mqtt,
+		Http,
+		XBee,
+		Count
+	};
+
+	struct Options {
+		size_t mqtt;          //!< MQTT nodes.
+		size_t http;          //!< HTTP nodes.
+		size_t sites;         //!< Simulated XBee coordinators.
+		size_t xbee;          //!< Remote XBee nodes per site.
+		int duration;         //!< Measurement time in seconds, after the ramp.
+		int interval;         //!< Milliseconds between the samples of a node.
+		int ramp;             //!< Milliseconds over which the nodes are started.
+		int workers;          //!< Executor worker threads.
+		lwiot::IPAddress gateway;
+		bool local;           //!< Run the gateway in this process.
+		uint16_t mqttPort;
+		uint16_t httpPort;
+	};
+
+	/**
+	 * @brief Latency histogram with a relative error of at most 1/16.
+	 *
+	 * Values below 16 have a bucket of their own; above that, every power of two is split in 16
+	 * buckets. Recording is a single relaxed increment, so all nodes can share a histogram.
+	 */
+	class Histogram {
+	public:
+		static constexpr size_t SubBuckets = 16;
+		static constexpr size_t Buckets = 61 * SubBuckets;
+
+		explicit Histogram() = default;
+
+		void record(uint64_t value);
+		void reset();
+
+		uint64_t count() const;
+		uint64_t max() const;
+
+		/**
+		 * @brief Smallest recorded value such that \p fraction of all values is not larger.
+		 * @return The upper bound of the bucket of that value, or 0 if nothing was recorded.
+		 */
+		uint64_t percentile(double fraction) const;
+
+	private:
+		lwiot::Atomic<uint64_t> _buckets[Buckets];
+		lwiot::Atomic<uint64_t> _max;
+
+		static size_t index(uint64_t value);
+		static uint64_t upper(size_t idx);
+	};
+
+	struct Statistics {
+		lwiot::Atomic<uint64_t> sent;       //!< Messages sent by the nodes.
+		lwiot::Atomic<uint64_t> received;   //!< Round trips completed.
+		lwiot::Atomic<uint64_t> bytes;      //!< Payload bytes sent.
+		lwiot::Atomic<uint64_t> errors;     //!< Failed connects, sends and sensor reads.
+		lwiot::Atomic<uint64_t> timeouts;   //!< Round trips that were not completed in time.
+		lwiot::Atomic<uint64_t> connects;   //!< (Re)connects.
+		lwiot::Atomic<int> connected;       //!< Nodes with an open connection.
+		Histogram latency;                  //!< Round trip time in microseconds.
+
+		void reset();
+	};
+
+	/**
+	 * @brief Run a fleet of virtual nodes against a gateway.
+	 *
+	 * Nodes are coroutines on a single executor, so a node costs its connection and a few hundred
+	 * bytes of state instead of a thread and its stack. They are started spread over the ramp
+	 * time, after which the counters are reset and the fleet is measured for the configured
+	 * duration.
+	 */
+	class Fleet {
+	public:
+		explicit Fleet(const Options& options);
+		virtual ~Fleet();
+
+		Fleet(const Fleet&) = delete;
+		Fleet& operator=(const Fleet&) = delete;
+
+		/**
+		 * @brief Start the nodes, measure them and stop them again.
+		 * @return False if the local gateway could not be started.
+		 */
+		bool run();
+
+		/**
+		 * @brief Write the results of the last run() to \p output.
+		 * @return True if every node kind that was run completed round trips without errors.
+		 */
+		bool report(FILE *output) const;
+
+		bool running() const;
+		const Options& options() const;
+		lwiot::Executor& executor();
+		Statistics& statistics(Kind kind);
+
+		/**
+		 * @brief Start delay of node \p idx out of \p count, in milliseconds.
+		 */
+		int delay(size_t idx, size_t count) const;
+
+	private:
+		Options _options;
+		lwiot::Executor _executor;
+		lwiot::AtomicBool _running;
+		Statistics _stats[static_cast<size_t>(Kind::Count)];
+		Statistics _results[static_cast<size_t>(Kind::Count)];
+		Gateway *_gateway;
+		lwiot::stl::Vector<Node*> _nodes;
+		lwiot::stl::Vector<XBeeSite*> _sites;
+
+		time_t _elapsed;
+		size_t _resident[2];
+		size_t _heap[2];
+
+		uint64_t generated() const;
+		void stop();
+	};
+
+	/**
+	 * @brief Resident set size of the process, in bytes.
+	 */
+	extern size_t resident();
+
+	/**
+	 * @brief Heap in use, in bytes, or 0 when the C library cannot tell.
+	 */
+	extern size_t heap();
+}
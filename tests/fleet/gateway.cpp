@@ -0,0 +1,247 @@
+/*
+ * Local gateway for the fleet runner.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/stl/move.h>
+
+#include "gateway.h"
+
+#define GATEWAY_LOOP_INTERVAL 50
+#define GATEWAY_IDLE_TIMEOUT 60000
+#define GATEWAY_SPARE_SLOTS 16
+
+namespace fleet
+{
+	Gateway::Session::Session(lwiot::UniquePointer<lwiot::TcpClient>&& socket) :
+		client(lwiot::stl::move(socket)), length(0), closed(false)
+	{
+	}
+
+	Gateway::Gateway(const Options& options) : _options(options), _broker(),
+		_http(new lwiot::SocketTcpServer(BIND_ADDR_LB, options.httpPort)), _loop(GATEWAY_LOOP_INTERVAL),
+		_brokerThread("gateway-mqtt"), _httpThread("gateway-http"), _running(false)
+	{
+		this->_http.on("/fleet/{id}", lwiot::HTTP_POST, [](lwiot::HttpServer& server) {
+			server.send(204);
+		});
+
+		this->_http.setMaxConnections(options.http + GATEWAY_SPARE_SLOTS, GATEWAY_IDLE_TIMEOUT);
+	}
+
+	Gateway::~Gateway()
+	{
+		this->stop();
+	}
+
+	bool Gateway::start()
+	{
+		if(!this->_broker.bind(BIND_ADDR_LB, this->_options.mqttPort)) {
+			print_dbg("Unable to bind the MQTT port!\n");
+			return false;
+		}
+
+		if(!this->_http.begin()) {
+			print_dbg("Unable to bind the HTTP port!\n");
+			this->_broker.close();
+			return false;
+		}
+
+		this->_loop.accept(this->_broker, [this](lwiot::UniquePointer<lwiot::TcpClient>& client) {
+			this->accept(client);
+		});
+
+		this->_running = true;
+		this->_brokerThread.start([this]() {
+			this->_loop.run();
+		});
+
+		this->_httpThread.start([this]() {
+			while(this->_running)
+				this->_http.handleClient();
+		});
+
+		return true;
+	}
+
+	void Gateway::stop()
+	{
+		if(!this->_running)
+			return;
+
+		this->_running = false;
+		this->_loop.stop();
+		this->_brokerThread.join();
+		this->_httpThread.join();
+
+		for(auto session : this->_sessions) {
+			if(!session->closed)
+				session->client->close();
+
+			delete session;
+		}
+
+		this->_sessions.clear();
+		this->_broker.close();
+		this->_http.close();
+	}
+
+	void Gateway::accept(lwiot::UniquePointer<lwiot::TcpClient>& client)
+	{
+		auto session = new Session(lwiot::stl::move(client));
+		auto socket = static_cast<lwiot::SocketTcpClient*>(session->client.get());
+
+		socket->setOption(SOCKET_OPT_NODELAY, 1);
+		this->_sessions.pushback(session);
+
+		this->_loop.add(*socket, SOCKET_POLL_READ, [this, session](uint32_t events) {
+			this->receive(*session, events);
+		});
+	}
+
+	void Gateway::close(Session& session)
+	{
+		auto socket = static_cast<lwiot::SocketTcpClient*>(session.client.get());
+
+		this->_loop.remove(socket->handle());
+		socket->close();
+		session.closed = true;
+	}
+
+	void Gateway::receive(Session& session, uint32_t events)
+	{
+		if(session.closed)
+			return;
+
+		auto available = session.client->available();
+
+		if((events & SOCKET_POLL_ERROR) || available == 0) {
+			this->close(session);
+			return;
+		}
+
+		auto space = sizeof(session.buffer) - session.length;
+
+		if(space == 0) {
+			print_dbg("MQTT packet does not fit in the session buffer!\n");
+			this->close(session);
+			return;
+		}
+
+		auto rv = session.client->read(session.buffer + session.length, available < space ? available : space);
+
+		if(rv <= 0) {
+			this->close(session);
+			return;
+		}
+
+		session.length += rv;
+
+		size_t offset = 0;
+
+		while(!session.closed && offset < session.length) {
+			auto length = this->handle(session, session.buffer + offset, session.length - offset);
+
+			if(length == 0)
+				break;
+
+			offset += length;
+		}
+
+		if(session.closed)
+			return;
+
+		session.length -= offset;
+		memmove(session.buffer, session.buffer + offset, session.length);
+	}
+
+	size_t Gateway::handle(Session& session, const uint8_t *data, size_t length)
+	{
+		size_t remaining = 0;
+		size_t idx = 1;
+		int shift = 0;
+
+		do {
+			if(idx >= length || shift > 21)
+				return 0;
+
+			remaining |= static_cast<size_t>(data[idx] & 0x7F) << shift;
+			shift += 7;
+		} while(data[idx++] & 0x80);
+
+		auto total = idx + remaining;
+		auto payload = data + idx;
+
+		if(total > length)
+			return 0;
+
+		switch(data[0] & 0xF0) {
+		case 0x10: {
+			const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+
+			session.client->write(connack, sizeof(connack));
+			break;
+		}
+
+		case 0x80: {
+			if(remaining < 4)
+				break;
+
+			size_t tl = (payload[2] << 8) | payload[3];
+			const uint8_t suback[] = { 0x90, 0x03, payload[0], payload[1], 0x00 };
+
+			if(4 + tl <= remaining)
+				session.topic = lwiot::String(reinterpret_cast<const char *>(payload + 4), tl);
+
+			session.client->write(suback, sizeof(suback));
+			break;
+		}
+
+		case 0x30: {
+			if(remaining < 2)
+				break;
+
+			size_t tl = (payload[0] << 8) | payload[1];
+
+			if(data[0] & 0x06) {
+				if(remaining < 4 + tl)
+					break;
+
+				const uint8_t puback[] = { 0x40, 0x02, payload[2 + tl], payload[3 + tl] };
+				session.client->write(puback, sizeof(puback));
+			}
+
+			/* Reflect the message unchanged, if it was sent to the topic of the session. */
+			if(2 + tl <= remaining && session.topic.length() == tl &&
+			   memcmp(session.topic.c_str(), payload + 2, tl) == 0)
+				session.client->write(data, total);
+
+			break;
+		}
+
+		case 0xC0: {
+			const uint8_t pingresp[] = { 0xD0, 0x00 };
+
+			session.client->write(pingresp, sizeof(pingresp));
+			break;
+		}
+
+		case 0xE0:
+			this->close(session);
+			break;
+
+		default:
+			break;
+		}
+
+		return total;
+	}
+}
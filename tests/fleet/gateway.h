@@ -0,0 +1,81 @@
+/*
+ * Local gateway for the fleet runner.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/uniquepointer.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/network/eventloop.h>
+#include <lwiot/network/httpserver.h>
+#include <lwiot/network/sockettcpserver.h>
+#include <lwiot/stl/vector.h>
+
+#include "fleet.h"
+
+#ifndef CONFIG_FLEET_MQTT_BUFFER
+#define CONFIG_FLEET_MQTT_BUFFER 1024
+#endif
+
+namespace fleet
+{
+	/**
+	 * @brief Gateway that the fleet runs against when no remote one is given.
+	 *
+	 * MQTT connections are served by a single event loop thread. It is not a broker: every
+	 * PUBLISH is reflected to the connection that sent it, if that connection subscribed to the
+	 * topic, so the work per message does not depend on the size of the fleet. HTTP is served by
+	 * an HttpServer with a connection slot for every node.
+	 */
+	class Gateway {
+	public:
+		explicit Gateway(const Options& options);
+		virtual ~Gateway();
+
+		Gateway(const Gateway&) = delete;
+		Gateway& operator=(const Gateway&) = delete;
+
+		bool start();
+		void stop();
+
+	private:
+		struct Session {
+			explicit Session(lwiot::UniquePointer<lwiot::TcpClient>&& socket);
+
+			lwiot::UniquePointer<lwiot::TcpClient> client;
+			uint8_t buffer[CONFIG_FLEET_MQTT_BUFFER];
+			size_t length;
+			lwiot::String topic;
+			bool closed;
+		};
+
+		const Options& _options;
+		lwiot::SocketTcpServer _broker;
+		lwiot::HttpServer _http;
+		lwiot::EventLoop _loop;
+		lwiot::FunctionalThread _brokerThread;
+		lwiot::FunctionalThread _httpThread;
+		lwiot::AtomicBool _running;
+
+		/* Only the event loop thread touches the sessions while it runs. */
+		lwiot::stl::Vector<Session*> _sessions;
+
+		void accept(lwiot::UniquePointer<lwiot::TcpClient>& client);
+		void receive(Session& session, uint32_t events);
+		void close(Session& session);
+
+		/**
+		 * @brief Handle the first packet in the buffer of \p session.
+		 * @return The length of the packet, or 0 if it is incomplete.
+		 */
+		size_t handle(Session& session, const uint8_t *data, size_t length);
+	};
+}
@@ -0,0 +1,136 @@
+/*
+ * Hosted fleet load runner.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+
+#include <sys/resource.h>
+
+#include "fleet.h"
+
+#define MQTT_PORT 5590
+#define HTTP_PORT 5591
+#define FDS_PER_NODE 2
+#define SPARE_FDS 64
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [options]\n\n"
+			"  --mqtt <n>        MQTT nodes (default 100)\n"
+			"  --http <n>        HTTP nodes (default 100)\n"
+			"  --sites <n>       Simulated XBee coordinators (default 1)\n"
+			"  --xbee <n>        Remote XBee nodes per site (default 100)\n"
+			"  --duration <s>    Measurement time, after the ramp (default 10)\n"
+			"  --interval <ms>   Time between the samples of a node (default 1000)\n"
+			"  --ramp <ms>       Time over which the nodes are started (default 2000)\n"
+			"  --workers <n>     Executor worker threads (default 4)\n"
+			"  --gateway <ip>    Run against a remote gateway instead of a local one\n"
+			"  --mqtt-port <n>   MQTT port of the gateway (default %d)\n"
+			"  --http-port <n>   HTTP port of the gateway (default %d)\n", name, MQTT_PORT, HTTP_PORT);
+}
+
+static bool parse(int argc, char **argv, fleet::Options& options)
+{
+	for(int idx = 1; idx < argc; idx++) {
+		const char *arg = argv[idx];
+
+		if(idx + 1 >= argc)
+			return false;
+
+		const char *value = argv[++idx];
+
+		if(strcmp(arg, "--mqtt") == 0)
+			options.mqtt = strtoul(value, nullptr, 10);
+		else if(strcmp(arg, "--http") == 0)
+			options.http = strtoul(value, nullptr, 10);
+		else if(strcmp(arg, "--sites") == 0)
+			options.sites = strtoul(value, nullptr, 10);
+		else if(strcmp(arg, "--xbee") == 0)
+			options.xbee = strtoul(value, nullptr, 10);
+		else if(strcmp(arg, "--duration") == 0)
+			options.duration = atoi(value);
+		else if(strcmp(arg, "--interval") == 0)
+			options.interval = atoi(value);
+		else if(strcmp(arg, "--ramp") == 0)
+			options.ramp = atoi(value);
+		else if(strcmp(arg, "--workers") == 0)
+			options.workers = atoi(value);
+		else if(strcmp(arg, "--mqtt-port") == 0)
+			options.mqttPort = static_cast<uint16_t>(atoi(value));
+		else if(strcmp(arg, "--http-port") == 0)
+			options.httpPort = static_cast<uint16_t>(atoi(value));
+		else if(strcmp(arg, "--gateway") == 0) {
+			options.gateway = lwiot::IPAddress::fromString(value);
+			options.local = false;
+		} else {
+			return false;
+		}
+	}
+
+	return options.duration > 0 && options.interval > 0 && options.ramp >= 0 && options.workers > 0 &&
+	       (options.sites == 0 || options.xbee > 0);
+}
+
+/* Every node has a connection, and a local gateway holds the other end of it. */
+static bool reserve(const fleet::Options& options)
+{
+	struct rlimit limit;
+	rlim_t needed = (options.mqtt + options.http) * (options.local ? FDS_PER_NODE : 1) + SPARE_FDS;
+
+	if(getrlimit(RLIMIT_NOFILE, &limit) != 0)
+		return false;
+
+	if(limit.rlim_cur >= needed)
+		return true;
+
+	if(limit.rlim_max != RLIM_INFINITY && limit.rlim_max < needed) {
+		fprintf(stderr, "The fleet needs %lu file descriptors, but at most %lu are allowed.\n",
+				static_cast<unsigned long>(needed), static_cast<unsigned long>(limit.rlim_max));
+		return false;
+	}
+
+	limit.rlim_cur = needed;
+	return setrlimit(RLIMIT_NOFILE, &limit) == 0;
+}
+
+int main(int argc, char **argv)
+{
+	fleet::Options options;
+
+	options.mqtt = 100;
+	options.http = 100;
+	options.sites = 1;
+	options.xbee = 100;
+	options.duration = 10;
+	options.interval = 1000;
+	options.ramp = 2000;
+	options.workers = 4;
+	options.gateway = lwiot::IPAddress(127, 0, 0, 1);
+	options.local = true;
+	options.mqttPort = MQTT_PORT;
+	options.httpPort = HTTP_PORT;
+
+	if(!parse(argc, argv, options)) {
+		usage(argv[0]);
+		return -EXIT_FAILURE;
+	}
+
+	if(!reserve(options))
+		return -EXIT_FAILURE;
+
+	lwiot_init();
+
+	auto runner = new fleet::Fleet(options);
+	auto ok = runner->run() && runner->report(stdout);
+
+	delete runner;
+	lwiot_destroy();
+
+	return ok ? -EXIT_SUCCESS : -EXIT_FAILURE;
+}
@@ -0,0 +1,472 @@
+/*
+ * Virtual fleet nodes.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/kernel/clock.h>
+#include <lwiot/hosted/i2csimulator.h>
+
+#include "nodes.h"
+
+#define SENSOR_FREQUENCY 400000
+#define XBEE_PAYLOAD 16
+#define XBEE_POLL 100
+
+namespace fleet
+{
+	SimulatedSensor::SimulatedSensor(size_t id) : _model(),
+		_sim(new lwiot::hosted::I2CSimulator(SENSOR_FREQUENCY)), _bus(this->_sim), _sensor(this->_bus)
+	{
+		this->_sim->attach(this->_model);
+		this->_model.setTemperature(18.0 + static_cast<double>(id % 100) / 10.0);
+		this->_model.setHumidity(35.0 + static_cast<double>(id % 30));
+	}
+
+	bool SimulatedSensor::start()
+	{
+		return this->_sensor.startMeasurement();
+	}
+
+	time_t SimulatedSensor::remaining() const
+	{
+		return this->_sensor.remaining();
+	}
+
+	bool SimulatedSensor::collect()
+	{
+		return this->_sensor.collect();
+	}
+
+	float SimulatedSensor::temperature() const
+	{
+		return static_cast<float>(this->_sensor.temperature());
+	}
+
+	float SimulatedSensor::humidity() const
+	{
+		return static_cast<float>(this->_sensor.humidity());
+	}
+
+	size_t SimulatedSensor::format(char *output, size_t length, uint32_t seq) const
+	{
+		auto rv = snprintf(output, length, "%u,%.2f,%.2f", static_cast<unsigned>(seq),
+				static_cast<double>(this->temperature()), static_cast<double>(this->humidity()));
+
+		return rv < 0 ? 0 : static_cast<size_t>(rv);
+	}
+
+	Node::Node(Fleet& fleet, Kind kind, size_t id, int delay) : Coroutine(), _fleet(fleet),
+		_stats(fleet.statistics(kind)), _sensor(id), _id(id), _delay(delay), _seq(0), _next(0), _sent(0),
+		_online(false)
+	{
+	}
+
+	int Node::wait()
+	{
+		auto now = lwiot_tick_ms();
+		auto interval = this->_fleet.options().interval;
+
+		/* A node that fell behind skips the samples it missed, instead of sending a burst. */
+		if(this->_next + interval < now)
+			this->_next = now;
+
+		auto delay = this->_next > now ? this->_next - now : 0;
+
+		this->_next += interval;
+		return static_cast<int>(delay);
+	}
+
+	void Node::online()
+	{
+		if(this->_online)
+			return;
+
+		this->_online = true;
+		this->_stats.connects.fetch_add(1, lwiot::memory_order_relaxed);
+		this->_stats.connected.fetch_add(1, lwiot::memory_order_relaxed);
+	}
+
+	void Node::offline()
+	{
+		if(!this->_online)
+			return;
+
+		this->_online = false;
+		this->_stats.connected.fetch_sub(1, lwiot::memory_order_relaxed);
+	}
+
+	void Node::sent(size_t bytes)
+	{
+		this->_sent = lwiot::Clock::now();
+		this->_stats.sent.fetch_add(1, lwiot::memory_order_relaxed);
+		this->_stats.bytes.fetch_add(bytes, lwiot::memory_order_relaxed);
+	}
+
+	void Node::completed()
+	{
+		this->_stats.received.fetch_add(1, lwiot::memory_order_relaxed);
+		this->_stats.latency.record((lwiot::Clock::now() - this->_sent) / 1000ULL);
+	}
+
+	MqttNode::MqttNode(Fleet& fleet, size_t id, int delay) : Node(fleet, Kind::Mqtt, id, delay),
+		_length(0), _attached(false), _echoed(false)
+	{
+		char topic[24];
+
+		snprintf(topic, sizeof(topic), "fleet/%u", static_cast<unsigned>(id));
+		this->_topic = topic;
+
+		this->_client.setCallback([this](const lwiot::String& topic, const lwiot::SharedByteBuffer& payload) {
+			this->receive(payload);
+		});
+	}
+
+	lwiot::CoroutineState MqttNode::run()
+	{
+		LWIOT_CO_BEGIN();
+		LWIOT_CO_SLEEP(this->_delay);
+
+		while(this->_fleet.running()) {
+			if(!this->_online && !this->connect()) {
+				LWIOT_CO_SLEEP(CONFIG_FLEET_BACKOFF);
+				continue;
+			}
+
+			LWIOT_CO_SLEEP(this->wait());
+
+			if(!this->_sensor.start()) {
+				this->_stats.errors.fetch_add(1, lwiot::memory_order_relaxed);
+				continue;
+			}
+
+			LWIOT_CO_SLEEP(this->_sensor.remaining());
+
+			if(!this->publish())
+				continue;
+
+			while(!this->_echoed) {
+				LWIOT_CO_READABLE(this->_socket, 1, CONFIG_FLEET_TIMEOUT);
+
+				if(this->timedOut()) {
+					/* Start over on a new connection, so that a late echo is not taken for the next one. */
+					this->_stats.timeouts.fetch_add(1, lwiot::memory_order_relaxed);
+					this->_socket.close();
+					this->offline();
+					break;
+				}
+
+				if(!this->_client.loop()) {
+					this->_stats.errors.fetch_add(1, lwiot::memory_order_relaxed);
+					this->_socket.close();
+					this->offline();
+					break;
+				}
+			}
+		}
+
+		if(this->_online) {
+			this->_client.disconnect();
+			this->offline();
+		}
+
+		LWIOT_CO_END();
+	}
+
+	bool MqttNode::connect()
+	{
+		auto& options = this->_fleet.options();
+
+		if(!this->_socket.connect(options.gateway, options.mqttPort)) {
+			this->_stats.errors.fetch_add(1, lwiot::memory_order_relaxed);
+			return false;
+		}
+
+		/* The client applies its socket options on attach, which needs an open socket. */
+		if(!this->_attached) {
+			this->_client.begin(this->_socket);
+			this->_attached = true;
+		}
+
+		if(!this->_client.connect(this->_topic, "", "") ||
+		   !this->_client.subscribe(this->_topic, lwiot::MqttClient::QOS0)) {
+			this->_stats.errors.fetch_add(1, lwiot::memory_order_relaxed);
+			this->_socket.close();
+			return false;
+		}
+
+		this->online();
+		return true;
+	}
+
+	bool MqttNode::publish()
+	{
+		if(!this->_sensor.collect()) {
+			this->_stats.errors.fetch_add(1, lwiot::memory_order_relaxed);
+			return false;
+		}
+
+		this->_length = this->_sensor.format(this->_sample, sizeof(this->_sample), ++this->_seq);
+
+		lwiot::ByteBuffer payload(this->_length, true);
+
+		payload.write(this->_sample, this->_length);
+		this->_echoed = false;
+		this->sent(this->_length);
+
+		if(!this->_client.publish(this->_topic, payload, false)) {
+			this->_stats.errors.fetch_add(1, lwiot::memory_order_relaxed);
+			this->_socket.close();
+			this->offline();
+			return false;
+		}
+
+		return true;
+	}
+
+	void MqttNode::receive(const lwiot::SharedByteBuffer& payload)
+	{
+		if(payload.size() != this->_length || memcmp(payload.data(), this->_sample, this->_length) != 0)
+			return;
+
+		this->_echoed = true;
+		this->completed();
+	}
+
+	HttpNode::HttpNode(Fleet& fleet, size_t id, int delay) : Node(fleet, Kind::Http, id, delay), _length(0),
+		_status(0), _close(false)
+	{
+	}
+
+	lwiot::CoroutineState HttpNode::run()
+	{
+		LWIOT_CO_BEGIN();
+		LWIOT_CO_SLEEP(this->_delay);
+
+		while(this->_fleet.running()) {
+			if(!this->_online && !this->connect()) {
+				LWIOT_CO_SLEEP(CONFIG_FLEET_BACKOFF);
+				continue;
+			}
+
+			LWIOT_CO_SLEEP(this->wait());
+
+			if(!this->_sensor.start()) {
+				this->_stats.errors.fetch_add(1, lwiot::memory_order_relaxed);
+				continue;
+			}
+
+			LWIOT_CO_SLEEP(this->_sensor.remaining());
+
+			if(!this->post())
+				continue;
+
+			for(;;) {
+				LWIOT_CO_READABLE(this->_socket, 1, CONFIG_FLEET_TIMEOUT);
+
+				if(this->timedOut()) {
+					this->_stats.timeouts.fetch_add(1, lwiot::memory_order_relaxed);
+					this->_close = true;
+					break;
+				}
+
+				this->_status = this->receive();
+
+				if(this->_status < 0) {
+					this->_stats.errors.fetch_add(1, lwiot::memory_order_relaxed);
+					this->_close = true;
+					break;
+				}
+
+				if(this->_status > 0) {
+					this->completed();
+					break;
+				}
+			}
+
+			/* The server ends a connection after a number of requests; the node reconnects. */
+			if(this->_close) {
+				this->_socket.close();
+				this->offline();
+			}
+		}
+
+		if(this->_online) {
+			this->_socket.close();
+			this->offline();
+		}
+
+		LWIOT_CO_END();
+	}
+
+	bool HttpNode::connect()
+	{
+		auto& options = this->_fleet.options();
+
+		if(!this->_socket.connect(options.gateway, options.httpPort)) {
+			this->_stats.errors.fetch_add(1, lwiot::memory_order_relaxed);
+			return false;
+		}
+
+		this->_socket.setOption(SOCKET_OPT_NODELAY, 1);
+		this->_length = 0;
+		this->_close = false;
+		this->online();
+
+		return true;
+	}
+
+	bool HttpNode::post()
+	{
+		char sample[CONFIG_FLEET_SAMPLE_LENGTH];
+
+		if(!this->_sensor.collect()) {
+			this->_stats.errors.fetch_add(1, lwiot::memory_order_relaxed);
+			return false;
+		}
+
+		auto length = this->_sensor.format(sample, sizeof(sample), ++this->_seq);
+		auto rv = snprintf(this->_buffer, sizeof(this->_buffer),
+				"POST /fleet/%u HTTP/1.1\r\nHost: fleet\r\nContent-Type: text/plain\r\n"
+				"Content-Length: %u\r\n\r\n%s", static_cast<unsigned>(this->_id),
+				static_cast<unsigned>(length), sample);
+
+		this->_length = 0;
+		this->sent(length);
+
+		if(rv <= 0 || this->_socket.write(this->_buffer, rv) != rv) {
+			this->_stats.errors.fetch_add(1, lwiot::memory_order_relaxed);
+			this->_socket.close();
+			this->offline();
+			return false;
+		}
+
+		return true;
+	}
+
+	int HttpNode::receive()
+	{
+		auto space = sizeof(this->_buffer) - 1 - this->_length;
+		auto available = this->_socket.available();
+
+		if(available == 0 || space == 0)
+			return -1;
+
+		auto rv = this->_socket.read(this->_buffer + this->_length, available < space ? available : space);
+
+		if(rv <= 0)
+			return -1;
+
+		this->_length += rv;
+		this->_buffer[this->_length] = '\0';
+
+		auto end = strstr(this->_buffer, "\r\n\r\n");
+
+		if(end == nullptr)
+			return 0;
+
+		if(strncmp(this->_buffer, "HTTP/1.", 7) != 0 || this->_buffer[9] != '2')
+			return -1;
+
+		size_t content = 0;
+
+		for(auto line = strstr(this->_buffer, "\r\n") + 2; line < end; line = strstr(line, "\r\n") + 2) {
+			if(strncasecmp(line, "Content-Length:", 15) == 0)
+				content = strtoul(line + 15, nullptr, 10);
+			else if(strncasecmp(line, "Connection: close", 17) == 0)
+				this->_close = true;
+		}
+
+		auto total = static_cast<size_t>(end - this->_buffer) + 4 + content;
+
+		if(total >= sizeof(this->_buffer))
+			return -1;
+
+		if(this->_length < total)
+			return 0;
+
+		this->_length = 0;
+		return 1;
+	}
+
+	XBeeSite::XBeeSite(Fleet& fleet, int delay) : Coroutine(), _fleet(fleet), _delay(delay),
+		_sim(config(fleet.options())), _dispatcher(Handler { &fleet.statistics(Kind::XBee) })
+	{
+		this->_xbee.setSerial(this->_sim);
+	}
+
+	XBeeSite::~XBeeSite()
+	{
+		this->_sim.stop();
+	}
+
+	void XBeeSite::stop()
+	{
+		this->_sim.stop();
+	}
+
+	lwiot::hosted::XBeeSimulator::Statistics XBeeSite::statistics() const
+	{
+		return this->_sim.statistics();
+	}
+
+	lwiot::hosted::XBeeSimulator::Config XBeeSite::config(const Options& options)
+	{
+		lwiot::hosted::XBeeSimulator::Config config;
+
+		config.nodes = options.xbee;
+		config.rate = 1000.0 / options.interval;
+		config.payload = XBEE_PAYLOAD;
+		config.latency = CONFIG_FLEET_XBEE_LATENCY;
+		config.loss = 0.0;
+		config.throughput = 0;
+		config.echo = false;
+
+		return config;
+	}
+
+	void XBeeSite::Handler::operator()(lwiot::ZBRxResponse& rx)
+	{
+		uint64_t stamp;
+
+		if(rx.getDataLength() < sizeof(stamp))
+			return;
+
+		memcpy(&stamp, rx.getData(), sizeof(stamp));
+		this->stats->received.fetch_add(1, lwiot::memory_order_relaxed);
+		this->stats->bytes.fetch_add(rx.getDataLength(), lwiot::memory_order_relaxed);
+		this->stats->latency.record((lwiot::Clock::now() - stamp) / 1000ULL);
+	}
+
+	lwiot::CoroutineState XBeeSite::run()
+	{
+		LWIOT_CO_BEGIN();
+		LWIOT_CO_SLEEP(this->_delay);
+
+		this->_sim.start();
+
+		while(this->_fleet.running()) {
+			LWIOT_CO_READABLE(this->_sim, 1, XBEE_POLL);
+
+			while(this->_sim.available() > 0) {
+				this->_xbee.readPacket();
+
+				if(this->_xbee.getResponse().isAvailable())
+					this->_dispatcher.dispatch(this->_xbee.getResponse());
+				else if(this->_xbee.getResponse().isError())
+					this->_fleet.statistics(Kind::XBee).errors.fetch_add(1, lwiot::memory_order_relaxed);
+			}
+		}
+
+		this->_sim.stop();
+		LWIOT_CO_END();
+	}
+}
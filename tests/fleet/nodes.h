@@ -0,0 +1,177 @@
+/*
+ * Virtual fleet nodes.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+
+#include <lwiot/io/i2cbus.h>
+#include <lwiot/device/sht31sensor.h>
+#include <lwiot/hosted/i2cdevicemodels.h>
+#include <lwiot/hosted/xbeesimulator.h>
+#include <lwiot/kernel/coroutine.h>
+#include <lwiot/network/mqttclient.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/xbee/xbee.h>
+#include <lwiot/network/xbee/xbeedispatcher.h>
+
+#include "fleet.h"
+
+#ifndef CONFIG_FLEET_SAMPLE_LENGTH
+#define CONFIG_FLEET_SAMPLE_LENGTH 32
+#endif
+
+#ifndef CONFIG_FLEET_HTTP_BUFFER
+#define CONFIG_FLEET_HTTP_BUFFER 512
+#endif
+
+#ifndef CONFIG_FLEET_XBEE_LATENCY
+#define CONFIG_FLEET_XBEE_LATENCY 5
+#endif
+
+namespace fleet
+{
+	/**
+	 * @brief SHT31 on a simulated I2C bus of its own.
+	 */
+	class SimulatedSensor {
+	public:
+		explicit SimulatedSensor(size_t id);
+
+		bool start();
+		time_t remaining() const;
+		bool collect();
+
+		/**
+		 * @brief Write the last result as <tt>seq,temperature,humidity</tt>.
+		 * @return The length of the text.
+		 */
+		size_t format(char *output, size_t length, uint32_t seq) const;
+
+		float temperature() const;
+		float humidity() const;
+
+	private:
+		lwiot::hosted::Sht31Model _model;
+		lwiot::hosted::I2CSimulator *_sim; //!< Owned by _bus.
+		lwiot::I2CBus _bus;
+		lwiot::Sht31Sensor _sensor;
+	};
+
+	class Node : public lwiot::Coroutine {
+	public:
+		explicit Node(Fleet& fleet, Kind kind, size_t id, int delay);
+
+	protected:
+		Fleet& _fleet;
+		Statistics& _stats;
+		SimulatedSensor _sensor;
+		size_t _id;
+		int _delay;
+		uint32_t _seq;
+		time_t _next;
+		uint64_t _sent;
+		bool _online;
+
+		/**
+		 * @brief Milliseconds until the next sample is due.
+		 */
+		int wait();
+
+		void online();
+		void offline();
+		void sent(size_t bytes);
+		void completed();
+	};
+
+	/**
+	 * @brief Node that publishes its samples to its own topic and waits for the echo.
+	 */
+	class MqttNode : public Node {
+	public:
+		explicit MqttNode(Fleet& fleet, size_t id, int delay);
+
+	protected:
+		lwiot::CoroutineState run() override;
+
+	private:
+		lwiot::SocketTcpClient _socket;
+		lwiot::MqttClient _client;
+		lwiot::String _topic;
+		char _sample[CONFIG_FLEET_SAMPLE_LENGTH];
+		size_t _length;
+		bool _attached;
+		bool _echoed;
+
+		bool connect();
+		bool publish();
+		void receive(const lwiot::SharedByteBuffer& payload);
+	};
+
+	/**
+	 * @brief Node that posts its samples over a persistent HTTP/1.1 connection.
+	 */
+	class HttpNode : public Node {
+	public:
+		explicit HttpNode(Fleet& fleet, size_t id, int delay);
+
+	protected:
+		lwiot::CoroutineState run() override;
+
+	private:
+		lwiot::SocketTcpClient _socket;
+		char _buffer[CONFIG_FLEET_HTTP_BUFFER];
+		size_t _length;
+		int _status;
+		bool _close;
+
+		bool connect();
+		bool post();
+
+		/**
+		 * @brief Read the response.
+		 * @return 1 once a complete response was read, 0 if more data is needed, or -1 if the
+		 *         response failed.
+		 */
+		int receive();
+	};
+
+	/**
+	 * @brief Simulated XBee coordinator with a mesh of remote nodes.
+	 *
+	 * The mesh runs on the simulator thread; the coordinator reads its serial stream from a
+	 * coroutine, and hands RX frames to a compile-time dispatcher.
+	 */
+	class XBeeSite : public lwiot::Coroutine {
+	public:
+		explicit XBeeSite(Fleet& fleet, int delay);
+		~XBeeSite() override;
+
+		void stop();
+		lwiot::hosted::XBeeSimulator::Statistics statistics() const;
+
+	protected:
+		lwiot::CoroutineState run() override;
+
+	private:
+		struct Handler {
+			Statistics *stats;
+
+			void operator()(lwiot::ZBRxResponse& rx);
+		};
+
+		Fleet& _fleet;
+		int _delay;
+		lwiot::hosted::XBeeSimulator _sim;
+		lwiot::XBee _xbee;
+		lwiot::XBeeDispatcher<Handler, lwiot::ZBRxResponse> _dispatcher;
+
+		static lwiot::hosted::XBeeSimulator::Config config(const Options& options);
+	};
+}
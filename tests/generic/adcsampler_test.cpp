@@ -0,0 +1,166 @@
+/*
+ * ADC sampler unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/test.h>
+
+#include <lwiot/io/adcchip.h>
+#include <lwiot/io/adcsampler.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/kernel/functionalthread.h>
+
+class CountingAdc : public lwiot::AdcChip {
+public:
+	explicit CountingAdc() : AdcChip(4, 3300, 4096), counts{0, 0, 0, 0}
+	{
+	}
+
+	void begin() override
+	{
+	}
+
+	size_t read(int pin) const override
+	{
+		return static_cast<size_t>(pin * 1000 + this->counts[pin]++ % 1000);
+	}
+
+	mutable size_t counts[4];
+};
+
+class StreamingAdc : public CountingAdc {
+public:
+	explicit StreamingAdc() : _dma("adc-dma"), _running(false)
+	{
+	}
+
+	bool startContinuous(const int *pins, size_t num, uint32_t rate, lwiot::AdcSampler& sampler) override
+	{
+		UNUSED(rate);
+
+		this->_running = true;
+		this->_dma.start([this, pins, num, &sampler]() {
+			while(this->_running) {
+				for(size_t idx = 0; idx < num; idx++)
+					sampler.push(static_cast<uint16_t>(this->read(pins[idx])));
+
+				lwiot_udelay(200);
+			}
+		});
+
+		return true;
+	}
+
+	void stopContinuous() override
+	{
+		this->_running = false;
+		this->_dma.join();
+	}
+
+private:
+	lwiot::FunctionalThread _dma;
+	volatile bool _running;
+};
+
+static void check_blocks(const lwiot::stl::Vector<uint16_t>& samples)
+{
+	/* Frames are stored in pin order and every pin counts up without gaps. */
+	for(size_t idx = 0; idx < samples.size(); idx += 2) {
+		assert(samples[idx] / 1000 == 1);
+		assert(samples[idx + 1] / 1000 == 3);
+		assert(samples[idx] % 1000 == (idx / 2) % 1000);
+		assert(samples[idx + 1] % 1000 == (idx / 2) % 1000);
+	}
+}
+
+static void adcsampler_software_test()
+{
+	CountingAdc chip;
+	lwiot::AdcSampler sampler(chip);
+	lwiot::stl::Vector<int> pins;
+	lwiot::stl::Vector<uint16_t> samples;
+	uint16_t buffer[64];
+	volatile int blocks = 0;
+	auto ignore = [](const uint16_t *data, size_t length) {
+		UNUSED(data);
+		UNUSED(length);
+	};
+
+	pins.pushback(1);
+	pins.pushback(3);
+
+	assert(!sampler.begin(pins, 1000, buffer, sizeof(buffer) / sizeof(buffer[0]), 15, ignore));
+	assert(sampler.begin(pins, 2000, buffer, 64, 16, [&](const uint16_t *data, size_t length) {
+		assert(length == 16);
+
+		for(size_t idx = 0; idx < length; idx++)
+			samples.pushback(data[idx]);
+
+		blocks = blocks + 1;
+	}));
+
+	assert(!sampler.begin(pins, 2000, buffer, 64, 16, ignore));
+
+	/* 8 frames per block at 2 kHz: 25 blocks take 100 ms. */
+	for(int idx = 0; idx < 100 && blocks < 25; idx++)
+		lwiot_sleep(10);
+
+	sampler.end();
+
+	assert(blocks >= 25);
+	assert(samples.size() == static_cast<size_t>(blocks) * 16);
+	check_blocks(samples);
+
+	print_dbg("Software sampling test done! Overruns: %u\n", static_cast<unsigned>(sampler.overruns()));
+}
+
+static void adcsampler_stream_test()
+{
+	StreamingAdc chip;
+	lwiot::AdcSampler sampler(chip);
+	lwiot::stl::Vector<int> pins;
+	lwiot::stl::Vector<uint16_t> samples;
+	uint16_t buffer[128];
+	volatile int blocks = 0;
+
+	pins.pushback(1);
+	pins.pushback(3);
+
+	assert(sampler.begin(pins, 5000, buffer, 128, 32, [&](const uint16_t *data, size_t length) {
+		for(size_t idx = 0; idx < length; idx++)
+			samples.pushback(data[idx]);
+
+		blocks = blocks + 1;
+	}));
+
+	for(int idx = 0; idx < 200 && blocks < 20; idx++)
+		lwiot_sleep(10);
+
+	sampler.end();
+
+	assert(blocks >= 20);
+	assert(sampler.overruns() == 0);
+	check_blocks(samples);
+
+	print_dbg("Streaming sampling test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	adcsampler_software_test();
+	adcsampler_stream_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+/*
+ * Arena allocator unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/linkedlist.h>
+#include <lwiot/util/arenaallocator.h>
+#include <lwiot/util/json.h>
+
+static int destroyed = 0;
+
+struct Tracker {
+	~Tracker()
+	{
+		destroyed++;
+	}
+
+	lwiot::stl::String value;
+};
+
+static void test_arena()
+{
+	lwiot::Arena arena(64);
+
+	for(int idx = 0; idx < 16; idx++) {
+		auto data = arena.allocate(24, 8);
+		assert(data);
+		assert((reinterpret_cast<uintptr_t>(data) & 0x7) == 0);
+	}
+
+	assert(arena.used() >= 16 * 24);
+	auto trackers = arena.create<Tracker>(3);
+	trackers[1].value = "Hello, World";
+
+	arena.reset();
+	assert(destroyed == 3);
+	assert(arena.used() == 0);
+
+	for(int idx = 0; idx < 16; idx++)
+		arena.allocate(24, 8);
+
+	/* The arena should have grown a single block for the peak usage */
+	assert(arena.capacity() >= 16 * 24);
+	arena.reset();
+	assert(arena.capacity() >= 16 * 24);
+
+	print_dbg("Arena test done!\n");
+}
+
+static void test_external()
+{
+	uint8_t buffer[128];
+	lwiot::Arena arena(buffer, sizeof(buffer));
+	lwiot::ArenaAllocator<int> alloc(arena);
+	lwiot::stl::LinkedList<int, lwiot::ArenaAllocator<int>> list(alloc);
+
+	for(int idx = 0; idx < 32; idx++)
+		list.push_back(idx);
+
+	assert(list.size() == 32);
+	assert(list.back() == 31);
+	list.clear();
+
+	arena.reset();
+	assert(arena.used() == 0);
+	assert(arena.allocate(8) >= static_cast<void*>(buffer));
+
+	print_dbg("External buffer test done!\n");
+}
+
+static void test_json()
+{
+	lwiot::Arena arena;
+	lwiot::ArenaJsonBuffer jbuffer(arena);
+	char json[] = "{\"sensor\":\"gps\",\"time\":1351824120,\"data\":[48.756080,2.302038]}";
+
+	lwiot::JsonObject& root = jbuffer.parseObject(json);
+	const char *sensor = root["sensor"];
+	long time = root["time"];
+
+	assert(lwiot::stl::String(sensor) == "gps");
+	assert(time == 1351824120);
+	assert(arena.used() > 0);
+
+	arena.reset();
+	print_dbg("JSON test done!\n");
+}
+
+int main(int argc, char**argv)
+{
+	lwiot_init();
+
+	UNUSED(argc);
+	UNUSED(argv);
+
+	test_arena();
+	test_external();
+	test_json();
+
+	lwiot_destroy();
+	wait_close();
+	return -EXIT_SUCCESS;
+}
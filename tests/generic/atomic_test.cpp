@@ -0,0 +1,103 @@
+/*
+ * Atomic unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/test.h>
+
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+
+static void atomic_integral_test()
+{
+	lwiot::atomic_uint32_t value(5);
+	uint32_t expected = 4;
+
+	assert(value.is_lock_free());
+	assert(!value.compare_exchange_strong(expected, 10));
+	assert(expected == 5);
+	assert(value.compare_exchange_strong(expected, 10, lwiot::memory_order_acq_rel));
+	assert(value.load(lwiot::memory_order_acquire) == 10);
+
+	while(!value.compare_exchange_weak(expected, 12))
+		;
+
+	assert(value.exchange(0x0F) == 12);
+	assert(value.fetch_or(0xF0) == 0x0F);
+	assert(value.fetch_and(0x3C) == 0xFF);
+	assert(value.fetch_xor(0xFF) == 0x3C);
+	assert(value.load() == 0xC3);
+
+	assert(++value == 0xC4);
+	assert(--value == 0xC3);
+	assert(value.fetch_sub(3, lwiot::memory_order_relaxed) == 0xC3);
+	assert(value.load(lwiot::memory_order_relaxed) == 0xC0);
+
+	lwiot::atomic_uint64_t wide(1ULL << 40);
+	assert(wide.fetch_add(1) == 1ULL << 40);
+	assert(wide.load() == (1ULL << 40) + 1);
+
+	print_dbg("Integral test passed!\n");
+}
+
+static void atomic_pointer_test()
+{
+	uint32_t array[4];
+	lwiot::Atomic<uint32_t*> ptr(array);
+	uint32_t *expected = array;
+
+	assert(ptr.fetch_add(2) == array);
+	assert(ptr.load() == &array[2]);
+	assert(ptr.fetch_sub(1) == &array[2]);
+	assert(!ptr.compare_exchange_strong(expected, &array[3]));
+	assert(expected == &array[1]);
+	assert(ptr.compare_exchange_strong(expected, &array[3]));
+	assert(ptr.exchange(nullptr) == &array[3]);
+	assert(ptr.load() == nullptr);
+
+	print_dbg("Pointer test passed!\n");
+}
+
+static void atomic_thread_test()
+{
+	lwiot::atomic_long_t counter(0);
+	lwiot::FunctionalThread t1("atomic-1"), t2("atomic-2");
+
+	auto worker = [&]() {
+		for(int idx = 0; idx < 100000; idx++) {
+			long current = counter.load(lwiot::memory_order_relaxed);
+
+			while(!counter.compare_exchange_weak(current, current + 1, lwiot::memory_order_relaxed))
+				;
+		}
+	};
+
+	t1.start(worker);
+	t2.start(worker);
+	t1.join();
+	t2.join();
+
+	assert(counter.load() == 200000);
+	print_dbg("Thread test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	atomic_integral_test();
+	atomic_pointer_test();
+	atomic_thread_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+/*
+ * Buffer chain unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/bytebuffer.h>
+#include <lwiot/bufferchain.h>
+
+static void bufferchain_append_test()
+{
+	const char header[] = "head";
+	const char payload[] = "payload";
+	lwiot::ByteBuffer buffer(8);
+	lwiot::BufferChain chain;
+
+	buffer.write("tail", 4);
+
+	assert(chain.empty());
+	chain.append(header, 4).append(payload, 7).append(buffer);
+	chain.append(nullptr, 0);
+
+	assert(chain.segments() == 3);
+	assert(chain.length() == 15);
+	assert(chain[0].buffer() == header);
+	assert(chain[1].buffer() == payload);
+	assert(chain[2].buffer() == buffer.data());
+
+	size_t total = 0;
+
+	for(const auto& segment : chain)
+		total += segment.size();
+
+	assert(total == chain.length());
+
+	chain.clear();
+	assert(chain.empty());
+	assert(chain.segments() == 0);
+}
+
+static void bufferchain_copy_test()
+{
+	lwiot::BufferChain chain(2);
+	char output[16];
+
+	for(int idx = 0; idx < 6; idx++)
+		chain.append("ab", 2);
+
+	assert(chain.segments() == 6);
+
+	memset(output, 0, sizeof(output));
+	assert(chain.copyTo(output, sizeof(output)) == 12);
+	assert(strcmp(output, "abababababab") == 0);
+
+	memset(output, 0, sizeof(output));
+	assert(chain.copyTo(output, 5) == 5);
+	assert(strcmp(output, "ababa") == 0);
+
+	print_dbg("Buffer chain copy test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	bufferchain_append_test();
+	bufferchain_copy_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
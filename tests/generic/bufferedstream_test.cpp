@@ -6,6 +6,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <lwiot.h>
 #include <assert.h>
 
@@ -13,6 +14,67 @@
 #include <lwiot/bufferedstream.h>
 #include <lwiot/test.h>
 
+static void circular_test()
+{
+	lwiot::BufferedStream bs(8, lwiot::BufferedStream::Circular);
+	char output[8];
+
+	assert(bs.mode() == lwiot::BufferedStream::Circular);
+	assert(bs.write("abcdef", 6) == 6);
+	assert(bs.available() == 6);
+
+	memset(output, 0, sizeof(output));
+	assert(bs.read(output, 4) == 4);
+	assert(memcmp(output, "abcd", 4) == 0);
+
+	/* Wraps around the end of the buffer; only 6 bytes fit. */
+	assert(bs.write("ghijklmn", 8) == 6);
+	assert(bs.full());
+	assert(bs.size() == 8);
+	assert(!bs.write('x'));
+
+	auto span = bs.readableSpan();
+	assert(span.size() == 4);
+	assert(memcmp(span.buffer(), "efgh", 4) == 0);
+	assert(bs.toString() == "efghijkl");
+
+	bs.commitRead(span.size());
+	span = bs.readableSpan();
+	assert(span.size() == 4);
+	assert(memcmp(span.buffer(), "ijkl", 4) == 0);
+
+	auto free = bs.writableSpan();
+	assert(free.size() == 4);
+	memcpy(free.buffer(), "mnop", 4);
+	bs.commitWrite(4);
+
+	assert(bs.full());
+	assert(bs.read(output, sizeof(output)) == 8);
+	assert(memcmp(output, "ijklmnop", 8) == 0);
+	assert(bs.available() == 0);
+	assert(bs.writableSpan().size() == 8);
+}
+
+static void span_test()
+{
+	lwiot::BufferedStream bs(4);
+	char output[8];
+
+	auto free = bs.writableSpan();
+	assert(free.size() == 4);
+	memcpy(free.buffer(), "ab", 2);
+	bs.commitWrite(2);
+
+	bs << "cd";
+	assert(bs.writableSpan().size() > 0);
+	assert(bs.available() == 4);
+
+	assert(bs.read(output, 3) == 3);
+	assert(memcmp(output, "abc", 3) == 0);
+	assert(bs.readableSpan().size() == 1);
+	assert(bs.read() == 'd');
+}
+
 int main(int argc, char **argv)
 {
 	UNUSED(argc);
@@ -35,6 +97,9 @@ int main(int argc, char **argv)
 	}
 	printf("\n");
 
+	circular_test();
+	span_test();
+
 	lwiot_destroy();
 
 	wait_close();
@@ -0,0 +1,150 @@
+/*
+ * Buffered UART unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/test.h>
+#include <lwiot/error.h>
+
+#include <lwiot/io/buffereduart.h>
+#include <lwiot/kernel/event.h>
+#include <lwiot/kernel/functionalthread.h>
+
+/*
+ * Loopback port: a "hardware" thread moves bytes from the TX ring to the RX ring in FIFO sized
+ * chunks, at roughly 230400 baud, and reports an idle line when the transmitter runs dry.
+ */
+class LoopbackUart : public lwiot::BufferedUart {
+public:
+	explicit LoopbackUart(size_t rx, size_t tx) : BufferedUart(1, 3, 230400, SERIAL_8N1, rx, tx),
+		starts(0), _irq(lwiot::EventType::Counting, 1), _hw("uart-hw"), _running(true)
+	{
+		this->_hw.start([this]() {
+			uint8_t fifo[16];
+
+			while(this->_running) {
+				this->_irq.wait(20);
+
+				while(true) {
+					auto num = this->transmit(fifo, sizeof(fifo));
+
+					if(num == 0)
+						break;
+
+					lwiot_udelay(num * 40);
+					this->received(fifo, num);
+				}
+
+				this->idle();
+			}
+		});
+	}
+
+	~LoopbackUart() override
+	{
+		this->_running = false;
+		this->_irq.signal();
+		this->_hw.join();
+	}
+
+	int starts;
+
+protected:
+	void startTransmit() override
+	{
+		this->starts++;
+		this->_irq.signal();
+	}
+
+private:
+	lwiot::Event _irq;
+	lwiot::FunctionalThread _hw;
+	volatile bool _running;
+};
+
+static void buffereduart_loopback_test()
+{
+	LoopbackUart uart(1024, 256);
+	uint8_t tx[600], rx[600];
+	time_t start;
+
+	for(size_t idx = 0; idx < sizeof(tx); idx++)
+		tx[idx] = static_cast<uint8_t>(idx * 7);
+
+	/* Fits in the TX ring: returns without waiting for the wire. */
+	start = lwiot_tick_ms();
+	assert(uart.write(tx, 200) == 200);
+	assert(lwiot_tick_ms() - start < 5);
+
+	/* Larger than the TX ring: blocks until the rest fits. */
+	assert(uart.write(tx + 200, 400) == 400);
+	assert(uart.flush(1000));
+
+	assert(uart.read(rx, sizeof(rx), 1000) == sizeof(rx));
+	assert(memcmp(tx, rx, sizeof(tx)) == 0);
+	assert(uart.overruns() == 0);
+
+	assert(uart.read(rx, 1, 50) == -ETMO);
+	assert(uart.readFrame(rx, sizeof(rx), 50) == -ETMO);
+
+	print_dbg("Loopback test done! Transmitter starts: %i\n", uart.starts);
+}
+
+static void buffereduart_frame_test()
+{
+	LoopbackUart uart(256, 256);
+	uint8_t rx[64];
+
+	uart.write("hello", 5);
+	assert(uart.flush(1000));
+	lwiot_sleep(50);
+	uart.write("world!", 6);
+
+	assert(uart.readFrame(rx, sizeof(rx), 1000) == 5);
+	assert(memcmp(rx, "hello", 5) == 0);
+
+	assert(uart.readFrame(rx, 4, 1000) == 4);
+	assert(uart.readFrame(rx + 4, sizeof(rx), 1000) == 2);
+	assert(memcmp(rx, "world!", 6) == 0);
+
+	print_dbg("Frame test done!\n");
+}
+
+static void buffereduart_overrun_test()
+{
+	LoopbackUart uart(64, 256);
+	uint8_t tx[200];
+	uint8_t rx[200];
+
+	memset(tx, 0x55, sizeof(tx));
+	uart.write(tx, sizeof(tx));
+	assert(uart.flush(1000));
+
+	assert(uart.available() == 64);
+	assert(uart.overruns() == sizeof(tx) - 64);
+	assert(uart.read(rx, sizeof(rx), 20) == 64);
+
+	print_dbg("Overrun test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	buffereduart_loopback_test();
+	buffereduart_frame_test();
+	buffereduart_overrun_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -6,6 +6,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <lwiot.h>
 
@@ -40,11 +41,40 @@ private:
 	int _x;
 };
 
+static void append_test()
+{
+	const uint8_t data[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+	lwiot::ByteBuffer buffer(4, true);
+
+	buffer.writeUnchecked(0);
+	buffer.writeUnchecked(data, 3);
+	assert(buffer.index() == 4);
+
+	buffer.append(data, sizeof(data));
+	assert(buffer.index() == 14);
+	assert(buffer.count() == 14);
+	assert(memcmp(buffer.data() + 4, data, sizeof(data)) == 0);
+
+	buffer.reserveExact(20);
+	assert(buffer.count() == 20);
+	buffer.reserveExact(8);
+	assert(buffer.count() == 20);
+	assert(buffer[13] == 10);
+
+	lwiot::ByteBuffer moved(lwiot::stl::move(buffer));
+	buffer.append(data, 2);
+	assert(buffer.index() == 2);
+	assert(buffer[1] == 2);
+	assert(moved.index() == 14);
+}
+
 int main(int argc, char **argv)
 {
 	TestBuffer bf(5);
 
 	lwiot_init();
+	append_test();
+
 	for(int i = 65; i < 75; i++)
 		bf.write((uint8_t)i);
 
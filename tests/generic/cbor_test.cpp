@@ -0,0 +1,187 @@
+/*
+ * CBOR unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/util/cbor.h>
+#include <lwiot/util/json.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/test.h>
+
+template <typename T>
+static void check(const T& value, const uint8_t *expected, size_t length)
+{
+	lwiot::ByteBuffer buffer(1);
+	lwiot::CborWriter writer(buffer);
+
+	writer.write(value);
+	assert(buffer.index() == length);
+	assert(memcmp(buffer.data(), expected, length) == 0);
+}
+
+#define CHECK(value, ...) do { \
+	const uint8_t expected[] = { __VA_ARGS__ }; \
+	check(value, expected, sizeof(expected)); \
+} while(0)
+
+/* Test vectors from appendix A of RFC 7049. */
+static void test_writer()
+{
+	CHECK(0, 0x00);
+	CHECK(23, 0x17);
+	CHECK(24, 0x18, 0x18);
+	CHECK(100, 0x18, 0x64);
+	CHECK(1000, 0x19, 0x03, 0xE8);
+	CHECK(1000000, 0x1A, 0x00, 0x0F, 0x42, 0x40);
+	CHECK(1000000000000LL, 0x1B, 0x00, 0x00, 0x00, 0xE8, 0xD4, 0xA5, 0x10, 0x00);
+	CHECK(18446744073709551615ULL, 0x1B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF);
+	CHECK(-1, 0x20);
+	CHECK(-100, 0x38, 0x63);
+	CHECK(-1000, 0x39, 0x03, 0xE7);
+	CHECK(1.1, 0xFB, 0x3F, 0xF1, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9A);
+	CHECK(100000.0, 0xFA, 0x47, 0xC3, 0x50, 0x00);
+	CHECK(1.5f, 0xFA, 0x3F, 0xC0, 0x00, 0x00);
+	CHECK(false, 0xF4);
+	CHECK(true, 0xF5);
+	CHECK("", 0x60);
+	CHECK("IETF", 0x64, 'I', 'E', 'T', 'F');
+	CHECK(lwiot::String("a"), 0x61, 'a');
+
+	/* {"a": 1, "b": [2, 3]} and [_ 1, [2, 3]] */
+	const uint8_t map[] = { 0xA2, 0x61, 'a', 0x01, 0x61, 'b', 0x82, 0x02, 0x03 };
+	const uint8_t indefinite[] = { 0x9F, 0x01, 0x82, 0x02, 0x03, 0xFF };
+	const uint8_t bytes[] = { 0x44, 0x01, 0x02, 0x03, 0x04, 0xF6 };
+	lwiot::ByteBuffer buffer(4);
+	lwiot::CborWriter writer(buffer);
+
+	writer.beginMap(2).member("a", 1);
+	writer.write("b").beginArray(2).write(2).write(3);
+	assert(buffer.index() == sizeof(map) && memcmp(buffer.data(), map, sizeof(map)) == 0);
+
+	buffer.setIndex(0);
+	writer.beginArray().write(1).beginArray(2).write(2).write(3).end();
+	assert(buffer.index() == sizeof(indefinite) && memcmp(buffer.data(), indefinite, sizeof(indefinite)) == 0);
+
+	buffer.setIndex(0);
+	writer.writeBytes(bytes + 1, 4).writeNull();
+	assert(buffer.index() == sizeof(bytes) && memcmp(buffer.data(), bytes, sizeof(bytes)) == 0);
+}
+
+static void test_reader()
+{
+	const uint8_t data[] = {
+		0xA3, 0x61, 'a', 0x39, 0x03, 0xE7,
+		0x61, 'b', 0x9F, 0xF9, 0x3C, 0x00, 0xF9, 0xC4, 0x00, 0xF9, 0x7B, 0xFF, 0xFF,
+		0x61, 'c', 0xC1, 0x1A, 0x51, 0x4B, 0x67, 0xB0
+	};
+	lwiot::CborReader reader(data, sizeof(data));
+	lwiot::CborReader::Item item;
+
+	assert(reader.next(item) && item.type == lwiot::CborReader::Type::Map && item.value == 3);
+	assert(reader.next(item) && item.type == lwiot::CborReader::Type::Text && item.text() == "a");
+	assert(reader.next(item) && item.integer() == -1000);
+
+	assert(reader.next(item) && item.text() == "b");
+	assert(reader.next(item) && item.type == lwiot::CborReader::Type::Array && item.indefinite);
+	assert(reader.next(item) && item.type == lwiot::CborReader::Type::Float && item.number == 1.0);
+	assert(reader.next(item) && item.number == -4.0);
+	assert(reader.next(item) && item.number == 65504.0);
+	assert(reader.next(item) && item.type == lwiot::CborReader::Type::Break);
+
+	assert(reader.next(item) && item.text() == "c");
+	assert(reader.next(item) && item.type == lwiot::CborReader::Type::Tag && item.value == 1);
+	assert(reader.next(item) && item.integer() == 1363896240);
+	assert(reader.done() && !reader.next(item));
+
+	/* Skip a nested value at once. */
+	lwiot::CborReader skipper(data, sizeof(data));
+
+	assert(skipper.next(item) && skipper.skip(item) && skipper.done());
+
+	/* Truncated input. */
+	lwiot::CborReader truncated(data, 5);
+
+	assert(truncated.next(item) && !truncated.skip(item));
+
+	const uint8_t length[] = { 0x65, 'a', 'b' };
+	lwiot::CborReader invalid(length, sizeof(length));
+
+	assert(!invalid.next(item));
+}
+
+static void test_json()
+{
+	const char json[] = "{\"sensor\":\"gps\",\"time\":1351824120,\"valid\":true,\"error\":null,"
+	                    "\"data\":[48.75608,2.302038,-12],\"meta\":{}}";
+	lwiot::DynamicJsonBuffer jbuffer;
+	lwiot::ByteBuffer cbor(1);
+	char text[128];
+
+	auto& root = jbuffer.parseObject(json);
+
+	assert(root.success());
+	lwiot::serializeCbor(root, cbor);
+	assert(cbor.index() < strlen(json));
+	print_dbg("JSON: %u bytes, CBOR: %u bytes\n", (unsigned)strlen(json), (unsigned)cbor.index());
+
+	lwiot::DynamicJsonBuffer decoded;
+	lwiot::JsonVariant result;
+
+	assert(lwiot::parseCbor(decoded, cbor.data(), cbor.index(), result));
+	assert(result.is<lwiot::JsonObject&>());
+
+	auto& object = result.as<lwiot::JsonObject&>();
+
+	assert(strcmp(object["sensor"].as<const char *>(), "gps") == 0);
+	assert(object["time"].as<long>() == 1351824120);
+	assert(object["valid"].as<bool>());
+	assert(object["error"].as<const char *>() == nullptr);
+	assert(object["data"][0].as<double>() > 48.7560 && object["data"][0].as<double>() < 48.7561);
+	assert(object["data"][2].as<long>() == -12);
+	assert(object["meta"].as<lwiot::JsonObject&>().size() == 0);
+
+	object["meta"].as<lwiot::JsonObject&>().printTo(text, sizeof(text));
+	assert(strcmp(text, "{}") == 0);
+
+	/* The decoded document survives the CBOR data. */
+	memset(cbor.data(), 0, cbor.index());
+	assert(strcmp(object["sensor"].as<const char *>(), "gps") == 0);
+
+	/* Trailing data, non-string keys and runaway nesting are rejected. */
+	const uint8_t trailing[] = { 0x01, 0x02 };
+	const uint8_t key[] = { 0xA1, 0x01, 0x02 };
+	uint8_t deep[CONFIG_CBOR_NESTING + 2];
+
+	memset(deep, 0x81, sizeof(deep));
+	deep[sizeof(deep) - 1] = 0x00;
+
+	assert(!lwiot::parseCbor(decoded, trailing, sizeof(trailing), result));
+	assert(!lwiot::parseCbor(decoded, key, sizeof(key), result));
+	assert(!lwiot::parseCbor(decoded, deep, sizeof(deep), result));
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	test_writer();
+	test_reader();
+	test_json();
+
+	print_dbg("CBOR test passed!\n");
+
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,209 @@
+/*
+ * Clock and stopwatch unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/kernel/clock.h>
+#include <lwiot/kernel/deadlinetimer.h>
+#include <lwiot/util/stopwatch.h>
+#include <lwiot/cachedclock.h>
+
+/* RTC that counts whole seconds from an epoch, and the bus transfers it would cost. */
+class FakeRealTimeClock : public lwiot::RealTimeClock {
+public:
+	explicit FakeRealTimeClock(time_t epoch) : reads(0), writes(0), _epoch(epoch), _start(lwiot_tick_ms())
+	{
+	}
+
+	lwiot::DateTime now() override
+	{
+		this->reads++;
+		return lwiot::DateTime(this->_epoch + (lwiot_tick_ms() - this->_start) / 1000);
+	}
+
+	void set(const lwiot::DateTime& dt) override
+	{
+		this->writes++;
+		this->_epoch = dt.timestamp();
+		this->_start = lwiot_tick_ms();
+	}
+
+	int reads;
+	int writes;
+
+private:
+	time_t _epoch;
+	time_t _start;
+};
+
+static void clock_test()
+{
+	auto start = lwiot::Clock::now();
+	auto previous = start;
+
+	for(int idx = 0; idx < 1000; idx++) {
+		auto now = lwiot::Clock::now();
+
+		assert(now >= previous);
+		previous = now;
+	}
+
+	lwiot_sleep(20);
+	assert(lwiot::Clock::now() - start >= 19 * 1000000ULL);
+	assert(lwiot::Clock::nowMs() - start / 1000000ULL >= 19);
+
+	print_dbg("Clock test passed!\n");
+}
+
+static void stopwatch_test()
+{
+	lwiot::Stopwatch watch;
+
+	assert(!watch.isRunning());
+	assert(watch.elapsed() == 0);
+
+	watch.start();
+	lwiot_sleep(20);
+	watch.stop();
+
+	auto first = watch.elapsed();
+	assert(first >= 19 * 1000000ULL);
+
+	/* A stopped watch does not advance. */
+	lwiot_sleep(20);
+	assert(watch.elapsed() == first);
+
+	watch.start();
+	lwiot_sleep(20);
+	assert(watch.isRunning());
+	assert(watch.elapsedMs() >= 38);
+	watch.stop();
+
+	watch.restart();
+	assert(watch.isRunning());
+	assert(watch.elapsedMs() < first / 1000000ULL);
+
+	watch.reset();
+	assert(watch.elapsed() == 0);
+
+	print_dbg("Stopwatch test passed!\n");
+}
+
+static void delay_test()
+{
+	lwiot::Stopwatch watch;
+	uint64_t best = UINT64_MAX;
+
+	for(int idx = 0; idx < 10; idx++) {
+		watch.restart();
+		lwiot_ndelay(50 * 1000);
+		watch.stop();
+
+		assert(watch.elapsed() >= 50 * 1000);
+
+		if(watch.elapsed() < best)
+			best = watch.elapsed();
+	}
+
+	/* The best case must be close to the requested delay. */
+	assert(best < 100 * 1000);
+
+	watch.restart();
+	lwiot_udelay(200);
+	assert(watch.elapsedUs() >= 200);
+
+	print_dbg("Delay test passed!\n");
+}
+
+static void deadline_test()
+{
+	lwiot::DeadlineTimer timer;
+	lwiot::Stopwatch watch(true);
+
+	timer.expiresAfter(100 * 1000);
+	assert(!timer.expired());
+
+	/* Consecutive slots are relative to the previous deadline, not to the end of the wait. */
+	for(int idx = 0; idx < 5; idx++) {
+		timer.wait();
+		assert(timer.expired());
+		timer.extend(100 * 1000);
+	}
+
+	watch.stop();
+	assert(watch.elapsedUs() >= 500);
+
+	print_dbg("Deadline timer test passed!\n");
+}
+
+static void cached_clock_test()
+{
+	FakeRealTimeClock rtc(1600000000);
+	lwiot::CachedClock clock(rtc, 100);
+	time_t previous = 0;
+
+	auto now = clock.now();
+	assert(now.timestamp() == 1600000000);
+	assert(rtc.reads == 1);
+
+	/* Served from memory until the resync interval has passed. */
+	for(int idx = 0; idx < 1000; idx++) {
+		auto ms = clock.milliseconds();
+
+		assert(ms >= previous);
+		assert(ms / 1000 >= 1600000000 && ms / 1000 <= 1600000001);
+		previous = ms;
+	}
+
+	assert(rtc.reads == 1);
+
+	lwiot_sleep(120);
+	clock.now();
+	assert(rtc.reads == 2);
+
+	clock.invalidate();
+	clock.now();
+	assert(rtc.reads == 3);
+
+	/* A reference that is far off steps the clock and is written to the RTC. */
+	clock.sync(1700000000);
+	assert(rtc.writes == 1);
+	assert(clock.now().timestamp() == 1700000000);
+
+	/* Small corrections back do not make the clock run backwards. */
+	previous = clock.milliseconds();
+	clock.sync(1700000000);
+	assert(clock.milliseconds() >= previous);
+
+	clock.set(lwiot::DateTime(1500000000));
+	assert(clock.now().timestamp() == 1500000000);
+	assert(clock.drift() >= -CONFIG_CLOCK_MAX_DRIFT && clock.drift() <= CONFIG_CLOCK_MAX_DRIFT);
+
+	print_dbg("Cached clock test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	clock_test();
+	stopwatch_test();
+	delay_test();
+	deadline_test();
+	cached_clock_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,209 @@
+/*
+ * Compressed stream unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/bufferedstream.h>
+#include <lwiot/compression.h>
+#include <lwiot/compressedstream.h>
+#include <lwiot/stl/vector.h>
+
+#ifdef NDEBUG
+#error "Debugging not enabled.."
+#endif
+
+using namespace lwiot;
+
+#define INPUT_SIZE 20000
+
+static const char reference_text[] =
+	"lwIoT streams compress HTTP responses, log uploads and store-and-forward segments. "
+	"lwIoT streams compress HTTP responses, log uploads and store-and-forward segments. "
+	"lwIoT streams compress HTTP responses, log uploads and store-and-forward segments. "
+	"The quick brown fox jumps over the lazy dog 0123456789.\n";
+
+/* Created by gzip -9, with a file name and dynamic Huffman codes. */
+static const uint8_t reference_gzip[] = {
+	0x1f, 0x8b, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff, 0x6c, 0x6f, 0x67, 0x2e, 0x74, 0x78,
+	0x74, 0x00, 0xd5, 0x8c, 0xc9, 0x11, 0xc2, 0x30, 0x10, 0x04, 0xff, 0x44, 0x31, 0x01, 0x60, 0x17,
+	0xf7, 0x91, 0x81, 0xf9, 0xf1, 0x50, 0x02, 0xc2, 0x5e, 0x9b, 0x43, 0xd2, 0x8a, 0x5d, 0x09, 0x01,
+	0xd1, 0xa3, 0x34, 0xf8, 0x75, 0xcd, 0x54, 0xb7, 0x2b, 0x27, 0x36, 0xd0, 0x24, 0x64, 0xbd, 0xa2,
+	0x67, 0x1f, 0x85, 0x54, 0xd1, 0x19, 0x73, 0x46, 0xa5, 0xc8, 0x41, 0x49, 0xe7, 0x70, 0x3c, 0x21,
+	0x47, 0xc7, 0x76, 0x50, 0xd8, 0x30, 0x54, 0x81, 0x85, 0x9a, 0x4a, 0xcd, 0xc8, 0x52, 0xac, 0xd4,
+	0x85, 0x26, 0x4f, 0x21, 0x69, 0x0b, 0xf7, 0x17, 0x49, 0x73, 0x25, 0x3c, 0xf3, 0xad, 0x7f, 0xe0,
+	0x22, 0x5c, 0x02, 0x46, 0x7e, 0xe3, 0x9e, 0x7d, 0x54, 0xf0, 0x8b, 0x04, 0xa9, 0xde, 0xce, 0x7e,
+	0x3f, 0x18, 0x6a, 0x73, 0xb1, 0x5c, 0xad, 0x37, 0xdb, 0xdd, 0xfe, 0x70, 0x6c, 0x67, 0x3f, 0x2b,
+	0x44, 0xe6, 0x9c, 0x31, 0x01, 0x00, 0x00,
+};
+
+/* Log-like text with some noise, so that both matches and literals occur. */
+static void generate(stl::Vector<uint8_t>& data)
+{
+	char line[64];
+
+	srand(0xC0DE);
+
+	while(data.size() < INPUT_SIZE) {
+		auto length = snprintf(line, sizeof(line), "sensor %d: temperature %d.%d C\n", rand() % 8,
+		                       15 + rand() % 10, rand() % 10);
+
+		for(int idx = 0; idx < length; idx++)
+			data.push_back(line[idx]);
+
+		if(rand() % 5 == 0)
+			data.push_back(rand());
+	}
+}
+
+static void drain(BufferedStream& stream, stl::Vector<uint8_t>& output)
+{
+	uint8_t buffer[100];
+	ssize_t num;
+
+	while((num = stream.read(buffer, sizeof(buffer))) > 0) {
+		for(ssize_t idx = 0; idx < num; idx++)
+			output.push_back(buffer[idx]);
+	}
+}
+
+static void roundtrip(CompressionFormat format, uint8_t window, uint8_t lookahead)
+{
+	stl::Vector<uint8_t> input, compressed, output;
+	BufferedStream plain, packed, unpacked;
+
+	generate(input);
+
+	/* Compress on write, in writes of varying size. */
+	CompressingStream compressor(packed, format, window, lookahead);
+
+	for(size_t pos = 0, step = 1; pos < input.size(); pos += step, step = step % 300 + 7) {
+		auto num = input.size() - pos < step ? input.size() - pos : step;
+		assert(compressor.write(input.data() + pos, num) == static_cast<ssize_t>(num));
+	}
+
+	assert(compressor.finish());
+	drain(packed, compressed);
+	assert(compressed.size() < input.size() / 2);
+
+	/* Decompress on write. */
+	DecompressingStream writer(unpacked, format, window, lookahead);
+	assert(writer.write(compressed.data(), compressed.size()) == static_cast<ssize_t>(compressed.size()));
+	assert(writer.finish());
+	drain(unpacked, output);
+	assert(output.size() == input.size());
+	assert(memcmp(output.data(), input.data(), input.size()) == 0);
+
+	/* Compress and decompress on read, one byte at a time at the end. */
+	plain.write(input.data(), input.size());
+	CompressingStream source(plain, format, window, lookahead);
+	DecompressingStream reader(source, format, window, lookahead);
+
+	output.clear();
+
+	uint8_t buffer[37];
+	ssize_t num;
+
+	while((num = reader.read(buffer, output.size() < input.size() - 10 ? sizeof(buffer) : 1)) > 0) {
+		for(ssize_t idx = 0; idx < num; idx++)
+			output.push_back(buffer[idx]);
+	}
+
+	assert(!reader.failed());
+	assert(output.size() == input.size());
+	assert(memcmp(output.data(), input.data(), input.size()) == 0);
+}
+
+static void roundtrip_test()
+{
+	roundtrip(CompressionFormat::Heatshrink, 0, 0);
+	roundtrip(CompressionFormat::Heatshrink, 10, 5);
+	roundtrip(CompressionFormat::Heatshrink, 6, 3);
+	roundtrip(CompressionFormat::Deflate, 0, 0);
+	roundtrip(CompressionFormat::Deflate, 9, 4);
+	roundtrip(CompressionFormat::Gzip, 15, 9);
+
+	print_dbg("Round trip test passed!\n");
+}
+
+static void reference_test()
+{
+	stl::Vector<uint8_t> output;
+	BufferedStream unpacked;
+	DecompressingStream gzip(unpacked, CompressionFormat::Gzip);
+
+	/* Byte by byte, so every state has to wait for input. */
+	for(auto byte : reference_gzip)
+		assert(gzip.write(byte));
+
+	assert(gzip.finish());
+	drain(unpacked, output);
+	assert(output.size() == sizeof(reference_text) - 1);
+	assert(memcmp(output.data(), reference_text, output.size()) == 0);
+
+	/* A stored block, followed by a final block with fixed codes. */
+	static const uint8_t stored[] = { 0x00, 0x03, 0x00, 0xFC, 0xFF, 'a', 'b', 'c', 0x03, 0x00 };
+	InflateDecoder inflate;
+	uint8_t buffer[8];
+	size_t used;
+
+	assert(inflate.process(stored, sizeof(stored), used, buffer, sizeof(buffer)) == 3);
+	assert(used == sizeof(stored));
+	assert(inflate.done());
+	assert(memcmp(buffer, "abc", 3) == 0);
+
+	print_dbg("Reference test passed!\n");
+}
+
+static void failure_test()
+{
+	uint8_t data[sizeof(reference_gzip)];
+	BufferedStream sink;
+
+	/* Corrupt CRC. */
+	memcpy(data, reference_gzip, sizeof(data));
+	data[sizeof(data) - 8] ^= 1;
+
+	DecompressingStream gzip(sink, CompressionFormat::Gzip);
+	assert(gzip.write(data, sizeof(data)) < 0);
+	assert(gzip.failed());
+	assert(!gzip.finish());
+
+	/* Truncated stream. */
+	assert(gzip.write(reference_gzip, sizeof(reference_gzip) / 2) == sizeof(reference_gzip) / 2);
+	assert(!gzip.finish());
+
+	/* Not a gzip stream. */
+	assert(gzip.write("plain text", 10) < 0);
+	gzip.finish();
+
+	/* The stream is usable again after finish(). */
+	assert(gzip.write(reference_gzip, sizeof(reference_gzip)) == sizeof(reference_gzip));
+	assert(gzip.finish());
+
+	print_dbg("Failure test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	roundtrip_test();
+	reference_test();
+	failure_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <time.h>
+#include <string.h>
 
 #include <lwiot/log.h>
 #include <lwiot/stl/string.h>
@@ -29,10 +30,77 @@ static void dt_test()
 	assert(result > dt && dt < result);
 }
 
+static void calendar_test()
+{
+	/* Compare with the C library, across leap years, centuries and times before the epoch. */
+	for(int64_t stamp = -2208988800LL; stamp < 7258118400LL; stamp += 86399 * 7 + 3607) {
+		time_t value = static_cast<time_t>(stamp);
+		lwiot::DateTime dt(value);
+		struct tm tm;
+
+		gmtime_r(&value, &tm);
+		assert(dt.year() == tm.tm_year + 1900 && dt.month() == tm.tm_mon && dt.day() == tm.tm_mday);
+		assert(dt.hour() == tm.tm_hour && dt.minute() == tm.tm_min && dt.second() == tm.tm_sec);
+		assert(dt.dayOfWeek() == tm.tm_wday);
+
+		auto days = stamp >= 0 ? stamp / 86400 : (stamp - 86399) / 86400;
+		assert(lwiot::DateTime::daysFromCivil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday) == days);
+	}
+
+	/* Moving along the same day only updates the time. */
+	lwiot::DateTime dt(1582934399);
+	assert(dt.day() == 28 && dt.month() == 1);
+	dt.sync(1582934400);
+	assert(dt.day() == 29 && dt.hour() == 0);
+	dt.sync(1582934400 + 3661);
+	assert(dt.day() == 29 && dt.hour() == 1 && dt.minute() == 1 && dt.second() == 1);
+
+	print_dbg("Calendar test done!\n");
+}
+
+static void iso_test()
+{
+	char buffer[lwiot::DateTime::IsoBufferSize];
+	time_t stamp;
+	int ms;
+
+	assert(lwiot::DateTime::formatIso(buffer, 1600000000) == 20);
+	assert(strcmp(buffer, "2020-09-13T12:26:40Z") == 0);
+	assert(lwiot::DateTime::formatIso(buffer, 951782400, 7) == 24);
+	assert(strcmp(buffer, "2000-02-29T00:00:00.007Z") == 0);
+	assert(lwiot::DateTime(0).toIsoString() == "1970-01-01T00:00:00Z");
+
+	assert(lwiot::DateTime::parseIso("2020-09-13T12:26:40Z", stamp) && stamp == 1600000000);
+	assert(lwiot::DateTime::parseIso("2020-09-13 14:26:40.5+02:00", stamp, &ms) && stamp == 1600000000 && ms == 500);
+	assert(lwiot::DateTime::parseIso("2020-09-13T07:56:40,123456-0430", stamp, &ms) && stamp == 1600000000 && ms == 123);
+	assert(lwiot::DateTime::parseIso("2020-09-13T12:26", stamp, &ms) && stamp == 1599999960 && ms == 0);
+	assert(lwiot::DateTime::parseIso("1969-12-31T23:59:59Z", stamp) && stamp == -1);
+
+	const char *invalid[] = {
+		"", "2020-09-13", "2020-9-13T12:26:40Z", "2020-13-01T00:00:00Z", "2020-09-13T12:26:40Y",
+		"2020-09-13T12:26:40.Z", "2020-09-13T24:00:00Z", "2020-09-13T12:26:40+1"
+	};
+
+	for(auto text : invalid)
+		assert(!lwiot::DateTime::parseIso(text, stamp));
+
+	lwiot::IsoFormatter formatter;
+
+	assert(strcmp(formatter.format(1600000000123LL), "2020-09-13T12:26:40.123Z") == 0);
+	assert(strcmp(formatter.format(1600000000999LL), "2020-09-13T12:26:40.999Z") == 0);
+	assert(strcmp(formatter.format(1600041599000LL), "2020-09-13T23:59:59.000Z") == 0);
+	assert(strcmp(formatter.format(1600041600001LL), "2020-09-14T00:00:00.001Z") == 0);
+	assert(strcmp(formatter.format(-1LL), "1969-12-31T23:59:59.999Z") == 0);
+
+	print_dbg("ISO 8601 test done!\n");
+}
+
 int main(int argc, char **argv)
 {
 	lwiot_init();
 	dt_test();
+	calendar_test();
+	iso_test();
 	wait_close();
 	lwiot_destroy();
 
@@ -0,0 +1,353 @@
+/*
+ * Delta update unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/io/blockdevice.h>
+#include <lwiot/network/sha256.h>
+#include <lwiot/network/deltaupdate.h>
+#include <lwiot/stl/vector.h>
+
+#ifdef NDEBUG
+#error "Debugging not enabled.."
+#endif
+
+using namespace lwiot;
+
+#define IMAGE_SIZE 4096
+
+class RamDevice : public BlockDevice {
+public:
+	explicit RamDevice(size_t size) : BlockDevice(size, 256), writes(0), memory(new uint8_t[size])
+	{
+		memset(this->memory, 0xFF, size);
+	}
+
+	~RamDevice() override
+	{
+		delete[] this->memory;
+	}
+
+	int writes;
+	uint8_t *memory;
+
+protected:
+	bool readBurst(size_t addr, void *data, size_t length) override
+	{
+		memcpy(data, this->memory + addr, length);
+		return true;
+	}
+
+	bool writeBurst(size_t addr, const void *data, size_t length) override
+	{
+		memcpy(this->memory + addr, data, length);
+		this->writes++;
+		return true;
+	}
+};
+
+class Bits {
+public:
+	explicit Bits(stl::Vector<uint8_t>& output) : _output(output), _byte(0), _count(0)
+	{
+	}
+
+	void put(uint16_t value, int num)
+	{
+		for(int idx = num - 1; idx >= 0; idx--) {
+			this->_byte = (this->_byte << 1) | ((value >> idx) & 1);
+
+			if(++this->_count == 8) {
+				this->_output.push_back(this->_byte);
+				this->_byte = 0;
+				this->_count = 0;
+			}
+		}
+	}
+
+	void flush()
+	{
+		if(this->_count != 0)
+			this->put(0, 8 - this->_count);
+	}
+
+private:
+	stl::Vector<uint8_t>& _output;
+	uint8_t _byte;
+	int _count;
+};
+
+/* Greedy heatshrink encoder with the decoder's window and lookahead. */
+static void compress(const stl::Vector<uint8_t>& input, stl::Vector<uint8_t>& output)
+{
+	const size_t window = 1 << CONFIG_DELTA_WINDOW;
+	const size_t lookahead = 1 << CONFIG_DELTA_LOOKAHEAD;
+	Bits bits(output);
+
+	for(size_t pos = 0; pos < input.size(); ) {
+		size_t best = 0, offset = 0;
+
+		for(size_t back = 1; back <= window && back <= pos; back++) {
+			size_t len = 0;
+
+			while(len < lookahead && pos + len < input.size() && input[pos + len] == input[pos - back + len])
+				len++;
+
+			if(len > best) {
+				best = len;
+				offset = back;
+			}
+		}
+
+		if(best >= 2) {
+			bits.put(0, 1);
+			bits.put(offset - 1, CONFIG_DELTA_WINDOW);
+			bits.put(best - 1, CONFIG_DELTA_LOOKAHEAD);
+			pos += best;
+		} else {
+			bits.put(1, 1);
+			bits.put(input[pos], 8);
+			pos++;
+		}
+	}
+
+	bits.flush();
+}
+
+static void offtout(stl::Vector<uint8_t>& output, int64_t value)
+{
+	uint64_t magnitude = value < 0 ? -value : value;
+
+	for(int idx = 0; idx < 8; idx++) {
+		uint8_t byte = magnitude >> (idx * 8);
+
+		if(idx == 7 && value < 0)
+			byte |= 0x80;
+
+		output.push_back(byte);
+	}
+}
+
+struct Control {
+	int64_t add;
+	int64_t extra;
+	int64_t seek;
+};
+
+/*
+ * Build a patch from control records and the image it should produce. The new image is created
+ * here as well, following bspatch, so the test does not depend on a bsdiff implementation.
+ */
+static void patch(const uint8_t *old, const Control *controls, size_t num, stl::Vector<uint8_t>& image,
+                  stl::Vector<uint8_t>& output)
+{
+	stl::Vector<uint8_t> body;
+	int64_t pos = 0;
+	uint8_t value = 1;
+
+	for(size_t idx = 0; idx < num; idx++) {
+		auto& ctrl = controls[idx];
+
+		offtout(body, ctrl.add);
+		offtout(body, ctrl.extra);
+		offtout(body, ctrl.seek);
+
+		for(int64_t add = 0; add < ctrl.add; add++) {
+			uint8_t diff = (add % 97) == 0 ? value++ : 0;
+
+			body.push_back(diff);
+			image.push_back(old[pos + add] + diff);
+		}
+
+		for(int64_t extra = 0; extra < ctrl.extra; extra++) {
+			body.push_back(extra * 7);
+			image.push_back(extra * 7);
+		}
+
+		pos += ctrl.add + ctrl.seek;
+	}
+
+	const char *magic = "ENDSLEY/BSDIFF43";
+
+	for(size_t idx = 0; idx < 16; idx++)
+		output.push_back(magic[idx]);
+
+	offtout(output, image.size());
+	compress(body, output);
+}
+
+static void sha256_test()
+{
+	static const uint8_t abc[] = {
+		0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+		0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+	};
+	static const uint8_t longer[] = {
+		0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+		0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1
+	};
+	static const uint8_t empty[] = {
+		0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+		0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55
+	};
+	const char *message = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+	uint8_t digest[SHA256_DIGEST_SIZE];
+	sha256_context_t ctx;
+
+	sha256("abc", 3, digest);
+	assert(memcmp(digest, abc, sizeof(digest)) == 0);
+
+	sha256("", 0, digest);
+	assert(memcmp(digest, empty, sizeof(digest)) == 0);
+
+	/* Incremental updates split over block boundaries. */
+	sha256_init(&ctx);
+
+	for(size_t idx = 0; idx < strlen(message); idx++)
+		sha256_update(&ctx, message + idx, 1);
+
+	sha256_final(&ctx, digest);
+	assert(memcmp(digest, longer, sizeof(digest)) == 0);
+
+	print_dbg("SHA-256 test passed!\n");
+}
+
+static void build(RamDevice& source, stl::Vector<uint8_t>& image, stl::Vector<uint8_t>& data)
+{
+	static const Control controls[] = {
+		{ 1000, 100, 200 },
+		{ 1500, 0, -700 },
+		{ 600, 37, 0 },
+		{ 0, 300, 1000 },
+		{ 400, 0, 0 }
+	};
+
+	srand(0x5EED);
+
+	for(size_t idx = 0; idx < IMAGE_SIZE; idx++)
+		source.memory[idx] = (idx % 64) < 40 ? idx / 64 : rand();
+
+	patch(source.memory, controls, sizeof(controls) / sizeof(controls[0]), image, data);
+}
+
+static void apply_test()
+{
+	RamDevice source(IMAGE_SIZE), target(IMAGE_SIZE);
+	stl::Vector<uint8_t> image, data;
+	uint8_t digest[SHA256_DIGEST_SIZE];
+
+	build(source, image, data);
+	sha256(image.data(), image.size(), digest);
+	assert(data.size() < image.size());
+
+	DeltaUpdate update(source, target);
+	update.expect(digest);
+
+	/* Feed the patch in pieces that split the header, control records and symbols. */
+	for(size_t pos = 0, step = 1; pos < data.size(); pos += step, step = step % 29 + 3) {
+		auto num = data.size() - pos < step ? data.size() - pos : step;
+		assert(update.write(data.data() + pos, num));
+	}
+
+	assert(update.size() == image.size());
+	assert(update.written() == image.size());
+	assert(update.finish());
+	assert(update.error() == DeltaUpdate::Error::None);
+	assert(memcmp(update.digest(), digest, sizeof(digest)) == 0);
+	assert(memcmp(target.memory, image.data(), image.size()) == 0);
+
+	/* The new image is written in whole blocks, not byte by byte. */
+	assert(target.writes <= static_cast<int>(image.size() / CONFIG_DELTA_BLOCK_SIZE + 2));
+
+	print_dbg("Delta update test passed!\n");
+}
+
+static void chunk_test()
+{
+	RamDevice source(IMAGE_SIZE), target(IMAGE_SIZE);
+	stl::Vector<uint8_t> image, data;
+	uint8_t digest[SHA256_DIGEST_SIZE];
+
+	build(source, image, data);
+	sha256(image.data(), image.size(), digest);
+
+	DeltaUpdate update(source, target);
+	update.expect(digest);
+
+	/* A failed update is restarted by the next message. */
+	RawBuffer garbage(source.memory, 100);
+	assert(!update.receive(0, garbage, 200));
+	assert(update.error() == DeltaUpdate::Error::Format);
+
+	for(size_t offset = 0; offset < data.size(); offset += 100) {
+		auto num = data.size() - offset < 100 ? data.size() - offset : 100;
+		RawBuffer span(data.data() + offset, num);
+
+		assert(update.receive(offset, span, data.size()));
+	}
+
+	assert(update.error() == DeltaUpdate::Error::None);
+	assert(memcmp(target.memory, image.data(), image.size()) == 0);
+
+	print_dbg("Chunked receive test passed!\n");
+}
+
+static void failure_test()
+{
+	RamDevice source(IMAGE_SIZE), target(IMAGE_SIZE);
+	stl::Vector<uint8_t> image, data;
+	uint8_t digest[SHA256_DIGEST_SIZE];
+
+	build(source, image, data);
+	sha256(image.data(), image.size(), digest);
+
+	DeltaUpdate update(source, target);
+
+	/* Truncated patch. */
+	assert(update.write(data.data(), data.size() / 2));
+	assert(!update.finish());
+	assert(update.error() == DeltaUpdate::Error::Size);
+	assert(!update.write(data.data() + data.size() / 2, 1));
+
+	/* Wrong digest. */
+	digest[0] ^= 1;
+	update.expect(digest);
+	update.reset();
+	assert(update.write(data.data(), data.size()));
+	assert(!update.finish());
+	assert(update.error() == DeltaUpdate::Error::Digest);
+
+	/* Image larger than the target partition. */
+	RamDevice small(1024);
+	DeltaUpdate large(source, small);
+	assert(!large.write(data.data(), data.size()));
+	assert(large.error() == DeltaUpdate::Error::Target);
+
+	print_dbg("Failure test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	sha256_test();
+	apply_test();
+	chunk_test();
+	failure_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
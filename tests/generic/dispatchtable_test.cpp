@@ -0,0 +1,112 @@
+/*
+ * Dispatch table unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/test.h>
+#include <lwiot/stl/dispatchtable.h>
+#include <lwiot/network/xbee/xbeedispatcher.h>
+
+struct Ping {
+	static constexpr uint8_t API_ID = 3;
+};
+
+struct Data {
+	static constexpr uint8_t API_ID = 7;
+};
+
+struct Ack {
+	static constexpr uint8_t API_ID = 4;
+};
+
+struct Invoker {
+	template <typename T>
+	static int invoke(int *last, int value)
+	{
+		*last = T::API_ID;
+		return value;
+	}
+};
+
+static void table_test()
+{
+	typedef lwiot::stl::DispatchTable<int(int*, int), Invoker, Ping, Data, Ack> Table;
+	int last = 0;
+
+	static_assert(Table::Min == 3, "Smallest key is 3!");
+	static_assert(Table::Max == 7, "Largest key is 7!");
+	static_assert(Table::Size == 5, "Table spans five keys!");
+
+	assert(Table::dispatch(7, &last, 1));
+	assert(last == Data::API_ID);
+	assert(Table::dispatch(3, &last, 1));
+	assert(last == Ping::API_ID);
+	assert(Table::lookup(4)(&last, 42) == 42);
+	assert(last == Ack::API_ID);
+
+	last = 0;
+	assert(!Table::dispatch(5, &last, 1));
+	assert(!Table::dispatch(2, &last, 1));
+	assert(!Table::dispatch(100, &last, 1));
+	assert(Table::lookup(6) == nullptr);
+	assert(last == 0);
+}
+
+struct XBeeHandler {
+	int modem;
+	int at;
+
+	void operator()(lwiot::ModemStatusResponse& status)
+	{
+		this->modem = status.getStatus();
+	}
+
+	void operator()(lwiot::AtCommandResponse& response)
+	{
+		this->at = response.getFrameId();
+	}
+};
+
+static void xbee_test()
+{
+	uint8_t status[] = { 0x02 };
+	uint8_t at[] = { 0x11, 'N', 'I', 0x00 };
+	lwiot::XBeeResponse response;
+
+	auto dispatcher = lwiot::make_xbee_dispatcher<lwiot::ModemStatusResponse, lwiot::AtCommandResponse>(
+			XBeeHandler { 0, 0 });
+
+	response.setApiId(MODEM_STATUS_RESPONSE);
+	response.setFrameData(status);
+	response.setFrameLength(sizeof(status));
+	assert(dispatcher.dispatch(response));
+	assert(dispatcher.handler().modem == 0x02);
+
+	response.setApiId(AT_COMMAND_RESPONSE);
+	response.setFrameData(at);
+	response.setFrameLength(sizeof(at));
+	assert(dispatcher.dispatch(response));
+	assert(dispatcher.handler().at == 0x11);
+
+	response.setApiId(ZB_RX_RESPONSE);
+	assert(!dispatcher.dispatch(response));
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	table_test();
+	xbee_test();
+
+	lwiot_destroy();
+	wait_close();
+	return -EXIT_SUCCESS;
+}
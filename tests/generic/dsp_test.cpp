@@ -0,0 +1,129 @@
+/*
+ * DSP kernel unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <math.h>
+#include <lwiot.h>
+
+#include <lwiot/test.h>
+
+#include <lwiot/util/dsp.h>
+
+#define FS 1000.0f
+#define LENGTH 256
+#define PI 3.14159265358979323846f
+
+static bool near(float a, float b, float eps)
+{
+	return fabsf(a - b) <= eps;
+}
+
+static void sine(float *out, size_t length, float frequency, float amplitude)
+{
+	for(size_t idx = 0; idx < length; idx++)
+		out[idx] = amplitude * sinf(2.0f * PI * frequency * static_cast<float>(idx) / FS);
+}
+
+static void dsp_statistics_test()
+{
+	float data[LENGTH];
+	uint16_t raw[5] = { 2048, 2049, 2047, 4095, 0 };
+	float converted[5];
+
+	sine(data, LENGTH, 125.0f, 2.0f);
+	assert(near(lwiot::dsp::mean(data, LENGTH), 0.0f, 1e-4f));
+	assert(near(lwiot::dsp::rms(data, LENGTH), 2.0f / sqrtf(2.0f), 1e-3f));
+	assert(near(lwiot::dsp::peak(data, LENGTH), 2.0f, 1e-3f));
+
+	lwiot::dsp::convert(raw, converted, 5, 2048.0f, 1.0f / 2048.0f);
+	assert(converted[0] == 0.0f);
+	assert(near(converted[3], 1.0f, 1e-3f));
+	assert(converted[4] == -1.0f);
+
+	print_dbg("DSP statistics test done!\n");
+}
+
+static void dsp_filter_test()
+{
+	float low[LENGTH], high[LENGTH], out[LENGTH];
+	auto lowpass = lwiot::dsp::Biquad::lowpass(FS, 50.0f);
+	auto average = lwiot::dsp::Fir::average(4);
+
+	sine(low, LENGTH, 10.0f, 1.0f);
+	sine(high, LENGTH, 400.0f, 1.0f);
+
+	lowpass.process(low, out, LENGTH);
+	assert(lwiot::dsp::rms(out + 128, 128) > 0.65f);
+
+	lowpass.reset();
+	lowpass.process(high, out, LENGTH);
+	assert(lwiot::dsp::rms(out + 128, 128) < 0.05f);
+
+	/* A four tap moving average removes a sine with a period of four samples. */
+	sine(high, LENGTH, 250.0f, 1.0f);
+	average.process(high, out, LENGTH);
+	for(size_t idx = 4; idx < LENGTH; idx++)
+		assert(near(out[idx], 0.0f, 1e-4f));
+
+	average.reset();
+	for(size_t idx = 0; idx < LENGTH; idx++)
+		high[idx] = 1.0f;
+
+	assert(average.decimate(high, out, 10, 4) == 3);
+	assert(average.decimate(high, out + 3, 10, 4) == 2);
+	assert(out[0] == 0.25f && out[1] == 1.0f && out[4] == 1.0f);
+
+	print_dbg("DSP filter test done!\n");
+}
+
+static void dsp_spectrum_test()
+{
+	float re[LENGTH], im[LENGTH], mag[LENGTH / 2];
+	size_t max = 0;
+
+	/* 125 Hz at 1 kHz lands in bin 32 of a 256 point FFT. */
+	sine(re, LENGTH, 125.0f, 1.0f);
+	for(size_t idx = 0; idx < LENGTH; idx++)
+		im[idx] = 0.0f;
+
+	assert(!lwiot::dsp::fft(re, im, 100));
+	assert(lwiot::dsp::fft(re, im, LENGTH));
+	lwiot::dsp::magnitude(re, im, mag, LENGTH / 2);
+
+	for(size_t idx = 1; idx < LENGTH / 2; idx++) {
+		if(mag[idx] > mag[max])
+			max = idx;
+	}
+
+	assert(max == 32);
+	assert(near(mag[32], LENGTH / 2.0f, 0.01f * LENGTH));
+
+	lwiot::dsp::Goertzel detector(FS, 125.0f, LENGTH);
+	lwiot::dsp::Goertzel other(FS, 300.0f, LENGTH);
+
+	sine(re, LENGTH, 125.0f, 0.5f);
+	assert(near(detector.amplitude(re), 0.5f, 0.01f));
+	assert(other.amplitude(re) < 0.05f);
+
+	print_dbg("DSP spectrum test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	dsp_statistics_test();
+	dsp_filter_test();
+	dsp_spectrum_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
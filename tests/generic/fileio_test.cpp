@@ -7,14 +7,19 @@
 
 #include <lwiot.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include <assert.h>
 #include <time.h>
 
 #include <lwiot/log.h>
 #include <lwiot/types.h>
+#include <lwiot/error.h>
+#include <lwiot/bytebuffer.h>
 
 #include <lwiot/stl/string.h>
 #include <lwiot/io/file.h>
+#include <lwiot/io/mappedregion.h>
 
 #include <lwiot/test.h>
 
@@ -35,6 +40,149 @@ static void read_test(const lwiot::stl::String& path)
 	print_dbg("Read from file: %s\n", str.c_str());
 }
 
+static size_t disk_size(const char *path)
+{
+	FILE *fp = fopen(path, "r");
+	size_t size;
+
+	assert(fp != nullptr);
+	fseek(fp, 0L, SEEK_END);
+	size = ftell(fp);
+	fclose(fp);
+
+	return size;
+}
+
+static void buffered_write_test(size_t buffer)
+{
+	uint8_t data[1500];
+	uint8_t check[1500];
+
+	for(size_t idx = 0; idx < sizeof(data); idx++)
+		data[idx] = static_cast<uint8_t>(idx * 31);
+
+	{
+		lwiot::File file("buffered.bin", lwiot::FileMode::ReadWrite, buffer);
+
+		/* Small writes stay in the buffer until a block is complete. */
+		for(size_t idx = 0; idx < 100; idx++)
+			assert(file.write(data[idx]));
+
+		if(buffer > 0)
+			assert(disk_size("buffered.bin") == 100 - 100 % buffer);
+
+		assert(file.write(data + 100, 900) == 900);
+		assert(file.write(data + 1000, 500) == 500);
+		assert(file.size() == sizeof(data));
+
+		/* Overwrite a range and read it back through the buffer. */
+		assert(file.seek(700));
+		assert(file.write("overwrite", 9) == 9);
+		memcpy(data + 700, "overwrite", 9);
+
+		assert(file.seek(0));
+		assert(file.available() == sizeof(data));
+		assert(file.read(check, 3) == 3);
+		assert(file.read(check + 3, sizeof(check)) == sizeof(check) - 3);
+		assert(memcmp(data, check, sizeof(data)) == 0);
+		assert(file.available() == 0);
+		assert(file.read(check, 1) == 0);
+
+		assert(file.flush());
+		assert(disk_size("buffered.bin") == sizeof(data));
+	}
+
+	{
+		lwiot::File file("buffered.bin", lwiot::FileMode::Read, buffer);
+
+		memset(check, 0, sizeof(check));
+		assert(file.seek(1200));
+		assert(file.read() == data[1200]);
+		assert(file.seek(0));
+		assert(file.read(check, sizeof(check)) == sizeof(check));
+		assert(memcmp(data, check, sizeof(data)) == 0);
+	}
+
+	{
+		lwiot::File file("buffered.bin", lwiot::FileMode::Append, buffer);
+
+		assert(file.write("tail", 4) == 4);
+	}
+
+	assert(disk_size("buffered.bin") == sizeof(data) + 4);
+	print_dbg("Buffered write test done (%u byte buffer)!\n", static_cast<unsigned>(buffer));
+}
+
+static void readline_test(size_t buffer)
+{
+	lwiot::ByteBuffer line;
+
+	{
+		lwiot::File file("lines.txt", lwiot::FileMode::Write, buffer);
+
+		file << "first line\n";
+		file << "second line\r\n";
+		file << "\n";
+
+		for(int idx = 0; idx < 100; idx++)
+			file << "0123456789";
+
+		file << "\nlast";
+	}
+
+	lwiot::File file("lines.txt", lwiot::FileMode::Read, buffer);
+
+	assert(file.readLine(line) == 10);
+	assert(memcmp(line.data(), "first line", 10) == 0);
+
+	line.reset();
+	assert(file.readLine(line) == 11);
+	assert(memcmp(line.data(), "second line", 11) == 0);
+
+	line.reset();
+	assert(file.readLine(line) == 0);
+	assert(file.readLine(line) == 1000);
+	assert(line.data()[999] == '9');
+
+	line.reset();
+	assert(file.readLine(line) == 4);
+	assert(memcmp(line.data(), "last", 4) == 0);
+	assert(file.readLine(line) == -ENOTFOUND);
+
+	print_dbg("Read line test done (%u byte buffer)!\n", static_cast<unsigned>(buffer));
+}
+
+static void mapped_region_test()
+{
+	lwiot::MappedRegion empty;
+	lwiot::MappedRegion missing("missing.bin");
+
+	assert(!empty && !missing);
+
+	{
+		lwiot::File file("mapped.txt", lwiot::FileMode::Write);
+		file << "mapped content";
+	}
+
+	lwiot::MappedRegion region("mapped.txt");
+
+	assert(region);
+	assert(region.size() == 14);
+	assert(region.view() == "mapped content");
+	assert(region.span().size() == 14);
+
+	lwiot::MappedRegion moved(lwiot::stl::move(region));
+
+	assert(!region && moved);
+	assert(memcmp(moved.data(), "mapped", 6) == 0);
+
+	moved.unmap();
+	assert(!moved && moved.size() == 0);
+	remove("mapped.txt");
+
+	print_dbg("Mapped region test done!\n");
+}
+
 int main(int argc, char **argv)
 {
 	lwiot_init();
@@ -42,6 +190,18 @@ int main(int argc, char **argv)
 	write_test("test.txt");
 	read_test("test.txt");
 
+	buffered_write_test(512);
+	buffered_write_test(64);
+	buffered_write_test(0);
+	readline_test(512);
+	readline_test(16);
+	readline_test(0);
+
+	mapped_region_test();
+
+	remove("buffered.bin");
+	remove("lines.txt");
+
 	wait_close();
 	lwiot_destroy();
 
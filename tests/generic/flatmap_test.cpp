@@ -0,0 +1,99 @@
+/*
+ * Flat map unit test.
+ *
+ * Author: Michel Megens
+ * Email: dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/flatmap.h>
+#include <lwiot/test.h>
+
+static void test_basic()
+{
+	lwiot::stl::String s1("test..");
+	lwiot::stl::FlatMap<int, lwiot::String> m1;
+
+	m1.add(5, "Hello");
+	m1.add(6, "World");
+	m1.add(1, "What?!");
+
+	lwiot::stl::FlatMap<int, lwiot::String> m2(lwiot::stl::move(m1));
+	assert(m1.size() == 0);
+
+	m2[4] = "Bla. Bla";
+	m2[6] = "Testing..";
+	m2[9] = "More testing..";
+	m2.add(6, lwiot::stl::move(s1));
+
+	assert(m2[6].equals("test.."));
+	assert(m2.contains(4));
+	assert(m2.contains(1));
+	assert(m2.size() == 5);
+
+	m2.remove(1);
+	m2.remove(4);
+
+	assert(m2.find(4) == m2.end());
+	auto iter = m2.find(5);
+	assert(iter != m2.end());
+	assert(iter->value.equals("Hello"));
+	assert(!m2.contains(1));
+	assert(!m2.contains(4));
+	assert(m2.size() == 3);
+
+	size_t num = 0;
+	for(auto& e : m2) {
+		print_dbg("Entry: [%i]: %s\n", e.key, e.value.c_str());
+		num++;
+	}
+
+	assert(num == m2.size());
+}
+
+static void test_order()
+{
+	lwiot::stl::FlatMap<int, int> map;
+	const int keys[] = { 42, 7, 19, 3, 88, 56, 1, 23 };
+
+	for(auto key : keys)
+		map.add(key, key * 2);
+
+	int last = -1;
+	for(const auto& e : map) {
+		assert(e.key > last);
+		assert(e.value == e.key * 2);
+		last = e.key;
+	}
+
+	const auto& cmap = map;
+	assert(cmap.at(19) == 38);
+	assert(cmap.at(20) == 0);
+	assert(cmap.find(88) != cmap.end());
+	assert(cmap.find(89) == cmap.end());
+
+	lwiot::stl::FlatMap<int, int> copy(map);
+	map.clear();
+
+	assert(map.empty());
+	assert(copy.size() == 8);
+	assert(copy.contains(56));
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	test_basic();
+	test_order();
+
+	wait_close();
+	lwiot_destroy();
+	return -EXIT_SUCCESS;
+}
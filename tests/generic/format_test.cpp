@@ -0,0 +1,112 @@
+/*
+ * String formatting unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+#include <lwiot/format.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+
+static_assert(lwiot::detail::is_valid_format<int, const char *>("{} {}"), "Valid format rejected");
+static_assert(lwiot::detail::is_valid_format<>("{{}}"), "Escapes rejected");
+static_assert(lwiot::detail::is_valid_format<unsigned, double>("{:x} {:.2}"), "Valid specifiers rejected");
+static_assert(!lwiot::detail::is_valid_format<int>("{} {}"), "Missing argument accepted");
+static_assert(!lwiot::detail::is_valid_format<int, int>("{}"), "Extra argument accepted");
+static_assert(!lwiot::detail::is_valid_format<const char *>("{:x}"), "Base specifier on a string accepted");
+static_assert(!lwiot::detail::is_valid_format<int>("{:.3}"), "Precision on an integer accepted");
+static_assert(!lwiot::detail::is_valid_format<int>("{"), "Unterminated field accepted");
+static_assert(!lwiot::detail::is_valid_format<>("}"), "Unmatched brace accepted");
+
+static void format_test()
+{
+	char output[64];
+	lwiot::String str("world");
+
+	auto length = lwiot::format(output, sizeof(output), LWIOT_FMT("Hello {}, {} + {} = {}"), str, -1, 3U, 2L);
+	assert(strcmp(output, "Hello world, -1 + 3 = 2") == 0);
+	assert(length == strlen(output));
+
+	lwiot::format(output, sizeof(output), LWIOT_FMT("{:x} {:X} {:o} {:b} {:x}"), 0xABCU, 0xABCU, 8, 5, -255);
+	assert(strcmp(output, "abc ABC 10 101 -ff") == 0);
+
+	lwiot::format(output, sizeof(output), LWIOT_FMT("{} {:.2} {:.0}"), 1.5, 3.14159f, 2.5);
+	assert(strcmp(output, "1.500000 3.14 2") == 0);
+
+	lwiot::format(output, sizeof(output), LWIOT_FMT("{{{}}} {} {} {}"), 'c', true, false, lwiot::StringView("view", 2));
+	assert(strcmp(output, "{c} true false vi") == 0);
+
+	uint8_t u8 = 200;
+	int8_t s8 = -100;
+	lwiot::format(output, sizeof(output), LWIOT_FMT("{} {}"), u8, s8);
+	assert(strcmp(output, "200 -100") == 0);
+
+	lwiot::format(output, sizeof(output), "{} {:q} {}", 1);
+	assert(strcmp(output, "1 {:q} {}") == 0);
+
+	print_dbg("Format test passed!\n");
+}
+
+static void truncate_test()
+{
+	char output[8];
+
+	auto length = lwiot::format(output, sizeof(output), LWIOT_FMT("{} is too long"), "this");
+	assert(length == strlen("this is too long"));
+	assert(strcmp(output, "this is") == 0);
+
+	assert(lwiot::format(nullptr, 0, LWIOT_FMT("{}"), 12345) == 5);
+	print_dbg("Truncation test passed!\n");
+}
+
+static void logger_test()
+{
+	char *data = nullptr;
+	size_t size = 0;
+	auto file = open_memstream(&data, &size);
+	lwiot::Logger log("test", file);
+	char longer[301];
+
+	memset(longer, 'x', sizeof(longer) - 1);
+	longer[sizeof(longer) - 1] = '\0';
+
+	log.println(LWIOT_FMT("value: {}"), 42);
+	log << "partial ";
+	log.println("{}", 7);
+	log.println(LWIOT_FMT("{}"), longer);
+	fclose(file);
+
+	assert(strstr(data, "[lwiot][test]: value: 42\n") != nullptr);
+	assert(strstr(data, "[lwiot][test]: partial 7\n") != nullptr);
+	assert(strstr(data, "[lwiot][test]: xxx") != nullptr);
+	assert(strstr(data, "xxx\n") != nullptr);
+	assert(data[size - 1] == '\n');
+
+	free(data);
+	print_dbg("Logger test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	format_test();
+	truncate_test();
+	logger_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -12,8 +12,11 @@
 #include <lwiot/log.h>
 #include <lwiot/function.h>
 #include <lwiot/functor.h>
+#include <lwiot/uniquepointer.h>
 #include <lwiot/test.h>
 
+#include <assert.h>
+
 class FunctorTest : public lwiot::Functor {
 public:
 	FunctorTest() = default;
@@ -36,6 +39,70 @@ protected:
 
 };
 
+static int add(int a, int b)
+{
+	return a + b;
+}
+
+static int apply(lwiot::FunctionRef<int(int, int)> fn)
+{
+	return fn(2, 3);
+}
+
+static void large_capture_test()
+{
+	char buffer[256];
+	int offset = 4;
+
+	memset(buffer, 0, sizeof(buffer));
+	buffer[200] = 42;
+
+	/* Too big for the inline buffer, ends up on the heap. */
+	lwiot::Function<int(int)> fn = [buffer, offset](int idx) -> int {
+		return buffer[idx + offset];
+	};
+
+	auto copy = fn;
+	lwiot::Function<int(int)> moved(lwiot::stl::move(fn));
+
+	assert(!fn.valid());
+	assert(copy(196) == 42);
+	assert(moved(196) == 42);
+
+	print_dbg("Large capture test passed!\n");
+}
+
+static void unique_function_test()
+{
+	lwiot::UniquePointer<int> ptr(new int(5));
+	lwiot::UniqueFunction<int(void)> fn = [value = lwiot::stl::move(ptr)]() -> int {
+		return *value;
+	};
+
+	assert(fn() == 5);
+
+	lwiot::UniqueFunction<int(void)> other(lwiot::stl::move(fn));
+	assert(!fn);
+	assert(other() == 5);
+
+	print_dbg("Unique function test passed!\n");
+}
+
+static void function_ref_test()
+{
+	int factor = 10;
+	auto lambda = [&](int a, int b) {
+		return (a + b) * factor;
+	};
+
+	static_assert(sizeof(lwiot::FunctionRef<int(int, int)>) == 2 * sizeof(void*), "Unexpected size!");
+
+	assert(apply(add) == 5);
+	assert(apply(lambda) == 50);
+
+	print_dbg("Function reference test passed!\n");
+}
+
 int main(int argc, char **argv)
 {
 	lwiot::Function<int(int)> fn;
@@ -54,6 +121,10 @@ int main(int argc, char **argv)
 
 	print_dbg("Fn of 15 = %i\n", fn(15));
 
+	large_capture_test();
+	unique_function_test();
+	function_ref_test();
+
 	lwiot_destroy();
 	wait_close();
 
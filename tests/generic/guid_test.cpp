@@ -15,6 +15,63 @@
 
 #include <lwiot/stl/move.h>
 
+static void format_test()
+{
+	lwiot::Guid guid;
+	lwiot::Guid parsed;
+	char text[lwiot::Guid::STRING_LENGTH + 1];
+
+	assert(guid.version() == 4);
+	assert((guid.bytes()[8] & 0xC0) == 0x80);
+	assert(guid.timestamp() == -1);
+
+	guid.formatTo(text);
+	assert(strlen(text) == lwiot::Guid::STRING_LENGTH);
+	assert(guid.toString() == text);
+	assert(guid == guid.toString());
+
+	assert(lwiot::Guid::parse(text, parsed));
+	assert(parsed == guid);
+
+	assert(lwiot::Guid::parse("3F2504E0-4F89-41D3-9A0C-0305E82C3301", parsed));
+	assert(parsed.toString() == "3f2504e0-4f89-41d3-9a0c-0305e82c3301");
+	assert(parsed == "3f2504e0-4f89-41d3-9a0c-0305e82c3301");
+	assert(parsed != "3f2504e0-4f89-41d3-9a0c-0305e82c3302");
+
+	assert(!lwiot::Guid::parse("3f2504e0-4f89-41d3-9a0c-0305e82c330", parsed));
+	assert(!lwiot::Guid::parse("3f2504e0-4f89-41d3-9a0c-0305e82c33011", parsed));
+	assert(!lwiot::Guid::parse("3f2504e0+4f89-41d3-9a0c-0305e82c3301", parsed));
+	assert(!lwiot::Guid::parse("3f2504e0-4f89-41d3-9a0c-0305e82c33g1", parsed));
+	assert(!lwiot::Guid::parse("3f2504e0-4f89-41d3-9a0c-0305e82c33\xe9" "1", parsed));
+	assert(parsed.toString() == "3f2504e0-4f89-41d3-9a0c-0305e82c3301");
+
+	print_dbg("Format test passed!\n");
+}
+
+static void ordered_test()
+{
+	lwiot::Guid g1 = lwiot::Guid::v7(1700000000123LL);
+	lwiot::Guid g2 = lwiot::Guid::v7(1700000000124LL);
+
+	assert(g1.version() == 7);
+	assert((g1.bytes()[8] & 0xC0) == 0x80);
+	assert(g1.timestamp() == 1700000000123LL);
+	assert(g1 < g2);
+	assert(g1.toString().substring(0, 13) == "018bcfe5-687b");
+
+	lwiot::Guid previous = lwiot::Guid::v7();
+
+	for(int idx = 0; idx < 10000; idx++) {
+		auto next = lwiot::Guid::v7();
+
+		assert(previous < next);
+		assert(next.version() == 7);
+		previous = next;
+	}
+
+	print_dbg("Ordered test passed!\n");
+}
+
 int main(int argc, char **argv)
 {
 	lwiot_init();
@@ -42,6 +99,17 @@ int main(int argc, char **argv)
 	print_dbg("Guid g5: %s\n", g5.toString().c_str());
 	assert(g2 == g5);
 
+	format_test();
+	ordered_test();
+
+#ifdef HAVE_RANDOM_BYTES
+	uint8_t r1[32], r2[32];
+
+	assert(lwiot_random_bytes(r1, sizeof(r1)) == -EOK);
+	assert(lwiot_random_bytes(r2, sizeof(r2)) == -EOK);
+	assert(memcmp(r1, r2, sizeof(r1)) != 0);
+#endif
+
 	lwiot_destroy();
 	wait_close();
 
@@ -0,0 +1,153 @@
+/*
+ * Heap hook and accounting unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+#include <lwiot/heap.h>
+#include <lwiot/error.h>
+
+#include <lwiot/stl/vector.h>
+
+static size_t external_allocs;
+
+static void *external_alloc(void *ctx, size_t size)
+{
+	auto count = static_cast<size_t*>(ctx);
+
+	*count += 1;
+	return malloc(size);
+}
+
+static void external_free(void *ctx, void *ptr)
+{
+	auto count = static_cast<size_t*>(ctx);
+
+	*count -= 1;
+	free(ptr);
+}
+
+static void accounting_test()
+{
+	lwiot_heap_stats stats{};
+	void *a, *b;
+
+	assert(lwiot_heap_statistics(LWIOT_HEAP_TAG_MQTT, &stats) == -EOK);
+	assert(stats.current == 0 && stats.peak == 0);
+
+	a = lwiot_heap_alloc(100, LWIOT_HEAP_TAG_MQTT);
+	b = lwiot_heap_zalloc(50, LWIOT_HEAP_TAG_MQTT);
+	assert(a && b);
+	assert(((uintptr_t) a % alignof(max_align_t)) == 0);
+	assert(((uint8_t*) b)[49] == 0);
+
+	lwiot_heap_statistics(LWIOT_HEAP_TAG_MQTT, &stats);
+	assert(stats.current == 150);
+	assert(stats.peak == 150);
+	assert(stats.allocations == 2);
+
+	memset(a, 0xAB, 100);
+	a = lwiot_heap_realloc(a, 200);
+	assert(((uint8_t*) a)[99] == 0xAB);
+
+	lwiot_heap_statistics(LWIOT_HEAP_TAG_MQTT, &stats);
+	assert(stats.current == 250);
+
+	lwiot_heap_free(a);
+	lwiot_heap_free(b);
+
+	lwiot_heap_statistics(LWIOT_HEAP_TAG_MQTT, &stats);
+	assert(stats.current == 0);
+	assert(stats.peak == 250);
+	assert(stats.allocations == 0);
+
+	lwiot_heap_reset_peak(LWIOT_HEAP_TAG_MQTT);
+	lwiot_heap_statistics(LWIOT_HEAP_TAG_MQTT, &stats);
+	assert(stats.peak == 0);
+
+	assert(lwiot_heap_alloc(10, LWIOT_HEAP_TAG_MAX) == nullptr);
+	assert(lwiot_heap_statistics(LWIOT_HEAP_TAG_MAX, &stats) == -EINVALID);
+
+	print_dbg("Accounting test passed!\n");
+}
+
+static void stl_test()
+{
+	lwiot_heap_stats before{}, during{}, after{};
+
+	lwiot_heap_statistics(LWIOT_HEAP_TAG_STL, &before);
+
+	{
+		lwiot::stl::Vector<int> vector;
+
+		for(int idx = 0; idx < 100; idx++)
+			vector.pushback(idx);
+
+		lwiot_heap_statistics(LWIOT_HEAP_TAG_STL, &during);
+		assert(during.current >= before.current + 100 * sizeof(int));
+	}
+
+	lwiot_heap_statistics(LWIOT_HEAP_TAG_STL, &after);
+	assert(after.current == before.current);
+
+	print_dbg("STL accounting test passed!\n");
+}
+
+static void backend_test()
+{
+	lwiot_heap_backend backend{};
+	lwiot_heap_stats stats{};
+	void *ptr;
+
+	/* Without an external backend, external allocations come from the default region. */
+	ptr = lwiot_heap_alloc(64, LWIOT_HEAP_TAG_GFX | LWIOT_HEAP_EXTERNAL);
+	assert(ptr);
+	assert(external_allocs == 0);
+	lwiot_heap_free(ptr);
+
+	assert(lwiot_heap_register(LWIOT_HEAP_REGION_EXTERNAL, &backend) == -EINVALID);
+
+	backend.alloc = external_alloc;
+	backend.free = external_free;
+	backend.ctx = &external_allocs;
+	assert(lwiot_heap_register(LWIOT_HEAP_REGION_EXTERNAL, &backend) == -EOK);
+
+	ptr = lwiot_heap_alloc(1024, LWIOT_HEAP_TAG_GFX | LWIOT_HEAP_EXTERNAL);
+	assert(external_allocs == 1);
+
+	/* Without a realloc hook the block is moved, and stays in its region. */
+	ptr = lwiot_heap_realloc(ptr, 2048);
+	assert(ptr);
+	assert(external_allocs == 1);
+
+	lwiot_heap_statistics(LWIOT_HEAP_TAG_GFX, &stats);
+	assert(stats.current == 2048);
+
+	lwiot_heap_free(ptr);
+	assert(external_allocs == 0);
+
+	print_dbg("Backend test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	accounting_test();
+	stl_test();
+	backend_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -8,6 +8,9 @@
 #include <stdlib.h>
 #include <lwiot.h>
 
+#include <assert.h>
+
+#include <lwiot/io/parallelbus.h>
 #include <lwiot/hosted/hostedgpiochip.h>
 #include <ostream>
 #include <iostream>
@@ -45,6 +48,28 @@ int main(int argc, char **argv)
 	hosted.write(2, true);
 	hosted.write(1, true);
 
+	hosted.writeMask(0x0F, 0x06);
+	assert(hosted.readPort() == 0x0F);
+	hosted.writeMask(0x10, 0x06);
+	assert(hosted.readPort() == 0x19);
+	hosted.toggleMask(0x03);
+	assert(hosted.readPort() == 0x1A);
+
+	const int contiguous[] = { 2, 3, 4, 5 };
+	const int scattered[] = { 7, 1, 9 };
+	lwiot::ParallelBus nibble(hosted, contiguous, 4, 0);
+	lwiot::ParallelBus bits(hosted, scattered, 3);
+
+	nibble.begin();
+	nibble.write(0xA);
+	assert(nibble.read() == 0xA);
+	assert((hosted.readPort() & 0x3D) == 0x29);
+
+	bits.begin();
+	bits.write(0x5);
+	assert(bits.read() == 0x5);
+	assert((hosted.readPort() & 0x282) == 0x280);
+
 	std::cout << "Rendering plot.." << std::endl;
 
 	lwiot_destroy();
@@ -0,0 +1,172 @@
+/*
+ * HTTP multipart parser unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/network/httpmultipartparser.h>
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#define BOUNDARY "----lwiot1234"
+
+struct Result {
+	lwiot::String names;
+	lwiot::String files;
+	lwiot::String types;
+	lwiot::String content[4];
+	int parts;
+	int ended;
+};
+
+static void attach(lwiot::HttpMultipartParser& parser, Result& result)
+{
+	result.parts = 0;
+	result.ended = 0;
+
+	parser.onBegin([&result](const lwiot::HttpMultipartPart& part) {
+		result.names += part.name.toString() + ";";
+		result.types += part.type.toString() + ";";
+
+		if(part.file)
+			result.files += part.filename.toString() + ";";
+
+		result.parts++;
+		return true;
+	});
+
+	parser.onData([&result](const uint8_t *data, size_t length) {
+		assert(result.parts > 0 && length > 0);
+		result.content[result.parts - 1].append(lwiot::StringView(reinterpret_cast<const char*>(data), length));
+		return true;
+	});
+
+	parser.onEnd([&result]() {
+		result.ended++;
+		return true;
+	});
+}
+
+static lwiot::String body(const lwiot::String& file)
+{
+	lwiot::String text("preamble\r\n--" BOUNDARY "\r\n"
+					   "Content-Disposition: form-data; name=\"field\"\r\n"
+					   "\r\n"
+					   "value\r\n"
+					   "--" BOUNDARY "  \r\n"
+					   "Content-Disposition: form-data; name=\"firmware\"; filename=\"fw;1.bin\"\r\n"
+					   "Content-Type: application/octet-stream\r\n"
+					   "\r\n");
+
+	text += file;
+	text += "\r\n--" BOUNDARY "--\r\nepilogue";
+	return text;
+}
+
+static lwiot::String file_content(size_t length)
+{
+	lwiot::String file;
+
+	/* Includes sequences that look like the start of a delimiter. */
+	for(size_t idx = 0; file.length() < length; idx++) {
+		if(idx % 7 == 0)
+			file += "\r\n--" "----lwiot12";
+		else
+			file += static_cast<char>('a' + idx % 26);
+	}
+
+	return file;
+}
+
+static void multipart_chunk_test()
+{
+	auto file = file_content(5000);
+	auto text = body(file);
+
+	const size_t chunks[] = { 1, 3, 17, 256, 1460, 10000 };
+
+	for(auto chunk : chunks) {
+		lwiot::HttpMultipartParser parser(BOUNDARY, 512);
+		Result result;
+		size_t idx = 0;
+
+		attach(parser, result);
+
+		while(idx < text.length()) {
+			auto num = text.length() - idx < chunk ? text.length() - idx : chunk;
+
+			assert(parser.feed(text.c_str() + idx, num) == num);
+			idx += num;
+		}
+
+		assert(parser.done());
+		assert(!parser.failed());
+		assert(result.parts == 2);
+		assert(result.ended == 2);
+		assert(result.names == "field;firmware;");
+		assert(result.files == "fw;1.bin;");
+		assert(result.types == ";application/octet-stream;");
+		assert(result.content[0] == "value");
+		assert(result.content[1] == file);
+	}
+}
+
+static void multipart_error_test()
+{
+	lwiot::HttpMultipartParser invalid("");
+	assert(invalid.failed());
+
+	lwiot::HttpMultipartParser parser(BOUNDARY, 128);
+	Result result;
+	lwiot::String headers("--" BOUNDARY "\r\nContent-Disposition: form-data; name=\"");
+
+	attach(parser, result);
+
+	/* Part headers that do not fit in the buffer. */
+	while(headers.length() < 256)
+		headers += "x";
+
+	parser.feed(headers.c_str(), headers.length());
+	assert(parser.failed());
+	assert(!parser.done());
+
+	lwiot::HttpMultipartParser garbage(BOUNDARY);
+	lwiot::String text("--" BOUNDARY "xx\r\n\r\n");
+	garbage.feed(text.c_str(), text.length());
+	assert(garbage.failed());
+
+	/* A handler can stop the parser. */
+	lwiot::HttpMultipartParser stopped(BOUNDARY);
+	text = body("data");
+	stopped.onData([](const uint8_t *data, size_t length) {
+		UNUSED(data);
+		UNUSED(length);
+		return false;
+	});
+
+	stopped.feed(text.c_str(), text.length());
+	assert(stopped.failed());
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	multipart_chunk_test();
+	multipart_error_test();
+	print_dbg("HTTP multipart parser test done!\n");
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
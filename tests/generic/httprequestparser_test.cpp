@@ -0,0 +1,174 @@
+/*
+ * HTTP request parser unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/network/httprequestparser.h>
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+static const char request[] = "GET /api/sensor?id=4&name=a%20b HTTP/1.1\r\n"
+							  "Host: localhost\r\n"
+							  "Content-Length:  5 \r\n"
+							  "X-Empty:\r\n"
+							  "\r\n"
+							  "hello";
+
+static void parser_fragment_test()
+{
+	lwiot::HttpRequestParser parser;
+	size_t length = strlen(request);
+	size_t idx = 0;
+
+	/* Feed the request one byte at a time; the body must be left alone. */
+	while(idx < length && !parser.done()) {
+		assert(parser.feed(request + idx, 1) == 1);
+		idx++;
+	}
+
+	assert(parser.done());
+	assert(!parser.failed());
+	assert(lwiot::StringView(request + idx) == "hello");
+	assert(parser.feed("more", 4) == 0);
+
+	assert(parser.method() == "GET");
+	assert(parser.target() == "/api/sensor?id=4&name=a%20b");
+	assert(parser.path() == "/api/sensor");
+	assert(parser.query() == "id=4&name=a%20b");
+	assert(parser.version() == 1);
+
+	assert(parser.headers() == 3);
+	assert(parser.headerName(0) == "Host");
+	assert(parser.headerValue(1) == "5");
+	assert(parser.header("content-length") == "5");
+	assert(parser.header("X-Empty").empty());
+	assert(parser.header("Accept").empty());
+	assert(parser.headerName(3).empty());
+}
+
+static void parser_bulk_test()
+{
+	lwiot::HttpRequestParser parser;
+	size_t length = strlen(request);
+
+	assert(parser.feed(request, length) == length - 5);
+	assert(parser.done());
+
+	parser.reset();
+	assert(!parser.started());
+	assert(!parser.done());
+	assert(parser.headers() == 0);
+
+	/* Leading empty lines and bare line feeds are accepted. */
+	const char bare[] = "\r\nPOST / HTTP/1.0\nHost: x\n\n";
+	assert(parser.feed(bare, sizeof(bare) - 1) == sizeof(bare) - 1);
+	assert(parser.done());
+	assert(parser.method() == "POST");
+	assert(parser.path() == "/");
+	assert(parser.query().empty());
+	assert(parser.version() == 0);
+	assert(parser.header("host") == "x");
+}
+
+static void parser_failure_test()
+{
+	const char *invalid[] = {
+		"GET /\r\n\r\n",
+		"GET / HTTP/2.0\r\n\r\n",
+		"G(T / HTTP/1.1\r\n\r\n",
+		"GET / HTTP/1.1\r\nNo colon\r\n\r\n",
+		"GET / HTTP/1.1\r\nHost: a\r\n folded\r\n\r\n",
+		"GET / HTTP/1.1\r\n: empty\r\n\r\n",
+	};
+
+	for(auto text : invalid) {
+		lwiot::HttpRequestParser parser;
+
+		parser.feed(text, strlen(text));
+		assert(parser.failed());
+		assert(!parser.done());
+	}
+
+	lwiot::HttpRequestParser small(32);
+	auto consumed = small.feed(request, strlen(request));
+
+	assert(consumed == 32);
+	assert(small.failed());
+}
+
+static void parser_header_id_test()
+{
+	const char head[] = "GET / HTTP/1.1\r\nhost: a\r\nX-Custom: 1\r\nHOST: b\r\nsec-websocket-KEY: k\r\n\r\n";
+	lwiot::HttpRequestParser parser;
+
+	for(size_t idx = 0; idx < lwiot::http::HeaderCount; idx++) {
+		auto id = static_cast<lwiot::http::Header>(idx);
+		auto name = lwiot::http::name(id);
+		lwiot::String lower(name.toString());
+
+		lower.toLowerCase();
+		assert(lwiot::http::lookup(name) == id);
+		assert(lwiot::http::lookup(lower) == id);
+	}
+
+	assert(lwiot::http::lookup("X-Custom") == lwiot::http::Header::Unknown);
+	assert(lwiot::http::lookup("") == lwiot::http::Header::Unknown);
+	assert(lwiot::http::lookup("Hos") == lwiot::http::Header::Unknown);
+
+	parser.feed(head, strlen(head));
+	assert(parser.done());
+	assert(parser.headerId(0) == lwiot::http::Header::Host);
+	assert(parser.headerId(1) == lwiot::http::Header::Unknown);
+	assert(parser.headerId(3) == lwiot::http::Header::SecWebSocketKey);
+
+	/* The first of repeated headers is found, as before. */
+	assert(parser.header(lwiot::http::Header::Host) == "a");
+	assert(parser.header("Host") == "a");
+	assert(parser.header("x-custom") == "1");
+	assert(parser.header("Sec-WebSocket-Key") == "k");
+	assert(parser.header(lwiot::http::Header::Range).empty());
+
+	parser.reset();
+	assert(parser.header(lwiot::http::Header::Host).empty());
+}
+
+static void parser_decode_test()
+{
+	assert(lwiot::HttpRequestParser::decode("a%20b+c") == "a b c");
+	assert(lwiot::HttpRequestParser::decode("100%") == "100%");
+	assert(lwiot::HttpRequestParser::decode("%zz%4A") == "%zzJ");
+	assert(lwiot::HttpRequestParser::decode("").length() == 0);
+
+	assert(lwiot::HttpRequestParser::decodedEquals("a%20b", "a b"));
+	assert(lwiot::HttpRequestParser::decodedEquals("name", "name"));
+	assert(!lwiot::HttpRequestParser::decodedEquals("a%20b", "a b c"));
+	assert(!lwiot::HttpRequestParser::decodedEquals("a%20bc", "a b"));
+	assert(!lwiot::HttpRequestParser::decodedEquals("a+b", "a+b"));
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	parser_fragment_test();
+	parser_bulk_test();
+	parser_failure_test();
+	parser_header_id_test();
+	parser_decode_test();
+	print_dbg("HTTP request parser test done!\n");
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
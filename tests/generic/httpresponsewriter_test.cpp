@@ -0,0 +1,151 @@
+/*
+ * HTTP response writer unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/network/tcpclient.h>
+#include <lwiot/network/httpresponsewriter.h>
+
+class CaptureClient : public lwiot::TcpClient {
+public:
+	explicit CaptureClient() : TcpClient(), writes(0)
+	{
+	}
+
+	explicit operator bool() const override
+	{
+		return true;
+	}
+
+	bool connected() const override
+	{
+		return true;
+	}
+
+	size_t available() const override
+	{
+		return 0;
+	}
+
+	using TcpClient::read;
+	using TcpClient::write;
+
+	ssize_t read(void *output, const size_t& length) override
+	{
+		return -1;
+	}
+
+	ssize_t write(const void *bytes, const size_t& length) override
+	{
+		auto data = static_cast<const char *>(bytes);
+
+		for(size_t idx = 0; idx < length; idx++)
+			this->output += data[idx];
+
+		this->writes++;
+		return length;
+	}
+
+	bool connect(const lwiot::IPAddress& addr, uint16_t port) override
+	{
+		return true;
+	}
+
+	bool connect(const lwiot::String& host, uint16_t port) override
+	{
+		return true;
+	}
+
+	void close() override
+	{
+	}
+
+	lwiot::String output;
+	int writes;
+
+protected:
+	ssize_t receive(void *output, size_t length) override
+	{
+		return -1;
+	}
+};
+
+static void response_head_test()
+{
+	lwiot::HttpResponseWriter writer(64);
+	CaptureClient client;
+
+	/* Headers may be added before the status is known. */
+	writer.header("Content-Length", static_cast<size_t>(4));
+	writer.append(lwiot::http::ConnectionClose);
+	writer.header("Content-Type", "text/plain", true);
+	writer.begin(1, 404);
+
+	assert(writer.send(client, "body", 4) > 0);
+	assert(client.output == "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 4\r\n"
+	                        "Connection: close\r\n\r\nbody");
+	assert(client.writes == 2);
+	assert(writer.empty());
+
+	/* HTTP/1.0 and codes without a reason phrase. */
+	client.output = "";
+	writer.begin(0, 299);
+	writer.send(client);
+	assert(client.output == "HTTP/1.0 299 \r\n\r\n");
+
+	/* The buffer grows for long headers. */
+	lwiot::String value;
+
+	for(int idx = 0; idx < 200; idx++)
+		value += 'x';
+
+	client.output = "";
+	writer.header("X-Long", value);
+	writer.header("Server", "lwIoT", true);
+	writer.begin(1, 200);
+	writer.send(client);
+	assert(client.output == lwiot::String("HTTP/1.1 200 OK\r\nServer: lwIoT\r\nX-Long: ") + value + "\r\n\r\n");
+
+	/* Cleared heads do not leak into the next response. */
+	client.output = "";
+	writer.header("X-Dropped", "1");
+	writer.clear();
+	writer.begin(1, 204);
+	writer.send(client);
+	assert(client.output == "HTTP/1.1 204 No Content\r\n\r\n");
+}
+
+static void reason_test()
+{
+	assert(lwiot::HttpResponseWriter::reason(100) == "Continue");
+	assert(lwiot::HttpResponseWriter::reason(206) == "Partial Content");
+	assert(lwiot::HttpResponseWriter::reason(505) == "HTTP Version not supported");
+	assert(lwiot::HttpResponseWriter::reason(299).empty());
+
+	print_dbg("HTTP response writer test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	response_head_test();
+	reason_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
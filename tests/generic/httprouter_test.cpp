@@ -0,0 +1,111 @@
+/*
+ * HTTP router unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/network/httprouter.h>
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+static lwiot::RequestHandler root, index_get, sensor, sensor_put, sensor_all, sensor_value, files, any;
+
+static void router_literal_test()
+{
+	lwiot::HttpRouter router;
+	lwiot::HttpPathArgs args;
+
+	assert(router.empty());
+	assert(router.add("/", lwiot::HTTP_ANY, &root));
+	assert(router.add("/index.html", lwiot::HTTP_GET, &index_get));
+	assert(!router.add("/index.html", lwiot::HTTP_GET, &any));
+	assert(!router.empty());
+
+	assert(router.match(lwiot::HTTP_GET, "/", args) == &root);
+	assert(router.match(lwiot::HTTP_POST, "/", args) == &root);
+	assert(router.match(lwiot::HTTP_GET, "/index.html", args) == &index_get);
+	assert(router.match(lwiot::HTTP_POST, "/index.html", args) == nullptr);
+	assert(router.match(lwiot::HTTP_GET, "/index.html/", args) == nullptr);
+	assert(router.match(lwiot::HTTP_GET, "/index", args) == nullptr);
+	assert(router.match(lwiot::HTTP_GET, "", args) == nullptr);
+	assert(args.count == 0);
+
+	router.clear();
+	assert(router.empty());
+	assert(router.match(lwiot::HTTP_GET, "/", args) == nullptr);
+}
+
+static void router_param_test()
+{
+	lwiot::HttpRouter router;
+	lwiot::HttpPathArgs args;
+
+	assert(router.add("/api/sensor/{id}", lwiot::HTTP_GET, &sensor));
+	assert(router.add("/api/sensor/{id}", lwiot::HTTP_PUT, &sensor_put));
+	assert(router.add("/api/sensor/all", lwiot::HTTP_GET, &sensor_all));
+	assert(router.add("/api/sensor/{id}/{field}", lwiot::HTTP_ANY, &sensor_value));
+
+	assert(router.match(lwiot::HTTP_GET, "/api/sensor/all", args) == &sensor_all);
+	assert(args.count == 0);
+
+	assert(router.match(lwiot::HTTP_GET, "/api/sensor/42", args) == &sensor);
+	assert(args.count == 1);
+	assert(args.values[0] == "42");
+	assert((*args.names)[0] == "id");
+
+	assert(router.match(lwiot::HTTP_PUT, "/api/sensor/42", args) == &sensor_put);
+	assert(router.match(lwiot::HTTP_DELETE, "/api/sensor/42", args) == nullptr);
+
+	/* The literal does not match the deeper route, the parameter does. */
+	assert(router.match(lwiot::HTTP_GET, "/api/sensor/all/value", args) == &sensor_value);
+	assert(args.count == 2);
+	assert(args.values[0] == "all");
+	assert(args.values[1] == "value");
+	assert((*args.names)[1] == "field");
+}
+
+static void router_wildcard_test()
+{
+	lwiot::HttpRouter router;
+	lwiot::HttpPathArgs args;
+
+	assert(router.add("/static/*", lwiot::HTTP_GET, &files));
+	assert(router.add("/static/index.html", lwiot::HTTP_GET, &index_get));
+	assert(router.add("/{any}", lwiot::HTTP_GET, &any));
+
+	assert(router.match(lwiot::HTTP_GET, "/static/index.html", args) == &index_get);
+	assert(router.match(lwiot::HTTP_GET, "/static/css/main.css", args) == &files);
+	assert(args.count == 1);
+	assert(args.values[0] == "css/main.css");
+	assert((*args.names)[0] == "*");
+
+	assert(router.match(lwiot::HTTP_GET, "/static/", args) == &files);
+	assert(args.values[0].empty());
+
+	assert(router.match(lwiot::HTTP_GET, "/static", args) == &any);
+	assert(args.values[0] == "static");
+	assert(router.match(lwiot::HTTP_POST, "/static/a", args) == nullptr);
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	router_literal_test();
+	router_param_test();
+	router_wildcard_test();
+	print_dbg("HTTP router test done!\n");
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,282 @@
+/*
+ * I2C simulator and device model test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/io/i2cbus.h>
+#include <lwiot/io/i2cmessage.h>
+#include <lwiot/device/bmp280sensor.h>
+#include <lwiot/device/sht31sensor.h>
+#include <lwiot/device/ccs811sensor.h>
+#include <lwiot/device/eeprom24c02.h>
+#include <lwiot/device/ssd1306display.h>
+#include <lwiot/hosted/i2csimulator.h>
+#include <lwiot/hosted/i2cdevicemodels.h>
+
+using lwiot::hosted::I2CSimulator;
+
+static void test_bus_timing()
+{
+	auto sim = new I2CSimulator(100000);
+	lwiot::hosted::Eeprom24C02Model eeprom;
+	lwiot::I2CBus bus(sim);
+	lwiot::I2CMessage msg(2);
+
+	sim->attach(eeprom);
+
+	msg.setAddress(0x50, false, false);
+	msg.write(0x10);
+	msg.write(0xAB);
+	assert(bus.transfer(msg));
+
+	/* Start, address, 2 data bytes and stop: 29 bits at 10 us. */
+	auto stats = sim->statistics();
+	assert(stats.transfers == 1);
+	assert(stats.messages == 1);
+	assert(stats.bytes == 2);
+	assert(stats.busy == 290000);
+	assert(sim->duration(2) + 10000 == stats.busy);
+
+	/* The page write is in progress, and nobody is at 0x51. */
+	assert(!bus.transfer(msg));
+	msg.setAddress(0x51, false, false);
+	assert(!bus.transfer(msg));
+	assert(sim->statistics().nacks == 2);
+	assert(eeprom.peek(0x10) == 0xAB);
+
+	print_dbg("Bus timing test passed!\n");
+}
+
+static void test_bmp280()
+{
+	auto sim = new I2CSimulator(400000);
+	lwiot::hosted::Bmp280Model model;
+	lwiot::I2CBus bus(sim);
+	lwiot::Bmp280Sensor sensor(bus);
+	int32_t pressure;
+	float temperature;
+
+	sim->attach(model);
+	sensor.begin();
+
+	/* Normal mode with x16 pressure oversampling converts in 35.5 ms. */
+	lwiot_sleep(40);
+	sensor.read(pressure, temperature);
+
+	assert(model.conversions() >= 1);
+	assert(sensor.temperatureCentiCelsius() == 2508);
+	assert(pressure >= 100653 && pressure <= 100654);
+	print_dbg("BMP280 test passed: %d Pa\n", pressure);
+}
+
+static void test_sht31()
+{
+	auto sim = new I2CSimulator(400000);
+	lwiot::hosted::Sht31Model model;
+	lwiot::I2CBus bus(sim);
+	lwiot::Sht31Sensor sensor(bus);
+	lwiot::I2CMessage cmd(2), rx(6);
+
+	sim->attach(model);
+	model.setTemperature(21.5);
+	model.setHumidity(40.0);
+
+	assert(sensor.begin());
+	assert(sensor.sample());
+	assert(sensor.temperatureMilliCelsius() > 21490 && sensor.temperatureMilliCelsius() < 21510);
+	assert(sensor.humidityMilliPercent() > 39990 && sensor.humidityMilliPercent() < 40010);
+
+	/* Without clock stretching the result is not acknowledged until it is ready. */
+	cmd.setAddress(0x44, false, false);
+	cmd.write(0x24);
+	cmd.write(0x00);
+	rx.setAddress(0x44, false, true);
+
+	assert(bus.transfer(cmd));
+	assert(!bus.transfer(rx));
+
+	/* With clock stretching the read waits for the result on the bus. */
+	cmd.setIndex(0);
+	cmd.write(0x2C);
+	cmd.write(0x06);
+	lwiot_sleep(20);
+
+	auto before = sim->statistics().busy;
+	assert(bus.transfer(cmd));
+	rx.setIndex(0);
+	assert(bus.transfer(rx));
+	assert(sim->statistics().busy - before > 14000000);
+	assert(model.measurements() == 3);
+
+	sensor.setHeaterStatus(true);
+	assert(model.heater());
+	print_dbg("SHT31 test passed!\n");
+}
+
+static void test_ccs811()
+{
+	auto sim = new I2CSimulator(100000);
+	lwiot::hosted::Ccs811Model model;
+	lwiot::I2CBus bus(sim);
+	lwiot::Ccs811Sensor sensor(bus);
+
+	sim->attach(model);
+	model.setResult(612, 33);
+
+	assert(!model.application());
+	assert(sensor.begin());
+	assert(model.application());
+	assert(model.driveMode() == 1);
+
+	sensor.setDriveMode(4);
+	assert(sensor.sample());
+	assert(sensor.eco2() == 612);
+	assert(sensor.tvoc() == 33);
+	assert(!sensor.available());
+
+	auto temperature = sensor.calculateTemperature();
+	assert(temperature > 24.9 && temperature < 25.1);
+	print_dbg("CCS811 test passed!\n");
+}
+
+static void test_eeprom()
+{
+	auto sim = new I2CSimulator(400000);
+	lwiot::hosted::Eeprom24C02Model model;
+	lwiot::I2CBus bus(sim);
+	uint8_t data[20], readback[20];
+
+	sim->attach(model);
+
+	/* Page writes wrap around within the page, so the last bytes overwrite the first ones. */
+	lwiot::I2CMessage msg(11);
+	msg.setAddress(0x50, false, false);
+	msg.write(0x06);
+
+	for(uint8_t idx = 0; idx < 10; idx++)
+		msg.write(idx);
+
+	assert(bus.transfer(msg));
+	assert(model.peek(0x06) == 8 && model.peek(0x07) == 9);
+	assert(model.peek(0x00) == 2 && model.peek(0x05) == 7);
+	assert(model.peek(0x08) == 0xFF);
+	assert(model.writeCycles() == 1);
+
+	lwiot_sleep(6);
+
+	{
+		lwiot::Eeprom24C02 eeprom(bus);
+
+		for(size_t idx = 0; idx < sizeof(data); idx++)
+			data[idx] = static_cast<uint8_t>(idx * 3 + 1);
+
+		assert(eeprom.write(0x25, data, sizeof(data)) == sizeof(data));
+		assert(eeprom.flush());
+		assert(eeprom.read(0x25, readback, sizeof(readback)) == sizeof(readback));
+		assert(memcmp(data, readback, sizeof(data)) == 0);
+	}
+
+	for(size_t idx = 0; idx < sizeof(data); idx++)
+		assert(model.peek(0x25 + idx) == data[idx]);
+
+	print_dbg("24C02 test passed!\n");
+}
+
+static void test_ssd1306()
+{
+	auto sim = new I2CSimulator(400000);
+	lwiot::hosted::Ssd1306Model model;
+	lwiot::I2CBus bus(sim);
+	lwiot::Ssd1306Display display(bus);
+
+	sim->attach(model);
+	display.begin();
+	assert(model.on());
+
+	display.clear();
+	display.drawPixel(10, 20, WHITE);
+	display.display();
+
+	assert(model.dataWritten() == SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8);
+	assert(model.pixel(10, 20));
+	assert(!model.pixel(11, 20));
+
+	auto full = sim->statistics().busy;
+
+	/* A single changed pixel is sent as a single byte. */
+	sim->resetStatistics();
+	display.drawPixel(100, 60, WHITE);
+	display.display();
+
+	assert(model.dataWritten() == SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8 + 1);
+	assert(model.pixel(100, 60));
+	assert(model.pixel(10, 20));
+	assert(sim->statistics().busy * 50 < full);
+
+	display.invert(true);
+	assert(model.inverted());
+	print_dbg("SSD1306 test passed: full frame %llu us\n", static_cast<unsigned long long>(full / 1000));
+}
+
+/* Bus time only depends on the traffic, not on the host. */
+static uint64_t run_workload()
+{
+	auto sim = new I2CSimulator(400000);
+	lwiot::hosted::Bmp280Model bmp;
+	lwiot::hosted::Ssd1306Model oled;
+	lwiot::I2CBus bus(sim);
+	lwiot::Bmp280Sensor sensor(bus);
+	lwiot::Ssd1306Display display(bus);
+
+	sim->attach(bmp);
+	sim->attach(oled);
+
+	sensor.begin();
+	display.begin();
+
+	for(int idx = 0; idx < 8; idx++) {
+		display.fillRect(idx * 8, 0, 8, 8, WHITE);
+		display.display();
+	}
+
+	return sim->statistics().busy;
+}
+
+static void test_determinism()
+{
+	auto first = run_workload();
+	auto second = run_workload();
+
+	assert(first > 0);
+	assert(first == second);
+	print_dbg("Determinism test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	test_bus_timing();
+	test_bmp280();
+	test_sht31();
+	test_ccs811();
+	test_eeprom();
+	test_ssd1306();
+	test_determinism();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+/*
+ * Intrusive list unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/intrusivelist.h>
+
+struct Item {
+	explicit Item(int v) : value(v)
+	{
+	}
+
+	lwiot::String name;
+	int value;
+	lwiot::stl::IntrusiveListHook hook;
+	lwiot::stl::IntrusiveListHook other;
+};
+
+typedef lwiot::stl::IntrusiveList<Item, &Item::hook> ItemList;
+typedef lwiot::stl::IntrusiveList<Item, &Item::other> OtherList;
+
+static void intrusivelist_test()
+{
+	Item a(1), b(2), c(3), d(4);
+	ItemList list;
+	OtherList other;
+
+	list.push_back(b);
+	list.push_back(c);
+	list.push_front(a);
+	assert(list.size() == 3);
+	assert(list.front().value == 1);
+	assert(list.back().value == 3);
+
+	auto iter = list.begin();
+	++iter;
+	list.insert(iter, d);
+
+	int expected[] = { 1, 4, 2, 3 };
+	int idx = 0;
+
+	for(auto& item : list)
+		assert(item.value == expected[idx++]);
+
+	other.push_back(c);
+	other.push_back(a);
+	assert(other.front().value == 3);
+
+	list.remove(d);
+	assert(!d.hook.linked());
+	assert(list.size() == 3);
+
+	Item copy(a);
+	assert(!copy.hook.linked());
+
+	iter = list.erase(list.begin());
+	assert(iter->value == 2);
+	assert(list.size() == 2);
+	assert(other.size() == 2);
+
+	const ItemList& clist = list;
+	int sum = 0;
+	for(auto& item : clist)
+		sum += item.value;
+	assert(sum == 5);
+
+	list.clear();
+	other.clear();
+	assert(list.empty());
+	assert(!c.hook.linked() && !c.other.linked());
+
+	print_dbg("Intrusive list test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	intrusivelist_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -7,6 +7,8 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <assert.h>
 #include <lwiot.h>
 
 #ifdef WIN32
@@ -18,6 +20,82 @@
 #include <lwiot/log.h>
 #include <lwiot/test.h>
 #include <lwiot/network/ipaddress.h>
+#include <lwiot/stl/unorderedmap.h>
+
+static void test_parse()
+{
+	const char *valid[] = {
+		"0.0.0.0", "255.255.255.255", "10.0.1.200", "::", "::1", "1::", "fe80::1", "2001:db8::ff00:42:8329",
+		"2001:db8:0:0:1::1", "1:2:3:4:5:6:7:8", "::ffff:192.0.2.1", "64:ff9b::10.0.0.1"
+	};
+	const char *invalid[] = {
+		"", "1.2.3", "1.2.3.4.5", "256.1.1.1", "01.2.3.4", "1..2.3", "1.2.3.4 ", "a.b.c.d", ":", ":::",
+		"1:2:3:4:5:6:7:8:9", "1::2::3", "12345::", "::1:2:3:4:5:6:7:8", "1:2:3:4:5:6:7:8::", "1:",
+		":1", "::ffff:1.2.3", "1:2:3:4:5:6:7:1.2.3.4", "fe80::1%eth0", "g::"
+	};
+	char buffer[lwiot::IPAddress::MaxStringLength];
+
+	for(auto str : valid) {
+		lwiot::IPAddress addr;
+		uint8_t expected[16];
+
+		assert(lwiot::IPAddress::parse(str, addr));
+		assert(inet_pton(addr.isIPv6() ? AF_INET6 : AF_INET, str, expected) == 1);
+		assert(memcmp(&addr[0], expected, addr.isIPv6() ? 16 : 4) == 0);
+
+		/* The text form parses back to the same address. */
+		lwiot::IPAddress copy;
+		auto length = addr.formatTo(buffer, sizeof(buffer));
+
+		assert(length == strlen(buffer));
+		assert(lwiot::IPAddress::parse(lwiot::StringView(buffer, length), copy));
+		assert(copy == addr);
+		assert(lwiot::stl::Hash<lwiot::IPAddress>()(copy) == lwiot::stl::Hash<lwiot::IPAddress>()(addr));
+	}
+
+	for(auto str : invalid) {
+		lwiot::IPAddress addr(1, 2, 3, 4);
+
+		assert(!lwiot::IPAddress::parse(str, addr));
+		assert(addr == lwiot::IPAddress(1, 2, 3, 4));
+	}
+
+	assert(lwiot::IPAddress::fromString("2001:db8::1").toString() == "2001:db8::1");
+	assert(lwiot::IPAddress::fromString("1.2.3.256") == lwiot::IPAddress());
+
+	/* Buffers that are too small are left alone. */
+	lwiot::IPAddress(192, 168, 100, 200).formatTo(buffer, sizeof(buffer));
+	assert(strcmp(buffer, "192.168.100.200") == 0);
+	assert(lwiot::IPAddress(192, 168, 100, 200).formatTo(buffer, 15) == 0);
+	assert(strcmp(buffer, "192.168.100.200") == 0);
+	assert(lwiot::IPAddress(0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF)
+		       .formatTo(buffer, sizeof(buffer)) == 39);
+
+	print_dbg("IP address parse test done!\n");
+}
+
+static void test_map()
+{
+	constexpr lwiot::IPAddress gateway(192, 168, 1, 1);
+	constexpr lwiot::IPAddress loopback(0, 0, 0, 0, 0, 0, 0, 1);
+	lwiot::stl::UnorderedMap<lwiot::IPAddress, int> peers;
+
+	peers.add(gateway, 1);
+	peers.add(loopback, 2);
+
+	for(int idx = 0; idx < 100; idx++)
+		peers.add(lwiot::IPAddress(10, 0, 0, static_cast<uint8_t>(idx)), idx + 3);
+
+	assert(peers.size() == 102);
+	assert(peers.at(lwiot::IPAddress::fromString("192.168.1.1")) == 1);
+	assert(peers.at(lwiot::IPAddress::fromString("::1")) == 2);
+	assert(peers.at(lwiot::IPAddress(10, 0, 0, 42)) == 45);
+
+	/* The same bytes as another version are a different address. */
+	assert(peers.find(lwiot::IPAddress(0xC0A8, 0x0101, 0, 0, 0, 0, 0, 0)) == peers.end());
+
+	print_dbg("IP address map test done!\n");
+}
 
 int main(int argc, char **argv)
 {
@@ -32,6 +110,31 @@ int main(int argc, char **argv)
 	print_dbg("Address 2: %s\n", addr2.toString().c_str());
 	print_dbg("Address 3: %s\n", addr3.toString().c_str());
 
+	remote_addr_t remote;
+	uint8_t ip6[16] = {0xfe,0x80,0,0,0,0,0,0,0,0,0,0,0,0,0,1};
+
+	memcpy(remote.addr.ip6_addr.ip, ip6, sizeof(ip6));
+	remote.version = 6;
+
+	lwiot::IPAddress addr4(remote);
+	assert(addr4.isIPv6());
+	assert(addr4.toString() == "fe80::1");
+
+	auto addr5 = lwiot::IPAddress::fromBindAddress(BIND6_ADDR_LB);
+	assert(addr5.isIPv6());
+	assert(addr5.toString() == "::1");
+	assert(lwiot::IPAddress::fromBindAddress(BIND6_ADDR_ANY).toString() == "::");
+
+	ip6[15] = 0;
+	ip6[1] = 0x81;
+	ip6[6] = 0x12;
+	memcpy(remote.addr.ip6_addr.ip, ip6, sizeof(ip6));
+	assert(lwiot::IPAddress(remote).toString() == "fe81:0:0:1200::");
+	print_dbg("Address 4: %s\n", addr4.toString().c_str());
+
+	test_parse();
+	test_map();
+
 	wait_close();
 	lwiot_destroy();
 	return -EXIT_SUCCESS;
@@ -7,15 +7,94 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <assert.h>
 #include <lwiot.h>
+#include <lwiot/log.h>
 
+#include <lwiot/ringbufferstream.h>
 #include <lwiot/util/json.h>
 #include <lwiot/stl/string.h>
 #include <lwiot/test.h>
 
+static void json_scan_test()
+{
+	lwiot::DynamicJsonBuffer jbuffer;
+
+	/* Strings and runs of white space longer than a block, escapes on block edges. */
+	char json[] = "{\n"
+		"                                    \"long\" : \"abcdefghijklmnopqrstuvwxyz0123456789\",\n"
+		"\t\t\"escaped\":\"0123456789abcd\\\"q\\\\\\nend\", /* comment */\n"
+		"\t\t'single' : 'it\\'s \"quoted\"', // comment\n"
+		"\r\n\t\"list\" : [ \"\" ,\"x\"   ,   1 ]\n"
+		"}";
+
+	lwiot::JsonObject& root = jbuffer.parseObject(json);
+	assert(root.success());
+
+	const char *value = root["long"];
+	assert(strcmp(value, "abcdefghijklmnopqrstuvwxyz0123456789") == 0);
+	value = root["escaped"];
+	assert(strcmp(value, "0123456789abcd\"q\\\nend") == 0);
+	value = root["single"];
+	assert(strcmp(value, "it's \"quoted\"") == 0);
+
+	assert(root["list"].size() == 3);
+	value = root["list"][0];
+	assert(strcmp(value, "") == 0);
+	value = root["list"][1];
+	assert(strcmp(value, "x") == 0);
+	assert(root["list"][2] == 1);
+
+	/* An unterminated string must not run past the end of the input. */
+	char broken[] = "{\"key\":\"abcdefghijklmnopqrstuvwxyz";
+	assert(!jbuffer.parseObject(broken).success());
+	char dangling[] = "[\"abc\\";
+	assert(!jbuffer.parseArray(dangling).success());
+
+	print_dbg("JSON scan test done!\n");
+}
+
+static void json_stream_test()
+{
+	lwiot::DynamicJsonBuffer jbuffer;
+	lwiot::RingBufferStream stream(1024);
+	lwiot::String expected;
+	char output[1024];
+
+	auto& obj = jbuffer.createObject();
+	auto& values = obj.createNestedArray("values");
+
+	obj["name"] = "a \"quoted\"\tname that is longer than the print buffer of the printer";
+
+	for(int idx = 0; idx < 40; idx++)
+		values.add(idx * 7);
+
+	obj.printTo(expected);
+	assert(obj.measureLength() == expected.length());
+
+	/* Straight to a stream, through the print buffer. */
+	assert(obj.printTo(stream) == expected.length());
+	assert(stream.available() == expected.length());
+	assert(stream.read(output, expected.length()) == static_cast<ssize_t>(expected.length()));
+	assert(memcmp(output, expected.c_str(), expected.length()) == 0);
+
+	/* Output that does not fit is reported. */
+	lwiot::RingBufferStream small(32);
+	assert(obj.printTo(small) == 0);
+
+	/* Fixed buffers are cut off. */
+	assert(obj.printTo(output, 16) == 15);
+	assert(strncmp(output, expected.c_str(), 15) == 0 && output[15] == '\0');
+
+	print_dbg("JSON stream test done!\n");
+}
 
 int main(int argc, char **argv)
 {
+	json_scan_test();
+	json_stream_test();
+
 	lwiot::DynamicJsonBuffer jbuffer;
 
 	const char json[] = "{\"sensor\":\"gps\",\"time\":1351824120,\"data\":[48.756080,2.302038]}";
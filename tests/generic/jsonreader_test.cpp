@@ -0,0 +1,161 @@
+/*
+ * Streaming JSON reader unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/ringbufferstream.h>
+#include <lwiot/util/jsonreader.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/test.h>
+
+typedef lwiot::JsonReader::Event Event;
+
+static void fill(lwiot::RingBufferStream& stream, const char *json)
+{
+	auto length = strlen(json);
+	assert(stream.write(json, length) == static_cast<ssize_t>(length));
+}
+
+static void test_events()
+{
+	lwiot::RingBufferStream stream(512);
+	lwiot::JsonReader reader(stream);
+
+	fill(stream, " {\"name\" : \"gate\\u00e9\\n\", \"on\":true, \"off\":false, \"none\":null,\n"
+		"\"list\":[1, -2.5e3, {}, []], \"nested\":{\"a\":{\"b\":\"c\"}}} trailing");
+
+	assert(reader.next() == Event::BeginObject);
+	assert(reader.depth() == 0);
+
+	assert(reader.next() == Event::String);
+	assert(reader.key() == "name");
+	assert(reader.string() == "gate\xc3\xa9\n");
+	assert(reader.matches("$.name"));
+
+	assert(reader.next() == Event::Bool && reader.boolean());
+	assert(reader.next() == Event::Bool && !reader.boolean());
+	assert(reader.next() == Event::Null);
+	assert(reader.key() == "none");
+
+	assert(reader.next() == Event::BeginArray);
+	assert(reader.key() == "list");
+	assert(reader.next() == Event::Number && reader.integer() == 1);
+	assert(reader.index() == 0 && reader.depth() == 2);
+	assert(reader.next() == Event::Number && reader.number() == -2500.0);
+	assert(reader.index() == 1);
+	assert(reader.matches("$.list[1]") && reader.matches("$.list[*]") && !reader.matches("$.list[0]"));
+	assert(reader.next() == Event::BeginObject);
+	assert(reader.next() == Event::EndObject);
+	assert(reader.next() == Event::BeginArray);
+	assert(reader.index() == 3);
+	assert(reader.next() == Event::EndArray);
+	assert(reader.next() == Event::EndArray);
+	assert(reader.matches("$.list"));
+
+	assert(reader.next() == Event::BeginObject);
+	assert(reader.skip());
+	assert(reader.key() == "nested");
+
+	assert(reader.next() == Event::EndObject);
+	assert(reader.depth() == 0);
+
+	/* Data after the document is ignored. */
+	assert(reader.next() == Event::End);
+	assert(reader.next() == Event::End);
+	assert(!reader.truncated());
+
+	print_dbg("JSON reader event test done!\n");
+}
+
+static void test_select()
+{
+	lwiot::RingBufferStream stream(4096);
+	lwiot::JsonReader reader(stream);
+	lwiot::String json("{\"version\":2,\"sensors\":[");
+	size_t count = 0;
+	const int sensors = 64;
+
+	/* A document that is much larger than the reader. */
+	for(int idx = 0; idx < sensors; idx++) {
+		char entry[64];
+
+		snprintf(entry, sizeof(entry), "%s{\"id\":\"s%d\",\"config\":{\"id\":%d,\"rate\":10}}", idx ? "," : "", idx, idx);
+		json += entry;
+	}
+
+	json += "],\"id\":\"gateway\"}";
+	fill(stream, json.c_str());
+	assert(json.length() > 4 * sizeof(reader));
+
+	auto rv = reader.select("$.sensors[*].id", [&](lwiot::JsonReader& r, Event event) {
+		char expected[16];
+
+		snprintf(expected, sizeof(expected), "s%u", static_cast<unsigned>(count));
+		assert(event == Event::String);
+		assert(r.string() == expected);
+		count++;
+		return true;
+	});
+
+	assert(rv == sensors);
+	assert(count == sensors);
+
+	print_dbg("JSON reader select test done!\n");
+}
+
+static void test_errors()
+{
+	const char *invalid[] = {
+		"", "{", "{\"a\" 1}", "[1,]", "[1 2]", "{\"a\":tru}", "[\"abc", "[\"\\x\"]", "[1.2.3]", "{1:2}",
+		"[[[[[[[[[[[[[[[[[[[[]]]]]]]]]]]]]]]]]]]]"
+	};
+
+	for(auto json : invalid) {
+		lwiot::RingBufferStream stream(64);
+		lwiot::JsonReader reader(stream);
+		Event event;
+
+		fill(stream, json);
+
+		do {
+			event = reader.next();
+		} while(event != Event::Error && event != Event::End);
+
+		assert(event == Event::Error);
+		assert(reader.next() == Event::Error);
+	}
+
+	lwiot::RingBufferStream stream(256);
+	lwiot::JsonReader reader(stream);
+
+	fill(stream, "[\"0123456789012345678901234567890123456789012345678901234567890123456789\", 1]");
+	assert(reader.select("$[*]", [](lwiot::JsonReader& r, Event event) {
+		return true;
+	}) == 2);
+	assert(reader.truncated());
+
+	print_dbg("JSON reader error test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	test_events();
+	test_select();
+	test_errors();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+/*
+ * JSON schema binding unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/ringbufferstream.h>
+#include <lwiot/util/jsonschema.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/test.h>
+
+struct Location {
+	double latitude;
+	double longitude;
+};
+
+LWIOT_JSON_SCHEMA(Location,
+	LWIOT_JSON_NAMED_FIELD(Location, latitude, "lat"),
+	LWIOT_JSON_NAMED_FIELD(Location, longitude, "lon")
+)
+
+struct Reading {
+	uint32_t id;
+	int8_t offset;
+	int64_t timestamp;
+	bool ok;
+	float value;
+	char unit[8];
+	uint16_t history[4];
+	Location location;
+};
+
+LWIOT_JSON_SCHEMA(Reading,
+	LWIOT_JSON_FIELD(Reading, id),
+	LWIOT_JSON_FIELD(Reading, offset),
+	LWIOT_JSON_FIELD(Reading, timestamp),
+	LWIOT_JSON_FIELD(Reading, ok),
+	LWIOT_JSON_FIELD(Reading, value),
+	LWIOT_JSON_FIELD(Reading, unit),
+	LWIOT_JSON_FIELD(Reading, history),
+	LWIOT_JSON_FIELD(Reading, location)
+)
+
+static void test_read()
+{
+	const char json[] = "{\"id\":4000000000, \"unknown\":{\"id\":1,\"list\":[1,2]}, \"offset\":-12,"
+		"\"timestamp\":1600000000123, \"ok\":true, \"value\":21.5, \"unit\":\"celsius!!\","
+		"\"history\":[1,2,3,4,5], \"location\":{\"lat\":52.25,\"lon\":null,\"alt\":3}}";
+	Reading reading;
+
+	memset(&reading, 0, sizeof(reading));
+	reading.location.longitude = 6.5;
+
+	assert(lwiot::readJson(json, sizeof(json) - 1, reading));
+	assert(reading.id == 4000000000U);
+	assert(reading.offset == -12);
+	assert(reading.timestamp == 1600000000123LL);
+	assert(reading.ok);
+	assert(reading.value == 21.5f);
+	assert(strcmp(reading.unit, "celsius") == 0);
+	assert(reading.history[0] == 1 && reading.history[3] == 4);
+	assert(reading.location.latitude == 52.25);
+	assert(reading.location.longitude == 6.5);
+
+	/* Values of the wrong type are rejected. */
+	const char *invalid[] = {
+		"[]", "{\"id\":\"1\"}", "{\"ok\":1}", "{\"unit\":[]}", "{\"history\":3}", "{\"location\":[1]}", "{\"id\":1"
+	};
+
+	for(auto doc : invalid)
+		assert(!lwiot::readJson(doc, strlen(doc), reading));
+
+	print_dbg("JSON schema read test done!\n");
+}
+
+static void test_roundtrip()
+{
+	lwiot::RingBufferStream stream(512);
+	lwiot::String text;
+	Reading reading, copy;
+
+	memset(&reading, 0, sizeof(reading));
+	memset(&copy, 0, sizeof(copy));
+
+	reading.id = 7;
+	reading.offset = -1;
+	reading.timestamp = -5;
+	reading.ok = false;
+	reading.value = 0.1f;
+	strcpy(reading.unit, "\"C\"\n");
+	reading.history[2] = 65535;
+	reading.location.latitude = -33.865143;
+	reading.location.longitude = 151.2099;
+
+	auto length = lwiot::writeJson(text, reading);
+	assert(length == text.length());
+	assert(text == "{\"id\":7,\"offset\":-1,\"timestamp\":-5,\"ok\":false,\"value\":0.1,\"unit\":\"\\\"C\\\"\\n\","
+		"\"history\":[0,0,65535,0],\"location\":{\"lat\":-33.865143,\"lon\":151.2099}}");
+
+	assert(lwiot::writeJson(stream, reading) == length);
+	assert(lwiot::readJson(stream, copy));
+	assert(memcmp(&reading, &copy, sizeof(reading)) == 0);
+
+	/* A full character array is written up to its end. */
+	memcpy(reading.unit, "12345678", sizeof(reading.unit));
+	text = "";
+	lwiot::writeJson(text, reading);
+	assert(text.indexOf("\"unit\":\"12345678\",") > 0);
+
+	print_dbg("JSON schema round trip test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	test_read();
+	test_roundtrip();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
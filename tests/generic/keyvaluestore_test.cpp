@@ -0,0 +1,288 @@
+/*
+ * Key-value store unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/test.h>
+
+#include <lwiot/bytebuffer.h>
+#include <lwiot/util/keyvaluestore.h>
+
+#define SECTORS 4
+#define SECTORSIZE 128
+#define STORE "kvstore_test.bin"
+
+/* Store in RAM. The memory outlives the store, to test remounting. */
+class MemoryKeyValueStore : public lwiot::KeyValueStore {
+public:
+	explicit MemoryKeyValueStore(uint8_t *memory) : KeyValueStore(SECTORS, SECTORSIZE), _memory(memory)
+	{
+	}
+
+protected:
+	bool read(size_t offset, void *data, size_t length) override
+	{
+		if(offset + length > this->storage())
+			return false;
+
+		memcpy(data, this->_memory + offset, length);
+		return true;
+	}
+
+	bool write(size_t offset, const void *data, size_t length) override
+	{
+		if(offset + length > this->storage())
+			return false;
+
+		memcpy(this->_memory + offset, data, length);
+		return true;
+	}
+
+private:
+	uint8_t *_memory;
+};
+
+static uint32_t get_u32(lwiot::KeyValueStore& store, const char *key)
+{
+	uint32_t value = 0;
+
+	assert(store.get(key, &value, sizeof(value)) == sizeof(value));
+	return value;
+}
+
+static void kvstore_basic_test()
+{
+	uint8_t memory[SECTORS * SECTORSIZE] = {};
+	MemoryKeyValueStore store(memory);
+	lwiot::ByteBuffer value;
+	uint32_t counter = 5;
+	char text[16];
+
+	assert(store.size() == 0);
+	assert(store.get("ssid", text, sizeof(text)) == -ENOTFOUND);
+	assert(!store.remove("ssid"));
+	assert(!store.set("", &counter, sizeof(counter)));
+
+	assert(store.set("ssid", "lwiot", 5));
+	assert(store.set("counter", &counter, sizeof(counter)));
+	assert(store.size() == 2);
+
+	assert(store.get("ssid", text, sizeof(text)) == 5);
+	assert(memcmp(text, "lwiot", 5) == 0);
+	assert(store.get("ssid", text, 2) == 5);
+
+	assert(store.get("ssid", value));
+	assert(value.index() == 5);
+	assert(memcmp(value.data(), "lwiot", 5) == 0);
+
+	counter++;
+	assert(store.set("counter", &counter, sizeof(counter)));
+	assert(get_u32(store, "counter") == 6);
+	assert(store.size() == 2);
+
+	assert(store.remove("ssid"));
+	assert(!store.contains("ssid"));
+	assert(store.contains("counter"));
+	assert(store.size() == 1);
+
+	/* Empty values are values too. */
+	assert(store.set("flag", "", 0));
+	assert(store.get("flag", text, sizeof(text)) == 0);
+
+	/* A record must fit in a sector. */
+	uint8_t big[SECTORSIZE] = {};
+	assert(!store.set("big", big, sizeof(big)));
+
+	print_dbg("Basic key-value store test done!\n");
+}
+
+static void kvstore_remount_test()
+{
+	uint8_t memory[SECTORS * SECTORSIZE] = {};
+
+	{
+		MemoryKeyValueStore store(memory);
+
+		for(uint32_t idx = 0; idx < 100; idx++)
+			assert(store.set("counter", &idx, sizeof(idx)));
+
+		assert(store.set("name", "device", 6));
+		assert(store.set("gone", "x", 1));
+		assert(store.remove("gone"));
+	}
+
+	MemoryKeyValueStore store(memory);
+	char text[8];
+
+	assert(store.size() == 2);
+	assert(get_u32(store, "counter") == 99);
+	assert(store.get("name", text, sizeof(text)) == 6);
+	assert(memcmp(text, "device", 6) == 0);
+	assert(!store.contains("gone"));
+
+	print_dbg("Key-value store remount test done!\n");
+}
+
+static void kvstore_compaction_test()
+{
+	uint8_t memory[SECTORS * SECTORSIZE] = {};
+	MemoryKeyValueStore store(memory);
+	uint32_t value;
+
+	/* Static keys in the first sector are moved along as the counter keeps wrapping around. */
+	assert(store.set("a", "alpha", 5));
+	assert(store.set("b", "bravo", 5));
+
+	for(value = 0; value < 1000; value++)
+		assert(store.set("counter", &value, sizeof(value)));
+
+	assert(store.size() == 3);
+	assert(get_u32(store, "counter") == 999);
+
+	MemoryKeyValueStore remounted(memory);
+	char text[8];
+
+	assert(remounted.size() == 3);
+	assert(get_u32(remounted, "counter") == 999);
+	assert(remounted.get("a", text, sizeof(text)) == 5 && memcmp(text, "alpha", 5) == 0);
+	assert(remounted.get("b", text, sizeof(text)) == 5 && memcmp(text, "bravo", 5) == 0);
+
+	/* The writes went around the ring, leaving at most one sector free. */
+	size_t used = 0;
+
+	for(size_t sector = 0; sector < SECTORS; sector++)
+		used += memory[sector * SECTORSIZE] == 'K';
+
+	assert(used >= SECTORS - 1);
+
+	/* Compacting ahead of time frees the oldest sector, once it holds stale records. */
+	MemoryKeyValueStore idle(memory);
+
+	while(idle.compact());
+	assert(!idle.compact());
+	assert(idle.size() == 3);
+	assert(get_u32(idle, "counter") == 999);
+
+	print_dbg("Key-value store compaction test done!\n");
+}
+
+static void kvstore_full_test()
+{
+	uint8_t memory[SECTORS * SECTORSIZE] = {};
+	MemoryKeyValueStore store(memory);
+	uint8_t value[48] = {};
+	char key[] = "k0";
+	size_t stored = 0;
+
+	/* Distinct keys cannot be compacted away, so the store fills up. */
+	for(int idx = 0; idx < 10; idx++) {
+		key[1] = static_cast<char>('0' + idx);
+
+		if(!store.set(key, value, sizeof(value)))
+			break;
+
+		stored++;
+	}
+
+	assert(stored > 0 && stored < 10);
+	assert(store.size() == stored);
+
+	/* Removing keys makes room again. */
+	key[1] = '0';
+	assert(store.remove(key));
+	key[1] = '1';
+	assert(store.remove(key));
+	key[1] = 'x';
+	assert(store.set(key, value, sizeof(value)));
+	assert(store.size() == stored - 1);
+
+	store.clear();
+	assert(store.size() == 0);
+
+	MemoryKeyValueStore remounted(memory);
+	assert(remounted.size() == 0);
+	assert(remounted.set(key, value, sizeof(value)));
+
+	print_dbg("Full key-value store test done!\n");
+}
+
+static void kvstore_torn_write_test()
+{
+	uint8_t memory[SECTORS * SECTORSIZE] = {};
+	size_t end;
+
+	{
+		MemoryKeyValueStore store(memory);
+		uint32_t value = 1;
+
+		assert(store.set("counter", &value, sizeof(value)));
+		end = 8 + 6 + 7 + 4;
+		value = 2;
+		assert(store.set("counter", &value, sizeof(value)));
+	}
+
+	/* A reset halfway through the second record leaves the first one current. */
+	memory[end + 6 + 7] ^= 0xFF;
+
+	MemoryKeyValueStore store(memory);
+	uint32_t value = 3;
+
+	assert(get_u32(store, "counter") == 1);
+
+	/* New records are written over the damaged one. */
+	assert(store.set("counter", &value, sizeof(value)));
+
+	MemoryKeyValueStore remounted(memory);
+	assert(get_u32(remounted, "counter") == 3);
+
+	print_dbg("Torn write test done!\n");
+}
+
+#ifdef HAVE_UNISTD_H
+static void kvstore_file_test()
+{
+	uint32_t value = 42;
+
+	remove(STORE);
+
+	{
+		lwiot::FileKeyValueStore store(STORE, 2, 256);
+
+		assert(store.set("answer", &value, sizeof(value)));
+	}
+
+	lwiot::FileKeyValueStore store(STORE, 2, 256);
+
+	assert(get_u32(store, "answer") == 42);
+	remove(STORE);
+
+	print_dbg("File key-value store test done!\n");
+}
+#endif
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	kvstore_basic_test();
+	kvstore_remount_test();
+	kvstore_compaction_test();
+	kvstore_full_test();
+	kvstore_torn_write_test();
+#ifdef HAVE_UNISTD_H
+	kvstore_file_test();
+#endif
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -7,12 +7,14 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <assert.h>
 #include <lwiot.h>
 
 #include <lwiot/log.h>
 
 #include <lwiot/io/pwm.h>
 #include <lwiot/io/rgbleddriver.h>
+#include <lwiot/io/ledanimator.h>
 
 #include <lwiot/test.h>
 
@@ -30,6 +32,151 @@ protected:
 	virtual void update(int freq) { }
 };
 
+class SilentPwmChannel : public lwiot::PwmChannel {
+public:
+	explicit SilentPwmChannel(bool hardware = false) : reloads(0), fades(0), _hardware(hardware)
+	{
+	}
+
+	void enable() override { }
+	void disable() override { }
+
+	void reload() override
+	{
+		this->reloads++;
+	}
+
+	bool fade(const double& duty, int ms) override
+	{
+		UNUSED(duty);
+		UNUSED(ms);
+
+		if(this->_hardware)
+			this->fades++;
+
+		return this->_hardware;
+	}
+
+	volatile int reloads;
+	int fades;
+
+protected:
+	void update(int freq) override { }
+
+private:
+	bool _hardware;
+};
+
+static void wait_idle(const lwiot::LedAnimator& animator, int ms)
+{
+	for(int idx = 0; idx < ms / 10 && animator.active() != 0; idx++)
+		lwiot_sleep(10);
+}
+
+static void ledanimator_fade_test()
+{
+	SilentPwmChannel r, g, b, hw(true);
+	lwiot::RgbLedDriver rgb(r, g, b);
+	lwiot::LedDriver led(hw);
+	lwiot::LedAnimator animator;
+	time_t start;
+
+	assert(lwiot::LedAnimator::ease(lwiot::Easing::EaseIn, 0.5) == 0.25);
+	assert(lwiot::LedAnimator::ease(lwiot::Easing::EaseOut, 0.5) == 0.75);
+	assert(lwiot::LedAnimator::ease(lwiot::Easing::EaseInOut, 0.5) == 0.5);
+
+	start = lwiot_tick_ms();
+	animator.fade(rgb, 255, 0, 51, 200, lwiot::Easing::EaseInOut);
+	animator.fade(led, 80.0, 100);
+
+	/* Fading must not block the caller. */
+	assert(lwiot_tick_ms() - start < 50);
+	assert(animator.active() == 4);
+
+	lwiot_sleep(100);
+	assert(r.duty() > 0.0 && r.duty() < 100.0);
+	assert(g.duty() == 0.0);
+
+	wait_idle(animator, 1000);
+	assert(animator.active() == 0);
+	assert(r.duty() == 100.0);
+	assert(g.duty() == 0.0);
+	assert(b.level() == 205);
+	assert(r.reloads > 3);
+
+	/* The hardware fade is only reconciled when it is done. */
+	assert(hw.fades == 1);
+	assert(hw.reloads == 2);
+	assert(led.brightness() == 80.0);
+
+	print_dbg("LED animator fade test done!\n");
+}
+
+static void leddriver_level_test()
+{
+	SilentPwmChannel r, g, b;
+	lwiot::RgbLedDriver rgb(r, g, b);
+	uint8_t red, green, blue;
+
+	assert(r.resolution() == 1023);
+	r.setLevel(5000);
+	assert(r.level() == 1023 && r.duty() == 100.0);
+	r.setDutyCycle(50.0);
+	assert(r.level() == 512);
+
+	rgb.set(255, 128, 0);
+	assert(r.level() == 1023 && g.level() == 514 && b.level() == 0);
+
+	rgb.setGamma(true);
+	rgb.set(255, 128, 0);
+	assert(r.level() == 1023 && g.level() == 225 && b.level() == 0);
+	assert(lwiot::LedDriver::gamma(0, 1023) == 0);
+	assert(lwiot::LedDriver::gamma(1, 65535) == 0);
+	assert(lwiot::LedDriver::gamma(255, 4095) == 4095);
+
+	lwiot::RgbLedDriver::hsvToRgb(0, 255, 255, red, green, blue);
+	assert(red == 255 && green == 0 && blue == 0);
+	lwiot::RgbLedDriver::hsvToRgb(120, 255, 255, red, green, blue);
+	assert(red == 0 && green == 255 && blue == 0);
+	lwiot::RgbLedDriver::hsvToRgb(-120, 255, 255, red, green, blue);
+	assert(red == 0 && green == 0 && blue == 255);
+	lwiot::RgbLedDriver::hsvToRgb(30, 255, 255, red, green, blue);
+	assert(red == 255 && green == 127 && blue == 0);
+	lwiot::RgbLedDriver::hsvToRgb(200, 0, 100, red, green, blue);
+	assert(red == 100 && green == 100 && blue == 100);
+
+	print_dbg("LED driver level test done!\n");
+}
+
+static void ledanimator_rotate_test()
+{
+	SilentPwmChannel r, g, b;
+	lwiot::RgbLedDriver rgb(r, g, b);
+	lwiot::LedAnimator animator;
+
+	animator.rotate(rgb, 100);
+	lwiot_sleep(250);
+	assert(animator.active() == 1);
+
+	/* A fade replaces the rotation. */
+	animator.fade(rgb, 0, 0, 0, 50);
+	assert(animator.active() == 3);
+	wait_idle(animator, 1000);
+
+	assert(animator.active() == 0);
+	assert(r.duty() == 0.0 && g.duty() == 0.0 && b.duty() == 0.0);
+
+	animator.rotate(rgb, 50, 1.0, 1.0, false);
+	wait_idle(animator, 1000);
+	assert(animator.active() == 0);
+
+	animator.rotate(rgb, 50);
+	animator.cancel(rgb);
+	assert(animator.active() == 0);
+
+	print_dbg("LED animator rotate test done!\n");
+}
+
 int main(int argc, char **argv)
 {
 	lwiot_init();
@@ -45,6 +192,9 @@ int main(int argc, char **argv)
 	print_dbg("Fading to RGB value..");
 	rgb.fade(250, 12, 30);
 
+	leddriver_level_test();
+	ledanimator_fade_test();
+	ledanimator_rotate_test();
 
 	lwiot_destroy();
 	wait_close();
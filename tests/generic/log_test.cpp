@@ -7,11 +7,97 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <lwiot.h>
+#include <assert.h>
 
 #include <lwiot/log.h>
 #include <lwiot/test.h>
 
+static int calls = 0;
+
+static int counted()
+{
+	calls++;
+	return calls;
+}
+
+static size_t read_all(FILE *file, char *output, size_t size)
+{
+	fflush(file);
+	rewind(file);
+
+	auto length = fread(output, 1, size - 1, file);
+	output[length] = '\0';
+
+	rewind(file);
+	return length;
+}
+
+static void test_levels()
+{
+	FILE *file = tmpfile();
+	char text[512];
+
+	assert(file != nullptr);
+
+	lwiot::Logger net("net", file);
+	lwiot::Logger sensor("sensor", file);
+
+	/* Debug lines are compiled out unless HAVE_DEBUG is set, including their arguments. */
+	LWIOT_LOG_DEBUG(net, "debug {}", counted());
+	LWIOT_LOG_INFO(net, "info {}", counted());
+	LWIOT_LOG_WARNING(sensor, "warning {}", 1);
+
+	read_all(file, text, sizeof(text));
+
+#if CONFIG_LOG_LEVEL <= LWIOT_LOG_LEVEL_DEBUG
+	assert(calls == 2);
+	assert(strstr(text, "[lwiot][net]: debug 1") != nullptr);
+#else
+	assert(calls == 1);
+#endif
+
+	assert(strstr(text, "[lwiot][net]: info") != nullptr);
+	assert(strstr(text, "[lwiot][sensor]: warning 1") != nullptr);
+
+	/* Raise the level of one subsystem. Filtered lines do not evaluate their format arguments. */
+	assert(lwiot::Logger::setLevel("sensor", lwiot::LogLevel::Error));
+	assert(!sensor.enabled(lwiot::LogLevel::Warning));
+	assert(net.enabled(lwiot::LogLevel::Info));
+
+	file = freopen(nullptr, "w+", file);
+	assert(file != nullptr);
+
+	calls = 0;
+	LWIOT_LOG_INFO(sensor, "hidden {}", counted());
+	LWIOT_LOG_ERROR(sensor, "error {}", 2);
+	LWIOT_LOG_INFO(net, "shown");
+	assert(calls == 0);
+
+	read_all(file, text, sizeof(text));
+	assert(strstr(text, "hidden") == nullptr);
+	assert(strstr(text, "error 2") != nullptr);
+	assert(strstr(text, "shown") != nullptr);
+
+	/* The default level applies to subsystems without a level of their own. */
+	lwiot::Logger::setLevel(lwiot::LogLevel::Error);
+	assert(!net.enabled(lwiot::LogLevel::Warning));
+	assert(sensor.enabled(lwiot::LogLevel::Error));
+	assert(!lwiot::Logger("late").enabled(lwiot::LogLevel::Info));
+
+	lwiot::Logger::setLevel("net", lwiot::LogLevel::Debug);
+	assert(net.enabled(lwiot::LogLevel::Debug));
+
+	lwiot::Logger::setLevel(lwiot::LogLevel::Info);
+	assert(net.enabled(lwiot::LogLevel::Debug));
+	assert(!sensor.enabled(lwiot::LogLevel::Warning));
+	assert(lwiot::Logger().enabled(lwiot::LogLevel::Info));
+
+	fclose(file);
+	print_dbg("Log level test done!\n");
+}
+
 int main(int argc, char **argv)
 {
 	lwiot::Logger logger("log-test");
@@ -20,6 +106,8 @@ int main(int argc, char **argv)
 	logger << "Today it is " << 21.1531f << " Degrees!" << lwiot::Logger::newline;
 	logger << "End of test";
 
+	test_levels();
+
 	wait_close();
 	return -EXIT_SUCCESS;
 }
@@ -0,0 +1,196 @@
+/*
+ * Asynchronous logging backend unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+#include <lwiot/util/logbackend.h>
+#include <lwiot/kernel/functionalthread.h>
+
+#define THREADS 4
+#define LINES   500
+
+class CaptureSink : public lwiot::TextLogSink {
+public:
+	explicit CaptureSink(time_t delay = 0) : length(0), batches(0), _delay(delay)
+	{
+		this->text = (char *) malloc(1 << 20);
+	}
+
+	~CaptureSink() override
+	{
+		free(this->text);
+	}
+
+	char *text;
+	size_t length;
+	size_t batches;
+
+protected:
+	void output(const char *data, size_t size) override
+	{
+		assert(this->length + size < (1 << 20));
+		memcpy(this->text + this->length, data, size);
+		this->length += size;
+		this->batches++;
+
+		if(this->_delay)
+			lwiot_sleep(this->_delay);
+	}
+
+private:
+	time_t _delay;
+};
+
+class RecordSink : public lwiot::LogSink {
+public:
+	RecordSink() : count(0)
+	{
+	}
+
+	void write(const lwiot::LogRecord& record) override
+	{
+		if(this->count < 8)
+			this->records[this->count] = record;
+
+		this->count++;
+	}
+
+	lwiot::LogRecord records[8];
+	size_t count;
+};
+
+static void test_threads()
+{
+	CaptureSink sink;
+	lwiot::AsyncLogBackend backend(sink, lwiot::AsyncLogBackend::Policy::Block);
+	lwiot::FunctionalThread *threads[THREADS];
+	int next[THREADS] = { 0 };
+	size_t lines = 0;
+
+	backend.begin();
+	lwiot::Logger::setBackend(&backend);
+
+	for(int idx = 0; idx < THREADS; idx++) {
+		threads[idx] = new lwiot::FunctionalThread("log-test");
+		threads[idx]->start([idx]() {
+			char name[4] = { 't', static_cast<char>('0' + idx), '\0' };
+			lwiot::Logger log(name);
+
+			for(int num = 0; num < LINES; num++)
+				log.println("line {} of {}", num, idx);
+		});
+	}
+
+	for(auto thread : threads) {
+		thread->join();
+		delete thread;
+	}
+
+	backend.end();
+	lwiot::Logger::setBackend(nullptr);
+
+	/* Every line arrives whole and once, in the order in which each thread logged them. */
+	sink.text[sink.length] = '\0';
+
+	for(char *line = sink.text; *line != '\0'; line = strchr(line, '\n') + 1) {
+		unsigned long long tick;
+		int thread, num, idx;
+
+		assert(sscanf(line, "[%llu][lwiot][t%d]: line %d of %d\n", &tick, &thread, &num, &idx) == 4);
+		assert(thread == idx && thread >= 0 && thread < THREADS);
+		assert(num == next[thread]);
+
+		next[thread]++;
+		lines++;
+	}
+
+	assert(lines == THREADS * LINES);
+	assert(backend.dropped() == 0);
+	assert(sink.batches < lines);
+
+	print_dbg("Log backend thread test done!\n");
+}
+
+static void test_drop()
+{
+	CaptureSink sink(5);
+	lwiot::AsyncLogBackend backend(sink);
+	lwiot::Logger log("drop");
+	size_t lines = 0;
+
+	backend.begin();
+	lwiot::Logger::setBackend(&backend);
+
+	for(int num = 0; num < 1000; num++)
+		log.println("line {}", num);
+
+	backend.end();
+	lwiot::Logger::setBackend(nullptr);
+
+	for(size_t idx = 0; idx < sink.length; idx++) {
+		if(sink.text[idx] == '\n')
+			lines++;
+	}
+
+	/* A slow sink loses lines rather than holding up the caller. */
+	assert(backend.dropped() > 0);
+	assert(lines + backend.dropped() == 1000);
+
+	print_dbg("Log backend drop test done!\n");
+}
+
+static void test_records()
+{
+	RecordSink sink;
+	lwiot::AsyncLogBackend backend(sink);
+	lwiot::Logger log("a-very-long-subsystem");
+
+	assert(!backend.log(lwiot::LogLevel::Info, nullptr, 0, "text", 4));
+
+	backend.begin();
+	lwiot::Logger::setBackend(&backend);
+
+	log.println(lwiot::LogLevel::Error, "failed: {}", -5);
+	log << "count: " << 42 << lwiot::Logger::newline;
+
+	backend.end();
+	lwiot::Logger::setBackend(nullptr);
+
+	assert(sink.count == 4);
+	assert(sink.records[0].level == lwiot::LogLevel::Error);
+	assert(sink.records[0].flags == (lwiot::LogRecord::Start | lwiot::LogRecord::End));
+	assert(memcmp(sink.records[0].payload, "failed: -5", sink.records[0].length) == 0);
+	assert(strlen(sink.records[0].subsystem) == CONFIG_LOG_SUBSYS_LENGTH - 1);
+
+	/* Streamed lines arrive in parts. */
+	assert(sink.records[1].flags == lwiot::LogRecord::Start);
+	assert(sink.records[2].flags == 0);
+	assert(memcmp(sink.records[2].payload, "42", 2) == 0);
+	assert(sink.records[3].flags == lwiot::LogRecord::End && sink.records[3].length == 0);
+
+	print_dbg("Log backend record test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	test_records();
+	test_threads();
+	test_drop();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+/*
+ * Measurement window unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <math.h>
+#include <lwiot.h>
+
+#include <lwiot/test.h>
+
+#include <lwiot/util/measurementwindow.h>
+#include <lwiot/util/measurementvector.h>
+
+#define WINDOW 8
+#define SEED 1337
+
+template <typename T>
+static void reference(const T* samples, size_t last, size_t window, double& mean, double& variance,
+                      T& min, T& max, double& median)
+{
+	size_t first = last + 1 > window ? last + 1 - window : 0;
+	size_t count = last + 1 - first;
+	T sorted[WINDOW];
+
+	mean = variance = 0.0;
+	min = max = samples[first];
+
+	for(size_t idx = first; idx <= last; idx++) {
+		mean += samples[idx];
+		min = samples[idx] < min ? samples[idx] : min;
+		max = samples[idx] > max ? samples[idx] : max;
+		sorted[idx - first] = samples[idx];
+	}
+
+	mean /= count;
+
+	for(size_t idx = first; idx <= last; idx++)
+		variance += (samples[idx] - mean) * (samples[idx] - mean);
+
+	variance /= count;
+
+	for(size_t i = 1; i < count; i++) {
+		for(size_t j = i; j > 0 && sorted[j - 1] > sorted[j]; j--) {
+			T tmp = sorted[j];
+			sorted[j] = sorted[j - 1];
+			sorted[j - 1] = tmp;
+		}
+	}
+
+	median = (count & 1) ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2.0;
+}
+
+static void measurementwindow_float_test()
+{
+	lwiot::MeasurementWindow<float, WINDOW> window(0.5f);
+	float samples[200];
+
+	assert(window.empty());
+	assert(window.mean() == 0.0f && window.median() == 0.0f);
+
+	for(size_t idx = 0; idx < 200; idx++) {
+		double mean, variance, median;
+		float min, max;
+
+		samples[idx] = static_cast<float>(rand() % 1000) / 10.0f;
+		window.add(samples[idx]);
+		reference(samples, idx, WINDOW, mean, variance, min, max, median);
+
+		assert(fabs(window.mean() - mean) < 1e-3);
+		assert(fabs(window.variance() - variance) < 1e-2);
+		assert(window.min() == min);
+		assert(window.max() == max);
+		assert(fabs(window.median() - median) < 1e-4);
+	}
+
+	assert(window.full() && window.size() == WINDOW);
+
+	window.clear();
+	window.add(4.0f);
+	assert(window.ema() == 4.0f);
+	window.add(8.0f);
+	assert(window.ema() == 6.0f);
+
+	print_dbg("Float measurement window test done!\n");
+}
+
+static void measurementwindow_fixed_test()
+{
+	lwiot::MeasurementWindow<int32_t, WINDOW> window(0.25f);
+	int32_t samples[200];
+
+	srand(SEED);
+
+	for(size_t idx = 0; idx < 200; idx++) {
+		double mean, variance, median;
+		int32_t min, max;
+
+		/* Q16.16 samples between -100 and 100. */
+		samples[idx] = (rand() % (200 << 16)) - (100 << 16);
+		window.add(samples[idx]);
+		reference(samples, idx, WINDOW, mean, variance, min, max, median);
+
+		assert(fabs(window.mean() - mean) <= 1.0);
+		assert(fabs(window.variance() - variance) <= 2.0);
+		assert(window.min() == min);
+		assert(window.max() == max);
+		assert(fabs(window.median() - median) <= 1.0);
+	}
+
+	window.clear();
+	window.add(100 << 16);
+	window.add(200 << 16);
+	assert(window.ema() == 125 << 16);
+	assert(window.sum() == 300 << 16);
+
+	print_dbg("Fixed-point measurement window test done!\n");
+}
+
+static void measurementvector_test()
+{
+	lwiot::MeasurementVector vector;
+
+	vector.add(3.0);
+	vector.add(4.0);
+	vector.add(5.0);
+	vector.add(0.0);
+	assert(fabs(vector.smooth() - sqrt(50.0 / 4)) < 1e-9);
+
+	vector.clear();
+	vector.add(2.0);
+	assert(vector.smooth() == 2.0);
+
+	print_dbg("Measurement vector test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	measurementwindow_float_test();
+	measurementwindow_fixed_test();
+	measurementvector_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
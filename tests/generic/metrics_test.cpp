@@ -0,0 +1,217 @@
+/*
+ * Metrics registry unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/util/cbor.h>
+#include <lwiot/util/metrics.h>
+#include <lwiot/kernel/functionalthread.h>
+
+#define THREADS 4
+#define INCREMENTS 10000
+
+static lwiot::metrics::Counter started("test_started_total", "Tests started.");
+
+static void export_text(const lwiot::metrics::Registry& registry, bool json, char *output, size_t size)
+{
+	size_t length = 0;
+
+	auto ok = [&](const char *data, size_t num) {
+		assert(length + num < size);
+		memcpy(output + length, data, num);
+		length += num;
+		return true;
+	};
+
+	if(json)
+		assert(registry.writeJson(ok));
+	else
+		assert(registry.writePrometheus(ok));
+
+	output[length] = '\0';
+}
+
+static void test_buckets()
+{
+	using lwiot::metrics::Histogram;
+
+	/* Every value falls in the bucket whose bounds hold it. */
+	for(Histogram::value_type value = 0; value < 200000; value++) {
+		auto idx = Histogram::bucket(value);
+
+		if(idx == Histogram::Buckets - 1) {
+			assert(value > Histogram::upperBound(idx - 1));
+			continue;
+		}
+
+		assert(value <= Histogram::upperBound(idx));
+		assert(idx == 0 || value > Histogram::upperBound(idx - 1));
+	}
+
+	assert(Histogram::bucket(3) == 3);
+	assert(Histogram::bucket(4) == 4 && Histogram::upperBound(4) == 4);
+	assert(Histogram::bucket(10) == 9 && Histogram::upperBound(9) == 11);
+#if CONFIG_METRICS_HISTOGRAM_BUCKETS == 64
+	assert(Histogram::upperBound(Histogram::Buckets - 2) == 114687);
+#endif
+
+	print_dbg("Metrics bucket test done!\n");
+}
+
+static void test_threads()
+{
+	lwiot::metrics::Registry registry;
+	lwiot::metrics::Counter counter(registry, "ops_total");
+	lwiot::metrics::Gauge gauge(registry, "ops_active");
+	lwiot::metrics::Histogram histogram(registry, "op_us");
+	lwiot::FunctionalThread *threads[THREADS];
+
+	for(auto& thread : threads) {
+		thread = new lwiot::FunctionalThread("metrics-test");
+		thread->start([&]() {
+			for(int idx = 0; idx < INCREMENTS; idx++) {
+				gauge.add(1);
+				counter.inc();
+				histogram.observe(static_cast<unsigned long>(idx % 100));
+				gauge.sub(1);
+			}
+		});
+	}
+
+	for(auto thread : threads) {
+		thread->join();
+		delete thread;
+	}
+
+	assert(counter.value() == THREADS * INCREMENTS);
+	assert(gauge.value() == 0);
+	assert(histogram.count() == THREADS * INCREMENTS);
+	assert(histogram.sum() == THREADS * (INCREMENTS / 100) * 4950UL);
+
+	registry.reset();
+	assert(counter.value() == 0 && histogram.count() == 0 && histogram.sum() == 0);
+
+	print_dbg("Metrics thread test done!\n");
+}
+
+static void test_prometheus()
+{
+	lwiot::metrics::Registry registry;
+	lwiot::metrics::Counter requests(registry, "http_requests_total", "Requests served.");
+	lwiot::metrics::Gauge heap(registry, "heap_free_bytes");
+	char text[2048];
+
+	{
+		lwiot::metrics::Histogram latency(registry, "http_request_us", "Request latency.");
+
+		requests.inc(3);
+		heap.set(-12);
+		latency.observe(1);
+		latency.observe(5);
+		latency.observe(5);
+		latency.observe(1000000);
+
+		assert(registry.size() == 3);
+		assert(registry.find("http_request_us") == &latency);
+
+		export_text(registry, false, text, sizeof(text));
+
+		assert(strstr(text, "# HELP http_requests_total Requests served.\n"
+		                    "# TYPE http_requests_total counter\n"
+		                    "http_requests_total 3\n") == text);
+		assert(strstr(text, "# TYPE heap_free_bytes gauge\nheap_free_bytes -12\n") != nullptr);
+		assert(strstr(text, "# HELP heap_free_bytes") == nullptr);
+
+		/* Buckets are cumulative, and stop at the highest bucket in use below the last one. */
+		assert(strstr(text, "# TYPE http_request_us histogram\n"
+		                    "http_request_us_bucket{le=\"0\"} 0\n"
+		                    "http_request_us_bucket{le=\"1\"} 1\n") != nullptr);
+		assert(strstr(text, "http_request_us_bucket{le=\"5\"} 3\n") != nullptr);
+		assert(strstr(text, "http_request_us_bucket{le=\"+Inf\"} 4\n"
+		                    "http_request_us_sum 1000011\n"
+		                    "http_request_us_count 4\n") != nullptr);
+		assert(strstr(text, "le=\"114687\"") == nullptr);
+
+		export_text(registry, true, text, sizeof(text));
+		assert(strcmp(text, "{\"http_requests_total\":3,\"heap_free_bytes\":-12,\"http_request_us\":"
+		                    "{\"count\":4,\"sum\":1000011,\"buckets\":[[1,1],[5,2],[null,1]]}}") == 0);
+	}
+
+	/* Metrics leave the registry when they are destroyed. */
+	assert(registry.size() == 2);
+	assert(registry.find("http_request_us") == nullptr);
+
+	/* A writer that fails stops the export. */
+	size_t calls = 0;
+	assert(!registry.writePrometheus([&](const char *data, size_t length) {
+		calls++;
+		return false;
+	}));
+	assert(calls == 1);
+
+	print_dbg("Metrics Prometheus test done!\n");
+}
+
+static void test_cbor()
+{
+	lwiot::metrics::Registry registry;
+	lwiot::metrics::Counter counter(registry, "count");
+	lwiot::metrics::Histogram histogram(registry, "latency");
+	lwiot::ByteBuffer buffer;
+	lwiot::CborWriter writer(buffer);
+	lwiot::CborReader::Item item;
+
+	counter.inc(7);
+	histogram.observe(2);
+	registry.writeCbor(writer);
+
+	lwiot::CborReader reader(buffer.data(), buffer.index());
+
+	assert(reader.next(item) && item.type == lwiot::CborReader::Type::Map && item.value == 2);
+	assert(reader.next(item) && item.text() == "count");
+	assert(reader.next(item) && item.integer() == 7);
+	assert(reader.next(item) && item.text() == "latency");
+	assert(reader.next(item) && item.type == lwiot::CborReader::Type::Map && item.value == 3);
+	assert(reader.next(item) && item.text() == "count");
+	assert(reader.next(item) && item.integer() == 1);
+	assert(reader.next(item) && item.text() == "sum");
+	assert(reader.next(item) && item.integer() == 2);
+	assert(reader.next(item) && item.text() == "buckets");
+	assert(reader.next(item) && item.type == lwiot::CborReader::Type::Array && item.indefinite);
+	assert(reader.next(item) && item.type == lwiot::CborReader::Type::Array && item.value == 2);
+	assert(reader.next(item) && item.integer() == 2);
+	assert(reader.next(item) && item.integer() == 1);
+	assert(reader.next(item) && item.type == lwiot::CborReader::Type::Break);
+	assert(reader.done());
+
+	print_dbg("Metrics CBOR test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	started.inc();
+	assert(lwiot::metrics::Registry::global().find("test_started_total") == &started);
+
+	test_buckets();
+	test_threads();
+	test_prometheus();
+	test_cbor();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
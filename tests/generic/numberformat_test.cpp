@@ -0,0 +1,98 @@
+/*
+ * Number formatting unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/util/numberformat.h>
+
+static void integer_test()
+{
+	char expected[lwiot::NumberFormat::BufferSize];
+	char output[lwiot::NumberFormat::BufferSize];
+	const long long values[] = {
+		0, 1, 9, 10, 99, 100, 101, 12345, -1, -10, -987654321, INT_MAX, INT_MIN,
+		4294967295LL, 4294967296LL, 1234567890123LL, LLONG_MAX, LLONG_MIN
+	};
+
+	for(auto value : values) {
+		snprintf(expected, sizeof(expected), "%lld", value);
+		assert(lwiot::NumberFormat::formatSigned(output, value) == strlen(expected));
+		assert(strcmp(output, expected) == 0);
+
+		snprintf(expected, sizeof(expected), "%llu", static_cast<unsigned long long>(value));
+		assert(lwiot::NumberFormat::formatUnsigned(output, value) == strlen(expected));
+		assert(strcmp(output, expected) == 0);
+	}
+
+	assert(lwiot::NumberFormat::formatUnsigned(output, ULLONG_MAX) == 20);
+	assert(strcmp(output, "18446744073709551615") == 0);
+
+	lwiot::NumberFormat::formatUnsigned(output, 0xBEEF, 16);
+	assert(strcmp(output, "BEEF") == 0);
+	lwiot::NumberFormat::formatUnsigned(output, 5, 2);
+	assert(strcmp(output, "101") == 0);
+	assert(lwiot::NumberFormat::formatUnsigned(output, ULLONG_MAX, 2) == 64);
+}
+
+static void float_test()
+{
+	char expected[lwiot::NumberFormat::BufferSize];
+	char output[lwiot::NumberFormat::BufferSize];
+	const double values[] = {
+		0.0, 1.0, -1.0, 0.5, 3.14159265, -2.71828, 100.01, 0.000001, 123456789.987654,
+		9.9999999, -0.0000001, 4294967296.75
+	};
+
+	for(auto value : values) {
+		for(int precision = 0; precision <= 6; precision++) {
+			snprintf(expected, sizeof(expected), "%.*f", precision, value);
+			assert(lwiot::NumberFormat::formatFloat(output, value, precision) == strlen(expected));
+			assert(strcmp(output, expected) == 0);
+		}
+	}
+
+	lwiot::NumberFormat::formatFloat(output, 1.0 / 0.0, 2);
+	assert(strcmp(output, "inf") == 0);
+	lwiot::NumberFormat::formatFloat(output, -1.0 / 0.0, 2);
+	assert(strcmp(output, "-inf") == 0);
+
+	lwiot::NumberFormat::formatFloat(output, 1e20, 2);
+	assert(strcmp(output, "1.00e+20") == 0);
+
+	lwiot::String str(12.5);
+	assert(str == "12.500000");
+
+	lwiot::String num(-42);
+	assert(num == "-42");
+
+	lwiot::String hex(255U, 16);
+	assert(hex == "FF");
+
+	print_dbg("Number formatting test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	integer_test();
+	float_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
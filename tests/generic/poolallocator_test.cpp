@@ -0,0 +1,166 @@
+/*
+ * Pool allocator unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/stl/linkedlist.h>
+#include <lwiot/stl/map.h>
+#include <lwiot/util/poolallocator.h>
+#include <lwiot/util/objectpool.h>
+#include <lwiot/uniquepointer.h>
+
+class Base {
+public:
+	explicit Base(int value) : value(value)
+	{
+	}
+
+	virtual ~Base()
+	{
+		destroyed++;
+	}
+
+	int value;
+	static int destroyed;
+};
+
+int Base::destroyed = 0;
+
+class Derived : public Base {
+public:
+	explicit Derived(int value, int extra) : Base(value), extra(extra)
+	{
+	}
+
+	int extra;
+};
+
+struct CountingDelete {
+	int *count;
+
+	void operator()(int *p) const noexcept
+	{
+		(*this->count)++;
+		delete p;
+	}
+};
+
+static void test_pool()
+{
+	lwiot::BlockPool<sizeof(int), 4> pool;
+	void *blocks[4];
+
+	for(auto& block : blocks) {
+		block = pool.allocate();
+		assert(block);
+		assert(pool.contains(block));
+	}
+
+	assert(pool.allocate() == nullptr);
+
+	pool.deallocate(blocks[2]);
+	void *block = pool.allocate();
+	assert(block == blocks[2]);
+
+	for(auto& b : blocks)
+		pool.deallocate(b);
+
+	print_dbg("Block pool test done!\n");
+}
+
+static void test_containers()
+{
+	typedef lwiot::PoolAllocator<int, 16> Allocator;
+	lwiot::stl::LinkedList<int, Allocator> list;
+	lwiot::stl::Map<lwiot::stl::String, int, Allocator> map;
+	lwiot::stl::Vector<int, Allocator> vec;
+
+	for(int idx = 0; idx < 32; idx++)
+		list.push_back(idx);
+
+	assert(list.size() == 32);
+	assert(list.front() == 0);
+	assert(list.back() == 31);
+	list.clear();
+
+	map.add("abc", 1);
+	map.add("def", 2);
+	map["abc"] = 3;
+	assert(map.at("abc") == 3);
+	assert(map.at("def") == 2);
+	map.remove("def");
+	assert(!map.contains("def"));
+
+	vec.pushback(1);
+	vec.pushback(2);
+	assert(vec[1] == 2);
+
+	print_dbg("Container test done!\n");
+}
+
+static void test_object_pool()
+{
+	lwiot::ObjectPool<Derived, 2> pool;
+
+	{
+		/* Objects are deleted through the base class and go back to the pool. */
+		lwiot::UniquePointer<Base> a(pool.create(1, 2));
+		lwiot::UniquePointer<Base> b(pool.create(3, 4));
+
+		assert(a && b);
+		assert(pool.used() == 2);
+		assert(pool.create(5, 6) == nullptr);
+		assert(b->value == 3);
+
+		b.reset();
+		assert(pool.used() == 1);
+		assert(Base::destroyed == 1);
+
+		auto c = pool.acquire(7, 8);
+		assert(c && c->extra == 8);
+		assert(pool.contains(c.get()));
+	}
+
+	assert(pool.used() == 0);
+	assert(Base::destroyed == 3);
+
+	int count = 0;
+
+	{
+		lwiot::UniquePointer<int, CountingDelete> p(new int(5), CountingDelete{&count});
+		lwiot::UniquePointer<int, CountingDelete> q(lwiot::stl::move(p));
+
+		assert(!p && *q == 5);
+	}
+
+	assert(count == 1);
+	assert(sizeof(lwiot::UniquePointer<int>) == sizeof(int *));
+	print_dbg("Object pool test passed!\n");
+}
+
+int main(int argc, char**argv)
+{
+	lwiot_init();
+
+	UNUSED(argc);
+	UNUSED(argv);
+
+	test_pool();
+	test_containers();
+	test_object_pool();
+
+	lwiot_destroy();
+	wait_close();
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+/*
+ * Bounded queue unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/test.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/kernel/queue.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/kernel/atomic.h>
+
+static void queue_basic_test()
+{
+	lwiot::Queue<lwiot::String, 3> queue;
+	lwiot::stl::Vector<lwiot::String> batch;
+	lwiot::String value;
+
+	assert(queue.tryPush("one"));
+	assert(queue.tryPush("two"));
+	assert(queue.push("three", 10));
+	assert(queue.full());
+	assert(!queue.tryPush("four"));
+	assert(!queue.push("four", 50));
+
+	assert(queue.tryPop(value));
+	assert(value == "one");
+	assert(queue.popAll(batch) == 2);
+	assert(batch[0] == "two" && batch[1] == "three");
+
+	assert(queue.empty());
+	assert(!queue.tryPop(value));
+	assert(!queue.pop(value, 50));
+	assert(queue.popAll(batch, 50) == 0);
+
+	print_dbg("Basic queue test done!\n");
+}
+
+static void queue_thread_test()
+{
+	lwiot::Queue<int, 8> queue;
+	lwiot::FunctionalThread p1("q-producer-1");
+	lwiot::FunctionalThread p2("q-producer-2");
+	lwiot::stl::Vector<int> batch;
+	const int total = 2000;
+	long sum = 0;
+	size_t received = 0;
+
+	p1.start([&]() {
+		for(int idx = 0; idx < total; idx++)
+			queue.push(idx);
+	});
+
+	p2.start([&]() {
+		for(int idx = 0; idx < total; idx++)
+			queue.push(-idx);
+	});
+
+	while(received < total * 2) {
+		batch.clear();
+		received += queue.popAll(batch, 1000);
+
+		for(auto value : batch)
+			sum += value;
+	}
+
+	assert(received == total * 2);
+	assert(sum == 0);
+
+	p1.stop();
+	p2.stop();
+	print_dbg("Threaded queue test done!\n");
+}
+
+/* Draining a full queue must wake every producer that is blocked on it, not just one. */
+static void queue_drain_wakeup_test()
+{
+	const int producers = 4;
+	lwiot::Queue<int, producers> queue;
+	lwiot::FunctionalThread *threads[producers];
+	lwiot::Atomic<int> pushed(0);
+	lwiot::stl::Vector<int> batch;
+
+	for(int idx = 0; idx < producers; idx++)
+		assert(queue.tryPush(idx));
+
+	for(int idx = 0; idx < producers; idx++) {
+		threads[idx] = new lwiot::FunctionalThread("q-blocked");
+		threads[idx]->start([&queue, &pushed, idx]() {
+			queue.push(producers + idx);
+			pushed.fetch_add(1);
+		});
+	}
+
+	lwiot_sleep(100);
+	assert(pushed.load() == 0);
+	assert(queue.popAll(batch) == producers);
+
+	auto start = lwiot_tick_ms();
+
+	while(pushed.load() < producers && lwiot_tick_ms() - start < 1000)
+		lwiot_sleep(1);
+
+	assert(pushed.load() == producers);
+	assert(queue.full());
+
+	for(auto thread : threads) {
+		thread->stop();
+		delete thread;
+	}
+
+	print_dbg("Drain wake up test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	queue_basic_test();
+	queue_thread_test();
+	queue_drain_wakeup_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+/*
+ * Register device unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/test.h>
+
+#include <lwiot/io/i2cbus.h>
+#include <lwiot/io/i2calgorithm.h>
+#include <lwiot/io/i2cmessage.h>
+#include <lwiot/device/registerdevice.h>
+
+#define SLAVE 0x40
+
+class RegisterMap : public lwiot::I2CAlgorithm {
+public:
+	explicit RegisterMap() : I2CAlgorithm(20, 100000), transfers(0), pointer(0)
+	{
+		for(size_t idx = 0; idx < sizeof(this->regs); idx++)
+			this->regs[idx] = static_cast<uint8_t>(idx ^ 0xA5);
+	}
+
+	ssize_t transfer(lwiot::I2CMessage& msg) override
+	{
+		this->transfers++;
+		return this->handle(msg);
+	}
+
+	ssize_t transfer(lwiot::stl::Vector<lwiot::I2CMessage>& msgs) override
+	{
+		ssize_t total = 0;
+
+		this->transfers++;
+
+		for(auto& msg : msgs)
+			total += this->handle(msg);
+
+		return total;
+	}
+
+	int transfers;
+	uint8_t regs[256];
+
+private:
+	uint8_t pointer;
+
+	ssize_t handle(lwiot::I2CMessage& msg)
+	{
+		if(msg.address() != SLAVE)
+			return -EINVALID;
+
+		if(msg.isRead()) {
+			for(size_t idx = 0; idx < msg.count(); idx++)
+				msg[idx] = this->regs[this->pointer++];
+
+			msg.setIndex(msg.count());
+			return msg.count();
+		}
+
+		this->pointer = msg[0];
+
+		for(size_t idx = 1; idx < msg.index(); idx++)
+			this->regs[this->pointer++] = msg[idx];
+
+		return msg.index();
+	}
+};
+
+static void registerdevice_read_test()
+{
+	auto* map = new RegisterMap();
+	lwiot::I2CBus bus(map);
+	lwiot::RegisterDevice<uint8_t> dev(bus, SLAVE);
+	uint8_t block[24];
+	uint16_t word;
+
+	assert(dev.read(0x88, block, sizeof(block)));
+	assert(map->transfers == 1);
+
+	for(size_t idx = 0; idx < sizeof(block); idx++)
+		assert(block[idx] == ((0x88 + idx) ^ 0xA5));
+
+	assert(dev.read16(0x10, word));
+	assert(word == (((0x10 ^ 0xA5) << 8) | (0x11 ^ 0xA5)));
+	assert(dev.read16(0x10, word, true));
+	assert(word == (((0x11 ^ 0xA5) << 8) | (0x10 ^ 0xA5)));
+
+	print_dbg("Register device read test done!\n");
+}
+
+static void registerdevice_span_test()
+{
+	auto* map = new RegisterMap();
+	lwiot::I2CBus bus(map);
+	lwiot::RegisterDevice<uint8_t> dev(bus, SLAVE);
+	uint8_t a[2], b[1], c[3], d[2];
+
+	lwiot::RegisterDevice<uint8_t>::Span spans[] = {
+		{0x24, c, sizeof(c)},
+		{0x20, a, sizeof(a)},
+		{0x80, d, sizeof(d)},
+		{0x23, b, sizeof(b)},
+	};
+
+	/* 0x20 - 0x26 in one burst, 0x80 - 0x81 in another. */
+	assert(dev.read(spans, 4));
+	assert(map->transfers == 2);
+
+	assert(a[0] == (0x20 ^ 0xA5) && a[1] == (0x21 ^ 0xA5));
+	assert(b[0] == (0x23 ^ 0xA5));
+	assert(c[0] == (0x24 ^ 0xA5) && c[2] == (0x26 ^ 0xA5));
+	assert(d[0] == (0x80 ^ 0xA5) && d[1] == (0x81 ^ 0xA5));
+
+	print_dbg("Register device span test done!\n");
+}
+
+static void registerdevice_cache_test()
+{
+	auto* map = new RegisterMap();
+	lwiot::I2CBus bus(map);
+	lwiot::RegisterDevice<uint8_t> dev(bus, SLAVE);
+	uint8_t value;
+	uint8_t block[4];
+
+	assert(dev.cache(0x88, 24));
+	assert(map->transfers == 1);
+
+	assert(dev.read8(0x90, value) && value == (0x90 ^ 0xA5));
+	assert(dev.read(0x9C, block, sizeof(block)));
+	assert(map->transfers == 1);
+
+	/* Writes go to the device and the cache. */
+	assert(dev.write8(0x90, 0x42));
+	assert(map->transfers == 2 && map->regs[0x90] == 0x42);
+	assert(dev.read8(0x90, value) && value == 0x42);
+	assert(map->transfers == 2);
+
+	/* Partially cached reads go to the device. */
+	assert(dev.read(0x9E, block, sizeof(block)));
+	assert(map->transfers == 3);
+
+	dev.invalidate();
+	assert(dev.read8(0x90, value) && value == 0x42);
+	assert(map->transfers == 4);
+
+	print_dbg("Register device cache test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	registerdevice_read_test();
+	registerdevice_span_test();
+	registerdevice_cache_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+/*
+ * Ring buffer unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/test.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/ringbuffer.h>
+#include <lwiot/ringbufferstream.h>
+#include <lwiot/kernel/functionalthread.h>
+
+static void ringbuffer_basic_test()
+{
+	lwiot::stl::RingBuffer<lwiot::String, 4> rb;
+	lwiot::String value;
+
+	assert(rb.empty());
+	assert(rb.push("one"));
+	assert(rb.push("two"));
+	assert(rb.emplace("three"));
+	assert(rb.push("four"));
+	assert(rb.full());
+	assert(!rb.push("five"));
+
+	assert(rb.pop(value));
+	assert(value == "one");
+	assert(rb.push("five"));
+	assert(rb.size() == 4);
+
+	assert(rb.pop(value) && value == "two");
+	assert(rb.pop(value) && value == "three");
+	assert(rb.pop(value) && value == "four");
+	assert(rb.pop(value) && value == "five");
+	assert(!rb.pop(value));
+
+	rb.push("left behind");
+	rb.clear();
+	assert(rb.empty());
+
+	print_dbg("Basic ring buffer test done!\n");
+}
+
+static void ringbuffer_thread_test()
+{
+	static lwiot::stl::RingBuffer<uint32_t, 16> rb;
+	const uint32_t total = 20000;
+	lwiot::FunctionalThread producer("rb-producer");
+	uint32_t expected = 0;
+
+	producer.start([&]() {
+		for(uint32_t idx = 0; idx < total;) {
+			if(rb.push(idx))
+				idx++;
+		}
+	});
+
+	while(expected < total) {
+		uint32_t value;
+
+		if(!rb.pop(value))
+			continue;
+
+		assert(value == expected);
+		expected++;
+	}
+
+	producer.stop();
+	print_dbg("Threaded ring buffer test done!\n");
+}
+
+static void ringbufferstream_test()
+{
+	lwiot::RingBufferStream stream(10);
+	char buffer[16];
+
+	assert(stream.capacity() == 16);
+	stream << "Hello, " << "World";
+	assert(stream.available() == 12);
+
+	assert(stream.read(buffer, 7) == 7);
+	assert(memcmp(buffer, "Hello, ", 7) == 0);
+
+	/* Wraps around the end of the buffer. */
+	assert(stream.write("0123456789ABCDEF", 16) == 11);
+	assert(stream.full());
+	assert(!stream.write('x'));
+
+	assert(stream.read(buffer, sizeof(buffer)) == 16);
+	assert(memcmp(buffer, "World0123456789A", 16) == 0);
+	assert(stream.available() == 0);
+	assert(stream.read() == 0);
+
+	print_dbg("Ring buffer stream test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	ringbuffer_basic_test();
+	ringbuffer_thread_test();
+	ringbufferstream_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,123 @@
+/*
+ * Sample batch unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/test.h>
+
+#include <lwiot/bytebuffer.h>
+#include <lwiot/device/sensorscheduler.h>
+#include <lwiot/util/samplebatch.h>
+#include <lwiot/util/cbor.h>
+#include <lwiot/util/json.h>
+#include <lwiot/util/dsp.h>
+
+static void batch_add_test()
+{
+	lwiot::SampleBatch batch(4);
+	lwiot::SensorReading reading;
+	float values[4];
+
+	assert(reinterpret_cast<uintptr_t>(batch.values()) % CONFIG_SAMPLE_BATCH_ALIGN == 0);
+	assert(reinterpret_cast<uintptr_t>(batch.timestamps()) % CONFIG_SAMPLE_BATCH_ALIGN == 0);
+	assert(batch.empty());
+
+	memset(&reading, 0, sizeof(reading));
+	reading.sensor = 3;
+	reading.timestamp = 100;
+	reading.ok = true;
+	reading.count = 2;
+	reading.values[0] = 1.0f;
+	reading.values[1] = 2.0f;
+
+	assert(batch.add(reading) == 2);
+	assert(batch.add(110, 4, 7.0f));
+	assert(batch.add(120, 3, 3.0f));
+	assert(batch.full());
+	assert(!batch.add(130, 3, 4.0f));
+
+	assert(batch.gather(3, values, 4) == 3);
+	assert(values[0] == 1.0f && values[2] == 3.0f);
+	assert(batch.gather(3, values, 1) == 1);
+
+	batch.clear();
+	assert(batch.empty());
+
+	print_dbg("Batch add test done!\n");
+}
+
+static void batch_encode_test()
+{
+	lwiot::SampleBatch batch(8);
+	lwiot::ByteBuffer cbor(16);
+	lwiot::ByteBuffer json(16);
+	lwiot::CborWriter writer(cbor);
+	lwiot::CborReader::Item item;
+
+	batch.add(5000, 1, 20.5f);
+	batch.add(5010, 1, 20.75f);
+	batch.add(5020, 2, NAN);
+
+	writer.write(batch);
+
+	lwiot::CborReader reader(cbor.data(), cbor.index());
+
+	assert(reader.next(item) && item.type == lwiot::CborReader::Type::Map && item.value == 4);
+	assert(reader.next(item) && item.text() == "t");
+	assert(reader.next(item) && item.integer() == 5000);
+	assert(reader.next(item) && item.text() == "dt");
+	assert(reader.next(item) && item.type == lwiot::CborReader::Type::Array && item.value == 3);
+	assert(reader.next(item) && item.integer() == 0);
+	assert(reader.next(item) && item.integer() == 10);
+	assert(reader.next(item) && item.integer() == 20);
+	assert(reader.next(item) && item.text() == "s");
+	assert(reader.next(item) && item.type == lwiot::CborReader::Type::Array && item.value == 3);
+
+	auto length = lwiot::serializeJson(batch, json, 2);
+	const char *expected = "{\"t\":5000,\"dt\":[0,10,20],\"s\":[1,1,2],\"v\":[20.50,20.75,null]}";
+
+	assert(length == strlen(expected));
+	assert(memcmp(json.data(), expected, length) == 0);
+
+	print_dbg("Batch encode test done!\n");
+}
+
+static void batch_dsp_test()
+{
+	lwiot::SampleBatch batch(64);
+	auto average = lwiot::dsp::Fir::average(4);
+
+	for(int idx = 0; idx < 64; idx++)
+		batch.add(idx, 1, (idx % 2) ? 3.0f : 1.0f);
+
+	assert(fabsf(lwiot::dsp::mean(batch) - 2.0f) < 1e-5f);
+	assert(fabsf(lwiot::dsp::peak(batch) - 3.0f) < 1e-5f);
+
+	average.process(batch);
+	assert(fabsf(batch.values()[63] - 2.0f) < 1e-5f);
+
+	print_dbg("Batch DSP test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	batch_add_test();
+	batch_encode_test();
+	batch_dsp_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
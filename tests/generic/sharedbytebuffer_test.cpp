@@ -0,0 +1,132 @@
+/*
+ * Shared byte buffer unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/bytebuffer.h>
+#include <lwiot/sharedbytebuffer.h>
+#include <lwiot/stl/move.h>
+
+static void sharedbytebuffer_share_test()
+{
+	lwiot::ByteBuffer input(8);
+
+	input.write("Hello, World", 12);
+	auto raw = input.data();
+
+	lwiot::SharedByteBuffer buffer(lwiot::stl::move(input));
+	assert(buffer.data() == raw);
+	assert(buffer.size() == 12);
+	assert(buffer.useCount() == 1);
+
+	lwiot::SharedByteBuffer copy(buffer);
+	assert(copy.data() == buffer.data());
+	assert(buffer.useCount() == 2);
+	assert(copy == buffer);
+
+	lwiot::SharedByteBuffer moved(lwiot::stl::move(copy));
+	assert(copy.empty());
+	assert(moved.useCount() == 2);
+
+	lwiot::SharedByteBuffer other("Hello, World", 12);
+	assert(other == buffer);
+	assert(other.data() != buffer.data());
+	assert(other.useCount() == 1);
+}
+
+static void sharedbytebuffer_slice_test()
+{
+	lwiot::SharedByteBuffer buffer("Hello, World", 12);
+	auto world = buffer.slice(7);
+
+	assert(world.size() == 5);
+	assert(world.data() == buffer.data() + 7);
+	assert(memcmp(world.data(), "World", 5) == 0);
+	assert(buffer.useCount() == 2);
+
+	auto orld = world.slice(1, 3);
+	assert(orld.size() == 3);
+	assert(orld[0] == 'o' && orld[2] == 'l');
+	assert(buffer.useCount() == 3);
+
+	assert(buffer.slice(20).empty());
+	assert(buffer.slice(10, 10).size() == 2);
+
+	auto copy = world.toByteBuffer();
+	assert(copy.index() == 5);
+	assert(copy.data() != world.data());
+	assert(memcmp(copy.data(), "World", 5) == 0);
+
+	buffer = lwiot::SharedByteBuffer();
+	assert(world.useCount() == 2);
+	assert(memcmp(world.data(), "World", 5) == 0);
+
+	print_dbg("Shared byte buffer slice test passed!\n");
+}
+
+/* Memory that is lent out, like a network buffer, and returned when the last view is gone. */
+class LentBuffer : public lwiot::ByteBuffer {
+public:
+	explicit LentBuffer(uint8_t *data, size_t size, bool& returned) : ByteBuffer(data, size), _returned(returned)
+	{
+	}
+
+	~LentBuffer() override
+	{
+		this->release();
+		this->_returned = true;
+	}
+
+private:
+	bool& _returned;
+};
+
+static void sharedbytebuffer_external_test()
+{
+	uint8_t memory[] = { 'H', 'e', 'l', 'l', 'o' };
+	bool returned = false;
+
+	{
+		lwiot::SharedPointer<lwiot::ByteBuffer> storage(new LentBuffer(memory, sizeof(memory), returned));
+		lwiot::SharedByteBuffer buffer(storage);
+
+		storage.reset();
+		assert(buffer.data() == memory);
+		assert(buffer.size() == sizeof(memory));
+
+		auto ell = buffer.slice(1, 3);
+		buffer = lwiot::SharedByteBuffer();
+
+		assert(!returned);
+		assert(ell.data() == memory + 1);
+		assert(memcmp(ell.data(), "ell", 3) == 0);
+	}
+
+	assert(returned);
+	print_dbg("Shared byte buffer external memory test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	sharedbytebuffer_share_test();
+	sharedbytebuffer_slice_test();
+	sharedbytebuffer_external_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -10,11 +10,61 @@
 
 #include <lwiot/types.h>
 #include <lwiot/sharedpointer.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/kernel/functionalthread.h>
 #include <lwiot/test.h>
 
+static void make_shared_test()
+{
+	auto str = lwiot::makeShared<lwiot::String>("Hello, World!");
+	lwiot::SharedPointer<lwiot::String> empty;
+
+	assert(str.unique());
+	assert(*str == "Hello, World!");
+	assert(!empty);
+	assert(empty.useCount() == 0);
+
+	lwiot::SharedPointer<lwiot::String> copy(str);
+	assert(copy.useCount() == 2);
+
+	str.reset();
+	assert(copy.unique());
+	assert(copy->length() == 13);
+
+	print_dbg("makeShared test passed!\n");
+}
+
+static void thread_test()
+{
+	auto value = lwiot::makeShared<int>(0);
+
+	{
+		lwiot::FunctionalThread t1("shared-1"), t2("shared-2");
+
+		/* Each copy of the functor holds a reference as well. */
+		auto worker = [value]() {
+			for(int idx = 0; idx < 10000; idx++) {
+				lwiot::SharedPointer<int> copy(value);
+				assert(copy.useCount() >= 2);
+			}
+		};
+
+		t1.start(worker);
+		t2.start(worker);
+		t1.join();
+		t2.join();
+	}
+
+	assert(value.unique());
+	print_dbg("Thread test passed!\n");
+}
+
 int main(int argc, char **argv)
 {
 	lwiot_init();
+	make_shared_test();
+	thread_test();
+
 	int *ptr = new int;
 	int *newptr = new int;
 
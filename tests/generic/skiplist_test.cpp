@@ -42,10 +42,56 @@ static void skiplist_test()
 	print_dbg("Insert test done!");
 }
 
+static void skiplist_range_test()
+{
+	lwiot::stl::SkipList<int, int, 4> sl;
+	lwiot::stl::Vector<lwiot::stl::Pair<int, int>> samples;
+
+	for(int idx = 0; idx < 32; idx++)
+		samples.pushback(lwiot::stl::Pair<int, int>(idx * 10, idx));
+
+	sl.reserve(40);
+	sl.insertRange(samples.begin(), samples.end());
+	assert(sl.size() == 32);
+	assert(sl.at(150) == 15);
+
+	auto num = sl.eraseRange(0, 100);
+	assert(num == 10);
+	assert(sl.size() == 22);
+	assert(sl.find(90) == sl.end());
+	assert(sl.begin() == sl.find(100));
+
+	num = sl.eraseRange(205, 255);
+	assert(num == 5);
+	assert(sl.find(210) == sl.end());
+	assert(sl.find(200) != sl.end());
+	assert(sl.find(260) != sl.end());
+
+	sl.insert(5, 500);
+	sl.insert(5, 501);
+	assert(sl.size() == 18);
+	assert(sl.at(5) == 501);
+
+	lwiot::stl::SkipList<int, int, 4> copy(sl);
+	assert(copy.size() == sl.size());
+	assert(sl.eraseRange(0, 1000) == 18);
+	assert(sl.empty());
+	assert(copy.at(310) == 31);
+
+	int last = -1;
+	for(auto iter = copy.find(100); iter != copy.end(); ++iter) {
+		assert(*iter > last);
+		last = *iter;
+	}
+
+	print_dbg("Range test done!");
+}
+
 int main(int argc, char **argv)
 {
 	lwiot_init();
 	skiplist_test();
+	skiplist_range_test();
 
 	wait_close();
 	lwiot_destroy();
@@ -0,0 +1,95 @@
+/*
+ * Small vector unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/stl/smallvector.h>
+
+static size_t sum(const lwiot::stl::Vector<int>& vec)
+{
+	size_t rv = 0;
+
+	for(auto value : vec)
+		rv += value;
+
+	return rv;
+}
+
+static void test_inline()
+{
+	lwiot::stl::SmallVector<int, 4> vec;
+
+	vec.pushback(1);
+	vec.pushback(2);
+	vec.pushback(3);
+	vec.pushback(4);
+
+	assert(vec.isSmall());
+	assert(vec.capacity() == 4);
+	assert(sum(vec) == 10);
+
+	vec.pushback(5);
+	assert(!vec.isSmall());
+	assert(vec.size() == 5);
+	assert(sum(vec) == 15);
+	assert(vec[4] == 5);
+
+	vec.clear();
+	print_dbg("Inline test done!\n");
+}
+
+static void test_move()
+{
+	lwiot::stl::SmallVector<lwiot::stl::String, 2> v1;
+	lwiot::stl::Vector<lwiot::stl::String> v2;
+
+	v1.pushback("abc");
+	v1.pushback("def");
+
+	v2 = lwiot::stl::move(v1);
+	assert(v1.size() == 0);
+	assert(v2.size() == 2);
+	assert(v2[1] == "def");
+
+	lwiot::stl::SmallVector<lwiot::stl::String, 2> v3(v2);
+	assert(v3.isSmall());
+	assert(v3[0] == "abc");
+
+	lwiot::stl::SmallVector<lwiot::stl::String, 2> v4(lwiot::stl::move(v3));
+	assert(v4.isSmall());
+	assert(v3.size() == 0);
+	v3 = v4;
+	v4.pushback("ghi");
+	assert(!v4.isSmall());
+	assert(v4.size() == 3);
+	assert(v3.size() == 2);
+	assert(v4[0] == "abc");
+
+	print_dbg("Move test done!\n");
+}
+
+int main(int argc, char**argv)
+{
+	lwiot_init();
+
+	UNUSED(argc);
+	UNUSED(argv);
+
+	test_inline();
+	test_move();
+
+	lwiot_destroy();
+	wait_close();
+	return -EXIT_SUCCESS;
+}
@@ -6,12 +6,17 @@
  */
 
 #include <stdlib.h>
+#include <assert.h>
 #include <lwiot.h>
 
 #include <lwiot/test.h>
+#include <lwiot/io/gpiochip.h>
+#include <lwiot/io/gpiopin.h>
 #include <lwiot/io/spimessage.h>
 #include <lwiot/io/spibus.h>
 #include <lwiot/types.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/device/ssd1306display.h>
 
 #include <stack>
 
@@ -48,6 +53,115 @@ public:
 	}
 };
 
+class DcChip : public lwiot::GpioChip {
+public:
+	explicit DcChip() : GpioChip(8), level(true), edges(0)
+	{
+	}
+
+	void mode(int pin, const lwiot::PinMode& mode) override
+	{
+	}
+
+	void write(int pin, bool value) override
+	{
+		if(value != this->level)
+			this->edges++;
+
+		this->level = value;
+	}
+
+	bool read(int pin) const override
+	{
+		return this->level;
+	}
+
+	void setOpenDrain(int pin) override
+	{
+	}
+
+	void odWrite(int pin, bool value) override
+	{
+	}
+
+	void attachIrqHandler(int pin, irq_handler_t handler, lwiot::IrqEdge edge) override
+	{
+	}
+
+	void detachIrqHandler(int pin) override
+	{
+	}
+
+	bool level;
+	int edges;
+};
+
+struct Segment {
+	bool data;
+	size_t length;
+	uint8_t first;
+};
+
+class DisplaySpiBus : public lwiot::SpiBus {
+public:
+	explicit DisplaySpiBus(const DcChip& dc) : lwiot::SpiBus(1, 2, 3), _dc(dc)
+	{
+	}
+
+	bool transfer(lwiot::SpiMessage& msg) override
+	{
+		Segment segment;
+
+		segment.data = this->_dc.level;
+		segment.length = msg.size();
+		segment.first = msg.txdata().data()[0];
+		this->segments.pushback(segment);
+
+		return true;
+	}
+	using SpiBus::transfer;
+
+	lwiot::stl::Vector<Segment> segments;
+
+private:
+	const DcChip& _dc;
+};
+
+static void ssd1306_spi_test()
+{
+	DcChip chip;
+	DisplaySpiBus bus(chip);
+	lwiot::Ssd1306Display display(bus, -1, lwiot::GpioPin(0, chip));
+
+	display.begin();
+
+	for(auto& segment : bus.segments)
+		assert(!segment.data);
+
+	/* Commands share a single D/C level, and a refresh switches it once for all of its pages. */
+	assert(chip.edges == 1);
+	assert(bus.frequency() == CONFIG_SSD1306_SPI_FREQUENCY);
+
+	bus.segments.clear();
+	display.display();
+
+	assert(bus.segments.size() == 2);
+	assert(!bus.segments[0].data && bus.segments[0].length == 6);
+	assert(bus.segments[1].data && bus.segments[1].length == SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8);
+	assert(chip.edges == 2);
+
+	bus.segments.clear();
+	display.fillRect(10, 4, 10, 16, WHITE);
+	display.display();
+
+	assert(bus.segments.size() == 2);
+	assert(bus.segments[1].data && bus.segments[1].length == 10 * 3);
+	assert(bus.segments[1].first == 0xF0);
+	assert(chip.edges == 4);
+
+	print_dbg("SSD1306 SPI test passed!\n");
+}
+
 int main(int argc, char **argv)
 {
 	unsigned char data[4];
@@ -76,6 +190,8 @@ int main(int argc, char **argv)
 		print_dbg("Data: 0x%X\n", byte);
 	}
 
+	ssd1306_spi_test();
+
 	wait_close();
 	lwiot_destroy();
 	return -EXIT_SUCCESS;
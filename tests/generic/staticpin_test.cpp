@@ -0,0 +1,267 @@
+/*
+ * Unit test for compile-time GPIO pins.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/io/gpiopin.h>
+#include <lwiot/io/staticpin.h>
+
+#ifdef NDEBUG
+#error "Debugging not enabled.."
+#endif
+
+using namespace lwiot;
+
+/* Port emulated in memory. Every rising edge of the clock pin records the data pin. */
+struct MemoryPort {
+	static uint32_t state;
+	static uint32_t direction;
+	static uint32_t accesses;
+	static uint32_t log;
+	static int edges;
+
+	static constexpr uint32_t clock = 1UL << 5;
+	static constexpr uint32_t data = 1UL << 6;
+
+	static void update(uint32_t next)
+	{
+		if((next & clock) && !(state & clock))
+			log = (log << 1) | ((next & data) ? 1 : 0), edges++;
+
+		state = next;
+		accesses++;
+	}
+
+	static void set(uint32_t mask)
+	{
+		update(state | mask);
+	}
+
+	static void clear(uint32_t mask)
+	{
+		update(state & ~mask);
+	}
+
+	/* Inputs float high, as if pulled up. */
+	static uint32_t read()
+	{
+		accesses++;
+		return (state & direction) | ~direction;
+	}
+
+	static void output(uint32_t mask)
+	{
+		direction |= mask;
+	}
+
+	static void input(uint32_t mask)
+	{
+		direction &= ~mask;
+	}
+
+	static bool registers(GpioFastPin& fast)
+	{
+		return false;
+	}
+
+	static void reset()
+	{
+		state = direction = accesses = log = 0;
+		edges = 0;
+	}
+};
+
+uint32_t MemoryPort::state;
+uint32_t MemoryPort::direction;
+uint32_t MemoryPort::accesses;
+uint32_t MemoryPort::log;
+int MemoryPort::edges;
+
+typedef StaticPin<MemoryPort, 3> Led;
+typedef StaticPin<MemoryPort, 5> Clock;
+typedef StaticPin<MemoryPort, 6> Data;
+
+static void pin_test()
+{
+	MemoryPort::reset();
+
+	static_assert(Led::mask == 0x8, "Wrong pin mask");
+	static_assert(sizeof(Led) == 1, "A static pin has no state");
+
+	Led::output();
+	Led::high();
+	assert(Led::read());
+	assert(MemoryPort::state == 0x8);
+
+	Led::low();
+	assert(!Led::read());
+
+	/* Open drain: released lines are pulled up, pulled lines read low. */
+	Led::pull();
+	assert(!Led::read());
+	Led::release();
+	assert(Led::read());
+
+	/* One port access per operation. */
+	MemoryPort::accesses = 0;
+	Led::write(true);
+	Led::read();
+	assert(MemoryPort::accesses == 2);
+
+	print_dbg("Pin test passed!\n");
+}
+
+static void shift_test()
+{
+	MemoryPort::reset();
+	Clock::output();
+	Data::output();
+
+	shiftOut(Data(), Clock(), false, 0xA5);
+	assert(MemoryPort::edges == 8);
+	assert(MemoryPort::log == 0xA5);
+
+	MemoryPort::reset();
+	Clock::output();
+	Data::output();
+
+	shiftOut(Data(), Clock(), true, 0x0F, 4);
+	assert(MemoryPort::edges == 4);
+	assert(MemoryPort::log == 0xF);
+
+	/* The data pin floats high as an input. */
+	Data::input();
+	assert(shiftIn(Data(), Clock(), false) == 0xFF);
+
+	print_dbg("Shift test passed!\n");
+}
+
+static void adapter_test()
+{
+	StaticGpioChip<MemoryPort> chip;
+	GpioPin led(3, chip), clock(5, chip), data(6, chip);
+	GpioFastPin fast;
+
+	MemoryPort::reset();
+
+	led.output();
+	led.write(true);
+	assert(led.read());
+	assert(Led::read());
+
+	/* The port has no memory mapped registers to hand out. */
+	assert(!led.fastPin(fast));
+
+	led.setOpenDrain();
+	led.write(false);
+	assert(!led.read());
+	led.write(true);
+	assert(led.read());
+	assert((MemoryPort::direction & Led::mask) == 0);
+
+	chip.writeMask(0x40, 0x08);
+	assert(chip.readPort() & 0x40);
+
+	/* Code written against the static interface takes run time pins through DynamicPin. */
+	clock.output();
+	data.output();
+	MemoryPort::log = 0;
+	MemoryPort::edges = 0;
+
+	DynamicPin dclock(clock), ddata(data);
+	shiftOut(ddata, dclock, false, 0x3C);
+	assert(MemoryPort::log == 0x3C);
+
+	MemoryPort::log = 0;
+	data.shiftOut(clock, false, 0x81, 8, 0);
+	assert(MemoryPort::log == 0x81);
+
+	print_dbg("Adapter test passed!\n");
+}
+
+static uint32_t words[3];
+
+struct WordPort {
+	static void set(uint32_t mask)
+	{
+		words[0] = mask;
+	}
+
+	static void clear(uint32_t mask)
+	{
+		words[1] = mask;
+	}
+
+	static uint32_t read()
+	{
+		return words[2];
+	}
+
+	static void output(uint32_t mask)
+	{
+	}
+
+	static void input(uint32_t mask)
+	{
+	}
+
+	static bool registers(GpioFastPin& fast)
+	{
+		fast.set = &words[0];
+		fast.clear = &words[1];
+		fast.in = &words[2];
+
+		return true;
+	}
+};
+
+static void fast_test()
+{
+	typedef StaticPin<WordPort, 7> Pin;
+	StaticGpioChip<WordPort> chip;
+	GpioPin pin(7, chip);
+	GpioFastPin fast;
+
+	auto registers = Pin::fast();
+
+	assert(registers.mask == 0x80);
+	assert(registers.set == &words[0]);
+
+	assert(pin.fastPin(fast));
+	assert(fast.mask == 0x80);
+
+	fast.high();
+	assert(words[0] == 0x80);
+	fast.low();
+	assert(words[1] == 0x80);
+
+	words[2] = 0x80;
+	assert(Pin::read());
+
+	print_dbg("Fast pin test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	pin_test();
+	shift_test();
+	adapter_test();
+	fast_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
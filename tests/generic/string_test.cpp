@@ -11,12 +11,75 @@
 #include <assert.h>
 
 #include <lwiot/stl/string.h>
+#include <lwiot/stl/move.h>
+#include <lwiot/stl/stringview.h>
 #include <lwiot/log.h>
 #include <lwiot/test.h>
 
 #define FOOBAR_STR "The usual: Foo Bar"
 #define HELLOWORLD_STR "The usual: Hello, World!"
 
+class InspectableString : public lwiot::String {
+public:
+	InspectableString(const char *cstr) : lwiot::String(cstr)
+	{
+	}
+
+	using lwiot::String::isInline;
+	using lwiot::String::operator=;
+};
+
+static void inline_storage_test()
+{
+	InspectableString small("topic/a");
+	InspectableString empty("");
+
+	assert(small.isInline());
+	assert(empty.isInline());
+
+	small += "/sensor/x";
+	assert(!small.isInline());
+	assert(small == "topic/a/sensor/x");
+
+	small = "abc";
+	assert(small == "abc");
+	assert(small.length() == 3);
+
+	lwiot::String inlined("short");
+	lwiot::String moved(lwiot::stl::move(inlined));
+	assert(moved == "short");
+
+	lwiot::String target("a string that lives on the heap");
+	lwiot::String source("tiny");
+	target = lwiot::stl::move(source);
+	assert(target == "tiny");
+
+	lwiot::String fresh;
+	fresh = lwiot::stl::move(target);
+	assert(fresh == "tiny");
+	assert(strlen(fresh.c_str()) == 4);
+}
+
+static void append_test()
+{
+	lwiot::String response;
+	lwiot::StringView reason("OK");
+	uint8_t version = 1;
+
+	response.append("HTTP/1.", version, ' ', 200, ' ', reason, "\r\n");
+	assert(response == "HTTP/1.1 200 OK\r\n");
+
+	response.append(lwiot::String("Content-Length: "), 1024UL, "\r\n");
+	assert(response == "HTTP/1.1 200 OK\r\nContent-Length: 1024\r\n");
+
+	lwiot::String twice("ab");
+	twice.append(twice, '-', twice);
+	assert(twice == "abab-ab");
+
+	lwiot::String chain = lwiot::String("HTTP/1.") + 1 + ' ' + 404 + " Not Found" + "\r\n";
+	assert(chain == "HTTP/1.1 404 Not Found\r\n");
+}
+
 int main(int argc, char **argv)
 {
 	lwiot_init();
@@ -37,6 +100,9 @@ int main(int argc, char **argv)
 	assert(strcmp(s5.c_str(), FOOBAR_STR) == 0);
 	assert(strcmp(s3.c_str(), HELLOWORLD_STR) == 0);
 
+	inline_storage_test();
+	append_test();
+
 	wait_close();
 	return -EXIT_SUCCESS;
 }
@@ -0,0 +1,88 @@
+/*
+ * String view unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/stringview.h>
+#include <lwiot/stl/unorderedmap.h>
+#include <lwiot/stl/map.h>
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+static constexpr lwiot::StringView Prefix("sensors/");
+static_assert(Prefix.length() == 8, "StringView length must be computed at compile time");
+
+static void stringview_basic_test()
+{
+	const char *request = "GET /index.html?user=test HTTP/1.1";
+	lwiot::StringView line(request);
+
+	auto method = line.substr(0, line.find(' '));
+	assert(method == "GET");
+
+	auto start = line.find(' ') + 1;
+	auto uri = line.substr(start, line.find(' ', start) - start);
+	assert(uri == "/index.html?user=test");
+	assert(uri.startsWith("/index"));
+	assert(uri.find("user=") == 12);
+	assert(uri.find("nope") == lwiot::StringView::npos);
+	assert(line.endsWith("HTTP/1.1"));
+	assert(line.rfind('/') == 30);
+
+	lwiot::String owned = uri.toString();
+	assert(owned == "/index.html?user=test");
+	assert(owned == uri);
+
+	lwiot::StringView padded("  value \r\n");
+	assert(padded.trim() == "value");
+	assert(lwiot::StringView("Content-Type").equalsIgnoreCase("content-type"));
+	assert(lwiot::StringView("abc").compare("abd") < 0);
+	assert(lwiot::StringView("abc").compare("ab") > 0);
+	assert(line.substr(100).empty());
+}
+
+static void stringview_lookup_test()
+{
+	lwiot::stl::UnorderedMap<lwiot::String, int> table;
+	lwiot::stl::Map<lwiot::String, int> map;
+	const char *buffer = "temperature;humidity";
+	lwiot::StringView input(buffer);
+
+	table.add("temperature", 1);
+	table.add("humidity", 2);
+	map.add("humidity", 3);
+
+	auto temp = input.substr(0, input.find(';'));
+	auto hum = input.substr(input.find(';') + 1);
+
+	assert(table.find(temp) != table.end());
+	assert(table.find(temp)->value == 1);
+	assert(table.contains(hum));
+	assert(!table.contains(lwiot::StringView("pressure")));
+
+	assert(map.contains(hum));
+	assert(map.find(hum)->value == 3);
+	assert(!map.contains(temp));
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	stringview_basic_test();
+	stringview_lookup_test();
+	print_dbg("String view test done!\n");
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+/*
+ * TCP client read-ahead unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/bytebuffer.h>
+#include <lwiot/network/tcpclient.h>
+
+class MemoryClient : public lwiot::TcpClient {
+public:
+	explicit MemoryClient(const char *data, size_t segment) :
+		TcpClient(), calls(0), _data(data), _length(strlen(data)), _segment(segment)
+	{
+	}
+
+	explicit operator bool() const override
+	{
+		return true;
+	}
+
+	bool connected() const override
+	{
+		return true;
+	}
+
+	size_t available() const override
+	{
+		return this->_readahead.available() + this->_length;
+	}
+
+	using TcpClient::read;
+	using TcpClient::write;
+
+	ssize_t read(void *output, const size_t& length) override
+	{
+		return this->readBuffered(output, length);
+	}
+
+	ssize_t write(const void *bytes, const size_t& length) override
+	{
+		return length;
+	}
+
+	bool connect(const lwiot::IPAddress& addr, uint16_t port) override
+	{
+		return true;
+	}
+
+	bool connect(const lwiot::String& host, uint16_t port) override
+	{
+		return true;
+	}
+
+	void close() override
+	{
+	}
+
+	int calls;
+
+protected:
+	ssize_t receive(void *output, size_t length) override
+	{
+		if(length > this->_segment)
+			length = this->_segment;
+
+		if(length > this->_length)
+			length = this->_length;
+
+		memcpy(output, this->_data, length);
+		this->_data += length;
+		this->_length -= length;
+		this->calls++;
+
+		return length;
+	}
+
+private:
+	const char *_data;
+	size_t _length;
+	size_t _segment;
+};
+
+static void readahead_readuntil_test()
+{
+	MemoryClient client("GET /index.html HTTP/1.1\r\nHost: example.com\r\n\r\nbody", 1024);
+	lwiot::ByteBuffer line;
+
+	auto num = client.readUntil('\r', line);
+	assert(num == 24);
+	assert(memcmp(line.data(), "GET /index.html HTTP/1.1", 24) == 0);
+	assert(client.read() == '\n');
+
+	assert(client.readStringUntil('\r') == "Host: example.com");
+	assert(client.skipUntil('\n') == 0);
+	assert(client.skipUntil('\n') == 1);
+
+	auto span = client.peekSpan();
+	assert(span.size() == 4);
+	assert(memcmp(span.buffer(), "body", 4) == 0);
+
+	/* Everything was served from a single socket read. */
+	assert(client.calls == 1);
+}
+
+static void readahead_segmented_test()
+{
+	MemoryClient client("first line\nsecond line\n", 3);
+	char output[4];
+
+	assert(client.readStringUntil('\n') == "first line");
+	/* Only the buffered remainder of the last segment is returned. */
+	assert(client.read(output, 4) == 1);
+	assert(output[0] == 's');
+	assert(client.readStringUntil('\n') == "econd line");
+
+	/* The stream is exhausted: return what is left. */
+	assert(client.readStringUntil('\n') == "");
+	assert(client.available() == 0);
+
+	print_dbg("TCP client read-ahead test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	readahead_readuntil_test();
+	readahead_segmented_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
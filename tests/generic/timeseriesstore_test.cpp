@@ -0,0 +1,266 @@
+/*
+ * Time-series store unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/test.h>
+
+#include <lwiot/stl/vector.h>
+#include <lwiot/device/sensorscheduler.h>
+#include <lwiot/util/timeseriesstore.h>
+#include <lwiot/util/samplebatch.h>
+
+#define BLOCKS 8
+#define BLOCKSIZE 128
+
+/* Store in RAM. The memory outlives the store, to test remounting. */
+class MemoryTimeSeriesStore : public lwiot::TimeSeriesStore {
+public:
+	explicit MemoryTimeSeriesStore(uint8_t *memory) : TimeSeriesStore(BLOCKS, BLOCKSIZE), _memory(memory)
+	{
+	}
+
+protected:
+	bool read(size_t offset, void *data, size_t length) override
+	{
+		if(offset + length > this->storage())
+			return false;
+
+		memcpy(data, this->_memory + offset, length);
+		return true;
+	}
+
+	bool write(size_t offset, const void *data, size_t length) override
+	{
+		if(offset + length > this->storage())
+			return false;
+
+		memcpy(this->_memory + offset, data, length);
+		return true;
+	}
+
+private:
+	uint8_t *_memory;
+};
+
+struct Point {
+	time_t timestamp;
+	double value;
+};
+
+static lwiot::stl::Vector<Point> collect(lwiot::TimeSeriesStore& store, time_t from, time_t to)
+{
+	lwiot::stl::Vector<Point> points;
+
+	auto count = store.query(from, to, [&points](time_t timestamp, double value) {
+		points.pushback(Point{ timestamp, value });
+		return true;
+	});
+
+	assert(count == points.size());
+	return points;
+}
+
+/* A sample every second with some jitter, of a slowly changing temperature. */
+static Point sample(int idx)
+{
+	time_t timestamp = 1000000 + idx * 1000 + (idx % 7 == 0 ? 3 : 0);
+	double value = 21.0 + (idx / 10) * 0.25;
+
+	return Point{ timestamp, value };
+}
+
+static void timeseries_roundtrip_test()
+{
+	uint8_t memory[BLOCKS * BLOCKSIZE] = {};
+	MemoryTimeSeriesStore store(memory);
+	int points = 0;
+
+	assert(store.empty());
+
+	/* Fill half of the ring. */
+	for(; points < 1000; points++) {
+		auto point = sample(points);
+		assert(store.add(point.timestamp, point.value));
+
+		if(memory[(BLOCKS / 2) * BLOCKSIZE] != 0)
+			break;
+	}
+
+	/* Four blocks of 100 bytes of payload hold far more than 4 * 100 / 16 raw points. */
+	assert(points > 4 * 100 / 4);
+	assert(!store.empty());
+
+	auto all = collect(store, 0, 100000000);
+	assert(all.size() == static_cast<size_t>(points) + 1);
+
+	for(size_t idx = 0; idx < all.size(); idx++) {
+		auto expected = sample(static_cast<int>(idx));
+
+		assert(all[idx].timestamp == expected.timestamp);
+		assert(all[idx].value == expected.value);
+	}
+
+	/* Range queries are inclusive on both ends. */
+	auto range = collect(store, sample(50).timestamp, sample(60).timestamp);
+	assert(range.size() == 11);
+	assert(range[0].timestamp == sample(50).timestamp);
+	assert(range[10].timestamp == sample(60).timestamp);
+
+	assert(collect(store, 0, 999999).size() == 0);
+
+	/* Timestamps may not go back. */
+	assert(!store.add(sample(0).timestamp, 1.0));
+
+	print_dbg("Time-series round trip test done!\n");
+}
+
+static void timeseries_irregular_test()
+{
+	uint8_t memory[BLOCKS * BLOCKSIZE] = {};
+	MemoryTimeSeriesStore store(memory);
+	const Point points[] = {
+		{ 10, 1.5 }, { 10, -1.5 }, { 20, 0.0 }, { 5000, 1e300 }, { 5001, -1e-300 },
+		{ 5000000000ULL, 3.14159 }, { 5000000100ULL, 3.14159 }, { 5000000100ULL, 2.71828 }, { 5000000300ULL, 42.0 }
+	};
+	size_t count = sizeof(points) / sizeof(points[0]);
+
+	for(size_t idx = 0; idx < count; idx++)
+		assert(store.add(points[idx].timestamp, points[idx].value));
+
+	auto all = collect(store, 0, 6000000000ULL);
+	assert(all.size() == count);
+
+	for(size_t idx = 0; idx < count; idx++) {
+		assert(all[idx].timestamp == points[idx].timestamp);
+		assert(all[idx].value == points[idx].value);
+	}
+
+	/* A visitor can stop the query. */
+	size_t visited = store.query(0, 6000000000ULL, [](time_t timestamp, double value) {
+		UNUSED(value);
+		return timestamp < 5000;
+	});
+	assert(visited == 4);
+
+	print_dbg("Irregular time-series test done!\n");
+}
+
+static void timeseries_ring_test()
+{
+	uint8_t memory[BLOCKS * BLOCKSIZE] = {};
+	MemoryTimeSeriesStore store(memory);
+	int total = 20000;
+
+	/* Noisy values do not compress well, so the ring wraps many times. */
+	for(int idx = 0; idx < total; idx++)
+		assert(store.add(idx * 1000, static_cast<double>((idx * 7919) % 1000) / 7.0));
+
+	auto all = collect(store, 0, total * 1000);
+
+	assert(all.size() > 0 && all.size() < static_cast<size_t>(total));
+	assert(all[all.size() - 1].timestamp == static_cast<time_t>((total - 1) * 1000));
+
+	/* What is left is a contiguous run of the newest points. */
+	for(size_t idx = 1; idx < all.size(); idx++)
+		assert(all[idx].timestamp == all[idx - 1].timestamp + 1000);
+
+	auto first = static_cast<int>(all[0].timestamp / 1000);
+	assert(all[0].value == static_cast<double>((first * 7919) % 1000) / 7.0);
+
+	/* After a flush, everything survives a reset. */
+	assert(store.flush());
+
+	MemoryTimeSeriesStore remounted(memory);
+	auto after = collect(remounted, 0, total * 1000);
+
+	assert(after.size() > 0);
+	assert(after[after.size() - 1].timestamp == all[all.size() - 1].timestamp);
+	assert(after[0].timestamp >= all[0].timestamp);
+
+	/* New points go into a new block, behind the flushed one. */
+	assert(!remounted.add(0, 1.0));
+	assert(remounted.add(total * 1000, 1.0));
+	assert(collect(remounted, total * 1000, total * 1000).size() == 1);
+
+	remounted.clear();
+	assert(remounted.empty());
+
+	MemoryTimeSeriesStore cleared(memory);
+	assert(cleared.empty());
+
+	print_dbg("Time-series ring test done!\n");
+}
+
+static void timeseries_reading_test()
+{
+	uint8_t memory[BLOCKS * BLOCKSIZE] = {};
+	MemoryTimeSeriesStore store(memory);
+	lwiot::SensorReading reading;
+
+	memset(&reading, 0, sizeof(reading));
+	reading.timestamp = 500;
+	reading.ok = true;
+	reading.count = 2;
+	reading.values[0] = 21.5f;
+	reading.values[1] = 55.0f;
+
+	assert(store.add(reading, 1));
+	assert(!store.add(reading, 2));
+
+	reading.ok = false;
+	assert(!store.add(reading));
+
+	auto all = collect(store, 0, 1000);
+	assert(all.size() == 1);
+	assert(all[0].timestamp == 500 && all[0].value == 55.0);
+
+	print_dbg("Sensor reading test done!\n");
+}
+
+static void timeseries_batch_test()
+{
+	uint8_t memory[BLOCKS * BLOCKSIZE] = {};
+	MemoryTimeSeriesStore store(memory);
+	lwiot::SampleBatch batch(32);
+
+	for(int idx = 0; idx < 16; idx++) {
+		assert(batch.add(1000 + idx * 100, 1, 20.0f + idx * 0.5f));
+		assert(batch.add(1000 + idx * 100, 2, 50.0f));
+	}
+
+	assert(store.add(batch, 1) == 16);
+
+	auto all = collect(store, 0, 100000);
+	assert(all.size() == 16);
+	assert(all[3].timestamp == 1300 && all[3].value == 21.5);
+
+	/* Points older than the newest one stop the batch. */
+	assert(store.add(batch, 2) == 0);
+
+	print_dbg("Sample batch test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	timeseries_roundtrip_test();
+	timeseries_irregular_test();
+	timeseries_ring_test();
+	timeseries_reading_test();
+	timeseries_batch_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
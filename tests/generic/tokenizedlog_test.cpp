@@ -0,0 +1,171 @@
+/*
+ * Tokenized logging unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+#include <lwiot/ringbufferstream.h>
+#include <lwiot/util/tokenizedlog.h>
+
+#ifdef __linux__
+extern "C" const char __start_lwiot_tokens[];
+extern "C" const char __stop_lwiot_tokens[];
+#endif
+
+static size_t skip_header(const uint8_t *record, uint32_t token, uint8_t header)
+{
+	uint32_t value = record[1] | record[2] << 8 | record[3] << 16 | static_cast<uint32_t>(record[4]) << 24;
+	size_t idx = 5;
+
+	assert(value == token);
+
+	while(record[idx] & 0x80)
+		idx++;
+
+	assert(record[idx + 1] == header);
+	return idx + 2;
+}
+
+static void test_encode()
+{
+	lwiot::RingBufferStream stream(256);
+	lwiot::TokenizedLogger log(stream);
+	uint8_t record[64];
+
+	LWIOT_LOG_TOKENIZED_LEVEL(log, lwiot::LogLevel::Warning, "value {} of {}", -3, 300U);
+
+	auto length = stream.available();
+	assert(length <= sizeof(record));
+	stream.read(record, length);
+	assert(record[0] + 1U == length);
+
+	/* Kinds 1 and 2 in one byte, then -3 zigzag encoded and 300 as two bytes. */
+	auto idx = skip_header(record, lwiot::detail::log_token("value {} of {}"), 0x22);
+	assert(record[idx++] == 0x21);
+	assert(record[idx++] == 5);
+	assert(record[idx++] == 0xAC && record[idx++] == 0x02);
+	assert(idx == length);
+
+	LWIOT_LOG_TOKENIZED(log, "{:.2} {} {}", 0.5, "text", true);
+
+	length = stream.available();
+	stream.read(record, length);
+	idx = skip_header(record, lwiot::detail::log_token("{:.2} {} {}"), 0x13);
+
+	/* 0.5 fits a float exactly. */
+	assert(record[idx++] == 0x63 && record[idx++] == 0x05);
+	idx += 4;
+	assert(record[idx++] == 4 && memcmp(record + idx, "text", 4) == 0);
+	idx += 4;
+	assert(record[idx++] == 1);
+	assert(idx == length);
+
+	print_dbg("Tokenized log encode test done!\n");
+}
+
+static void test_truncate()
+{
+	lwiot::detail::FormatArg args[3];
+	char text[128];
+	uint8_t record[32];
+
+	memset(text, 'a', sizeof(text));
+	args[0].kind = lwiot::detail::FormatKind::Unsigned;
+	args[0].u = 1;
+	args[1].kind = lwiot::detail::FormatKind::String;
+	args[1].s = text;
+	args[1].length = sizeof(text);
+	args[2].kind = lwiot::detail::FormatKind::Float;
+	args[2].f = 0.1;
+
+	/* The string is cut off, and the argument after it is left out along with its kind. */
+	auto length = lwiot::detail::encode_log_record(record, sizeof(record), lwiot::LogLevel::Info, 1, 0, args, 3);
+	assert(length == sizeof(record) - 1);
+	assert(record[0] == length - 1);
+	assert(record[6] == 0x12 && record[7] == 0x62);
+	assert(record[8] == 1 && record[9] == length - 10);
+	assert(record[10] == 'a' && record[length - 1] == 'a');
+
+	assert(lwiot::detail::encode_log_record(record, 4, lwiot::LogLevel::Info, 1, 0, args, 3) == 0);
+
+	print_dbg("Tokenized log truncate test done!\n");
+}
+
+static void test_section()
+{
+#ifdef __linux__
+	const char *fmt = "value {} of {}";
+	bool found = false;
+
+	for(auto entry = __start_lwiot_tokens; entry < __stop_lwiot_tokens; entry += strlen(entry) + 1) {
+		while(*entry == '\0' && entry < __stop_lwiot_tokens)
+			entry++;
+
+		if(strcmp(entry, fmt) == 0)
+			found = true;
+	}
+
+	assert(found);
+	print_dbg("Tokenized log section test done!\n");
+#endif
+}
+
+static void test_sink()
+{
+	lwiot::RingBufferStream stream(1024);
+	lwiot::TokenizedLogSink sink(stream);
+	lwiot::AsyncLogBackend backend(sink, lwiot::AsyncLogBackend::Policy::Block);
+	lwiot::TokenizedLogger tokenized(backend);
+	lwiot::Logger log("sink");
+	uint8_t data[1024];
+
+	backend.begin();
+	lwiot::Logger::setBackend(&backend);
+
+	LWIOT_LOG_TOKENIZED(tokenized, "value {} of {}", 1, 2U);
+	log.println("text {}", 3);
+
+	backend.end();
+	lwiot::Logger::setBackend(nullptr);
+
+	auto length = stream.available();
+	stream.read(data, length);
+
+	/* The tokenized record as it was logged, followed by the text as token 0. */
+	auto idx = skip_header(data, lwiot::detail::log_token("value {} of {}"), 0x12);
+	assert(idx + 3 == data[0] + 1U);
+
+	auto text = data + data[0] + 1;
+	idx = skip_header(text, 0, 0x13);
+	assert(text[idx] == 0x66 && text[idx + 1] == 0x02);
+	assert(text[idx + 2] == 4 && memcmp(text + idx + 3, "sink", 4) == 0);
+	assert(text[idx + 7] == 6 && memcmp(text + idx + 8, "text 3", 6) == 0);
+	assert(text[idx + 14] == (lwiot::LogRecord::Start | lwiot::LogRecord::End));
+	assert(data[0] + text[0] + 2U == length);
+
+	print_dbg("Tokenized log sink test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	test_encode();
+	test_truncate();
+	test_section();
+	test_sink();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+/*
+ * MQTT topic trie unit test.
+ *
+ * Author: Michel Megens
+ * Email: dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/network/topictrie.h>
+#include <lwiot/test.h>
+
+static int matches(const lwiot::TopicTrie<int>& trie, const char *topic)
+{
+	int mask = 0;
+
+	trie.match(topic, [&mask](int value) {
+		mask |= 1 << value;
+	});
+
+	return mask;
+}
+
+static void test_split()
+{
+	lwiot::StringView levels[4];
+
+	assert(lwiot::TopicTrie<int>::split("site/1/sensor", levels, 4) == 3);
+	assert(levels[0].equals("site"));
+	assert(levels[2].equals("sensor"));
+
+	assert(lwiot::TopicTrie<int>::split("/a/", levels, 4) == 3);
+	assert(levels[0].empty() && levels[1].equals("a") && levels[2].empty());
+
+	assert(lwiot::TopicTrie<int>::split("a/b/c/d/e", levels, 4) == 0);
+	assert(lwiot::TopicTrie<int>::split("", levels, 4) == 0);
+
+	assert(lwiot::TopicTrie<int>::unshare("$share/workers/jobs/#").equals("jobs/#"));
+	assert(lwiot::TopicTrie<int>::unshare("$SYS/uptime").equals("$SYS/uptime"));
+	assert(lwiot::TopicTrie<int>::unshare("$share/workers").equals("$share/workers"));
+}
+
+static void test_wildcards()
+{
+	lwiot::TopicTrie<int> trie;
+
+	assert(trie.add("site/+/sensor/#", 0));
+	assert(trie.add("site/hall/sensor/temp", 1));
+	assert(trie.add("site/#", 2));
+	assert(trie.add("#", 3));
+	assert(trie.add("+/+", 4));
+	assert(trie.add("site/hall/sensor/temp", 5));
+	assert(trie.size() == 6);
+
+	assert(matches(trie, "site/hall/sensor/temp") == 0x2F);
+	assert(matches(trie, "site/roof/sensor") == 0x0D);
+	assert(matches(trie, "site/roof/actuator") == 0x0C);
+	assert(matches(trie, "site") == 0x0C);
+	assert(matches(trie, "home/hall") == 0x18);
+	assert(matches(trie, "$SYS/uptime") == 0);
+
+	assert(!trie.add("site/#/sensor", 6));
+	assert(!trie.add("site/ha+", 6));
+	assert(!trie.add("", 6));
+}
+
+static void test_remove()
+{
+	lwiot::TopicTrie<int> trie;
+
+	trie.add("a/b", 1);
+	trie.add("a/b", 2);
+	trie.add("a/+/c", 3);
+	trie.add("$SYS/#", 4);
+
+	assert(matches(trie, "$SYS/uptime") == 0x10);
+	assert(trie.remove("a/b") == 2);
+	assert(trie.remove("a/b") == 0);
+	assert(matches(trie, "a/b") == 0);
+	assert(matches(trie, "a/b/c") == 0x08);
+
+	assert(trie.remove("a/+/c") == 1);
+	assert(matches(trie, "a/b/c") == 0);
+	assert(trie.size() == 1);
+
+	trie.clear();
+	assert(trie.empty());
+	assert(matches(trie, "$SYS/uptime") == 0);
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	test_split();
+	test_wildcards();
+	test_remove();
+
+	print_dbg("Topic trie test successful!\n");
+
+	wait_close();
+	lwiot_destroy();
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+/*
+ * Tracing span unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#define CONFIG_TRACE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+#include <lwiot/util/trace.h>
+#include <lwiot/kernel/functionalthread.h>
+
+#define THREADS 3
+#define SPANS   50
+
+static char text[1 << 16];
+static size_t length;
+
+static bool capture()
+{
+	length = 0;
+
+	return lwiot::Tracer::write([](const char *data, size_t size) {
+		assert(length + size < sizeof(text));
+		memcpy(text + length, data, size);
+		length += size;
+		return true;
+	});
+}
+
+static size_t count(const char *needle)
+{
+	size_t num = 0;
+
+	for(auto ptr = strstr(text, needle); ptr != nullptr; ptr = strstr(ptr + 1, needle))
+		num++;
+
+	return num;
+}
+
+static void test_spans()
+{
+	lwiot::Tracer::setThreadName("main \"thread\"");
+
+	{
+		TRACE_SPAN("outer");
+
+		{
+			TRACE_SPAN("inner");
+			lwiot_sleep(2);
+		}
+	}
+
+	assert(capture());
+	text[length] = '\0';
+
+	assert(strncmp(text, "{\"traceEvents\":[", 16) == 0);
+	assert(strcmp(text + length - 3, "]}\n") == 0);
+	assert(strstr(text, "\"args\":{\"name\":\"main \\\"thread\\\"\"}") != nullptr);
+
+	/* Spans are written when they end, so the inner span comes first. */
+	auto inner = strstr(text, "{\"name\":\"inner\",\"ph\":\"X\"");
+	auto outer = strstr(text, "{\"name\":\"outer\",\"ph\":\"X\"");
+	assert(inner != nullptr && outer != nullptr && inner < outer);
+
+	double ts_inner, dur_inner, ts_outer, dur_outer;
+	assert(sscanf(strstr(inner, "\"ts\":"), "\"ts\":%lf,\"dur\":%lf", &ts_inner, &dur_inner) == 2);
+	assert(sscanf(strstr(outer, "\"ts\":"), "\"ts\":%lf,\"dur\":%lf", &ts_outer, &dur_outer) == 2);
+	assert(dur_inner >= 2000.0 && dur_outer >= dur_inner);
+	assert(ts_outer <= ts_inner && ts_outer + dur_outer >= ts_inner + dur_inner);
+
+	/* A second write only holds what was recorded since. */
+	assert(capture());
+	text[length] = '\0';
+	assert(count("\"ph\":\"X\"") == 0);
+
+	print_dbg("Trace span test done!\n");
+}
+
+static void test_threads()
+{
+	lwiot::FunctionalThread *threads[THREADS];
+
+	for(auto& thread : threads) {
+		thread = new lwiot::FunctionalThread("trace-test");
+		thread->start([]() {
+			lwiot::Tracer::setThreadName("worker");
+
+			for(int idx = 0; idx < SPANS; idx++) {
+				TRACE_SPAN("work");
+			}
+		});
+	}
+
+	for(auto thread : threads) {
+		thread->join();
+		delete thread;
+	}
+
+	/* Buffers of threads that exited are written all the same. */
+	assert(capture());
+	text[length] = '\0';
+	assert(count("{\"name\":\"work\"") == THREADS * SPANS);
+
+	/* Threads that overflow their buffer lose their oldest spans. */
+	auto dropped = lwiot::Tracer::dropped();
+
+	for(int idx = 0; idx < CONFIG_TRACE_EVENTS + 10; idx++) {
+		TRACE_SPAN("many");
+	}
+
+	assert(capture());
+	text[length] = '\0';
+	assert(count("{\"name\":\"many\"") == CONFIG_TRACE_EVENTS);
+	assert(lwiot::Tracer::dropped() == dropped + 10);
+
+	print_dbg("Trace thread test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	test_spans();
+	test_threads();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
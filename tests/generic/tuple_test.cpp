@@ -22,6 +22,50 @@ constexpr bool Equals(float a, float b)
 	return (diff < FLT_EPSILON) && (-diff < FLT_EPSILON);
 }
 
+static int sum(int a, int b, int c)
+{
+	return a + b + c;
+}
+
+static void apply_test()
+{
+	auto args = lwiot::stl::MakeTuple(1, 2, 3);
+	const auto& cargs = args;
+	lwiot::stl::Tuple<> empty;
+
+	assert(lwiot::stl::apply(sum, args) == 6);
+	assert(lwiot::stl::apply(sum, cargs) == 6);
+	assert(lwiot::stl::apply([](int a, int b, int c) { return a * b * c; }, lwiot::stl::MakeTuple(2, 3, 4)) == 24);
+	assert(lwiot::stl::apply([]() { return 7; }, empty) == 7);
+
+	lwiot::stl::apply([](int& a, int&, int&) { a = 10; }, args);
+	assert(lwiot::stl::get<0>(args) == 10);
+}
+
+static void bind_front_test()
+{
+	int counter = 0;
+
+	auto add = lwiot::stl::bind_front(sum, 1, 2);
+	assert(add(3) == 6);
+
+	auto all = lwiot::stl::bind_front(sum, 1, 2, 3);
+	assert(all() == 6);
+
+	auto none = lwiot::stl::bind_front(sum);
+	assert(none(4, 5, 6) == 15);
+
+	auto increment = lwiot::stl::bind_front([](int *value, int step) { *value += step; }, &counter);
+	increment(2);
+	increment(3);
+	assert(counter == 5);
+
+	auto concat = lwiot::stl::bind_front([](const lwiot::stl::String& a, const char *b) {
+		return a + b;
+	}, lwiot::stl::String("AB"));
+	assert(concat("C") == "ABC");
+}
+
 int main(int argc, char **argv)
 {
 	lwiot_init();
@@ -33,6 +77,9 @@ int main(int argc, char **argv)
 	assert(lwiot::stl::get<3>(tuple) == "ABC");
 	assert(Equals(lwiot::stl::get<float>(tuple), 211.9f));
 
+	apply_test();
+	bind_front_test();
+
 	lwiot_destroy();
 	wait_close();
 	return -EXIT_SUCCESS;
@@ -0,0 +1,107 @@
+/*
+ * Unordered map unit test.
+ *
+ * Author: Michel Megens
+ * Email: dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/types.h>
+#include <lwiot/log.h>
+#include <lwiot/stl/string.h>
+#include <lwiot/stl/unorderedmap.h>
+#include <lwiot/test.h>
+
+static void test_basic()
+{
+	lwiot::stl::String s1("test..");
+	lwiot::stl::UnorderedMap<int, lwiot::String> m1;
+
+	m1.add(5, "Hello");
+	m1.add(6, "World");
+	m1.add(1, "What?!");
+
+	lwiot::stl::UnorderedMap<int, lwiot::String> m2(lwiot::stl::move(m1));
+	assert(m1.size() == 0);
+
+	m2[4] = "Bla. Bla";
+	m2[6] = "Testing..";
+	m2[9] = "More testing..";
+	m2.add(6, lwiot::stl::move(s1));
+
+	assert(m2[6].equals("test.."));
+	assert(m2.contains(4));
+	assert(m2.contains(1));
+	assert(m2.size() == 5);
+
+	m2.remove(1);
+	m2.remove(4);
+
+	assert(m2.find(4) == m2.end());
+	auto iter = m2.find(5);
+	assert(iter != m2.end());
+	assert(iter->value.equals("Hello"));
+	assert(!m2.contains(1));
+	assert(!m2.contains(4));
+	assert(m2.size() == 3);
+
+	size_t num = 0;
+	for(auto& e : m2) {
+		print_dbg("Entry: [%i]: %s\n", e.key, e.value.c_str());
+		num++;
+	}
+
+	assert(num == m2.size());
+}
+
+static void test_strings()
+{
+	lwiot::stl::UnorderedMap<lwiot::stl::String, int> map;
+
+	for(int idx = 0; idx < 256; idx++) {
+		lwiot::stl::String topic("sensors/");
+
+		topic += idx;
+		map.add(topic, idx);
+	}
+
+	assert(map.size() == 256);
+	assert(map.capacity() * map.maxLoadFactor() >= 256);
+	assert(map.at("sensors/100") == 100);
+	assert(map.at("sensors/255") == 255);
+	assert(!map.contains("sensors/256"));
+
+	for(int idx = 0; idx < 256; idx += 2) {
+		lwiot::stl::String topic("sensors/");
+
+		topic += idx;
+		map.remove(topic);
+	}
+
+	assert(map.size() == 128);
+	assert(map.at("sensors/101") == 101);
+	assert(!map.contains("sensors/100"));
+
+	lwiot::stl::UnorderedMap<lwiot::stl::String, int> copy(map);
+	assert(copy.size() == 128);
+	assert(copy.at("sensors/1") == 1);
+
+	map.clear();
+	assert(map.empty());
+	assert(copy.contains("sensors/3"));
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	test_basic();
+	test_strings();
+
+	wait_close();
+	lwiot_destroy();
+	return -EXIT_SUCCESS;
+}
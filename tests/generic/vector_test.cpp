@@ -13,6 +13,63 @@
 #include <lwiot/log.h>
 #include <lwiot/test.h>
 #include <lwiot/stl/vector.h>
+#include <lwiot/stl/string.h>
+
+struct Counted {
+	explicit Counted(int v) : value(v)
+	{
+	}
+
+	Counted(const Counted& other) : value(other.value)
+	{
+		copies++;
+	}
+
+	Counted(Counted&& other) noexcept : value(other.value)
+	{
+		other.value = -1;
+		moves++;
+	}
+
+	Counted& operator=(const Counted& rhs) = default;
+
+	int value;
+
+	static int copies;
+	static int moves;
+};
+
+int Counted::copies = 0;
+int Counted::moves = 0;
+
+static void test_emplace()
+{
+	lwiot::stl::Vector<Counted> vec;
+	lwiot::stl::Vector<lwiot::stl::String> strings;
+
+	for(int idx = 0; idx < 16; idx++)
+		vec.emplace_back(idx);
+
+	assert(Counted::copies == 0);
+	assert(Counted::moves > 0);
+	assert(vec[15].value == 15);
+	assert(vec.back().value == 15);
+
+	for(int idx = 0; idx < 9; idx++)
+		strings.emplace_back("Hello");
+
+	strings[0] = "World";
+	assert(strings[8] == "Hello");
+	assert(strings[0] == "World");
+
+	lwiot::stl::Vector<lwiot::stl::String> copy(strings);
+	assert(copy.size() == 9);
+	assert(copy[0] == "World");
+
+	copy = lwiot::stl::Vector<lwiot::stl::String>();
+	copy.emplace_back("abc");
+	assert(copy.size() == 1);
+}
 
 struct IteratorTest {
 	void test_const_iter(const lwiot::stl::Vector<int>& vec) const
@@ -59,6 +116,8 @@ int main(int argc, char**argv)
 	assert(v2[0] == 2);
 	assert(v2[3] == 510);
 
+	test_emplace();
+
 	lwiot_destroy();
 	wait_close();
 	return -EXIT_SUCCESS;
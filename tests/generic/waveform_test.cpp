@@ -0,0 +1,154 @@
+/*
+ * Waveform unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/test.h>
+
+#include <lwiot/io/gpiochip.h>
+#include <lwiot/io/gpiopin.h>
+#include <lwiot/io/spibus.h>
+#include <lwiot/io/spimessage.h>
+#include <lwiot/io/waveform.h>
+#include <lwiot/io/spiwaveform.h>
+#include <lwiot/stl/vector.h>
+
+class RecordingChip : public lwiot::GpioChip {
+public:
+	explicit RecordingChip() : GpioChip(8)
+	{
+	}
+
+	void mode(int pin, const lwiot::PinMode& mode) override
+	{
+	}
+
+	void write(int pin, bool value) override
+	{
+		this->levels.pushback(value);
+	}
+
+	bool read(int pin) const override
+	{
+		return false;
+	}
+
+	void setOpenDrain(int pin) override
+	{
+	}
+
+	void odWrite(int pin, bool value) override
+	{
+	}
+
+	void attachIrqHandler(int pin, irq_handler_t handler, lwiot::IrqEdge edge) override
+	{
+	}
+
+	void detachIrqHandler(int pin) override
+	{
+	}
+
+	lwiot::stl::Vector<bool> levels;
+};
+
+class CaptureSpiBus : public lwiot::SpiBus {
+public:
+	explicit CaptureSpiBus() : SpiBus(1, 2, 3), length(0)
+	{
+	}
+
+	bool transfer(lwiot::SpiMessage& msg) override
+	{
+		this->length = msg.size();
+
+		for(size_t idx = 0; idx < msg.size() && idx < sizeof(this->data); idx++)
+			this->data[idx] = msg.txdata().data()[idx];
+
+		return true;
+	}
+	using SpiBus::transfer;
+
+	uint8_t data[8];
+	size_t length;
+};
+
+static void waveform_encode_test()
+{
+	lwiot::Waveform wave(416);
+	const uint8_t byte = 0x80;
+
+	/* At 416 ns a one is encoded as 110 and a zero as 100. */
+	wave.encode(&byte, 1, lwiot::Waveform::Ws2812Zero, lwiot::Waveform::Ws2812One);
+	assert(wave.samples() == 24);
+	assert(wave.size() == 3);
+	assert(wave.data()[0] == 0xD2 && wave.data()[1] == 0x49 && wave.data()[2] == 0x24);
+
+	wave.append(false, 50000);
+	assert(wave.samples() == 24 + 120);
+	assert(!wave.sample(30));
+
+	wave.clear();
+	wave.append(true, 100);
+	assert(wave.samples() == 1 && wave.sample(0));
+
+	print_dbg("Waveform encode test done!\n");
+}
+
+static void waveform_spi_test()
+{
+	CaptureSpiBus bus;
+	lwiot::SpiWaveform out(bus);
+	lwiot::Waveform wave(416);
+	const uint8_t bytes[] = { 0x80, 0x01 };
+
+	wave.encode(bytes, sizeof(bytes), lwiot::Waveform::Ws2812Zero, lwiot::Waveform::Ws2812One);
+	assert(out.write(wave));
+	assert(bus.length == 6);
+	assert(bus.frequency() == 1000000000UL / 416);
+	assert(bus.data[0] == 0xD2 && bus.data[3] == 0x92 && bus.data[5] == 0x26);
+
+	print_dbg("SPI waveform test done!\n");
+}
+
+static void waveform_gpio_test()
+{
+	RecordingChip chip;
+	lwiot::GpioPin pin(3, chip);
+	lwiot::Waveform wave(1000);
+	lwiot::Waveform fine(10);
+
+	wave.append(true, 2000);
+	wave.append(false, 1000);
+	wave.append(true, 1000);
+
+	assert(pin.waveform(wave));
+	assert(chip.levels.size() == 3);
+	assert(chip.levels[0] && !chip.levels[1] && chip.levels[2]);
+
+	fine.append(true, 100);
+	assert(!pin.waveform(fine));
+
+	print_dbg("GPIO waveform test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	waveform_encode_test();
+	waveform_spi_test();
+	waveform_gpio_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+/*
+ * WebSocket frame parser unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/network/sha1.h>
+#include <lwiot/network/websocket.h>
+
+using namespace lwiot;
+
+/* Build a masked client frame. */
+static size_t frame(uint8_t *output, uint8_t first, const char *payload, size_t length)
+{
+	static const uint8_t mask[] = { 0x37, 0xfa, 0x21, 0x3d };
+	size_t idx = 0;
+
+	output[idx++] = first;
+
+	if(length < 126) {
+		output[idx++] = 0x80 | length;
+	} else {
+		output[idx++] = 0x80 | 126;
+		output[idx++] = length >> 8;
+		output[idx++] = length & 0xFF;
+	}
+
+	memcpy(output + idx, mask, sizeof(mask));
+	idx += sizeof(mask);
+
+	for(size_t num = 0; num < length; num++)
+		output[idx++] = payload[num] ^ mask[num & 3];
+
+	return idx;
+}
+
+static void sha1_test()
+{
+	uint8_t digest[SHA1_DIGEST_SIZE];
+	static const uint8_t abc[] = {
+		0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e,
+		0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d
+	};
+	static const uint8_t two_blocks[] = {
+		0x84, 0x98, 0x3e, 0x44, 0x1c, 0x3b, 0xd2, 0x6e, 0xba, 0xae,
+		0x4a, 0xa1, 0xf9, 0x51, 0x29, 0xe5, 0xe5, 0x46, 0x70, 0xf1
+	};
+	const char *message = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+
+	sha1("abc", 3, digest);
+	assert(memcmp(digest, abc, sizeof(abc)) == 0);
+
+	sha1(message, strlen(message), digest);
+	assert(memcmp(digest, two_blocks, sizeof(two_blocks)) == 0);
+}
+
+static void handshake_test()
+{
+	char accept[32];
+	uint8_t head[websocket::MaxHeader];
+
+	/* The example of RFC 6455, section 1.3. */
+	websocket::accept("dGhlIHNhbXBsZSBub25jZQ==", accept);
+	assert(strcmp(accept, "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") == 0);
+
+	assert(websocket::header(head, websocket::Text, 5) == 2);
+	assert(head[0] == 0x81 && head[1] == 5);
+	assert(websocket::header(head, websocket::Binary, 300) == 4);
+	assert(head[0] == 0x82 && head[1] == 126 && head[2] == 1 && head[3] == 44);
+	assert(websocket::header(head, websocket::Binary, 70000) == 10);
+	assert(head[1] == 127 && head[7] == 1 && head[8] == 0x11 && head[9] == 0x70);
+}
+
+static void parser_test()
+{
+	WebSocketParser parser(64);
+	uint8_t data[256];
+	size_t length;
+
+	/* A single frame, fed one byte at a time. */
+	length = frame(data, 0x81, "Hello", 5);
+
+	for(size_t idx = 0; idx < length; idx++)
+		assert(parser.feed(data + idx, 1) == 1);
+
+	assert(parser.done());
+	assert(parser.opcode() == websocket::Text);
+	assert(parser.text() == "Hello");
+	parser.next();
+
+	/* A fragmented message with a ping in between, in one piece. Feeding stops after each. */
+	length = frame(data, 0x01, "Hel", 3);
+	length += frame(data + length, 0x89, "ping", 4);
+	length += frame(data + length, 0x80, "lo", 2);
+
+	auto consumed = parser.feed(data, length);
+	assert(parser.done());
+	assert(parser.opcode() == websocket::Ping);
+	assert(parser.text() == "ping");
+	parser.next();
+
+	consumed += parser.feed(data + consumed, length - consumed);
+	assert(consumed == length);
+	assert(parser.done());
+	assert(parser.opcode() == websocket::Text);
+	assert(parser.text() == "Hello");
+	parser.next();
+
+	/* Messages larger than the limit. */
+	char large[100];
+	memset(large, 'x', sizeof(large));
+	length = frame(data, 0x82, large, sizeof(large));
+	parser.feed(data, length);
+	assert(parser.failed());
+	assert(parser.error() == websocket::MessageTooBig);
+
+	/* Unmasked client frames. */
+	parser.reset();
+	data[0] = 0x81;
+	data[1] = 0x01;
+	data[2] = 'x';
+	parser.feed(data, 3);
+	assert(parser.failed());
+	assert(parser.error() == websocket::ProtocolError);
+
+	/* A continuation without a message. */
+	parser.reset();
+	length = frame(data, 0x80, "x", 1);
+	parser.feed(data, length);
+	assert(parser.failed());
+
+	print_dbg("WebSocket parser test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	sha1_test();
+	handshake_test();
+	parser_test();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
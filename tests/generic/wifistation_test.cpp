@@ -0,0 +1,187 @@
+/*
+ * WiFi station unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/test.h>
+
+#include <lwiot/network/ipaddress.h>
+#include <lwiot/network/wifistation.h>
+#include <lwiot/util/keyvaluestore.h>
+
+#define SECTORS 4
+#define SECTORSIZE 128
+
+class MemoryKeyValueStore : public lwiot::KeyValueStore {
+public:
+	explicit MemoryKeyValueStore() : KeyValueStore(SECTORS, SECTORSIZE), full(false)
+	{
+		memset(this->_memory, 0xFF, sizeof(this->_memory));
+	}
+
+	bool full;
+
+protected:
+	bool read(size_t offset, void *data, size_t length) override
+	{
+		if(offset + length > this->storage())
+			return false;
+
+		memcpy(data, this->_memory + offset, length);
+		return true;
+	}
+
+	bool write(size_t offset, const void *data, size_t length) override
+	{
+		if(this->full || offset + length > this->storage())
+			return false;
+
+		memcpy(this->_memory + offset, data, length);
+		return true;
+	}
+
+private:
+	uint8_t _memory[SECTORS * SECTORSIZE];
+};
+
+/* Station that connects at once. Resuming only works while the access point keeps its BSSID. */
+class TestStation : public lwiot::WifiStation {
+public:
+	explicit TestStation() : scans(0), resumes(0), bssid(0x10)
+	{
+	}
+
+	void connectTo(const lwiot::String& ssid, const lwiot::String& password) override
+	{
+		WifiStation::connectTo(ssid, password);
+		this->scans++;
+		this->setStatus(lwiot::WL_CONNECTED);
+		this->setAddress(lwiot::IPAddress(192, 168, 1, 20));
+	}
+
+	operator bool() const override
+	{
+		return this->status() == lwiot::WL_CONNECTED;
+	}
+
+	int scans;
+	int resumes;
+	uint8_t bssid;
+
+protected:
+	bool link(Link& link) const override
+	{
+		memset(link.bssid, this->bssid, sizeof(link.bssid));
+		link.channel = 6;
+		link.address = this->address();
+		link.gateway = lwiot::IPAddress(192, 168, 1, 1);
+		link.netmask = lwiot::IPAddress(255, 255, 255, 0);
+		link.dns = lwiot::IPAddress(192, 168, 1, 1);
+
+		return true;
+	}
+
+	bool resume(const lwiot::String& ssid, const lwiot::String& password, const Link& link) override
+	{
+		this->resumes++;
+		assert(link.channel == 6);
+		assert(link.gateway == lwiot::IPAddress(192, 168, 1, 1));
+
+		if(link.bssid[0] != this->bssid) {
+			this->setStatus(lwiot::WL_CONNECT_FAILED);
+			return true;
+		}
+
+		WifiStation::connectTo(ssid, password);
+		this->setStatus(lwiot::WL_CONNECTED);
+		this->setAddress(link.address);
+
+		return true;
+	}
+};
+
+static void plain_connect_test()
+{
+	TestStation station;
+
+	assert(station.connect("lwiot", "secret"));
+	assert(station.connect("lwiot", "secret"));
+	assert(station.scans == 2);
+	assert(station.resumes == 0);
+	assert(!station.timing().fast);
+}
+
+static void fast_reconnect_test()
+{
+	MemoryKeyValueStore store;
+	TestStation station;
+
+	station.setFastReconnect(store);
+
+	assert(station.connect("lwiot", "secret"));
+	assert(!station.timing().fast);
+	assert(station.timing().stored);
+	assert(station.scans == 1);
+	assert(store.contains(CONFIG_WIFI_LINK_KEY));
+
+	station.disconnect();
+	assert(station.connect("lwiot", "secret"));
+	assert(station.timing().fast);
+	assert(station.timing().resume == 0);
+	assert(station.scans == 1);
+	assert(station.resumes == 1);
+	assert(station.address() == lwiot::IPAddress(192, 168, 1, 20));
+
+	/* The link belongs to another network. */
+	station.disconnect();
+	assert(station.connect("other", "secret"));
+	assert(!station.timing().fast);
+	assert(station.scans == 2);
+	assert(station.resumes == 1);
+
+	/* The access point was replaced, so resuming fails and the station scans. */
+	station.disconnect();
+	station.bssid = 0x20;
+	assert(station.connect("other", "secret"));
+	assert(!station.timing().fast);
+	assert(station.scans == 3);
+	assert(station.resumes == 2);
+
+	station.disconnect();
+	assert(station.connect("other", "secret"));
+	assert(station.timing().fast);
+	assert(station.resumes == 3);
+
+	station.clearFastReconnect();
+	assert(!store.contains(CONFIG_WIFI_LINK_KEY));
+
+	/* A link that can not be stored does not fail the connection. */
+	store.full = true;
+	station.setFastReconnect(store);
+	station.disconnect();
+	assert(station.connect("other", "secret"));
+	assert(!station.timing().stored);
+	assert(!store.contains(CONFIG_WIFI_LINK_KEY));
+
+	print_dbg("Fast reconnect test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	plain_connect_test();
+	fast_reconnect_test();
+
+	lwiot_destroy();
+	wait_close();
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,651 @@
+/*
+ * XBee test against the hosted mesh simulator.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+#include <lwiot/function.h>
+#include <lwiot/bytebuffer.h>
+#include <lwiot/scopedlock.h>
+
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/atomic.h>
+
+#include <lwiot/network/xbee/xbee.h>
+#include <lwiot/network/xbee/asyncxbee.h>
+#include <lwiot/network/xbee/xbeeframe.h>
+#include <lwiot/network/xbee/xbeenodetable.h>
+#include <lwiot/network/xbee/xbeetransport.h>
+#include <lwiot/hosted/xbeesimulator.h>
+
+#define TRANSPORT_DATA 0xF0
+#define TRANSPORT_POLL 0xF1
+#define TRANSPORT_ACK  0xF2
+
+#define FRAGMENT_SIZE 8
+#define MESSAGE_SIZE 1000
+#define WAIT_TMO 1000
+
+/* Transport timeout times the number of attempts, as configured in the library. */
+#define TRANSPORT_LINGER (CONFIG_XBEE_TRANSPORT_TIMEOUT * (CONFIG_XBEE_TRANSPORT_RETRIES + 1))
+
+using lwiot::hosted::XBeeSimulator;
+
+/*
+ * An AsyncXbee in pushed mode on a simulated mesh whose nodes echo everything they receive.
+ * A transport that sends to node 0 gets its own fragments back, and acknowledges them to
+ * itself. The filter decides how many copies of each echoed fragment reach the transport.
+ *
+ * While held, the output of the simulator is buffered instead of passed to the radio, so
+ * tests can delay responses or deliver them in reverse order.
+ */
+class Rig {
+public:
+	typedef lwiot::Function<int(uint8_t index)> Filter;
+
+	explicit Rig(size_t nodes = 1, lwiot::XBeeNodeTable *table = nullptr) : delivered(0), acks(0), ack_bitmap(0),
+		_lock(false), _seen(), _hold_lock(false), _holding(false), _dispatch_lock(false), _closed(false),
+		sim(config(nodes)), transport(xbee)
+	{
+		this->xb.setSerial(this->sim);
+		this->xbee.setDevice(this->xb);
+		this->xbee.getDevice().setNodeTable(table);
+		this->xbee.setReceiveMode(lwiot::AsyncXbee::ReceiveMode::Pushed);
+
+		this->sim.setReceiver([this](const uint8_t *data, size_t length) {
+			lwiot::ScopedLock lock(this->_hold_lock);
+
+			if(this->_holding)
+				this->_held.write(data, length);
+			else
+				this->push(data, length);
+		});
+
+		this->transport.setHandler([this](uint64_t source, const lwiot::ByteBuffer& message) {
+			lwiot::ScopedLock lock(this->_lock);
+
+			assert(source == XBeeSimulator::address(0));
+			this->_message = message;
+			this->delivered.fetch_add(1);
+		});
+
+		this->xbee.setFrameHandler([this](const lwiot::XBeeFrame& frame) {
+			this->dispatch(frame.response());
+		});
+
+		this->xbee.begin([](lwiot::XBeeResponse&) { });
+	}
+
+	~Rig()
+	{
+		this->sim.stop();
+		this->sim.setReceiver([](const uint8_t *, size_t) { });
+
+		/* The transport goes before the receive thread of the XBee stops. */
+		lwiot::ScopedLock lock(this->_dispatch_lock);
+		this->_closed = true;
+	}
+
+	void setFilter(const Filter& filter)
+	{
+		lwiot::ScopedLock lock(this->_lock);
+		this->_filter = filter;
+	}
+
+	int seen(uint8_t index) const
+	{
+		lwiot::ScopedLock lock(this->_lock);
+		return this->_seen[index];
+	}
+
+	lwiot::ByteBuffer received() const
+	{
+		lwiot::ScopedLock lock(this->_lock);
+		return this->_message;
+	}
+
+	void hold()
+	{
+		lwiot::ScopedLock lock(this->_hold_lock);
+		this->_holding = true;
+	}
+
+	/* Pass the held output to the radio, optionally with the frames in reverse order. */
+	void release(bool reverse = false)
+	{
+		lwiot::ScopedLock lock(this->_hold_lock);
+		auto data = this->_held.data();
+		size_t end = this->_held.index();
+
+		this->_holding = false;
+
+		if(!reverse) {
+			this->push(data, end);
+		} else {
+			/* Start bytes are escaped within frames. */
+			for(size_t idx = end; idx > 0; idx--) {
+				if(data[idx - 1] != START_BYTE)
+					continue;
+
+				this->push(data + idx - 1, end - idx + 1);
+				end = idx - 1;
+			}
+		}
+
+		this->_held.setIndex(0);
+	}
+
+	/* Pass a fragment to the transport as if node 0 sent it. */
+	void inject(uint8_t type, uint8_t id, uint8_t index, uint8_t count, const uint8_t *data, size_t length)
+	{
+		uint8_t frame[11 + 5 + FRAGMENT_SIZE];
+		lwiot::XBeeResponse response;
+		auto source = XBeeSimulator::address(0);
+
+		for(int idx = 0; idx < 8; idx++)
+			frame[idx] = static_cast<uint8_t>(source >> (56 - idx * 8));
+
+		frame[8] = 0;
+		frame[9] = 1;
+		frame[10] = 1;
+		frame[11] = type;
+		frame[12] = id;
+		frame[13] = index;
+		frame[14] = count;
+		frame[15] = FRAGMENT_SIZE;
+		memcpy(frame + 16, data, length);
+
+		response.setApiId(ZB_RX_RESPONSE);
+		response.setMsbLength(0);
+		response.setLsbLength(static_cast<uint8_t>(1 + 16 + length));
+		response.setFrameLength(static_cast<uint8_t>(16 + length));
+		response.setFrameData(frame);
+
+		this->transport.handle(response);
+	}
+
+	/* Handlers run on the threads of the components below, so their state is declared first. */
+	lwiot::Atomic<int> delivered;
+	lwiot::Atomic<int> acks;
+	lwiot::Atomic<int> ack_bitmap;
+
+private:
+	mutable lwiot::Lock _lock;
+	Filter _filter;
+	lwiot::ByteBuffer _message;
+	int _seen[256];
+
+	lwiot::Lock _hold_lock;
+	bool _holding;
+	lwiot::ByteBuffer _held;
+
+	lwiot::Lock _dispatch_lock;
+	bool _closed;
+
+public:
+	XBeeSimulator sim;
+	lwiot::XBee xb;
+	lwiot::AsyncXbee xbee;
+	lwiot::XBeeTransport transport;
+
+private:
+	void push(const uint8_t *data, size_t length)
+	{
+		while(length > 0) {
+			auto rv = this->xbee.receive(data, length);
+
+			data += rv;
+			length -= rv;
+
+			if(length > 0)
+				lwiot_sleep(1);
+		}
+	}
+
+	static XBeeSimulator::Config config(size_t nodes)
+	{
+		XBeeSimulator::Config config;
+
+		config.nodes = nodes;
+		config.rate = 0;
+		config.payload = 32;
+		config.latency = 1;
+		config.loss = 0;
+		config.throughput = 0;
+		config.echo = true;
+
+		return config;
+	}
+
+	/* Only the receive thread of the XBee runs this. */
+	void dispatch(lwiot::XBeeResponse& response)
+	{
+		lwiot::ZBRxResponse rx;
+		int copies = 1;
+
+		lwiot::ScopedLock closing(this->_dispatch_lock);
+
+		if(this->_closed || response.getApiId() != ZB_RX_RESPONSE)
+			return;
+
+		response.getZBRxResponse(rx);
+
+		auto data = rx.getData();
+
+		if(rx.getDataLength() < 3)
+			return;
+
+		if(data[0] == TRANSPORT_ACK) {
+			this->ack_bitmap.store(data[3]);
+			this->acks.fetch_add(1);
+		} else {
+			lwiot::ScopedLock lock(this->_lock);
+
+			this->_seen[data[2]]++;
+
+			if(this->_filter)
+				copies = this->_filter(data[2]);
+		}
+
+		for(int idx = 0; idx < copies; idx++)
+			this->transport.handle(response);
+	}
+};
+
+static bool wait_for(lwiot::Atomic<int>& counter, int value)
+{
+	for(int idx = 0; idx < WAIT_TMO && counter.load() < value; idx++)
+		lwiot_sleep(1);
+
+	return counter.load() >= value;
+}
+
+static lwiot::ByteBuffer make_message(size_t length, uint8_t seed)
+{
+	lwiot::ByteBuffer message(length);
+
+	for(size_t idx = 0; idx < length; idx++)
+		message.write(static_cast<uint8_t>(idx * 7 + seed));
+
+	return message;
+}
+
+static bool equals(const lwiot::ByteBuffer& a, const lwiot::ByteBuffer& b)
+{
+	return a.index() == b.index() && memcmp(a.data(), b.data(), a.index()) == 0;
+}
+
+static void test_command_correlation()
+{
+	Rig rig;
+	lwiot::Atomic<int> answered(0);
+	const char *commands[] = { "NP", "MY", "SH", "SL" };
+	const uint8_t expected[][4] = {
+		{ 0x00, 0x54 }, { 0x00, 0x00 }, { 0x00, 0x13, 0xA2, 0x00 }, { 0x40, 0x00, 0x00, 0x00 }
+	};
+	const size_t lengths[] = { 2, 2, 4, 4 };
+
+	/* The responses arrive in reverse order; each must reach the handler of its own command. */
+	rig.hold();
+
+	for(size_t idx = 0; idx < 4; idx++) {
+		auto rv = rig.xbee.command(commands[idx], nullptr, 0, [&, idx](bool ok, const lwiot::ByteBuffer& value) {
+			assert(ok);
+			assert(value.index() == lengths[idx]);
+			assert(memcmp(value.data(), expected[idx], lengths[idx]) == 0);
+			answered.fetch_add(1);
+		});
+
+		assert(rv);
+	}
+
+	lwiot_sleep(20);
+	assert(answered.load() == 0);
+
+	rig.release(true);
+	assert(wait_for(answered, 4));
+
+	print_dbg("Command correlation test passed!\n");
+}
+
+static void test_command_timeout()
+{
+	Rig rig;
+	lwiot::Atomic<int> failed(0);
+	lwiot::Atomic<int> answered(0);
+
+	rig.hold();
+
+	auto rv = rig.xbee.command("NP", nullptr, 0, [&](bool ok, const lwiot::ByteBuffer&) {
+		if(ok)
+			answered.fetch_add(1);
+		else
+			failed.fetch_add(1);
+	}, 50);
+
+	assert(rv);
+	assert(wait_for(failed, 1));
+
+	/* A response that arrives after the timeout is not passed to the expired handler. */
+	rig.release();
+	lwiot_sleep(50);
+
+	assert(failed.load() == 1);
+	assert(answered.load() == 0);
+
+	print_dbg("Command timeout test passed!\n");
+}
+
+static void test_command_pending_full()
+{
+	Rig rig;
+	lwiot::Atomic<int> answered(0);
+	auto handler = [&](bool ok, const lwiot::ByteBuffer&) {
+		assert(ok);
+		answered.fetch_add(1);
+	};
+
+	rig.hold();
+
+	for(int idx = 0; idx < CONFIG_XBEE_AT_PENDING; idx++)
+		assert(rig.xbee.command("MY", nullptr, 0, handler));
+
+	assert(!rig.xbee.command("MY", nullptr, 0, handler));
+
+	rig.release();
+	assert(wait_for(answered, CONFIG_XBEE_AT_PENDING));
+
+	/* The answered commands made room again. */
+	assert(rig.xbee.command("MY", nullptr, 0, handler));
+	assert(wait_for(answered, CONFIG_XBEE_AT_PENDING + 1));
+
+	print_dbg("Command table full test passed!\n");
+}
+
+static void test_window_full()
+{
+	Rig rig;
+	lwiot::Atomic<int> delivered(0);
+	lwiot::AsyncXbee::DeliveryStats stats;
+	lwiot::ZigbeeAddress addr;
+	auto payload = make_message(16, 7);
+	auto handler = [&](bool ok) {
+		assert(ok);
+		delivered.fetch_add(1);
+	};
+
+	addr.setAddress64(XBeeSimulator::address(0));
+	rig.hold();
+
+	for(int idx = 0; idx < CONFIG_XBEE_TX_WINDOW; idx++)
+		assert(rig.xbee.transmit(addr, payload, handler));
+
+	/* Nothing is delivered, so the window stays full. */
+	auto start = lwiot_tick_ms();
+	assert(!rig.xbee.transmit(addr, payload, handler));
+	assert(lwiot_tick_ms() - start >= CONFIG_XBEE_TX_TIMEOUT);
+
+	/* Every frame timed out once, and is sent again once the radio answers. */
+	lwiot_sleep(100);
+	rig.release();
+
+	assert(rig.xbee.flush(WAIT_TMO * 5));
+	assert(delivered.load() == CONFIG_XBEE_TX_WINDOW);
+	assert(rig.xbee.getDeliveryStats(XBeeSimulator::address(0), stats));
+	assert(stats.delivered == CONFIG_XBEE_TX_WINDOW);
+	assert(stats.failed == 0);
+	assert(stats.retries >= CONFIG_XBEE_TX_WINDOW);
+
+	print_dbg("Transmit window full test passed!\n");
+}
+
+static void test_frame_id_wrap()
+{
+	Rig rig;
+	lwiot::Atomic<int> delivered(0);
+	lwiot::Atomic<int> failed(0);
+	lwiot::AsyncXbee::DeliveryStats stats;
+	lwiot::ZigbeeAddress present;
+	lwiot::ZigbeeAddress absent;
+	auto payload = make_message(16, 8);
+
+	present.setAddress64(XBeeSimulator::address(0));
+	absent.setAddress64(XBeeSimulator::address(5));
+
+	/* Many times around the frame ID counter, with a full window all the way. */
+	for(int idx = 0; idx < 600; idx++) {
+		assert(rig.xbee.transmit(present, payload, [&](bool ok) {
+			assert(ok);
+			delivered.fetch_add(1);
+		}));
+	}
+
+	assert(rig.xbee.flush(WAIT_TMO * 5));
+	assert(delivered.load() == 600);
+
+	/*
+	 * Wrap the counter while a frame is in flight: the next frame has to skip its ID. The
+	 * first frame takes an address discovery, so the failure of the second frame, to a node
+	 * that does not exist, arrives first. It must not be taken for the first frame.
+	 */
+	rig.hold();
+
+	assert(rig.xbee.transmit(present, payload, [&](bool ok) {
+		assert(ok);
+		delivered.fetch_add(1);
+	}));
+
+	for(int idx = 0; idx < UINT8_MAX - 1; idx++)
+		rig.xbee.getDevice().getNextFrameId();
+
+	assert(rig.xbee.transmit(absent, payload, [&](bool ok) {
+		assert(!ok);
+		failed.fetch_add(1);
+	}));
+
+	lwiot_sleep(20);
+	rig.release();
+
+	assert(rig.xbee.flush(WAIT_TMO * 5));
+	assert(delivered.load() == 601);
+	assert(failed.load() == 1);
+	assert(rig.xbee.getDeliveryStats(XBeeSimulator::address(0), stats));
+	assert(stats.delivered == 601);
+	assert(stats.retries == 0);
+
+	print_dbg("Frame ID wrap test passed!\n");
+}
+
+/* Transmit to a node and wait for its echo, which the node table learns from. */
+static void ping(Rig& rig, size_t node)
+{
+	lwiot::ZigbeeAddress addr;
+	auto payload = make_message(16, 0);
+
+	addr.setAddress64(XBeeSimulator::address(node));
+
+	assert(rig.xbee.transmit(addr, payload, lwiot::AsyncXbee::DeliveryHandler()));
+	assert(rig.xbee.flush(WAIT_TMO));
+
+	/* The echo follows the transmit status; it also spaces out the refresh times. */
+	lwiot_sleep(10);
+}
+
+static void test_node_table_eviction()
+{
+	lwiot::XBeeNodeTable table;
+	Rig rig(CONFIG_XBEE_NODE_TABLE + 2, &table);
+	uint16_t address16;
+
+	for(size_t node = 0; node < CONFIG_XBEE_NODE_TABLE; node++)
+		ping(rig, node);
+
+	assert(table.size() == CONFIG_XBEE_NODE_TABLE);
+
+	for(size_t node = 0; node < CONFIG_XBEE_NODE_TABLE; node++) {
+		assert(table.lookup(XBeeSimulator::address(node), address16));
+		assert(address16 == node + 1);
+	}
+
+	/* Node 0 is refreshed, so nodes 1 and 2 are the least recently refreshed ones. */
+	ping(rig, 0);
+	ping(rig, CONFIG_XBEE_NODE_TABLE);
+	ping(rig, CONFIG_XBEE_NODE_TABLE + 1);
+
+	assert(table.size() == CONFIG_XBEE_NODE_TABLE);
+	assert(table.lookup(XBeeSimulator::address(0), address16));
+	assert(!table.lookup(XBeeSimulator::address(1), address16));
+	assert(!table.lookup(XBeeSimulator::address(2), address16));
+	assert(table.lookup(XBeeSimulator::address(3), address16));
+	assert(table.lookup(XBeeSimulator::address(CONFIG_XBEE_NODE_TABLE + 1), address16));
+	assert(address16 == CONFIG_XBEE_NODE_TABLE + 2);
+
+	print_dbg("Node table eviction test passed!\n");
+}
+
+static void test_transport_loopback()
+{
+	Rig rig;
+	auto message = make_message(MESSAGE_SIZE, 1);
+
+	assert(rig.transport.send(XBeeSimulator::address(0), message));
+	assert(rig.delivered.load() == 1);
+	assert(equals(rig.received(), message));
+
+	print_dbg("Transport loopback test passed!\n");
+}
+
+static void test_transport_fragment_loss()
+{
+	bool dropped = false;
+	Rig rig;
+	auto message = make_message(MESSAGE_SIZE, 2);
+
+	/* Lose the first copy of fragment 3; only that fragment is sent again. */
+	rig.setFilter([&dropped](uint8_t index) {
+		if(index != 3 || dropped)
+			return 1;
+
+		dropped = true;
+		return 0;
+	});
+
+	assert(rig.transport.send(XBeeSimulator::address(0), message));
+	assert(rig.delivered.load() == 1);
+	assert(equals(rig.received(), message));
+	assert(rig.seen(3) == 2);
+	assert(rig.seen(2) == 1);
+	assert(rig.seen(4) == 1);
+
+	print_dbg("Transport fragment loss test passed!\n");
+}
+
+static void test_transport_duplicates()
+{
+	Rig rig;
+	auto message = make_message(MESSAGE_SIZE, 3);
+
+	rig.setFilter([](uint8_t) {
+		return 2;
+	});
+
+	assert(rig.transport.send(XBeeSimulator::address(0), message));
+	assert(rig.delivered.load() == 1);
+	assert(equals(rig.received(), message));
+
+	print_dbg("Transport duplicate fragment test passed!\n");
+}
+
+static void test_transport_out_of_order()
+{
+	Rig rig;
+	auto message = make_message(4 * FRAGMENT_SIZE - 2, 4);
+	auto data = message.data();
+
+	/* Fragment 1 is missing: the acknowledgement holds 0, 2 and 3. */
+	rig.inject(TRANSPORT_DATA, 9, 3, 4, data + 3 * FRAGMENT_SIZE, FRAGMENT_SIZE - 2);
+	rig.inject(TRANSPORT_DATA, 9, 0, 4, data, FRAGMENT_SIZE);
+	rig.inject(TRANSPORT_POLL, 9, 2, 4, data + 2 * FRAGMENT_SIZE, FRAGMENT_SIZE);
+
+	assert(wait_for(rig.acks, 1));
+	assert(rig.ack_bitmap.load() == 0x0D);
+	assert(rig.delivered.load() == 0);
+
+	rig.inject(TRANSPORT_DATA, 9, 0, 4, data, FRAGMENT_SIZE);
+	rig.inject(TRANSPORT_POLL, 9, 1, 4, data + FRAGMENT_SIZE, FRAGMENT_SIZE);
+
+	assert(rig.delivered.load() == 1);
+	assert(equals(rig.received(), message));
+	assert(wait_for(rig.acks, 2));
+	assert(rig.ack_bitmap.load() == 0x0F);
+
+	print_dbg("Transport out of order test passed!\n");
+}
+
+static void send_message(Rig& rig, uint8_t id, const lwiot::ByteBuffer& message)
+{
+	auto data = message.data();
+
+	for(uint8_t idx = 0; idx < 4; idx++) {
+		auto size = idx == 3 ? message.index() - 3 * FRAGMENT_SIZE : FRAGMENT_SIZE;
+		rig.inject(idx == 3 ? TRANSPORT_POLL : TRANSPORT_DATA, id, idx, 4, data + idx * FRAGMENT_SIZE, size);
+	}
+}
+
+static void test_transport_sender_restart()
+{
+	Rig rig;
+	auto first = make_message(4 * FRAGMENT_SIZE - 3, 5);
+	auto second = make_message(4 * FRAGMENT_SIZE - 3, 6);
+
+	send_message(rig, 1, first);
+	assert(rig.delivered.load() == 1);
+
+	/* A repeat of the delivered message is acknowledged, but not delivered again. */
+	rig.inject(TRANSPORT_POLL, 1, 3, 4, first.data() + 3 * FRAGMENT_SIZE, first.index() - 3 * FRAGMENT_SIZE);
+	assert(wait_for(rig.acks, 2));
+	assert(rig.ack_bitmap.load() == 0x0F);
+	assert(rig.delivered.load() == 1);
+
+	/* Once the sender would have given up, the same ID is a new message. */
+	lwiot_sleep(TRANSPORT_LINGER + 100);
+	send_message(rig, 1, second);
+	assert(rig.delivered.load() == 2);
+	assert(equals(rig.received(), second));
+
+	print_dbg("Transport sender restart test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	test_command_correlation();
+	test_command_timeout();
+	test_command_pending_full();
+
+	test_window_full();
+	test_frame_id_wrap();
+
+	test_node_table_eviction();
+
+	test_transport_loopback();
+	test_transport_fragment_loss();
+	test_transport_duplicates();
+	test_transport_out_of_order();
+	test_transport_sender_restart();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
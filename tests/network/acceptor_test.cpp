@@ -0,0 +1,99 @@
+/*
+ * TCP acceptor pool and batched accept unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/network/eventloop.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+#include <lwiot/network/tcpacceptorpool.h>
+
+#define PORT 5558
+#define CLIENTS 64
+
+static void connect_clients(uint16_t port)
+{
+	lwiot::IPAddress addr(127, 0, 0, 1);
+	lwiot::SocketTcpClient *clients[CLIENTS];
+
+	/* Connect everything first, so the listeners see a burst. */
+	for(auto& client : clients) {
+		client = new lwiot::SocketTcpClient();
+		assert(client->connect(addr, port));
+	}
+
+	for(auto client : clients) {
+		uint8_t byte = 0;
+
+		assert(client->read(&byte, 1) == 1);
+		assert(byte == 'a');
+		delete client;
+	}
+}
+
+static void test_pool()
+{
+	lwiot::TcpAcceptorPool pool(4);
+	lwiot::atomic_int_t accepted(0);
+
+	assert(pool.start(BIND_ADDR_LB, PORT, [&](lwiot::UniquePointer<lwiot::TcpClient>& client) {
+		client->write('a');
+		accepted.fetch_add(1);
+	}));
+
+	auto listeners = pool.listeners();
+	assert(listeners >= 1);
+	connect_clients(PORT);
+	assert(accepted.load() == CLIENTS);
+
+	pool.stop();
+	assert(pool.listeners() == 0);
+	print_dbg("Acceptor pool test passed (%u listeners)!\n", static_cast<unsigned>(listeners));
+}
+
+static void test_loop()
+{
+	lwiot::SocketTcpServer server;
+	lwiot::EventLoop loop(20);
+	lwiot::FunctionalThread worker("event-loop");
+	int accepted = 0;
+
+	assert(server.bind(BIND_ADDR_LB, PORT + 1));
+	assert(loop.accept(server, [&](lwiot::UniquePointer<lwiot::TcpClient>& client) {
+		client->write('a');
+		accepted++;
+	}));
+
+	worker.start([&]() { loop.run(); });
+	connect_clients(PORT + 1);
+
+	loop.stop();
+	worker.join();
+
+	assert(accepted == CLIENTS);
+	server.close();
+	print_dbg("Event loop accept test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	test_pool();
+	test_loop();
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,375 @@
+/*
+ * Asynchronous MQTT client unit test, against a minimal local broker.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/ringbufferstream.h>
+#include <lwiot/util/json.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/network/asyncmqttclient.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+
+#define PORT 5566
+#define ROUNDS 10
+#define PUBLISHERS 4
+#define MESSAGES 50
+#define LARGE 5000
+
+static lwiot::atomic_int_t received(0);
+static lwiot::atomic_int_t reconnects(0);
+static volatile time_t delivered;
+
+/* Read one packet and return its type. */
+static uint8_t read_packet(lwiot::TcpClient& client, uint8_t *payload, size_t size, uint8_t *flags = nullptr)
+{
+	uint8_t type, byte;
+	size_t length = 0;
+	int shift = 0;
+
+	if(client.read(&type, 1) != 1)
+		return 0;
+
+	do {
+		if(client.read(&byte, 1) != 1)
+			return 0;
+
+		length |= (byte & 0x7F) << shift;
+		shift += 7;
+	} while(byte & 0x80);
+
+	assert(length <= size);
+
+	for(size_t idx = 0; idx < length; ) {
+		auto rv = client.read(payload + idx, length - idx);
+
+		if(rv <= 0)
+			return 0;
+
+		idx += rv;
+	}
+
+	if(flags != nullptr)
+		*flags = type & 0x0F;
+
+	return type & 0xF0;
+}
+
+static lwiot::UniquePointer<lwiot::TcpClient> accept_session(lwiot::SocketTcpServer& server)
+{
+	const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+	uint8_t payload[256];
+	auto client = server.accept();
+
+	assert(client);
+	client->setOption(SOCKET_OPT_NODELAY, 1);
+	assert(read_packet(*client, payload, sizeof(payload)) == 0x10);
+	client->write(connack, sizeof(connack));
+
+	return client;
+}
+
+static void publish(lwiot::TcpClient& client, const char *topic, const char *data)
+{
+	uint8_t packet[64];
+	auto tl = strlen(topic);
+	auto dl = strlen(data);
+
+	packet[0] = 0x30;
+	packet[1] = static_cast<uint8_t>(2 + tl + dl);
+	packet[2] = 0;
+	packet[3] = static_cast<uint8_t>(tl);
+	memcpy(packet + 4, topic, tl);
+	memcpy(packet + 4 + tl, data, dl);
+
+	client.write(packet, 4 + tl + dl);
+}
+
+static void publisher(lwiot::AsyncMqttClient& mqtt, int id)
+{
+	char data[8];
+
+	for(int num = 0; num < MESSAGES; num++) {
+		snprintf(data, sizeof(data), "%d:%d", id, num);
+		assert(mqtt.publish("sensor", data, false));
+	}
+}
+
+static void publish_large(lwiot::TcpClient& client, const char *topic, size_t size)
+{
+	auto packet = new uint8_t[size + 64];
+	auto tl = strlen(topic);
+	auto remaining = 2 + tl + size;
+	size_t pos = 1;
+
+	packet[0] = 0x30;
+
+	do {
+		packet[pos] = remaining % 128;
+		remaining /= 128;
+
+		if(remaining > 0)
+			packet[pos] |= 0x80;
+
+		pos++;
+	} while(remaining > 0);
+
+	packet[pos++] = 0;
+	packet[pos++] = static_cast<uint8_t>(tl);
+	memcpy(packet + pos, topic, tl);
+	pos += tl;
+
+	for(size_t idx = 0; idx < size; idx++)
+		packet[pos++] = static_cast<uint8_t>(idx * 7);
+
+	client.write(packet, pos);
+	delete[] packet;
+}
+
+static void wait_for(lwiot::atomic_int_t& counter, int value)
+{
+	auto start = lwiot_tick_ms();
+
+	while(counter.load() < value && lwiot_tick_ms() - start < 3000)
+		lwiot_sleep(1);
+
+	assert(counter.load() >= value);
+}
+
+int main(int argc, char **argv)
+{
+	lwiot::SocketTcpServer server;
+	uint8_t payload[256];
+
+	lwiot_init();
+	assert(server.bind(BIND_ADDR_LB, PORT));
+
+	lwiot::UniquePointer<lwiot::TcpClient> session;
+	lwiot::FunctionalThread broker("broker");
+
+	broker.start([&]() {
+		session = accept_session(server);
+	});
+
+	lwiot::SocketTcpClient client(lwiot::IPAddress(127, 0, 0, 1), PORT);
+	lwiot::AsyncMqttClient mqtt;
+
+	lwiot::atomic_int_t streamed(0);
+	bool intact = true;
+
+	mqtt.setReconnectBackoff(20, 200);
+	mqtt.setChunkHandler([&](const lwiot::String& topic, size_t offset, const lwiot::RawBuffer& span, size_t total) {
+		auto bytes = static_cast<const uint8_t *>(span.buffer());
+
+		intact = intact && topic == "ota/image" && total == LARGE && offset == static_cast<size_t>(streamed.load());
+
+		for(size_t idx = 0; idx < span.size(); idx++)
+			intact = intact && bytes[idx] == static_cast<uint8_t>((offset + idx) * 7);
+
+		streamed.fetch_add(static_cast<int>(span.size()));
+	});
+	mqtt.setReconnectHandler([]() {
+		reconnects.fetch_add(1);
+	});
+
+	assert(mqtt.start(client));
+	assert(mqtt.connect("lwiot-test", "", ""));
+	broker.join();
+
+	mqtt.subscribe("cmd", [](const lwiot::SharedByteBuffer& data) {
+		delivered = lwiot_tick_ms();
+		received.fetch_add(1);
+	});
+
+	assert(read_packet(*session, payload, sizeof(payload)) == 0x80);
+
+	/* Messages are dispatched as they arrive, not on the next tick of a fixed interval. */
+	time_t worst = 0;
+
+	for(int round = 1; round <= ROUNDS; round++) {
+		auto sent = lwiot_tick_ms();
+
+		publish(*session, "cmd", "on");
+		wait_for(received, round);
+
+		if(delivered - sent > worst)
+			worst = delivered - sent;
+
+		lwiot_sleep(7);
+	}
+
+	assert(worst < 30);
+
+	/* Wildcard subscriptions receive every matching topic. */
+	static lwiot::atomic_int_t sensors(0);
+
+	mqtt.subscribe("site/+/sensor/#", [](const lwiot::SharedByteBuffer& data) {
+		sensors.fetch_add(1);
+	});
+
+	assert(read_packet(*session, payload, sizeof(payload)) == 0x80);
+	publish(*session, "site/hall/sensor/temp", "21");
+	publish(*session, "site/roof/sensor", "on");
+	publish(*session, "site/roof/actuator", "off");
+	publish(*session, "cmd", "on");
+	wait_for(received, ROUNDS + 1);
+	assert(sensors.load() == 2);
+
+	/* Publishing is not held up by the loop waiting for data. */
+	auto start = lwiot_tick_ms();
+	assert(mqtt.publish("status", "ok", false));
+	assert(lwiot_tick_ms() - start < 30);
+	assert(read_packet(*session, payload, sizeof(payload)) == 0x30);
+
+	/* Concurrent publishers share the outbound queue without losing messages. */
+	lwiot::FunctionalThread *publishers[PUBLISHERS];
+	int next[PUBLISHERS] = {};
+
+	for(int idx = 0; idx < PUBLISHERS; idx++) {
+		publishers[idx] = new lwiot::FunctionalThread("publisher");
+		publishers[idx]->start([&mqtt, idx]() {
+			publisher(mqtt, idx);
+		});
+	}
+
+	for(int num = 0; num < PUBLISHERS * MESSAGES; num++) {
+		int id, seq;
+
+		memset(payload, 0, sizeof(payload));
+		assert(read_packet(*session, payload, sizeof(payload)) == 0x30);
+		assert(sscanf(reinterpret_cast<char *>(payload) + 8, "%d:%d", &id, &seq) == 2);
+		assert(seq == next[id]++);
+	}
+
+	for(auto thread : publishers) {
+		thread->join();
+		delete thread;
+	}
+
+	assert(mqtt.dropped() == 0);
+
+	/* QoS 1 messages carry a packet identifier and are kept until they are acknowledged. */
+	uint8_t flags;
+
+	mqtt.setQoS("alarm", lwiot::MqttClient::QOS1);
+	assert(mqtt.publish("alarm", "smoke", false));
+	assert(read_packet(*session, payload, sizeof(payload), &flags) == 0x30);
+	assert(flags == 0x02);
+	assert(memcmp(payload + 7, "\x00\x01smoke", 7) == 0);
+
+	/* Payloads larger than the packet buffer are received and published in chunks. */
+	publish_large(*session, "ota/image", LARGE);
+	wait_for(streamed, LARGE);
+	assert(intact);
+
+	lwiot::RingBufferStream source(LARGE);
+	auto large = new uint8_t[LARGE + 64];
+
+	for(int idx = 0; idx < LARGE; idx++)
+		source.write(static_cast<uint8_t>(idx * 3));
+
+	assert(mqtt.publish("thumbnail", source, LARGE));
+	assert(read_packet(*session, large, LARGE + 64) == 0x30);
+	assert(memcmp(large, "\x00\x09thumbnail", 11) == 0);
+
+	for(int idx = 0; idx < LARGE; idx++)
+		assert(large[11 + idx] == static_cast<uint8_t>(idx * 3));
+
+	/* JSON documents are written straight to the connection, without a size limit. */
+	lwiot::DynamicJsonBuffer jbuffer;
+	lwiot::String document;
+	auto& doc = jbuffer.createObject();
+	auto& values = doc.createNestedArray("values");
+
+	doc["sensor"] = "bme280";
+
+	for(int idx = 0; idx < 200; idx++)
+		values.add(idx);
+
+	doc.printTo(document);
+	assert(document.length() > lwiot::MqttClient::MQTT_MAX_PACKET_SIZE);
+
+	assert(mqtt.publishJson("sensors", doc));
+	assert(read_packet(*session, large, LARGE + 64) == 0x30);
+	assert(memcmp(large, "\x00\x07sensors", 9) == 0);
+	assert(memcmp(large + 9, document.c_str(), document.length()) == 0);
+
+	delete[] large;
+
+	/* A lost connection is restored after the backoff delay. */
+	lwiot::FunctionalThread rebroker("broker");
+	auto lost = lwiot::stl::move(session);
+
+	rebroker.start([&]() {
+		session = accept_session(server);
+	});
+
+	lost->close();
+	rebroker.join();
+	wait_for(reconnects, 1);
+	assert(mqtt.connected());
+
+	/* The unacknowledged message is sent again, marked as a duplicate. */
+	const uint8_t puback[] = { 0x40, 0x02, 0x00, 0x01 };
+
+	assert(read_packet(*session, payload, sizeof(payload), &flags) == 0x30);
+	assert(flags == 0x0A);
+	session->write(puback, sizeof(puback));
+
+	/* Messages published before the client connects are queued; the oldest make way. */
+	lwiot::SocketTcpClient offline_client(lwiot::IPAddress(127, 0, 0, 1), PORT);
+	lwiot::AsyncMqttClient offline;
+	char data[8];
+
+	offline.setOverflowPolicy(lwiot::AsyncMqttClient::OverflowPolicy::DropOldest);
+
+	for(int num = 0; num < CONFIG_MQTT_QUEUE_SIZE + 8; num++) {
+		snprintf(data, sizeof(data), "%d", num);
+		assert(offline.publish("log", data, false));
+	}
+
+	assert(offline.dropped() == 8);
+
+	lwiot::FunctionalThread offbroker("broker");
+	lwiot::UniquePointer<lwiot::TcpClient> offsession;
+
+	offbroker.start([&]() {
+		offsession = accept_session(server);
+	});
+
+	assert(offline.start(offline_client));
+	assert(offline.connect("lwiot-offline", "", ""));
+	offbroker.join();
+
+	for(int num = 8; num < CONFIG_MQTT_QUEUE_SIZE + 8; num++) {
+		memset(payload, 0, sizeof(payload));
+		assert(read_packet(*offsession, payload, sizeof(payload)) == 0x30);
+		assert(atoi(reinterpret_cast<char *>(payload) + 5) == num);
+	}
+
+	offline.stop();
+	offsession->close();
+
+	mqtt.stop();
+	session->close();
+	server.close();
+
+	print_dbg("Async MQTT client test passed!\n");
+
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,197 @@
+/*
+ * Base 64 unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+#include <lwiot/error.h>
+#include <lwiot/ringbufferstream.h>
+
+#include <lwiot/network/base64.h>
+#include <lwiot/network/base64stream.h>
+
+#define MAX_LENGTH 700
+
+static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* Plain encoder to compare against. */
+static size_t reference(const uint8_t *input, size_t length, char *output, bool newlines)
+{
+	size_t idx, written = 0, groups = 0;
+
+	for(idx = 0; idx < length; idx += 3) {
+		uint32_t value = static_cast<uint32_t>(input[idx]) << 16;
+
+		if(idx + 1 < length)
+			value |= static_cast<uint32_t>(input[idx + 1]) << 8;
+		if(idx + 2 < length)
+			value |= input[idx + 2];
+
+		output[written++] = alphabet[value >> 18];
+		output[written++] = alphabet[(value >> 12) & 0x3F];
+		output[written++] = idx + 1 < length ? alphabet[(value >> 6) & 0x3F] : '=';
+		output[written++] = idx + 2 < length ? alphabet[value & 0x3F] : '=';
+
+		if(newlines && idx + 2 < length && ++groups == BASE64_CHARS_PER_LINE / 4) {
+			output[written++] = '\n';
+			groups = 0;
+		}
+	}
+
+	output[written] = '\0';
+	return written;
+}
+
+static void test_vectors()
+{
+	const char *plain[] = { "", "f", "fo", "foo", "foob", "fooba", "foobar" };
+	const char *encoded[] = { "", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy" };
+	char buffer[32];
+
+	for(size_t idx = 0; idx < sizeof(plain) / sizeof(plain[0]); idx++) {
+		auto length = base64_encode_chars(plain[idx], static_cast<int>(strlen(plain[idx])), buffer);
+
+		assert(length == static_cast<int>(strlen(encoded[idx])));
+		assert(strcmp(buffer, encoded[idx]) == 0);
+
+		length = base64_decode_chars(encoded[idx], static_cast<int>(strlen(encoded[idx])), buffer);
+		assert(length == static_cast<int>(strlen(plain[idx])));
+		assert(memcmp(buffer, plain[idx], length) == 0);
+	}
+
+	/* Anything outside of the alphabet is skipped, also in the middle of a group. */
+	const char noisy[] = "Zm9v\r\nY m\tFy*Zm9v!YmFy";
+	auto length = base64_decode_chars(noisy, sizeof(noisy) - 1, buffer);
+	assert(length == 12);
+	assert(memcmp(buffer, "foobarfoobar", 12) == 0);
+
+	assert(base64_decode_value('z') == 51);
+	assert(base64_decode_value('{') < 0);
+	assert(base64_decode_value('=') < 0);
+
+	print_dbg("Base 64 vector test done!\n");
+}
+
+static void test_random()
+{
+	uint8_t input[MAX_LENGTH], decoded[MAX_LENGTH + 1];
+	char expected[MAX_LENGTH * 2], output[MAX_LENGTH * 2];
+	base64_encodestate state;
+
+	for(size_t idx = 0; idx < sizeof(input); idx++)
+		input[idx] = static_cast<uint8_t>(rand());
+
+	for(size_t length = 0; length < MAX_LENGTH; length++) {
+		auto written = reference(input, length, expected, false);
+
+		/* Split in two, so the fast paths start at every possible offset. */
+		base64_init_encodestate_nonewlines(&state);
+		auto first = base64_encode_block((const char *) input, static_cast<int>(length / 2), output, &state);
+		first += base64_encode_block((const char *) input + length / 2, static_cast<int>(length - length / 2),
+		                             output + first, &state);
+		first += base64_encode_blockend(output + first, &state);
+
+		assert(first == static_cast<int>(written));
+		assert(memcmp(output, expected, written) == 0);
+
+		auto size = base64_decode_chars(output, first, (char *) decoded);
+		assert(size == static_cast<int>(length));
+		assert(memcmp(decoded, input, length) == 0);
+
+		written = reference(input, length, expected, true);
+		first = base64_encode_chars((const char *) input, static_cast<int>(length), output);
+		assert(first <= static_cast<int>(base64_encode_expected_len(length)));
+		assert(first == static_cast<int>(written));
+		assert(memcmp(output, expected, written) == 0);
+
+		size = base64_decode_chars(output, first, (char *) decoded);
+		assert(size == static_cast<int>(length));
+		assert(memcmp(decoded, input, length) == 0);
+	}
+
+	print_dbg("Base 64 random test done!\n");
+}
+
+static void test_stream()
+{
+	const size_t chunks[] = { 1, 2, 5, 16, 17, 64, 300 };
+	uint8_t input[MAX_LENGTH], decoded[MAX_LENGTH];
+	char expected[MAX_LENGTH * 2], encoded[MAX_LENGTH * 2];
+
+	for(size_t idx = 0; idx < sizeof(input); idx++)
+		input[idx] = static_cast<uint8_t>(rand());
+
+	for(auto chunk : chunks) {
+		for(int newlines = 0; newlines < 2; newlines++) {
+			lwiot::RingBufferStream text(MAX_LENGTH * 2), data(MAX_LENGTH);
+			lwiot::Base64Encoder encoder(text, newlines != 0);
+			lwiot::Base64Decoder decoder(data);
+			auto written = reference(input, sizeof(input), expected, newlines != 0);
+			ssize_t total = 0;
+
+			for(size_t offset = 0; offset < sizeof(input); offset += chunk) {
+				auto length = sizeof(input) - offset < chunk ? sizeof(input) - offset : chunk;
+				auto rv = encoder.update(input + offset, length);
+
+				assert(rv >= 0);
+				total += rv;
+			}
+
+			total += encoder.final();
+			assert(total == static_cast<ssize_t>(written));
+			assert(text.read(encoded, written) == static_cast<ssize_t>(written));
+			assert(memcmp(encoded, expected, written) == 0);
+
+			total = 0;
+			for(size_t offset = 0; offset < written; offset += chunk) {
+				auto length = written - offset < chunk ? written - offset : chunk;
+				auto rv = decoder.update(encoded + offset, length);
+
+				assert(rv >= 0);
+				total += rv;
+			}
+
+			assert(decoder.final() == 0);
+			assert(total == sizeof(input));
+			assert(data.read(decoded, sizeof(decoded)) == sizeof(decoded));
+			assert(memcmp(decoded, input, sizeof(input)) == 0);
+		}
+	}
+
+	/* A group of a single character does not hold a byte. */
+	lwiot::RingBufferStream data(16), small(8);
+	lwiot::Base64Decoder decoder(data);
+
+	assert(decoder.update("Zm9vY", 5) == 3);
+	assert(decoder.final() == -EINVALID);
+	assert(decoder.update("Zg", 2) == 1);
+	assert(decoder.final() == 0);
+
+	/* Output that does not fit is reported. */
+	lwiot::Base64Encoder encoder(small);
+	assert(encoder.update(input, 9) == -EINVALID);
+
+	print_dbg("Base 64 stream test done!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	test_vectors();
+	test_random();
+	test_stream();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
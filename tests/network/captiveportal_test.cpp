@@ -6,20 +6,122 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <lwiot.h>
+#include <assert.h>
 
 #include <lwiot/types.h>
 #include <lwiot/error.h>
 #include <lwiot/scopedlock.h>
 #include <lwiot/test.h>
 
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
 #include <lwiot/network/udpclient.h>
 #include <lwiot/network/udpserver.h>
 #include <lwiot/network/socketudpserver.h>
+#include <lwiot/network/socketudpclient.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+#include <lwiot/network/httpserver.h>
 #include <lwiot/network/captiveportal.h>
 
 #include <lwiot/stl/move.h>
 
+#define HTTP_PORT 5575
+
+static void test_dns()
+{
+	lwiot::SocketUdpClient client(lwiot::IPAddress(127,0,0,1), 5300);
+	const uint8_t query[] = {
+		0xAB, 0xCD, FLAG_RD, 0, 0, 1, 0, 0, 0, 0, 0, 0,
+		12, 'c', 'o', 'n', 'n', 'e', 'c', 't', 'i', 'v', 'i', 't', 'y',
+		7, 'A', 'n', 'd', 'r', 'o', 'i', 'd', 3, 'c', 'o', 'm', 0,
+		0, QTYPE_A, 0, QCLASS_IN
+	};
+	uint8_t reply[DNS_LEN];
+
+	client.setTimeout(2);
+	assert(client.write(query, sizeof(query)) == sizeof(query));
+
+	auto rv = client.read(reply, sizeof(reply));
+	assert(rv == sizeof(query) + 16);
+	assert(reply[0] == 0xAB && reply[1] == 0xCD);
+	assert(reply[2] == (FLAG_QR | FLAG_RD) && reply[7] == 1);
+	assert(memcmp(reply + sizeof(DnsHeader), query + sizeof(DnsHeader), sizeof(query) - sizeof(DnsHeader)) == 0);
+	assert(memcmp(reply + rv - 4, "\x01\x02\x03\x04", 4) == 0);
+}
+
+static lwiot::String probe(const char *request)
+{
+	lwiot::SocketTcpClient client;
+	char buffer[512];
+	size_t length = 0;
+	auto start = lwiot_tick_ms();
+
+	assert(client.connect(lwiot::IPAddress(127, 0, 0, 1), HTTP_PORT));
+	client.write(request);
+
+	while(lwiot_tick_ms() - start < 3000 && length < sizeof(buffer) - 1) {
+		if(client.available() == 0) {
+			if(!client.alive())
+				break;
+
+			lwiot_sleep(5);
+			continue;
+		}
+
+		auto rv = client.read(buffer + length, sizeof(buffer) - 1 - length);
+
+		if(rv <= 0)
+			break;
+
+		length += rv;
+	}
+
+	buffer[length] = '\0';
+	client.close();
+	return lwiot::String(buffer);
+}
+
+static void test_probes(lwiot::CaptivePortal& portal)
+{
+	lwiot::HttpServer server(new lwiot::SocketTcpServer(BIND_ADDR_LB, HTTP_PORT));
+	lwiot::FunctionalThread worker("http");
+	lwiot::AtomicBool running(true);
+
+	portal.redirectProbes(server, "/setup");
+	server.on("/setup", lwiot::HTTP_GET, [](lwiot::HttpServer& srv) {
+		srv.send(200, "text/plain", "setup");
+	});
+
+	assert(server.begin());
+
+	worker.start([&]() {
+		while(running)
+			server.handleClient();
+	});
+
+	auto response = probe("GET /generate_204 HTTP/1.1\r\nHost: connectivitycheck.android.com\r\n\r\n");
+	assert(response.startsWith("HTTP/1.1 302"));
+	assert(response.indexOf("Location: http://1.2.3.4/setup\r\n") > 0);
+	assert(response.indexOf("Content-Length: 0\r\n") > 0);
+
+	response = probe("GET /hotspot-detect.html?x=1 HTTP/1.0\r\n\r\n");
+	assert(response.startsWith("HTTP/1.1 302"));
+
+	/* Everything else takes the normal route. */
+	response = probe("GET /setup HTTP/1.1\r\nHost: test\r\n\r\n");
+	assert(response.startsWith("HTTP/1.1 200") && response.endsWith("setup"));
+
+	response = probe("GET /generate_2040 HTTP/1.1\r\nHost: test\r\n\r\n");
+	assert(response.startsWith("HTTP/1.1 404"));
+
+	running = false;
+	worker.join();
+	server.close();
+}
+
 static void start_and_run_server()
 {
 	lwiot::SocketUdpServer *srv = new lwiot::SocketUdpServer();
@@ -27,7 +129,9 @@ static void start_and_run_server()
 	                            lwiot::IPAddress(lwiot::IPAddress::fromString("1.2.3.4")));
 
 	portal.begin(srv, 5300);
-	lwiot_sleep(5000);
+	test_dns();
+	test_probes(portal);
+	lwiot_sleep(1000);
 	portal.end();
 	print_dbg("Captive portal test complete!");
 }
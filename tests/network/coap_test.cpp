@@ -0,0 +1,365 @@
+/*
+ * CoAP unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/util/cbor.h>
+#include <lwiot/network/coap.h>
+#include <lwiot/network/coapendpoint.h>
+#include <lwiot/network/udpclient.h>
+#include <lwiot/network/socketudpserver.h>
+
+#define SERVER_PORT 5593
+#define CLIENT_PORT 5594
+#define RAW_PORT 5595
+#define DEAD_PORT 5596
+
+#define LARGE 1300
+#define UPLOAD 1500
+
+static const lwiot::IPAddress localhost(127, 0, 0, 1);
+
+template <typename Func>
+static void wait_for(Func&& done)
+{
+	for(int idx = 0; idx < 300 && !done(); idx++)
+		lwiot_sleep(10);
+
+	assert(done());
+}
+
+static void test_message()
+{
+	lwiot::CoapMessage msg(lwiot::CoapType::Confirmable, lwiot::COAP_GET, 0x1234);
+	lwiot::CoapMessage parsed;
+	lwiot::CoapBlock block;
+	uint8_t buffer[128];
+	char path[32];
+	const uint8_t token[] = { 1, 2, 3 };
+	uint32_t value;
+
+	msg.setToken(token, sizeof(token));
+	assert(msg.setPath("/sensors/temp?unit=c&raw"));
+	assert(msg.addOption(lwiot::COAP_OPTION_OBSERVE, 0U));
+	assert(msg.setBlock(lwiot::COAP_OPTION_BLOCK2, lwiot::CoapBlock(3, true, 64)));
+	assert(msg.addOption(lwiot::COAP_OPTION_SIZE1, 300U));
+	msg.setPayload("abc", 3);
+
+	auto length = msg.encode(buffer, sizeof(buffer));
+	assert(length > 0);
+	assert(msg.encode(buffer, 10) == -ENOMEMORY);
+	assert(parsed.parse(buffer, static_cast<size_t>(length)));
+
+	assert(parsed.type() == lwiot::CoapType::Confirmable);
+	assert(parsed.code() == lwiot::COAP_GET);
+	assert(parsed.id() == 0x1234);
+	assert(parsed.sameToken(msg));
+	assert(parsed.path(path, sizeof(path)) == strlen("/sensors/temp"));
+	assert(memcmp(path, "/sensors/temp", strlen("/sensors/temp")) == 0);
+	assert(parsed.hasOption(lwiot::COAP_OPTION_URI_QUERY));
+	assert(parsed.option(lwiot::COAP_OPTION_OBSERVE, value) && value == 0);
+	assert(parsed.option(lwiot::COAP_OPTION_SIZE1, value) && value == 300);
+	assert(parsed.block(lwiot::COAP_OPTION_BLOCK2, block));
+	assert(block.num == 3 && block.more && block.size == 64);
+	assert(parsed.payloadLength() == 3 && memcmp(parsed.payload(), "abc", 3) == 0);
+
+	/* Copies keep the options that are stored inside the message. */
+	lwiot::CoapMessage copy(msg);
+	assert(copy.option(lwiot::COAP_OPTION_SIZE1, value) && value == 300);
+	assert(copy.path() == "/sensors/temp");
+
+	/* Options with extended deltas and lengths. */
+	lwiot::CoapMessage big(lwiot::CoapType::NonConfirmable, lwiot::COAP_POST, 7);
+	char uri[40];
+
+	memset(uri, 'x', sizeof(uri));
+	assert(big.addOption(lwiot::COAP_OPTION_PROXY_URI, uri, sizeof(uri)));
+	assert(big.addOption(2000, 1U));
+	length = big.encode(buffer, sizeof(buffer));
+	assert(length > 0);
+	assert(parsed.parse(buffer, static_cast<size_t>(length)));
+	assert(parsed.option(2000, value) && value == 1);
+
+	lwiot::RawBuffer raw(nullptr, 0);
+	assert(parsed.option(lwiot::COAP_OPTION_PROXY_URI, raw) && raw.size() == sizeof(uri));
+
+	/* Malformed datagrams. */
+	buffer[0] = 0x80;
+	assert(!parsed.parse(buffer, 4));
+	assert(!parsed.parse(buffer, 2));
+	buffer[0] = 0x48;
+	buffer[1] = lwiot::COAP_GET;
+	assert(!parsed.parse(buffer, 8));
+
+	assert(lwiot::CoapBlock::fit(700) == 512);
+	assert(lwiot::CoapBlock::fit(2000) == 1024);
+	assert(lwiot::CoapBlock::decode(lwiot::CoapBlock(5, false, 256).encode(), block) && block.num == 5 && !block.more);
+
+	print_dbg("CoAP message test passed!\n");
+}
+
+static void test_requests(lwiot::CoapEndpoint& server, lwiot::CoapEndpoint& client)
+{
+	volatile bool done = false;
+	lwiot::ByteBuffer large(LARGE, true);
+	lwiot::ByteBuffer uploaded;
+
+	for(int idx = 0; idx < LARGE; idx++)
+		large.write(static_cast<uint8_t>(idx));
+
+	assert(server.on("/sensors/{id}", lwiot::COAP_GET, [](const lwiot::CoapMessage& request, lwiot::CoapMessage& response,
+	                                                       const lwiot::HttpPathArgs& args) {
+		lwiot::CborWriter cbor(response.body());
+
+		cbor.beginMap(1).member("id", args.values[0]);
+		response.setContentFormat(lwiot::COAP_FORMAT_CBOR);
+	}));
+	assert(!server.on("/sensors/{id}", lwiot::COAP_GET, lwiot::CoapEndpoint::Handler()));
+
+	assert(server.on("/large", lwiot::COAP_GET, [&](const lwiot::CoapMessage& request, lwiot::CoapMessage& response,
+	                                                const lwiot::HttpPathArgs& args) {
+		response.body().write(large);
+	}));
+
+	assert(server.on("/upload", lwiot::COAP_POST, [&](const lwiot::CoapMessage& request, lwiot::CoapMessage& response,
+	                                                  const lwiot::HttpPathArgs& args) {
+		uploaded.write(request.payload(), request.payloadLength());
+		response.setCode(lwiot::COAP_CHANGED);
+	}));
+
+	/* Piggybacked response with a CBOR payload. */
+	assert(client.get(localhost, SERVER_PORT, "/sensors/42", [&](const lwiot::CoapMessage *response) {
+		lwiot::CborReader reader(response->payload(), response->payloadLength());
+		lwiot::CborReader::Item item;
+		uint32_t format;
+
+		assert(response->code() == lwiot::COAP_CONTENT);
+		assert(response->option(lwiot::COAP_OPTION_CONTENT_FORMAT, format) && format == lwiot::COAP_FORMAT_CBOR);
+		assert(reader.next(item) && item.type == lwiot::CborReader::Type::Map);
+		assert(reader.next(item) && item.text() == "id");
+		assert(reader.next(item) && item.text() == "42");
+		done = true;
+	}));
+	wait_for([&]() { return done; });
+
+	/* Unknown resources and methods. */
+	done = false;
+	assert(client.get(localhost, SERVER_PORT, "/missing", [&](const lwiot::CoapMessage *response) {
+		assert(response->code() == lwiot::COAP_NOT_FOUND);
+		done = true;
+	}));
+	wait_for([&]() { return done; });
+
+	lwiot::CoapMessage del(lwiot::CoapType::NonConfirmable, lwiot::COAP_DELETE);
+	assert(del.setPath("/large"));
+	done = false;
+	assert(client.request(localhost, SERVER_PORT, del, [&](const lwiot::CoapMessage *response) {
+		assert(response->code() == lwiot::COAP_METHOD_NOT_ALLOWED);
+		assert(response->type() == lwiot::CoapType::NonConfirmable);
+		done = true;
+	}));
+	wait_for([&]() { return done; });
+
+	/* Block-wise response. */
+	done = false;
+	assert(client.get(localhost, SERVER_PORT, "/large", [&](const lwiot::CoapMessage *response) {
+		assert(response->code() == lwiot::COAP_CONTENT);
+		assert(response->payloadLength() == LARGE);
+		assert(memcmp(response->payload(), large.data(), LARGE) == 0);
+		assert(!response->hasOption(lwiot::COAP_OPTION_BLOCK2));
+		done = true;
+	}));
+	wait_for([&]() { return done; });
+
+	/*
+	 * The body of a block-wise response stays valid until the handler returns, even though
+	 * the exchange is gone by then. Allocations in the handler would reuse a freed body;
+	 * built with -fsanitize=address, reading it fails right away.
+	 */
+	done = false;
+	assert(client.get(localhost, SERVER_PORT, "/large", [&](const lwiot::CoapMessage *response) {
+		for(size_t size = LARGE; size <= 4 * LARGE; size += 16) {
+			auto scratch = static_cast<uint8_t *>(lwiot_mem_alloc(size));
+
+			memset(scratch, 0xA5, size);
+			lwiot_mem_free(scratch);
+		}
+
+		assert(response->payloadLength() == LARGE);
+		assert(memcmp(response->payload(), large.data(), LARGE) == 0);
+		done = true;
+	}));
+	wait_for([&]() { return done; });
+
+	/* Block-wise request. */
+	lwiot::CoapMessage post(lwiot::CoapType::Confirmable, lwiot::COAP_POST);
+	uint8_t body[UPLOAD];
+
+	for(int idx = 0; idx < UPLOAD; idx++)
+		body[idx] = static_cast<uint8_t>(idx * 7);
+
+	assert(post.setPath("/upload"));
+	post.setPayload(body, sizeof(body));
+	done = false;
+	assert(client.request(localhost, SERVER_PORT, post, [&](const lwiot::CoapMessage *response) {
+		lwiot::CoapBlock block;
+
+		assert(response->code() == lwiot::COAP_CHANGED);
+		assert(response->block(lwiot::COAP_OPTION_BLOCK1, block) && !block.more);
+		done = true;
+	}));
+	wait_for([&]() { return done; });
+	assert(uploaded.index() == UPLOAD);
+	assert(memcmp(uploaded.data(), body, UPLOAD) == 0);
+
+	print_dbg("CoAP request test passed!\n");
+}
+
+static void test_observe(lwiot::CoapEndpoint& server, lwiot::CoapEndpoint& client)
+{
+	volatile int notifications = 0;
+	volatile int value = 10;
+
+	assert(server.on("/counter", lwiot::COAP_GET, [&](const lwiot::CoapMessage& request, lwiot::CoapMessage& response,
+	                                                  const lwiot::HttpPathArgs& args) {
+		lwiot::CborWriter cbor(response.body());
+		cbor.write(static_cast<int>(value));
+	}));
+
+	auto handle = client.observe(localhost, SERVER_PORT, "/counter", [&](const lwiot::CoapMessage *response) {
+		lwiot::CborReader reader(response->payload(), response->payloadLength());
+		lwiot::CborReader::Item item;
+
+		assert(response->hasOption(lwiot::COAP_OPTION_OBSERVE));
+		assert(reader.next(item) && item.integer() == value);
+		notifications++;
+	});
+
+	assert(handle > 0);
+	wait_for([&]() { return notifications == 1; });
+	assert(server.observers() == 1);
+
+	value = 11;
+	assert(server.notify("/counter") == 1);
+	wait_for([&]() { return notifications == 2; });
+
+	value = 12;
+	assert(server.notify("/counter", true) == 1);
+	wait_for([&]() { return notifications == 3; });
+	assert(server.notify("/missing") == 0);
+
+	/* The next notification after a cancel is rejected, which ends the observation. */
+	client.cancel(handle);
+	assert(server.notify("/counter") == 1);
+	wait_for([&]() { return server.observers() == 0; });
+	assert(notifications == 3);
+
+	print_dbg("CoAP observe test passed!\n");
+}
+
+static void test_duplicates(lwiot::CoapEndpoint& server)
+{
+	lwiot::SocketUdpServer raw(BIND_ADDR_LB, RAW_PORT);
+	lwiot::CoapMessage request(lwiot::CoapType::Confirmable, lwiot::COAP_GET, 0x4321);
+	lwiot::CoapMessage response;
+	lwiot::IPAddress addr;
+	uint8_t buffer[CONFIG_COAP_MESSAGE_SIZE];
+	uint16_t port;
+	uint8_t reply[64];
+
+	assert(raw.bind());
+	raw.setTimeout(2);
+
+	auto before = server.statistics();
+
+	request.setToken("t", 1);
+	assert(request.setPath("/sensors/7"));
+
+	auto length = request.encode(buffer, sizeof(buffer));
+	assert(length > 0);
+
+	for(int idx = 0; idx < 2; idx++) {
+		assert(raw.sendTo(buffer, static_cast<size_t>(length), localhost, SERVER_PORT) == length);
+
+		auto num = raw.recvFrom(reply, sizeof(reply), addr, port);
+		assert(num > 0);
+		assert(response.parse(reply, static_cast<size_t>(num)));
+		assert(response.type() == lwiot::CoapType::Acknowledgement);
+		assert(response.id() == 0x4321);
+		assert(response.code() == lwiot::COAP_CONTENT);
+	}
+
+	assert(server.statistics().duplicates == before.duplicates + 1);
+
+	/* Pings are answered with a reset. */
+	lwiot::CoapMessage ping(lwiot::CoapType::Confirmable, lwiot::COAP_EMPTY, 0x55);
+	length = ping.encode(buffer, sizeof(buffer));
+	assert(raw.sendTo(buffer, static_cast<size_t>(length), localhost, SERVER_PORT) == length);
+	assert(raw.recvFrom(reply, sizeof(reply), addr, port) == 4);
+	assert(response.parse(reply, 4));
+	assert(response.type() == lwiot::CoapType::Reset && response.id() == 0x55);
+
+	raw.close();
+	print_dbg("CoAP duplicate test passed!\n");
+}
+
+static void test_timeout(lwiot::CoapEndpoint& client)
+{
+	volatile bool done = false;
+	auto before = client.statistics();
+
+	client.setAckTimeout(20, 2);
+	assert(client.get(localhost, DEAD_PORT, "/nobody", [&](const lwiot::CoapMessage *response) {
+		assert(response == nullptr);
+		done = true;
+	}));
+
+	wait_for([&]() { return done; });
+
+	auto stats = client.statistics();
+	assert(stats.retransmissions == before.retransmissions + 2);
+	assert(stats.timeouts == before.timeouts + 1);
+	print_dbg("CoAP retransmission test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	test_message();
+
+	{
+		lwiot::CoapEndpoint server;
+		lwiot::CoapEndpoint client;
+		auto udp = new lwiot::SocketUdpServer(BIND_ADDR_LB, SERVER_PORT);
+		auto other = new lwiot::SocketUdpServer(BIND_ADDR_LB, CLIENT_PORT);
+
+		assert(udp->bind());
+		assert(other->bind());
+		server.begin(udp);
+		client.begin(other);
+
+		test_requests(server, client);
+		test_observe(server, client);
+		test_duplicates(server);
+		test_timeout(client);
+
+		client.end();
+		server.end();
+	}
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+/*
+ * Connection pool unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/scopedlock.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/network/connectionpool.h>
+#include <lwiot/network/tcpacceptorpool.h>
+
+#define PORT 5560
+#define MAX_PEERS 8
+
+static lwiot::Lock lock(false);
+static lwiot::UniquePointer<lwiot::TcpClient> peers[MAX_PEERS];
+static int npeers = 0;
+
+static void close_peers()
+{
+	lwiot::ScopedLock guard(lock);
+
+	for(auto& peer : peers)
+		peer.reset();
+
+	npeers = 0;
+}
+
+static int accepted()
+{
+	lwiot::ScopedLock guard(lock);
+	return npeers;
+}
+
+static void test_pool()
+{
+	lwiot::TcpAcceptorPool server(1);
+	lwiot::ConnectionPool pool(2, 200);
+	lwiot::String host("127.0.0.1");
+
+	assert(server.start(BIND_ADDR_LB, PORT, [](lwiot::UniquePointer<lwiot::TcpClient>& client) {
+		lwiot::ScopedLock guard(lock);
+
+		assert(npeers < MAX_PEERS);
+		peers[npeers++] = lwiot::stl::move(client);
+	}));
+
+	pool.setConnectTimeout(1000);
+
+	/* A released connection is handed out again. */
+	lwiot::TcpClient *first;
+	{
+		auto lease = pool.acquire(host, PORT);
+		assert(lease);
+		first = &lease.client();
+	}
+
+	assert(pool.idle() == 1);
+	{
+		auto lease = pool.acquire(host, PORT);
+		assert(&lease.client() == first);
+	}
+
+	/* The per host limit holds. */
+	{
+		auto a = pool.acquire(host, PORT);
+		auto b = pool.acquire(host, PORT);
+		auto c = pool.acquire(host, PORT);
+
+		assert(a && b);
+		assert(!c);
+		assert(pool.size() == 2);
+
+		b.discard();
+		assert(pool.size() == 1);
+	}
+
+	lwiot_sleep(50);
+	assert(accepted() == 2);
+
+	/* A connection closed by the peer is not handed out. */
+	close_peers();
+	lwiot_sleep(50);
+	{
+		auto lease = pool.acquire(host, PORT);
+		assert(lease);
+		assert(lease->alive());
+	}
+
+	lwiot_sleep(50);
+	assert(accepted() == 1);
+
+	/* Idle connections expire. */
+	lwiot_sleep(250);
+	pool.purge();
+	assert(pool.size() == 0);
+
+	close_peers();
+	server.stop();
+	print_dbg("Connection pool test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	test_pool();
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
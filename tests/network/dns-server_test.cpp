@@ -6,6 +6,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <lwiot.h>
 #include <assert.h>
 
@@ -16,10 +17,75 @@
 #include <lwiot/network/udpclient.h>
 #include <lwiot/network/udpserver.h>
 #include <lwiot/network/socketudpserver.h>
+#include <lwiot/network/socketudpclient.h>
 #include <lwiot/network/dnsserver.h>
 
 #include <lwiot/stl/move.h>
 
+static size_t query(lwiot::UdpClient& client, const char *name, uint16_t id, uint8_t *reply)
+{
+	uint8_t packet[DNS_LEN];
+	size_t length = sizeof(DnsHeader);
+	ssize_t rv;
+
+	memset(packet, 0, sizeof(DnsHeader));
+	packet[0] = id >> 8;
+	packet[1] = id & 0xFF;
+	packet[2] = FLAG_RD;
+	packet[5] = 1;
+
+	for(auto label = name; *label; ) {
+		auto end = strchr(label, '.');
+		auto len = end ? end - label : strlen(label);
+
+		packet[length++] = static_cast<uint8_t>(len);
+		memcpy(packet + length, label, len);
+		length += len;
+		label += end ? len + 1 : len;
+	}
+
+	packet[length++] = 0;
+	packet[length++] = 0;
+	packet[length++] = QTYPE_A;
+	packet[length++] = 0;
+	packet[length++] = QCLASS_IN;
+
+	assert(client.write(packet, length) == static_cast<ssize_t>(length));
+	rv = client.read(reply, DNS_LEN);
+	assert(rv >= static_cast<ssize_t>(sizeof(DnsHeader)));
+
+	/* The question is sent back as it was asked. */
+	assert(reply[0] == packet[0] && reply[1] == packet[1]);
+	assert(rv < static_cast<ssize_t>(length) || memcmp(reply + sizeof(DnsHeader), packet + sizeof(DnsHeader),
+		length - sizeof(DnsHeader)) == 0);
+
+	return static_cast<size_t>(rv);
+}
+
+static void test_queries()
+{
+	lwiot::SocketUdpClient client(lwiot::IPAddress(127,0,0,1), 5000);
+	uint8_t reply[DNS_LEN];
+	size_t length;
+
+	client.setTimeout(2);
+
+	length = query(client, "WWW.Test.com", 0x1234, reply);
+	assert(reply[2] == (FLAG_QR | FLAG_AA | FLAG_RD) && reply[3] == 0);
+	assert(reply[7] == 1);
+	assert(memcmp(reply + length - 4, "\x7f\x00\x00\x02", 4) == 0);
+
+	length = query(client, "test.com", 0x4321, reply);
+	assert(reply[7] == 1);
+	assert(memcmp(reply + length - 4, "\x7f\x00\x00\x01", 4) == 0);
+
+	query(client, "unknown.com", 1, reply);
+	assert(reply[3] == static_cast<uint8_t>(lwiot::DnsReplyCode::NonExistentDomain));
+	assert(reply[7] == 0);
+
+	print_dbg("DNS server query test done!\n");
+}
+
 static void start_and_run_server()
 {
 	auto udp = new lwiot::SocketUdpServer(BIND_ADDR_LB, 5000);
@@ -27,9 +93,11 @@ static void start_and_run_server()
 
 	srv.map("test.com", lwiot::IPAddress(127,0,0,1));
 	srv.map("www.test.com", lwiot::IPAddress(127,0,0,1));
+	srv.map("WWW.TEST.COM", lwiot::IPAddress(127,0,0,2));
 	udp->bind();
 	srv.begin(udp);
 
+	test_queries();
 	lwiot_sleep(1000);
 	wait_close();
 	srv.end();
@@ -0,0 +1,99 @@
+/*
+ * DNS client unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/executor.h>
+#include <lwiot/network/dnsclient.h>
+
+static const uint32_t loopback = static_cast<uint32_t>(lwiot::IPAddress(127,0,0,1));
+
+static void test_cache()
+{
+	lwiot::DnsClient dns(1000, 100);
+	lwiot::String host("localhost");
+	lwiot::String invalid("lwiot-test.invalid");
+	lwiot::IPAddress address;
+
+	assert(!dns.cached(host, address));
+	address = dns.lookup(host);
+	assert(static_cast<uint32_t>(address) == loopback);
+
+	address = lwiot::IPAddress(0,0,0,0);
+	assert(dns.cached(host, address));
+	assert(static_cast<uint32_t>(address) == loopback);
+
+	/* Failures are cached for the negative TTL. */
+	address = dns.lookup(invalid);
+	assert(static_cast<uint32_t>(address) == 0);
+	assert(dns.cached(invalid, address));
+
+	lwiot_sleep(150);
+	assert(!dns.cached(invalid, address));
+	assert(dns.cached(host, address));
+
+	dns.flush();
+	assert(!dns.cached(host, address));
+
+	print_dbg("DNS cache test passed!\n");
+}
+
+static void test_async()
+{
+	lwiot::DnsClient dns;
+	lwiot::Executor executor("dns");
+	lwiot::String host("localhost");
+	lwiot::atomic_int_t done(0);
+	lwiot::atomic_int_t found(0);
+
+	executor.start();
+
+	auto handler = [&](const lwiot::String& name, const lwiot::IPAddress& address) {
+		assert(name == host);
+
+		if(static_cast<uint32_t>(address) == loopback)
+			found.fetch_add(1);
+
+		done.fetch_add(1);
+	};
+
+	/* Concurrent lookups share a query. */
+	assert(dns.lookup(host, executor, handler));
+	assert(dns.lookup(host, executor, handler));
+
+	for(int idx = 0; idx < 100 && done.load() < 2; idx++)
+		lwiot_sleep(10);
+
+	assert(done.load() == 2);
+	assert(found.load() == 2);
+
+	/* Cached results complete immediately. */
+	assert(dns.lookup(host, executor, handler));
+	assert(done.load() == 3);
+	assert(found.load() == 3);
+
+	executor.stop();
+	print_dbg("Async DNS test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	test_cache();
+	test_async();
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
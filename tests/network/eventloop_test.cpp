@@ -0,0 +1,101 @@
+/*
+ * Socket event loop unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/network/eventloop.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+
+#include <lwiot/stl/move.h>
+
+#define PORT 5556
+#define CLIENTS 2
+
+static void test_echo()
+{
+	lwiot::SocketTcpServer server;
+	lwiot::UniquePointer<lwiot::TcpClient> accepted[CLIENTS];
+	lwiot::EventLoop loop(20);
+	lwiot::FunctionalThread worker("event-loop");
+	int naccepted = 0;
+
+	assert(server.bind(BIND_ADDR_LB, PORT));
+
+	/* One thread accepts and serves all connections. */
+	assert(loop.add(server, [&](uint32_t events) {
+		assert(events & SOCKET_POLL_READ);
+		assert(naccepted < CLIENTS);
+
+		auto& slot = accepted[naccepted++];
+		slot = server.accept();
+		auto *client = static_cast<lwiot::SocketTcpClient*>(slot.get());
+
+		loop.add(*client, SOCKET_POLL_READ, [&loop, client](uint32_t events) {
+			uint8_t buffer[16];
+
+			if(events & SOCKET_POLL_ERROR || client->available() == 0) {
+				loop.remove(client->handle());
+				return;
+			}
+
+			auto num = client->read(buffer, sizeof(buffer));
+			client->write(buffer, num);
+		});
+	}));
+
+	assert(!loop.add(server, [](uint32_t) {}));
+	worker.start([&]() { loop.run(); });
+
+	lwiot::SocketTcpClient c1, c2;
+	lwiot::IPAddress addr(127, 0, 0, 1);
+	uint8_t data[] = {'a', 'b', 'c', 'd'};
+	uint8_t buffer[4];
+
+	assert(c1.connect(addr, PORT));
+	assert(c2.connect(addr, PORT));
+
+	c2.write(data, sizeof(data));
+	assert(c2.read(buffer, sizeof(buffer)) == sizeof(buffer));
+	assert(memcmp(data, buffer, sizeof(buffer)) == 0);
+
+	c1.write(data, sizeof(data));
+	assert(c1.read(buffer, sizeof(buffer)) == sizeof(buffer));
+	assert(memcmp(data, buffer, sizeof(buffer)) == 0);
+
+	assert(naccepted == CLIENTS);
+	assert(loop.size() == 3);
+
+	/* A closed peer reports readable with no data, the handler removes it. */
+	c1.close();
+	lwiot_sleep(100);
+	assert(loop.size() == 2);
+
+	loop.stop();
+	worker.join();
+
+	c2.close();
+	server.close();
+	print_dbg("Event loop test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	test_echo();
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,313 @@
+/*
+ * HTTP chunked response unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/bytebuffer.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/util/json.h>
+#include <lwiot/util/timeseriesstore.h>
+#include <lwiot/network/httpserver.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+
+#define PORT 5564
+#define LINES 2000
+#define SERIES "httpchunked_series.bin"
+
+static lwiot::AtomicBool running(true);
+
+static lwiot::String line(int idx)
+{
+	return lwiot::String("sample,") + lwiot::String(idx) + ",21.5\n";
+}
+
+static lwiot::String expected()
+{
+	lwiot::String body;
+
+	for(int idx = 0; idx < LINES; idx++)
+		body += line(idx);
+
+	return body;
+}
+
+/* Send a request and read the response until the server closes the connection. */
+static lwiot::ByteBuffer request(const char *head)
+{
+	lwiot::SocketTcpClient client;
+	lwiot::IPAddress addr(127, 0, 0, 1);
+	lwiot::ByteBuffer response(4096);
+	char buffer[512];
+	auto start = lwiot_tick_ms();
+
+	assert(client.connect(addr, PORT));
+	client.write(head, strlen(head));
+
+	while(lwiot_tick_ms() - start < 5000) {
+		if(client.available() == 0) {
+			if(!client.alive())
+				break;
+
+			lwiot_sleep(5);
+			continue;
+		}
+
+		auto rv = client.read(buffer, sizeof(buffer));
+
+		if(rv <= 0)
+			break;
+
+		response.write(buffer, rv);
+	}
+
+	client.close();
+	return response;
+}
+
+static size_t body_offset(const lwiot::ByteBuffer& response)
+{
+	auto data = reinterpret_cast<const char *>(response.data());
+
+	for(size_t idx = 0; idx + 4 <= response.index(); idx++) {
+		if(memcmp(data + idx, "\r\n\r\n", 4) == 0)
+			return idx + 4;
+	}
+
+	assert(false);
+	return 0;
+}
+
+/* The head, as text. */
+static lwiot::String head(const lwiot::ByteBuffer& response)
+{
+	auto length = body_offset(response);
+	lwiot::String text;
+
+	for(size_t idx = 0; idx < length; idx++)
+		text += static_cast<char>(response.data()[idx]);
+
+	return text;
+}
+
+static lwiot::String header(const lwiot::String& response, const char *name)
+{
+	auto start = response.indexOf(name);
+
+	if(start < 0)
+		return "";
+
+	start += strlen(name) + 2;
+	return response.substring(start, response.indexOf("\r\n", start));
+}
+
+static bool equals(const lwiot::ByteBuffer& data, const lwiot::String& text)
+{
+	return data.index() == text.length() && memcmp(data.data(), text.c_str(), text.length()) == 0;
+}
+
+/* Decode a chunked body, counting the chunks. */
+static lwiot::ByteBuffer dechunk(const lwiot::ByteBuffer& response, int& chunks)
+{
+	lwiot::ByteBuffer output(4096);
+	auto data = reinterpret_cast<const char *>(response.data());
+	size_t pos = body_offset(response);
+
+	chunks = 0;
+
+	while(true) {
+		char *end;
+		auto size = strtoul(data + pos, &end, 16);
+
+		assert(end > data + pos && memcmp(end, "\r\n", 2) == 0);
+		pos = end - data + 2;
+
+		if(size == 0) {
+			assert(response.index() - pos == 2 && memcmp(data + pos, "\r\n", 2) == 0);
+			return output;
+		}
+
+		assert(pos + size + 2 <= response.index());
+		output.write(data + pos, size);
+		pos += size + 2;
+		chunks++;
+	}
+}
+
+#ifdef HAVE_ZLIB
+static lwiot::ByteBuffer inflate_body(const lwiot::ByteBuffer& data)
+{
+	lwiot::ByteBuffer output(4096);
+	z_stream stream;
+	uint8_t buffer[256];
+	int rv;
+
+	memset(&stream, 0, sizeof(stream));
+	assert(inflateInit2(&stream, 15 + 32) == Z_OK);
+
+	stream.next_in = data.data();
+	stream.avail_in = data.index();
+
+	do {
+		stream.next_out = buffer;
+		stream.avail_out = sizeof(buffer);
+		rv = inflate(&stream, Z_NO_FLUSH);
+		assert(rv == Z_OK || rv == Z_STREAM_END);
+
+		output.write(buffer, sizeof(buffer) - stream.avail_out);
+	} while(rv != Z_STREAM_END);
+
+	inflateEnd(&stream);
+	return output;
+}
+#endif
+
+static void stream_lines(lwiot::HttpServer& server, lwiot::HttpContentCoding coding)
+{
+	assert(server.beginChunked(200, "text/csv", coding));
+
+	for(int idx = 0; idx < LINES; idx++)
+		assert(server.writeChunk(line(idx)) > 0);
+
+	assert(server.endChunked());
+}
+
+static void test_chunked()
+{
+	lwiot::HttpServer server(new lwiot::SocketTcpServer(BIND_ADDR_LB, PORT));
+	lwiot::FunctionalThread worker("http");
+	lwiot::String large;
+	int chunks;
+
+	remove(SERIES);
+	lwiot::FileTimeSeriesStore series(SERIES, 4, 256);
+
+	for(int idx = 0; idx < 100; idx++)
+		assert(series.add(1000 + idx * 1000, idx * 0.5));
+
+	for(int idx = 0; idx < 3 * CONFIG_HTTP_CHUNK_BUFFER; idx++)
+		large += static_cast<char>('a' + idx % 26);
+
+	server.on("/history.csv", [&](lwiot::HttpServer& srv) {
+		stream_lines(srv, lwiot::HttpContentCoding::Identity);
+	});
+
+	server.on("/history.csv.gz", [&](lwiot::HttpServer& srv) {
+		stream_lines(srv, lwiot::HttpContentCoding::Gzip);
+	});
+
+	server.on("/mixed", [&](lwiot::HttpServer& srv) {
+		/* Small writes are collected, large ones are sent as they are; the handler does not end the body. */
+		assert(srv.beginChunked(200, "text/plain"));
+		srv.writeChunk("head ");
+		srv.writeChunk(large);
+		srv.sendContent(" tail");
+	});
+
+	server.serveTimeSeries("/series", series);
+
+	lwiot::DynamicJsonBuffer jbuffer;
+	lwiot::String document;
+	auto& doc = jbuffer.createObject();
+	auto& values = doc.createNestedArray("values");
+
+	doc["sensor"] = "bme280 \"outside\"";
+
+	for(int idx = 0; idx < 100; idx++)
+		values.add(idx * 3);
+
+	doc.printTo(document);
+
+	server.on("/json", [&](lwiot::HttpServer& srv) {
+		srv.sendJson(200, doc);
+	});
+
+	assert(server.begin());
+
+	worker.start([&]() {
+		while(running)
+			server.handleClient();
+	});
+
+	auto response = request("GET /history.csv HTTP/1.1\r\nHost: test\r\n\r\n");
+	auto text = head(response);
+	assert(text.startsWith("HTTP/1.1 200"));
+	assert(header(text, "Transfer-Encoding") == "chunked");
+	assert(header(text, "Content-Type") == "text/csv");
+	assert(equals(dechunk(response, chunks), expected()));
+	/* Chunks are no larger than the send buffer. */
+	assert(chunks >= static_cast<int>(expected().length() / CONFIG_HTTP_CHUNK_BUFFER));
+
+	/* HTTP/1.0 clients get the plain body, ended by closing the connection. */
+	response = request("GET /history.csv HTTP/1.0\r\n\r\n");
+	text = head(response);
+	assert(text.startsWith("HTTP/1.0 200"));
+	assert(text.indexOf("Transfer-Encoding") < 0);
+	assert(response.index() - text.length() == expected().length());
+	assert(memcmp(response.data() + text.length(), expected().c_str(), expected().length()) == 0);
+
+	response = request("GET /mixed HTTP/1.1\r\n\r\n");
+	assert(equals(dechunk(response, chunks), lwiot::String("head ") + large + " tail"));
+
+	/* Compression is only used when the client accepts it. */
+	response = request("GET /history.csv.gz HTTP/1.1\r\n\r\n");
+	assert(head(response).indexOf("Content-Encoding") < 0);
+	assert(equals(dechunk(response, chunks), expected()));
+
+#ifdef HAVE_ZLIB
+	response = request("GET /history.csv.gz HTTP/1.1\r\nAccept-Encoding: gzip, deflate\r\n\r\n");
+	assert(header(head(response), "Content-Encoding") == "gzip");
+
+	auto compressed = dechunk(response, chunks);
+	assert(compressed.index() < expected().length());
+	assert(equals(inflate_body(compressed), expected()));
+#endif
+
+	response = request("GET /series?from=2000&to=4000 HTTP/1.1\r\n\r\n");
+	assert(header(head(response), "Content-Type") == "text/csv");
+	assert(equals(dechunk(response, chunks), "timestamp,value\n2000,0.5\n3000,1\n4000,1.5\n"));
+
+	response = request("GET /series?from=99000&format=json HTTP/1.1\r\n\r\n");
+	assert(header(head(response), "Content-Type") == "application/json");
+	assert(equals(dechunk(response, chunks), "[[99000,49],[100000,49.5]]"));
+
+	/* JSON documents are measured for the Content-Length and written without a copy. */
+	response = request("GET /json HTTP/1.0\r\n\r\n");
+	text = head(response);
+	assert(header(text, "Content-Type") == "application/json");
+	assert(header(text, "Content-Length").toInt() == static_cast<long>(document.length()));
+	assert(response.index() - text.length() == document.length());
+	assert(memcmp(response.data() + text.length(), document.c_str(), document.length()) == 0);
+
+	running = false;
+	worker.join();
+	server.close();
+	remove(SERIES);
+
+	print_dbg("Chunked response test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	test_chunked();
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,177 @@
+/*
+ * HTTP persistent connection unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/network/httpserver.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+
+#define PORT 5562
+
+static lwiot::AtomicBool running(true);
+
+static int occurrences(const char *haystack, const char *needle)
+{
+	int count = 0;
+
+	for(auto ptr = strstr(haystack, needle); ptr != nullptr; ptr = strstr(ptr + 1, needle))
+		count++;
+
+	return count;
+}
+
+/* Read until \p needle was seen \p num times, or the connection is closed. */
+static lwiot::String receive(lwiot::SocketTcpClient& client, const char *needle, int num)
+{
+	char buffer[2048];
+	size_t length = 0;
+	auto start = lwiot_tick_ms();
+
+	buffer[0] = '\0';
+
+	while(lwiot_tick_ms() - start < 3000 && length < sizeof(buffer) - 1) {
+		if(client.available() == 0) {
+			if(!client.alive())
+				break;
+
+			lwiot_sleep(5);
+			continue;
+		}
+
+		auto rv = client.read(buffer + length, sizeof(buffer) - 1 - length);
+
+		if(rv <= 0)
+			break;
+
+		length += rv;
+		buffer[length] = '\0';
+
+		if(occurrences(buffer, needle) >= num)
+			break;
+	}
+
+	return lwiot::String(buffer);
+}
+
+static void test_keepalive()
+{
+	lwiot::HttpServer server(new lwiot::SocketTcpServer(BIND_ADDR_LB, PORT));
+	lwiot::FunctionalThread worker("http");
+	lwiot::SocketTcpClient first, second, legacy;
+	lwiot::IPAddress addr(127, 0, 0, 1);
+	const char pipelined[] = "GET /hello HTTP/1.1\r\nHost: test\r\n\r\nGET /hello HTTP/1.1\r\nHost: test\r\n\r\n";
+
+	server.on("/hello", lwiot::HTTP_GET, [](lwiot::HttpServer& srv) {
+		srv.send(200, "text/plain", "hello");
+	});
+
+	server.on("/sensor/{id}", lwiot::HTTP_GET, [](lwiot::HttpServer& srv) {
+		srv.send(200, "text/plain", lwiot::String("sensor-") + srv.pathArg("id"));
+	});
+
+	server.on("/echo", lwiot::HTTP_ANY, [](lwiot::HttpServer& srv) {
+		srv.send(200, "text/plain", lwiot::String("echo-") + srv.arg("name") + "-" + srv.arg("q"));
+	});
+
+	server.on("/headers", lwiot::HTTP_GET, [](lwiot::HttpServer& srv) {
+		srv.send(200, "text/plain", lwiot::String("headers-") + srv.header("x-token") + "-" + srv.header("User-Agent") +
+			(srv.hasHeader("X-Other") ? "-other" : "") + (srv.hasHeader("Authorization") ? "-auth" : ""));
+	});
+
+	const char *keys[] = { "X-Token", "User-Agent", "X-Other" };
+	server.collectHeaders(keys, 3);
+	server.setMaxConnections(4, 2000);
+	server.setPipelining(true);
+	assert(server.begin());
+
+	worker.start([&]() {
+		while(running)
+			server.handleClient();
+	});
+
+	/* Two requests in a single write are both answered, on the same connection. */
+	assert(first.connect(addr, PORT));
+	assert(first.write(pipelined, sizeof(pipelined) - 1) == sizeof(pipelined) - 1);
+
+	auto response = receive(first, "\r\n\r\nhello", 2);
+	assert(occurrences(response.c_str(), "\r\n\r\nhello") == 2);
+	assert(occurrences(response.c_str(), "Connection: keep-alive") == 2);
+
+	/* A second client is served while the first one stays connected. */
+	assert(second.connect(addr, PORT));
+	second.write("GET /sensor/7 HTTP/1.1\r\nHost: test\r\n\r\n");
+	response = receive(second, "sensor-7", 1);
+	assert(response.indexOf("sensor-7") >= 0);
+	assert(first.alive());
+
+	/* A head that arrives in pieces is completed without blocking the other connections. */
+	second.write("GET /echo?name=a%20b&q=");
+	lwiot_sleep(50);
+	first.write("GET /hello HTTP/1.1\r\nHost: test\r\n\r\n");
+	response = receive(first, "\r\n\r\nhello", 1);
+	assert(response.indexOf("hello") >= 0);
+	second.write("1 HTTP/1.1\r\nHost: test\r\n\r\n");
+	response = receive(second, "echo-", 1);
+	assert(response.indexOf("echo-a b-1") >= 0);
+
+	/* Form bodies are parsed into arguments as well. */
+	second.write("POST /echo HTTP/1.1\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+			  "Content-Length: 14\r\n\r\nname=x+y&q=%32");
+	response = receive(second, "echo-", 1);
+	assert(response.indexOf("echo-x y-2") >= 0);
+
+	/* Collected headers are found by any case, and reset between requests. */
+	second.write("GET /headers HTTP/1.1\r\nX-TOKEN: abc\r\nuser-agent: test\r\nX-Other: 1\r\n\r\n");
+	response = receive(second, "headers-", 1);
+	assert(response.indexOf("headers-abc-test-other") >= 0);
+	second.write("GET /headers HTTP/1.1\r\nAuthorization: Basic eDp5\r\n\r\n");
+	response = receive(second, "headers-", 1);
+	assert(response.indexOf("headers---auth") >= 0);
+
+	/* The client can still ask for the connection to be closed. */
+	first.write("GET /hello HTTP/1.1\r\nConnection: close\r\n\r\n");
+	response = receive(first, "\r\n\r\nhello", 2);
+	assert(response.indexOf("Connection: close") >= 0);
+
+	/* HTTP/1.0 clients get a connection per request, unless they ask for keep-alive. */
+	assert(legacy.connect(addr, PORT));
+	legacy.write("GET /hello HTTP/1.0\r\n\r\n");
+	response = receive(legacy, "\r\n\r\nhello", 2);
+	assert(response.indexOf("Connection: close") >= 0);
+
+	/* Idle connections are closed by the server. */
+	lwiot_sleep(2500);
+	assert(!second.alive());
+
+	running = false;
+	worker.join();
+
+	first.close();
+	second.close();
+	legacy.close();
+	server.close();
+	print_dbg("Keep-alive test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	test_keepalive();
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,230 @@
+/*
+ * HTTP WebSocket and event stream unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/network/httpserver.h>
+#include <lwiot/network/websocket.h>
+#include <lwiot/network/eventsource.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+
+#define PORT 5565
+
+static lwiot::AtomicBool running(true);
+
+static void connect(lwiot::SocketTcpClient& client, const char *head)
+{
+	lwiot::IPAddress addr(127, 0, 0, 1);
+
+	assert(client.connect(addr, PORT));
+	client.write(head, strlen(head));
+}
+
+/* Read until \p length bytes arrived or nothing arrives for a while. */
+static size_t receive(lwiot::SocketTcpClient& client, char *buffer, size_t length)
+{
+	size_t total = 0;
+	auto start = lwiot_tick_ms();
+
+	while(total < length && lwiot_tick_ms() - start < 3000) {
+		if(client.available() == 0) {
+			lwiot_sleep(5);
+			continue;
+		}
+
+		auto rv = client.read(buffer + total, length - total);
+
+		if(rv <= 0)
+			break;
+
+		total += rv;
+	}
+
+	return total;
+}
+
+static lwiot::String head(lwiot::SocketTcpClient& client)
+{
+	lwiot::String text;
+	char c;
+
+	while(!text.endsWith("\r\n\r\n") && receive(client, &c, 1) == 1)
+		text += c;
+
+	return text;
+}
+
+static void wait_for(const lwiot::HttpPushEndpoint& endpoint, size_t subscribers)
+{
+	auto start = lwiot_tick_ms();
+
+	while(endpoint.subscribers() != subscribers && lwiot_tick_ms() - start < 3000)
+		lwiot_sleep(5);
+
+	assert(endpoint.subscribers() == subscribers);
+}
+
+static void send_frame(lwiot::SocketTcpClient& client, uint8_t opcode, const char *payload)
+{
+	uint8_t frame[64];
+	uint8_t mask[] = { 1, 2, 3, 4 };
+	auto length = strlen(payload);
+
+	frame[0] = 0x80 | opcode;
+	frame[1] = 0x80 | length;
+	memcpy(frame + 2, mask, sizeof(mask));
+
+	for(size_t idx = 0; idx < length; idx++)
+		frame[6 + idx] = payload[idx] ^ mask[idx & 3];
+
+	client.write(frame, 6 + length);
+}
+
+static lwiot::String read_frame(lwiot::SocketTcpClient& client, uint8_t& opcode)
+{
+	char header[2];
+	char payload[128];
+
+	assert(receive(client, header, 2) == 2);
+	opcode = header[0] & 0x0F;
+	assert((header[1] & 0x80) == 0);
+
+	size_t length = header[1] & 0x7F;
+	assert(length < 126);
+	assert(receive(client, payload, length) == length);
+
+	return lwiot::String(payload, length);
+}
+
+static void test_websocket(lwiot::WebSocketEndpoint& endpoint)
+{
+	lwiot::SocketTcpClient first, second;
+	uint8_t opcode;
+
+	connect(first, "GET /ws HTTP/1.1\r\nHost: test\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+	               "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n");
+
+	auto response = head(first);
+	assert(response.startsWith("HTTP/1.1 101 Switching Protocols\r\n"));
+	assert(response.indexOf("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") > 0);
+	assert(response.indexOf("Content-Length") < 0);
+
+	connect(second, "GET /ws HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+	                "Sec-WebSocket-Key: AQIDBAUGBwgJCgsMDQ4PEC==\r\nSec-WebSocket-Version: 13\r\n\r\n");
+	assert(head(second).startsWith("HTTP/1.1 101"));
+	wait_for(endpoint, 2);
+
+	/* Messages are echoed by the handler, pings answered by the endpoint. */
+	send_frame(first, 0x1, "echo me");
+	assert(read_frame(first, opcode) == "echo me");
+	assert(opcode == 0x1);
+
+	send_frame(first, 0x9, "are you there");
+	assert(read_frame(first, opcode) == "are you there");
+	assert(opcode == 0xA);
+
+	assert(endpoint.broadcast("21.5") == 2);
+	assert(read_frame(first, opcode) == "21.5");
+	assert(read_frame(second, opcode) == "21.5");
+
+	/* Closing completes the handshake and frees the slot. */
+	send_frame(second, 0x8, "\x03\xe8");
+	assert(read_frame(second, opcode).length() == 2);
+	assert(opcode == 0x8);
+	wait_for(endpoint, 1);
+
+	first.close();
+	second.close();
+	wait_for(endpoint, 0);
+
+	/* Version mismatches are refused. */
+	lwiot::SocketTcpClient old;
+	connect(old, "GET /ws HTTP/1.1\r\nUpgrade: websocket\r\nSec-WebSocket-Key: x\r\nSec-WebSocket-Version: 8\r\n\r\n");
+	response = head(old);
+	assert(response.startsWith("HTTP/1.1 426 Upgrade Required"));
+	assert(response.indexOf("Sec-WebSocket-Version: 13") > 0);
+	old.close();
+}
+
+static void test_events(lwiot::EventSource& events)
+{
+	lwiot::SocketTcpClient client;
+	char buffer[128];
+
+	events.setRetry(2000);
+	connect(client, "GET /events HTTP/1.1\r\nAccept: text/event-stream\r\n\r\n");
+
+	auto response = head(client);
+	assert(response.startsWith("HTTP/1.1 200 OK\r\n"));
+	assert(response.indexOf("Content-Type: text/event-stream") > 0);
+	assert(response.indexOf("Transfer-Encoding") < 0);
+	assert(response.indexOf("Content-Length") < 0);
+
+	const char *retry = "retry: 2000\n\n";
+	assert(receive(client, buffer, strlen(retry)) == strlen(retry));
+	assert(memcmp(buffer, retry, strlen(retry)) == 0);
+	wait_for(events, 1);
+
+	const char *event = "event: sample\nid: 7\ndata: 21.5\ndata: 40%\n\n";
+	assert(events.broadcast("21.5\n40%", "sample", "7") == 1);
+	assert(receive(client, buffer, strlen(event)) == strlen(event));
+	assert(memcmp(buffer, event, strlen(event)) == 0);
+
+	assert(events.heartbeat() == 1);
+	assert(receive(client, buffer, 3) == 3);
+	assert(memcmp(buffer, ":\n\n", 3) == 0);
+
+	client.close();
+	wait_for(events, 0);
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	lwiot::HttpServer server(new lwiot::SocketTcpServer(BIND_ADDR_LB, PORT));
+	lwiot::FunctionalThread worker("http");
+	lwiot::WebSocketEndpoint endpoint(2);
+	lwiot::EventSource events;
+
+	endpoint.onMessage([](lwiot::WebSocketEndpoint& ws, size_t client, const lwiot::WebSocketParser& message) {
+		ws.send(client, message.text());
+	});
+
+	server.setMaxConnections(4);
+	server.addEndpoint("/ws", endpoint);
+	server.addEndpoint("/events", events);
+	assert(server.begin());
+
+	worker.start([&]() {
+		while(running)
+			server.handleClient();
+	});
+
+	test_websocket(endpoint);
+	test_events(events);
+
+	running = false;
+	worker.join();
+	server.close();
+
+	print_dbg("HTTP push test passed!\n");
+
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
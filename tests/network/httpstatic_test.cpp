@@ -0,0 +1,211 @@
+/*
+ * HTTP static file unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/io/file.h>
+#include <lwiot/io/mappedregion.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/network/httpserver.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+
+#define PORT 5563
+#define INDEX "<html>lwIoT static index</html>"
+
+static lwiot::AtomicBool running(true);
+
+static void create(const char *path, const char *content)
+{
+	lwiot::File file(path, lwiot::FileMode::Write);
+
+	assert(file);
+	file.write(content, strlen(content));
+}
+
+/* Send a request and read the response until the server closes the connection. */
+static lwiot::String request(const char *head)
+{
+	lwiot::SocketTcpClient client;
+	lwiot::IPAddress addr(127, 0, 0, 1);
+	char buffer[2048];
+	size_t length = 0;
+	auto start = lwiot_tick_ms();
+
+	assert(client.connect(addr, PORT));
+	client.write(head, strlen(head));
+
+	while(lwiot_tick_ms() - start < 3000 && length < sizeof(buffer) - 1) {
+		if(client.available() == 0) {
+			if(!client.alive())
+				break;
+
+			lwiot_sleep(5);
+			continue;
+		}
+
+		auto rv = client.read(buffer + length, sizeof(buffer) - 1 - length);
+
+		if(rv <= 0)
+			break;
+
+		length += rv;
+	}
+
+	buffer[length] = '\0';
+	client.close();
+
+	return lwiot::String(buffer);
+}
+
+static lwiot::String header(const lwiot::String& response, const char *name)
+{
+	auto start = response.indexOf(name);
+
+	if(start < 0)
+		return "";
+
+	start += strlen(name) + 2;
+	return response.substring(start, response.indexOf("\r\n", start));
+}
+
+static lwiot::String body(const lwiot::String& response)
+{
+	return response.substring(response.indexOf("\r\n\r\n") + 4);
+}
+
+static void test_static()
+{
+	lwiot::HttpServer server(new lwiot::SocketTcpServer(BIND_ADDR_LB, PORT));
+	lwiot::FunctionalThread worker("http");
+
+	mkdir("www", 0755);
+	create("www/index.html", INDEX);
+	create("www/app.js", "plain javascript");
+	create("www/app.js.gz", "gzipped javascript");
+	create("secret.txt", "secret");
+
+	static const char asset[] = "built-in asset";
+	lwiot::MappedRegion script("www/app.js");
+	lwiot::MappedRegion builtin(asset, sizeof(asset) - 1);
+
+	assert(script);
+
+	server.serveStatic("/static/", "www/", "max-age=60");
+	server.serveStatic("/mapped.js", script);
+	server.serveStatic("/asset", builtin, "text/plain", "immutable");
+	assert(server.begin());
+
+	worker.start([&]() {
+		while(running)
+			server.handleClient();
+	});
+
+	/* Directories serve their index, with validators. */
+	auto response = request("GET /static/ HTTP/1.1\r\nHost: test\r\n\r\n");
+	assert(response.startsWith("HTTP/1.1 200"));
+	assert(body(response) == INDEX);
+	assert(header(response, "Content-Type") == "text/html");
+	assert(header(response, "Cache-Control") == "max-age=60");
+	assert(header(response, "Accept-Ranges") == "bytes");
+	assert(header(response, "Last-Modified").endsWith("GMT"));
+
+	auto etag = header(response, "ETag");
+	assert(etag.length() > 2);
+
+	/* A matching validator is answered without the file. */
+	response = request((lwiot::String("GET /static/index.html HTTP/1.1\r\nIf-None-Match: ") + etag +
+	                    "\r\n\r\n").c_str());
+	assert(response.startsWith("HTTP/1.1 304"));
+	assert(body(response) == "");
+	assert(response.indexOf("Content-Length") < 0);
+
+	response = request((lwiot::String("GET /static/index.html HTTP/1.1\r\nIf-Modified-Since: ") +
+	                    header(response, "Last-Modified") + "\r\n\r\n").c_str());
+	assert(response.startsWith("HTTP/1.1 304"));
+
+	/* Byte ranges. */
+	response = request("GET /static/index.html HTTP/1.1\r\nRange: bytes=1-5\r\n\r\n");
+	assert(response.startsWith("HTTP/1.1 206"));
+	assert(body(response) == "html>");
+	assert(header(response, "Content-Range") == lwiot::String("bytes 1-5/") + lwiot::String(strlen(INDEX)));
+
+	response = request("GET /static/index.html HTTP/1.1\r\nRange: bytes=-7\r\n\r\n");
+	assert(body(response) == "</html>");
+
+	response = request("GET /static/index.html HTTP/1.1\r\nRange: bytes=1000-\r\n\r\n");
+	assert(response.startsWith("HTTP/1.1 416"));
+
+	response = request("GET /static/index.html HTTP/1.1\r\nRange: bytes=1-5\r\nIf-Range: \"stale\"\r\n\r\n");
+	assert(response.startsWith("HTTP/1.1 200"));
+	assert(body(response) == INDEX);
+
+	/* Compressed variants go to clients that accept them. */
+	response = request("GET /static/app.js HTTP/1.1\r\nAccept-Encoding: deflate, gzip\r\n\r\n");
+	assert(body(response) == "gzipped javascript");
+	assert(header(response, "Content-Encoding") == "gzip");
+	assert(header(response, "Content-Type") == "application/javascript");
+	assert(header(response, "Vary") == "Accept-Encoding");
+
+	response = request("GET /static/app.js HTTP/1.1\r\nAccept-Encoding: gzip;q=0\r\n\r\n");
+	assert(body(response) == "plain javascript");
+	assert(response.indexOf("Content-Encoding") < 0);
+
+	/* Regions are served in place. */
+	response = request("GET /mapped.js HTTP/1.1\r\n\r\n");
+	assert(response.startsWith("HTTP/1.1 200"));
+	assert(body(response) == "plain javascript");
+	assert(header(response, "Content-Type") == "application/javascript");
+
+	etag = header(response, "ETag");
+	response = request((lwiot::String("GET /mapped.js HTTP/1.1\r\nIf-None-Match: ") + etag + "\r\n\r\n").c_str());
+	assert(response.startsWith("HTTP/1.1 304"));
+
+	response = request("GET /asset HTTP/1.1\r\nRange: bytes=9-\r\n\r\n");
+	assert(response.startsWith("HTTP/1.1 206"));
+	assert(body(response) == "asset");
+	assert(header(response, "Content-Type") == "text/plain");
+	assert(header(response, "Cache-Control") == "immutable");
+
+	/* Nothing outside the served directory. */
+	response = request("GET /static/../secret.txt HTTP/1.1\r\n\r\n");
+	assert(response.startsWith("HTTP/1.1 404"));
+
+	response = request("GET /static/missing.txt HTTP/1.1\r\n\r\n");
+	assert(response.startsWith("HTTP/1.1 404"));
+
+	running = false;
+	worker.join();
+	server.close();
+
+	remove("www/index.html");
+	remove("www/app.js");
+	remove("www/app.js.gz");
+	remove("secret.txt");
+	rmdir("www");
+
+	print_dbg("Static file test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	test_static();
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
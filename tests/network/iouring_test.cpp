@@ -0,0 +1,163 @@
+/*
+ * io_uring backend unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/io/file.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+#include <lwiot/util/poolallocator.h>
+#include <lwiot/hosted/iouring.h>
+
+#define PORT 5590
+#define BLOCK 2048
+
+typedef lwiot::BlockPool<BLOCK, 8> Pool;
+
+template <typename Func>
+static void poll_until(lwiot::hosted::IoUring& ring, Func&& done)
+{
+	for(int idx = 0; idx < 100 && !done(); idx++)
+		assert(ring.poll(20) >= 0);
+
+	assert(done());
+}
+
+static void test_socket(lwiot::hosted::IoUring& ring, Pool& pool)
+{
+	lwiot::SocketTcpServer server;
+	lwiot::UniquePointer<lwiot::TcpClient> accepted;
+	lwiot::SocketTcpClient client;
+	const char data[] = "io_uring";
+	char buffer[sizeof(data)];
+	ssize_t received, sent;
+	bool done;
+
+	assert(server.bind(BIND_ADDR_LB, PORT));
+	assert(ring.accept(server, [&](lwiot::UniquePointer<lwiot::TcpClient>& c) {
+		accepted = lwiot::stl::move(c);
+	}));
+
+	assert(client.connect(lwiot::IPAddress(127, 0, 0, 1), PORT));
+	poll_until(ring, [&]() { return accepted.get() != nullptr; });
+
+	auto peer = static_cast<lwiot::SocketTcpClient*>(accepted.get())->handle();
+
+	/* Receive into a block of the registered pool. */
+	auto block = static_cast<char*>(pool.allocate());
+	received = -1;
+
+	assert(ring.recv(peer, block, BLOCK, [&](ssize_t result) { received = result; }));
+	assert(ring.pending() == 1);
+	client.write(data, sizeof(data));
+	poll_until(ring, [&]() { return received >= 0; });
+
+	assert(received == sizeof(data));
+	assert(memcmp(block, data, sizeof(data)) == 0);
+	pool.deallocate(block);
+
+	sent = -1;
+	assert(ring.send(peer, data, sizeof(data), [&](ssize_t result) { sent = result; }));
+	poll_until(ring, [&]() { return sent >= 0; });
+	assert(sent == sizeof(data));
+	assert(client.read(buffer, sizeof(buffer)) == sizeof(buffer));
+	assert(memcmp(buffer, data, sizeof(data)) == 0);
+
+	/* Heap buffers work too, and operations on a socket can be cancelled. */
+	done = false;
+	assert(ring.recv(peer, buffer, sizeof(buffer), [&](ssize_t result) {
+		assert(result == -ECANCELED);
+		done = true;
+	}));
+
+	assert(ring.poll(SOCKET_POLL_NOWAIT) == 0);
+	assert(ring.cancel(peer));
+	poll_until(ring, [&]() { return done && ring.pending() == 0; });
+
+	/* A closed peer completes the receive with end of file. */
+	received = -1;
+	assert(ring.recv(peer, buffer, sizeof(buffer), [&](ssize_t result) { received = result; }));
+	client.close();
+	poll_until(ring, [&]() { return received >= 0; });
+	assert(received == 0);
+
+	server.close();
+	print_dbg("io_uring socket test passed!\n");
+}
+
+static void test_file(lwiot::hosted::IoUring& ring, Pool& pool)
+{
+	const char path[] = "iouring_test.txt";
+	ssize_t result = -1;
+
+	{
+		lwiot::File file(path, lwiot::FileMode::ReadWrite);
+
+		file.write("0123456789", 10);
+		assert(file.flush());
+
+		auto block = static_cast<char*>(pool.allocate());
+
+		assert(ring.read(file, 4, block, BLOCK, [&](ssize_t bytes) { result = bytes; }));
+		poll_until(ring, [&]() { return result >= 0; });
+
+		assert(result == 6);
+		assert(memcmp(block, "456789", 6) == 0);
+		pool.deallocate(block);
+	}
+
+	remove(path);
+	print_dbg("io_uring file test passed!\n");
+}
+
+static void test_timeout(lwiot::hosted::IoUring& ring)
+{
+	ssize_t result = 0;
+	auto start = lwiot_tick_ms();
+
+	assert(ring.timeout(50, [&](ssize_t rv) { result = rv; }));
+	poll_until(ring, [&]() { return result != 0; });
+
+	assert(result == -ETIME);
+	assert(lwiot_tick_ms() - start >= 49);
+	print_dbg("io_uring timeout test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	static Pool pool;
+
+	lwiot_init();
+
+	{
+		lwiot::hosted::IoUring ring;
+
+		if(ring.valid()) {
+			assert(ring.registerBuffers(pool));
+			assert(!ring.registerBuffers(pool));
+
+			test_socket(ring, pool);
+			test_file(ring, pool);
+			test_timeout(ring);
+		} else {
+			print_dbg("io_uring is not available, skipping.\n");
+		}
+	}
+
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,138 @@
+/*
+ * IPv6 socket unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/network/stdnet.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+#include <lwiot/network/socketudpserver.h>
+
+#define PORT_TCP  5570
+#define PORT_DUAL 5571
+#define PORT_UDP  5572
+#define PORT_ANY  5574
+
+static void exchange(lwiot::SocketTcpServer& server, lwiot::TcpClient& client)
+{
+	const char msg[] = "ping";
+	char buffer[sizeof(msg)];
+
+	auto peer = server.accept();
+	assert(peer);
+	assert(client.write(msg, sizeof(msg)) == sizeof(msg));
+	assert(peer->read(buffer, sizeof(buffer)) == sizeof(buffer));
+	assert(memcmp(msg, buffer, sizeof(msg)) == 0);
+}
+
+static void test_tcp6()
+{
+	auto lb = lwiot::IPAddress::fromBindAddress(BIND6_ADDR_LB);
+	lwiot::SocketTcpServer server(BIND6_ADDR_LB, PORT_TCP);
+	lwiot::SocketTcpClient client;
+
+	assert(server.bind());
+	assert(client.connect(lb, PORT_TCP));
+	exchange(server, client);
+
+	client.close();
+	server.close();
+	print_dbg("IPv6 TCP test passed!\n");
+}
+
+static void test_dualstack()
+{
+	lwiot::SocketTcpServer server(BIND6_ADDR_ANY, PORT_DUAL);
+	lwiot::SocketTcpClient v4, host;
+
+	assert(server.bind());
+
+	/* IPv4 clients reach an IPv6 wildcard listener. */
+	assert(v4.connect(lwiot::IPAddress(127,0,0,1), PORT_DUAL));
+	exchange(server, v4);
+
+	assert(host.connect(lwiot::String("localhost"), PORT_DUAL));
+	exchange(server, host);
+
+	v4.close();
+	host.close();
+	server.close();
+	print_dbg("Dual stack test passed!\n");
+}
+
+static void test_udp6()
+{
+	auto lb = lwiot::IPAddress::fromBindAddress(BIND6_ADDR_LB);
+	lwiot::SocketUdpServer a(BIND6_ADDR_LB, PORT_UDP), b(BIND6_ADDR_LB, PORT_UDP + 1);
+	const char msg[] = "ping";
+	char buffer[16];
+	lwiot::IPAddress peer;
+	uint16_t port = 0;
+
+	assert(a.bind());
+	assert(b.bind());
+	b.setTimeout(1);
+
+	assert(a.sendTo(msg, sizeof(msg), lb, PORT_UDP + 1) == sizeof(msg));
+	assert(b.recvFrom(buffer, sizeof(buffer), peer, port) == sizeof(msg));
+	assert(memcmp(msg, buffer, sizeof(msg)) == 0);
+	assert(peer.isIPv6());
+	assert(peer.toString() == "::1");
+	assert(port == PORT_UDP);
+
+	a.close();
+	b.close();
+	print_dbg("IPv6 UDP test passed!\n");
+}
+
+static void test_connect_any()
+{
+	lwiot::SocketTcpServer server(BIND_ADDR_LB, PORT_ANY);
+	remote_addr_t remotes[2];
+	size_t index = 42;
+
+	assert(server.bind());
+
+	/* Nothing listens on ::1, so the second address wins. */
+	memset(remotes, 0, sizeof(remotes));
+	lwiot::IPAddress::fromBindAddress(BIND6_ADDR_LB).toRemoteAddress(remotes[0]);
+	lwiot::IPAddress(127,0,0,1).toRemoteAddress(remotes[1]);
+	remotes[0].port = remotes[1].port = to_netorders(PORT_ANY);
+
+	auto start = lwiot_tick_ms();
+	auto socket = tcp_socket_create_any(remotes, 2, 2000, &index);
+
+	assert(socket != nullptr);
+	assert(index == 1);
+	assert(lwiot_tick_ms() - start < 1000);
+
+	lwiot::SocketTcpClient client(socket);
+	exchange(server, client);
+
+	client.close();
+	server.close();
+	print_dbg("Connect any test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	test_tcp6();
+	test_dualstack();
+	test_udp6();
+	test_connect_any();
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
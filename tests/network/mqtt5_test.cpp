@@ -0,0 +1,246 @@
+/*
+ * MQTT 5 unit test, against a minimal local broker.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/network/asyncmqttclient.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+
+#define PORT 5568
+#define TOPIC "telemetry/building/floor/temperature"
+
+static lwiot::atomic_int_t received(0);
+static lwiot::String origin;
+
+/* Read one packet and return its type; \p length is set to the remaining length. */
+static uint8_t read_packet(lwiot::TcpClient& client, uint8_t *payload, size_t size, size_t *length = nullptr)
+{
+	uint8_t type, byte;
+	size_t remaining = 0;
+	int shift = 0;
+
+	if(client.read(&type, 1) != 1)
+		return 0;
+
+	do {
+		if(client.read(&byte, 1) != 1)
+			return 0;
+
+		remaining |= (byte & 0x7F) << shift;
+		shift += 7;
+	} while(byte & 0x80);
+
+	assert(remaining <= size);
+
+	for(size_t idx = 0; idx < remaining; ) {
+		auto rv = client.read(payload + idx, remaining - idx);
+
+		if(rv <= 0)
+			return 0;
+
+		idx += rv;
+	}
+
+	if(length != nullptr)
+		*length = remaining;
+
+	return type & 0xF0;
+}
+
+/* Accept a connection, check that it speaks MQTT 5 and allow one message in flight and two topic aliases. */
+static lwiot::UniquePointer<lwiot::TcpClient> accept_session(lwiot::SocketTcpServer& server)
+{
+	const uint8_t connack[] = { 0x20, 0x09, 0x00, 0x00, 0x06, 0x21, 0x00, 0x01, 0x22, 0x00, 0x02 };
+	uint8_t payload[256];
+	auto client = server.accept();
+
+	assert(client);
+	client->setOption(SOCKET_OPT_NODELAY, 1);
+	assert(read_packet(*client, payload, sizeof(payload)) == 0x10);
+	assert(payload[6] == 5);
+	assert(payload[10] == 3 && payload[11] == 0x21);
+	client->write(connack, sizeof(connack));
+
+	return client;
+}
+
+static void wait_for(lwiot::atomic_int_t& counter, int value)
+{
+	auto start = lwiot_tick_ms();
+
+	while(counter.load() < value && lwiot_tick_ms() - start < 3000)
+		lwiot_sleep(1);
+
+	assert(counter.load() >= value);
+}
+
+/* A QoS 0 PUBLISH: topic, the properties and then the payload. */
+static void check_publish(const uint8_t *payload, size_t length, const char *topic, const uint8_t *props, size_t plen)
+{
+	auto tl = strlen(topic);
+
+	assert(length == 2 + tl + 1 + plen + 2);
+	assert(payload[0] == 0 && payload[1] == tl);
+	assert(memcmp(payload + 2, topic, tl) == 0);
+	assert(payload[2 + tl] == plen);
+	assert(memcmp(payload + 3 + tl, props, plen) == 0);
+	assert(memcmp(payload + 3 + tl + plen, "21", 2) == 0);
+}
+
+int main(int argc, char **argv)
+{
+	const uint8_t alias1[] = { 0x23, 0x00, 0x01 };
+	const uint8_t alias2[] = { 0x23, 0x00, 0x02 };
+	lwiot::SocketTcpServer server;
+	uint8_t payload[256];
+	size_t length;
+
+	lwiot_init();
+	assert(server.bind(BIND_ADDR_LB, PORT));
+
+	lwiot::UniquePointer<lwiot::TcpClient> session;
+	lwiot::FunctionalThread broker("broker");
+
+	broker.start([&]() {
+		session = accept_session(server);
+	});
+
+	lwiot::SocketTcpClient client(lwiot::IPAddress(127, 0, 0, 1), PORT);
+	lwiot::AsyncMqttClient mqtt;
+
+	mqtt.setVersion(lwiot::AsyncMqttClient::Version::V5);
+	assert(mqtt.start(client));
+	assert(mqtt.connect("lwiot-v5", "", ""));
+	broker.join();
+
+	/* The first message assigns a topic alias, the next ones only carry the alias. */
+	assert(mqtt.publish(TOPIC, "21", false));
+	assert(read_packet(*session, payload, sizeof(payload), &length) == 0x30);
+	check_publish(payload, length, TOPIC, alias1, sizeof(alias1));
+
+	assert(mqtt.publish(TOPIC, "21", false));
+	assert(read_packet(*session, payload, sizeof(payload), &length) == 0x30);
+	check_publish(payload, length, "", alias1, sizeof(alias1));
+
+	/* No more aliases than the broker allows. */
+	assert(mqtt.publish("b", "21", false));
+	assert(read_packet(*session, payload, sizeof(payload), &length) == 0x30);
+	check_publish(payload, length, "b", alias2, sizeof(alias2));
+
+	assert(mqtt.publish("c", "21", false));
+	assert(read_packet(*session, payload, sizeof(payload), &length) == 0x30);
+	check_publish(payload, length, "c", alias1, 0);
+
+	/* User properties. */
+	const uint8_t unit[] = { 0x23, 0x00, 0x02, 0x26, 0x00, 0x04, 'u', 'n', 'i', 't', 0x00, 0x01, 'C' };
+	lwiot::AsyncMqttClient::UserProperties properties;
+	lwiot::ByteBuffer data(2);
+
+	data.write("21", 2);
+	properties.pushback(lwiot::stl::Pair<lwiot::String, lwiot::String>("unit", "C"));
+	assert(mqtt.publish("b", data, false, properties));
+	assert(read_packet(*session, payload, sizeof(payload), &length) == 0x30);
+	check_publish(payload, length, "", unit, sizeof(unit));
+
+	/* The broker's receive maximum of one holds back the second QoS 1 message. */
+	const uint8_t puback[] = { 0x40, 0x02, 0x00, 0x01 };
+
+	mqtt.setQoS("event", lwiot::MqttClient::QOS1);
+	assert(mqtt.publish("event", "1", false));
+	assert(mqtt.publish("event", "2", false));
+	assert(read_packet(*session, payload, sizeof(payload)) == 0x30);
+	assert(payload[8] == 1);
+	assert(!session->readable(100));
+
+	session->write(puback, sizeof(puback));
+	assert(read_packet(*session, payload, sizeof(payload)) == 0x30);
+	assert(payload[8] == 2);
+
+	/* Shared subscriptions are sent as is, and messages are matched on the filter. */
+	const uint8_t suback[] = { 0x90, 0x04, 0x00, 0x02, 0x00, 0x01 };
+	const uint8_t job[] = {
+		0x30, 0x19, 0x00, 0x06, 'j', 'o', 'b', 's', '/', '1',
+		0x0D, 0x26, 0x00, 0x06, 'o', 'r', 'i', 'g', 'i', 'n', 0x00, 0x02, 'g', 'w',
+		'r', 'u', 'n'
+	};
+
+	assert(mqtt.subscribe("$share/workers/jobs/#", [&mqtt](const lwiot::SharedByteBuffer& data) {
+		auto& props = mqtt.properties();
+
+		if(props.size() == 1 && props[0].first == "origin")
+			origin = props[0].second;
+
+		received.fetch_add(1);
+	}, lwiot::MqttClient::QOS1));
+
+	assert(read_packet(*session, payload, sizeof(payload), &length) == 0x80);
+	assert(payload[2] == 0);
+	assert(memcmp(payload + 5, "$share/workers/jobs/#", 21) == 0);
+	assert(payload[length - 1] == 1);
+
+	session->write(suback, sizeof(suback));
+	session->write(job, sizeof(job));
+	wait_for(received, 1);
+	assert(origin == "gw");
+	assert(mqtt.reason() == 1);
+
+	mqtt.stop();
+	session->close();
+
+	/* The synchronous client aliases topics as well. */
+	lwiot::SocketTcpClient sync_client(lwiot::IPAddress(127, 0, 0, 1), PORT);
+	lwiot::MqttClient sync;
+	lwiot::FunctionalThread rebroker("broker");
+
+	rebroker.start([&]() {
+		session = accept_session(server);
+	});
+
+	sync.setVersion(lwiot::MqttClient::Version::V5);
+	sync.begin(sync_client);
+	assert(sync.connect("lwiot-sync", "", ""));
+	rebroker.join();
+
+	assert(sync.publish(TOPIC, "21"));
+	assert(read_packet(*session, payload, sizeof(payload), &length) == 0x30);
+	check_publish(payload, length, TOPIC, alias1, sizeof(alias1));
+	assert(sync.publish(TOPIC, "21"));
+	assert(read_packet(*session, payload, sizeof(payload), &length) == 0x30);
+	check_publish(payload, length, "", alias1, sizeof(alias1));
+
+	/* A broker that disconnects the client reports why. */
+	const uint8_t disconnect[] = { 0xE0, 0x01, 0x8B };
+	auto start = lwiot_tick_ms();
+
+	session->write(disconnect, sizeof(disconnect));
+
+	while(sync.loop() && lwiot_tick_ms() - start < 3000)
+		lwiot_sleep(1);
+
+	assert(!sync.connected());
+	assert(sync.reason() == 0x8B);
+
+	session->close();
+	server.close();
+
+	print_dbg("MQTT 5 test passed!\n");
+
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,200 @@
+/*
+ * MQTT bridge unit test, against a minimal local broker.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/network/asyncmqttclient.h>
+#include <lwiot/network/mqttbridge.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+
+#define PORT 5570
+
+static lwiot::atomic_int_t received(0);
+
+static uint8_t read_packet(lwiot::TcpClient& client, uint8_t *payload, size_t size, size_t *length)
+{
+	uint8_t type, byte;
+	size_t remaining = 0;
+	int shift = 0;
+
+	if(client.read(&type, 1) != 1)
+		return 0;
+
+	do {
+		if(client.read(&byte, 1) != 1)
+			return 0;
+
+		remaining |= (byte & 0x7F) << shift;
+		shift += 7;
+	} while(byte & 0x80);
+
+	assert(remaining <= size);
+
+	for(size_t idx = 0; idx < remaining; ) {
+		auto rv = client.read(payload + idx, remaining - idx);
+
+		if(rv <= 0)
+			return 0;
+
+		idx += rv;
+	}
+
+	*length = remaining;
+	return type & 0xF0;
+}
+
+/* Read a (un)subscribe packet and check its topic filter. */
+static void check_filter(lwiot::TcpClient& client, uint8_t type, const char *filter)
+{
+	uint8_t payload[64];
+	size_t length;
+
+	assert(read_packet(client, payload, sizeof(payload), &length) == type);
+	assert(payload[3] == strlen(filter));
+	assert(memcmp(payload + 4, filter, strlen(filter)) == 0);
+}
+
+static void publish(lwiot::TcpClient& client, const char *topic, const char *data)
+{
+	uint8_t packet[64];
+	auto tl = strlen(topic);
+	auto dl = strlen(data);
+
+	packet[0] = 0x30;
+	packet[1] = static_cast<uint8_t>(2 + tl + dl);
+	packet[2] = 0;
+	packet[3] = static_cast<uint8_t>(tl);
+	memcpy(packet + 4, topic, tl);
+	memcpy(packet + 4 + tl, data, dl);
+
+	client.write(packet, 4 + tl + dl);
+}
+
+static void wait_for(int value)
+{
+	auto start = lwiot_tick_ms();
+
+	while(received.load() < value && lwiot_tick_ms() - start < 3000)
+		lwiot_sleep(1);
+
+	assert(received.load() == value);
+}
+
+int main(int argc, char **argv)
+{
+	const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+	lwiot::SocketTcpServer server;
+	lwiot::UniquePointer<lwiot::TcpClient> session;
+	lwiot::FunctionalThread broker("broker");
+	uint8_t payload[64];
+	size_t length;
+
+	lwiot_init();
+	assert(server.bind(BIND_ADDR_LB, PORT));
+
+	broker.start([&]() {
+		session = server.accept();
+		assert(session);
+		session->setOption(SOCKET_OPT_NODELAY, 1);
+		assert(read_packet(*session, payload, sizeof(payload), &length) == 0x10);
+		session->write(connack, sizeof(connack));
+	});
+
+	lwiot::SocketTcpClient client(lwiot::IPAddress(127, 0, 0, 1), PORT);
+	lwiot::AsyncMqttClient mqtt;
+
+	assert(mqtt.start(client));
+	assert(mqtt.connect("lwiot-bridge", "", ""));
+	broker.join();
+
+	{
+		lwiot::MqttBridge bridge(mqtt, "bridge");
+		lwiot::String last;
+
+		auto handler = [&last](const char *device) {
+			return [&last, device](const lwiot::String& topic, const lwiot::SharedByteBuffer& data) {
+				last = lwiot::String(device) + ":" + topic + "=" +
+				       lwiot::String(reinterpret_cast<const char *>(data.data()), data.size());
+				received.fetch_add(1);
+			};
+		};
+
+		assert(bridge.add("dev1", handler("dev1")));
+		assert(bridge.add("dev2", handler("dev2")));
+		assert(!bridge.add("dev1", handler("dev1")));
+		assert(!bridge.add("dev/3", handler("dev3")));
+		assert(bridge.devices() == 2);
+
+		/* Devices that subscribe to the same filter share one broker subscription. */
+		assert(bridge.subscribe("dev1", "cmd/#"));
+		check_filter(*session, 0x80, "bridge/+/cmd/#");
+		assert(bridge.subscribe("dev2", "cmd/#"));
+		assert(bridge.subscribe("dev2", "cmd/#"));
+		assert(bridge.subscriptions() == 1);
+		assert(!bridge.subscribe("dev3", "cmd/#"));
+
+		/* Messages only reach the device named in the topic, with a relative topic. */
+		publish(*session, "bridge/dev2/cmd/led", "on");
+		wait_for(1);
+		assert(last == "dev2:cmd/led=on");
+
+		publish(*session, "bridge/dev3/cmd/led", "on");
+		publish(*session, "bridge/dev1/cmd", "off");
+		wait_for(2);
+		assert(last == "dev1:cmd=off");
+
+		/* Devices publish in their own namespace. */
+		lwiot::ByteBuffer up(2);
+
+		up.write("up", 2);
+		assert(bridge.publish("dev1", "status", up));
+		assert(!bridge.publish("dev3", "status", up));
+		assert(read_packet(*session, payload, sizeof(payload), &length) == 0x30);
+		assert(payload[1] == strlen("bridge/dev1/status"));
+		assert(memcmp(payload + 2, "bridge/dev1/status", payload[1]) == 0);
+
+		/* The broker subscription is dropped with its last device. */
+		assert(bridge.unsubscribe("dev2", "cmd/#"));
+		assert(!bridge.unsubscribe("dev2", "cmd/#"));
+		assert(bridge.subscriptions() == 1);
+
+		publish(*session, "bridge/dev2/cmd/led", "on");
+		publish(*session, "bridge/dev1/cmd/led", "off");
+		wait_for(3);
+		assert(last == "dev1:cmd/led=off");
+
+		assert(bridge.subscribe("dev2", "config"));
+		check_filter(*session, 0x80, "bridge/+/config");
+		assert(bridge.remove("dev1"));
+		check_filter(*session, 0xA0, "bridge/+/cmd/#");
+		assert(bridge.devices() == 1 && bridge.subscriptions() == 1);
+	}
+
+	/* The remaining subscriptions go with the bridge. */
+	check_filter(*session, 0xA0, "bridge/+/config");
+
+	mqtt.stop();
+	session->close();
+	server.close();
+
+	print_dbg("MQTT bridge test passed!\n");
+
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
@@ -36,15 +36,15 @@ class MqttClientTest : public lwiot::Functor {
 		mqtt.start(client);
 
 		mqtt.connect("lwiot-test", "test", "test");
-		mqtt.subscribe("test/subscribe/1", [&a](const lwiot::ByteBuffer& payload) {
-			lwiot::stl::String str(payload);
+		mqtt.subscribe("test/subscribe/1", [&a](const lwiot::SharedByteBuffer& payload) {
+			lwiot::stl::String str(reinterpret_cast<const char *>(payload.data()), payload.size());
 
 			a++;
 			print_dbg("Data (subscribe/1): %s\n", str.c_str());
 		}, lwiot::MqttClient::QOS0);
 
-		mqtt.subscribe("test/subscribe/2", [&b](const lwiot::ByteBuffer& payload) {
-			lwiot::stl::String str(payload);
+		mqtt.subscribe("test/subscribe/2", [&b](const lwiot::SharedByteBuffer& payload) {
+			lwiot::stl::String str(reinterpret_cast<const char *>(payload.data()), payload.size());
 
 			b++;
 			print_dbg("Data (subscribe/2): %s\n", str.c_str());
@@ -0,0 +1,263 @@
+/*
+ * MQTT offline log unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/io/file.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/network/asyncmqttclient.h>
+#include <lwiot/network/mqttofflinelog.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+
+#define PORT 5569
+#define LOG "mqttoffline_log.bin"
+
+/* Three segments of 64 bytes hold five messages of one byte on topic "t" each. */
+#define SEGMENTS 3
+#define SEGSIZE 64
+
+static lwiot::ByteBuffer message(const char *text)
+{
+	lwiot::ByteBuffer buffer(strlen(text));
+
+	buffer.write(text, strlen(text));
+	return buffer;
+}
+
+/* Replay at most \p max messages, appending their payloads to \p output. */
+static size_t replay(lwiot::MqttOfflineLog& log, size_t max, lwiot::String& output)
+{
+	return log.replay(max, [&output](const lwiot::String& topic, const lwiot::ByteBuffer& payload, bool retained) {
+		assert(topic == "t");
+		output += lwiot::String(reinterpret_cast<const char *>(payload.data()), payload.index());
+		return true;
+	});
+}
+
+static void corrupt(size_t offset)
+{
+	lwiot::File file(LOG, lwiot::FileMode::ReadWriteNoCreate);
+	uint8_t byte;
+
+	assert(file.seek(offset));
+	assert(file.read(&byte, 1) == 1);
+	byte ^= 0xFF;
+	assert(file.seek(offset));
+	assert(file.write(&byte, 1) == 1);
+	file.flush();
+}
+
+static void test_log()
+{
+	lwiot::String output;
+
+	{
+		lwiot::MqttFileOfflineLog log(LOG, SEGMENTS, SEGSIZE);
+
+		assert(log.empty());
+		assert(log.append("t", message("0"), false));
+		assert(log.append("t", message("1"), true));
+		assert(log.append("t", message("2"), false));
+		assert(log.pending() == 3);
+		assert(!log.append("t", message("a message that is larger than a segment can hold......."), false));
+	}
+
+	/* Messages and sent marks survive a restart. */
+	{
+		lwiot::MqttFileOfflineLog log(LOG, SEGMENTS, SEGSIZE);
+
+		assert(log.pending() == 3);
+		assert(replay(log, 2, output) == 2 && output == "01");
+	}
+
+	{
+		lwiot::MqttFileOfflineLog log(LOG, SEGMENTS, SEGSIZE);
+		bool retained = false;
+
+		assert(log.pending() == 1);
+
+		/* A message that is refused is offered again. */
+		assert(log.replay(4, [](const lwiot::String&, const lwiot::ByteBuffer&, bool) { return false; }) == 0);
+		assert(log.replay(4, [&retained](const lwiot::String&, const lwiot::ByteBuffer&, bool retain) {
+			retained = retain;
+			return true;
+		}) == 1);
+		assert(!retained && log.empty());
+		log.clear();
+	}
+
+	/* A record that was cut short is dropped, the records before it are not. */
+	{
+		lwiot::MqttFileOfflineLog log(LOG, SEGMENTS, SEGSIZE);
+
+		assert(log.append("t", message("a"), false));
+		assert(log.append("t", message("b"), false));
+	}
+
+	corrupt(8 + 11 + 10);
+	output = "";
+
+	{
+		lwiot::MqttFileOfflineLog log(LOG, SEGMENTS, SEGSIZE);
+
+		assert(log.pending() == 1);
+		assert(log.append("t", message("c"), false));
+		assert(replay(log, 8, output) == 2 && output == "ac");
+		log.clear();
+	}
+
+	/* A full log discards its oldest segment. */
+	output = "";
+
+	{
+		lwiot::MqttFileOfflineLog log(LOG, SEGMENTS, SEGSIZE);
+		char text[] = "A";
+
+		for(int idx = 0; idx < 20; idx++, text[0]++)
+			assert(log.append("t", message(text), false));
+
+		assert(log.dropped() == 5);
+		assert(log.pending() == 15);
+	}
+
+	{
+		lwiot::MqttFileOfflineLog log(LOG, SEGMENTS, SEGSIZE);
+
+		assert(log.pending() == 15);
+		assert(replay(log, 4, output) == 4);
+		assert(replay(log, 100, output) == 11);
+		assert(output == "FGHIJKLMNOPQRST");
+		assert(log.empty());
+
+		/* Released segments are used again. */
+		assert(log.append("t", message("U"), false));
+		assert(replay(log, 1, output) == 1 && output.length() == 16);
+	}
+}
+
+static uint8_t read_packet(lwiot::TcpClient& client, uint8_t *payload, size_t size, size_t *length)
+{
+	uint8_t type, byte;
+	size_t remaining = 0;
+	int shift = 0;
+
+	if(client.read(&type, 1) != 1)
+		return 0;
+
+	do {
+		if(client.read(&byte, 1) != 1)
+			return 0;
+
+		remaining |= (byte & 0x7F) << shift;
+		shift += 7;
+	} while(byte & 0x80);
+
+	assert(remaining <= size);
+
+	for(size_t idx = 0; idx < remaining; ) {
+		auto rv = client.read(payload + idx, remaining - idx);
+
+		if(rv <= 0)
+			return 0;
+
+		idx += rv;
+	}
+
+	*length = remaining;
+	return type & 0xF0;
+}
+
+static void check_publish(lwiot::TcpClient& client, const char *data)
+{
+	uint8_t payload[64];
+	size_t length;
+
+	assert(read_packet(client, payload, sizeof(payload), &length) == 0x30);
+	assert(length == 2 + 5 + strlen(data));
+	assert(memcmp(payload + 2, "event", 5) == 0);
+	assert(memcmp(payload + 7, data, strlen(data)) == 0);
+}
+
+/* Messages published before the client connects are published once it does, in order. */
+static void test_client()
+{
+	const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+	lwiot::SocketTcpServer server;
+	lwiot::UniquePointer<lwiot::TcpClient> session;
+	lwiot::FunctionalThread broker("broker");
+	lwiot::MqttFileOfflineLog log(LOG);
+
+	log.clear();
+	assert(server.bind(BIND_ADDR_LB, PORT));
+
+	lwiot::SocketTcpClient client(lwiot::IPAddress(127, 0, 0, 1), PORT);
+	lwiot::AsyncMqttClient mqtt;
+
+	mqtt.setOfflineLog(log);
+	mqtt.setReplayRate(2, 10);
+
+	for(char text[] = "0"; text[0] < '5'; text[0]++)
+		assert(mqtt.publish("event", text, false));
+
+	assert(log.pending() == 5);
+
+	broker.start([&]() {
+		uint8_t payload[128];
+		size_t length;
+
+		session = server.accept();
+		assert(session);
+		session->setOption(SOCKET_OPT_NODELAY, 1);
+		assert(read_packet(*session, payload, sizeof(payload), &length) == 0x10);
+		session->write(connack, sizeof(connack));
+	});
+
+	assert(mqtt.start(client));
+	assert(mqtt.connect("lwiot-offline", "", ""));
+	broker.join();
+
+	assert(mqtt.publish("event", "5", false));
+
+	for(char text[] = "0"; text[0] <= '5'; text[0]++)
+		check_publish(*session, text);
+
+	assert(log.empty());
+
+	/* A stopped client logs its messages again. */
+	mqtt.stop();
+	assert(mqtt.publish("event", "6", false));
+	assert(log.pending() == 1);
+
+	session->close();
+	server.close();
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	remove(LOG);
+
+	test_log();
+	remove(LOG);
+	test_client();
+	remove(LOG);
+
+	print_dbg("MQTT offline log test passed!\n");
+
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
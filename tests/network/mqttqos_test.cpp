@@ -0,0 +1,257 @@
+/*
+ * MQTT QoS 1 and QoS 2 unit test, against a minimal local broker.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/network/asyncmqttclient.h>
+#include <lwiot/network/mqttsessionstore.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+
+#define PORT 5567
+#define SESSION "mqttqos_session.bin"
+
+static lwiot::atomic_int_t received(0);
+
+/* Read one packet and return its type. The packet identifier of acknowledgements ends up in \p id. */
+static uint8_t read_packet(lwiot::TcpClient& client, uint8_t *payload, size_t size, uint8_t *flags = nullptr,
+                           uint16_t *id = nullptr)
+{
+	uint8_t type, byte;
+	size_t length = 0;
+	int shift = 0;
+
+	if(client.read(&type, 1) != 1)
+		return 0;
+
+	do {
+		if(client.read(&byte, 1) != 1)
+			return 0;
+
+		length |= (byte & 0x7F) << shift;
+		shift += 7;
+	} while(byte & 0x80);
+
+	assert(length <= size);
+
+	for(size_t idx = 0; idx < length; ) {
+		auto rv = client.read(payload + idx, length - idx);
+
+		if(rv <= 0)
+			return 0;
+
+		idx += rv;
+	}
+
+	if(flags != nullptr)
+		*flags = type & 0x0F;
+
+	if(id != nullptr && length >= 2)
+		*id = (payload[length - 2] << 8) | payload[length - 1];
+
+	return type & 0xF0;
+}
+
+/* Packet identifier of a PUBLISH packet, right after the topic. */
+static uint16_t publish_id(const uint8_t *payload)
+{
+	size_t tl = (payload[0] << 8) | payload[1];
+	return (payload[2 + tl] << 8) | payload[3 + tl];
+}
+
+static void acknowledge(lwiot::TcpClient& client, uint8_t type, uint16_t id)
+{
+	const uint8_t packet[] = { type, 0x02, static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id & 0xFF) };
+	client.write(packet, sizeof(packet));
+}
+
+static lwiot::UniquePointer<lwiot::TcpClient> accept_session(lwiot::SocketTcpServer& server)
+{
+	const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+	uint8_t payload[256];
+	auto client = server.accept();
+
+	assert(client);
+	client->setOption(SOCKET_OPT_NODELAY, 1);
+	assert(read_packet(*client, payload, sizeof(payload)) == 0x10);
+	client->write(connack, sizeof(connack));
+
+	return client;
+}
+
+static lwiot::UniquePointer<lwiot::TcpClient> connect(lwiot::SocketTcpServer& server, lwiot::AsyncMqttClient& mqtt,
+                                                      lwiot::TcpClient& client, const char *id)
+{
+	lwiot::UniquePointer<lwiot::TcpClient> session;
+	lwiot::FunctionalThread broker("broker");
+
+	broker.start([&]() {
+		session = accept_session(server);
+	});
+
+	assert(mqtt.start(client));
+	assert(mqtt.connect(id, "", "", "", lwiot::MqttClient::QOS0, false, "", false));
+	broker.join();
+
+	return session;
+}
+
+int main(int argc, char **argv)
+{
+	lwiot::SocketTcpServer server;
+	uint8_t payload[256];
+	uint8_t flags;
+	uint16_t id;
+
+	lwiot_init();
+	remove(SESSION);
+	assert(server.bind(BIND_ADDR_LB, PORT));
+
+	lwiot::SocketTcpClient client(lwiot::IPAddress(127, 0, 0, 1), PORT);
+	lwiot::AsyncMqttClient mqtt;
+	lwiot::MqttFileSessionStore store(SESSION);
+
+	mqtt.setRetryInterval(0);
+	mqtt.setInflightWindow(2);
+	mqtt.setSessionStore(store);
+	mqtt.setQoS("event", lwiot::MqttClient::QOS1);
+	mqtt.setQoS("alarm", lwiot::MqttClient::QOS2);
+
+	auto session = connect(server, mqtt, client, "lwiot-qos");
+
+	/* No more than the in-flight window is waiting for an acknowledgement. */
+	assert(mqtt.publish("event", "1", false));
+	assert(mqtt.publish("event", "2", false));
+	assert(mqtt.publish("event", "3", false));
+
+	assert(read_packet(*session, payload, sizeof(payload), &flags) == 0x30 && flags == 0x02);
+	assert(publish_id(payload) == 1);
+	assert(read_packet(*session, payload, sizeof(payload)) == 0x30);
+	assert(publish_id(payload) == 2);
+	assert(!session->readable(100));
+
+	acknowledge(*session, 0x40, 1);
+	assert(read_packet(*session, payload, sizeof(payload)) == 0x30);
+	assert(publish_id(payload) == 3);
+	acknowledge(*session, 0x40, 2);
+	acknowledge(*session, 0x40, 3);
+
+	/* Unacknowledged messages are sent again after the retry interval. */
+	mqtt.setRetryInterval(50);
+	assert(mqtt.publish("event", "4", false));
+	assert(read_packet(*session, payload, sizeof(payload), &flags) == 0x30 && flags == 0x02);
+	assert(read_packet(*session, payload, sizeof(payload), &flags) == 0x30 && flags == 0x0A);
+	assert(publish_id(payload) == 4);
+	acknowledge(*session, 0x40, 4);
+	lwiot_sleep(20);
+	mqtt.setRetryInterval(0);
+
+	/* QoS 2: PUBLISH, PUBREC, PUBREL, PUBCOMP. */
+	assert(mqtt.publish("alarm", "smoke", false));
+	assert(read_packet(*session, payload, sizeof(payload), &flags) == 0x30 && flags == 0x04);
+	assert(publish_id(payload) == 5);
+	acknowledge(*session, 0x50, 5);
+	assert(read_packet(*session, payload, sizeof(payload), &flags, &id) == 0x60);
+	assert(flags == 0x02 && id == 5);
+	acknowledge(*session, 0x70, 5);
+
+	/* Incoming QoS 2 messages are delivered once, even when the broker sends them again. */
+	const uint8_t incoming[] = { 0x34, 0x0B, 0x00, 0x03, 'c', 'm', 'd', 0x00, 0x10, 'o', 'n', '!', '!' };
+	uint8_t duplicate[sizeof(incoming)];
+
+	mqtt.subscribe("cmd", [](const lwiot::SharedByteBuffer& data) {
+		received.fetch_add(1);
+	}, lwiot::MqttClient::QOS2);
+	assert(read_packet(*session, payload, sizeof(payload)) == 0x80);
+
+	memcpy(duplicate, incoming, sizeof(incoming));
+	duplicate[0] |= 0x08;
+
+	session->write(incoming, sizeof(incoming));
+	assert(read_packet(*session, payload, sizeof(payload), nullptr, &id) == 0x50 && id == 0x10);
+	session->write(duplicate, sizeof(duplicate));
+	assert(read_packet(*session, payload, sizeof(payload), nullptr, &id) == 0x50 && id == 0x10);
+	acknowledge(*session, 0x62, 0x10);
+	assert(read_packet(*session, payload, sizeof(payload), nullptr, &id) == 0x70 && id == 0x10);
+	assert(received.load() == 1);
+
+	/* Leave a QoS 2 message half way and a QoS 1 message unacknowledged. */
+	assert(mqtt.publish("alarm", "fire", false));
+	assert(read_packet(*session, payload, sizeof(payload)) == 0x30);
+	assert(publish_id(payload) == 6);
+	acknowledge(*session, 0x50, 6);
+	assert(read_packet(*session, payload, sizeof(payload), nullptr, &id) == 0x60 && id == 6);
+
+	assert(mqtt.publish("event", "7", false));
+	assert(read_packet(*session, payload, sizeof(payload)) == 0x30);
+	assert(publish_id(payload) == 7);
+
+	mqtt.stop();
+	session->close();
+
+	/* A new client picks up where the previous one left off. */
+	lwiot::SocketTcpClient reclient(lwiot::IPAddress(127, 0, 0, 1), PORT);
+	lwiot::AsyncMqttClient remqtt;
+	lwiot::MqttFileSessionStore restore(SESSION);
+	bool released = false, republished = false;
+
+	remqtt.setQoS("event", lwiot::MqttClient::QOS1);
+	remqtt.setSessionStore(restore);
+	session = connect(server, remqtt, reclient, "lwiot-qos");
+
+	for(int idx = 0; idx < 2; idx++) {
+		auto type = read_packet(*session, payload, sizeof(payload), &flags, &id);
+
+		if(type == 0x60) {
+			assert(id == 6);
+			released = true;
+			acknowledge(*session, 0x70, 6);
+		} else {
+			assert(type == 0x30 && flags == 0x0A && publish_id(payload) == 7);
+			republished = true;
+			acknowledge(*session, 0x40, 7);
+		}
+	}
+
+	assert(released && republished);
+
+	/* Restored identifiers are not handed out again. */
+	assert(remqtt.publish("event", "8", false));
+	assert(read_packet(*session, payload, sizeof(payload)) == 0x30);
+	assert(publish_id(payload) == 8);
+	acknowledge(*session, 0x40, 8);
+	lwiot_sleep(20);
+
+	/* Everything has been acknowledged, so the store is empty. */
+	int stored = 0;
+
+	restore.load([&stored](uint16_t, const lwiot::ByteBuffer&) {
+		stored++;
+	});
+	assert(stored == 0);
+
+	remqtt.stop();
+	session->close();
+	server.close();
+	remove(SESSION);
+
+	print_dbg("MQTT QoS test passed!\n");
+
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+/*
+ * UDP multicast and broadcast unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/network/udpclient.h>
+#include <lwiot/network/socketudpclient.h>
+#include <lwiot/network/socketudpserver.h>
+
+#define PORT 5592
+
+static void test_options()
+{
+	lwiot::SocketUdpClient client(lwiot::IPAddress(239, 255, 0, 1), PORT);
+	int value = 0;
+
+	assert(lwiot::IPAddress(239, 255, 0, 1).isMulticast());
+	assert(lwiot::IPAddress(0xFF02, 0, 0, 0, 0, 0, 0, 0xFB).isMulticast());
+	assert(!lwiot::IPAddress(192, 168, 1, 1).isMulticast());
+
+	assert(client.setMulticastTtl(3));
+	assert(client.setMulticastLoopback(false));
+	assert(client.setOption(SOCKET_OPT_BROADCAST, 1));
+	assert(socket_get_option(client.handle(), SOCKET_OPT_MULTICAST_TTL, &value) == -EOK);
+	assert(value == 3);
+
+	assert(!client.joinGroup(lwiot::IPAddress(10, 0, 0, 1)));
+	print_dbg("UDP multicast option test passed!\n");
+}
+
+static void test_multicast()
+{
+	lwiot::IPAddress group(239, 255, 0, 1);
+	lwiot::SocketUdpServer server(BIND_ADDR_ANY, PORT);
+	lwiot::SocketUdpClient sender(group, PORT);
+	lwiot::IPAddress addr;
+	uint16_t port;
+	char buffer[16];
+	const char msg[] = "time-sync";
+
+	assert(server.bind());
+	server.setTimeout(1);
+
+	/* Without a multicast route the host cannot send to a group at all. */
+	if(!server.joinGroup(group)) {
+		print_dbg("Multicast is not available, skipping.\n");
+		return;
+	}
+
+	assert(sender.setMulticastLoopback(true));
+	assert(sender.setMulticastTtl(1));
+
+	if(sender.write(msg, sizeof(msg)) != sizeof(msg)) {
+		print_dbg("Multicast is not routed, skipping.\n");
+		return;
+	}
+
+	auto rv = server.recvFrom(buffer, sizeof(buffer), addr, port);
+	assert(rv == sizeof(msg));
+	assert(memcmp(buffer, msg, sizeof(msg)) == 0);
+
+	assert(server.leaveGroup(group));
+	assert(!server.leaveGroup(group));
+
+	print_dbg("UDP multicast test passed!\n");
+}
+
+static void test_broadcast()
+{
+	lwiot::SocketUdpClient client(lwiot::IPAddress(127, 0, 0, 1), PORT);
+	const char msg[] = "discover";
+
+	auto rv = client.broadcast(msg, sizeof(msg), PORT);
+
+	/* Hosts without a broadcast capable interface refuse the datagram. */
+	assert(rv == sizeof(msg) || rv < 0);
+	assert(client.stats().writes == 1);
+
+	print_dbg("UDP broadcast test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	test_options();
+	test_multicast();
+	test_broadcast();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+/*
+ * NTP client unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/network/udpclient.h>
+#include <lwiot/network/udpserver.h>
+#include <lwiot/network/socketudpclient.h>
+#include <lwiot/network/socketudpserver.h>
+#include <lwiot/network/ntpclient.h>
+
+#define PORT 5576
+#define SERVERS 3
+#define EPOCH 1600000000000LL
+
+static lwiot::AtomicBool running(true);
+static volatile int64_t shifts[SERVERS];
+
+static int64_t reference(int idx)
+{
+	return EPOCH + lwiot_tick_ms() + shifts[idx];
+}
+
+static void timestamp(uint8_t *p, int64_t ms)
+{
+	uint64_t seconds = ms / 1000 + 2208988800ULL;
+	uint64_t fraction = ((ms % 1000) << 32) / 1000;
+
+	for(int idx = 0; idx < 4; idx++) {
+		p[idx] = (seconds >> (24 - idx * 8)) & 0xFF;
+		p[idx + 4] = (fraction >> (24 - idx * 8)) & 0xFF;
+	}
+}
+
+static void serve(int idx)
+{
+	lwiot::SocketUdpServer server(BIND_ADDR_LB, PORT + idx);
+	uint8_t packet[48];
+	lwiot::IPAddress peer;
+	uint16_t port;
+
+	assert(server.bind());
+	server.setTimeout(1);
+
+	while(running) {
+		if(server.recvFrom(packet, sizeof(packet), peer, port) != sizeof(packet))
+			continue;
+
+		auto now = reference(idx);
+
+		memcpy(packet + 24, packet + 40, 8);
+		packet[0] = 0x24;
+		packet[1] = 1;
+		timestamp(packet + 32, now);
+		timestamp(packet + 40, now);
+		server.sendTo(packet, sizeof(packet), peer, port);
+	}
+}
+
+static int64_t error(const lwiot::NtpClient& client, int idx)
+{
+	auto rv = client.milliseconds() - reference(idx);
+	return rv < 0 ? -rv : rv;
+}
+
+static void test_ntp()
+{
+	lwiot::FunctionalThread *workers[SERVERS];
+	lwiot::SocketUdpClient *udp[SERVERS];
+	lwiot::NtpClient client;
+
+	for(int idx = 0; idx < SERVERS; idx++) {
+		workers[idx] = new lwiot::FunctionalThread("ntp");
+		workers[idx]->start([idx]() {
+			serve(idx);
+		});
+
+		udp[idx] = new lwiot::SocketUdpClient(lwiot::IPAddress(127, 0, 0, 1), PORT + idx);
+		assert(client.addServer(*udp[idx]));
+	}
+
+	lwiot_sleep(100);
+	client.begin();
+	assert(!client.synchronized());
+
+	/* The first update steps the clock, and the server that is off is outvoted. */
+	shifts[2] = 5000;
+	assert(client.update());
+	assert(client.synchronized());
+	assert(error(client, 0) <= 5);
+	assert(client.time() == client.milliseconds() / 1000);
+
+	/* Small offsets are slewed, rather than stepped. */
+	shifts[0] = shifts[1] = 60;
+	auto before = client.milliseconds();
+	assert(client.update());
+	assert(client.offset() >= 55 && client.offset() <= 65);
+	assert(client.milliseconds() - before < 20);
+	assert(error(client, 0) >= 40);
+
+	/* Large offsets are stepped. */
+	shifts[0] = shifts[1] = 1000;
+	assert(client.update());
+	assert(error(client, 0) <= 5);
+	assert(client.delay() <= 5);
+	assert(client.drift() == 0);
+
+	running = false;
+
+	for(int idx = 0; idx < SERVERS; idx++) {
+		workers[idx]->join();
+		delete workers[idx];
+		delete udp[idx];
+	}
+
+	print_dbg("NTP client test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	test_ntp();
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+/*
+ * Socket option and connect timeout unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+
+#define PORT 5557
+
+static void test_options()
+{
+	lwiot::SocketTcpServer server;
+	lwiot::SocketTcpClient client;
+	lwiot::IPAddress addr(127, 0, 0, 1);
+	int value = 0;
+
+	assert(server.bind(BIND_ADDR_LB, PORT));
+
+	/* Options set before connecting are applied once the socket exists. */
+	assert(client.setOption(SOCKET_OPT_NODELAY, 1));
+	client.setConnectTimeout(1000);
+	assert(client.connect(addr, PORT));
+
+	auto accepted = server.accept();
+	assert(accepted.get() != nullptr);
+
+	assert(socket_get_option(client.handle(), SOCKET_OPT_NODELAY, &value) == -EOK);
+	assert(value != 0);
+
+	assert(client.setOption(SOCKET_OPT_KEEPALIVE, 1));
+	assert(socket_get_option(client.handle(), SOCKET_OPT_KEEPALIVE, &value) == -EOK);
+	assert(value != 0);
+
+	assert(client.setOption(SOCKET_OPT_RCVBUF, 16 * 1024));
+	assert(socket_get_option(client.handle(), SOCKET_OPT_RCVBUF, &value) == -EOK);
+	assert(value > 0);
+
+	assert(!client.setOption(SOCKET_OPT_MAX, 1));
+	assert(socket_set_option(client.handle(), SOCKET_OPT_MAX, 1) == -ENOTSUPPORTED);
+
+	client.close();
+	accepted->close();
+	server.close();
+	print_dbg("Socket option test passed!\n");
+}
+
+static void test_connect_timeout()
+{
+	lwiot::SocketTcpClient client;
+	lwiot::IPAddress addr(127, 0, 0, 1);
+
+	/* Nothing listens on this port: the connect is refused long before the timeout. */
+	client.setConnectTimeout(1000);
+	auto start = lwiot_tick_ms();
+	assert(!client.connect(addr, PORT + 1));
+	assert(lwiot_tick_ms() - start < 1000);
+	assert(!client.connected());
+
+	assert(client.stats().connect_failures == 1);
+	assert(client.stats().connects == 0);
+
+	print_dbg("Connect timeout test passed!\n");
+}
+
+static void test_stats()
+{
+	lwiot::SocketTcpServer server;
+	lwiot::SocketTcpClient client;
+	lwiot::IPAddress addr(127, 0, 0, 1);
+	uint8_t buffer[16];
+
+	lwiot::SocketStats::resetGlobal();
+	assert(server.bind(BIND_ADDR_LB, PORT + 2));
+	assert(client.connect(addr, PORT + 2));
+
+	auto accepted = server.accept();
+	assert(accepted.get() != nullptr);
+
+	assert(client.write("hello", 5) == 5);
+	assert(accepted->write("world!", 6) == 6);
+	assert(client.read(buffer, 6) == 6);
+
+	auto stats = client.stats();
+	assert(stats.connects == 1);
+	assert(stats.bytes_out == 5);
+	assert(stats.bytes_in == 6);
+	assert(stats.writes == 1);
+	assert(stats.reads >= 1);
+	assert(stats.errors == 0);
+
+	auto global = lwiot::SocketStats::global();
+	assert(global.bytes_out == 11);
+	assert(global.connects == 1);
+	print_dbg("Stats: %s\n", stats.toString().c_str());
+
+	client.resetStats();
+	assert(client.stats().bytes_in == 0);
+
+	client.close();
+	accepted->close();
+	server.close();
+	print_dbg("Socket statistics test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	test_options();
+	test_connect_timeout();
+	test_stats();
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
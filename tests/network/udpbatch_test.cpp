@@ -0,0 +1,109 @@
+/*
+ * Batched and client-less UDP server unit test.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/network/datagrambatch.h>
+#include <lwiot/network/socketudpserver.h>
+
+#define PORT_A 5010
+#define PORT_B 5011
+#define COUNT  40
+
+static void test_batch()
+{
+	lwiot::SocketUdpServer a(BIND_ADDR_LB, PORT_A), b(BIND_ADDR_LB, PORT_B);
+	lwiot::DatagramBatch out(COUNT, 64), in(COUNT, 64);
+	lwiot::IPAddress lb(127, 0, 0, 1);
+	size_t total;
+
+	assert(a.bind());
+	assert(b.bind());
+	a.setTimeout(1);
+	b.setTimeout(1);
+
+	for(uint32_t idx = 0; idx < COUNT; idx++)
+		assert(out.add(&idx, sizeof(idx), lb, PORT_B));
+
+	assert(!out.add("x", 1, lb, PORT_B));
+	assert(a.sendBatch(out) == COUNT);
+
+	/* More datagrams than one system call moves, so this crosses a chunk boundary. */
+	total = 0;
+	while(total < COUNT) {
+		auto rv = b.recvBatch(in, COUNT);
+		assert(rv > 0);
+
+		for(size_t idx = 0; idx < in.size(); idx++) {
+			uint32_t value;
+
+			assert(in.length(idx) == sizeof(value));
+			memcpy(&value, in.data(idx), sizeof(value));
+			assert(value == total + idx);
+			assert(in.port(idx) == PORT_A);
+			assert(static_cast<uint32_t>(in.address(idx)) == static_cast<uint32_t>(lb));
+		}
+
+		total += in.size();
+	}
+
+	assert(total == COUNT);
+
+	/* Nothing queued: the receive times out instead of returning an empty batch. */
+	assert(b.recvBatch(in, COUNT) < 0);
+	assert(in.size() == 0);
+
+	a.close();
+	b.close();
+	print_dbg("UDP batch test passed!\n");
+}
+
+static void test_recvfrom()
+{
+	lwiot::SocketUdpServer a(BIND_ADDR_LB, PORT_A), b(BIND_ADDR_LB, PORT_B);
+	lwiot::IPAddress lb(127, 0, 0, 1), peer;
+	const char msg[] = "ping";
+	char buffer[16];
+	uint16_t port = 0;
+
+	assert(a.bind());
+	assert(b.bind());
+	b.setTimeout(1);
+
+	assert(a.sendTo(msg, sizeof(msg), lb, PORT_B) == sizeof(msg));
+	assert(b.recvFrom(buffer, sizeof(buffer), peer, port) == sizeof(msg));
+	assert(strcmp(buffer, msg) == 0);
+	assert(port == PORT_A);
+	assert(static_cast<uint32_t>(peer) == static_cast<uint32_t>(lb));
+
+	/* Reply from the server socket, no client object involved. */
+	assert(b.sendTo(buffer, sizeof(msg), peer, port) == sizeof(msg));
+	a.setTimeout(1);
+	assert(a.recvFrom(buffer, sizeof(buffer), peer, port) == sizeof(msg));
+	assert(port == PORT_B);
+
+	a.close();
+	b.close();
+	print_dbg("UDP recvFrom test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	test_batch();
+	test_recvfrom();
+	lwiot_destroy();
+	wait_close();
+
+	return -EXIT_SUCCESS;
+}
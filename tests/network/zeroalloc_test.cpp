@@ -0,0 +1,326 @@
+/*
+ * Allocation free hot path test. Requires a build with CONFIG_ALLOC_TRACKING.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <lwiot.h>
+#include <assert.h>
+
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/bytebuffer.h>
+#include <lwiot/bufferedstream.h>
+#include <lwiot/io/gpiopin.h>
+#include <lwiot/io/i2cbus.h>
+#include <lwiot/io/i2cmessage.h>
+#include <lwiot/hosted/hardwarei2calgorithm.h>
+#include <lwiot/network/mqttclient.h>
+#include <lwiot/network/httpserver.h>
+#include <lwiot/network/tcpclient.h>
+#include <lwiot/network/sockettcpclient.h>
+#include <lwiot/network/sockettcpserver.h>
+#include <lwiot/network/xbee/xbee.h>
+#include <lwiot/util/allocationguard.h>
+
+#ifndef CONFIG_ALLOC_TRACKING
+#error "Allocation tracking is not enabled"
+#endif
+
+#define PORT 5583
+#define ROUNDS 16
+#define WARMUP 2
+
+/* TCP connection to a scripted peer: written data is discarded, and read data is queued by the test. */
+class ScriptedClient : public lwiot::TcpClient {
+public:
+	explicit ScriptedClient() : TcpClient(), written(0), _head(0), _tail(0)
+	{
+	}
+
+	void push(const void *data, size_t length)
+	{
+		assert(this->_tail + length <= sizeof(this->_data));
+		memcpy(this->_data + this->_tail, data, length);
+		this->_tail += length;
+	}
+
+	explicit operator bool() const override
+	{
+		return true;
+	}
+
+	bool connected() const override
+	{
+		return true;
+	}
+
+	size_t available() const override
+	{
+		return this->_readahead.available() + this->_tail - this->_head;
+	}
+
+	using TcpClient::read;
+	using TcpClient::write;
+
+	ssize_t read(void *output, const size_t& length) override
+	{
+		return this->readBuffered(output, length);
+	}
+
+	ssize_t write(const void *bytes, const size_t& length) override
+	{
+		this->written += length;
+		return length;
+	}
+
+	bool connect(const lwiot::IPAddress& addr, uint16_t port) override
+	{
+		return true;
+	}
+
+	bool connect(const lwiot::String& host, uint16_t port) override
+	{
+		return true;
+	}
+
+	void close() override
+	{
+	}
+
+	size_t written;
+
+protected:
+	ssize_t receive(void *output, size_t length) override
+	{
+		if(length > this->_tail - this->_head)
+			length = this->_tail - this->_head;
+
+		memcpy(output, this->_data + this->_head, length);
+		this->_head += length;
+
+		if(this->_head == this->_tail)
+			this->_head = this->_tail = 0;
+
+		return length;
+	}
+
+private:
+	uint8_t _data[1024];
+	size_t _head;
+	size_t _tail;
+};
+
+static void test_guard()
+{
+	lwiot::ScopedAllocationGuard guard;
+
+	assert(lwiot::ScopedAllocationGuard::enabled());
+	assert(guard.ok());
+
+	auto ptr = lwiot_mem_alloc(24);
+	assert(guard.allocations() == 1);
+	assert(guard.bytes() == 24);
+	assert(!guard.ok());
+
+	lwiot_mem_free(ptr);
+	assert(guard.frees() == 1);
+
+	{
+		lwiot::ScopedAllocationGuard nested(64);
+		auto object = new lwiot::ByteBuffer(16, true);
+
+		delete object;
+		assert(nested.allocations() == 2);
+		assert(nested.ok());
+	}
+
+	assert(guard.allocations() == 3);
+
+	guard.reset();
+	assert(guard.ok());
+	print_dbg("Allocation guard test passed!\n");
+}
+
+/*
+ * Once connected, keep-alives, acknowledgements and idle loops must not touch the heap. A
+ * PUBLISH is handed to the callback in a shared buffer, which is the only allocation.
+ */
+static void test_mqtt_loop()
+{
+	const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+	const uint8_t pingreq[] = { 0xC0, 0x00 };
+	const uint8_t pingresp[] = { 0xD0, 0x00 };
+	const uint8_t puback[] = { 0x40, 0x02, 0x00, 0x01 };
+	const uint8_t publish[] = { 0x30, 0x0E, 0x00, 0x06, 's', 'e', 'n', 's', 'o', 'r', '2', '1', '.', '5', 'C', '!' };
+	ScriptedClient client;
+	lwiot::MqttClient mqtt;
+	int received = 0;
+
+	mqtt.begin(client);
+	mqtt.setCallback([&received](const lwiot::String& topic, const lwiot::SharedByteBuffer& payload) {
+		received++;
+	});
+
+	client.push(connack, sizeof(connack));
+	assert(mqtt.connect("zeroalloc", "", ""));
+
+	/* The first message sizes the buffers that are reused afterwards. */
+	client.push(publish, sizeof(publish));
+	assert(mqtt.loop());
+	assert(received == 1);
+
+	for(int idx = 0; idx < ROUNDS; idx++) {
+		lwiot::ScopedAllocationGuard guard;
+
+		assert(mqtt.loop());
+		client.push(pingreq, sizeof(pingreq));
+		assert(mqtt.loop());
+		client.push(pingresp, sizeof(pingresp));
+		assert(mqtt.loop());
+		client.push(puback, sizeof(puback));
+		assert(mqtt.loop());
+
+		assert(guard.ok());
+	}
+
+	for(int idx = 0; idx < ROUNDS; idx++) {
+		lwiot::ScopedAllocationGuard guard(64);
+
+		client.push(publish, sizeof(publish));
+		assert(mqtt.loop());
+
+		assert(guard.allocations() <= 3);
+		assert(guard.ok());
+	}
+
+	assert(received == ROUNDS + 1);
+	print_dbg("MQTT loop test passed!\n");
+}
+
+static void test_http_request()
+{
+	const char request[] = "GET /hello HTTP/1.1\r\nHost: test\r\n\r\n";
+	lwiot::HttpServer server(new lwiot::SocketTcpServer(BIND_ADDR_LB, PORT));
+	lwiot::SocketTcpClient client;
+	lwiot::IPAddress addr(127, 0, 0, 1);
+	lwiot::String body("hello");
+	char response[512];
+
+	server.on("/hello", lwiot::HTTP_GET, [&body](lwiot::HttpServer& srv) {
+		srv.send(200, "text/plain", body);
+	});
+
+	server.setMaxConnections(2, 5000);
+	assert(server.begin());
+	assert(client.connect(addr, PORT));
+
+	for(int idx = 0; idx < WARMUP + ROUNDS; idx++) {
+		size_t allocations = 0;
+		auto start = lwiot_tick_ms();
+
+		assert(client.write(request, sizeof(request) - 1) == sizeof(request) - 1);
+
+		while(client.available() == 0 && lwiot_tick_ms() - start < 3000) {
+			lwiot::ScopedAllocationGuard guard;
+
+			server.handleClient();
+
+			allocations += guard.allocations();
+		}
+
+		lwiot_sleep(5);
+		auto length = client.read(response, sizeof(response) - 1);
+
+		assert(length > 0);
+		response[length] = '\0';
+		assert(strstr(response, "\r\n\r\nhello") != nullptr);
+
+		/* The first requests accept the connection and size its buffers. */
+		if(idx >= WARMUP)
+			assert(allocations == 0);
+	}
+
+	client.close();
+	server.close();
+	print_dbg("HTTP request test passed!\n");
+}
+
+static void test_i2c_transfer()
+{
+	lwiot::GpioPin scl(1), sda(2);
+	lwiot::I2CBus bus(new lwiot::hosted::HardwareI2CAlgorithm(scl, sda, 400000));
+	lwiot::I2CMessage wr(1), rd(3);
+
+	wr.setAddress(0x6B, false, false);
+	rd.setAddress(0x6B, false, true);
+	wr.write(1);
+
+	for(int idx = 0; idx < ROUNDS; idx++) {
+		lwiot::ScopedAllocationGuard guard;
+
+		bus.transfer(wr);
+		rd.setIndex(0);
+		bus.transfer(rd);
+
+		assert(guard.ok());
+	}
+
+	print_dbg("I2C transfer test passed!\n");
+}
+
+static void test_xbee_read()
+{
+	/* ZigBee receive packet from 0x0013A20040A1B2C3, 0x1234, with "hello" as payload. */
+	const uint8_t frame[] = {
+		0x7E, 0x00, 0x11, 0x90, 0x00, 0x13, 0xA2, 0x00, 0x40, 0xA1, 0xB2, 0xC3, 0x12, 0x34, 0x01,
+		'h', 'e', 'l', 'l', 'o', 0x00
+	};
+	uint8_t packet[sizeof(frame)];
+	lwiot::BufferedStream serial(1024);
+	lwiot::XBee xbee;
+	uint8_t sum = 0;
+
+	memcpy(packet, frame, sizeof(frame));
+
+	for(size_t idx = 3; idx < sizeof(packet) - 1; idx++)
+		sum += packet[idx];
+
+	packet[sizeof(packet) - 1] = 0xFF - sum;
+	xbee.setSerial(serial);
+
+	for(int idx = 0; idx < ROUNDS; idx++) {
+		serial.write(packet, sizeof(packet));
+
+		lwiot::ScopedAllocationGuard guard;
+
+		xbee.readPacket();
+		assert(xbee.getResponse().isAvailable());
+		assert(xbee.getResponse().getApiId() == 0x90);
+
+		assert(guard.ok());
+	}
+
+	print_dbg("XBee read test passed!\n");
+}
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+
+	test_guard();
+	test_mqtt_loop();
+	test_http_request();
+	test_i2c_transfer();
+	test_xbee_read();
+
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
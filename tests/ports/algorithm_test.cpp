@@ -0,0 +1,227 @@
+/*
+ * Unit test for the stl algorithms.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#ifdef HAVE_RTOS
+#include <FreeRTOS.h>
+#include <task.h>
+#endif
+
+#include <lwiot/kernel/executor.h>
+#include <lwiot/kernel/thread.h>
+#include <lwiot/stl/vector.h>
+#include <lwiot/stl/algorithm.h>
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#ifdef NDEBUG
+#error "Debugging not enabled.."
+#endif
+
+using namespace lwiot;
+
+static void fill(stl::Vector<int>& values, size_t num, uint32_t seed)
+{
+	values.clear();
+
+	for(size_t idx = 0; idx < num; idx++) {
+		seed = seed * 1103515245U + 12345U;
+		values.push_back(static_cast<int>((seed >> 16) % 1000));
+	}
+}
+
+static bool sorted(const stl::Vector<int>& values)
+{
+	for(size_t idx = 1; idx < values.size(); idx++) {
+		if(values[idx - 1] > values[idx])
+			return false;
+	}
+
+	return true;
+}
+
+static void sort_test()
+{
+	stl::Vector<int> values;
+
+	/* Random, already sorted, reversed and constant input. */
+	fill(values, 5000, 42);
+	stl::sort(values.begin(), values.end());
+	assert(sorted(values));
+
+	stl::sort(values.begin(), values.end());
+	assert(sorted(values));
+
+	stl::sort(values.begin(), values.end(), [](int a, int b) { return a > b; });
+	assert(values[0] >= values[values.size() - 1]);
+	stl::sort(values.begin(), values.end());
+	assert(sorted(values));
+
+	for(auto& value : values)
+		value = 7;
+
+	stl::sort(values.begin(), values.end());
+	assert(values[0] == 7);
+
+	int raw[] = { 5, 3, 9, 1 };
+	stl::sort(raw, raw + 4);
+	assert(raw[0] == 1 && raw[3] == 9);
+
+	print_dbg("Sort test passed!\n");
+}
+
+static void search_test()
+{
+	stl::Vector<int> values;
+
+	for(int idx = 0; idx < 100; idx++)
+		values.push_back(idx * 2);
+
+	assert(stl::binary_search(values.begin(), values.end(), 42));
+	assert(!stl::binary_search(values.begin(), values.end(), 43));
+	assert(stl::lower_bound(values.begin(), values.end(), 43) - values.begin() == 22);
+	assert(stl::upper_bound(values.begin(), values.end(), 42) - values.begin() == 22);
+	assert(stl::lower_bound(values.begin(), values.end(), 500) == values.end());
+
+	auto split = stl::partition(values.begin(), values.end(), [](int value) { return value % 4 == 0; });
+
+	assert(split - values.begin() == 50);
+
+	for(auto iter = values.begin(); iter != split; ++iter)
+		assert(*iter % 4 == 0);
+
+	fill(values, 1001, 7);
+
+	auto nth = values.begin() + 500;
+	stl::Vector<int> copy(values);
+
+	stl::nth_element(values.begin(), nth, values.end());
+	stl::sort(copy.begin(), copy.end());
+
+	auto median = copy[500];
+	assert(*nth == median);
+
+	for(auto iter = values.begin(); iter != nth; ++iter)
+		assert(*iter <= median);
+
+	print_dbg("Search test passed!\n");
+}
+
+static void reduce_test()
+{
+	stl::Vector<int> values;
+	stl::Vector<int> squares;
+
+	for(int idx = 1; idx <= 100; idx++) {
+		values.push_back(idx);
+		squares.push_back(0);
+	}
+
+	assert(stl::accumulate(values.begin(), values.end(), 0) == 5050);
+	assert(stl::accumulate(values.begin(), values.begin() + 5, 1, [](int a, int b) { return a * b; }) == 120);
+
+	auto end = stl::transform(values.begin(), values.end(), squares.begin(), [](int value) { return value * value; });
+
+	assert(end == squares.end());
+	assert(squares[9] == 100);
+
+	print_dbg("Reduce test passed!\n");
+}
+
+static void parallel_test()
+{
+	Executor executor("algorithm", 3);
+	stl::Vector<int> values;
+	stl::Vector<int> doubled;
+	long expected = 0;
+
+	executor.start();
+
+	fill(values, 20000, 1234);
+
+	for(auto value : values) {
+		expected += value;
+		doubled.push_back(0);
+	}
+
+	auto sum = stl::parallel::accumulate(executor, values.begin(), values.end(), 0L);
+	assert(sum == expected);
+
+	stl::parallel::transform(executor, values.begin(), values.end(), doubled.begin(), [](int value) {
+		return value * 2;
+	});
+
+	for(size_t idx = 0; idx < values.size(); idx++)
+		assert(doubled[idx] == values[idx] * 2);
+
+	stl::parallel::sort(executor, values.begin(), values.end());
+	assert(sorted(values));
+	assert(stl::accumulate(values.begin(), values.end(), 0L) == expected);
+
+	/* Posting from a worker must not deadlock, even when all workers do. */
+	Atomic<int> done(0);
+
+	for(int idx = 0; idx < 3; idx++) {
+		executor.post([&]() {
+			stl::Vector<int> local;
+
+			fill(local, 10000, static_cast<uint32_t>(done.load()) + 99);
+			stl::parallel::sort(executor, local.begin(), local.end());
+			assert(sorted(local));
+			++done;
+		});
+	}
+
+	while(done.load() != 3)
+		Thread::sleep(10);
+
+	executor.stop();
+	print_dbg("Parallel test passed!\n");
+}
+
+class ThreadTest : public Thread {
+public:
+	explicit ThreadTest(const char *arg) : Thread("algorithm-test", (void*)arg)
+	{
+	}
+
+protected:
+	void run() override
+	{
+		sort_test();
+		search_test();
+		reduce_test();
+		parallel_test();
+
+#ifdef HAVE_RTOS
+		vTaskEndScheduler();
+#endif
+	}
+};
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	UNUSED(argc);
+	UNUSED(argv);
+
+	ThreadTest t1("algorithm-test");
+
+	t1.start();
+#ifdef HAVE_RTOS
+	vTaskStartScheduler();
+#endif
+
+	t1.join();
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
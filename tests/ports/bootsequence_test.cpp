@@ -0,0 +1,198 @@
+/*
+ * Unit test for the BootSequence class.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#ifdef HAVE_RTOS
+#include <FreeRTOS.h>
+#include <task.h>
+#endif
+
+#include <lwiot/kernel/bootsequence.h>
+#include <lwiot/kernel/executor.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/thread.h>
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#ifdef NDEBUG
+#error "Debugging not enabled.."
+#endif
+
+using namespace lwiot;
+
+static void parallel_test()
+{
+	Executor executor("boot", 3);
+	Logger logger("boot-test");
+	Atomic<int> order(0);
+	int wifi = 0, sensor = 0, mqtt = 0;
+
+	executor.start();
+
+	{
+		BootSequence boot(executor);
+
+		boot.add("wifi", [&]() {
+			Thread::sleep(100);
+			wifi = ++order;
+			return true;
+		});
+
+		boot.add("sensor", [&]() {
+			Thread::sleep(100);
+			sensor = ++order;
+			return true;
+		});
+
+		boot.add("mqtt", [&]() {
+			mqtt = ++order;
+			return true;
+		}).after("mqtt", "wifi");
+
+		auto start = lwiot_tick_ms();
+
+		assert(boot.start());
+		assert(boot.wait());
+
+		/* The sensor and Wi-Fi start up at the same time. */
+		assert(lwiot_tick_ms() - start < 190);
+		assert(mqtt > wifi);
+		assert(sensor != 0);
+		assert(boot.status("mqtt") == BootStatus::Done);
+
+		auto steps = boot.steps();
+
+		assert(steps.size() == 3);
+		assert(steps[0].duration >= 90000000ULL);
+		assert(steps[2].started >= steps[0].started + steps[0].duration);
+		assert(boot.elapsed() >= 100000000ULL);
+
+		boot.report(logger);
+	}
+
+	executor.stop();
+	print_dbg("Parallel test passed!\n");
+}
+
+static void lazy_test()
+{
+	Executor executor("boot", 2);
+	int tls = 0, ota = 0, dns = 0;
+
+	executor.start();
+
+	{
+		BootSequence boot(executor);
+
+		boot.add("dns", [&]() { return ++dns > 0; }, true);
+		boot.add("tls", [&]() { return ++tls > 0; }, true).after("tls", "dns");
+		boot.add("ota", [&]() { return ++ota > 0; }, true);
+
+		assert(boot.start());
+		assert(boot.wait());
+		assert(dns == 0 && tls == 0 && ota == 0);
+		assert(boot.status("tls") == BootStatus::Pending);
+
+		/* Requiring a component initializes its dependencies, once. */
+		assert(boot.require("tls"));
+		assert(boot.require("tls"));
+		assert(dns == 1 && tls == 1);
+		assert(ota == 0);
+		assert(!boot.require("unknown"));
+	}
+
+	executor.stop();
+	print_dbg("Lazy test passed!\n");
+}
+
+static void failure_test()
+{
+	Executor executor("boot", 2);
+	bool ran = false;
+
+	executor.start();
+
+	{
+		BootSequence boot(executor);
+
+		boot.add("wifi", []() { return false; });
+		boot.add("mqtt", [&]() { return ran = true; }).after("mqtt", "wifi");
+		boot.add("ntp", [&]() { return ran = true; }).after("ntp", "mqtt");
+		boot.add("sensor", []() { return true; });
+
+		assert(boot.start());
+		assert(!boot.wait());
+		assert(!ran);
+		assert(boot.status("wifi") == BootStatus::Failed);
+		assert(boot.status("mqtt") == BootStatus::Skipped);
+		assert(boot.status("ntp") == BootStatus::Skipped);
+		assert(boot.status("sensor") == BootStatus::Done);
+	}
+
+	{
+		BootSequence cycle(executor);
+
+		cycle.add("a", []() { return true; }).after("a", "b");
+		cycle.add("b", []() { return true; }).after("b", "a");
+		assert(!cycle.start());
+
+		BootSequence unknown(executor);
+
+		unknown.add("a", []() { return true; }).after("a", "missing");
+		assert(!unknown.start());
+
+		BootSequence misspelled(executor);
+
+		misspelled.add("a", []() { return true; }).after("A", "a");
+		assert(!misspelled.start());
+	}
+
+	executor.stop();
+	print_dbg("Failure test passed!\n");
+}
+
+class ThreadTest : public Thread {
+public:
+	explicit ThreadTest(const char *arg) : Thread("bootsequence-test", (void*)arg)
+	{
+	}
+
+protected:
+	void run() override
+	{
+		parallel_test();
+		lazy_test();
+		failure_test();
+
+#ifdef HAVE_RTOS
+		vTaskEndScheduler();
+#endif
+	}
+};
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	UNUSED(argc);
+	UNUSED(argv);
+
+	ThreadTest t1("bootsequence-test");
+
+	t1.start();
+#ifdef HAVE_RTOS
+	vTaskStartScheduler();
+#endif
+
+	t1.join();
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
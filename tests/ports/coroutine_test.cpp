@@ -0,0 +1,180 @@
+/*
+ * Unit test for the Coroutine class.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#ifdef HAVE_RTOS
+#include <FreeRTOS.h>
+#include <task.h>
+#endif
+
+#include <lwiot/kernel/coroutine.h>
+#include <lwiot/kernel/executor.h>
+#include <lwiot/kernel/thread.h>
+#include <lwiot/ringbufferstream.h>
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#ifdef NDEBUG
+#error "Debugging not enabled.."
+#endif
+
+class Ticker : public lwiot::Coroutine {
+public:
+	explicit Ticker(int ticks) : Coroutine(), _ticks(ticks), _count(0)
+	{
+	}
+
+	int count() const
+	{
+		return this->_count;
+	}
+
+protected:
+	lwiot::CoroutineState run() override
+	{
+		LWIOT_CO_BEGIN();
+
+		for(this->_count = 0; this->_count < this->_ticks; this->_count++) {
+			LWIOT_CO_SLEEP(20);
+			LWIOT_CO_YIELD();
+		}
+
+		LWIOT_CO_END();
+	}
+
+private:
+	int _ticks;
+	int _count;
+};
+
+class Reader : public lwiot::Coroutine {
+public:
+	explicit Reader(lwiot::Stream& stream) : Coroutine(), _stream(stream), _value(0), _timeout(false)
+	{
+	}
+
+	uint32_t value() const
+	{
+		return this->_value;
+	}
+
+	bool timeout() const
+	{
+		return this->_timeout;
+	}
+
+protected:
+	lwiot::CoroutineState run() override
+	{
+		LWIOT_CO_BEGIN();
+
+		LWIOT_CO_READABLE(this->_stream, sizeof(this->_value), 1000);
+		assert(!this->timedOut());
+		this->_stream.read(&this->_value, sizeof(this->_value));
+
+		LWIOT_CO_READABLE(this->_stream, 1, 100);
+		this->_timeout = this->timedOut();
+
+		LWIOT_CO_END();
+	}
+
+private:
+	lwiot::Stream& _stream;
+	uint32_t _value;
+	bool _timeout;
+};
+
+static void ticker_test()
+{
+	lwiot::Executor executor("co");
+	Ticker *tickers[100];
+	auto start = lwiot_tick_ms();
+
+	executor.start();
+
+	/* A hundred coroutines share a single worker thread. */
+	for(auto& ticker : tickers) {
+		ticker = new Ticker(5);
+		assert(ticker->start(executor));
+	}
+
+	for(auto ticker : tickers) {
+		assert(ticker->join(2000));
+		assert(ticker->count() == 5);
+		delete ticker;
+	}
+
+	assert(lwiot_tick_ms() - start < 1000);
+
+	executor.stop();
+	print_dbg("Ticker test passed!\n");
+}
+
+static void reader_test()
+{
+	lwiot::Executor executor("co");
+	lwiot::RingBufferStream stream(16);
+	Reader reader(stream);
+	uint32_t value = 0xDEADBEEF;
+
+	executor.start();
+	assert(reader.start(executor));
+	assert(!reader.start(executor));
+
+	lwiot_sleep(50);
+	assert(!reader.done());
+
+	stream.write(&value, sizeof(value));
+	assert(reader.join(1000));
+
+	assert(reader.value() == 0xDEADBEEF);
+	assert(reader.timeout());
+
+	executor.stop();
+	print_dbg("Reader test passed!\n");
+}
+
+class ThreadTest : public lwiot::Thread {
+public:
+	explicit ThreadTest(const char *arg) : Thread("coroutine-test", (void*)arg)
+	{
+	}
+
+protected:
+	void run() override
+	{
+		ticker_test();
+		reader_test();
+
+#ifdef HAVE_RTOS
+		vTaskEndScheduler();
+#endif
+	}
+};
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	UNUSED(argc);
+	UNUSED(argv);
+
+	ThreadTest t1("coroutine-test");
+
+	t1.start();
+#ifdef HAVE_RTOS
+	vTaskStartScheduler();
+#endif
+
+	wait_close();
+	t1.stop();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
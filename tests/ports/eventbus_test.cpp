@@ -0,0 +1,294 @@
+/*
+ * Unit test for the EventBus class.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#ifdef HAVE_RTOS
+#include <FreeRTOS.h>
+#include <task.h>
+#endif
+
+#include <lwiot/kernel/eventbus.h>
+#include <lwiot/kernel/executor.h>
+#include <lwiot/kernel/thread.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/stl/vector.h>
+
+#ifdef NDEBUG
+#error "Debugging not enabled.."
+#endif
+
+struct Sample {
+	explicit Sample(int sensor, float value) : sensor(sensor), value(value)
+	{
+	}
+
+	int sensor;
+	float value;
+};
+
+struct RawSamples : public lwiot::Topic<Sample> { };
+struct FilteredSamples : public lwiot::Topic<Sample> { };
+struct Alarms : public lwiot::Topic<int> { };
+
+template <typename Func>
+static void wait_for(Func&& done)
+{
+	for(int idx = 0; idx < 200 && !done(); idx++)
+		lwiot_sleep(5);
+
+	assert(done());
+}
+
+static void sync_test()
+{
+	lwiot::EventBus bus;
+	const Sample *seen = nullptr;
+	int raw = 0, filtered = 0, alarms = 0;
+
+	assert(bus.publish<RawSamples>(lwiot::makeShared<Sample>(1, 1.0f)) == 0);
+
+	{
+		lwiot::Subscriber<RawSamples> first(bus, [&](const lwiot::SharedPointer<Sample>& sample) {
+			seen = sample.get();
+			raw++;
+		});
+		lwiot::Subscriber<RawSamples> second(bus, [&](const lwiot::SharedPointer<Sample>& sample) {
+			assert(sample.get() == seen);
+			raw++;
+		});
+		lwiot::Subscriber<FilteredSamples> third(bus, [&](const lwiot::SharedPointer<Sample>& sample) {
+			filtered++;
+		});
+		lwiot::Subscriber<Alarms> fourth(bus, [&](const lwiot::SharedPointer<int>& level) {
+			assert(*level == 3);
+			alarms++;
+		});
+
+		assert(first.subscribed() && second.subscribed());
+		assert(bus.subscribers<RawSamples>() == 2);
+		assert(bus.subscribers<FilteredSamples>() == 1);
+
+		/* Topics with the same message type are separate, and messages are shared, not copied. */
+		auto sample = lwiot::makeShared<Sample>(2, 21.5f);
+		assert(bus.publish<RawSamples>(sample) == 2);
+		assert(seen == sample.get());
+		assert(sample.useCount() == 1);
+		assert(raw == 2 && filtered == 0);
+
+		assert(bus.emit<FilteredSamples>(2, 21.0f) == 1);
+		assert(bus.emit<Alarms>(3) == 1);
+		assert(filtered == 1 && alarms == 1);
+	}
+
+	assert(bus.subscribers<RawSamples>() == 0);
+	assert(bus.emit<RawSamples>(3, 0.0f) == 0);
+	assert(raw == 2);
+
+	print_dbg("Synchronous delivery test passed!\n");
+}
+
+static void capacity_test()
+{
+	lwiot::EventBus bus;
+	lwiot::stl::Vector<lwiot::Subscriber<Alarms>*> subscribers;
+
+	for(int idx = 0; idx < CONFIG_EVENTBUS_SUBSCRIBERS; idx++) {
+		subscribers.push_back(new lwiot::Subscriber<Alarms>(bus, [](const lwiot::SharedPointer<int>&) { }));
+		assert(subscribers.back()->subscribed());
+	}
+
+	{
+		lwiot::Subscriber<Alarms> extra(bus, [](const lwiot::SharedPointer<int>&) { });
+		assert(!extra.subscribed());
+	}
+
+	assert(bus.emit<Alarms>(1) == CONFIG_EVENTBUS_SUBSCRIBERS);
+
+	for(auto subscriber : subscribers)
+		delete subscriber;
+
+	print_dbg("Capacity test passed!\n");
+}
+
+static void queued_test()
+{
+	lwiot::Executor executor("bus");
+	lwiot::EventBus bus;
+	lwiot::stl::Vector<int> order;
+	const int num = 100;
+
+	executor.start();
+
+	{
+		lwiot::QueuedSubscriber<RawSamples, 128> storage(bus, executor, [&](const lwiot::SharedPointer<Sample>& sample) {
+			order.push_back(sample->sensor);
+		});
+
+		for(int idx = 0; idx < num; idx++)
+			assert(bus.emit<RawSamples>(idx, 0.0f) == 1);
+
+		wait_for([&]() { return order.size() == num; });
+
+		for(int idx = 0; idx < num; idx++)
+			assert(order[idx] == idx);
+
+		assert(storage.dropped() == 0);
+		assert(storage.pending() == 0);
+	}
+
+	executor.stop();
+	print_dbg("Queued delivery test passed!\n");
+}
+
+static void backpressure_test()
+{
+	lwiot::Executor executor("bus");
+	lwiot::EventBus bus;
+	lwiot::stl::Vector<int> rejected, dropped;
+	volatile bool blocked = true;
+
+	executor.start();
+
+	/* Keep the only worker busy, so messages pile up in the queues. */
+	executor.post([&]() {
+		while(blocked)
+			lwiot_sleep(1);
+	});
+
+	{
+		lwiot::QueuedSubscriber<Alarms, 4> reject(bus, executor, [&](const lwiot::SharedPointer<int>& value) {
+			rejected.push_back(*value);
+		});
+		lwiot::QueuedSubscriber<Alarms, 4> drop(bus, executor, [&](const lwiot::SharedPointer<int>& value) {
+			dropped.push_back(*value);
+		}, lwiot::EventOverflow::DropOldest);
+
+		for(int idx = 0; idx < 4; idx++)
+			assert(bus.emit<Alarms>(idx) == 2);
+
+		/* The rejecting subscriber refuses, the other one overwrites. */
+		assert(bus.emit<Alarms>(4) == 1);
+		assert(bus.emit<Alarms>(5) == 1);
+		assert(reject.pending() == 4 && drop.pending() == 4);
+		assert(reject.dropped() == 2 && drop.dropped() == 2);
+
+		blocked = false;
+		wait_for([&]() { return rejected.size() == 4 && dropped.size() == 4; });
+
+		for(int idx = 0; idx < 4; idx++) {
+			assert(rejected[idx] == idx);
+			assert(dropped[idx] == idx + 2);
+		}
+
+		assert(bus.emit<Alarms>(6) == 2);
+		wait_for([&]() { return rejected.size() == 5 && dropped.size() == 5; });
+	}
+
+	executor.stop();
+	print_dbg("Backpressure test passed!\n");
+}
+
+class Publisher : public lwiot::Thread {
+public:
+	explicit Publisher(lwiot::EventBus& bus) : Thread("publisher"), running(true), published(0), _bus(bus)
+	{
+	}
+
+	volatile bool running;
+	volatile int published;
+
+protected:
+	void run() override
+	{
+		auto sample = lwiot::makeShared<Sample>(1, 1.0f);
+
+		while(this->running) {
+			this->_bus.publish<RawSamples>(sample);
+			this->published++;
+		}
+	}
+
+private:
+	lwiot::EventBus& _bus;
+};
+
+static void churn_test()
+{
+	lwiot::EventBus bus;
+	lwiot::atomic_int_t handled(0);
+	Publisher publisher(bus);
+
+	publisher.start();
+	wait_for([&]() { return publisher.published > 0; });
+
+	/* Subscribers come and go while the topic is being published to. */
+	for(int idx = 0; idx < 200; idx++) {
+		lwiot::Subscriber<RawSamples> subscriber(bus, [&](const lwiot::SharedPointer<Sample>& sample) {
+			assert(sample->sensor == 1);
+			handled.fetch_add(1);
+		});
+
+		int published = publisher.published;
+
+		assert(subscriber.subscribed());
+		wait_for([&]() { return publisher.published - published > 2; });
+	}
+
+	publisher.running = false;
+	publisher.join();
+
+	assert(handled.load() > 0);
+	assert(bus.subscribers<RawSamples>() == 0);
+	print_dbg("Churn test passed!\n");
+}
+
+class ThreadTest : public lwiot::Thread {
+public:
+	explicit ThreadTest(const char *arg) : Thread("eventbus-test", (void*)arg)
+	{
+	}
+
+protected:
+	void run() override
+	{
+		sync_test();
+		capacity_test();
+		queued_test();
+		backpressure_test();
+		churn_test();
+
+#ifdef HAVE_RTOS
+		vTaskEndScheduler();
+#endif
+	}
+};
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	UNUSED(argc);
+	UNUSED(argv);
+
+	ThreadTest t1("eventbus-test");
+
+	t1.start();
+#ifdef HAVE_RTOS
+	vTaskStartScheduler();
+#endif
+
+	t1.join();
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
@@ -18,8 +18,12 @@
 #include <lwiot/kernel/event.h>
 #include <lwiot/log.h>
 #include <lwiot/kernel/thread.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/kernel/atomic.h>
 #include <lwiot/test.h>
 
+#include <assert.h>
+
 class ThreadTest : public lwiot::Thread {
 public:
 	explicit ThreadTest(const char *arg, lwiot::Event& event) : Thread("Testing thread", (void*)arg)
@@ -41,6 +45,86 @@ private:
 	lwiot::Event *event;
 };
 
+static void broadcast_test()
+{
+	lwiot::Event event;
+	lwiot::atomic_int_t woken(0);
+	lwiot::FunctionalThread w1("waiter-1"), w2("waiter-2"), w3("waiter-3");
+
+	auto waiter = [&]() {
+		if(event.wait(2000))
+			woken.fetch_add(1);
+	};
+
+	w1.start(waiter);
+	w2.start(waiter);
+	w3.start(waiter);
+
+	lwiot_sleep(100);
+	event.broadcast();
+
+	w1.join();
+	w2.join();
+	w3.join();
+
+	assert(woken.load() == 3);
+	print_dbg("Broadcast test passed!\n");
+}
+
+static void counting_test()
+{
+	lwiot::Event event(lwiot::EventType::Counting, 3);
+
+	/* Signals without waiters are stored, up to the maximum. */
+	for(int idx = 0; idx < 5; idx++)
+		event.signal();
+
+	assert(event.wait(10));
+	assert(event.wait(10));
+	assert(event.wait(10));
+	assert(!event.wait(10));
+
+	lwiot::Event binary;
+
+	binary.signal();
+	assert(!binary.wait(10));
+
+	print_dbg("Counting test passed!\n");
+}
+
+static void wait_any_test()
+{
+	lwiot::Event first(lwiot::EventType::Counting), second(lwiot::EventType::Counting, 2);
+	lwiot::Event* events[] = { &first, &second };
+	lwiot::FunctionalThread signaler("signaler"), both("both");
+
+	assert(lwiot::Event::waitAny(events, 2, 10) == -ETMO);
+
+	second.signal();
+	assert(lwiot::Event::waitAny(events, 2, 10) == 1);
+
+	signaler.start([&]() {
+		lwiot_sleep(50);
+		first.signal();
+	});
+
+	assert(lwiot::Event::waitAny(events, 2, 1000) == 0);
+	signaler.join();
+
+	/* The waiter got only one of the signals; the other is still stored. */
+	both.start([&]() {
+		lwiot_sleep(50);
+		second.signal();
+		first.signal();
+	});
+
+	assert(lwiot::Event::waitAny(events, 2, 1000) == 1);
+	both.join();
+	assert(first.wait(10));
+
+	print_dbg("Wait any test passed!\n");
+}
+
 static void main_thread(void *arg)
 {
 	lwiot::Event *e = (lwiot::Event*)arg;
@@ -56,6 +140,10 @@ static void main_thread(void *arg)
 
 	print_dbg("Timeout wait result: %i\n", e->wait(1000));
 
+	broadcast_test();
+	counting_test();
+	wait_any_test();
+
 #ifdef HAVE_RTOS
 	vTaskEndScheduler();
 #endif
@@ -0,0 +1,222 @@
+/*
+ * Unit test for the Executor class.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#ifdef HAVE_RTOS
+#include <FreeRTOS.h>
+#include <task.h>
+#endif
+
+#include <lwiot/kernel/executor.h>
+#include <lwiot/kernel/thread.h>
+#include <lwiot/kernel/lock.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/scopedlock.h>
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#include <lwiot/stl/vector.h>
+
+#ifdef NDEBUG
+#error "Debugging not enabled.."
+#endif
+
+static void priority_test()
+{
+	lwiot::Executor executor("prio");
+	lwiot::Lock lock(false);
+	lwiot::stl::Vector<int> order;
+	volatile bool blocked = true;
+
+	executor.start();
+
+	/* Keep the only worker busy until all tasks are queued. */
+	executor.post([&]() {
+		while(blocked)
+			lwiot_sleep(1);
+	});
+
+	lwiot_sleep(10);
+
+	for(int idx = 0; idx < 3; idx++) {
+		executor.post([&order, &lock, idx]() {
+			lwiot::ScopedLock l(lock);
+			order.push_back(idx);
+		});
+	}
+
+	executor.post([&]() {
+		lwiot::ScopedLock l(lock);
+		order.push_back(10);
+	}, 5);
+
+	blocked = false;
+	lwiot_sleep(100);
+
+	assert(order.size() == 4);
+	assert(order[0] == 10);
+	assert(order[1] == 0);
+	assert(order[2] == 1);
+	assert(order[3] == 2);
+
+	executor.stop();
+	print_dbg("Priority test passed!\n");
+}
+
+static void schedule_test()
+{
+	lwiot::Executor executor("delay");
+	volatile time_t first = 0, second = 0;
+	auto start = lwiot_tick_ms();
+
+	executor.start();
+
+	executor.schedule(200, [&]() {
+		second = lwiot_tick_ms();
+	});
+
+	executor.schedule(100, [&]() {
+		first = lwiot_tick_ms();
+	});
+
+	lwiot_sleep(50);
+	assert(first == 0 && second == 0);
+
+	lwiot_sleep(250);
+	assert(first != 0 && second != 0);
+	assert(first - start >= 100);
+	assert(second - start >= 200);
+	assert(first < second);
+
+	executor.stop();
+	print_dbg("Schedule test passed!\n");
+}
+
+static void workers_test()
+{
+	lwiot::Executor executor("pool", 4);
+	lwiot::Lock lock(false);
+	int done = 0;
+	auto start = lwiot_tick_ms();
+
+	assert(executor.workers() == 4);
+	executor.start();
+
+	for(int idx = 0; idx < 4; idx++) {
+		executor.post([&]() {
+			lwiot_sleep(200);
+
+			lwiot::ScopedLock l(lock);
+			done++;
+		});
+	}
+
+	while(executor.pending() != 0 || done != 4)
+		lwiot_sleep(10);
+
+	/* The tasks must have run side by side. */
+	assert(lwiot_tick_ms() - start < 600);
+
+	executor.stop();
+	print_dbg("Workers test passed!\n");
+}
+
+static void fanout_test()
+{
+	lwiot::Executor executor("fanout", 4);
+	lwiot::atomic_int_t done(0);
+	const int num = 10000;
+
+	executor.start();
+
+	/* Tasks posted from a task end up in the deque of the current worker. */
+	executor.post([&]() {
+		for(int idx = 0; idx < num; idx++) {
+			executor.post([&]() {
+				done.fetch_add(1);
+			});
+		}
+	});
+
+	for(int idx = 0; idx < 500 && done.load() != num; idx++)
+		lwiot_sleep(10);
+
+	assert(done.load() == num);
+	assert(executor.pending() == 0);
+
+	executor.stop();
+	print_dbg("Fan out test passed!\n");
+}
+
+static void stop_test()
+{
+	lwiot::Executor executor("stop");
+	volatile int ran = 0;
+
+	assert(!executor.post([]() { }));
+
+	executor.start();
+	executor.schedule(500, [&]() {
+		ran++;
+	});
+
+	assert(executor.pending() == 1);
+	executor.stop();
+
+	assert(executor.pending() == 0);
+	assert(!executor.running());
+	assert(!executor.post([]() { }));
+
+	lwiot_sleep(600);
+	assert(ran == 0);
+
+	print_dbg("Stop test passed!\n");
+}
+
+class ThreadTest : public lwiot::Thread {
+public:
+	explicit ThreadTest(const char *arg) : Thread("executor-test", (void*)arg)
+	{
+	}
+
+protected:
+	void run() override
+	{
+		priority_test();
+		schedule_test();
+		workers_test();
+		fanout_test();
+		stop_test();
+
+#ifdef HAVE_RTOS
+		vTaskEndScheduler();
+#endif
+	}
+};
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	UNUSED(argc);
+	UNUSED(argv);
+
+	ThreadTest t1("executor-test");
+
+	t1.start();
+#ifdef HAVE_RTOS
+	vTaskStartScheduler();
+#endif
+
+	wait_close();
+	t1.stop();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
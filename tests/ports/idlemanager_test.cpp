@@ -0,0 +1,221 @@
+/*
+ * Unit test for the IdleManager class.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#ifdef HAVE_RTOS
+#include <FreeRTOS.h>
+#include <task.h>
+#endif
+
+#include <lwiot/kernel/idlemanager.h>
+#include <lwiot/kernel/event.h>
+#include <lwiot/kernel/timer.h>
+#include <lwiot/kernel/thread.h>
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#ifdef NDEBUG
+#error "Debugging not enabled.."
+#endif
+
+using namespace lwiot;
+
+class Waiter : public Thread {
+public:
+	explicit Waiter(Event& event) : Thread("waiter"), signalled(false), _event(event)
+	{
+	}
+
+	bool signalled;
+
+protected:
+	void run() override
+	{
+		this->signalled = this->_event.wait(500);
+	}
+
+private:
+	Event& _event;
+};
+
+class IdleTimer : public Timer {
+public:
+	explicit IdleTimer() : Timer("idle-tmr", 300, TIMER_ONSHOT_FLAG, nullptr)
+	{
+	}
+
+protected:
+	void tick() override
+	{
+	}
+};
+
+static void deadline_test()
+{
+	auto now = lwiot_tick();
+
+	assert(IdleManager::next() == 0);
+
+	{
+		IdleManager::Deadline later(now + 50000);
+		assert(IdleManager::next() == now + 50000);
+
+		IdleManager::Deadline sooner(now + 20000);
+		assert(IdleManager::next() == now + 20000);
+
+		sooner.set(now + 80000);
+		assert(IdleManager::next() == now + 50000);
+
+		later.clear();
+		assert(later.expiry() == 0);
+		assert(IdleManager::next() == now + 80000);
+	}
+
+	assert(IdleManager::next() == 0);
+	print_dbg("Deadline test passed!\n");
+}
+
+static void idle_test()
+{
+	IdleManager::reset();
+
+	{
+		auto start = lwiot_tick();
+		IdleManager::Deadline deadline(start + 40000);
+
+		assert(IdleManager::idle());
+		assert(lwiot_tick() >= start + 30000);
+	}
+
+	/* Without deadlines the sleep is only bounded by the timeout. */
+	auto start = lwiot_tick_ms();
+	assert(IdleManager::idle(20));
+	assert(lwiot_tick_ms() - start >= 15);
+
+	auto stats = IdleManager::statistics();
+
+	assert(stats.sleeps == 2);
+	assert(stats.skipped == 0);
+	assert(stats.asleep >= 50);
+	assert(stats.worst >= stats.latency);
+
+	print_dbg("Idle test passed! Mean wake up latency: %lu us, worst: %lu us\n",
+		static_cast<unsigned long>(stats.latency), static_cast<unsigned long>(stats.worst));
+}
+
+static void skip_test()
+{
+	IdleManager::reset();
+
+	{
+		IdleManager::Deadline deadline(lwiot_tick() + 500);
+		assert(!IdleManager::idle());
+	}
+
+	{
+		IdleManager::WakeLock awake;
+		assert(!IdleManager::idle(100));
+	}
+
+	assert(IdleManager::idle(CONFIG_IDLE_MIN_SLEEP));
+	assert(!IdleManager::idle(CONFIG_IDLE_MIN_SLEEP - 1));
+
+	auto stats = IdleManager::statistics();
+
+	assert(stats.sleeps == 1);
+	assert(stats.skipped == 3);
+
+	print_dbg("Skip test passed!\n");
+}
+
+static void event_test()
+{
+	Event event;
+	Waiter waiter(event);
+	auto start = lwiot_tick();
+
+	waiter.start();
+	Thread::sleep(50);
+
+	/* The waiter registered the end of its timeout. */
+	auto next = IdleManager::next();
+
+	assert(next >= start + 400000);
+	assert(next <= lwiot_tick() + 500000);
+
+	event.signal();
+	waiter.join();
+
+	assert(waiter.signalled);
+	assert(IdleManager::next() == 0);
+
+	print_dbg("Event test passed!\n");
+}
+
+static void timer_test()
+{
+#ifdef HAVE_TIMER_EXPIRY
+	IdleTimer timer;
+	auto start = lwiot_tick();
+
+	timer.start();
+
+	auto next = IdleManager::next();
+
+	assert(next >= start + 300000);
+	assert(next <= lwiot_tick() + 300000);
+
+	timer.stop();
+	assert(IdleManager::next() == 0);
+
+	print_dbg("Timer test passed!\n");
+#endif
+}
+
+class ThreadTest : public Thread {
+public:
+	explicit ThreadTest(const char *arg) : Thread("idlemanager-test", (void*)arg)
+	{
+	}
+
+protected:
+	void run() override
+	{
+		deadline_test();
+		idle_test();
+		skip_test();
+		event_test();
+		timer_test();
+
+#ifdef HAVE_RTOS
+		vTaskEndScheduler();
+#endif
+	}
+};
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	UNUSED(argc);
+	UNUSED(argv);
+
+	ThreadTest t1("idlemanager-test");
+
+	t1.start();
+#ifdef HAVE_RTOS
+	vTaskStartScheduler();
+#endif
+
+	t1.join();
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
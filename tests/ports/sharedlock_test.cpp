@@ -0,0 +1,133 @@
+/*
+ * Unit test for the SharedLock class.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#ifdef HAVE_RTOS
+#include <FreeRTOS.h>
+#include <task.h>
+#endif
+
+#include <lwiot/kernel/sharedlock.h>
+#include <lwiot/kernel/uniquelock.h>
+#include <lwiot/kernel/functionalthread.h>
+#include <lwiot/kernel/atomic.h>
+#include <lwiot/kernel/thread.h>
+#include <lwiot/scopedsharedlock.h>
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#ifdef NDEBUG
+#error "Debugging not enabled.."
+#endif
+
+static void readers_test()
+{
+	lwiot::SharedLock lock;
+	lwiot::atomic_int_t inside(0);
+	lwiot::atomic_int_t peak(0);
+
+	auto reader = [&]() {
+		lwiot::ScopedSharedLock guard(lock);
+		auto now = inside.fetch_add(1) + 1;
+
+		if(now > peak.load())
+			peak.store(now);
+
+		lwiot_sleep(100);
+		inside.fetch_sub(1);
+	};
+
+	lwiot::FunctionalThread r1("reader-1"), r2("reader-2"), r3("reader-3");
+
+	r1.start(reader);
+	r2.start(reader);
+	r3.start(reader);
+
+	lwiot_sleep(50);
+	assert(!lock.try_lock());
+
+	r1.join();
+	r2.join();
+	r3.join();
+
+	assert(peak.load() > 1);
+	assert(lock.try_lock());
+	assert(!lock.try_lock_shared());
+	lock.unlock();
+
+	print_dbg("Readers test passed!\n");
+}
+
+static void writer_test()
+{
+	lwiot::SharedLock lock;
+	lwiot::atomic_int_t value(0);
+	lwiot::FunctionalThread writer("writer");
+
+	lock.lock_shared();
+
+	writer.start([&]() {
+		lwiot::UniqueLock<lwiot::SharedLock> guard(lock);
+		value.store(1);
+	});
+
+	lwiot_sleep(50);
+	assert(value.load() == 0);
+
+	/* A waiting writer keeps new readers out. */
+	assert(!lock.try_lock_shared());
+
+	lock.unlock_shared();
+	writer.join();
+
+	assert(value.load() == 1);
+	assert(lock.try_lock_shared());
+	lock.unlock_shared();
+
+	print_dbg("Writer test passed!\n");
+}
+
+class ThreadTest : public lwiot::Thread {
+public:
+	explicit ThreadTest(const char *arg) : Thread("sharedlock-test", (void*)arg)
+	{
+	}
+
+protected:
+	void run() override
+	{
+		readers_test();
+		writer_test();
+
+#ifdef HAVE_RTOS
+		vTaskEndScheduler();
+#endif
+	}
+};
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	UNUSED(argc);
+	UNUSED(argv);
+
+	ThreadTest t1("sharedlock-test");
+
+	t1.start();
+#ifdef HAVE_RTOS
+	vTaskStartScheduler();
+#endif
+
+	wait_close();
+	t1.stop();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}
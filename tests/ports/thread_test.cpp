@@ -20,6 +20,8 @@
 #include <lwiot/log.h>
 #include <lwiot/kernel/thread.h>
 #include <lwiot/kernel/functionalthread.h>
+#include <lwiot/kernel/threadregistry.h>
+#include <lwiot/kernel/staticthread.h>
 #include <lwiot/test.h>
 #include <lwiot/kernel/lock.h>
 
@@ -50,10 +52,145 @@ protected:
 	}
 };
 
+class BusyThread : public lwiot::Thread {
+public:
+	explicit BusyThread() : Thread("busy-thread", 10, 64 * 1024), _stop(false)
+	{
+	}
+
+	void halt()
+	{
+		this->_stop.store(true);
+	}
+
+protected:
+	void run() override
+	{
+		volatile char buffer[512];
+		uint64_t sum = 0;
+
+		for(auto idx = 0U; idx < sizeof(buffer); idx++)
+			buffer[idx] = (char) idx;
+
+		while(!this->_stop.load()) {
+			for(auto idx = 0U; idx < sizeof(buffer); idx++)
+				sum += buffer[idx];
+		}
+
+		UNUSED(sum);
+	}
+
+private:
+	lwiot::AtomicBool _stop;
+};
+
+static void stats_test()
+{
+	BusyThread busy;
+
+	assert(busy.stackHighWaterMark() == 0);
+	busy.start();
+	lwiot_sleep(200);
+
+#ifdef HAVE_THREAD_STATS
+	lwiot::ThreadStatistics stats;
+
+	assert(busy.statistics(stats));
+	assert(stats.running);
+	assert(stats.cpuTime > 0);
+	assert(stats.stackSize >= 64 * 1024);
+	assert(stats.stackHighWaterMark < stats.stackSize);
+#ifndef WIN32
+	assert(stats.stackHighWaterMark > 0);
+#endif
+#endif
+
+	bool found = false;
+	auto snapshot = lwiot::ThreadRegistry::snapshot();
+
+	for(auto& entry : snapshot) {
+		if(entry.name == "busy-thread")
+			found = true;
+	}
+
+	assert(found);
+
+	busy.halt();
+	busy.join();
+
+	snapshot = lwiot::ThreadRegistry::snapshot();
+
+	for(auto& entry : snapshot)
+		assert(entry.name != "busy-thread");
+
+	print_dbg("Thread statistics test passed!\n");
+}
+
+static void affinity_test()
+{
+	lwiot::Lock lock(false, true);
+	lwiot::FunctionalThread pinned("pinned-thread");
+	bool ran = false;
+
+	pinned.setAffinity(1U);
+	assert(pinned.affinity() == 1U);
+
+	lock.lock();
+	pinned.start([&]() {
+		lwiot::ScopedLock g(lock);
+		ran = true;
+	});
+
+	lwiot_sleep(50);
+	assert(!ran);
+	lock.unlock();
+	pinned.join();
+
+	assert(ran);
+	print_dbg("Thread affinity test passed!\n");
+}
+
+class StaticTestThread : public lwiot::StaticThread<128 * 1024> {
+public:
+	explicit StaticTestThread() : StaticThread("static-thread"), value(0)
+	{
+	}
+
+	lwiot::atomic_int_t value;
+
+protected:
+	void run() override
+	{
+		this->value.store(42);
+	}
+};
+
+static StaticTestThread static_thread;
+
+static void static_test()
+{
+	static_thread.start();
+	static_thread.join();
+
+	assert(static_thread.value.load() == 42);
+
+	/* The thread can be restarted in the same storage. */
+	static_thread.value.store(0);
+	static_thread.start();
+	static_thread.join();
+	assert(static_thread.value.load() == 42);
+
+	print_dbg("Static thread test passed!\n");
+}
+
 static void main_thread(void *arg)
 {
 	static auto *lock = (lwiot::Lock*)arg;
 
+	stats_test();
+	affinity_test();
+	static_test();
+
 	lwiot::Function<void(void)> lambda1 = [&]() -> void {
 		int i = 0;
 
@@ -80,6 +217,17 @@ static void main_thread(void *arg)
 	};
 
 	lock->lock();
+
+	/* Timed acquisitions of a held lock must give up. */
+	lwiot::FunctionalThread tp0("ft-tp0");
+	tp0.start([&]() {
+		auto start = lwiot_tick_ms();
+
+		assert(!lock->try_lock(100));
+		assert(lwiot_tick_ms() - start >= 99);
+	});
+	tp0.join();
+
 	lwiot::FunctionalThread tp1("ft-tp1", lambda1);
 	lwiot::FunctionalThread tp2("ft-tp2", lambda2);
 	lwiot::FunctionalThread tp3("ft-tp3");
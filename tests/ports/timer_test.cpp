@@ -46,6 +46,186 @@ private:
 	int _ticks;
 };
 
+class SlowTimer : public lwiot::Timer {
+public:
+	explicit SlowTimer(uint32_t flags) : Timer("Slow tmr", 100, flags, nullptr), _ticks(0)
+	{ }
+
+	const int& ticks() const
+	{
+		return this->_ticks;
+	}
+
+protected:
+	void tick() override
+	{
+		_ticks++;
+
+		/* Overrun the second period to miss two ticks. */
+		lwiot_sleep(_ticks == 2 ? 350 : 20);
+	}
+
+private:
+	int _ticks;
+};
+
+class RestartTimer : public lwiot::Timer {
+public:
+	explicit RestartTimer() : Timer("Restart tmr", 100, lwiot::TimerType::OneShot, nullptr), _ticks(0)
+	{ }
+
+	const int& ticks() const
+	{
+		return this->_ticks;
+	}
+
+protected:
+	void tick() override
+	{
+		_ticks++;
+
+		/* The timer is out of the heap by now, so it can be started again. */
+		if(_ticks < 3)
+			this->start();
+	}
+
+private:
+	int _ticks;
+};
+
+class ZeroTimer : public lwiot::Timer {
+public:
+	explicit ZeroTimer() : Timer("Zero tmr", 0, lwiot::TimerType::Periodic, nullptr), _ticks(0)
+	{ }
+
+	const int& ticks() const
+	{
+		return this->_ticks;
+	}
+
+protected:
+	void tick() override
+	{
+		_ticks++;
+	}
+
+private:
+	int _ticks;
+};
+
+#define ORDER_TIMERS 7
+
+static int order[ORDER_TIMERS];
+static int fired;
+
+class OrderTimer : public lwiot::Timer {
+public:
+	explicit OrderTimer(int id, unsigned long ms) : Timer("Order tmr", ms, lwiot::TimerType::OneShot, nullptr), _id(id)
+	{ }
+
+protected:
+	void tick() override
+	{
+		order[fired++] = _id;
+	}
+
+private:
+	int _id;
+};
+
+static void periodic_test(uint32_t flags, int expected)
+{
+	SlowTimer timer(flags);
+
+	timer.start();
+	lwiot_sleep(1050);
+	timer.stop();
+
+	print_dbg("Periodic timer ticks: %i\n", timer.ticks());
+	assert(timer.ticks() == expected);
+}
+
+static void restart_test()
+{
+	RestartTimer timer;
+
+	timer.start();
+	lwiot_sleep(450);
+	assert(timer.ticks() == 3);
+
+	lwiot_sleep(200);
+	assert(timer.ticks() == 3);
+	print_dbg("Restart from tick test passed!\n");
+}
+
+static void zero_period_test()
+{
+	ZeroTimer timer;
+
+	/* A zero period timer is due again right away; it should not stall the timer thread. */
+	timer.start();
+	lwiot_sleep(50);
+	timer.stop();
+
+	/* The timer thread may still be running the last tick, so keep the timer alive for it. */
+	lwiot_sleep(20);
+	assert(timer.ticks() > 1);
+	print_dbg("Zero period test passed!\n");
+}
+
+static void reset_front_test()
+{
+	TestTimer slow("Slow tmr", 2000, lwiot::TimerType::OneShot, nullptr);
+	TestTimer first("First tmr", 1000, lwiot::TimerType::OneShot, nullptr);
+
+	slow.start();
+	first.start();
+	lwiot_sleep(50);
+
+	/* The timer thread sleeps until the first timer expires, so it has to be woken up. */
+	slow.setPeriod(100);
+	slow.reset();
+
+	lwiot_sleep(200);
+	assert(slow.ticks() == 1);
+	assert(first.ticks() == 0);
+
+	lwiot_sleep(850);
+	assert(first.ticks() == 1);
+	print_dbg("Reset to front test passed!\n");
+}
+
+static void stop_middle_test()
+{
+	OrderTimer *timers[ORDER_TIMERS];
+	const unsigned long periods[ORDER_TIMERS] = { 700, 600, 500, 400, 300, 200, 100 };
+
+	fired = 0;
+
+	/* Started in reverse order, every timer moves up through the heap. */
+	for(int idx = 0; idx < ORDER_TIMERS; idx++) {
+		timers[idx] = new OrderTimer(idx, periods[idx]);
+		timers[idx]->start();
+	}
+
+	/* Neither is the first or the last timer in the heap. */
+	timers[2]->stop();
+	timers[4]->stop();
+
+	lwiot_sleep(800);
+	assert(fired == ORDER_TIMERS - 2);
+
+	const int expected[] = { 6, 5, 3, 1, 0 };
+
+	for(int idx = 0; idx < fired; idx++)
+		assert(order[idx] == expected[idx]);
+
+	for(int idx = 0; idx < ORDER_TIMERS; idx++)
+		delete timers[idx];
+
+	print_dbg("Stop in the middle test passed!\n");
+}
+
 class ThreadTest : public lwiot::Thread {
 public:
 	explicit ThreadTest(const char *arg) : Thread("Testing thread", (void*)arg)
@@ -78,6 +258,15 @@ protected:
 		lwiot_sleep(1000);
 		delete timer;
 
+		periodic_test(lwiot::TimerType::Periodic, 8);
+		periodic_test(lwiot::TimerType::PeriodicBurst, 10);
+		periodic_test(lwiot::TimerType::PeriodicCoalesce, 7);
+
+		restart_test();
+		zero_period_test();
+		reset_front_test();
+		stop_middle_test();
+
 		lwiot::FunctionalTimer<void>  ft1(lwiot::TimerType::OneShot, 2500);
 		lwiot::FunctionalTimer<int>   ft2(lwiot::TimerType::OneShot, 2000, 2);
 
@@ -0,0 +1,235 @@
+/*
+ * Unit test for the WatchdogSupervisor class.
+ *
+ * @author Michel Megens
+ * @email  dev@bietje.net
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <lwiot.h>
+
+#ifdef HAVE_RTOS
+#include <FreeRTOS.h>
+#include <task.h>
+#endif
+
+#include <lwiot/io/watchdog.h>
+#include <lwiot/io/watchdogsupervisor.h>
+#include <lwiot/kernel/thread.h>
+#include <lwiot/log.h>
+#include <lwiot/test.h>
+
+#ifdef NDEBUG
+#error "Debugging not enabled.."
+#endif
+
+using namespace lwiot;
+
+class CountingWatchdog : public Watchdog {
+public:
+	explicit CountingWatchdog() : Watchdog(), resets(0), timeout(0)
+	{
+	}
+
+	bool enable(uint32_t tmo) override
+	{
+		this->timeout = tmo;
+		return Watchdog::enable(tmo);
+	}
+
+	void reset() override
+	{
+		this->resets++;
+	}
+
+	bool active() const
+	{
+		return this->enabled();
+	}
+
+	int resets;
+	uint32_t timeout;
+};
+
+class Worker : public Thread {
+public:
+	explicit Worker(WatchdogSupervisor& supervisor) : Thread("worker"), running(true), stall(false),
+		_heartbeat(supervisor, "worker", 100)
+	{
+	}
+
+	volatile bool running;
+	volatile bool stall;
+
+protected:
+	void run() override
+	{
+		while(this->running) {
+			if(!this->stall)
+				this->_heartbeat.beat();
+
+			Thread::sleep(10);
+		}
+	}
+
+private:
+	Heartbeat _heartbeat;
+};
+
+static void check_test()
+{
+	CountingWatchdog watchdog;
+	WatchdogSupervisor supervisor(watchdog);
+	const char *stalled = nullptr;
+	int stalls = 0;
+
+	supervisor.setStallHandler([&](const HeartbeatStatus& status) {
+		stalled = status.name;
+		stalls++;
+	});
+
+	/* Nothing to supervise. */
+	assert(supervisor.check());
+	assert(watchdog.resets == 1);
+
+	{
+		Heartbeat mqtt(supervisor, "mqtt", 50);
+		Heartbeat xbee(supervisor, "xbee", 200);
+
+		assert(mqtt.registered() && xbee.registered());
+		assert(supervisor.report().size() == 2);
+		assert(supervisor.check());
+
+		Thread::sleep(100);
+		xbee.beat();
+
+		assert(!supervisor.check());
+		assert(watchdog.resets == 2);
+		assert(stalls == 1);
+		assert(strcmp(stalled, "mqtt") == 0);
+
+		/* A stall is reported once. */
+		assert(!supervisor.check());
+		assert(stalls == 1);
+
+		auto report = supervisor.report();
+
+		assert(report[0].stalled && report[0].age >= 100);
+		assert(!report[1].stalled);
+
+		mqtt.beat();
+		assert(supervisor.check());
+		assert(watchdog.resets == 3);
+	}
+
+	assert(supervisor.report().size() == 0);
+	print_dbg("Check test passed!\n");
+}
+
+static void slots_test()
+{
+	CountingWatchdog watchdog;
+	WatchdogSupervisor supervisor(watchdog);
+	Heartbeat *beats[CONFIG_WATCHDOG_HEARTBEATS];
+
+	for(auto& beat : beats)
+		beat = new Heartbeat(supervisor, "beat", 1000);
+
+	Heartbeat extra(supervisor, "extra", 1000);
+	assert(!extra.registered());
+	extra.beat();
+
+	for(auto beat : beats)
+		delete beat;
+
+	Heartbeat again(supervisor, "again", 1000);
+	assert(again.registered());
+
+	print_dbg("Slots test passed!\n");
+}
+
+static void supervisor_test()
+{
+	CountingWatchdog watchdog;
+	WatchdogSupervisor supervisor(watchdog, 20);
+	Worker worker(supervisor);
+	bool stalled = false;
+
+	supervisor.setStallHandler([&](const HeartbeatStatus& status) {
+		stalled = strcmp(status.name, "worker") == 0;
+	});
+
+	worker.start();
+
+	/* A timeout that is not longer than the interval is refused. */
+	assert(!supervisor.begin(20));
+	assert(!watchdog.active());
+
+	assert(supervisor.begin(1000));
+	assert(watchdog.active() && watchdog.timeout == 1000);
+
+	Thread::sleep(200);
+	assert(!stalled);
+
+	auto fed = watchdog.resets;
+
+	assert(fed >= 5);
+
+	/* A thread that stops checking in stops the feeding. */
+	worker.stall = true;
+	Thread::sleep(250);
+	assert(stalled);
+
+	fed = watchdog.resets;
+	Thread::sleep(100);
+	assert(watchdog.resets == fed);
+
+	supervisor.end();
+	assert(!watchdog.active());
+
+	worker.running = false;
+	worker.join();
+
+	print_dbg("Supervisor test passed!\n");
+}
+
+class ThreadTest : public Thread {
+public:
+	explicit ThreadTest(const char *arg) : Thread("watchdogsupervisor-test", (void*)arg)
+	{
+	}
+
+protected:
+	void run() override
+	{
+		check_test();
+		slots_test();
+		supervisor_test();
+
+#ifdef HAVE_RTOS
+		vTaskEndScheduler();
+#endif
+	}
+};
+
+int main(int argc, char **argv)
+{
+	lwiot_init();
+	UNUSED(argc);
+	UNUSED(argv);
+
+	ThreadTest t1("watchdogsupervisor-test");
+
+	t1.start();
+#ifdef HAVE_RTOS
+	vTaskStartScheduler();
+#endif
+
+	t1.join();
+	wait_close();
+	lwiot_destroy();
+
+	return -EXIT_SUCCESS;
+}